@@ -125,6 +125,9 @@ IF %ERRORLEVEL% NEQ 0 GOTO ERROR
 ECHO running util-tests.exe ...
 unit_tests\%Configuration%\util-tests.exe
 IF %ERRORLEVEL% NEQ 0 GOTO ERROR
+ECHO running partition-tests.exe ...
+unit_tests\%Configuration%\partition-tests.exe
+IF %ERRORLEVEL% NEQ 0 GOTO ERROR
 ECHO running server-tests.exe ...
 unit_tests\%Configuration%\server-tests.exe
 IF %ERRORLEVEL% NEQ 0 GOTO ERROR
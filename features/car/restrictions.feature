@@ -430,3 +430,55 @@ Feature: Car - Turn restrictions
             | a    | b  | ax,xy,yb,yb |
             | b    | a  | yb,xy,ax,ax |
 
+
+    @no_turning
+    Scenario: Car - No right turn over a via way
+        Given the node map
+            | a | b | c |
+            |   |   | f |
+            |   | e | g |
+
+        And the ways
+            | nodes | oneway |
+            | ab    | no     |
+            | bc    | no     |
+            | cf    | no     |
+            | be    | no     |
+            | eg    | no     |
+            | gf    | no     |
+
+        And the relations
+            | type        | way:from | way:to | way:via | restriction   |
+            | restriction | ab       | cf     | bc      | no_right_turn |
+
+        When I route I should get
+            | from | to | route          |
+            | a    | f  | ab,be,eg,gf,gf |
+            | a    | c  | ab,bc,bc       |
+            | f    | a  | cf,bc,ab,ab    |
+
+    @no_turning
+    Scenario: Car - Route from the from way to the via way of a restriction
+        Given the node map
+            | a | b | 1 | c |
+            |   |   |   | f |
+            |   | e |   | g |
+
+        And the ways
+            | nodes | oneway |
+            | ab    | no     |
+            | bc    | no     |
+            | cf    | no     |
+            | be    | no     |
+            | eg    | no     |
+            | gf    | no     |
+
+        And the relations
+            | type        | way:from | way:to | way:via | restriction   |
+            | restriction | ab       | cf     | bc      | no_right_turn |
+
+        When I route I should get
+            | from | to | route          |
+            | a    | 1  | ab,bc,bc       |
+            | 1    | f  | bc,cf,cf       |
+            | a    | f  | ab,be,eg,gf,gf |
@@ -222,12 +222,12 @@ module.exports = function () {
                 });
             };
 
-            ['osrm', 'osrm.ebg', 'osrm.edges', 'osrm.enw', 'osrm.fileIndex', 'osrm.geometry', 'osrm.icd',
-             'osrm.names', 'osrm.nodes', 'osrm.properties', 'osrm.ramIndex', 'osrm.restrictions', 'osrm.tld', 'osrm.tls'].forEach(file => {
+            ['osrm', 'osrm.duplicated_nodes', 'osrm.ebg', 'osrm.edges', 'osrm.enw', 'osrm.fileIndex', 'osrm.geometry',
+             'osrm.icd', 'osrm.names', 'osrm.nodes', 'osrm.properties', 'osrm.ramIndex', 'osrm.restrictions', 'osrm.tld', 'osrm.tls'].forEach(file => {
                  q.defer(rename, file);
              });
 
-            ['osrm.edge_penalties', 'osrm.edge_segment_lookup'].forEach(file => {
+            ['osrm.edge_penalties', 'osrm.edge_segment_lookup', 'osrm.segment_index'].forEach(file => {
                 q.defer(renameIfExists, file);
             });
 
@@ -281,13 +281,14 @@ module.exports = function () {
 
             var q = d3.queue();
 
-            ['osrm', 'osrm.core', 'osrm.datasource_indexes', 'osrm.datasource_names', 'osrm.ebg','osrm.edges',
-             'osrm.enw', 'osrm.fileIndex', 'osrm.geometry', 'osrm.hsgr', 'osrm.icd','osrm.level', 'osrm.names',
+            ['osrm', 'osrm.core', 'osrm.datasource_indexes', 'osrm.datasource_names', 'osrm.duplicated_nodes',
+             'osrm.ebg','osrm.edges', 'osrm.enw', 'osrm.fileIndex', 'osrm.geometry', 'osrm.hsgr', 'osrm.icd',
+             'osrm.level', 'osrm.names',
              'osrm.nodes', 'osrm.properties', 'osrm.ramIndex', 'osrm.restrictions', 'osrm.tld', 'osrm.tls'].forEach((file) => {
                  q.defer(rename, file);
              });
 
-            ['osrm.edge_penalties', 'osrm.edge_segment_lookup'].forEach(file => {
+            ['osrm.edge_penalties', 'osrm.edge_segment_lookup', 'osrm.segment_index'].forEach(file => {
                 q.defer(renameIfExists, file);
             });
 
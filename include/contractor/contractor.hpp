@@ -58,18 +58,40 @@ class Contractor
 
     int Run();
 
+    // Makes a running contraction with checkpoints enabled write a checkpoint after its current
+    // round and fail. Safe to call from a signal handler.
+    static void Interrupt();
+
+    // Splits the edge-based graph into nested cells (osrm-partition)
+    int Partition();
+
+    // Computes the cell metrics of a partition for the current weights (osrm-customize)
+    int Customize();
+
   protected:
     void ContractGraph(const unsigned max_edge_id,
                        util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
                        util::DeallocatingVector<QueryEdge> &contracted_edge_list,
                        std::vector<EdgeWeight> &&node_weights,
                        std::vector<bool> &is_core_node,
-                       std::vector<float> &inout_node_levels) const;
+                       std::vector<float> &inout_node_levels,
+                       const std::vector<QueryEdge> &previous_edges) const;
     void WriteCoreNodeMarker(std::vector<bool> &&is_core_node) const;
+    // Precomputes the distances of config.core_landmarks landmarks in the core
+    void WriteCoreLandmarks(const util::DeallocatingVector<QueryEdge> &contracted_edge_list,
+                            const std::vector<bool> &is_core_node) const;
     void WriteNodeLevels(std::vector<float> &&node_levels) const;
     void ReadNodeLevels(std::vector<float> &contraction_order) const;
+    void ReadContractedGraph(std::vector<QueryEdge> &contracted_edge_list) const;
+    // Maps the node ids in the r-tree leaves from one renumbering to another
+    void RenumberRTreeLeaves(const std::vector<NodeID> &previous_node_ids,
+                             const std::vector<NodeID> &node_ids) const;
+    // The same for the copies of via ways, see extractor::DuplicatedNode
+    void RenumberDuplicatedNodes(const std::vector<NodeID> &previous_node_ids,
+                                 const std::vector<NodeID> &node_ids) const;
     std::size_t
-    WriteContractedGraph(unsigned number_of_edge_based_nodes,
+    WriteContractedGraph(const std::string &graph_path,
+                         unsigned number_of_edge_based_nodes,
                          const util::DeallocatingVector<QueryEdge> &contracted_edge_list);
     void FindComponents(unsigned max_edge_id,
                         const util::DeallocatingVector<extractor::EdgeBasedEdge> &edges,
@@ -83,13 +105,12 @@ class Contractor
                           util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
                           const std::string &edge_segment_lookup_path,
                           const std::string &edge_penalty_path,
+                          const std::string &segment_index_path,
                           const std::vector<std::string> &segment_speed_path,
                           const std::vector<std::string> &turn_penalty_path,
-                          const std::string &nodes_filename,
                           const std::string &geometry_filename,
                           const std::string &datasource_names_filename,
-                          const std::string &datasource_indexes_filename,
-                          const std::string &rtree_leaf_filename);
+                          const std::string &datasource_indexes_filename);
 };
 }
 }
@@ -30,7 +30,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/filesystem/path.hpp>
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -39,22 +41,37 @@ namespace contractor
 
 struct ContractorConfig
 {
-    ContractorConfig() : requested_num_threads(0) {}
+    ContractorConfig()
+        : reorder_changed(false), renumber_nodes(false), requested_num_threads(0), checkpoint_interval(0),
+          core_landmarks(0), time_slot_duration(60)
+    {
+    }
 
     // Infer the output names from the path of the .osrm file
     void UseDefaultOutputNames()
     {
         level_output_path = osrm_input_path.string() + ".level";
         core_output_path = osrm_input_path.string() + ".core";
+        core_landmarks_output_path = osrm_input_path.string() + ".core_landmarks";
+        edge_lengths_output_path = osrm_input_path.string() + ".edge_lengths";
         graph_output_path = osrm_input_path.string() + ".hsgr";
         edge_based_graph_path = osrm_input_path.string() + ".ebg";
         edge_segment_lookup_path = osrm_input_path.string() + ".edge_segment_lookup";
         edge_penalty_path = osrm_input_path.string() + ".edge_penalties";
+        segment_index_path = osrm_input_path.string() + ".segment_index";
         node_based_graph_path = osrm_input_path.string() + ".nodes";
         geometry_path = osrm_input_path.string() + ".geometry";
         rtree_leaf_path = osrm_input_path.string() + ".fileIndex";
+        duplicated_nodes_path = osrm_input_path.string() + ".duplicated_nodes";
         datasource_names_path = osrm_input_path.string() + ".datasource_names";
         datasource_indexes_path = osrm_input_path.string() + ".datasource_indexes";
+        partition_path = osrm_input_path.string() + ".partition";
+        cells_path = osrm_input_path.string() + ".cells";
+        mld_graph_path = osrm_input_path.string() + ".mldgr";
+        node_order_path = osrm_input_path.string() + ".node_order";
+        checkpoint_path = osrm_input_path.string() + ".contraction_checkpoint";
+        time_slots_output_path = osrm_input_path.string() + ".time_slots";
+        edge_data_path = osrm_input_path.string() + ".edges";
     }
 
     boost::filesystem::path config_file_path;
@@ -62,28 +79,81 @@ struct ContractorConfig
 
     std::string level_output_path;
     std::string core_output_path;
+    std::string core_landmarks_output_path;
+    // Length in meters of every edge of the .hsgr, see WriteEdgeLengths
+    std::string edge_lengths_output_path;
     std::string graph_output_path;
     std::string edge_based_graph_path;
 
     std::string edge_segment_lookup_path;
     std::string edge_penalty_path;
+    // segments of the geometries sorted by their OSM nodes, see SegmentSpeeds
+    std::string segment_index_path;
     std::string node_based_graph_path;
     std::string geometry_path;
     std::string rtree_leaf_path;
+    // the copies of via ways made for via-way restrictions, renumbered like the r-tree leaves
+    std::string duplicated_nodes_path;
     bool use_cached_priority;
 
+    // Re-contract only the part of the previous .hsgr around changed edge weights.
+    // Requires the .level file of the run that produced it.
+    bool incremental;
+    // Number of hops around a changed arc in which witness searches are repeated
+    unsigned incremental_radius;
+    // Recompute the order of the re-contracted nodes in incremental mode and write the new .level
+    bool reorder_changed;
+
+    // Number the nodes of the .hsgr by their level in the hierarchy, so that the nodes a query
+    // settles are close to each other in memory. The r-tree leaves are renumbered along, the
+    // permutation from the ids of osrm-extract is kept in the .node_order file.
+    bool renumber_nodes;
+    std::string node_order_path;
+
     unsigned requested_num_threads;
 
+    // Minutes between two checkpoints of the contraction, 0 disables them. A run with checkpoints
+    // enabled resumes from the checkpoint of a previous run that was interrupted.
+    unsigned checkpoint_interval;
+    std::string checkpoint_path;
+
     // A percentage of vertices that will be contracted for the hierarchy.
     // Offers a trade-off between preprocessing and query time.
     // The remaining vertices form the core of the hierarchy
     //(e.g. 0.8 contracts 80 percent of the hierarchy, leaving a core of 20%)
     double core_factor;
+    // Number of landmarks whose distances to and from all core nodes are written to the
+    // .core_landmarks file, osrm-routed uses them for A* searches in the core
+    unsigned core_landmarks;
 
     std::vector<std::string> segment_speed_lookup_paths;
     std::vector<std::string> turn_penalty_lookup_paths;
+
+    // One speed file per time slot of time_slot_duration minutes, the weights of all slots are
+    // written to the .time_slots file and selected by the departure time of a route request
+    std::vector<std::string> time_slot_speed_lookup_paths;
+    unsigned time_slot_duration;
+    std::string time_slots_output_path;
+
+    // One speed file per further metric, e.g. a shortest distance one. Their weights share the
+    // hierarchy of the .hsgr, follow the time slots in the .time_slots file and are selected by
+    // the metric parameter of route requests, metric n being the n-th file.
+    std::vector<std::string> metric_speed_lookup_paths;
+
+    // Class lists like "toll,ferry", each adds a metric after the ones of the speed files that
+    // excludes the edges of these classes. The classes are read from the .edges file.
+    std::vector<std::string> exclude_classes;
+    std::string edge_data_path;
+
     std::string datasource_indexes_path;
     std::string datasource_names_path;
+
+    // Output of osrm-partition and osrm-customize for multi-level Dijkstra
+    std::string partition_path;
+    std::string cells_path;
+    std::string mld_graph_path;
+    // Maximal number of edge-based nodes in a cell, one entry per level from the bottom up
+    std::vector<std::size_t> max_cell_sizes;
 };
 }
 }
@@ -0,0 +1,23 @@
+#ifndef OSRM_CONTRACTOR_EDGE_LENGTHS_HPP
+#define OSRM_CONTRACTOR_EDGE_LENGTHS_HPP
+
+#include "contractor/contractor_config.hpp"
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Writes the .edge_lengths file: the number of edges of the .hsgr as 64 bit integer followed by
+// one EdgeLength per edge in the order of the .hsgr.
+//
+// An edge that is not a shortcut stores half the length of the edge-based nodes at both of its
+// ends, so a path of edges counts its inner nodes once and half of its first and last node, no
+// matter in which direction the edges are traversed. A shortcut stores the sum of the two edges it
+// replaces. Shortcuts that are used in both directions keep the longer of the two lengths, the
+// same as their weight.
+void WriteEdgeLengths(const ContractorConfig &config);
+}
+}
+
+#endif // OSRM_CONTRACTOR_EDGE_LENGTHS_HPP
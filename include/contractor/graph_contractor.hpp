@@ -6,6 +6,7 @@
 #include "util/deallocating_vector.hpp"
 #include "util/dynamic_graph.hpp"
 #include "util/integer_range.hpp"
+#include "util/io.hpp"
 #include "util/percent.hpp"
 #include "util/simple_logger.hpp"
 #include "util/timing_util.hpp"
@@ -14,16 +15,26 @@
 #include "util/xor_fast_hash_storage.hpp"
 
 #include <boost/assert.hpp>
+#include <boost/filesystem.hpp>
 
 #include <stxxl/vector>
 
 #include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_sort.h>
+#include <tbb/tick_count.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
 #include <limits>
 #include <memory>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -60,6 +71,9 @@ class GraphContractor
         bool backward : 1;
         bool is_original_via_node_ID : 1;
     } data;
+    // an edge of the contractor graph takes 16 bytes, the flags share a word with originalEdges
+    static_assert(sizeof(ContractorEdgeData) == 3 * sizeof(unsigned),
+                  "ContractorEdgeData is not packed");
 
     struct ContractorHeapData
     {
@@ -81,15 +95,37 @@ class GraphContractor
                                             util::XORFastHashStorage<NodeID, NodeID>>;
     using ContractorEdge = ContractorGraph::InputEdge;
 
+    using NodeDepth = int;
+
     struct ContractorThreadData
     {
         ContractorHeap heap;
         std::vector<ContractorEdge> inserted_edges;
         std::vector<NodeID> neighbours;
+        // nodes that have to be re-contracted because a lower shortcut changed (incremental mode)
+        std::vector<NodeID> dirty_nodes;
+        // neighbours of contracted nodes with their new minimum depth, their priorities are
+        // re-evaluated once at the end of the round
+        std::vector<std::pair<NodeID, NodeDepth>> stale_neighbours;
         explicit ContractorThreadData(NodeID nodes) : heap(nodes) {}
     };
 
-    using NodeDepth = int;
+    // A directed shortcut arc of the previous hierarchy, grouped by its via node
+    struct PreviousArc
+    {
+        NodeID from;
+        NodeID to;
+        EdgeWeight distance;
+
+        bool operator<(const PreviousArc &other) const
+        {
+            return std::tie(from, to, distance) < std::tie(other.from, other.to, other.distance);
+        }
+        bool operator==(const PreviousArc &other) const
+        {
+            return std::tie(from, to, distance) == std::tie(other.from, other.to, other.distance);
+        }
+    };
 
     struct ContractionStats
     {
@@ -258,76 +294,309 @@ class GraphContractor
         util::SimpleLogger().Write() << "contractor finished initalization";
     }
 
-    void Run(double core_factor = 1.0)
+    // Enables incremental contraction against the hierarchy of a previous run that used the same
+    // cached node levels. Nodes further than dirty_radius hops away from a changed arc replay their
+    // previous shortcuts instead of running witness searches.
+    void SetPreviousHierarchy(const std::vector<QueryEdge> &previous_edges,
+                              const unsigned dirty_radius)
+    {
+        const NodeID number_of_nodes = contractor_graph->GetNumberOfNodes();
+        const auto arc_key = [](const NodeID from, const NodeID to) {
+            return (static_cast<std::uint64_t>(from) << 32) | to;
+        };
+
+        std::unordered_map<std::uint64_t, EdgeWeight> previous_original_arcs;
+        const auto add_original_arc = [&](const NodeID from, const NodeID to, const EdgeWeight w) {
+            auto iter = previous_original_arcs.emplace(arc_key(from, to), w).first;
+            iter->second = std::min(iter->second, w);
+        };
+
+        is_dirty.assign(number_of_nodes, false);
+        previous_shortcut_offsets.assign(number_of_nodes + 1, 0);
+        for (const auto &edge : previous_edges)
+        {
+            if (!edge.data.shortcut)
+            {
+                if (edge.data.forward)
+                    add_original_arc(edge.source, edge.target, edge.data.distance);
+                if (edge.data.backward)
+                    add_original_arc(edge.target, edge.source, edge.data.distance);
+                continue;
+            }
+            BOOST_ASSERT(edge.data.id < number_of_nodes);
+            previous_shortcut_offsets[edge.data.id + 1] += edge.data.forward + edge.data.backward;
+            // self-loops depend on the node weights and are always recomputed
+            if (edge.source == edge.target)
+                is_dirty[edge.data.id] = true;
+        }
+        std::partial_sum(previous_shortcut_offsets.begin(),
+                         previous_shortcut_offsets.end(),
+                         previous_shortcut_offsets.begin());
+
+        previous_shortcuts.resize(previous_shortcut_offsets.back());
+        std::vector<std::size_t> insert_position(previous_shortcut_offsets.begin(),
+                                                 previous_shortcut_offsets.end() - 1);
+        for (const auto &edge : previous_edges)
+        {
+            if (!edge.data.shortcut)
+                continue;
+            if (edge.data.forward)
+                previous_shortcuts[insert_position[edge.data.id]++] = {
+                    edge.source, edge.target, edge.data.distance};
+            if (edge.data.backward)
+                previous_shortcuts[insert_position[edge.data.id]++] = {
+                    edge.target, edge.source, edge.data.distance};
+        }
+        for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+        {
+            std::sort(previous_shortcuts.begin() + previous_shortcut_offsets[node],
+                      previous_shortcuts.begin() + previous_shortcut_offsets[node + 1]);
+        }
+
+        // mark the endpoints of all arcs that were added, removed or re-weighted
+        std::vector<char> changed(number_of_nodes, false);
+        std::size_t matched_arcs = 0;
+        for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+        {
+            for (auto edge : contractor_graph->GetAdjacentEdgeRange(node))
+            {
+                const ContractorEdgeData &data = contractor_graph->GetEdgeData(edge);
+                if (!data.forward)
+                    continue;
+                const NodeID target = contractor_graph->GetTarget(edge);
+                const auto iter = previous_original_arcs.find(arc_key(node, target));
+                if (iter != previous_original_arcs.end() &&
+                    iter->second == static_cast<EdgeWeight>(data.distance))
+                {
+                    ++matched_arcs;
+                }
+                else
+                {
+                    changed[node] = changed[target] = true;
+                }
+            }
+        }
+        if (matched_arcs != previous_original_arcs.size())
+        {
+            for (const auto &arc : previous_original_arcs)
+            {
+                const NodeID from = static_cast<NodeID>(arc.first >> 32);
+                const NodeID to = static_cast<NodeID>(arc.first & 0xFFFFFFFF);
+                if (from >= number_of_nodes || to >= number_of_nodes)
+                    continue;
+                bool still_exists = false;
+                for (auto edge : contractor_graph->GetAdjacentEdgeRange(from))
+                {
+                    const ContractorEdgeData &data = contractor_graph->GetEdgeData(edge);
+                    still_exists |= data.forward && contractor_graph->GetTarget(edge) == to &&
+                                    static_cast<EdgeWeight>(data.distance) == arc.second;
+                }
+                if (!still_exists)
+                {
+                    changed[from] = changed[to] = true;
+                }
+            }
+        }
+
+        // Witnesses of unchanged nodes are not re-validated. Widening the dirty region by a few
+        // hops covers the short witnesses that run over a changed arc.
+        std::vector<NodeID> frontier;
+        for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+        {
+            if (changed[node])
+            {
+                is_dirty[node] = true;
+                frontier.push_back(node);
+            }
+        }
+        std::vector<char> reached(changed);
+        for (unsigned hop = 0; hop < dirty_radius && !frontier.empty(); ++hop)
+        {
+            std::vector<NodeID> next_frontier;
+            for (const NodeID node : frontier)
+            {
+                for (auto edge : contractor_graph->GetAdjacentEdgeRange(node))
+                {
+                    const NodeID target = contractor_graph->GetTarget(edge);
+                    if (!reached[target])
+                    {
+                        reached[target] = is_dirty[target] = true;
+                        next_frontier.push_back(target);
+                    }
+                }
+            }
+            frontier.swap(next_frontier);
+        }
+
+        util::SimpleLogger().Write()
+            << "incremental contraction: "
+            << std::count(changed.begin(), changed.end(), true) << " nodes with changed arcs, "
+            << std::count(is_dirty.begin(), is_dirty.end(), true) << " nodes to re-contract";
+    }
+
+    // Recomputes the order of the nodes that SetPreviousHierarchy marked for re-contraction. Run
+    // hands their cached levels out again in the order of their current priorities, which are
+    // updated like without cached levels, so the order outside of the changed region stays the
+    // same. GetNodeLevels returns the levels of the new order.
+    void ReorderDirtyNodes()
+    {
+        BOOST_ASSERT(!previous_shortcut_offsets.empty());
+        BOOST_ASSERT(node_levels.size() == contractor_graph->GetNumberOfNodes());
+        previous_node_levels = node_levels;
+    }
+
+    // Writes the state of the contraction to path after the first round that ends interval_seconds
+    // after the last checkpoint. Run resumes from a checkpoint of the same input graph.
+    void SetCheckpoint(std::string path, const double interval_seconds)
+    {
+        checkpoint_path = std::move(path);
+        checkpoint_interval = interval_seconds;
+    }
+
+    // Once interrupted is set, Run writes a checkpoint after the current round and stops. Another
+    // Run on the same input graph resumes from there.
+    void SetInterruptFlag(const std::atomic<bool> &interrupted)
+    {
+        BOOST_ASSERT(!checkpoint_path.empty());
+        interrupt_flag = &interrupted;
+    }
+
+    // Returns false if the contraction was interrupted, see SetInterruptFlag
+    bool Run(double core_factor = 1.0)
     {
         // for the preperation we can use a big grain size, which is much faster (probably cache)
         const constexpr size_t InitGrainSize = 100000;
-        const constexpr size_t PQGrainSize = 100000;
         // auto_partitioner will automatically increase the blocksize if we have
         // a lot of data. It is *important* for the last loop iterations
         // (which have a very small dataset) that it is devisible.
+        // Witness searches are split into chunks of about the same cost instead, see
+        // GetBalancedChunks.
         const constexpr size_t IndependentGrainSize = 1;
         const constexpr size_t ContractGrainSize = 1;
-        const constexpr size_t NeighboursGrainSize = 1;
         const constexpr size_t DeleteGrainSize = 1;
 
         const NodeID number_of_nodes = contractor_graph->GetNumberOfNodes();
         util::Percent p(number_of_nodes);
 
         ThreadDataContainer thread_data_list(number_of_nodes);
+        // time every thread spends in witness searches, reset for each round
+        tbb::enumerable_thread_specific<double> busy_seconds(0.);
+        double total_busy_seconds = 0.;
+        double total_available_seconds = 0.;
 
         NodeID number_of_contracted_nodes = 0;
         std::vector<NodeDepth> node_depth;
         std::vector<float> node_priorities;
         is_core_node.resize(number_of_nodes, false);
 
-        std::vector<RemainingNodeData> remaining_nodes(number_of_nodes);
-        // initialize priorities in parallel
-        tbb::parallel_for(tbb::blocked_range<int>(0, number_of_nodes, InitGrainSize),
-                          [this, &remaining_nodes](const tbb::blocked_range<int> &range) {
-                              for (int x = range.begin(), end = range.end(); x != end; ++x)
-                              {
-                                  remaining_nodes[x].id = x;
-                              }
-                          });
-
+        std::vector<RemainingNodeData> remaining_nodes;
         bool use_cached_node_priorities = !node_levels.empty();
-        if (use_cached_node_priorities)
+
+        // incremental contraction keeps the original node ids to look up the previous shortcuts
+        const bool incremental = !previous_shortcut_offsets.empty();
+        BOOST_ASSERT(!incremental || use_cached_node_priorities);
+        std::size_t number_of_replayed_nodes = 0;
+
+        unsigned current_level = 0;
+        bool flushed_contractor = false;
+
+        CheckpointHeader checkpoint;
+        checkpoint.graph_checksum = checkpoint_path.empty() ? 0 : GetGraphChecksum();
+        checkpoint.core_factor = core_factor;
+        checkpoint.number_of_input_nodes = number_of_nodes;
+        checkpoint.use_cached_node_priorities = use_cached_node_priorities;
+        checkpoint.incremental = incremental;
+        checkpoint.reorder_dirty_nodes = !previous_node_levels.empty();
+        auto last_checkpoint = tbb::tick_count::now();
+
+        if (!checkpoint_path.empty() &&
+            ReadCheckpoint(checkpoint, remaining_nodes, node_priorities, node_depth))
         {
-            std::cout << "using cached node priorities ..." << std::flush;
-            node_priorities.swap(node_levels);
-            std::cout << "ok" << std::endl;
+            number_of_contracted_nodes = checkpoint.number_of_contracted_nodes;
+            number_of_replayed_nodes = checkpoint.number_of_replayed_nodes;
+            current_level = checkpoint.current_level;
+            flushed_contractor = checkpoint.flushed_contractor;
+            thread_data_list.number_of_nodes = contractor_graph->GetNumberOfNodes();
+            p.PrintStatus(number_of_contracted_nodes);
         }
         else
         {
-            node_depth.resize(number_of_nodes, 0);
-            node_priorities.resize(number_of_nodes);
-            node_levels.resize(number_of_nodes);
-
-            std::cout << "initializing elimination PQ ..." << std::flush;
-            tbb::parallel_for(tbb::blocked_range<int>(0, number_of_nodes, PQGrainSize),
-                              [this, &node_priorities, &node_depth, &thread_data_list](
-                                  const tbb::blocked_range<int> &range) {
-                                  ContractorThreadData *data = thread_data_list.GetThreadData();
+            remaining_nodes.resize(number_of_nodes);
+            // initialize priorities in parallel
+            tbb::parallel_for(tbb::blocked_range<int>(0, number_of_nodes, InitGrainSize),
+                              [this, &remaining_nodes](const tbb::blocked_range<int> &range) {
                                   for (int x = range.begin(), end = range.end(); x != end; ++x)
                                   {
-                                      node_priorities[x] =
-                                          this->EvaluateNodePriority(data, node_depth[x], x);
+                                      remaining_nodes[x].id = x;
                                   }
                               });
-            std::cout << "ok" << std::endl;
+
+            if (use_cached_node_priorities)
+            {
+                std::cout << "using cached node priorities ..." << std::flush;
+                node_priorities.swap(node_levels);
+                std::cout << "ok" << std::endl;
+            }
+            else
+            {
+                node_depth.resize(number_of_nodes, 0);
+                node_priorities.resize(number_of_nodes);
+                node_levels.resize(number_of_nodes);
+
+                std::cout << "initializing elimination PQ ..." << std::flush;
+                ForEachBalancedChunk(
+                    GetBalancedChunks(remaining_nodes, 0, number_of_nodes),
+                    busy_seconds,
+                    [this, &node_priorities, &node_depth, &thread_data_list](
+                        const tbb::blocked_range<std::size_t> &range) {
+                        ContractorThreadData *data = thread_data_list.GetThreadData();
+                        for (auto x = range.begin(), end = range.end(); x != end; ++x)
+                        {
+                            node_priorities[x] =
+                                this->EvaluateNodePriority(data, node_depth[x], x);
+                        }
+                    });
+                std::cout << "ok" << std::endl;
+            }
+            BOOST_ASSERT(node_priorities.size() == number_of_nodes);
+        }
+
+        // see ReorderDirtyNodes
+        const bool reorder_dirty_nodes = !previous_node_levels.empty();
+        std::vector<NodeID> reordered_nodes;
+        std::vector<char> is_reordered;
+        std::vector<float> reordered_priorities;
+        if (reorder_dirty_nodes)
+        {
+            // the order changes, so the new levels are written like without cached levels
+            node_levels.resize(number_of_nodes);
+            node_depth.resize(number_of_nodes, 0);
+            is_reordered.resize(number_of_nodes, false);
+            reordered_priorities.resize(number_of_nodes);
+            for (const auto &node_data : remaining_nodes)
+            {
+                if (is_dirty[node_data.id])
+                {
+                    reordered_nodes.push_back(node_data.id);
+                    is_reordered[node_data.id] = true;
+                }
+            }
+            EvaluateNodePriorities(reordered_nodes,
+                                   node_depth,
+                                   reordered_priorities,
+                                   thread_data_list,
+                                   busy_seconds);
+            util::SimpleLogger().Write() << "re-ordering " << reordered_nodes.size() << " nodes";
         }
-        BOOST_ASSERT(node_priorities.size() == number_of_nodes);
 
         std::cout << "preprocessing " << number_of_nodes << " nodes ..." << std::flush;
 
-        unsigned current_level = 0;
-        bool flushed_contractor = false;
         while (number_of_nodes > 2 &&
                number_of_contracted_nodes < static_cast<NodeID>(number_of_nodes * core_factor))
         {
-            if (!flushed_contractor && (number_of_contracted_nodes >
-                                        static_cast<NodeID>(number_of_nodes * 0.65 * core_factor)))
+            if (!incremental && !flushed_contractor &&
+                (number_of_contracted_nodes >
+                 static_cast<NodeID>(number_of_nodes * 0.65 * core_factor)))
             {
                 util::DeallocatingVector<ContractorEdge>
                     new_edge_set; // this one is not explicitely
@@ -428,6 +697,11 @@ class GraphContractor
                 thread_data_list.number_of_nodes = contractor_graph->GetNumberOfNodes();
             }
 
+            if (reorder_dirty_nodes)
+            {
+                RankReorderedNodes(reordered_nodes, reordered_priorities, node_priorities);
+            }
+
             tbb::parallel_for(
                 tbb::blocked_range<std::size_t>(0, remaining_nodes.size(), IndependentGrainSize),
                 [this, &node_priorities, &remaining_nodes, &thread_data_list](
@@ -451,7 +725,7 @@ class GraphContractor
                 std::distance(remaining_nodes.begin(), begin_independent_nodes);
             auto end_independent_nodes_idx = remaining_nodes.size();
 
-            if (!use_cached_node_priorities)
+            if (!use_cached_node_priorities || reorder_dirty_nodes)
             {
                 // write out contraction level
                 tbb::parallel_for(
@@ -480,21 +754,58 @@ class GraphContractor
                     });
             }
 
+            for (auto &seconds : busy_seconds)
+            {
+                seconds = 0.;
+            }
+            const auto round_start = tbb::tick_count::now();
+            const auto chunks = GetBalancedChunks(
+                remaining_nodes, begin_independent_nodes_idx, end_independent_nodes_idx);
+
             // contract independent nodes
-            tbb::parallel_for(
-                tbb::blocked_range<std::size_t>(
-                    begin_independent_nodes_idx, end_independent_nodes_idx, ContractGrainSize),
-                [this, &remaining_nodes, &thread_data_list](
+            ForEachBalancedChunk(
+                chunks,
+                busy_seconds,
+                [this, incremental, &remaining_nodes, &thread_data_list](
                     const tbb::blocked_range<std::size_t> &range) {
                     ContractorThreadData *data = thread_data_list.GetThreadData();
                     for (int position = range.begin(), end = range.end(); position != end;
                          ++position)
                     {
                         const NodeID x = remaining_nodes[position].id;
-                        this->ContractNode<false>(data, x);
+                        if (!incremental)
+                        {
+                            this->ContractNode<false>(data, x);
+                            continue;
+                        }
+
+                        const std::size_t first_inserted_edge = data->inserted_edges.size();
+                        if (is_dirty[x] || !this->ReplayNode(data, x))
+                        {
+                            is_dirty[x] = true;
+                            this->ContractNode<false>(data, x);
+                        }
+                        this->MarkNeighboursOnChange(data, x, first_inserted_edge);
                     }
                 });
 
+            if (incremental)
+            {
+                for (const auto position : util::irange<std::size_t>(
+                         begin_independent_nodes_idx, end_independent_nodes_idx))
+                {
+                    number_of_replayed_nodes += !is_dirty[remaining_nodes[position].id];
+                }
+                for (auto &data : thread_data_list.data)
+                {
+                    for (const NodeID node : data->dirty_nodes)
+                    {
+                        is_dirty[node] = true;
+                    }
+                    data->dirty_nodes.clear();
+                }
+            }
+
             tbb::parallel_for(
                 tbb::blocked_range<int>(
                     begin_independent_nodes_idx, end_independent_nodes_idx, DeleteGrainSize),
@@ -542,30 +853,112 @@ class GraphContractor
                 data->inserted_edges.clear();
             }
 
-            if (!use_cached_node_priorities)
+            // Nodes that outgrow their block leave the old one behind, the graph is compacted once
+            // the unused slots take half as much memory as the edges.
+            if (contractor_graph->GetEdgeCapacity() >
+                CompactionFactor * contractor_graph->GetNumberOfEdges())
+            {
+                TIMER_START(compact);
+                const auto capacity = contractor_graph->GetEdgeCapacity();
+                contractor_graph->Compact();
+                TIMER_STOP(compact);
+                util::SimpleLogger().Write(logDEBUG)
+                    << "compacted " << capacity << " edge slots to "
+                    << contractor_graph->GetEdgeCapacity() << " in " << TIMER_SEC(compact) << "s";
+            }
+
+            if (reorder_dirty_nodes)
             {
+                for (const auto position : util::irange<std::size_t>(
+                         begin_independent_nodes_idx, end_independent_nodes_idx))
+                {
+                    is_reordered[remaining_nodes[position].id] = false;
+                }
+                reordered_nodes.erase(std::remove_if(reordered_nodes.begin(),
+                                                     reordered_nodes.end(),
+                                                     [&is_reordered](const NodeID node) {
+                                                         return !is_reordered[node];
+                                                     }),
+                                      reordered_nodes.end());
+            }
+
+            if (!use_cached_node_priorities || reorder_dirty_nodes)
+            {
+                // Lazy updates: a node next to several contracted nodes is re-evaluated once,
+                // after all of them are contracted, instead of once per contracted neighbour.
                 tbb::parallel_for(
-                    tbb::blocked_range<int>(begin_independent_nodes_idx,
-                                            end_independent_nodes_idx,
-                                            NeighboursGrainSize),
-                    [this, &node_priorities, &remaining_nodes, &node_depth, &thread_data_list](
-                        const tbb::blocked_range<int> &range) {
+                    tbb::blocked_range<std::size_t>(
+                        begin_independent_nodes_idx, end_independent_nodes_idx, ContractGrainSize),
+                    [this, &remaining_nodes, &node_depth, &thread_data_list](
+                        const tbb::blocked_range<std::size_t> &range) {
                         ContractorThreadData *data = thread_data_list.GetThreadData();
-                        for (int position = range.begin(), end = range.end(); position != end;
+                        for (auto position = range.begin(), end = range.end(); position != end;
                              ++position)
                         {
-                            NodeID x = remaining_nodes[position].id;
-                            this->UpdateNodeNeighbours(node_priorities, node_depth, data, x);
+                            this->MarkNeighboursStale(
+                                data, node_depth, remaining_nodes[position].id);
                         }
                     });
+
+                auto stale_nodes = MergeStaleNeighbours(thread_data_list, node_depth);
+                if (use_cached_node_priorities)
+                {
+                    // only the re-ordered nodes have priorities besides their cached levels
+                    stale_nodes.erase(std::remove_if(stale_nodes.begin(),
+                                                     stale_nodes.end(),
+                                                     [&is_reordered](const NodeID node) {
+                                                         return !is_reordered[node];
+                                                     }),
+                                      stale_nodes.end());
+                }
+                EvaluateNodePriorities(stale_nodes,
+                                       node_depth,
+                                       use_cached_node_priorities ? reordered_priorities
+                                                                  : node_priorities,
+                                       thread_data_list,
+                                       busy_seconds);
             }
 
+            // The contraction and the neighbour updates are the parts with witness searches, the
+            // sorting and inserting of edges in between is not counted.
+            const auto round_busy_seconds = busy_seconds.combine(std::plus<double>());
+            const auto round_available_seconds =
+                busy_seconds.size() * (tbb::tick_count::now() - round_start).seconds();
+            total_busy_seconds += round_busy_seconds;
+            total_available_seconds += round_available_seconds;
+            util::SimpleLogger().Write(logDEBUG)
+                << "level " << current_level << ": contracted "
+                << (end_independent_nodes_idx - begin_independent_nodes_idx) << " nodes in "
+                << (chunks.size() - 1) << " chunks, " << busy_seconds.size() << " threads "
+                << static_cast<int>(100 * round_busy_seconds /
+                                    std::max(round_available_seconds, 1e-9))
+                << "% busy";
+
             // remove contracted nodes from the pool
             number_of_contracted_nodes += end_independent_nodes_idx - begin_independent_nodes_idx;
             remaining_nodes.resize(begin_independent_nodes_idx);
 
             p.PrintStatus(number_of_contracted_nodes);
             ++current_level;
+
+            const bool interrupted = interrupt_flag && interrupt_flag->load();
+            if (!checkpoint_path.empty() &&
+                (interrupted ||
+                 (tbb::tick_count::now() - last_checkpoint).seconds() >= checkpoint_interval))
+            {
+                checkpoint.number_of_contracted_nodes = number_of_contracted_nodes;
+                checkpoint.number_of_replayed_nodes = number_of_replayed_nodes;
+                checkpoint.current_level = current_level;
+                checkpoint.flushed_contractor = flushed_contractor;
+                WriteCheckpoint(checkpoint, remaining_nodes, node_priorities, node_depth);
+                last_checkpoint = tbb::tick_count::now();
+            }
+            if (interrupted)
+            {
+                std::cout << " [interrupted]" << std::endl;
+                thread_data_list.data.clear();
+                return false;
+            }
         }
 
         if (remaining_nodes.size() > 2)
@@ -601,11 +994,29 @@ class GraphContractor
             is_core_node.clear();
         }
 
+        util::SimpleLogger().Write()
+            << "[contraction] threads were busy "
+            << static_cast<int>(100 * total_busy_seconds / std::max(total_available_seconds, 1e-9))
+            << "% of the time in witness searches";
         util::SimpleLogger().Write() << "[core] " << remaining_nodes.size() << " nodes "
                                      << contractor_graph->GetNumberOfEdges() << " edges."
                                      << std::endl;
+        if (incremental)
+        {
+            util::SimpleLogger().Write() << "[incremental] replayed " << number_of_replayed_nodes
+                                         << " nodes, re-contracted "
+                                         << (number_of_contracted_nodes - number_of_replayed_nodes)
+                                         << " nodes";
+        }
 
         thread_data_list.data.clear();
+
+        if (!checkpoint_path.empty())
+        {
+            boost::filesystem::remove(checkpoint_path);
+            boost::filesystem::remove(checkpoint_path + ".external");
+        }
+        return true;
     }
 
     inline void GetCoreMarker(std::vector<bool> &out_is_core_node)
@@ -675,6 +1086,311 @@ class GraphContractor
     }
 
   private:
+    // estimating the cost is cheap compared to contracting, so it uses a big grain size
+    static const constexpr std::size_t BalanceGrainSize = 10000;
+    // enough chunks to keep many threads busy until the end of a round
+    static const constexpr std::size_t NumberOfBalancedChunks = 1024;
+    // ratio of edge slots to edges at which the graph is compacted
+    static const constexpr double CompactionFactor = 1.5;
+
+    static NodeID GetNodeID(const RemainingNodeData &node_data) { return node_data.id; }
+    static NodeID GetNodeID(const NodeID node) { return node; }
+
+    // Positions in [begin, end) of nodes at which chunks of about the same estimated contraction
+    // cost start, followed by end. The witness searches of a node grow with the product of its in-
+    // and out-degree, so chunks with the same number of nodes differ a lot in cost.
+    template <typename NodeContainer>
+    std::vector<std::size_t>
+    GetBalancedChunks(const NodeContainer &nodes,
+                      const std::size_t begin,
+                      const std::size_t end) const
+    {
+        if (begin == end)
+        {
+            return {begin, end};
+        }
+
+        std::vector<std::uint64_t> cost(end - begin);
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(begin, end, BalanceGrainSize),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto position = range.begin(); position != range.end();
+                                   ++position)
+                              {
+                                  std::uint64_t in_degree = 0, out_degree = 0;
+                                  for (auto edge : contractor_graph->GetAdjacentEdgeRange(
+                                           GetNodeID(nodes[position])))
+                                  {
+                                      const auto &data = contractor_graph->GetEdgeData(edge);
+                                      in_degree += data.backward;
+                                      out_degree += data.forward;
+                                  }
+                                  cost[position - begin] = (in_degree + 1) * (out_degree + 1);
+                              }
+                          });
+        std::partial_sum(cost.begin(), cost.end(), cost.begin());
+
+        const auto number_of_chunks = std::min(end - begin, std::size_t{NumberOfBalancedChunks});
+        std::vector<std::size_t> chunk_begins;
+        chunk_begins.reserve(number_of_chunks + 1);
+        chunk_begins.push_back(begin);
+        for (const auto chunk : util::irange<std::size_t>(1, number_of_chunks))
+        {
+            const auto chunk_cost = cost.back() * chunk / number_of_chunks;
+            const auto position =
+                begin + (std::upper_bound(cost.begin(), cost.end(), chunk_cost) - cost.begin());
+            if (position > chunk_begins.back() && position < end)
+            {
+                chunk_begins.push_back(position);
+            }
+        }
+        chunk_begins.push_back(end);
+        return chunk_begins;
+    }
+
+    // Runs function on every chunk, the chunks are distributed by work stealing and the time a
+    // thread spends on them is added to its busy_seconds.
+    template <typename Function>
+    static void ForEachBalancedChunk(const std::vector<std::size_t> &chunk_begins,
+                                     tbb::enumerable_thread_specific<double> &busy_seconds,
+                                     const Function &function)
+    {
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, chunk_begins.size() - 1, 1),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              const auto start = tbb::tick_count::now();
+                              for (auto chunk = range.begin(); chunk != range.end(); ++chunk)
+                              {
+                                  function(tbb::blocked_range<std::size_t>(
+                                      chunk_begins[chunk], chunk_begins[chunk + 1]));
+                              }
+                              busy_seconds.local() += (tbb::tick_count::now() - start).seconds();
+                          });
+    }
+
+    // The scalar state of Run after a round, followed in the checkpoint by the vectors of the state
+    struct CheckpointHeader
+    {
+        std::uint64_t graph_checksum = 0;
+        std::uint64_t number_of_external_edges = 0;
+        std::uint64_t number_of_replayed_nodes = 0;
+        double core_factor = 0;
+        NodeID number_of_input_nodes = 0;
+        NodeID number_of_graph_nodes = 0;
+        NodeID number_of_contracted_nodes = 0;
+        std::uint32_t current_level = 0;
+        bool flushed_contractor = false;
+        bool use_cached_node_priorities = false;
+        bool incremental = false;
+        bool reorder_dirty_nodes = false;
+    };
+
+    // Identifies the input of a run, a checkpoint is only resumed with the same graph and weights
+    std::uint64_t GetGraphChecksum() const
+    {
+        std::uint64_t checksum = 14695981039346656037ULL;
+        const auto combine = [&checksum](const std::uint64_t value) {
+            checksum = (checksum ^ value) * 1099511628211ULL;
+        };
+        for (const auto node : util::irange<NodeID>(0, contractor_graph->GetNumberOfNodes()))
+        {
+            for (auto edge : contractor_graph->GetAdjacentEdgeRange(node))
+            {
+                const ContractorEdgeData &data = contractor_graph->GetEdgeData(edge);
+                combine(node);
+                combine(contractor_graph->GetTarget(edge));
+                combine(data.distance);
+                combine(data.id);
+                combine(data.forward | (data.backward << 1));
+            }
+        }
+        for (const auto weight : node_weights)
+        {
+            combine(weight);
+        }
+        for (const auto level : node_levels)
+        {
+            combine(static_cast<std::uint64_t>(level));
+        }
+        return checksum;
+    }
+
+    void WriteCheckpoint(const CheckpointHeader &checkpoint,
+                         const std::vector<RemainingNodeData> &remaining_nodes,
+                         const std::vector<float> &node_priorities,
+                         const std::vector<NodeDepth> &node_depth)
+    {
+        TIMER_START(write_checkpoint);
+        const auto external_path = checkpoint_path + ".external";
+        const auto temporary_path = checkpoint_path + ".tmp";
+        const constexpr std::size_t WriteBufferSize = 1024;
+
+        // Edges are only ever appended to external_edge_list, so only the new ones are written.
+        // A failed earlier attempt may have left edges behind the last checkpoint.
+        boost::system::error_code error;
+        if (boost::filesystem::exists(external_path))
+        {
+            boost::filesystem::resize_file(
+                external_path, number_of_checkpointed_external_edges * sizeof(QueryEdge), error);
+        }
+        std::ofstream external_stream(external_path, std::ios::binary | std::ios::app);
+        std::vector<QueryEdge> external_buffer;
+        external_buffer.reserve(WriteBufferSize);
+        for (auto index = number_of_checkpointed_external_edges; index < external_edge_list.size();
+             ++index)
+        {
+            external_buffer.push_back(external_edge_list[index]);
+            if (external_buffer.size() == WriteBufferSize || index + 1 == external_edge_list.size())
+            {
+                external_stream.write(reinterpret_cast<const char *>(external_buffer.data()),
+                                      external_buffer.size() * sizeof(QueryEdge));
+                external_buffer.clear();
+            }
+        }
+        external_stream.close();
+
+        CheckpointHeader header = checkpoint;
+        header.number_of_graph_nodes = contractor_graph->GetNumberOfNodes();
+        header.number_of_external_edges = external_edge_list.size();
+
+        std::ofstream stream(temporary_path, std::ios::binary);
+        util::writeFingerprint(stream);
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        util::serializeVector(stream, remaining_nodes);
+        util::serializeVector(stream, node_priorities);
+        util::serializeVector(stream, node_depth);
+        util::serializeVector(stream, node_levels);
+        util::serializeVector(stream, node_weights);
+        util::serializeVector(stream, orig_node_id_from_new_node_id_map);
+        util::serializeVector(stream, is_dirty);
+        // the order of the edges of a node decides which shortcuts get added, a resumed run only
+        // matches an uninterrupted one if the graph changes exactly as before
+        contractor_graph->Write(stream);
+        stream.close();
+
+        // a failed checkpoint leaves the previous one intact, the contraction goes on regardless
+        if (!external_stream || !stream)
+        {
+            util::SimpleLogger().Write(logWARNING) << "Failed writing checkpoint "
+                                                   << checkpoint_path;
+            return;
+        }
+        boost::filesystem::rename(temporary_path, checkpoint_path, error);
+        if (error)
+        {
+            util::SimpleLogger().Write(logWARNING) << "Failed writing checkpoint "
+                                                   << checkpoint_path << ": " << error.message();
+            return;
+        }
+        number_of_checkpointed_external_edges = header.number_of_external_edges;
+        TIMER_STOP(write_checkpoint);
+
+        util::SimpleLogger().Write() << "[checkpoint] level " << header.current_level << ", "
+                                     << header.number_of_contracted_nodes
+                                     << " nodes contracted, written in "
+                                     << TIMER_SEC(write_checkpoint) << "s";
+    }
+
+    // Restores the state written by WriteCheckpoint if it was written for the same input as
+    // checkpoint describes. On failure the state is left as it was.
+    bool ReadCheckpoint(CheckpointHeader &checkpoint,
+                        std::vector<RemainingNodeData> &remaining_nodes,
+                        std::vector<float> &node_priorities,
+                        std::vector<NodeDepth> &node_depth)
+    {
+        const auto external_path = checkpoint_path + ".external";
+        number_of_checkpointed_external_edges = 0;
+        if (!boost::filesystem::exists(checkpoint_path))
+        {
+            boost::filesystem::remove(external_path);
+            return false;
+        }
+
+        TIMER_START(read_checkpoint);
+        std::ifstream stream(checkpoint_path, std::ios::binary);
+        CheckpointHeader header;
+        if (!util::readAndCheckFingerprint(stream) ||
+            !stream.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+            header.graph_checksum != checkpoint.graph_checksum ||
+            header.number_of_input_nodes != checkpoint.number_of_input_nodes ||
+            header.core_factor != checkpoint.core_factor ||
+            header.use_cached_node_priorities != checkpoint.use_cached_node_priorities ||
+            header.incremental != checkpoint.incremental ||
+            header.reorder_dirty_nodes != checkpoint.reorder_dirty_nodes)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << checkpoint_path << " was written for a different input, contracting from the "
+                << "start";
+            boost::filesystem::remove(external_path);
+            return false;
+        }
+
+        std::vector<RemainingNodeData> checkpoint_remaining_nodes;
+        std::vector<float> checkpoint_node_priorities;
+        std::vector<NodeDepth> checkpoint_node_depth;
+        std::vector<float> checkpoint_node_levels;
+        std::vector<EdgeWeight> checkpoint_node_weights;
+        std::vector<NodeID> checkpoint_orig_node_ids;
+        std::vector<char> checkpoint_is_dirty;
+        auto checkpoint_graph = std::make_shared<ContractorGraph>(0);
+        bool complete = util::deserializeVector(stream, checkpoint_remaining_nodes) &&
+                        util::deserializeVector(stream, checkpoint_node_priorities) &&
+                        util::deserializeVector(stream, checkpoint_node_depth) &&
+                        util::deserializeVector(stream, checkpoint_node_levels) &&
+                        util::deserializeVector(stream, checkpoint_node_weights) &&
+                        util::deserializeVector(stream, checkpoint_orig_node_ids) &&
+                        util::deserializeVector(stream, checkpoint_is_dirty) &&
+                        checkpoint_graph->Read(stream) &&
+                        checkpoint_graph->GetNumberOfNodes() == header.number_of_graph_nodes;
+
+        const constexpr std::size_t ReadBufferSize = 1024;
+        std::ifstream external_stream(external_path, std::ios::binary);
+        std::vector<QueryEdge> external_buffer(ReadBufferSize);
+        const auto number_of_external_edges = header.number_of_external_edges;
+        for (std::uint64_t read_edges = 0; complete && read_edges < number_of_external_edges;)
+        {
+            const auto count =
+                std::min<std::uint64_t>(ReadBufferSize, number_of_external_edges - read_edges);
+            complete = static_cast<bool>(external_stream.read(
+                reinterpret_cast<char *>(external_buffer.data()), count * sizeof(QueryEdge)));
+            for (const auto index : util::irange<std::size_t>(0, complete ? count : 0))
+            {
+                external_edge_list.push_back(external_buffer[index]);
+            }
+            read_edges += count;
+        }
+        external_stream.close();
+
+        if (!complete)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << checkpoint_path << " is incomplete, contracting from the start";
+            external_edge_list.clear();
+            boost::filesystem::remove(external_path);
+            return false;
+        }
+
+        remaining_nodes.swap(checkpoint_remaining_nodes);
+        node_priorities.swap(checkpoint_node_priorities);
+        node_depth.swap(checkpoint_node_depth);
+        node_levels.swap(checkpoint_node_levels);
+        node_weights.swap(checkpoint_node_weights);
+        orig_node_id_from_new_node_id_map.swap(checkpoint_orig_node_ids);
+        is_dirty.swap(checkpoint_is_dirty);
+        contractor_graph = std::move(checkpoint_graph);
+
+        // drop edges of a checkpoint that was not completed
+        boost::filesystem::resize_file(external_path,
+                                       header.number_of_external_edges * sizeof(QueryEdge));
+        number_of_checkpointed_external_edges = header.number_of_external_edges;
+        checkpoint = header;
+        TIMER_STOP(read_checkpoint);
+
+        util::SimpleLogger().Write() << "resuming contraction at level " << header.current_level
+                                     << " with " << header.number_of_contracted_nodes
+                                     << " nodes contracted, read checkpoint in "
+                                     << TIMER_SEC(read_checkpoint) << "s";
+        return true;
+    }
+
     inline void RelaxNode(const NodeID node,
                           const NodeID forbidden_node,
                           const int distance,
@@ -934,43 +1650,148 @@ class GraphContractor
 
         if (!RUNSIMULATION)
         {
-            std::size_t iend = inserted_edges.size();
-            for (std::size_t i = inserted_edges_size; i < iend; ++i)
+            RemoveDuplicateInsertedEdges(inserted_edges, inserted_edges_size);
+        }
+        return true;
+    }
+
+    // Merges the shortcuts from inserted_edges_size onwards that only differ in their direction
+    inline void RemoveDuplicateInsertedEdges(std::vector<ContractorEdge> &inserted_edges,
+                                             std::size_t inserted_edges_size) const
+    {
+        std::size_t iend = inserted_edges.size();
+        for (std::size_t i = inserted_edges_size; i < iend; ++i)
+        {
+            bool found = false;
+            for (std::size_t other = i + 1; other < iend; ++other)
             {
-                bool found = false;
-                for (std::size_t other = i + 1; other < iend; ++other)
+                if (inserted_edges[other].source != inserted_edges[i].source)
                 {
-                    if (inserted_edges[other].source != inserted_edges[i].source)
-                    {
-                        continue;
-                    }
-                    if (inserted_edges[other].target != inserted_edges[i].target)
-                    {
-                        continue;
-                    }
-                    if (inserted_edges[other].data.distance != inserted_edges[i].data.distance)
-                    {
-                        continue;
-                    }
-                    if (inserted_edges[other].data.shortcut != inserted_edges[i].data.shortcut)
-                    {
-                        continue;
-                    }
-                    inserted_edges[other].data.forward |= inserted_edges[i].data.forward;
-                    inserted_edges[other].data.backward |= inserted_edges[i].data.backward;
-                    found = true;
-                    break;
+                    continue;
+                }
+                if (inserted_edges[other].target != inserted_edges[i].target)
+                {
+                    continue;
                 }
-                if (!found)
+                if (inserted_edges[other].data.distance != inserted_edges[i].data.distance)
                 {
-                    inserted_edges[inserted_edges_size++] = inserted_edges[i];
+                    continue;
                 }
+                if (inserted_edges[other].data.shortcut != inserted_edges[i].data.shortcut)
+                {
+                    continue;
+                }
+                inserted_edges[other].data.forward |= inserted_edges[i].data.forward;
+                inserted_edges[other].data.backward |= inserted_edges[i].data.backward;
+                found = true;
+                break;
+            }
+            if (!found)
+            {
+                inserted_edges[inserted_edges_size++] = inserted_edges[i];
             }
-            inserted_edges.resize(inserted_edges_size);
         }
+        inserted_edges.resize(inserted_edges_size);
+    }
+
+    // Re-inserts the shortcuts the previous hierarchy created for node, with weights taken from the
+    // current graph. Returns false if one of the required arcs does not exist anymore or if a
+    // re-ordered neighbour was contracted before node in the previous hierarchy.
+    inline bool ReplayNode(ContractorThreadData *data, const NodeID node)
+    {
+        std::vector<ContractorEdge> &inserted_edges = data->inserted_edges;
+        const std::size_t inserted_edges_size = inserted_edges.size();
+
+        if (!previous_node_levels.empty())
+        {
+            for (auto edge : contractor_graph->GetAdjacentEdgeRange(node))
+            {
+                if (previous_node_levels[contractor_graph->GetTarget(edge)] <
+                    previous_node_levels[node])
+                {
+                    return false;
+                }
+            }
+        }
+
+        const auto find_arc = [this, node](const NodeID other, const bool towards_node) {
+            const ContractorEdgeData *best = nullptr;
+            for (auto edge : contractor_graph->GetAdjacentEdgeRange(node))
+            {
+                const ContractorEdgeData &edge_data = contractor_graph->GetEdgeData(edge);
+                if (contractor_graph->GetTarget(edge) != other ||
+                    !(towards_node ? edge_data.backward : edge_data.forward))
+                {
+                    continue;
+                }
+                if (best == nullptr || edge_data.distance < best->distance)
+                {
+                    best = &edge_data;
+                }
+            }
+            return best;
+        };
+
+        for (auto index = previous_shortcut_offsets[node];
+             index != previous_shortcut_offsets[node + 1];
+             ++index)
+        {
+            const PreviousArc &arc = previous_shortcuts[index];
+            const ContractorEdgeData *in_data = find_arc(arc.from, true);
+            const ContractorEdgeData *out_data = find_arc(arc.to, false);
+            if (in_data == nullptr || out_data == nullptr)
+            {
+                inserted_edges.resize(inserted_edges_size);
+                return false;
+            }
+
+            const EdgeWeight path_distance = in_data->distance + out_data->distance;
+            const unsigned original_edges = in_data->originalEdges + out_data->originalEdges;
+            inserted_edges.emplace_back(
+                arc.from, arc.to, path_distance, original_edges, node, true, true, false);
+            inserted_edges.emplace_back(
+                arc.to, arc.from, path_distance, original_edges, node, true, false, true);
+        }
+        RemoveDuplicateInsertedEdges(inserted_edges, inserted_edges_size);
         return true;
     }
 
+    // Compares the shortcuts inserted for node with the previous hierarchy and marks all neighbours
+    // of node for re-contraction if they differ, since their witness searches depend on them.
+    inline void MarkNeighboursOnChange(ContractorThreadData *data,
+                                       const NodeID node,
+                                       const std::size_t first_inserted_edge)
+    {
+        std::vector<PreviousArc> arcs;
+        for (auto index = first_inserted_edge; index != data->inserted_edges.size(); ++index)
+        {
+            const ContractorEdge &edge = data->inserted_edges[index];
+            if (edge.data.forward)
+            {
+                arcs.push_back(
+                    {edge.source, edge.target, static_cast<EdgeWeight>(edge.data.distance)});
+            }
+        }
+        std::sort(arcs.begin(), arcs.end());
+
+        const auto previous_begin = previous_shortcuts.begin() + previous_shortcut_offsets[node];
+        const auto previous_end = previous_shortcuts.begin() + previous_shortcut_offsets[node + 1];
+        if (arcs.size() == static_cast<std::size_t>(std::distance(previous_begin, previous_end)) &&
+            std::equal(arcs.begin(), arcs.end(), previous_begin))
+        {
+            return;
+        }
+
+        for (auto edge : contractor_graph->GetAdjacentEdgeRange(node))
+        {
+            const NodeID target = contractor_graph->GetTarget(edge);
+            if (target != node)
+            {
+                data->dirty_nodes.push_back(target);
+            }
+        }
+    }
+
     inline void DeleteIncomingEdges(ContractorThreadData *data, const NodeID node)
     {
         std::vector<NodeID> &neighbours = data->neighbours;
@@ -995,35 +1816,82 @@ class GraphContractor
         }
     }
 
-    inline bool UpdateNodeNeighbours(std::vector<float> &priorities,
-                                     std::vector<NodeDepth> &node_depth,
-                                     ContractorThreadData *const data,
-                                     const NodeID node)
+    // Sets the priorities of nodes in parallel
+    void EvaluateNodePriorities(const std::vector<NodeID> &nodes,
+                                const std::vector<NodeDepth> &node_depth,
+                                std::vector<float> &priorities,
+                                ThreadDataContainer &thread_data_list,
+                                tbb::enumerable_thread_specific<double> &busy_seconds)
     {
-        std::vector<NodeID> &neighbours = data->neighbours;
-        neighbours.clear();
+        ForEachBalancedChunk(
+            GetBalancedChunks(nodes, 0, nodes.size()),
+            busy_seconds,
+            [this, &nodes, &node_depth, &priorities, &thread_data_list](
+                const tbb::blocked_range<std::size_t> &range) {
+                ContractorThreadData *data = thread_data_list.GetThreadData();
+                for (auto position = range.begin(), end = range.end(); position != end; ++position)
+                {
+                    const NodeID u = nodes[position];
+                    priorities[u] = this->EvaluateNodePriority(data, node_depth[u], u);
+                }
+            });
+    }
 
-        // find all neighbours
+    // Gives the remaining re-ordered nodes their levels in the order of their priorities
+    void RankReorderedNodes(std::vector<NodeID> &nodes,
+                            const std::vector<float> &priorities,
+                            std::vector<float> &levels) const
+    {
+        std::vector<float> free_levels(nodes.size());
+        std::transform(nodes.begin(), nodes.end(), free_levels.begin(), [&levels](const NodeID u) {
+            return levels[u];
+        });
+        std::sort(free_levels.begin(), free_levels.end());
+        std::sort(nodes.begin(),
+                  nodes.end(),
+                  [this, &priorities](const NodeID lhs, const NodeID rhs) {
+                      return priorities[lhs] < priorities[rhs] ||
+                             (priorities[lhs] == priorities[rhs] && Bias(rhs, lhs));
+                  });
+        for (const auto rank : util::irange<std::size_t>(0, nodes.size()))
+        {
+            levels[nodes[rank]] = free_levels[rank];
+        }
+    }
+
+    // Remembers the neighbours of a contracted node for re-evaluation, see MergeStaleNeighbours
+    inline void MarkNeighboursStale(ContractorThreadData *const data,
+                                    const std::vector<NodeDepth> &node_depth,
+                                    const NodeID node) const
+    {
         for (auto e : contractor_graph->GetAdjacentEdgeRange(node))
         {
             const NodeID u = contractor_graph->GetTarget(e);
-            if (u == node)
+            if (u != node)
             {
-                continue;
+                data->stale_neighbours.emplace_back(u, node_depth[node] + 1);
             }
-            neighbours.push_back(u);
-            node_depth[u] = std::max(node_depth[node] + 1, node_depth[u]);
         }
-        // eliminate duplicate entries ( forward + backward edges )
-        std::sort(neighbours.begin(), neighbours.end());
-        neighbours.resize(std::unique(neighbours.begin(), neighbours.end()) - neighbours.begin());
+    }
 
-        // re-evaluate priorities of neighboring nodes
-        for (const NodeID u : neighbours)
+    // Raises the depth of all stale neighbours of the round and returns each of them once
+    static std::vector<NodeID> MergeStaleNeighbours(ThreadDataContainer &thread_data_list,
+                                                    std::vector<NodeDepth> &node_depth)
+    {
+        std::vector<NodeID> stale_nodes;
+        for (auto &data : thread_data_list.data)
         {
-            priorities[u] = EvaluateNodePriority(data, node_depth[u], u);
+            for (const auto &neighbour : data->stale_neighbours)
+            {
+                auto &depth = node_depth[neighbour.first];
+                depth = std::max(depth, neighbour.second);
+                stale_nodes.push_back(neighbour.first);
+            }
+            data->stale_neighbours.clear();
         }
-        return true;
+        tbb::parallel_sort(stale_nodes.begin(), stale_nodes.end());
+        stale_nodes.erase(std::unique(stale_nodes.begin(), stale_nodes.end()), stale_nodes.end());
+        return stale_nodes;
     }
 
     inline bool IsNodeIndependent(const std::vector<float> &priorities,
@@ -1117,6 +1985,20 @@ class GraphContractor
     std::vector<EdgeWeight> node_weights;
     std::vector<bool> is_core_node;
     util::XORFastHash<> fast_hash;
+
+    // Shortcuts of the previous hierarchy for incremental contraction, grouped by via node
+    std::vector<std::size_t> previous_shortcut_offsets;
+    std::vector<PreviousArc> previous_shortcuts;
+    // Nodes that need a full re-contraction instead of replaying their previous shortcuts
+    std::vector<char> is_dirty;
+    // The cached levels before ReorderDirtyNodes, empty if the order was not changed
+    std::vector<float> previous_node_levels;
+
+    std::string checkpoint_path;
+    double checkpoint_interval = 0;
+    const std::atomic<bool> *interrupt_flag = nullptr;
+    // The edges of external_edge_list are appended to the .external file of the checkpoint
+    std::uint64_t number_of_checkpointed_external_edges = 0;
 };
 }
 }
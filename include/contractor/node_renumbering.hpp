@@ -0,0 +1,154 @@
+#ifndef OSRM_CONTRACTOR_NODE_RENUMBERING_HPP
+#define OSRM_CONTRACTOR_NODE_RENUMBERING_HPP
+
+#include "contractor/query_edge.hpp"
+
+#include "util/exception.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Computes a new id for every node of the contracted graph, the nodes at the top of the
+// hierarchy come first.
+//
+// Every edge of a contracted node leads to a higher ranked node, so the level of a node is the
+// length of the longest path of stored edges that ends in it. The core, which was not
+// contracted, is put on top of all levels. Within a level the nodes keep their relative order.
+template <typename EdgeContainer>
+std::vector<NodeID> ComputeLevelOrder(const std::size_t number_of_nodes,
+                                      const EdgeContainer &edges,
+                                      const std::vector<bool> &is_core_node)
+{
+    const auto is_core = [&](const NodeID node) {
+        return node < is_core_node.size() && is_core_node[node];
+    };
+    const auto is_upward = [&](const QueryEdge &edge) {
+        return edge.source != edge.target && !is_core(edge.source);
+    };
+
+    // adjacency array of the edges towards higher ranked nodes
+    std::vector<std::size_t> offsets(number_of_nodes + 1, 0);
+    std::vector<std::size_t> in_degree(number_of_nodes, 0);
+    for (const auto &edge : edges)
+    {
+        if (is_upward(edge))
+        {
+            ++offsets[edge.source + 1];
+            ++in_degree[edge.target];
+        }
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<NodeID> targets(offsets.back());
+    std::vector<std::size_t> insert_position(offsets.begin(), offsets.end() - 1);
+    for (const auto &edge : edges)
+    {
+        if (is_upward(edge))
+        {
+            targets[insert_position[edge.source]++] = edge.target;
+        }
+    }
+
+    // topological order, a node is visited once all of its lower ranked neighbours are
+    std::vector<unsigned> levels(number_of_nodes, 0);
+    std::vector<NodeID> queue;
+    queue.reserve(number_of_nodes);
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        if (in_degree[node] == 0)
+        {
+            queue.push_back(node);
+        }
+    }
+    unsigned max_level = 0;
+    for (std::size_t index = 0; index < queue.size(); ++index)
+    {
+        const auto node = queue[index];
+        max_level = std::max(max_level, levels[node]);
+        for (auto edge = offsets[node]; edge < offsets[node + 1]; ++edge)
+        {
+            const auto target = targets[edge];
+            levels[target] = std::max(levels[target], levels[node] + 1);
+            if (--in_degree[target] == 0)
+            {
+                queue.push_back(target);
+            }
+        }
+    }
+    if (queue.size() != number_of_nodes)
+    {
+        throw util::exception("Contracted graph has a cycle, can not order nodes by level");
+    }
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        if (is_core(node))
+        {
+            levels[node] = max_level + 1;
+        }
+    }
+
+    // counting sort by descending level
+    std::vector<std::size_t> level_begin(max_level + 3, 0);
+    for (const auto level : levels)
+    {
+        ++level_begin[max_level + 2 - level];
+    }
+    std::partial_sum(level_begin.begin(), level_begin.end(), level_begin.begin());
+    std::vector<NodeID> new_ids(number_of_nodes);
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        new_ids[node] = static_cast<NodeID>(level_begin[max_level + 1 - levels[node]]++);
+    }
+    return new_ids;
+}
+
+// Maps the end points and the middle nodes of the shortcuts to their new ids
+template <typename EdgeContainer>
+void RenumberQueryEdges(EdgeContainer &edges, const std::vector<NodeID> &new_ids)
+{
+    for (auto &edge : edges)
+    {
+        BOOST_ASSERT(edge.source < new_ids.size() && edge.target < new_ids.size());
+        edge.source = new_ids[edge.source];
+        edge.target = new_ids[edge.target];
+        if (edge.data.shortcut)
+        {
+            BOOST_ASSERT(edge.data.id < new_ids.size());
+            edge.data.id = new_ids[edge.data.id];
+        }
+    }
+}
+
+inline std::vector<bool> RenumberNodeMarkers(const std::vector<bool> &markers,
+                                             const std::vector<NodeID> &new_ids)
+{
+    std::vector<bool> renumbered(markers.size(), false);
+    for (std::size_t node = 0; node < markers.size(); ++node)
+    {
+        renumbered[new_ids[node]] = markers[node];
+    }
+    return renumbered;
+}
+
+inline std::vector<NodeID> InvertNodeOrder(const std::vector<NodeID> &new_ids)
+{
+    std::vector<NodeID> old_ids(new_ids.size());
+    for (std::size_t node = 0; node < new_ids.size(); ++node)
+    {
+        old_ids[new_ids[node]] = static_cast<NodeID>(node);
+    }
+    return old_ids;
+}
+}
+}
+
+#endif // OSRM_CONTRACTOR_NODE_RENUMBERING_HPP
@@ -0,0 +1,80 @@
+#ifndef OSRM_CONTRACTOR_QUERY_GRAPH_UPDATE_HPP
+#define OSRM_CONTRACTOR_QUERY_GRAPH_UPDATE_HPP
+
+#include "contractor/contractor_config.hpp"
+#include "contractor/query_edge.hpp"
+#include "contractor/traffic_lookup.hpp"
+
+#include "extractor/compressed_edge_container.hpp"
+#include "extractor/edge_classes.hpp"
+#include "extractor/original_edge_data.hpp"
+
+#include "util/static_graph.hpp"
+#include "util/typedefs.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Updates the weights of a contracted graph without contracting it again. The weights of the
+// geometry segments and of the original edges are recomputed for new speeds and the shortcuts are
+// repaired bottom-up, the hierarchy itself is kept. See SharedTrafficUpdate for the caveats.
+namespace query_graph_update
+{
+using QueryGraph = util::StaticGraph<QueryEdge::EdgeData>;
+using GraphNode = QueryGraph::NodeArrayEntry;
+using GraphEdge = QueryGraph::EdgeArrayEntry;
+using CompressedEdge = extractor::CompressedEdgeContainer::CompressedEdge;
+
+// The view of the graph and geometries that are updated in place
+struct QueryGraphData
+{
+    const GraphNode *nodes;
+    GraphEdge *edges;
+    NodeID number_of_nodes;
+
+    const unsigned *geometry_indices;
+    CompressedEdge *geometry_list;
+    std::size_t number_of_geometry_segments;
+
+    EdgeID BeginEdges(const NodeID node) const { return nodes[node].first_edge; }
+    EdgeID EndEdges(const NodeID node) const { return nodes[node + 1].first_edge; }
+};
+
+// Shortcuts are stored at the node with the lower level and the two edges they replace at their
+// middle node, which was contracted before. Returns the nodes in the order their shortcuts can be
+// repaired, grouped into layers whose shortcuts only depend on lower layers.
+std::vector<std::vector<NodeID>> GetShortcutLayers(const QueryGraphData &data);
+
+// Updates the weights of all geometry segments that have a speed, returns their number
+std::size_t UpdateGeometryWeights(const QueryGraphData &data, const SegmentSpeeds &segment_speeds);
+
+// Recomputes the weight of every edge that is not a shortcut and marks the nodes with a changed
+// edge, returns the number of changed edges
+std::size_t UpdateOriginalEdges(const QueryGraphData &data,
+                                const ContractorConfig &config,
+                                const SegmentSpeeds &segment_speeds,
+                                const TurnPenaltyLookup &turn_penalty_lookup,
+                                std::vector<char> &is_changed);
+
+// Gives every edge that is not a shortcut and has one of the classes EXCLUDED_EDGE_WEIGHT and marks
+// the nodes with a changed edge, returns the number of changed edges
+std::size_t ExcludeEdgeClasses(const QueryGraphData &data,
+                               const std::vector<extractor::OriginalEdgeData> &original_edges,
+                               const extractor::EdgeClasses classes,
+                               std::vector<char> &is_changed);
+
+// Recomputes the shortcuts whose middle node has a changed edge, layer by layer. Returns the
+// number of changed shortcuts. Shortcuts over excluded edges keep EXCLUDED_EDGE_WEIGHT. A shortcut
+// for both directions gets the larger of their two weights.
+std::size_t RepairShortcuts(const QueryGraphData &data, std::vector<char> &is_changed);
+}
+}
+}
+
+#endif // OSRM_CONTRACTOR_QUERY_GRAPH_UPDATE_HPP
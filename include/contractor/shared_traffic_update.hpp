@@ -0,0 +1,34 @@
+#ifndef OSRM_CONTRACTOR_SHARED_TRAFFIC_UPDATE_HPP
+#define OSRM_CONTRACTOR_SHARED_TRAFFIC_UPDATE_HPP
+
+#include "contractor/contractor_config.hpp"
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Applies segment speeds and turn penalties to the dataset osrm-datastore loaded into shared
+// memory, without contracting the graph again. The dataset is copied into the unused region where
+// the geometry weights and the weights of the original edges are updated and the shortcut weights
+// are repaired bottom-up, then the copy is published like osrm-datastore publishes a new dataset.
+//
+// The hierarchy itself is kept: a shortcut that was left out because of a witness path is not
+// added when the witness gets slower, so routes can be suboptimal until the graph is contracted
+// again. A shortcut for both directions has one weight, when the update makes them differ it gets
+// the larger one, so routes over the cheaper direction look slower than they are and can also be
+// suboptimal. This is meant for small changes in between regular runs of osrm-contract.
+class SharedTrafficUpdate
+{
+  public:
+    explicit SharedTrafficUpdate(ContractorConfig config);
+
+    int Run();
+
+  private:
+    ContractorConfig config;
+};
+}
+}
+
+#endif // OSRM_CONTRACTOR_SHARED_TRAFFIC_UPDATE_HPP
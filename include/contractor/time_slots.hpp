@@ -0,0 +1,46 @@
+#ifndef OSRM_CONTRACTOR_TIME_SLOTS_HPP
+#define OSRM_CONTRACTOR_TIME_SLOTS_HPP
+
+#include "contractor/contractor_config.hpp"
+#include "extractor/edge_classes.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Start of the .time_slots file. It is followed by one block per time slot and then one per
+// metric: the edge data of all edges of the .hsgr, then the weights of all segments of the
+// .geometry. Time slots and metrics are both weight overlays, overlay i is the i-th block.
+struct TimeSlotsHeader
+{
+    static const constexpr std::uint32_t MAX_METRICS = 32;
+
+    std::uint32_t number_of_slots;
+    // in seconds, slot i covers the departures in [i, i + 1) * slot_duration
+    std::uint32_t slot_duration;
+    std::uint64_t number_of_edges;
+    std::uint64_t number_of_geometry_segments;
+    std::uint32_t number_of_metrics;
+    // the segment weights are stored as EdgeWeight, but all of them fit into this many bytes,
+    // 0 in files of older versions
+    std::uint32_t segment_weight_bytes;
+    // classes metric i + 1 excludes, none for the ones of speed files
+    std::array<extractor::EdgeClasses, MAX_METRICS> metric_excluded_classes;
+
+    std::uint32_t GetNumberOfOverlays() const { return number_of_slots + number_of_metrics; }
+};
+
+// Weights of the contracted graph for times of the day, one slot per file of
+// --time-slot-speed-file, and for further metrics, one per file of --metric-speed-file. Every
+// overlay applies its speeds on top of --segment-speed-file the way osrm-traffic-update does, so
+// all overlays share the hierarchy of the .hsgr and only store weights. The metrics of
+// --exclude-classes use the speeds of the dataset and give the excluded edges EXCLUDED_EDGE_WEIGHT.
+void WriteTimeSlots(const ContractorConfig &config);
+}
+}
+
+#endif // OSRM_CONTRACTOR_TIME_SLOTS_HPP
@@ -0,0 +1,205 @@
+#ifndef OSRM_CONTRACTOR_TRAFFIC_LOOKUP_HPP
+#define OSRM_CONTRACTOR_TRAFFIC_LOOKUP_HPP
+
+#include "contractor/traffic_update_file.hpp"
+#include "extractor/edge_based_graph_factory.hpp"
+#include "util/integer_range.hpp"
+#include "util/make_unique.hpp"
+#include "util/simple_logger.hpp"
+#include "util/typedefs.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Entries of all speed or penalty files. Every file is searched in place, a binary file in its
+// memory mapping, a CSV file after it was parsed and sorted. Later files take precedence.
+template <typename Entry> class TrafficLookup
+{
+    struct File
+    {
+        std::unique_ptr<MappedTrafficFile<Entry>> mapped;
+        std::vector<Entry> parsed;
+        const Entry *begin;
+        const Entry *end;
+    };
+
+  public:
+    TrafficLookup() = default;
+
+    template <typename ParseCSV, typename SortEntries>
+    TrafficLookup(const std::vector<std::string> &filenames,
+                  const ParseCSV &parse_csv,
+                  const SortEntries &sort_entries)
+        : files(filenames.size())
+    {
+        tbb::parallel_for(std::size_t{0}, filenames.size(), [&](const std::size_t idx) {
+            const auto &filename = filenames[idx];
+            auto &file = files[idx];
+            if (IsBinaryTrafficFile(filename))
+            {
+                file.mapped = util::make_unique<MappedTrafficFile<Entry>>(filename);
+                file.begin = file.mapped->begin();
+                file.end = file.mapped->end();
+            }
+            else
+            {
+                file.parsed = parse_csv(filename);
+                sort_entries(file.parsed);
+                file.begin = file.parsed.data();
+                file.end = file.parsed.data() + file.parsed.size();
+            }
+            util::SimpleLogger().Write() << "Loaded " << filename << " with "
+                                         << (file.end - file.begin) << " unique values";
+        });
+    }
+
+    // Returns the entry and the id of its file, which starts at one since zero means the weight was
+    // assigned by the profile. Returns nullptr if no file has an entry for the key.
+    template <typename Key> std::pair<const Entry *, std::uint8_t> Find(const Key &key) const
+    {
+        for (auto idx = files.size(); idx > 0; --idx)
+        {
+            const auto &file = files[idx - 1];
+            const auto entry =
+                std::lower_bound(file.begin, file.end, key, [](const Entry &lhs, const Key &rhs) {
+                    return lhs.Key() < rhs;
+                });
+            if (entry != file.end && entry->Key() == key)
+            {
+                return std::make_pair(entry, static_cast<std::uint8_t>(idx));
+            }
+        }
+        return std::make_pair(nullptr, std::uint8_t{0});
+    }
+
+    // Merges every file with the keys get_key(0) up to get_key(size - 1), which have to be sorted
+    // like the entries, and calls visit(position, entry, file id) for every key with an entry.
+    // The calls for a position come in the order of the files, so the last one takes precedence.
+    // Blocks of keys are merged in parallel, with one search per file for the first key of a
+    // block instead of one per key.
+    template <typename GetKey, typename Visit>
+    void Join(const std::size_t size, const GetKey &get_key, const Visit &visit) const
+    {
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, size, JOIN_GRAIN),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                for (const auto idx : util::irange<std::size_t>(0, files.size()))
+                {
+                    const auto &file = files[idx];
+                    auto entry = std::lower_bound(
+                        file.begin,
+                        file.end,
+                        get_key(range.begin()),
+                        [](const Entry &lhs, const decltype(get_key(0)) &rhs) {
+                            return lhs.Key() < rhs;
+                        });
+                    for (auto position = range.begin(); position < range.end() && entry != file.end;
+                         ++position)
+                    {
+                        const auto key = get_key(position);
+                        while (entry != file.end && entry->Key() < key)
+                        {
+                            ++entry;
+                        }
+                        if (entry != file.end && entry->Key() == key)
+                        {
+                            visit(position, *entry, static_cast<std::uint8_t>(idx + 1));
+                        }
+                    }
+                }
+            });
+    }
+
+  private:
+    // keys merged by one task of Join
+    static const constexpr std::size_t JOIN_GRAIN = 1 << 14;
+
+    std::vector<File> files;
+};
+
+using SegmentSpeedLookup = TrafficLookup<SegmentSpeedEntry>;
+using TurnPenaltyLookup = TrafficLookup<TurnPenaltyEntry>;
+
+inline std::pair<const SegmentSpeedEntry *, std::uint8_t>
+FindSegmentSpeed(const SegmentSpeedLookup &lookup, const OSMNodeID from, const OSMNodeID to)
+{
+    return lookup.Find(
+        std::make_tuple(static_cast<std::uint64_t>(from), static_cast<std::uint64_t>(to)));
+}
+
+inline std::pair<const TurnPenaltyEntry *, std::uint8_t>
+FindTurnPenalty(const TurnPenaltyLookup &lookup,
+                const OSMNodeID from,
+                const OSMNodeID via,
+                const OSMNodeID to)
+{
+    return lookup.Find(std::make_tuple(static_cast<std::uint64_t>(from),
+                                       static_cast<std::uint64_t>(via),
+                                       static_cast<std::uint64_t>(to)));
+}
+
+// This sets the segment weight using the same formula as the EdgeBasedGraphFactory for
+// consistency. The *why* of this formula is lost in the annals of time.
+inline int GetSegmentWeight(const double segment_length, const std::uint32_t speed)
+{
+    return std::max(1, static_cast<int>(std::floor((segment_length * 10.) / (speed / 3.6) + .5)));
+}
+
+// The speeds of a SegmentSpeedLookup for every segment of the .geometry file. osrm-extract writes
+// the segments sorted by their OSM nodes to the .segment_index, which is merged with the speed
+// files in one pass, and the position of the first segment of every edge-based edge.
+class SegmentSpeeds
+{
+  public:
+    SegmentSpeeds() = default;
+
+    // Throws util::exception if the index is missing or truncated
+    SegmentSpeeds(const SegmentSpeedLookup &segment_speed_lookup,
+                  const std::string &segment_index_filename);
+
+    std::size_t GetNumberOfSegments() const { return sources.size(); }
+    std::size_t GetNumberOfEdges() const { return edge_first_segments.size(); }
+
+    // Id of the file with the speed of a segment, zero if it has none, see TrafficLookup::Find
+    std::uint8_t GetSource(const std::size_t segment) const { return sources[segment]; }
+    // Weight of a segment for its speed, only set for segments with a source
+    EdgeWeight GetWeight(const std::size_t segment) const { return weights[segment]; }
+    std::uint32_t GetFirstSegment(const EdgeID edge) const { return edge_first_segments[edge]; }
+
+  private:
+    std::vector<EdgeWeight> weights;
+    std::vector<std::uint8_t> sources;
+    std::vector<std::uint32_t> edge_first_segments;
+};
+
+// Offsets of the segments of every edge-based edge in the .edge_segment_lookup file, the segments
+// of an edge are a header followed by a block per segment.
+std::vector<std::size_t> GetEdgeSegmentOffsets(const char *edge_segment_bytes,
+                                               const std::size_t number_of_edges);
+
+// Weight of an edge-based edge with the speeds of its segments and its turn penalty looked up,
+// falls back to the weights of the profile for everything that has no entry. Empty segment speeds
+// keep the weights of all segments.
+int GetUpdatedEdgeWeight(const char *edge_segments,
+                         const extractor::lookup::PenaltyBlock &penalty,
+                         const SegmentSpeeds &segment_speeds,
+                         const EdgeID edge,
+                         const TurnPenaltyLookup &turn_penalty_lookup);
+}
+}
+
+#endif // OSRM_CONTRACTOR_TRAFFIC_LOOKUP_HPP
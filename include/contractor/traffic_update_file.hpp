@@ -0,0 +1,147 @@
+#ifndef OSRM_CONTRACTOR_TRAFFIC_UPDATE_FILE_HPP
+#define OSRM_CONTRACTOR_TRAFFIC_UPDATE_FILE_HPP
+
+#include "util/exception.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Segment speeds and turn penalties for osrm-contract, either as CSV files or in a binary format
+// that is memory mapped and searched in place. A binary file is a TrafficFileHeader followed by
+// the entries sorted by their key without duplicates.
+
+// from,to,speed in km/h
+struct SegmentSpeedEntry
+{
+    std::uint64_t from;
+    std::uint64_t to;
+    std::uint32_t speed;
+    std::uint32_t reserved;
+
+    std::tuple<std::uint64_t, std::uint64_t> Key() const { return std::make_tuple(from, to); }
+};
+static_assert(sizeof(SegmentSpeedEntry) == 24, "SegmentSpeedEntry must not be padded");
+
+// from,via,to,penalty in seconds
+struct TurnPenaltyEntry
+{
+    std::uint64_t from;
+    std::uint64_t via;
+    std::uint64_t to;
+    double penalty;
+
+    std::tuple<std::uint64_t, std::uint64_t, std::uint64_t> Key() const
+    {
+        return std::make_tuple(from, via, to);
+    }
+};
+static_assert(sizeof(TurnPenaltyEntry) == 32, "TurnPenaltyEntry must not be padded");
+
+struct TrafficFileHeader
+{
+    static constexpr const char MAGIC[8] = {'O', 'S', 'R', 'M', 'T', 'R', 'F', '\0'};
+    static constexpr const std::uint32_t VERSION = 1;
+    enum Kind : std::uint32_t
+    {
+        SEGMENT_SPEEDS = 1,
+        TURN_PENALTIES = 2
+    };
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t kind;
+    std::uint64_t number_of_entries;
+};
+static_assert(sizeof(TrafficFileHeader) == 24, "TrafficFileHeader must not be padded");
+
+template <typename Entry> struct TrafficFileKind;
+template <> struct TrafficFileKind<SegmentSpeedEntry>
+{
+    static constexpr const std::uint32_t value = TrafficFileHeader::SEGMENT_SPEEDS;
+};
+template <> struct TrafficFileKind<TurnPenaltyEntry>
+{
+    static constexpr const std::uint32_t value = TrafficFileHeader::TURN_PENALTIES;
+};
+
+// True if the file starts with the header of the binary format, anything else is read as CSV
+bool IsBinaryTrafficFile(const std::string &filename);
+
+// The CSV parsers split a file into chunks that are parsed in parallel, the entries are returned
+// in file order.
+std::vector<SegmentSpeedEntry> ParseSegmentSpeedCSV(const std::string &filename);
+std::vector<TurnPenaltyEntry> ParseTurnPenaltyCSV(const std::string &filename);
+
+// Sort entries by their key. Like osrm-contract always did for CSV files, the first speed of a
+// segment and the last penalty of a turn in a file is kept.
+void SortSegmentSpeeds(std::vector<SegmentSpeedEntry> &entries);
+void SortTurnPenalties(std::vector<TurnPenaltyEntry> &entries);
+
+// Writes entries that are sorted and unique
+void WriteTrafficFile(const std::string &filename, const std::vector<SegmentSpeedEntry> &entries);
+void WriteTrafficFile(const std::string &filename, const std::vector<TurnPenaltyEntry> &entries);
+
+// Read-only view of the entries of a binary traffic file
+template <typename Entry> class MappedTrafficFile
+{
+  public:
+    explicit MappedTrafficFile(const std::string &filename)
+    {
+        using boost::interprocess::file_mapping;
+        using boost::interprocess::mapped_region;
+        using boost::interprocess::read_only;
+
+        const file_mapping mapping{filename.c_str(), read_only};
+        region = mapped_region{mapping, read_only};
+        region.advise(mapped_region::advice_willneed);
+
+        if (region.get_size() < sizeof(TrafficFileHeader))
+        {
+            throw util::exception("Traffic file " + filename + " is truncated");
+        }
+        TrafficFileHeader header;
+        std::memcpy(&header, region.get_address(), sizeof(header));
+        if (std::memcmp(header.magic, TrafficFileHeader::MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != TrafficFileHeader::VERSION)
+        {
+            throw util::exception("Traffic file " + filename + " has an unsupported format");
+        }
+        if (header.kind != TrafficFileKind<Entry>::value)
+        {
+            throw util::exception("Traffic file " + filename + " contains other data");
+        }
+        if (region.get_size() !=
+            sizeof(TrafficFileHeader) + header.number_of_entries * sizeof(Entry))
+        {
+            throw util::exception("Traffic file " + filename + " is truncated");
+        }
+
+        entries_begin = reinterpret_cast<const Entry *>(
+            static_cast<const char *>(region.get_address()) + sizeof(TrafficFileHeader));
+        entries_end = entries_begin + header.number_of_entries;
+    }
+
+    const Entry *begin() const { return entries_begin; }
+    const Entry *end() const { return entries_end; }
+    std::size_t size() const { return entries_end - entries_begin; }
+
+  private:
+    boost::interprocess::mapped_region region;
+    const Entry *entries_begin;
+    const Entry *entries_end;
+};
+}
+}
+
+#endif // OSRM_CONTRACTOR_TRAFFIC_UPDATE_FILE_HPP
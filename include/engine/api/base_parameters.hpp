@@ -35,6 +35,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/optional.hpp>
 
 #include <algorithm>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -55,16 +56,36 @@ namespace api
  *              optional per coordinate
  *  - bearings: limits the search for segments in the road network to given bearing(s) in degree
  *              towards true north in clockwise direction, optional per coordinate
+ *  - format: encoding of the response, only the Table service supports Binary for now
+ *  - debug: adds the search statistics of the query to JSON responses, see SearchStatistics
  *
  * \see OSRM, Coordinate, Hint, Bearing, RouteParame, RouteParameters, TableParameters,
  *      NearestParameters, TripParameters, MatchParameters and TileParameters
  */
 struct BaseParameters
 {
+    enum class OutputFormatType
+    {
+        JSON,
+        Binary
+    };
+
     std::vector<util::Coordinate> coordinates;
     std::vector<boost::optional<Hint>> hints;
     std::vector<boost::optional<double>> radiuses;
     std::vector<boost::optional<Bearing>> bearings;
+    OutputFormatType format;
+    bool debug = false;
+
+    BaseParameters(std::vector<util::Coordinate> coordinates_ = {},
+                   std::vector<boost::optional<Hint>> hints_ = {},
+                   std::vector<boost::optional<double>> radiuses_ = {},
+                   std::vector<boost::optional<Bearing>> bearings_ = {},
+                   const OutputFormatType format_ = OutputFormatType::JSON)
+        : coordinates(std::move(coordinates_)), hints(std::move(hints_)),
+          radiuses(std::move(radiuses_)), bearings(std::move(bearings_)), format(format_)
+    {
+    }
 
     // FIXME add validation for invalid bearing values
     bool IsValid() const
@@ -0,0 +1,102 @@
+#ifndef ENGINE_API_ISOCHRONE_API_HPP
+#define ENGINE_API_ISOCHRONE_API_HPP
+
+#include "engine/api/base_api.hpp"
+#include "engine/api/isochrone_parameters.hpp"
+
+#include "engine/api/json_factory.hpp"
+#include "engine/phantom_node.hpp"
+#include "util/coordinate.hpp"
+
+#include <boost/assert.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+
+class IsochroneAPI final : public BaseAPI
+{
+  public:
+    IsochroneAPI(const datafacade::BaseDataFacade &facade_,
+                 const IsochroneParameters &parameters_)
+        : BaseAPI(facade_, parameters_), parameters(parameters_)
+    {
+    }
+
+    // hull is the convex hull of the reachable area, segments are the reachable parts of the
+    // road segments from where they are entered
+    void MakeResponse(const PhantomNode &source,
+                      const std::vector<util::Coordinate> &hull,
+                      const std::vector<std::pair<util::Coordinate, util::Coordinate>> &segments,
+                      util::json::Object &response) const
+    {
+        BOOST_ASSERT(parameters.coordinates.size() == 1);
+        BOOST_ASSERT(!hull.empty());
+
+        util::json::Array waypoints;
+        waypoints.values.push_back(MakeWaypoint(source));
+
+        response.values["code"] = "Ok";
+        response.values["waypoints"] = std::move(waypoints);
+        response.values["isochrone"] = MakePolygon(hull);
+
+        if (parameters.segments)
+        {
+            util::json::Array lines;
+            lines.values.reserve(segments.size());
+            for (const auto &segment : segments)
+            {
+                util::json::Array line;
+                line.values.push_back(json::detail::coordinateToLonLat(segment.first));
+                line.values.push_back(json::detail::coordinateToLonLat(segment.second));
+                lines.values.push_back(std::move(line));
+            }
+
+            util::json::Object geojson;
+            geojson.values["type"] = "MultiLineString";
+            geojson.values["coordinates"] = std::move(lines);
+            response.values["segments"] = std::move(geojson);
+        }
+    }
+
+    const IsochroneParameters &parameters;
+
+  private:
+    // GeoJSON polygon with a closed outer ring, hulls of less than three coordinates do not
+    // enclose an area and are returned as point or line string
+    util::json::Object MakePolygon(const std::vector<util::Coordinate> &hull) const
+    {
+        if (hull.size() < 3)
+        {
+            return json::makeGeoJSONGeometry(hull.begin(), hull.end());
+        }
+
+        util::json::Array ring;
+        ring.values.reserve(hull.size() + 1);
+        for (const auto coordinate : hull)
+        {
+            ring.values.push_back(json::detail::coordinateToLonLat(coordinate));
+        }
+        ring.values.push_back(json::detail::coordinateToLonLat(hull.front()));
+
+        util::json::Array rings;
+        rings.values.push_back(std::move(ring));
+
+        util::json::Object geojson;
+        geojson.values["type"] = "Polygon";
+        geojson.values["coordinates"] = std::move(rings);
+        return geojson;
+    }
+};
+
+} // ns api
+} // ns engine
+} // ns osrm
+
+#endif
@@ -7,6 +7,7 @@
 #include "engine/datafacade/datafacade_base.hpp"
 
 #include "engine/internal_route_result.hpp"
+#include "engine/map_matching/matching_session.hpp"
 #include "engine/map_matching/sub_matching.hpp"
 
 #include "util/integer_range.hpp"
@@ -85,7 +86,13 @@ class MatchAPI final : public RouteAPI
             for (auto point_index : util::irange(
                      0u, static_cast<unsigned>(sub_matchings[sub_matching_index].indices.size())))
             {
-                trace_idx_to_matching_idx[sub_matchings[sub_matching_index].indices[point_index]] =
+                const auto trace_index = sub_matchings[sub_matching_index].indices[point_index];
+                // the frontier of a session is not part of the request's trace
+                if (trace_index == map_matching::SESSION_FRONTIER_INDEX)
+                {
+                    continue;
+                }
+                trace_idx_to_matching_idx[trace_index] =
                     MatchingIndex{sub_matching_index, point_index};
             }
         }
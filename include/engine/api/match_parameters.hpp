@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "engine/api/route_parameters.hpp"
 
+#include <string>
 #include <vector>
 
 namespace osrm
@@ -44,6 +45,10 @@ namespace api
  *
  * Holds member attributes:
  *  - timestamps: timestamp(s) for the corresponding input coordinate(s)
+ *  - session: token of a matching session, the coordinates then continue the trace matched by
+ *             the previous requests of the session and a single coordinate is enough
+ *  - tidy: thin out the samples of high frequency traces before matching them, the dropped
+ *          samples have no tracepoint. Requests of a session are not thinned.
  *
  * \see OSRM, Coordinate, Hint, Bearing, RouteParame, RouteParameters, TableParameters,
  *      NearestParameters, TripParameters, MatchParameters and TileParameters
@@ -67,9 +72,14 @@ struct MatchParameters : public RouteParameters
     }
 
     std::vector<unsigned> timestamps;
+    std::string session;
+    bool tidy = false;
+
     bool IsValid() const
     {
-        return RouteParameters::IsValid() &&
+        const std::size_t min_coordinates = session.empty() ? 2 : 1;
+        return coordinates.size() >= min_coordinates && format == OutputFormatType::JSON &&
+               BaseParameters::IsValid() &&
                (timestamps.empty() || timestamps.size() == coordinates.size());
     }
 };
@@ -6,6 +6,7 @@
 
 #include "engine/api/json_factory.hpp"
 #include "engine/phantom_node.hpp"
+#include "util/json_writer.hpp"
 
 #include <boost/assert.hpp>
 
@@ -26,28 +27,89 @@ class NearestAPI final : public BaseAPI
     {
     }
 
+    // With a single input coordinate "waypoints" holds its candidates, with more it holds one
+    // array of candidates per input coordinate, empty if nothing was found within the radius.
     void MakeResponse(const std::vector<std::vector<PhantomNodeWithDistance>> &phantom_nodes,
                       util::json::Object &response) const
     {
-        BOOST_ASSERT(phantom_nodes.size() == 1);
-        BOOST_ASSERT(parameters.coordinates.size() == 1);
-
-        util::json::Array waypoints;
-        waypoints.values.resize(phantom_nodes.front().size());
-        std::transform(phantom_nodes.front().begin(),
-                       phantom_nodes.front().end(),
-                       waypoints.values.begin(),
-                       [this](const PhantomNodeWithDistance &phantom_with_distance) {
-                           auto waypoint = MakeWaypoint(phantom_with_distance.phantom_node);
-                           waypoint.values["distance"] = phantom_with_distance.distance;
-                           return waypoint;
-                       });
+        BOOST_ASSERT(phantom_nodes.size() == parameters.coordinates.size());
+        BOOST_ASSERT(phantom_nodes.size() > 0);
 
+        if (phantom_nodes.size() == 1)
+        {
+            response.values["waypoints"] = MakeWaypoints(phantom_nodes.front());
+        }
+        else
+        {
+            util::json::Array waypoints;
+            waypoints.values.reserve(phantom_nodes.size());
+            for (const auto &candidates : phantom_nodes)
+            {
+                waypoints.values.push_back(MakeWaypoints(candidates));
+            }
+            response.values["waypoints"] = std::move(waypoints);
+        }
         response.values["code"] = "Ok";
-        response.values["waypoints"] = std::move(waypoints);
+    }
+
+    // Same response as above, rendered one waypoint at a time so large requests never hold
+    // the json::Object of all candidates
+    void MakeResponse(const std::vector<std::vector<PhantomNodeWithDistance>> &phantom_nodes,
+                      util::json::Writer &writer) const
+    {
+        BOOST_ASSERT(phantom_nodes.size() == parameters.coordinates.size());
+        BOOST_ASSERT(phantom_nodes.size() > 0);
+
+        const auto write_candidates = [&](const std::vector<PhantomNodeWithDistance> &candidates) {
+            writer.StartArray();
+            for (const auto &phantom_with_distance : candidates)
+            {
+                writer.Value(MakeWaypoint(phantom_with_distance));
+            }
+            writer.EndArray();
+        };
+
+        writer.StartObject();
+        writer.Key("waypoints");
+        if (phantom_nodes.size() == 1)
+        {
+            write_candidates(phantom_nodes.front());
+        }
+        else
+        {
+            writer.StartArray();
+            for (const auto &candidates : phantom_nodes)
+            {
+                write_candidates(candidates);
+            }
+            writer.EndArray();
+        }
+        writer.Key("code");
+        writer.String("Ok");
+        writer.EndObject();
     }
 
     const NearestParameters &parameters;
+
+  private:
+    util::json::Object MakeWaypoint(const PhantomNodeWithDistance &phantom_with_distance) const
+    {
+        auto waypoint = BaseAPI::MakeWaypoint(phantom_with_distance.phantom_node);
+        waypoint.values["distance"] = phantom_with_distance.distance;
+        return waypoint;
+    }
+
+    util::json::Array
+    MakeWaypoints(const std::vector<PhantomNodeWithDistance> &candidates) const
+    {
+        util::json::Array waypoints;
+        waypoints.values.reserve(candidates.size());
+        for (const auto &phantom_with_distance : candidates)
+        {
+            waypoints.values.push_back(MakeWaypoint(phantom_with_distance));
+        }
+        return waypoints;
+    }
 };
 
 } // ns api
@@ -50,7 +50,11 @@ struct NearestParameters : public BaseParameters
 {
     unsigned number_of_results = 1;
 
-    bool IsValid() const { return BaseParameters::IsValid() && number_of_results >= 1; }
+    bool IsValid() const
+    {
+        return BaseParameters::IsValid() && format == OutputFormatType::JSON &&
+               number_of_results >= 1;
+    }
 };
 }
 }
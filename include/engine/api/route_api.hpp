@@ -12,14 +12,19 @@
 #include "engine/guidance/assemble_overview.hpp"
 #include "engine/guidance/assemble_route.hpp"
 #include "engine/guidance/assemble_steps.hpp"
-#include "engine/guidance/lane_processing.hpp"
 #include "engine/guidance/post_processing.hpp"
 
 #include "engine/internal_route_result.hpp"
+#include "engine/metrics.hpp"
 
 #include "util/coordinate.hpp"
 #include "util/integer_range.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+
+#include <cstddef>
 #include <iterator>
 #include <vector>
 
@@ -33,28 +38,79 @@ namespace api
 class RouteAPI : public BaseAPI
 {
   public:
-    RouteAPI(const datafacade::BaseDataFacade &facade_, const RouteParameters &parameters_)
-        : BaseAPI(facade_, parameters_), parameters(parameters_)
+    // below this many path points of a route its legs and alternatives are assembled on the
+    // calling thread, handing them out to other threads would take longer
+    const static constexpr std::size_t PARALLEL_ASSEMBLY_MIN_PATH_SIZE = 4096;
+
+    // With parallel_assembly the legs and the alternative of large routes are assembled at the
+    // same time, on the threads of the search engine.
+    RouteAPI(const datafacade::BaseDataFacade &facade_,
+             const RouteParameters &parameters_,
+             const bool parallel_assembly = false)
+        : BaseAPI(facade_, parameters_), parameters(parameters_),
+          parallel_assembly(parallel_assembly)
     {
     }
 
     void MakeResponse(const InternalRouteResult &raw_route, util::json::Object &response) const
     {
-        auto number_of_routes = raw_route.has_alternative() ? 2UL : 1UL;
+        const auto number_of_alternatives =
+            raw_route.has_alternative() ? 1 + raw_route.further_alternatives.size() : 0UL;
+        const auto number_of_routes = 1 + number_of_alternatives;
         util::json::Array routes;
         routes.values.resize(number_of_routes);
-        routes.values[0] = MakeRoute(raw_route.segment_end_coordinates,
-                                     raw_route.unpacked_path_segments,
-                                     raw_route.source_traversed_in_reverse,
-                                     raw_route.target_traversed_in_reverse);
-        if (raw_route.has_alternative())
+
+        std::size_t path_size = raw_route.unpacked_alternative.size();
+        for (const auto &path_data : raw_route.unpacked_path_segments)
+        {
+            path_size += path_data.size();
+        }
+        for (const auto &alternative : raw_route.further_alternatives)
+        {
+            path_size += alternative.unpacked_path.size();
+        }
+        const bool assemble_in_parallel =
+            parallel_assembly && path_size >= PARALLEL_ASSEMBLY_MIN_PATH_SIZE;
+
+        const auto make_route = [&] {
+            routes.values[0] = MakeRoute(raw_route.segment_end_coordinates,
+                                         raw_route.unpacked_path_segments,
+                                         raw_route.source_traversed_in_reverse,
+                                         raw_route.target_traversed_in_reverse,
+                                         assemble_in_parallel);
+        };
+        const auto make_alternative = [&](const std::size_t alternative) {
+            if (alternative == 0)
+            {
+                const std::vector<std::vector<PathData>> wrapped_leg(
+                    1, raw_route.unpacked_alternative);
+                routes.values[1] = MakeRoute(raw_route.segment_end_coordinates,
+                                             wrapped_leg,
+                                             raw_route.alt_source_traversed_in_reverse,
+                                             raw_route.alt_target_traversed_in_reverse);
+                return;
+            }
+            const auto &further = raw_route.further_alternatives[alternative - 1];
+            const std::vector<std::vector<PathData>> wrapped_leg(1, further.unpacked_path);
+            routes.values[1 + alternative] =
+                MakeRoute(raw_route.segment_end_coordinates,
+                          wrapped_leg,
+                          std::vector<bool>(1, further.source_traversed_in_reverse),
+                          std::vector<bool>(1, further.target_traversed_in_reverse));
+        };
+        if (assemble_in_parallel && number_of_alternatives > 0)
         {
-            std::vector<std::vector<PathData>> wrapped_leg(1);
-            wrapped_leg.front() = std::move(raw_route.unpacked_alternative);
-            routes.values[1] = MakeRoute(raw_route.segment_end_coordinates,
-                                         wrapped_leg,
-                                         raw_route.alt_source_traversed_in_reverse,
-                                         raw_route.alt_target_traversed_in_reverse);
+            tbb::parallel_invoke(make_route, [&] {
+                tbb::parallel_for(std::size_t{0}, number_of_alternatives, make_alternative);
+            });
+        }
+        else
+        {
+            make_route();
+            for (const auto alternative : util::irange<std::size_t>(0UL, number_of_alternatives))
+            {
+                make_alternative(alternative);
+            }
         }
         response.values["waypoints"] = BaseAPI::MakeWaypoints(raw_route.segment_end_coordinates);
         response.values["routes"] = std::move(routes);
@@ -75,25 +131,49 @@ class RouteAPI : public BaseAPI
         return json::makeGeoJSONGeometry(begin, end);
     }
 
+    // The legs are assembled independently of each other, with parallel_legs on all threads
     util::json::Object MakeRoute(const std::vector<PhantomNodes> &segment_end_coordinates,
                                  const std::vector<std::vector<PathData>> &unpacked_path_segments,
                                  const std::vector<bool> &source_traversed_in_reverse,
-                                 const std::vector<bool> &target_traversed_in_reverse) const
+                                 const std::vector<bool> &target_traversed_in_reverse,
+                                 const bool parallel_legs = false) const
     {
-        std::vector<guidance::RouteLeg> legs;
-        std::vector<guidance::LegGeometry> leg_geometries;
+        metrics::StageTimer timer(metrics::Stage::Guidance);
+
         auto number_of_legs = segment_end_coordinates.size();
-        legs.reserve(number_of_legs);
-        leg_geometries.reserve(number_of_legs);
+        std::vector<guidance::RouteLeg> legs(number_of_legs);
+        std::vector<guidance::LegGeometry> leg_geometries;
 
-        for (auto idx : util::irange<std::size_t>(0UL, number_of_legs))
+        // Without steps, annotations and overview only the duration and distance of the legs
+        // are needed, neither their geometry nor their steps are assembled then
+        const bool needs_geometry = parameters.steps || parameters.annotations ||
+                                    parameters.overview != RouteParameters::OverviewType::False;
+        if (needs_geometry)
         {
+            leg_geometries.resize(number_of_legs);
+        }
+
+        const auto assemble_leg = [&](const std::size_t idx) {
             const auto &phantoms = segment_end_coordinates[idx];
             const auto &path_data = unpacked_path_segments[idx];
 
             const bool reversed_source = source_traversed_in_reverse[idx];
             const bool reversed_target = target_traversed_in_reverse[idx];
 
+            if (!needs_geometry)
+            {
+                const auto distance = guidance::assembleDistance(
+                    BaseAPI::facade, path_data, phantoms.source_phantom, phantoms.target_phantom);
+                legs[idx] = guidance::assembleLeg(facade,
+                                                  path_data,
+                                                  distance,
+                                                  phantoms.source_phantom,
+                                                  phantoms.target_phantom,
+                                                  reversed_target,
+                                                  false);
+                return;
+            }
+
             auto leg_geometry = guidance::assembleGeometry(
                 BaseAPI::facade, path_data, phantoms.source_phantom, phantoms.target_phantom);
             auto leg = guidance::assembleLeg(facade,
@@ -142,20 +222,31 @@ class RouteAPI : public BaseAPI
                  * the overall response consistent.
                  */
 
-                guidance::trimShortSegments(steps, leg_geometry);
-                leg.steps = guidance::postProcess(std::move(steps));
-                leg.steps = guidance::collapseTurns(std::move(leg.steps));
-                leg.steps = guidance::buildIntersections(std::move(leg.steps));
-                leg.steps = guidance::assignRelativeLocations(std::move(leg.steps),
-                                                              leg_geometry,
-                                                              phantoms.source_phantom,
-                                                              phantoms.target_phantom);
-                leg.steps = guidance::anticipateLaneChange(std::move(leg.steps));
-                leg_geometry = guidance::resyncGeometry(std::move(leg_geometry), leg.steps);
+                guidance::postProcessLeg(
+                    steps, leg_geometry, phantoms.source_phantom, phantoms.target_phantom);
+                leg.steps = std::move(steps);
             }
 
-            leg_geometries.push_back(std::move(leg_geometry));
-            legs.push_back(std::move(leg));
+            leg_geometries[idx] = std::move(leg_geometry);
+            legs[idx] = std::move(leg);
+        };
+
+        if (parallel_legs && number_of_legs > 1)
+        {
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_legs, 1),
+                              [&](const tbb::blocked_range<std::size_t> &range) {
+                                  for (auto idx = range.begin(); idx != range.end(); ++idx)
+                                  {
+                                      assemble_leg(idx);
+                                  }
+                              });
+        }
+        else
+        {
+            for (auto idx : util::irange<std::size_t>(0UL, number_of_legs))
+            {
+                assemble_leg(idx);
+            }
         }
 
         auto route = guidance::assembleRoute(legs);
@@ -172,7 +263,7 @@ class RouteAPI : public BaseAPI
         }
 
         std::vector<util::json::Value> step_geometries;
-        for (const auto idx : util::irange<std::size_t>(0UL, legs.size()))
+        for (const auto idx : util::irange<std::size_t>(0UL, leg_geometries.size()))
         {
             auto &leg_geometry = leg_geometries[idx];
 
@@ -241,6 +332,7 @@ class RouteAPI : public BaseAPI
     }
 
     const RouteParameters &parameters;
+    const bool parallel_assembly;
 };
 
 } // ns api
@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define ENGINE_API_ROUTE_PARAMETERS_HPP
 
 #include "engine/api/base_parameters.hpp"
+#include "extractor/edge_classes.hpp"
 
 #include <vector>
 
@@ -45,10 +46,18 @@ namespace api
  * Holds member attributes:
  *  - steps: return route step for each route leg
  *  - alternatives: tries to find alternative routes
+ *  - number_of_alternatives: alternative routes searched for besides the fastest one, more than
+ *                            one are found by the penalty method
  *  - geometries: route geometry encoded in Polyline or GeoJSON
  *  - overview: adds overview geometry either Full, Simplified (according to highest zoom level) or
  *              False (not at all)
  *  - continue_straight: enable or disable continue_straight (disabled by default)
+ *  - departure_time: seconds since the start of the time slot cycle of the dataset, selects the
+ *                    weights of the time slot the route departs in
+ *  - metric: selects the weights of the metric-th --metric-speed-file of osrm-contract, 0 selects
+ *            the weights of the dataset
+ *  - exclude: edge classes the route avoids, selects the metric of osrm-contract --exclude-classes
+ *             with exactly these classes
  *
  * \see OSRM, Coordinate, Hint, Bearing, RouteParame, RouteParameters, TableParameters,
  *      NearestParameters, TripParameters, MatchParameters and TileParameters
@@ -85,12 +94,21 @@ struct RouteParameters : public BaseParameters
 
     bool steps = false;
     bool alternatives = false;
+    unsigned number_of_alternatives = 1;
     bool annotations = false;
     GeometriesType geometries = GeometriesType::Polyline;
     OverviewType overview = OverviewType::Simplified;
     boost::optional<bool> continue_straight;
+    boost::optional<unsigned> departure_time;
+    unsigned metric = 0;
+    extractor::EdgeClasses exclude = EDGE_CLASS_NONE;
 
-    bool IsValid() const { return coordinates.size() >= 2 && BaseParameters::IsValid(); }
+    // Only JSON responses are implemented for route, match and trip
+    bool IsValid() const
+    {
+        return coordinates.size() >= 2 && format == OutputFormatType::JSON &&
+               BaseParameters::IsValid();
+    }
 };
 }
 }
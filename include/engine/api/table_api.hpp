@@ -5,6 +5,7 @@
 #include "engine/api/json_factory.hpp"
 #include "engine/api/table_parameters.hpp"
 
+#include "engine/base64.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
 
 #include "engine/guidance/assemble_geometry.hpp"
@@ -16,9 +17,13 @@
 #include "engine/internal_route_result.hpp"
 
 #include "util/integer_range.hpp"
+#include "util/json_writer.hpp"
 
 #include <boost/range/algorithm/transform.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <iterator>
 
 namespace osrm
@@ -36,13 +41,15 @@ class TableAPI final : public BaseAPI
     {
     }
 
+    // The distances are in tenth of meters like the durations are in tenth of seconds, both are
+    // only used if the parameters request them
     virtual void MakeResponse(const std::vector<EdgeWeight> &durations,
+                              const std::vector<EdgeWeight> &distances,
                               const std::vector<PhantomNode> &phantoms,
                               util::json::Object &response) const
     {
         auto number_of_sources = parameters.sources.size();
         auto number_of_destinations = parameters.destinations.size();
-        ;
 
         // symmetric case
         if (parameters.sources.empty())
@@ -65,11 +72,274 @@ class TableAPI final : public BaseAPI
             response.values["destinations"] = MakeWaypoints(phantoms, parameters.destinations);
         }
 
-        response.values["durations"] =
-            MakeTable(durations, number_of_sources, number_of_destinations);
+        const auto make_table = [&](const std::vector<EdgeWeight> &values) -> util::json::Value {
+            if (parameters.matrix_encoding == TableParameters::MatrixEncodingType::Base64)
+            {
+                return MakeEncodedTable(values, number_of_sources * number_of_destinations);
+            }
+            return MakeTable(values, number_of_sources, number_of_destinations);
+        };
+        if (parameters.HasAnnotation(TableParameters::AnnotationsType::Duration))
+        {
+            response.values["durations"] = make_table(durations);
+        }
+        if (parameters.HasAnnotation(TableParameters::AnnotationsType::Distance))
+        {
+            response.values["distances"] = make_table(distances);
+        }
         response.values["code"] = "Ok";
     }
 
+    // Same response as above, but the matrices are streamed into the writer
+    // without materializing a json::Array per row first.
+    virtual void MakeResponse(const std::vector<EdgeWeight> &durations,
+                              const std::vector<EdgeWeight> &distances,
+                              const std::vector<PhantomNode> &phantoms,
+                              util::json::Writer &writer) const
+    {
+        MakeResponse(
+            [&](const RowsHandler &handle_rows) {
+                handle_rows(durations, distances, NumberOfSources(phantoms));
+            },
+            phantoms,
+            writer);
+    }
+
+    // Hands blocks of rows of the durations and distances matrices to the writer, together
+    // with the number of rows in the block. Unrequested matrices can be empty.
+    using RowsHandler = std::function<void(const std::vector<EdgeWeight> &durations,
+                                           const std::vector<EdgeWeight> &distances,
+                                           const std::size_t number_of_rows)>;
+
+    // The response for tables that are computed block by block: produce_rows(handle_rows) has to
+    // pass all rows in order. Only the rendered text grows with the table, if both matrices are
+    // requested the distances are rendered into a second buffer until the durations are done.
+    template <typename ProduceRows>
+    void MakeResponse(ProduceRows &&produce_rows,
+                      const std::vector<PhantomNode> &phantoms,
+                      util::json::Writer &writer) const
+    {
+        const auto number_of_destinations = NumberOfDestinations(phantoms);
+        const auto with_durations =
+            parameters.HasAnnotation(TableParameters::AnnotationsType::Duration);
+        const auto with_distances =
+            parameters.HasAnnotation(TableParameters::AnnotationsType::Distance);
+        const auto encoded =
+            parameters.matrix_encoding == TableParameters::MatrixEncodingType::Base64;
+
+        writer.StartObject();
+
+        writer.Key("sources");
+        writer.Value(parameters.sources.empty() ? MakeWaypoints(phantoms)
+                                                : MakeWaypoints(phantoms, parameters.sources));
+
+        writer.Key("destinations");
+        writer.Value(parameters.destinations.empty()
+                         ? MakeWaypoints(phantoms)
+                         : MakeWaypoints(phantoms, parameters.destinations));
+
+        std::vector<char> separate_distances;
+        util::json::Writer separate_distances_writer(separate_distances);
+        auto &distances_writer = with_durations ? separate_distances_writer : writer;
+
+        // the encoded matrices are a string each, continued with every block of rows
+        Base64Encoder durations_encoder;
+        Base64Encoder distances_encoder;
+        const auto start_matrix = [encoded](util::json::Writer &matrix_writer) {
+            if (encoded)
+            {
+                matrix_writer.StartString();
+            }
+            else
+            {
+                matrix_writer.StartArray();
+            }
+        };
+        const auto add_rows = [&](const std::vector<EdgeWeight> &values,
+                                  const std::size_t number_of_rows,
+                                  Base64Encoder &encoder,
+                                  util::json::Writer &matrix_writer) {
+            if (encoded)
+            {
+                const auto block_entries = number_of_rows * number_of_destinations;
+                BOOST_ASSERT(values.size() >= block_entries);
+                matrix_writer.StringPiece(
+                    encoder.Append(reinterpret_cast<const char *>(values.data()),
+                                   block_entries * sizeof(EdgeWeight)));
+            }
+            else
+            {
+                MakeRows(values, number_of_rows, number_of_destinations, matrix_writer);
+            }
+        };
+        const auto end_matrix = [encoded](Base64Encoder &encoder,
+                                          util::json::Writer &matrix_writer) {
+            if (encoded)
+            {
+                matrix_writer.StringPiece(encoder.Finish());
+                matrix_writer.EndString();
+            }
+            else
+            {
+                matrix_writer.EndArray();
+            }
+        };
+
+        if (with_durations)
+        {
+            writer.Key("durations");
+            start_matrix(writer);
+        }
+        if (with_distances)
+        {
+            if (!with_durations)
+            {
+                writer.Key("distances");
+            }
+            start_matrix(distances_writer);
+        }
+
+        produce_rows(RowsHandler{[&](const std::vector<EdgeWeight> &durations,
+                                     const std::vector<EdgeWeight> &distances,
+                                     const std::size_t number_of_rows) {
+            if (with_durations)
+            {
+                add_rows(durations, number_of_rows, durations_encoder, writer);
+            }
+            if (with_distances)
+            {
+                add_rows(distances, number_of_rows, distances_encoder, distances_writer);
+            }
+        }});
+
+        if (with_durations)
+        {
+            end_matrix(durations_encoder, writer);
+        }
+        if (with_distances)
+        {
+            end_matrix(distances_encoder, distances_writer);
+            if (with_durations)
+            {
+                writer.Key("distances");
+                writer.Raw(separate_distances);
+            }
+        }
+
+        writer.Key("code");
+        writer.String("Ok");
+
+        writer.EndObject();
+    }
+
+    // Binary encoding of the table for consumers that only need the numbers. All fields are
+    // 32 bit integers in host byte order (little-endian on all supported platforms):
+    //
+    //   magic "OSRT", version, number of sources S, number of destinations D,
+    //   only in version 2: the requested annotations, 1 for durations, 2 for distances, 3 for both,
+    //   S source locations and D destination locations as fixed point lon, lat pairs,
+    //   S * D durations in row major order in tenth of seconds, INVALID_EDGE_WEIGHT if unreachable,
+    //   only in version 2: S * D distances in tenth of meters, INVALID_EDGE_WEIGHT if unreachable
+    //
+    // Version 1 is written if only durations are requested, then there is no annotations field.
+    // Everything is 4 byte aligned so clients can read the matrices in place.
+    virtual void MakeBinaryResponse(const std::vector<EdgeWeight> &durations,
+                                    const std::vector<EdgeWeight> &distances,
+                                    const std::vector<PhantomNode> &phantoms,
+                                    std::vector<char> &buffer) const
+    {
+        MakeBinaryResponse(
+            [&](const RowsHandler &handle_rows) {
+                handle_rows(durations, distances, NumberOfSources(phantoms));
+            },
+            phantoms,
+            buffer);
+    }
+
+    // The binary response for tables that are computed block by block, see above
+    template <typename ProduceRows>
+    void MakeBinaryResponse(ProduceRows &&produce_rows,
+                            const std::vector<PhantomNode> &phantoms,
+                            std::vector<char> &buffer) const
+    {
+        const auto &sources = parameters.sources;
+        const auto &destinations = parameters.destinations;
+        const auto number_of_sources = NumberOfSources(phantoms);
+        const auto number_of_destinations = NumberOfDestinations(phantoms);
+        const auto with_durations =
+            parameters.HasAnnotation(TableParameters::AnnotationsType::Duration);
+        const auto with_distances =
+            parameters.HasAnnotation(TableParameters::AnnotationsType::Distance);
+        const auto number_of_entries = number_of_sources * number_of_destinations;
+
+        const auto append = [](std::vector<char> &out, const void *data, const std::size_t size) {
+            const auto begin = static_cast<const char *>(data);
+            out.insert(out.end(), begin, begin + size);
+        };
+        const auto append_uint32 = [&](const std::uint32_t value) {
+            append(buffer, &value, sizeof(value));
+        };
+        const auto append_location = [&](const std::size_t index) {
+            BOOST_ASSERT(index < phantoms.size());
+            const std::int32_t location[2] = {
+                static_cast<std::int32_t>(phantoms[index].location.lon),
+                static_cast<std::int32_t>(phantoms[index].location.lat)};
+            append(buffer, location, sizeof(location));
+        };
+
+        buffer.reserve(buffer.size() +
+                       sizeof(std::uint32_t) *
+                           (5 + 2 * (number_of_sources + number_of_destinations) +
+                            (with_durations + with_distances) * number_of_entries));
+
+        append(buffer, "OSRT", 4);
+        append_uint32(with_distances ? BINARY_TABLE_VERSION : 1);
+        append_uint32(static_cast<std::uint32_t>(number_of_sources));
+        append_uint32(static_cast<std::uint32_t>(number_of_destinations));
+        if (with_distances)
+        {
+            append_uint32(static_cast<std::uint32_t>(parameters.annotations));
+        }
+
+        for (const auto index : util::irange<std::size_t>(0UL, number_of_sources))
+        {
+            append_location(sources.empty() ? index : sources[index]);
+        }
+        for (const auto index : util::irange<std::size_t>(0UL, number_of_destinations))
+        {
+            append_location(destinations.empty() ? index : destinations[index]);
+        }
+
+        // the distances follow all durations, until then they wait in a buffer of their own
+        std::vector<char> separate_distances;
+        auto &distances_buffer = with_durations ? separate_distances : buffer;
+
+        static_assert(sizeof(EdgeWeight) == sizeof(std::int32_t), "durations are 32 bit");
+        produce_rows(RowsHandler{[&](const std::vector<EdgeWeight> &durations,
+                                     const std::vector<EdgeWeight> &distances,
+                                     const std::size_t number_of_rows) {
+            const auto block_entries = number_of_rows * number_of_destinations;
+            if (with_durations)
+            {
+                BOOST_ASSERT(durations.size() >= block_entries);
+                append(buffer, durations.data(), block_entries * sizeof(EdgeWeight));
+            }
+            if (with_distances)
+            {
+                BOOST_ASSERT(distances.size() >= block_entries);
+                append(distances_buffer, distances.data(), block_entries * sizeof(EdgeWeight));
+            }
+        }});
+
+        if (with_durations && with_distances)
+        {
+            buffer.insert(buffer.end(), separate_distances.begin(), separate_distances.end());
+        }
+    }
+
+    // the newest version, older clients that only ask for durations still get version 1
+    static constexpr std::uint32_t BINARY_TABLE_VERSION = 2;
+
     // FIXME gcc 4.8 doesn't support for lambdas to call protected member functions
     //  protected:
     virtual util::json::Array MakeWaypoints(const std::vector<PhantomNode> &phantoms) const
@@ -125,6 +395,68 @@ class TableAPI final : public BaseAPI
         return json_table;
     }
 
+    // The first number_of_entries values as base64 of their 32 bit little-endian bytes, in tenth
+    // of their unit and INVALID_EDGE_WEIGHT if unreachable like in the binary response
+    virtual util::json::String MakeEncodedTable(const std::vector<EdgeWeight> &values,
+                                                std::size_t number_of_entries) const
+    {
+        static_assert(sizeof(EdgeWeight) == sizeof(std::int32_t), "durations are 32 bit");
+        BOOST_ASSERT(values.size() >= number_of_entries);
+        Base64Encoder encoder;
+        auto encoded = encoder.Append(reinterpret_cast<const char *>(values.data()),
+                                      number_of_entries * sizeof(EdgeWeight));
+        return util::json::String(encoded + encoder.Finish());
+    }
+
+    virtual void MakeTable(const std::vector<EdgeWeight> &values,
+                           std::size_t number_of_rows,
+                           std::size_t number_of_columns,
+                           util::json::Writer &writer) const
+    {
+        writer.StartArray();
+        MakeRows(values, number_of_rows, number_of_columns, writer);
+        writer.EndArray();
+    }
+
+    // The rows of a table without the enclosing array
+    virtual void MakeRows(const std::vector<EdgeWeight> &values,
+                          std::size_t number_of_rows,
+                          std::size_t number_of_columns,
+                          util::json::Writer &writer) const
+    {
+        BOOST_ASSERT(values.size() >= number_of_rows * number_of_columns);
+
+        for (const auto row : util::irange<std::size_t>(0UL, number_of_rows))
+        {
+            writer.StartArray();
+            auto row_begin_iterator = values.begin() + (row * number_of_columns);
+            auto row_end_iterator = values.begin() + ((row + 1) * number_of_columns);
+            std::for_each(row_begin_iterator,
+                          row_end_iterator,
+                          [&writer](const EdgeWeight duration) {
+                              if (duration == INVALID_EDGE_WEIGHT)
+                              {
+                                  writer.Null();
+                              }
+                              else
+                              {
+                                  writer.NumberInTenths(duration);
+                              }
+                          });
+            writer.EndArray();
+        }
+    }
+
+    std::size_t NumberOfSources(const std::vector<PhantomNode> &phantoms) const
+    {
+        return parameters.sources.empty() ? phantoms.size() : parameters.sources.size();
+    }
+
+    std::size_t NumberOfDestinations(const std::vector<PhantomNode> &phantoms) const
+    {
+        return parameters.destinations.empty() ? phantoms.size() : parameters.destinations.size();
+    }
+
     const TableParameters &parameters;
 };
 
@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
 #include <iterator>
+#include <string>
 #include <vector>
 
 namespace osrm
@@ -51,14 +52,40 @@ namespace api
  *             use all coordinates as sources
  *  - destinations: indices into coordinates indicating destinations for the Table service, no
  *                  destinations means use all coordinates as destinations
+ *  - annotations: which matrices to return, durations and/or distances
+ *  - target_set: name of a target set. With destinations they are registered as the target set,
+ *                without the destinations are the coordinates the target set was registered
+ *                with and all coordinates of the request are sources.
+ *  - matrix_encoding: the matrices of a JSON response as arrays of arrays of numbers or as
+ *                     base64 strings of 32 bit little-endian integers in tenth of their unit
+ *  - distribute: whether the rows of a large table may be split among the table peers, the
+ *                peers themselves are asked without, so requests never cascade between them
  *
  * \see OSRM, Coordinate, Hint, Bearing, RouteParame, RouteParameters, TableParameters,
  *      NearestParameters, TripParameters, MatchParameters and TileParameters
  */
 struct TableParameters : public BaseParameters
 {
+    enum class AnnotationsType
+    {
+        None = 0,
+        Duration = 0x01,
+        Distance = 0x02,
+        All = Duration | Distance
+    };
+
     std::vector<std::size_t> sources;
     std::vector<std::size_t> destinations;
+    enum class MatrixEncodingType
+    {
+        Array,
+        Base64
+    };
+
+    AnnotationsType annotations = AnnotationsType::Duration;
+    std::string target_set;
+    MatrixEncodingType matrix_encoding = MatrixEncodingType::Array;
+    bool distribute = true;
 
     TableParameters() = default;
     template <typename... Args>
@@ -70,13 +97,26 @@ struct TableParameters : public BaseParameters
     {
     }
 
+    // the destinations are the coordinates of a registered target set
+    bool UsesTargetSet() const { return !target_set.empty() && destinations.empty(); }
+
+    bool HasAnnotation(const AnnotationsType annotation) const
+    {
+        return (static_cast<int>(annotations) & static_cast<int>(annotation)) != 0;
+    }
+
     bool IsValid() const
     {
         if (!BaseParameters::IsValid())
             return false;
 
-        // Distance Table makes only sense with 2+ coodinates
-        if (coordinates.size() < 2)
+        if (annotations == AnnotationsType::None)
+            return false;
+
+        // Distance Table makes only sense with 2+ coodinates, unless the destinations are those of
+        // a registered target set
+        const std::size_t min_coordinates = UsesTargetSet() ? 1 : 2;
+        if (coordinates.size() < min_coordinates)
             return false;
 
         // 1/ The user is able to specify duplicates in srcs and dsts, in that case it's her fault
@@ -100,6 +140,19 @@ struct TableParameters : public BaseParameters
         return true;
     }
 };
+
+inline TableParameters::AnnotationsType operator|(const TableParameters::AnnotationsType lhs,
+                                                  const TableParameters::AnnotationsType rhs)
+{
+    return static_cast<TableParameters::AnnotationsType>(static_cast<int>(lhs) |
+                                                         static_cast<int>(rhs));
+}
+
+inline TableParameters::AnnotationsType &operator|=(TableParameters::AnnotationsType &lhs,
+                                                    const TableParameters::AnnotationsType rhs)
+{
+    return lhs = lhs | rhs;
+}
 }
 }
 }
@@ -61,8 +61,9 @@ inline std::string encodeBase64(const unsigned char *first, std::size_t size)
     BOOST_ASSERT(bytes_to_pad == 0 || bytes_to_pad == 1 || bytes_to_pad == 2);
     BOOST_ASSERT_MSG(0 == bytes.size() % 3, "base64 input data size is not a multiple of 3");
 
-    std::string encoded{detail::Base64FromBinary{bytes.data()},
-                        detail::Base64FromBinary{bytes.data() + (bytes.size() - bytes_to_pad)}};
+    std::string encoded{
+        osrm::detail::Base64FromBinary{bytes.data()},
+        osrm::detail::Base64FromBinary{bytes.data() + (bytes.size() - bytes_to_pad)}};
 
     return encoded.append(bytes_to_pad, '=');
 }
@@ -94,6 +95,41 @@ template <typename T> std::string encodeBase64Bytewise(const T &x)
     return encodeBase64(reinterpret_cast<const unsigned char *>(&x), sizeof(T));
 }
 
+// Encodes bytes that arrive piece by piece. Appending all pieces and finishing returns the same
+// characters as encodeBase64 of all bytes at once.
+class Base64Encoder
+{
+  public:
+    std::string Append(const char *first, const std::size_t size)
+    {
+        pending.insert(pending.end(), first, first + size);
+        const auto complete = pending.size() - pending.size() % 3;
+        if (complete == 0)
+        {
+            return {};
+        }
+        auto encoded = encodeBase64(pending.data(), complete);
+        pending.erase(pending.begin(), pending.begin() + complete);
+        return encoded;
+    }
+
+    // Encodes the remaining bytes with padding
+    std::string Finish()
+    {
+        if (pending.empty())
+        {
+            return {};
+        }
+        auto encoded = encodeBase64(pending.data(), pending.size());
+        pending.clear();
+        return encoded;
+    }
+
+  private:
+    // at most two bytes between calls
+    std::vector<char> pending;
+};
+
 // Decoding Implementation
 
 // Decodes into a chunk of memory that is at least as large as the input.
@@ -104,8 +140,8 @@ template <typename OutputIter> void decodeBase64(const std::string &encoded, Out
     const auto num_padded = std::count(begin(encoded), end(encoded), '=');
     std::replace(begin(unpadded), end(unpadded), '=', 'A'); // A_64 == \0
 
-    std::string decoded{detail::BinaryFromBase64{begin(unpadded)},
-                        detail::BinaryFromBase64{begin(unpadded) + unpadded.length()}};
+    std::string decoded{osrm::detail::BinaryFromBase64{begin(unpadded)},
+                        osrm::detail::BinaryFromBase64{begin(unpadded) + unpadded.length()}};
 
     decoded.erase(end(decoded) - num_padded, end(decoded));
     std::copy(begin(decoded), end(decoded), out);
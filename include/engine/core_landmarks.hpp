@@ -0,0 +1,355 @@
+#ifndef ENGINE_CORE_LANDMARKS_HPP
+#define ENGINE_CORE_LANDMARKS_HPP
+
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+/**
+ * Distances from and to a few landmarks in the core of a partially contracted graph.
+ *
+ * osrm-contract --core leaves the top of the hierarchy uncontracted and queries run a plain
+ * bidirectional Dijkstra in there. With landmarks the core search becomes an A* search (ALT):
+ * the triangle inequality on the landmark distances gives lower bounds on the distance to the
+ * entry points of the other search direction.
+ *
+ * The landmarks are picked greedily, each one is the core node furthest away from the ones
+ * before it. The distances are either computed once for every dataset generation or written by
+ * osrm-contract --core-landmarks and loaded with the rest of the dataset.
+ */
+class CoreLandmarks
+{
+  public:
+    using EntryPoints = std::vector<std::pair<NodeID, EdgeWeight>>;
+
+    /**
+     * Lower bounds of one core search between two sets of entry points with initial weights.
+     *
+     * The potential of a node is the bound on the distance to the reverse entry points minus the
+     * bound on the distance from the forward entry points. Half of it is the A* potential of the
+     * forward search and the negated half the one of the reverse search, so both stay consistent
+     * and the searches can stop as soon as the sum of their smallest keys reaches the best path.
+     */
+    class Potential
+    {
+      public:
+        static const constexpr std::int32_t UNREACHABLE = std::numeric_limits<std::int32_t>::max();
+
+        // UNREACHABLE if node can not be on a path between the entry points
+        std::int32_t operator()(const NodeID node) const
+        {
+            const auto index = landmarks.core_index[node];
+            std::int64_t to_reverse_entries = min_reverse_weight;
+            std::int64_t from_forward_entries = min_forward_weight;
+            if (index == SPECIAL_NODEID)
+            {
+                return static_cast<std::int32_t>(to_reverse_entries - from_forward_entries);
+            }
+
+            const auto number_of_landmarks = landmarks.number_of_landmarks;
+            const auto *distances = &landmarks.distances[2 * number_of_landmarks * index];
+            for (const auto landmark : util::irange<std::size_t>(0, number_of_landmarks))
+            {
+                const auto from_landmark = distances[2 * landmark];
+                const auto to_landmark = distances[2 * landmark + 1];
+                const auto &bound = bounds[landmark];
+
+                if (bound.reverse_from_landmark != INVALID && from_landmark != INVALID)
+                {
+                    to_reverse_entries =
+                        std::max(to_reverse_entries, bound.reverse_from_landmark - from_landmark);
+                }
+                if (bound.reverse_to_landmark != INVALID)
+                {
+                    // all reverse entry points reach the landmark, so node does not reach them
+                    if (to_landmark == INVALID)
+                        return UNREACHABLE;
+                    to_reverse_entries =
+                        std::max(to_reverse_entries, to_landmark - bound.reverse_to_landmark);
+                }
+                if (bound.forward_to_landmark != INVALID && to_landmark != INVALID)
+                {
+                    from_forward_entries =
+                        std::max(from_forward_entries, bound.forward_to_landmark - to_landmark);
+                }
+                if (bound.forward_from_landmark != INVALID)
+                {
+                    if (from_landmark == INVALID)
+                        return UNREACHABLE;
+                    from_forward_entries =
+                        std::max(from_forward_entries, from_landmark - bound.forward_from_landmark);
+                }
+            }
+
+            const auto potential = to_reverse_entries - from_forward_entries;
+            BOOST_ASSERT(potential < UNREACHABLE && potential > -UNREACHABLE);
+            return static_cast<std::int32_t>(potential);
+        }
+
+      private:
+        friend class CoreLandmarks;
+        static const constexpr std::int64_t INVALID = INVALID_EDGE_WEIGHT;
+
+        // Per landmark L, with k the initial weight of an entry point e:
+        // reverse_from_landmark = min(d(L, e) + k), reverse_to_landmark = max(d(e, L) - k) over
+        // the reverse entry points, forward_to_landmark = min(k + d(e, L)) and
+        // forward_from_landmark = max(d(L, e) - k) over the forward ones. The maxima are INVALID
+        // if an entry point does not reach the landmark or is not reached from it.
+        struct Bounds
+        {
+            std::int64_t reverse_from_landmark;
+            std::int64_t reverse_to_landmark;
+            std::int64_t forward_to_landmark;
+            std::int64_t forward_from_landmark;
+        };
+
+        explicit Potential(const CoreLandmarks &landmarks) : landmarks(landmarks) {}
+
+        const CoreLandmarks &landmarks;
+        std::vector<Bounds> bounds;
+        std::int64_t min_forward_weight = 0;
+        std::int64_t min_reverse_weight = 0;
+    };
+
+    // Computes the distances of up to requested_number_of_landmarks landmarks
+    template <typename GraphT>
+    CoreLandmarks(const GraphT &graph, const std::size_t requested_number_of_landmarks)
+    {
+        IndexCoreNodes(graph);
+        number_of_landmarks = std::min(requested_number_of_landmarks, core_nodes.size());
+        if (number_of_landmarks == 0)
+        {
+            return;
+        }
+        computed_distances.resize(2 * number_of_landmarks * core_nodes.size(), INVALID_EDGE_WEIGHT);
+        distances = computed_distances.data();
+
+        const constexpr bool FORWARD = true;
+        const constexpr bool REVERSE = false;
+        std::vector<EdgeWeight> distance;
+        std::vector<EdgeWeight> distance_to_landmarks(core_nodes.size(), INVALID_EDGE_WEIGHT);
+        std::vector<NodeID> landmarks;
+
+        RunDijkstra(graph, 0, FORWARD, distance);
+        auto next_landmark = GetFurthestNode(distance);
+        for (const auto landmark : util::irange<std::size_t>(0, number_of_landmarks))
+        {
+            landmarks.push_back(next_landmark);
+            RunDijkstra(graph, next_landmark, FORWARD, distance);
+            for (const auto index : util::irange<std::size_t>(0, core_nodes.size()))
+            {
+                computed_distances[2 * (number_of_landmarks * index + landmark)] = distance[index];
+                distance_to_landmarks[index] =
+                    std::min(distance_to_landmarks[index], distance[index]);
+            }
+            next_landmark = GetFurthestNode(distance_to_landmarks);
+        }
+
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_landmarks, 1),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                std::vector<EdgeWeight> reverse_distance;
+                for (auto landmark = range.begin(); landmark != range.end(); ++landmark)
+                {
+                    RunDijkstra(graph, landmarks[landmark], REVERSE, reverse_distance);
+                    for (const auto index : util::irange<std::size_t>(0, core_nodes.size()))
+                    {
+                        computed_distances[2 * (number_of_landmarks * index + landmark) + 1] =
+                            reverse_distance[index];
+                    }
+                }
+            });
+    }
+
+    // Uses distances in the layout of GetDistances(), they have to outlive this object
+    template <typename GraphT>
+    CoreLandmarks(const GraphT &graph,
+                  const EdgeWeight *stored_distances,
+                  const std::size_t number_of_distances)
+        : distances(stored_distances)
+    {
+        IndexCoreNodes(graph);
+        if (core_nodes.empty() || number_of_distances % (2 * core_nodes.size()) != 0)
+        {
+            throw util::exception("Core landmarks do not match the core of the graph");
+        }
+        number_of_landmarks = number_of_distances / (2 * core_nodes.size());
+    }
+
+    CoreLandmarks(const CoreLandmarks &) = delete;
+    CoreLandmarks &operator=(const CoreLandmarks &) = delete;
+
+    std::size_t GetNumberOfLandmarks() const { return number_of_landmarks; }
+
+    // By core node in the order of the node ids, landmark and direction: d(landmark, node)
+    // followed by d(node, landmark)
+    const EdgeWeight *GetDistances() const { return distances; }
+    std::size_t GetNumberOfDistances() const { return 2 * number_of_landmarks * core_nodes.size(); }
+
+    Potential GetPotential(const EntryPoints &forward_entry_points,
+                           const EntryPoints &reverse_entry_points) const
+    {
+        using Bounds = Potential::Bounds;
+        const auto INVALID = Potential::INVALID;
+
+        Potential potential(*this);
+        potential.bounds.resize(number_of_landmarks,
+                                Bounds{INVALID, -INVALID, INVALID, -INVALID});
+        const auto min_weight = [](const EntryPoints &entry_points) {
+            std::int64_t weight = entry_points.empty() ? 0 : INVALID;
+            for (const auto &entry_point : entry_points)
+            {
+                weight = std::min<std::int64_t>(weight, entry_point.second);
+            }
+            return weight;
+        };
+        potential.min_forward_weight = min_weight(forward_entry_points);
+        potential.min_reverse_weight = min_weight(reverse_entry_points);
+
+        for (const auto landmark : util::irange<std::size_t>(0, number_of_landmarks))
+        {
+            auto &bounds = potential.bounds[landmark];
+            for (const auto &entry_point : reverse_entry_points)
+            {
+                const auto index = core_index[entry_point.first];
+                BOOST_ASSERT(index != SPECIAL_NODEID);
+                const std::int64_t from_landmark = GetDistance(landmark, index, true);
+                const std::int64_t to_landmark = GetDistance(landmark, index, false);
+                if (from_landmark != INVALID)
+                {
+                    bounds.reverse_from_landmark = std::min(bounds.reverse_from_landmark,
+                                                            from_landmark + entry_point.second);
+                }
+                bounds.reverse_to_landmark =
+                    (to_landmark == INVALID || bounds.reverse_to_landmark == INVALID)
+                        ? INVALID
+                        : std::max(bounds.reverse_to_landmark, to_landmark - entry_point.second);
+            }
+            for (const auto &entry_point : forward_entry_points)
+            {
+                const auto index = core_index[entry_point.first];
+                BOOST_ASSERT(index != SPECIAL_NODEID);
+                const std::int64_t from_landmark = GetDistance(landmark, index, true);
+                const std::int64_t to_landmark = GetDistance(landmark, index, false);
+                if (to_landmark != INVALID)
+                {
+                    bounds.forward_to_landmark =
+                        std::min(bounds.forward_to_landmark, entry_point.second + to_landmark);
+                }
+                bounds.forward_from_landmark =
+                    (from_landmark == INVALID || bounds.forward_from_landmark == INVALID)
+                        ? INVALID
+                        : std::max(bounds.forward_from_landmark,
+                                   from_landmark - entry_point.second);
+            }
+            // without entry points there is nothing to bound
+            if (reverse_entry_points.empty())
+                bounds.reverse_to_landmark = INVALID;
+            if (forward_entry_points.empty())
+                bounds.forward_from_landmark = INVALID;
+        }
+        return potential;
+    }
+
+  private:
+    template <typename GraphT> void IndexCoreNodes(const GraphT &graph)
+    {
+        core_index.assign(graph.GetNumberOfNodes(), SPECIAL_NODEID);
+        for (const auto node : util::irange<NodeID>(0, graph.GetNumberOfNodes()))
+        {
+            if (graph.IsCoreNode(node))
+            {
+                core_index[node] = static_cast<NodeID>(core_nodes.size());
+                core_nodes.push_back(node);
+            }
+        }
+    }
+
+    EdgeWeight GetDistance(const std::size_t landmark, const NodeID index, const bool from) const
+    {
+        return distances[2 * (number_of_landmarks * index + landmark) + (from ? 0 : 1)];
+    }
+
+    // Distances by core index from the core node with index source (forward) or to it (reverse)
+    template <typename GraphT>
+    void RunDijkstra(const GraphT &graph,
+                     const NodeID source,
+                     const bool forward,
+                     std::vector<EdgeWeight> &distance) const
+    {
+        using QueueEntry = std::pair<EdgeWeight, NodeID>;
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+        distance.assign(core_nodes.size(), INVALID_EDGE_WEIGHT);
+        distance[source] = 0;
+        queue.emplace(0, source);
+        while (!queue.empty())
+        {
+            const auto entry = queue.top();
+            queue.pop();
+            if (entry.first > distance[entry.second])
+            {
+                continue;
+            }
+            for (const auto edge : graph.GetAdjacentEdgeRange(core_nodes[entry.second]))
+            {
+                const auto &data = graph.GetEdgeData(edge);
+                const auto target = core_index[graph.GetTarget(edge)];
+                if (!(forward ? data.forward : data.backward) || target == SPECIAL_NODEID)
+                {
+                    continue;
+                }
+                const EdgeWeight target_distance = entry.first + data.distance;
+                if (target_distance < distance[target])
+                {
+                    distance[target] = target_distance;
+                    queue.emplace(target_distance, target);
+                }
+            }
+        }
+    }
+
+    // Core index of the reached node with the largest distance
+    static NodeID GetFurthestNode(const std::vector<EdgeWeight> &distance)
+    {
+        NodeID furthest = 0;
+        for (const auto index : util::irange<NodeID>(0, distance.size()))
+        {
+            if (distance[index] != INVALID_EDGE_WEIGHT &&
+                (distance[furthest] == INVALID_EDGE_WEIGHT || distance[index] > distance[furthest]))
+            {
+                furthest = index;
+            }
+        }
+        return furthest;
+    }
+
+    std::vector<NodeID> core_index;
+    std::vector<NodeID> core_nodes;
+    std::size_t number_of_landmarks = 0;
+    // by core index, landmark and direction: d(landmark, node) followed by d(node, landmark)
+    const EdgeWeight *distances = nullptr;
+    std::vector<EdgeWeight> computed_distances;
+};
+}
+}
+
+#endif // ENGINE_CORE_LANDMARKS_HPP
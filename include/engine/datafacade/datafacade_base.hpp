@@ -5,19 +5,27 @@
 
 #include "contractor/query_edge.hpp"
 #include "extractor/edge_based_node.hpp"
+#include "extractor/edge_classes.hpp"
 #include "extractor/external_memory_node.hpp"
 #include "extractor/guidance/turn_instruction.hpp"
 #include "extractor/guidance/turn_lane_types.hpp"
+#include "engine/bearing.hpp"
 #include "engine/phantom_node.hpp"
+#include "partition/cell_storage.hpp"
+#include "partition/multi_level_partition.hpp"
 #include "util/exception.hpp"
 #include "util/guidance/bearing_class.hpp"
 #include "util/guidance/entry_class.hpp"
 #include "util/integer_range.hpp"
+#include "util/strided_view.hpp"
 #include "util/string_util.hpp"
+#include "util/string_view.hpp"
 #include "util/typedefs.hpp"
 
 #include "osrm/coordinate.hpp"
 
+#include <boost/optional.hpp>
+
 #include <cstddef>
 
 #include <string>
@@ -52,12 +60,39 @@ class BaseDataFacade
 
     virtual const EdgeData &GetEdgeData(const EdgeID e) const = 0;
 
+    // GetTarget and GetEdgeData of an edge in one call, for the relaxation loops of the searches
+    struct AdjacentEdge
+    {
+        NodeID target;
+        EdgeData data;
+    };
+    virtual AdjacentEdge GetAdjacentEdge(const EdgeID e) const = 0;
+
+    // false for datasets of osrm-contract versions that did not write the .edge_lengths file
+    virtual bool HasEdgeLengths() const = 0;
+
+    // in meters, see contractor::WriteEdgeLengths for how shortcuts and node lengths are counted
+    virtual EdgeLength GetEdgeLength(const EdgeID e) const = 0;
+
+    // The copies of an edge-based node on a via way made for via-way restrictions, see
+    // extractor::DuplicatedNode. Routes from the from way of a restriction that end on the via
+    // way end on such a copy, so the searches to a target on the node also search to them.
+    virtual std::vector<NodeID> GetDuplicatedNodes(const NodeID n) const = 0;
+
+    // The node a copy was made of, the node itself if it is no copy
+    virtual NodeID GetOriginalNode(const NodeID n) const = 0;
+
     virtual EdgeID BeginEdges(const NodeID n) const = 0;
 
     virtual EdgeID EndEdges(const NodeID n) const = 0;
 
     virtual EdgeRange GetAdjacentEdgeRange(const NodeID node) const = 0;
 
+    // the part of GetAdjacentEdgeRange that a search in the given direction relaxes. The edges
+    // still need their direction checked, graphs of older osrm-contract versions return all edges.
+    virtual EdgeRange GetDirectedEdgeRange(const NodeID node,
+                                           const bool forward_direction) const = 0;
+
     // searches for a specific edge
     virtual EdgeID FindEdge(const NodeID from, const NodeID to) const = 0;
 
@@ -85,6 +120,14 @@ class BaseDataFacade
     virtual void GetUncompressedDatasources(const EdgeID id,
                                             std::vector<uint8_t> &data_sources) const = 0;
 
+    // Same as the three functions above, but the views point into the memory of the facade
+    // instead of copying. They are valid as long as the facade is.
+    virtual util::StridedView<NodeID> GetUncompressedGeometryView(const EdgeID id) const = 0;
+
+    virtual util::StridedView<EdgeWeight> GetUncompressedWeightsView(const EdgeID id) const = 0;
+
+    virtual util::StridedView<uint8_t> GetUncompressedDatasourcesView(const EdgeID id) const = 0;
+
     // Gets the name of a datasource
     virtual std::string GetDatasourceName(const uint8_t datasource_name_id) const = 0;
 
@@ -123,6 +166,13 @@ class BaseDataFacade
     NearestPhantomNodes(const util::Coordinate input_coordinate,
                         const unsigned max_results,
                         const double max_distance) const = 0;
+    // max_results nearest PhantomNodes for every coordinate in one batched query, radiuses and
+    // bearings are either empty or have an entry per coordinate
+    virtual std::vector<std::vector<PhantomNodeWithDistance>>
+    NearestPhantomNodes(const std::vector<util::Coordinate> &input_coordinates,
+                        const unsigned max_results,
+                        const std::vector<boost::optional<double>> &radiuses,
+                        const std::vector<boost::optional<Bearing>> &bearings) const = 0;
 
     virtual std::pair<PhantomNode, PhantomNode> NearestPhantomNodeWithAlternativeFromBigComponent(
         const util::Coordinate input_coordinate) const = 0;
@@ -138,6 +188,9 @@ class BaseDataFacade
     NearestPhantomNodeWithAlternativeFromBigComponent(const util::Coordinate input_coordinate,
                                                       const int bearing,
                                                       const int bearing_range) const = 0;
+    virtual std::vector<std::pair<PhantomNode, PhantomNode>>
+    NearestPhantomNodesWithAlternativeFromBigComponent(
+        const std::vector<util::Coordinate> &input_coordinates) const = 0;
 
     virtual bool hasLaneData(const EdgeID id) const = 0;
     virtual util::guidance::LaneTupelIdPair GetLaneData(const EdgeID id) const = 0;
@@ -156,10 +209,39 @@ class BaseDataFacade
 
     virtual std::string GetDestinationsForID(const unsigned name_id) const = 0;
 
+    // Same as the three functions above without copying, valid as long as the facade is
+    virtual util::StringView GetNameViewForID(const unsigned name_id) const = 0;
+
+    virtual util::StringView GetPronunciationViewForID(const unsigned name_id) const = 0;
+
+    virtual util::StringView GetDestinationsViewForID(const unsigned name_id) const = 0;
+
     virtual std::size_t GetCoreSize() const = 0;
 
+    // landmark distances of osrm-contract --core-landmarks, see CoreLandmarks
+    virtual std::size_t GetNumberOfCoreLandmarkDistances() const = 0;
+
+    virtual const EdgeWeight *GetCoreLandmarkDistances() const = 0;
+
+    // weights of osrm-contract --time-slot-speed-file, GetEdgeData and GetUncompressedWeights
+    // return the ones of the ActiveTimeSlot() of the calling thread
+    virtual unsigned GetNumberOfTimeSlots() const = 0;
+
+    // in seconds
+    virtual unsigned GetTimeSlotDuration() const = 0;
+
+    // weights of osrm-contract --metric-speed-file, selected like time slots, see MetricTimeSlot
+    virtual unsigned GetNumberOfMetrics() const = 0;
+
+    // classes whose edges metric n > 0 excludes, see osrm-contract --exclude-classes
+    virtual extractor::EdgeClasses GetExcludedClasses(const unsigned metric) const = 0;
+
     virtual std::string GetTimestamp() const = 0;
 
+    // false for datasets of osrm-datastore --weights-only, which lack names, OSM node ids,
+    // datasources and all of guidance and only answer distance tables
+    virtual bool HasGuidanceData() const = 0;
+
     virtual bool GetContinueStraightDefault() const = 0;
 
     virtual BearingClassID GetBearingClassID(const NodeID id) const = 0;
@@ -167,9 +249,31 @@ class BaseDataFacade
     virtual util::guidance::BearingClass
     GetBearingClass(const BearingClassID bearing_class_id) const = 0;
 
+    // the bearings of GetBearingClass without copying them, valid as long as the facade
+    virtual util::guidance::BearingRange
+    GetBearings(const BearingClassID bearing_class_id) const = 0;
+
     virtual EntryClassID GetEntryClassID(const EdgeID eid) const = 0;
 
     virtual util::guidance::EntryClass GetEntryClass(const EntryClassID entry_class_id) const = 0;
+
+    // multi-level Dijkstra data, only available if HasMultiLevelData()
+    virtual bool HasMultiLevelData() const = 0;
+
+    virtual const partition::MultiLevelPartition &GetMultiLevelPartition() const = 0;
+
+    virtual const partition::CellStorage &GetCellStorage() const = 0;
+
+    // the uncontracted edge-based graph the cells were customized on
+    virtual EdgeRange GetUncontractedAdjacentEdgeRange(const NodeID node) const = 0;
+
+    virtual NodeID GetUncontractedTarget(const EdgeID e) const = 0;
+
+    virtual const EdgeData &GetUncontractedEdgeData(const EdgeID e) const = 0;
+
+    // Faults in the mapped pages of the dataset and the r-tree leaves, so that the first queries
+    // do not wait for the disk
+    virtual void WarmUp() const = 0;
 };
 }
 }
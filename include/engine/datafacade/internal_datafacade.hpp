@@ -9,27 +9,39 @@
 #include "util/guidance/bearing_class.hpp"
 #include "util/guidance/entry_class.hpp"
 
+#include "contractor/time_slots.hpp"
 #include "extractor/compressed_edge_container.hpp"
+#include "extractor/duplicated_node.hpp"
 #include "extractor/original_edge_data.hpp"
 #include "extractor/profile_properties.hpp"
 #include "extractor/query_node.hpp"
 #include "storage/storage_config.hpp"
 #include "engine/geospatial_query.hpp"
+#include "engine/time_slot.hpp"
+#include "util/block_encoded_coordinates.hpp"
+#include "util/delta_encoded_geometries.hpp"
+#include "util/fingerprint.hpp"
 #include "util/graph_loader.hpp"
+#include "util/intermediate_file.hpp"
 #include "util/guidance/turn_lanes.hpp"
 #include "util/io.hpp"
+#include "util/make_unique.hpp"
+#include "util/name_table.hpp"
 #include "util/packed_vector.hpp"
 #include "util/range_table.hpp"
 #include "util/rectangle.hpp"
+#include "util/segment_weight_list.hpp"
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/simple_logger.hpp"
 #include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
+#include "util/touch_pages.hpp"
 #include "util/typedefs.hpp"
 
 #include "osrm/coordinate.hpp"
 
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 
 #include <algorithm>
@@ -46,6 +58,7 @@
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/thread/tss.hpp>
 
 namespace osrm
@@ -60,11 +73,12 @@ class InternalDataFacade final : public BaseDataFacade
 
   private:
     using super = BaseDataFacade;
-    using QueryGraph = util::StaticGraph<typename super::EdgeData>;
+    // the arrays of the graphs are loaded or mapped by LoadFileRange
+    using QueryGraph = util::StaticGraph<typename super::EdgeData, true>;
     using InputEdge = QueryGraph::InputEdge;
     using RTreeLeaf = super::RTreeLeaf;
     using InternalRTree =
-        util::StaticRTree<RTreeLeaf, util::ShM<util::Coordinate, false>::vector, false>;
+        util::StaticRTree<RTreeLeaf, util::CoordinateList<false>, false>;
     using InternalGeospatialQuery = GeospatialQuery<InternalRTree, BaseDataFacade>;
 
     InternalDataFacade() {}
@@ -72,20 +86,35 @@ class InternalDataFacade final : public BaseDataFacade
     unsigned m_check_sum;
     unsigned m_number_of_nodes;
     std::unique_ptr<QueryGraph> m_query_graph;
+    // whether the .hsgr orders the edges of each node by direction
+    bool m_direction_ordered;
     std::string m_timestamp;
 
-    util::ShM<util::Coordinate, false>::vector m_coordinate_list;
-    util::PackedVector<OSMNodeID, false> m_osmnodeid_list;
+    util::CoordinateList<false> m_coordinate_list;
+    util::PackedOSMNodeIDs<false> m_osmnodeid_list;
     util::ShM<NodeID, false>::vector m_via_node_list;
     util::ShM<unsigned, false>::vector m_name_ID_list;
     util::ShM<extractor::guidance::TurnInstruction, false>::vector m_turn_instruction_list;
     util::ShM<LaneDataID, false>::vector m_lane_data_id;
     util::ShM<util::guidance::LaneTupelIdPair, false>::vector m_lane_tupel_id_pairs;
-    util::ShM<extractor::TravelMode, false>::vector m_travel_mode_list;
-    util::ShM<char, false>::vector m_names_char_list;
-    util::ShM<unsigned, false>::vector m_geometry_indices;
-    util::ShM<extractor::CompressedEdgeContainer::CompressedEdge, false>::vector m_geometry_list;
+    util::PackedVector<extractor::TravelMode, TRAVEL_MODE_BITS> m_travel_mode_list;
+    util::ShM<unsigned, true>::vector m_geometry_indices;
+    util::ShM<extractor::CompressedEdgeContainer::CompressedEdge, true>::vector m_geometry_list;
+    // replaces m_geometry_list if not empty
+    util::DeltaEncodedGeometries<false> m_encoded_geometries;
     util::ShM<bool, false>::vector m_is_core_node;
+    util::ShM<EdgeWeight, true>::vector m_core_landmark_distances;
+    util::ShM<EdgeLength, true>::vector m_edge_lengths;
+    util::ShM<extractor::DuplicatedNode, true>::vector m_duplicated_nodes;
+    // the same copies sorted by their ids, so that GetOriginalNode is a binary search as well
+    std::vector<extractor::DuplicatedNode> m_duplicated_nodes_by_duplicate;
+    util::ShM<EdgeData, false>::vector m_time_slot_edge_data;
+    util::SegmentWeightList<false> m_time_slot_segment_weights;
+    unsigned m_number_of_time_slots = 0;
+    unsigned m_time_slot_duration = 0;
+    unsigned m_number_of_metrics = 0;
+    std::array<extractor::EdgeClasses, contractor::TimeSlotsHeader::MAX_METRICS>
+        m_metric_excluded_classes{};
     util::ShM<unsigned, false>::vector m_segment_weights;
     util::ShM<uint8_t, false>::vector m_datasource_list;
     util::ShM<std::string, false>::vector m_datasource_names;
@@ -97,7 +126,7 @@ class InternalDataFacade final : public BaseDataFacade
     std::unique_ptr<InternalGeospatialQuery> m_geospatial_query;
     boost::filesystem::path ram_index_path;
     boost::filesystem::path file_index_path;
-    util::RangeTable<16, false> m_name_table;
+    util::NameTable m_name_table;
 
     // bearing classes by node based node
     util::ShM<BearingClassID, false>::vector m_bearing_class_id_table;
@@ -111,6 +140,111 @@ class InternalDataFacade final : public BaseDataFacade
     util::RangeTable<16, false> m_bearing_ranges_table;
     util::ShM<DiscreteBearing, false>::vector m_bearing_values_table;
 
+    // multi-level Dijkstra data, see osrm-partition and osrm-customize
+    bool m_has_multi_level_data = false;
+    partition::MultiLevelPartition m_multi_level_partition;
+    partition::CellStorage m_cell_storage;
+    std::unique_ptr<QueryGraph> m_uncontracted_graph;
+
+    // Blocks that are stored in the files as they are used, see LoadFileRange. Either the files
+    // are mapped with lazy loading or the blocks are read into buffers owned by the facade.
+    bool m_lazy_loading = false;
+    std::unordered_map<std::string, boost::iostreams::mapped_file_source> m_mapped_files;
+    std::vector<std::unique_ptr<char[]>> m_loaded_blocks;
+
+    // Points view at count objects of type T at offset in the file. With lazy loading the pages
+    // of the file are only read on first access and are shared with other processes through the
+    // page cache.
+    template <typename T>
+    void LoadFileRange(const boost::filesystem::path &path,
+                       const std::uint64_t offset,
+                       const std::size_t count,
+                       util::SharedMemoryWrapper<T> &view)
+    {
+        const std::uint64_t size = sizeof(T) * std::uint64_t{count};
+        if (count == 0)
+        {
+            view.reset(nullptr, 0);
+            return;
+        }
+        // compressed intermediates can not be mapped and are always read
+        const bool compressed = util::IsCompressedFile(path);
+        if (!compressed && boost::filesystem::file_size(path) < offset + size)
+        {
+            throw util::exception(path.string() + " is truncated, run the preprocessing again");
+        }
+
+        if (m_lazy_loading && !compressed)
+        {
+            auto mapped_file = m_mapped_files.find(path.string());
+            if (mapped_file == m_mapped_files.end())
+            {
+                mapped_file =
+                    m_mapped_files
+                        .emplace(path.string(), boost::iostreams::mapped_file_source(path))
+                        .first;
+            }
+            const auto address = mapped_file->second.data() + offset;
+            if (reinterpret_cast<std::uintptr_t>(address) % alignof(T) != 0)
+            {
+                throw util::exception("Can not map misaligned data of " + path.string());
+            }
+            view.reset(reinterpret_cast<T *>(const_cast<char *>(address)), count);
+            return;
+        }
+
+        std::unique_ptr<char[]> buffer(new char[size]);
+        util::IntermediateInputFile stream(path);
+        stream.seekg(offset);
+        stream.read(buffer.get(), size);
+        if (!stream)
+        {
+            throw util::exception("Could not read " + path.string());
+        }
+        view.reset(reinterpret_cast<T *>(buffer.get()), count);
+        m_loaded_blocks.push_back(std::move(buffer));
+    }
+
+    // Same format as readHSGRFromStream
+    std::unique_ptr<QueryGraph> LoadHSGR(const boost::filesystem::path &hsgr_path,
+                                         unsigned &check_sum,
+                                         unsigned &number_of_nodes)
+    {
+        boost::filesystem::ifstream hsgr_stream(hsgr_path, std::ios::binary);
+        if (!hsgr_stream)
+        {
+            throw util::exception("Could not open " + hsgr_path.string() + " for reading.");
+        }
+
+        util::FingerPrint fingerprint_loaded;
+        hsgr_stream.read(reinterpret_cast<char *>(&fingerprint_loaded), sizeof(util::FingerPrint));
+        if (!fingerprint_loaded.TestGraphUtil(util::FingerPrint::GetValid()))
+        {
+            util::SimpleLogger().Write(logWARNING) << ".hsgr was prepared with different build.\n"
+                                                      "Reprocess to get rid of this warning.";
+        }
+
+        unsigned number_of_edges = 0;
+        hsgr_stream.read(reinterpret_cast<char *>(&check_sum), sizeof(unsigned));
+        hsgr_stream.read(reinterpret_cast<char *>(&number_of_nodes), sizeof(unsigned));
+        hsgr_stream.read(reinterpret_cast<char *>(&number_of_edges), sizeof(unsigned));
+        if (!hsgr_stream)
+        {
+            throw util::exception("Could not read " + hsgr_path.string());
+        }
+        const std::uint64_t nodes_offset = hsgr_stream.tellg();
+        const std::uint64_t edges_offset =
+            nodes_offset + sizeof(QueryGraph::NodeArrayEntry) * std::uint64_t{number_of_nodes};
+
+        util::ShM<QueryGraph::NodeArrayEntry, true>::vector node_list;
+        util::ShM<QueryGraph::EdgeArrayEntry, true>::vector edge_list;
+        LoadFileRange(hsgr_path, nodes_offset, number_of_nodes, node_list);
+        LoadFileRange(hsgr_path, edges_offset, number_of_edges, edge_list);
+        util::SimpleLogger().Write() << "loaded " << node_list.size() << " nodes and "
+                                     << edge_list.size() << " edges";
+        return util::make_unique<QueryGraph>(node_list, edge_list);
+    }
+
     void LoadProfileProperties(const boost::filesystem::path &properties_path)
     {
         boost::filesystem::ifstream in_stream(properties_path);
@@ -150,50 +284,78 @@ class InternalDataFacade final : public BaseDataFacade
 
     void LoadGraph(const boost::filesystem::path &hsgr_path)
     {
-        util::ShM<QueryGraph::NodeArrayEntry, false>::vector node_list;
-        util::ShM<QueryGraph::EdgeArrayEntry, false>::vector edge_list;
-
         util::SimpleLogger().Write() << "loading graph from " << hsgr_path.string();
 
-        m_number_of_nodes = readHSGRFromStream(hsgr_path, node_list, edge_list, &m_check_sum);
-
-        BOOST_ASSERT_MSG(0 != node_list.size(), "node list empty");
-        // BOOST_ASSERT_MSG(0 != edge_list.size(), "edge list empty");
-        util::SimpleLogger().Write() << "loaded " << node_list.size() << " nodes and "
-                                     << edge_list.size() << " edges";
-        m_query_graph = std::unique_ptr<QueryGraph>(new QueryGraph(node_list, edge_list));
+        m_query_graph = LoadHSGR(hsgr_path, m_check_sum, m_number_of_nodes);
+        m_direction_ordered = m_query_graph->IsDirectionOrdered();
 
-        BOOST_ASSERT_MSG(0 == node_list.size(), "node list not flushed");
-        BOOST_ASSERT_MSG(0 == edge_list.size(), "edge list not flushed");
+        BOOST_ASSERT_MSG(0 != m_number_of_nodes, "node list empty");
         util::SimpleLogger().Write() << "Data checksum is " << m_check_sum;
     }
 
+    void LoadMultiLevelData(const boost::filesystem::path &partition_path,
+                            const boost::filesystem::path &cells_path,
+                            const boost::filesystem::path &mld_graph_path)
+    {
+        unsigned check_sum = 0;
+        unsigned number_of_nodes = 0;
+        m_uncontracted_graph = LoadHSGR(mld_graph_path, check_sum, number_of_nodes);
+
+        m_multi_level_partition.Read(partition_path.string());
+        m_cell_storage.Read(cells_path.string());
+
+        if (m_multi_level_partition.GetNumberOfNodes() !=
+                m_uncontracted_graph->GetNumberOfNodes() ||
+            m_multi_level_partition.GetNumberOfLevels() != m_cell_storage.GetNumberOfLevels())
+        {
+            throw util::exception(mld_graph_path.string() + ", " + partition_path.string() +
+                                  " and " + cells_path.string() + " do not match");
+        }
+        m_has_multi_level_data = true;
+    }
+
     void LoadNodeAndEdgeInformation(const boost::filesystem::path &nodes_file,
-                                    const boost::filesystem::path &edges_file)
+                                    const boost::filesystem::path &edges_file,
+                                    const bool compress_coordinates)
     {
-        boost::filesystem::ifstream nodes_input_stream(nodes_file, std::ios::binary);
+        util::IntermediateInputFile nodes_input_stream(nodes_file);
 
         extractor::QueryNode current_node;
         unsigned number_of_coordinates = 0;
         nodes_input_stream.read((char *)&number_of_coordinates, sizeof(unsigned));
-        m_coordinate_list.resize(number_of_coordinates);
+        std::vector<util::Coordinate> coordinates(number_of_coordinates);
         m_osmnodeid_list.reserve(number_of_coordinates);
         for (unsigned i = 0; i < number_of_coordinates; ++i)
         {
             nodes_input_stream.read((char *)&current_node, sizeof(extractor::QueryNode));
-            m_coordinate_list[i] = util::Coordinate(current_node.lon, current_node.lat);
+            coordinates[i] = util::Coordinate(current_node.lon, current_node.lat);
             m_osmnodeid_list.push_back(current_node.node_id);
-            BOOST_ASSERT(m_coordinate_list[i].IsValid());
+            BOOST_ASSERT(coordinates[i].IsValid());
+        }
+        if (compress_coordinates)
+        {
+            std::vector<util::BlockEncodedCoordinates<false>::Block> blocks;
+            std::vector<std::uint64_t> words;
+            util::BlockEncodedCoordinates<false>::Encode(coordinates, blocks, words);
+            util::BlockEncodedCoordinates<false> encoded;
+            encoded.Reset(std::move(blocks), std::move(words));
+            m_coordinate_list.Reset(std::move(encoded));
+            util::SimpleLogger().Write() << "compressed coordinates to "
+                                         << m_coordinate_list.SizeInBytes() << " bytes";
+        }
+        else
+        {
+            m_coordinate_list.Reset(std::move(coordinates));
         }
 
-        boost::filesystem::ifstream edges_input_stream(edges_file, std::ios::binary);
+        util::IntermediateInputFile edges_input_stream(edges_file);
         unsigned number_of_edges = 0;
         edges_input_stream.read((char *)&number_of_edges, sizeof(unsigned));
         m_via_node_list.resize(number_of_edges);
         m_name_ID_list.resize(number_of_edges);
         m_turn_instruction_list.resize(number_of_edges);
         m_lane_data_id.resize(number_of_edges);
-        m_travel_mode_list.resize(number_of_edges);
+        m_travel_mode_list.reserve(number_of_edges);
         m_entry_class_id_list.resize(number_of_edges);
 
         extractor::OriginalEdgeData current_edge_data;
@@ -205,7 +367,7 @@ class InternalDataFacade final : public BaseDataFacade
             m_name_ID_list[i] = current_edge_data.name_id;
             m_turn_instruction_list[i] = current_edge_data.turn_instruction;
             m_lane_data_id[i] = current_edge_data.lane_data_id;
-            m_travel_mode_list[i] = current_edge_data.travel_mode;
+            m_travel_mode_list.push_back(current_edge_data.travel_mode);
             m_entry_class_id_list[i] = current_edge_data.entry_classid;
         }
     }
@@ -233,32 +395,161 @@ class InternalDataFacade final : public BaseDataFacade
         }
     }
 
-    void LoadGeometries(const boost::filesystem::path &geometry_file)
+    void LoadCoreLandmarks(const boost::filesystem::path &core_landmarks_file)
+    {
+        boost::filesystem::ifstream landmarks_stream(core_landmarks_file, std::ios::binary);
+        std::uint64_t number_of_distances = 0;
+        landmarks_stream.read((char *)&number_of_distances, sizeof(std::uint64_t));
+        if (!landmarks_stream)
+        {
+            throw util::exception("Could not read " + core_landmarks_file.string());
+        }
+        LoadFileRange(core_landmarks_file,
+                      sizeof(std::uint64_t),
+                      number_of_distances,
+                      m_core_landmark_distances);
+    }
+
+    void LoadEdgeLengths(const boost::filesystem::path &edge_lengths_file)
     {
-        std::ifstream geometry_stream(geometry_file.string().c_str(), std::ios::binary);
+        boost::filesystem::ifstream edge_lengths_stream(edge_lengths_file, std::ios::binary);
+        std::uint64_t number_of_edges = 0;
+        edge_lengths_stream.read((char *)&number_of_edges, sizeof(std::uint64_t));
+        if (number_of_edges != m_query_graph->GetNumberOfEdges())
+        {
+            throw util::exception(edge_lengths_file.string() +
+                                  " does not match the graph, run osrm-contract again");
+        }
+        LoadFileRange(edge_lengths_file, sizeof(std::uint64_t), number_of_edges, m_edge_lengths);
+    }
+
+    void LoadDuplicatedNodes(const boost::filesystem::path &duplicated_nodes_file)
+    {
+        boost::filesystem::ifstream duplicated_nodes_stream(duplicated_nodes_file,
+                                                            std::ios::binary);
+        if (!util::readAndCheckFingerprint(duplicated_nodes_stream))
+        {
+            throw util::exception("Fingerprint of " + duplicated_nodes_file.string() +
+                                  " does not match or could not read from file");
+        }
+        std::uint64_t number_of_duplicated_nodes = 0;
+        duplicated_nodes_stream.read((char *)&number_of_duplicated_nodes, sizeof(std::uint64_t));
+        LoadFileRange(duplicated_nodes_file,
+                      sizeof(util::FingerPrint) + sizeof(std::uint64_t),
+                      number_of_duplicated_nodes,
+                      m_duplicated_nodes);
+        m_duplicated_nodes_by_duplicate = extractor::SortByDuplicate(
+            m_duplicated_nodes.data(), m_duplicated_nodes.data() + m_duplicated_nodes.size());
+    }
+
+    void LoadTimeSlots(const boost::filesystem::path &time_slots_file)
+    {
+        boost::filesystem::ifstream time_slots_stream(time_slots_file, std::ios::binary);
+        contractor::TimeSlotsHeader header;
+        time_slots_stream.read((char *)&header, sizeof(contractor::TimeSlotsHeader));
+        if (!time_slots_stream)
+        {
+            throw util::exception("Could not read " + time_slots_file.string());
+        }
+        if (header.number_of_edges != m_query_graph->GetNumberOfEdges() ||
+            header.number_of_geometry_segments != NumberOfGeometrySegments())
+        {
+            throw util::exception(time_slots_file.string() +
+                                  " does not match the graph, run osrm-contract again");
+        }
+
+        // segment weights that all fit into 16 bits are kept as such
+        const bool narrow = header.segment_weight_bytes == sizeof(std::uint16_t);
+        const auto number_of_segment_weights =
+            header.GetNumberOfOverlays() * header.number_of_geometry_segments;
+        std::vector<EdgeWeight> segment_weights(
+            narrow ? header.number_of_geometry_segments : number_of_segment_weights);
+        std::vector<std::uint16_t> narrow_segment_weights(narrow ? number_of_segment_weights : 0);
+        m_time_slot_edge_data.resize(header.GetNumberOfOverlays() * header.number_of_edges);
+        for (const auto slot : util::irange(0u, header.GetNumberOfOverlays()))
+        {
+            const auto slot_offset = slot * header.number_of_geometry_segments;
+            time_slots_stream.read((char *)(m_time_slot_edge_data.data() +
+                                            slot * header.number_of_edges),
+                                   sizeof(EdgeData) * header.number_of_edges);
+            time_slots_stream.read(
+                (char *)(segment_weights.data() + (narrow ? 0 : slot_offset)),
+                sizeof(EdgeWeight) * header.number_of_geometry_segments);
+            if (narrow)
+            {
+                std::transform(segment_weights.begin(),
+                               segment_weights.end(),
+                               narrow_segment_weights.begin() + slot_offset,
+                               util::SegmentWeightList<false>::Narrow);
+            }
+        }
+        if (!time_slots_stream)
+        {
+            throw util::exception("Could not read " + time_slots_file.string());
+        }
+        if (narrow)
+        {
+            m_time_slot_segment_weights.Reset(std::move(narrow_segment_weights));
+        }
+        else
+        {
+            m_time_slot_segment_weights.Reset(std::move(segment_weights));
+        }
+        m_number_of_time_slots = header.number_of_slots;
+        m_time_slot_duration = header.slot_duration;
+        m_number_of_metrics = header.number_of_metrics;
+        m_metric_excluded_classes = header.metric_excluded_classes;
+    }
+
+    void LoadGeometries(const boost::filesystem::path &geometry_file, const bool compress)
+    {
+        util::IntermediateInputFile geometry_stream(geometry_file);
         unsigned number_of_indices = 0;
         unsigned number_of_compressed_geometries = 0;
 
         geometry_stream.read((char *)&number_of_indices, sizeof(unsigned));
+        LoadFileRange(geometry_file, sizeof(unsigned), number_of_indices, m_geometry_indices);
 
-        m_geometry_indices.resize(number_of_indices);
-        if (number_of_indices > 0)
+        const std::uint64_t list_offset = sizeof(unsigned) * (number_of_indices + 2ull);
+        geometry_stream.seekg(list_offset - sizeof(unsigned));
+        geometry_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
+        if (!geometry_stream)
         {
-            geometry_stream.read((char *)&(m_geometry_indices[0]),
-                                 number_of_indices * sizeof(unsigned));
+            throw util::exception("Could not read " + geometry_file.string());
         }
+        BOOST_ASSERT(number_of_indices == 0 ||
+                     m_geometry_indices[number_of_indices - 1] == number_of_compressed_geometries);
 
-        geometry_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
-
-        BOOST_ASSERT(m_geometry_indices.back() == number_of_compressed_geometries);
-        m_geometry_list.resize(number_of_compressed_geometries);
-
-        if (number_of_compressed_geometries > 0)
+        if (compress && number_of_indices > 0)
         {
-            geometry_stream.read((char *)&(m_geometry_list[0]),
+            // the encoded geometries replace the list, which is only needed to encode them
+            std::vector<extractor::CompressedEdgeContainer::CompressedEdge> geometry_list(
+                number_of_compressed_geometries);
+            geometry_stream.read((char *)geometry_list.data(),
                                  number_of_compressed_geometries *
                                      sizeof(extractor::CompressedEdgeContainer::CompressedEdge));
+            if (!geometry_stream)
+            {
+                throw util::exception("Could not read " + geometry_file.string());
+            }
+            std::vector<std::uint64_t> block_offsets;
+            std::vector<unsigned char> bytes;
+            util::DeltaEncodedGeometries<false>::Encode(
+                m_geometry_indices, geometry_list, block_offsets, bytes);
+            m_encoded_geometries.Reset(std::move(block_offsets), std::move(bytes));
+            util::SimpleLogger().Write() << "compressed geometries to "
+                                         << m_encoded_geometries.SizeInBytes() << " bytes";
+            return;
         }
+
+        LoadFileRange(
+            geometry_file, list_offset, number_of_compressed_geometries, m_geometry_list);
+    }
+
+    // the segments of all geometries, which index the time slot weights as well
+    std::size_t NumberOfGeometrySegments() const
+    {
+        return m_geometry_indices.empty() ? 0 : m_geometry_indices[m_geometry_indices.size() - 1];
     }
 
     void LoadDatasourceInfo(const boost::filesystem::path &datasource_names_file,
@@ -316,19 +607,7 @@ class InternalDataFacade final : public BaseDataFacade
 
     void LoadStreetNames(const boost::filesystem::path &names_file)
     {
-        boost::filesystem::ifstream name_stream(names_file, std::ios::binary);
-
-        name_stream >> m_name_table;
-
-        unsigned number_of_chars = 0;
-        name_stream.read((char *)&number_of_chars, sizeof(unsigned));
-        BOOST_ASSERT_MSG(0 != number_of_chars, "name file broken");
-        m_names_char_list.resize(number_of_chars + 1); //+1 gives sentinel element
-        name_stream.read((char *)&m_names_char_list[0], number_of_chars * sizeof(char));
-        if (0 == m_names_char_list.size())
-        {
-            util::SimpleLogger().Write(logWARNING) << "list of street names is empty";
-        }
+        m_name_table = util::NameTable(names_file.string());
     }
 
     void LoadIntersectionClasses(const boost::filesystem::path &intersection_class_file)
@@ -387,22 +666,48 @@ class InternalDataFacade final : public BaseDataFacade
         m_geospatial_query.reset();
     }
 
-    explicit InternalDataFacade(const storage::StorageConfig &config)
+    explicit InternalDataFacade(const storage::StorageConfig &config,
+                                const bool load_multi_level_data = false)
     {
         ram_index_path = config.ram_index_path;
         file_index_path = config.file_index_path;
+        m_lazy_loading = config.lazy_loading;
 
         util::SimpleLogger().Write() << "loading graph data";
         LoadGraph(config.hsgr_data_path);
 
         util::SimpleLogger().Write() << "loading edge information";
-        LoadNodeAndEdgeInformation(config.nodes_data_path, config.edges_data_path);
+        LoadNodeAndEdgeInformation(
+            config.nodes_data_path, config.edges_data_path, config.compress_coordinates);
+
+        if (boost::filesystem::exists(config.edge_lengths_path))
+        {
+            util::SimpleLogger().Write() << "loading edge lengths";
+            LoadEdgeLengths(config.edge_lengths_path);
+        }
+
+        if (boost::filesystem::exists(config.duplicated_nodes_path))
+        {
+            LoadDuplicatedNodes(config.duplicated_nodes_path);
+        }
 
         util::SimpleLogger().Write() << "loading core information";
         LoadCoreInformation(config.core_data_path);
 
+        if (boost::filesystem::exists(config.core_landmarks_path))
+        {
+            util::SimpleLogger().Write() << "loading core landmarks";
+            LoadCoreLandmarks(config.core_landmarks_path);
+        }
+
         util::SimpleLogger().Write() << "loading geometries";
-        LoadGeometries(config.geometries_path);
+        LoadGeometries(config.geometries_path, config.compress_geometries);
+
+        if (boost::filesystem::exists(config.time_slots_path))
+        {
+            util::SimpleLogger().Write() << "loading time slots";
+            LoadTimeSlots(config.time_slots_path);
+        }
 
         util::SimpleLogger().Write() << "loading datasource info";
         LoadDatasourceInfo(config.datasource_names_path, config.datasource_indexes_path);
@@ -427,6 +732,12 @@ class InternalDataFacade final : public BaseDataFacade
 
         util::SimpleLogger().Write() << "Loading Lane Data Pairs";
         LoadLaneTupelIdPairs(config.turn_lane_data_path);
+
+        if (load_multi_level_data)
+        {
+            util::SimpleLogger().Write() << "loading multi-level Dijkstra data";
+            LoadMultiLevelData(config.partition_path, config.cells_path, config.mld_graph_path);
+        }
     }
 
     // search graph access
@@ -441,11 +752,49 @@ class InternalDataFacade final : public BaseDataFacade
 
     NodeID GetTarget(const EdgeID e) const override final { return m_query_graph->GetTarget(e); }
 
-    EdgeData &GetEdgeData(const EdgeID e) const override final
+    const EdgeData &GetEdgeData(const EdgeID e) const override final
     {
+        if (m_number_of_time_slots + m_number_of_metrics > 0 &&
+            ActiveTimeSlot() != INVALID_TIME_SLOT)
+        {
+            BOOST_ASSERT(ActiveTimeSlot() < m_number_of_time_slots + m_number_of_metrics);
+            return m_time_slot_edge_data.at(
+                static_cast<std::size_t>(ActiveTimeSlot()) * m_query_graph->GetNumberOfEdges() + e);
+        }
         return m_query_graph->GetEdgeData(e);
     }
 
+    AdjacentEdge GetAdjacentEdge(const EdgeID e) const override final
+    {
+        return {m_query_graph->GetTarget(e), GetEdgeData(e)};
+    }
+
+    bool HasEdgeLengths() const override final { return !m_edge_lengths.empty(); }
+
+    EdgeLength GetEdgeLength(const EdgeID e) const override final
+    {
+        BOOST_ASSERT(e < m_edge_lengths.size());
+        return m_edge_lengths[e];
+    }
+
+    std::vector<NodeID> GetDuplicatedNodes(const NodeID n) const override final
+    {
+        if (m_duplicated_nodes.empty())
+        {
+            return {};
+        }
+        return extractor::FindDuplicates(
+            &m_duplicated_nodes[0], &m_duplicated_nodes[0] + m_duplicated_nodes.size(), n);
+    }
+
+    NodeID GetOriginalNode(const NodeID n) const override final
+    {
+        return extractor::FindOriginal(
+            m_duplicated_nodes_by_duplicate.data(),
+            m_duplicated_nodes_by_duplicate.data() + m_duplicated_nodes_by_duplicate.size(),
+            n);
+    }
+
     EdgeID BeginEdges(const NodeID n) const override final { return m_query_graph->BeginEdges(n); }
 
     EdgeID EndEdges(const NodeID n) const override final { return m_query_graph->EndEdges(n); }
@@ -455,6 +804,13 @@ class InternalDataFacade final : public BaseDataFacade
         return m_query_graph->GetAdjacentEdgeRange(node);
     }
 
+    EdgeRange GetDirectedEdgeRange(const NodeID node,
+                                   const bool forward_direction) const override final
+    {
+        return m_direction_ordered ? m_query_graph->GetDirectedEdgeRange(node, forward_direction)
+                                   : m_query_graph->GetAdjacentEdgeRange(node);
+    }
+
     // searches for a specific edge
     EdgeID FindEdge(const NodeID from, const NodeID to) const override final
     {
@@ -543,6 +899,18 @@ class InternalDataFacade final : public BaseDataFacade
         return m_geospatial_query->NearestPhantomNodes(input_coordinate, max_results, max_distance);
     }
 
+    std::vector<std::vector<PhantomNodeWithDistance>>
+    NearestPhantomNodes(const std::vector<util::Coordinate> &input_coordinates,
+                        const unsigned max_results,
+                        const std::vector<boost::optional<double>> &radiuses,
+                        const std::vector<boost::optional<Bearing>> &bearings) const override final
+    {
+        BOOST_ASSERT(m_geospatial_query.get());
+
+        return m_geospatial_query->NearestPhantomNodes(
+            input_coordinates, max_results, radiuses, bearings);
+    }
+
     std::vector<PhantomNodeWithDistance>
     NearestPhantomNodes(const util::Coordinate input_coordinate,
                         const unsigned max_results,
@@ -609,6 +977,16 @@ class InternalDataFacade final : public BaseDataFacade
             input_coordinate, bearing, bearing_range);
     }
 
+    std::vector<std::pair<PhantomNode, PhantomNode>>
+    NearestPhantomNodesWithAlternativeFromBigComponent(
+        const std::vector<util::Coordinate> &input_coordinates) const override final
+    {
+        BOOST_ASSERT(m_geospatial_query.get());
+
+        return m_geospatial_query->NearestPhantomNodesWithAlternativeFromBigComponent(
+            input_coordinates);
+    }
+
     unsigned GetCheckSum() const override final { return m_check_sum; }
 
     unsigned GetNameIndexFromEdgeID(const unsigned id) const override final
@@ -618,22 +996,7 @@ class InternalDataFacade final : public BaseDataFacade
 
     std::string GetNameForID(const unsigned name_id) const override final
     {
-        if (std::numeric_limits<unsigned>::max() == name_id)
-        {
-            return "";
-        }
-        auto range = m_name_table.GetRange(name_id);
-
-        std::string result;
-        result.reserve(range.size());
-        if (range.begin() != range.end())
-        {
-            result.resize(range.back() - range.front() + 1);
-            std::copy(m_names_char_list.begin() + range.front(),
-                      m_names_char_list.begin() + range.back() + 1,
-                      result.begin());
-        }
-        return result;
+        return util::ToString(GetNameViewForID(name_id));
     }
 
     std::string GetPronunciationForID(const unsigned name_id) const override final
@@ -654,6 +1017,23 @@ class InternalDataFacade final : public BaseDataFacade
         return GetNameForID(name_id + 1);
     }
 
+    util::StringView GetNameViewForID(const unsigned name_id) const override final
+    {
+        return m_name_table.GetNameViewForID(name_id);
+    }
+
+    util::StringView GetPronunciationViewForID(const unsigned name_id) const override final
+    {
+        // see GetPronunciationForID
+        return GetNameViewForID(name_id + 2);
+    }
+
+    util::StringView GetDestinationsViewForID(const unsigned name_id) const override final
+    {
+        // see GetDestinationsForID
+        return GetNameViewForID(name_id + 1);
+    }
+
     virtual unsigned GetGeometryIndexForEdgeID(const unsigned id) const override final
     {
         return m_via_node_list.at(id);
@@ -661,6 +1041,28 @@ class InternalDataFacade final : public BaseDataFacade
 
     virtual std::size_t GetCoreSize() const override final { return m_is_core_node.size(); }
 
+    std::size_t GetNumberOfCoreLandmarkDistances() const override final
+    {
+        return m_core_landmark_distances.size();
+    }
+
+    const EdgeWeight *GetCoreLandmarkDistances() const override final
+    {
+        return m_core_landmark_distances.empty() ? nullptr : m_core_landmark_distances.data();
+    }
+
+    unsigned GetNumberOfTimeSlots() const override final { return m_number_of_time_slots; }
+
+    unsigned GetTimeSlotDuration() const override final { return m_time_slot_duration; }
+
+    unsigned GetNumberOfMetrics() const override final { return m_number_of_metrics; }
+
+    extractor::EdgeClasses GetExcludedClasses(const unsigned metric) const override final
+    {
+        BOOST_ASSERT(metric > 0 && metric <= m_number_of_metrics);
+        return m_metric_excluded_classes[metric - 1];
+    }
+
     virtual bool IsCoreNode(const NodeID id) const override final
     {
         if (m_is_core_node.size() > 0)
@@ -676,6 +1078,12 @@ class InternalDataFacade final : public BaseDataFacade
     virtual void GetUncompressedGeometry(const EdgeID id,
                                          std::vector<NodeID> &result_nodes) const override final
     {
+        if (!m_encoded_geometries.Empty())
+        {
+            m_encoded_geometries.GetNodes(m_geometry_indices, id, result_nodes);
+            return;
+        }
+
         const unsigned begin = m_geometry_indices.at(id);
         const unsigned end = m_geometry_indices.at(id + 1);
 
@@ -697,6 +1105,22 @@ class InternalDataFacade final : public BaseDataFacade
 
         result_weights.clear();
         result_weights.reserve(end - begin);
+        if (m_number_of_time_slots + m_number_of_metrics > 0 &&
+            ActiveTimeSlot() != INVALID_TIME_SLOT)
+        {
+            const auto offset =
+                static_cast<std::size_t>(ActiveTimeSlot()) * NumberOfGeometrySegments();
+            for (const auto index : util::irange(begin, end))
+            {
+                result_weights.push_back(m_time_slot_segment_weights[offset + index]);
+            }
+            return;
+        }
+        if (!m_encoded_geometries.Empty())
+        {
+            m_encoded_geometries.GetWeights(m_geometry_indices, id, result_weights);
+            return;
+        }
         std::for_each(m_geometry_list.begin() + begin,
                       m_geometry_list.begin() + end,
                       [&](const osrm::extractor::CompressedEdgeContainer::CompressedEdge &edge) {
@@ -733,6 +1157,68 @@ class InternalDataFacade final : public BaseDataFacade
         }
     }
 
+    util::StridedView<NodeID> GetUncompressedGeometryView(const EdgeID id) const override final
+    {
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+        if (begin == end)
+        {
+            return {};
+        }
+        if (!m_encoded_geometries.Empty())
+        {
+            std::vector<NodeID> nodes;
+            m_encoded_geometries.GetNodes(m_geometry_indices, id, nodes);
+            return util::StridedView<NodeID>(std::move(nodes));
+        }
+        return {&m_geometry_list[begin].node_id,
+                end - begin,
+                sizeof(extractor::CompressedEdgeContainer::CompressedEdge)};
+    }
+
+    util::StridedView<EdgeWeight> GetUncompressedWeightsView(const EdgeID id) const override final
+    {
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+        if (begin == end)
+        {
+            return {};
+        }
+        if (m_number_of_time_slots + m_number_of_metrics > 0 &&
+            ActiveTimeSlot() != INVALID_TIME_SLOT)
+        {
+            const auto offset =
+                static_cast<std::size_t>(ActiveTimeSlot()) * NumberOfGeometrySegments();
+            return m_time_slot_segment_weights.View(offset + begin, end - begin);
+        }
+        if (!m_encoded_geometries.Empty())
+        {
+            std::vector<EdgeWeight> weights;
+            m_encoded_geometries.GetWeights(m_geometry_indices, id, weights);
+            return util::StridedView<EdgeWeight>(std::move(weights));
+        }
+        return {&m_geometry_list[begin].weight,
+                end - begin,
+                sizeof(extractor::CompressedEdgeContainer::CompressedEdge)};
+    }
+
+    util::StridedView<uint8_t> GetUncompressedDatasourcesView(const EdgeID id) const override final
+    {
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+        if (begin == end)
+        {
+            return {};
+        }
+        // Without datasource info all segments come from datasource 0
+        if (m_datasource_list.empty())
+        {
+            static const uint8_t default_datasource = 0;
+            return {&default_datasource, end - begin, 0};
+        }
+        return {&m_datasource_list[begin], end - begin};
+    }
+
     virtual std::string GetDatasourceName(const uint8_t datasource_name_id) const override final
     {
         BOOST_ASSERT(m_datasource_names.size() >= 1);
@@ -742,6 +1228,8 @@ class InternalDataFacade final : public BaseDataFacade
 
     std::string GetTimestamp() const override final { return m_timestamp; }
 
+    bool HasGuidanceData() const override final { return true; }
+
     bool GetContinueStraightDefault() const override final
     {
         return m_profile_properties.continue_straight_at_waypoint;
@@ -768,6 +1256,15 @@ class InternalDataFacade final : public BaseDataFacade
         return result;
     }
 
+    util::guidance::BearingRange
+    GetBearings(const BearingClassID bearing_class_id) const override final
+    {
+        BOOST_ASSERT(bearing_class_id != INVALID_BEARING_CLASSID);
+        auto range = m_bearing_ranges_table.GetRange(bearing_class_id);
+        return {m_bearing_values_table.data() + range.front(),
+                m_bearing_values_table.data() + range.back() + 1};
+    }
+
     EntryClassID GetEntryClassID(const EdgeID eid) const override final
     {
         return m_entry_class_id_list.at(eid);
@@ -800,6 +1297,39 @@ class InternalDataFacade final : public BaseDataFacade
                 m_lane_description_masks.begin() +
                     m_lane_description_offsets[lane_description_id + 1]);
     }
+    bool HasMultiLevelData() const override final { return m_has_multi_level_data; }
+
+    const partition::MultiLevelPartition &GetMultiLevelPartition() const override final
+    {
+        return m_multi_level_partition;
+    }
+
+    const partition::CellStorage &GetCellStorage() const override final { return m_cell_storage; }
+
+    EdgeRange GetUncontractedAdjacentEdgeRange(const NodeID node) const override final
+    {
+        return m_uncontracted_graph->GetAdjacentEdgeRange(node);
+    }
+
+    NodeID GetUncontractedTarget(const EdgeID e) const override final
+    {
+        return m_uncontracted_graph->GetTarget(e);
+    }
+
+    const EdgeData &GetUncontractedEdgeData(const EdgeID e) const override final
+    {
+        return m_uncontracted_graph->GetEdgeData(e);
+    }
+
+    // Blocks read into buffers are resident already, only mapped files are paged in
+    void WarmUp() const override final
+    {
+        for (const auto &mapped_file : m_mapped_files)
+        {
+            util::TouchPages(mapped_file.second.data(), mapped_file.second.size());
+        }
+        m_static_rtree->WarmUpLeaves();
+    }
 };
 }
 }
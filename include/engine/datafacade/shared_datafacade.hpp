@@ -1,13 +1,16 @@
 #ifndef SHARED_DATAFACADE_HPP
 #define SHARED_DATAFACADE_HPP
 
-// implements all data storage when shared memory _IS_ used
+// implements all data storage when shared memory _IS_ used, or a dataset file mapped instead
 
+#include "storage/dataset.hpp"
 #include "storage/shared_datatype.hpp"
 #include "storage/shared_memory.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
 
+#include "contractor/time_slots.hpp"
 #include "extractor/compressed_edge_container.hpp"
+#include "extractor/duplicated_node.hpp"
 #include "extractor/guidance/turn_instruction.hpp"
 #include "extractor/guidance/turn_lane_types.hpp"
 #include "extractor/profile_properties.hpp"
@@ -16,15 +19,23 @@
 #include "util/guidance/turn_lanes.hpp"
 
 #include "engine/geospatial_query.hpp"
+#include "engine/time_slot.hpp"
+#include "util/block_encoded_coordinates.hpp"
+#include "util/delta_encoded_geometries.hpp"
 #include "util/make_unique.hpp"
+#include "util/name_table.hpp"
+#include "util/packed_vector.hpp"
 #include "util/range_table.hpp"
 #include "util/rectangle.hpp"
+#include "util/segment_weight_list.hpp"
 #include "util/simple_logger.hpp"
 #include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
+#include "util/touch_pages.hpp"
 #include "util/typedefs.hpp"
 
 #include <cstddef>
+#include <cstdint>
 
 #include <algorithm>
 #include <iterator>
@@ -35,8 +46,6 @@
 #include <vector>
 
 #include <boost/assert.hpp>
-#include <boost/thread/lock_guard.hpp>
-#include <boost/thread/shared_mutex.hpp>
 #include <boost/thread/tss.hpp>
 
 namespace osrm
@@ -58,37 +67,56 @@ class SharedDataFacade final : public BaseDataFacade
     using InputEdge = QueryGraph::InputEdge;
     using RTreeLeaf = super::RTreeLeaf;
     using SharedRTree =
-        util::StaticRTree<RTreeLeaf, util::ShM<util::Coordinate, true>::vector, true>;
+        util::StaticRTree<RTreeLeaf, util::CoordinateList<true>, true>;
     using SharedGeospatialQuery = GeospatialQuery<SharedRTree, BaseDataFacade>;
     using RTreeNode = SharedRTree::TreeNode;
 
     storage::SharedDataLayout *data_layout;
     char *shared_memory;
+    std::unique_ptr<storage::SharedMemory> m_timestamp_memory;
     storage::SharedDataTimestamp *data_timestamp_ptr;
 
     storage::SharedDataType CURRENT_LAYOUT;
     storage::SharedDataType CURRENT_DATA;
     unsigned CURRENT_TIMESTAMP;
+    // maps the replica of the data region on this node if osrm-datastore wrote one
+    unsigned numa_node;
 
     unsigned m_check_sum;
     std::unique_ptr<QueryGraph> m_query_graph;
+    // whether the .hsgr orders the edges of each node by direction
+    bool m_direction_ordered;
     std::unique_ptr<storage::SharedMemory> m_layout_memory;
     std::unique_ptr<storage::SharedMemory> m_large_memory;
+    std::unique_ptr<storage::DatasetFile> m_dataset;
     std::string m_timestamp;
     extractor::ProfileProperties *m_profile_properties;
 
-    util::ShM<util::Coordinate, true>::vector m_coordinate_list;
-    util::PackedVector<OSMNodeID, true> m_osmnodeid_list;
+    util::CoordinateList<true> m_coordinate_list;
+    util::PackedOSMNodeIDs<true> m_osmnodeid_list;
     util::ShM<NodeID, true>::vector m_via_node_list;
     util::ShM<unsigned, true>::vector m_name_ID_list;
     util::ShM<LaneDataID, true>::vector m_lane_data_id;
     util::ShM<extractor::guidance::TurnInstruction, true>::vector m_turn_instruction_list;
-    util::ShM<extractor::TravelMode, true>::vector m_travel_mode_list;
-    util::ShM<char, true>::vector m_names_char_list;
+    util::PackedVector<extractor::TravelMode, TRAVEL_MODE_BITS, true> m_travel_mode_list;
     util::ShM<unsigned, true>::vector m_name_begin_indices;
     util::ShM<unsigned, true>::vector m_geometry_indices;
     util::ShM<extractor::CompressedEdgeContainer::CompressedEdge, true>::vector m_geometry_list;
+    // replaces m_geometry_list if not empty
+    util::DeltaEncodedGeometries<true> m_encoded_geometries;
     util::ShM<bool, true>::vector m_is_core_node;
+    util::ShM<EdgeWeight, true>::vector m_core_landmark_distances;
+    util::ShM<EdgeLength, true>::vector m_edge_lengths;
+    util::ShM<extractor::DuplicatedNode, true>::vector m_duplicated_nodes;
+    // the same copies sorted by their ids, so that GetOriginalNode is a binary search as well
+    std::vector<extractor::DuplicatedNode> m_duplicated_nodes_by_duplicate;
+    util::ShM<EdgeData, true>::vector m_time_slot_edge_data;
+    util::SegmentWeightList<true> m_time_slot_segment_weights;
+    unsigned m_number_of_time_slots = 0;
+    unsigned m_time_slot_duration = 0;
+    unsigned m_number_of_metrics = 0;
+    std::array<extractor::EdgeClasses, contractor::TimeSlotsHeader::MAX_METRICS>
+        m_metric_excluded_classes{};
     util::ShM<uint8_t, true>::vector m_datasource_list;
     util::ShM<std::uint32_t, true>::vector m_lane_description_offsets;
     util::ShM<extractor::guidance::TurnLaneType::Mask, true>::vector m_lane_description_masks;
@@ -102,7 +130,7 @@ class SharedDataFacade final : public BaseDataFacade
     std::unique_ptr<SharedGeospatialQuery> m_geospatial_query;
     boost::filesystem::path file_index_path;
 
-    std::shared_ptr<util::RangeTable<16, true>> m_name_table;
+    util::BasicNameTable<true> m_name_table;
 
     // bearing classes by node based node
     util::ShM<BearingClassID, true>::vector m_bearing_class_id_table;
@@ -145,11 +173,28 @@ class SharedDataFacade final : public BaseDataFacade
 
         auto tree_ptr = data_layout->GetBlockPtr<RTreeNode>(
             shared_memory, storage::SharedDataLayout::R_SEARCH_TREE);
-        m_static_rtree.reset(
-            new SharedRTree(tree_ptr,
-                            data_layout->num_entries[storage::SharedDataLayout::R_SEARCH_TREE],
-                            file_index_path,
-                            m_coordinate_list));
+        const auto tree_size = data_layout->num_entries[storage::SharedDataLayout::R_SEARCH_TREE];
+
+        // osrm-datastore either copied the leaves into shared memory or left them in the file
+        const auto leaves_size =
+            data_layout->num_entries[storage::SharedDataLayout::R_SEARCH_TREE_LEAVES];
+        if (leaves_size > 0)
+        {
+            auto leaves_ptr = data_layout->GetAlignedBlockPtr<SharedRTree::LeafNode>(
+                shared_memory,
+                storage::SharedDataLayout::R_SEARCH_TREE_LEAVES,
+                sizeof(SharedRTree::LeafNode));
+            m_static_rtree.reset(new SharedRTree(tree_ptr,
+                                                 tree_size,
+                                                 leaves_ptr,
+                                                 leaves_size / sizeof(SharedRTree::LeafNode),
+                                                 m_coordinate_list));
+        }
+        else
+        {
+            m_static_rtree.reset(
+                new SharedRTree(tree_ptr, tree_size, file_index_path, m_coordinate_list));
+        }
         m_geospatial_query.reset(
             new SharedGeospatialQuery(*m_static_rtree, m_coordinate_list, *this));
     }
@@ -167,30 +212,70 @@ class SharedDataFacade final : public BaseDataFacade
         util::ShM<GraphEdge, true>::vector edge_list(
             graph_edges_ptr, data_layout->num_entries[storage::SharedDataLayout::GRAPH_EDGE_LIST]);
         m_query_graph.reset(new QueryGraph(node_list, edge_list));
+        m_direction_ordered = m_query_graph->IsDirectionOrdered();
+
+        const auto number_of_edge_lengths =
+            data_layout->num_entries[storage::SharedDataLayout::EDGE_LENGTHS];
+        if (number_of_edge_lengths > 0)
+        {
+            auto edge_lengths_ptr = data_layout->GetBlockPtr<EdgeLength>(
+                shared_memory, storage::SharedDataLayout::EDGE_LENGTHS);
+            m_edge_lengths.reset(edge_lengths_ptr, number_of_edge_lengths);
+        }
+
+        const auto number_of_duplicated_nodes =
+            data_layout->num_entries[storage::SharedDataLayout::DUPLICATED_NODES];
+        if (number_of_duplicated_nodes > 0)
+        {
+            auto duplicated_nodes_ptr = data_layout->GetBlockPtr<extractor::DuplicatedNode>(
+                shared_memory, storage::SharedDataLayout::DUPLICATED_NODES);
+            m_duplicated_nodes.reset(duplicated_nodes_ptr, number_of_duplicated_nodes);
+            m_duplicated_nodes_by_duplicate = extractor::SortByDuplicate(
+                duplicated_nodes_ptr, duplicated_nodes_ptr + number_of_duplicated_nodes);
+        }
     }
 
     void LoadNodeAndEdgeInformation()
     {
-        auto coordinate_list_ptr = data_layout->GetBlockPtr<util::Coordinate>(
-            shared_memory, storage::SharedDataLayout::COORDINATE_LIST);
-        m_coordinate_list.reset(
-            coordinate_list_ptr,
-            data_layout->num_entries[storage::SharedDataLayout::COORDINATE_LIST]);
+        if (data_layout->num_entries[storage::SharedDataLayout::COORDINATE_BLOCKS] > 0)
+        {
+            using EncodedCoordinates = util::BlockEncodedCoordinates<true>;
+            EncodedCoordinates encoded;
+            encoded.Reset(data_layout->GetBlockPtr<EncodedCoordinates::Block>(
+                              shared_memory, storage::SharedDataLayout::COORDINATE_BLOCKS),
+                          data_layout->num_entries[storage::SharedDataLayout::COORDINATE_BLOCKS],
+                          data_layout->GetBlockPtr<std::uint64_t>(
+                              shared_memory, storage::SharedDataLayout::COORDINATE_WORDS),
+                          data_layout->num_entries[storage::SharedDataLayout::COORDINATE_WORDS]);
+            m_coordinate_list.Reset(std::move(encoded));
+        }
+        else
+        {
+            m_coordinate_list.Reset(util::ShM<util::Coordinate, true>::vector(
+                data_layout->GetBlockPtr<util::Coordinate>(
+                    shared_memory, storage::SharedDataLayout::COORDINATE_LIST),
+                data_layout->num_entries[storage::SharedDataLayout::COORDINATE_LIST]));
+        }
 
         auto osmnodeid_list_ptr = data_layout->GetBlockPtr<std::uint64_t>(
             shared_memory, storage::SharedDataLayout::OSM_NODE_ID_LIST);
         m_osmnodeid_list.reset(
             osmnodeid_list_ptr,
             data_layout->num_entries[storage::SharedDataLayout::OSM_NODE_ID_LIST]);
-        // We (ab)use the number of coordinates here because we know we have the same amount of ids
-        m_osmnodeid_list.set_number_of_entries(
-            data_layout->num_entries[storage::SharedDataLayout::COORDINATE_LIST]);
+        // We (ab)use the number of coordinates here because we know we have the same amount of ids,
+        // unless osrm-datastore --weights-only left them out
+        if (data_layout->num_entries[storage::SharedDataLayout::OSM_NODE_ID_LIST] > 0)
+        {
+            m_osmnodeid_list.set_number_of_entries(m_coordinate_list.size());
+        }
 
-        auto travel_mode_list_ptr = data_layout->GetBlockPtr<extractor::TravelMode>(
+        auto travel_mode_list_ptr = data_layout->GetBlockPtr<std::uint64_t>(
             shared_memory, storage::SharedDataLayout::TRAVEL_MODE);
-        util::ShM<extractor::TravelMode, true>::vector travel_mode_list(
-            travel_mode_list_ptr, data_layout->num_entries[storage::SharedDataLayout::TRAVEL_MODE]);
-        m_travel_mode_list = std::move(travel_mode_list);
+        m_travel_mode_list.reset(travel_mode_list_ptr,
+                                 data_layout->num_entries[storage::SharedDataLayout::TRAVEL_MODE]);
+        // there is one travel mode per original edge, the same as name IDs
+        m_travel_mode_list.set_number_of_entries(
+            data_layout->num_entries[storage::SharedDataLayout::NAME_ID_LIST]);
 
         auto lane_data_id_ptr = data_layout->GetBlockPtr<LaneDataID>(
             shared_memory, storage::SharedDataLayout::LANE_DATA_ID);
@@ -238,23 +323,15 @@ class SharedDataFacade final : public BaseDataFacade
 
     void LoadNames()
     {
-        auto offsets_ptr = data_layout->GetBlockPtr<unsigned>(
-            shared_memory, storage::SharedDataLayout::NAME_OFFSETS);
-        auto blocks_ptr = data_layout->GetBlockPtr<IndexBlock>(
-            shared_memory, storage::SharedDataLayout::NAME_BLOCKS);
-        util::ShM<unsigned, true>::vector name_offsets(
-            offsets_ptr, data_layout->num_entries[storage::SharedDataLayout::NAME_OFFSETS]);
-        util::ShM<IndexBlock, true>::vector name_blocks(
-            blocks_ptr, data_layout->num_entries[storage::SharedDataLayout::NAME_BLOCKS]);
-
-        auto names_list_ptr = data_layout->GetBlockPtr<char>(
-            shared_memory, storage::SharedDataLayout::NAME_CHAR_LIST);
-        util::ShM<char, true>::vector names_char_list(
-            names_list_ptr, data_layout->num_entries[storage::SharedDataLayout::NAME_CHAR_LIST]);
-        m_name_table = util::make_unique<util::RangeTable<16, true>>(
-            name_offsets, name_blocks, static_cast<unsigned>(names_char_list.size()));
-
-        m_names_char_list = std::move(names_char_list);
+        m_name_table.reset(
+            data_layout->GetBlockPtr<std::uint32_t>(shared_memory,
+                                                    storage::SharedDataLayout::NAME_OFFSETS),
+            data_layout->GetBlockPtr<std::uint8_t>(shared_memory,
+                                                   storage::SharedDataLayout::NAME_LENGTHS),
+            data_layout->num_entries[storage::SharedDataLayout::NAME_OFFSETS],
+            data_layout->GetBlockPtr<char>(shared_memory,
+                                           storage::SharedDataLayout::NAME_CHAR_LIST),
+            data_layout->num_entries[storage::SharedDataLayout::NAME_CHAR_LIST]);
     }
 
     void LoadTurnLaneDescriptions()
@@ -286,6 +363,53 @@ class SharedDataFacade final : public BaseDataFacade
         util::ShM<bool, true>::vector is_core_node(
             core_marker_ptr, data_layout->num_entries[storage::SharedDataLayout::CORE_MARKER]);
         m_is_core_node = std::move(is_core_node);
+
+        const auto number_of_core_landmark_distances =
+            data_layout->num_entries[storage::SharedDataLayout::CORE_LANDMARK_DISTANCES];
+        if (number_of_core_landmark_distances > 0)
+        {
+            auto core_landmark_distances_ptr = data_layout->GetBlockPtr<EdgeWeight>(
+                shared_memory, storage::SharedDataLayout::CORE_LANDMARK_DISTANCES);
+            m_core_landmark_distances.reset(core_landmark_distances_ptr,
+                                            number_of_core_landmark_distances);
+        }
+    }
+
+    void LoadTimeSlots()
+    {
+        if (data_layout->num_entries[storage::SharedDataLayout::TIME_SLOTS] == 0)
+        {
+            return;
+        }
+
+        const auto &header = *data_layout->GetBlockPtr<contractor::TimeSlotsHeader>(
+            shared_memory, storage::SharedDataLayout::TIME_SLOTS);
+        m_number_of_time_slots = header.number_of_slots;
+        m_time_slot_duration = header.slot_duration;
+        m_number_of_metrics = header.number_of_metrics;
+        m_metric_excluded_classes = header.metric_excluded_classes;
+
+        auto edge_data_ptr = data_layout->GetBlockPtr<EdgeData>(
+            shared_memory, storage::SharedDataLayout::TIME_SLOT_EDGE_DATA);
+        m_time_slot_edge_data.reset(
+            edge_data_ptr,
+            data_layout->num_entries[storage::SharedDataLayout::TIME_SLOT_EDGE_DATA]);
+        const auto number_of_segment_weights =
+            data_layout->num_entries[storage::SharedDataLayout::TIME_SLOT_GEOMETRY_WEIGHTS];
+        if (header.segment_weight_bytes == sizeof(std::uint16_t))
+        {
+            auto segment_weights_ptr = data_layout->GetBlockPtr<std::uint16_t>(
+                shared_memory, storage::SharedDataLayout::TIME_SLOT_GEOMETRY_WEIGHTS);
+            m_time_slot_segment_weights.Reset(util::SegmentWeightList<true>::NarrowVector(
+                segment_weights_ptr, number_of_segment_weights));
+        }
+        else
+        {
+            auto segment_weights_ptr = data_layout->GetBlockPtr<EdgeWeight>(
+                shared_memory, storage::SharedDataLayout::TIME_SLOT_GEOMETRY_WEIGHTS);
+            m_time_slot_segment_weights.Reset(util::SegmentWeightList<true>::WideVector(
+                segment_weights_ptr, number_of_segment_weights));
+        }
     }
 
     void LoadGeometries()
@@ -305,6 +429,17 @@ class SharedDataFacade final : public BaseDataFacade
             data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_LIST]);
         m_geometry_list = std::move(geometry_list);
 
+        if (data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_BLOCK_OFFSETS] > 0)
+        {
+            m_encoded_geometries.Reset(
+                data_layout->GetBlockPtr<std::uint64_t>(
+                    shared_memory, storage::SharedDataLayout::GEOMETRIES_BLOCK_OFFSETS),
+                data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_BLOCK_OFFSETS],
+                data_layout->GetBlockPtr<unsigned char>(
+                    shared_memory, storage::SharedDataLayout::GEOMETRIES_ENCODED),
+                data_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_ENCODED]);
+        }
+
         auto datasources_list_ptr = data_layout->GetBlockPtr<uint8_t>(
             shared_memory, storage::SharedDataLayout::DATASOURCES_LIST);
         util::ShM<uint8_t, true>::vector datasources_list(
@@ -334,6 +469,12 @@ class SharedDataFacade final : public BaseDataFacade
         m_datasource_name_lengths = std::move(datasource_name_lengths);
     }
 
+    // the segments of all geometries, which index the time slot weights as well
+    std::size_t NumberOfGeometrySegments() const
+    {
+        return m_geometry_indices.empty() ? 0 : m_geometry_indices[m_geometry_indices.size() - 1];
+    }
+
     void LoadIntersectionClasses()
     {
         auto bearing_class_id_ptr = data_layout->GetBlockPtr<BearingClassID>(
@@ -368,106 +509,110 @@ class SharedDataFacade final : public BaseDataFacade
         m_entry_class_table = std::move(entry_class_table);
     }
 
+    void LoadData()
+    {
+        const auto file_index_ptr = data_layout->GetBlockPtr<char>(
+            shared_memory, storage::SharedDataLayout::FILE_INDEX_PATH);
+        file_index_path = boost::filesystem::path(file_index_ptr);
+        const bool shared_leaves =
+            data_layout->num_entries[storage::SharedDataLayout::R_SEARCH_TREE_LEAVES] > 0;
+        if (!shared_leaves && !boost::filesystem::exists(file_index_path))
+        {
+            util::SimpleLogger().Write(logDEBUG) << "Leaf file name " << file_index_path.string();
+            throw util::exception("Could not load leaf index file. "
+                                  "Is any data loaded into shared memory?");
+        }
+
+        LoadGraph();
+        LoadChecksum();
+        LoadNodeAndEdgeInformation();
+        LoadGeometries();
+        LoadTimestamp();
+        LoadViaNodeList();
+        LoadNames();
+        LoadTurnLaneDescriptions();
+        LoadCoreInformation();
+        LoadTimeSlots();
+        LoadProfileProperties();
+        LoadRTree();
+        LoadIntersectionClasses();
+
+        util::SimpleLogger().Write() << "number of geometries: " << m_coordinate_list.size();
+        for (unsigned i = 0; i < m_coordinate_list.size(); ++i)
+        {
+            BOOST_ASSERT(GetCoordinateOfNode(i).IsValid());
+        }
+    }
+
   public:
     virtual ~SharedDataFacade() {}
 
-    boost::shared_mutex data_mutex;
-
-    SharedDataFacade()
+    // Serves the dataset generation osrm-datastore published last. The facade never changes
+    // afterwards, newer generations get a facade of their own, see IsOutdated.
+    explicit SharedDataFacade(const unsigned numa_node = 0) : numa_node(numa_node)
     {
         if (!storage::SharedMemory::RegionExists(storage::CURRENT_REGIONS))
         {
             throw util::exception(
                 "No shared memory blocks found, have you forgotten to run osrm-datastore?");
         }
-        data_timestamp_ptr = static_cast<storage::SharedDataTimestamp *>(
-            storage::makeSharedMemory(
-                storage::CURRENT_REGIONS, sizeof(storage::SharedDataTimestamp), false, false)
-                ->Ptr());
-        CURRENT_LAYOUT = storage::LAYOUT_NONE;
-        CURRENT_DATA = storage::DATA_NONE;
-        CURRENT_TIMESTAMP = 0;
+        m_timestamp_memory.reset(storage::makeSharedMemory(
+            storage::CURRENT_REGIONS, sizeof(storage::SharedDataTimestamp), false, false));
+        data_timestamp_ptr =
+            static_cast<storage::SharedDataTimestamp *>(m_timestamp_memory->Ptr());
+        CURRENT_TIMESTAMP = data_timestamp_ptr->timestamp;
+        CURRENT_LAYOUT = data_timestamp_ptr->layout;
+        CURRENT_DATA = data_timestamp_ptr->data;
+
+        m_layout_memory.reset(storage::makeSharedMemory(CURRENT_LAYOUT));
+        data_layout = static_cast<storage::SharedDataLayout *>(m_layout_memory->Ptr());
+
+        if (numa_node > 0 && numa_node < data_timestamp_ptr->numa_replicas)
+        {
+            m_large_memory.reset(
+                storage::makeSharedMemory(storage::GetReplicaRegion(CURRENT_DATA, numa_node)));
+        }
+        else
+        {
+            m_large_memory.reset(storage::makeSharedMemory(CURRENT_DATA));
+        }
+        shared_memory = (char *)(m_large_memory->Ptr());
 
-        // load data
-        CheckAndReloadFacade();
+        LoadData();
     }
 
-    void CheckAndReloadFacade()
+    // Serves a dataset written by osrm-datastore --dataset. The blocks are used in place in the
+    // mapping of the file, so startup does not depend on the size of the dataset.
+    explicit SharedDataFacade(const boost::filesystem::path &dataset_path)
+        : data_timestamp_ptr(nullptr), CURRENT_LAYOUT(storage::LAYOUT_NONE),
+          CURRENT_DATA(storage::DATA_NONE), CURRENT_TIMESTAMP(0), numa_node(0)
     {
-        if (CURRENT_LAYOUT != data_timestamp_ptr->layout ||
-            CURRENT_DATA != data_timestamp_ptr->data ||
-            CURRENT_TIMESTAMP != data_timestamp_ptr->timestamp)
-        {
-            // Get exclusive lock
-            util::SimpleLogger().Write(logDEBUG) << "Updates available, getting exclusive lock";
-            const boost::lock_guard<boost::shared_mutex> lock(data_mutex);
+        m_dataset = util::make_unique<storage::DatasetFile>(dataset_path);
+        data_layout = &m_dataset->GetLayout();
+        shared_memory = m_dataset->GetData();
+        LoadData();
+    }
 
-            if (CURRENT_LAYOUT != data_timestamp_ptr->layout ||
-                CURRENT_DATA != data_timestamp_ptr->data)
-            {
-                // release the previous shared memory segments
-                storage::SharedMemory::Remove(CURRENT_LAYOUT);
-                storage::SharedMemory::Remove(CURRENT_DATA);
+    // true if osrm-datastore published a newer dataset than the one this facade was loaded from,
+    // a dataset file never changes
+    bool IsOutdated() const
+    {
+        return data_timestamp_ptr && CURRENT_TIMESTAMP != data_timestamp_ptr->timestamp;
+    }
 
-                CURRENT_LAYOUT = data_timestamp_ptr->layout;
-                CURRENT_DATA = data_timestamp_ptr->data;
-                CURRENT_TIMESTAMP = 0; // Force trigger a reload
+    // timestamp of the dataset osrm-datastore published last, the one of this facade if it
+    // was loaded from a dataset file
+    unsigned GetPublishedTimestamp() const
+    {
+        return data_timestamp_ptr ? data_timestamp_ptr->timestamp.load() : CURRENT_TIMESTAMP;
+    }
 
-                util::SimpleLogger().Write(logDEBUG)
-                    << "Current layout was different to new layout, swapping";
-            }
-            else
-            {
-                util::SimpleLogger().Write(logDEBUG)
-                    << "Current layout was same to new layout, not swapping";
-            }
+    // data region the queries on this facade run on
+    storage::SharedDataType GetDataRegion() const { return CURRENT_DATA; }
 
-            if (CURRENT_TIMESTAMP != data_timestamp_ptr->timestamp)
-            {
-                CURRENT_TIMESTAMP = data_timestamp_ptr->timestamp;
-
-                util::SimpleLogger().Write(logDEBUG) << "Performing data reload";
-                m_layout_memory.reset(storage::makeSharedMemory(CURRENT_LAYOUT));
-
-                data_layout = static_cast<storage::SharedDataLayout *>(m_layout_memory->Ptr());
-
-                m_large_memory.reset(storage::makeSharedMemory(CURRENT_DATA));
-                shared_memory = (char *)(m_large_memory->Ptr());
-
-                const auto file_index_ptr = data_layout->GetBlockPtr<char>(
-                    shared_memory, storage::SharedDataLayout::FILE_INDEX_PATH);
-                file_index_path = boost::filesystem::path(file_index_ptr);
-                if (!boost::filesystem::exists(file_index_path))
-                {
-                    util::SimpleLogger().Write(logDEBUG) << "Leaf file name "
-                                                         << file_index_path.string();
-                    throw util::exception("Could not load leaf index file. "
-                                          "Is any data loaded into shared memory?");
-                }
-
-                LoadGraph();
-                LoadChecksum();
-                LoadNodeAndEdgeInformation();
-                LoadGeometries();
-                LoadTimestamp();
-                LoadViaNodeList();
-                LoadNames();
-                LoadTurnLaneDescriptions();
-                LoadCoreInformation();
-                LoadProfileProperties();
-                LoadRTree();
-                LoadIntersectionClasses();
-
-                util::SimpleLogger().Write() << "number of geometries: "
-                                             << m_coordinate_list.size();
-                for (unsigned i = 0; i < m_coordinate_list.size(); ++i)
-                {
-                    BOOST_ASSERT(GetCoordinateOfNode(i).IsValid());
-                }
-            }
-            util::SimpleLogger().Write(logDEBUG) << "Releasing exclusive lock";
-        }
-    }
+    // the blocks of the data region, in shared memory or in the mapping of a dataset file
+    const storage::SharedDataLayout &GetDataLayout() const { return *data_layout; }
+    const char *GetData() const { return shared_memory; }
 
     // search graph access
     unsigned GetNumberOfNodes() const override final { return m_query_graph->GetNumberOfNodes(); }
@@ -481,11 +626,49 @@ class SharedDataFacade final : public BaseDataFacade
 
     NodeID GetTarget(const EdgeID e) const override final { return m_query_graph->GetTarget(e); }
 
-    EdgeData &GetEdgeData(const EdgeID e) const override final
+    const EdgeData &GetEdgeData(const EdgeID e) const override final
     {
+        if (m_number_of_time_slots + m_number_of_metrics > 0 &&
+            ActiveTimeSlot() != INVALID_TIME_SLOT)
+        {
+            BOOST_ASSERT(ActiveTimeSlot() < m_number_of_time_slots + m_number_of_metrics);
+            return m_time_slot_edge_data.at(
+                static_cast<std::size_t>(ActiveTimeSlot()) * m_query_graph->GetNumberOfEdges() + e);
+        }
         return m_query_graph->GetEdgeData(e);
     }
 
+    AdjacentEdge GetAdjacentEdge(const EdgeID e) const override final
+    {
+        return {m_query_graph->GetTarget(e), GetEdgeData(e)};
+    }
+
+    bool HasEdgeLengths() const override final { return !m_edge_lengths.empty(); }
+
+    EdgeLength GetEdgeLength(const EdgeID e) const override final
+    {
+        BOOST_ASSERT(e < m_edge_lengths.size());
+        return m_edge_lengths[e];
+    }
+
+    std::vector<NodeID> GetDuplicatedNodes(const NodeID n) const override final
+    {
+        if (m_duplicated_nodes.empty())
+        {
+            return {};
+        }
+        return extractor::FindDuplicates(
+            &m_duplicated_nodes[0], &m_duplicated_nodes[0] + m_duplicated_nodes.size(), n);
+    }
+
+    NodeID GetOriginalNode(const NodeID n) const override final
+    {
+        return extractor::FindOriginal(
+            m_duplicated_nodes_by_duplicate.data(),
+            m_duplicated_nodes_by_duplicate.data() + m_duplicated_nodes_by_duplicate.size(),
+            n);
+    }
+
     EdgeID BeginEdges(const NodeID n) const override final { return m_query_graph->BeginEdges(n); }
 
     EdgeID EndEdges(const NodeID n) const override final { return m_query_graph->EndEdges(n); }
@@ -495,6 +678,13 @@ class SharedDataFacade final : public BaseDataFacade
         return m_query_graph->GetAdjacentEdgeRange(node);
     }
 
+    EdgeRange GetDirectedEdgeRange(const NodeID node,
+                                   const bool forward_direction) const override final
+    {
+        return m_direction_ordered ? m_query_graph->GetDirectedEdgeRange(node, forward_direction)
+                                   : m_query_graph->GetAdjacentEdgeRange(node);
+    }
+
     // searches for a specific edge
     EdgeID FindEdge(const NodeID from, const NodeID to) const override final
     {
@@ -526,6 +716,12 @@ class SharedDataFacade final : public BaseDataFacade
     virtual void GetUncompressedGeometry(const EdgeID id,
                                          std::vector<NodeID> &result_nodes) const override final
     {
+        if (!m_encoded_geometries.Empty())
+        {
+            m_encoded_geometries.GetNodes(m_geometry_indices, id, result_nodes);
+            return;
+        }
+
         const unsigned begin = m_geometry_indices.at(id);
         const unsigned end = m_geometry_indices.at(id + 1);
 
@@ -547,6 +743,22 @@ class SharedDataFacade final : public BaseDataFacade
 
         result_weights.clear();
         result_weights.reserve(end - begin);
+        if (m_number_of_time_slots + m_number_of_metrics > 0 &&
+            ActiveTimeSlot() != INVALID_TIME_SLOT)
+        {
+            const auto offset =
+                static_cast<std::size_t>(ActiveTimeSlot()) * NumberOfGeometrySegments();
+            for (const auto index : util::irange(begin, end))
+            {
+                result_weights.push_back(m_time_slot_segment_weights[offset + index]);
+            }
+            return;
+        }
+        if (!m_encoded_geometries.Empty())
+        {
+            m_encoded_geometries.GetWeights(m_geometry_indices, id, result_weights);
+            return;
+        }
         std::for_each(m_geometry_list.begin() + begin,
                       m_geometry_list.begin() + end,
                       [&](const osrm::extractor::CompressedEdgeContainer::CompressedEdge &edge) {
@@ -619,6 +831,18 @@ class SharedDataFacade final : public BaseDataFacade
         return m_geospatial_query->NearestPhantomNodes(input_coordinate, max_results, max_distance);
     }
 
+    std::vector<std::vector<PhantomNodeWithDistance>>
+    NearestPhantomNodes(const std::vector<util::Coordinate> &input_coordinates,
+                        const unsigned max_results,
+                        const std::vector<boost::optional<double>> &radiuses,
+                        const std::vector<boost::optional<Bearing>> &bearings) const override final
+    {
+        BOOST_ASSERT(m_geospatial_query.get());
+
+        return m_geospatial_query->NearestPhantomNodes(
+            input_coordinates, max_results, radiuses, bearings);
+    }
+
     std::vector<PhantomNodeWithDistance>
     NearestPhantomNodes(const util::Coordinate input_coordinate,
                         const unsigned max_results,
@@ -685,6 +909,16 @@ class SharedDataFacade final : public BaseDataFacade
             input_coordinate, bearing, bearing_range);
     }
 
+    std::vector<std::pair<PhantomNode, PhantomNode>>
+    NearestPhantomNodesWithAlternativeFromBigComponent(
+        const std::vector<util::Coordinate> &input_coordinates) const override final
+    {
+        BOOST_ASSERT(m_geospatial_query.get());
+
+        return m_geospatial_query->NearestPhantomNodesWithAlternativeFromBigComponent(
+            input_coordinates);
+    }
+
     unsigned GetCheckSum() const override final { return m_check_sum; }
 
     unsigned GetNameIndexFromEdgeID(const unsigned id) const override final
@@ -694,22 +928,7 @@ class SharedDataFacade final : public BaseDataFacade
 
     std::string GetNameForID(const unsigned name_id) const override final
     {
-        if (std::numeric_limits<unsigned>::max() == name_id)
-        {
-            return "";
-        }
-        auto range = m_name_table->GetRange(name_id);
-
-        std::string result;
-        result.reserve(range.size());
-        if (range.begin() != range.end())
-        {
-            result.resize(range.back() - range.front() + 1);
-            std::copy(m_names_char_list.begin() + range.front(),
-                      m_names_char_list.begin() + range.back() + 1,
-                      result.begin());
-        }
-        return result;
+        return util::ToString(GetNameViewForID(name_id));
     }
 
     std::string GetPronunciationForID(const unsigned name_id) const override final
@@ -730,6 +949,23 @@ class SharedDataFacade final : public BaseDataFacade
         return GetNameForID(name_id + 1);
     }
 
+    util::StringView GetNameViewForID(const unsigned name_id) const override final
+    {
+        return m_name_table.GetNameViewForID(name_id);
+    }
+
+    util::StringView GetPronunciationViewForID(const unsigned name_id) const override final
+    {
+        // see GetPronunciationForID
+        return GetNameViewForID(name_id + 2);
+    }
+
+    util::StringView GetDestinationsViewForID(const unsigned name_id) const override final
+    {
+        // see GetDestinationsForID
+        return GetNameViewForID(name_id + 1);
+    }
+
     bool IsCoreNode(const NodeID id) const override final
     {
         if (m_is_core_node.size() > 0)
@@ -742,6 +978,28 @@ class SharedDataFacade final : public BaseDataFacade
 
     virtual std::size_t GetCoreSize() const override final { return m_is_core_node.size(); }
 
+    std::size_t GetNumberOfCoreLandmarkDistances() const override final
+    {
+        return m_core_landmark_distances.size();
+    }
+
+    const EdgeWeight *GetCoreLandmarkDistances() const override final
+    {
+        return m_core_landmark_distances.empty() ? nullptr : &m_core_landmark_distances[0];
+    }
+
+    unsigned GetNumberOfTimeSlots() const override final { return m_number_of_time_slots; }
+
+    unsigned GetTimeSlotDuration() const override final { return m_time_slot_duration; }
+
+    unsigned GetNumberOfMetrics() const override final { return m_number_of_metrics; }
+
+    extractor::EdgeClasses GetExcludedClasses(const unsigned metric) const override final
+    {
+        BOOST_ASSERT(metric > 0 && metric <= m_number_of_metrics);
+        return m_metric_excluded_classes[metric - 1];
+    }
+
     // Returns the data source ids that were used to supply the edge
     // weights.
     virtual void
@@ -771,6 +1029,68 @@ class SharedDataFacade final : public BaseDataFacade
         }
     }
 
+    util::StridedView<NodeID> GetUncompressedGeometryView(const EdgeID id) const override final
+    {
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+        if (begin == end)
+        {
+            return {};
+        }
+        if (!m_encoded_geometries.Empty())
+        {
+            std::vector<NodeID> nodes;
+            m_encoded_geometries.GetNodes(m_geometry_indices, id, nodes);
+            return util::StridedView<NodeID>(std::move(nodes));
+        }
+        return {&m_geometry_list[begin].node_id,
+                end - begin,
+                sizeof(extractor::CompressedEdgeContainer::CompressedEdge)};
+    }
+
+    util::StridedView<EdgeWeight> GetUncompressedWeightsView(const EdgeID id) const override final
+    {
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+        if (begin == end)
+        {
+            return {};
+        }
+        if (m_number_of_time_slots + m_number_of_metrics > 0 &&
+            ActiveTimeSlot() != INVALID_TIME_SLOT)
+        {
+            const auto offset =
+                static_cast<std::size_t>(ActiveTimeSlot()) * NumberOfGeometrySegments();
+            return m_time_slot_segment_weights.View(offset + begin, end - begin);
+        }
+        if (!m_encoded_geometries.Empty())
+        {
+            std::vector<EdgeWeight> weights;
+            m_encoded_geometries.GetWeights(m_geometry_indices, id, weights);
+            return util::StridedView<EdgeWeight>(std::move(weights));
+        }
+        return {&m_geometry_list[begin].weight,
+                end - begin,
+                sizeof(extractor::CompressedEdgeContainer::CompressedEdge)};
+    }
+
+    util::StridedView<uint8_t> GetUncompressedDatasourcesView(const EdgeID id) const override final
+    {
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+        if (begin == end)
+        {
+            return {};
+        }
+        // Without datasource info all segments come from datasource 0
+        if (m_datasource_list.empty())
+        {
+            static const uint8_t default_datasource = 0;
+            return {&default_datasource, end - begin, 0};
+        }
+        return {&m_datasource_list[begin], end - begin};
+    }
+
     virtual std::string GetDatasourceName(const uint8_t datasource_name_id) const override final
     {
         BOOST_ASSERT(m_datasource_name_offsets.size() >= 1);
@@ -788,6 +1108,11 @@ class SharedDataFacade final : public BaseDataFacade
 
     std::string GetTimestamp() const override final { return m_timestamp; }
 
+    bool HasGuidanceData() const override final
+    {
+        return data_layout->num_entries[storage::SharedDataLayout::TURN_INSTRUCTION] > 0;
+    }
+
     bool GetContinueStraightDefault() const override final
     {
         return m_profile_properties->continue_straight_at_waypoint;
@@ -811,6 +1136,15 @@ class SharedDataFacade final : public BaseDataFacade
         return result;
     }
 
+    util::guidance::BearingRange
+    GetBearings(const BearingClassID bearing_class_id) const override final
+    {
+        BOOST_ASSERT(bearing_class_id != INVALID_BEARING_CLASSID);
+        auto range = m_bearing_ranges_table->GetRange(bearing_class_id);
+        return {m_bearing_values_table.data() + range.front(),
+                m_bearing_values_table.data() + range.back() + 1};
+    }
+
     EntryClassID GetEntryClassID(const EdgeID eid) const override final
     {
         return m_entry_class_id_list.at(eid);
@@ -821,6 +1155,42 @@ class SharedDataFacade final : public BaseDataFacade
         return m_entry_class_table.at(entry_class_id);
     }
 
+    // osrm-datastore does not load the multi-level Dijkstra data
+    bool HasMultiLevelData() const override final { return false; }
+
+    const partition::MultiLevelPartition &GetMultiLevelPartition() const override final
+    {
+        throw util::exception("Multi-level Dijkstra is not supported with shared memory");
+    }
+
+    const partition::CellStorage &GetCellStorage() const override final
+    {
+        throw util::exception("Multi-level Dijkstra is not supported with shared memory");
+    }
+
+    EdgeRange GetUncontractedAdjacentEdgeRange(const NodeID) const override final
+    {
+        throw util::exception("Multi-level Dijkstra is not supported with shared memory");
+    }
+
+    NodeID GetUncontractedTarget(const EdgeID) const override final
+    {
+        throw util::exception("Multi-level Dijkstra is not supported with shared memory");
+    }
+
+    const EdgeData &GetUncontractedEdgeData(const EdgeID) const override final
+    {
+        throw util::exception("Multi-level Dijkstra is not supported with shared memory");
+    }
+
+    // The pages of a region osrm-datastore locked are resident, but still have to be mapped
+    // into this process. Leaves left in the .fileIndex are paged in from the file.
+    void WarmUp() const override final
+    {
+        util::TouchPages(shared_memory, data_layout->GetSizeOfLayout());
+        m_static_rtree->WarmUpLeaves();
+    }
+
     bool hasLaneData(const EdgeID id) const override final
     {
         return INVALID_LANE_DATAID != m_lane_data_id.at(id);
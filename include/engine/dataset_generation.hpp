@@ -0,0 +1,78 @@
+#ifndef OSRM_ENGINE_DATASET_GENERATION_HPP
+#define OSRM_ENGINE_DATASET_GENERATION_HPP
+
+#include <memory>
+#include <mutex>
+
+namespace osrm
+{
+namespace engine
+{
+
+// How queries pick up the dataset generations that osrm-datastore and osrm-traffic-update
+// publish in shared memory. A publisher first publishes the new generation and then waits until
+// no query is counted on the data region of the previous one before it deletes that region.
+//
+// GenerationT tells with IsOutdated() whether a newer generation was published and with
+// GetDataRegion() which region it runs on. LockT has a reload_mutex that serializes loading new
+// generations in this process, and counts the queries on a region with IncreaseQueryCount and
+// DecreaseQueryCount. load() returns the newest published generation.
+
+// Returns the newest generation. Only one thread per process loads a new generation, all others
+// keep getting the previous one in the meantime.
+template <typename GenerationT, typename LockT, typename LoadT>
+std::shared_ptr<GenerationT> CurrentGeneration(LockT &lock,
+                                               std::shared_ptr<GenerationT> &generation,
+                                               const LoadT &load)
+{
+    auto current = std::atomic_load(&generation);
+    if (!current->IsOutdated())
+    {
+        return current;
+    }
+
+    std::unique_lock<std::mutex> reload_lock(lock.reload_mutex, std::try_to_lock);
+    if (!reload_lock.owns_lock())
+    {
+        return current;
+    }
+
+    // someone else might have been faster
+    current = std::atomic_load(&generation);
+    if (current->IsOutdated())
+    {
+        current = load();
+        std::atomic_store(&generation, current);
+    }
+
+    return current;
+}
+
+// Returns the newest generation counted as in use by one more query. A query only runs on a
+// generation that is still current once it is counted: a publisher waits for every query it sees
+// counted, and one it does not see is counted after the new generation was published, so it
+// finds its generation outdated. It then drops its count and waits for the thread that loads the
+// new generation, the previous region may be gone already.
+template <typename GenerationT, typename LockT, typename LoadT>
+std::shared_ptr<GenerationT> AcquireGeneration(LockT &lock,
+                                               std::shared_ptr<GenerationT> &generation,
+                                               const LoadT &load)
+{
+    while (true)
+    {
+        auto current = CurrentGeneration(lock, generation, load);
+        const auto data_region = current->GetDataRegion();
+        lock.IncreaseQueryCount(data_region);
+        if (!current->IsOutdated())
+        {
+            return current;
+        }
+        lock.DecreaseQueryCount(data_region);
+
+        const std::lock_guard<std::mutex> wait_for_reload(lock.reload_mutex);
+    }
+}
+}
+}
+
+#endif // OSRM_ENGINE_DATASET_GENERATION_HPP
@@ -3,6 +3,8 @@
 
 #include "util/coordinate.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <vector>
 
@@ -59,12 +61,55 @@ const constexpr auto DOUGLAS_PEUCKER_THRESHOLDS_SIZE =
     sizeof(DOUGLAS_PEUCKER_THRESHOLDS) / sizeof(*DOUGLAS_PEUCKER_THRESHOLDS);
 } // ns detail
 
-// These functions compute the bitvector of indicating generalized input
-// points according to the (Ramer-)Douglas-Peucker algorithm.
+// Simplifies geometries by the (Ramer-)Douglas-Peucker algorithm, keeping its buffers between
+// geometries so repeated simplifications do not allocate.
 //
-// Input is vector of pairs. Each pair consists of the point information and a
-// bit indicating if the points is present in the generalization.
-// Note: points may also be pre-selected*/
+// Every coordinate has a significance: the simplification on a zoom level keeps exactly the
+// coordinates whose significance exceeds the threshold of that zoom level. ComputeSignificance
+// determines it for all zoom levels at once, Filter then simplifies for any of them without
+// running the algorithm again. Simplify only divides as far as a single zoom level needs.
+class DouglasPeucker
+{
+  public:
+    using CoordinateIter = std::vector<util::Coordinate>::const_iterator;
+
+    // Appends the coordinates kept on the zoom level to output, nothing for less than two
+    void Simplify(const CoordinateIter begin,
+                  const CoordinateIter end,
+                  const unsigned zoom_level,
+                  std::vector<util::Coordinate> &output);
+
+    void ComputeSignificance(const CoordinateIter begin, const CoordinateIter end);
+
+    // Appends the coordinates kept on the zoom level to output, begin has to be the start of the
+    // geometry given to the last ComputeSignificance
+    void Filter(const CoordinateIter begin,
+                const unsigned zoom_level,
+                std::vector<util::Coordinate> &output) const;
+
+    // The first and last coordinate are always kept and have the maximal significance
+    const std::vector<std::uint64_t> &GetSignificance() const { return significance; }
+
+  private:
+    // Divides the geometry at the farthest coordinate as long as it is farther than threshold
+    void
+    Divide(const CoordinateIter begin, const CoordinateIter end, const std::uint64_t threshold);
+
+    struct Range
+    {
+        std::size_t first;
+        std::size_t last;
+        // a coordinate is never more significant than the one its range was split at
+        std::uint64_t max_significance;
+    };
+
+    std::vector<util::FloatCoordinate> projected_coordinates;
+    std::vector<std::uint64_t> significance;
+    std::vector<Range> ranges;
+};
+
+// Computes the generalization of the input points according to the (Ramer-)Douglas-Peucker
+// algorithm on the given zoom level.
 std::vector<util::Coordinate> douglasPeucker(std::vector<util::Coordinate>::const_iterator begin,
                                              std::vector<util::Coordinate>::const_iterator end,
                                              const unsigned zoom_level);
@@ -2,12 +2,15 @@
 #define ENGINE_HPP
 
 #include "storage/shared_barriers.hpp"
+#include "engine/engine_config.hpp"
 #include "engine/status.hpp"
 #include "util/json_container.hpp"
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace osrm
 {
@@ -23,7 +26,6 @@ struct Object;
 // Fwd decls
 namespace engine
 {
-struct EngineConfig;
 namespace api
 {
 struct RouteParameters;
@@ -31,6 +33,7 @@ struct TableParameters;
 struct NearestParameters;
 struct TripParameters;
 struct MatchParameters;
+struct IsochroneParameters;
 struct TileParameters;
 }
 namespace plugins
@@ -40,6 +43,7 @@ class TablePlugin;
 class NearestPlugin;
 class TripPlugin;
 class MatchPlugin;
+class IsochronePlugin;
 class TilePlugin;
 }
 // End fwd decls
@@ -49,11 +53,16 @@ namespace datafacade
 class BaseDataFacade;
 }
 
+// One dataset generation pinned for several queries, see Engine::TakeSnapshot
+struct EngineSnapshot;
+
 class Engine final
 {
   public:
     // Needs to be public
     struct EngineLock;
+    // A data facade together with the plugins answering queries on it
+    struct QueryData;
 
     explicit Engine(EngineConfig &config);
 
@@ -64,23 +73,95 @@ class Engine final
     ~Engine();
 
     Status Route(const api::RouteParameters &parameters, util::json::Object &result);
+    Status Route(const std::vector<api::RouteParameters> &parameters, util::json::Object &result);
     Status Table(const api::TableParameters &parameters, util::json::Object &result);
+    Status Table(const api::TableParameters &parameters, std::vector<char> &result);
+    // Hands large responses to handle_chunk while they are rendered, see TablePlugin
+    using ChunkHandler = std::function<void(std::vector<char> &rendered)>;
+    Status Table(const api::TableParameters &parameters,
+                 std::vector<char> &result,
+                 const ChunkHandler &handle_chunk);
     Status Nearest(const api::NearestParameters &parameters, util::json::Object &result);
+    Status Nearest(const api::NearestParameters &parameters, std::vector<char> &result);
     Status Trip(const api::TripParameters &parameters, util::json::Object &result);
     Status Match(const api::MatchParameters &parameters, util::json::Object &result);
+    Status Match(const std::vector<api::MatchParameters> &parameters, util::json::Object &result);
+    Status Isochrone(const api::IsochroneParameters &parameters, util::json::Object &result);
     Status Tile(const api::TileParameters &parameters, std::string &result);
 
+    // Queue the query for the async workers, false if the queue is full. The callback runs on
+    // a worker once the query is answered and is never called for rejected queries.
+    template <typename ResultT> using Callback = std::function<void(Status, ResultT &)>;
+    bool RouteAsync(api::RouteParameters parameters, Callback<util::json::Object> callback);
+    bool TableAsync(api::TableParameters parameters, Callback<util::json::Object> callback);
+    bool NearestAsync(api::NearestParameters parameters, Callback<util::json::Object> callback);
+    bool TripAsync(api::TripParameters parameters, Callback<util::json::Object> callback);
+    bool MatchAsync(api::MatchParameters parameters, Callback<util::json::Object> callback);
+    bool IsochroneAsync(api::IsochroneParameters parameters,
+                        Callback<util::json::Object> callback);
+    bool TileAsync(api::TileParameters parameters, Callback<std::string> callback);
+
+    // Changes whenever osrm-datastore publishes a new dataset, always 0 without shared memory
+    unsigned GetDatasetGeneration() const;
+
+    // Timestamp of the dataset queries are currently answered on, see osrm-extract
+    std::string GetTimestamp() const;
+
+    // Sizes of the blocks of a dataset in shared memory or of a dataset file, see OSRM
+    void GetMemoryUsage(util::json::Object &result) const;
+
+    // Allocates the search heaps of the calling thread if EngineConfig::warm_up is set
+    void PrepareThread();
+
+    // Pins the current dataset generation until the snapshot is destroyed. The queries below
+    // run on it as they are, without looking for a newer generation or counting each of them.
+    std::shared_ptr<const EngineSnapshot> TakeSnapshot();
+    Status Route(const EngineSnapshot &snapshot,
+                 const api::RouteParameters &parameters,
+                 util::json::Object &result) const;
+    Status Table(const EngineSnapshot &snapshot,
+                 const api::TableParameters &parameters,
+                 util::json::Object &result) const;
+    Status Table(const EngineSnapshot &snapshot,
+                 const api::TableParameters &parameters,
+                 std::vector<char> &result) const;
+    Status Nearest(const EngineSnapshot &snapshot,
+                   const api::NearestParameters &parameters,
+                   util::json::Object &result) const;
+    Status Trip(const EngineSnapshot &snapshot,
+                const api::TripParameters &parameters,
+                util::json::Object &result) const;
+    Status Match(const EngineSnapshot &snapshot,
+                 const api::MatchParameters &parameters,
+                 util::json::Object &result) const;
+    Status Isochrone(const EngineSnapshot &snapshot,
+                     const api::IsochroneParameters &parameters,
+                     util::json::Object &result) const;
+    Status Tile(const EngineSnapshot &snapshot,
+                const api::TileParameters &parameters,
+                std::string &result) const;
+    unsigned GetDatasetGeneration(const EngineSnapshot &snapshot) const;
+    std::string GetTimestamp(const EngineSnapshot &snapshot) const;
+
   private:
+    // Workers of the asynchronous queries, started by the first one
+    struct AsyncWorkers;
+
+    template <typename ParameterT, typename ResultT>
+    bool RunAsync(Status (Engine::*query)(const ParameterT &, ResultT &),
+                  ParameterT parameters,
+                  Callback<ResultT> callback);
+
     std::unique_ptr<EngineLock> lock;
 
-    std::unique_ptr<plugins::ViaRoutePlugin> route_plugin;
-    std::unique_ptr<plugins::TablePlugin> table_plugin;
-    std::unique_ptr<plugins::NearestPlugin> nearest_plugin;
-    std::unique_ptr<plugins::TripPlugin> trip_plugin;
-    std::unique_ptr<plugins::MatchPlugin> match_plugin;
-    std::unique_ptr<plugins::TilePlugin> tile_plugin;
+    EngineConfig config;
+
+    // With shared memory a new QueryData is published for every dataset generation.
+    // Queries hold on to the one they started with, so old generations drain naturally.
+    std::shared_ptr<QueryData> query_data;
 
-    std::unique_ptr<datafacade::BaseDataFacade> query_data_facade;
+    // last member, so the workers are stopped before anything they use is destroyed
+    std::unique_ptr<AsyncWorkers> async_workers;
 };
 }
 }
@@ -33,6 +33,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/filesystem/path.hpp>
 
 #include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -51,13 +52,75 @@ namespace engine
  *  - Route
  *  - Table
  *  - Match
+ *  - Nearest
+ *
+ * Isochrones can cover at most max_duration_isochrone seconds (-1 for unlimited).
  *
  * In addition, shared memory can be used for datasets loaded with osrm-datastore.
+ * Alternatively use_dataset serves the single file written by osrm-datastore --dataset, which is
+ * mapped instead of read at startup.
+ * With shared memory, numa_node selects the copy of the data that osrm-datastore --numa replicate
+ * placed on that NUMA node.
+ *
+ * Large distance tables can fan out their searches over all cores. So can routes via many
+ * waypoints with use_parallel_route, which searches each leg from each direction of its start
+ * on its own and thus runs up to twice the searches of a sequential route. The legs and the
+ * alternative of large routes are then assembled in parallel as well.
+ * The rows of the largest rendered distance tables can be split further among table_peers,
+ * other osrm-routed instances given as host:port that serve the same dataset, see TablePeers.
+ * They are asked for the tables of table_peer_profile.
+ *
+ * The Tile service caches up to tile_cache_size encoded tiles, 0 disables the cache.
+ * A cache miss encodes the aligned block of tile_metatile_size x tile_metatile_size tiles around
+ * the requested one and caches all of them, 1 only encodes the requested tile.
+ * Route, Table and Trip can cache up to phantom_node_cache_size snapped coordinates, which helps
+ * when the same locations are requested over and over. The cache is disabled by default.
+ *
+ * Route, Trip and Match can cache the unpacked original edges of up to unpacking_cache_size
+ * long shortcuts, which saves unpacking the top of the hierarchy over and over. The cache is
+ * disabled by default.
+ *
+ * Route can cache up to route_result_cache_size unpacked routes between two snapped segments
+ * and skips the search for further requests between them, for example from the entrances of a
+ * mall. Such a route can be longer than the shortest one by the length of a geometry segment at
+ * its start or end. The cache is disabled by default.
+ *
+ * Alternative routes inspect at most max_alternative_candidates via nodes in depth, picked by
+ * their approximated length and sharing. 0 inspects all of them.
+ *
+ * Searches in the core of a partially contracted graph (osrm-contract --core) are directed by
+ * core_landmarks landmarks for route, trip and match, 0 runs a plain Dijkstra in the core.
+ * Landmarks precomputed by osrm-contract --core-landmarks are always used and take precedence.
+ *
+ * Trip improves the tours of more than eight locations by local search for at most
+ * max_trip_optimization_time milliseconds, 0 disables the improvement.
+ *
+ * Match only expands the matching_beam_width most likely states of a trace coordinate to the
+ * next one, and only the states whose log probability is within matching_beam_range of the most
+ * likely one. This bounds the transitions routed per coordinate in dense areas with many
+ * candidates, at the risk of missing the best matching. 0 disables either limit.
+ *
+ * The searches of a query give up after max_query_time milliseconds and the query fails with
+ * the code Timeout, 0 lets queries run to completion. Queries of a batch share one deadline.
+ *
+ * With warm_up the pages of a dataset are faulted in before it answers its first query, also
+ * for every dataset osrm-datastore publishes later on, and OSRM::PrepareThread allocates the
+ * search heaps of a thread ahead of its first query.
+ *
+ * The asynchronous queries are answered by async_workers threads, 0 starts one per hardware
+ * thread. The threads are only started by the first asynchronous query. At most
+ * max_queued_async_queries queries wait for a thread, further ones are rejected.
  *
  * \see OSRM, StorageConfig
  */
 struct EngineConfig final
 {
+    enum class Algorithm
+    {
+        CH,
+        MLD
+    };
+
     bool IsValid() const;
 
     storage::StorageConfig storage_config;
@@ -65,7 +128,30 @@ struct EngineConfig final
     int max_locations_viaroute = -1;
     int max_locations_distance_table = -1;
     int max_locations_map_matching = -1;
+    int max_locations_nearest = -1;
+    int max_duration_isochrone = -1;
     bool use_shared_memory = true;
+    bool use_dataset = false;
+    unsigned numa_node = 0;
+    bool use_parallel_table = false;
+    bool use_parallel_route = false;
+    std::vector<std::string> table_peers;
+    std::string table_peer_profile = "driving";
+    int tile_cache_size = 512;
+    int tile_metatile_size = 1;
+    int phantom_node_cache_size = 0;
+    int max_alternative_candidates = 0;
+    int unpacking_cache_size = 0;
+    int route_result_cache_size = 0;
+    int max_trip_optimization_time = 10;
+    int matching_beam_width = 0;
+    double matching_beam_range = 0;
+    int max_query_time = 0;
+    bool warm_up = false;
+    int core_landmarks = 0;
+    int async_workers = 0;
+    int max_queued_async_queries = 1024;
+    Algorithm algorithm = Algorithm::CH;
 };
 }
 }
@@ -1,15 +1,19 @@
 #ifndef GEOSPATIAL_QUERY_HPP
 #define GEOSPATIAL_QUERY_HPP
 
+#include "engine/bearing.hpp"
 #include "engine/phantom_node.hpp"
 #include "util/bearing.hpp"
 #include "util/coordinate_calculation.hpp"
+#include "util/integer_range.hpp"
 #include "util/rectangle.hpp"
 #include "util/typedefs.hpp"
 #include "util/web_mercator.hpp"
 
 #include "osrm/coordinate.hpp"
 
+#include <boost/optional.hpp>
+
 #include <algorithm>
 #include <cmath>
 #include <memory>
@@ -28,6 +32,7 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     using EdgeData = typename RTreeT::EdgeData;
     using CoordinateList = typename RTreeT::CoordinateList;
     using CandidateSegment = typename RTreeT::CandidateSegment;
+    using BearingFilter = typename RTreeT::BearingFilter;
 
   public:
     GeospatialQuery(RTreeT &rtree_, const CoordinateList &coordinates_, DataFacadeT &datafacade_)
@@ -67,6 +72,7 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     {
         auto results = rtree.Nearest(
             input_coordinate,
+            BearingFilter{bearing, bearing_range},
             [this, bearing, bearing_range, max_distance](const CandidateSegment &segment) {
                 return CheckSegmentBearing(segment, bearing, bearing_range);
             },
@@ -87,13 +93,13 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                         const int bearing_range) const
     {
         auto results =
-            rtree.Nearest(input_coordinate,
-                          [this, bearing, bearing_range](const CandidateSegment &segment) {
-                              return CheckSegmentBearing(segment, bearing, bearing_range);
-                          },
-                          [max_results](const std::size_t num_results, const CandidateSegment &) {
-                              return num_results >= max_results;
-                          });
+            rtree.KNearest(input_coordinate,
+                           BearingFilter{bearing, bearing_range},
+                           max_results,
+                           [this, bearing, bearing_range](const CandidateSegment &segment) {
+                               return CheckSegmentBearing(segment, bearing, bearing_range);
+                           },
+                           [](const CandidateSegment &) { return false; });
 
         return MakePhantomNodes(input_coordinate, results);
     }
@@ -109,15 +115,15 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                         const int bearing_range) const
     {
         auto results =
-            rtree.Nearest(input_coordinate,
-                          [this, bearing, bearing_range](const CandidateSegment &segment) {
-                              return CheckSegmentBearing(segment, bearing, bearing_range);
-                          },
-                          [this, max_distance, max_results, input_coordinate](
-                              const std::size_t num_results, const CandidateSegment &segment) {
-                              return num_results >= max_results ||
-                                     CheckSegmentDistance(input_coordinate, segment, max_distance);
-                          });
+            rtree.KNearest(input_coordinate,
+                           BearingFilter{bearing, bearing_range},
+                           max_results,
+                           [this, bearing, bearing_range](const CandidateSegment &segment) {
+                               return CheckSegmentBearing(segment, bearing, bearing_range);
+                           },
+                           [this, max_distance, input_coordinate](const CandidateSegment &segment) {
+                               return CheckSegmentDistance(input_coordinate, segment, max_distance);
+                           });
 
         return MakePhantomNodes(input_coordinate, results);
     }
@@ -127,16 +133,62 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     std::vector<PhantomNodeWithDistance>
     NearestPhantomNodes(const util::Coordinate input_coordinate, const unsigned max_results) const
     {
-        auto results =
-            rtree.Nearest(input_coordinate,
-                          [](const CandidateSegment &) { return std::make_pair(true, true); },
-                          [max_results](const std::size_t num_results, const CandidateSegment &) {
-                              return num_results >= max_results;
-                          });
+        auto results = rtree.Nearest(input_coordinate, max_results);
 
         return MakePhantomNodes(input_coordinate, results);
     }
 
+    // Batched version of the queries above: the max_results nearest PhantomNodes of every
+    // coordinate, within its radius and bearing range if it has one. radiuses and bearings are
+    // either empty or have an entry per coordinate. Shares a single hilbert ordered r-tree
+    // traversal between all coordinates, results are in input order.
+    // Does not filter by small/big component!
+    std::vector<std::vector<PhantomNodeWithDistance>>
+    NearestPhantomNodes(const std::vector<util::Coordinate> &input_coordinates,
+                        const unsigned max_results,
+                        const std::vector<boost::optional<double>> &radiuses,
+                        const std::vector<boost::optional<Bearing>> &bearings) const
+    {
+        BOOST_ASSERT(radiuses.empty() || radiuses.size() == input_coordinates.size());
+        BOOST_ASSERT(bearings.empty() || bearings.size() == input_coordinates.size());
+
+        std::vector<boost::optional<BearingFilter>> bearing_filters(bearings.size());
+        std::transform(bearings.begin(),
+                       bearings.end(),
+                       bearing_filters.begin(),
+                       [](const boost::optional<Bearing> &bearing) {
+                           return bearing ? boost::make_optional(
+                                                BearingFilter{bearing->bearing, bearing->range})
+                                          : boost::none;
+                       });
+
+        auto results = rtree.KNearest(
+            input_coordinates,
+            bearing_filters,
+            max_results,
+            [this, &bearings](const std::size_t query_index, const CandidateSegment &segment) {
+                if (bearings.empty() || !bearings[query_index])
+                {
+                    return std::make_pair(true, true);
+                }
+                return CheckSegmentBearing(
+                    segment, bearings[query_index]->bearing, bearings[query_index]->range);
+            },
+            [this, &radiuses, &input_coordinates](const std::size_t query_index,
+                                                  const CandidateSegment &segment) {
+                return !radiuses.empty() && radiuses[query_index] &&
+                       CheckSegmentDistance(
+                           input_coordinates[query_index], segment, *radiuses[query_index]);
+            });
+
+        std::vector<std::vector<PhantomNodeWithDistance>> phantom_nodes(input_coordinates.size());
+        for (const auto i : util::irange<std::size_t>(0UL, input_coordinates.size()))
+        {
+            phantom_nodes[i] = MakePhantomNodes(input_coordinates[i], results[i]);
+        }
+        return phantom_nodes;
+    }
+
     // Returns max_results nearest PhantomNodes in the given max distance.
     // Does not filter by small/big component!
     std::vector<PhantomNodeWithDistance>
@@ -145,13 +197,12 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                         const double max_distance) const
     {
         auto results =
-            rtree.Nearest(input_coordinate,
-                          [](const CandidateSegment &) { return std::make_pair(true, true); },
-                          [this, max_distance, max_results, input_coordinate](
-                              const std::size_t num_results, const CandidateSegment &segment) {
-                              return num_results >= max_results ||
-                                     CheckSegmentDistance(input_coordinate, segment, max_distance);
-                          });
+            rtree.KNearest(input_coordinate,
+                           max_results,
+                           [](const CandidateSegment &) { return std::make_pair(true, true); },
+                           [this, max_distance, input_coordinate](const CandidateSegment &segment) {
+                               return CheckSegmentDistance(input_coordinate, segment, max_distance);
+                           });
 
         return MakePhantomNodes(input_coordinate, results);
     }
@@ -162,34 +213,12 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     NearestPhantomNodeWithAlternativeFromBigComponent(const util::Coordinate input_coordinate,
                                                       const double max_distance) const
     {
-        bool has_small_component = false;
-        bool has_big_component = false;
-        auto results = rtree.Nearest(
+        return NearestWithAlternativeFromBigComponent(
             input_coordinate,
-            [&has_big_component, &has_small_component](const CandidateSegment &segment) {
-                auto use_segment = (!has_small_component ||
-                                    (!has_big_component && !segment.data.component.is_tiny));
-                auto use_directions = std::make_pair(use_segment, use_segment);
-
-                has_big_component = has_big_component || !segment.data.component.is_tiny;
-                has_small_component = has_small_component || segment.data.component.is_tiny;
-
-                return use_directions;
-            },
-            [this, &has_big_component, max_distance, input_coordinate](
-                const std::size_t num_results, const CandidateSegment &segment) {
-                return (num_results > 0 && has_big_component) ||
-                       CheckSegmentDistance(input_coordinate, segment, max_distance);
+            boost::none,
+            [this, max_distance, input_coordinate](const CandidateSegment &segment) {
+                return CheckSegmentDistance(input_coordinate, segment, max_distance);
             });
-
-        if (results.size() == 0)
-        {
-            return std::make_pair(PhantomNode{}, PhantomNode{});
-        }
-
-        BOOST_ASSERT(results.size() == 1 || results.size() == 2);
-        return std::make_pair(MakePhantomNode(input_coordinate, results.front()).phantom_node,
-                              MakePhantomNode(input_coordinate, results.back()).phantom_node);
     }
 
     // Returns the nearest phantom node. If this phantom node is not from a big component
@@ -197,32 +226,46 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     std::pair<PhantomNode, PhantomNode>
     NearestPhantomNodeWithAlternativeFromBigComponent(const util::Coordinate input_coordinate) const
     {
-        bool has_small_component = false;
-        bool has_big_component = false;
-        auto results = rtree.Nearest(
-            input_coordinate,
-            [&has_big_component, &has_small_component](const CandidateSegment &segment) {
-                auto use_segment = (!has_small_component ||
-                                    (!has_big_component && !segment.data.component.is_tiny));
-                auto use_directions = std::make_pair(use_segment, use_segment);
-
-                has_big_component = has_big_component || !segment.data.component.is_tiny;
-                has_small_component = has_small_component || segment.data.component.is_tiny;
+        return NearestWithAlternativeFromBigComponent(
+            input_coordinate, boost::none, [](const CandidateSegment &) { return false; });
+    }
 
-                return use_directions;
-            },
-            [&has_big_component](const std::size_t num_results, const CandidateSegment &) {
-                return num_results > 0 && has_big_component;
+    // Batched version of NearestPhantomNodeWithAlternativeFromBigComponent that shares a single
+    // hilbert ordered r-tree traversal between all coordinates.
+    std::vector<std::pair<PhantomNode, PhantomNode>>
+    NearestPhantomNodesWithAlternativeFromBigComponent(
+        const std::vector<util::Coordinate> &input_coordinates) const
+    {
+        auto results = rtree.Nearest(
+            input_coordinates,
+            [](const std::size_t, const CandidateSegment &) { return std::make_pair(true, true); },
+            [](const std::size_t, const std::size_t num_results, const CandidateSegment &) {
+                return num_results > 0;
             });
 
-        if (results.size() == 0)
+        std::vector<std::pair<PhantomNode, PhantomNode>> phantom_node_pairs(
+            input_coordinates.size());
+        for (const auto i : util::irange<std::size_t>(0UL, input_coordinates.size()))
         {
-            return std::make_pair(PhantomNode{}, PhantomNode{});
-        }
+            if (results[i].empty())
+            {
+                continue;
+            }
 
-        BOOST_ASSERT(results.size() == 1 || results.size() == 2);
-        return std::make_pair(MakePhantomNode(input_coordinate, results.front()).phantom_node,
-                              MakePhantomNode(input_coordinate, results.back()).phantom_node);
+            BOOST_ASSERT(results[i].size() == 1);
+            const auto phantom_node =
+                MakePhantomNode(input_coordinates[i], results[i].front()).phantom_node;
+            phantom_node_pairs[i] = std::make_pair(
+                phantom_node,
+                results[i].front().component.is_tiny
+                    ? NearestFromBigComponent(
+                          input_coordinates[i],
+                          boost::none,
+                          [](const CandidateSegment &) { return false; },
+                          phantom_node)
+                    : phantom_node);
+        }
+        return phantom_node_pairs;
     }
 
     // Returns the nearest phantom node. If this phantom node is not from a big component
@@ -230,40 +273,10 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
     std::pair<PhantomNode, PhantomNode> NearestPhantomNodeWithAlternativeFromBigComponent(
         const util::Coordinate input_coordinate, const int bearing, const int bearing_range) const
     {
-        bool has_small_component = false;
-        bool has_big_component = false;
-        auto results = rtree.Nearest(
+        return NearestWithAlternativeFromBigComponent(
             input_coordinate,
-            [this, bearing, bearing_range, &has_big_component, &has_small_component](
-                const CandidateSegment &segment) {
-                auto use_segment = (!has_small_component ||
-                                    (!has_big_component && !segment.data.component.is_tiny));
-                auto use_directions = std::make_pair(use_segment, use_segment);
-
-                if (use_segment)
-                {
-                    use_directions = CheckSegmentBearing(segment, bearing, bearing_range);
-                    if (use_directions.first || use_directions.second)
-                    {
-                        has_big_component = has_big_component || !segment.data.component.is_tiny;
-                        has_small_component = has_small_component || segment.data.component.is_tiny;
-                    }
-                }
-
-                return use_directions;
-            },
-            [&has_big_component](const std::size_t num_results, const CandidateSegment &) {
-                return num_results > 0 && has_big_component;
-            });
-
-        if (results.size() == 0)
-        {
-            return std::make_pair(PhantomNode{}, PhantomNode{});
-        }
-
-        BOOST_ASSERT(results.size() > 0);
-        return std::make_pair(MakePhantomNode(input_coordinate, results.front()).phantom_node,
-                              MakePhantomNode(input_coordinate, results.back()).phantom_node);
+            BearingFilter{bearing, bearing_range},
+            [](const CandidateSegment &) { return false; });
     }
 
     // Returns the nearest phantom node. If this phantom node is not from a big component
@@ -274,45 +287,72 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                                                       const int bearing,
                                                       const int bearing_range) const
     {
-        bool has_small_component = false;
-        bool has_big_component = false;
-        auto results = rtree.Nearest(
+        return NearestWithAlternativeFromBigComponent(
             input_coordinate,
-            [this, bearing, bearing_range, &has_big_component, &has_small_component](
-                const CandidateSegment &segment) {
-                auto use_segment = (!has_small_component ||
-                                    (!has_big_component && !segment.data.component.is_tiny));
-                auto use_directions = std::make_pair(use_segment, use_segment);
-
-                if (use_segment)
-                {
-                    use_directions = CheckSegmentBearing(segment, bearing, bearing_range);
-                    if (use_directions.first || use_directions.second)
-                    {
-                        has_big_component = has_big_component || !segment.data.component.is_tiny;
-                        has_small_component = has_small_component || segment.data.component.is_tiny;
-                    }
-                }
-
-                return use_directions;
-            },
-            [this, &has_big_component, max_distance, input_coordinate](
-                const std::size_t num_results, const CandidateSegment &segment) {
-                return (num_results > 0 && has_big_component) ||
-                       CheckSegmentDistance(input_coordinate, segment, max_distance);
+            BearingFilter{bearing, bearing_range},
+            [this, max_distance, input_coordinate](const CandidateSegment &segment) {
+                return CheckSegmentDistance(input_coordinate, segment, max_distance);
             });
+    }
 
-        if (results.size() == 0)
+  private:
+    // The nearest segment within the bearing filter, and if it is of a tiny component the
+    // nearest one of a big component as well. The latter is found by a second search that skips
+    // the tiny components in the r-tree, instead of filtering its way through all of them.
+    // Searches stop at the first segment that is out of range.
+    template <typename OutOfRangeT>
+    std::pair<PhantomNode, PhantomNode>
+    NearestWithAlternativeFromBigComponent(const util::Coordinate input_coordinate,
+                                           const boost::optional<BearingFilter> bearing_filter,
+                                           const OutOfRangeT out_of_range) const
+    {
+        const auto filter = [this, &bearing_filter](const CandidateSegment &segment) {
+            return CheckSegmentBearing(segment, bearing_filter);
+        };
+        const auto terminate = [&out_of_range](const std::size_t num_results,
+                                               const CandidateSegment &segment) {
+            return num_results > 0 || out_of_range(segment);
+        };
+        const auto results =
+            bearing_filter ? rtree.Nearest(input_coordinate, *bearing_filter, filter, terminate)
+                           : rtree.Nearest(input_coordinate, filter, terminate);
+
+        if (results.empty())
         {
             return std::make_pair(PhantomNode{}, PhantomNode{});
         }
 
-        BOOST_ASSERT(results.size() > 0);
-        return std::make_pair(MakePhantomNode(input_coordinate, results.front()).phantom_node,
-                              MakePhantomNode(input_coordinate, results.back()).phantom_node);
+        BOOST_ASSERT(results.size() == 1);
+        const auto phantom_node = MakePhantomNode(input_coordinate, results.front()).phantom_node;
+        if (!results.front().component.is_tiny)
+        {
+            return std::make_pair(phantom_node, phantom_node);
+        }
+        return std::make_pair(
+            phantom_node,
+            NearestFromBigComponent(input_coordinate, bearing_filter, out_of_range, phantom_node));
+    }
+
+    // The nearest phantom node of a big component, fallback if there is none in range
+    template <typename OutOfRangeT>
+    PhantomNode NearestFromBigComponent(const util::Coordinate input_coordinate,
+                                        const boost::optional<BearingFilter> bearing_filter,
+                                        const OutOfRangeT out_of_range,
+                                        const PhantomNode &fallback) const
+    {
+        const auto results = rtree.NearestInBigComponents(
+            input_coordinate,
+            bearing_filter,
+            [this, &bearing_filter](const CandidateSegment &segment) {
+                return CheckSegmentBearing(segment, bearing_filter);
+            },
+            [&out_of_range](const std::size_t num_results, const CandidateSegment &segment) {
+                return num_results > 0 || out_of_range(segment);
+            });
+        return results.empty() ? fallback
+                               : MakePhantomNode(input_coordinate, results.front()).phantom_node;
     }
 
-  private:
     std::vector<PhantomNodeWithDistance>
     MakePhantomNodes(const util::Coordinate input_coordinate,
                      const std::vector<EdgeData> &results) const
@@ -440,6 +480,13 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
         return std::make_pair(forward_bearing_valid, backward_bearing_valid);
     }
 
+    std::pair<bool, bool> CheckSegmentBearing(const CandidateSegment &segment,
+                                              const boost::optional<BearingFilter> &filter) const
+    {
+        return filter ? CheckSegmentBearing(segment, filter->bearing, filter->range)
+                      : std::make_pair(true, true);
+    }
+
     const RTreeT &rtree;
     const CoordinateList &coordinates;
     DataFacadeT &datafacade;
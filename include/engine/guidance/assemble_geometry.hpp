@@ -45,8 +45,8 @@ inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
 
     // Need to get the node ID preceding the source phantom node
     // TODO: check if this was traversed in reverse?
-    std::vector<NodeID> reverse_geometry;
-    facade.GetUncompressedGeometry(source_node.reverse_packed_geometry_id, reverse_geometry);
+    const auto reverse_geometry =
+        facade.GetUncompressedGeometryView(source_node.reverse_packed_geometry_id);
     geometry.osm_node_ids.push_back(facade.GetOSMNodeIDOfNode(
         reverse_geometry[reverse_geometry.size() - source_node.fwd_segment_position - 1]));
 
@@ -86,8 +86,8 @@ inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
 
     // Need to get the node ID following the destination phantom node
     // TODO: check if this was traversed in reverse??
-    std::vector<NodeID> forward_geometry;
-    facade.GetUncompressedGeometry(target_node.forward_packed_geometry_id, forward_geometry);
+    const auto forward_geometry =
+        facade.GetUncompressedGeometryView(target_node.forward_packed_geometry_id);
     geometry.osm_node_ids.push_back(
         facade.GetOSMNodeIDOfNode(forward_geometry[target_node.fwd_segment_position]));
 
@@ -97,6 +97,35 @@ inline LegGeometry assembleGeometry(const datafacade::BaseDataFacade &facade,
 
     return geometry;
 }
+
+// The distance of the leg, the same as the sum of the segment distances of assembleGeometry
+// without building the geometry. Sums up segment by segment, so both agree to the last bit.
+inline double assembleDistance(const datafacade::BaseDataFacade &facade,
+                               const std::vector<PathData> &leg_data,
+                               const PhantomNode &source_node,
+                               const PhantomNode &target_node)
+{
+    auto distance = 0.;
+    auto cumulative_distance = 0.;
+    auto prev_coordinate = source_node.location;
+    for (const auto &path_point : leg_data)
+    {
+        const auto coordinate = facade.GetCoordinateOfNode(path_point.turn_via_node);
+        cumulative_distance +=
+            util::coordinate_calculation::haversineDistance(prev_coordinate, coordinate);
+
+        // all changes to this check have to be matched with assembleGeometry
+        if (path_point.turn_instruction.type != extractor::guidance::TurnType::NoTurn)
+        {
+            distance += cumulative_distance;
+            cumulative_distance = 0.;
+        }
+        prev_coordinate = coordinate;
+    }
+    cumulative_distance +=
+        util::coordinate_calculation::haversineDistance(prev_coordinate, target_node.location);
+    return distance + cumulative_distance;
+}
 }
 }
 }
@@ -116,9 +116,10 @@ std::array<std::uint32_t, SegmentNumber> summarizeRoute(const std::vector<PathDa
 }
 }
 
+// distance is the length of the leg in meters, see assembleDistance
 inline RouteLeg assembleLeg(const datafacade::BaseDataFacade &facade,
                             const std::vector<PathData> &route_data,
-                            const LegGeometry &leg_geometry,
+                            const double distance,
                             const PhantomNode &source_node,
                             const PhantomNode &target_node,
                             const bool target_traversed_in_reverse,
@@ -128,8 +129,6 @@ inline RouteLeg assembleLeg(const datafacade::BaseDataFacade &facade,
         (target_traversed_in_reverse ? target_node.reverse_weight : target_node.forward_weight) /
         10.;
 
-    auto distance = std::accumulate(
-        leg_geometry.segment_distances.begin(), leg_geometry.segment_distances.end(), 0.);
     auto duration = std::accumulate(route_data.begin(),
                                     route_data.end(),
                                     0.,
@@ -192,6 +191,25 @@ inline RouteLeg assembleLeg(const datafacade::BaseDataFacade &facade,
     return RouteLeg{duration, distance, summary, {}};
 }
 
+inline RouteLeg assembleLeg(const datafacade::BaseDataFacade &facade,
+                            const std::vector<PathData> &route_data,
+                            const LegGeometry &leg_geometry,
+                            const PhantomNode &source_node,
+                            const PhantomNode &target_node,
+                            const bool target_traversed_in_reverse,
+                            const bool needs_summary)
+{
+    const auto distance = std::accumulate(
+        leg_geometry.segment_distances.begin(), leg_geometry.segment_distances.end(), 0.);
+    return assembleLeg(facade,
+                       route_data,
+                       distance,
+                       source_node,
+                       target_node,
+                       target_traversed_in_reverse,
+                       needs_summary);
+}
+
 } // namespace guidance
 } // namespace engine
 } // namespace osrm
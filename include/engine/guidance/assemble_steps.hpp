@@ -101,15 +101,12 @@ inline std::vector<RouteStep> assembleSteps(const datafacade::BaseDataFacade &fa
             if (path_point.turn_instruction.type != extractor::guidance::TurnType::NoTurn)
             {
                 BOOST_ASSERT(segment_duration >= 0);
-                const auto name = facade.GetNameForID(step_name_id);
-                const auto pronunciation = facade.GetPronunciationForID(step_name_id);
-                const auto destinations = facade.GetDestinationsForID(step_name_id);
                 const auto distance = leg_geometry.segment_distances[segment_index];
 
                 steps.push_back(RouteStep{step_name_id,
-                                          std::move(name),
-                                          std::move(pronunciation),
-                                          std::move(destinations),
+                                          facade.GetNameForID(step_name_id),
+                                          facade.GetPronunciationForID(step_name_id),
+                                          facade.GetDestinationsForID(step_name_id),
                                           NO_ROTARY_NAME,
                                           segment_duration / 10.0,
                                           distance,
@@ -130,21 +127,19 @@ inline std::vector<RouteStep> assembleSteps(const datafacade::BaseDataFacade &fa
 
                 bearings = detail::getIntermediateBearings(leg_geometry, segment_index);
                 const auto entry_class = facade.GetEntryClass(path_point.entry_classid);
-                const auto bearing_class =
-                    facade.GetBearingClass(facade.GetBearingClassID(path_point.turn_via_node));
-                intersection.in = bearing_class.findMatchingBearing(
-                    util::bearing::reverseBearing(bearings.first));
-                intersection.out = bearing_class.findMatchingBearing(bearings.second);
+                // the stored bearings are read in place, the intersection reuses its buffers
+                const auto available_bearings =
+                    facade.GetBearings(facade.GetBearingClassID(path_point.turn_via_node));
+                intersection.in = util::guidance::findMatchingBearing(
+                    available_bearings, util::bearing::reverseBearing(bearings.first));
+                intersection.out =
+                    util::guidance::findMatchingBearing(available_bearings, bearings.second);
                 intersection.location = facade.GetCoordinateOfNode(path_point.turn_via_node);
-                intersection.bearings.clear();
-                intersection.bearings.reserve(bearing_class.getAvailableBearings().size());
-                std::copy(bearing_class.getAvailableBearings().begin(),
-                          bearing_class.getAvailableBearings().end(),
-                          std::back_inserter(intersection.bearings));
-                intersection.entry.clear();
+                intersection.bearings.assign(available_bearings.begin(), available_bearings.end());
+                intersection.entry.resize(intersection.bearings.size());
                 for (auto idx : util::irange<std::size_t>(0, intersection.bearings.size()))
                 {
-                    intersection.entry.push_back(entry_class.allowsEntry(idx));
+                    intersection.entry[idx] = entry_class.allowsEntry(idx);
                 }
                 maneuver = {intersection.location,
                             bearings.first,
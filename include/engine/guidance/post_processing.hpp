@@ -50,6 +50,13 @@ std::vector<RouteStep> removeNoTurnInstructions(std::vector<RouteStep> steps);
 // Move in LegGeometry for modification in place.
 LegGeometry resyncGeometry(LegGeometry leg_geometry, const std::vector<RouteStep> &steps);
 
+// Runs all of the above on the steps of a leg, in the order the route service needs them.
+// The passes hand the same vector on to each other, the steps are never copied.
+void postProcessLeg(std::vector<RouteStep> &steps,
+                    LegGeometry &leg_geometry,
+                    const PhantomNode &source_node,
+                    const PhantomNode &target_node);
+
 } // namespace guidance
 } // namespace engine
 } // namespace osrm
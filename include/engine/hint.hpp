@@ -32,9 +32,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "util/coordinate.hpp"
 
+#include <boost/optional.hpp>
+
 #include <cstdint>
 #include <iosfwd>
 #include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -47,7 +50,8 @@ namespace datafacade
 class BaseDataFacade;
 }
 
-// Is returned as a temporary identifier for snapped coodinates
+// Is returned as a temporary identifier for snapped coodinates.
+// Its compact encoding leaves out what the facade can restore, see CompactHint.
 struct Hint
 {
     PhantomNode phantom;
@@ -56,7 +60,17 @@ struct Hint
     bool IsValid(const util::Coordinate new_input_coordinates,
                  const datafacade::BaseDataFacade &facade) const;
 
+    // Same as above for a facade with the given number of nodes and checksum
+    bool IsValid(const util::Coordinate new_input_coordinates,
+                 const unsigned number_of_nodes,
+                 const std::uint32_t checksum) const;
+
+    // Decoded compact hints have no input location and no offsets until they are restored
+    bool IsCompact() const;
+
     std::string ToBase64() const;
+    std::string ToCompactBase64() const;
+    // Decodes both encodings, distinguished by their size
     static Hint FromBase64(const std::string &base64Hint);
 
     friend bool operator==(const Hint &, const Hint &);
@@ -67,6 +81,42 @@ static_assert(sizeof(Hint) == 60 + 4, "Hint is bigger than expected");
 constexpr std::size_t ENCODED_HINT_SIZE = 88;
 static_assert(ENCODED_HINT_SIZE / 4 * 3 >= sizeof(Hint),
               "ENCODED_HINT_SIZE does not match size of Hint");
+
+// The part of a phantom node the facade cannot restore. The offsets are summed up from the
+// weights of the packed geometry and the input coordinate only enters the checksum.
+struct CompactHint
+{
+    CompactHint();
+    CompactHint(const PhantomNode &phantom, const std::uint32_t data_checksum);
+
+    SegmentID forward_segment_id;
+    SegmentID reverse_segment_id;
+    unsigned forward_packed_geometry_id;
+    unsigned reverse_packed_geometry_id;
+    unsigned name_id;
+    PhantomNode::ComponentType component;
+    int forward_weight;
+    int reverse_weight;
+    util::Coordinate location;
+    // checksum of the dataset and the input coordinate
+    std::uint32_t checksum;
+    unsigned short fwd_segment_position;
+    extractor::TravelMode forward_travel_mode;
+    extractor::TravelMode backward_travel_mode;
+};
+
+static_assert(sizeof(CompactHint) == 48, "CompactHint has more padding than expected");
+constexpr std::size_t ENCODED_COMPACT_HINT_SIZE = 64;
+static_assert(ENCODED_COMPACT_HINT_SIZE / 4 * 3 == sizeof(CompactHint),
+              "ENCODED_COMPACT_HINT_SIZE does not match size of CompactHint");
+
+// Returns the phantom nodes of the hints that are valid for their coordinates and restores
+// the compact ones from the facade. The checksum and the number of nodes of the facade are
+// looked up once for all hints.
+std::vector<boost::optional<PhantomNode>>
+getHintedPhantomNodes(const std::vector<boost::optional<Hint>> &hints,
+                      const std::vector<util::Coordinate> &coordinates,
+                      const datafacade::BaseDataFacade &facade);
 }
 }
 
@@ -35,6 +35,15 @@ struct PathData
     EntryClassID entry_classid;
 };
 
+// An alternative route of a single leg
+struct AlternativeRouteResult
+{
+    std::vector<PathData> unpacked_path;
+    bool source_traversed_in_reverse;
+    bool target_traversed_in_reverse;
+    int length;
+};
+
 struct InternalRouteResult
 {
     std::vector<std::vector<PathData>> unpacked_path_segments;
@@ -46,6 +55,8 @@ struct InternalRouteResult
     std::vector<bool> alt_target_traversed_in_reverse;
     int shortest_path_length;
     int alternative_path_length;
+    // the alternatives of the penalty method after the one above, shortest first
+    std::vector<AlternativeRouteResult> further_alternatives;
 
     bool is_valid() const { return INVALID_EDGE_WEIGHT != shortest_path_length; }
 
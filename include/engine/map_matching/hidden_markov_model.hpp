@@ -1,14 +1,18 @@
 #ifndef HIDDEN_MARKOV_MODEL
 #define HIDDEN_MARKOV_MODEL
 
+#include "engine/search_engine_data.hpp"
 #include "util/integer_range.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/math/constants/constants.hpp>
+#include <boost/range/iterator_range_core.hpp>
 
 #include <cmath>
 
+#include <algorithm>
 #include <limits>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -48,55 +52,103 @@ struct TransitionLogProbability
     double operator()(const double d_t) const { return -log_beta - d_t / beta; }
 };
 
-template <class CandidateLists> struct HiddenMarkovModel
+// Values of all candidates of a trace in one array, layer t holds the values of the candidates of
+// timestamp t. The array is taken from a pool of the calling thread, so matching a long trace
+// neither allocates an array per timestamp nor one per request.
+template <typename T> class LayeredValues
 {
-    std::vector<std::vector<double>> viterbi;
-    std::vector<std::vector<std::pair<unsigned, unsigned>>> parents;
-    std::vector<std::vector<float>> path_distances;
-    std::vector<std::vector<bool>> pruned;
-    std::vector<bool> breakage;
+    using Pool = ThreadLocalPool<std::vector<T>>;
 
-    const CandidateLists &candidates_list;
-    const std::vector<std::vector<double>> &emission_log_probabilities;
+  public:
+    using Layer = boost::iterator_range<T *>;
+    using ConstLayer = boost::iterator_range<const T *>;
+
+    // offsets[t] is the index of the first value of layer t, offsets.back() the number of values
+    LayeredValues(const std::vector<std::size_t> &offsets, const T &value)
+        : offsets(offsets), values(Pool::Acquire())
+    {
+        BOOST_ASSERT(!offsets.empty());
+        values->assign(offsets.back(), value);
+    }
+
+    Layer operator[](const std::size_t t)
+    {
+        BOOST_ASSERT(t + 1 < offsets.size());
+        return {values->data() + offsets[t], values->data() + offsets[t + 1]};
+    }
 
-    HiddenMarkovModel(const CandidateLists &candidates_list,
-                      const std::vector<std::vector<double>> &emission_log_probabilities)
-        : breakage(candidates_list.size()), candidates_list(candidates_list),
-          emission_log_probabilities(emission_log_probabilities)
+    ConstLayer operator[](const std::size_t t) const
     {
-        viterbi.resize(candidates_list.size());
-        parents.resize(candidates_list.size());
-        path_distances.resize(candidates_list.size());
-        pruned.resize(candidates_list.size());
-        breakage.resize(candidates_list.size());
-        for (const auto i : util::irange<std::size_t>(0UL, candidates_list.size()))
+        BOOST_ASSERT(t + 1 < offsets.size());
+        return {values->data() + offsets[t], values->data() + offsets[t + 1]};
+    }
+
+    // number of layers
+    std::size_t size() const { return offsets.size() - 1; }
+
+    // sets all values of the layers from first_layer on
+    void Fill(const std::size_t first_layer, const T &value)
+    {
+        BOOST_ASSERT(first_layer < offsets.size());
+        std::fill(values->begin() + offsets[first_layer], values->end(), value);
+    }
+
+  private:
+    const std::vector<std::size_t> &offsets;
+    typename Pool::Handle values;
+};
+
+template <class CandidateLists> struct HiddenMarkovModel
+{
+  private:
+    // declared first, the layered values below refer to it
+    ThreadLocalPool<std::vector<std::size_t>>::Handle layer_offsets;
+    ThreadLocalPool<std::vector<bool>>::Handle breakage_storage;
+
+    static const std::vector<std::size_t> &
+    LayerOffsets(const CandidateLists &candidates_list, std::vector<std::size_t> &offsets)
+    {
+        offsets.reserve(candidates_list.size() + 1);
+        offsets.push_back(0);
+        for (const auto &candidates : candidates_list)
         {
-            const auto &num_candidates = candidates_list[i].size();
-            // add empty vectors
-            if (num_candidates > 0)
-            {
-                viterbi[i].resize(num_candidates);
-                parents[i].resize(num_candidates);
-                path_distances[i].resize(num_candidates);
-                pruned[i].resize(num_candidates);
-            }
+            offsets.push_back(offsets.back() + candidates.size());
         }
+        return offsets;
+    }
+
+  public:
+    // pruned is a char instead of a bool, std::vector<bool> has no contiguous storage to point to
+    LayeredValues<double> viterbi;
+    LayeredValues<std::pair<unsigned, unsigned>> parents;
+    LayeredValues<float> path_distances;
+    LayeredValues<char> pruned;
+    // filled in by the caller before initialize
+    LayeredValues<double> emission_log_probabilities;
+    std::vector<bool> &breakage;
+
+    const CandidateLists &candidates_list;
 
-        Clear(0);
+    explicit HiddenMarkovModel(const CandidateLists &candidates_list)
+        : layer_offsets(ThreadLocalPool<std::vector<std::size_t>>::Acquire()),
+          breakage_storage(ThreadLocalPool<std::vector<bool>>::Acquire()),
+          viterbi(LayerOffsets(candidates_list, *layer_offsets), IMPOSSIBLE_LOG_PROB),
+          parents(*layer_offsets, std::make_pair(0u, 0u)), path_distances(*layer_offsets, 0),
+          pruned(*layer_offsets, true), emission_log_probabilities(*layer_offsets, 0),
+          breakage(*breakage_storage), candidates_list(candidates_list)
+    {
+        breakage.assign(candidates_list.size(), true);
     }
 
     void Clear(std::size_t initial_timestamp)
     {
-        BOOST_ASSERT(viterbi.size() == parents.size() && parents.size() == path_distances.size() &&
-                     path_distances.size() == pruned.size() && pruned.size() == breakage.size());
+        BOOST_ASSERT(viterbi.size() == breakage.size());
+        BOOST_ASSERT(initial_timestamp <= breakage.size());
 
-        for (const auto t : util::irange(initial_timestamp, viterbi.size()))
-        {
-            std::fill(viterbi[t].begin(), viterbi[t].end(), IMPOSSIBLE_LOG_PROB);
-            std::fill(parents[t].begin(), parents[t].end(), std::make_pair(0u, 0u));
-            std::fill(path_distances[t].begin(), path_distances[t].end(), 0);
-            std::fill(pruned[t].begin(), pruned[t].end(), true);
-        }
+        viterbi.Fill(initial_timestamp, IMPOSSIBLE_LOG_PROB);
+        parents.Fill(initial_timestamp, std::make_pair(0u, 0u));
+        path_distances.Fill(initial_timestamp, 0);
+        pruned.Fill(initial_timestamp, true);
         std::fill(breakage.begin() + initial_timestamp, breakage.end(), true);
     }
 
@@ -107,14 +159,17 @@ template <class CandidateLists> struct HiddenMarkovModel
         {
             BOOST_ASSERT(initial_timestamp < num_points);
 
-            for (const auto s : util::irange<std::size_t>(0UL, viterbi[initial_timestamp].size()))
+            auto initial_viterbi = viterbi[initial_timestamp];
+            auto initial_parents = parents[initial_timestamp];
+            auto initial_pruned = pruned[initial_timestamp];
+            const auto initial_emissions = emission_log_probabilities[initial_timestamp];
+            for (const auto s : util::irange<std::size_t>(0UL, initial_viterbi.size()))
             {
-                viterbi[initial_timestamp][s] = emission_log_probabilities[initial_timestamp][s];
-                parents[initial_timestamp][s] = std::make_pair(initial_timestamp, s);
-                pruned[initial_timestamp][s] = viterbi[initial_timestamp][s] < MINIMAL_LOG_PROB;
+                initial_viterbi[s] = initial_emissions[s];
+                initial_parents[s] = std::make_pair(initial_timestamp, s);
+                initial_pruned[s] = initial_viterbi[s] < MINIMAL_LOG_PROB;
 
-                breakage[initial_timestamp] =
-                    breakage[initial_timestamp] && pruned[initial_timestamp][s];
+                breakage[initial_timestamp] = breakage[initial_timestamp] && initial_pruned[s];
             }
 
             ++initial_timestamp;
@@ -0,0 +1,128 @@
+#ifndef MAP_MATCHING_MATCHING_SESSION_HPP
+#define MAP_MATCHING_MATCHING_SESSION_HPP
+
+#include "engine/phantom_node.hpp"
+#include "util/coordinate.hpp"
+
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace map_matching
+{
+
+// Index of the frontier layer in the sub matchings of a session request. It does not belong to
+// the request's coordinates but carries the matched location of the previous request.
+static const constexpr unsigned SESSION_FRONTIER_INDEX = std::numeric_limits<unsigned>::max();
+
+// The last unbroken layer of the Viterbi lattice of a matching session. New samples are
+// matched against it instead of against the whole trace matched so far.
+struct MatchingFrontier
+{
+    std::vector<PhantomNodeWithDistance> candidates;
+    // log probabilities, normalized so that the most likely candidate has 0
+    std::vector<double> viterbi;
+    util::Coordinate coordinate;
+    boost::optional<unsigned> timestamp;
+
+    bool IsValid() const { return !candidates.empty(); }
+};
+
+// Keeps the frontiers of the open matching sessions keyed by their token. Sessions that were
+// not used for longer than the timeout are dropped, if the store is full the least recently
+// used session is dropped.
+class MatchingSessions
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    MatchingSessions(const std::size_t max_sessions, const Clock::duration timeout)
+        : max_sessions(max_sessions), timeout(timeout)
+    {
+    }
+
+    // returns an invalid frontier for unknown or expired sessions
+    MatchingFrontier Get(const std::string &token)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto iter = sessions.find(token);
+        if (iter == sessions.end())
+        {
+            return {};
+        }
+        if (Clock::now() - iter->second.last_access > timeout)
+        {
+            sessions.erase(iter);
+            return {};
+        }
+        return iter->second.frontier;
+    }
+
+    void Store(const std::string &token, MatchingFrontier frontier)
+    {
+        const auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (sessions.size() >= max_sessions && sessions.find(token) == sessions.end())
+        {
+            for (auto iter = sessions.begin(); iter != sessions.end();)
+            {
+                if (now - iter->second.last_access > timeout)
+                    iter = sessions.erase(iter);
+                else
+                    ++iter;
+            }
+        }
+        if (!sessions.empty() && sessions.size() >= max_sessions &&
+            sessions.find(token) == sessions.end())
+        {
+            sessions.erase(std::min_element(sessions.begin(),
+                                            sessions.end(),
+                                            [](const SessionMap::value_type &lhs,
+                                               const SessionMap::value_type &rhs) {
+                                                return lhs.second.last_access <
+                                                       rhs.second.last_access;
+                                            }));
+        }
+
+        auto &session = sessions[token];
+        session.frontier = std::move(frontier);
+        session.last_access = now;
+    }
+
+    void Erase(const std::string &token)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sessions.erase(token);
+    }
+
+  private:
+    struct Session
+    {
+        MatchingFrontier frontier;
+        Clock::time_point last_access;
+    };
+    using SessionMap = std::unordered_map<std::string, Session>;
+
+    const std::size_t max_sessions;
+    const Clock::duration timeout;
+    std::mutex mutex;
+    SessionMap sessions;
+};
+}
+}
+}
+
+#endif // MAP_MATCHING_MATCHING_SESSION_HPP
@@ -0,0 +1,114 @@
+#ifndef MAP_MATCHING_TRACE_THINNING_HPP
+#define MAP_MATCHING_TRACE_THINNING_HPP
+
+#include "engine/api/match_parameters.hpp"
+#include "util/coordinate_calculation.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace map_matching
+{
+
+// Samples closer than this to the last kept sample hardly change the matching
+static const constexpr double THINNING_DISTANCE = 10.;
+// ... unless they were taken this many seconds after it, which keeps the timing of the trace
+static const constexpr unsigned THINNING_TIME = 5;
+
+// The samples of a trace that are matched instead of all of them
+struct ThinnedTrace
+{
+    // coordinates, timestamps, radiuses, bearings and hints of the kept samples
+    api::MatchParameters parameters;
+    // index of every kept sample in the original trace
+    std::vector<std::size_t> indices;
+    // median seconds between the samples of the original trace, 0 without timestamps. The
+    // trace is split at gaps relative to this instead of the longer gaps of the thinned trace.
+    unsigned sample_time = 0;
+};
+
+namespace detail
+{
+// Keeps the values at the given indices, traces without such values stay without them
+template <typename T>
+void KeepValues(std::vector<T> &values, const std::vector<std::size_t> &indices)
+{
+    if (values.empty())
+    {
+        return;
+    }
+    std::vector<T> kept_values;
+    kept_values.reserve(indices.size());
+    for (const auto index : indices)
+    {
+        kept_values.push_back(std::move(values[index]));
+    }
+    values = std::move(kept_values);
+}
+}
+
+// Drops the samples of high frequency traces that are within THINNING_DISTANCE of the last kept
+// sample and, if the trace has timestamps, less than THINNING_TIME seconds after it. Stationary
+// samples thus shrink to one every THINNING_TIME seconds. The first and the last sample are
+// always kept.
+inline ThinnedTrace ThinTrace(const api::MatchParameters &parameters)
+{
+    BOOST_ASSERT(parameters.IsValid());
+
+    ThinnedTrace thinned;
+    const auto &coordinates = parameters.coordinates;
+    const auto &timestamps = parameters.timestamps;
+    const bool use_timestamps = !timestamps.empty();
+
+    thinned.indices.push_back(0);
+    for (std::size_t index = 1; index < coordinates.size(); ++index)
+    {
+        const auto last_kept = thinned.indices.back();
+        const bool moved = util::coordinate_calculation::haversineDistance(
+                               coordinates[last_kept], coordinates[index]) >= THINNING_DISTANCE;
+        const bool elapsed =
+            use_timestamps && timestamps[index] - timestamps[last_kept] >= THINNING_TIME;
+        if (moved || elapsed || index + 1 == coordinates.size())
+        {
+            thinned.indices.push_back(index);
+        }
+    }
+
+    if (use_timestamps && timestamps.size() > 1)
+    {
+        std::vector<unsigned> sample_times(timestamps.size() - 1);
+        std::transform(timestamps.begin() + 1,
+                       timestamps.end(),
+                       timestamps.begin(),
+                       sample_times.begin(),
+                       [](const unsigned next, const unsigned previous) {
+                           return next - previous;
+                       });
+        const auto median = sample_times.begin() + sample_times.size() / 2;
+        std::nth_element(sample_times.begin(), median, sample_times.end());
+        thinned.sample_time = std::max(1u, *median);
+    }
+
+    // everything but the per sample values carries over
+    thinned.parameters = parameters;
+    detail::KeepValues(thinned.parameters.coordinates, thinned.indices);
+    detail::KeepValues(thinned.parameters.timestamps, thinned.indices);
+    detail::KeepValues(thinned.parameters.radiuses, thinned.indices);
+    detail::KeepValues(thinned.parameters.bearings, thinned.indices);
+    detail::KeepValues(thinned.parameters.hints, thinned.indices);
+
+    return thinned;
+}
+}
+}
+}
+
+#endif // MAP_MATCHING_TRACE_THINNING_HPP
@@ -0,0 +1,99 @@
+#ifndef ENGINE_METRICS_HPP
+#define ENGINE_METRICS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace osrm
+{
+namespace engine
+{
+namespace metrics
+{
+
+enum class Service
+{
+    Route,
+    Table,
+    Nearest,
+    Trip,
+    Match,
+    Isochrone,
+    Tile,
+    Other
+};
+static const constexpr std::size_t NUM_SERVICES = static_cast<std::size_t>(Service::Other) + 1;
+
+enum class Stage
+{
+    Parse,
+    Snapping,
+    Search,
+    Unpacking,
+    Guidance,
+    Rendering,
+    Compression
+};
+static const constexpr std::size_t NUM_STAGES = static_cast<std::size_t>(Stage::Compression) + 1;
+
+// Collects the timings and search counters of the request the calling thread handles while the
+// scope lives. They are added to the metrics of the thread when the scope ends, requests that
+// never got a service (e.g. malformed URLs or /metrics itself) are dropped. Without a scope all
+// timers and counters are no-ops, so library users of libosrm pay nothing.
+class RequestScope
+{
+  public:
+    RequestScope();
+    ~RequestScope();
+
+    RequestScope(const RequestScope &) = delete;
+    RequestScope &operator=(const RequestScope &) = delete;
+};
+
+// Attributes the request of the calling thread to the service of the given URL name
+void SetService(const std::string &name);
+
+// Remembers the URL of the request of the calling thread for the query log, if there is one
+void SetURL(const std::string &url);
+
+// Appends a line of JSON to the file at path for every request of a service that takes at least
+// slow_query_threshold, and for a sample_rate fraction of the faster ones: its URL, service,
+// duration, the time of each stage and its search counters. The URLs can be replayed, e.g. with
+// osrm-routed --warm-up-requests. Has to be called before any request is handled. Throws
+// util::exception if the file can not be opened.
+void UseQueryLog(const std::string &path,
+                 const std::chrono::milliseconds slow_query_threshold,
+                 const double sample_rate);
+
+// Times a stage of the current request. Stages nest: the time of an inner stage (e.g. unpacking
+// inside of a search) is only counted for the inner one.
+class StageTimer
+{
+  public:
+    explicit StageTimer(const Stage stage);
+    ~StageTimer();
+
+    StageTimer(const StageTimer &) = delete;
+    StageTimer &operator=(const StageTimer &) = delete;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    const Stage stage;
+    StageTimer *const parent;
+    Clock::time_point start;
+    Clock::duration nested;
+    const bool active;
+};
+
+// Adds a finished search on a query heap to the current request
+void CountSearch(const std::size_t inserted_nodes, const std::size_t settled_nodes);
+
+// All metrics in the Prometheus text exposition format (version 0.0.4)
+std::string RenderPrometheus();
+}
+}
+}
+
+#endif // ENGINE_METRICS_HPP
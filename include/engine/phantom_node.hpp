@@ -167,6 +167,21 @@ static_assert(sizeof(PhantomNode) == 60, "PhantomNode has more padding then expe
 
 using PhantomNodePair = std::pair<PhantomNode, PhantomNode>;
 
+// The fields of a phantom node a search starts from. Tables run many searches per phantom node,
+// they derive these once and keep them in a compact array instead of reading full phantom nodes.
+struct SearchPhantomNode
+{
+    SegmentID forward_segment_id;
+    SegmentID reverse_segment_id;
+    // INVALID_EDGE_WEIGHT if the direction is not enabled
+    EdgeWeight forward_weight_plus_offset;
+    EdgeWeight reverse_weight_plus_offset;
+    // see ManyToManyRouting::GetPhantomLengthFromMiddle, 0 if no lengths are needed
+    EdgeLength length_from_middle;
+};
+
+static_assert(sizeof(SearchPhantomNode) == 20, "SearchPhantomNode has more padding then expected");
+
 struct PhantomNodeWithDistance
 {
     PhantomNode phantom_node;
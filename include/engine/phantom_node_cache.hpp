@@ -0,0 +1,120 @@
+#ifndef ENGINE_PHANTOM_NODE_CACHE_HPP
+#define ENGINE_PHANTOM_NODE_CACHE_HPP
+
+#include "engine/bearing.hpp"
+#include "engine/phantom_node.hpp"
+
+#include "util/coordinate.hpp"
+#include "util/lru_cache.hpp"
+#include "util/make_unique.hpp"
+#include "util/std_hash.hpp"
+
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+/**
+ * Bounded cache of snapping results, shared by all plugins of one dataset generation.
+ *
+ * Coordinates are already fixed point with a precision of 1e-6 degree, requests for the
+ * same location therefore map to the same key without further quantization. Bearing and
+ * radius take part in the key as they change the snapping result.
+ *
+ * The cache is split into independently locked shards so that concurrent queries rarely
+ * contend on the same mutex.
+ */
+class PhantomNodeCache
+{
+  public:
+    struct Key
+    {
+        std::int32_t lon;
+        std::int32_t lat;
+        // negative if not set
+        short bearing;
+        short range;
+        double radius;
+
+        bool operator==(const Key &other) const
+        {
+            return lon == other.lon && lat == other.lat && bearing == other.bearing &&
+                   range == other.range && radius == other.radius;
+        }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const
+        {
+            return hash_val(key.lon, key.lat, key.bearing, key.range, key.radius);
+        }
+    };
+
+    explicit PhantomNodeCache(const std::size_t capacity)
+    {
+        const auto shard_capacity = std::max<std::size_t>(1, capacity / NUMBER_OF_SHARDS);
+        shards.reserve(NUMBER_OF_SHARDS);
+        for (std::size_t i = 0; i < NUMBER_OF_SHARDS; ++i)
+        {
+            shards.push_back(util::make_unique<Shard>(shard_capacity));
+        }
+    }
+
+    static Key MakeKey(const util::Coordinate coordinate,
+                       const boost::optional<Bearing> &bearing,
+                       const boost::optional<double> &radius)
+    {
+        return Key{static_cast<std::int32_t>(coordinate.lon),
+                   static_cast<std::int32_t>(coordinate.lat),
+                   bearing ? bearing->bearing : static_cast<short>(-1),
+                   bearing ? bearing->range : static_cast<short>(-1),
+                   radius ? *radius : -1.};
+    }
+
+    boost::optional<PhantomNodePair> Get(const Key &key)
+    {
+        auto &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (const auto cached = shard.cache.Get(key))
+        {
+            return *cached;
+        }
+        return boost::none;
+    }
+
+    void Put(const Key &key, const PhantomNodePair &phantom_nodes)
+    {
+        auto &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.cache.Put(key, phantom_nodes);
+    }
+
+  private:
+    static const constexpr std::size_t NUMBER_OF_SHARDS = 8;
+
+    struct Shard
+    {
+        explicit Shard(const std::size_t capacity) : cache(capacity) {}
+
+        std::mutex mutex;
+        util::LRUCache<Key, PhantomNodePair, KeyHash> cache;
+    };
+
+    Shard &GetShard(const Key &key) { return *shards[KeyHash()(key) % NUMBER_OF_SHARDS]; }
+
+    std::vector<std::unique_ptr<Shard>> shards;
+};
+}
+}
+
+#endif // ENGINE_PHANTOM_NODE_CACHE_HPP
@@ -0,0 +1,34 @@
+#ifndef ISOCHRONE_HPP
+#define ISOCHRONE_HPP
+
+#include "engine/api/isochrone_parameters.hpp"
+#include "engine/plugins/plugin_base.hpp"
+#include "engine/routing_algorithms/facade_routing.hpp"
+#include "engine/routing_algorithms/isochrone.hpp"
+#include "engine/search_engine_data.hpp"
+#include "osrm/json_container.hpp"
+
+namespace osrm
+{
+namespace engine
+{
+namespace plugins
+{
+
+class IsochronePlugin final : public BasePlugin
+{
+  private:
+    SearchEngineData heaps;
+    routing_algorithms::FacadeRouting<routing_algorithms::IsochroneRouting> isochrone;
+    const int max_duration_isochrone;
+
+  public:
+    explicit IsochronePlugin(datafacade::BaseDataFacade &facade, const int max_duration_isochrone);
+
+    Status HandleRequest(const api::IsochroneParameters &params, util::json::Object &result);
+};
+}
+}
+}
+
+#endif /* ISOCHRONE_HPP */
@@ -5,10 +5,14 @@
 #include "engine/plugins/plugin_base.hpp"
 
 #include "engine/map_matching/bayes_classifier.hpp"
+#include "engine/map_matching/matching_session.hpp"
+#include "engine/routing_algorithms/facade_routing.hpp"
 #include "engine/routing_algorithms/map_matching.hpp"
 #include "engine/routing_algorithms/shortest_path.hpp"
 #include "util/json_util.hpp"
 
+#include <chrono>
+#include <cstddef>
 #include <vector>
 
 namespace osrm
@@ -26,20 +30,42 @@ class MatchPlugin : public BasePlugin
     using CandidateLists = routing_algorithms::CandidateLists;
     static const constexpr double DEFAULT_GPS_PRECISION = 5;
     static const constexpr double RADIUS_MULTIPLIER = 3;
+    static const constexpr std::size_t MAX_MATCHING_SESSIONS = 10000;
+    static const constexpr int MATCHING_SESSION_TIMEOUT_SECONDS = 300;
 
-    MatchPlugin(datafacade::BaseDataFacade &facade_, const int max_locations_map_matching)
-        : BasePlugin(facade_), map_matching(&facade_, heaps, DEFAULT_GPS_PRECISION),
-          shortest_path(&facade_, heaps), max_locations_map_matching(max_locations_map_matching)
+    // beam_width and beam_range limit the states the Viterbi search expands, see MapMatching
+    MatchPlugin(datafacade::BaseDataFacade &facade_,
+                const int max_locations_map_matching,
+                const std::size_t beam_width = 0,
+                const double beam_range = 0)
+        : BasePlugin(facade_),
+          map_matching(&facade_, heaps, double{DEFAULT_GPS_PRECISION}, beam_width, beam_range),
+          shortest_path(&facade_, heaps), max_locations_map_matching(max_locations_map_matching),
+          sessions(MAX_MATCHING_SESSIONS, std::chrono::seconds(MATCHING_SESSION_TIMEOUT_SECONDS))
     {
     }
 
+    void UseUnpackingCache(UnpackingCache *cache)
+    {
+        map_matching.UseUnpackingCache(cache);
+        shortest_path.UseUnpackingCache(cache);
+    }
+
+    void UseCoreLandmarks(const CoreLandmarks *landmarks)
+    {
+        map_matching.UseCoreLandmarks(landmarks);
+        shortest_path.UseCoreLandmarks(landmarks);
+    }
+
     Status HandleRequest(const api::MatchParameters &parameters, util::json::Object &json_result);
 
   private:
     SearchEngineData heaps;
-    routing_algorithms::MapMatching<datafacade::BaseDataFacade> map_matching;
-    routing_algorithms::ShortestPathRouting<datafacade::BaseDataFacade> shortest_path;
+    routing_algorithms::FacadeRouting<routing_algorithms::MapMatching> map_matching;
+    routing_algorithms::FacadeRouting<routing_algorithms::ShortestPathRouting> shortest_path;
     int max_locations_map_matching;
+    // Viterbi frontiers of the open matching sessions
+    map_matching::MatchingSessions sessions;
 };
 }
 }
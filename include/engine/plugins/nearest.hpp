@@ -5,6 +5,8 @@
 #include "engine/plugins/plugin_base.hpp"
 #include "osrm/json_container.hpp"
 
+#include <vector>
+
 namespace osrm
 {
 namespace engine
@@ -15,9 +17,17 @@ namespace plugins
 class NearestPlugin final : public BasePlugin
 {
   public:
-    explicit NearestPlugin(datafacade::BaseDataFacade &facade);
+    explicit NearestPlugin(datafacade::BaseDataFacade &facade, const int max_locations_nearest);
 
     Status HandleRequest(const api::NearestParameters &params, util::json::Object &result);
+    // Renders the response directly into result, skipping the json::Object
+    Status HandleRequest(const api::NearestParameters &params, std::vector<char> &result);
+
+  private:
+    template <typename ResultT>
+    Status HandleNearestRequest(const api::NearestParameters &params, ResultT &result);
+
+    int max_locations_nearest;
 };
 }
 }
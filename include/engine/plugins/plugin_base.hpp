@@ -3,17 +3,23 @@
 
 #include "engine/api/base_parameters.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
+#include "engine/hint.hpp"
+#include "engine/metrics.hpp"
 #include "engine/phantom_node.hpp"
+#include "engine/phantom_node_cache.hpp"
 #include "engine/status.hpp"
+#include "engine/time_slot.hpp"
 
 #include "util/coordinate.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/integer_range.hpp"
 #include "util/json_container.hpp"
+#include "util/json_writer.hpp"
 
 #include <algorithm>
 #include <iterator>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace osrm
@@ -23,10 +29,19 @@ namespace engine
 namespace plugins
 {
 
+// Phantom nodes of unconstrained coordinates, snapped for a whole batch of queries up front
+using SnappedCoordinates =
+    std::unordered_map<PhantomNodeCache::Key, PhantomNodePair, PhantomNodeCache::KeyHash>;
+
 class BasePlugin
 {
+  public:
+    // Snapping results are looked up in and added to the cache, it has to outlive the plugin
+    void UsePhantomNodeCache(PhantomNodeCache *cache) { phantom_node_cache = cache; }
+
   protected:
     datafacade::BaseDataFacade &facade;
+    PhantomNodeCache *phantom_node_cache = nullptr;
     BasePlugin(datafacade::BaseDataFacade &facade_) : facade(facade_) {}
 
     bool CheckAllCoordinates(const std::vector<util::Coordinate> &coordinates)
@@ -46,6 +61,20 @@ class BasePlugin
         return Status::Error;
     }
 
+    Status Error(const std::string &code,
+                 const std::string &message,
+                 std::vector<char> &rendered_result) const
+    {
+        util::json::Writer writer(rendered_result);
+        writer.StartObject();
+        writer.Key("code");
+        writer.String(code);
+        writer.Key("message");
+        writer.String(message);
+        writer.EndObject();
+        return Status::Error;
+    }
+
     // Decides whether to use the phantom node from a big or small component if both are found.
     // Returns true if all phantom nodes are in the same component after snapping.
     std::vector<PhantomNode>
@@ -114,22 +143,24 @@ class BasePlugin
     GetPhantomNodesInRange(const api::BaseParameters &parameters,
                            const std::vector<double> radiuses) const
     {
+        metrics::StageTimer timer(metrics::Stage::Snapping);
+
         std::vector<std::vector<PhantomNodeWithDistance>> phantom_nodes(
             parameters.coordinates.size());
         BOOST_ASSERT(radiuses.size() == parameters.coordinates.size());
 
         const bool use_hints = !parameters.hints.empty();
         const bool use_bearings = !parameters.bearings.empty();
+        const auto hinted_phantoms = GetHintedPhantomNodes(parameters, use_hints);
 
         for (const auto i : util::irange<std::size_t>(0UL, parameters.coordinates.size()))
         {
-            if (use_hints && parameters.hints[i] &&
-                parameters.hints[i]->IsValid(parameters.coordinates[i], facade))
+            if (use_hints && hinted_phantoms[i])
             {
                 phantom_nodes[i].push_back(PhantomNodeWithDistance{
-                    parameters.hints[i]->phantom,
-                    util::coordinate_calculation::haversineDistance(
-                        parameters.coordinates[i], parameters.hints[i]->phantom.location),
+                    *hinted_phantoms[i],
+                    util::coordinate_calculation::haversineDistance(parameters.coordinates[i],
+                                                                    hinted_phantoms[i]->location),
                 });
                 continue;
             }
@@ -154,135 +185,204 @@ class BasePlugin
     std::vector<std::vector<PhantomNodeWithDistance>>
     GetPhantomNodes(const api::BaseParameters &parameters, unsigned number_of_results)
     {
+        metrics::StageTimer timer(metrics::Stage::Snapping);
+
         std::vector<std::vector<PhantomNodeWithDistance>> phantom_nodes(
             parameters.coordinates.size());
 
         const bool use_hints = !parameters.hints.empty();
         const bool use_bearings = !parameters.bearings.empty();
         const bool use_radiuses = !parameters.radiuses.empty();
+        const auto hinted_phantoms = GetHintedPhantomNodes(parameters, use_hints);
+
+        // all coordinates without a hint are snapped in one batched r-tree query
+        std::vector<std::size_t> batch_indices;
+        std::vector<util::Coordinate> batch_coordinates;
+        std::vector<boost::optional<double>> batch_radiuses;
+        std::vector<boost::optional<Bearing>> batch_bearings;
 
         BOOST_ASSERT(parameters.IsValid());
         for (const auto i : util::irange<std::size_t>(0UL, parameters.coordinates.size()))
         {
-            if (use_hints && parameters.hints[i] &&
-                parameters.hints[i]->IsValid(parameters.coordinates[i], facade))
+            if (use_hints && hinted_phantoms[i])
             {
                 phantom_nodes[i].push_back(PhantomNodeWithDistance{
-                    parameters.hints[i]->phantom,
-                    util::coordinate_calculation::haversineDistance(
-                        parameters.coordinates[i], parameters.hints[i]->phantom.location),
+                    *hinted_phantoms[i],
+                    util::coordinate_calculation::haversineDistance(parameters.coordinates[i],
+                                                                    hinted_phantoms[i]->location),
                 });
                 continue;
             }
 
-            if (use_bearings && parameters.bearings[i])
+            batch_indices.push_back(i);
+            batch_coordinates.push_back(parameters.coordinates[i]);
+            if (use_radiuses)
             {
-                if (use_radiuses && parameters.radiuses[i])
-                {
-                    phantom_nodes[i] = facade.NearestPhantomNodes(parameters.coordinates[i],
-                                                                  number_of_results,
-                                                                  *parameters.radiuses[i],
-                                                                  parameters.bearings[i]->bearing,
-                                                                  parameters.bearings[i]->range);
-                }
-                else
-                {
-                    phantom_nodes[i] = facade.NearestPhantomNodes(parameters.coordinates[i],
-                                                                  number_of_results,
-                                                                  parameters.bearings[i]->bearing,
-                                                                  parameters.bearings[i]->range);
-                }
+                batch_radiuses.push_back(parameters.radiuses[i]);
             }
-            else
+            if (use_bearings)
             {
-                if (use_radiuses && parameters.radiuses[i])
-                {
-                    phantom_nodes[i] = facade.NearestPhantomNodes(
-                        parameters.coordinates[i], number_of_results, *parameters.radiuses[i]);
-                }
-                else
-                {
-                    phantom_nodes[i] =
-                        facade.NearestPhantomNodes(parameters.coordinates[i], number_of_results);
-                }
+                batch_bearings.push_back(parameters.bearings[i]);
             }
+        }
 
-            // we didn't find a fitting node, return error
-            if (phantom_nodes[i].empty())
+        if (!batch_coordinates.empty())
+        {
+            auto batch_phantom_nodes = facade.NearestPhantomNodes(
+                batch_coordinates, number_of_results, batch_radiuses, batch_bearings);
+            BOOST_ASSERT(batch_phantom_nodes.size() == batch_indices.size());
+            for (const auto j : util::irange<std::size_t>(0UL, batch_indices.size()))
             {
-                break;
+                phantom_nodes[batch_indices[j]] = std::move(batch_phantom_nodes[j]);
             }
         }
         return phantom_nodes;
     }
 
-    std::vector<PhantomNodePair> GetPhantomNodes(const api::BaseParameters &parameters)
+    std::vector<PhantomNodePair> GetPhantomNodes(const api::BaseParameters &parameters,
+                                                 const SnappedCoordinates *snapped = nullptr)
     {
+        metrics::StageTimer timer(metrics::Stage::Snapping);
+
         std::vector<PhantomNodePair> phantom_node_pairs(parameters.coordinates.size());
 
-        const bool use_hints = !parameters.hints.empty();
+        // hints and cached phantom nodes carry the weights of the dataset, not of a time slot
+        const bool use_dataset_weights = ActiveTimeSlot() == INVALID_TIME_SLOT;
+        const bool use_hints = !parameters.hints.empty() && use_dataset_weights;
         const bool use_bearings = !parameters.bearings.empty();
         const bool use_radiuses = !parameters.radiuses.empty();
+        const bool use_phantom_node_cache = phantom_node_cache && use_dataset_weights;
+        const auto hinted_phantoms = GetHintedPhantomNodes(parameters, use_hints);
+
+        // unconstrained coordinates are snapped together in one batched r-tree query
+        std::vector<std::size_t> batch_indices;
+        std::vector<util::Coordinate> batch_coordinates;
 
         BOOST_ASSERT(parameters.IsValid());
         for (const auto i : util::irange<std::size_t>(0UL, parameters.coordinates.size()))
         {
-            if (use_hints && parameters.hints[i] &&
-                parameters.hints[i]->IsValid(parameters.coordinates[i], facade))
+            if (use_hints && hinted_phantoms[i])
             {
-                phantom_node_pairs[i].first = parameters.hints[i]->phantom;
+                phantom_node_pairs[i].first = *hinted_phantoms[i];
                 // we don't set the second one - it will be marked as invalid
                 continue;
             }
 
-            if (use_bearings && parameters.bearings[i])
+            const boost::optional<Bearing> no_bearing;
+            const boost::optional<double> no_radius;
+            const auto &bearing = use_bearings ? parameters.bearings[i] : no_bearing;
+            const auto &radius = use_radiuses ? parameters.radiuses[i] : no_radius;
+
+            const auto key = PhantomNodeCache::MakeKey(parameters.coordinates[i], bearing, radius);
+            if (use_phantom_node_cache)
             {
-                if (use_radiuses && parameters.radiuses[i])
-                {
-                    phantom_node_pairs[i] =
-                        facade.NearestPhantomNodeWithAlternativeFromBigComponent(
-                            parameters.coordinates[i],
-                            *parameters.radiuses[i],
-                            parameters.bearings[i]->bearing,
-                            parameters.bearings[i]->range);
-                }
-                else
+                if (const auto cached = phantom_node_cache->Get(key))
                 {
-                    phantom_node_pairs[i] =
-                        facade.NearestPhantomNodeWithAlternativeFromBigComponent(
-                            parameters.coordinates[i],
-                            parameters.bearings[i]->bearing,
-                            parameters.bearings[i]->range);
+                    phantom_node_pairs[i] = *cached;
+                    continue;
                 }
             }
-            else
+
+            // batches are only snapped with the weights of the dataset
+            if (snapped && use_dataset_weights)
             {
-                if (use_radiuses && parameters.radiuses[i])
+                const auto snapped_pair = snapped->find(key);
+                if (snapped_pair != snapped->end())
                 {
-                    phantom_node_pairs[i] =
-                        facade.NearestPhantomNodeWithAlternativeFromBigComponent(
-                            parameters.coordinates[i], *parameters.radiuses[i]);
-                }
-                else
-                {
-                    phantom_node_pairs[i] =
-                        facade.NearestPhantomNodeWithAlternativeFromBigComponent(
-                            parameters.coordinates[i]);
+                    phantom_node_pairs[i] = snapped_pair->second;
+                    if (!CheckPhantomNodePair(phantom_node_pairs[i], key))
+                    {
+                        phantom_node_pairs.pop_back();
+                        return phantom_node_pairs;
+                    }
+                    continue;
                 }
             }
 
-            // we didn't find a fitting node, return error
-            if (!phantom_node_pairs[i].first.IsValid(facade.GetNumberOfNodes()))
+            if (!bearing && !radius)
+            {
+                batch_indices.push_back(i);
+                batch_coordinates.push_back(parameters.coordinates[i]);
+                continue;
+            }
+
+            phantom_node_pairs[i] =
+                NearestPhantomNodePair(parameters.coordinates[i], bearing, radius);
+            if (!CheckPhantomNodePair(phantom_node_pairs[i], key))
             {
                 // TODO document why?
                 phantom_node_pairs.pop_back();
-                break;
+                return phantom_node_pairs;
+            }
+        }
+
+        if (!batch_coordinates.empty())
+        {
+            const auto batch_pairs =
+                facade.NearestPhantomNodesWithAlternativeFromBigComponent(batch_coordinates);
+            BOOST_ASSERT(batch_pairs.size() == batch_indices.size());
+            for (const auto j : util::irange<std::size_t>(0UL, batch_indices.size()))
+            {
+                const auto i = batch_indices[j];
+                phantom_node_pairs[i] = batch_pairs[j];
+                if (!CheckPhantomNodePair(
+                        phantom_node_pairs[i],
+                        PhantomNodeCache::MakeKey(parameters.coordinates[i], boost::none, boost::none)))
+                {
+                    phantom_node_pairs.pop_back();
+                    break;
+                }
             }
-            BOOST_ASSERT(phantom_node_pairs[i].first.IsValid(facade.GetNumberOfNodes()));
-            BOOST_ASSERT(phantom_node_pairs[i].second.IsValid(facade.GetNumberOfNodes()));
         }
         return phantom_node_pairs;
     }
+
+  private:
+    std::vector<boost::optional<PhantomNode>>
+    GetHintedPhantomNodes(const api::BaseParameters &parameters, const bool use_hints) const
+    {
+        if (!use_hints)
+            return {};
+        return getHintedPhantomNodes(parameters.hints, parameters.coordinates, facade);
+    }
+
+    // Returns false if no fitting node was found, otherwise remembers the pair in the cache
+    bool CheckPhantomNodePair(const PhantomNodePair &phantom_node_pair,
+                              const PhantomNodeCache::Key &key) const
+    {
+        if (!phantom_node_pair.first.IsValid(facade.GetNumberOfNodes()))
+        {
+            return false;
+        }
+        BOOST_ASSERT(phantom_node_pair.second.IsValid(facade.GetNumberOfNodes()));
+
+        if (phantom_node_cache && ActiveTimeSlot() == INVALID_TIME_SLOT)
+        {
+            phantom_node_cache->Put(key, phantom_node_pair);
+        }
+        return true;
+    }
+
+    PhantomNodePair NearestPhantomNodePair(const util::Coordinate coordinate,
+                                           const boost::optional<Bearing> &bearing,
+                                           const boost::optional<double> &radius) const
+    {
+        if (bearing)
+        {
+            if (radius)
+            {
+                return facade.NearestPhantomNodeWithAlternativeFromBigComponent(
+                    coordinate, *radius, bearing->bearing, bearing->range);
+            }
+            return facade.NearestPhantomNodeWithAlternativeFromBigComponent(
+                coordinate, bearing->bearing, bearing->range);
+        }
+        if (radius)
+        {
+            return facade.NearestPhantomNodeWithAlternativeFromBigComponent(coordinate, *radius);
+        }
+        return facade.NearestPhantomNodeWithAlternativeFromBigComponent(coordinate);
+    }
 };
 }
 }
@@ -3,10 +3,21 @@
 
 #include "engine/plugins/plugin_base.hpp"
 
+#include "engine/api/table_api.hpp"
 #include "engine/api/table_parameters.hpp"
+#include "engine/routing_algorithms/facade_routing.hpp"
 #include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/search_engine_data.hpp"
+#include "engine/table_peers.hpp"
 #include "util/json_container.hpp"
+#include "util/lru_cache.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -18,15 +29,80 @@ namespace plugins
 class TablePlugin final : public BasePlugin
 {
   public:
+    // registered target sets beyond this drop the least recently used one
+    static const constexpr std::size_t MAX_TARGET_SETS = 64;
+
     explicit TablePlugin(datafacade::BaseDataFacade &facade,
-                         const int max_locations_distance_table);
+                         const int max_locations_distance_table,
+                         const bool use_parallel_table = false);
 
     Status HandleRequest(const api::TableParameters &params, util::json::Object &result);
+    // Renders the response directly into result, skipping the json::Object. Errors are
+    // always rendered as JSON, successful responses in the requested output format.
+    Status HandleRequest(const api::TableParameters &params, std::vector<char> &result);
+
+    // Receives rendered bytes of a response, e.g. to send them while the rest is rendered
+    using ChunkHandler = std::function<void(std::vector<char> &rendered)>;
+    // Tables that are computed in tiles hand their response to handle_chunk whenever at least
+    // RESPONSE_CHUNK_SIZE bytes are rendered and clear the buffer, the rest is left in result.
+    // Errors are detected before the first chunk, a response handed out in part is successful
+    // unless the query runs past its deadline.
+    Status HandleRequest(const api::TableParameters &params,
+                         std::vector<char> &result,
+                         const ChunkHandler &handle_chunk);
+
+    static const constexpr std::size_t RESPONSE_CHUNK_SIZE = 64 * 1024;
+
+    // Rendered responses of tables with at least TablePeers::MIN_DISTRIBUTED_ENTRIES entries
+    // split their sources among the peers and this plugin. The peers have to outlive the plugin.
+    void UseTablePeers(const TablePeers *peers) { table_peers = peers; }
 
   private:
+    template <typename ResultT>
+    Status HandleTableRequest(const api::TableParameters &params,
+                              ResultT &result,
+                              const ChunkHandler &handle_chunk);
+
+    // Runs the searches and renders the response. Rendered responses of tables larger than
+    // TiledTable::TILE_ENTRIES are computed in tiles and written block by block of rows, unless
+    // the destinations are prepared targets. JSON objects are never handed out in chunks.
+    Status MakeTable(const api::TableAPI &table_api,
+                     const std::vector<PhantomNode> &phantoms,
+                     const routing_algorithms::OneToManyTargets *prepared_targets,
+                     util::json::Object &result,
+                     const ChunkHandler &handle_chunk) const;
+    Status MakeTable(const api::TableAPI &table_api,
+                     const std::vector<PhantomNode> &phantoms,
+                     const routing_algorithms::OneToManyTargets *prepared_targets,
+                     std::vector<char> &result,
+                     const ChunkHandler &handle_chunk) const;
+
+    std::vector<EdgeWeight>
+    ComputeTable(const api::TableParameters &params,
+                 const std::vector<PhantomNode> &phantoms,
+                 const routing_algorithms::OneToManyTargets *prepared_targets,
+                 std::vector<EdgeLength> *length_table) const;
+
+    using TiledTable = routing_algorithms::ManyToManyRouting<datafacade::BaseDataFacade>;
+
     SearchEngineData heaps;
-    routing_algorithms::ManyToManyRouting<datafacade::BaseDataFacade> distance_table;
+    routing_algorithms::FacadeRouting<routing_algorithms::ManyToManyRouting> distance_table;
     int max_locations_distance_table;
+    const TablePeers *table_peers = nullptr;
+
+    // The destinations of a target set are snapped and prepared for the sweep once when the set
+    // is registered, tables against it only run the searches of their sources. A plugin only
+    // serves the dataset its facade was created for, so registered sets never outlive their data.
+    struct TargetSet
+    {
+        std::vector<util::Coordinate> coordinates;
+        std::vector<PhantomNode> phantoms;
+        // nullptr if the graph cannot be swept, the tables then run the bucket searches
+        std::shared_ptr<const routing_algorithms::OneToManyTargets> prepared;
+    };
+
+    std::mutex target_sets_mutex;
+    util::LRUCache<std::string, std::shared_ptr<const TargetSet>> target_sets;
 };
 }
 }
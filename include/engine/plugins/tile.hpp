@@ -4,7 +4,16 @@
 #include "engine/api/tile_parameters.hpp"
 #include "engine/plugins/plugin_base.hpp"
 
+#include "util/lru_cache.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <mutex>
 #include <string>
+#include <vector>
+
+#include <boost/assert.hpp>
 
 /*
  * This plugin generates Mapbox Vector tiles that show the internal
@@ -13,6 +22,14 @@
  * to display maps that show the exact road network that
  * OSRM is routing.  This is very useful for debugging routing
  * errors
+ *
+ * Encoded tiles are kept in a LRU cache. A plugin only ever serves the dataset
+ * generation its facade was created for, with shared memory a new generation
+ * comes with a new plugin, so cached tiles never outlive their data.
+ *
+ * Clients request neighboring tiles together. With a metatile size of n > 1 a
+ * cache miss encodes the whole aligned block of n x n tiles around the requested
+ * tile from a single box query and puts all of them into the cache.
  */
 namespace osrm
 {
@@ -24,9 +41,31 @@ namespace plugins
 class TilePlugin final : public BasePlugin
 {
   public:
-    TilePlugin(datafacade::BaseDataFacade &facade) : BasePlugin(facade) {}
+    TilePlugin(datafacade::BaseDataFacade &facade,
+               const std::size_t cache_size = 512,
+               const unsigned metatile_size = 1)
+        : BasePlugin(facade), cache_size(cache_size), metatile_size(metatile_size),
+          cache(cache_size)
+    {
+        BOOST_ASSERT(metatile_size > 0);
+    }
 
     Status HandleRequest(const api::TileParameters &parameters, std::string &pbf_buffer);
+
+  private:
+    // Encodes the size x size tiles at zoom z starting at min_x, min_y row by row
+    Status EncodeTiles(const unsigned z,
+                       const unsigned min_x,
+                       const unsigned min_y,
+                       const unsigned size,
+                       std::vector<std::string> &pbf_buffers);
+
+    const std::size_t cache_size;
+    const unsigned metatile_size;
+
+    std::mutex cache_mutex;
+    // keyed by z, x and y packed into an integer, see detail::tileKey
+    util::LRUCache<std::uint64_t, std::string> cache;
 };
 }
 }
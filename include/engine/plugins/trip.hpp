@@ -4,6 +4,7 @@
 #include "engine/plugins/plugin_base.hpp"
 
 #include "engine/api/trip_parameters.hpp"
+#include "engine/routing_algorithms/facade_routing.hpp"
 #include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/routing_algorithms/shortest_path.hpp"
 
@@ -12,6 +13,7 @@
 #include <boost/assert.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <iterator>
 #include <memory>
@@ -30,20 +32,30 @@ class TripPlugin final : public BasePlugin
 {
   private:
     SearchEngineData heaps;
-    routing_algorithms::ShortestPathRouting<datafacade::BaseDataFacade> shortest_path;
-    routing_algorithms::ManyToManyRouting<datafacade::BaseDataFacade> duration_table;
+    routing_algorithms::FacadeRouting<routing_algorithms::ShortestPathRouting> shortest_path;
+    routing_algorithms::FacadeRouting<routing_algorithms::ManyToManyRouting> duration_table;
     int max_locations_trip;
+    std::chrono::milliseconds max_optimization_time;
 
     InternalRouteResult ComputeRoute(const std::vector<PhantomNode> &phantom_node_list,
                                      const std::vector<NodeID> &trip);
 
   public:
-    explicit TripPlugin(datafacade::BaseDataFacade &facade_, const int max_locations_trip_)
+    explicit TripPlugin(datafacade::BaseDataFacade &facade_,
+                        const int max_locations_trip_,
+                        const std::chrono::milliseconds max_optimization_time_)
         : BasePlugin(facade_), shortest_path(&facade_, heaps), duration_table(&facade_, heaps),
-          max_locations_trip(max_locations_trip_)
+          max_locations_trip(max_locations_trip_), max_optimization_time(max_optimization_time_)
     {
     }
 
+    void UseUnpackingCache(UnpackingCache *cache) { shortest_path.UseUnpackingCache(cache); }
+
+    void UseCoreLandmarks(const CoreLandmarks *landmarks)
+    {
+        shortest_path.UseCoreLandmarks(landmarks);
+    }
+
     Status HandleRequest(const api::TripParameters &parameters, util::json::Object &json_result);
 };
 }
@@ -4,9 +4,13 @@
 #include "engine/api/route_api.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
 #include "engine/plugins/plugin_base.hpp"
+#include "engine/route_result_cache.hpp"
 
+#include "engine/routing_algorithms/facade_routing.hpp"
 #include "engine/routing_algorithms/alternative_path.hpp"
 #include "engine/routing_algorithms/direct_shortest_path.hpp"
+#include "engine/routing_algorithms/multi_level_dijkstra.hpp"
+#include "engine/routing_algorithms/penalty_alternative_path.hpp"
 #include "engine/routing_algorithms/shortest_path.hpp"
 #include "engine/search_engine_data.hpp"
 #include "util/json_container.hpp"
@@ -29,16 +33,56 @@ class ViaRoutePlugin final : public BasePlugin
 {
   private:
     SearchEngineData heaps;
-    routing_algorithms::ShortestPathRouting<datafacade::BaseDataFacade> shortest_path;
-    routing_algorithms::AlternativeRouting<datafacade::BaseDataFacade> alternative_path;
-    routing_algorithms::DirectShortestPathRouting<datafacade::BaseDataFacade> direct_shortest_path;
+    routing_algorithms::FacadeRouting<routing_algorithms::ShortestPathRouting> shortest_path;
+    routing_algorithms::FacadeRouting<routing_algorithms::AlternativeRouting> alternative_path;
+    routing_algorithms::FacadeRouting<routing_algorithms::PenaltyAlternativeRouting>
+        penalty_alternative_path;
+    routing_algorithms::FacadeRouting<routing_algorithms::DirectShortestPathRouting>
+        direct_shortest_path;
+    routing_algorithms::FacadeRouting<routing_algorithms::MultiLevelDijkstraRouting>
+        multi_level_dijkstra;
     int max_locations_viaroute;
+    bool use_multi_level_dijkstra;
+    bool use_parallel_route;
+    RouteResultCache *route_result_cache = nullptr;
 
   public:
-    explicit ViaRoutePlugin(datafacade::BaseDataFacade &facade, int max_locations_viaroute);
+    explicit ViaRoutePlugin(datafacade::BaseDataFacade &facade,
+                            int max_locations_viaroute,
+                            bool use_multi_level_dijkstra = false,
+                            std::size_t max_alternative_candidates = 0,
+                            bool use_parallel_route = false);
+
+    void UseUnpackingCache(UnpackingCache *cache)
+    {
+        shortest_path.UseUnpackingCache(cache);
+        alternative_path.UseUnpackingCache(cache);
+        penalty_alternative_path.UseUnpackingCache(cache);
+        direct_shortest_path.UseUnpackingCache(cache);
+    }
+
+    // single leg routes without alternatives reuse the unpacked path of earlier queries
+    // between the same snapped segments
+    void UseRouteResultCache(RouteResultCache *cache) { route_result_cache = cache; }
+
+    // alternative routes are not supported on a core
+    void UseCoreLandmarks(const CoreLandmarks *landmarks)
+    {
+        shortest_path.UseCoreLandmarks(landmarks);
+        direct_shortest_path.UseCoreLandmarks(landmarks);
+    }
 
     Status HandleRequest(const api::RouteParameters &route_parameters,
-                         util::json::Object &json_result);
+                         util::json::Object &json_result,
+                         const SnappedCoordinates *snapped = nullptr);
+
+    // Answers a batch of queries in parallel, the result and status of a query have its index.
+    // The coordinates of the batch are snapped together and the queries run in the order of
+    // their first coordinate on the hilbert curve, so consecutive searches of a thread touch
+    // nearby parts of the graph with its warm heaps.
+    void HandleBatch(const std::vector<api::RouteParameters> &route_parameters,
+                     std::vector<util::json::Object> &json_results,
+                     std::vector<Status> &statuses);
 };
 }
 }
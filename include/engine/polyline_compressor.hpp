@@ -12,19 +12,23 @@ namespace engine
 {
 namespace detail
 {
+// 5 decimal places, use POLYLINE6_PRECISION for the 6 decimal places of polyline6
 constexpr double POLYLINE_PRECISION = 1e5;
-constexpr double COORDINATE_TO_POLYLINE = POLYLINE_PRECISION / COORDINATE_PRECISION;
-constexpr double POLYLINE_TO_COORDINATE = COORDINATE_PRECISION / POLYLINE_PRECISION;
+constexpr double POLYLINE6_PRECISION = 1e6;
 }
 
 using CoordVectorForwardIter = std::vector<util::Coordinate>::const_iterator;
 // Encodes geometry into polyline format.
 // See: https://developers.google.com/maps/documentation/utilities/polylinealgorithm
-std::string encodePolyline(CoordVectorForwardIter begin, CoordVectorForwardIter end);
+// The characters are written in one pass into a single string, without intermediate buffers.
+std::string encodePolyline(CoordVectorForwardIter begin,
+                           CoordVectorForwardIter end,
+                           const double precision = detail::POLYLINE_PRECISION);
 
 // Decodes geometry from polyline format
 // See: https://developers.google.com/maps/documentation/utilities/polylinealgorithm
-std::vector<util::Coordinate> decodePolyline(const std::string &polyline);
+std::vector<util::Coordinate> decodePolyline(const std::string &polyline,
+                                             const double precision = detail::POLYLINE_PRECISION);
 }
 }
 
@@ -0,0 +1,81 @@
+#ifndef ENGINE_QUERY_DEADLINE_HPP
+#define ENGINE_QUERY_DEADLINE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Point in time after which the searches of a query give up, see EngineConfig::max_query_time
+struct QueryDeadline
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point expiry;
+};
+
+// Thrown out of the searches of a query that ran past its deadline
+class QueryTimeout final : public std::exception
+{
+  public:
+    const char *what() const noexcept override { return "Query ran past its deadline"; }
+};
+
+// Deadline of the query the calling thread runs, nullptr if it has none
+inline const QueryDeadline *&ActiveQueryDeadline()
+{
+    static thread_local const QueryDeadline *deadline = nullptr;
+    return deadline;
+}
+
+// Sets the deadline of the searches the calling thread runs in its lifetime. Searches running
+// in parallel for a query have to take the deadline of the query's thread along.
+class QueryDeadlineScope
+{
+  public:
+    explicit QueryDeadlineScope(const QueryDeadline *deadline)
+        : previous_deadline(ActiveQueryDeadline())
+    {
+        ActiveQueryDeadline() = deadline;
+    }
+
+    ~QueryDeadlineScope() { ActiveQueryDeadline() = previous_deadline; }
+
+    QueryDeadlineScope(const QueryDeadlineScope &) = delete;
+    QueryDeadlineScope &operator=(const QueryDeadlineScope &) = delete;
+
+  private:
+    const QueryDeadline *const previous_deadline;
+};
+
+// The searches call this for the nodes they settle, the clock is only read once per
+// DEADLINE_CHECK_INTERVAL settled nodes. Throws QueryTimeout if the deadline of the query passed.
+inline void CheckQueryDeadline(const std::size_t settled_nodes = 1)
+{
+    static const constexpr std::size_t DEADLINE_CHECK_INTERVAL = 1024;
+    static thread_local std::size_t unchecked_nodes = 0;
+
+    const auto *const deadline = ActiveQueryDeadline();
+    if (!deadline)
+    {
+        return;
+    }
+
+    unchecked_nodes += settled_nodes;
+    if (unchecked_nodes >= DEADLINE_CHECK_INTERVAL)
+    {
+        unchecked_nodes = 0;
+        if (QueryDeadline::Clock::now() >= deadline->expiry)
+        {
+            throw QueryTimeout();
+        }
+    }
+}
+}
+}
+
+#endif // ENGINE_QUERY_DEADLINE_HPP
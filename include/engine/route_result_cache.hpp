@@ -0,0 +1,199 @@
+#ifndef ENGINE_ROUTE_RESULT_CACHE_HPP
+#define ENGINE_ROUTE_RESULT_CACHE_HPP
+
+#include "engine/internal_route_result.hpp"
+#include "engine/phantom_node.hpp"
+
+#include "util/lru_cache.hpp"
+#include "util/make_unique.hpp"
+#include "util/std_hash.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+/**
+ * Bounded cache of unpacked single leg routes, shared by all queries of one dataset generation.
+ *
+ * Many coordinates snap to the same pair of segments, think of the entrances of a mall. The
+ * key therefore is the snapped segments of source and target, not the coordinates. The position
+ * of a phantom node on the compressed geometry of its segment buckets its offset: the unpacked
+ * path only depends on that position, the weights are rebased to the exact offsets of a hit.
+ * A hit can pick a different direction on the source or target segment than a fresh search,
+ * the result is longer by at most the weight of the geometry segment the phantom nodes lie on.
+ *
+ * Local paths, with source and target on the same segment, depend on the order of the offsets
+ * and are never cached.
+ *
+ * The cache is split into independently locked shards so that concurrent queries rarely
+ * contend on the same mutex.
+ */
+class RouteResultCache
+{
+  public:
+    struct Key
+    {
+        NodeID source_forward;
+        NodeID source_reverse;
+        NodeID target_forward;
+        NodeID target_reverse;
+        unsigned short source_position;
+        unsigned short target_position;
+        // enabled flags of the four segments
+        std::uint8_t enabled;
+        // weights of the dataset, a metric or a departure slot
+        unsigned time_slot;
+
+        bool operator==(const Key &other) const
+        {
+            return source_forward == other.source_forward &&
+                   source_reverse == other.source_reverse &&
+                   target_forward == other.target_forward &&
+                   target_reverse == other.target_reverse &&
+                   source_position == other.source_position &&
+                   target_position == other.target_position && enabled == other.enabled &&
+                   time_slot == other.time_slot;
+        }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const
+        {
+            return hash_val(key.source_forward,
+                            key.source_reverse,
+                            key.target_forward,
+                            key.target_reverse,
+                            key.source_position,
+                            key.target_position,
+                            key.enabled,
+                            key.time_slot);
+        }
+    };
+
+    explicit RouteResultCache(const std::size_t capacity)
+    {
+        const auto shard_capacity = std::max<std::size_t>(1, capacity / NUMBER_OF_SHARDS);
+        shards.reserve(NUMBER_OF_SHARDS);
+        for (std::size_t i = 0; i < NUMBER_OF_SHARDS; ++i)
+        {
+            shards.push_back(util::make_unique<Shard>(shard_capacity));
+        }
+    }
+
+    static bool IsCacheable(const PhantomNodes &phantoms)
+    {
+        return phantoms.source_phantom.forward_packed_geometry_id !=
+               phantoms.target_phantom.forward_packed_geometry_id;
+    }
+
+    static Key MakeKey(const PhantomNodes &phantoms, const unsigned time_slot)
+    {
+        const auto &source = phantoms.source_phantom;
+        const auto &target = phantoms.target_phantom;
+        return Key{source.forward_segment_id.id,
+                   source.reverse_segment_id.id,
+                   target.forward_segment_id.id,
+                   target.reverse_segment_id.id,
+                   source.fwd_segment_position,
+                   target.fwd_segment_position,
+                   static_cast<std::uint8_t>(source.forward_segment_id.enabled |
+                                             source.reverse_segment_id.enabled << 1 |
+                                             target.forward_segment_id.enabled << 2 |
+                                             target.reverse_segment_id.enabled << 3),
+                   time_slot};
+    }
+
+    // Returns the cached route rebased to the offsets of the phantom nodes
+    boost::optional<InternalRouteResult> Get(const Key &key, const PhantomNodes &phantoms)
+    {
+        auto &shard = GetShard(key);
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        const auto cached = shard.cache.Get(key);
+        if (!cached)
+        {
+            return boost::none;
+        }
+        InternalRouteResult route = *cached;
+        lock.unlock();
+
+        Rebase(phantoms, route);
+        return route;
+    }
+
+    void Put(const Key &key, const InternalRouteResult &route)
+    {
+        BOOST_ASSERT(route.is_valid() && route.segment_end_coordinates.size() == 1);
+        auto &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.cache.Put(key, route);
+    }
+
+  private:
+    static const constexpr std::size_t NUMBER_OF_SHARDS = 8;
+
+    struct Shard
+    {
+        explicit Shard(const std::size_t capacity) : cache(capacity) {}
+
+        std::mutex mutex;
+        util::LRUCache<Key, InternalRouteResult, KeyHash> cache;
+    };
+
+    // Moves the start and end of the route from the phantom nodes it was found for to the ones
+    // of the same bucket. Mirrors how the search and the unpacking account for the offsets.
+    static void Rebase(const PhantomNodes &phantoms, InternalRouteResult &route)
+    {
+        const auto &old_phantoms = route.segment_end_coordinates.front();
+        const bool source_in_reverse = route.source_traversed_in_reverse.front();
+        const bool target_in_reverse = route.target_traversed_in_reverse.front();
+
+        const auto source_weight = [source_in_reverse](const PhantomNode &phantom) {
+            return source_in_reverse ? phantom.GetReverseWeightPlusOffset()
+                                     : phantom.GetForwardWeightPlusOffset();
+        };
+        const auto target_weight = [target_in_reverse](const PhantomNode &phantom) {
+            return target_in_reverse ? phantom.GetReverseWeightPlusOffset()
+                                     : phantom.GetForwardWeightPlusOffset();
+        };
+        route.shortest_path_length +=
+            source_weight(old_phantoms.source_phantom) - source_weight(phantoms.source_phantom) +
+            target_weight(phantoms.target_phantom) - target_weight(old_phantoms.target_phantom);
+
+        // the unpacking subtracts the part of the first segment before the source
+        auto &unpacked_path = route.unpacked_path_segments.front();
+        if (!unpacked_path.empty())
+        {
+            const auto partial_weight = [source_in_reverse](const PhantomNode &phantom) {
+                return source_in_reverse ? phantom.reverse_weight : phantom.forward_weight;
+            };
+            unpacked_path.front().duration_until_turn =
+                std::max(unpacked_path.front().duration_until_turn +
+                             partial_weight(old_phantoms.source_phantom) -
+                             partial_weight(phantoms.source_phantom),
+                         0);
+        }
+
+        route.segment_end_coordinates.front() = phantoms;
+    }
+
+    Shard &GetShard(const Key &key) { return *shards[KeyHash()(key) % NUMBER_OF_SHARDS]; }
+
+    std::vector<std::unique_ptr<Shard>> shards;
+};
+}
+}
+
+#endif // ENGINE_ROUTE_RESULT_CACHE_HPP
@@ -45,6 +45,13 @@ class AlternativeRouting final
         int length;
         int sharing;
 
+        // the packed halves <s,..,v> and <v,..,t> of the via path and their meeting nodes, the
+        // T-test and the unpacking reuse them instead of searching from v again
+        std::vector<NodeID> packed_s_v_path;
+        std::vector<NodeID> packed_v_t_path;
+        NodeID s_v_middle = SPECIAL_NODEID;
+        NodeID v_t_middle = SPECIAL_NODEID;
+
         bool operator<(const RankedCandidateNode &other) const
         {
             return (2 * length + sharing) < (2 * other.length + other.sharing);
@@ -52,10 +59,17 @@ class AlternativeRouting final
     };
     DataFacadeT *facade;
     SearchEngineData &engine_working_data;
+    // 0 inspects all preselected via nodes, otherwise only the best ones by approximation
+    std::size_t max_inspected_candidates;
 
   public:
-    AlternativeRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
-        : super(facade), facade(facade), engine_working_data(engine_working_data)
+    using super::UseUnpackingCache;
+
+    AlternativeRouting(DataFacadeT *facade,
+                       SearchEngineData &engine_working_data,
+                       const std::size_t max_inspected_candidates = 0)
+        : super(facade), facade(facade), engine_working_data(engine_working_data),
+          max_inspected_candidates(max_inspected_candidates)
     {
     }
 
@@ -68,18 +82,13 @@ class AlternativeRouting final
         std::vector<SearchSpaceEdge> forward_search_space;
         std::vector<SearchSpaceEdge> reverse_search_space;
 
-        // Init queues, semi-expensive because access to TSS invokes a sys-call
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-        engine_working_data.InitializeOrClearSecondThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-        engine_working_data.InitializeOrClearThirdThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-
-        QueryHeap &forward_heap1 = *(engine_working_data.forward_heap_1);
-        QueryHeap &reverse_heap1 = *(engine_working_data.reverse_heap_1);
-        QueryHeap &forward_heap2 = *(engine_working_data.forward_heap_2);
-        QueryHeap &reverse_heap2 = *(engine_working_data.reverse_heap_2);
+        // the search spaces of these heaps are intersected with the via path searches below
+        auto forward_heap_handle =
+            engine_working_data.GetHeap<QueryHeap>(super::facade->GetNumberOfNodes());
+        auto reverse_heap_handle =
+            engine_working_data.GetHeap<QueryHeap>(super::facade->GetNumberOfNodes());
+        QueryHeap &forward_heap1 = *forward_heap_handle;
+        QueryHeap &reverse_heap1 = *reverse_heap_handle;
 
         int upper_bound_to_shortest_path_distance = INVALID_EDGE_WEIGHT;
         NodeID middle_node = SPECIAL_NODEID;
@@ -112,17 +121,17 @@ class AlternativeRouting final
         {
             BOOST_ASSERT(phantom_node_pair.target_phantom.forward_segment_id.id !=
                          SPECIAL_SEGMENTID);
-            reverse_heap1.Insert(phantom_node_pair.target_phantom.forward_segment_id.id,
-                                 phantom_node_pair.target_phantom.GetForwardWeightPlusOffset(),
-                                 phantom_node_pair.target_phantom.forward_segment_id.id);
+            super::InsertTargetNode(reverse_heap1,
+                                    phantom_node_pair.target_phantom.forward_segment_id.id,
+                                    phantom_node_pair.target_phantom.GetForwardWeightPlusOffset());
         }
         if (phantom_node_pair.target_phantom.reverse_segment_id.enabled)
         {
             BOOST_ASSERT(phantom_node_pair.target_phantom.reverse_segment_id.id !=
                          SPECIAL_SEGMENTID);
-            reverse_heap1.Insert(phantom_node_pair.target_phantom.reverse_segment_id.id,
-                                 phantom_node_pair.target_phantom.GetReverseWeightPlusOffset(),
-                                 phantom_node_pair.target_phantom.reverse_segment_id.id);
+            super::InsertTargetNode(reverse_heap1,
+                                    phantom_node_pair.target_phantom.reverse_segment_id.id,
+                                    phantom_node_pair.target_phantom.GetReverseWeightPlusOffset());
         }
 
         // search from s and t till new_min/(1+epsilon) > length_of_shortest_path
@@ -242,7 +251,7 @@ class AlternativeRouting final
         // reverse_search_space.size() << ", marked " << approximated_reverse_sharing.size() << "
         // nodes";
 
-        std::vector<NodeID> preselected_node_list;
+        std::vector<RankedCandidateNode> preselected_node_list;
         for (const NodeID node : via_node_candidate_list)
         {
             if (node == middle_node)
@@ -268,10 +277,18 @@ class AlternativeRouting final
 
             if (length_passes && sharing_passes && stretch_passes)
             {
-                preselected_node_list.emplace_back(node);
+                preselected_node_list.emplace_back(node, approximated_length, approximated_sharing);
             }
         }
 
+        // early termination: only the most promising nodes are inspected in depth
+        if (max_inspected_candidates > 0 && preselected_node_list.size() > max_inspected_candidates)
+        {
+            std::stable_sort(preselected_node_list.begin(), preselected_node_list.end());
+            preselected_node_list.erase(preselected_node_list.begin() + max_inspected_candidates,
+                                        preselected_node_list.end());
+        }
+
         std::vector<NodeID> &packed_shortest_path = packed_forward_path;
         if (!path_is_a_loop)
         {
@@ -283,42 +300,36 @@ class AlternativeRouting final
         std::vector<RankedCandidateNode> ranked_candidates_list;
 
         // prioritizing via nodes for deep inspection
-        for (const NodeID node : preselected_node_list)
-        {
-            int length_of_via_path = 0, sharing_of_via_path = 0;
-            ComputeLengthAndSharingOfViaPath(node,
-                                             &length_of_via_path,
-                                             &sharing_of_via_path,
-                                             packed_shortest_path,
-                                             min_edge_offset);
+        for (auto &candidate : preselected_node_list)
+        {
+            candidate.length = 0;
+            candidate.sharing = 0;
+            if (!ComputeLengthAndSharingOfViaPath(candidate,
+                                                  packed_shortest_path,
+                                                  min_edge_offset,
+                                                  forward_heap1,
+                                                  reverse_heap1))
+            {
+                continue;
+            }
             const int maximum_allowed_sharing =
                 static_cast<int>(upper_bound_to_shortest_path_distance * VIAPATH_GAMMA);
-            if (sharing_of_via_path <= maximum_allowed_sharing &&
-                length_of_via_path <= upper_bound_to_shortest_path_distance * (1 + VIAPATH_EPSILON))
+            if (candidate.sharing <= maximum_allowed_sharing &&
+                candidate.length <= upper_bound_to_shortest_path_distance * (1 + VIAPATH_EPSILON))
             {
-                ranked_candidates_list.emplace_back(node, length_of_via_path, sharing_of_via_path);
+                ranked_candidates_list.push_back(std::move(candidate));
             }
         }
         std::sort(ranked_candidates_list.begin(), ranked_candidates_list.end());
 
-        NodeID selected_via_node = SPECIAL_NODEID;
-        int length_of_via_path = INVALID_EDGE_WEIGHT;
-        NodeID s_v_middle = SPECIAL_NODEID, v_t_middle = SPECIAL_NODEID;
+        const RankedCandidateNode *selected_candidate = nullptr;
         for (const RankedCandidateNode &candidate : ranked_candidates_list)
         {
-            if (ViaNodeCandidatePassesTTest(forward_heap1,
-                                            reverse_heap1,
-                                            forward_heap2,
-                                            reverse_heap2,
-                                            candidate,
-                                            upper_bound_to_shortest_path_distance,
-                                            &length_of_via_path,
-                                            &s_v_middle,
-                                            &v_t_middle,
-                                            min_edge_offset))
+            if (ViaNodeCandidatePassesTTest(
+                    candidate, upper_bound_to_shortest_path_distance, min_edge_offset))
             {
                 // select first admissable
-                selected_via_node = candidate.node;
+                selected_candidate = &candidate;
                 break;
             }
         }
@@ -332,7 +343,7 @@ class AlternativeRouting final
                 (packed_shortest_path.front() !=
                  phantom_node_pair.source_phantom.forward_segment_id.id));
             raw_route_data.target_traversed_in_reverse.push_back(
-                (packed_shortest_path.back() !=
+                (super::facade->GetOriginalNode(packed_shortest_path.back()) !=
                  phantom_node_pair.target_phantom.forward_segment_id.id));
 
             super::UnpackPath(
@@ -346,23 +357,21 @@ class AlternativeRouting final
             raw_route_data.shortest_path_length = upper_bound_to_shortest_path_distance;
         }
 
-        if (SPECIAL_NODEID != selected_via_node)
+        if (nullptr != selected_candidate)
         {
-            std::vector<NodeID> packed_alternate_path;
-            // retrieve alternate path
-            RetrievePackedAlternatePath(forward_heap1,
-                                        reverse_heap1,
-                                        forward_heap2,
-                                        reverse_heap2,
-                                        s_v_middle,
-                                        v_t_middle,
-                                        packed_alternate_path);
+            // alternate path <s,..,v,..,t>, v is the last node of <s,..,v> and the first of <v,..,t>
+            std::vector<NodeID> packed_alternate_path(
+                selected_candidate->packed_s_v_path.begin(),
+                std::prev(selected_candidate->packed_s_v_path.end()));
+            packed_alternate_path.insert(packed_alternate_path.end(),
+                                         selected_candidate->packed_v_t_path.begin(),
+                                         selected_candidate->packed_v_t_path.end());
 
             raw_route_data.alt_source_traversed_in_reverse.push_back(
                 (packed_alternate_path.front() !=
                  phantom_node_pair.source_phantom.forward_segment_id.id));
             raw_route_data.alt_target_traversed_in_reverse.push_back(
-                (packed_alternate_path.back() !=
+                (super::facade->GetOriginalNode(packed_alternate_path.back()) !=
                  phantom_node_pair.target_phantom.forward_segment_id.id));
 
             // unpack the alternate path
@@ -371,7 +380,7 @@ class AlternativeRouting final
                               phantom_node_pair,
                               raw_route_data.unpacked_alternative);
 
-            raw_route_data.alternative_path_length = length_of_via_path;
+            raw_route_data.alternative_path_length = selected_candidate->length;
         }
         else
         {
@@ -380,56 +389,35 @@ class AlternativeRouting final
     }
 
   private:
-    // unpack alternate <s,..,v,..,t> by exploring search spaces from v
-    void RetrievePackedAlternatePath(const QueryHeap &forward_heap1,
-                                     const QueryHeap &reverse_heap1,
-                                     const QueryHeap &forward_heap2,
-                                     const QueryHeap &reverse_heap2,
-                                     const NodeID s_v_middle,
-                                     const NodeID v_t_middle,
-                                     std::vector<NodeID> &packed_path) const
-    {
-        // fetch packed path [s,v)
-        std::vector<NodeID> packed_v_t_path;
-        super::RetrievePackedPathFromHeap(forward_heap1, reverse_heap2, s_v_middle, packed_path);
-        packed_path.pop_back(); // remove middle node. It's in both half-paths
-
-        // fetch patched path [v,t]
-        super::RetrievePackedPathFromHeap(
-            forward_heap2, reverse_heap1, v_t_middle, packed_v_t_path);
-
-        packed_path.insert(packed_path.end(), packed_v_t_path.begin(), packed_v_t_path.end());
-    }
-
-    // TODO: reorder parameters
     // compute and unpack <s,..,v> and <v,..,t> by exploring search spaces
     // from v and intersecting against queues. only half-searches have to be
-    // done at this stage
-    void ComputeLengthAndSharingOfViaPath(const NodeID via_node,
-                                          int *real_length_of_via_path,
-                                          int *sharing_of_via_path,
+    // done at this stage. Returns false if v is not on a path from s to t.
+    bool ComputeLengthAndSharingOfViaPath(RankedCandidateNode &candidate,
                                           const std::vector<NodeID> &packed_shortest_path,
-                                          const EdgeWeight min_edge_offset)
+                                          const EdgeWeight min_edge_offset,
+                                          QueryHeap &existing_forward_heap,
+                                          QueryHeap &existing_reverse_heap)
     {
-        engine_working_data.InitializeOrClearSecondThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
+        const NodeID via_node = candidate.node;
+        int *sharing_of_via_path = &candidate.sharing;
 
-        QueryHeap &existing_forward_heap = *engine_working_data.forward_heap_1;
-        QueryHeap &existing_reverse_heap = *engine_working_data.reverse_heap_1;
-        QueryHeap &new_forward_heap = *engine_working_data.forward_heap_2;
-        QueryHeap &new_reverse_heap = *engine_working_data.reverse_heap_2;
+        auto new_forward_heap_handle =
+            engine_working_data.GetHeap<QueryHeap>(super::facade->GetNumberOfNodes());
+        auto new_reverse_heap_handle =
+            engine_working_data.GetHeap<QueryHeap>(super::facade->GetNumberOfNodes());
+        QueryHeap &new_forward_heap = *new_forward_heap_handle;
+        QueryHeap &new_reverse_heap = *new_reverse_heap_handle;
 
-        std::vector<NodeID> packed_s_v_path;
-        std::vector<NodeID> packed_v_t_path;
+        std::vector<NodeID> &packed_s_v_path = candidate.packed_s_v_path;
+        std::vector<NodeID> &packed_v_t_path = candidate.packed_v_t_path;
 
         std::vector<NodeID> partially_unpacked_shortest_path;
         std::vector<NodeID> partially_unpacked_via_path;
 
-        NodeID s_v_middle = SPECIAL_NODEID;
+        NodeID &s_v_middle = candidate.s_v_middle;
         int upper_bound_s_v_path_length = INVALID_EDGE_WEIGHT;
         new_reverse_heap.Insert(via_node, 0, via_node);
         // compute path <s,..,v> by reusing forward search from s
-        const bool constexpr STALLING_ENABLED = true;
         const bool constexpr DO_NOT_FORCE_LOOPS = false;
         while (!new_reverse_heap.Empty())
         {
@@ -439,12 +427,11 @@ class AlternativeRouting final
                                upper_bound_s_v_path_length,
                                min_edge_offset,
                                false,
-                               STALLING_ENABLED,
                                DO_NOT_FORCE_LOOPS,
                                DO_NOT_FORCE_LOOPS);
         }
         // compute path <v,..,t> by reusing backward search from node t
-        NodeID v_t_middle = SPECIAL_NODEID;
+        NodeID &v_t_middle = candidate.v_t_middle;
         int upper_bound_of_v_t_path_length = INVALID_EDGE_WEIGHT;
         new_forward_heap.Insert(via_node, 0, via_node);
         while (!new_forward_heap.Empty())
@@ -455,16 +442,14 @@ class AlternativeRouting final
                                upper_bound_of_v_t_path_length,
                                min_edge_offset,
                                true,
-                               STALLING_ENABLED,
                                DO_NOT_FORCE_LOOPS,
                                DO_NOT_FORCE_LOOPS);
         }
-        *real_length_of_via_path = upper_bound_s_v_path_length + upper_bound_of_v_t_path_length;
-
         if (SPECIAL_NODEID == s_v_middle || SPECIAL_NODEID == v_t_middle)
         {
-            return;
+            return false;
         }
+        candidate.length = upper_bound_s_v_path_length + upper_bound_of_v_t_path_length;
 
         // retrieve packed paths
         super::RetrievePackedPathFromHeap(
@@ -566,8 +551,8 @@ class AlternativeRouting final
                 break;
             }
         }
-        // finished partial unpacking spree! Amount of sharing is stored to appropriate pointer
-        // variable
+        // finished partial unpacking spree! Amount of sharing is stored in the candidate
+        return true;
     }
 
     // int approximateAmountOfSharing(
@@ -630,6 +615,7 @@ class AlternativeRouting final
 
         const NodeID node = forward_heap.DeleteMin();
         const int distance = forward_heap.GetKey(node);
+        CheckQueryDeadline();
         // const NodeID parentnode = forward_heap.GetData(node).parent;
         // util::SimpleLogger().Write() << (is_forward_directed ? "[fwd] " : "[rev] ") << "settled
         // edge ("
@@ -679,7 +665,7 @@ class AlternativeRouting final
             }
         }
 
-        for (auto edge : facade->GetAdjacentEdgeRange(node))
+        for (auto edge : facade->GetDirectedEdgeRange(node, is_forward_directed))
         {
             const EdgeData &data = facade->GetEdgeData(edge);
             const bool edge_is_forward_directed =
@@ -710,88 +696,18 @@ class AlternativeRouting final
         }
     }
 
-    // conduct T-Test
-    bool ViaNodeCandidatePassesTTest(QueryHeap &existing_forward_heap,
-                                     QueryHeap &existing_reverse_heap,
-                                     QueryHeap &new_forward_heap,
-                                     QueryHeap &new_reverse_heap,
-                                     const RankedCandidateNode &candidate,
+    // conduct T-Test on the via path found by ComputeLengthAndSharingOfViaPath
+    bool ViaNodeCandidatePassesTTest(const RankedCandidateNode &candidate,
                                      const int length_of_shortest_path,
-                                     int *length_of_via_path,
-                                     NodeID *s_v_middle,
-                                     NodeID *v_t_middle,
                                      const EdgeWeight min_edge_offset) const
     {
-        new_forward_heap.Clear();
-        new_reverse_heap.Clear();
-        std::vector<NodeID> packed_s_v_path;
-        std::vector<NodeID> packed_v_t_path;
+        const std::vector<NodeID> &packed_s_v_path = candidate.packed_s_v_path;
+        const std::vector<NodeID> &packed_v_t_path = candidate.packed_v_t_path;
+        BOOST_ASSERT(!packed_s_v_path.empty() && !packed_v_t_path.empty());
 
-        *s_v_middle = SPECIAL_NODEID;
-        int upper_bound_s_v_path_length = INVALID_EDGE_WEIGHT;
-        // compute path <s,..,v> by reusing forward search from s
-        new_reverse_heap.Insert(candidate.node, 0, candidate.node);
-        const bool constexpr STALLING_ENABLED = true;
+        NodeID s_P = candidate.s_v_middle, t_P = candidate.v_t_middle;
         const bool constexpr DO_NOT_FORCE_LOOPS = false;
-        while (new_reverse_heap.Size() > 0)
-        {
-            super::RoutingStep(new_reverse_heap,
-                               existing_forward_heap,
-                               *s_v_middle,
-                               upper_bound_s_v_path_length,
-                               min_edge_offset,
-                               false,
-                               STALLING_ENABLED,
-                               DO_NOT_FORCE_LOOPS,
-                               DO_NOT_FORCE_LOOPS);
-        }
-
-        if (INVALID_EDGE_WEIGHT == upper_bound_s_v_path_length)
-        {
-            return false;
-        }
-
-        // compute path <v,..,t> by reusing backward search from t
-        *v_t_middle = SPECIAL_NODEID;
-        int upper_bound_of_v_t_path_length = INVALID_EDGE_WEIGHT;
-        new_forward_heap.Insert(candidate.node, 0, candidate.node);
-        while (new_forward_heap.Size() > 0)
-        {
-            super::RoutingStep(new_forward_heap,
-                               existing_reverse_heap,
-                               *v_t_middle,
-                               upper_bound_of_v_t_path_length,
-                               min_edge_offset,
-                               true,
-                               STALLING_ENABLED,
-                               DO_NOT_FORCE_LOOPS,
-                               DO_NOT_FORCE_LOOPS);
-        }
 
-        if (INVALID_EDGE_WEIGHT == upper_bound_of_v_t_path_length)
-        {
-            return false;
-        }
-
-        *length_of_via_path = upper_bound_s_v_path_length + upper_bound_of_v_t_path_length;
-
-        // retrieve packed paths
-        super::RetrievePackedPathFromHeap(
-            existing_forward_heap, new_reverse_heap, *s_v_middle, packed_s_v_path);
-
-        super::RetrievePackedPathFromHeap(
-            new_forward_heap, existing_reverse_heap, *v_t_middle, packed_v_t_path);
-
-        NodeID s_P = *s_v_middle, t_P = *v_t_middle;
-        if (SPECIAL_NODEID == s_P)
-        {
-            return false;
-        }
-
-        if (SPECIAL_NODEID == t_P)
-        {
-            return false;
-        }
         const int T_threshold = static_cast<int>(VIAPATH_EPSILON * length_of_shortest_path);
         int unpacked_until_distance = 0;
 
@@ -918,11 +834,12 @@ class AlternativeRouting final
 
         t_test_path_length += unpacked_until_distance;
         // Run actual T-Test query and compare if distances equal.
-        engine_working_data.InitializeOrClearThirdThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-
-        QueryHeap &forward_heap3 = *engine_working_data.forward_heap_3;
-        QueryHeap &reverse_heap3 = *engine_working_data.reverse_heap_3;
+        auto forward_heap_handle =
+            engine_working_data.GetHeap<QueryHeap>(super::facade->GetNumberOfNodes());
+        auto reverse_heap_handle =
+            engine_working_data.GetHeap<QueryHeap>(super::facade->GetNumberOfNodes());
+        QueryHeap &forward_heap3 = *forward_heap_handle;
+        QueryHeap &reverse_heap3 = *reverse_heap_handle;
         int upper_bound = INVALID_EDGE_WEIGHT;
         NodeID middle = SPECIAL_NODEID;
 
@@ -939,7 +856,6 @@ class AlternativeRouting final
                                    upper_bound,
                                    min_edge_offset,
                                    true,
-                                   STALLING_ENABLED,
                                    DO_NOT_FORCE_LOOPS,
                                    DO_NOT_FORCE_LOOPS);
             }
@@ -951,7 +867,6 @@ class AlternativeRouting final
                                    upper_bound,
                                    min_edge_offset,
                                    false,
-                                   STALLING_ENABLED,
                                    DO_NOT_FORCE_LOOPS,
                                    DO_NOT_FORCE_LOOPS);
             }
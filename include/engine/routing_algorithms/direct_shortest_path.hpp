@@ -29,37 +29,15 @@ class DirectShortestPathRouting final
 {
     using super = BasicRoutingInterface<DataFacadeT, DirectShortestPathRouting<DataFacadeT>>;
     using QueryHeap = SearchEngineData::QueryHeap;
+    using DenseQueryHeap = SearchEngineData::DenseQueryHeap;
     SearchEngineData &engine_working_data;
 
-  public:
-    DirectShortestPathRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
-        : super(facade), engine_working_data(engine_working_data)
-    {
-    }
-
-    ~DirectShortestPathRouting() {}
-
-    void operator()(const std::vector<PhantomNodes> &phantom_nodes_vector,
-                    InternalRouteResult &raw_route_data) const
+    template <typename HeapT>
+    void InsertPhantomNodes(const PhantomNode &source_phantom,
+                            const PhantomNode &target_phantom,
+                            HeapT &forward_heap,
+                            HeapT &reverse_heap) const
     {
-        // Get distance to next pair of target nodes.
-        BOOST_ASSERT_MSG(1 == phantom_nodes_vector.size(),
-                         "Direct Shortest Path Query only accepts a single source and target pair. "
-                         "Multiple ones have been specified.");
-        const auto &phantom_node_pair = phantom_nodes_vector.front();
-        const auto &source_phantom = phantom_node_pair.source_phantom;
-        const auto &target_phantom = phantom_node_pair.target_phantom;
-
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-        QueryHeap &forward_heap = *(engine_working_data.forward_heap_1);
-        QueryHeap &reverse_heap = *(engine_working_data.reverse_heap_1);
-        forward_heap.Clear();
-        reverse_heap.Clear();
-
-        BOOST_ASSERT(source_phantom.IsValid());
-        BOOST_ASSERT(target_phantom.IsValid());
-
         if (source_phantom.forward_segment_id.enabled)
         {
             forward_heap.Insert(source_phantom.forward_segment_id.id,
@@ -75,17 +53,40 @@ class DirectShortestPathRouting final
 
         if (target_phantom.forward_segment_id.enabled)
         {
-            reverse_heap.Insert(target_phantom.forward_segment_id.id,
-                                target_phantom.GetForwardWeightPlusOffset(),
-                                target_phantom.forward_segment_id.id);
+            super::InsertTargetNode(reverse_heap,
+                                    target_phantom.forward_segment_id.id,
+                                    target_phantom.GetForwardWeightPlusOffset());
         }
 
         if (target_phantom.reverse_segment_id.enabled)
         {
-            reverse_heap.Insert(target_phantom.reverse_segment_id.id,
-                                target_phantom.GetReverseWeightPlusOffset(),
-                                target_phantom.reverse_segment_id.id);
+            super::InsertTargetNode(reverse_heap,
+                                    target_phantom.reverse_segment_id.id,
+                                    target_phantom.GetReverseWeightPlusOffset());
         }
+    }
+
+  public:
+    DirectShortestPathRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
+        : super(facade), engine_working_data(engine_working_data)
+    {
+    }
+
+    ~DirectShortestPathRouting() {}
+
+    void operator()(const std::vector<PhantomNodes> &phantom_nodes_vector,
+                    InternalRouteResult &raw_route_data) const
+    {
+        // Get distance to next pair of target nodes.
+        BOOST_ASSERT_MSG(1 == phantom_nodes_vector.size(),
+                         "Direct Shortest Path Query only accepts a single source and target pair. "
+                         "Multiple ones have been specified.");
+        const auto &phantom_node_pair = phantom_nodes_vector.front();
+        const auto &source_phantom = phantom_node_pair.source_phantom;
+        const auto &target_phantom = phantom_node_pair.target_phantom;
+
+        BOOST_ASSERT(source_phantom.IsValid());
+        BOOST_ASSERT(target_phantom.IsValid());
 
         int distance = INVALID_EDGE_WEIGHT;
         std::vector<NodeID> packed_leg;
@@ -95,12 +96,17 @@ class DirectShortestPathRouting final
 
         if (super::facade->GetCoreSize() > 0)
         {
-            engine_working_data.InitializeOrClearSecondThreadLocalStorage(
-                super::facade->GetNumberOfNodes());
-            QueryHeap &forward_core_heap = *(engine_working_data.forward_heap_2);
-            QueryHeap &reverse_core_heap = *(engine_working_data.reverse_heap_2);
-            forward_core_heap.Clear();
-            reverse_core_heap.Clear();
+            const auto number_of_nodes = super::facade->GetNumberOfNodes();
+            auto forward_heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+            auto reverse_heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+            auto forward_core_heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+            auto reverse_core_heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+            QueryHeap &forward_heap = *forward_heap_handle;
+            QueryHeap &reverse_heap = *reverse_heap_handle;
+            QueryHeap &forward_core_heap = *forward_core_heap_handle;
+            QueryHeap &reverse_core_heap = *reverse_core_heap_handle;
+
+            InsertPhantomNodes(source_phantom, target_phantom, forward_heap, reverse_heap);
 
             super::SearchWithCore(forward_heap,
                                   reverse_heap,
@@ -113,6 +119,18 @@ class DirectShortestPathRouting final
         }
         else
         {
+            // a fully contracted graph settles few nodes but looks them up a lot,
+            // so the dense heaps are worth their memory here
+            const auto number_of_nodes = super::facade->GetNumberOfNodes();
+            auto forward_heap_handle =
+                engine_working_data.GetHeap<DenseQueryHeap>(number_of_nodes);
+            auto reverse_heap_handle =
+                engine_working_data.GetHeap<DenseQueryHeap>(number_of_nodes);
+            DenseQueryHeap &forward_heap = *forward_heap_handle;
+            DenseQueryHeap &reverse_heap = *reverse_heap_handle;
+
+            InsertPhantomNodes(source_phantom, target_phantom, forward_heap, reverse_heap);
+
             super::Search(forward_heap,
                           reverse_heap,
                           distance,
@@ -136,7 +154,8 @@ class DirectShortestPathRouting final
         raw_route_data.source_traversed_in_reverse.push_back(
             (packed_leg.front() != phantom_node_pair.source_phantom.forward_segment_id.id));
         raw_route_data.target_traversed_in_reverse.push_back(
-            (packed_leg.back() != phantom_node_pair.target_phantom.forward_segment_id.id));
+            (super::facade->GetOriginalNode(packed_leg.back()) !=
+             phantom_node_pair.target_phantom.forward_segment_id.id));
 
         super::UnpackPath(packed_leg.begin(),
                           packed_leg.end(),
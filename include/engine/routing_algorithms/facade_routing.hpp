@@ -0,0 +1,98 @@
+#ifndef FACADE_ROUTING_HPP
+#define FACADE_ROUTING_HPP
+
+#include "engine/core_landmarks.hpp"
+#include "engine/datafacade/datafacade_base.hpp"
+#include "engine/datafacade/internal_datafacade.hpp"
+#include "engine/datafacade/shared_datafacade.hpp"
+#include "engine/metrics.hpp"
+#include "engine/unpacking_cache.hpp"
+#include "util/make_unique.hpp"
+
+#include <boost/assert.hpp>
+
+#include <memory>
+#include <utility>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+// Instantiates a routing algorithm for the concrete type of the facade it runs on. Both facades
+// are final, so the graph accessors in the search loops are direct calls the compiler can inline
+// instead of virtual calls through BaseDataFacade. The type is picked once when the plugins of a
+// dataset are created, any other facade (e.g. in tests) runs on the virtual interface.
+template <template <class> class AlgorithmT> class FacadeRouting
+{
+  public:
+    template <typename... Args>
+    FacadeRouting(datafacade::BaseDataFacade *facade, Args &&... args)
+    {
+        if (auto shared_facade = dynamic_cast<datafacade::SharedDataFacade *>(facade))
+        {
+            shared_routing = util::make_unique<AlgorithmT<datafacade::SharedDataFacade>>(
+                shared_facade, std::forward<Args>(args)...);
+        }
+        else if (auto internal_facade = dynamic_cast<datafacade::InternalDataFacade *>(facade))
+        {
+            internal_routing = util::make_unique<AlgorithmT<datafacade::InternalDataFacade>>(
+                internal_facade, std::forward<Args>(args)...);
+        }
+        else
+        {
+            base_routing = util::make_unique<AlgorithmT<datafacade::BaseDataFacade>>(
+                facade, std::forward<Args>(args)...);
+        }
+    }
+
+    template <typename... Args>
+    auto operator()(Args &&... args) const
+        -> decltype(std::declval<AlgorithmT<datafacade::BaseDataFacade> &>()(
+            std::forward<Args>(args)...))
+    {
+        metrics::StageTimer timer(metrics::Stage::Search);
+        if (shared_routing)
+        {
+            return (*shared_routing)(std::forward<Args>(args)...);
+        }
+        if (internal_routing)
+        {
+            return (*internal_routing)(std::forward<Args>(args)...);
+        }
+        BOOST_ASSERT(base_routing);
+        return (*base_routing)(std::forward<Args>(args)...);
+    }
+
+    void UseUnpackingCache(UnpackingCache *cache)
+    {
+        if (shared_routing)
+            shared_routing->UseUnpackingCache(cache);
+        if (internal_routing)
+            internal_routing->UseUnpackingCache(cache);
+        if (base_routing)
+            base_routing->UseUnpackingCache(cache);
+    }
+
+    void UseCoreLandmarks(const CoreLandmarks *landmarks)
+    {
+        if (shared_routing)
+            shared_routing->UseCoreLandmarks(landmarks);
+        if (internal_routing)
+            internal_routing->UseCoreLandmarks(landmarks);
+        if (base_routing)
+            base_routing->UseCoreLandmarks(landmarks);
+    }
+
+  private:
+    std::unique_ptr<AlgorithmT<datafacade::SharedDataFacade>> shared_routing;
+    std::unique_ptr<AlgorithmT<datafacade::InternalDataFacade>> internal_routing;
+    std::unique_ptr<AlgorithmT<datafacade::BaseDataFacade>> base_routing;
+};
+}
+}
+}
+
+#endif // FACADE_ROUTING_HPP
@@ -0,0 +1,169 @@
+#ifndef ISOCHRONE_ROUTING_HPP
+#define ISOCHRONE_ROUTING_HPP
+
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+// One-to-all search in the style of PHAST: an upward search from the source, followed by a
+// linear downward sweep over all nodes in descending rank.
+//
+// The contracted graph stores every edge at its lower ranked node, so the post-order of a depth
+// first search along the stored edges puts every node behind all of its higher ranked
+// neighbours. This sweep order only depends on the graph and is computed on the first query.
+// The edges between core nodes, which were not contracted, are relaxed by the upward search.
+template <class DataFacadeT>
+class IsochroneRouting final
+    : public BasicRoutingInterface<DataFacadeT, IsochroneRouting<DataFacadeT>>
+{
+    using super = BasicRoutingInterface<DataFacadeT, IsochroneRouting<DataFacadeT>>;
+    using QueryHeap = SearchEngineData::DenseQueryHeap;
+    SearchEngineData &engine_working_data;
+
+    mutable std::once_flag sweep_order_computed;
+    mutable std::vector<NodeID> sweep_order;
+
+  public:
+    IsochroneRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
+        : super(facade), engine_working_data(engine_working_data)
+    {
+    }
+
+    ~IsochroneRouting() {}
+
+    // Returns the weight to reach the start of every node from the source, nodes that can not
+    // be reached within max_weight are INVALID_EDGE_WEIGHT.
+    std::vector<EdgeWeight> operator()(const PhantomNode &source, const EdgeWeight max_weight) const
+    {
+        std::call_once(sweep_order_computed, [this]() { ComputeSweepOrder(); });
+
+        const auto number_of_nodes = super::facade->GetNumberOfNodes();
+        std::vector<EdgeWeight> weights(number_of_nodes, INVALID_EDGE_WEIGHT);
+
+        auto heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+        QueryHeap &heap = *heap_handle;
+
+        if (source.forward_segment_id.enabled)
+        {
+            heap.Insert(source.forward_segment_id.id,
+                        -source.GetForwardWeightPlusOffset(),
+                        source.forward_segment_id.id);
+        }
+        if (source.reverse_segment_id.enabled)
+        {
+            heap.Insert(source.reverse_segment_id.id,
+                        -source.GetReverseWeightPlusOffset(),
+                        source.reverse_segment_id.id);
+        }
+
+        // upward search, the edges of contracted nodes all lead to higher ranked nodes
+        while (!heap.Empty())
+        {
+            const NodeID node = heap.DeleteMin();
+            const EdgeWeight weight = heap.GetKey(node);
+            CheckQueryDeadline();
+            if (weight > max_weight)
+            {
+                break;
+            }
+            weights[node] = weight;
+
+            for (const auto edge : super::facade->GetDirectedEdgeRange(node, true))
+            {
+                const auto &data = super::facade->GetEdgeData(edge);
+                if (!data.forward)
+                {
+                    continue;
+                }
+                const NodeID to = super::facade->GetTarget(edge);
+                const EdgeWeight to_weight = weight + data.distance;
+                if (!heap.WasInserted(to))
+                {
+                    heap.Insert(to, to_weight, node);
+                }
+                else if (to_weight < heap.GetKey(to))
+                {
+                    heap.GetData(to).parent = node;
+                    heap.DecreaseKey(to, to_weight);
+                }
+            }
+        }
+
+        // downward sweep, the higher ranked end of every edge is final when it is reached
+        for (const auto node : sweep_order)
+        {
+            auto weight = weights[node];
+            for (const auto edge : super::facade->GetDirectedEdgeRange(node, false))
+            {
+                const auto &data = super::facade->GetEdgeData(edge);
+                const auto from_weight = weights[super::facade->GetTarget(edge)];
+                if (data.backward && from_weight != INVALID_EDGE_WEIGHT)
+                {
+                    weight = std::min(weight, from_weight + data.distance);
+                }
+            }
+            weights[node] = weight <= max_weight ? weight : INVALID_EDGE_WEIGHT;
+        }
+
+        return weights;
+    }
+
+  private:
+    void ComputeSweepOrder() const
+    {
+        const auto number_of_nodes = super::facade->GetNumberOfNodes();
+        sweep_order.reserve(number_of_nodes);
+
+        std::vector<bool> visited(number_of_nodes, false);
+        // nodes on the current search path with the next edge to follow
+        std::vector<std::pair<NodeID, EdgeID>> stack;
+        for (NodeID root = 0; root < number_of_nodes; ++root)
+        {
+            if (visited[root] || super::facade->IsCoreNode(root))
+            {
+                continue;
+            }
+            visited[root] = true;
+            stack.emplace_back(root, super::facade->BeginEdges(root));
+
+            while (!stack.empty())
+            {
+                const auto node = stack.back().first;
+                const auto edge = stack.back().second;
+                if (edge == super::facade->EndEdges(node))
+                {
+                    sweep_order.push_back(node);
+                    stack.pop_back();
+                    continue;
+                }
+                ++stack.back().second;
+
+                const auto target = super::facade->GetTarget(edge);
+                if (!visited[target] && !super::facade->IsCoreNode(target))
+                {
+                    visited[target] = true;
+                    stack.emplace_back(target, super::facade->BeginEdges(target));
+                }
+            }
+        }
+    }
+};
+}
+}
+}
+
+#endif // ISOCHRONE_ROUTING_HPP
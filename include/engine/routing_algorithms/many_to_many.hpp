@@ -1,14 +1,27 @@
 #ifndef MANY_TO_MANY_ROUTING_HPP
 #define MANY_TO_MANY_ROUTING_HPP
 
+#include "engine/query_deadline.hpp"
 #include "engine/routing_algorithms/routing_base.hpp"
 #include "engine/search_engine_data.hpp"
+#include "engine/search_statistics.hpp"
+#include "util/hilbert_value.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/assert.hpp>
+#include <boost/range/iterator_range_core.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <memory>
+#include <numeric>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -19,36 +32,107 @@ namespace engine
 namespace routing_algorithms
 {
 
+// Targets prepared for the one-to-many sweep of ManyToManyRouting, see SearchOneToMany. The
+// sweep visits the union of the backward search spaces of the targets in an order in which every
+// node comes after the higher nodes its backward edges lead to. Independent of the sources, so
+// targets that are queried over and over again can be prepared once.
+struct OneToManyTargets
+{
+    // the edges of a sweep node end at end_edge, they start where the ones of its predecessor end
+    struct SweepNode
+    {
+        NodeID node;
+        std::uint32_t end_edge;
+    };
+    struct SweepEdge
+    {
+        std::uint32_t from; // position of the higher node in the sweep
+        EdgeWeight weight;
+        EdgeID edge;
+    };
+
+    std::vector<SearchPhantomNode> target_phantoms;
+    std::vector<SweepNode> sweep_nodes;
+    std::vector<SweepEdge> sweep_edges;
+    std::unordered_map<NodeID, std::uint32_t> sweep_position;
+};
+
 template <class DataFacadeT>
 class ManyToManyRouting final
     : public BasicRoutingInterface<DataFacadeT, ManyToManyRouting<DataFacadeT>>
 {
     using super = BasicRoutingInterface<DataFacadeT, ManyToManyRouting<DataFacadeT>>;
-    using QueryHeap = SearchEngineData::QueryHeap;
+    using QueryHeap = SearchEngineData::ManyToManyQueryHeap;
     SearchEngineData &engine_working_data;
+    const bool parallel_searches;
+
+    // below this many table entries scheduling overhead outweighs parallel searches
+    static constexpr std::size_t PARALLEL_SEARCH_MIN_ENTRIES = 1024;
+    // tables with a single source and at least this many targets run SearchOneToMany
+    static constexpr std::size_t ONE_TO_MANY_MIN_TARGETS = 64;
 
     struct NodeBucket
     {
+        NodeID middle_node;
+        NodeID parent_node; // parent in the backward search, needed to retrieve paths
         unsigned target_id; // essentially a row in the distance matrix
         EdgeWeight distance;
-        NodeBucket(const unsigned target_id, const EdgeWeight distance)
-            : target_id(target_id), distance(distance)
+        EdgeLength length; // only set if the table has lengths
+        NodeBucket(const NodeID middle_node,
+                   const NodeID parent_node,
+                   const unsigned target_id,
+                   const EdgeWeight distance,
+                   const EdgeLength length)
+            : middle_node(middle_node), parent_node(parent_node), target_id(target_id),
+              distance(distance), length(length)
         {
         }
+
+        // partial order comparison
+        bool operator<(const NodeBucket &rhs) const { return middle_node < rhs.middle_node; }
+
+        // functor for equal_range
+        struct Compare
+        {
+            bool operator()(const NodeBucket &lhs, const NodeID &rhs) const
+            {
+                return lhs.middle_node < rhs;
+            }
+
+            bool operator()(const NodeID &lhs, const NodeBucket &rhs) const
+            {
+                return lhs < rhs.middle_node;
+            }
+        };
     };
 
-    // FIXME This should be replaced by an std::unordered_multimap, though this needs benchmarking
-    using SearchSpaceWithBuckets = std::unordered_map<NodeID, std::vector<NodeBucket>>;
+    // All buckets of the backward searches in one flat array, sorted by middle node once the
+    // backward phase is done. Saves the per-node allocations of a node -> bucket list map.
+    using SearchSpaceWithBuckets = std::vector<NodeBucket>;
+    // The buckets of a table are taken from a pool of the thread, so that their memory is
+    // reused by the next table instead of being allocated again
+    using BucketsPool = ThreadLocalPool<SearchSpaceWithBuckets>;
 
   public:
-    ManyToManyRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
-        : super(facade), engine_working_data(engine_working_data)
+    // Tile sizes of the streamed table, see the operator taking a RowsHandler
+    static constexpr std::size_t TILE_COLUMNS = 1024;
+    static constexpr std::size_t TILE_ENTRIES = 1024 * 1024;
+
+    ManyToManyRouting(DataFacadeT *facade,
+                      SearchEngineData &engine_working_data,
+                      const bool parallel_searches = false)
+        : super(facade), engine_working_data(engine_working_data),
+          parallel_searches(parallel_searches)
     {
     }
 
+    // Durations from every source to every target, row-major. If length_table is given it is
+    // filled with the lengths in meters of the same paths, INVALID_EDGE_LENGTH where there is
+    // none. The lengths are carried along in the searches, no path is unpacked for them.
     std::vector<EdgeWeight> operator()(const std::vector<PhantomNode> &phantom_nodes,
                                        const std::vector<std::size_t> &source_indices,
-                                       const std::vector<std::size_t> &target_indices) const
+                                       const std::vector<std::size_t> &target_indices,
+                                       std::vector<EdgeLength> *length_table = nullptr) const
     {
         const auto number_of_sources =
             source_indices.empty() ? phantom_nodes.size() : source_indices.size();
@@ -57,199 +141,1159 @@ class ManyToManyRouting final
         const auto number_of_entries = number_of_sources * number_of_targets;
         std::vector<EdgeWeight> result_table(number_of_entries,
                                              std::numeric_limits<EdgeWeight>::max());
+        const bool with_lengths = length_table != nullptr;
+        if (with_lengths)
+        {
+            BOOST_ASSERT(super::facade->HasEdgeLengths());
+            length_table->assign(number_of_entries, INVALID_EDGE_LENGTH);
+        }
 
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
+        const auto target_phantoms =
+            MakeSearchPhantomNodes(phantom_nodes, target_indices, with_lengths);
+        const auto source_phantoms =
+            MakeSearchPhantomNodes(phantom_nodes, source_indices, with_lengths);
 
-        QueryHeap &query_heap = *(engine_working_data.forward_heap_1);
+        if (UseOneToMany(number_of_sources, number_of_targets))
+        {
+            SearchOneToMany(source_phantoms.front(),
+                            0,
+                            PrepareTargets(target_phantoms),
+                            result_table,
+                            length_table);
+            return result_table;
+        }
 
-        SearchSpaceWithBuckets search_space_with_buckets;
+        const bool parallel =
+            parallel_searches && number_of_entries >= PARALLEL_SEARCH_MIN_ENTRIES;
+        const auto search_space_with_buckets = BucketsPool::Acquire();
+        SearchTargets(target_phantoms,
+                      MakeHilbertCodes(phantom_nodes, target_indices),
+                      0,
+                      number_of_targets,
+                      with_lengths,
+                      parallel,
+                      *search_space_with_buckets);
+        SearchSources(source_phantoms,
+                      MakeHilbertCodes(phantom_nodes, source_indices),
+                      0,
+                      number_of_sources,
+                      number_of_targets,
+                      *search_space_with_buckets,
+                      result_table,
+                      length_table,
+                      parallel);
 
-        unsigned column_idx = 0;
-        const auto search_target_phantom = [&](const PhantomNode &phantom) {
-            query_heap.Clear();
-            // insert target(s) at distance 0
+        return result_table;
+    }
 
-            if (phantom.forward_segment_id.enabled)
+    // The same table for sizes that do not fit into memory at once. The table is computed in
+    // tiles of at most TILE_COLUMNS targets and TILE_ENTRIES entries. Once all tiles of a block
+    // of rows are done, handle_rows(first_row, number_of_rows, durations, lengths) gets the rows
+    // in row-major order, lengths is empty unless with_lengths is set. Peak memory is one block
+    // of rows and the buckets of one tile, independent of the size of the table.
+    //
+    // If there are more than TILE_COLUMNS targets their backward searches are repeated for every
+    // block of rows, which is the price for not keeping the buckets of all targets.
+    template <typename RowsHandler>
+    void operator()(const std::vector<PhantomNode> &phantom_nodes,
+                    const std::vector<std::size_t> &source_indices,
+                    const std::vector<std::size_t> &target_indices,
+                    const bool with_lengths,
+                    RowsHandler &&handle_rows) const
+    {
+        BOOST_ASSERT(!with_lengths || super::facade->HasEdgeLengths());
+        const auto number_of_sources =
+            source_indices.empty() ? phantom_nodes.size() : source_indices.size();
+        const auto number_of_targets =
+            target_indices.empty() ? phantom_nodes.size() : target_indices.size();
+        if (number_of_targets == 0)
+        {
+            return;
+        }
+
+        // the targets of all blocks of rows derive their lengths only once
+        const auto target_phantoms =
+            MakeSearchPhantomNodes(phantom_nodes, target_indices, with_lengths);
+        const auto source_phantoms =
+            MakeSearchPhantomNodes(phantom_nodes, source_indices, with_lengths);
+
+        if (UseOneToMany(number_of_sources, number_of_targets))
+        {
+            std::vector<EdgeWeight> row_durations(number_of_targets,
+                                                  std::numeric_limits<EdgeWeight>::max());
+            std::vector<EdgeLength> row_lengths;
+            if (with_lengths)
             {
-                query_heap.Insert(phantom.forward_segment_id.id,
-                                  phantom.GetForwardWeightPlusOffset(),
-                                  phantom.forward_segment_id.id);
+                row_lengths.assign(number_of_targets, INVALID_EDGE_LENGTH);
             }
-            if (phantom.reverse_segment_id.enabled)
+            SearchOneToMany(source_phantoms.front(),
+                            0,
+                            PrepareTargets(target_phantoms),
+                            row_durations,
+                            with_lengths ? &row_lengths : nullptr);
+            handle_rows(0, 1, row_durations, row_lengths);
+            return;
+        }
+
+        const std::size_t rows_per_block =
+            number_of_targets < TILE_ENTRIES ? TILE_ENTRIES / number_of_targets : 1;
+        const bool single_tile = number_of_targets <= TILE_COLUMNS;
+
+        // blocks of rows and tiles keep their place in the table, only the searches within them
+        // run in hilbert order
+        const auto target_codes = MakeHilbertCodes(phantom_nodes, target_indices);
+        const auto source_codes = MakeHilbertCodes(phantom_nodes, source_indices);
+
+        // with a single tile of targets its buckets serve all blocks of rows
+        // with multiple tiles the buckets of one tile at a time
+        const auto buckets = BucketsPool::Acquire();
+        if (single_tile)
+        {
+            SearchTargets(target_phantoms,
+                          target_codes,
+                          0,
+                          number_of_targets,
+                          with_lengths,
+                          parallel_searches,
+                          *buckets);
+        }
+
+        std::vector<EdgeWeight> block_durations;
+        std::vector<EdgeLength> block_lengths;
+        std::vector<EdgeWeight> tile_durations;
+        std::vector<EdgeLength> tile_lengths;
+        for (std::size_t first_row = 0; first_row < number_of_sources; first_row += rows_per_block)
+        {
+            const auto number_of_rows = std::min(rows_per_block, number_of_sources - first_row);
+            const auto block_entries = number_of_rows * number_of_targets;
+            block_durations.assign(block_entries, std::numeric_limits<EdgeWeight>::max());
+            if (with_lengths)
             {
-                query_heap.Insert(phantom.reverse_segment_id.id,
-                                  phantom.GetReverseWeightPlusOffset(),
-                                  phantom.reverse_segment_id.id);
+                block_lengths.assign(block_entries, INVALID_EDGE_LENGTH);
             }
 
-            // explore search space
-            while (!query_heap.Empty())
+            if (single_tile)
             {
-                BackwardRoutingStep(column_idx, query_heap, search_space_with_buckets);
+                SearchSources(source_phantoms,
+                              source_codes,
+                              first_row,
+                              number_of_rows,
+                              number_of_targets,
+                              *buckets,
+                              block_durations,
+                              with_lengths ? &block_lengths : nullptr,
+                              parallel_searches);
+                handle_rows(first_row, number_of_rows, block_durations, block_lengths);
+                continue;
             }
-            ++column_idx;
-        };
 
-        // for each source do forward search
-        unsigned row_idx = 0;
-        const auto search_source_phantom = [&](const PhantomNode &phantom) {
-            query_heap.Clear();
-            // insert target(s) at distance 0
+            for (std::size_t first_column = 0; first_column < number_of_targets;
+                 first_column += TILE_COLUMNS)
+            {
+                const std::size_t number_of_columns =
+                    number_of_targets - first_column < TILE_COLUMNS ? number_of_targets - first_column
+                                                                    : TILE_COLUMNS;
+                SearchTargets(target_phantoms,
+                              target_codes,
+                              first_column,
+                              number_of_columns,
+                              with_lengths,
+                              parallel_searches,
+                              *buckets);
+
+                const auto tile_entries = number_of_rows * number_of_columns;
+                tile_durations.assign(tile_entries, std::numeric_limits<EdgeWeight>::max());
+                if (with_lengths)
+                {
+                    tile_lengths.assign(tile_entries, INVALID_EDGE_LENGTH);
+                }
+                SearchSources(source_phantoms,
+                              source_codes,
+                              first_row,
+                              number_of_rows,
+                              number_of_columns,
+                              *buckets,
+                              tile_durations,
+                              with_lengths ? &tile_lengths : nullptr,
+                              parallel_searches);
+
+                for (std::size_t row_idx = 0; row_idx < number_of_rows; ++row_idx)
+                {
+                    const auto tile_row = row_idx * number_of_columns;
+                    const auto block_row = row_idx * number_of_targets + first_column;
+                    std::copy_n(tile_durations.begin() + tile_row,
+                                number_of_columns,
+                                block_durations.begin() + block_row);
+                    if (with_lengths)
+                    {
+                        std::copy_n(tile_lengths.begin() + tile_row,
+                                    number_of_columns,
+                                    block_lengths.begin() + block_row);
+                    }
+                }
+            }
+            handle_rows(first_row, number_of_rows, block_durations, block_lengths);
+        }
+    }
+
+    // Prepares targets for tables against them, see the operator taking OneToManyTargets. With
+    // edge lengths the prepared targets serve tables with and without lengths. Graphs with a core
+    // cannot be swept, then nullptr is returned.
+    std::shared_ptr<const OneToManyTargets>
+    operator()(const std::vector<PhantomNode> &target_phantom_nodes) const
+    {
+        if (super::facade->GetCoreSize() > 0)
+        {
+            return nullptr;
+        }
+        return std::make_shared<const OneToManyTargets>(PrepareTargets(MakeSearchPhantomNodes(
+            target_phantom_nodes, {}, super::facade->HasEdgeLengths())));
+    }
+
+    // The table from the given sources to prepared targets, one forward search and one sweep per
+    // source. Otherwise like the table operator above.
+    std::vector<EdgeWeight> operator()(const std::vector<PhantomNode> &phantom_nodes,
+                                       const std::vector<std::size_t> &source_indices,
+                                       const OneToManyTargets &targets,
+                                       std::vector<EdgeLength> *length_table = nullptr) const
+    {
+        const auto source_phantoms =
+            MakeSearchPhantomNodes(phantom_nodes, source_indices, length_table != nullptr);
+        const auto search_order = SearchOrder(
+            MakeHilbertCodes(phantom_nodes, source_indices), 0, source_phantoms.size());
+        const auto number_of_entries = source_phantoms.size() * targets.target_phantoms.size();
+        std::vector<EdgeWeight> result_table(number_of_entries,
+                                             std::numeric_limits<EdgeWeight>::max());
+        if (length_table)
+        {
+            BOOST_ASSERT(super::facade->HasEdgeLengths());
+            length_table->assign(number_of_entries, INVALID_EDGE_LENGTH);
+        }
+
+        if (parallel_searches && number_of_entries >= PARALLEL_SEARCH_MIN_ENTRIES)
+        {
+            // the rows of the result table are disjoint between sources
+            auto *const statistics = ActiveSearchStatistics();
+            const auto *const deadline = ActiveQueryDeadline();
+            tbb::enumerable_thread_specific<SearchStatistics> thread_local_statistics;
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, source_phantoms.size()),
+                              [&](const tbb::blocked_range<std::size_t> &range) {
+                                  const SearchStatisticsScope statistics_scope(
+                                      statistics ? &thread_local_statistics.local() : nullptr);
+                                  const QueryDeadlineScope deadline_scope(deadline);
+                                  for (auto position = range.begin(); position != range.end();
+                                       ++position)
+                                  {
+                                      const auto row_idx = search_order[position];
+                                      SearchOneToMany(source_phantoms[row_idx],
+                                                      row_idx,
+                                                      targets,
+                                                      result_table,
+                                                      length_table);
+                                  }
+                              });
+            MergeStatistics(statistics, thread_local_statistics);
+            return result_table;
+        }
+
+        for (const auto row_idx : search_order)
+        {
+            SearchOneToMany(
+                source_phantoms[row_idx], row_idx, targets, result_table, length_table);
+        }
+        return result_table;
+    }
 
+    // Durations and packed paths from every source to every target, row-major like the table.
+    // Searches are pruned at duration_upper_bound: pairs without a path within the bound get
+    // INVALID_EDGE_WEIGHT and an empty path.
+    void operator()(const std::vector<PhantomNode> &source_phantom_nodes,
+                    const std::vector<PhantomNode> &target_phantom_nodes,
+                    const EdgeWeight duration_upper_bound,
+                    std::vector<EdgeWeight> &result_table,
+                    std::vector<std::vector<NodeID>> &packed_paths) const
+    {
+        const auto source_phantoms = MakeSearchPhantomNodes(source_phantom_nodes, {}, false);
+        const auto target_phantoms = MakeSearchPhantomNodes(target_phantom_nodes, {}, false);
+        const auto number_of_targets = target_phantoms.size();
+        const auto number_of_entries = source_phantoms.size() * number_of_targets;
+        result_table.assign(number_of_entries, INVALID_EDGE_WEIGHT);
+        packed_paths.assign(number_of_entries, {});
+        std::vector<NodeID> middle_table(number_of_entries, SPECIAL_NODEID);
+
+        auto query_heap_handle =
+            engine_working_data.GetHeap<QueryHeap>(super::facade->GetNumberOfNodes());
+        QueryHeap &query_heap = *query_heap_handle;
+
+        // the sources start with negative offsets, so a path can be shorter than its backward part
+        EdgeWeight min_source_offset = 0;
+        for (const auto &phantom : source_phantoms)
+        {
             if (phantom.forward_segment_id.enabled)
+                min_source_offset =
+                    std::min(min_source_offset, -phantom.forward_weight_plus_offset);
+            if (phantom.reverse_segment_id.enabled)
+                min_source_offset =
+                    std::min(min_source_offset, -phantom.reverse_weight_plus_offset);
+        }
+        const EdgeWeight backward_upper_bound =
+            duration_upper_bound > INVALID_EDGE_WEIGHT + min_source_offset
+                ? INVALID_EDGE_WEIGHT
+                : duration_upper_bound - min_source_offset;
+
+        const auto buckets = BucketsPool::Acquire();
+        SearchSpaceWithBuckets &search_space_with_buckets = *buckets;
+        for (std::size_t column_idx = 0; column_idx < number_of_targets; ++column_idx)
+        {
+            SearchTargetPhantom(target_phantoms[column_idx],
+                                column_idx,
+                                query_heap,
+                                search_space_with_buckets,
+                                false,
+                                backward_upper_bound);
+        }
+        std::stable_sort(search_space_with_buckets.begin(), search_space_with_buckets.end());
+
+        for (std::size_t row_idx = 0; row_idx < source_phantoms.size(); ++row_idx)
+        {
+            SearchSourcePhantom(source_phantoms[row_idx],
+                                row_idx,
+                                number_of_targets,
+                                query_heap,
+                                search_space_with_buckets,
+                                result_table,
+                                nullptr,
+                                &middle_table,
+                                duration_upper_bound);
+
+            // the forward search space of the source is still in the heap
+            for (std::size_t column_idx = 0; column_idx < number_of_targets; ++column_idx)
             {
-                query_heap.Insert(phantom.forward_segment_id.id,
-                                  -phantom.GetForwardWeightPlusOffset(),
-                                  phantom.forward_segment_id.id);
+                const auto entry_idx = row_idx * number_of_targets + column_idx;
+                if (result_table[entry_idx] >= duration_upper_bound)
+                {
+                    result_table[entry_idx] = INVALID_EDGE_WEIGHT;
+                    continue;
+                }
+                RetrievePackedPath(query_heap,
+                                   search_space_with_buckets,
+                                   column_idx,
+                                   middle_table[entry_idx],
+                                   result_table[entry_idx],
+                                   packed_paths[entry_idx]);
             }
-            if (phantom.reverse_segment_id.enabled)
+        }
+    }
+
+    // The sweep relies on every edge being stored at its lower node, which a core breaks
+    bool UseOneToMany(const std::size_t number_of_sources,
+                      const std::size_t number_of_targets) const
+    {
+        return number_of_sources == 1 && number_of_targets >= ONE_TO_MANY_MIN_TARGETS &&
+               super::facade->GetCoreSize() == 0;
+    }
+
+    OneToManyTargets PrepareTargets(std::vector<SearchPhantomNode> target_phantoms) const
+    {
+        OneToManyTargets targets;
+        targets.target_phantoms = std::move(target_phantoms);
+        SelectSweepNodes(targets);
+        return targets;
+    }
+
+    // One row of the table in the manner of RPHAST: a single forward search gives the distances
+    // of the upward search space of the source, a sweep over the backward search spaces of the
+    // targets from higher to lower nodes carries them down to the targets. This replaces one
+    // backward search per target and the sorting of their buckets by a single pass over the
+    // union of their search spaces.
+    void SearchOneToMany(const SearchPhantomNode &source,
+                         const std::size_t row_idx,
+                         const OneToManyTargets &targets,
+                         std::vector<EdgeWeight> &result_table,
+                         std::vector<EdgeLength> *length_table) const
+    {
+        const bool with_lengths = length_table != nullptr;
+        const auto &target_phantoms = targets.target_phantoms;
+        const auto &sweep_nodes = targets.sweep_nodes;
+        const auto &sweep_edges = targets.sweep_edges;
+        const auto number_of_targets = target_phantoms.size();
+
+        auto query_heap_handle =
+            engine_working_data.GetHeap<QueryHeap>(super::facade->GetNumberOfNodes());
+        QueryHeap &query_heap = *query_heap_handle;
+        // without buckets the search only settles the upward search space of the source
+        const SearchSpaceWithBuckets no_buckets;
+        SearchSourcePhantom(source,
+                            row_idx,
+                            number_of_targets,
+                            query_heap,
+                            no_buckets,
+                            result_table,
+                            length_table);
+
+        std::vector<EdgeWeight> distances(sweep_nodes.size(), INVALID_EDGE_WEIGHT);
+        std::vector<EdgeLength> lengths(with_lengths ? sweep_nodes.size() : 0, 0);
+        std::uint32_t begin_edge = 0;
+        for (std::size_t position = 0; position < sweep_nodes.size(); ++position)
+        {
+            const auto &sweep_node = sweep_nodes[position];
+            auto &distance = distances[position];
+            if (query_heap.WasInserted(sweep_node.node))
+            {
+                distance = query_heap.GetKey(sweep_node.node);
+                if (with_lengths)
+                {
+                    lengths[position] = query_heap.GetData(sweep_node.node).length;
+                }
+            }
+            for (auto edge_idx = begin_edge; edge_idx < sweep_node.end_edge; ++edge_idx)
             {
-                query_heap.Insert(phantom.reverse_segment_id.id,
-                                  -phantom.GetReverseWeightPlusOffset(),
-                                  phantom.reverse_segment_id.id);
+                const auto &edge = sweep_edges[edge_idx];
+                if (distances[edge.from] == INVALID_EDGE_WEIGHT ||
+                    distances[edge.from] + edge.weight >= distance)
+                {
+                    continue;
+                }
+                distance = distances[edge.from] + edge.weight;
+                if (with_lengths)
+                {
+                    lengths[position] =
+                        lengths[edge.from] + super::facade->GetEdgeLength(edge.edge);
+                }
             }
+            begin_edge = sweep_node.end_edge;
+        }
+
+        CheckQueryDeadline(sweep_nodes.size());
+        auto *const statistics = ActiveSearchStatistics();
+        if (statistics)
+        {
+            statistics->settled_nodes += sweep_nodes.size();
+            statistics->relaxed_edges += sweep_edges.size();
+        }
+
+        // A negative sum means the source lies behind the target on the same node. The bucket
+        // searches handle that with loops and the next best meeting node, which the sweep does
+        // not keep, so those targets take the bucket searches.
+        std::vector<std::size_t> bucket_columns;
+        for (std::size_t column_idx = 0; column_idx < number_of_targets; ++column_idx)
+        {
+            const auto &target = target_phantoms[column_idx];
+            EdgeWeight duration = INVALID_EDGE_WEIGHT;
+            EdgeLength length = INVALID_EDGE_LENGTH;
+            bool needs_buckets = false;
+            const auto reach_node = [&](const NodeID node,
+                                        const EdgeWeight weight_plus_offset,
+                                        const EdgeLength length_from_middle) {
+                const auto position = targets.sweep_position.find(node);
+                BOOST_ASSERT(position != targets.sweep_position.end());
+                if (distances[position->second] == INVALID_EDGE_WEIGHT)
+                {
+                    return;
+                }
+                const EdgeWeight new_duration = distances[position->second] + weight_plus_offset;
+                if (new_duration < 0)
+                {
+                    needs_buckets = true;
+                }
+                else if (new_duration < duration)
+                {
+                    duration = new_duration;
+                    if (with_lengths)
+                    {
+                        length = lengths[position->second] + length_from_middle;
+                    }
+                }
+            };
+            // a path may end on a copy of the target node, see InsertTargetNode
+            const auto reach = [&](const SegmentID segment_id,
+                                   const EdgeWeight weight_plus_offset,
+                                   const EdgeLength length_from_middle) {
+                if (!segment_id.enabled)
+                {
+                    return;
+                }
+                reach_node(segment_id.id, weight_plus_offset, length_from_middle);
+                for (const NodeID duplicate : super::facade->GetDuplicatedNodes(segment_id.id))
+                {
+                    reach_node(duplicate, weight_plus_offset, length_from_middle);
+                }
+            };
+            reach(target.forward_segment_id,
+                  target.forward_weight_plus_offset,
+                  target.length_from_middle);
+            reach(target.reverse_segment_id,
+                  target.reverse_weight_plus_offset,
+                  -target.length_from_middle);
 
-            // explore search space
-            while (!query_heap.Empty())
+            const auto entry_idx = row_idx * number_of_targets + column_idx;
+            if (needs_buckets)
             {
-                ForwardRoutingStep(row_idx,
-                                   number_of_targets,
-                                   query_heap,
-                                   search_space_with_buckets,
-                                   result_table);
+                bucket_columns.push_back(column_idx);
             }
-            ++row_idx;
-        };
+            else if (duration != INVALID_EDGE_WEIGHT)
+            {
+                result_table[entry_idx] = duration;
+                if (with_lengths)
+                {
+                    (*length_table)[entry_idx] = length;
+                }
+            }
+        }
+        if (bucket_columns.empty())
+        {
+            return;
+        }
 
-        if (target_indices.empty())
+        std::vector<SearchPhantomNode> bucket_targets;
+        for (const auto column_idx : bucket_columns)
+        {
+            bucket_targets.push_back(target_phantoms[column_idx]);
+        }
+        std::vector<EdgeWeight> bucket_durations(bucket_columns.size(),
+                                                 std::numeric_limits<EdgeWeight>::max());
+        std::vector<EdgeLength> bucket_lengths(with_lengths ? bucket_columns.size() : 0,
+                                               INVALID_EDGE_LENGTH);
+        const auto buckets = BucketsPool::Acquire();
+        SearchTargets(
+            bucket_targets, {}, 0, bucket_targets.size(), with_lengths, false, *buckets);
+        SearchSourcePhantom(source,
+                            0,
+                            bucket_targets.size(),
+                            query_heap,
+                            *buckets,
+                            bucket_durations,
+                            with_lengths ? &bucket_lengths : nullptr);
+        for (std::size_t bucket_idx = 0; bucket_idx < bucket_columns.size(); ++bucket_idx)
         {
-            for (const auto &phantom : phantom_nodes)
+            const auto entry_idx = row_idx * number_of_targets + bucket_columns[bucket_idx];
+            result_table[entry_idx] = bucket_durations[bucket_idx];
+            if (with_lengths)
             {
-                search_target_phantom(phantom);
+                (*length_table)[entry_idx] = bucket_lengths[bucket_idx];
             }
         }
-        else
+    }
+
+    // Collects the sweep nodes and edges of the backward search spaces of the targets, placing
+    // every node once all higher nodes its backward edges lead to are placed
+    void SelectSweepNodes(OneToManyTargets &targets) const
+    {
+        auto &sweep_nodes = targets.sweep_nodes;
+        auto &sweep_edges = targets.sweep_edges;
+        auto &sweep_position = targets.sweep_position;
+        // position of nodes that are on the stack of the depth-first search and not placed yet
+        const auto on_stack = std::numeric_limits<std::uint32_t>::max();
+        struct StackEntry
         {
-            for (const auto index : target_indices)
+            NodeID node;
+            EdgeID next_edge;
+        };
+        std::vector<StackEntry> stack;
+        const auto visit = [&](const NodeID node) {
+            if (!sweep_position.emplace(node, on_stack).second)
             {
-                const auto &phantom = phantom_nodes[index];
-                search_target_phantom(phantom);
+                return false;
+            }
+            stack.push_back({node, super::facade->BeginEdges(node)});
+            return true;
+        };
+
+        const auto place_node = [&](const NodeID target_node) {
+            visit(target_node);
+            while (!stack.empty())
+            {
+                // descend into the first higher node that was not visited yet
+                bool descended = false;
+                const auto node = stack.back().node;
+                const auto end_edge = super::facade->EndEdges(node);
+                while (!descended && stack.back().next_edge < end_edge)
+                {
+                    const auto edge = stack.back().next_edge++;
+                    const NodeID to = super::facade->GetTarget(edge);
+                    if (super::facade->GetEdgeData(edge).backward && to != node)
+                    {
+                        descended = visit(to);
+                    }
+                }
+                if (descended)
+                {
+                    continue;
+                }
+
+                stack.pop_back();
+                for (const auto edge : super::facade->GetDirectedEdgeRange(node, false))
+                {
+                    const auto &data = super::facade->GetEdgeData(edge);
+                    const NodeID to = super::facade->GetTarget(edge);
+                    if (!data.backward || to == node)
+                    {
+                        continue;
+                    }
+                    const auto from = sweep_position.find(to)->second;
+                    BOOST_ASSERT_MSG(from != on_stack, "backward edges form a cycle");
+                    sweep_edges.push_back({from, data.distance, edge});
+                }
+                sweep_position[node] = static_cast<std::uint32_t>(sweep_nodes.size());
+                sweep_nodes.push_back({node, static_cast<std::uint32_t>(sweep_edges.size())});
+            }
+        };
+        // the copies of the target nodes take part in the sweep as well, see InsertTargetNode
+        const auto place = [&](const NodeID target_node) {
+            place_node(target_node);
+            for (const NodeID duplicate : super::facade->GetDuplicatedNodes(target_node))
+            {
+                place_node(duplicate);
+            }
+        };
+
+        for (const auto &target : targets.target_phantoms)
+        {
+            if (target.forward_segment_id.enabled)
+            {
+                place(target.forward_segment_id.id);
+            }
+            if (target.reverse_segment_id.enabled)
+            {
+                place(target.reverse_segment_id.id);
             }
         }
+    }
 
-        if (source_indices.empty())
+    // Converts the phantom nodes of the given indices, all of them if there are none
+    std::vector<SearchPhantomNode>
+    MakeSearchPhantomNodes(const std::vector<PhantomNode> &phantom_nodes,
+                           const std::vector<std::size_t> &indices,
+                           const bool with_lengths) const
+    {
+        const auto number_of_phantoms = indices.empty() ? phantom_nodes.size() : indices.size();
+        std::vector<SearchPhantomNode> search_phantoms;
+        search_phantoms.reserve(number_of_phantoms);
+        for (std::size_t index = 0; index < number_of_phantoms; ++index)
         {
-            for (const auto &phantom : phantom_nodes)
+            const auto &phantom =
+                indices.empty() ? phantom_nodes[index] : phantom_nodes[indices[index]];
+            search_phantoms.push_back(
+                {phantom.forward_segment_id,
+                 phantom.reverse_segment_id,
+                 phantom.forward_segment_id.enabled ? phantom.GetForwardWeightPlusOffset()
+                                                    : INVALID_EDGE_WEIGHT,
+                 phantom.reverse_segment_id.enabled ? phantom.GetReverseWeightPlusOffset()
+                                                    : INVALID_EDGE_WEIGHT,
+                 with_lengths ? GetPhantomLengthFromMiddle(phantom) : 0});
+        }
+        return search_phantoms;
+    }
+
+    // Hilbert codes of the locations of the phantom nodes of the given indices, all of them if
+    // there are none
+    static std::vector<std::uint64_t>
+    MakeHilbertCodes(const std::vector<PhantomNode> &phantom_nodes,
+                     const std::vector<std::size_t> &indices)
+    {
+        const auto number_of_phantoms = indices.empty() ? phantom_nodes.size() : indices.size();
+        std::vector<std::uint64_t> hilbert_codes(number_of_phantoms);
+        for (std::size_t index = 0; index < number_of_phantoms; ++index)
+        {
+            hilbert_codes[index] = util::hilbertCode(
+                (indices.empty() ? phantom_nodes[index] : phantom_nodes[indices[index]]).location);
+        }
+        return hilbert_codes;
+    }
+
+    // The offsets 0 .. count - 1 of the phantoms first .. first + count - 1 ordered by their
+    // hilbert codes, in their given order if there are no codes. Searches from nearby phantoms
+    // share much of their search spaces, so in this order the graph and the buckets a search
+    // touches are mostly still cached from the previous one. Parallel searches split the order
+    // into ranges, which gives every worker a compact region as well.
+    static std::vector<std::size_t> SearchOrder(const std::vector<std::uint64_t> &hilbert_codes,
+                                                const std::size_t first,
+                                                const std::size_t count)
+    {
+        std::vector<std::size_t> order(count);
+        std::iota(order.begin(), order.end(), 0);
+        if (!hilbert_codes.empty())
+        {
+            BOOST_ASSERT(first + count <= hilbert_codes.size());
+            std::sort(order.begin(),
+                      order.end(),
+                      [&](const std::size_t lhs, const std::size_t rhs) {
+                          return hilbert_codes[first + lhs] < hilbert_codes[first + rhs];
+                      });
+        }
+        return order;
+    }
+
+    // Runs the backward searches of the targets first_column .. first_column + number_of_columns,
+    // their buckets replace the content of search_space_with_buckets, numbered from 0 and sorted
+    // by middle node. The searches run in the order of the hilbert codes of the targets.
+    void SearchTargets(const std::vector<SearchPhantomNode> &target_phantoms,
+                       const std::vector<std::uint64_t> &hilbert_codes,
+                       const std::size_t first_column,
+                       const std::size_t number_of_columns,
+                       const bool with_lengths,
+                       const bool parallel,
+                       SearchSpaceWithBuckets &search_space_with_buckets) const
+    {
+        search_space_with_buckets.clear();
+        const auto search_order = SearchOrder(hilbert_codes, first_column, number_of_columns);
+
+        if (parallel)
+        {
+            // Every search runs on heaps of the worker executing it
+            tbb::enumerable_thread_specific<SearchSpaceWithBuckets> thread_local_buckets;
+            // and records its statistics for the thread that runs the query
+            auto *const statistics = ActiveSearchStatistics();
+            const auto *const deadline = ActiveQueryDeadline();
+            tbb::enumerable_thread_specific<SearchStatistics> thread_local_statistics;
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_columns),
+                              [&](const tbb::blocked_range<std::size_t> &range) {
+                                  const SearchStatisticsScope statistics_scope(
+                                      statistics ? &thread_local_statistics.local() : nullptr);
+                                  const QueryDeadlineScope deadline_scope(deadline);
+                                  auto query_heap_handle = engine_working_data.GetHeap<QueryHeap>(
+                                      super::facade->GetNumberOfNodes());
+                                  QueryHeap &query_heap = *query_heap_handle;
+                                  auto &buckets = thread_local_buckets.local();
+                                  for (auto position = range.begin(); position != range.end();
+                                       ++position)
+                                  {
+                                      const auto column_idx = search_order[position];
+                                      const auto &target =
+                                          target_phantoms[first_column + column_idx];
+                                      SearchTargetPhantom(target,
+                                                          column_idx,
+                                                          query_heap,
+                                                          buckets,
+                                                          with_lengths);
+                                  }
+                              });
+            MergeStatistics(statistics, thread_local_statistics);
+
+            for (const auto &buckets : thread_local_buckets)
             {
-                search_source_phantom(phantom);
+                search_space_with_buckets.insert(
+                    search_space_with_buckets.end(), buckets.begin(), buckets.end());
             }
+            // the order of buckets of the same node does not matter for the result
+            tbb::parallel_sort(search_space_with_buckets.begin(), search_space_with_buckets.end());
+            return;
+        }
+
+        auto query_heap_handle =
+            engine_working_data.GetHeap<QueryHeap>(super::facade->GetNumberOfNodes());
+        QueryHeap &query_heap = *query_heap_handle;
+
+        for (const auto column_idx : search_order)
+        {
+            SearchTargetPhantom(target_phantoms[first_column + column_idx],
+                                column_idx,
+                                query_heap,
+                                search_space_with_buckets,
+                                with_lengths);
+        }
+
+        // ordering the buckets of a node by target makes the forward phase write the result row
+        // front to back, no matter in which order the targets were searched
+        std::sort(search_space_with_buckets.begin(),
+                  search_space_with_buckets.end(),
+                  [](const NodeBucket &lhs, const NodeBucket &rhs) {
+                      return std::tie(lhs.middle_node, lhs.target_id) <
+                             std::tie(rhs.middle_node, rhs.target_id);
+                  });
+    }
+
+    // Runs the forward searches of the sources first_row .. first_row + number_of_rows against
+    // the buckets, their rows are numbered from 0 in result_table and length_table. The searches
+    // run in the order of the hilbert codes of the sources.
+    void SearchSources(const std::vector<SearchPhantomNode> &source_phantoms,
+                       const std::vector<std::uint64_t> &hilbert_codes,
+                       const std::size_t first_row,
+                       const std::size_t number_of_rows,
+                       const std::size_t number_of_columns,
+                       const SearchSpaceWithBuckets &search_space_with_buckets,
+                       std::vector<EdgeWeight> &result_table,
+                       std::vector<EdgeLength> *length_table,
+                       const bool parallel) const
+    {
+        const auto search_order = SearchOrder(hilbert_codes, first_row, number_of_rows);
+
+        if (parallel)
+        {
+            // the rows of the result table are disjoint between sources
+            auto *const statistics = ActiveSearchStatistics();
+            const auto *const deadline = ActiveQueryDeadline();
+            tbb::enumerable_thread_specific<SearchStatistics> thread_local_statistics;
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_rows),
+                              [&](const tbb::blocked_range<std::size_t> &range) {
+                                  const SearchStatisticsScope statistics_scope(
+                                      statistics ? &thread_local_statistics.local() : nullptr);
+                                  const QueryDeadlineScope deadline_scope(deadline);
+                                  auto query_heap_handle = engine_working_data.GetHeap<QueryHeap>(
+                                      super::facade->GetNumberOfNodes());
+                                  QueryHeap &query_heap = *query_heap_handle;
+                                  for (auto position = range.begin(); position != range.end();
+                                       ++position)
+                                  {
+                                      const auto row_idx = search_order[position];
+                                      SearchSourcePhantom(source_phantoms[first_row + row_idx],
+                                                          row_idx,
+                                                          number_of_columns,
+                                                          query_heap,
+                                                          search_space_with_buckets,
+                                                          result_table,
+                                                          length_table);
+                                  }
+                              });
+            MergeStatistics(statistics, thread_local_statistics);
+            return;
         }
-        else
+
+        auto query_heap_handle =
+            engine_working_data.GetHeap<QueryHeap>(super::facade->GetNumberOfNodes());
+        QueryHeap &query_heap = *query_heap_handle;
+
+        for (const auto row_idx : search_order)
         {
-            for (const auto index : source_indices)
+            SearchSourcePhantom(source_phantoms[first_row + row_idx],
+                                row_idx,
+                                number_of_columns,
+                                query_heap,
+                                search_space_with_buckets,
+                                result_table,
+                                length_table);
+        }
+    }
+
+    static void
+    MergeStatistics(SearchStatistics *const statistics,
+                    const tbb::enumerable_thread_specific<SearchStatistics> &thread_local_statistics)
+    {
+        if (statistics)
+        {
+            for (const auto &worker_statistics : thread_local_statistics)
             {
-                const auto &phantom = phantom_nodes[index];
-                search_source_phantom(phantom);
+                *statistics += worker_statistics;
             }
         }
+    }
 
-        return result_table;
+    void SearchTargetPhantom(const SearchPhantomNode &phantom,
+                             const unsigned column_idx,
+                             QueryHeap &query_heap,
+                             SearchSpaceWithBuckets &search_space_with_buckets,
+                             const bool with_lengths,
+                             const EdgeWeight upper_bound = INVALID_EDGE_WEIGHT) const
+    {
+        query_heap.Clear();
+        // insert target(s) at distance 0
+
+        const EdgeLength length_from_middle = with_lengths ? phantom.length_from_middle : 0;
+        if (phantom.forward_segment_id.enabled)
+        {
+            super::InsertTargetNode(query_heap,
+                                    phantom.forward_segment_id.id,
+                                    phantom.forward_weight_plus_offset,
+                                    [&](const NodeID parent) {
+                                        return QueryHeap::DataType{parent, length_from_middle};
+                                    });
+        }
+        if (phantom.reverse_segment_id.enabled)
+        {
+            super::InsertTargetNode(query_heap,
+                                    phantom.reverse_segment_id.id,
+                                    phantom.reverse_weight_plus_offset,
+                                    [&](const NodeID parent) {
+                                        return QueryHeap::DataType{parent, -length_from_middle};
+                                    });
+        }
+
+        // explore search space
+        while (!query_heap.Empty() && query_heap.MinKey() <= upper_bound)
+        {
+            BackwardRoutingStep(column_idx, query_heap, search_space_with_buckets, with_lengths);
+        }
+    }
+
+    void SearchSourcePhantom(const SearchPhantomNode &phantom,
+                             const unsigned row_idx,
+                             const unsigned number_of_targets,
+                             QueryHeap &query_heap,
+                             const SearchSpaceWithBuckets &search_space_with_buckets,
+                             std::vector<EdgeWeight> &result_table,
+                             std::vector<EdgeLength> *length_table,
+                             std::vector<NodeID> *middle_table = nullptr,
+                             const EdgeWeight upper_bound = INVALID_EDGE_WEIGHT) const
+    {
+        query_heap.Clear();
+        // insert target(s) at distance 0
+
+        const EdgeLength length_from_middle = length_table ? phantom.length_from_middle : 0;
+        if (phantom.forward_segment_id.enabled)
+        {
+            query_heap.Insert(phantom.forward_segment_id.id,
+                              -phantom.forward_weight_plus_offset,
+                              {phantom.forward_segment_id.id, -length_from_middle});
+        }
+        if (phantom.reverse_segment_id.enabled)
+        {
+            query_heap.Insert(phantom.reverse_segment_id.id,
+                              -phantom.reverse_weight_plus_offset,
+                              {phantom.reverse_segment_id.id, length_from_middle});
+        }
+
+        // explore search space, the backward distances are never negative
+        while (!query_heap.Empty() && query_heap.MinKey() <= upper_bound)
+        {
+            ForwardRoutingStep(row_idx,
+                               number_of_targets,
+                               query_heap,
+                               search_space_with_buckets,
+                               result_table,
+                               length_table,
+                               middle_table);
+        }
     }
 
     void ForwardRoutingStep(const unsigned row_idx,
                             const unsigned number_of_targets,
                             QueryHeap &query_heap,
                             const SearchSpaceWithBuckets &search_space_with_buckets,
-                            std::vector<EdgeWeight> &result_table) const
+                            std::vector<EdgeWeight> &result_table,
+                            std::vector<EdgeLength> *length_table,
+                            std::vector<NodeID> *middle_table = nullptr) const
     {
         const NodeID node = query_heap.DeleteMin();
         const int source_distance = query_heap.GetKey(node);
+        const EdgeLength source_length = query_heap.GetData(node).length;
+
+        CheckQueryDeadline();
+        auto *const statistics = ActiveSearchStatistics();
+        if (statistics)
+        {
+            ++statistics->settled_nodes;
+        }
 
         // check if each encountered node has an entry
-        const auto bucket_iterator = search_space_with_buckets.find(node);
-        // iterate bucket if there exists one
-        if (bucket_iterator != search_space_with_buckets.end())
+        const auto &bucket_list = std::equal_range(search_space_with_buckets.begin(),
+                                                   search_space_with_buckets.end(),
+                                                   node,
+                                                   typename NodeBucket::Compare());
+        for (const auto &current_bucket : boost::make_iterator_range(bucket_list))
         {
-            const std::vector<NodeBucket> &bucket_list = bucket_iterator->second;
-            for (const NodeBucket &current_bucket : bucket_list)
+            // get target id from bucket entry
+            const unsigned column_idx = current_bucket.target_id;
+            const int target_distance = current_bucket.distance;
+            const auto entry_idx = row_idx * number_of_targets + column_idx;
+            auto &current_distance = result_table[entry_idx];
+            // check if new distance is better
+            EdgeWeight new_distance = source_distance + target_distance;
+            bool is_loop = false;
+            if (new_distance < 0)
             {
-                // get target id from bucket entry
-                const unsigned column_idx = current_bucket.target_id;
-                const int target_distance = current_bucket.distance;
-                auto &current_distance = result_table[row_idx * number_of_targets + column_idx];
-                // check if new distance is better
-                const EdgeWeight new_distance = source_distance + target_distance;
-                if (new_distance < 0)
+                const EdgeWeight loop_weight = super::GetLoopWeight(node);
+                if (loop_weight == INVALID_EDGE_WEIGHT || new_distance + loop_weight < 0)
                 {
-                    const EdgeWeight loop_weight = super::GetLoopWeight(node);
-                    const int new_distance_with_loop = new_distance + loop_weight;
-                    if (loop_weight != INVALID_EDGE_WEIGHT && new_distance_with_loop >= 0)
-                    {
-                        current_distance = std::min(current_distance, new_distance_with_loop);
-                    }
+                    continue;
                 }
-                else if (new_distance < current_distance)
+                new_distance += loop_weight;
+                is_loop = true;
+            }
+            if (new_distance < current_distance)
+            {
+                current_distance = new_distance;
+                if (length_table)
                 {
-                    result_table[row_idx * number_of_targets + column_idx] = new_distance;
+                    (*length_table)[entry_idx] = source_length + current_bucket.length +
+                                                 (is_loop ? GetLoopLength(node) : 0);
+                }
+                if (middle_table)
+                {
+                    (*middle_table)[entry_idx] = node;
                 }
             }
         }
         if (StallAtNode<true>(node, source_distance, query_heap))
         {
+            if (statistics)
+            {
+                ++statistics->stalled_nodes;
+            }
             return;
         }
-        RelaxOutgoingEdges<true>(node, source_distance, query_heap);
+        RelaxOutgoingEdges<true>(
+            node, source_distance, query_heap, statistics, length_table != nullptr);
     }
 
     void BackwardRoutingStep(const unsigned column_idx,
                              QueryHeap &query_heap,
-                             SearchSpaceWithBuckets &search_space_with_buckets) const
+                             SearchSpaceWithBuckets &search_space_with_buckets,
+                             const bool with_lengths) const
     {
         const NodeID node = query_heap.DeleteMin();
         const int target_distance = query_heap.GetKey(node);
+        const auto &data = query_heap.GetData(node);
+
+        CheckQueryDeadline();
+        auto *const statistics = ActiveSearchStatistics();
+        if (statistics)
+        {
+            ++statistics->settled_nodes;
+        }
 
         // store settled nodes in search space bucket
-        search_space_with_buckets[node].emplace_back(column_idx, target_distance);
+        search_space_with_buckets.emplace_back(
+            node, data.parent, column_idx, target_distance, data.length);
 
         if (StallAtNode<false>(node, target_distance, query_heap))
         {
+            if (statistics)
+            {
+                ++statistics->stalled_nodes;
+            }
+            return;
+        }
+
+        RelaxOutgoingEdges<false>(node, target_distance, query_heap, statistics, with_lengths);
+    }
+
+    // Same layout as the packed paths of the point to point searches: a path that is a loop at
+    // the middle node is stored as [middle, middle].
+    void RetrievePackedPath(QueryHeap &forward_heap,
+                            const SearchSpaceWithBuckets &search_space_with_buckets,
+                            const unsigned column_idx,
+                            const NodeID middle_node,
+                            const EdgeWeight duration,
+                            std::vector<NodeID> &packed_path) const
+    {
+        const auto find_bucket = [&](const NodeID node) -> const NodeBucket & {
+            const auto buckets = std::equal_range(search_space_with_buckets.begin(),
+                                                  search_space_with_buckets.end(),
+                                                  node,
+                                                  typename NodeBucket::Compare());
+            const auto bucket =
+                std::find_if(buckets.first, buckets.second, [&](const NodeBucket &bucket) {
+                    return bucket.target_id == column_idx;
+                });
+            BOOST_ASSERT(bucket != buckets.second);
+            return *bucket;
+        };
+
+        packed_path.clear();
+        const auto *bucket = &find_bucket(middle_node);
+        if (duration != forward_heap.GetKey(middle_node) + bucket->distance)
+        {
+            packed_path.push_back(middle_node);
+            packed_path.push_back(middle_node);
             return;
         }
 
-        RelaxOutgoingEdges<false>(node, target_distance, query_heap);
+        super::RetrievePackedPathFromSingleHeap(forward_heap, middle_node, packed_path);
+        std::reverse(packed_path.begin(), packed_path.end());
+        packed_path.push_back(middle_node);
+        while (bucket->parent_node != bucket->middle_node)
+        {
+            packed_path.push_back(bucket->parent_node);
+            bucket = &find_bucket(bucket->parent_node);
+        }
     }
 
     template <bool forward_direction>
-    inline void
-    RelaxOutgoingEdges(const NodeID node, const EdgeWeight distance, QueryHeap &query_heap) const
+    inline void RelaxOutgoingEdges(const NodeID node,
+                                   const EdgeWeight distance,
+                                   QueryHeap &query_heap,
+                                   SearchStatistics *const statistics,
+                                   const bool with_lengths) const
     {
-        for (auto edge : super::facade->GetAdjacentEdgeRange(node))
+        const EdgeLength length = query_heap.GetData(node).length;
+        const auto edges = super::facade->GetDirectedEdgeRange(node, forward_direction);
+        super::PrefetchTargets(query_heap, edges);
+
+        std::uint64_t relaxed_edges = 0;
+        for (auto edge : edges)
         {
-            const auto &data = super::facade->GetEdgeData(edge);
+            const auto adjacent_edge = super::facade->GetAdjacentEdge(edge);
+            const auto &data = adjacent_edge.data;
             const bool direction_flag = (forward_direction ? data.forward : data.backward);
             if (direction_flag)
             {
-                const NodeID to = super::facade->GetTarget(edge);
+                ++relaxed_edges;
+
+                const NodeID to = adjacent_edge.target;
                 const int edge_weight = data.distance;
 
                 BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
                 const int to_distance = distance + edge_weight;
+                const EdgeLength to_length =
+                    with_lengths ? length + super::facade->GetEdgeLength(edge) : 0;
 
                 // New Node discovered -> Add to Heap + Node Info Storage
                 if (!query_heap.WasInserted(to))
                 {
-                    query_heap.Insert(to, to_distance, node);
+                    query_heap.Insert(to, to_distance, {node, to_length});
                 }
                 // Found a shorter Path -> Update distance
                 else if (to_distance < query_heap.GetKey(to))
                 {
                     // new parent
-                    query_heap.GetData(to).parent = node;
+                    query_heap.GetData(to) = {node, to_length};
                     query_heap.DecreaseKey(to, to_distance);
                 }
             }
         }
+        if (statistics)
+        {
+            statistics->relaxed_edges += relaxed_edges;
+        }
+    }
+
+    // Length of the loop edge GetLoopWeight picks
+    EdgeLength GetLoopLength(const NodeID node) const
+    {
+        EdgeWeight loop_weight = INVALID_EDGE_WEIGHT;
+        EdgeLength loop_length = 0;
+        for (auto edge : super::facade->GetDirectedEdgeRange(node, true))
+        {
+            const auto &data = super::facade->GetEdgeData(edge);
+            if (data.forward && super::facade->GetTarget(edge) == node &&
+                data.distance < loop_weight)
+            {
+                loop_weight = data.distance;
+                loop_length = super::facade->GetEdgeLength(edge);
+            }
+        }
+        return loop_length;
+    }
+
+    // The edge lengths count half of the edge-based nodes at both ends, so the searches start at
+    // the middle of the nodes of a phantom. Returns the signed length from that middle to the
+    // phantom along the forward node, for the reverse node it is negated.
+    EdgeLength GetPhantomLengthFromMiddle(const PhantomNode &phantom) const
+    {
+        const auto forward_geometry =
+            super::facade->GetUncompressedGeometryView(phantom.forward_packed_geometry_id);
+        const auto reverse_geometry =
+            super::facade->GetUncompressedGeometryView(phantom.reverse_packed_geometry_id);
+        BOOST_ASSERT(forward_geometry.size() > phantom.fwd_segment_position);
+        BOOST_ASSERT(reverse_geometry.size() == forward_geometry.size());
+
+        // a geometry does not store its first node, it is the last one of the other direction
+        auto previous =
+            super::facade->GetCoordinateOfNode(reverse_geometry[reverse_geometry.size() - 1]);
+        double length_to_phantom = 0.;
+        double total_length = 0.;
+        for (std::size_t position = 0; position < forward_geometry.size(); ++position)
+        {
+            const auto current = super::facade->GetCoordinateOfNode(forward_geometry[position]);
+            if (position == phantom.fwd_segment_position)
+            {
+                length_to_phantom = total_length + util::coordinate_calculation::haversineDistance(
+                                                       previous, phantom.location);
+            }
+            total_length += util::coordinate_calculation::haversineDistance(previous, current);
+            previous = current;
+        }
+        return static_cast<EdgeLength>(length_to_phantom - total_length / 2);
     }
 
     // Stalling
@@ -257,13 +1301,14 @@ class ManyToManyRouting final
     inline bool
     StallAtNode(const NodeID node, const EdgeWeight distance, QueryHeap &query_heap) const
     {
-        for (auto edge : super::facade->GetAdjacentEdgeRange(node))
+        for (auto edge : super::facade->GetDirectedEdgeRange(node, !forward_direction))
         {
-            const auto &data = super::facade->GetEdgeData(edge);
+            const auto adjacent_edge = super::facade->GetAdjacentEdge(edge);
+            const auto &data = adjacent_edge.data;
             const bool reverse_flag = ((!forward_direction) ? data.forward : data.backward);
             if (reverse_flag)
             {
-                const NodeID to = super::facade->GetTarget(edge);
+                const NodeID to = adjacent_edge.target;
                 const int edge_weight = data.distance;
                 BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
                 if (query_heap.WasInserted(to))
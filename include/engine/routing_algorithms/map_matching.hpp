@@ -1,14 +1,15 @@
 #ifndef MAP_MATCHING_HPP
 #define MAP_MATCHING_HPP
 
+#include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/routing_algorithms/routing_base.hpp"
 
 #include "engine/map_matching/hidden_markov_model.hpp"
 #include "engine/map_matching/matching_confidence.hpp"
+#include "engine/map_matching/matching_session.hpp"
 #include "engine/map_matching/sub_matching.hpp"
 
 #include "util/coordinate_calculation.hpp"
-#include "util/for_each_pair.hpp"
 #include "util/json_logger.hpp"
 
 #include <cstddef>
@@ -16,6 +17,7 @@
 #include <algorithm>
 #include <deque>
 #include <iomanip>
+#include <limits>
 #include <numeric>
 #include <utility>
 #include <vector>
@@ -44,9 +46,14 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
     using super = BasicRoutingInterface<DataFacadeT, MapMatching<DataFacadeT>>;
     using QueryHeap = SearchEngineData::QueryHeap;
     SearchEngineData &engine_working_data;
+    // computes the transitions between two layers of candidates with one bucket search
+    ManyToManyRouting<DataFacadeT> many_to_many;
     map_matching::EmissionLogProbability default_emission_log_probability;
     map_matching::TransitionLogProbability transition_log_probability;
     map_matching::MatchingConfidence confidence;
+    // 0 disables the respective limit of the states expanded per step, see SelectBeam
+    std::size_t beam_width;
+    double beam_range;
 
     unsigned GetMedianSampleTime(const std::vector<unsigned> &timestamps) const
     {
@@ -66,18 +73,228 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
   public:
     MapMatching(DataFacadeT *facade,
                 SearchEngineData &engine_working_data,
-                const double default_gps_precision)
+                const double default_gps_precision,
+                const std::size_t beam_width = 0,
+                const double beam_range = 0)
         : super(facade), engine_working_data(engine_working_data),
+          many_to_many(facade, engine_working_data),
           default_emission_log_probability(default_gps_precision),
-          transition_log_probability(MATCHING_BETA)
+          transition_log_probability(MATCHING_BETA), beam_width(beam_width), beam_range(beam_range)
     {
     }
 
+    // sample_time is the median time between the samples of the trace before it was thinned, see
+    // map_matching::ThinTrace. 0 takes it from the timestamps.
     SubMatchingList
     operator()(const CandidateLists &candidates_list,
                const std::vector<util::Coordinate> &trace_coordinates,
                const std::vector<unsigned> &trace_timestamps,
-               const std::vector<boost::optional<double>> &trace_gps_precision) const
+               const std::vector<boost::optional<double>> &trace_gps_precision,
+               const unsigned sample_time = 0) const
+    {
+        HMM model(candidates_list);
+        SetEmissionLogProbabilities(candidates_list, trace_gps_precision, 0, model);
+        return Match(
+            candidates_list, trace_coordinates, trace_timestamps, model, nullptr, sample_time);
+    }
+
+    // Matches the samples of a session request. The frontier of the previous request is used
+    // as first layer of the lattice and replaced by the last unbroken layer of this request,
+    // or invalidated if the trace could not be matched up to its end. The frontier shows up in
+    // the sub matchings with the SESSION_FRONTIER_INDEX.
+    SubMatchingList
+    operator()(const CandidateLists &candidates_list,
+               const std::vector<util::Coordinate> &trace_coordinates,
+               const std::vector<unsigned> &trace_timestamps,
+               const std::vector<boost::optional<double>> &trace_gps_precision,
+               map_matching::MatchingFrontier &frontier) const
+    {
+        if (!frontier.IsValid())
+        {
+            HMM model(candidates_list);
+            SetEmissionLogProbabilities(candidates_list, trace_gps_precision, 0, model);
+            if (candidates_list.size() < 2)
+            {
+                SetFrontier(candidates_list,
+                            trace_coordinates,
+                            trace_timestamps,
+                            model.emission_log_probabilities[0],
+                            0,
+                            frontier);
+                return {};
+            }
+            return Match(candidates_list, trace_coordinates, trace_timestamps, model, &frontier);
+        }
+
+        CandidateLists session_candidates;
+        session_candidates.reserve(candidates_list.size() + 1);
+        session_candidates.push_back(frontier.candidates);
+        session_candidates.insert(
+            session_candidates.end(), candidates_list.begin(), candidates_list.end());
+
+        std::vector<util::Coordinate> session_coordinates;
+        session_coordinates.reserve(trace_coordinates.size() + 1);
+        session_coordinates.push_back(frontier.coordinate);
+        session_coordinates.insert(
+            session_coordinates.end(), trace_coordinates.begin(), trace_coordinates.end());
+
+        std::vector<unsigned> session_timestamps;
+        if (!trace_timestamps.empty())
+        {
+            session_timestamps.reserve(trace_timestamps.size() + 1);
+            session_timestamps.push_back(frontier.timestamp ? *frontier.timestamp
+                                                            : trace_timestamps.front());
+            session_timestamps.insert(
+                session_timestamps.end(), trace_timestamps.begin(), trace_timestamps.end());
+        }
+
+        HMM model(session_candidates);
+        BOOST_ASSERT(frontier.viterbi.size() == model.emission_log_probabilities[0].size());
+        std::copy(frontier.viterbi.begin(),
+                  frontier.viterbi.end(),
+                  model.emission_log_probabilities[0].begin());
+        SetEmissionLogProbabilities(candidates_list, trace_gps_precision, 1, model);
+
+        auto sub_matchings =
+            Match(session_candidates, session_coordinates, session_timestamps, model, &frontier);
+
+        // map the lattice layers back to the request's coordinates
+        for (auto &sub_matching : sub_matchings)
+        {
+            for (auto &index : sub_matching.indices)
+            {
+                index = index == 0 ? map_matching::SESSION_FRONTIER_INDEX : index - 1;
+            }
+        }
+
+        return sub_matchings;
+    }
+
+  private:
+    // the emission probabilities of candidates_list[t] go to layer first_layer + t of the model
+    void
+    SetEmissionLogProbabilities(const CandidateLists &candidates_list,
+                                const std::vector<boost::optional<double>> &trace_gps_precision,
+                                const std::size_t first_layer,
+                                HMM &model) const
+    {
+        BOOST_ASSERT(first_layer + candidates_list.size() ==
+                     model.emission_log_probabilities.size());
+        for (auto t = 0UL; t < candidates_list.size(); ++t)
+        {
+            auto emission_log_probabilities = model.emission_log_probabilities[first_layer + t];
+            if (!trace_gps_precision.empty() && trace_gps_precision[t])
+            {
+                map_matching::EmissionLogProbability emission_log_probability(
+                    *trace_gps_precision[t]);
+                std::transform(
+                    candidates_list[t].begin(),
+                    candidates_list[t].end(),
+                    emission_log_probabilities.begin(),
+                    [&emission_log_probability](const PhantomNodeWithDistance &candidate) {
+                        return emission_log_probability(candidate.distance);
+                    });
+            }
+            else
+            {
+                std::transform(candidates_list[t].begin(),
+                               candidates_list[t].end(),
+                               emission_log_probabilities.begin(),
+                               [this](const PhantomNodeWithDistance &candidate) {
+                                   return default_emission_log_probability(candidate.distance);
+                               });
+            }
+        }
+    }
+
+    // The unpruned states of a layer that are expanded to the next one, in the order of the layer.
+    // With a beam only the beam_width most likely states and only the states within beam_range
+    // of the most likely one are expanded. That bounds the transitions routed per step to
+    // beam_width times the candidates of the next layer, dropped states can no longer be the
+    // parent of a state of the next layer.
+    void SelectBeam(const map_matching::LayeredValues<double>::ConstLayer &viterbi,
+                    const map_matching::LayeredValues<char>::ConstLayer &pruned,
+                    std::vector<std::size_t> &beam) const
+    {
+        beam.clear();
+        for (const auto s : util::irange<std::size_t>(0UL, viterbi.size()))
+        {
+            if (!pruned[s])
+            {
+                beam.push_back(s);
+            }
+        }
+
+        if (beam_range > 0 && !beam.empty())
+        {
+            const auto max_log_probability =
+                viterbi[*std::max_element(beam.begin(),
+                                          beam.end(),
+                                          [&viterbi](const std::size_t lhs, const std::size_t rhs) {
+                                              return viterbi[lhs] < viterbi[rhs];
+                                          })];
+            beam.erase(std::remove_if(beam.begin(),
+                                      beam.end(),
+                                      [&](const std::size_t s) {
+                                          return viterbi[s] < max_log_probability - beam_range;
+                                      }),
+                       beam.end());
+        }
+
+        if (beam_width > 0 && beam.size() > beam_width)
+        {
+            std::nth_element(beam.begin(),
+                             beam.begin() + beam_width,
+                             beam.end(),
+                             [&viterbi](const std::size_t lhs, const std::size_t rhs) {
+                                 return viterbi[lhs] > viterbi[rhs];
+                             });
+            beam.resize(beam_width);
+            std::sort(beam.begin(), beam.end());
+        }
+    }
+
+    // stores layer t as frontier, with the probabilities normalized to keep them in range
+    void SetFrontier(const CandidateLists &candidates_list,
+                     const std::vector<util::Coordinate> &trace_coordinates,
+                     const std::vector<unsigned> &trace_timestamps,
+                     const map_matching::LayeredValues<double>::ConstLayer &viterbi,
+                     const std::size_t t,
+                     map_matching::MatchingFrontier &frontier) const
+    {
+        frontier = map_matching::MatchingFrontier{};
+        if (t >= candidates_list.size() || candidates_list[t].empty())
+        {
+            return;
+        }
+
+        const auto max_log_probability = *std::max_element(viterbi.begin(), viterbi.end());
+        if (max_log_probability < map_matching::MINIMAL_LOG_PROB)
+        {
+            return;
+        }
+
+        frontier.candidates = candidates_list[t];
+        frontier.viterbi.reserve(viterbi.size());
+        for (const auto log_probability : viterbi)
+        {
+            frontier.viterbi.push_back(log_probability < map_matching::MINIMAL_LOG_PROB
+                                           ? map_matching::IMPOSSIBLE_LOG_PROB
+                                           : log_probability - max_log_probability);
+        }
+        frontier.coordinate = trace_coordinates[t];
+        if (!trace_timestamps.empty())
+        {
+            frontier.timestamp = trace_timestamps[t];
+        }
+    }
+
+    SubMatchingList Match(const CandidateLists &candidates_list,
+                          const std::vector<util::Coordinate> &trace_coordinates,
+                          const std::vector<unsigned> &trace_timestamps,
+                          HMM &model,
+                          map_matching::MatchingFrontier *frontier,
+                          const unsigned sample_time = 0) const
     {
         SubMatchingList sub_matchings;
 
@@ -96,7 +313,10 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                 return 1u;
             }
         }();
-        const auto max_broken_time = median_sample_time * MAX_BROKEN_STATES;
+        // a thinned trace breaks where the trace it was thinned from would break
+        const auto max_broken_time =
+            (use_timestamps && sample_time > 0 ? sample_time : median_sample_time) *
+            MAX_BROKEN_STATES;
         const auto max_distance_delta = [&] {
             if (use_timestamps)
             {
@@ -108,68 +328,46 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             }
         }();
 
-        std::vector<std::vector<double>> emission_log_probabilities(trace_coordinates.size());
-        if (trace_gps_precision.empty())
-        {
-            for (auto t = 0UL; t < candidates_list.size(); ++t)
-            {
-                emission_log_probabilities[t].resize(candidates_list[t].size());
-                std::transform(candidates_list[t].begin(),
-                               candidates_list[t].end(),
-                               emission_log_probabilities[t].begin(),
-                               [this](const PhantomNodeWithDistance &candidate) {
-                                   return default_emission_log_probability(candidate.distance);
-                               });
-            }
-        }
-        else
-        {
-            for (auto t = 0UL; t < candidates_list.size(); ++t)
-            {
-                emission_log_probabilities[t].resize(candidates_list[t].size());
-                if (trace_gps_precision[t])
-                {
-                    map_matching::EmissionLogProbability emission_log_probability(
-                        *trace_gps_precision[t]);
-                    std::transform(
-                        candidates_list[t].begin(),
-                        candidates_list[t].end(),
-                        emission_log_probabilities[t].begin(),
-                        [&emission_log_probability](const PhantomNodeWithDistance &candidate) {
-                            return emission_log_probability(candidate.distance);
-                        });
-                }
-                else
-                {
-                    std::transform(candidates_list[t].begin(),
-                                   candidates_list[t].end(),
-                                   emission_log_probabilities[t].begin(),
-                                   [this](const PhantomNodeWithDistance &candidate) {
-                                       return default_emission_log_probability(candidate.distance);
-                                   });
-                }
-            }
-        }
-
-        HMM model(candidates_list, emission_log_probabilities);
+        // step_distances[t] is the distance from trace coordinate t - 1 to t, all transitions
+        // between neighbouring timestamps use these
+        std::vector<double> step_distances(trace_coordinates.size(), 0.);
+        util::coordinate_calculation::haversineDistances(trace_coordinates.data(),
+                                                         trace_coordinates.data() + 1,
+                                                         trace_coordinates.size() - 1,
+                                                         step_distances.data() + 1);
 
         std::size_t initial_timestamp = model.initialize(0);
         if (initial_timestamp == map_matching::INVALID_STATE)
         {
+            if (frontier)
+            {
+                *frontier = map_matching::MatchingFrontier{};
+            }
             return sub_matchings;
         }
 
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-        engine_working_data.InitializeOrClearSecondThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-
-        QueryHeap &forward_heap = *(engine_working_data.forward_heap_1);
-        QueryHeap &reverse_heap = *(engine_working_data.reverse_heap_1);
-        QueryHeap &forward_core_heap = *(engine_working_data.forward_heap_2);
-        QueryHeap &reverse_core_heap = *(engine_working_data.reverse_heap_2);
+        const auto number_of_nodes = super::facade->GetNumberOfNodes();
+        auto forward_heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+        auto reverse_heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+        auto forward_core_heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+        auto reverse_core_heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+
+        QueryHeap &forward_heap = *forward_heap_handle;
+        QueryHeap &reverse_heap = *reverse_heap_handle;
+        QueryHeap &forward_core_heap = *forward_core_heap_handle;
+        QueryHeap &reverse_core_heap = *reverse_core_heap_handle;
+
+        // the bucket search needs a fully contracted graph, the core is searched pairwise
+        const bool use_many_to_many = super::facade->GetCoreSize() == 0;
+        std::vector<PhantomNode> source_phantoms;
+        std::vector<PhantomNode> target_phantoms;
+        std::vector<std::size_t> source_rows;
+        std::vector<std::size_t> beam;
+        std::vector<EdgeWeight> durations;
+        std::vector<std::vector<NodeID>> packed_paths;
 
         std::size_t breakage_begin = map_matching::INVALID_STATE;
+        bool lattice_exhausted = false;
         std::vector<std::size_t> split_points;
         std::vector<std::size_t> prev_unbroken_timestamps;
         prev_unbroken_timestamps.reserve(candidates_list.size());
@@ -209,6 +407,7 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                 // no new start was found -> stop viterbi calculation
                 if (new_start == map_matching::INVALID_STATE)
                 {
+                    lattice_exhausted = true;
                     break;
                 }
 
@@ -223,47 +422,80 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             BOOST_ASSERT(!prev_unbroken_timestamps.empty());
             const std::size_t prev_unbroken_timestamp = prev_unbroken_timestamps.back();
 
-            const auto &prev_viterbi = model.viterbi[prev_unbroken_timestamp];
-            const auto &prev_pruned = model.pruned[prev_unbroken_timestamp];
+            const auto prev_viterbi = model.viterbi[prev_unbroken_timestamp];
+            const auto prev_pruned = model.pruned[prev_unbroken_timestamp];
             const auto &prev_unbroken_timestamps_list = candidates_list[prev_unbroken_timestamp];
             const auto &prev_coordinate = trace_coordinates[prev_unbroken_timestamp];
 
-            auto &current_viterbi = model.viterbi[t];
-            auto &current_pruned = model.pruned[t];
-            auto &current_parents = model.parents[t];
-            auto &current_lengths = model.path_distances[t];
+            const auto current_emissions = model.emission_log_probabilities[t];
+            auto current_viterbi = model.viterbi[t];
+            auto current_pruned = model.pruned[t];
+            auto current_parents = model.parents[t];
+            auto current_lengths = model.path_distances[t];
             const auto &current_timestamps_list = candidates_list[t];
             const auto &current_coordinate = trace_coordinates[t];
 
-            const auto haversine_distance = util::coordinate_calculation::haversineDistance(
-                prev_coordinate, current_coordinate);
+            const auto haversine_distance =
+                prev_unbroken_timestamp + 1 == t
+                    ? step_distances[t]
+                    : util::coordinate_calculation::haversineDistance(prev_coordinate,
+                                                                      current_coordinate);
             // assumes minumum of 0.1 m/s
             const int duration_uppder_bound =
                 ((haversine_distance + max_distance_delta) * 0.25) * 10;
 
-            // compute d_t for this timestamp and the next one
-            for (const auto s : util::irange<std::size_t>(0UL, prev_viterbi.size()))
+            SelectBeam(prev_viterbi, prev_pruned, beam);
+
+            if (use_many_to_many)
             {
-                if (prev_pruned[s])
+                // all transitions from the expanded previous candidates at once
+                source_phantoms.clear();
+                source_rows.assign(prev_viterbi.size(), 0);
+                for (const auto s : beam)
                 {
-                    continue;
+                    source_rows[s] = source_phantoms.size();
+                    source_phantoms.push_back(prev_unbroken_timestamps_list[s].phantom_node);
+                }
+                target_phantoms.clear();
+                for (const auto &candidate : current_timestamps_list)
+                {
+                    target_phantoms.push_back(candidate.phantom_node);
                 }
+                many_to_many(source_phantoms,
+                             target_phantoms,
+                             duration_uppder_bound,
+                             durations,
+                             packed_paths);
+            }
 
+            // compute d_t for this timestamp and the next one
+            for (const auto s : beam)
+            {
                 for (const auto s_prime : util::irange<std::size_t>(0UL, current_viterbi.size()))
                 {
-                    const double emission_pr = emission_log_probabilities[t][s_prime];
+                    const double emission_pr = current_emissions[s_prime];
                     double new_value = prev_viterbi[s] + emission_pr;
                     if (current_viterbi[s_prime] > new_value)
                     {
                         continue;
                     }
 
-                    forward_heap.Clear();
-                    reverse_heap.Clear();
-
                     double network_distance;
-                    if (super::facade->GetCoreSize() > 0)
+                    if (use_many_to_many)
+                    {
+                        const auto entry = source_rows[s] * target_phantoms.size() + s_prime;
+                        network_distance =
+                            durations[entry] == INVALID_EDGE_WEIGHT
+                                ? std::numeric_limits<double>::max()
+                                : super::GetPathDistance(
+                                      packed_paths[entry],
+                                      prev_unbroken_timestamps_list[s].phantom_node,
+                                      current_timestamps_list[s_prime].phantom_node);
+                    }
+                    else
                     {
+                        forward_heap.Clear();
+                        reverse_heap.Clear();
                         forward_core_heap.Clear();
                         reverse_core_heap.Clear();
                         network_distance = super::GetNetworkDistanceWithCore(
@@ -275,14 +507,6 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                             current_timestamps_list[s_prime].phantom_node,
                             duration_uppder_bound);
                     }
-                    else
-                    {
-                        network_distance = super::GetNetworkDistance(
-                            forward_heap,
-                            reverse_heap,
-                            prev_unbroken_timestamps_list[s].phantom_node,
-                            current_timestamps_list[s_prime].phantom_node);
-                    }
 
                     // get distance diff between loc1/2 and locs/s_prime
                     const auto d_t = std::abs(network_distance - haversine_distance);
@@ -330,6 +554,26 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             split_points.push_back(prev_unbroken_timestamps.back() + 1);
         }
 
+        if (frontier)
+        {
+            if (lattice_exhausted || prev_unbroken_timestamps.empty())
+            {
+                *frontier = map_matching::MatchingFrontier{};
+            }
+            else
+            {
+                const auto last_unbroken_timestamp = prev_unbroken_timestamps.back();
+                SetFrontier(candidates_list,
+                            trace_coordinates,
+                            trace_timestamps,
+                            model.viterbi[last_unbroken_timestamp],
+                            last_unbroken_timestamp,
+                            *frontier);
+            }
+        }
+
+        std::vector<util::Coordinate> matched_coordinates;
+        std::vector<double> matched_distances;
         std::size_t sub_matching_begin = initial_timestamp;
         for (const auto sub_matching_end : split_points)
         {
@@ -354,12 +598,12 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             }
 
             // loop through the columns, and only compare the last entry
+            const auto parent_viterbi = model.viterbi[parent_timestamp_index];
             const auto max_element_iter =
-                std::max_element(model.viterbi[parent_timestamp_index].begin(),
-                                 model.viterbi[parent_timestamp_index].end());
+                std::max_element(parent_viterbi.begin(), parent_viterbi.end());
 
             std::size_t parent_candidate_index =
-                std::distance(model.viterbi[parent_timestamp_index].begin(), max_element_iter);
+                std::distance(parent_viterbi.begin(), max_element_iter);
 
             std::deque<std::pair<std::size_t, std::size_t>> reconstructed_indices;
             while (parent_timestamp_index > sub_matching_begin)
@@ -400,14 +644,18 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                     candidates_list[timestamp_index][location_index].phantom_node);
                 matching_distance += model.path_distances[timestamp_index][location_index];
             }
-            util::for_each_pair(
-                reconstructed_indices,
-                [&trace_distance,
-                 &trace_coordinates](const std::pair<std::size_t, std::size_t> &prev,
-                                     const std::pair<std::size_t, std::size_t> &curr) {
-                    trace_distance += util::coordinate_calculation::haversineDistance(
-                        trace_coordinates[prev.first], trace_coordinates[curr.first]);
-                });
+            matched_coordinates.clear();
+            for (const auto idx : reconstructed_indices)
+            {
+                matched_coordinates.push_back(trace_coordinates[idx.first]);
+            }
+            matched_distances.resize(matched_coordinates.size() - 1);
+            util::coordinate_calculation::haversineDistances(matched_coordinates.data(),
+                                                             matched_coordinates.data() + 1,
+                                                             matched_distances.size(),
+                                                             matched_distances.data());
+            trace_distance =
+                std::accumulate(matched_distances.begin(), matched_distances.end(), 0.0);
 
             matching.confidence = confidence(trace_distance, matching_distance);
 
@@ -0,0 +1,416 @@
+#ifndef MULTI_LEVEL_DIJKSTRA_HPP
+#define MULTI_LEVEL_DIJKSTRA_HPP
+
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "partition/cell_storage.hpp"
+#include "partition/multi_level_partition.hpp"
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+/// Bidirectional Dijkstra on the overlay graphs of a multi-level partition. At every node the
+/// search uses the highest level on which the node shares its cell with neither source nor
+/// target: the cliques of that cell plus the base arcs leaving it. Clique arcs are unpacked by a
+/// search inside of their cell on the next lower level.
+/// Every leg is routed on its own, so the direction at via points is not constrained.
+template <class DataFacadeT>
+class MultiLevelDijkstraRouting final
+    : public BasicRoutingInterface<DataFacadeT, MultiLevelDijkstraRouting<DataFacadeT>>
+{
+    using super = BasicRoutingInterface<DataFacadeT, MultiLevelDijkstraRouting<DataFacadeT>>;
+    using QueryHeap = SearchEngineData::MultiLevelQueryHeap;
+    using EdgeData = typename DataFacadeT::EdgeData;
+    SearchEngineData &engine_working_data;
+
+    // an arc of the overlay graph, level 0 stands for an arc of the base graph
+    struct PackedArc
+    {
+        NodeID from;
+        NodeID to;
+        partition::LevelID level;
+    };
+
+    partition::LevelID GetQueryLevel(const std::vector<NodeID> &endpoints,
+                                     const NodeID node) const
+    {
+        const auto &partition = super::facade->GetMultiLevelPartition();
+        partition::LevelID level = partition.GetNumberOfLevels() - 1;
+        for (const auto endpoint : endpoints)
+        {
+            level = std::min(level, partition.GetHighestDifferentLevel(endpoint, node));
+        }
+        return level;
+    }
+
+    static void Relax(QueryHeap &heap,
+                      const NodeID from,
+                      const NodeID to,
+                      const int weight,
+                      const bool from_clique)
+    {
+        if (!heap.WasInserted(to))
+        {
+            heap.Insert(to, weight, {from, from_clique});
+        }
+        else if (weight < heap.GetKey(to))
+        {
+            heap.GetData(to) = {from, from_clique};
+            heap.DecreaseKey(to, weight);
+        }
+    }
+
+    void RoutingStep(QueryHeap &forward_heap,
+                     QueryHeap &reverse_heap,
+                     const std::vector<NodeID> &endpoints,
+                     NodeID &middle_node,
+                     int &upper_bound,
+                     const bool forward_direction) const
+    {
+        const auto &partition = super::facade->GetMultiLevelPartition();
+        const NodeID node = forward_heap.DeleteMin();
+        const int weight = forward_heap.GetKey(node);
+        CheckQueryDeadline();
+
+        if (reverse_heap.WasInserted(node))
+        {
+            const int path_weight = weight + reverse_heap.GetKey(node);
+            // negative weights are paths that would leave the target segment before the source
+            if (path_weight >= 0 && path_weight < upper_bound)
+            {
+                middle_node = node;
+                upper_bound = path_weight;
+            }
+        }
+
+        const auto level = GetQueryLevel(endpoints, node);
+        if (level > 0)
+        {
+            const auto cell =
+                super::facade->GetCellStorage().GetCell(level, partition.GetCell(level, node));
+            if (forward_direction)
+            {
+                const auto source_index = cell.GetSourceIndex(node);
+                if (source_index < cell.GetNumberOfSources())
+                {
+                    for (const auto index :
+                         util::irange<std::uint32_t>(0, cell.GetNumberOfDestinations()))
+                    {
+                        const auto clique_weight = cell.GetWeight(source_index, index);
+                        if (clique_weight != INVALID_EDGE_WEIGHT)
+                        {
+                            Relax(forward_heap,
+                                  node,
+                                  cell.GetDestination(index),
+                                  weight + clique_weight,
+                                  true);
+                        }
+                    }
+                }
+            }
+            else
+            {
+                const auto destination_index = cell.GetDestinationIndex(node);
+                if (destination_index < cell.GetNumberOfDestinations())
+                {
+                    for (const auto index :
+                         util::irange<std::uint32_t>(0, cell.GetNumberOfSources()))
+                    {
+                        const auto clique_weight = cell.GetWeight(index, destination_index);
+                        if (clique_weight != INVALID_EDGE_WEIGHT)
+                        {
+                            Relax(forward_heap,
+                                  node,
+                                  cell.GetSource(index),
+                                  weight + clique_weight,
+                                  true);
+                        }
+                    }
+                }
+            }
+        }
+
+        for (const auto edge : super::facade->GetUncontractedAdjacentEdgeRange(node))
+        {
+            const auto &data = super::facade->GetUncontractedEdgeData(edge);
+            if (forward_direction ? !data.forward : !data.backward)
+                continue;
+
+            const NodeID target = super::facade->GetUncontractedTarget(edge);
+            // arcs inside of the cell are covered by its clique
+            if (level > 0 && partition.GetHighestDifferentLevel(node, target) < level)
+                continue;
+
+            Relax(forward_heap, node, target, weight + data.distance, false);
+        }
+    }
+
+    // Replaces a clique arc by the arcs of the next lower level, searching inside of its cell.
+    // The heap of a finished search is reused for this, it is cleared first.
+    void
+    UnpackClique(const PackedArc &arc, QueryHeap &heap, std::vector<PackedArc> &sub_arcs) const
+    {
+        const auto &partition = super::facade->GetMultiLevelPartition();
+        const auto &cells = super::facade->GetCellStorage();
+        const partition::LevelID sub_level = arc.level - 1;
+        const auto cell_id = partition.GetCell(arc.level, arc.from);
+
+        heap.Clear();
+        heap.Insert(arc.from, 0, {arc.from, false});
+        while (!heap.Empty())
+        {
+            const NodeID node = heap.DeleteMin();
+            if (node == arc.to)
+                break;
+            const int weight = heap.GetKey(node);
+
+            if (sub_level > 0)
+            {
+                const auto sub_cell = cells.GetCell(sub_level, partition.GetCell(sub_level, node));
+                const auto source_index = sub_cell.GetSourceIndex(node);
+                if (source_index < sub_cell.GetNumberOfSources())
+                {
+                    for (const auto index :
+                         util::irange<std::uint32_t>(0, sub_cell.GetNumberOfDestinations()))
+                    {
+                        const auto clique_weight = sub_cell.GetWeight(source_index, index);
+                        if (clique_weight != INVALID_EDGE_WEIGHT)
+                        {
+                            Relax(heap,
+                                  node,
+                                  sub_cell.GetDestination(index),
+                                  weight + clique_weight,
+                                  true);
+                        }
+                    }
+                }
+            }
+
+            for (const auto edge : super::facade->GetUncontractedAdjacentEdgeRange(node))
+            {
+                const auto &data = super::facade->GetUncontractedEdgeData(edge);
+                if (!data.forward)
+                    continue;
+
+                const NodeID target = super::facade->GetUncontractedTarget(edge);
+                if (partition.GetCell(arc.level, target) != cell_id)
+                    continue;
+                if (sub_level > 0 &&
+                    partition.GetCell(sub_level, node) == partition.GetCell(sub_level, target))
+                    continue;
+
+                Relax(heap, node, target, weight + data.distance, false);
+            }
+        }
+        BOOST_ASSERT_MSG(heap.WasInserted(arc.to), "clique arc can not be unpacked");
+
+        const auto first_sub_arc = sub_arcs.size();
+        for (NodeID node = arc.to; node != arc.from;)
+        {
+            const auto &data = heap.GetData(node);
+            sub_arcs.push_back(
+                PackedArc{data.parent, node, data.from_clique ? sub_level : partition::LevelID{0}});
+            node = data.parent;
+        }
+        std::reverse(sub_arcs.begin() + first_sub_arc, sub_arcs.end());
+    }
+
+    // the cheapest base arc from -> to
+    const EdgeData &FindBaseEdgeData(const NodeID from, const NodeID to) const
+    {
+        EdgeID best_edge = SPECIAL_EDGEID;
+        int best_weight = std::numeric_limits<int>::max();
+        for (const auto edge : super::facade->GetUncontractedAdjacentEdgeRange(from))
+        {
+            const auto &data = super::facade->GetUncontractedEdgeData(edge);
+            if (data.forward && super::facade->GetUncontractedTarget(edge) == to &&
+                data.distance < best_weight)
+            {
+                best_edge = edge;
+                best_weight = data.distance;
+            }
+        }
+        BOOST_ASSERT_MSG(best_edge != SPECIAL_EDGEID, "base arc of the path not found");
+        return super::facade->GetUncontractedEdgeData(best_edge);
+    }
+
+    // Returns the weight of the leg, INVALID_EDGE_WEIGHT if there is no route
+    int RouteLeg(const PhantomNodes &phantom_node_pair,
+                 bool &source_traversed_in_reverse,
+                 bool &target_traversed_in_reverse,
+                 std::vector<PathData> &unpacked_path) const
+    {
+        const auto &source_phantom = phantom_node_pair.source_phantom;
+        const auto &target_phantom = phantom_node_pair.target_phantom;
+
+        auto forward_heap_handle =
+            engine_working_data.GetHeap<QueryHeap>(super::facade->GetNumberOfNodes());
+        auto reverse_heap_handle =
+            engine_working_data.GetHeap<QueryHeap>(super::facade->GetNumberOfNodes());
+        QueryHeap &forward_heap = *forward_heap_handle;
+        QueryHeap &reverse_heap = *reverse_heap_handle;
+
+        std::vector<NodeID> endpoints;
+        if (source_phantom.forward_segment_id.enabled)
+        {
+            const NodeID node = source_phantom.forward_segment_id.id;
+            forward_heap.Insert(node, -source_phantom.GetForwardWeightPlusOffset(), {node, false});
+            endpoints.push_back(node);
+        }
+        if (source_phantom.reverse_segment_id.enabled)
+        {
+            const NodeID node = source_phantom.reverse_segment_id.id;
+            forward_heap.Insert(node, -source_phantom.GetReverseWeightPlusOffset(), {node, false});
+            endpoints.push_back(node);
+        }
+        // the copies of the target nodes are endpoints as well, see InsertTargetNode
+        const auto insert_target = [&](const NodeID node, const EdgeWeight weight) {
+            super::InsertTargetNode(reverse_heap, node, weight, [&](const NodeID parent) {
+                endpoints.push_back(parent);
+                return QueryHeap::DataType{parent, false};
+            });
+        };
+        if (target_phantom.forward_segment_id.enabled)
+        {
+            insert_target(target_phantom.forward_segment_id.id,
+                          target_phantom.GetForwardWeightPlusOffset());
+        }
+        if (target_phantom.reverse_segment_id.enabled)
+        {
+            insert_target(target_phantom.reverse_segment_id.id,
+                          target_phantom.GetReverseWeightPlusOffset());
+        }
+
+        NodeID middle_node = SPECIAL_NODEID;
+        int upper_bound = INVALID_EDGE_WEIGHT;
+        const auto min_key = [](const QueryHeap &heap) {
+            return heap.Empty() ? INVALID_EDGE_WEIGHT : heap.MinKey();
+        };
+        // no shorter path can meet once the smallest keys of both heaps exceed the best path
+        while (!forward_heap.Empty() && !reverse_heap.Empty() &&
+               static_cast<std::int64_t>(min_key(forward_heap)) + min_key(reverse_heap) <
+                   upper_bound)
+        {
+            RoutingStep(forward_heap, reverse_heap, endpoints, middle_node, upper_bound, true);
+            if (!reverse_heap.Empty())
+            {
+                RoutingStep(
+                    reverse_heap, forward_heap, endpoints, middle_node, upper_bound, false);
+            }
+        }
+
+        if (middle_node == SPECIAL_NODEID)
+        {
+            return INVALID_EDGE_WEIGHT;
+        }
+
+        // overlay arcs from the source to the middle node and on to the target
+        std::vector<PackedArc> packed_path;
+        NodeID source_node = middle_node;
+        while (forward_heap.GetData(source_node).parent != source_node)
+        {
+            const auto &data = forward_heap.GetData(source_node);
+            packed_path.push_back(PackedArc{
+                data.parent,
+                source_node,
+                data.from_clique ? GetQueryLevel(endpoints, data.parent) : partition::LevelID{0}});
+            source_node = data.parent;
+        }
+        std::reverse(packed_path.begin(), packed_path.end());
+        NodeID target_node = middle_node;
+        while (reverse_heap.GetData(target_node).parent != target_node)
+        {
+            const auto &data = reverse_heap.GetData(target_node);
+            packed_path.push_back(PackedArc{
+                target_node,
+                data.parent,
+                data.from_clique ? GetQueryLevel(endpoints, data.parent) : partition::LevelID{0}});
+            target_node = data.parent;
+        }
+
+        source_traversed_in_reverse = source_node != source_phantom.forward_segment_id.id;
+        target_traversed_in_reverse =
+            super::facade->GetOriginalNode(target_node) != target_phantom.forward_segment_id.id;
+
+        // unpack depth-first so that the base arcs come out in path order
+        std::vector<PackedArc> stack(packed_path.rbegin(), packed_path.rend());
+        std::vector<PackedArc> sub_arcs;
+        while (!stack.empty())
+        {
+            const PackedArc arc = stack.back();
+            stack.pop_back();
+            if (arc.level == 0)
+            {
+                super::AppendOriginalEdge(FindBaseEdgeData(arc.from, arc.to),
+                                          phantom_node_pair,
+                                          source_traversed_in_reverse,
+                                          unpacked_path);
+            }
+            else
+            {
+                sub_arcs.clear();
+                UnpackClique(arc, forward_heap, sub_arcs);
+                stack.insert(stack.end(), sub_arcs.rbegin(), sub_arcs.rend());
+            }
+        }
+        super::AppendTargetSegment(phantom_node_pair,
+                                   source_traversed_in_reverse,
+                                   target_traversed_in_reverse,
+                                   unpacked_path);
+
+        return upper_bound;
+    }
+
+  public:
+    MultiLevelDijkstraRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
+        : super(facade), engine_working_data(engine_working_data)
+    {
+    }
+
+    ~MultiLevelDijkstraRouting() {}
+
+    void operator()(const std::vector<PhantomNodes> &phantom_nodes_vector,
+                    InternalRouteResult &raw_route_data) const
+    {
+        BOOST_ASSERT(super::facade->HasMultiLevelData());
+
+        raw_route_data.shortest_path_length = 0;
+        raw_route_data.alternative_path_length = INVALID_EDGE_WEIGHT;
+        raw_route_data.unpacked_path_segments.resize(phantom_nodes_vector.size());
+        for (const auto leg : util::irange<std::size_t>(0UL, phantom_nodes_vector.size()))
+        {
+            bool source_traversed_in_reverse = false;
+            bool target_traversed_in_reverse = false;
+            const int weight = RouteLeg(phantom_nodes_vector[leg],
+                                        source_traversed_in_reverse,
+                                        target_traversed_in_reverse,
+                                        raw_route_data.unpacked_path_segments[leg]);
+            if (INVALID_EDGE_WEIGHT == weight)
+            {
+                raw_route_data.shortest_path_length = INVALID_EDGE_WEIGHT;
+                return;
+            }
+            raw_route_data.shortest_path_length += weight;
+            raw_route_data.source_traversed_in_reverse.push_back(source_traversed_in_reverse);
+            raw_route_data.target_traversed_in_reverse.push_back(target_traversed_in_reverse);
+        }
+    }
+};
+}
+}
+}
+
+#endif // MULTI_LEVEL_DIJKSTRA_HPP
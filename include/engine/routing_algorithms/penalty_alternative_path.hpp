@@ -0,0 +1,506 @@
+#ifndef PENALTY_ALTERNATIVE_PATH_ROUTING_HPP
+#define PENALTY_ALTERNATIVE_PATH_ROUTING_HPP
+
+#include "engine/routing_algorithms/alternative_path.hpp"
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/integer_range.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+/**
+ * Several alternative routes by the penalty method: searches with raised weights on the edges of
+ * the shortest path find routes that avoid parts of it.
+ *
+ * Every candidate search raises the weights of the whole shortest path a little and those of one
+ * section of it a lot, each candidate another section. The candidates thus do not depend on each
+ * other and are searched at the same time, every one with the heaps of its worker and its own
+ * penalties. The graph and its weights are not changed.
+ *
+ * The searches run on the contracted graph, the penalty of a shortcut is the sum of the penalties
+ * of the edges it stands for. The contraction only kept the shortcuts that are shortest for the
+ * unpenalized weights, so a search finds the best up-down path under the penalties and not always
+ * the best path, which is enough to find candidates. They are kept by their true lengths like
+ * the alternative of AlternativeRouting: at most VIAPATH_EPSILON longer than the shortest path
+ * and sharing at most VIAPATH_GAMMA of its length with it and with every other kept route.
+ */
+template <class DataFacadeT>
+class PenaltyAlternativeRouting final
+    : private BasicRoutingInterface<DataFacadeT, PenaltyAlternativeRouting<DataFacadeT>>
+{
+    using super = BasicRoutingInterface<DataFacadeT, PenaltyAlternativeRouting<DataFacadeT>>;
+    using EdgeData = typename DataFacadeT::EdgeData;
+    using QueryHeap = SearchEngineData::QueryHeap;
+
+    const static constexpr bool DO_NOT_FORCE_LOOP = false;
+
+    // Raised weights of a candidate search, in percent of the weights of the edges leaving the
+    // nodes. The penalties of packed edges are remembered, shortcuts share most of their edges.
+    struct PenaltyOverlay
+    {
+        std::unordered_map<NodeID, unsigned> node_penalties;
+        std::unordered_map<std::uint64_t, EdgeWeight> edge_penalties;
+    };
+
+    struct Candidate
+    {
+        std::vector<NodeID> packed_path;
+        // the path unpacked and the weights of the edges between its nodes
+        std::vector<NodeID> nodes;
+        std::vector<EdgeWeight> weights;
+        EdgeWeight length = INVALID_EDGE_WEIGHT;
+    };
+
+    SearchEngineData &engine_working_data;
+
+  public:
+    // the shortest path is split into this many sections per requested alternative
+    static const constexpr std::size_t CANDIDATES_PER_ALTERNATIVE = 2;
+    static const constexpr std::size_t MAX_CANDIDATES = 16;
+    // raised weights, in percent, of the whole shortest path and of the avoided section
+    static const constexpr unsigned PATH_PENALTY = 25;
+    static const constexpr unsigned SECTION_PENALTY = 300;
+
+    using super::UseUnpackingCache;
+
+    PenaltyAlternativeRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
+        : super(facade), engine_working_data(engine_working_data)
+    {
+    }
+
+    virtual ~PenaltyAlternativeRouting() {}
+
+    void operator()(const PhantomNodes &phantom_node_pair,
+                    const unsigned number_of_alternatives,
+                    InternalRouteResult &raw_route_data) const
+    {
+        const auto number_of_nodes = super::facade->GetNumberOfNodes();
+
+        Candidate shortest_path;
+        {
+            auto forward_heap = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+            auto reverse_heap = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+            InsertPhantomNodes(phantom_node_pair, *forward_heap, *reverse_heap);
+            EdgeWeight distance = INVALID_EDGE_WEIGHT;
+            super::Search(*forward_heap,
+                          *reverse_heap,
+                          distance,
+                          shortest_path.packed_path,
+                          DO_NOT_FORCE_LOOP,
+                          DO_NOT_FORCE_LOOP);
+            if (INVALID_EDGE_WEIGHT == distance)
+            {
+                return;
+            }
+            shortest_path.length = distance;
+        }
+        BOOST_ASSERT(!shortest_path.packed_path.empty());
+        AppendRoute(phantom_node_pair, shortest_path, raw_route_data);
+
+        // a path looping over a single node is not avoided by any other
+        const bool path_is_a_loop = shortest_path.packed_path.size() == 2 &&
+                                    shortest_path.packed_path.front() ==
+                                        shortest_path.packed_path.back();
+        if (number_of_alternatives == 0 || path_is_a_loop)
+        {
+            return;
+        }
+        UnpackNodes(shortest_path);
+
+        const auto number_of_candidates = std::min<std::size_t>(
+            MAX_CANDIDATES, CANDIDATES_PER_ALTERNATIVE * number_of_alternatives);
+        auto candidates = SearchCandidates(phantom_node_pair, shortest_path, number_of_candidates);
+
+        std::sort(candidates.begin(),
+                  candidates.end(),
+                  [](const Candidate &lhs, const Candidate &rhs) {
+                      return lhs.length < rhs.length;
+                  });
+
+        // the edges of the kept routes, by their nodes
+        std::vector<std::unordered_set<std::uint64_t>> route_edges(1);
+        InsertEdges(shortest_path, route_edges.front());
+        const auto maximum_length = shortest_path.length * (1 + VIAPATH_EPSILON);
+        const auto maximum_sharing = shortest_path.length * VIAPATH_GAMMA;
+        for (const auto &candidate : candidates)
+        {
+            if (route_edges.size() > number_of_alternatives)
+            {
+                break;
+            }
+            if (INVALID_EDGE_WEIGHT == candidate.length || candidate.length > maximum_length)
+            {
+                continue;
+            }
+            const bool shares_too_much = std::any_of(
+                route_edges.begin(),
+                route_edges.end(),
+                [&](const std::unordered_set<std::uint64_t> &edges) {
+                    return Sharing(candidate, edges) > maximum_sharing;
+                });
+            if (shares_too_much)
+            {
+                continue;
+            }
+            route_edges.emplace_back();
+            InsertEdges(candidate, route_edges.back());
+            AppendRoute(phantom_node_pair, candidate, raw_route_data);
+        }
+    }
+
+  private:
+    void InsertPhantomNodes(const PhantomNodes &phantom_node_pair,
+                            QueryHeap &forward_heap,
+                            QueryHeap &reverse_heap) const
+    {
+        const auto &source_phantom = phantom_node_pair.source_phantom;
+        const auto &target_phantom = phantom_node_pair.target_phantom;
+        if (source_phantom.forward_segment_id.enabled)
+        {
+            forward_heap.Insert(source_phantom.forward_segment_id.id,
+                                -source_phantom.GetForwardWeightPlusOffset(),
+                                source_phantom.forward_segment_id.id);
+        }
+        if (source_phantom.reverse_segment_id.enabled)
+        {
+            forward_heap.Insert(source_phantom.reverse_segment_id.id,
+                                -source_phantom.GetReverseWeightPlusOffset(),
+                                source_phantom.reverse_segment_id.id);
+        }
+        if (target_phantom.forward_segment_id.enabled)
+        {
+            super::InsertTargetNode(reverse_heap,
+                                    target_phantom.forward_segment_id.id,
+                                    target_phantom.GetForwardWeightPlusOffset());
+        }
+        if (target_phantom.reverse_segment_id.enabled)
+        {
+            super::InsertTargetNode(reverse_heap,
+                                    target_phantom.reverse_segment_id.id,
+                                    target_phantom.GetReverseWeightPlusOffset());
+        }
+    }
+
+    // The first route is the shortest path, then the alternative of the via node search and
+    // the further alternatives
+    void AppendRoute(const PhantomNodes &phantom_node_pair,
+                     const Candidate &route,
+                     InternalRouteResult &raw_route_data) const
+    {
+        const bool source_traversed_in_reverse =
+            route.packed_path.front() != phantom_node_pair.source_phantom.forward_segment_id.id;
+        const bool target_traversed_in_reverse =
+            super::facade->GetOriginalNode(route.packed_path.back()) !=
+            phantom_node_pair.target_phantom.forward_segment_id.id;
+
+        std::vector<PathData> *unpacked_path = nullptr;
+        if (!raw_route_data.is_valid())
+        {
+            raw_route_data.unpacked_path_segments.resize(1);
+            raw_route_data.source_traversed_in_reverse.push_back(source_traversed_in_reverse);
+            raw_route_data.target_traversed_in_reverse.push_back(target_traversed_in_reverse);
+            raw_route_data.shortest_path_length = route.length;
+            unpacked_path = &raw_route_data.unpacked_path_segments.front();
+        }
+        else if (!raw_route_data.has_alternative())
+        {
+            raw_route_data.alt_source_traversed_in_reverse.push_back(source_traversed_in_reverse);
+            raw_route_data.alt_target_traversed_in_reverse.push_back(target_traversed_in_reverse);
+            raw_route_data.alternative_path_length = route.length;
+            unpacked_path = &raw_route_data.unpacked_alternative;
+        }
+        else
+        {
+            raw_route_data.further_alternatives.emplace_back();
+            auto &alternative = raw_route_data.further_alternatives.back();
+            alternative.source_traversed_in_reverse = source_traversed_in_reverse;
+            alternative.target_traversed_in_reverse = target_traversed_in_reverse;
+            alternative.length = route.length;
+            unpacked_path = &alternative.unpacked_path;
+        }
+        super::UnpackPath(
+            route.packed_path.begin(), route.packed_path.end(), phantom_node_pair, *unpacked_path);
+    }
+
+    std::vector<Candidate> SearchCandidates(const PhantomNodes &phantom_node_pair,
+                                            const Candidate &shortest_path,
+                                            const std::size_t number_of_candidates) const
+    {
+        // the section of a node is the part of the path length its edge starts in
+        std::vector<std::size_t> sections(shortest_path.weights.size());
+        EdgeWeight path_weight = 0;
+        for (const auto index : util::irange<std::size_t>(0UL, shortest_path.weights.size()))
+        {
+            sections[index] = std::min<std::size_t>(
+                number_of_candidates - 1,
+                number_of_candidates * static_cast<std::uint64_t>(path_weight) /
+                    std::max(1, shortest_path.length));
+            path_weight += shortest_path.weights[index];
+        }
+
+        std::vector<Candidate> candidates(number_of_candidates);
+        auto *const statistics = ActiveSearchStatistics();
+        const auto *const deadline = ActiveQueryDeadline();
+        const auto time_slot = ActiveTimeSlot();
+        tbb::enumerable_thread_specific<SearchStatistics> thread_local_statistics;
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_candidates, 1),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                const SearchStatisticsScope statistics_scope(
+                    statistics ? &thread_local_statistics.local() : nullptr);
+                const QueryDeadlineScope deadline_scope(deadline);
+                const TimeSlotScope time_slot_scope(time_slot);
+
+                const auto number_of_nodes = super::facade->GetNumberOfNodes();
+                auto forward_heap = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+                auto reverse_heap = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+
+                for (auto candidate = range.begin(); candidate != range.end(); ++candidate)
+                {
+                    PenaltyOverlay overlay;
+                    for (const auto index : util::irange<std::size_t>(0UL, sections.size()))
+                    {
+                        overlay.node_penalties[shortest_path.nodes[index]] +=
+                            PATH_PENALTY + (sections[index] == candidate ? SECTION_PENALTY : 0);
+                    }
+
+                    forward_heap->Clear();
+                    reverse_heap->Clear();
+                    InsertPhantomNodes(phantom_node_pair, *forward_heap, *reverse_heap);
+                    SearchCandidate(*forward_heap, *reverse_heap, overlay, candidates[candidate]);
+                }
+            });
+
+        if (statistics)
+        {
+            for (const auto &worker_statistics : thread_local_statistics)
+            {
+                *statistics += worker_statistics;
+            }
+        }
+        return candidates;
+    }
+
+    // Bidirectional search with the weights of the overlay. Stall-on-demand compares the
+    // unpenalized weights, so no node is stalled.
+    void SearchCandidate(QueryHeap &forward_heap,
+                         QueryHeap &reverse_heap,
+                         PenaltyOverlay &overlay,
+                         Candidate &candidate) const
+    {
+        NodeID middle_node = SPECIAL_NODEID;
+        EdgeWeight upper_bound = INVALID_EDGE_WEIGHT;
+        const auto min_edge_offset = std::min(0, forward_heap.MinKey());
+        while (0 < (forward_heap.Size() + reverse_heap.Size()))
+        {
+            if (0 < forward_heap.Size())
+            {
+                PenalizedRoutingStep(forward_heap,
+                                     reverse_heap,
+                                     middle_node,
+                                     upper_bound,
+                                     min_edge_offset,
+                                     true,
+                                     overlay);
+            }
+            if (0 < reverse_heap.Size())
+            {
+                PenalizedRoutingStep(reverse_heap,
+                                     forward_heap,
+                                     middle_node,
+                                     upper_bound,
+                                     min_edge_offset,
+                                     false,
+                                     overlay);
+            }
+        }
+
+        // loops are no alternatives to a path between different nodes
+        if (SPECIAL_NODEID == middle_node ||
+            upper_bound != forward_heap.GetKey(middle_node) + reverse_heap.GetKey(middle_node))
+        {
+            return;
+        }
+        super::RetrievePackedPathFromHeap(
+            forward_heap, reverse_heap, middle_node, candidate.packed_path);
+        UnpackNodes(candidate);
+
+        // the keys of the first and last node are the offsets of the phantom nodes
+        candidate.length = forward_heap.GetKey(candidate.packed_path.front()) +
+                           reverse_heap.GetKey(candidate.packed_path.back());
+        for (const auto weight : candidate.weights)
+        {
+            candidate.length += weight;
+        }
+    }
+
+    void PenalizedRoutingStep(QueryHeap &forward_heap,
+                              QueryHeap &reverse_heap,
+                              NodeID &middle_node,
+                              EdgeWeight &upper_bound,
+                              const EdgeWeight min_edge_offset,
+                              const bool forward_direction,
+                              PenaltyOverlay &overlay) const
+    {
+        const NodeID node = forward_heap.DeleteMin();
+        const EdgeWeight distance = forward_heap.GetKey(node);
+
+        CheckQueryDeadline();
+        auto *const statistics = ActiveSearchStatistics();
+        if (statistics)
+        {
+            ++statistics->settled_nodes;
+        }
+
+        if (reverse_heap.WasInserted(node))
+        {
+            super::UpdateMiddleNode(forward_heap,
+                                    reverse_heap,
+                                    node,
+                                    reverse_heap.GetKey(node) + distance,
+                                    middle_node,
+                                    upper_bound,
+                                    forward_direction,
+                                    DO_NOT_FORCE_LOOP,
+                                    DO_NOT_FORCE_LOOP);
+        }
+
+        if (distance + min_edge_offset > upper_bound)
+        {
+            forward_heap.DeleteAll();
+            return;
+        }
+
+        for (const auto edge : super::facade->GetDirectedEdgeRange(node, forward_direction))
+        {
+            const auto adjacent_edge = super::facade->GetAdjacentEdge(edge);
+            const EdgeData &data = adjacent_edge.data;
+            if (!(forward_direction ? data.forward : data.backward))
+            {
+                continue;
+            }
+            if (statistics)
+            {
+                ++statistics->relaxed_edges;
+            }
+
+            // the reverse search follows the edges of the path backwards
+            const NodeID to = adjacent_edge.target;
+            const NodeID path_from = forward_direction ? node : to;
+            const NodeID path_to = forward_direction ? to : node;
+            const EdgeWeight penalty =
+                data.shortcut
+                    ? Penalty(path_from, data.id, overlay) + Penalty(data.id, path_to, overlay)
+                    : NodePenalty(path_from, data.distance, overlay);
+            const EdgeWeight to_distance = distance + data.distance + penalty;
+
+            if (!forward_heap.WasInserted(to))
+            {
+                forward_heap.Insert(to, to_distance, node);
+            }
+            else if (to_distance < forward_heap.GetKey(to))
+            {
+                forward_heap.GetData(to).parent = node;
+                forward_heap.DecreaseKey(to, to_distance);
+            }
+        }
+    }
+
+    EdgeWeight
+    NodePenalty(const NodeID from, const EdgeWeight weight, const PenaltyOverlay &overlay) const
+    {
+        const auto penalty = overlay.node_penalties.find(from);
+        return penalty == overlay.node_penalties.end() ? 0 : weight * penalty->second / 100;
+    }
+
+    // Penalty of the packed edge (from, to) of a path, the sum of those of its original edges
+    EdgeWeight Penalty(const NodeID from, const NodeID to, PenaltyOverlay &overlay) const
+    {
+        const auto key = static_cast<std::uint64_t>(from) << 32 | to;
+        const auto known = overlay.edge_penalties.find(key);
+        if (known != overlay.edge_penalties.end())
+        {
+            return known->second;
+        }
+
+        const EdgeData &data = super::facade->GetEdgeData(super::FindSmallestEdge(from, to));
+        const EdgeWeight penalty =
+            data.shortcut ? Penalty(from, data.id, overlay) + Penalty(data.id, to, overlay)
+                          : NodePenalty(from, data.distance, overlay);
+        overlay.edge_penalties.emplace(key, penalty);
+        return penalty;
+    }
+
+    void UnpackNodes(Candidate &route) const
+    {
+        route.nodes.clear();
+        route.weights.clear();
+        if (route.packed_path.size() == 1)
+        {
+            route.nodes.push_back(route.packed_path.front());
+            return;
+        }
+        for (const auto index : util::irange<std::size_t>(1UL, route.packed_path.size()))
+        {
+            // UnpackEdge appends both ends of the edge
+            if (!route.nodes.empty())
+            {
+                route.nodes.pop_back();
+            }
+            super::UnpackEdge(route.packed_path[index - 1], route.packed_path[index], route.nodes);
+        }
+        for (const auto index : util::irange<std::size_t>(1UL, route.nodes.size()))
+        {
+            const auto edge = super::FindSmallestEdge(route.nodes[index - 1], route.nodes[index]);
+            route.weights.push_back(super::facade->GetEdgeData(edge).distance);
+        }
+    }
+
+    static std::uint64_t EdgeKey(const Candidate &route, const std::size_t index)
+    {
+        return static_cast<std::uint64_t>(route.nodes[index]) << 32 | route.nodes[index + 1];
+    }
+
+    static void InsertEdges(const Candidate &route, std::unordered_set<std::uint64_t> &edges)
+    {
+        for (const auto index : util::irange<std::size_t>(0UL, route.weights.size()))
+        {
+            edges.insert(EdgeKey(route, index));
+        }
+    }
+
+    static EdgeWeight Sharing(const Candidate &route,
+                              const std::unordered_set<std::uint64_t> &edges)
+    {
+        EdgeWeight sharing = 0;
+        for (const auto index : util::irange<std::size_t>(0UL, route.weights.size()))
+        {
+            if (edges.count(EdgeKey(route, index)) > 0)
+            {
+                sharing += route.weights[index];
+            }
+        }
+        return sharing;
+    }
+};
+}
+}
+}
+
+#endif // PENALTY_ALTERNATIVE_PATH_ROUTING_HPP
@@ -0,0 +1,146 @@
+#ifndef QUERY_STRATEGY_HPP
+#define QUERY_STRATEGY_HPP
+
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstdint>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+// Policies of the bidirectional search on the contracted graph, see
+// BasicRoutingInterface::RoutingStep. All combinations find the same shortest paths, they only
+// differ in the number of nodes they touch and the work per node. The engine uses
+// DefaultQueryStrategy, the query-strategy-bench compares the combinations on a dataset.
+
+// Stalling policies decide whether a settled node can be skipped because its key is larger
+// than its distance, which is what makes searches on a contracted graph small.
+struct NoStalling
+{
+    template <typename DataFacadeT, typename HeapT>
+    static bool IsStalled(const DataFacadeT &, HeapT &, const NodeID, const EdgeWeight, bool)
+    {
+        return false;
+    }
+};
+
+// The node is reached more cheaply from a node in the heap over an edge of the other direction
+struct StallOnDemand
+{
+    template <typename DataFacadeT, typename HeapT>
+    static bool IsStalled(const DataFacadeT &facade,
+                          HeapT &heap,
+                          const NodeID node,
+                          const EdgeWeight distance,
+                          const bool forward_direction)
+    {
+        for (const auto edge : facade.GetDirectedEdgeRange(node, !forward_direction))
+        {
+            const auto adjacent_edge = facade.GetAdjacentEdge(edge);
+            const auto &data = adjacent_edge.data;
+            const bool reverse_flag = ((!forward_direction) ? data.forward : data.backward);
+            if (reverse_flag)
+            {
+                const NodeID to = adjacent_edge.target;
+                const EdgeWeight edge_weight = data.distance;
+
+                BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
+
+                if (heap.WasInserted(to) && heap.GetKey(to) + edge_weight < distance)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+// Termination policies. A direction always stops once its smallest key plus the edge offset
+// exceeds the best path found so far. Pruning also keeps such nodes out of the heap: keys only
+// grow and the keys of the other direction are at least the edge offset, so no path over them
+// can be shorter.
+struct StopAtUpperBound
+{
+    static bool IsPruned(const std::int32_t, const std::int32_t, const std::int32_t)
+    {
+        return false;
+    }
+};
+
+struct PruneAtUpperBound
+{
+    static bool IsPruned(const std::int32_t distance,
+                         const std::int32_t min_edge_offset,
+                         const std::int32_t upper_bound)
+    {
+        return distance + min_edge_offset > upper_bound;
+    }
+};
+
+// Interleaving policies pick the directions that take a step in the next round
+struct SearchRound
+{
+    bool forward;
+    bool reverse;
+};
+
+// A step of each direction per round
+struct Alternating
+{
+    template <typename HeapT>
+    static SearchRound NextRound(const HeapT &forward_heap, const HeapT &reverse_heap)
+    {
+        return {!forward_heap.Empty(), !reverse_heap.Empty()};
+    }
+};
+
+// The direction with the smaller key, keeps both search radii about the same
+struct SmallerKeyFirst
+{
+    template <typename HeapT>
+    static SearchRound NextRound(const HeapT &forward_heap, const HeapT &reverse_heap)
+    {
+        if (forward_heap.Empty() || reverse_heap.Empty())
+        {
+            return {!forward_heap.Empty(), !reverse_heap.Empty()};
+        }
+        const bool forward = forward_heap.MinKey() <= reverse_heap.MinKey();
+        return {forward, !forward};
+    }
+};
+
+// The direction with fewer nodes in its heap, keeps both search spaces about the same size
+struct SmallerHeapFirst
+{
+    template <typename HeapT>
+    static SearchRound NextRound(const HeapT &forward_heap, const HeapT &reverse_heap)
+    {
+        if (forward_heap.Empty() || reverse_heap.Empty())
+        {
+            return {!forward_heap.Empty(), !reverse_heap.Empty()};
+        }
+        const bool forward = forward_heap.Size() <= reverse_heap.Size();
+        return {forward, !forward};
+    }
+};
+
+template <typename StallingT, typename TerminationT, typename InterleavingT> struct QueryStrategy
+{
+    using Stalling = StallingT;
+    using Termination = TerminationT;
+    using Interleaving = InterleavingT;
+};
+
+using DefaultQueryStrategy = QueryStrategy<StallOnDemand, StopAtUpperBound, Alternating>;
+}
+}
+}
+
+#endif // QUERY_STRATEGY_HPP
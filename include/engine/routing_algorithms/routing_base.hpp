@@ -2,12 +2,21 @@
 #define ROUTING_BASE_HPP
 
 #include "extractor/guidance/turn_instruction.hpp"
+#include "engine/core_landmarks.hpp"
 #include "engine/internal_route_result.hpp"
+#include "engine/metrics.hpp"
+#include "engine/query_deadline.hpp"
+#include "engine/routing_algorithms/query_strategy.hpp"
 #include "engine/search_engine_data.hpp"
+#include "engine/search_statistics.hpp"
+#include "engine/time_slot.hpp"
+#include "engine/unpacking_cache.hpp"
+#include "util/arena.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/assert.hpp>
+#include <boost/optional.hpp>
 
 #include <cstddef>
 #include <cstdint>
@@ -34,14 +43,44 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
 
   protected:
     DataFacadeT *facade;
+    UnpackingCache *unpacking_cache = nullptr;
+    const CoreLandmarks *core_landmarks = nullptr;
 
   public:
     explicit BasicRoutingInterface(DataFacadeT *facade) : facade(facade) {}
     ~BasicRoutingInterface() {}
 
+    // optional, shortcuts of packed paths are unpacked from the cache if they are in there
+    void UseUnpackingCache(UnpackingCache *cache) { unpacking_cache = cache; }
+
+    // optional, searches in the core of a partially contracted graph run A* with the landmarks
+    void UseCoreLandmarks(const CoreLandmarks *landmarks) { core_landmarks = landmarks; }
+
     BasicRoutingInterface(const BasicRoutingInterface &) = delete;
     BasicRoutingInterface &operator=(const BasicRoutingInterface &) = delete;
 
+    // Inserts a target node into the reverse heap along with the copies via-way restrictions
+    // made of it. Routes from the from way of such a restriction reach the via way on a copy only,
+    // so a target there has to be reachable on the copies as well.
+    template <typename HeapT, typename MakeDataT>
+    void InsertTargetNode(HeapT &reverse_heap,
+                          const NodeID node,
+                          const EdgeWeight weight,
+                          const MakeDataT &make_data) const
+    {
+        reverse_heap.Insert(node, weight, make_data(node));
+        for (const NodeID duplicate : facade->GetDuplicatedNodes(node))
+        {
+            reverse_heap.Insert(duplicate, weight, make_data(duplicate));
+        }
+    }
+
+    template <typename HeapT>
+    void InsertTargetNode(HeapT &reverse_heap, const NodeID node, const EdgeWeight weight) const
+    {
+        InsertTargetNode(reverse_heap, node, weight, [](const NodeID parent) { return parent; });
+    }
+
     /*
     min_edge_offset is needed in case we use multiple
     nodes as start/target nodes with different (even negative) offsets.
@@ -71,57 +110,37 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
     Since we are dealing with a graph that contains _negative_ edges,
     we need to add an offset to the termination criterion.
     */
-    void RoutingStep(SearchEngineData::QueryHeap &forward_heap,
-                     SearchEngineData::QueryHeap &reverse_heap,
+    template <typename Strategy = DefaultQueryStrategy, typename HeapT>
+    void RoutingStep(HeapT &forward_heap,
+                     HeapT &reverse_heap,
                      NodeID &middle_node_id,
                      std::int32_t &upper_bound,
                      std::int32_t min_edge_offset,
                      const bool forward_direction,
-                     const bool stalling,
                      const bool force_loop_forward,
                      const bool force_loop_reverse) const
     {
         const NodeID node = forward_heap.DeleteMin();
         const std::int32_t distance = forward_heap.GetKey(node);
 
+        CheckQueryDeadline();
+        auto *const statistics = ActiveSearchStatistics();
+        if (statistics)
+        {
+            ++statistics->settled_nodes;
+        }
+
         if (reverse_heap.WasInserted(node))
         {
-            const std::int32_t new_distance = reverse_heap.GetKey(node) + distance;
-            if (new_distance < upper_bound)
-            {
-                // if loops are forced, they are so at the source
-                if (new_distance >= 0 &&
-                    (!force_loop_forward || forward_heap.GetData(node).parent != node) &&
-                    (!force_loop_reverse || reverse_heap.GetData(node).parent != node))
-                {
-                    middle_node_id = node;
-                    upper_bound = new_distance;
-                }
-                else
-                {
-                    // check whether there is a loop present at the node
-                    for (const auto edge : facade->GetAdjacentEdgeRange(node))
-                    {
-                        const EdgeData &data = facade->GetEdgeData(edge);
-                        bool forward_directionFlag =
-                            (forward_direction ? data.forward : data.backward);
-                        if (forward_directionFlag)
-                        {
-                            const NodeID to = facade->GetTarget(edge);
-                            if (to == node)
-                            {
-                                const EdgeWeight edge_weight = data.distance;
-                                const std::int32_t loop_distance = new_distance + edge_weight;
-                                if (loop_distance >= 0 && loop_distance < upper_bound)
-                                {
-                                    middle_node_id = node;
-                                    upper_bound = loop_distance;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+            UpdateMiddleNode(forward_heap,
+                             reverse_heap,
+                             node,
+                             reverse_heap.GetKey(node) + distance,
+                             middle_node_id,
+                             upper_bound,
+                             forward_direction,
+                             force_loop_forward,
+                             force_loop_reverse);
         }
 
         // make sure we don't terminate too early if we initialize the distance
@@ -133,43 +152,38 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             return;
         }
 
-        // Stalling
-        if (stalling)
+        if (Strategy::Stalling::IsStalled(
+                *facade, forward_heap, node, distance, forward_direction))
         {
-            for (const auto edge : facade->GetAdjacentEdgeRange(node))
+            if (statistics)
             {
-                const EdgeData &data = facade->GetEdgeData(edge);
-                const bool reverse_flag = ((!forward_direction) ? data.forward : data.backward);
-                if (reverse_flag)
-                {
-                    const NodeID to = facade->GetTarget(edge);
-                    const EdgeWeight edge_weight = data.distance;
-
-                    BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
-
-                    if (forward_heap.WasInserted(to))
-                    {
-                        if (forward_heap.GetKey(to) + edge_weight < distance)
-                        {
-                            return;
-                        }
-                    }
-                }
+                ++statistics->stalled_nodes;
             }
+            return;
         }
 
-        for (const auto edge : facade->GetAdjacentEdgeRange(node))
+        const auto edges = facade->GetDirectedEdgeRange(node, forward_direction);
+        PrefetchTargets(forward_heap, edges);
+
+        std::uint64_t relaxed_edges = 0;
+        for (const auto edge : edges)
         {
-            const EdgeData &data = facade->GetEdgeData(edge);
+            const auto adjacent_edge = facade->GetAdjacentEdge(edge);
+            const EdgeData &data = adjacent_edge.data;
             bool forward_directionFlag = (forward_direction ? data.forward : data.backward);
             if (forward_directionFlag)
             {
+                ++relaxed_edges;
 
-                const NodeID to = facade->GetTarget(edge);
+                const NodeID to = adjacent_edge.target;
                 const EdgeWeight edge_weight = data.distance;
 
                 BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
                 const int to_distance = distance + edge_weight;
+                if (Strategy::Termination::IsPruned(to_distance, min_edge_offset, upper_bound))
+                {
+                    continue;
+                }
 
                 // New Node discovered -> Add to Heap + Node Info Storage
                 if (!forward_heap.WasInserted(to))
@@ -185,12 +199,156 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 }
             }
         }
+        if (statistics)
+        {
+            statistics->relaxed_edges += relaxed_edges;
+        }
+    }
+
+    // Starts loading the heap slots of the targets of edges before they are relaxed one after
+    // another. Only for heaps whose slots can be found without reading the heap.
+    template <typename HeapT>
+    void PrefetchTargets(const HeapT &heap, const datafacade::EdgeRange &edges) const
+    {
+        if (!HeapT::CAN_PREFETCH)
+        {
+            return;
+        }
+        for (const auto edge : edges)
+        {
+            heap.Prefetch(facade->GetTarget(edge));
+        }
+    }
+
+    // Takes the path of new_distance over node, where both searches met, if it is the best so far
+    template <typename HeapT>
+    void UpdateMiddleNode(const HeapT &forward_heap,
+                          const HeapT &reverse_heap,
+                          const NodeID node,
+                          const std::int32_t new_distance,
+                          NodeID &middle_node_id,
+                          std::int32_t &upper_bound,
+                          const bool forward_direction,
+                          const bool force_loop_forward,
+                          const bool force_loop_reverse) const
+    {
+        if (new_distance >= upper_bound)
+        {
+            return;
+        }
+
+        // if loops are forced, they are so at the source
+        if (new_distance >= 0 &&
+            (!force_loop_forward || forward_heap.GetData(node).parent != node) &&
+            (!force_loop_reverse || reverse_heap.GetData(node).parent != node))
+        {
+            middle_node_id = node;
+            upper_bound = new_distance;
+            return;
+        }
+
+        // check whether there is a loop present at the node
+        for (const auto edge : facade->GetDirectedEdgeRange(node, forward_direction))
+        {
+            const EdgeData &data = facade->GetEdgeData(edge);
+            bool forward_directionFlag = (forward_direction ? data.forward : data.backward);
+            if (forward_directionFlag)
+            {
+                const NodeID to = facade->GetTarget(edge);
+                if (to == node)
+                {
+                    const EdgeWeight edge_weight = data.distance;
+                    const std::int32_t loop_distance = new_distance + edge_weight;
+                    if (loop_distance >= 0 && loop_distance < upper_bound)
+                    {
+                        middle_node_id = node;
+                        upper_bound = loop_distance;
+                    }
+                }
+            }
+        }
+    }
+
+    // Like RoutingStep, but the heaps are ordered by twice the distance plus the potential of
+    // the node in the direction of the search, see CoreLandmarks::Potential.
+    template <typename HeapT>
+    void LandmarkRoutingStep(HeapT &forward_heap,
+                             HeapT &reverse_heap,
+                             const CoreLandmarks::Potential &potential,
+                             NodeID &middle_node_id,
+                             std::int32_t &upper_bound,
+                             const bool forward_direction,
+                             const bool force_loop_forward,
+                             const bool force_loop_reverse) const
+    {
+        const std::int32_t sign = forward_direction ? 1 : -1;
+        const NodeID node = forward_heap.DeleteMin();
+        const std::int32_t node_potential = sign * potential(node);
+        const std::int32_t distance = (forward_heap.GetKey(node) - node_potential) / 2;
+
+        CheckQueryDeadline();
+        auto *const statistics = ActiveSearchStatistics();
+        if (statistics)
+        {
+            ++statistics->settled_nodes;
+        }
+
+        if (reverse_heap.WasInserted(node))
+        {
+            const std::int32_t reverse_distance = (reverse_heap.GetKey(node) + node_potential) / 2;
+            UpdateMiddleNode(forward_heap,
+                             reverse_heap,
+                             node,
+                             reverse_distance + distance,
+                             middle_node_id,
+                             upper_bound,
+                             forward_direction,
+                             force_loop_forward,
+                             force_loop_reverse);
+        }
+
+        const auto edges = facade->GetDirectedEdgeRange(node, forward_direction);
+        PrefetchTargets(forward_heap, edges);
+
+        std::uint64_t relaxed_edges = 0;
+        for (const auto edge : edges)
+        {
+            const auto adjacent_edge = facade->GetAdjacentEdge(edge);
+            const EdgeData &data = adjacent_edge.data;
+            if (forward_direction ? data.forward : data.backward)
+            {
+                ++relaxed_edges;
+
+                const NodeID to = adjacent_edge.target;
+                const auto to_potential = potential(to);
+                if (to_potential == CoreLandmarks::Potential::UNREACHABLE)
+                {
+                    continue;
+                }
+
+                BOOST_ASSERT_MSG(data.distance > 0, "edge_weight invalid");
+                const int to_key = 2 * (distance + data.distance) + sign * to_potential;
+                if (!forward_heap.WasInserted(to))
+                {
+                    forward_heap.Insert(to, to_key, node);
+                }
+                else if (to_key < forward_heap.GetKey(to))
+                {
+                    forward_heap.GetData(to).parent = node;
+                    forward_heap.DecreaseKey(to, to_key);
+                }
+            }
+        }
+        if (statistics)
+        {
+            statistics->relaxed_edges += relaxed_edges;
+        }
     }
 
     inline EdgeWeight GetLoopWeight(NodeID node) const
     {
         EdgeWeight loop_weight = INVALID_EDGE_WEIGHT;
-        for (auto edge : facade->GetAdjacentEdgeRange(node))
+        for (auto edge : facade->GetDirectedEdgeRange(node, true))
         {
             const auto &data = facade->GetEdgeData(edge);
             if (data.forward)
@@ -211,72 +369,112 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                     const PhantomNodes &phantom_node_pair,
                     std::vector<PathData> &unpacked_path) const
     {
+        metrics::StageTimer timer(metrics::Stage::Unpacking);
+
         const bool start_traversed_in_reverse =
             (*packed_path_begin != phantom_node_pair.source_phantom.forward_segment_id.id);
+        // a path may end on a copy of the target node, see InsertTargetNode
+        const NodeID target_node = facade->GetOriginalNode(*std::prev(packed_path_end));
         const bool target_traversed_in_reverse =
-            (*std::prev(packed_path_end) != phantom_node_pair.target_phantom.forward_segment_id.id);
+            (target_node != phantom_node_pair.target_phantom.forward_segment_id.id);
 
         BOOST_ASSERT(std::distance(packed_path_begin, packed_path_end) > 0);
-        std::stack<std::pair<NodeID, NodeID>> recursion_stack;
+        BOOST_ASSERT(*packed_path_begin == phantom_node_pair.source_phantom.forward_segment_id.id ||
+                     *packed_path_begin == phantom_node_pair.source_phantom.reverse_segment_id.id);
+        BOOST_ASSERT(target_node == phantom_node_pair.target_phantom.forward_segment_id.id ||
+                     target_node == phantom_node_pair.target_phantom.reverse_segment_id.id);
 
-        // We have to push the path in reverse order onto the stack because it's LIFO.
-        for (auto current = std::prev(packed_path_end); current != packed_path_begin;
-             current = std::prev(current))
+        std::vector<EdgeID> original_edges;
+        for (auto current = packed_path_begin; std::next(current) != packed_path_end; ++current)
         {
-            recursion_stack.emplace(*std::prev(current), *current);
+            original_edges.clear();
+            UnpackPackedEdge(*current, *std::next(current), original_edges);
+            for (const auto original_edge : original_edges)
+            {
+                AppendOriginalEdge(facade->GetEdgeData(original_edge),
+                                   phantom_node_pair,
+                                   start_traversed_in_reverse,
+                                   unpacked_path);
+            }
         }
+        AppendTargetSegment(phantom_node_pair,
+                            start_traversed_in_reverse,
+                            target_traversed_in_reverse,
+                            unpacked_path);
+    }
 
-        BOOST_ASSERT(*packed_path_begin == phantom_node_pair.source_phantom.forward_segment_id.id ||
-                     *packed_path_begin == phantom_node_pair.source_phantom.reverse_segment_id.id);
-        BOOST_ASSERT(
-            *std::prev(packed_path_end) == phantom_node_pair.target_phantom.forward_segment_id.id ||
-            *std::prev(packed_path_end) == phantom_node_pair.target_phantom.reverse_segment_id.id);
-
-        std::pair<NodeID, NodeID> edge;
-        while (!recursion_stack.empty())
+    // Contraction might introduce double edges by inserting shortcuts, this searches for the
+    // smallest upwards edge (from, to) found by the forward search. If there is none, the edge
+    // must have been a downwards edge found by the reverse search.
+    EdgeID FindSmallestEdge(const NodeID from, const NodeID to) const
+    {
+        // from               to
+        //     *------------------>*
+        //            edge_id
+        EdgeID smaller_edge_id = SPECIAL_EDGEID;
+        EdgeWeight edge_weight = std::numeric_limits<EdgeWeight>::max();
+        for (const auto edge_id : facade->GetDirectedEdgeRange(from, true))
         {
-            // edge.first         edge.second
-            //     *------------------>*
-            //            edge_id
-            edge = recursion_stack.top();
-            recursion_stack.pop();
+            const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
+            if ((facade->GetTarget(edge_id) == to) && (weight < edge_weight) &&
+                facade->GetEdgeData(edge_id).forward)
+            {
+                smaller_edge_id = edge_id;
+                edge_weight = weight;
+            }
+        }
 
-            // Contraction might introduce double edges by inserting shortcuts
-            // this searching for the smallest upwards edge found by the forward search
-            EdgeID smaller_edge_id = SPECIAL_EDGEID;
-            EdgeWeight edge_weight = std::numeric_limits<EdgeWeight>::max();
-            for (const auto edge_id : facade->GetAdjacentEdgeRange(edge.first))
+        // from               to
+        //     *<------------------*
+        //            edge_id
+        if (SPECIAL_EDGEID == smaller_edge_id)
+        {
+            for (const auto edge_id : facade->GetDirectedEdgeRange(to, false))
             {
                 const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
-                if ((facade->GetTarget(edge_id) == edge.second) && (weight < edge_weight) &&
-                    facade->GetEdgeData(edge_id).forward)
+                if ((facade->GetTarget(edge_id) == from) && (weight < edge_weight) &&
+                    facade->GetEdgeData(edge_id).backward)
                 {
                     smaller_edge_id = edge_id;
                     edge_weight = weight;
                 }
             }
+        }
+        BOOST_ASSERT_MSG(edge_weight != std::numeric_limits<EdgeWeight>::max(),
+                         "edge weight invalid");
+        return smaller_edge_id;
+    }
 
-            // edge.first         edge.second
-            //     *<------------------*
-            //            edge_id
-            // if we don't find a forward edge, this edge must have been an downwards edge
-            // found by the reverse search.
-            if (SPECIAL_EDGEID == smaller_edge_id)
-            {
-                for (const auto edge_id : facade->GetAdjacentEdgeRange(edge.second))
-                {
-                    const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
-                    if ((facade->GetTarget(edge_id) == edge.first) && (weight < edge_weight) &&
-                        facade->GetEdgeData(edge_id).backward)
-                    {
-                        smaller_edge_id = edge_id;
-                        edge_weight = weight;
-                    }
-                }
-            }
-            BOOST_ASSERT_MSG(edge_weight != INVALID_EDGE_WEIGHT, "edge id invalid");
+    // Appends the original edges the edge (from, to) of a packed path stands for, in path order
+    void UnpackPackedEdge(const NodeID from,
+                          const NodeID to,
+                          std::vector<EdgeID> &original_edges) const
+    {
+        const EdgeID packed_edge = FindSmallestEdge(from, to);
+        if (!facade->GetEdgeData(packed_edge).shortcut)
+        {
+            original_edges.push_back(packed_edge);
+            return;
+        }
 
-            const EdgeData &ed = facade->GetEdgeData(smaller_edge_id);
+        // the smallest edges between two nodes depend on the weights of the time slot
+        const bool use_unpacking_cache = unpacking_cache && ActiveTimeSlot() == INVALID_TIME_SLOT;
+        if (use_unpacking_cache && unpacking_cache->Get(packed_edge, original_edges))
+        {
+            return;
+        }
+
+        const auto unpacked_begin = original_edges.size();
+        std::stack<std::pair<NodeID, NodeID>, util::ArenaVector<std::pair<NodeID, NodeID>>>
+            recursion_stack;
+        recursion_stack.emplace(from, to);
+        while (!recursion_stack.empty())
+        {
+            const auto edge = recursion_stack.top();
+            recursion_stack.pop();
+
+            const EdgeID edge_id = FindSmallestEdge(edge.first, edge.second);
+            const EdgeData &ed = facade->GetEdgeData(edge_id);
             if (ed.shortcut)
             { // unpack
                 const NodeID middle_node_id = ed.id;
@@ -286,60 +484,83 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             }
             else
             {
-                BOOST_ASSERT_MSG(!ed.shortcut, "original edge flagged as shortcut");
-                unsigned name_index = facade->GetNameIndexFromEdgeID(ed.id);
-                const auto turn_instruction = facade->GetTurnInstructionForEdgeID(ed.id);
-                const extractor::TravelMode travel_mode =
-                    (unpacked_path.empty() && start_traversed_in_reverse)
-                        ? phantom_node_pair.source_phantom.backward_travel_mode
-                        : facade->GetTravelModeForEdgeID(ed.id);
-
-                std::vector<NodeID> id_vector;
-                facade->GetUncompressedGeometry(facade->GetGeometryIndexForEdgeID(ed.id),
-                                                id_vector);
-                BOOST_ASSERT(id_vector.size() > 0);
-
-                std::vector<EdgeWeight> weight_vector;
-                facade->GetUncompressedWeights(facade->GetGeometryIndexForEdgeID(ed.id),
-                                               weight_vector);
-                BOOST_ASSERT(weight_vector.size() > 0);
-
-                auto total_weight = std::accumulate(weight_vector.begin(), weight_vector.end(), 0);
-
-                BOOST_ASSERT(weight_vector.size() == id_vector.size());
-                const bool is_first_segment = unpacked_path.empty();
-
-                const std::size_t start_index =
-                    (is_first_segment
-                         ? ((start_traversed_in_reverse)
-                                ? id_vector.size() -
-                                      phantom_node_pair.source_phantom.fwd_segment_position - 1
-                                : phantom_node_pair.source_phantom.fwd_segment_position)
-                         : 0);
-                const std::size_t end_index = id_vector.size();
-
-                BOOST_ASSERT(start_index >= 0);
-                BOOST_ASSERT(start_index < end_index);
-                for (std::size_t i = start_index; i < end_index; ++i)
-                {
-                    unpacked_path.push_back(
-                        PathData{id_vector[i],
-                                 name_index,
-                                 weight_vector[i],
-                                 extractor::guidance::TurnInstruction::NO_TURN(),
-                                 {{0, INVALID_LANEID}, INVALID_LANE_DESCRIPTIONID},
-                                 travel_mode,
-                                 INVALID_ENTRY_CLASSID});
-                }
-                BOOST_ASSERT(unpacked_path.size() > 0);
-                if (facade->hasLaneData(ed.id))
-                    unpacked_path.back().lane_data = facade->GetLaneData(ed.id);
-
-                unpacked_path.back().entry_classid = facade->GetEntryClassID(ed.id);
-                unpacked_path.back().turn_instruction = turn_instruction;
-                unpacked_path.back().duration_until_turn += (ed.distance - total_weight);
+                original_edges.push_back(edge_id);
             }
         }
+
+        if (use_unpacking_cache &&
+            original_edges.size() - unpacked_begin >= UnpackingCache::MIN_UNPACKED_EDGES)
+        {
+            unpacking_cache->Put(packed_edge,
+                                 std::vector<EdgeID>(original_edges.begin() + unpacked_begin,
+                                                     original_edges.end()));
+        }
+    }
+
+    // Appends the geometry of an original (not shortcut) edge of the edge-expanded graph
+    void AppendOriginalEdge(const EdgeData &ed,
+                            const PhantomNodes &phantom_node_pair,
+                            const bool start_traversed_in_reverse,
+                            std::vector<PathData> &unpacked_path) const
+    {
+        BOOST_ASSERT_MSG(!ed.shortcut, "original edge flagged as shortcut");
+        unsigned name_index = facade->GetNameIndexFromEdgeID(ed.id);
+        const auto turn_instruction = facade->GetTurnInstructionForEdgeID(ed.id);
+        const extractor::TravelMode travel_mode =
+            (unpacked_path.empty() && start_traversed_in_reverse)
+                ? phantom_node_pair.source_phantom.backward_travel_mode
+                : facade->GetTravelModeForEdgeID(ed.id);
+
+        std::vector<NodeID> id_vector;
+        facade->GetUncompressedGeometry(facade->GetGeometryIndexForEdgeID(ed.id), id_vector);
+        BOOST_ASSERT(id_vector.size() > 0);
+
+        std::vector<EdgeWeight> weight_vector;
+        facade->GetUncompressedWeights(facade->GetGeometryIndexForEdgeID(ed.id), weight_vector);
+        BOOST_ASSERT(weight_vector.size() > 0);
+
+        auto total_weight = std::accumulate(weight_vector.begin(), weight_vector.end(), 0);
+
+        BOOST_ASSERT(weight_vector.size() == id_vector.size());
+        const bool is_first_segment = unpacked_path.empty();
+
+        const std::size_t start_index =
+            (is_first_segment
+                 ? ((start_traversed_in_reverse)
+                        ? id_vector.size() -
+                              phantom_node_pair.source_phantom.fwd_segment_position - 1
+                        : phantom_node_pair.source_phantom.fwd_segment_position)
+                 : 0);
+        const std::size_t end_index = id_vector.size();
+
+        BOOST_ASSERT(start_index >= 0);
+        BOOST_ASSERT(start_index < end_index);
+        for (std::size_t i = start_index; i < end_index; ++i)
+        {
+            unpacked_path.push_back(PathData{id_vector[i],
+                                             name_index,
+                                             weight_vector[i],
+                                             extractor::guidance::TurnInstruction::NO_TURN(),
+                                             {{0, INVALID_LANEID}, INVALID_LANE_DESCRIPTIONID},
+                                             travel_mode,
+                                             INVALID_ENTRY_CLASSID});
+        }
+        BOOST_ASSERT(unpacked_path.size() > 0);
+        if (facade->hasLaneData(ed.id))
+            unpacked_path.back().lane_data = facade->GetLaneData(ed.id);
+
+        unpacked_path.back().entry_classid = facade->GetEntryClassID(ed.id);
+        unpacked_path.back().turn_instruction = turn_instruction;
+        unpacked_path.back().duration_until_turn += (ed.distance - total_weight);
+    }
+
+    // Appends the part of the target segment up to the target phantom node and fixes up the
+    // partial first and last segments. Needs to be called after the last original edge.
+    void AppendTargetSegment(const PhantomNodes &phantom_node_pair,
+                             const bool start_traversed_in_reverse,
+                             const bool target_traversed_in_reverse,
+                             std::vector<PathData> &unpacked_path) const
+    {
         std::size_t start_index = 0, end_index = 0;
         std::vector<unsigned> id_vector;
         std::vector<EdgeWeight> weight_vector;
@@ -442,7 +663,8 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
 
     void UnpackEdge(const NodeID s, const NodeID t, std::vector<NodeID> &unpacked_path) const
     {
-        std::stack<std::pair<NodeID, NodeID>> recursion_stack;
+        std::stack<std::pair<NodeID, NodeID>, util::ArenaVector<std::pair<NodeID, NodeID>>>
+            recursion_stack;
         recursion_stack.emplace(s, t);
 
         std::pair<NodeID, NodeID> edge;
@@ -451,35 +673,7 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             edge = recursion_stack.top();
             recursion_stack.pop();
 
-            EdgeID smaller_edge_id = SPECIAL_EDGEID;
-            EdgeWeight edge_weight = std::numeric_limits<EdgeWeight>::max();
-            for (const auto edge_id : facade->GetAdjacentEdgeRange(edge.first))
-            {
-                const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
-                if ((facade->GetTarget(edge_id) == edge.second) && (weight < edge_weight) &&
-                    facade->GetEdgeData(edge_id).forward)
-                {
-                    smaller_edge_id = edge_id;
-                    edge_weight = weight;
-                }
-            }
-
-            if (SPECIAL_EDGEID == smaller_edge_id)
-            {
-                for (const auto edge_id : facade->GetAdjacentEdgeRange(edge.second))
-                {
-                    const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
-                    if ((facade->GetTarget(edge_id) == edge.first) && (weight < edge_weight) &&
-                        facade->GetEdgeData(edge_id).backward)
-                    {
-                        smaller_edge_id = edge_id;
-                        edge_weight = weight;
-                    }
-                }
-            }
-            BOOST_ASSERT_MSG(edge_weight != std::numeric_limits<EdgeWeight>::max(),
-                             "edge weight invalid");
-
+            const EdgeID smaller_edge_id = FindSmallestEdge(edge.first, edge.second);
             const EdgeData &ed = facade->GetEdgeData(smaller_edge_id);
             if (ed.shortcut)
             { // unpack
@@ -497,8 +691,9 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         unpacked_path.emplace_back(t);
     }
 
-    void RetrievePackedPathFromHeap(const SearchEngineData::QueryHeap &forward_heap,
-                                    const SearchEngineData::QueryHeap &reverse_heap,
+    template <typename HeapT>
+    void RetrievePackedPathFromHeap(const HeapT &forward_heap,
+                                    const HeapT &reverse_heap,
                                     const NodeID middle_node_id,
                                     std::vector<NodeID> &packed_path) const
     {
@@ -508,7 +703,8 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         RetrievePackedPathFromSingleHeap(reverse_heap, middle_node_id, packed_path);
     }
 
-    void RetrievePackedPathFromSingleHeap(const SearchEngineData::QueryHeap &search_heap,
+    template <typename HeapT>
+    void RetrievePackedPathFromSingleHeap(const HeapT &search_heap,
                                           const NodeID middle_node_id,
                                           std::vector<NodeID> &packed_path) const
     {
@@ -532,8 +728,9 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
     // && source_phantom.GetForwardWeightPlusOffset() > target_phantom.GetForwardWeightPlusOffset())
     // requires
     // a force loop, if the heaps have been initialized with positive offsets.
-    void Search(SearchEngineData::QueryHeap &forward_heap,
-                SearchEngineData::QueryHeap &reverse_heap,
+    template <typename Strategy = DefaultQueryStrategy, typename HeapT>
+    void Search(HeapT &forward_heap,
+                HeapT &reverse_heap,
                 std::int32_t &distance,
                 std::vector<NodeID> &packed_leg,
                 const bool force_loop_forward,
@@ -550,32 +747,30 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         BOOST_ASSERT(reverse_heap.MinKey() >= 0);
 
         // run two-Target Dijkstra routing step.
-        const constexpr bool STALLING_ENABLED = true;
         while (0 < (forward_heap.Size() + reverse_heap.Size()))
         {
-            if (!forward_heap.Empty())
+            const auto round = Strategy::Interleaving::NextRound(forward_heap, reverse_heap);
+            if (round.forward)
             {
-                RoutingStep(forward_heap,
-                            reverse_heap,
-                            middle,
-                            distance,
-                            min_edge_offset,
-                            true,
-                            STALLING_ENABLED,
-                            force_loop_forward,
-                            force_loop_reverse);
+                RoutingStep<Strategy>(forward_heap,
+                                      reverse_heap,
+                                      middle,
+                                      distance,
+                                      min_edge_offset,
+                                      true,
+                                      force_loop_forward,
+                                      force_loop_reverse);
             }
-            if (!reverse_heap.Empty())
+            if (round.reverse)
             {
-                RoutingStep(reverse_heap,
-                            forward_heap,
-                            middle,
-                            distance,
-                            min_edge_offset,
-                            false,
-                            STALLING_ENABLED,
-                            force_loop_reverse,
-                            force_loop_forward);
+                RoutingStep<Strategy>(reverse_heap,
+                                      forward_heap,
+                                      middle,
+                                      distance,
+                                      min_edge_offset,
+                                      false,
+                                      force_loop_reverse,
+                                      force_loop_forward);
             }
         }
 
@@ -612,6 +807,8 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
     // && source_phantom.GetForwardWeightPlusOffset() > target_phantom.GetForwardWeightPlusOffset())
     // requires
     // a force loop, if the heaps have been initialized with positive offsets.
+    // The core is not contracted, its search never stalls.
+    template <typename Strategy = DefaultQueryStrategy>
     void SearchWithCore(SearchEngineData::QueryHeap &forward_heap,
                         SearchEngineData::QueryHeap &reverse_heap,
                         SearchEngineData::QueryHeap &forward_core_heap,
@@ -633,11 +830,11 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         // we only every insert negative offsets for nodes in the forward heap
         BOOST_ASSERT(reverse_heap.MinKey() >= 0);
 
-        const constexpr bool STALLING_ENABLED = true;
         // run two-Target Dijkstra routing step.
         while (0 < (forward_heap.Size() + reverse_heap.Size()))
         {
-            if (!forward_heap.Empty())
+            const auto round = Strategy::Interleaving::NextRound(forward_heap, reverse_heap);
+            if (round.forward)
             {
                 if (facade->IsCoreNode(forward_heap.Min()))
                 {
@@ -647,18 +844,17 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 }
                 else
                 {
-                    RoutingStep(forward_heap,
-                                reverse_heap,
-                                middle,
-                                distance,
-                                min_edge_offset,
-                                true,
-                                STALLING_ENABLED,
-                                force_loop_forward,
-                                force_loop_reverse);
+                    RoutingStep<Strategy>(forward_heap,
+                                          reverse_heap,
+                                          middle,
+                                          distance,
+                                          min_edge_offset,
+                                          true,
+                                          force_loop_forward,
+                                          force_loop_reverse);
                 }
             }
-            if (!reverse_heap.Empty())
+            if (round.reverse)
             {
                 if (facade->IsCoreNode(reverse_heap.Min()))
                 {
@@ -668,15 +864,14 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 }
                 else
                 {
-                    RoutingStep(reverse_heap,
-                                forward_heap,
-                                middle,
-                                distance,
-                                min_edge_offset,
-                                false,
-                                STALLING_ENABLED,
-                                force_loop_reverse,
-                                force_loop_forward);
+                    RoutingStep<Strategy>(reverse_heap,
+                                          forward_heap,
+                                          middle,
+                                          distance,
+                                          min_edge_offset,
+                                          false,
+                                          force_loop_reverse,
+                                          force_loop_forward);
                 }
             }
         }
@@ -689,6 +884,22 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         std::sort(forward_entry_points.begin(), forward_entry_points.end(), entry_point_comparator);
         std::sort(reverse_entry_points.begin(), reverse_entry_points.end(), entry_point_comparator);
 
+        // with landmarks the core heaps hold twice the distance plus the potential of a node. The
+        // landmark distances are no lower bounds for the weights of a time slot.
+        boost::optional<CoreLandmarks::Potential> potential;
+        if (core_landmarks && core_landmarks->GetNumberOfLandmarks() > 0 &&
+            ActiveTimeSlot() == INVALID_TIME_SLOT)
+        {
+            potential.emplace(
+                core_landmarks->GetPotential(forward_entry_points, reverse_entry_points));
+        }
+        const std::int32_t key_factor = potential ? 2 : 1;
+        const auto get_core_key = [&potential](const NodeID node,
+                                               const EdgeWeight weight,
+                                               const std::int32_t sign) {
+            return potential ? 2 * weight + sign * (*potential)(node) : weight;
+        };
+
         NodeID last_id = SPECIAL_NODEID;
         forward_core_heap.Clear();
         reverse_core_heap.Clear();
@@ -698,8 +909,12 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             {
                 continue;
             }
-            forward_core_heap.Insert(p.first, p.second, p.first);
             last_id = p.first;
+            if (potential && (*potential)(p.first) == CoreLandmarks::Potential::UNREACHABLE)
+            {
+                continue;
+            }
+            forward_core_heap.Insert(p.first, get_core_key(p.first, p.second, 1), p.first);
         }
         last_id = SPECIAL_NODEID;
         for (const auto &p : reverse_entry_points)
@@ -708,46 +923,98 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             {
                 continue;
             }
-            reverse_core_heap.Insert(p.first, p.second, p.first);
             last_id = p.first;
+            if (potential && (*potential)(p.first) == CoreLandmarks::Potential::UNREACHABLE)
+            {
+                continue;
+            }
+            reverse_core_heap.Insert(p.first, get_core_key(p.first, p.second, -1), p.first);
         }
 
-        // get offset to account for offsets on phantom nodes on compressed edges
-        int min_core_edge_offset = 0;
-        if (forward_core_heap.Size() > 0)
+        if (potential)
         {
-            min_core_edge_offset = std::min(min_core_edge_offset, forward_core_heap.MinKey());
+            // The potentials of both directions add up to zero, so the sum of the smallest keys
+            // is a lower bound on the paths that were not found yet.
+            while (0 < forward_core_heap.Size() && 0 < reverse_core_heap.Size() &&
+                   2 * static_cast<std::int64_t>(distance) >
+                       static_cast<std::int64_t>(forward_core_heap.MinKey()) +
+                           reverse_core_heap.MinKey())
+            {
+                LandmarkRoutingStep(forward_core_heap,
+                                    reverse_core_heap,
+                                    *potential,
+                                    middle,
+                                    distance,
+                                    true,
+                                    force_loop_forward,
+                                    force_loop_reverse);
+                if (0 == reverse_core_heap.Size())
+                {
+                    break;
+                }
+                LandmarkRoutingStep(reverse_core_heap,
+                                    forward_core_heap,
+                                    *potential,
+                                    middle,
+                                    distance,
+                                    false,
+                                    force_loop_reverse,
+                                    force_loop_forward);
+            }
         }
-        if (reverse_core_heap.Size() > 0 && reverse_core_heap.MinKey() < 0)
+        else
         {
-            min_core_edge_offset = std::min(min_core_edge_offset, reverse_core_heap.MinKey());
+            // get offset to account for offsets on phantom nodes on compressed edges
+            int min_core_edge_offset = 0;
+            if (forward_core_heap.Size() > 0)
+            {
+                min_core_edge_offset = std::min(min_core_edge_offset, forward_core_heap.MinKey());
+            }
+            if (reverse_core_heap.Size() > 0 && reverse_core_heap.MinKey() < 0)
+            {
+                min_core_edge_offset = std::min(min_core_edge_offset, reverse_core_heap.MinKey());
+            }
+            BOOST_ASSERT(min_core_edge_offset <= 0);
+
+            // run two-target Dijkstra routing step on core with termination criterion
+            using CoreStrategy = QueryStrategy<NoStalling,
+                                               typename Strategy::Termination,
+                                               typename Strategy::Interleaving>;
+            while (0 < forward_core_heap.Size() && 0 < reverse_core_heap.Size() &&
+                   distance > (forward_core_heap.MinKey() + reverse_core_heap.MinKey()))
+            {
+                const auto round =
+                    CoreStrategy::Interleaving::NextRound(forward_core_heap, reverse_core_heap);
+                if (round.forward)
+                {
+                    RoutingStep<CoreStrategy>(forward_core_heap,
+                                              reverse_core_heap,
+                                              middle,
+                                              distance,
+                                              min_core_edge_offset,
+                                              true,
+                                              force_loop_forward,
+                                              force_loop_reverse);
+                }
+                if (round.reverse)
+                {
+                    RoutingStep<CoreStrategy>(reverse_core_heap,
+                                              forward_core_heap,
+                                              middle,
+                                              distance,
+                                              min_core_edge_offset,
+                                              false,
+                                              force_loop_reverse,
+                                              force_loop_forward);
+                }
+            }
         }
-        BOOST_ASSERT(min_core_edge_offset <= 0);
 
-        // run two-target Dijkstra routing step on core with termination criterion
-        const constexpr bool STALLING_DISABLED = false;
-        while (0 < forward_core_heap.Size() && 0 < reverse_core_heap.Size() &&
-               distance > (forward_core_heap.MinKey() + reverse_core_heap.MinKey()))
+        // the core heaps were cleared for this search, the nodes it took from them are settled
+        if (auto *const statistics = ActiveSearchStatistics())
         {
-            RoutingStep(forward_core_heap,
-                        reverse_core_heap,
-                        middle,
-                        distance,
-                        min_core_edge_offset,
-                        true,
-                        STALLING_DISABLED,
-                        force_loop_forward,
-                        force_loop_reverse);
-
-            RoutingStep(reverse_core_heap,
-                        forward_core_heap,
-                        middle,
-                        distance,
-                        min_core_edge_offset,
-                        false,
-                        STALLING_DISABLED,
-                        force_loop_reverse,
-                        force_loop_forward);
+            statistics->core_settled_nodes +=
+                forward_core_heap.NumberOfRemovedNodes() + reverse_core_heap.NumberOfRemovedNodes();
         }
 
         // No path found for both target nodes?
@@ -764,7 +1031,8 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         // we need to unpack sub path from core heaps
         if (facade->IsCoreNode(middle))
         {
-            if (distance != forward_core_heap.GetKey(middle) + reverse_core_heap.GetKey(middle))
+            if (key_factor * distance !=
+                forward_core_heap.GetKey(middle) + reverse_core_heap.GetKey(middle))
             {
                 // self loop
                 BOOST_ASSERT(forward_core_heap.GetData(middle).parent == middle &&
@@ -907,15 +1175,15 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
 
         if (target_phantom.forward_segment_id.enabled)
         {
-            reverse_heap.Insert(target_phantom.forward_segment_id.id,
-                                target_phantom.GetForwardWeightPlusOffset(),
-                                target_phantom.forward_segment_id.id);
+            InsertTargetNode(reverse_heap,
+                             target_phantom.forward_segment_id.id,
+                             target_phantom.GetForwardWeightPlusOffset());
         }
         if (target_phantom.reverse_segment_id.enabled)
         {
-            reverse_heap.Insert(target_phantom.reverse_segment_id.id,
-                                target_phantom.GetReverseWeightPlusOffset(),
-                                target_phantom.reverse_segment_id.id);
+            InsertTargetNode(reverse_heap,
+                             target_phantom.reverse_segment_id.id,
+                             target_phantom.GetReverseWeightPlusOffset());
         }
 
         const bool constexpr DO_NOT_FORCE_LOOPS =
@@ -968,15 +1236,15 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
 
         if (target_phantom.forward_segment_id.enabled)
         {
-            reverse_heap.Insert(target_phantom.forward_segment_id.id,
-                                target_phantom.GetForwardWeightPlusOffset(),
-                                target_phantom.forward_segment_id.id);
+            InsertTargetNode(reverse_heap,
+                             target_phantom.forward_segment_id.id,
+                             target_phantom.GetForwardWeightPlusOffset());
         }
         if (target_phantom.reverse_segment_id.enabled)
         {
-            reverse_heap.Insert(target_phantom.reverse_segment_id.id,
-                                target_phantom.GetReverseWeightPlusOffset(),
-                                target_phantom.reverse_segment_id.id);
+            InsertTargetNode(reverse_heap,
+                             target_phantom.reverse_segment_id.id,
+                             target_phantom.GetReverseWeightPlusOffset());
         }
 
         const bool constexpr DO_NOT_FORCE_LOOPS =
@@ -5,12 +5,22 @@
 
 #include "engine/routing_algorithms/routing_base.hpp"
 
+#include "engine/query_deadline.hpp"
 #include "engine/search_engine_data.hpp"
+#include "engine/search_statistics.hpp"
+#include "engine/time_slot.hpp"
 #include "util/integer_range.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/optional.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <vector>
+
 namespace osrm
 {
 namespace engine
@@ -26,10 +36,136 @@ class ShortestPathRouting final
     using QueryHeap = SearchEngineData::QueryHeap;
     SearchEngineData &engine_working_data;
     const static constexpr bool DO_NOT_FORCE_LOOP = false;
+    // below this many legs scheduling overhead outweighs parallel searches
+    const static constexpr std::size_t PARALLEL_SEARCH_MIN_LEGS = 8;
+    const bool parallel_searches;
+
+    // Like Search to both directions of the target, which search from the same source
+    // distances. The forward search runs once over its whole search space, which on the
+    // contracted graph is hardly larger than the one of a bidirectional search, and each target
+    // direction only searches backwards until no path over the forward search space can be
+    // shorter. The backward search of a waypoint does not help the forward search of the next
+    // leg, the two follow the edges into and out of the waypoint.
+    void SearchToBothTargetNodes(QueryHeap &forward_heap,
+                                 QueryHeap &reverse_heap,
+                                 const bool search_from_forward_node,
+                                 const bool search_from_reverse_node,
+                                 const PhantomNode &source_phantom,
+                                 const PhantomNode &target_phantom,
+                                 const int total_distance_to_forward,
+                                 const int total_distance_to_reverse,
+                                 int &new_total_distance_to_forward,
+                                 int &new_total_distance_to_reverse,
+                                 std::vector<NodeID> &leg_packed_path_forward,
+                                 std::vector<NodeID> &leg_packed_path_reverse) const
+    {
+        forward_heap.Clear();
+        reverse_heap.Clear();
+        if (search_from_forward_node)
+        {
+            forward_heap.Insert(source_phantom.forward_segment_id.id,
+                                total_distance_to_forward -
+                                    source_phantom.GetForwardWeightPlusOffset(),
+                                source_phantom.forward_segment_id.id);
+        }
+        if (search_from_reverse_node)
+        {
+            forward_heap.Insert(source_phantom.reverse_segment_id.id,
+                                total_distance_to_reverse -
+                                    source_phantom.GetReverseWeightPlusOffset(),
+                                source_phantom.reverse_segment_id.id);
+        }
+        BOOST_ASSERT(forward_heap.Size() > 0);
+        const auto min_edge_offset = std::min(0, forward_heap.MinKey());
+
+        // without a target nothing bounds the forward search
+        NodeID no_middle = SPECIAL_NODEID;
+        int no_upper_bound = INVALID_EDGE_WEIGHT;
+        while (!forward_heap.Empty())
+        {
+            super::RoutingStep(forward_heap,
+                               reverse_heap,
+                               no_middle,
+                               no_upper_bound,
+                               min_edge_offset,
+                               true,
+                               DO_NOT_FORCE_LOOP,
+                               DO_NOT_FORCE_LOOP);
+        }
+
+        // the keys of the settled forward nodes stay in the heap, the backward searches meet
+        // them when they settle a node the forward search reached
+        const auto search_to = [&](const NodeID target_node,
+                                   const EdgeWeight target_offset,
+                                   const bool force_loop_forward,
+                                   const bool force_loop_reverse,
+                                   int &distance,
+                                   std::vector<NodeID> &packed_leg) {
+            reverse_heap.Clear();
+            super::InsertTargetNode(reverse_heap, target_node, target_offset);
+            NodeID middle = SPECIAL_NODEID;
+            distance = INVALID_EDGE_WEIGHT;
+            while (!reverse_heap.Empty())
+            {
+                super::RoutingStep(reverse_heap,
+                                   forward_heap,
+                                   middle,
+                                   distance,
+                                   min_edge_offset,
+                                   false,
+                                   force_loop_reverse,
+                                   force_loop_forward);
+            }
+
+            if (SPECIAL_NODEID == middle)
+            {
+                distance = INVALID_EDGE_WEIGHT;
+            }
+            else if (distance != forward_heap.GetKey(middle) + reverse_heap.GetKey(middle))
+            {
+                // self loop makes up the full path
+                packed_leg.push_back(middle);
+                packed_leg.push_back(middle);
+            }
+            else
+            {
+                super::RetrievePackedPathFromHeap(forward_heap, reverse_heap, middle, packed_leg);
+            }
+        };
+
+        search_to(target_phantom.forward_segment_id.id,
+                  target_phantom.GetForwardWeightPlusOffset(),
+                  super::NeedsLoopForward(source_phantom, target_phantom),
+                  DO_NOT_FORCE_LOOP,
+                  new_total_distance_to_forward,
+                  leg_packed_path_forward);
+        search_to(target_phantom.reverse_segment_id.id,
+                  target_phantom.GetReverseWeightPlusOffset(),
+                  DO_NOT_FORCE_LOOP,
+                  super::NeedsLoopBackwards(source_phantom, target_phantom),
+                  new_total_distance_to_reverse,
+                  leg_packed_path_reverse);
+    }
+
+    // The paths of a leg searched without the distances of the previous legs, see SearchLegs.
+    // Direction 0 is the forward and 1 the reverse segment of a phantom node.
+    // With u-turns at the waypoints only target direction 0 is used, it stands for both.
+    struct LegPaths
+    {
+        // [source direction][target direction]
+        int weights[2][2] = {{INVALID_EDGE_WEIGHT, INVALID_EDGE_WEIGHT},
+                             {INVALID_EDGE_WEIGHT, INVALID_EDGE_WEIGHT}};
+        std::vector<NodeID> paths[2][2];
+    };
 
   public:
-    ShortestPathRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
-        : super(facade), engine_working_data(engine_working_data)
+    // With parallel_searches the legs of long routes are searched at the same time. This takes
+    // up to twice the searches since each direction of the waypoints is searched from separately.
+    ShortestPathRouting(DataFacadeT *facade,
+                        SearchEngineData &engine_working_data,
+                        const bool parallel_searches = false)
+        : super(facade), engine_working_data(engine_working_data),
+          parallel_searches(parallel_searches)
     {
     }
 
@@ -68,15 +204,15 @@ class ShortestPathRouting final
         }
         if (search_to_forward_node)
         {
-            reverse_heap.Insert(target_phantom.forward_segment_id.id,
-                                target_phantom.GetForwardWeightPlusOffset(),
-                                target_phantom.forward_segment_id.id);
+            super::InsertTargetNode(reverse_heap,
+                                    target_phantom.forward_segment_id.id,
+                                    target_phantom.GetForwardWeightPlusOffset());
         }
         if (search_to_reverse_node)
         {
-            reverse_heap.Insert(target_phantom.reverse_segment_id.id,
-                                target_phantom.GetReverseWeightPlusOffset(),
-                                target_phantom.reverse_segment_id.id);
+            super::InsertTargetNode(reverse_heap,
+                                    target_phantom.reverse_segment_id.id,
+                                    target_phantom.GetReverseWeightPlusOffset());
         }
 
         BOOST_ASSERT(forward_heap.Size() > 0);
@@ -137,13 +273,30 @@ class ShortestPathRouting final
                 std::vector<NodeID> &leg_packed_path_forward,
                 std::vector<NodeID> &leg_packed_path_reverse) const
     {
+        if (search_to_forward_node && search_to_reverse_node && super::facade->GetCoreSize() == 0)
+        {
+            SearchToBothTargetNodes(forward_heap,
+                                    reverse_heap,
+                                    search_from_forward_node,
+                                    search_from_reverse_node,
+                                    source_phantom,
+                                    target_phantom,
+                                    total_distance_to_forward,
+                                    total_distance_to_reverse,
+                                    new_total_distance_to_forward,
+                                    new_total_distance_to_reverse,
+                                    leg_packed_path_forward,
+                                    leg_packed_path_reverse);
+            return;
+        }
+
         if (search_to_forward_node)
         {
             forward_heap.Clear();
             reverse_heap.Clear();
-            reverse_heap.Insert(target_phantom.forward_segment_id.id,
-                                target_phantom.GetForwardWeightPlusOffset(),
-                                target_phantom.forward_segment_id.id);
+            super::InsertTargetNode(reverse_heap,
+                                    target_phantom.forward_segment_id.id,
+                                    target_phantom.GetForwardWeightPlusOffset());
 
             if (search_from_forward_node)
             {
@@ -192,9 +345,9 @@ class ShortestPathRouting final
         {
             forward_heap.Clear();
             reverse_heap.Clear();
-            reverse_heap.Insert(target_phantom.reverse_segment_id.id,
-                                target_phantom.GetReverseWeightPlusOffset(),
-                                target_phantom.reverse_segment_id.id);
+            super::InsertTargetNode(reverse_heap,
+                                    target_phantom.reverse_segment_id.id,
+                                    target_phantom.GetReverseWeightPlusOffset());
             if (search_from_forward_node)
             {
                 forward_heap.Insert(source_phantom.forward_segment_id.id,
@@ -238,6 +391,141 @@ class ShortestPathRouting final
         }
     }
 
+    // Searches every leg on its own, from each direction of its source phantom node that is
+    // enabled. The legs only depend on each other through the distances to their sources, which
+    // PickLeg adds afterwards.
+    std::vector<LegPaths> SearchLegs(const std::vector<PhantomNodes> &phantom_nodes_vector,
+                                     const bool allow_uturn_at_waypoint) const
+    {
+        std::vector<LegPaths> legs(phantom_nodes_vector.size());
+
+        auto *const statistics = ActiveSearchStatistics();
+        const auto *const deadline = ActiveQueryDeadline();
+        const auto time_slot = ActiveTimeSlot();
+        tbb::enumerable_thread_specific<SearchStatistics> thread_local_statistics;
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, legs.size()),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                const SearchStatisticsScope statistics_scope(
+                    statistics ? &thread_local_statistics.local() : nullptr);
+                const QueryDeadlineScope deadline_scope(deadline);
+                const TimeSlotScope time_slot_scope(time_slot);
+
+                const auto number_of_nodes = super::facade->GetNumberOfNodes();
+                auto forward_heap = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+                auto reverse_heap = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+                auto forward_core_heap = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+                auto reverse_core_heap = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+
+                for (auto leg = range.begin(); leg != range.end(); ++leg)
+                {
+                    const auto &source_phantom = phantom_nodes_vector[leg].source_phantom;
+                    const auto &target_phantom = phantom_nodes_vector[leg].target_phantom;
+                    const bool from_node[] = {source_phantom.forward_segment_id.enabled,
+                                              source_phantom.reverse_segment_id.enabled};
+                    const bool to_forward_node = target_phantom.forward_segment_id.enabled;
+                    const bool to_reverse_node = target_phantom.reverse_segment_id.enabled;
+                    if (!to_forward_node && !to_reverse_node)
+                    {
+                        continue;
+                    }
+
+                    auto &paths = legs[leg];
+                    for (const auto direction : {0, 1})
+                    {
+                        if (!from_node[direction])
+                        {
+                            continue;
+                        }
+                        if (allow_uturn_at_waypoint)
+                        {
+                            SearchWithUTurn(*forward_heap,
+                                            *reverse_heap,
+                                            *forward_core_heap,
+                                            *reverse_core_heap,
+                                            direction == 0,
+                                            direction == 1,
+                                            to_forward_node,
+                                            to_reverse_node,
+                                            source_phantom,
+                                            target_phantom,
+                                            0,
+                                            0,
+                                            paths.weights[direction][0],
+                                            paths.paths[direction][0]);
+                        }
+                        else
+                        {
+                            Search(*forward_heap,
+                                   *reverse_heap,
+                                   *forward_core_heap,
+                                   *reverse_core_heap,
+                                   direction == 0,
+                                   direction == 1,
+                                   to_forward_node,
+                                   to_reverse_node,
+                                   source_phantom,
+                                   target_phantom,
+                                   0,
+                                   0,
+                                   paths.weights[direction][0],
+                                   paths.weights[direction][1],
+                                   paths.paths[direction][0],
+                                   paths.paths[direction][1]);
+                        }
+                    }
+                }
+            });
+
+        if (statistics)
+        {
+            for (const auto &worker_statistics : thread_local_statistics)
+            {
+                *statistics += worker_statistics;
+            }
+        }
+        return legs;
+    }
+
+    // Continues the routes to the source directions with a leg of SearchLegs, the same way
+    // SearchWithUTurn and Search do with the distances to the source directions. With u-turns
+    // at the waypoints the leg ends up in new_total_distance_to_forward like in SearchWithUTurn.
+    void PickLeg(LegPaths &leg,
+                 const bool allow_uturn_at_waypoint,
+                 const bool search_from_forward_node,
+                 const bool search_from_reverse_node,
+                 const int total_distance_to_forward,
+                 const int total_distance_to_reverse,
+                 int &new_total_distance_to_forward,
+                 int &new_total_distance_to_reverse,
+                 std::vector<NodeID> &leg_packed_path_forward,
+                 std::vector<NodeID> &leg_packed_path_reverse) const
+    {
+        const bool from_node[] = {search_from_forward_node, search_from_reverse_node};
+        const int total_distance[] = {total_distance_to_forward, total_distance_to_reverse};
+        int *const new_total_distance[] = {&new_total_distance_to_forward,
+                                           &new_total_distance_to_reverse};
+        std::vector<NodeID> *const leg_packed_path[] = {&leg_packed_path_forward,
+                                                        &leg_packed_path_reverse};
+        const auto number_of_targets = allow_uturn_at_waypoint ? 1 : 2;
+        for (auto target = 0; target < number_of_targets; ++target)
+        {
+            for (const auto source : {0, 1})
+            {
+                if (!from_node[source] || leg.weights[source][target] == INVALID_EDGE_WEIGHT)
+                {
+                    continue;
+                }
+                const auto distance = total_distance[source] + leg.weights[source][target];
+                if (distance < *new_total_distance[target])
+                {
+                    *new_total_distance[target] = distance;
+                    *leg_packed_path[target] = std::move(leg.paths[source][target]);
+                }
+            }
+        }
+    }
+
     void UnpackLegs(const std::vector<PhantomNodes> &phantom_nodes_vector,
                     const std::vector<NodeID> &total_packed_path,
                     const std::vector<std::size_t> &packed_leg_begin,
@@ -262,7 +550,7 @@ class ShortestPathRouting final
                 (*leg_begin !=
                  phantom_nodes_vector[current_leg].source_phantom.forward_segment_id.id));
             raw_route_data.target_traversed_in_reverse.push_back(
-                (*std::prev(leg_end) !=
+                (super::facade->GetOriginalNode(*std::prev(leg_end)) !=
                  phantom_nodes_vector[current_leg].target_phantom.forward_segment_id.id));
         }
     }
@@ -275,15 +563,23 @@ class ShortestPathRouting final
             !(continue_straight_at_waypoint ? *continue_straight_at_waypoint
                                             : super::facade->GetContinueStraightDefault());
 
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-        engine_working_data.InitializeOrClearSecondThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
+        const auto number_of_nodes = super::facade->GetNumberOfNodes();
+        auto forward_heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+        auto reverse_heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+        auto forward_core_heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
+        auto reverse_core_heap_handle = engine_working_data.GetHeap<QueryHeap>(number_of_nodes);
 
-        QueryHeap &forward_heap = *(engine_working_data.forward_heap_1);
-        QueryHeap &reverse_heap = *(engine_working_data.reverse_heap_1);
-        QueryHeap &forward_core_heap = *(engine_working_data.forward_heap_2);
-        QueryHeap &reverse_core_heap = *(engine_working_data.reverse_heap_2);
+        QueryHeap &forward_heap = *forward_heap_handle;
+        QueryHeap &reverse_heap = *reverse_heap_handle;
+        QueryHeap &forward_core_heap = *forward_core_heap_handle;
+        QueryHeap &reverse_core_heap = *reverse_core_heap_handle;
+
+        // the legs of long routes are searched up front, only picking them is sequential
+        std::vector<LegPaths> leg_paths;
+        if (parallel_searches && phantom_nodes_vector.size() >= PARALLEL_SEARCH_MIN_LEGS)
+        {
+            leg_paths = SearchLegs(phantom_nodes_vector, allow_uturn_at_waypoint);
+        }
 
         int total_distance_to_forward = 0;
         int total_distance_to_reverse = 0;
@@ -322,24 +618,41 @@ class ShortestPathRouting final
 
             BOOST_ASSERT(search_from_forward_node || search_from_reverse_node);
 
+            if (!leg_paths.empty())
+            {
+                PickLeg(leg_paths[current_leg],
+                        allow_uturn_at_waypoint,
+                        search_from_forward_node,
+                        search_from_reverse_node,
+                        total_distance_to_forward,
+                        total_distance_to_reverse,
+                        new_total_distance_to_forward,
+                        new_total_distance_to_reverse,
+                        packed_leg_to_forward,
+                        packed_leg_to_reverse);
+            }
+
             if (search_to_reverse_node || search_to_forward_node)
             {
                 if (allow_uturn_at_waypoint)
                 {
-                    SearchWithUTurn(forward_heap,
-                                    reverse_heap,
-                                    forward_core_heap,
-                                    reverse_core_heap,
-                                    search_from_forward_node,
-                                    search_from_reverse_node,
-                                    search_to_forward_node,
-                                    search_to_reverse_node,
-                                    source_phantom,
-                                    target_phantom,
-                                    total_distance_to_forward,
-                                    total_distance_to_reverse,
-                                    new_total_distance_to_forward,
-                                    packed_leg_to_forward);
+                    if (leg_paths.empty())
+                    {
+                        SearchWithUTurn(forward_heap,
+                                        reverse_heap,
+                                        forward_core_heap,
+                                        reverse_core_heap,
+                                        search_from_forward_node,
+                                        search_from_reverse_node,
+                                        search_to_forward_node,
+                                        search_to_reverse_node,
+                                        source_phantom,
+                                        target_phantom,
+                                        total_distance_to_forward,
+                                        total_distance_to_reverse,
+                                        new_total_distance_to_forward,
+                                        packed_leg_to_forward);
+                    }
                     // if only the reverse node is valid (e.g. when using the match plugin) we
                     // actually need to move
                     if (!target_phantom.forward_segment_id.enabled)
@@ -355,7 +668,7 @@ class ShortestPathRouting final
                         packed_leg_to_reverse = packed_leg_to_forward;
                     }
                 }
-                else
+                else if (leg_paths.empty())
                 {
                     Search(forward_heap,
                            reverse_heap,
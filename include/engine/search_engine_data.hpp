@@ -1,11 +1,17 @@
 #ifndef SEARCH_ENGINE_DATA_HPP
 #define SEARCH_ENGINE_DATA_HPP
 
-#include <boost/thread/tss.hpp>
-
+#include "engine/metrics.hpp"
 #include "util/binary_heap.hpp"
 #include "util/typedefs.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 namespace osrm
 {
 namespace engine
@@ -17,24 +23,208 @@ struct HeapData
     /* explicit */ HeapData(NodeID p) : parent(p) {}
 };
 
+// Multi-level Dijkstra also needs to know whether a node was reached over a cell clique,
+// those arcs are unpacked by a search inside of the cell.
+struct MultiLevelHeapData
+{
+    NodeID parent;
+    bool from_clique;
+    MultiLevelHeapData(NodeID p, bool from_clique) : parent(p), from_clique(from_clique) {}
+};
+
+// The table searches carry the length of the path to a node along with its weight, so the
+// distances of a table come out of the same searches as its durations.
+struct ManyToManyHeapData
+{
+    NodeID parent;
+    EdgeLength length;
+    ManyToManyHeapData(NodeID p, EdgeLength length) : parent(p), length(length) {}
+};
+
+// How a ThreadLocalPool creates, resets and trims its objects. Objects are created for a size,
+// for heaps the number of nodes of the graph, and only handed out again for the same size.
+template <typename T> struct PoolTraits;
+
+template <typename IndexStorage> struct IsDenseStorage : std::false_type
+{
+};
+
+template <typename NodeID, typename Key>
+struct IsDenseStorage<util::ArrayStorage<NodeID, Key>> : std::true_type
+{
+};
+
+template <typename NodeID, typename Key, typename Weight, typename Data, typename IndexStorage>
+struct PoolTraits<util::BinaryHeap<NodeID, Key, Weight, Data, IndexStorage>>
+{
+    using HeapT = util::BinaryHeap<NodeID, Key, Weight, Data, IndexStorage>;
+
+    // A hash map that held this many nodes keeps its buckets after clearing, such heaps are
+    // freed instead of kept for small queries. Dense heaps have the same size for every query.
+    static constexpr std::size_t MAX_KEPT_INSERTED_NODES = 1 << 20;
+
+    static std::unique_ptr<HeapT> Create(const std::size_t number_of_nodes)
+    {
+        return std::unique_ptr<HeapT>(new HeapT(number_of_nodes));
+    }
+
+    // The heap still holds the last search it was used for, this is where it gets counted
+    static bool Release(HeapT &heap)
+    {
+        metrics::CountSearch(heap.NumberOfInsertedNodes(), heap.NumberOfRemovedNodes());
+        const bool keep = IsDenseStorage<IndexStorage>::value ||
+                          heap.NumberOfInsertedNodes() <= MAX_KEPT_INSERTED_NODES;
+        if (keep)
+        {
+            heap.Clear();
+        }
+        return keep;
+    }
+};
+
+template <typename T> struct PoolTraits<std::vector<T>>
+{
+    static constexpr std::size_t MAX_KEPT_CAPACITY = 1 << 20;
+
+    static std::unique_ptr<std::vector<T>> Create(const std::size_t)
+    {
+        return std::unique_ptr<std::vector<T>>(new std::vector<T>());
+    }
+
+    static bool Release(std::vector<T> &values)
+    {
+        values.clear();
+        return values.capacity() <= MAX_KEPT_CAPACITY;
+    }
+};
+
+// Per thread free list of objects of type T. Acquire hands out an idle object of the thread or
+// creates a new one, the returned handle gives the object back when it goes out of scope. Every
+// search thus only holds the heaps it uses, and nested searches simply acquire more of them.
+//
+// Idle objects of a different size were made for a dataset that is no longer loaded and are
+// dropped, as are the objects past MAX_IDLE_OBJECTS and the ones PoolTraits<T>::Release trims.
+template <typename T> class ThreadLocalPool
+{
+    static constexpr std::size_t MAX_IDLE_OBJECTS = 6;
+
+    struct Entry
+    {
+        std::size_t size;
+        std::unique_ptr<T> object;
+    };
+
+  public:
+    class Handle
+    {
+      public:
+        Handle(const std::size_t size, std::unique_ptr<T> object)
+            : size(size), object(std::move(object))
+        {
+        }
+        Handle(Handle &&) = default;
+        Handle &operator=(Handle &&) = delete;
+        Handle(const Handle &) = delete;
+        Handle &operator=(const Handle &) = delete;
+
+        ~Handle()
+        {
+            if (object)
+            {
+                ThreadLocalPool::Release(size, std::move(object));
+            }
+        }
+
+        T &operator*() const { return *object; }
+        T *operator->() const { return object.get(); }
+
+      private:
+        std::size_t size;
+        std::unique_ptr<T> object;
+    };
+
+    static Handle Acquire(const std::size_t size = 0)
+    {
+        auto &idle = Idle();
+        while (!idle.empty())
+        {
+            auto entry = std::move(idle.back());
+            idle.pop_back();
+            if (entry.size == size)
+            {
+                return Handle(size, std::move(entry.object));
+            }
+        }
+        return Handle(size, PoolTraits<T>::Create(size));
+    }
+
+    // Creates objects of the given size until the calling thread holds count idle ones, so that
+    // its first searches do not have to allocate them
+    static void Reserve(const std::size_t size, const std::size_t count)
+    {
+        auto &idle = Idle();
+        idle.erase(std::remove_if(idle.begin(),
+                                  idle.end(),
+                                  [size](const Entry &entry) { return entry.size != size; }),
+                   idle.end());
+        while (idle.size() < count && idle.size() < MAX_IDLE_OBJECTS)
+        {
+            idle.push_back(Entry{size, PoolTraits<T>::Create(size)});
+        }
+    }
+
+  private:
+    static void Release(const std::size_t size, std::unique_ptr<T> object)
+    {
+        auto &idle = Idle();
+        if (PoolTraits<T>::Release(*object) && idle.size() < MAX_IDLE_OBJECTS)
+        {
+            idle.push_back(Entry{size, std::move(object)});
+        }
+    }
+
+    static std::vector<Entry> &Idle()
+    {
+        static thread_local std::vector<Entry> idle;
+        return idle;
+    }
+};
+
 struct SearchEngineData
 {
     using QueryHeap =
         util::BinaryHeap<NodeID, NodeID, int, HeapData, util::UnorderedMapStorage<NodeID, int>>;
-    using SearchEngineHeapPtr = boost::thread_specific_ptr<QueryHeap>;
 
-    static SearchEngineHeapPtr forward_heap_1;
-    static SearchEngineHeapPtr reverse_heap_1;
-    static SearchEngineHeapPtr forward_heap_2;
-    static SearchEngineHeapPtr reverse_heap_2;
-    static SearchEngineHeapPtr forward_heap_3;
-    static SearchEngineHeapPtr reverse_heap_3;
+    // Heap backed by a dense per-node index array instead of a hash map. Trades memory
+    // (one index per node and heap) for hash-free inserts and lookups, so it is only used by
+    // the algorithms whose queries settle enough nodes to be dominated by hashing.
+    using DenseQueryHeap =
+        util::BinaryHeap<NodeID, NodeID, int, HeapData, util::ArrayStorage<NodeID, int>>;
+
+    using MultiLevelQueryHeap = util::
+        BinaryHeap<NodeID, NodeID, int, MultiLevelHeapData, util::ArrayStorage<NodeID, int>>;
+
+    using ManyToManyQueryHeap = util::BinaryHeap<NodeID,
+                                                 NodeID,
+                                                 int,
+                                                 ManyToManyHeapData,
+                                                 util::UnorderedMapStorage<NodeID, int>>;
 
-    void InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes);
+    template <typename HeapT> using HeapHandle = typename ThreadLocalPool<HeapT>::Handle;
 
-    void InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes);
+    // An empty heap for a graph of number_of_nodes nodes, owned by the calling thread until the
+    // handle is destroyed
+    template <typename HeapT> static HeapHandle<HeapT> GetHeap(const unsigned number_of_nodes)
+    {
+        return ThreadLocalPool<HeapT>::Acquire(number_of_nodes);
+    }
 
-    void InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes);
+    // Allocates count heaps of the calling thread ahead of its first query
+    template <typename HeapT>
+    static void ReserveHeaps(const unsigned number_of_nodes, const std::size_t count)
+    {
+        ThreadLocalPool<HeapT>::Reserve(number_of_nodes, count);
+    }
 };
 }
 }
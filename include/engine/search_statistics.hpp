@@ -0,0 +1,61 @@
+#ifndef ENGINE_SEARCH_STATISTICS_HPP
+#define ENGINE_SEARCH_STATISTICS_HPP
+
+#include <cstdint>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Size of the search spaces of a query, see the debug request parameter
+struct SearchStatistics
+{
+    // nodes taken from a heap and expanded or stalled
+    std::uint64_t settled_nodes = 0;
+    // edges in search direction that were relaxed from settled nodes
+    std::uint64_t relaxed_edges = 0;
+    // settled nodes whose edges stall-on-demand skipped
+    std::uint64_t stalled_nodes = 0;
+    // part of settled_nodes that was settled by the search in the core of the graph
+    std::uint64_t core_settled_nodes = 0;
+
+    SearchStatistics &operator+=(const SearchStatistics &other)
+    {
+        settled_nodes += other.settled_nodes;
+        relaxed_edges += other.relaxed_edges;
+        stalled_nodes += other.stalled_nodes;
+        core_settled_nodes += other.core_settled_nodes;
+        return *this;
+    }
+};
+
+// Statistics the searches of the calling thread add to, nullptr if they are not recorded
+inline SearchStatistics *&ActiveSearchStatistics()
+{
+    static thread_local SearchStatistics *statistics = nullptr;
+    return statistics;
+}
+
+// Records the statistics of the searches the calling thread runs in its lifetime
+class SearchStatisticsScope
+{
+  public:
+    explicit SearchStatisticsScope(SearchStatistics *statistics)
+        : previous_statistics(ActiveSearchStatistics())
+    {
+        ActiveSearchStatistics() = statistics;
+    }
+
+    ~SearchStatisticsScope() { ActiveSearchStatistics() = previous_statistics; }
+
+    SearchStatisticsScope(const SearchStatisticsScope &) = delete;
+    SearchStatisticsScope &operator=(const SearchStatisticsScope &) = delete;
+
+  private:
+    SearchStatistics *const previous_statistics;
+};
+}
+}
+
+#endif // ENGINE_SEARCH_STATISTICS_HPP
@@ -0,0 +1,85 @@
+#ifndef ENGINE_TABLE_PEERS_HPP
+#define ENGINE_TABLE_PEERS_HPP
+
+#include "engine/api/table_parameters.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/optional.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+/**
+ * Other osrm-routed instances serving the same dataset, among which the rows of the largest
+ * distance tables are split. Every peer searches a consecutive shard of the sources against all
+ * destinations, with the buckets of the destinations computed on each peer, and answers with a
+ * binary table. The coordinating engine renders the rows of the shards in order.
+ *
+ * Peers are asked with plain HTTP/1.0 requests with distribute=false, so they search their shard
+ * themselves even if they have peers of their own. A peer that does not answer in time has its
+ * shard searched by the coordinating engine.
+ */
+class TablePeers
+{
+  public:
+    // Smaller tables are not worth the round trips to the peers
+    static const constexpr std::size_t MIN_DISTRIBUTED_ENTRIES = 16 * 1024 * 1024;
+
+    // A shard of rows of a table, in row major order. The durations are empty if the table does
+    // not have them, so are the distances.
+    struct Rows
+    {
+        std::vector<EdgeWeight> durations;
+        std::vector<EdgeWeight> distances;
+    };
+
+    // Peers that do not answer within this are given up without a max. query time
+    static const constexpr int DEFAULT_TIMEOUT = 60 * 1000;
+
+    // Peers are given as host:port and asked for the tables of profile, each within timeout.
+    // Throws util::exception for peers not of that form.
+    TablePeers(const std::vector<std::string> &peers,
+               std::string profile,
+               const std::chrono::milliseconds timeout);
+
+    std::size_t Size() const { return peers.size(); }
+
+    // Asks a peer for the rows of sources against the destinations of params. Returns none if
+    // the peer cannot be reached, does not answer in time or not with a table of the expected
+    // size.
+    boost::optional<Rows> FetchRows(const std::size_t peer,
+                                    const api::TableParameters &params,
+                                    const std::vector<std::size_t> &sources) const;
+
+    // Path and query of a binary table request for the rows of sources against the destinations
+    // of params. Only the coordinates of these are sent, with their hints, radiuses and bearings.
+    std::string MakeQuery(const api::TableParameters &params,
+                          const std::vector<std::size_t> &sources) const;
+
+    // Decodes a response of api::TableAPI::MakeBinaryResponse with the given dimensions
+    static boost::optional<Rows> ParseBinaryTable(const std::string &body,
+                                                  const std::size_t number_of_sources,
+                                                  const std::size_t number_of_destinations);
+
+  private:
+    struct Peer
+    {
+        std::string host;
+        std::string port;
+    };
+
+    std::vector<Peer> peers;
+    std::string profile;
+    std::chrono::milliseconds timeout;
+};
+}
+}
+
+#endif // ENGINE_TABLE_PEERS_HPP
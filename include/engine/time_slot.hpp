@@ -0,0 +1,48 @@
+#ifndef ENGINE_TIME_SLOT_HPP
+#define ENGINE_TIME_SLOT_HPP
+
+#include <limits>
+
+namespace osrm
+{
+namespace engine
+{
+
+static const constexpr unsigned INVALID_TIME_SLOT = std::numeric_limits<unsigned>::max();
+
+// Time slot whose weights the data facades return to the calling thread, see
+// osrm-contract --time-slot-speed-file. The metrics of --metric-speed-file follow the time slots.
+// INVALID_TIME_SLOT selects the weights of the dataset.
+inline unsigned &ActiveTimeSlot()
+{
+    static thread_local unsigned time_slot = INVALID_TIME_SLOT;
+    return time_slot;
+}
+
+// Slot of the metric-th metric, metric 0 being the weights of the dataset
+inline unsigned MetricTimeSlot(const unsigned number_of_time_slots, const unsigned metric)
+{
+    return metric == 0 ? INVALID_TIME_SLOT : number_of_time_slots + metric - 1;
+}
+
+// Selects the weights of a time slot for the queries the calling thread runs in its lifetime
+class TimeSlotScope
+{
+  public:
+    explicit TimeSlotScope(const unsigned time_slot) : previous_time_slot(ActiveTimeSlot())
+    {
+        ActiveTimeSlot() = time_slot;
+    }
+
+    ~TimeSlotScope() { ActiveTimeSlot() = previous_time_slot; }
+
+    TimeSlotScope(const TimeSlotScope &) = delete;
+    TimeSlotScope &operator=(const TimeSlotScope &) = delete;
+
+  private:
+    const unsigned previous_time_slot;
+};
+}
+}
+
+#endif // ENGINE_TIME_SLOT_HPP
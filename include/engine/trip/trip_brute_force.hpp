@@ -1,13 +1,22 @@
 #ifndef TRIP_BRUTE_FORCE_HPP
 #define TRIP_BRUTE_FORCE_HPP
 
+#include "engine/query_deadline.hpp"
 #include "util/dist_table_wrapper.hpp"
+#include "util/integer_range.hpp"
 #include "util/simple_logger.hpp"
 #include "util/typedefs.hpp"
 
 #include "osrm/json_container.hpp"
 
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
 #include <iterator>
 #include <limits>
@@ -21,61 +30,162 @@ namespace engine
 namespace trip
 {
 
-// computes the distance of a given permutation
-EdgeWeight ReturnDistance(const util::DistTableWrapper<EdgeWeight> &dist_table,
-                          const std::vector<NodeID> &location_order,
-                          const EdgeWeight min_route_dist,
-                          const std::size_t component_size)
+namespace detail
+{
+// Depth-first search for the shortest tour that starts with two given locations, the other
+// locations are tried in the order of nodes. Branches whose lower bound exceeds the shortest tour
+// any search found so far are cut, searches running in parallel share that bound.
+class TourSearch
 {
-    EdgeWeight route_dist = 0;
-    std::size_t i = 0;
-    while (i < location_order.size() && (route_dist < min_route_dist))
+  public:
+    TourSearch(const util::DistTableWrapper<EdgeWeight> &dist_table,
+               const std::vector<NodeID> &nodes,
+               const std::vector<EdgeWeight> &min_leaving,
+               std::atomic<std::int64_t> &shared_bound)
+        : dist_table(dist_table), nodes(nodes), min_leaving(min_leaving),
+          shared_bound(shared_bound), best_distance(std::numeric_limits<std::int64_t>::max())
     {
-        route_dist += dist_table(location_order[i], location_order[(i + 1) % component_size]);
-        BOOST_ASSERT_MSG(dist_table(location_order[i], location_order[(i + 1) % component_size]) !=
-                             INVALID_EDGE_WEIGHT,
-                         "invalid route found");
-        ++i;
     }
 
-    return route_dist;
+    // Returns the distance of the shortest tour nodes[first], nodes[second], ... that is not
+    // longer than the shared bound, the tour is in best_route. The first one in search order wins
+    // among tours of the same distance.
+    std::int64_t Run(const std::size_t first, const std::size_t second)
+    {
+        best_distance = std::numeric_limits<std::int64_t>::max();
+        best_route.clear();
+        used.assign(nodes.size(), false);
+        tour.clear();
+        std::int64_t unvisited_bound = 0;
+        for (const auto node : nodes)
+        {
+            unvisited_bound += min_leaving[node];
+        }
+        for (const auto index : {first, second})
+        {
+            used[index] = true;
+            tour.push_back(nodes[index]);
+            unvisited_bound -= min_leaving[nodes[index]];
+        }
+        Extend(dist_table(nodes[first], nodes[second]), unvisited_bound);
+        return best_distance;
+    }
+
+    std::vector<NodeID> best_route;
+
+  private:
+    // unvisited_bound is the sum of the cheapest edges leaving the unvisited locations
+    void Extend(const std::int64_t distance, const std::int64_t unvisited_bound)
+    {
+        CheckQueryDeadline();
+        const auto current = tour.back();
+        if (tour.size() == nodes.size())
+        {
+            const auto total = distance + dist_table(current, tour.front());
+            if (total < best_distance && total <= shared_bound.load())
+            {
+                best_distance = total;
+                best_route = tour;
+                auto bound = shared_bound.load();
+                while (total < bound && !shared_bound.compare_exchange_weak(bound, total))
+                {
+                }
+            }
+            return;
+        }
+
+        // every location that is still to be left adds at least its cheapest leaving edge
+        const auto lower_bound = distance + min_leaving[current] + unvisited_bound;
+        if (lower_bound >= best_distance || lower_bound > shared_bound.load())
+        {
+            return;
+        }
+
+        for (const auto index : util::irange<std::size_t>(0, nodes.size()))
+        {
+            if (used[index])
+            {
+                continue;
+            }
+            used[index] = true;
+            tour.push_back(nodes[index]);
+            Extend(distance + dist_table(current, nodes[index]),
+                   unvisited_bound - min_leaving[nodes[index]]);
+            tour.pop_back();
+            used[index] = false;
+        }
+    }
+
+    const util::DistTableWrapper<EdgeWeight> &dist_table;
+    const std::vector<NodeID> &nodes;
+    const std::vector<EdgeWeight> &min_leaving;
+    std::atomic<std::int64_t> &shared_bound;
+
+    std::int64_t best_distance;
+    std::vector<NodeID> tour;
+    std::vector<bool> used;
+};
 }
 
-// computes the route by computing all permutations and selecting the shortest
+// computes the shortest round trip by branch and bound over all permutations. Round trips that
+// are rotations of each other are the same, so all of them start at the smallest location id and
+// the choices of the second location are searched in parallel.
 template <typename NodeIDIterator>
 std::vector<NodeID> BruteForceTrip(const NodeIDIterator start,
                                    const NodeIDIterator end,
                                    const std::size_t number_of_locations,
                                    const util::DistTableWrapper<EdgeWeight> &dist_table)
 {
-    (void)number_of_locations; // unused
-
-    const auto component_size = std::distance(start, end);
-
-    std::vector<NodeID> perm(start, end);
-    std::vector<NodeID> route;
-    route.reserve(component_size);
+    std::vector<NodeID> nodes(start, end);
+    std::sort(nodes.begin(), nodes.end());
 
-    EdgeWeight min_route_dist = INVALID_EDGE_WEIGHT;
+    BOOST_ASSERT_MSG(nodes.size() > 0, "no permutation given");
+    BOOST_ASSERT_MSG(nodes.back() < number_of_locations, "invalid node id");
+    if (nodes.size() < 3)
+    {
+        return nodes;
+    }
 
-    // check length of all possible permutation of the component ids
+    std::vector<EdgeWeight> min_leaving(number_of_locations, INVALID_EDGE_WEIGHT);
+    for (const auto from : nodes)
+    {
+        for (const auto to : nodes)
+        {
+            if (from != to)
+            {
+                BOOST_ASSERT_MSG(dist_table(from, to) != INVALID_EDGE_WEIGHT,
+                                 "invalid route found");
+                min_leaving[from] = std::min(min_leaving[from], dist_table(from, to));
+            }
+        }
+    }
 
-    BOOST_ASSERT_MSG(perm.size() > 0, "no permutation given");
-    BOOST_ASSERT_MSG(*(std::max_element(std::begin(perm), std::end(perm))) < number_of_locations,
-                     "invalid node id");
-    BOOST_ASSERT_MSG(*(std::min_element(std::begin(perm), std::end(perm))) >= 0, "invalid node id");
+    std::atomic<std::int64_t> shared_bound{std::numeric_limits<std::int64_t>::max()};
+    std::vector<std::int64_t> distances(nodes.size());
+    std::vector<std::vector<NodeID>> routes(nodes.size());
+    const auto *const deadline = ActiveQueryDeadline();
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(1, nodes.size(), 1),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          const QueryDeadlineScope deadline_scope(deadline);
+                          detail::TourSearch search(dist_table, nodes, min_leaving, shared_bound);
+                          for (auto second = range.begin(); second != range.end(); ++second)
+                          {
+                              distances[second] = search.Run(0, second);
+                              routes[second] = std::move(search.best_route);
+                          }
+                      });
 
-    do
+    // the first shortest tour in the order of the sequential search, whatever the scheduling was
+    std::size_t best = 1;
+    for (const auto second : util::irange<std::size_t>(2, nodes.size()))
     {
-        const auto new_distance = ReturnDistance(dist_table, perm, min_route_dist, component_size);
-        if (new_distance <= min_route_dist)
+        if (distances[second] < distances[best])
         {
-            min_route_dist = new_distance;
-            route = perm;
+            best = second;
         }
-    } while (std::next_permutation(std::begin(perm), std::end(perm)));
-
-    return route;
+    }
+    BOOST_ASSERT(!routes[best].empty());
+    return routes[best];
 }
 }
 }
@@ -1,6 +1,7 @@
 #ifndef TRIP_FARTHEST_INSERTION_HPP
 #define TRIP_FARTHEST_INSERTION_HPP
 
+#include "engine/query_deadline.hpp"
 #include "util/dist_table_wrapper.hpp"
 #include "util/typedefs.hpp"
 #include "util/typedefs.hpp"
@@ -8,6 +9,9 @@
 #include "osrm/json_container.hpp"
 #include <boost/assert.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+
 #include <algorithm>
 #include <cstdlib>
 #include <limits>
@@ -73,6 +77,22 @@ GetShortestRoundTrip(const NodeID new_loc,
     return std::make_pair(min_trip_distance, next_insert_point_candidate);
 }
 
+// the location whose insertion makes the round trip the longest and where to insert it
+struct InsertionCandidate
+{
+    EdgeWeight distance;
+    NodeID node;
+    NodeIDIter insert_point;
+    // position of the location in its component, ties go to the last position
+    std::size_t position;
+
+    bool IsBetterThan(const InsertionCandidate &other) const
+    {
+        return distance > other.distance ||
+               (distance == other.distance && position > other.position);
+    }
+};
+
 template <typename NodeIDIterator>
 // given two initial start nodes, find a roundtrip route using the farthest insertion algorithm
 std::vector<NodeID> FindRoute(const std::size_t &number_of_locations,
@@ -100,39 +120,51 @@ std::vector<NodeID> FindRoute(const std::size_t &number_of_locations,
     // add all other nodes missing (two nodes are already in the initial start trip)
     for (std::size_t j = 2; j < component_size; ++j)
     {
-
-        auto farthest_distance = std::numeric_limits<int>::min();
-        auto next_node = -1;
-        NodeIDIter next_insert_point;
-
-        // find unvisited loc i that is the farthest away from all other visited locs
-        for (auto i = start; i != end; ++i)
-        {
-            // find the shortest distance from i to all visited nodes
-            if (!visited[*i])
-            {
-                const auto insert_candidate =
-                    GetShortestRoundTrip(*i, dist_table, number_of_locations, route);
-
-                BOOST_ASSERT_MSG(insert_candidate.first != INVALID_EDGE_WEIGHT,
-                                 "shortest round trip is invalid");
-
-                // add the location to the current trip such that it results in the shortest total
-                // tour
-                if (insert_candidate.first >= farthest_distance)
+        // every insertion looks at all pairs of unvisited and visited locations
+        CheckQueryDeadline(component_size * route.size());
+
+        // find unvisited loc i that is the farthest away from all other visited locs, the
+        // candidates are scanned in parallel and only read the route
+        const InsertionCandidate no_candidate{
+            std::numeric_limits<EdgeWeight>::min(), SPECIAL_NODEID, route.end(), 0};
+        const auto farthest = tbb::parallel_reduce(
+            tbb::blocked_range<std::size_t>(0, component_size, 8),
+            no_candidate,
+            [&](const tbb::blocked_range<std::size_t> &range, InsertionCandidate farthest) {
+                for (auto position = range.begin(); position != range.end(); ++position)
                 {
-                    farthest_distance = insert_candidate.first;
-                    next_node = *i;
-                    next_insert_point = insert_candidate.second;
+                    const NodeID node = *(start + position);
+                    // find the shortest distance from i to all visited nodes
+                    if (visited[node])
+                    {
+                        continue;
+                    }
+                    const auto insert_candidate =
+                        GetShortestRoundTrip(node, dist_table, number_of_locations, route);
+
+                    BOOST_ASSERT_MSG(insert_candidate.first != INVALID_EDGE_WEIGHT,
+                                     "shortest round trip is invalid");
+
+                    // add the location to the current trip such that it results in the shortest
+                    // total tour
+                    const InsertionCandidate candidate{
+                        insert_candidate.first, node, insert_candidate.second, position};
+                    if (candidate.IsBetterThan(farthest))
+                    {
+                        farthest = candidate;
+                    }
                 }
-            }
-        }
+                return farthest;
+            },
+            [](const InsertionCandidate &lhs, const InsertionCandidate &rhs) {
+                return rhs.IsBetterThan(lhs) ? rhs : lhs;
+            });
 
-        BOOST_ASSERT_MSG(next_node >= 0, "next node to visit is invalid");
+        BOOST_ASSERT_MSG(farthest.node != SPECIAL_NODEID, "next node to visit is invalid");
 
         // mark as visited and insert node
-        visited[next_node] = true;
-        route.insert(next_insert_point, next_node);
+        visited[farthest.node] = true;
+        route.insert(farthest.insert_point, farthest.node);
     }
     return route;
 }
@@ -0,0 +1,185 @@
+#ifndef TRIP_LOCAL_SEARCH_HPP
+#define TRIP_LOCAL_SEARCH_HPP
+
+#include "engine/query_deadline.hpp"
+#include "util/typedefs.hpp"
+
+#include "util/dist_table_wrapper.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace trip
+{
+
+// number of closest locations a location is considered to be connected to by a new edge
+static const constexpr std::size_t LOCAL_SEARCH_NEIGHBOURS = 10;
+// longest run of consecutive locations an Or-opt move relocates
+static const constexpr std::size_t OR_OPT_MAX_SEGMENT = 3;
+
+// Improves a round trip with 2-opt and Or-opt moves until no move shortens it any more or the
+// time budget is used up.
+//
+// The durations are asymmetric, so a 2-opt move that reverses a part of the trip is evaluated
+// with prefix sums of the trip in both directions. Only moves that introduce an edge to one of
+// the LOCAL_SEARCH_NEIGHBOURS closest locations are tried. The first location stays in place.
+inline std::vector<NodeID> LocalSearchTrip(const std::vector<NodeID> &route,
+                                           const util::DistTableWrapper<EdgeWeight> &dist_table,
+                                           const std::chrono::milliseconds max_optimization_time)
+{
+    const auto deadline = std::chrono::steady_clock::now() + max_optimization_time;
+
+    const auto number_of_nodes = route.size();
+    if (number_of_nodes < 4)
+    {
+        return route;
+    }
+
+    // everything below works on positions in the initial route instead of location ids
+    const auto distance = [&](const std::size_t from, const std::size_t to) {
+        return dist_table(route[from], route[to]);
+    };
+
+    const auto number_of_neighbours = std::min(LOCAL_SEARCH_NEIGHBOURS, number_of_nodes - 1);
+    std::vector<std::size_t> neighbours(number_of_nodes * number_of_neighbours);
+    std::vector<std::size_t> candidates;
+    for (std::size_t node = 0; node < number_of_nodes; ++node)
+    {
+        candidates.resize(number_of_nodes);
+        std::iota(candidates.begin(), candidates.end(), 0);
+        candidates.erase(candidates.begin() + node);
+        std::partial_sort(candidates.begin(),
+                          candidates.begin() + number_of_neighbours,
+                          candidates.end(),
+                          [&](const std::size_t lhs, const std::size_t rhs) {
+                              return distance(node, lhs) < distance(node, rhs);
+                          });
+        std::copy(candidates.begin(),
+                  candidates.begin() + number_of_neighbours,
+                  neighbours.begin() + node * number_of_neighbours);
+    }
+
+    std::vector<std::size_t> tour(number_of_nodes);
+    std::iota(tour.begin(), tour.end(), 0);
+    std::vector<std::size_t> position(number_of_nodes);
+    // duration of the trip up to a position, in trip and in reverse direction
+    std::vector<EdgeWeight> forward_prefix(number_of_nodes + 1);
+    std::vector<EdgeWeight> reverse_prefix(number_of_nodes + 1);
+
+    const auto at = [&](const std::size_t index) { return tour[index % number_of_nodes]; };
+
+    // applies the first improving 2-opt move, reversing the trip between i and j
+    const auto two_opt = [&]() {
+        for (std::size_t i = 1; i < number_of_nodes; ++i)
+        {
+            const auto before = tour[i - 1];
+            const auto first = tour[i];
+            for (auto neighbour = neighbours.begin() + before * number_of_neighbours,
+                      neighbour_end = neighbour + number_of_neighbours;
+                 neighbour != neighbour_end;
+                 ++neighbour)
+            {
+                const auto j = position[*neighbour];
+                if (j <= i)
+                    continue;
+
+                const auto last = tour[j];
+                const auto after = at(j + 1);
+                const auto old_duration = distance(before, first) +
+                                          (forward_prefix[j] - forward_prefix[i]) +
+                                          distance(last, after);
+                const auto new_duration = distance(before, last) +
+                                          (reverse_prefix[j] - reverse_prefix[i]) +
+                                          distance(first, after);
+                if (new_duration < old_duration)
+                {
+                    std::reverse(tour.begin() + i, tour.begin() + j + 1);
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    // applies the first improving Or-opt move, relocating the trip between i and i + length
+    // right in front of one of the neighbours of its last location
+    const auto or_opt = [&]() {
+        for (std::size_t length = 1; length <= OR_OPT_MAX_SEGMENT; ++length)
+        {
+            for (std::size_t i = 1; i + length <= number_of_nodes; ++i)
+            {
+                const auto before = tour[i - 1];
+                const auto first = tour[i];
+                const auto last = tour[i + length - 1];
+                const auto after = at(i + length);
+                const auto removal_gain =
+                    distance(before, first) + distance(last, after) - distance(before, after);
+
+                for (auto neighbour = neighbours.begin() + last * number_of_neighbours,
+                          neighbour_end = neighbour + number_of_neighbours;
+                     neighbour != neighbour_end;
+                     ++neighbour)
+                {
+                    const auto next = *neighbour;
+                    const auto next_position = position[next];
+                    const auto previous = at(next_position + number_of_nodes - 1);
+                    // inside of the segment or where it already is
+                    if ((next_position >= i && next_position < i + length) || next == after)
+                        continue;
+
+                    const auto insertion_cost = distance(previous, first) +
+                                                distance(last, next) - distance(previous, next);
+                    if (insertion_cost < removal_gain)
+                    {
+                        const std::vector<std::size_t> segment(tour.begin() + i,
+                                                               tour.begin() + i + length);
+                        tour.erase(tour.begin() + i, tour.begin() + i + length);
+                        // in front of the first location is the end of the round trip
+                        const auto insert_at =
+                            next_position == 0
+                                ? tour.end()
+                                : std::find(tour.begin(), tour.end(), next);
+                        tour.insert(insert_at, segment.begin(), segment.end());
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    };
+
+    bool improved = true;
+    while (improved && std::chrono::steady_clock::now() < deadline)
+    {
+        CheckQueryDeadline(number_of_nodes);
+        for (std::size_t index = 0; index < number_of_nodes; ++index)
+        {
+            position[tour[index]] = index;
+            forward_prefix[index + 1] = forward_prefix[index] + distance(tour[index], at(index + 1));
+            reverse_prefix[index + 1] = reverse_prefix[index] + distance(at(index + 1), tour[index]);
+        }
+
+        improved = two_opt() || or_opt();
+    }
+
+    std::vector<NodeID> improved_route(number_of_nodes);
+    std::transform(tour.begin(), tour.end(), improved_route.begin(), [&](const std::size_t node) {
+        return route[node];
+    });
+    BOOST_ASSERT(improved_route.front() == route.front());
+    return improved_route;
+}
+}
+}
+}
+
+#endif // TRIP_LOCAL_SEARCH_HPP
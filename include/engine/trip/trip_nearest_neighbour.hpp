@@ -1,12 +1,16 @@
 #ifndef TRIP_NEAREST_NEIGHBOUR_HPP
 #define TRIP_NEAREST_NEIGHBOUR_HPP
 
+#include "engine/query_deadline.hpp"
 #include "util/dist_table_wrapper.hpp"
 #include "util/simple_logger.hpp"
 #include "util/typedefs.hpp"
 
 #include "osrm/json_container.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <algorithm>
 #include <cstdlib>
 #include <limits>
@@ -36,61 +40,76 @@ std::vector<NodeID> NearestNeighbourTrip(const NodeIDIterator &start,
     // 6. repeat 1-5 with different starting points and choose iteration with shortest trip
     // 7. DONE!
     //////////////////////////////////////////////////////////////////////////////////////////////////
-    std::vector<NodeID> route;
-    route.reserve(number_of_locations);
-
-    const auto component_size = std::distance(start, end);
-    auto shortest_trip_distance = INVALID_EDGE_WEIGHT;
-
-    // ALWAYS START AT ANOTHER STARTING POINT
-    for (auto start_node = start; start_node != end; ++start_node)
+    const std::size_t component_size = std::distance(start, end);
+    if (component_size == 0)
     {
-        NodeID curr_node = *start_node;
+        return {};
+    }
+    std::vector<EdgeWeight> trip_distances(component_size);
+    std::vector<std::vector<NodeID>> routes(component_size);
 
-        std::vector<NodeID> curr_route;
-        curr_route.reserve(component_size);
-        curr_route.push_back(*start_node);
+    // ALWAYS START AT ANOTHER STARTING POINT, the starts are independent and tried in parallel
+    const auto *const deadline = ActiveQueryDeadline();
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, component_size),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            const QueryDeadlineScope deadline_scope(deadline);
+            for (auto start_index = range.begin(); start_index != range.end(); ++start_index)
+            {
+                CheckQueryDeadline(component_size * component_size);
+                NodeID curr_node = *(start + start_index);
 
-        // visited[i] indicates whether node i was already visited by the salesman
-        std::vector<bool> visited(number_of_locations, false);
-        visited[*start_node] = true;
+                std::vector<NodeID> curr_route;
+                curr_route.reserve(component_size);
+                curr_route.push_back(curr_node);
 
-        // 3. REPEAT FOR EVERY UNVISITED NODE
-        EdgeWeight trip_dist = 0;
-        for (std::size_t via_point = 1; via_point < component_size; ++via_point)
-        {
-            EdgeWeight min_dist = INVALID_EDGE_WEIGHT;
-            NodeID min_id = SPECIAL_NODEID;
+                // visited[i] indicates whether node i was already visited by the salesman
+                std::vector<bool> visited(number_of_locations, false);
+                visited[curr_node] = true;
 
-            // 2. FIND NEAREST NEIGHBOUR
-            for (auto next = start; next != end; ++next)
-            {
-                const auto curr_dist = dist_table(curr_node, *next);
-                BOOST_ASSERT_MSG(curr_dist != INVALID_EDGE_WEIGHT, "invalid distance found");
-                if (!visited[*next] && curr_dist < min_dist)
+                // 3. REPEAT FOR EVERY UNVISITED NODE
+                EdgeWeight trip_dist = 0;
+                for (std::size_t via_point = 1; via_point < component_size; ++via_point)
                 {
-                    min_dist = curr_dist;
-                    min_id = *next;
-                }
-            }
+                    EdgeWeight min_dist = INVALID_EDGE_WEIGHT;
+                    NodeID min_id = SPECIAL_NODEID;
 
-            BOOST_ASSERT_MSG(min_id != SPECIAL_NODEID, "no next node found");
+                    // 2. FIND NEAREST NEIGHBOUR
+                    for (auto next = start; next != end; ++next)
+                    {
+                        const auto curr_dist = dist_table(curr_node, *next);
+                        BOOST_ASSERT_MSG(curr_dist != INVALID_EDGE_WEIGHT,
+                                         "invalid distance found");
+                        if (!visited[*next] && curr_dist < min_dist)
+                        {
+                            min_dist = curr_dist;
+                            min_id = *next;
+                        }
+                    }
 
-            visited[min_id] = true;
-            curr_route.push_back(min_id);
-            trip_dist += min_dist;
-            curr_node = min_id;
-        }
+                    BOOST_ASSERT_MSG(min_id != SPECIAL_NODEID, "no next node found");
+
+                    visited[min_id] = true;
+                    curr_route.push_back(min_id);
+                    trip_dist += min_dist;
+                    curr_node = min_id;
+                }
 
-        // check round trip with this starting point is shorter than the shortest round trip found
-        // till now
-        if (trip_dist < shortest_trip_distance)
+                trip_distances[start_index] = trip_dist;
+                routes[start_index] = std::move(curr_route);
+            }
+        });
+
+    // the round trip of the first starting point that is shorter than the ones before
+    std::size_t shortest = 0;
+    for (std::size_t start_index = 1; start_index < component_size; ++start_index)
+    {
+        if (trip_distances[start_index] < trip_distances[shortest])
         {
-            shortest_trip_distance = trip_dist;
-            route = std::move(curr_route);
+            shortest = start_index;
         }
     }
-    return route;
+    return routes[shortest];
 }
 }
 }
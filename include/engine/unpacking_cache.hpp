@@ -0,0 +1,82 @@
+#ifndef ENGINE_UNPACKING_CACHE_HPP
+#define ENGINE_UNPACKING_CACHE_HPP
+
+#include "util/lru_cache.hpp"
+#include "util/make_unique.hpp"
+#include "util/typedefs.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+/**
+ * Bounded cache of unpacked shortcuts, shared by all plugins of one dataset generation.
+ *
+ * Maps the id of a shortcut of the contracted graph to the original edges it stands for, in
+ * path order. Only shortcuts of packed paths, the top of the hierarchy, that expand to at least
+ * MIN_UNPACKED_EDGES original edges are worth caching.
+ *
+ * The cache is split into independently locked shards so that concurrent queries rarely
+ * contend on the same mutex.
+ */
+class UnpackingCache
+{
+  public:
+    static const constexpr std::size_t MIN_UNPACKED_EDGES = 8;
+
+    explicit UnpackingCache(const std::size_t capacity)
+    {
+        const auto shard_capacity = std::max<std::size_t>(1, capacity / NUMBER_OF_SHARDS);
+        shards.reserve(NUMBER_OF_SHARDS);
+        for (std::size_t i = 0; i < NUMBER_OF_SHARDS; ++i)
+        {
+            shards.push_back(util::make_unique<Shard>(shard_capacity));
+        }
+    }
+
+    // appends the original edges of the shortcut, returns false if it is not cached
+    bool Get(const EdgeID shortcut, std::vector<EdgeID> &original_edges)
+    {
+        auto &shard = GetShard(shortcut);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (const auto cached = shard.cache.Get(shortcut))
+        {
+            original_edges.insert(original_edges.end(), cached->begin(), cached->end());
+            return true;
+        }
+        return false;
+    }
+
+    void Put(const EdgeID shortcut, std::vector<EdgeID> original_edges)
+    {
+        auto &shard = GetShard(shortcut);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.cache.Put(shortcut, std::move(original_edges));
+    }
+
+  private:
+    static const constexpr std::size_t NUMBER_OF_SHARDS = 8;
+
+    struct Shard
+    {
+        explicit Shard(const std::size_t capacity) : cache(capacity) {}
+
+        std::mutex mutex;
+        util::LRUCache<EdgeID, std::vector<EdgeID>> cache;
+    };
+
+    Shard &GetShard(const EdgeID shortcut) { return *shards[shortcut % NUMBER_OF_SHARDS]; }
+
+    std::vector<std::unique_ptr<Shard>> shards;
+};
+}
+}
+
+#endif // ENGINE_UNPACKING_CACHE_HPP
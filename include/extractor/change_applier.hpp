@@ -0,0 +1,60 @@
+#ifndef CHANGE_APPLIER_HPP
+#define CHANGE_APPLIER_HPP
+
+#include "util/typedefs.hpp"
+
+#include <boost/filesystem/path.hpp>
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// Applies OSM change files (.osc) to the buffers the input of the extraction is read in, so that
+// an updated extract is built from the last input and the changes since, without writing the
+// updated input first. The input has to be sorted by type and id, like planet files and the
+// extracts made from them are.
+class ChangeApplier
+{
+  public:
+    // Reads the changes of all files into memory. Of objects changed more than once only the
+    // newest version is applied.
+    explicit ChangeApplier(const std::vector<boost::filesystem::path> &change_paths);
+
+    // The buffer with changed objects replaced by their newest version, deleted objects dropped
+    // and created objects inserted in order. Buffers have to be passed in input order.
+    osmium::memory::Buffer Apply(const osmium::memory::Buffer &input);
+
+    // The created objects that come after the last object of the input, once all of the input
+    // was passed to Apply. The buffer is invalid if there are none.
+    osmium::memory::Buffer Finish();
+
+    std::size_t GetNumberOfChanges() const { return changes.size(); }
+
+    // Ascending ids of the ways that were created, modified or deleted, or that reference a
+    // changed node. These are the ways whose segments may differ from the last extract.
+    const std::vector<OSMWayID> &GetAffectedWays() const { return affected_ways; }
+
+  private:
+    void ApplyChangesBefore(const osmium::OSMObject &object, osmium::memory::Buffer &output);
+    void ApplyNextChange(osmium::memory::Buffer &output);
+
+    osmium::memory::Buffer change_buffer;
+    // newest version of every changed object, sorted by type and id
+    std::vector<const osmium::OSMObject *> changes;
+    std::vector<const osmium::OSMObject *>::const_iterator next_change;
+    // sorted ids of the changed nodes
+    std::vector<osmium::object_id_type> changed_nodes;
+
+    std::vector<OSMWayID> affected_ways;
+};
+}
+}
+
+#endif // CHANGE_APPLIER_HPP
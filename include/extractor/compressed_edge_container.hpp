@@ -3,6 +3,8 @@
 
 #include "util/typedefs.hpp"
 
+#include <boost/range/iterator_range.hpp>
+
 #include <unordered_map>
 
 #include <string>
@@ -22,7 +24,8 @@ class CompressedEdgeContainer
         NodeID node_id;    // refers to an internal node-based-node
         EdgeWeight weight; // the weight of the edge leading to this node
     };
-    using EdgeBucket = std::vector<CompressedEdge>;
+    // geometry of an edge, it is valid until the next edge is added or compressed
+    using EdgeBucket = boost::iterator_range<std::vector<CompressedEdge>::const_iterator>;
 
     CompressedEdgeContainer();
     void CompressEdge(const EdgeID surviving_edge_id,
@@ -35,21 +38,42 @@ class CompressedEdgeContainer
     void
     AddUncompressedEdge(const EdgeID edgei_id, const NodeID target_node, const EdgeWeight weight);
 
+    // Adds the geometries of many edges at once, the geometry of edge_ids[i] are the entries
+    // from offsets[i] up to offsets[i + 1] of geometries
+    void AddEdgeGeometries(const std::vector<EdgeID> &edge_ids,
+                           const std::vector<unsigned> &offsets,
+                           std::vector<CompressedEdge> geometries);
+
     bool HasEntryForID(const EdgeID edge_id) const;
     void PrintStatistics() const;
-    void SerializeInternalVector(const std::string &path) const;
+    // compress writes the file in compressed frames, see util::IntermediateOutputFile
+    void SerializeInternalVector(const std::string &path, const bool compress) const;
+    // Position of every geometry in the list that SerializeInternalVector writes, followed by
+    // the size of that list
+    std::vector<unsigned> GetGeometryIndices() const;
     unsigned GetPositionForID(const EdgeID edge_id) const;
-    const EdgeBucket &GetBucketReference(const EdgeID edge_id) const;
+    EdgeBucket GetBucketReference(const EdgeID edge_id) const;
     bool IsTrivial(const EdgeID edge_id) const;
     NodeID GetFirstEdgeTargetID(const EdgeID edge_id) const;
     NodeID GetLastEdgeTargetID(const EdgeID edge_id) const;
     NodeID GetLastEdgeSourceID(const EdgeID edge_id) const;
 
   private:
-    int free_list_maximum = 0;
+    // the entries of the arena that belong to one edge
+    struct GeometryRange
+    {
+        unsigned begin;
+        unsigned size;
+    };
+
+    unsigned GetOrAddBucket(const EdgeID edge_id);
+    void MoveBucketToEnd(const unsigned bucket_id);
+    void ReserveGeometries(const std::size_t additional_entries);
 
-    void IncreaseFreeList();
-    std::vector<EdgeBucket> m_compressed_geometries;
+    // Arena of the geometries of all edges. A geometry is moved to the end when it grows, the
+    // entries that are left behind are skipped when the geometries are serialized.
+    std::vector<CompressedEdge> m_geometries;
+    std::vector<GeometryRange> m_compressed_geometries;
     std::vector<unsigned> m_free_list;
     std::unordered_map<EdgeID, unsigned> m_edge_id_to_list_index_map;
 };
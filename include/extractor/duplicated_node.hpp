@@ -0,0 +1,73 @@
+#ifndef OSRM_EXTRACTOR_DUPLICATED_NODE_HPP
+#define OSRM_EXTRACTOR_DUPLICATED_NODE_HPP
+
+#include "util/typedefs.hpp"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// An edge-based node of a via way and a copy of it made for a via-way restriction, see
+// EdgeBasedGraphFactory. The copy has the geometry of the original but is only entered from the
+// from way of the restriction, so routes from there that end on the via way end on the copy.
+struct DuplicatedNode
+{
+    NodeID original;
+    NodeID duplicate;
+
+    bool operator<(const DuplicatedNode &other) const
+    {
+        return std::tie(original, duplicate) < std::tie(other.original, other.duplicate);
+    }
+};
+
+// The copies of node in [begin, end), which is sorted by the originals
+inline std::vector<NodeID>
+FindDuplicates(const DuplicatedNode *begin, const DuplicatedNode *end, const NodeID node)
+{
+    std::vector<NodeID> duplicates;
+    const auto by_original = [](const DuplicatedNode &duplicated_node, const NodeID original) {
+        return duplicated_node.original < original;
+    };
+    for (auto iter = std::lower_bound(begin, end, node, by_original);
+         iter != end && iter->original == node;
+         ++iter)
+    {
+        duplicates.push_back(iter->duplicate);
+    }
+    return duplicates;
+}
+
+// [begin, end) sorted by the copies instead of the originals, for FindOriginal
+inline std::vector<DuplicatedNode> SortByDuplicate(const DuplicatedNode *begin,
+                                                   const DuplicatedNode *end)
+{
+    std::vector<DuplicatedNode> by_duplicate(begin, end);
+    std::sort(by_duplicate.begin(),
+              by_duplicate.end(),
+              [](const DuplicatedNode &lhs, const DuplicatedNode &rhs) {
+                  return lhs.duplicate < rhs.duplicate;
+              });
+    return by_duplicate;
+}
+
+// The node a copy in [begin, end), which is sorted by the copies, was made of, node itself if it
+// is no copy
+inline NodeID
+FindOriginal(const DuplicatedNode *begin, const DuplicatedNode *end, const NodeID node)
+{
+    const auto iter = std::lower_bound(
+        begin, end, node, [](const DuplicatedNode &duplicated_node, const NodeID duplicate) {
+            return duplicated_node.duplicate < duplicate;
+        });
+    return iter == end || iter->duplicate != node ? node : iter->original;
+}
+}
+}
+
+#endif // OSRM_EXTRACTOR_DUPLICATED_NODE_HPP
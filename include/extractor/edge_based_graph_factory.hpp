@@ -4,6 +4,7 @@
 #define EDGE_BASED_GRAPH_FACTORY_HPP_
 
 #include "extractor/compressed_edge_container.hpp"
+#include "extractor/duplicated_node.hpp"
 #include "extractor/edge_based_edge.hpp"
 #include "extractor/edge_based_node.hpp"
 #include "extractor/original_edge_data.hpp"
@@ -43,6 +44,8 @@ namespace osrm
 namespace extractor
 {
 
+class ScriptingEnvironment;
+
 namespace lookup
 {
 // Set to 1 byte alignment
@@ -69,6 +72,16 @@ struct PenaltyBlock
     OSMNodeID to_id;
 } __attribute ((packed));
 static_assert(sizeof(PenaltyBlock) == 28, "PenaltyBlock is not packed correctly");
+
+// A segment of the .geometry file, the .segment_index stores them sorted by from_id and to_id
+struct SegmentIndexBlock
+{
+    OSMNodeID from_id;
+    OSMNodeID to_id;
+    std::uint32_t segment;
+    double segment_length;
+} __attribute ((packed));
+static_assert(sizeof(SegmentIndexBlock) == 28, "SegmentIndexBlock is not packed correctly");
 }
 
 class EdgeBasedGraphFactory
@@ -91,16 +104,22 @@ class EdgeBasedGraphFactory
 
     void Run(const std::string &original_edge_data_filename,
              const std::string &turn_lane_data_filename,
-             lua_State *lua_state,
+             ScriptingEnvironment &scripting_environment,
              const std::string &edge_segment_lookup_filename,
              const std::string &edge_penalty_filename,
-             const bool generate_edge_lookup);
+             const std::string &segment_index_filename,
+             const bool generate_edge_lookup,
+             const bool compress_edge_data,
+             const std::string &turn_cost_tables_filename,
+             const bool generate_turn_cost_tables);
 
     // The following get access functions destroy the content in the factory
     void GetEdgeBasedEdges(util::DeallocatingVector<EdgeBasedEdge> &edges);
     void GetEdgeBasedNodes(std::vector<EdgeBasedNode> &nodes);
     void GetStartPointMarkers(std::vector<bool> &node_is_startpoint);
     void GetEdgeBasedNodeWeights(std::vector<EdgeWeight> &output_node_weights);
+    // The copies of via ways made for via-way restrictions, sorted by their original
+    void GetDuplicatedNodes(std::vector<DuplicatedNode> &duplicated_nodes) const;
 
     // These access functions don't destroy the content
     const std::vector<BearingClassID> &GetBearingClassIds() const;
@@ -143,8 +162,9 @@ class EdgeBasedGraphFactory
     std::shared_ptr<util::NodeBasedDynamicGraph> m_node_based_graph;
     std::shared_ptr<RestrictionMap const> m_restriction_map;
 
-    const std::unordered_set<NodeID> &m_barrier_nodes;
-    const std::unordered_set<NodeID> &m_traffic_lights;
+    //! dense per-node flags, the turn generation reads them concurrently
+    std::vector<bool> m_barrier_nodes;
+    std::vector<bool> m_traffic_lights;
     const CompressedEdgeContainer &m_compressed_edge_container;
 
     ProfileProperties profile_properties;
@@ -158,14 +178,51 @@ class EdgeBasedGraphFactory
     void GenerateEdgeExpandedNodes();
     void GenerateEdgeExpandedEdges(const std::string &original_edge_data_filename,
                                    const std::string &turn_lane_data_filename,
-                                   lua_State *lua_state,
+                                   ScriptingEnvironment &scripting_environment,
                                    const std::string &edge_segment_lookup_filename,
                                    const std::string &edge_fixed_penalties_filename,
-                                   const bool generate_edge_lookup);
+                                   const std::string &segment_index_filename,
+                                   const bool generate_edge_lookup,
+                                   const bool compress_edge_data,
+                                   const std::string &turn_cost_tables_filename,
+                                   const bool generate_turn_cost_tables);
+
+    // Writes the segments of all geometries sorted by their OSM nodes, followed by the position
+    // of the first segment of every edge-based edge in the .geometry file. Speed updates merge
+    // this index with their sorted speeds instead of searching the speed of every segment.
+    void WriteSegmentIndex(const std::string &segment_index_filename,
+                           const std::vector<unsigned> &geometry_indices,
+                           const std::vector<std::uint32_t> &edge_first_segments) const;
 
     void InsertEdgeBasedNode(const NodeID u, const NodeID v);
 
-    void FlushVectorToStream(std::ofstream &edge_data_file,
+    // A restriction over a via way gets a copy of the edge-based node of the via way. The copy
+    // replaces the via way after the from edge and only has the turns the restriction allows.
+    // Routes from the from edge that end on the via way end on the copy, the copies are written
+    // to the .duplicated_nodes file so that queries search to them along with the original.
+    struct ViaWayDuplicate
+    {
+        NodeID edge_based_node;
+        bool is_only;
+        std::vector<EdgeID> to_edges;
+
+        bool IsAllowed(const EdgeID to_edge) const
+        {
+            const bool is_to_edge =
+                std::find(to_edges.begin(), to_edges.end(), to_edge) != to_edges.end();
+            return is_only == is_to_edge;
+        }
+    };
+
+    void GenerateViaWayNodes();
+
+    std::vector<ViaWayDuplicate> m_via_way_duplicates;
+    //! (from edge, via edge) -> duplicate that is entered instead of the via edge
+    std::unordered_map<std::uint64_t, std::size_t> m_via_way_duplicate_by_turn;
+    //! via edge -> its duplicates
+    std::unordered_map<EdgeID, std::vector<std::size_t>> m_via_way_duplicates_by_edge;
+
+    void FlushVectorToStream(std::ostream &edge_data_file,
                              std::vector<OriginalEdgeData> &original_edge_data_vector) const;
 
     std::size_t restricted_turns_counter;
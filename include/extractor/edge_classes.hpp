@@ -0,0 +1,58 @@
+#ifndef OSRM_EXTRACTOR_EDGE_CLASSES_HPP
+#define OSRM_EXTRACTOR_EDGE_CLASSES_HPP
+
+#include "util/exception.hpp"
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// Bit set of the classes a profile marks a way with, e.g. toll roads. Route requests can exclude
+// classes, see osrm-contract --exclude-classes.
+using EdgeClasses = std::uint8_t;
+}
+}
+
+const constexpr osrm::extractor::EdgeClasses EDGE_CLASS_NONE = 0;
+const constexpr osrm::extractor::EdgeClasses EDGE_CLASS_TOLL = 1 << 0;
+const constexpr osrm::extractor::EdgeClasses EDGE_CLASS_MOTORWAY = 1 << 1;
+const constexpr osrm::extractor::EdgeClasses EDGE_CLASS_FERRY = 1 << 2;
+
+namespace osrm
+{
+namespace extractor
+{
+
+// Parses a comma separated list of class names like "toll,ferry"
+inline EdgeClasses ParseEdgeClasses(const std::string &names)
+{
+    std::vector<std::string> class_names;
+    boost::split(class_names, names, boost::is_any_of(","));
+
+    EdgeClasses classes = EDGE_CLASS_NONE;
+    for (const auto &name : class_names)
+    {
+        if (name == "toll")
+            classes |= EDGE_CLASS_TOLL;
+        else if (name == "motorway")
+            classes |= EDGE_CLASS_MOTORWAY;
+        else if (name == "ferry")
+            classes |= EDGE_CLASS_FERRY;
+        else
+            throw util::exception("Unknown edge class " + name +
+                                  ", known are toll, motorway and ferry");
+    }
+    return classes;
+}
+}
+}
+
+#endif // OSRM_EXTRACTOR_EDGE_CLASSES_HPP
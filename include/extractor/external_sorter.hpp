@@ -0,0 +1,180 @@
+#ifndef OSRM_EXTRACTOR_EXTERNAL_SORTER_HPP
+#define OSRM_EXTRACTOR_EXTERNAL_SORTER_HPP
+
+#include "util/exception.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// Sorts the data collected by the extractor. Ranges that fit into the memory budget are copied
+// into memory and sorted in parallel. Larger ranges are cut into runs of the budget's size that
+// are sorted in parallel and spilled to disk, the runs are then merged back into the range.
+//
+// The elements are spilled as raw bytes, so they need to be trivially copyable.
+class ExternalSorter
+{
+  public:
+    ExternalSorter(const std::size_t memory_budget, boost::filesystem::path spill_directory)
+        : memory_budget(memory_budget), spill_directory(std::move(spill_directory))
+    {
+    }
+
+    template <typename Iterator, typename Compare>
+    void Sort(Iterator begin, Iterator end, Compare compare) const
+    {
+        using ValueT = typename std::iterator_traits<Iterator>::value_type;
+
+        const std::size_t size = std::distance(begin, end);
+        const std::size_t run_size = std::max<std::size_t>(1, memory_budget / sizeof(ValueT));
+
+        std::vector<ValueT> buffer;
+        if (size <= run_size)
+        {
+            buffer.assign(begin, end);
+            tbb::parallel_sort(buffer.begin(), buffer.end(), compare);
+            std::copy(buffer.begin(), buffer.end(), begin);
+            return;
+        }
+
+        std::vector<Run> runs;
+        // removes the spill files on every exit, including exceptions
+        const SpillFiles spill_files{runs};
+
+        buffer.reserve(run_size);
+        for (auto run_begin = begin; run_begin != end;)
+        {
+            const auto run_end =
+                run_begin + std::min<std::size_t>(run_size, std::distance(run_begin, end));
+            buffer.assign(run_begin, run_end);
+            tbb::parallel_sort(buffer.begin(), buffer.end(), compare);
+
+            Run run;
+            run.path = spill_directory / boost::filesystem::unique_path("osrm-sort-%%%%-%%%%.tmp");
+            run.size = buffer.size();
+            runs.push_back(std::move(run));
+
+            boost::filesystem::ofstream run_stream(runs.back().path, std::ios::binary);
+            run_stream.write(reinterpret_cast<const char *>(buffer.data()),
+                             buffer.size() * sizeof(ValueT));
+            if (!run_stream)
+            {
+                throw util::exception("Could not spill sort run to " +
+                                      runs.back().path.string());
+            }
+            run_begin = run_end;
+        }
+        buffer.clear();
+        buffer.shrink_to_fit();
+
+        Merge<ValueT>(runs, std::max<std::size_t>(1, run_size / runs.size()), begin, compare);
+    }
+
+  private:
+    struct Run
+    {
+        boost::filesystem::path path;
+        std::size_t size;
+    };
+
+    struct SpillFiles
+    {
+        ~SpillFiles()
+        {
+            for (const auto &run : runs)
+            {
+                boost::system::error_code error;
+                boost::filesystem::remove(run.path, error);
+            }
+        }
+        const std::vector<Run> &runs;
+    };
+
+    // Multi-way merge of the sorted runs, every run is read in blocks of block_size elements
+    template <typename ValueT, typename Iterator, typename Compare>
+    void Merge(const std::vector<Run> &runs,
+               const std::size_t block_size,
+               Iterator output,
+               Compare compare) const
+    {
+        struct RunReader
+        {
+            boost::filesystem::ifstream stream;
+            std::vector<ValueT> block;
+            std::size_t position;
+            std::size_t remaining;
+
+            bool Next(const std::size_t block_size)
+            {
+                if (++position < block.size())
+                    return true;
+                if (remaining == 0)
+                    return false;
+
+                block.resize(std::min(block_size, remaining));
+                stream.read(reinterpret_cast<char *>(block.data()), block.size() * sizeof(ValueT));
+                if (!stream)
+                {
+                    throw util::exception("Could not read spilled sort run");
+                }
+                remaining -= block.size();
+                position = 0;
+                return true;
+            }
+        };
+
+        std::vector<RunReader> readers(runs.size());
+        for (std::size_t index = 0; index < runs.size(); ++index)
+        {
+            readers[index].stream.open(runs[index].path, std::ios::binary);
+            readers[index].position = 0;
+            readers[index].remaining = runs[index].size;
+        }
+
+        // the queue holds the index of every run that is not exhausted, smallest head on top
+        const auto head_greater = [&](const std::size_t lhs, const std::size_t rhs) {
+            return compare(readers[rhs].block[readers[rhs].position],
+                           readers[lhs].block[readers[lhs].position]);
+        };
+        std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(head_greater)> queue(
+            head_greater);
+        for (std::size_t index = 0; index < readers.size(); ++index)
+        {
+            // the block is still empty, so this loads the first one
+            if (readers[index].Next(block_size))
+                queue.push(index);
+        }
+
+        while (!queue.empty())
+        {
+            const auto index = queue.top();
+            queue.pop();
+            auto &reader = readers[index];
+            *output = reader.block[reader.position];
+            ++output;
+            if (reader.Next(block_size))
+                queue.push(index);
+        }
+    }
+
+    const std::size_t memory_budget;
+    const boost::filesystem::path spill_directory;
+};
+}
+}
+
+#endif // OSRM_EXTRACTOR_EXTERNAL_SORTER_HPP
@@ -2,6 +2,8 @@
 #define EXTRACTION_CONTAINERS_HPP
 
 #include "extractor/external_memory_node.hpp"
+#include "extractor/external_sorter.hpp"
+#include "extractor/extractor_config.hpp"
 #include "extractor/first_and_last_segment_of_way.hpp"
 #include "extractor/guidance/turn_lane_types.hpp"
 #include "extractor/internal_extractor_edge.hpp"
@@ -11,6 +13,7 @@
 #include <stxxl/vector>
 #include <unordered_map>
 #include <cstdint>
+#include <iosfwd>
 
 namespace osrm
 {
@@ -19,7 +22,8 @@ namespace extractor
 
 /**
  * Uses external memory containers from stxxl to store all the data that
- * is collected by the extractor callbacks.
+ * is collected by the extractor callbacks. The data is sorted either by stxxl
+ * or by the parallel ExternalSorter, depending on the extractor config.
  *
  * The data is the filtered, aggregated and finally written to disk.
  */
@@ -32,13 +36,27 @@ class ExtractionContainers
 #else
     const static unsigned stxxl_memory = ((sizeof(std::size_t) == 4) ? INT_MAX : UINT_MAX);
 #endif
+    const ExtractorConfig::SortAlgorithm sort_algorithm;
+    const ExternalSorter sorter;
+    const bool spatial_node_order;
+
+    // Compare has to provide min_value() and max_value() for stxxl
+    template <typename VectorT, typename Compare> void Sort(VectorT &vector, Compare compare);
+
+    template <typename GetNodeID, typename OnMatch, typename OnMiss>
+    void JoinEdgesWithNodes(GetNodeID get_node_id,
+                            OnMatch on_match,
+                            OnMiss on_miss,
+                            bool skip_invalid_sources);
+
     void PrepareNodes();
     void PrepareRestrictions();
-    void PrepareEdges(lua_State *segment_state);
+    void PrepareViaWayRestrictions();
+    void PrepareEdges(ScriptingEnvironment &scripting_environment);
 
-    void WriteNodes(std::ofstream &file_out_stream) const;
+    void WriteNodes(std::ostream &file_out_stream) const;
     void WriteRestrictions(const std::string &restrictions_file_name) const;
-    void WriteEdges(std::ofstream &file_out_stream) const;
+    void WriteEdges(std::ostream &file_out_stream) const;
     void WriteCharData(const std::string &file_name,
                        const stxxl::vector<unsigned> &offests,
                        const stxxl::vector<char> &char_data) const;
@@ -62,17 +80,19 @@ class ExtractionContainers
     stxxl::vector<std::uint32_t> turn_lane_offsets;
     stxxl::vector<guidance::TurnLaneType::Mask> turn_lane_masks;
     STXXLRestrictionsVector restrictions_list;
+    // restrictions over a via way, they are resolved separately and appended to restrictions_list
+    STXXLRestrictionsVector via_way_restrictions_list;
     STXXLWayIDStartEndVector way_start_end_id_list;
     std::unordered_map<OSMNodeID, NodeID> external_to_internal_node_id_map;
     unsigned max_internal_node_id;
 
-    ExtractionContainers();
+    explicit ExtractionContainers(const ExtractorConfig &config);
 
     void PrepareData(const std::string &output_file_name,
                      const std::string &restrictions_file_name,
                      const std::string &names_file_name,
                      const std::string &turn_lane_file_name,
-                     lua_State *segment_state);
+                     ScriptingEnvironment &scripting_environment);
 };
 }
 }
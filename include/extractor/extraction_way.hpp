@@ -1,6 +1,7 @@
 #ifndef EXTRACTION_WAY_HPP
 #define EXTRACTION_WAY_HPP
 
+#include "extractor/edge_classes.hpp"
 #include "extractor/travel_mode.hpp"
 #include "util/guidance/turn_lanes.hpp"
 #include "util/typedefs.hpp"
@@ -38,6 +39,7 @@ struct ExtractionWay
         backward_travel_mode = TRAVEL_MODE_INACCESSIBLE;
         turn_lanes_forward.clear();
         turn_lanes_backward.clear();
+        classes = EDGE_CLASS_NONE;
     }
 
     // These accessors exists because it's not possible to take the address of a bitfield,
@@ -46,6 +48,9 @@ struct ExtractionWay
     TravelMode get_forward_mode() const { return forward_travel_mode; }
     void set_backward_mode(const TravelMode m) { backward_travel_mode = m; }
     TravelMode get_backward_mode() const { return backward_travel_mode; }
+    // LUA has no notion of small integers
+    void set_classes(const unsigned c) { classes = static_cast<EdgeClasses>(c); }
+    unsigned get_classes() const { return classes; }
 
     double forward_speed;
     double backward_speed;
@@ -60,6 +65,7 @@ struct ExtractionWay
     bool is_startpoint;
     TravelMode forward_travel_mode : 4;
     TravelMode backward_travel_mode : 4;
+    EdgeClasses classes;
 };
 }
 }
@@ -55,7 +55,7 @@ class Extractor
     ExtractorConfig config;
 
     std::pair<std::size_t, EdgeID>
-    BuildEdgeExpandedGraph(lua_State *lua_state,
+    BuildEdgeExpandedGraph(ScriptingEnvironment &scripting_environment,
                            const ProfileProperties &profile_properties,
                            std::vector<QueryNode> &internal_to_external_node_map,
                            std::vector<EdgeBasedNode> &node_based_edge_list,
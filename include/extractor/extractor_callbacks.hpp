@@ -1,11 +1,12 @@
 #ifndef EXTRACTOR_CALLBACKS_HPP
 #define EXTRACTOR_CALLBACKS_HPP
 
+#include "util/lru_cache.hpp"
 #include "util/typedefs.hpp"
 #include "extractor/guidance/turn_lane_types.hpp"
 
 #include <boost/functional/hash.hpp>
-#include <boost/optional/optional_fwd.hpp>
+#include <boost/optional/optional.hpp>
 
 #include <string>
 #include <unordered_map>
@@ -55,8 +56,31 @@ class ExtractorCallbacks
     // warning: caller needs to take care of synchronization!
     void ProcessRestriction(const boost::optional<InputRestrictionContainer> &restriction);
 
+    // Turn lane descriptions of a way, none where the profile did not set lanes
+    struct WayTurnLanes
+    {
+        boost::optional<guidance::TurnLaneDescription> forward;
+        boost::optional<guidance::TurnLaneDescription> backward;
+    };
+
+    // Lane descriptions by turn:lanes string. Few distinct strings are tagged on many ways.
+    using TurnLaneCache = util::LRUCache<std::string, guidance::TurnLaneDescription>;
+
+    // Parses the turn lane strings of a way, the expensive part of processing it. Does not
+    // touch the callbacks, so it can run in parallel ahead of ProcessWay.
+    static WayTurnLanes ParseTurnLanes(const ExtractionWay &result_way);
+
+    // Same, but only parses strings that are not in the cache. The cache is not thread-safe,
+    // every thread uses its own.
+    static WayTurnLanes ParseTurnLanes(const ExtractionWay &result_way, TurnLaneCache &cache);
+
     // warning: caller needs to take care of synchronization!
     void ProcessWay(const osmium::Way &current_way, const ExtractionWay &result_way);
+
+    // warning: caller needs to take care of synchronization!
+    void ProcessWay(const osmium::Way &current_way,
+                    const ExtractionWay &result_way,
+                    const WayTurnLanes &turn_lanes);
 };
 }
 }
@@ -31,7 +31,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/filesystem/path.hpp>
 
 #include <array>
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -40,7 +42,20 @@ namespace extractor
 
 struct ExtractorConfig
 {
-    ExtractorConfig() noexcept : requested_num_threads(0) {}
+    // Parallel sorts in memory and spills to disk if the data exceeds sort_memory, STXXL uses
+    // stxxl's single threaded external sort.
+    enum class SortAlgorithm
+    {
+        Parallel,
+        STXXL
+    };
+
+    ExtractorConfig() noexcept
+        : requested_num_threads(0), sort_algorithm(SortAlgorithm::Parallel),
+          sort_memory(4ull * 1024 * 1024 * 1024), memory_budget(0), compress_intermediates(false),
+          spatial_node_order(false), generate_turn_cost_tables(false)
+    {
+    }
     void UseDefaultOutputNames()
     {
         std::string basepath = input_path.string();
@@ -70,16 +85,26 @@ struct ExtractorConfig
         edge_graph_output_path = basepath + ".osrm.ebg";
         rtree_nodes_output_path = basepath + ".osrm.ramIndex";
         rtree_leafs_output_path = basepath + ".osrm.fileIndex";
+        node_order_output_path = basepath + ".osrm.node_order";
         edge_segment_lookup_path = basepath + ".osrm.edge_segment_lookup";
         edge_penalty_path = basepath + ".osrm.edge_penalties";
+        segment_index_path = basepath + ".osrm.segment_index";
         edge_based_node_weights_output_path = basepath + ".osrm.enw";
+        duplicated_nodes_output_path = basepath + ".osrm.duplicated_nodes";
         profile_properties_output_path = basepath + ".osrm.properties";
         intersection_class_data_output_path = basepath + ".osrm.icd";
+        changed_ways_output_path = basepath + ".osrm.changed_ways";
+        turn_cost_tables_output_path = basepath + ".osrm.turn_costs";
     }
 
     boost::filesystem::path config_file_path;
     boost::filesystem::path input_path;
     boost::filesystem::path profile_path;
+    // polygon of the region to extract, everything is extracted if empty
+    boost::filesystem::path region_polygon_path;
+    // OSM change files (.osc) that are applied to the input while it is read, in order. The ids
+    // of the ways they affect are written to changed_ways_output_path.
+    std::vector<boost::filesystem::path> change_paths;
 
     std::string output_file_name;
     std::string restriction_file_name;
@@ -91,18 +116,40 @@ struct ExtractorConfig
     std::string edge_output_path;
     std::string edge_graph_output_path;
     std::string edge_based_node_weights_output_path;
+    // the copies of via ways made for via-way restrictions, see DuplicatedNode
+    std::string duplicated_nodes_output_path;
     std::string node_output_path;
     std::string rtree_nodes_output_path;
     std::string rtree_leafs_output_path;
+    std::string node_order_output_path;
     std::string profile_properties_output_path;
     std::string intersection_class_data_output_path;
+    std::string changed_ways_output_path;
 
     unsigned requested_num_threads;
     unsigned small_component_size;
 
+    SortAlgorithm sort_algorithm;
+    // memory budget of the parallel sort in bytes
+    std::size_t sort_memory;
+    // peak memory in bytes every phase of the extraction should stay below, 0 for no limit.
+    // Phases that exceed it are reported.
+    std::size_t memory_budget;
+
     bool generate_edge_lookup;
+    // compress the intermediates read by osrm-contract and osrm-datastore in parallel frames
+    bool compress_intermediates;
+    // number the nodes along a hilbert curve instead of by their OSM ids
+    bool spatial_node_order;
     std::string edge_penalty_path;
     std::string edge_segment_lookup_path;
+    // segments of the geometries sorted by their OSM nodes, see lookup::SegmentIndexBlock
+    std::string segment_index_path;
+
+    // Write the turn costs of the node-based graph as deduplicated per-intersection tables, see
+    // TurnCostTables
+    bool generate_turn_cost_tables;
+    std::string turn_cost_tables_output_path;
 };
 }
 }
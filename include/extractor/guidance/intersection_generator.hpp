@@ -5,11 +5,12 @@
 #include "extractor/guidance/intersection.hpp"
 #include "extractor/query_node.hpp"
 #include "extractor/restriction_map.hpp"
+#include "util/coordinate.hpp"
 #include "util/name_table.hpp"
 #include "util/node_based_graph.hpp"
 #include "util/typedefs.hpp"
 
-#include <unordered_set>
+#include <cstddef>
 #include <vector>
 
 namespace osrm
@@ -22,13 +23,16 @@ namespace guidance
 // from it. For this all turn possibilities are analysed.
 // We consider turn restrictions to indicate possible turns. U-turns are generated based on profile
 // decisions.
+//
+// The generator is immutable after construction and can be shared by concurrent turn analyses.
+// The node-based graph must not be modified while a generator refers to it.
 
 class IntersectionGenerator
 {
   public:
     IntersectionGenerator(const util::NodeBasedDynamicGraph &node_based_graph,
                           const RestrictionMap &restriction_map,
-                          const std::unordered_set<NodeID> &barrier_nodes,
+                          const std::vector<bool> &barrier_nodes,
                           const std::vector<QueryNode> &node_info_list,
                           const CompressedEdgeContainer &compressed_edge_container);
 
@@ -37,10 +41,16 @@ class IntersectionGenerator
   private:
     const util::NodeBasedDynamicGraph &node_based_graph;
     const RestrictionMap &restriction_map;
-    const std::unordered_set<NodeID> &barrier_nodes;
+    const std::vector<bool> &barrier_nodes;
     const std::vector<QueryNode> &node_info_list;
     const CompressedEdgeContainer &compressed_edge_container;
 
+    // The shape of an intersection does not depend on the edge it is entered from: the
+    // representative coordinate of every edge, seen from its source, is computed once. The
+    // coordinates of the edges leaving a node start at shape_offsets[node], in adjacency order.
+    std::vector<std::size_t> shape_offsets;
+    std::vector<util::Coordinate> shape_coordinates;
+
     // Check for restrictions/barriers and generate a list of valid and invalid turns present at
     // the
     // node reached
@@ -2,8 +2,8 @@
 #define OSRM_EXTRACTOR_GUIDANCE_INTERSECTION_HANDLER_HPP_
 
 #include "extractor/guidance/intersection.hpp"
+#include "extractor/guidance/name_announcements.hpp"
 #include "extractor/query_node.hpp"
-#include "extractor/suffix_table.hpp"
 
 #include "util/name_table.hpp"
 #include "util/node_based_graph.hpp"
@@ -28,7 +28,7 @@ class IntersectionHandler
     IntersectionHandler(const util::NodeBasedDynamicGraph &node_based_graph,
                         const std::vector<QueryNode> &node_info_list,
                         const util::NameTable &name_table,
-                        const SuffixTable &street_name_suffix_table);
+                        const NameAnnouncements &name_announcements);
     virtual ~IntersectionHandler();
 
     // check whether the handler can actually handle the intersection
@@ -43,7 +43,7 @@ class IntersectionHandler
     const util::NodeBasedDynamicGraph &node_based_graph;
     const std::vector<QueryNode> &node_info_list;
     const util::NameTable &name_table;
-    const SuffixTable &street_name_suffix_table;
+    const NameAnnouncements &name_announcements;
 
     // counts the number on allowed entry roads
     std::size_t countValid(const Intersection &intersection) const;
@@ -0,0 +1,61 @@
+#ifndef OSRM_EXTRACTOR_GUIDANCE_NAME_ANNOUNCEMENTS_HPP_
+#define OSRM_EXTRACTOR_GUIDANCE_NAME_ANNOUNCEMENTS_HPP_
+
+#include "extractor/suffix_table.hpp"
+
+#include "util/name_table.hpp"
+#include "util/node_based_graph.hpp"
+#include "util/typedefs.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+namespace guidance
+{
+
+// Decides whether a change between two street names has to be announced. Names are stored as
+// "{name} ({ref})", a change is obvious if the names or refs are contained in one another, or if
+// the names only differ in a prefix or suffix of the suffix table, e.g. "North Main Street" and
+// "Main Street".
+//
+// The parts of every name of the node-based graph are split once, the names without their prefix
+// and without their suffix are interned. Comparing two names then never allocates and only looks
+// at the characters of the name table for containment.
+class NameAnnouncements
+{
+  public:
+    NameAnnouncements(const util::NodeBasedDynamicGraph &node_based_graph,
+                      const util::NameTable &name_table,
+                      const SuffixTable &street_name_suffix_table);
+
+    // Only valid for the names of the edges of the node-based graph
+    bool requiresNameAnnounced(const NameID from, const NameID to) const;
+
+  private:
+    // Names are at most 255 characters long, see util::NameTable
+    struct NameParts
+    {
+        std::uint8_t name_length = 0;
+        std::uint8_t ref_begin = 0;
+        std::uint8_t ref_length = 0;
+        // the first or last word of the name is in the suffix table, or the name is one word
+        bool has_suffix_prefix = false;
+        bool has_suffix_suffix = false;
+        // interned name without its first word, and without its last word
+        std::uint32_t without_prefix = 0;
+        std::uint32_t without_suffix = 0;
+    };
+
+    const util::NameTable &name_table;
+    std::vector<NameParts> name_parts;
+};
+
+} // namespace guidance
+} // namespace extractor
+} // namespace osrm
+
+#endif /* OSRM_EXTRACTOR_GUIDANCE_NAME_ANNOUNCEMENTS_HPP_ */
@@ -42,7 +42,7 @@ class RoundaboutHandler : public IntersectionHandler
                       const std::vector<QueryNode> &node_info_list,
                       const CompressedEdgeContainer &compressed_edge_container,
                       const util::NameTable &name_table,
-                      const SuffixTable &street_name_suffix_table);
+                      const NameAnnouncements &name_announcements);
 
     ~RoundaboutHandler() override final;
 
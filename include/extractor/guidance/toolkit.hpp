@@ -10,7 +10,6 @@
 
 #include "extractor/compressed_edge_container.hpp"
 #include "extractor/query_node.hpp"
-#include "extractor/suffix_table.hpp"
 
 #include "extractor/guidance/classification_data.hpp"
 #include "extractor/guidance/discrete_angle.hpp"
@@ -25,9 +24,9 @@
 #include <unordered_map>
 #include <utility>
 
-#include <boost/algorithm/string.hpp>
-#include <boost/algorithm/string/predicate.hpp>
 #include <boost/functional/hash.hpp>
+#include <boost/range/rbegin.hpp>
+#include <boost/range/rend.hpp>
 
 namespace osrm
 {
@@ -148,8 +147,11 @@ getRepresentativeCoordinate(const NodeID from_node,
         const auto final_coordinate = extractCoordinateFromNode(query_nodes[final_node]);
 
         if (traverse_in_reverse)
-            return detail::getCoordinateFromCompressedRange(
-                base_coordinate, geometry.rbegin(), geometry.rend(), final_coordinate, query_nodes);
+            return detail::getCoordinateFromCompressedRange(base_coordinate,
+                                                            boost::rbegin(geometry),
+                                                            boost::rend(geometry),
+                                                            final_coordinate,
+                                                            query_nodes);
         else
             return detail::getCoordinateFromCompressedRange(
                 base_coordinate, geometry.begin(), geometry.end(), final_coordinate, query_nodes);
@@ -313,115 +315,6 @@ inline bool isDistinct(const DirectionModifier::Enum first, const DirectionModif
     return true;
 }
 
-inline std::pair<std::string, std::string> getPrefixAndSuffix(const std::string &data)
-{
-    const auto suffix_pos = data.find_last_of(' ');
-    if (suffix_pos == std::string::npos)
-        return {};
-
-    const auto prefix_pos = data.find_first_of(' ');
-    auto result = std::make_pair(data.substr(0, prefix_pos), data.substr(suffix_pos + 1));
-    boost::to_lower(result.first);
-    boost::to_lower(result.second);
-    return result;
-}
-
-inline bool requiresNameAnnounced(const std::string &from,
-                                  const std::string &to,
-                                  const SuffixTable &suffix_table)
-{
-    // first is empty and the second is not
-    if (from.empty() && !to.empty())
-        return true;
-
-    // FIXME, handle in profile to begin with?
-    // this uses the encoding of references in the profile, which is very BAD
-    // Input for this function should be a struct separating streetname, suffix (e.g. road,
-    // boulevard, North, West ...), and a list of references
-    std::string from_name;
-    std::string from_ref;
-    std::string to_name;
-    std::string to_ref;
-
-    // Split from the format "{name} ({ref})" -> name, ref
-    auto split = [](const std::string &name, std::string &out_name, std::string &out_ref) {
-        const auto ref_begin = name.find_first_of('(');
-        if (ref_begin != std::string::npos)
-        {
-            if (ref_begin != 0)
-                out_name = name.substr(0, ref_begin - 1);
-            const auto ref_end = name.find_first_of(')');
-            out_ref = name.substr(ref_begin + 1, ref_end - ref_begin - 1);
-        }
-        else
-        {
-            out_name = name;
-        }
-    };
-
-    split(from, from_name, from_ref);
-    split(to, to_name, to_ref);
-
-    // check similarity of names
-    const auto names_are_empty = from_name.empty() && to_name.empty();
-    const auto name_is_contained =
-        boost::starts_with(from_name, to_name) || boost::starts_with(to_name, from_name);
-
-    const auto checkForPrefixOrSuffixChange =
-        [](const std::string &first, const std::string &second, const SuffixTable &suffix_table) {
-
-            const auto first_prefix_and_suffixes = getPrefixAndSuffix(first);
-            const auto second_prefix_and_suffixes = getPrefixAndSuffix(second);
-            // reverse strings, get suffices and reverse them to get prefixes
-            const auto checkTable = [&](const std::string str) {
-                return str.empty() || suffix_table.isSuffix(str);
-            };
-
-            const bool is_prefix_change = [&]() -> bool {
-                if (!checkTable(first_prefix_and_suffixes.first))
-                    return false;
-                if (!checkTable(first_prefix_and_suffixes.first))
-                    return false;
-                return !first.compare(first_prefix_and_suffixes.first.length(),
-                                      std::string::npos,
-                                      second,
-                                      second_prefix_and_suffixes.first.length(),
-                                      std::string::npos);
-            }();
-
-            const bool is_suffix_change = [&]() -> bool {
-                if (!checkTable(first_prefix_and_suffixes.second))
-                    return false;
-                if (!checkTable(first_prefix_and_suffixes.second))
-                    return false;
-                return !first.compare(0,
-                                      first.length() - first_prefix_and_suffixes.second.length(),
-                                      second,
-                                      0,
-                                      second.length() - second_prefix_and_suffixes.second.length());
-            }();
-
-            return is_prefix_change || is_suffix_change;
-        };
-
-    const auto is_suffix_change = checkForPrefixOrSuffixChange(from_name, to_name, suffix_table);
-    const auto names_are_equal = from_name == to_name || name_is_contained || is_suffix_change;
-    const auto name_is_removed = !from_name.empty() && to_name.empty();
-    // references are contained in one another
-    const auto refs_are_empty = from_ref.empty() && to_ref.empty();
-    const auto ref_is_contained =
-        from_ref.empty() || to_ref.empty() ||
-        (from_ref.find(to_ref) != std::string::npos || to_ref.find(from_ref) != std::string::npos);
-    const auto ref_is_removed = !from_ref.empty() && to_ref.empty();
-
-    const auto obvious_change =
-        (names_are_empty && refs_are_empty) || (names_are_equal && ref_is_contained) ||
-        (names_are_equal && refs_are_empty) || (ref_is_contained && name_is_removed) ||
-        (names_are_equal && ref_is_removed) || is_suffix_change;
-
-    return !obvious_change;
-}
-
 inline int getPriority(const FunctionalRoadClass road_class)
 {
     // The road priorities indicate which roads can bee seen as more or less equal.
@@ -5,6 +5,7 @@
 #include "extractor/guidance/intersection.hpp"
 #include "extractor/guidance/intersection_generator.hpp"
 #include "extractor/guidance/motorway_handler.hpp"
+#include "extractor/guidance/name_announcements.hpp"
 #include "extractor/guidance/roundabout_handler.hpp"
 #include "extractor/guidance/toolkit.hpp"
 #include "extractor/guidance/turn_classification.hpp"
@@ -20,7 +21,6 @@
 
 #include <memory>
 #include <string>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -38,7 +38,7 @@ class TurnAnalysis
     TurnAnalysis(const util::NodeBasedDynamicGraph &node_based_graph,
                  const std::vector<QueryNode> &node_info_list,
                  const RestrictionMap &restriction_map,
-                 const std::unordered_set<NodeID> &barrier_nodes,
+                 const std::vector<bool> &barrier_nodes,
                  const CompressedEdgeContainer &compressed_edge_container,
                  const util::NameTable &name_table,
                  const SuffixTable &street_name_suffix_table);
@@ -56,6 +56,7 @@ class TurnAnalysis
   private:
     const util::NodeBasedDynamicGraph &node_based_graph;
     const IntersectionGenerator intersection_generator;
+    const NameAnnouncements name_announcements;
     const RoundaboutHandler roundabout_handler;
     const MotorwayHandler motorway_handler;
     const TurnHandler turn_handler;
@@ -27,7 +27,7 @@ class TurnHandler : public IntersectionHandler
     TurnHandler(const util::NodeBasedDynamicGraph &node_based_graph,
                 const std::vector<QueryNode> &node_info_list,
                 const util::NameTable &name_table,
-                const SuffixTable &street_name_suffix_table);
+                const NameAnnouncements &name_announcements);
     ~TurnHandler() override final;
 
     // check whether the handler can actually handle the intersection
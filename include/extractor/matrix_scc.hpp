@@ -0,0 +1,133 @@
+#ifndef MATRIX_SCC_HPP
+#define MATRIX_SCC_HPP
+
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// Strongly connected components of a graph that is given as a matrix, e.g. a duration table.
+// Two nodes are connected if the entry of the table is not INVALID_EDGE_WEIGHT.
+//
+// The table is read in place and the buffers are kept between runs, so a search does not
+// allocate once an object has seen a table of the same size. The components are numbered in the
+// same order as TarjanSCC numbers them on a MatrixGraphWrapper of the same table.
+class MatrixSCC
+{
+    struct Frame
+    {
+        NodeID node;
+        NodeID parent;
+    };
+
+    // search order of a node, or SPECIAL_NODEID if it was not reached yet
+    std::vector<unsigned> index;
+    std::vector<unsigned> low_link;
+    std::vector<bool> on_stack;
+    std::vector<bool> before_recursion;
+    std::vector<Frame> recursion_stack;
+    std::vector<NodeID> tarjan_stack;
+
+    std::vector<unsigned> components_index;
+    std::vector<std::size_t> component_size_vector;
+
+  public:
+    // Table needs GetNumberOfNodes() and operator()(from, to), like util::DistTableWrapper
+    template <typename Table> void Run(const Table &table)
+    {
+        const NodeID number_of_nodes = table.GetNumberOfNodes();
+
+        index.assign(number_of_nodes, SPECIAL_NODEID);
+        low_link.assign(number_of_nodes, SPECIAL_NODEID);
+        on_stack.assign(number_of_nodes, false);
+        before_recursion.assign(number_of_nodes, true);
+        components_index.assign(number_of_nodes, SPECIAL_NODEID);
+        component_size_vector.clear();
+        recursion_stack.clear();
+        tarjan_stack.clear();
+
+        unsigned current_index = 0;
+        for (NodeID root = 0; root < number_of_nodes; ++root)
+        {
+            if (components_index[root] != SPECIAL_NODEID)
+                continue;
+            recursion_stack.push_back({root, root});
+
+            while (!recursion_stack.empty())
+            {
+                const auto frame = recursion_stack.back();
+                const auto node = frame.node;
+                recursion_stack.pop_back();
+
+                if (!before_recursion[node])
+                {
+                    before_recursion[node] = true;
+                    low_link[frame.parent] = std::min(low_link[frame.parent], low_link[node]);
+                    if (low_link[node] == index[node])
+                    {
+                        const auto component = component_size_vector.size();
+                        std::size_t size = 0;
+                        NodeID member;
+                        do
+                        {
+                            member = tarjan_stack.back();
+                            tarjan_stack.pop_back();
+                            on_stack[member] = false;
+                            components_index[member] = component;
+                            ++size;
+                        } while (member != node);
+                        component_size_vector.push_back(size);
+                    }
+                    continue;
+                }
+
+                // a node can be on the recursion stack more than once
+                if (index[node] != SPECIAL_NODEID)
+                    continue;
+
+                recursion_stack.push_back(frame);
+                before_recursion[node] = false;
+                index[node] = low_link[node] = current_index++;
+                tarjan_stack.push_back(node);
+                on_stack[node] = true;
+
+                for (NodeID target = 0; target < number_of_nodes; ++target)
+                {
+                    if (table(node, target) == INVALID_EDGE_WEIGHT)
+                        continue;
+
+                    if (index[target] == SPECIAL_NODEID)
+                    {
+                        recursion_stack.push_back({target, node});
+                    }
+                    else if (on_stack[target])
+                    {
+                        low_link[node] = std::min(low_link[node], index[target]);
+                    }
+                }
+            }
+        }
+        BOOST_ASSERT(tarjan_stack.empty());
+    }
+
+    std::size_t GetNumberOfComponents() const { return component_size_vector.size(); }
+
+    std::size_t GetComponentSize(const unsigned component_id) const
+    {
+        return component_size_vector[component_id];
+    }
+
+    unsigned GetComponentID(const NodeID node) const { return components_index[node]; }
+};
+}
+}
+
+#endif // MATRIX_SCC_HPP
@@ -1,6 +1,7 @@
 #ifndef NODE_BASED_EDGE_HPP
 #define NODE_BASED_EDGE_HPP
 
+#include "extractor/edge_classes.hpp"
 #include "extractor/travel_mode.hpp"
 #include "util/typedefs.hpp"
 
@@ -27,7 +28,8 @@ struct NodeBasedEdge
                   TravelMode travel_mode,
                   bool is_split,
                   const LaneDescriptionID lane_description_id,
-                  guidance::RoadClassificationData road_classification);
+                  guidance::RoadClassificationData road_classification,
+                  EdgeClasses classes);
 
     bool operator<(const NodeBasedEdge &other) const;
 
@@ -44,6 +46,7 @@ struct NodeBasedEdge
     TravelMode travel_mode : 4;
     LaneDescriptionID lane_description_id;
     guidance::RoadClassificationData road_classification;
+    EdgeClasses classes;
 };
 
 struct NodeBasedEdgeWithOSM : NodeBasedEdge
@@ -60,7 +63,8 @@ struct NodeBasedEdgeWithOSM : NodeBasedEdge
                          TravelMode travel_mode,
                          bool is_split,
                          const LaneDescriptionID lane_description_id,
-                         guidance::RoadClassificationData road_classification);
+                         guidance::RoadClassificationData road_classification,
+                         EdgeClasses classes);
 
     OSMNodeID osm_source_id;
     OSMNodeID osm_target_id;
@@ -71,7 +75,8 @@ struct NodeBasedEdgeWithOSM : NodeBasedEdge
 inline NodeBasedEdge::NodeBasedEdge()
     : source(SPECIAL_NODEID), target(SPECIAL_NODEID), name_id(0), weight(0), forward(false),
       backward(false), roundabout(false), access_restricted(false), startpoint(true),
-      is_split(false), travel_mode(false), lane_description_id(INVALID_LANE_DESCRIPTIONID)
+      is_split(false), travel_mode(false), lane_description_id(INVALID_LANE_DESCRIPTIONID),
+      classes(EDGE_CLASS_NONE)
 {
 }
 
@@ -87,11 +92,13 @@ inline NodeBasedEdge::NodeBasedEdge(NodeID source,
                                     TravelMode travel_mode,
                                     bool is_split,
                                     const LaneDescriptionID lane_description_id,
-                                    guidance::RoadClassificationData road_classification)
+                                    guidance::RoadClassificationData road_classification,
+                                    EdgeClasses classes)
     : source(source), target(target), name_id(name_id), weight(weight), forward(forward),
       backward(backward), roundabout(roundabout), access_restricted(access_restricted),
       startpoint(startpoint), is_split(is_split), travel_mode(travel_mode),
-      lane_description_id(lane_description_id), road_classification(std::move(road_classification))
+      lane_description_id(lane_description_id), road_classification(std::move(road_classification)),
+      classes(classes)
 {
 }
 
@@ -125,7 +132,8 @@ inline NodeBasedEdgeWithOSM::NodeBasedEdgeWithOSM(
     TravelMode travel_mode,
     bool is_split,
     const LaneDescriptionID lane_description_id,
-    guidance::RoadClassificationData road_classification)
+    guidance::RoadClassificationData road_classification,
+    EdgeClasses classes)
     : NodeBasedEdge(SPECIAL_NODEID,
                     SPECIAL_NODEID,
                     name_id,
@@ -138,7 +146,8 @@ inline NodeBasedEdgeWithOSM::NodeBasedEdgeWithOSM(
                     travel_mode,
                     is_split,
                     lane_description_id,
-                    std::move(road_classification)),
+                    std::move(road_classification),
+                    classes),
       osm_source_id(std::move(source)), osm_target_id(std::move(target))
 {
 }
@@ -1,6 +1,7 @@
 #ifndef ORIGINAL_EDGE_DATA_HPP
 #define ORIGINAL_EDGE_DATA_HPP
 
+#include "extractor/edge_classes.hpp"
 #include "extractor/guidance/turn_instruction.hpp"
 #include "extractor/travel_mode.hpp"
 #include "util/typedefs.hpp"
@@ -20,9 +21,11 @@ struct OriginalEdgeData
                               LaneDataID lane_data_id,
                               guidance::TurnInstruction turn_instruction,
                               EntryClassID entry_classid,
-                              TravelMode travel_mode)
+                              TravelMode travel_mode,
+                              EdgeClasses classes)
         : via_node(via_node), name_id(name_id), entry_classid(entry_classid),
-          lane_data_id(lane_data_id), turn_instruction(turn_instruction), travel_mode(travel_mode)
+          lane_data_id(lane_data_id), turn_instruction(turn_instruction), travel_mode(travel_mode),
+          classes(classes)
     {
     }
 
@@ -30,7 +33,7 @@ struct OriginalEdgeData
         : via_node(std::numeric_limits<unsigned>::max()),
           name_id(std::numeric_limits<unsigned>::max()), entry_classid(INVALID_ENTRY_CLASSID),
           lane_data_id(INVALID_LANE_DATAID), turn_instruction(guidance::TurnInstruction::INVALID()),
-          travel_mode(TRAVEL_MODE_INACCESSIBLE)
+          travel_mode(TRAVEL_MODE_INACCESSIBLE), classes(EDGE_CLASS_NONE)
     {
     }
 
@@ -40,6 +43,7 @@ struct OriginalEdgeData
     LaneDataID lane_data_id;
     guidance::TurnInstruction turn_instruction;
     TravelMode travel_mode;
+    EdgeClasses classes;
 };
 
 static_assert(sizeof(OriginalEdgeData) == 16,
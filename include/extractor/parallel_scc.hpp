@@ -0,0 +1,399 @@
+#ifndef PARALLEL_SCC_HPP
+#define PARALLEL_SCC_HPP
+
+#include "util/integer_range.hpp"
+#include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// Strongly connected components, with the same interface as TarjanSCC.
+//
+// Road networks consist of one giant component and many small ones. The giant component is
+// found with a forward and a backward search from a pivot, both run as parallel breadth first
+// searches. All other components do not contain a node of it, so the remaining graph is split
+// into its weakly connected parts, which are searched with Tarjan's algorithm in parallel.
+//
+// The components are numbered in order of their smallest node.
+template <typename GraphT> class ParallelSCC
+{
+    // the remaining nodes are searched as one part if there are only few of them
+    static constexpr const std::size_t MIN_PARALLEL_PART_SIZE = 1024;
+
+    std::vector<unsigned> components_index;
+    std::vector<NodeID> component_size_vector;
+    std::shared_ptr<const GraphT> m_graph;
+    std::size_t size_one_counter;
+
+  public:
+    ParallelSCC(std::shared_ptr<const GraphT> graph)
+        : components_index(graph->GetNumberOfNodes(), SPECIAL_NODEID), m_graph(graph),
+          size_one_counter(0)
+    {
+        BOOST_ASSERT(m_graph->GetNumberOfNodes() > 0);
+    }
+
+    void Run()
+    {
+        TIMER_START(SCC_RUN);
+        const NodeID number_of_nodes = m_graph->GetNumberOfNodes();
+
+        // the nodes of a component are labeled with one of them until they are numbered
+        std::vector<NodeID> &labels = components_index;
+        std::fill(labels.begin(), labels.end(), SPECIAL_NODEID);
+
+        std::vector<EdgeID> reverse_offsets;
+        std::vector<NodeID> reverse_sources;
+        BuildReverseGraph(reverse_offsets, reverse_sources);
+
+        // the giant component contains the node with the most connections most likely
+        NodeID pivot = 0;
+        std::uint64_t pivot_degree = 0;
+        for (const NodeID node : util::irange(0u, number_of_nodes))
+        {
+            const std::uint64_t degree =
+                std::uint64_t{m_graph->GetOutDegree(node) + 1} *
+                (reverse_offsets[node + 1] - reverse_offsets[node] + 1);
+            if (degree > pivot_degree)
+            {
+                pivot = node;
+                pivot_degree = degree;
+            }
+        }
+
+        std::vector<std::atomic<bool>> forward_reached(number_of_nodes);
+        Search(pivot, forward_reached, [&](const NodeID node, std::vector<NodeID> &next) {
+            for (const auto edge : m_graph->GetAdjacentEdgeRange(node))
+            {
+                Reach(m_graph->GetTarget(edge), forward_reached, next);
+            }
+        });
+        std::vector<std::atomic<bool>> backward_reached(number_of_nodes);
+        Search(pivot, backward_reached, [&](const NodeID node, std::vector<NodeID> &next) {
+            for (auto edge = reverse_offsets[node]; edge != reverse_offsets[node + 1]; ++edge)
+            {
+                const auto source = reverse_sources[edge];
+                if (forward_reached[source].load(std::memory_order_relaxed))
+                {
+                    Reach(source, backward_reached, next);
+                }
+            }
+        });
+        tbb::parallel_for(tbb::blocked_range<NodeID>(0, number_of_nodes),
+                          [&](const tbb::blocked_range<NodeID> &range) {
+                              for (auto node = range.begin(); node != range.end(); ++node)
+                              {
+                                  if (forward_reached[node] && backward_reached[node])
+                                  {
+                                      labels[node] = pivot;
+                                  }
+                              }
+                          });
+        decltype(forward_reached)().swap(forward_reached);
+        decltype(backward_reached)().swap(backward_reached);
+        decltype(reverse_offsets)().swap(reverse_offsets);
+        decltype(reverse_sources)().swap(reverse_sources);
+
+        // weakly connected parts of the remaining graph, grouped by their smallest node
+        std::vector<NodeID> parents(number_of_nodes);
+        std::iota(parents.begin(), parents.end(), 0);
+        const auto find = [&](NodeID node) {
+            while (parents[node] != node)
+            {
+                parents[node] = parents[parents[node]];
+                node = parents[node];
+            }
+            return node;
+        };
+        for (const NodeID node : util::irange(0u, number_of_nodes))
+        {
+            if (labels[node] != SPECIAL_NODEID)
+                continue;
+            for (const auto edge : m_graph->GetAdjacentEdgeRange(node))
+            {
+                const auto target = m_graph->GetTarget(edge);
+                if (labels[target] != SPECIAL_NODEID)
+                    continue;
+                const auto node_root = find(node);
+                const auto target_root = find(target);
+                parents[std::max(node_root, target_root)] = std::min(node_root, target_root);
+            }
+        }
+
+        // The nodes of every part are consecutive, small parts are joined into one task. Edges
+        // only lead to nodes of the same part or of the giant component.
+        std::vector<NodeID> part_nodes;
+        std::vector<std::size_t> part_offsets;
+        {
+            std::vector<std::size_t> part_sizes(number_of_nodes, 0);
+            for (const NodeID node : util::irange(0u, number_of_nodes))
+            {
+                if (labels[node] == SPECIAL_NODEID)
+                {
+                    parents[node] = find(node);
+                    ++part_sizes[parents[node]];
+                }
+            }
+            std::vector<std::size_t> part_begin(number_of_nodes, 0);
+            part_offsets.push_back(0);
+            std::size_t current_size = 0;
+            for (const NodeID root : util::irange(0u, number_of_nodes))
+            {
+                if (part_sizes[root] == 0)
+                    continue;
+                part_begin[root] = part_offsets.back() + current_size;
+                current_size += part_sizes[root];
+                if (current_size >= MIN_PARALLEL_PART_SIZE)
+                {
+                    part_offsets.push_back(part_offsets.back() + current_size);
+                    current_size = 0;
+                }
+            }
+            if (current_size > 0)
+            {
+                part_offsets.push_back(part_offsets.back() + current_size);
+            }
+            part_nodes.resize(part_offsets.back());
+            for (const NodeID node : util::irange(0u, number_of_nodes))
+            {
+                if (labels[node] == SPECIAL_NODEID)
+                {
+                    part_nodes[part_begin[parents[node]]++] = node;
+                }
+            }
+        }
+        decltype(parents)().swap(parents);
+
+        std::vector<unsigned> tarjan_index(number_of_nodes, SPECIAL_NODEID);
+        std::vector<unsigned> low_link(number_of_nodes, SPECIAL_NODEID);
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, part_offsets.size() - 1, 1),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto part = range.begin(); part != range.end(); ++part)
+                              {
+                                  SearchPart(part_nodes.begin() + part_offsets[part],
+                                             part_nodes.begin() + part_offsets[part + 1],
+                                             tarjan_index,
+                                             low_link,
+                                             labels);
+                              }
+                          });
+
+        // number the components in order of their smallest node
+        std::vector<unsigned> label_to_component(number_of_nodes, SPECIAL_NODEID);
+        for (const NodeID node : util::irange(0u, number_of_nodes))
+        {
+            BOOST_ASSERT(labels[node] != SPECIAL_NODEID);
+            auto &component = label_to_component[labels[node]];
+            if (component == SPECIAL_NODEID)
+            {
+                component = component_size_vector.size();
+                component_size_vector.push_back(0);
+            }
+            components_index[node] = component;
+            ++component_size_vector[component];
+        }
+
+        for (const auto component : util::irange<std::size_t>(0, component_size_vector.size()))
+        {
+            if (component_size_vector[component] > 1000)
+            {
+                util::SimpleLogger().Write() << "large component [" << component
+                                             << "]=" << component_size_vector[component];
+            }
+        }
+
+        TIMER_STOP(SCC_RUN);
+        util::SimpleLogger().Write() << "SCC run took: " << TIMER_MSEC(SCC_RUN) / 1000. << "s";
+
+        size_one_counter = std::count_if(component_size_vector.begin(),
+                                         component_size_vector.end(),
+                                         [](unsigned value) { return 1 == value; });
+    }
+
+    std::size_t GetNumberOfComponents() const { return component_size_vector.size(); }
+
+    std::size_t GetSizeOneCount() const { return size_one_counter; }
+
+    unsigned GetComponentSize(const unsigned component_id) const
+    {
+        return component_size_vector[component_id];
+    }
+
+    unsigned GetComponentID(const NodeID node) const { return components_index[node]; }
+
+  private:
+    void BuildReverseGraph(std::vector<EdgeID> &reverse_offsets,
+                           std::vector<NodeID> &reverse_sources) const
+    {
+        const NodeID number_of_nodes = m_graph->GetNumberOfNodes();
+
+        std::vector<std::atomic<EdgeID>> positions(number_of_nodes + 1);
+        tbb::parallel_for(tbb::blocked_range<NodeID>(0, number_of_nodes),
+                          [&](const tbb::blocked_range<NodeID> &range) {
+                              for (auto node = range.begin(); node != range.end(); ++node)
+                              {
+                                  for (const auto edge : m_graph->GetAdjacentEdgeRange(node))
+                                  {
+                                      positions[m_graph->GetTarget(edge) + 1].fetch_add(
+                                          1, std::memory_order_relaxed);
+                                  }
+                              }
+                          });
+
+        reverse_offsets.resize(number_of_nodes + 1);
+        EdgeID offset = 0;
+        for (const NodeID node : util::irange(0u, number_of_nodes + 1))
+        {
+            offset += positions[node].load(std::memory_order_relaxed);
+            reverse_offsets[node] = offset;
+            positions[node].store(offset, std::memory_order_relaxed);
+        }
+
+        reverse_sources.resize(offset);
+        tbb::parallel_for(tbb::blocked_range<NodeID>(0, number_of_nodes),
+                          [&](const tbb::blocked_range<NodeID> &range) {
+                              for (auto node = range.begin(); node != range.end(); ++node)
+                              {
+                                  for (const auto edge : m_graph->GetAdjacentEdgeRange(node))
+                                  {
+                                      const auto position =
+                                          positions[m_graph->GetTarget(edge)].fetch_add(
+                                              1, std::memory_order_relaxed);
+                                      reverse_sources[position] = node;
+                                  }
+                              }
+                          });
+    }
+
+    // Adds a node to the next level of a search unless it was reached before
+    static void
+    Reach(const NodeID node, std::vector<std::atomic<bool>> &reached, std::vector<NodeID> &next)
+    {
+        if (!reached[node].load(std::memory_order_relaxed) && !reached[node].exchange(true))
+        {
+            next.push_back(node);
+        }
+    }
+
+    // Marks all nodes that can be reached from the source, one level of a breadth first search
+    // after the other. Expand calls Reach for all neighbours of a node.
+    template <typename Expand>
+    void Search(const NodeID source,
+                std::vector<std::atomic<bool>> &reached,
+                const Expand &expand) const
+    {
+        std::vector<NodeID> frontier{source};
+        reached[source].store(true);
+
+        tbb::enumerable_thread_specific<std::vector<NodeID>> next_frontiers;
+        while (!frontier.empty())
+        {
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, frontier.size()),
+                              [&](const tbb::blocked_range<std::size_t> &range) {
+                                  auto &next_frontier = next_frontiers.local();
+                                  for (auto index = range.begin(); index != range.end(); ++index)
+                                  {
+                                      expand(frontier[index], next_frontier);
+                                  }
+                              });
+
+            frontier.clear();
+            for (auto &next_frontier : next_frontiers)
+            {
+                frontier.insert(frontier.end(), next_frontier.begin(), next_frontier.end());
+                next_frontier.clear();
+            }
+        }
+    }
+
+    // Tarjan's algorithm on nodes that are only connected to each other and to nodes that
+    // already have a label. Every component is labeled with its root.
+    template <typename Iterator>
+    void SearchPart(const Iterator begin,
+                    const Iterator end,
+                    std::vector<unsigned> &tarjan_index,
+                    std::vector<unsigned> &low_link,
+                    std::vector<NodeID> &labels) const
+    {
+        // nodes on the search path with their next edge
+        std::vector<std::pair<NodeID, EdgeID>> recursion_stack;
+        std::vector<NodeID> tarjan_stack;
+        unsigned index = 0;
+
+        const auto visit = [&](const NodeID node) {
+            tarjan_index[node] = low_link[node] = index++;
+            tarjan_stack.push_back(node);
+            recursion_stack.emplace_back(node, m_graph->BeginEdges(node));
+        };
+
+        for (auto root = begin; root != end; ++root)
+        {
+            if (tarjan_index[*root] != SPECIAL_NODEID)
+                continue;
+            visit(*root);
+
+            while (!recursion_stack.empty())
+            {
+                const auto node = recursion_stack.back().first;
+                const auto edge = recursion_stack.back().second;
+                if (edge != m_graph->EndEdges(node))
+                {
+                    ++recursion_stack.back().second;
+                    const auto target = m_graph->GetTarget(edge);
+                    // nodes with a label belong to a component that is already complete
+                    if (labels[target] != SPECIAL_NODEID)
+                        continue;
+                    if (tarjan_index[target] == SPECIAL_NODEID)
+                    {
+                        visit(target);
+                    }
+                    else
+                    {
+                        // still on the stack
+                        low_link[node] = std::min(low_link[node], tarjan_index[target]);
+                    }
+                    continue;
+                }
+
+                recursion_stack.pop_back();
+                if (!recursion_stack.empty())
+                {
+                    const auto parent = recursion_stack.back().first;
+                    low_link[parent] = std::min(low_link[parent], low_link[node]);
+                }
+                if (low_link[node] == tarjan_index[node])
+                {
+                    NodeID member;
+                    do
+                    {
+                        member = tarjan_stack.back();
+                        tarjan_stack.pop_back();
+                        labels[member] = node;
+                    } while (member != node);
+                }
+            }
+        }
+    }
+};
+}
+}
+
+#endif // PARALLEL_SCC_HPP
@@ -4,15 +4,15 @@
 #include "util/coordinate.hpp"
 #include "util/exception.hpp"
 
-#include <boost/algorithm/string/trim.hpp>
 #include <boost/assert.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/filesystem/fstream.hpp>
-#include <boost/spirit/include/qi.hpp>
-#include <boost/spirit/include/qi_int.hpp>
 
-#include <iterator>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace osrm
 {
@@ -37,49 +37,8 @@ struct RasterDatum
 class RasterGrid
 {
   public:
-    RasterGrid(const boost::filesystem::path &filepath, std::size_t _xdim, std::size_t _ydim)
-    {
-        xdim = _xdim;
-        ydim = _ydim;
-        _data.reserve(ydim * xdim);
-
-        boost::filesystem::ifstream stream(filepath, std::ios::binary);
-        if (!stream)
-        {
-            throw util::exception("Unable to open raster file.");
-        }
-
-        stream.seekg(0, std::ios_base::end);
-        std::string buffer;
-        buffer.resize(static_cast<std::size_t>(stream.tellg()));
-
-        stream.seekg(0, std::ios_base::beg);
-
-        BOOST_ASSERT(buffer.size() > 1);
-        stream.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
-
-        boost::algorithm::trim(buffer);
-
-        auto itr = buffer.begin();
-        auto end = buffer.end();
-
-        bool r = false;
-        try
-        {
-            r = boost::spirit::qi::parse(
-                itr, end, +boost::spirit::qi::int_ % +boost::spirit::qi::space, _data);
-        }
-        catch (std::exception const &ex)
-        {
-            throw util::exception(
-                std::string("Failed to read from raster source with exception: ") + ex.what());
-        }
-
-        if (!r || itr != end)
-        {
-            throw util::exception("Failed to parse raster source correctly.");
-        }
-    }
+    // Maps the ASCII grid into memory and parses its values in parallel
+    RasterGrid(const boost::filesystem::path &filepath, std::size_t _xdim, std::size_t _ydim);
 
     RasterGrid(const RasterGrid &) = default;
     RasterGrid &operator=(const RasterGrid &) = default;
@@ -146,9 +105,39 @@ class SourceContainer
 
     RasterDatum GetRasterInterpolateFromSource(unsigned int source_id, double lon, double lat);
 
+    // Bulk lookups for a batch of coordinates, e.g. the endpoints of all segments of an edge
+    // batch. The lookups are spread over the TBB workers, results are in input order.
+    std::vector<RasterDatum>
+    GetRasterDataFromSource(unsigned int source_id,
+                            const std::vector<util::Coordinate> &coordinates) const;
+
+    std::vector<RasterDatum>
+    GetRasterInterpolateFromSource(unsigned int source_id,
+                                   const std::vector<util::Coordinate> &coordinates) const;
+
   private:
-    std::vector<RasterSource> LoadedSources;
+    // Consecutive segments share a node, so the profile queries most coordinates twice in a row
+    struct CachedLookup
+    {
+        std::int32_t lon = 0;
+        std::int32_t lat = 0;
+        unsigned int source_id = std::numeric_limits<unsigned int>::max();
+        RasterDatum datum;
+    };
+    static constexpr std::size_t LOOKUP_CACHE_SIZE = 1024;
+    using LookupCache = std::array<CachedLookup, LOOKUP_CACHE_SIZE>;
+
+    const RasterSource &GetSource(unsigned int source_id) const;
+
+    template <typename LookupT>
+    RasterDatum CachedLookupFromSource(
+        LookupCache &cache, unsigned int source_id, double lon, double lat, LookupT lookup);
+
+    // shared with the containers of the other profile states that loaded the same source
+    std::vector<std::shared_ptr<const RasterSource>> LoadedSources;
     std::unordered_map<std::string, int> LoadedSourcePaths;
+    LookupCache data_cache;
+    LookupCache interpolate_cache;
 };
 }
 }
@@ -0,0 +1,53 @@
+#ifndef REGION_FILTER_HPP
+#define REGION_FILTER_HPP
+
+#include "util/region_polygon.hpp"
+#include "util/typedefs.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// Region of the input that is extracted
+using RegionFilter = util::RegionPolygon;
+
+// Ids of the nodes within the region. Node ids are dense in OSM data, so the set has a bit per
+// id, in blocks that are only allocated when one of their ids is added.
+class RegionNodeSet
+{
+    static constexpr const std::uint64_t BLOCK_SIZE = 1 << 16;
+
+  public:
+    void Insert(const OSMNodeID node)
+    {
+        const auto id = static_cast<std::uint64_t>(node);
+        const auto block = id / BLOCK_SIZE;
+        if (block >= blocks.size())
+        {
+            blocks.resize(block + 1);
+        }
+        if (blocks[block].empty())
+        {
+            blocks[block].resize(BLOCK_SIZE, false);
+        }
+        blocks[block][id % BLOCK_SIZE] = true;
+    }
+
+    bool Contains(const OSMNodeID node) const
+    {
+        const auto id = static_cast<std::uint64_t>(node);
+        const auto block = id / BLOCK_SIZE;
+        return block < blocks.size() && !blocks[block].empty() && blocks[block][id % BLOCK_SIZE];
+    }
+
+  private:
+    std::vector<std::vector<bool>> blocks;
+};
+}
+}
+
+#endif // REGION_FILTER_HPP
@@ -19,6 +19,8 @@ struct TurnRestriction
     WayOrNode via;
     WayOrNode from;
     WayOrNode to;
+    // Restrictions with uses_via_way lead over the via way from via.node to via_end.node
+    WayOrNode via_end;
 
     struct Bits
     { // mostly unused
@@ -43,6 +45,7 @@ struct TurnRestriction
         via.node = node;
         from.node = SPECIAL_NODEID;
         to.node = SPECIAL_NODEID;
+        via_end.node = SPECIAL_NODEID;
     }
 
     explicit TurnRestriction(const bool is_only = false)
@@ -50,6 +53,7 @@ struct TurnRestriction
         via.node = SPECIAL_NODEID;
         from.node = SPECIAL_NODEID;
         to.node = SPECIAL_NODEID;
+        via_end.node = SPECIAL_NODEID;
         flags.is_only = is_only;
     }
 };
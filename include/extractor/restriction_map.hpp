@@ -8,9 +8,11 @@
 
 #include <boost/assert.hpp>
 
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -43,6 +45,16 @@ struct RestrictionTarget
         return (lhs.target_node == rhs.target_node && lhs.is_only == rhs.is_only);
     }
 };
+
+// Turn restriction from -> via_start -> ... -> via_end -> to over a via way
+struct ViaWayRestriction
+{
+    NodeID from;
+    NodeID via_start;
+    NodeID via_end;
+    NodeID to;
+    bool is_only;
+};
 }
 }
 
@@ -89,6 +101,8 @@ class RestrictionMap
         BOOST_ASSERT(node_u != SPECIAL_NODEID);
         BOOST_ASSERT(node_v != SPECIAL_NODEID);
         BOOST_ASSERT(node_w != SPECIAL_NODEID);
+        BOOST_ASSERT_MSG(m_flat_start_offsets.empty(),
+                         "restrictions changed after BuildFlatIndex");
 
         if (!IsViaNode(node_u))
         {
@@ -130,6 +144,11 @@ class RestrictionMap
 
     bool IsViaNode(const NodeID node) const;
 
+    // Freezes the restrictions into a flat index over the start nodes once the graph is
+    // compressed. The turn checks below read only the flat index and are safe to call
+    // concurrently, the Fixup* functions must not be called afterwards.
+    void BuildFlatIndex(const std::size_t number_of_nodes);
+
     // Replaces start edge (v, w) with (u, w). Only start node changes.
     void
     FixupStartingTurnRestriction(const NodeID node_u, const NodeID node_v, const NodeID node_w);
@@ -143,6 +162,12 @@ class RestrictionMap
 
     std::size_t size() const { return m_count; }
 
+    // The edge-based graph factory models these by duplicating the via way
+    const std::vector<ViaWayRestriction> &GetViaWayRestrictions() const
+    {
+        return m_via_way_restrictions;
+    }
+
   private:
     // check of node is the start of any restriction
     bool IsSourceNode(const NodeID node) const;
@@ -156,6 +181,18 @@ class RestrictionMap
     std::unordered_map<RestrictionSource, unsigned> m_restriction_map;
     std::unordered_set<NodeID> m_restriction_start_nodes;
     std::unordered_set<NodeID> m_no_turn_via_node_set;
+    std::vector<ViaWayRestriction> m_via_way_restrictions;
+
+    // Returns the targets of the restrictions starting with (u, v) as range into m_flat_targets
+    std::pair<std::uint32_t, std::uint32_t> GetFlatTargetRange(const NodeID node_u,
+                                                              const NodeID node_v) const;
+
+    //! start node -> range of m_flat_via_nodes, sorted by via node
+    std::vector<std::uint32_t> m_flat_start_offsets;
+    std::vector<NodeID> m_flat_via_nodes;
+    //! (start, via) -> range of m_flat_targets
+    std::vector<std::uint32_t> m_flat_target_offsets;
+    std::vector<RestrictionTarget> m_flat_targets;
 };
 }
 }
@@ -53,4 +53,8 @@ const constexpr osrm::extractor::TravelMode TRAVEL_MODE_RIVER_UP = 10;
 const constexpr osrm::extractor::TravelMode TRAVEL_MODE_RIVER_DOWN = 11;
 const constexpr osrm::extractor::TravelMode TRAVEL_MODE_ROUTE = 12;
 
+// Bits per travel mode in packed arrays, see util::PackedVector
+const constexpr unsigned TRAVEL_MODE_BITS = 4;
+static_assert(TRAVEL_MODE_ROUTE < (1u << TRAVEL_MODE_BITS), "travel modes exceed TRAVEL_MODE_BITS");
+
 #endif /* TRAVEL_MODE_HPP */
@@ -0,0 +1,114 @@
+#ifndef OSRM_EXTRACTOR_TURN_COST_TABLES_HPP
+#define OSRM_EXTRACTOR_TURN_COST_TABLES_HPP
+
+#include "util/buffered_file.hpp"
+#include "util/exception.hpp"
+#include "util/io.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/numeric/conversion/cast.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+// The turn costs of every intersection of the node-based graph, a node-based alternative to the
+// edge-based edges: cost i * degree + j of an intersection is the one of turning from its i-th to
+// its j-th adjacent edge, INVALID_EDGE_WEIGHT if the turn is not allowed. Many intersections
+// share the same costs, so an intersection only refers to a table and equal tables are stored
+// once.
+class TurnCostTables
+{
+  public:
+    using TableID = std::uint32_t;
+
+    // Adds the intersection of the next node-based node, costs is a degree x degree matrix
+    void AddIntersection(const std::vector<EdgeWeight> &costs)
+    {
+        const auto degree = static_cast<std::uint32_t>(std::sqrt(costs.size()));
+        BOOST_ASSERT(degree * degree == costs.size());
+
+        const auto id = boost::numeric_cast<TableID>(table_degrees.size());
+        const auto inserted = table_ids.insert({costs, id});
+        if (inserted.second)
+        {
+            table_degrees.push_back(degree);
+            table_offsets.push_back(table_costs.size());
+            table_costs.insert(table_costs.end(), costs.begin(), costs.end());
+        }
+        intersection_tables.push_back(inserted.first->second);
+    }
+
+    std::uint32_t GetDegree(const NodeID node) const
+    {
+        return table_degrees[intersection_tables[node]];
+    }
+
+    EdgeWeight
+    GetTurnCost(const NodeID node, const std::uint32_t from, const std::uint32_t to) const
+    {
+        const auto table = intersection_tables[node];
+        BOOST_ASSERT(from < table_degrees[table] && to < table_degrees[table]);
+        return table_costs[table_offsets[table] + from * table_degrees[table] + to];
+    }
+
+    std::size_t GetNumberOfIntersections() const { return intersection_tables.size(); }
+    std::size_t GetNumberOfTables() const { return table_degrees.size(); }
+
+    // bytes of the tables and the table ids of the intersections
+    std::size_t GetSize() const
+    {
+        return intersection_tables.size() * sizeof(TableID) +
+               table_degrees.size() * (sizeof(std::uint32_t) + sizeof(std::uint64_t)) +
+               table_costs.size() * sizeof(EdgeWeight);
+    }
+
+    void Write(const std::string &path) const
+    {
+        util::BufferedOutputFile stream(path);
+        util::writeFingerprint(stream);
+        if (!util::serializeVector(stream, intersection_tables) ||
+            !util::serializeVector(stream, table_degrees) ||
+            !util::serializeVector(stream, table_offsets) ||
+            !util::serializeVector(stream, table_costs))
+        {
+            throw util::exception("Failed writing " + path);
+        }
+    }
+
+    void Read(const std::string &path)
+    {
+        util::BufferedInputFile stream(path);
+        if (!util::readAndCheckFingerprint(stream) ||
+            !util::deserializeVector(stream, intersection_tables) ||
+            !util::deserializeVector(stream, table_degrees) ||
+            !util::deserializeVector(stream, table_offsets) ||
+            !util::deserializeVector(stream, table_costs))
+        {
+            throw util::exception("Could not read " + path);
+        }
+        table_ids.clear();
+    }
+
+  private:
+    std::vector<TableID> intersection_tables;
+    std::vector<std::uint32_t> table_degrees;
+    std::vector<std::uint64_t> table_offsets;
+    std::vector<EdgeWeight> table_costs;
+    // only used while the intersections are added
+    std::unordered_map<std::vector<EdgeWeight>, TableID, boost::hash<std::vector<EdgeWeight>>>
+        table_ids;
+};
+}
+}
+
+#endif // OSRM_EXTRACTOR_TURN_COST_TABLES_HPP
@@ -0,0 +1,75 @@
+#ifndef WAY_TAG_FILTER_HPP
+#define WAY_TAG_FILTER_HPP
+
+#include <osmium/tags/taglist.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace osrm
+{
+namespace extractor
+{
+
+/**
+ * Declarative part of a profile's way_function that the extractor evaluates without calling
+ * into Lua. Profiles declare it in get_way_tag_filter, and way_function is only called for the
+ * ways the filter does not reject:
+ *  - Require(group, key, value): a way needs one of the tags of every group, an empty value
+ *    stands for any value
+ *  - Reject(key, value): ways with the tag are rejected
+ *  - AddAccessKey(key): the access value of a way is the value of the first of these keys it
+ *    has, RequireAccess(group, value) and RejectAccess(value) match it like a tag
+ * Tags with empty values count as missing, like in the profiles. The rules are compiled into
+ * one lookup table by key, so a way takes one lookup per tag.
+ *
+ * A rejected way gets the default ExtractionWay, the filter must not reject ways that
+ * way_function makes routable.
+ */
+class WayTagFilter
+{
+  public:
+    void Require(const std::string &group, const std::string &key, const std::string &value);
+    void Reject(const std::string &key, const std::string &value);
+
+    void AddAccessKey(const std::string &key);
+    void RequireAccess(const std::string &group, const std::string &value);
+    void RejectAccess(const std::string &value);
+
+    // True if the profile declared no rules
+    bool Empty() const { return key_rules.empty() && access_keys.empty(); }
+
+    bool Rejects(const osmium::TagList &tags) const;
+
+  private:
+    // what a tag or an access value decides
+    struct Rule
+    {
+        // bits of the groups it satisfies
+        std::uint32_t groups = 0;
+        bool rejects = false;
+    };
+
+    struct ValueRules
+    {
+        Rule any_value;
+        std::unordered_map<std::string, Rule> values;
+
+        void Apply(const char *value, std::uint32_t &satisfied_groups, bool &rejected) const;
+    };
+
+    std::uint32_t GetGroup(const std::string &group);
+
+    std::vector<std::string> group_names;
+    std::uint32_t required_groups = 0;
+
+    std::unordered_map<std::string, ValueRules> key_rules;
+    std::vector<std::string> access_keys;
+    ValueRules access_rules;
+};
+}
+}
+
+#endif // WAY_TAG_FILTER_HPP
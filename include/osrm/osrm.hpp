@@ -31,8 +31,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "osrm/osrm_fwd.hpp"
 #include "osrm/status.hpp"
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -43,6 +45,7 @@ using engine::api::TableParameters;
 using engine::api::NearestParameters;
 using engine::api::TripParameters;
 using engine::api::MatchParameters;
+using engine::api::IsochroneParameters;
 using engine::api::TileParameters;
 
 /**
@@ -52,12 +55,16 @@ using engine::api::TileParameters;
  *
  *  - Route: shortest path queries for coordinates
  *  - Table: distance tables for coordinates
- *  - Nearest: nearest street segment for coordinate
+ *  - Nearest: nearest street segments for coordinates
  *  - Trip: shortest round trip between coordinates
  *  - Match: snaps noisy coordinate traces to the road network
+ *  - Isochrone: area reachable from a coordinate within a duration
  *  - Tile: vector tiles with internal graph representation
  *
  *  All services take service-specific parameters, fill a JSON object, and return a status code.
+ *
+ *  Every service can also be queried asynchronously: the query is queued for worker threads and
+ *  a callback receives the status and the result. The OSRM instance must outlive its queries.
  */
 class OSRM final
 {
@@ -85,6 +92,18 @@ class OSRM final
      */
     Status Route(const RouteParameters &parameters, json::Object &result);
 
+    /**
+     * Shortest path queries for a batch of coordinate sets.
+     * The coordinates of all queries are snapped together and the queries run in parallel,
+     * ordered by location. The result holds one route response per query in the given order,
+     * each with its own code.
+     *
+     * \param parameters route query specific parameters, one per query
+     * \return Status indicating success for the query or failure
+     * \see Status, RouteParameters and json::Object
+     */
+    Status Route(const std::vector<RouteParameters> &parameters, json::Object &result);
+
     /**
      * Distance tables for coordinates.
      *
@@ -95,7 +114,40 @@ class OSRM final
     Status Table(const TableParameters &parameters, json::Object &result);
 
     /**
-     * Nearest street segment for coordinate.
+     * Distance tables for coordinates, rendered as JSON text.
+     *
+     * Streams the response into the buffer instead of building a json::Object first,
+     * which is considerably cheaper for large tables.
+     *
+     * \param parameters table query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, TableParameters
+     */
+    Status Table(const TableParameters &parameters, std::vector<char> &result);
+
+    using ChunkHandler = std::function<void(std::vector<char> &rendered)>;
+
+    /**
+     * Distance tables for coordinates, rendered in the requested output format and handed out
+     * while rendering.
+     *
+     * Large tables are computed and rendered block by block of rows. Whenever a block completes
+     * at least 64 KiB of the response, the rendered bytes are passed to handle_chunk and removed
+     * from the buffer. What is left of the response ends up in result. Errors are always
+     * detected before the first chunk.
+     *
+     * \param parameters table query specific parameters
+     * \param handle_chunk receives the rendered bytes, e.g. to send them while the rest is computed
+     * 
+eturn Status indicating success for the query or failure
+     * \see Status, TableParameters
+     */
+    Status Table(const TableParameters &parameters,
+                 std::vector<char> &result,
+                 const ChunkHandler &handle_chunk);
+
+    /**
+     * Nearest street segments for one or more coordinates.
      *
      * \param parameters nearest query specific parameters
      * \return Status indicating success for the query or failure
@@ -103,6 +155,18 @@ class OSRM final
      */
     Status Nearest(const NearestParameters &parameters, json::Object &result);
 
+    /**
+     * Nearest street segments for coordinates, rendered as JSON text.
+     *
+     * Streams the waypoints into the buffer instead of building a json::Object first,
+     * which is considerably cheaper for requests with many coordinates.
+     *
+     * \param parameters nearest query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, NearestParameters
+     */
+    Status Nearest(const NearestParameters &parameters, std::vector<char> &result);
+
     /**
      * Trip: shortest round trip between coordinates.
      *
@@ -121,6 +185,25 @@ class OSRM final
      */
     Status Match(const MatchParameters &parameters, json::Object &result);
 
+    /**
+     * Match: snaps a batch of noisy coordinate traces to the road network.
+     * The traces are matched in parallel, the result holds one match response per trace.
+     *
+     * \param parameters match query specific parameters, one per trace
+     * \return Status indicating success for the query or failure
+     * \see Status, MatchParameters and json::Object
+     */
+    Status Match(const std::vector<MatchParameters> &parameters, json::Object &result);
+
+    /**
+     * Isochrone: area reachable from a coordinate within a duration
+     *
+     * \param parameters isochrone query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, IsochroneParameters and json::Object
+     */
+    Status Isochrone(const IsochroneParameters &parameters, json::Object &result);
+
     /**
      * Tile: vector tiles with internal graph representation
      *
@@ -130,6 +213,123 @@ class OSRM final
      */
     Status Tile(const TileParameters &parameters, std::string &result);
 
+    /**
+     * Callback of an asynchronous query, runs on a worker thread of the OSRM instance.
+     * The result can be moved from.
+     */
+    using Callback = std::function<void(Status status, json::Object &result)>;
+    using TileCallback = std::function<void(Status status, std::string &result)>;
+
+    /**
+     * Asynchronous variants of the services above.
+     *
+     * The queries are answered by EngineConfig::async_workers threads on their own, queries that
+     * do not fit into the queue of EngineConfig::max_queued_async_queries are rejected.
+     *
+     * \param parameters query specific parameters
+     * \param callback called with the status and result once the query is answered
+     * \return false if the query was rejected, its callback is then never called
+     * \see Callback, EngineConfig
+     */
+    bool RouteAsync(RouteParameters parameters, Callback callback);
+    bool TableAsync(TableParameters parameters, Callback callback);
+    bool NearestAsync(NearestParameters parameters, Callback callback);
+    bool TripAsync(TripParameters parameters, Callback callback);
+    bool MatchAsync(MatchParameters parameters, Callback callback);
+    bool IsochroneAsync(IsochroneParameters parameters, Callback callback);
+    bool TileAsync(TileParameters parameters, TileCallback callback);
+
+    /**
+     * Generation of the dataset queries are answered on.
+     *
+     * Changes whenever osrm-datastore publishes a new dataset into shared memory, is always 0
+     * for datasets loaded from files. Results of the same query are equal within a generation.
+     *
+     * \return the current dataset generation
+     */
+    unsigned GetDatasetGeneration() const;
+
+    /**
+     * Timestamp of the dataset queries are currently answered on.
+     *
+     * Taken from the OSM data by osrm-extract, or "n/a" if it had none.
+     *
+     * \return the timestamp of the dataset
+     */
+    std::string GetTimestamp() const;
+
+    /**
+     * Memory of the dataset queries are currently answered on.
+     *
+     * Only known for datasets in shared memory or of a dataset file, result stays empty for
+     * datasets loaded from the files of osrm-extract. Otherwise result gets the total size and
+     * resident_size in bytes, and blocks with the name, size and resident_size of every block
+     * that holds data. Resident sizes are only known on Linux.
+     *
+     * \param result object the sizes are added to
+     */
+    void GetMemoryUsage(json::Object &result) const;
+
+    /**
+     * Allocates the search heaps of the calling thread ahead of its first query.
+     *
+     * Only does something if EngineConfig::warm_up is set. Servers call it on every thread
+     * that answers queries before it takes the first one.
+     */
+    void PrepareThread();
+
+    /**
+     * One dataset generation pinned for a batch of related queries.
+     *
+     * All queries of a snapshot are answered on the same dataset, e.g. a table and the routes
+     * between the pairs chosen from it. With shared memory a query on a snapshot neither looks
+     * for a newer generation nor registers itself with osrm-datastore, the snapshot did both
+     * once when it was taken. osrm-datastore can not free the pinned generation before the last
+     * copy of the snapshot is destroyed, so keep them for a batch of queries only.
+     *
+     * Snapshots can be used by several threads at once. The OSRM instance must outlive them.
+     *
+     * \see GetSnapshot
+     */
+    class Snapshot final
+    {
+      public:
+        Status Route(const RouteParameters &parameters, json::Object &result) const;
+        Status Table(const TableParameters &parameters, json::Object &result) const;
+        Status Table(const TableParameters &parameters, std::vector<char> &result) const;
+        Status Nearest(const NearestParameters &parameters, json::Object &result) const;
+        Status Trip(const TripParameters &parameters, json::Object &result) const;
+        Status Match(const MatchParameters &parameters, json::Object &result) const;
+        Status Isochrone(const IsochroneParameters &parameters, json::Object &result) const;
+        Status Tile(const TileParameters &parameters, std::string &result) const;
+
+        /**
+         * Generation of the pinned dataset, see OSRM::GetDatasetGeneration
+         */
+        unsigned GetDatasetGeneration() const;
+
+        /**
+         * Timestamp of the pinned dataset, see OSRM::GetTimestamp
+         */
+        std::string GetTimestamp() const;
+
+      private:
+        friend class OSRM;
+        Snapshot(const engine::Engine &engine,
+                 std::shared_ptr<const engine::EngineSnapshot> snapshot);
+
+        const engine::Engine *engine_;
+        std::shared_ptr<const engine::EngineSnapshot> snapshot_;
+    };
+
+    /**
+     * Pins the dataset generation queries are currently answered on.
+     *
+     * eturn a snapshot answering queries on that generation only
+     * \see Snapshot
+     */
+    Snapshot GetSnapshot();
+
   private:
     std::unique_ptr<engine::Engine> engine_;
 };
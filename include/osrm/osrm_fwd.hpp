@@ -51,11 +51,13 @@ struct TableParameters;
 struct NearestParameters;
 struct TripParameters;
 struct MatchParameters;
+struct IsochroneParameters;
 struct TileParameters;
 } // ns api
 
 class Engine;
 struct EngineConfig;
+struct EngineSnapshot;
 } // ns engine
 } // ns osrm
 
@@ -0,0 +1,48 @@
+#ifndef OSRM_PARTITION_CELL_CUSTOMIZER_HPP
+#define OSRM_PARTITION_CELL_CUSTOMIZER_HPP
+
+#include "contractor/query_edge.hpp"
+#include "partition/cell_storage.hpp"
+#include "partition/multi_level_partition.hpp"
+
+#include "util/binary_heap.hpp"
+#include "util/static_graph.hpp"
+#include "util/typedefs.hpp"
+
+namespace osrm
+{
+namespace partition
+{
+
+// Uncontracted edge-based graph, every arc is stored at both of its end points
+using BaseGraph = util::StaticGraph<contractor::QueryEdge::EdgeData>;
+
+// Computes the metric of all cells bottom-up: the cliques of level l are found by searches on the
+// base arcs and cliques of level l - 1 that stay inside the cell. Only the weights have to be
+// recomputed when the edge weights change, the partition stays the same.
+class CellCustomizer
+{
+  public:
+    explicit CellCustomizer(const MultiLevelPartition &partition) : partition(partition) {}
+
+    void Customize(const BaseGraph &graph, CellStorage &cells) const;
+
+  private:
+    struct HeapData
+    {
+    };
+    using Heap = util::
+        BinaryHeap<NodeID, NodeID, EdgeWeight, HeapData, util::UnorderedMapStorage<NodeID, int>>;
+
+    void CustomizeCell(const BaseGraph &graph,
+                       Heap &heap,
+                       CellStorage &cells,
+                       const LevelID level,
+                       const CellID id) const;
+
+    const MultiLevelPartition &partition;
+};
+}
+}
+
+#endif // OSRM_PARTITION_CELL_CUSTOMIZER_HPP
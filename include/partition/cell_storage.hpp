@@ -0,0 +1,284 @@
+#ifndef OSRM_PARTITION_CELL_STORAGE_HPP
+#define OSRM_PARTITION_CELL_STORAGE_HPP
+
+#include "partition/multi_level_partition.hpp"
+
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/io.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace partition
+{
+
+// Boundary nodes and customized metric of every cell on every level of a MultiLevelPartition.
+// Source nodes are entered from outside of their cell, destination nodes leave it. The metric of a
+// cell is the matrix of shortest distances from each source to each destination *inside* the cell.
+class CellStorage
+{
+  public:
+    struct CellData
+    {
+        std::uint64_t source_boundary_offset;
+        std::uint64_t destination_boundary_offset;
+        std::uint64_t weight_offset;
+        std::uint32_t number_of_sources;
+        std::uint32_t number_of_destinations;
+    };
+
+    // Read-only view of one cell; weights are stored row-major by source.
+    class ConstCell
+    {
+      public:
+        ConstCell(const CellData &data,
+                  const NodeID *source_boundary,
+                  const NodeID *destination_boundary,
+                  const EdgeWeight *weights)
+            : sources(source_boundary + data.source_boundary_offset),
+              destinations(destination_boundary + data.destination_boundary_offset),
+              weights(weights + data.weight_offset), number_of_sources(data.number_of_sources),
+              number_of_destinations(data.number_of_destinations)
+        {
+        }
+
+        std::uint32_t GetNumberOfSources() const { return number_of_sources; }
+        std::uint32_t GetNumberOfDestinations() const { return number_of_destinations; }
+
+        NodeID GetSource(const std::uint32_t index) const { return sources[index]; }
+        NodeID GetDestination(const std::uint32_t index) const { return destinations[index]; }
+
+        // returns GetNumberOfSources() if node is not a source of this cell
+        std::uint32_t GetSourceIndex(const NodeID node) const
+        {
+            return FindIndex(sources, number_of_sources, node);
+        }
+
+        // returns GetNumberOfDestinations() if node is not a destination of this cell
+        std::uint32_t GetDestinationIndex(const NodeID node) const
+        {
+            return FindIndex(destinations, number_of_destinations, node);
+        }
+
+        EdgeWeight GetWeight(const std::uint32_t source_index,
+                             const std::uint32_t destination_index) const
+        {
+            BOOST_ASSERT(source_index < number_of_sources);
+            BOOST_ASSERT(destination_index < number_of_destinations);
+            return weights[source_index * number_of_destinations + destination_index];
+        }
+
+      protected:
+        static std::uint32_t
+        FindIndex(const NodeID *nodes, const std::uint32_t size, const NodeID node)
+        {
+            const auto iter = std::lower_bound(nodes, nodes + size, node);
+            return (iter != nodes + size && *iter == node)
+                       ? static_cast<std::uint32_t>(iter - nodes)
+                       : size;
+        }
+
+        const NodeID *sources;
+        const NodeID *destinations;
+        const EdgeWeight *weights;
+        std::uint32_t number_of_sources;
+        std::uint32_t number_of_destinations;
+    };
+
+    class Cell : public ConstCell
+    {
+      public:
+        Cell(const CellData &data,
+             const NodeID *source_boundary,
+             const NodeID *destination_boundary,
+             EdgeWeight *weights)
+            : ConstCell(data, source_boundary, destination_boundary, weights),
+              mutable_weights(weights + data.weight_offset)
+        {
+        }
+
+        void SetWeight(const std::uint32_t source_index,
+                       const std::uint32_t destination_index,
+                       const EdgeWeight weight)
+        {
+            BOOST_ASSERT(source_index < number_of_sources);
+            BOOST_ASSERT(destination_index < number_of_destinations);
+            mutable_weights[source_index * number_of_destinations + destination_index] = weight;
+        }
+
+      private:
+        EdgeWeight *mutable_weights;
+    };
+
+    CellStorage() = default;
+
+    // Collects the boundary nodes of all cells. An arc u -> v makes u a destination of its cell
+    // and v a source of its cell on every level on which both lie in different cells.
+    template <typename GraphT>
+    CellStorage(const MultiLevelPartition &partition, const GraphT &base_graph)
+    {
+        const auto number_of_levels = partition.GetNumberOfLevels();
+
+        // (level, cell, node) of every boundary node
+        using BoundaryEntry = std::tuple<LevelID, CellID, NodeID>;
+        std::vector<BoundaryEntry> sources;
+        std::vector<BoundaryEntry> destinations;
+        for (const auto node : util::irange<NodeID>(0, base_graph.GetNumberOfNodes()))
+        {
+            for (const auto edge : base_graph.GetAdjacentEdgeRange(node))
+            {
+                if (!base_graph.GetEdgeData(edge).forward)
+                    continue;
+
+                const NodeID target = base_graph.GetTarget(edge);
+                for (LevelID level = 1; level < number_of_levels; ++level)
+                {
+                    const auto source_cell = partition.GetCell(level, node);
+                    const auto target_cell = partition.GetCell(level, target);
+                    if (source_cell == target_cell)
+                    {
+                        // cells are nested, the arc is inside of all higher cells as well
+                        break;
+                    }
+                    destinations.emplace_back(level, source_cell, node);
+                    sources.emplace_back(level, target_cell, target);
+                }
+            }
+        }
+        const auto sort_unique = [](std::vector<BoundaryEntry> &entries) {
+            std::sort(entries.begin(), entries.end());
+            entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+        };
+        sort_unique(sources);
+        sort_unique(destinations);
+
+        level_to_cell_offset.push_back(0);
+        for (LevelID level = 1; level < number_of_levels; ++level)
+        {
+            level_to_cell_offset.push_back(level_to_cell_offset.back() +
+                                           partition.GetNumberOfCells(level));
+        }
+        cells.resize(level_to_cell_offset.back(), CellData{0, 0, 0, 0, 0});
+
+        for (const auto &entry : sources)
+        {
+            ++cells[GetCellIndex(std::get<0>(entry), std::get<1>(entry))].number_of_sources;
+            source_boundary.push_back(std::get<2>(entry));
+        }
+        for (const auto &entry : destinations)
+        {
+            ++cells[GetCellIndex(std::get<0>(entry), std::get<1>(entry))].number_of_destinations;
+            destination_boundary.push_back(std::get<2>(entry));
+        }
+
+        // entries are sorted by level and cell, so the boundaries of a cell are consecutive
+        std::uint64_t source_offset = 0;
+        std::uint64_t destination_offset = 0;
+        std::uint64_t weight_offset = 0;
+        for (auto &cell : cells)
+        {
+            cell.source_boundary_offset = source_offset;
+            cell.destination_boundary_offset = destination_offset;
+            cell.weight_offset = weight_offset;
+            source_offset += cell.number_of_sources;
+            destination_offset += cell.number_of_destinations;
+            weight_offset += static_cast<std::uint64_t>(cell.number_of_sources) *
+                             cell.number_of_destinations;
+        }
+        weights.resize(weight_offset, INVALID_EDGE_WEIGHT);
+    }
+
+    LevelID GetNumberOfLevels() const
+    {
+        return static_cast<LevelID>(level_to_cell_offset.size());
+    }
+
+    CellID GetNumberOfCells(const LevelID level) const
+    {
+        BOOST_ASSERT(level > 0 && level < GetNumberOfLevels());
+        return static_cast<CellID>(level_to_cell_offset[level] - level_to_cell_offset[level - 1]);
+    }
+
+    ConstCell GetCell(const LevelID level, const CellID id) const
+    {
+        return ConstCell{cells[GetCellIndex(level, id)],
+                         source_boundary.data(),
+                         destination_boundary.data(),
+                         weights.data()};
+    }
+
+    Cell GetCell(const LevelID level, const CellID id)
+    {
+        return Cell{cells[GetCellIndex(level, id)],
+                    source_boundary.data(),
+                    destination_boundary.data(),
+                    weights.data()};
+    }
+
+    void Write(const std::string &path) const
+    {
+        std::ofstream stream(path, std::ios::binary);
+        util::writeFingerprint(stream);
+        util::serializeVector(stream, level_to_cell_offset);
+        util::serializeVector(stream, cells);
+        util::serializeVector(stream, source_boundary);
+        util::serializeVector(stream, destination_boundary);
+        util::serializeVector(stream, weights);
+
+        if (!stream)
+        {
+            throw util::exception("Writing the cell metrics to " + path + " failed.");
+        }
+    }
+
+    void Read(const std::string &path)
+    {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream)
+        {
+            throw util::exception("Could not open " + path + " for reading.");
+        }
+        if (!util::readAndCheckFingerprint(stream))
+        {
+            throw util::exception("Fingerprint does not match in " + path);
+        }
+
+        if (!util::deserializeVector(stream, level_to_cell_offset) ||
+            !util::deserializeVector(stream, cells) ||
+            !util::deserializeVector(stream, source_boundary) ||
+            !util::deserializeVector(stream, destination_boundary) ||
+            !util::deserializeVector(stream, weights))
+        {
+            throw util::exception("Reading the cell metrics from " + path + " failed.");
+        }
+    }
+
+  private:
+    std::size_t GetCellIndex(const LevelID level, const CellID id) const
+    {
+        BOOST_ASSERT(level > 0 && level < GetNumberOfLevels());
+        BOOST_ASSERT(level_to_cell_offset[level - 1] + id < level_to_cell_offset[level]);
+        return level_to_cell_offset[level - 1] + id;
+    }
+
+    // level_to_cell_offset[l - 1] is the index of the first cell of level l
+    std::vector<std::uint64_t> level_to_cell_offset;
+    std::vector<CellData> cells;
+    std::vector<NodeID> source_boundary;
+    std::vector<NodeID> destination_boundary;
+    std::vector<EdgeWeight> weights;
+};
+}
+}
+
+#endif // OSRM_PARTITION_CELL_STORAGE_HPP
@@ -0,0 +1,141 @@
+#ifndef OSRM_PARTITION_MULTI_LEVEL_PARTITION_HPP
+#define OSRM_PARTITION_MULTI_LEVEL_PARTITION_HPP
+
+#include "util/exception.hpp"
+#include "util/io.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace partition
+{
+
+using LevelID = std::uint8_t;
+using CellID = std::uint32_t;
+
+// Nested cells over the nodes of the edge-based graph. Level 0 is the graph itself, every cell on
+// level l is the union of cells on level l - 1.
+class MultiLevelPartition
+{
+  public:
+    MultiLevelPartition() = default;
+
+    // level_to_cell_ids[l - 1][node] is the cell of node on level l
+    explicit MultiLevelPartition(std::vector<std::vector<CellID>> level_to_cell_ids_)
+        : level_to_cell_ids(std::move(level_to_cell_ids_))
+    {
+        InitializeNumberOfCells();
+    }
+
+    // number of levels including level 0
+    LevelID GetNumberOfLevels() const { return static_cast<LevelID>(level_to_cell_ids.size() + 1); }
+
+    std::size_t GetNumberOfNodes() const
+    {
+        return level_to_cell_ids.empty() ? 0 : level_to_cell_ids.front().size();
+    }
+
+    CellID GetNumberOfCells(const LevelID level) const
+    {
+        BOOST_ASSERT(level > 0 && level < GetNumberOfLevels());
+        return number_of_cells[level - 1];
+    }
+
+    CellID GetCell(const LevelID level, const NodeID node) const
+    {
+        BOOST_ASSERT(level > 0 && level < GetNumberOfLevels());
+        BOOST_ASSERT(node < GetNumberOfNodes());
+        return level_to_cell_ids[level - 1][node];
+    }
+
+    // Highest level on which first and second lie in different cells, 0 if they share all cells
+    LevelID GetHighestDifferentLevel(const NodeID first, const NodeID second) const
+    {
+        for (auto level = GetNumberOfLevels() - 1; level > 0; --level)
+        {
+            if (GetCell(level, first) != GetCell(level, second))
+            {
+                return level;
+            }
+        }
+        return 0;
+    }
+
+    // Highest level on which node lies in neither the cell of source nor the cell of target.
+    // A search may only use the overlay of this level at node.
+    LevelID GetQueryLevel(const NodeID source, const NodeID target, const NodeID node) const
+    {
+        return std::min(GetHighestDifferentLevel(source, node),
+                        GetHighestDifferentLevel(target, node));
+    }
+
+    void Write(const std::string &path) const
+    {
+        std::ofstream stream(path, std::ios::binary);
+        util::writeFingerprint(stream);
+
+        const std::uint64_t number_of_levels = level_to_cell_ids.size();
+        stream.write(reinterpret_cast<const char *>(&number_of_levels), sizeof(number_of_levels));
+        for (const auto &cell_ids : level_to_cell_ids)
+        {
+            util::serializeVector(stream, cell_ids);
+        }
+
+        if (!stream)
+        {
+            throw util::exception("Writing the partition to " + path + " failed.");
+        }
+    }
+
+    void Read(const std::string &path)
+    {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream)
+        {
+            throw util::exception("Could not open " + path + " for reading.");
+        }
+        if (!util::readAndCheckFingerprint(stream))
+        {
+            throw util::exception("Fingerprint does not match in " + path);
+        }
+
+        std::uint64_t number_of_levels = 0;
+        stream.read(reinterpret_cast<char *>(&number_of_levels), sizeof(number_of_levels));
+        level_to_cell_ids.resize(number_of_levels);
+        for (auto &cell_ids : level_to_cell_ids)
+        {
+            if (!util::deserializeVector(stream, cell_ids))
+            {
+                throw util::exception("Reading the partition from " + path + " failed.");
+            }
+        }
+        InitializeNumberOfCells();
+    }
+
+  private:
+    void InitializeNumberOfCells()
+    {
+        number_of_cells.clear();
+        for (const auto &cell_ids : level_to_cell_ids)
+        {
+            BOOST_ASSERT(cell_ids.size() == level_to_cell_ids.front().size());
+            const auto max_cell = std::max_element(cell_ids.begin(), cell_ids.end());
+            number_of_cells.push_back(max_cell == cell_ids.end() ? 0 : *max_cell + 1);
+        }
+    }
+
+    std::vector<std::vector<CellID>> level_to_cell_ids;
+    std::vector<CellID> number_of_cells;
+};
+}
+}
+
+#endif // OSRM_PARTITION_MULTI_LEVEL_PARTITION_HPP
@@ -0,0 +1,27 @@
+#ifndef OSRM_PARTITION_RECURSIVE_BISECTION_HPP
+#define OSRM_PARTITION_RECURSIVE_BISECTION_HPP
+
+#include "partition/multi_level_partition.hpp"
+
+#include "util/typedefs.hpp"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace partition
+{
+
+// Partitions the nodes into nested cells by recursively splitting every cell in half along a
+// breadth-first order started at a pseudo-peripheral node. Cells on level l hold at most
+// max_cell_sizes[l - 1] nodes, max_cell_sizes has to be strictly increasing.
+// Edges are treated as undirected.
+MultiLevelPartition bisectGraph(const std::size_t number_of_nodes,
+                                const std::vector<std::pair<NodeID, NodeID>> &edges,
+                                const std::vector<std::size_t> &max_cell_sizes);
+}
+}
+
+#endif // OSRM_PARTITION_RECURSIVE_BISECTION_HPP
@@ -1,6 +1,7 @@
 #ifndef SERVER_API_BASE_PARAMETERS_GRAMMAR_HPP
 #define SERVER_API_BASE_PARAMETERS_GRAMMAR_HPP
 
+#include "server/api/coordinate_list_parser.hpp"
 #include "engine/api/base_parameters.hpp"
 
 #include "engine/bearing.hpp"
@@ -27,64 +28,29 @@ namespace ph = boost::phoenix;
 namespace qi = boost::spirit::qi;
 }
 
-template <typename T, char... Fmt> struct no_trailing_dot_policy : qi::real_policies<T>
-{
-    template <typename Iterator> static bool parse_dot(Iterator &first, Iterator const &last)
-    {
-        if (first == last || *first != '.')
-            return false;
-
-        static const constexpr char fmt[sizeof...(Fmt)] = {Fmt...};
-
-        if (first + sizeof(fmt) < last && std::equal(fmt, fmt + sizeof(fmt), first + 1u))
-            return false;
-
-        ++first;
-        return true;
-    }
-
-    template <typename Iterator> static bool parse_exp(Iterator &, const Iterator &)
-    {
-        return false;
-    }
-
-    template <typename Iterator, typename Attribute>
-    static bool parse_exp_n(Iterator &, const Iterator &, Attribute &)
-    {
-        return false;
-    }
-
-    template <typename Iterator, typename Attribute>
-    static bool parse_nan(Iterator &, const Iterator &, Attribute &)
-    {
-        return false;
-    }
-
-    template <typename Iterator, typename Attribute>
-    static bool parse_inf(Iterator &, const Iterator &, Attribute &)
-    {
-        return false;
-    }
-};
-
 template <typename Iterator, typename Signature>
 struct BaseParametersGrammar : boost::spirit::qi::grammar<Iterator, Signature>
 {
-    using json_policy = no_trailing_dot_policy<double, 'j', 's', 'o', 'n'>;
-
     BaseParametersGrammar(qi::rule<Iterator, Signature> &root_rule)
         : BaseParametersGrammar::base_type(root_rule)
     {
+        // Hints come in a full and in a compact encoding, anything in between is rejected
         const auto add_hint = [](engine::api::BaseParameters &base_parameters,
                                  const boost::optional<std::string> &hint_string) {
             if (hint_string)
             {
+                if (hint_string->size() != engine::ENCODED_HINT_SIZE &&
+                    hint_string->size() != engine::ENCODED_COMPACT_HINT_SIZE)
+                {
+                    return false;
+                }
                 base_parameters.hints.emplace_back(engine::Hint::FromBase64(hint_string.get()));
             }
             else
             {
                 base_parameters.hints.emplace_back(boost::none);
             }
+            return true;
         };
 
         const auto add_bearing =
@@ -99,6 +65,11 @@ struct BaseParametersGrammar : boost::spirit::qi::grammar<Iterator, Signature>
                 base_parameters.bearings.push_back(std::move(bearing));
             };
 
+        const auto set_coordinates = [](engine::api::BaseParameters &base_parameters,
+                                        std::vector<util::Coordinate> &coordinates) {
+            base_parameters.coordinates = std::move(coordinates);
+        };
+
         polyline_chars = qi::char_("a-zA-Z0-9_.--[]{}@?|\\%~`^");
         base64_char = qi::char_("a-zA-Z0-9--_=");
         unlimited_rule = qi::lit("unlimited")[qi::_val = std::numeric_limits<double>::infinity()];
@@ -111,16 +82,6 @@ struct BaseParametersGrammar : boost::spirit::qi::grammar<Iterator, Signature>
                                                 qi::_1,
                                                 qi::_2)];
 
-        location_rule =
-            (double_ > qi::lit(',') >
-             double_)[qi::_val = ph::bind(
-                          [](double lon, double lat) {
-                              return util::Coordinate(util::toFixed(util::FloatLongitude{lon}),
-                                                      util::toFixed(util::FloatLatitude{lat}));
-                          },
-                          qi::_1,
-                          qi::_2)];
-
         polyline_rule = qi::as_string[qi::lit("polyline(") > +polyline_chars > ')']
                                      [qi::_val = ph::bind(
                                           [](const std::string &polyline) {
@@ -128,43 +89,56 @@ struct BaseParametersGrammar : boost::spirit::qi::grammar<Iterator, Signature>
                                           },
                                           qi::_1)];
 
-        query_rule =
-            ((location_rule % ';') |
-             polyline_rule)[ph::bind(&engine::api::BaseParameters::coordinates, qi::_r1) = qi::_1];
+        query_rule = (coordinate_list | polyline_rule)[ph::bind(set_coordinates, qi::_r1, qi::_1)];
 
         radiuses_rule = qi::lit("radiuses=") >
                         (-(qi::double_ | unlimited_rule) %
                          ';')[ph::bind(&engine::api::BaseParameters::radiuses, qi::_r1) = qi::_1];
 
-        hints_rule = qi::lit("hints=") >
-                     (-qi::as_string[qi::repeat(engine::ENCODED_HINT_SIZE)[base64_char]])[ph::bind(
-                         add_hint, qi::_r1, qi::_1)] %
-                         ';';
+        hints_rule =
+            qi::lit("hints=") >
+            (-qi::as_string[qi::repeat(engine::ENCODED_COMPACT_HINT_SIZE,
+                                       engine::ENCODED_HINT_SIZE)[base64_char]])
+                    [qi::_pass = ph::bind(add_hint, qi::_r1, qi::_1)] %
+                ';';
 
         bearings_rule =
             qi::lit("bearings=") >
             (-(qi::short_ > ',' > qi::short_))[ph::bind(add_bearing, qi::_r1, qi::_1)] % ';';
 
-        base_rule = radiuses_rule(qi::_r1) | hints_rule(qi::_r1) | bearings_rule(qi::_r1);
+        output_format_type.add("json", engine::api::BaseParameters::OutputFormatType::JSON)(
+            "binary", engine::api::BaseParameters::OutputFormatType::Binary);
+
+        format_rule = qi::lit('.') >
+                      output_format_type[ph::bind(&engine::api::BaseParameters::format, qi::_r1) =
+                                             qi::_1];
+
+        debug_rule = qi::lit("debug=") >
+                     qi::bool_[ph::bind(&engine::api::BaseParameters::debug, qi::_r1) = qi::_1];
+
+        base_rule = radiuses_rule(qi::_r1) | hints_rule(qi::_r1) | bearings_rule(qi::_r1) |
+                    debug_rule(qi::_r1);
     }
 
   protected:
     qi::rule<Iterator, Signature> base_rule;
     qi::rule<Iterator, Signature> query_rule;
+    qi::rule<Iterator, Signature> format_rule;
 
   private:
     qi::rule<Iterator, Signature> bearings_rule;
     qi::rule<Iterator, Signature> radiuses_rule;
     qi::rule<Iterator, Signature> hints_rule;
+    qi::rule<Iterator, Signature> debug_rule;
 
     qi::rule<Iterator, osrm::engine::Bearing()> bearing_rule;
-    qi::rule<Iterator, osrm::util::Coordinate()> location_rule;
     qi::rule<Iterator, std::vector<osrm::util::Coordinate>()> polyline_rule;
 
     qi::rule<Iterator, unsigned char()> base64_char;
     qi::rule<Iterator, std::string()> polyline_chars;
     qi::rule<Iterator, double()> unlimited_rule;
-    qi::real_parser<double, json_policy> double_;
+    CoordinateListParser coordinate_list;
+    qi::symbols<char, engine::api::BaseParameters::OutputFormatType> output_format_type;
 };
 }
 }
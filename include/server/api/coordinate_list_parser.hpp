@@ -0,0 +1,197 @@
+#ifndef SERVER_API_COORDINATE_LIST_PARSER_HPP
+#define SERVER_API_COORDINATE_LIST_PARSER_HPP
+
+#include "util/coordinate.hpp"
+
+#include <boost/spirit/include/qi.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+namespace api
+{
+
+// A dot followed by a letter starts the format suffix, e.g. ".json", and is not part of the number
+template <typename T> struct no_trailing_dot_policy : boost::spirit::qi::real_policies<T>
+{
+    template <typename Iterator> static bool parse_dot(Iterator &first, Iterator const &last)
+    {
+        if (first == last || *first != '.')
+            return false;
+
+        if (first + 1 < last && std::isalpha(static_cast<unsigned char>(*(first + 1))))
+            return false;
+
+        ++first;
+        return true;
+    }
+
+    template <typename Iterator> static bool parse_exp(Iterator &, const Iterator &)
+    {
+        return false;
+    }
+
+    template <typename Iterator, typename Attribute>
+    static bool parse_exp_n(Iterator &, const Iterator &, Attribute &)
+    {
+        return false;
+    }
+
+    template <typename Iterator, typename Attribute>
+    static bool parse_nan(Iterator &, const Iterator &, Attribute &)
+    {
+        return false;
+    }
+
+    template <typename Iterator, typename Attribute>
+    static bool parse_inf(Iterator &, const Iterator &, Attribute &)
+    {
+        return false;
+    }
+};
+
+namespace detail
+{
+// Up to 15 decimal digits the mantissa and its power of ten are exact doubles and the quotient
+// is the correctly rounded value, the same the real parser computes for these numbers.
+const constexpr int MAX_EXACT_DECIMAL_DIGITS = 15;
+const constexpr double EXACT_POWERS_OF_TEN[MAX_EXACT_DECIMAL_DIGITS + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+
+inline bool isDigit(const char character) { return character >= '0' && character <= '9'; }
+
+// Parses a number the way no_trailing_dot_policy does, but only if it has at most
+// MAX_EXACT_DECIMAL_DIGITS digits. On failure first is left untouched.
+template <typename Iterator>
+bool parseShortDecimal(Iterator &first, const Iterator last, double &value)
+{
+    auto iter = first;
+
+    bool negative = false;
+    if (iter != last && (*iter == '-' || *iter == '+'))
+    {
+        negative = *iter == '-';
+        ++iter;
+    }
+
+    std::uint64_t mantissa = 0;
+    int digits = 0;
+    for (; iter != last && isDigit(*iter); ++iter, ++digits)
+        mantissa = mantissa * 10 + static_cast<std::uint64_t>(*iter - '0');
+
+    int fraction_digits = 0;
+    if (no_trailing_dot_policy<double>::parse_dot(iter, last))
+    {
+        for (; iter != last && isDigit(*iter); ++iter, ++fraction_digits)
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(*iter - '0');
+        digits += fraction_digits;
+    }
+
+    if (digits == 0 || digits > MAX_EXACT_DECIMAL_DIGITS)
+        return false;
+
+    value = static_cast<double>(mantissa) / EXACT_POWERS_OF_TEN[fraction_digits];
+    if (negative)
+        value = -value;
+
+    first = iter;
+    return true;
+}
+
+template <typename Iterator>
+bool parseDecimal(Iterator &first, const Iterator last, double &value)
+{
+    if (parseShortDecimal(first, last, value))
+        return true;
+
+    // Long numbers are rare enough to leave them to the real parser
+    static const boost::spirit::qi::any_real_parser<double, no_trailing_dot_policy<double>> real;
+    return real.parse(first, last, boost::spirit::unused, boost::spirit::unused, value);
+}
+} // ns detail
+
+// Parses "lon,lat;lon,lat;..." like the rule (double_ > ',' > double_) % ';' does,
+// including its expectation failures, without the per coordinate overhead of the rules.
+// The coordinates are read into a vector reserved for all of them up front.
+struct CoordinateListParser : boost::spirit::qi::primitive_parser<CoordinateListParser>
+{
+    template <typename Context, typename Iterator> struct attribute
+    {
+        using type = std::vector<util::Coordinate>;
+    };
+
+    template <typename Iterator, typename Context, typename Skipper, typename Attribute>
+    bool parse(Iterator &first,
+               const Iterator &last,
+               Context &,
+               const Skipper &,
+               Attribute &attribute) const
+    {
+        std::vector<util::Coordinate> coordinates;
+        coordinates.reserve(std::count(first, std::find(first, last, '?'), ';') + 1);
+
+        auto iter = first;
+        auto end_of_list = first;
+        while (true)
+        {
+            double lon;
+            if (!detail::parseDecimal(iter, last, lon))
+                break;
+
+            if (iter == last || *iter != ',')
+                throw boost::spirit::qi::expectation_failure<Iterator>(
+                    iter, last, boost::spirit::info("literal-char", ','));
+            ++iter;
+
+            double lat;
+            if (!detail::parseDecimal(iter, last, lat))
+                throw boost::spirit::qi::expectation_failure<Iterator>(
+                    iter, last, boost::spirit::info("real"));
+
+            coordinates.emplace_back(util::toFixed(util::FloatLongitude{lon}),
+                                     util::toFixed(util::FloatLatitude{lat}));
+            end_of_list = iter;
+
+            if (iter == last || *iter != ';')
+                break;
+            ++iter;
+        }
+
+        if (coordinates.empty())
+            return false;
+
+        first = end_of_list;
+        assign(coordinates, attribute);
+        return true;
+    }
+
+    template <typename Context> boost::spirit::info what(Context &) const
+    {
+        return boost::spirit::info("coordinates");
+    }
+
+  private:
+    static void assign(std::vector<util::Coordinate> &coordinates,
+                       std::vector<util::Coordinate> &attribute)
+    {
+        attribute = std::move(coordinates);
+    }
+
+    template <typename Attribute>
+    static void assign(std::vector<util::Coordinate> &coordinates, Attribute &attribute)
+    {
+        boost::spirit::traits::assign_to(coordinates, attribute);
+    }
+};
+}
+}
+}
+
+#endif
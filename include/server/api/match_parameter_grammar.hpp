@@ -18,6 +18,8 @@ namespace
 {
 namespace ph = boost::phoenix;
 namespace qi = boost::spirit::qi;
+
+const constexpr unsigned MAX_SESSION_TOKEN_LENGTH = 64;
 }
 
 template <typename Iterator = std::string::iterator,
@@ -33,13 +35,28 @@ struct MatchParametersGrammar final : public RouteParametersGrammar<Iterator, Si
             (qi::uint_ %
              ';')[ph::bind(&engine::api::MatchParameters::timestamps, qi::_r1) = qi::_1];
 
-        root_rule = BaseGrammar::query_rule(qi::_r1) > -qi::lit(".json") >
-                    -('?' > (timestamps_rule(qi::_r1) | BaseGrammar::base_rule(qi::_r1)) % '&');
+        session_rule =
+            qi::lit("session=") >
+            qi::as_string[qi::repeat(1u, MAX_SESSION_TOKEN_LENGTH)[session_char]]
+                         [ph::bind(&engine::api::MatchParameters::session, qi::_r1) = qi::_1];
+
+        session_char = qi::char_("a-zA-Z0-9--_");
+
+        tidy_rule = qi::lit("tidy=") >
+                    qi::bool_[ph::bind(&engine::api::MatchParameters::tidy, qi::_r1) = qi::_1];
+
+        root_rule = BaseGrammar::query_rule(qi::_r1) > -BaseGrammar::format_rule(qi::_r1) >
+                    -('?' > (timestamps_rule(qi::_r1) | session_rule(qi::_r1) |
+                             tidy_rule(qi::_r1) | BaseGrammar::base_rule(qi::_r1)) %
+                                '&');
     }
 
   private:
     qi::rule<Iterator, Signature> root_rule;
     qi::rule<Iterator, Signature> timestamps_rule;
+    qi::rule<Iterator, Signature> session_rule;
+    qi::rule<Iterator, Signature> tidy_rule;
+    qi::rule<Iterator, char()> session_char;
 };
 }
 }
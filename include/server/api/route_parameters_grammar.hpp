@@ -30,13 +30,35 @@ struct RouteParametersGrammar : public BaseParametersGrammar<Iterator, Signature
     {
         route_rule =
             (qi::lit("alternatives=") >
-             qi::bool_[ph::bind(&engine::api::RouteParameters::alternatives, qi::_r1) = qi::_1]) |
+             (qi::bool_[ph::bind(&engine::api::RouteParameters::alternatives, qi::_r1) = qi::_1,
+                        ph::bind(&engine::api::RouteParameters::number_of_alternatives,
+                                 qi::_r1) = 1u] |
+              qi::uint_[ph::bind(&engine::api::RouteParameters::alternatives, qi::_r1) =
+                            qi::_1 > 0u,
+                        ph::bind(&engine::api::RouteParameters::number_of_alternatives,
+                                 qi::_r1) = qi::_1])) |
             (qi::lit("continue_straight=") >
              (qi::lit("default") |
               qi::bool_[ph::bind(&engine::api::RouteParameters::continue_straight, qi::_r1) =
-                            qi::_1]));
+                            qi::_1])) |
+            (qi::lit("departure_time=") >
+             qi::uint_[ph::bind(&engine::api::RouteParameters::departure_time, qi::_r1) =
+                           qi::_1]) |
+            (qi::lit("metric=") >
+             qi::uint_[ph::bind(&engine::api::RouteParameters::metric, qi::_r1) = qi::_1]) |
+            exclude_rule(qi::_r1);
 
-        root_rule = query_rule(qi::_r1) > -qi::lit(".json") >
+        exclude_type.add("toll", EDGE_CLASS_TOLL)("motorway", EDGE_CLASS_MOTORWAY)(
+            "ferry", EDGE_CLASS_FERRY);
+
+        // exclude=toll,ferry, the last occurrence wins like for the other options
+        exclude_rule =
+            qi::lit("exclude=")[ph::bind(&engine::api::RouteParameters::exclude, qi::_r1) =
+                                    EDGE_CLASS_NONE] >
+            (exclude_type[ph::bind(&engine::api::RouteParameters::exclude, qi::_r1) |= qi::_1] %
+             ',');
+
+        root_rule = query_rule(qi::_r1) > -BaseGrammar::format_rule(qi::_r1) >
                     -('?' > (route_rule(qi::_r1) | base_rule(qi::_r1)) % '&');
     }
 
@@ -71,9 +93,11 @@ struct RouteParametersGrammar : public BaseParametersGrammar<Iterator, Signature
   private:
     qi::rule<Iterator, Signature> root_rule;
     qi::rule<Iterator, Signature> route_rule;
+    qi::rule<Iterator, Signature> exclude_rule;
 
     qi::symbols<char, engine::api::RouteParameters::GeometriesType> geometries_type;
     qi::symbols<char, engine::api::RouteParameters::OverviewType> overview_type;
+    qi::symbols<char, extractor::EdgeClasses> exclude_type;
 };
 }
 }
@@ -20,6 +20,8 @@ namespace ph = boost::phoenix;
 namespace qi = boost::spirit::qi;
 }
 
+const constexpr unsigned MAX_TARGET_SET_NAME_LENGTH = 64;
+
 template <typename Iterator = std::string::iterator,
           typename Signature = void(engine::api::TableParameters &)>
 struct TableParametersGrammar final : public BaseParametersGrammar<Iterator, Signature>
@@ -48,9 +50,42 @@ struct TableParametersGrammar final : public BaseParametersGrammar<Iterator, Sig
             (qi::lit("all") |
              (size_t_ % ';')[ph::bind(&engine::api::TableParameters::sources, qi::_r1) = qi::_1]);
 
-        table_rule = destinations_rule(qi::_r1) | sources_rule(qi::_r1);
+        annotations_type.add("duration", engine::api::TableParameters::AnnotationsType::Duration)(
+            "distance", engine::api::TableParameters::AnnotationsType::Distance);
+
+        // annotations=duration,distance, the last occurrence wins like for the other options
+        annotations_rule =
+            qi::lit("annotations=")[ph::bind(&engine::api::TableParameters::annotations, qi::_r1) =
+                                        engine::api::TableParameters::AnnotationsType::None] >
+            (annotations_type[ph::bind(&engine::api::TableParameters::annotations, qi::_r1) |=
+                              qi::_1] %
+             ',');
+
+        target_set_rule =
+            qi::lit("target_set=") >
+            qi::as_string[qi::repeat(1u, MAX_TARGET_SET_NAME_LENGTH)[target_set_char]]
+                         [ph::bind(&engine::api::TableParameters::target_set, qi::_r1) = qi::_1];
+
+        target_set_char = qi::char_("a-zA-Z0-9--_");
+
+        matrix_encoding_type.add(
+            "array", engine::api::TableParameters::MatrixEncodingType::Array)(
+            "base64", engine::api::TableParameters::MatrixEncodingType::Base64);
+
+        matrix_encoding_rule =
+            qi::lit("matrix_encoding=") >
+            matrix_encoding_type[ph::bind(&engine::api::TableParameters::matrix_encoding,
+                                          qi::_r1) = qi::_1];
+
+        distribute_rule =
+            qi::lit("distribute=") >
+            qi::bool_[ph::bind(&engine::api::TableParameters::distribute, qi::_r1) = qi::_1];
+
+        table_rule = destinations_rule(qi::_r1) | sources_rule(qi::_r1) |
+                     annotations_rule(qi::_r1) | target_set_rule(qi::_r1) |
+                     matrix_encoding_rule(qi::_r1) | distribute_rule(qi::_r1);
 
-        root_rule = BaseGrammar::query_rule(qi::_r1) > -qi::lit(".json") >
+        root_rule = BaseGrammar::query_rule(qi::_r1) > -BaseGrammar::format_rule(qi::_r1) >
                     -('?' > (table_rule(qi::_r1) | BaseGrammar::base_rule(qi::_r1)) % '&');
     }
 
@@ -59,7 +94,14 @@ struct TableParametersGrammar final : public BaseParametersGrammar<Iterator, Sig
     qi::rule<Iterator, Signature> table_rule;
     qi::rule<Iterator, Signature> sources_rule;
     qi::rule<Iterator, Signature> destinations_rule;
+    qi::rule<Iterator, Signature> annotations_rule;
+    qi::rule<Iterator, Signature> target_set_rule;
+    qi::rule<Iterator, Signature> matrix_encoding_rule;
+    qi::rule<Iterator, Signature> distribute_rule;
+    qi::rule<Iterator, char()> target_set_char;
     qi::rule<Iterator, std::size_t()> size_t_;
+    qi::symbols<char, engine::api::TableParameters::AnnotationsType> annotations_type;
+    qi::symbols<char, engine::api::TableParameters::MatrixEncodingType> matrix_encoding_type;
 };
 }
 }
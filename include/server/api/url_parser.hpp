@@ -22,6 +22,12 @@ inline boost::optional<ParsedURL> parseURL(std::string url_string)
     auto iter = url_string.begin();
     return parseURL(iter, url_string.end());
 }
+
+// Whether the query part of a parsed URL has the option name=..., in any query of a batch
+bool hasOption(const std::string &query, const std::string &name);
+
+// The value of the first option name=... in the query part of a parsed URL, empty without one
+std::string getOption(const std::string &query, const std::string &name);
 }
 }
 }
@@ -0,0 +1,82 @@
+#ifndef SERVER_COMPRESSOR_HPP
+#define SERVER_COMPRESSOR_HPP
+
+#include "server/http/compression_type.hpp"
+
+#include <zlib.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+/// Gzip / deflate compression of reply bodies with persistent zlib streams.
+///
+/// Setting up a zlib stream allocates a few hundred kilobytes of state, which dominates the cost
+/// of compressing small replies. The streams are created once and reset between replies instead.
+/// Not thread-safe, use one Compressor per thread, e.g. via ForCurrentThread.
+///
+/// Replies below a minimum size are sent uncompressed. Compressing a reply that fits into a few
+/// TCP segments anyway costs more time than sending the bytes it saves.
+class Compressor
+{
+  public:
+    struct Statistics
+    {
+        std::atomic<std::uint64_t> compressed_replies{0};
+        std::atomic<std::uint64_t> stream_initializations{0};
+        std::atomic<std::uint64_t> buffer_growths{0};
+        std::atomic<std::uint64_t> skipped_replies{0};
+    };
+
+    static const constexpr int DEFAULT_LEVEL = Z_BEST_SPEED;
+    static const constexpr std::size_t DEFAULT_MIN_SIZE = 1024;
+
+    Compressor();
+    ~Compressor();
+    Compressor(const Compressor &) = delete;
+    Compressor &operator=(const Compressor &) = delete;
+
+    /// Replaces the content of output with the compressed input, reusing output's capacity.
+    void Compress(const std::vector<char> &input,
+                  const http::compression_type compression_type,
+                  std::vector<char> &output);
+
+    /// Compresses a reply that is produced in pieces: appends the compressed bytes of input to
+    /// output. The first piece starts a new stream, the last one finishes it. Pieces in between
+    /// may produce no output at all, zlib keeps the input until it has enough of it.
+    void CompressChunk(const std::vector<char> &input,
+                       const http::compression_type compression_type,
+                       std::vector<char> &output,
+                       const bool first,
+                       const bool last);
+
+    static Compressor &ForCurrentThread();
+
+    /// Sets the zlib level (1 to 9) of the streams and the smallest reply that is compressed.
+    /// Not synchronized, call it before the server threads start.
+    static void Configure(const int level, const std::size_t min_size);
+
+    /// False if a reply of this size is better sent uncompressed even if the client accepts it.
+    static bool ShouldCompress(const std::size_t size);
+
+    /// Process wide counters, replies minus initializations is the number of reused streams.
+    static const Statistics &GetStatistics();
+
+  private:
+    z_stream &GetStream(const http::compression_type compression_type);
+
+    z_stream gzip_stream;
+    z_stream deflate_stream;
+    bool gzip_initialized;
+    bool deflate_initialized;
+};
+}
+}
+
+#endif // SERVER_COMPRESSOR_HPP
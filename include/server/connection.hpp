@@ -11,7 +11,11 @@
 #include <boost/config.hpp>
 #include <boost/version.hpp>
 
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 // workaround for incomplete std::shared_ptr compatibility in old boost versions
@@ -34,37 +38,131 @@ namespace server
 class RequestHandler;
 
 /// Represents a single connection from a client.
+///
+/// Connections are kept alive for up to keepalive_requests requests if the client asks for it.
+/// Idle connections are closed after keepalive_timeout seconds, a timeout of zero disables
+/// keep-alive. Pipelined requests are scheduled as soon as they are parsed, so with workers up to
+/// MAX_PIPELINED_REQUESTS requests of a connection are answered concurrently. Their replies are
+/// written in the order of the requests, as HTTP/1.1 requires. Reading and writing happen on the
+/// connection's strand, requests may be answered by the request handler's workers.
+///
+/// Large replies that a worker renders piece by piece, e.g. tiled tables, are sent with chunked
+/// transfer coding while they are rendered. The worker waits while more than
+/// MAX_UNWRITTEN_BYTES of its reply are not written yet, which bounds the memory of the reply.
+/// Only the oldest request in flight of an HTTP/1.1 client is streamed, the replies before it
+/// would otherwise have to wait in memory.
+///
+/// The socket is a generic stream socket, so the same connection serves clients of a TCP
+/// acceptor and of a Unix domain socket acceptor.
 class Connection : public std::enable_shared_from_this<Connection>
 {
   public:
-    explicit Connection(boost::asio::io_service &io_service, RequestHandler &handler);
+    explicit Connection(boost::asio::io_service &io_service,
+                        RequestHandler &handler,
+                        const unsigned keepalive_timeout = 5,
+                        const unsigned keepalive_requests = 512);
     Connection(const Connection &) = delete;
     Connection &operator=(const Connection &) = delete;
 
-    boost::asio::ip::tcp::socket &socket();
+    using Socket = boost::asio::generic::stream_protocol::socket;
+
+    Socket &socket();
 
     /// Start the first asynchronous operation for the connection.
     void start();
 
   private:
+    // A request with its reply, owned by the connection until the reply has been written
+    struct PipelinedRequest
+    {
+        http::request request;
+        http::reply reply;
+        http::compression_type compression_type = http::no_compression;
+        // reused when the request object is recycled, only grows
+        std::vector<char> compressed_output;
+        std::vector<boost::asio::const_buffer> output_buffer;
+        bool keep_alive = false;
+        unsigned remaining_requests = 0;
+        bool answered = false;
+
+        // set on the strand before the request is scheduled
+        bool may_stream = false;
+        // set by the worker with the first chunk of the reply
+        bool streamed = false;
+        // the end of a streamed reply, i.e. its last chunk
+        std::vector<char> stream_tail;
+        // framed chunks of a streamed reply, handed from the worker to the strand
+        std::mutex stream_mutex;
+        std::condition_variable stream_written;
+        std::deque<std::vector<char>> chunks;
+        std::size_t unwritten_bytes = 0;
+        bool stream_failed = false;
+    };
+
+    void read_more();
+
     void handle_read(const boost::system::error_code &e, std::size_t bytes_transferred);
 
+    /// Parses the requests in [begin, end) of the incoming data buffer and schedules them.
+    void handle_data(char *begin, char *end);
+
+    /// Queues a parsed request and schedules it, or answers it right away if it can't be.
+    void dispatch(std::unique_ptr<PipelinedRequest> pipelined, const bool valid);
+
+    /// Answers the request, possibly on a worker thread of the request handler.
+    void handle_request(PipelinedRequest &pipelined);
+
+    /// Queues a piece of a streamed reply, waits on the worker while too much is not written.
+    void stream_chunk(PipelinedRequest &pipelined, std::vector<char> &chunk);
+
+    /// Sets the output buffer of a streamed reply to the rest of it.
+    void finish_stream(PipelinedRequest &pipelined);
+
+    /// Marks the request as answered on the strand and writes the replies that are due.
+    void handle_answered(PipelinedRequest *pipelined);
+
+    /// Writes the chunks of the oldest request's reply that are ready, or its reply once it is
+    /// answered.
+    void write_next();
+
     /// Handle completion of a write operation.
     void handle_write(const boost::system::error_code &e);
 
-    std::vector<char> compress_buffers(const std::vector<char> &uncompressed_data,
-                                       const http::compression_type compression_type);
+    void handle_chunk_write(const boost::system::error_code &e);
+
+    /// Closes the connection if it was idle for too long.
+    void handle_timeout(const boost::system::error_code &e);
+
+    void arm_idle_timer();
+
+    std::unique_ptr<PipelinedRequest> make_request();
+
+    static constexpr std::size_t MAX_PIPELINED_REQUESTS = 16;
+    static constexpr std::size_t MAX_UNWRITTEN_BYTES = 1024 * 1024;
 
     boost::asio::io_service::strand strand;
-    boost::asio::ip::tcp::socket TCP_socket;
+    Socket stream_socket;
+    boost::asio::deadline_timer timer;
     RequestHandler &request_handler;
     RequestParser request_parser;
     boost::array<char, 8192> incoming_data_buffer;
-    http::request current_request;
-    http::reply current_reply;
-    std::vector<char> compressed_output;
-    // Header compression_header;
-    std::vector<boost::asio::const_buffer> output_buffer;
+    // received but not yet parsed because too many requests are in flight
+    char *unparsed_begin;
+    char *unparsed_end;
+    const unsigned keepalive_timeout;
+    const unsigned keepalive_requests;
+    unsigned processed_requests;
+    bool reading;
+    bool writing;
+    // no further requests are read once a request closes the connection
+    bool closing;
+    // nothing is written after a write failed
+    bool write_failed;
+    // the request the parser is currently filling
+    std::unique_ptr<PipelinedRequest> parsed_request;
+    // requests in flight, in the order their replies are written
+    std::deque<std::unique_ptr<PipelinedRequest>> pending_requests;
+    std::vector<std::unique_ptr<PipelinedRequest>> spare_requests;
 };
 }
 }
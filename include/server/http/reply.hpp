@@ -5,6 +5,7 @@
 
 #include <boost/asio.hpp>
 
+#include <string>
 #include <vector>
 
 namespace osrm
@@ -21,16 +22,25 @@ class reply
     {
         ok = 200,
         bad_request = 400,
-        internal_server_error = 500
+        too_many_requests = 429,
+        internal_server_error = 500,
+        service_unavailable = 503
     } status;
 
     std::vector<header> headers;
     std::vector<boost::asio::const_buffer> to_buffers();
     std::vector<boost::asio::const_buffer> headers_to_buffers();
+    // Appends the status line and the headers of a reply whose body follows in chunks. Chunked
+    // transfer coding needs HTTP/1.1, unlike the other replies.
+    void append_chunked_headers(std::vector<char> &output) const;
     std::vector<char> content;
     static reply stock_reply(const status_type status);
     void set_size(const std::size_t size);
     void set_uncompressed_size();
+    // Resets to a default reply but keeps the capacity of the content buffer
+    void clear();
+    // Replaces 'Connection: close' and tells the client how long the connection stays open
+    void set_keep_alive(const unsigned timeout_seconds, const unsigned remaining_requests);
 
     reply();
 
@@ -18,6 +18,10 @@ struct request
     std::string referrer;
     std::string agent;
     boost::asio::ip::address endpoint;
+    // whether the client asked to reuse the connection, either explicitly or by using HTTP/1.1
+    bool keep_alive = false;
+    // HTTP/1.1 clients understand replies with a chunked body
+    bool accepts_chunked = false;
 };
 }
 }
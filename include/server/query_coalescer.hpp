@@ -0,0 +1,84 @@
+#ifndef SERVER_QUERY_COALESCER_HPP
+#define SERVER_QUERY_COALESCER_HPP
+
+#include "server/service/base_service.hpp"
+
+#include "engine/status.hpp"
+#include "util/json_container.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace osrm
+{
+namespace server
+{
+
+/**
+ * Lets identical queries that run at the same time share one computation: the first query of a
+ * key computes the result, the ones arriving while it runs wait for it and get a copy.
+ *
+ * With a time to live the results are kept that long afterwards, so repeated queries are
+ * answered without any computation. Results are only shared within the dataset generation they
+ * were computed on. At most max_entries results are kept, queries in flight are not limited.
+ */
+class QueryCoalescer
+{
+  public:
+    using ResultT = service::BaseService::ResultT;
+    using QueryT = std::function<engine::Status(ResultT &)>;
+
+    QueryCoalescer(const std::chrono::milliseconds time_to_live, const std::size_t max_entries);
+
+    engine::Status
+    Run(const std::string &key, const unsigned generation, const QueryT &query, ResultT &result);
+
+    // Key of a service query, the options are sorted unless one of them is given twice
+    static std::string
+    MakeKey(const std::string &service, const unsigned version, const std::string &query);
+
+    // Queries that depend on or change state of the engine have to run every time on their own:
+    // match queries of a session and tables registering or using a target set
+    static bool IsShareable(const std::string &service, const std::string &query);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Outcome
+    {
+        engine::Status status;
+        ResultT result;
+    };
+
+    struct Entry
+    {
+        std::uint64_t id;
+        unsigned generation;
+        std::shared_future<std::shared_ptr<const Outcome>> outcome;
+        std::size_t waiting_queries;
+        // only done entries are cached results, the others are still being computed
+        bool done;
+        Clock::time_point expiry;
+    };
+
+    // drops the cached results that expired, the caller holds the mutex
+    void RemoveExpired(const Clock::time_point now);
+
+    const Clock::duration time_to_live;
+    const std::size_t max_entries;
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    std::uint64_t next_id = 0;
+};
+}
+}
+
+#endif // SERVER_QUERY_COALESCER_HPP
@@ -0,0 +1,62 @@
+#ifndef SERVER_RATE_LIMITER_HPP
+#define SERVER_RATE_LIMITER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace osrm
+{
+namespace server
+{
+
+/**
+ * Limits the work each client can make the server do: a client has a bucket that refills with
+ * cost_per_second up to burst_cost, and a query is admitted if the bucket holds the query's cost.
+ * The cost is estimated from the URL before the query runs, see EstimateCost.
+ *
+ * A query costing more than burst_cost is admitted once the client's bucket is full. Buckets that
+ * are full again are the same as no bucket, they are dropped when MAX_CLIENTS clients are tracked.
+ * If that does not make room, new clients are admitted without being tracked.
+ */
+class RateLimiter
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    static const constexpr std::size_t MAX_CLIENTS = 64 * 1024;
+
+    RateLimiter(const double cost_per_second, const double burst_cost);
+
+    // Takes the cost from the client's bucket if it holds enough. Zero if the query is admitted,
+    // otherwise the time until the bucket holds the cost.
+    Clock::duration
+    Acquire(const std::string &client, double cost, const Clock::time_point now = Clock::now());
+
+    // Work of a service query, as the number of coordinates of route and match, the number of
+    // table entries of table and trip, and 1 for the other services. Match batches cost the sum
+    // of their traces. Only counts separators, the query does not have to be valid.
+    static double EstimateCost(const std::string &service, const std::string &query);
+
+  private:
+    struct Bucket
+    {
+        double cost;
+        Clock::time_point updated;
+    };
+
+    // the cost the bucket holds at now, at most burst_cost
+    double Refill(const Bucket &bucket, const Clock::time_point now) const;
+
+    const double cost_per_second;
+    const double burst_cost;
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Bucket> buckets;
+};
+}
+}
+
+#endif // SERVER_RATE_LIMITER_HPP
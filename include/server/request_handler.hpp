@@ -1,9 +1,22 @@
 #ifndef REQUEST_HANDLER_HPP
 #define REQUEST_HANDLER_HPP
 
+#include "server/rate_limiter.hpp"
 #include "server/service_handler.hpp"
+#include "server/shard_router.hpp"
 
+#include "util/work_queue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace osrm
 {
@@ -20,16 +33,89 @@ class RequestHandler
 {
 
   public:
-    RequestHandler() = default;
+    RequestHandler();
     RequestHandler(const RequestHandler &) = delete;
     RequestHandler &operator=(const RequestHandler &) = delete;
 
+    // Serves all profiles that have no service handler of their own
     void RegisterServiceHandler(std::unique_ptr<ServiceHandler> service_handler);
 
-    void HandleRequest(const http::request &current_request, http::reply &current_reply);
+    // Serves requests whose URL names the given profile, e.g. /route/v1/{profile}/...
+    void RegisterServiceHandler(const std::string &profile,
+                                std::unique_ptr<ServiceHandler> service_handler);
+
+    // Answers the requests of the services on number_of_workers threads instead of the thread
+    // calling Schedule. At most max_queued_requests requests wait for a worker, and a service
+    // listed in max_pending_requests admits at most that many queued or running requests.
+    // Cheap services are answered first, see request_handler.cpp.
+    void UseWorkers(const unsigned number_of_workers,
+                    const std::size_t max_queued_requests,
+                    const std::unordered_map<std::string, std::size_t> &max_pending_requests,
+                    std::function<void(unsigned worker)> initialize_worker = {});
+
+    // Runs the task that answers the request, on a worker if there are any. Requests that are no
+    // service query, e.g. /metrics, are answered right away. False if the task was rejected
+    // because the queue or the service is at its limit.
+    bool Schedule(const http::request &current_request, util::WorkQueue::Task task);
+
+    // Answers the service queries of a client address with 429 while their estimated costs
+    // exceed cost_per_second, with bursts of up to burst_cost. See RateLimiter for the costs.
+    void UseRateLimit(const double cost_per_second, const double burst_cost);
+
+    // Forwards the service queries whose coordinates all lie in the region of one of the shards
+    // to that shard, see ShardRouter. The other queries and the ones a shard does not answer
+    // are answered by the service handlers.
+    void UseShards(std::unique_ptr<ShardRouter> shard_router);
+
+    // Prepares the engines of all service handlers for queries on the calling thread. Runs on
+    // every thread answering requests, after it was pinned to its node.
+    void PrepareThread();
+
+    // Answers the requests of the stream, one URL per line such as /route/v1/driving/..., on
+    // number_of_threads threads to warm up the services before the server takes requests. The
+    // responses are dropped. Returns the number of requests that were answered successfully.
+    std::size_t Replay(std::istream &requests, const unsigned number_of_threads);
+
+    // Receives the body of a reply in pieces while it is rendered. By the first call the status
+    // and headers of the reply are final, the rest of the body ends up in its content.
+    using ChunkHandler = std::function<void(std::vector<char> &chunk)>;
+
+    // If handle_chunk is set, services that render large responses piece by piece pass the
+    // pieces to it as they are rendered. Such replies have no Content-Length header.
+    void HandleRequest(const http::request &current_request,
+                       http::reply &current_reply,
+                       const ChunkHandler &handle_chunk = {});
 
   private:
+    ServiceHandler *GetServiceHandler(const std::string &profile) const;
+
+    // Answers /health from counters only, without running a query
+    void HandleHealthRequest(http::reply &current_reply) const;
+    // Answers /stats with the query mix and the memory of the datasets
+    void HandleStatsRequest(http::reply &current_reply) const;
+
     std::unique_ptr<ServiceHandler> service_handler;
+    std::unordered_map<std::string, std::unique_ptr<ServiceHandler>> profile_service_handlers;
+
+    std::unique_ptr<util::WorkQueue> work_queue;
+    std::unordered_map<std::string, std::size_t> service_lanes;
+
+    std::unique_ptr<RateLimiter> rate_limiter;
+    std::unique_ptr<ShardRouter> shard_router;
+
+    const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    // service queries that are being answered right now
+    std::atomic<std::size_t> running_requests{0};
+
+    // queries of a service that were admitted, and the sum of their costs, see
+    // RateLimiter::EstimateCost
+    struct ServiceStatistics
+    {
+        std::atomic<std::uint64_t> requests{0};
+        std::atomic<std::uint64_t> cost{0};
+    };
+    // an entry per service, only the counters change after construction
+    std::unordered_map<std::string, ServiceStatistics> service_statistics;
 };
 }
 }
@@ -2,8 +2,7 @@
 #define REQUEST_PARSER_HPP
 
 #include "server/http/compression_type.hpp"
-#include "server/http/header.hpp"
-
+#include <string>
 #include <tuple>
 
 namespace osrm
@@ -28,46 +27,32 @@ class RequestParser
         indeterminate
     };
 
-    std::tuple<RequestStatus, http::compression_type>
+    // Consumes input until a request is complete. Returns the position after the request
+    // so that pipelined requests following it in the same buffer can be parsed afterwards.
+    std::tuple<RequestStatus, http::compression_type, char *>
     parse(http::request &current_request, char *begin, char *end);
 
   private:
-    RequestStatus consume(http::request &current_request, const char input);
-
-    bool is_char(const int character) const;
-
-    bool is_CTL(const int character) const;
+    // Parses the line [begin, end), end points to its '\n'
+    RequestStatus consume_line(http::request &current_request, const char *begin, const char *end);
 
-    bool is_special(const int character) const;
+    RequestStatus consume_request_line(http::request &current_request,
+                                       const char *begin,
+                                       const char *end);
 
-    bool is_digit(const int character) const;
+    RequestStatus consume_header_line(http::request &current_request,
+                                      const char *begin,
+                                      const char *end);
 
     enum class internal_state : unsigned char
     {
-        method_start,
-        method,
-        uri_start,
-        uri,
-        http_version_h,
-        http_version_t_1,
-        http_version_t_2,
-        http_version_p,
-        http_version_slash,
-        http_version_major_start,
-        http_version_major,
-        http_version_minor_start,
-        http_version_minor,
-        expecting_newline_1,
-        header_line_start,
-        header_lws,
-        header_name,
-        space_before_header_value,
-        header_value,
-        expecting_newline_2,
-        expecting_newline_3
+        request_line,
+        header_line
     } state;
 
-    http::header current_header;
+    // A line the previous buffer ended in. The connection reads into the same buffer again, so
+    // only lines that are split across reads are copied, all others are parsed in place.
+    std::string partial_line;
     http::compression_type selected_compression;
 };
 }
@@ -6,6 +6,8 @@
 #include "server/service_handler.hpp"
 
 #include "util/integer_range.hpp"
+#include "util/make_unique.hpp"
+#include "util/numa.hpp"
 #include "util/simple_logger.hpp"
 
 #include <boost/asio.hpp>
@@ -16,12 +18,16 @@
 #ifndef _WIN32
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 #endif
 
+#include <cstddef>
 #include <functional>
+#include <iosfwd>
 #include <memory>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace osrm
@@ -33,49 +39,130 @@ class Server
 {
   public:
     // Note: returns a shared instead of a unique ptr as it is captured in a lambda somewhere else
-    static std::shared_ptr<Server>
-    CreateServer(std::string &ip_address, int ip_port, unsigned requested_num_threads)
+    static std::shared_ptr<Server> CreateServer(std::string &ip_address,
+                                                int ip_port,
+                                                unsigned requested_num_threads,
+                                                unsigned keepalive_timeout = 5,
+                                                unsigned keepalive_requests = 512,
+                                                unsigned numa_nodes = 1,
+                                                bool listener_per_thread = false)
     {
         util::SimpleLogger().Write() << "http 1.1 compression handled by zlib version "
                                      << zlibVersion();
         const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
         const unsigned real_num_threads = std::min(hardware_threads, requested_num_threads);
-        return std::make_shared<Server>(ip_address, ip_port, real_num_threads);
+        return std::make_shared<Server>(ip_address,
+                                        ip_port,
+                                        real_num_threads,
+                                        keepalive_timeout,
+                                        keepalive_requests,
+                                        numa_nodes,
+                                        listener_per_thread);
     }
 
-    explicit Server(const std::string &address, const int port, const unsigned thread_pool_size)
-        : thread_pool_size(thread_pool_size), acceptor(io_service),
-          new_connection(std::make_shared<Connection>(io_service, request_handler))
+    explicit Server(const std::string &address,
+                    const int port,
+                    const unsigned thread_pool_size,
+                    const unsigned keepalive_timeout = 5,
+                    const unsigned keepalive_requests = 512,
+                    const unsigned numa_nodes = 1,
+                    const bool listener_per_thread = false)
+        : thread_pool_size(thread_pool_size), keepalive_timeout(keepalive_timeout),
+          keepalive_requests(keepalive_requests), numa_nodes(std::max(1u, numa_nodes))
     {
+        unsigned number_of_listeners = 1;
+        if (listener_per_thread)
+        {
+#ifdef SO_REUSEPORT
+            number_of_listeners = std::max(1u, thread_pool_size);
+#else
+            util::SimpleLogger().Write(logWARNING)
+                << "SO_REUSEPORT is not supported, all threads share one listener";
+#endif
+        }
+        for (unsigned i = 0; i < number_of_listeners; ++i)
+        {
+            listeners.push_back(util::make_unique<Listener>());
+        }
+
         const auto port_string = std::to_string(port);
 
-        boost::asio::ip::tcp::resolver resolver(io_service);
+        boost::asio::ip::tcp::resolver resolver(listeners.front()->io_service);
         boost::asio::ip::tcp::resolver::query query(address, port_string);
         boost::asio::ip::tcp::endpoint endpoint = *resolver.resolve(query);
 
-        acceptor.open(endpoint.protocol());
-#ifdef SO_REUSEPORT
-        const int option = 1;
-        setsockopt(acceptor.native_handle(), SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option));
-#endif
-        acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
-        acceptor.bind(endpoint);
-        acceptor.listen();
+        for (auto &listener : listeners)
+        {
+            Listen(*listener, endpoint);
+        }
 
-        util::SimpleLogger().Write() << "Listening on: " << acceptor.local_endpoint();
+        util::SimpleLogger().Write() << "Listening on: "
+                                     << listeners.front()->acceptor.local_endpoint();
+        if (listeners.size() > 1)
+        {
+            util::SimpleLogger().Write() << "Listeners: " << listeners.size();
+        }
+    }
 
-        acceptor.async_accept(
-            new_connection->socket(),
-            boost::bind(&Server::HandleAccept, this, boost::asio::placeholders::error));
+    // Requests are answered by number_of_workers threads, the threads of Run only read requests
+    // and write replies then. Requests beyond the limits are answered with 503, see
+    // RequestHandler::UseWorkers. The service handlers have to be registered before.
+    void UseWorkers(const unsigned number_of_workers,
+                    const std::size_t max_queued_requests,
+                    const std::unordered_map<std::string, std::size_t> &max_pending_requests)
+    {
+        request_handler.UseWorkers(number_of_workers,
+                                   max_queued_requests,
+                                   max_pending_requests,
+                                   [this](unsigned worker) {
+                                       PinThread(worker, "worker");
+                                       request_handler.PrepareThread();
+                                   });
+        answers_requests = false;
     }
 
+    // Pins each thread that answers requests to a CPU of its NUMA node instead of the whole node.
+    // The search heaps are allocated by the pinned threads, so they are placed next to the core
+    // that uses them. Has to be called before UseWorkers and Run.
+    void PinThreadsToCPUs() { pin_to_cpus = true; }
+
+    // Rejects the queries of clients that exceed their share, see RequestHandler::UseRateLimit
+    void UseRateLimit(const double cost_per_second, const double burst_cost)
+    {
+        request_handler.UseRateLimit(cost_per_second, burst_cost);
+    }
+
+    // Forwards the queries within the region of a shard to it, see RequestHandler::UseShards
+    void UseShards(std::unique_ptr<ShardRouter> shard_router)
+    {
+        request_handler.UseShards(std::move(shard_router));
+    }
+
+    // Warms up the services with sample requests, see RequestHandler::Replay
+    std::size_t Replay(std::istream &requests, const unsigned number_of_threads)
+    {
+        return request_handler.Replay(requests, number_of_threads);
+    }
+
+    // With several NUMA nodes the threads answering requests are pinned to the nodes
+    // round-robin, so that the service handlers answer their requests from the engine of the
+    // thread's node. With a listener per thread each thread runs the io_service of its own
+    // listener and handles the connections it accepted without sharing them with other threads.
     void Run()
     {
         std::vector<std::shared_ptr<std::thread>> threads;
         for (unsigned i = 0; i < thread_pool_size; ++i)
         {
-            std::shared_ptr<std::thread> thread = std::make_shared<std::thread>(
-                boost::bind(&boost::asio::io_service::run, &io_service));
+            auto &io_service = listeners[i % listeners.size()]->io_service;
+            std::shared_ptr<std::thread> thread =
+                std::make_shared<std::thread>([this, i, &io_service] {
+                    if (answers_requests)
+                    {
+                        PinThread(i, "thread");
+                        request_handler.PrepareThread();
+                    }
+                    io_service.run();
+                });
             threads.push_back(thread);
         }
         for (auto thread : threads)
@@ -84,31 +171,144 @@ class Server
         }
     }
 
-    void Stop() { io_service.stop(); }
+    ~Server()
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        if (local_listener)
+        {
+            ::unlink(local_listener->path.c_str());
+        }
+#endif
+    }
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    // Also accepts connections on a Unix domain socket at path, which spares clients on the same
+    // host the TCP loopback. The connections run on the threads of the first listener. A stale
+    // socket file at path is replaced.
+    void ListenLocal(const std::string &path)
+    {
+        ::unlink(path.c_str());
+        local_listener = util::make_unique<LocalListener>(listeners.front()->io_service, path);
+        Accept(*local_listener);
+        util::SimpleLogger().Write() << "Listening on: " << path;
+    }
+#endif
+
+    void Stop()
+    {
+        for (auto &listener : listeners)
+        {
+            listener->io_service.stop();
+        }
+    }
 
     void RegisterServiceHandler(std::unique_ptr<ServiceHandler> service_handler_)
     {
         request_handler.RegisterServiceHandler(std::move(service_handler_));
     }
 
+    void RegisterServiceHandler(const std::string &profile,
+                                std::unique_ptr<ServiceHandler> service_handler_)
+    {
+        request_handler.RegisterServiceHandler(profile, std::move(service_handler_));
+    }
+
   private:
-    void HandleAccept(const boost::system::error_code &e)
+    // An acceptor and the io_service its connections run on. Several listeners bind the same
+    // endpoint with SO_REUSEPORT and the kernel spreads the incoming connections over them.
+    struct Listener
+    {
+        Listener() : acceptor(io_service) {}
+
+        boost::asio::io_service io_service;
+        boost::asio::ip::tcp::acceptor acceptor;
+        std::shared_ptr<Connection> new_connection;
+    };
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    struct LocalListener
+    {
+        LocalListener(boost::asio::io_service &io_service, const std::string &path)
+            : io_service(io_service), path(path),
+              acceptor(io_service, boost::asio::local::stream_protocol::endpoint(path))
+        {
+        }
+
+        boost::asio::io_service &io_service;
+        const std::string path;
+        boost::asio::local::stream_protocol::acceptor acceptor;
+        std::shared_ptr<Connection> new_connection;
+    };
+#endif
+
+    void Listen(Listener &listener, const boost::asio::ip::tcp::endpoint &endpoint)
+    {
+        listener.acceptor.open(endpoint.protocol());
+#ifdef SO_REUSEPORT
+        const int option = 1;
+        setsockopt(
+            listener.acceptor.native_handle(), SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option));
+#endif
+        listener.acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+        listener.acceptor.bind(endpoint);
+        listener.acceptor.listen();
+
+        Accept(listener);
+    }
+
+    template <typename ListenerT> void Accept(ListenerT &listener)
+    {
+        listener.new_connection = std::make_shared<Connection>(
+            listener.io_service, request_handler, keepalive_timeout, keepalive_requests);
+        listener.acceptor.async_accept(listener.new_connection->socket(),
+                                       boost::bind(&Server::HandleAccept<ListenerT>,
+                                                   this,
+                                                   &listener,
+                                                   boost::asio::placeholders::error));
+    }
+
+    // Pins the index-th thread that answers requests to a NUMA node round-robin, or to a CPU of
+    // the node with PinThreadsToCPUs
+    void PinThread(const unsigned index, const char *thread) const
+    {
+        const auto node = index % numa_nodes;
+        if (pin_to_cpus)
+        {
+            if (!util::numa::PinThreadToCPU(node, index / numa_nodes))
+            {
+                util::SimpleLogger().Write(logWARNING) << "Could not pin a " << thread
+                                                       << " to a CPU of NUMA node " << node;
+            }
+        }
+        else if (numa_nodes > 1 && !util::numa::PinThreadToNode(node))
+        {
+            util::SimpleLogger().Write(logWARNING) << "Could not pin a " << thread
+                                                   << " to NUMA node " << node;
+        }
+    }
+
+    template <typename ListenerT>
+    void HandleAccept(ListenerT *listener, const boost::system::error_code &e)
     {
         if (!e)
         {
-            new_connection->start();
-            new_connection = std::make_shared<Connection>(io_service, request_handler);
-            acceptor.async_accept(
-                new_connection->socket(),
-                boost::bind(&Server::HandleAccept, this, boost::asio::placeholders::error));
+            listener->new_connection->start();
+            Accept(*listener);
         }
     }
 
     unsigned thread_pool_size;
-    boost::asio::io_service io_service;
-    boost::asio::ip::tcp::acceptor acceptor;
-    std::shared_ptr<Connection> new_connection;
+    unsigned keepalive_timeout;
+    unsigned keepalive_requests;
+    unsigned numa_nodes;
+    // false if workers answer the requests instead of the threads of Run
+    bool answers_requests = true;
+    bool pin_to_cpus = false;
     RequestHandler request_handler;
+    std::vector<std::unique_ptr<Listener>> listeners;
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    std::unique_ptr<LocalListener> local_listener;
+#endif
 };
 }
 }
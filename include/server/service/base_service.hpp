@@ -7,6 +7,7 @@
 
 #include <variant/variant.hpp>
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -17,10 +18,18 @@ namespace server
 namespace service
 {
 
+// Response body in one of the binary output formats, e.g. see TableAPI::MakeBinaryResponse
+struct BinaryResult
+{
+    std::vector<char> content;
+};
+
 class BaseService
 {
   public:
-    using ResultT = mapbox::util::variant<util::json::Object, std::string>;
+    // json::Object, already rendered JSON text, binary output or a protobuf encoded tile
+    using ResultT =
+        mapbox::util::variant<util::json::Object, std::vector<char>, BinaryResult, std::string>;
 
     BaseService(OSRM &routing_machine) : routing_machine(routing_machine) {}
     virtual ~BaseService() = default;
@@ -28,6 +37,20 @@ class BaseService
     virtual engine::Status
     RunQuery(std::size_t prefix_length, std::string &query, ResultT &result) = 0;
 
+    // Receives the rendered bytes of a response that is still being rendered
+    using ChunkHandler = std::function<void(std::vector<char> &rendered)>;
+
+    // Like RunQuery, but services that render large responses piece by piece pass the pieces
+    // to handle_chunk as they are done. By the first chunk result has the type of the response,
+    // what is left of the response ends up in it. Other services ignore handle_chunk.
+    virtual engine::Status RunStreamedQuery(std::size_t prefix_length,
+                                            std::string &query,
+                                            ResultT &result,
+                                            const ChunkHandler & /*handle_chunk*/)
+    {
+        return RunQuery(prefix_length, query, result);
+    }
+
     virtual unsigned GetVersion() = 0;
 
   protected:
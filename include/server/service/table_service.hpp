@@ -25,6 +25,12 @@ class TableService final : public BaseService
     engine::Status
     RunQuery(std::size_t prefix_length, std::string &query, ResultT &result) final override;
 
+    // Large tables are computed in tiles, their rows are handed to handle_chunk as they finish
+    engine::Status RunStreamedQuery(std::size_t prefix_length,
+                                    std::string &query,
+                                    ResultT &result,
+                                    const ChunkHandler &handle_chunk) final override;
+
     unsigned GetVersion() final override { return 1; }
 };
 }
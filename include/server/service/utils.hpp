@@ -10,6 +10,8 @@ namespace service
 const constexpr char PARAMETER_SIZE_MISMATCH_MSG[] =
     "Number of elements in %1% size %2% does not match coordinate size %3%";
 
+const constexpr char UNSUPPORTED_FORMAT_MSG[] = "Only the table service supports binary output.";
+
 template <typename ParamT>
 bool constrainParamSize(const char *msg_template,
                         const char *name,
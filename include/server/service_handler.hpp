@@ -1,11 +1,17 @@
 #ifndef SERVER_SERVICE_HANLDER_HPP
 #define SERVER_SERVICE_HANLDER_HPP
 
+#include "server/query_coalescer.hpp"
 #include "server/service/base_service.hpp"
 
 #include "osrm/osrm.hpp"
 
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace osrm
 {
@@ -26,14 +32,50 @@ struct ParsedURL;
 class ServiceHandler
 {
   public:
-    ServiceHandler(osrm::EngineConfig &config);
+    // Runs one engine per NUMA node, loaded by a thread on that node. A query is answered by
+    // the engine of the node the calling thread was pinned to, see Server. The requests of a
+    // matching session or using a target set all go to the engine of the node the token or
+    // the name of the set hashes to, which holds the session or the set.
+    ServiceHandler(osrm::EngineConfig &config, const unsigned numa_nodes = 1);
     using ResultT = service::BaseService::ResultT;
 
     engine::Status RunQuery(api::ParsedURL parsed_url, ResultT &result);
 
+    // Lets the service hand out large responses in pieces, see BaseService::RunStreamedQuery.
+    // Coalesced queries share their result and are never streamed.
+    engine::Status RunQuery(api::ParsedURL parsed_url,
+                            ResultT &result,
+                            const service::BaseService::ChunkHandler &handle_chunk);
+
+    // Identical queries running at the same time are computed once, their results are kept for
+    // time_to_live afterwards, at most max_entries of them. Match sessions and target sets are
+    // never shared, see QueryCoalescer.
+    void CoalesceQueries(const std::chrono::milliseconds time_to_live,
+                         const std::size_t max_entries);
+
+    // Prepares the engine of the calling thread's node for its queries, see OSRM::PrepareThread
+    void PrepareThread();
+
+    // The dataset the engine of the calling thread's node answers queries on
+    unsigned GetDatasetGeneration() const;
+    std::string GetTimestamp() const;
+    void GetMemoryUsage(util::json::Object &result) const;
+
   private:
-    std::unordered_map<std::string, std::unique_ptr<service::BaseService>> service_map;
-    OSRM routing_machine;
+    struct NodeServices
+    {
+        explicit NodeServices(osrm::EngineConfig &config);
+
+        OSRM routing_machine;
+        std::unordered_map<std::string, std::unique_ptr<service::BaseService>> service_map;
+    };
+
+    // The services of the engine that answers the query
+    NodeServices &SelectNode(const api::ParsedURL &parsed_url) const;
+
+    std::vector<std::unique_ptr<NodeServices>> node_services;
+    // shared by all nodes, their engines answer queries on the same dataset
+    std::unique_ptr<QueryCoalescer> coalescer;
 };
 }
 }
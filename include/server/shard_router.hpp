@@ -0,0 +1,73 @@
+#ifndef SERVER_SHARD_ROUTER_HPP
+#define SERVER_SHARD_ROUTER_HPP
+
+#include "util/coordinate.hpp"
+#include "util/http_client.hpp"
+#include "util/region_polygon.hpp"
+
+#include <boost/optional.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+/**
+ * Other osrm-routed instances that each serve the dataset of one region, as extracted with
+ * osrm-extract --region. Queries whose coordinates all lie within the region of a shard are
+ * forwarded to it and answered from its smaller dataset. All other queries, e.g. the ones that
+ * cross the border of two regions, are answered by the dataset of this server, which has to
+ * cover all regions. So are match batches, match sessions and target sets, whose traces or state
+ * a shard does not know.
+ *
+ * Shards are asked with plain HTTP/1.0 requests and must not have shards of their own. Queries a
+ * shard does not answer in time are answered here.
+ */
+class ShardRouter
+{
+  public:
+    // Shards that do not answer within this are given up without a max. query time
+    static const constexpr int DEFAULT_TIMEOUT = 60 * 1000;
+
+    // Shards are given as <polygon file>=host:port, with the region of the shard in the osmosis
+    // format, and have to answer within timeout. Throws util::exception for shards not of that
+    // form and unreadable polygons.
+    ShardRouter(const std::vector<std::string> &shards, const std::chrono::milliseconds timeout);
+
+    std::size_t Size() const { return shards.size(); }
+
+    // The first shard whose region contains all coordinates of the query part of a parsed URL.
+    // None if there is no such shard, the query has no coordinates, like tile requests, or it
+    // is a batch or uses a session or target set.
+    boost::optional<std::size_t> SelectShard(const std::string &query) const;
+
+    // Sends the request URI unchanged to a shard. None if the shard cannot be reached or does
+    // not answer in time.
+    boost::optional<util::HttpResponse> Forward(const std::size_t shard,
+                                                const std::string &uri) const;
+
+    // The coordinates at the start of the query part of a parsed URL, given as a list or as a
+    // polyline, followed by nothing but the format and the options. Empty if they are malformed,
+    // the service reports that when it parses the query.
+    static std::vector<util::Coordinate> ParseCoordinates(const std::string &query);
+
+  private:
+    struct Shard
+    {
+        util::RegionPolygon region;
+        std::string host;
+        std::string port;
+    };
+
+    std::vector<Shard> shards;
+    std::chrono::milliseconds timeout;
+};
+}
+}
+
+#endif // SERVER_SHARD_ROUTER_HPP
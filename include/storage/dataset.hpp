@@ -0,0 +1,82 @@
+#ifndef OSRM_STORAGE_DATASET_HPP
+#define OSRM_STORAGE_DATASET_HPP
+
+#include "storage/shared_datatype.hpp"
+#include "util/fingerprint.hpp"
+
+#include <boost/filesystem/path.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace storage
+{
+
+// The data region starts at a multiple of this in the file, which keeps every block of a mapped
+// dataset at the alignment it has in shared memory (the r-tree leaves need page alignment).
+static const constexpr std::uint64_t DATASET_DATA_ALIGNMENT = 64 * 1024;
+
+// Start of a .dataset file, the table of contents of the data region that follows it. The data
+// region is the one osrm-datastore places in shared memory, canaries included.
+struct DatasetHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    util::FingerPrint fingerprint;
+    std::uint64_t data_offset;
+    std::uint64_t data_size;
+    SharedDataLayout layout;
+    // CRC-32 of every block without its canaries
+    std::array<std::uint32_t, SharedDataLayout::NUM_BLOCKS> block_checksums;
+};
+
+// Writes a .dataset file. The data region is filled in place through a mapping of the file, the
+// file only replaces an existing dataset once Finish succeeded.
+class DatasetWriter
+{
+  public:
+    DatasetWriter(const boost::filesystem::path &path, const SharedDataLayout &layout);
+    ~DatasetWriter();
+
+    char *GetData();
+
+    // computes the block checksums, writes the header and moves the file into place
+    void Finish();
+
+  private:
+    boost::filesystem::path path;
+    boost::filesystem::path temporary_path;
+    DatasetHeader header;
+    boost::interprocess::file_mapping mapping;
+    boost::interprocess::mapped_region region;
+};
+
+// Maps a .dataset file without copying any of it. The mapping is private, so the data region can
+// be handed to code expecting writable shared memory without ever changing the file.
+class DatasetFile
+{
+  public:
+    explicit DatasetFile(const boost::filesystem::path &path);
+
+    SharedDataLayout &GetLayout();
+    char *GetData();
+
+    // Recomputes the checksums of all blocks and returns the names of the blocks that do not
+    // match. This reads the whole file, opening a dataset only checks its header.
+    std::vector<std::string> FindCorruptBlocks() const;
+
+  private:
+    boost::interprocess::file_mapping mapping;
+    boost::interprocess::mapped_region region;
+    DatasetHeader *header;
+};
+}
+}
+
+#endif // OSRM_STORAGE_DATASET_HPP
@@ -1,23 +1,221 @@
 #ifndef SHARED_BARRIERS_HPP
 #define SHARED_BARRIERS_HPP
 
+#include "storage/shared_datatype.hpp"
+
+#include "util/exception.hpp"
+#include "util/simple_logger.hpp"
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
 #include <boost/interprocess/sync/named_condition.hpp>
 #include <boost/interprocess/sync/named_mutex.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+
+#include <boost/assert.hpp>
+
+#ifdef OSRM_POSIX_SHARED_MEMORY
+#include <pthread.h>
+
+#include <cerrno>
+#include <thread>
+#endif
+
+#include <atomic>
 
 namespace osrm
 {
 namespace storage
 {
+
+// Lives in a small shared memory segment so that all osrm-routed processes and osrm-datastore
+// see the same values. Only lock-free atomics are valid across process boundaries.
+struct SharedQueryCounters
+{
+    // Number of queries currently running in any process, per data region they run on
+    std::atomic<int> number_of_queries[2];
+    // Set by osrm-datastore while it waits for the queries on the previous data region to drain
+    std::atomic<bool> update_pending;
+
+    std::atomic<int> &QueriesOn(const SharedDataType data_region)
+    {
+        BOOST_ASSERT(data_region == DATA_1 || data_region == DATA_2);
+        return number_of_queries[data_region == DATA_1 ? 0 : 1];
+    }
+};
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_BOOL_LOCK_FREE == 2,
+              "Shared query counters need lock-free atomics");
+
+#ifdef OSRM_POSIX_SHARED_MEMORY
+// Process-shared mutex that stays usable if its owner dies while holding it: the next lock()
+// takes over and releases it again later, no osrm-unlock-all needed.
+class RobustMutex
+{
+  public:
+    explicit RobustMutex(pthread_mutex_t *mutex) : mutex(mutex) {}
+
+    void lock() { Acquired(pthread_mutex_lock(mutex)); }
+
+    bool try_lock()
+    {
+        const auto result = pthread_mutex_trylock(mutex);
+        if (result == EBUSY)
+        {
+            return false;
+        }
+        Acquired(result);
+        return true;
+    }
+
+    void unlock() { pthread_mutex_unlock(mutex); }
+
+    pthread_mutex_t *native_handle() const { return mutex; }
+
+    // result of a call that acquires the mutex, recovers it from a dead owner
+    void Acquired(const int result)
+    {
+        if (result == EOWNERDEAD)
+        {
+            util::SimpleLogger().Write(logWARNING) << "recovered a lock of a crashed process";
+            pthread_mutex_consistent(mutex);
+        }
+        else if (result != 0)
+        {
+            throw util::exception("Could not acquire a shared lock");
+        }
+    }
+
+  private:
+    pthread_mutex_t *mutex;
+};
+
+class RobustCondition
+{
+  public:
+    explicit RobustCondition(pthread_cond_t *condition) : condition(condition) {}
+
+    void wait(boost::interprocess::scoped_lock<RobustMutex> &lock)
+    {
+        BOOST_ASSERT(lock.owns());
+        lock.mutex()->Acquired(pthread_cond_wait(condition, lock.mutex()->native_handle()));
+    }
+
+    void notify_all() { pthread_cond_broadcast(condition); }
+
+  private:
+    pthread_cond_t *condition;
+};
+
+// The locks of SharedBarriers, in the small shared memory segment osrm-robust-locks
+struct SharedLocks
+{
+    // zero in a freshly created segment, the first process to map it initializes the locks
+    enum State
+    {
+        UNINITIALIZED = 0,
+        INITIALIZING,
+        READY
+    };
+    std::atomic<int> state;
+    pthread_mutex_t pending_update_mutex;
+    pthread_mutex_t update_mutex;
+    pthread_mutex_t query_mutex;
+    pthread_cond_t no_running_queries_condition;
+
+    static SharedLocks *Map(boost::interprocess::shared_memory_object &memory,
+                            boost::interprocess::mapped_region &region)
+    {
+        memory.truncate(sizeof(SharedLocks));
+        region = boost::interprocess::mapped_region(memory, boost::interprocess::read_write);
+        auto *locks = static_cast<SharedLocks *>(region.get_address());
+
+        int expected = UNINITIALIZED;
+        if (locks->state.compare_exchange_strong(expected, INITIALIZING))
+        {
+            pthread_mutexattr_t mutex_attributes;
+            pthread_mutexattr_init(&mutex_attributes);
+            pthread_mutexattr_setpshared(&mutex_attributes, PTHREAD_PROCESS_SHARED);
+            pthread_mutexattr_setrobust(&mutex_attributes, PTHREAD_MUTEX_ROBUST);
+            pthread_mutex_init(&locks->pending_update_mutex, &mutex_attributes);
+            pthread_mutex_init(&locks->update_mutex, &mutex_attributes);
+            pthread_mutex_init(&locks->query_mutex, &mutex_attributes);
+            pthread_mutexattr_destroy(&mutex_attributes);
+
+            pthread_condattr_t condition_attributes;
+            pthread_condattr_init(&condition_attributes);
+            pthread_condattr_setpshared(&condition_attributes, PTHREAD_PROCESS_SHARED);
+            pthread_cond_init(&locks->no_running_queries_condition, &condition_attributes);
+            pthread_condattr_destroy(&condition_attributes);
+
+            locks->state = READY;
+        }
+        while (locks->state != READY)
+        {
+            std::this_thread::yield();
+        }
+        return locks;
+    }
+};
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "Shared locks need lock-free atomics");
+
+// Same interface as below, with POSIX shared memory and robust locks instead of the named
+// mutexes of boost that stay locked if a process dies while holding them.
+struct SharedBarriers
+{
+    using mutex_type = RobustMutex;
+
+    SharedBarriers()
+        : locks_memory(boost::interprocess::open_or_create,
+                       "osrm-robust-locks",
+                       boost::interprocess::read_write),
+          locks(SharedLocks::Map(locks_memory, locks_region)),
+          pending_update_mutex(&locks->pending_update_mutex),
+          update_mutex(&locks->update_mutex), query_mutex(&locks->query_mutex),
+          no_running_queries_condition(&locks->no_running_queries_condition),
+          counters_memory(boost::interprocess::open_or_create,
+                          "osrm-query-counters",
+                          boost::interprocess::read_write)
+    {
+        counters_memory.truncate(sizeof(SharedQueryCounters));
+        counters_region =
+            boost::interprocess::mapped_region(counters_memory, boost::interprocess::read_write);
+        counters = static_cast<SharedQueryCounters *>(counters_region.get_address());
+    }
+
+    boost::interprocess::shared_memory_object locks_memory;
+    boost::interprocess::mapped_region locks_region;
+    SharedLocks *locks;
+
+    RobustMutex pending_update_mutex;
+    RobustMutex update_mutex;
+    RobustMutex query_mutex;
+    RobustCondition no_running_queries_condition;
+
+    boost::interprocess::shared_memory_object counters_memory;
+    boost::interprocess::mapped_region counters_region;
+    SharedQueryCounters *counters;
+};
+#else
 struct SharedBarriers
 {
+    using mutex_type = boost::interprocess::named_mutex;
 
     SharedBarriers()
         : pending_update_mutex(boost::interprocess::open_or_create, "pending_update"),
           update_mutex(boost::interprocess::open_or_create, "update"),
           query_mutex(boost::interprocess::open_or_create, "query"),
           no_running_queries_condition(boost::interprocess::open_or_create, "no_running_queries"),
-          update_ongoing(false), number_of_queries(0)
+          counters_memory(boost::interprocess::open_or_create,
+                          "osrm-query-counters",
+                          boost::interprocess::read_write)
     {
+        // a freshly created segment is zero filled, which is a valid state for the counters
+        counters_memory.truncate(sizeof(SharedQueryCounters));
+        counters_region =
+            boost::interprocess::mapped_region(counters_memory, boost::interprocess::read_write);
+        counters = static_cast<SharedQueryCounters *>(counters_region.get_address());
     }
 
     // Mutex to protect access to the boolean variable
@@ -28,11 +226,11 @@ struct SharedBarriers
     // Condition that no update is running
     boost::interprocess::named_condition no_running_queries_condition;
 
-    // Is there an ongoing update?
-    bool update_ongoing;
-    // Is there any query?
-    int number_of_queries;
+    boost::interprocess::shared_memory_object counters_memory;
+    boost::interprocess::mapped_region counters_region;
+    SharedQueryCounters *counters;
 };
+#endif
 }
 }
 
@@ -4,9 +4,12 @@
 #include "util/exception.hpp"
 #include "util/simple_logger.hpp"
 
+#include <boost/assert.hpp>
+
 #include <cstdint>
 
 #include <array>
+#include <atomic>
 
 namespace osrm
 {
@@ -17,20 +20,25 @@ namespace storage
 const constexpr char CANARY[4] = {'O', 'S', 'R', 'M'};
 
 const constexpr char *block_id_to_name[] = {"NAME_OFFSETS",
-                                            "NAME_BLOCKS",
+                                            "NAME_LENGTHS",
                                             "NAME_CHAR_LIST",
                                             "NAME_ID_LIST",
                                             "VIA_NODE_LIST",
                                             "GRAPH_NODE_LIST",
                                             "GRAPH_EDGE_LIST",
                                             "COORDINATE_LIST",
+                                            "COORDINATE_BLOCKS",
+                                            "COORDINATE_WORDS",
                                             "OSM_NODE_ID_LIST",
                                             "TURN_INSTRUCTION",
                                             "TRAVEL_MODE",
                                             "ENTRY_CLASSID",
                                             "R_SEARCH_TREE",
+                                            "R_SEARCH_TREE_LEAVES",
                                             "GEOMETRIES_INDEX",
                                             "GEOMETRIES_LIST",
+                                            "GEOMETRIES_BLOCK_OFFSETS",
+                                            "GEOMETRIES_ENCODED",
                                             "HSGR_CHECKSUM",
                                             "TIMESTAMP",
                                             "FILE_INDEX_PATH",
@@ -48,27 +56,40 @@ const constexpr char *block_id_to_name[] = {"NAME_OFFSETS",
                                             "LANE_DATA_ID",
                                             "TURN_LANE_DATA",
                                             "LANE_DESCRIPTION_OFFSETS",
-                                            "LANE_DESCRIPTION_MASKS"};
+                                            "LANE_DESCRIPTION_MASKS",
+                                            "TIME_SLOTS",
+                                            "TIME_SLOT_EDGE_DATA",
+                                            "TIME_SLOT_GEOMETRY_WEIGHTS",
+                                            "EDGE_LENGTHS",
+                                            "DUPLICATED_NODES",
+                                            "CORE_LANDMARK_DISTANCES"};
 
 struct SharedDataLayout
 {
     enum BlockID
     {
         NAME_OFFSETS = 0,
-        NAME_BLOCKS,
+        NAME_LENGTHS,
         NAME_CHAR_LIST,
         NAME_ID_LIST,
         VIA_NODE_LIST,
         GRAPH_NODE_LIST,
         GRAPH_EDGE_LIST,
         COORDINATE_LIST,
+        // only with osrm-datastore --compress-coordinates, COORDINATE_LIST is empty then
+        COORDINATE_BLOCKS,
+        COORDINATE_WORDS,
         OSM_NODE_ID_LIST,
         TURN_INSTRUCTION,
         TRAVEL_MODE,
         ENTRY_CLASSID,
         R_SEARCH_TREE,
+        R_SEARCH_TREE_LEAVES,
         GEOMETRIES_INDEX,
         GEOMETRIES_LIST,
+        // only with osrm-datastore --compress-geometries, GEOMETRIES_LIST is empty then
+        GEOMETRIES_BLOCK_OFFSETS,
+        GEOMETRIES_ENCODED,
         HSGR_CHECKSUM,
         TIMESTAMP,
         FILE_INDEX_PATH,
@@ -87,6 +108,13 @@ struct SharedDataLayout
         TURN_LANE_DATA,
         LANE_DESCRIPTION_OFFSETS,
         LANE_DESCRIPTION_MASKS,
+        TIME_SLOTS,
+        TIME_SLOT_EDGE_DATA,
+        TIME_SLOT_GEOMETRY_WEIGHTS,
+        EDGE_LENGTHS,
+        DUPLICATED_NODES,
+        // last, so osrm-traffic-update can drop it without moving the other blocks
+        CORE_LANDMARK_DISTANCES,
         NUM_BLOCKS
     };
 
@@ -163,6 +191,17 @@ struct SharedDataLayout
 
         return ptr;
     }
+
+    // Rounds the block pointer up to a multiple of alignment, the block needs to be sized with
+    // alignment - 1 additional entries of slack.
+    template <typename T, bool WRITE_CANARY = false>
+    inline T *GetAlignedBlockPtr(char *shared_memory, BlockID bid, const std::uintptr_t alignment)
+    {
+        BOOST_ASSERT(entry_size[bid] == sizeof(char));
+        const auto address =
+            reinterpret_cast<std::uintptr_t>(GetBlockPtr<char, WRITE_CANARY>(shared_memory, bid));
+        return reinterpret_cast<T *>((address + alignment - 1) & ~(alignment - 1));
+    }
 };
 
 enum SharedDataType
@@ -176,11 +215,28 @@ enum SharedDataType
     DATA_NONE
 };
 
+// Copies of DATA_1 and DATA_2 for the NUMA nodes 1, 2,.. written by osrm-datastore --numa
+// replicate, node 0 uses the data region itself. Shared memory ids are bytes.
+static const constexpr unsigned MAX_NUMA_REPLICAS = 32;
+static const constexpr int DATA_1_REPLICAS = 16;
+static const constexpr int DATA_2_REPLICAS = DATA_1_REPLICAS + MAX_NUMA_REPLICAS;
+
+inline int GetReplicaRegion(const SharedDataType data_region, const unsigned numa_node)
+{
+    BOOST_ASSERT(data_region == DATA_1 || data_region == DATA_2);
+    BOOST_ASSERT(numa_node > 0 && numa_node < MAX_NUMA_REPLICAS);
+    return (data_region == DATA_1 ? DATA_1_REPLICAS : DATA_2_REPLICAS) +
+           static_cast<int>(numa_node);
+}
+
 struct SharedDataTimestamp
 {
     SharedDataType layout;
     SharedDataType data;
-    unsigned timestamp;
+    // number of NUMA nodes with a copy of data, 0 if there are no replicas
+    unsigned numa_replicas;
+    // bumped after layout and data are written, publishes a new dataset generation
+    std::atomic<unsigned> timestamp;
 };
 
 static_assert(sizeof(block_id_to_name) / sizeof(*block_id_to_name) == SharedDataLayout::NUM_BLOCKS,
@@ -7,7 +7,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/interprocess/mapped_region.hpp>
-#ifndef _WIN32
+#if !defined(_WIN32) && !defined(OSRM_POSIX_SHARED_MEMORY)
 #include <boost/interprocess/xsi_shared_memory.hpp>
 #else
 #include <boost/interprocess/shared_memory_object.hpp>
@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <string>
 
 namespace osrm
 {
@@ -39,7 +40,87 @@ struct OSRMLockFile
     }
 };
 
-#ifndef _WIN32
+#if defined(OSRM_POSIX_SHARED_MEMORY) && !defined(_WIN32)
+// POSIX shared memory, the regions are files in /dev/shm named osrm-region-<id>. They are only
+// limited by the size of /dev/shm instead of kernel.shmmax and kernel.shmall. A removed region
+// stays valid until the last process unmaps it, so readers never need to be cleaned up after.
+class SharedMemory
+{
+  public:
+    void *Ptr() const { return region.get_address(); }
+
+    SharedMemory(const SharedMemory &) = delete;
+    SharedMemory &operator=(const SharedMemory &) = delete;
+
+    template <typename IdentifierT>
+    SharedMemory(const boost::filesystem::path &,
+                 const IdentifierT id,
+                 const uint64_t size = 0,
+                 bool read_write = false,
+                 bool remove_prev = true)
+        : name(GetName(id))
+    {
+        if (0 == size)
+        { // read_only
+            shm = boost::interprocess::shared_memory_object(
+                boost::interprocess::open_only,
+                name.c_str(),
+                read_write ? boost::interprocess::read_write : boost::interprocess::read_only);
+            region = boost::interprocess::mapped_region(
+                shm, read_write ? boost::interprocess::read_write : boost::interprocess::read_only);
+        }
+        else
+        { // writeable pointer
+            if (remove_prev)
+            {
+                Remove(name);
+            }
+            shm = boost::interprocess::shared_memory_object(
+                boost::interprocess::open_or_create, name.c_str(), boost::interprocess::read_write);
+            shm.truncate(size);
+            region = boost::interprocess::mapped_region(shm, boost::interprocess::read_write);
+            util::SimpleLogger().Write(logDEBUG) << "writeable memory allocated " << size
+                                                 << " bytes";
+        }
+    }
+
+    template <typename IdentifierT> static bool RegionExists(const IdentifierT id)
+    {
+        try
+        {
+            boost::interprocess::shared_memory_object shm(boost::interprocess::open_only,
+                                                          GetName(id).c_str(),
+                                                          boost::interprocess::read_only);
+        }
+        catch (...)
+        {
+            return false;
+        }
+        return true;
+    }
+
+    template <typename IdentifierT> static bool Remove(const IdentifierT id)
+    {
+        return Remove(GetName(id));
+    }
+
+  private:
+    template <typename IdentifierT> static std::string GetName(const IdentifierT id)
+    {
+        return "osrm-region-" + std::to_string(static_cast<int>(id));
+    }
+
+    static bool Remove(const std::string &name)
+    {
+        util::SimpleLogger().Write(logDEBUG) << "deallocating prev memory";
+        return boost::interprocess::shared_memory_object::remove(name.c_str());
+    }
+
+    std::string name;
+    boost::interprocess::shared_memory_object shm;
+    boost::interprocess::mapped_region region;
+};
+#elif !defined(_WIN32)
 class SharedMemory
 {
 
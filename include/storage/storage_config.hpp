@@ -58,6 +58,14 @@ struct StorageConfig final
     boost::filesystem::path nodes_data_path;
     boost::filesystem::path edges_data_path;
     boost::filesystem::path core_data_path;
+    // only written by osrm-contract --core-landmarks
+    boost::filesystem::path core_landmarks_path;
+    // written by osrm-contract, missing in datasets of older versions
+    boost::filesystem::path edge_lengths_path;
+    // written by osrm-extract, missing in datasets of older versions
+    boost::filesystem::path duplicated_nodes_path;
+    // only written by osrm-contract --time-slot-speed-file
+    boost::filesystem::path time_slots_path;
     boost::filesystem::path geometries_path;
     boost::filesystem::path timestamp_path;
     boost::filesystem::path datasource_names_path;
@@ -67,6 +75,35 @@ struct StorageConfig final
     boost::filesystem::path intersection_class_path;
     boost::filesystem::path turn_lane_data_path;
     boost::filesystem::path turn_lane_description_path;
+    // only needed for multi-level Dijkstra, see osrm-partition and osrm-customize
+    boost::filesystem::path partition_path;
+    boost::filesystem::path cells_path;
+    boost::filesystem::path mld_graph_path;
+    // all of the above except for multi-level Dijkstra in one file, see osrm-datastore --dataset
+    boost::filesystem::path dataset_path;
+
+    // copy the r-tree leaves into shared memory instead of mapping file_index_path
+    bool share_rtree_leaves = false;
+    // advise the kernel to back the data region with transparent huge pages
+    bool use_huge_pages = false;
+    // touch all r-tree leaf pages in parallel after loading
+    bool warm_up_rtree_leaves = false;
+    // write the data region to dataset_path instead of publishing it in shared memory
+    bool write_dataset = false;
+    // spread the pages of the data region round-robin over all NUMA nodes
+    bool interleave_numa_nodes = false;
+    // place the data region on NUMA node 0 and a copy of it on every other node (Linux only)
+    bool replicate_numa_nodes = false;
+    // store the geometries block-compressed, see util::DeltaEncodedGeometries
+    bool compress_geometries = false;
+    // store the node coordinates block-compressed, see util::BlockEncodedCoordinates
+    bool compress_coordinates = false;
+    // map the files in InternalDataFacade where possible and read the pages on first access
+    bool lazy_loading = false;
+    // only load what distance tables need: the search graph, the r-tree with the coordinates and
+    // the geometry weights for snapping. Names, guidance, lanes, datasources and OSM node ids are
+    // left out, the other services are disabled for such a dataset.
+    bool weights_only = false;
 };
 }
 }
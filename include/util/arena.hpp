@@ -0,0 +1,169 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Hands out memory from large blocks and frees all of it at once in Release(). Deallocation is a
+// no-op, so it suits the many short lived temporaries of a request. Release() keeps a block for
+// the next request.
+class MonotonicArena
+{
+  public:
+    static const constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    MonotonicArena() = default;
+    MonotonicArena(const MonotonicArena &) = delete;
+    MonotonicArena &operator=(const MonotonicArena &) = delete;
+
+    void *Allocate(const std::size_t size, const std::size_t alignment)
+    {
+        BOOST_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0);
+        auto offset = (used + alignment - 1) & ~(alignment - 1);
+        if (blocks.empty() || offset + size > blocks.back().size)
+        {
+            // requests larger than a block get a block of their own
+            const std::size_t block_size =
+                size + alignment > BLOCK_SIZE ? size + alignment : BLOCK_SIZE;
+            blocks.push_back(Block{std::unique_ptr<char[]>(new char[block_size]), block_size});
+            const auto address = reinterpret_cast<std::uintptr_t>(blocks.back().data.get());
+            offset = ((address + alignment - 1) & ~(alignment - 1)) - address;
+        }
+        used = offset + size;
+        allocated_bytes += size;
+        return blocks.back().data.get() + offset;
+    }
+
+    // Frees everything allocated since the last Release()
+    void Release()
+    {
+        // blocks of larger allocations are not kept
+        if (!blocks.empty() && blocks.front().size == BLOCK_SIZE)
+        {
+            blocks.erase(blocks.begin() + 1, blocks.end());
+        }
+        else
+        {
+            blocks.clear();
+        }
+        used = 0;
+        allocated_bytes = 0;
+    }
+
+    // Bytes handed out since the last Release()
+    std::size_t AllocatedBytes() const { return allocated_bytes; }
+
+  private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    std::vector<Block> blocks;
+    // bytes used of the last block
+    std::size_t used = 0;
+    std::size_t allocated_bytes = 0;
+};
+
+namespace detail
+{
+inline MonotonicArena *&ActiveArena()
+{
+    static thread_local MonotonicArena *active_arena = nullptr;
+    return active_arena;
+}
+}
+
+// Makes the arena of the calling thread active until the scope ends and releases it then.
+// ArenaAllocators constructed in the scope allocate from it, everything they allocated has to
+// be gone by the end of the scope. Scopes do not nest, inner scopes use the outer arena.
+class ArenaScope
+{
+  public:
+    ArenaScope() : owns_arena(detail::ActiveArena() == nullptr)
+    {
+        if (owns_arena)
+        {
+            static thread_local MonotonicArena thread_arena;
+            detail::ActiveArena() = &thread_arena;
+        }
+    }
+
+    ~ArenaScope()
+    {
+        if (owns_arena)
+        {
+            detail::ActiveArena()->Release();
+            detail::ActiveArena() = nullptr;
+        }
+    }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+  private:
+    const bool owns_arena;
+};
+
+// Allocates from the arena of the ArenaScope active when it was constructed, or from the heap
+// outside of one. Only meant for containers that do not outlive the scope.
+template <typename T> class ArenaAllocator
+{
+  public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept : arena(detail::ActiveArena()) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena(other.arena)
+    {
+    }
+
+    T *allocate(const std::size_t count)
+    {
+        if (arena)
+        {
+            return static_cast<T *>(arena->Allocate(count * sizeof(T), alignof(T)));
+        }
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T *pointer, const std::size_t count) noexcept
+    {
+        if (!arena)
+        {
+            std::allocator<T>().deallocate(pointer, count);
+        }
+    }
+
+    template <typename U> bool operator==(const ArenaAllocator<U> &other) const noexcept
+    {
+        return arena == other.arena;
+    }
+
+    template <typename U> bool operator!=(const ArenaAllocator<U> &other) const noexcept
+    {
+        return arena != other.arena;
+    }
+
+  private:
+    template <typename U> friend class ArenaAllocator;
+
+    MonotonicArena *arena;
+};
+
+template <typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}
+}
+
+#endif // ARENA_HPP
@@ -2,6 +2,8 @@
 #define BEARING_HPP
 
 #include <boost/assert.hpp>
+
+#include <cstdint>
 #include <string>
 
 namespace osrm
@@ -96,6 +98,33 @@ inline double reverseBearing(const double bearing)
         return bearing - 180.;
     return bearing + 180;
 }
+
+// Bearings are binned into NUM_SECTORS sectors of 22.5 degrees to prune candidates by their
+// direction. A SectorMask has the bits of a set of sectors set.
+using SectorMask = std::uint16_t;
+static const constexpr int NUM_SECTORS = 16;
+static const constexpr SectorMask ALL_SECTORS = 0xffff;
+
+// Sector of a bearing in degrees, modulo 360
+inline SectorMask Sector(const int bearing)
+{
+    const int normalized = (bearing % 360 + 360) % 360;
+    return static_cast<SectorMask>(1u << (normalized * NUM_SECTORS / 360));
+}
+
+// Sectors of all bearings that CheckInBounds accepts for B and range
+inline SectorMask SectorsInBounds(const int B, const int range)
+{
+    if (range >= 180)
+        return ALL_SECTORS;
+
+    SectorMask sectors = 0;
+    for (int A = B - range; A <= B + range; ++A)
+    {
+        sectors |= Sector(A);
+    }
+    return sectors;
+}
 }
 }
 }
@@ -15,6 +15,20 @@ namespace osrm
 namespace util
 {
 
+// Hints the cache to load the line of address, searches use it for the heap slots of the
+// targets of a node's edges so their misses overlap instead of following one another
+inline void PrefetchForRead(const void *address)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(address, 0, 3);
+#else
+    (void)address;
+#endif
+}
+
+// Dense index storage with one slot per node. Clear() is a no-op: stale slots are harmless
+// since BinaryHeap::WasInserted verifies every index against the inserted node list.
+// Grows on demand so a heap outliving a dataset reload stays valid for larger graphs.
 template <typename NodeID, typename Key> class ArrayStorage
 {
   public:
@@ -22,9 +36,33 @@ template <typename NodeID, typename Key> class ArrayStorage
 
     ~ArrayStorage() {}
 
-    Key &operator[](NodeID node) { return positions[node]; }
+    Key &operator[](NodeID node)
+    {
+        if (static_cast<std::size_t>(node) >= positions.size())
+        {
+            positions.resize(static_cast<std::size_t>(node) + 1, 0);
+        }
+        return positions[node];
+    }
+
+    Key peek_index(const NodeID node) const
+    {
+        if (static_cast<std::size_t>(node) >= positions.size())
+        {
+            return std::numeric_limits<Key>::max();
+        }
+        return positions[node];
+    }
 
-    Key peek_index(const NodeID node) const { return positions[node]; }
+    static const constexpr bool CAN_PREFETCH = true;
+
+    void Prefetch(const NodeID node) const
+    {
+        if (static_cast<std::size_t>(node) < positions.size())
+        {
+            PrefetchForRead(&positions[node]);
+        }
+    }
 
     void Clear() {}
 
@@ -41,6 +79,11 @@ template <typename NodeID, typename Key> class MapStorage
 
     void Clear() { nodes.clear(); }
 
+    // the tree nodes can not be found without walking the tree
+    static const constexpr bool CAN_PREFETCH = false;
+
+    void Prefetch(const NodeID) const {}
+
     Key peek_index(const NodeID node) const
     {
         const auto iter = nodes.find(node);
@@ -78,6 +121,11 @@ template <typename NodeID, typename Key> class UnorderedMapStorage
         return iter->second;
     }
 
+    // the buckets are linked lists, only finding the entry loads them
+    static const constexpr bool CAN_PREFETCH = false;
+
+    void Prefetch(const NodeID) const {}
+
     void Clear() { nodes.clear(); }
 
   private:
@@ -105,14 +153,27 @@ class BinaryHeap
     {
         heap.resize(1);
         inserted_nodes.clear();
+        removed_nodes = 0;
         heap[0].weight = std::numeric_limits<Weight>::min();
         node_index.Clear();
     }
 
     std::size_t Size() const { return (heap.size() - 1); }
 
+    // Nodes inserted since the last Clear()
+    std::size_t NumberOfInsertedNodes() const { return inserted_nodes.size(); }
+
+    // Nodes taken by DeleteMin() since the last Clear(), the nodes a search settled
+    std::size_t NumberOfRemovedNodes() const { return removed_nodes; }
+
     bool Empty() const { return 0 == Size(); }
 
+    // Whether Prefetch does anything, searches skip collecting the nodes to prefetch otherwise
+    static const constexpr bool CAN_PREFETCH = IndexStorage::CAN_PREFETCH;
+
+    // Starts loading the index slot of node that WasInserted, GetKey and Insert read next
+    void Prefetch(const NodeID node) const { node_index.Prefetch(node); }
+
     void Insert(NodeID node, Weight weight, const Data &data)
     {
         HeapElement element;
@@ -184,6 +245,7 @@ class BinaryHeap
             Downheap(1);
         }
         inserted_nodes[removedIndex].key = 0;
+        ++removed_nodes;
         CheckHeap();
         return inserted_nodes[removedIndex].node;
     }
@@ -234,6 +296,7 @@ class BinaryHeap
     std::vector<HeapNode> inserted_nodes;
     std::vector<HeapElement> heap;
     IndexStorage node_index;
+    std::size_t removed_nodes = 0;
 
     void Downheap(Key key)
     {
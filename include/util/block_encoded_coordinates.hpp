@@ -0,0 +1,248 @@
+#ifndef BLOCK_ENCODED_COORDINATES_HPP
+#define BLOCK_ENCODED_COORDINATES_HPP
+
+#include "util/coordinate.hpp"
+#include "util/shared_memory_vector_wrapper.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+namespace detail
+{
+// Same layout in and out of shared memory
+struct CoordinateBlock
+{
+    std::int32_t min_lon;
+    std::int32_t min_lat;
+    // first word of the packed differences
+    std::uint32_t word_offset;
+    std::uint8_t number_of_coordinates;
+    std::uint8_t lon_bits;
+    std::uint8_t lat_bits;
+};
+}
+
+/**
+ * Block-compressed form of the node coordinates, the COORDINATE_LIST that otherwise stores two
+ * fixed point integers for every node.
+ *
+ * The coordinates are grouped into blocks of BLOCK_SIZE consecutive nodes. Every block stores
+ * the minimum longitude and latitude of its nodes and the number of bits the largest difference
+ * to these needs. The differences of all nodes of the block follow bit packed with these widths,
+ * starting at a word of their own. A coordinate is thus found without decoding any other: the
+ * position of its bits only depends on its index within the block.
+ *
+ * Nodes that are close by have close by ids if the extractor numbered them along a hilbert curve
+ * (osrm-extract --spatial-node-order), which keeps the widths small.
+ */
+template <bool UseSharedMemory = false> class BlockEncodedCoordinates
+{
+  public:
+    static const constexpr std::size_t BLOCK_SIZE = 16;
+
+    using Block = detail::CoordinateBlock;
+
+    static std::size_t NumberOfBlocks(const std::size_t number_of_coordinates)
+    {
+        return (number_of_coordinates + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    }
+
+    // Encodes anything with a fixed point lon and lat, e.g. coordinates or query nodes
+    template <typename CoordinateVector>
+    static void Encode(const CoordinateVector &coordinates,
+                       std::vector<Block> &blocks,
+                       std::vector<std::uint64_t> &words)
+    {
+        const auto bits_of = [](const std::uint64_t value) {
+            std::uint8_t bits = 0;
+            while ((value >> bits) != 0)
+            {
+                ++bits;
+            }
+            return bits;
+        };
+
+        blocks.clear();
+        blocks.reserve(NumberOfBlocks(coordinates.size()));
+        words.clear();
+        for (std::size_t begin = 0; begin < coordinates.size(); begin += BLOCK_SIZE)
+        {
+            const std::size_t end = std::min(begin + BLOCK_SIZE, coordinates.size());
+            Block block;
+            block.min_lon = static_cast<std::int32_t>(coordinates[begin].lon);
+            block.min_lat = static_cast<std::int32_t>(coordinates[begin].lat);
+            std::int32_t max_lon = block.min_lon;
+            std::int32_t max_lat = block.min_lat;
+            for (std::size_t index = begin; index < end; ++index)
+            {
+                const auto lon = static_cast<std::int32_t>(coordinates[index].lon);
+                const auto lat = static_cast<std::int32_t>(coordinates[index].lat);
+                block.min_lon = std::min(block.min_lon, lon);
+                block.min_lat = std::min(block.min_lat, lat);
+                max_lon = std::max(max_lon, lon);
+                max_lat = std::max(max_lat, lat);
+            }
+            BOOST_ASSERT(words.size() <= std::numeric_limits<std::uint32_t>::max());
+            block.word_offset = static_cast<std::uint32_t>(words.size());
+            block.number_of_coordinates = static_cast<std::uint8_t>(end - begin);
+            block.lon_bits = bits_of(static_cast<std::int64_t>(max_lon) - block.min_lon);
+            block.lat_bits = bits_of(static_cast<std::int64_t>(max_lat) - block.min_lat);
+            blocks.push_back(block);
+
+            const std::size_t coordinate_bits = block.lon_bits + block.lat_bits;
+            words.resize(words.size() + (coordinate_bits * (end - begin) + 63) / 64, 0);
+            std::uint64_t position = std::uint64_t{block.word_offset} * 64;
+            for (std::size_t index = begin; index < end; ++index)
+            {
+                const std::int64_t lon = static_cast<std::int32_t>(coordinates[index].lon);
+                const std::int64_t lat = static_cast<std::int32_t>(coordinates[index].lat);
+                Write(words, position, block.lon_bits, lon - block.min_lon);
+                Write(words, position + block.lon_bits, block.lat_bits, lat - block.min_lat);
+                position += coordinate_bits;
+            }
+        }
+    }
+
+    template <bool enabled = UseSharedMemory>
+    void Reset(typename std::enable_if<!enabled, std::vector<Block>>::type blocks_,
+               std::vector<std::uint64_t> words_)
+    {
+        blocks = std::move(blocks_);
+        words = std::move(words_);
+    }
+
+    template <bool enabled = UseSharedMemory>
+    void Reset(typename std::enable_if<enabled, Block>::type *blocks_ptr,
+               const std::size_t number_of_blocks,
+               std::uint64_t *words_ptr,
+               const std::size_t number_of_words)
+    {
+        blocks.reset(blocks_ptr, number_of_blocks);
+        words.reset(words_ptr, number_of_words);
+    }
+
+    bool empty() const { return blocks.empty(); }
+
+    std::size_t size() const
+    {
+        return blocks.empty()
+                   ? 0
+                   : (blocks.size() - 1) * BLOCK_SIZE +
+                         blocks[blocks.size() - 1].number_of_coordinates;
+    }
+
+    std::size_t SizeInBytes() const
+    {
+        return blocks.size() * sizeof(Block) + words.size() * sizeof(std::uint64_t);
+    }
+
+    Coordinate operator[](const std::size_t index) const
+    {
+        BOOST_ASSERT(index < size());
+        const Block &block = blocks[index / BLOCK_SIZE];
+        const std::uint64_t position =
+            std::uint64_t{block.word_offset} * 64 +
+            (index % BLOCK_SIZE) * (block.lon_bits + block.lat_bits);
+        return Coordinate{
+            FixedLongitude{static_cast<std::int32_t>(
+                block.min_lon + static_cast<std::int64_t>(Read(position, block.lon_bits)))},
+            FixedLatitude{static_cast<std::int32_t>(
+                block.min_lat +
+                static_cast<std::int64_t>(Read(position + block.lon_bits, block.lat_bits)))}};
+    }
+
+  private:
+    typename util::ShM<Block, UseSharedMemory>::vector blocks;
+    typename util::ShM<std::uint64_t, UseSharedMemory>::vector words;
+
+    // Values have at most 32 bits and span at most two words
+    static void Write(std::vector<std::uint64_t> &words,
+                      const std::uint64_t position,
+                      const std::uint8_t bits,
+                      const std::uint64_t value)
+    {
+        if (bits == 0)
+        {
+            return;
+        }
+        const auto word = position / 64;
+        const auto shift = position % 64;
+        words[word] |= value << shift;
+        if (shift + bits > 64)
+        {
+            words[word + 1] |= value >> (64 - shift);
+        }
+    }
+
+    std::uint64_t Read(const std::uint64_t position, const std::uint8_t bits) const
+    {
+        // blocks of equal values have no words
+        if (bits == 0)
+        {
+            return 0;
+        }
+        const auto word = position / 64;
+        const auto shift = position % 64;
+        std::uint64_t value = words[word] >> shift;
+        if (shift + bits > 64)
+        {
+            value |= words[word + 1] << (64 - shift);
+        }
+        return value & ((std::uint64_t{1} << bits) - 1);
+    }
+};
+
+/**
+ * The coordinates of all nodes, either as they are or block encoded. Used by the data facades,
+ * the r-tree and the geospatial queries alike.
+ */
+template <bool UseSharedMemory = false> class CoordinateList
+{
+  public:
+    using PlainVector = typename util::ShM<Coordinate, UseSharedMemory>::vector;
+    using EncodedCoordinates = BlockEncodedCoordinates<UseSharedMemory>;
+
+    void Reset(PlainVector plain_) { plain = std::move(plain_); }
+
+    void Reset(EncodedCoordinates encoded_)
+    {
+        encoded = std::move(encoded_);
+        plain = PlainVector();
+    }
+
+    bool IsEncoded() const { return !encoded.empty(); }
+
+    std::size_t size() const { return IsEncoded() ? encoded.size() : plain.size(); }
+
+    bool empty() const { return size() == 0; }
+
+    std::size_t SizeInBytes() const
+    {
+        return IsEncoded() ? encoded.SizeInBytes() : plain.size() * sizeof(Coordinate);
+    }
+
+    Coordinate operator[](const std::size_t index) const
+    {
+        return IsEncoded() ? encoded[index] : plain[index];
+    }
+
+  private:
+    PlainVector plain;
+    EncodedCoordinates encoded;
+};
+}
+}
+
+#endif // BLOCK_ENCODED_COORDINATES_HPP
@@ -0,0 +1,354 @@
+#ifndef BUFFERED_FILE_HPP
+#define BUFFERED_FILE_HPP
+
+#include "util/exception.hpp"
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <ios>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+namespace detail
+{
+// The files of the pipeline are written and read in blocks of this size, large enough that
+// network disks see few requests
+const constexpr std::size_t FILE_BLOCK_SIZE = 8 * 1024 * 1024;
+
+inline int SeekFile(std::FILE *file, const std::int64_t offset, const int origin)
+{
+#ifdef _WIN32
+    return _fseeki64(file, offset, origin);
+#else
+    return fseeko(file, offset, origin);
+#endif
+}
+
+inline std::int64_t TellFile(std::FILE *file)
+{
+#ifdef _WIN32
+    return _ftelli64(file);
+#else
+    return ftello(file);
+#endif
+}
+
+// Fills one block while the previous one is written on a background thread
+class DoubleBufferedWriter final : public std::streambuf
+{
+  public:
+    DoubleBufferedWriter(const boost::filesystem::path &path_, const bool append)
+        : path(path_), file(std::fopen(path.string().c_str(), append ? "ab" : "wb")),
+          block(FILE_BLOCK_SIZE), pending_block(FILE_BLOCK_SIZE), block_offset(0)
+    {
+        if (!file)
+        {
+            throw exception("Could not open " + path.string() + " for writing");
+        }
+        block_offset = TellFile(file);
+        setp(block.data(), block.data() + block.size());
+    }
+
+    ~DoubleBufferedWriter() override
+    {
+        if (file)
+        {
+            // errors were thrown by the writes that caused them or are lost without close()
+            try
+            {
+                Close();
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+
+    // Writes all data, throws if any of it could not be written
+    void Close()
+    {
+        if (!file)
+        {
+            return;
+        }
+        WriteBlock();
+        WaitForWrite();
+        const auto closed = std::fclose(file);
+        file = nullptr;
+        if (closed != 0)
+        {
+            throw exception("Could not write to " + path.string());
+        }
+    }
+
+  protected:
+    int_type overflow(const int_type character) override
+    {
+        WriteBlock();
+        if (!traits_type::eq_int_type(character, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(character);
+            pbump(1);
+        }
+        return traits_type::not_eof(character);
+    }
+
+    int sync() override
+    {
+        WriteBlock();
+        WaitForWrite();
+        return std::fflush(file) == 0 ? 0 : -1;
+    }
+
+    pos_type seekoff(const off_type offset,
+                     const std::ios_base::seekdir direction,
+                     const std::ios_base::openmode which) override
+    {
+        const auto position = block_offset + (pptr() - pbase());
+        if (!(which & std::ios_base::out) || !file)
+        {
+            return pos_type(off_type(-1));
+        }
+        if (direction == std::ios_base::cur && offset == 0)
+        {
+            return pos_type(position);
+        }
+
+        WriteBlock();
+        WaitForWrite();
+        const auto seeked = direction == std::ios_base::end
+                                ? SeekFile(file, offset, SEEK_END)
+                                : SeekFile(file,
+                                           direction == std::ios_base::cur ? position + offset
+                                                                           : offset,
+                                           SEEK_SET);
+        if (seeked != 0)
+        {
+            return pos_type(off_type(-1));
+        }
+        block_offset = TellFile(file);
+        return pos_type(block_offset);
+    }
+
+    pos_type seekpos(const pos_type position, const std::ios_base::openmode which) override
+    {
+        return seekoff(off_type(position), std::ios_base::beg, which);
+    }
+
+  private:
+    // hands the filled part of the block to the background thread
+    void WriteBlock()
+    {
+        WaitForWrite();
+        const std::size_t size = pptr() - pbase();
+        if (size == 0)
+        {
+            return;
+        }
+
+        std::swap(block, pending_block);
+        pending_write = std::async(std::launch::async, [this, size] {
+            if (std::fwrite(pending_block.data(), 1, size, file) != size)
+            {
+                throw exception("Could not write to " + path.string());
+            }
+        });
+        block_offset += size;
+        setp(block.data(), block.data() + block.size());
+    }
+
+    // rethrows the error of the last write
+    void WaitForWrite()
+    {
+        if (pending_write.valid())
+        {
+            pending_write.get();
+        }
+    }
+
+    const boost::filesystem::path path;
+    std::FILE *file;
+    std::vector<char> block;
+    std::vector<char> pending_block;
+    std::future<void> pending_write;
+    // file offset of the first character of block
+    std::int64_t block_offset;
+};
+
+// Reads the next block on a background thread while the current one is consumed
+class ReadAheadReader final : public std::streambuf
+{
+  public:
+    explicit ReadAheadReader(const boost::filesystem::path &path_)
+        : path(path_), file(std::fopen(path.string().c_str(), "rb")), block(FILE_BLOCK_SIZE),
+          pending_block(FILE_BLOCK_SIZE), block_offset(0), pending_offset(0)
+    {
+        setg(block.data(), block.data(), block.data());
+    }
+
+    ~ReadAheadReader() override
+    {
+        if (file)
+        {
+            DiscardRead();
+            std::fclose(file);
+        }
+    }
+
+    bool IsOpen() const { return file != nullptr; }
+
+  protected:
+    int_type underflow() override
+    {
+        if (gptr() < egptr())
+        {
+            return traits_type::to_int_type(*gptr());
+        }
+        if (!file)
+        {
+            return traits_type::eof();
+        }
+
+        if (!pending_read.valid())
+        {
+            StartRead();
+        }
+        const auto size = pending_read.get();
+        std::swap(block, pending_block);
+        block_offset = pending_offset;
+        pending_offset += size;
+        setg(block.data(), block.data(), block.data() + size);
+        if (size == 0)
+        {
+            return traits_type::eof();
+        }
+
+        StartRead();
+        return traits_type::to_int_type(*gptr());
+    }
+
+    pos_type seekoff(const off_type offset,
+                     const std::ios_base::seekdir direction,
+                     const std::ios_base::openmode which) override
+    {
+        const auto position = block_offset + (gptr() - eback());
+        if (!(which & std::ios_base::in) || !file)
+        {
+            return pos_type(off_type(-1));
+        }
+        if (direction == std::ios_base::cur && offset == 0)
+        {
+            return pos_type(position);
+        }
+
+        DiscardRead();
+        const auto seeked = direction == std::ios_base::end
+                                ? SeekFile(file, offset, SEEK_END)
+                                : SeekFile(file,
+                                           direction == std::ios_base::cur ? position + offset
+                                                                           : offset,
+                                           SEEK_SET);
+        if (seeked != 0)
+        {
+            return pos_type(off_type(-1));
+        }
+        block_offset = pending_offset = TellFile(file);
+        setg(block.data(), block.data(), block.data());
+        return pos_type(block_offset);
+    }
+
+    pos_type seekpos(const pos_type position, const std::ios_base::openmode which) override
+    {
+        return seekoff(off_type(position), std::ios_base::beg, which);
+    }
+
+  private:
+    void StartRead()
+    {
+        pending_read = std::async(std::launch::async, [this] {
+            const auto size = std::fread(pending_block.data(), 1, pending_block.size(), file);
+            if (size < pending_block.size() && std::ferror(file))
+            {
+                throw exception("Could not read from " + path.string());
+            }
+            return size;
+        });
+    }
+
+    void DiscardRead()
+    {
+        if (pending_read.valid())
+        {
+            pending_read.wait();
+            pending_read = {};
+        }
+    }
+
+    const boost::filesystem::path path;
+    std::FILE *file;
+    std::vector<char> block;
+    std::vector<char> pending_block;
+    std::future<std::size_t> pending_read;
+    // file offsets of the first characters of block and of the block being read
+    std::int64_t block_offset;
+    std::int64_t pending_offset;
+};
+}
+
+// Binary output file for the large files passed between the stages of the pipeline. The data
+// is collected in large blocks that are written on a background thread, so many small writes
+// cost no more than a few large ones. Opening and writing failures throw util::exception, call
+// close() to find out whether the last block was written.
+class BufferedOutputFile final : public std::ostream
+{
+  public:
+    explicit BufferedOutputFile(const boost::filesystem::path &path,
+                                const std::ios_base::openmode mode = std::ios_base::out)
+        : std::ostream(nullptr), buffer(path, mode & std::ios_base::app)
+    {
+        rdbuf(&buffer);
+        exceptions(std::ios_base::badbit);
+    }
+
+    void close() { buffer.Close(); }
+
+  private:
+    detail::DoubleBufferedWriter buffer;
+};
+
+// Binary input file that reads the next block on a background thread while the current one is
+// parsed. Like std::ifstream it fails the stream instead of throwing if the file can not be
+// opened or read.
+class BufferedInputFile final : public std::istream
+{
+  public:
+    explicit BufferedInputFile(const boost::filesystem::path &path)
+        : std::istream(nullptr), buffer(path)
+    {
+        rdbuf(&buffer);
+        if (!buffer.IsOpen())
+        {
+            setstate(std::ios_base::failbit);
+        }
+    }
+
+  private:
+    detail::ReadAheadReader buffer;
+};
+}
+}
+
+#endif // BUFFERED_FILE_HPP
@@ -5,7 +5,9 @@
 
 #include <boost/optional.hpp>
 
+#include <cstddef>
 #include <utility>
+#include <vector>
 
 namespace osrm
 {
@@ -30,6 +32,20 @@ double haversineDistance(const Coordinate first_coordinate, const Coordinate sec
 
 double greatCircleDistance(const Coordinate first_coordinate, const Coordinate second_coordinate);
 
+// Computes haversineDistance(firsts[i], seconds[i]) for count pairs of coordinates, e.g. the
+// consecutive points of a trace with seconds = firsts + 1. Uses AVX2 if the CPU supports it, the
+// results agree with the scalar version to within a micrometer.
+void haversineDistances(const Coordinate *firsts,
+                        const Coordinate *seconds,
+                        const std::size_t count,
+                        double *distances);
+
+// Same as haversineDistances for greatCircleDistance
+void greatCircleDistances(const Coordinate *firsts,
+                          const Coordinate *seconds,
+                          const std::size_t count,
+                          double *distances);
+
 inline std::pair<double, FloatCoordinate> projectPointOnSegment(const FloatCoordinate &source,
                                                                 const FloatCoordinate &target,
                                                                 const FloatCoordinate &coordinate)
@@ -68,6 +84,15 @@ inline std::pair<double, FloatCoordinate> projectPointOnSegment(const FloatCoord
             }};
 }
 
+// Computes projectPointOnSegment(sources[i], targets[i], coordinate).second for count segments,
+// e.g. all segments of an r-tree leaf. Uses AVX2 if the CPU supports it, the results are
+// identical to the scalar version.
+void projectPointOnSegments(const FloatCoordinate *sources,
+                            const FloatCoordinate *targets,
+                            const std::size_t count,
+                            const FloatCoordinate &coordinate,
+                            FloatCoordinate *nearest);
+
 double perpendicularDistance(const Coordinate segment_source,
                              const Coordinate segment_target,
                              const Coordinate query_location);
@@ -99,6 +124,10 @@ double circleRadius(const Coordinate first_coordinate,
 // returns to
 Coordinate interpolateLinear(double factor, const Coordinate from, const Coordinate to);
 
+// Returns the convex hull of the coordinates in counter-clockwise order, starting at the most
+// south-western one. The hull is not closed, the first coordinate is not repeated at the end.
+std::vector<Coordinate> convexHull(std::vector<Coordinate> coordinates);
+
 } // ns coordinate_calculation
 } // ns util
 } // ns osrm
@@ -0,0 +1,34 @@
+#ifndef CRC32C_HPP
+#define CRC32C_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace osrm
+{
+namespace util
+{
+
+// Bytes checksummed by one task of ParallelCRC32C
+static const constexpr std::size_t CRC32C_CHUNK_SIZE = 1024 * 1024;
+
+// Whether the CPU has the SSE4.2 crc32 instruction
+bool HasHardwareCRC32C();
+
+// CRC32C (Castagnoli) of the bytes, continuing from crc. There is no pre- or post-inversion, so the
+// checksum of nothing is 0 and checksums of adjacent ranges combine with CombineCRC32C. Uses the
+// 8-byte crc32 instruction when available.
+std::uint32_t CRC32C(const char *data, const std::size_t size, const std::uint32_t crc = 0);
+
+// Checksum of two adjacent ranges from the checksums of each, second_size is the length of the
+// second range
+std::uint32_t CombineCRC32C(const std::uint32_t first,
+                            const std::uint32_t second,
+                            const std::uint64_t second_size);
+
+// Same checksum as CRC32C, computed for chunks of CRC32C_CHUNK_SIZE bytes on all cores
+std::uint32_t ParallelCRC32C(const char *data, const std::size_t size);
+}
+}
+
+#endif // CRC32C_HPP
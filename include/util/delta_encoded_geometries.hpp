@@ -0,0 +1,219 @@
+#ifndef DELTA_ENCODED_GEOMETRIES_HPP
+#define DELTA_ENCODED_GEOMETRIES_HPP
+
+#include "util/shared_memory_vector_wrapper.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define OSRM_HAS_SSE2_VARINT_SKIP
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+namespace detail
+{
+inline std::uint64_t zigzag(const std::int64_t value)
+{
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t unzigzag(const std::uint64_t value)
+{
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+// Little endian base 128: seven bits per byte, the high bit is set on all but the last byte
+inline void writeVarint(std::uint64_t value, std::vector<unsigned char> &bytes)
+{
+    while (value >= 0x80)
+    {
+        bytes.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<unsigned char>(value));
+}
+
+inline std::uint64_t readVarint(const unsigned char *&position)
+{
+    std::uint64_t value = 0;
+    unsigned shift = 0;
+    while (*position & 0x80)
+    {
+        value |= static_cast<std::uint64_t>(*position++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= static_cast<std::uint64_t>(*position++) << shift;
+    return value;
+}
+
+// Every varint ends in the one byte without the high bit, so skipping varints is counting those
+// bytes. As long as at least 16 varints are left the next 16 bytes cannot end past them and they
+// are counted at once.
+inline const unsigned char *skipVarints(const unsigned char *position, std::size_t count)
+{
+#ifdef OSRM_HAS_SSE2_VARINT_SKIP
+    while (count >= 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+        const auto ends = ~static_cast<unsigned>(_mm_movemask_epi8(bytes)) & 0xffffu;
+        count -= __builtin_popcount(ends);
+        position += 16;
+    }
+#endif
+    while (count > 0)
+    {
+        count -= (*position++ & 0x80) == 0;
+    }
+    return position;
+}
+}
+
+/**
+ * Block-compressed form of the compressed geometries of all edges, the GEOMETRIES_LIST that
+ * otherwise stores a NodeID and an EdgeWeight for every segment.
+ *
+ * The geometries are grouped into blocks of BLOCK_SIZE consecutive geometries and every block
+ * starts at a byte offset of its own. Within a block each geometry stores the node ids of its
+ * segments followed by their weights, every value as the zigzag encoded difference to the
+ * previous value of the same geometry (the first to zero) in a varint. Decoding a geometry skips
+ * the varints of the geometries before it in the block, which is a count of bytes per 16 bytes.
+ *
+ * The segment offsets of the geometries (GEOMETRIES_INDEX) are stored as before and passed to all
+ * lookups.
+ */
+template <bool UseSharedMemory = false> class DeltaEncodedGeometries
+{
+  public:
+    static const constexpr std::size_t BLOCK_SIZE = 16;
+
+    static std::size_t NumberOfBlocks(const std::size_t number_of_geometries)
+    {
+        return (number_of_geometries + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    }
+
+    // Encodes the segments [indices[i], indices[i + 1]) of every geometry i of segments, which
+    // are anything with a node_id and a weight
+    template <typename IndexVector, typename SegmentVector>
+    static void Encode(const IndexVector &indices,
+                       const SegmentVector &segments,
+                       std::vector<std::uint64_t> &block_offsets,
+                       std::vector<unsigned char> &bytes)
+    {
+        BOOST_ASSERT(!indices.empty());
+        const std::size_t number_of_geometries = indices.size() - 1;
+
+        block_offsets.clear();
+        block_offsets.reserve(NumberOfBlocks(number_of_geometries));
+        bytes.clear();
+        for (std::size_t geometry = 0; geometry < number_of_geometries; ++geometry)
+        {
+            if (geometry % BLOCK_SIZE == 0)
+            {
+                block_offsets.push_back(bytes.size());
+            }
+
+            const std::size_t begin = indices[geometry];
+            const std::size_t end = indices[geometry + 1];
+            std::int64_t previous = 0;
+            for (std::size_t index = begin; index < end; ++index)
+            {
+                const std::int64_t node = segments[index].node_id;
+                detail::writeVarint(detail::zigzag(node - previous), bytes);
+                previous = node;
+            }
+            previous = 0;
+            for (std::size_t index = begin; index < end; ++index)
+            {
+                const std::int64_t weight = segments[index].weight;
+                detail::writeVarint(detail::zigzag(weight - previous), bytes);
+                previous = weight;
+            }
+        }
+    }
+
+    template <bool enabled = UseSharedMemory>
+    void Reset(typename std::enable_if<!enabled, std::vector<std::uint64_t>>::type block_offsets_,
+               std::vector<unsigned char> bytes_)
+    {
+        block_offsets = std::move(block_offsets_);
+        bytes = std::move(bytes_);
+    }
+
+    template <bool enabled = UseSharedMemory>
+    void Reset(typename std::enable_if<enabled, std::uint64_t>::type *block_offsets_ptr,
+               const std::size_t number_of_blocks,
+               unsigned char *bytes_ptr,
+               const std::size_t number_of_bytes)
+    {
+        block_offsets.reset(block_offsets_ptr, number_of_blocks);
+        bytes.reset(bytes_ptr, number_of_bytes);
+    }
+
+    bool Empty() const { return block_offsets.empty(); }
+
+    std::size_t SizeInBytes() const
+    {
+        return block_offsets.size() * sizeof(std::uint64_t) + bytes.size();
+    }
+
+    template <typename IndexVector>
+    void GetNodes(const IndexVector &indices,
+                  const std::size_t geometry,
+                  std::vector<NodeID> &nodes) const
+    {
+        const std::size_t count = indices[geometry + 1] - indices[geometry];
+        nodes.resize(count);
+        Decode(Find(indices, geometry), count, nodes.data());
+    }
+
+    template <typename IndexVector>
+    void GetWeights(const IndexVector &indices,
+                    const std::size_t geometry,
+                    std::vector<EdgeWeight> &weights) const
+    {
+        const std::size_t count = indices[geometry + 1] - indices[geometry];
+        weights.resize(count);
+        Decode(detail::skipVarints(Find(indices, geometry), count), count, weights.data());
+    }
+
+  private:
+    typename util::ShM<std::uint64_t, UseSharedMemory>::vector block_offsets;
+    typename util::ShM<unsigned char, UseSharedMemory>::vector bytes;
+
+    // First byte of the given geometry
+    template <typename IndexVector>
+    const unsigned char *Find(const IndexVector &indices, const std::size_t geometry) const
+    {
+        const std::size_t block = geometry / BLOCK_SIZE;
+        BOOST_ASSERT(block < block_offsets.size());
+        const std::size_t block_begin = indices[block * BLOCK_SIZE];
+        // node id and weight of every segment before the geometry in its block
+        const std::size_t preceding_values = 2 * (indices[geometry] - block_begin);
+        return detail::skipVarints(bytes.data() + block_offsets[block], preceding_values);
+    }
+
+    template <typename T>
+    static void Decode(const unsigned char *position, const std::size_t count, T *out)
+    {
+        std::int64_t value = 0;
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            value += detail::unzigzag(detail::readVarint(position));
+            out[index] = static_cast<T>(value);
+        }
+    }
+};
+}
+}
+
+#endif // DELTA_ENCODED_GEOMETRIES_HPP
@@ -11,7 +11,10 @@
 
 #include <algorithm>
 #include <atomic>
+#include <istream>
 #include <limits>
+#include <numeric>
+#include <ostream>
 #include <tuple>
 #include <vector>
 
@@ -171,24 +174,14 @@ template <typename EdgeDataT> class DynamicGraph
             }
             else
             {
-                EdgeIterator newFirstEdge = (EdgeIterator)edge_list.size();
-                unsigned newSize = node.edges * 1.1 + 2;
-                EdgeIterator requiredCapacity = newSize + edge_list.size();
-                EdgeIterator oldCapacity = edge_list.capacity();
-                if (requiredCapacity >= oldCapacity)
-                {
-                    edge_list.reserve(requiredCapacity * 1.1);
-                }
-                edge_list.resize(edge_list.size() + newSize);
+                const unsigned newSize = node.edges * 1.1 + 2;
+                const EdgeIterator newFirstEdge = AllocateBlock(newSize);
                 for (const auto i : irange(0u, node.edges))
                 {
                     edge_list[newFirstEdge + i] = edge_list[node.first_edge + i];
                     makeDummy(node.first_edge + i);
                 }
-                for (const auto i : irange(node.edges + 1, newSize))
-                {
-                    makeDummy(newFirstEdge + i);
-                }
+                ReleaseBlock(node.first_edge, node.edges);
                 node.first_edge = newFirstEdge;
             }
         }
@@ -200,6 +193,41 @@ template <typename EdgeDataT> class DynamicGraph
         return EdgeIterator(node.first_edge + node.edges);
     }
 
+    // Number of edge slots including the unused ones, see Compact
+    std::size_t GetEdgeCapacity() const { return edge_list.size(); }
+
+    // Moves the edges of all nodes next to each other in the order of their blocks and frees the
+    // unused slots at the end. Invalidates all edge iterators.
+    void Compact()
+    {
+        std::vector<NodeIterator> nodes_by_first_edge(number_of_nodes);
+        std::iota(nodes_by_first_edge.begin(), nodes_by_first_edge.end(), 0);
+        std::sort(nodes_by_first_edge.begin(),
+                  nodes_by_first_edge.end(),
+                  [this](const NodeIterator lhs, const NodeIterator rhs) {
+                      return node_array[lhs].first_edge < node_array[rhs].first_edge;
+                  });
+
+        // the blocks are disjoint, so no edge is overwritten before it is moved
+        EdgeIterator position = 0;
+        for (const auto node : nodes_by_first_edge)
+        {
+            Node &current = node_array[node];
+            for (const auto i : irange(0u, current.edges))
+            {
+                edge_list[position + i] = edge_list[current.first_edge + i];
+            }
+            current.first_edge = position;
+            position += current.edges;
+        }
+        if (node_array.size() > number_of_nodes)
+        {
+            node_array.back().first_edge = position;
+        }
+        edge_list.resize(position);
+        free_blocks.clear();
+    }
+
     // removes an edge. Invalidates edge iterators for the source node
     void DeleteEdge(const NodeIterator source, const EdgeIterator e)
     {
@@ -289,7 +317,115 @@ template <typename EdgeDataT> class DynamicGraph
         return current_iterator;
     }
 
+    // Writes the graph with its unused edge slots, which decide where InsertEdge puts new edges
+    // and so the order of the edges of a node. EdgeDataT is written as it is in memory.
+    bool Write(std::ostream &stream) const
+    {
+        const EdgeIterator edges = number_of_edges;
+        WriteValue(stream, number_of_nodes);
+        WriteValue(stream, edges);
+        WriteVector(stream, node_array);
+
+        const std::uint64_t edge_slots = edge_list.size();
+        WriteValue(stream, edge_slots);
+        const constexpr std::size_t WriteBufferSize = 1024;
+        std::vector<Edge> buffer;
+        buffer.reserve(WriteBufferSize);
+        for (const auto i : irange<std::size_t>(0, edge_slots))
+        {
+            buffer.push_back(edge_list[i]);
+            if (buffer.size() == WriteBufferSize || i + 1 == edge_slots)
+            {
+                stream.write(reinterpret_cast<const char *>(buffer.data()),
+                             buffer.size() * sizeof(Edge));
+                buffer.clear();
+            }
+        }
+
+        const std::uint64_t size_classes = free_blocks.size();
+        WriteValue(stream, size_classes);
+        for (const auto &blocks : free_blocks)
+        {
+            WriteVector(stream, blocks);
+        }
+        return static_cast<bool>(stream);
+    }
+
+    // Restores a graph written by Write, it then changes exactly like the written one would
+    bool Read(std::istream &stream)
+    {
+        EdgeIterator edges = 0;
+        std::uint64_t edge_slots = 0;
+        if (!ReadValue(stream, number_of_nodes) || !ReadValue(stream, edges) ||
+            !ReadVector(stream, node_array) || !ReadValue(stream, edge_slots))
+        {
+            return false;
+        }
+        number_of_edges = edges;
+
+        const constexpr std::size_t ReadBufferSize = 1024;
+        std::vector<Edge> buffer(ReadBufferSize);
+        edge_list.resize(edge_slots);
+        for (std::uint64_t slot = 0; slot < edge_slots;)
+        {
+            const auto count = std::min<std::uint64_t>(ReadBufferSize, edge_slots - slot);
+            if (!stream.read(reinterpret_cast<char *>(buffer.data()), count * sizeof(Edge)))
+            {
+                return false;
+            }
+            for (const auto i : irange<std::size_t>(0, count))
+            {
+                edge_list[slot + i] = buffer[i];
+            }
+            slot += count;
+        }
+
+        std::uint64_t size_classes = 0;
+        if (!ReadValue(stream, size_classes))
+        {
+            return false;
+        }
+        free_blocks.resize(size_classes);
+        for (auto &blocks : free_blocks)
+        {
+            if (!ReadVector(stream, blocks))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
   protected:
+    template <typename T> static void WriteValue(std::ostream &stream, const T &value)
+    {
+        stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <typename T> static void WriteVector(std::ostream &stream, const std::vector<T> &data)
+    {
+        const std::uint64_t count = data.size();
+        WriteValue(stream, count);
+        stream.write(reinterpret_cast<const char *>(data.data()), count * sizeof(T));
+    }
+
+    template <typename T> static bool ReadValue(std::istream &stream, T &value)
+    {
+        return static_cast<bool>(stream.read(reinterpret_cast<char *>(&value), sizeof(T)));
+    }
+
+    template <typename T> static bool ReadVector(std::istream &stream, std::vector<T> &data)
+    {
+        std::uint64_t count = 0;
+        if (!ReadValue(stream, count))
+        {
+            return false;
+        }
+        data.resize(count);
+        return static_cast<bool>(
+            stream.read(reinterpret_cast<char *>(data.data()), count * sizeof(T)));
+    }
+
     bool isDummy(const EdgeIterator edge) const
     {
         return edge_list[edge].target == (std::numeric_limits<NodeIterator>::max)();
@@ -300,6 +436,75 @@ template <typename EdgeDataT> class DynamicGraph
         edge_list[edge].target = (std::numeric_limits<NodeIterator>::max)();
     }
 
+    // Index of the smallest size class whose blocks all have at least size slots
+    static std::size_t GetSizeClass(const unsigned size)
+    {
+        std::size_t size_class = 0;
+        while ((1u << size_class) < size)
+        {
+            ++size_class;
+        }
+        return size_class;
+    }
+
+    // Returns the first of size consecutive dummy slots, reusing a block that a node moved away
+    // from if there is one that is still unused.
+    EdgeIterator AllocateBlock(const unsigned size)
+    {
+        const auto size_class = GetSizeClass(size);
+        while (size_class < free_blocks.size() && !free_blocks[size_class].empty())
+        {
+            const FreeBlock block = free_blocks[size_class].back();
+            free_blocks[size_class].pop_back();
+
+            // Nodes next to a free block grow into it, so it may be used partially already
+            bool is_unused = true;
+            for (const auto i : irange(block.first_edge, block.first_edge + block.size))
+            {
+                is_unused = is_unused && isDummy(i);
+            }
+            if (is_unused)
+            {
+                ReleaseBlock(block.first_edge + size, block.size - size);
+                return block.first_edge;
+            }
+        }
+
+        const EdgeIterator first_edge = static_cast<EdgeIterator>(edge_list.size());
+        edge_list.resize(edge_list.size() + size);
+        for (const auto i : irange(first_edge, first_edge + size))
+        {
+            makeDummy(i);
+        }
+        return first_edge;
+    }
+
+    // Remembers size dummy slots starting at first_edge for AllocateBlock
+    void ReleaseBlock(const EdgeIterator first_edge, const unsigned size)
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        // blocks of size class c hold at least 2^c slots
+        std::size_t size_class = GetSizeClass(size);
+        if ((1u << size_class) > size)
+        {
+            --size_class;
+        }
+        if (free_blocks.size() <= size_class)
+        {
+            free_blocks.resize(size_class + 1);
+        }
+        free_blocks[size_class].push_back({first_edge, size});
+    }
+
+    struct FreeBlock
+    {
+        EdgeIterator first_edge;
+        unsigned size;
+    };
+
     struct Node
     {
         // index of the first edge
@@ -319,6 +524,8 @@ template <typename EdgeDataT> class DynamicGraph
 
     std::vector<Node> node_array;
     DeallocatingVector<Edge> edge_list;
+    // blocks of dummy slots by size class, entries can be stale and are checked on reuse
+    std::vector<std::vector<FreeBlock>> free_blocks;
 };
 }
 }
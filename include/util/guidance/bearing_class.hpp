@@ -7,6 +7,7 @@
 #include <vector>
 
 #include <boost/functional/hash.hpp>
+#include <boost/range/iterator_range.hpp>
 
 #include "util/typedefs.hpp"
 
@@ -36,6 +37,12 @@ namespace util
 namespace guidance
 {
 
+// the bearings of a bearing class as the data facade stores them
+using BearingRange = boost::iterator_range<const DiscreteBearing *>;
+
+// index of the bearing closest to the given one, the bearings must not be empty
+std::size_t findMatchingBearing(const BearingRange bearings, const double bearing);
+
 class BearingClass
 {
   public:
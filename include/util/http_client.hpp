@@ -0,0 +1,32 @@
+#ifndef UTIL_HTTP_CLIENT_HPP
+#define UTIL_HTTP_CLIENT_HPP
+
+#include <boost/optional.hpp>
+
+#include <chrono>
+#include <string>
+
+namespace osrm
+{
+namespace util
+{
+
+struct HttpResponse
+{
+    unsigned status;
+    // empty if the response has none
+    std::string content_type;
+    std::string body;
+};
+
+// Sends a plain HTTP/1.0 GET request for target, a path with its query, and reads the response
+// until the server closes the connection. Returns none if the server cannot be reached, does not
+// answer completely within timeout, or the response is cut off or malformed.
+boost::optional<HttpResponse> HttpGet(const std::string &host,
+                                      const std::string &port,
+                                      const std::string &target,
+                                      const std::chrono::milliseconds timeout);
+}
+}
+
+#endif // UTIL_HTTP_CLIENT_HPP
@@ -0,0 +1,645 @@
+#ifndef INTERMEDIATE_FILE_HPP
+#define INTERMEDIATE_FILE_HPP
+
+#include "util/buffered_file.hpp"
+#include "util/exception.hpp"
+#include "util/make_unique.hpp"
+
+#include <boost/filesystem/path.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Compressed intermediate files start with this magic, followed by the size of the header, the
+// header and the frames. The header holds the first bytes of the data uncompressed, so writers
+// can still go back and fill in counts at the front of the file. Every frame is compressed on
+// its own as the raw size, the compressed size and the zlib stream of up to FILE_BLOCK_SIZE
+// bytes, which lets the frames be compressed and decompressed in parallel.
+namespace detail
+{
+const constexpr std::array<char, 8> INTERMEDIATE_FILE_MAGIC = {
+    {'O', 'S', 'R', 'M', 'Z', 'F', 'R', '1'}};
+const constexpr std::size_t INTERMEDIATE_HEADER_SIZE = 64;
+const constexpr std::size_t INTERMEDIATE_PREAMBLE_SIZE =
+    INTERMEDIATE_FILE_MAGIC.size() + sizeof(std::uint32_t) + INTERMEDIATE_HEADER_SIZE;
+
+// number of frames that are compressed or decompressed at the same time
+inline std::size_t ParallelFrames()
+{
+    return std::max(2u, std::min(8u, std::thread::hardware_concurrency()));
+}
+
+struct FrameHeader
+{
+    std::uint32_t raw_size;
+    std::uint32_t compressed_size;
+};
+
+inline std::vector<char> CompressFrame(const std::vector<char> &raw)
+{
+    uLongf compressed_size = compressBound(raw.size());
+    std::vector<char> frame(sizeof(FrameHeader) + compressed_size);
+    if (compress2(reinterpret_cast<Bytef *>(frame.data() + sizeof(FrameHeader)),
+                  &compressed_size,
+                  reinterpret_cast<const Bytef *>(raw.data()),
+                  raw.size(),
+                  Z_BEST_SPEED) != Z_OK)
+    {
+        throw exception("Could not compress a frame of an intermediate file");
+    }
+    const FrameHeader header{static_cast<std::uint32_t>(raw.size()),
+                             static_cast<std::uint32_t>(compressed_size)};
+    std::memcpy(frame.data(), &header, sizeof(header));
+    frame.resize(sizeof(FrameHeader) + compressed_size);
+    return frame;
+}
+
+inline std::vector<char> DecompressFrame(const std::vector<char> &compressed,
+                                         const std::uint32_t raw_size)
+{
+    std::vector<char> raw(raw_size);
+    uLongf size = raw_size;
+    if (uncompress(reinterpret_cast<Bytef *>(raw.data()),
+                   &size,
+                   reinterpret_cast<const Bytef *>(compressed.data()),
+                   compressed.size()) != Z_OK ||
+        size != raw_size)
+    {
+        throw exception("Could not decompress a frame of an intermediate file");
+    }
+    return raw;
+}
+
+// Compresses full blocks on background threads while the next ones are filled
+class CompressingWriter final : public std::streambuf
+{
+  public:
+    explicit CompressingWriter(const boost::filesystem::path &path_)
+        : path(path_), file(std::fopen(path.string().c_str(), "wb")), block(FILE_BLOCK_SIZE),
+          header(), in_block(false), patching(false), saved_fill(0), frame_bytes(0)
+    {
+        if (!file)
+        {
+            throw exception("Could not open " + path.string() + " for writing");
+        }
+        // the preamble is written on close, once the header is final
+        const std::array<char, INTERMEDIATE_PREAMBLE_SIZE> preamble{};
+        Write(preamble.data(), preamble.size());
+        setp(header.data(), header.data() + header.size());
+    }
+
+    ~CompressingWriter() override
+    {
+        if (file)
+        {
+            try
+            {
+                Close();
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+
+    // Writes all frames and the preamble, throws if any of it could not be written
+    void Close()
+    {
+        if (!file)
+        {
+            return;
+        }
+        EndPatch();
+        std::uint32_t header_size = header.size();
+        if (in_block)
+        {
+            CompressBlock();
+        }
+        else
+        {
+            header_size = pptr() - pbase();
+        }
+        while (!pending_frames.empty())
+        {
+            WriteFrame();
+        }
+
+        if (SeekFile(file, 0, SEEK_SET) != 0)
+        {
+            throw exception("Could not write to " + path.string());
+        }
+        Write(INTERMEDIATE_FILE_MAGIC.data(), INTERMEDIATE_FILE_MAGIC.size());
+        Write(reinterpret_cast<const char *>(&header_size), sizeof(header_size));
+        Write(header.data(), header.size());
+
+        const auto closed = std::fclose(file);
+        file = nullptr;
+        if (closed != 0)
+        {
+            throw exception("Could not write to " + path.string());
+        }
+    }
+
+  protected:
+    int_type overflow(const int_type character) override
+    {
+        // patches can only rewrite the header
+        if (patching)
+        {
+            return traits_type::eof();
+        }
+        if (in_block)
+        {
+            CompressBlock();
+        }
+        in_block = true;
+        setp(block.data(), block.data() + block.size());
+        if (!traits_type::eq_int_type(character, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(character);
+            pbump(1);
+        }
+        return traits_type::not_eof(character);
+    }
+
+    pos_type seekoff(const off_type offset,
+                     const std::ios_base::seekdir direction,
+                     const std::ios_base::openmode which) override
+    {
+        if (!(which & std::ios_base::out) || !file)
+        {
+            return pos_type(off_type(-1));
+        }
+        if (direction == std::ios_base::beg)
+        {
+            return seekpos(pos_type(offset), which);
+        }
+        const auto origin = direction == std::ios_base::cur ? Position() : EndPosition();
+        return seekpos(pos_type(origin + offset), which);
+    }
+
+    // Only the header and the end of the data can be sought to
+    pos_type seekpos(const pos_type position, const std::ios_base::openmode which) override
+    {
+        const std::int64_t target = position;
+        if (!(which & std::ios_base::out) || !file)
+        {
+            return pos_type(off_type(-1));
+        }
+        if (target == Position())
+        {
+            return position;
+        }
+        if (target == EndPosition())
+        {
+            EndPatch();
+            return position;
+        }
+
+        const std::int64_t header_end = in_block ? header.size() : EndPosition();
+        if (target < 0 || target >= header_end)
+        {
+            return pos_type(off_type(-1));
+        }
+        if (!patching)
+        {
+            saved_fill = pptr() - pbase();
+            patching = true;
+        }
+        setp(header.data() + target, header.data() + header_end);
+        return position;
+    }
+
+  private:
+    std::int64_t Position() const
+    {
+        if (patching || !in_block)
+        {
+            return pptr() - header.data();
+        }
+        return header.size() + frame_bytes + (pptr() - pbase());
+    }
+
+    std::int64_t EndPosition() const
+    {
+        if (!patching)
+        {
+            return Position();
+        }
+        return in_block ? header.size() + frame_bytes + saved_fill : saved_fill;
+    }
+
+    void EndPatch()
+    {
+        if (!patching)
+        {
+            return;
+        }
+        patching = false;
+        if (in_block)
+        {
+            setp(block.data(), block.data() + block.size());
+        }
+        else
+        {
+            setp(header.data(), header.data() + header.size());
+        }
+        pbump(saved_fill);
+    }
+
+    // hands the filled part of the block to a background thread
+    void CompressBlock()
+    {
+        const std::size_t size = pptr() - pbase();
+        if (size == 0)
+        {
+            return;
+        }
+        if (pending_frames.size() >= ParallelFrames())
+        {
+            WriteFrame();
+        }
+        pending_frames.push_back(
+            std::async(std::launch::async, [raw = std::vector<char>(pbase(), pptr())] {
+                return CompressFrame(raw);
+            }));
+        frame_bytes += size;
+        setp(block.data(), block.data() + block.size());
+    }
+
+    // writes the oldest frame, rethrows the error of its compression
+    void WriteFrame()
+    {
+        const auto frame = pending_frames.front().get();
+        pending_frames.pop_front();
+        Write(frame.data(), frame.size());
+    }
+
+    void Write(const char *data, const std::size_t size)
+    {
+        if (std::fwrite(data, 1, size, file) != size)
+        {
+            throw exception("Could not write to " + path.string());
+        }
+    }
+
+    const boost::filesystem::path path;
+    std::FILE *file;
+    std::vector<char> block;
+    std::array<char, INTERMEDIATE_HEADER_SIZE> header;
+    std::deque<std::future<std::vector<char>>> pending_frames;
+    // the header is full and the data goes to the blocks
+    bool in_block;
+    // the header is rewritten, saved_fill is the fill of the header or block before
+    bool patching;
+    std::int64_t saved_fill;
+    // raw size of all frames handed to the background threads
+    std::int64_t frame_bytes;
+};
+
+// Reads the frames in order and decompresses the next ones on background threads while the
+// current one is consumed
+class DecompressingReader final : public std::streambuf
+{
+  public:
+    explicit DecompressingReader(const boost::filesystem::path &path_)
+        : path(path_), file(std::fopen(path.string().c_str(), "rb")), current_offset(0),
+          next_frame(0), header_size(0)
+    {
+        if (!file)
+        {
+            throw exception("Could not open " + path.string() + " for reading");
+        }
+        std::array<char, INTERMEDIATE_FILE_MAGIC.size()> magic;
+        std::array<char, INTERMEDIATE_HEADER_SIZE> header;
+        if (!Read(magic.data(), magic.size()) || magic != INTERMEDIATE_FILE_MAGIC ||
+            !Read(reinterpret_cast<char *>(&header_size), sizeof(header_size)) ||
+            header_size > header.size() || !Read(header.data(), header.size()))
+        {
+            std::fclose(file);
+            throw exception("Could not read the preamble of " + path.string());
+        }
+        current.assign(header.begin(), header.begin() + header_size);
+        setg(current.data(), current.data(), current.data() + current.size());
+    }
+
+    ~DecompressingReader() override
+    {
+        DiscardFrames();
+        if (file)
+        {
+            std::fclose(file);
+        }
+    }
+
+  protected:
+    int_type underflow() override
+    {
+        if (gptr() < egptr())
+        {
+            return traits_type::to_int_type(*gptr());
+        }
+        if (!NextFrame())
+        {
+            return traits_type::eof();
+        }
+        return traits_type::to_int_type(*gptr());
+    }
+
+    pos_type seekoff(const off_type offset,
+                     const std::ios_base::seekdir direction,
+                     const std::ios_base::openmode which) override
+    {
+        if (!(which & std::ios_base::in) || direction == std::ios_base::end)
+        {
+            return pos_type(off_type(-1));
+        }
+        const std::int64_t position = current_offset + (gptr() - eback());
+        if (direction == std::ios_base::cur && offset == 0)
+        {
+            return pos_type(position);
+        }
+        return seekpos(pos_type(direction == std::ios_base::cur ? position + offset : offset),
+                       which);
+    }
+
+    pos_type seekpos(const pos_type position, const std::ios_base::openmode which) override
+    {
+        const std::int64_t target = position;
+        if (!(which & std::ios_base::in) || target < 0)
+        {
+            return pos_type(off_type(-1));
+        }
+        if (target >= current_offset &&
+            target <= current_offset + static_cast<std::int64_t>(current.size()))
+        {
+            setg(eback(), eback() + (target - current_offset), egptr());
+            return position;
+        }
+
+        DiscardFrames();
+        if (target < header_size)
+        {
+            // the header is not kept around, so the file is read from the start again
+            Rewind();
+            setg(eback(), eback() + target, egptr());
+            return position;
+        }
+
+        // frames that were not read yet are skipped by their headers
+        std::size_t index = 0;
+        while (LoadFrameInfo(index) &&
+               frames[index].raw_offset + frames[index].raw_size <= target)
+        {
+            ++index;
+        }
+        next_frame = index;
+        if (!NextFrame())
+        {
+            // at or past the end of the data
+            const auto end = frames.empty() ? header_size
+                                            : frames.back().raw_offset + frames.back().raw_size;
+            if (target != end)
+            {
+                return pos_type(off_type(-1));
+            }
+            current.clear();
+            current_offset = end;
+            setg(current.data(), current.data(), current.data());
+            return position;
+        }
+        setg(eback(), eback() + (target - current_offset), egptr());
+        return position;
+    }
+
+  private:
+    struct FrameInfo
+    {
+        std::int64_t raw_offset;
+        std::int64_t file_offset;
+        std::uint32_t raw_size;
+        std::uint32_t compressed_size;
+    };
+
+    // makes the frame after the current one current, false at the end of the data
+    bool NextFrame()
+    {
+        QueueFrames();
+        if (pending_frames.empty())
+        {
+            return false;
+        }
+        const auto &info = frames[next_frame - pending_frames.size()];
+        current = pending_frames.front().get();
+        pending_frames.pop_front();
+        current_offset = info.raw_offset;
+        setg(current.data(), current.data(), current.data() + current.size());
+        QueueFrames();
+        return true;
+    }
+
+    // starts to decompress the next frames, up to ParallelFrames at once
+    void QueueFrames()
+    {
+        while (pending_frames.size() < ParallelFrames() && LoadFrameInfo(next_frame))
+        {
+            const auto &info = frames[next_frame];
+            std::vector<char> compressed(info.compressed_size);
+            if (SeekFile(file, info.file_offset + sizeof(FrameHeader), SEEK_SET) != 0 ||
+                !Read(compressed.data(), compressed.size()))
+            {
+                throw exception(path.string() + " is truncated, run the preprocessing again");
+            }
+            pending_frames.push_back(std::async(
+                std::launch::async,
+                [compressed = std::move(compressed), raw_size = info.raw_size] {
+                    return DecompressFrame(compressed, raw_size);
+                }));
+            ++next_frame;
+        }
+    }
+
+    // reads the headers of the frames up to index, false if there is no such frame
+    bool LoadFrameInfo(const std::size_t index)
+    {
+        while (frames.size() <= index)
+        {
+            FrameInfo info;
+            info.raw_offset = header_size;
+            info.file_offset = INTERMEDIATE_PREAMBLE_SIZE;
+            if (!frames.empty())
+            {
+                const auto &last = frames.back();
+                info.raw_offset = last.raw_offset + last.raw_size;
+                info.file_offset = last.file_offset + sizeof(FrameHeader) + last.compressed_size;
+            }
+
+            FrameHeader header;
+            if (SeekFile(file, info.file_offset, SEEK_SET) != 0)
+            {
+                return false;
+            }
+            const auto size = std::fread(&header, 1, sizeof(header), file);
+            if (size == 0 && std::feof(file))
+            {
+                return false;
+            }
+            if (size != sizeof(header))
+            {
+                throw exception(path.string() + " is truncated, run the preprocessing again");
+            }
+            info.raw_size = header.raw_size;
+            info.compressed_size = header.compressed_size;
+            frames.push_back(info);
+        }
+        return true;
+    }
+
+    void Rewind()
+    {
+        std::array<char, INTERMEDIATE_HEADER_SIZE> header;
+        if (SeekFile(file, INTERMEDIATE_PREAMBLE_SIZE - header.size(), SEEK_SET) != 0 ||
+            !Read(header.data(), header.size()))
+        {
+            throw exception("Could not read the preamble of " + path.string());
+        }
+        current.assign(header.begin(), header.begin() + header_size);
+        current_offset = 0;
+        next_frame = 0;
+        setg(current.data(), current.data(), current.data() + current.size());
+    }
+
+    void DiscardFrames()
+    {
+        for (auto &frame : pending_frames)
+        {
+            frame.wait();
+        }
+        pending_frames.clear();
+    }
+
+    bool Read(char *data, const std::size_t size)
+    {
+        return std::fread(data, 1, size, file) == size;
+    }
+
+    const boost::filesystem::path path;
+    std::FILE *file;
+    std::vector<char> current;
+    // offset of current in the data
+    std::int64_t current_offset;
+    std::vector<FrameInfo> frames;
+    std::deque<std::future<std::vector<char>>> pending_frames;
+    // index of the frame queued next
+    std::size_t next_frame;
+    std::uint32_t header_size;
+};
+}
+
+// True if the file was written by a compressing IntermediateOutputFile
+inline bool IsCompressedFile(const boost::filesystem::path &path)
+{
+    std::array<char, detail::INTERMEDIATE_FILE_MAGIC.size()> magic;
+    std::FILE *file = std::fopen(path.string().c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    const bool complete = std::fread(magic.data(), 1, magic.size(), file) == magic.size();
+    std::fclose(file);
+    return complete && magic == detail::INTERMEDIATE_FILE_MAGIC;
+}
+
+// Output file for the intermediates that are passed from osrm-extract to osrm-contract and
+// osrm-datastore (.ebg, .edges, .geometry, .nodes). If compress is set, the data is compressed
+// in frames on several threads; that makes the files a fraction of their size for transfers,
+// at the cost of only being able to seek within the first bytes of the data afterwards. Errors
+// throw util::exception like BufferedOutputFile.
+class IntermediateOutputFile final : public std::ostream
+{
+  public:
+    IntermediateOutputFile(const boost::filesystem::path &path, const bool compress)
+        : std::ostream(nullptr)
+    {
+        if (compress)
+        {
+            compressing_buffer = util::make_unique<detail::CompressingWriter>(path);
+            rdbuf(compressing_buffer.get());
+        }
+        else
+        {
+            buffer = util::make_unique<detail::DoubleBufferedWriter>(path, false);
+            rdbuf(buffer.get());
+        }
+        exceptions(std::ios_base::badbit);
+    }
+
+    void close()
+    {
+        if (compressing_buffer)
+        {
+            compressing_buffer->Close();
+        }
+        else
+        {
+            buffer->Close();
+        }
+    }
+
+  private:
+    std::unique_ptr<detail::DoubleBufferedWriter> buffer;
+    std::unique_ptr<detail::CompressingWriter> compressing_buffer;
+};
+
+// Reads both the compressed and the plain intermediates, see IntermediateOutputFile. The
+// compressed frames are decompressed in parallel ahead of the reads. Like std::ifstream it fails
+// the stream instead of throwing if the file can not be opened.
+class IntermediateInputFile final : public std::istream
+{
+  public:
+    explicit IntermediateInputFile(const boost::filesystem::path &path) : std::istream(nullptr)
+    {
+        if (IsCompressedFile(path))
+        {
+            buffer = util::make_unique<detail::DecompressingReader>(path);
+        }
+        else
+        {
+            auto plain_buffer = util::make_unique<detail::ReadAheadReader>(path);
+            const bool is_open = plain_buffer->IsOpen();
+            buffer = std::move(plain_buffer);
+            rdbuf(buffer.get());
+            if (!is_open)
+            {
+                setstate(std::ios_base::failbit);
+            }
+            return;
+        }
+        rdbuf(buffer.get());
+    }
+
+  private:
+    std::unique_ptr<std::streambuf> buffer;
+};
+}
+}
+
+#endif // INTERMEDIATE_FILE_HPP
@@ -1,6 +1,7 @@
 #ifndef OSRM_INCLUDE_UTIL_IO_HPP_
 #define OSRM_INCLUDE_UTIL_IO_HPP_
 
+#include "util/buffered_file.hpp"
 #include "util/simple_logger.hpp"
 
 #include <boost/filesystem.hpp>
@@ -42,7 +43,7 @@ inline bool readAndCheckFingerprint(std::istream &stream)
 template <typename simple_type>
 bool serializeVector(const std::string &filename, const std::vector<simple_type> &data)
 {
-    std::ofstream stream(filename, std::ios::binary);
+    BufferedOutputFile stream(filename);
 
     writeFingerprint(stream);
 
@@ -50,7 +51,8 @@ bool serializeVector(const std::string &filename, const std::vector<simple_type>
     stream.write(reinterpret_cast<const char *>(&count), sizeof(count));
     if (!data.empty())
         stream.write(reinterpret_cast<const char *>(&data[0]), sizeof(simple_type) * count);
-    return static_cast<bool>(stream);
+    stream.close();
+    return true;
 }
 
 template <typename simple_type>
@@ -66,7 +68,7 @@ bool serializeVector(std::ostream &stream, const std::vector<simple_type> &data)
 template <typename simple_type>
 bool deserializeVector(const std::string &filename, std::vector<simple_type> &data)
 {
-    std::ifstream stream(filename, std::ios::binary);
+    BufferedInputFile stream(filename);
 
     if (!readAndCheckFingerprint(stream))
         return false;
@@ -95,7 +97,7 @@ template <typename simple_type>
 bool serializeVectorIntoAdjacencyArray(const std::string &filename,
                                        const std::vector<std::vector<simple_type>> &data)
 {
-    std::ofstream out_stream(filename, std::ios::binary);
+    BufferedOutputFile out_stream(filename);
     std::vector<std::uint32_t> offsets;
     offsets.reserve(data.size() + 1);
     std::uint64_t current_offset = 0;
@@ -116,35 +118,22 @@ bool serializeVectorIntoAdjacencyArray(const std::string &filename,
     if (!serializeVector(out_stream, all_data))
         return false;
 
-    return static_cast<bool>(out_stream);
+    out_stream.close();
+    return true;
 }
 
-template <typename simple_type, std::size_t WRITE_BLOCK_BUFFER_SIZE = 1024>
-bool serializeVector(std::ofstream &out_stream, const stxxl::vector<simple_type> &data)
+// use a BufferedOutputFile, the entries are written one by one
+template <typename simple_type>
+bool serializeVector(std::ostream &out_stream, const stxxl::vector<simple_type> &data)
 {
     const std::uint64_t size = data.size();
     out_stream.write(reinterpret_cast<const char *>(&size), sizeof(size));
 
-    simple_type write_buffer[WRITE_BLOCK_BUFFER_SIZE];
-    std::size_t buffer_len = 0;
-
     for (const auto entry : data)
     {
-        write_buffer[buffer_len++] = entry;
-
-        if (buffer_len >= WRITE_BLOCK_BUFFER_SIZE)
-        {
-            out_stream.write(reinterpret_cast<const char *>(write_buffer),
-                             WRITE_BLOCK_BUFFER_SIZE * sizeof(simple_type));
-            buffer_len = 0;
-        }
+        out_stream.write(reinterpret_cast<const char *>(&entry), sizeof(simple_type));
     }
 
-    // write remaining entries
-    if (buffer_len > 0)
-        out_stream.write(reinterpret_cast<const char *>(write_buffer),
-                         buffer_len * sizeof(simple_type));
-
     return static_cast<bool>(out_stream);
 }
 
@@ -153,7 +142,7 @@ bool deserializeAdjacencyArray(const std::string &filename,
                                std::vector<std::uint32_t> &offsets,
                                std::vector<simple_type>& data)
 {
-    std::ifstream in_stream(filename, std::ios::binary);
+    BufferedInputFile in_stream(filename);
 
     if (!deserializeVector(in_stream, offsets))
         return false;
@@ -170,8 +159,7 @@ bool deserializeAdjacencyArray(const std::string &filename,
 
 inline bool serializeFlags(const boost::filesystem::path &path, const std::vector<bool> &flags)
 {
-    // TODO this should be replaced with a FILE-based write using error checking
-    std::ofstream flag_stream(path.string(), std::ios::binary);
+    BufferedOutputFile flag_stream(path);
 
     writeFingerprint(flag_stream);
 
@@ -193,13 +181,14 @@ inline bool serializeFlags(const boost::filesystem::path &path, const std::vecto
     }
     SimpleLogger().Write() << "Wrote " << number_of_bits << " bits in " << chunk_count
                            << " chunks (Flags).";
-    return static_cast<bool>(flag_stream);
+    flag_stream.close();
+    return true;
 }
 
 inline bool deserializeFlags(const boost::filesystem::path &path, std::vector<bool> &flags)
 {
     SimpleLogger().Write() << "Reading flags from " << path;
-    std::ifstream flag_stream(path.string(), std::ios::binary);
+    BufferedInputFile flag_stream(path);
 
     if (!readAndCheckFingerprint(flag_stream))
         return false;
@@ -33,8 +33,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <variant/variant.hpp>
 
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -127,6 +129,107 @@ using Value = mapbox::util::variant<String,
                                     False,
                                     Null>;
 
+/**
+ * Key-value pairs of an Object.
+ *
+ * Objects in responses hold a handful of keys, so the pairs are kept in one vector that is searched
+ * linearly: building it costs a single allocation instead of one node per key, and the keys keep
+ * their insertion order. Provides the parts of the std::unordered_map interface used on objects.
+ */
+class ObjectValues
+{
+    using Storage = std::vector<std::pair<std::string, Value>>;
+
+  public:
+    using key_type = std::string;
+    using mapped_type = Value;
+    using value_type = Storage::value_type;
+    using size_type = Storage::size_type;
+    using iterator = Storage::iterator;
+    using const_iterator = Storage::const_iterator;
+
+    ObjectValues() = default;
+
+    // Like the maps the first of duplicate keys wins
+    ObjectValues(std::initializer_list<value_type> pairs)
+    {
+        entries.reserve(pairs.size());
+        for (const auto &pair : pairs)
+        {
+            if (find(pair.first) == entries.end())
+            {
+                entries.push_back(pair);
+            }
+        }
+    }
+
+    // Lookups compare against the key as given, string literals are not copied into a std::string
+    template <typename KeyT> Value &operator[](const KeyT &key)
+    {
+        const auto iter = find(key);
+        if (iter != entries.end())
+        {
+            return iter->second;
+        }
+        entries.emplace_back(std::string(key), Value{});
+        return entries.back().second;
+    }
+
+    template <typename KeyT> Value &at(const KeyT &key)
+    {
+        const auto iter = find(key);
+        if (iter == entries.end())
+        {
+            throw std::out_of_range("json::Object has no key " + std::string(key));
+        }
+        return iter->second;
+    }
+
+    template <typename KeyT> const Value &at(const KeyT &key) const
+    {
+        const auto iter = find(key);
+        if (iter == entries.end())
+        {
+            throw std::out_of_range("json::Object has no key " + std::string(key));
+        }
+        return iter->second;
+    }
+
+    template <typename KeyT> iterator find(const KeyT &key)
+    {
+        return std::find_if(entries.begin(), entries.end(), [&key](const value_type &entry) {
+            return entry.first == key;
+        });
+    }
+
+    template <typename KeyT> const_iterator find(const KeyT &key) const
+    {
+        return std::find_if(entries.begin(), entries.end(), [&key](const value_type &entry) {
+            return entry.first == key;
+        });
+    }
+
+    template <typename KeyT> size_type count(const KeyT &key) const
+    {
+        return find(key) == entries.end() ? 0 : 1;
+    }
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+    const_iterator cbegin() const { return entries.cbegin(); }
+    const_iterator cend() const { return entries.cend(); }
+
+    size_type size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    void reserve(const size_type size) { entries.reserve(size); }
+    void clear() { entries.clear(); }
+
+  private:
+    Storage entries;
+};
+
 /**
  * Typed Object.
  *
@@ -134,7 +237,7 @@ using Value = mapbox::util::variant<String,
  */
 struct Object
 {
-    std::unordered_map<std::string, Value> values;
+    ObjectValues values;
 };
 
 /**
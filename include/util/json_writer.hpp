@@ -0,0 +1,190 @@
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+
+#include "util/json_renderer.hpp"
+
+#include "osrm/json_container.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+namespace json
+{
+
+/**
+ * Streams JSON directly into a character buffer without building a json::Object first.
+ *
+ * Separators are emitted automatically, callers only have to balance the Start and End calls
+ * and to emit a Key before every value that is a member of an object. Existing json::Value
+ * trees can be embedded at any value position.
+ */
+class Writer
+{
+  public:
+    explicit Writer(std::vector<char> &out_) : out(out_) {}
+
+    void StartObject()
+    {
+        Separate();
+        out.push_back('{');
+        scopes.push_back(true);
+    }
+
+    void EndObject()
+    {
+        BOOST_ASSERT(!scopes.empty());
+        scopes.pop_back();
+        out.push_back('}');
+    }
+
+    void StartArray()
+    {
+        Separate();
+        out.push_back('[');
+        scopes.push_back(true);
+    }
+
+    void EndArray()
+    {
+        BOOST_ASSERT(!scopes.empty());
+        scopes.pop_back();
+        out.push_back(']');
+    }
+
+    void Key(const std::string &key)
+    {
+        Separate();
+        out.push_back('\"');
+        out.insert(out.end(), key.begin(), key.end());
+        out.push_back('\"');
+        out.push_back(':');
+        after_key = true;
+    }
+
+    void String(const std::string &value)
+    {
+        Separate();
+        ArrayRenderer{out}(json::String{value});
+    }
+
+    void Number(const double value)
+    {
+        Separate();
+        ArrayRenderer{out}(json::Number{value});
+    }
+
+    // Renders value / 10 like Number would, without going through a string stream.
+    // Durations and weights are stored in tenth of their unit, which makes this the hot path.
+    void NumberInTenths(const std::int64_t value)
+    {
+        Separate();
+        auto magnitude = value;
+        if (magnitude < 0)
+        {
+            out.push_back('-');
+            magnitude = -magnitude;
+        }
+        AppendInteger(magnitude / 10);
+        if (magnitude % 10 != 0)
+        {
+            out.push_back('.');
+            out.push_back(static_cast<char>('0' + magnitude % 10));
+        }
+    }
+
+    void Bool(const bool value)
+    {
+        Separate();
+        if (value)
+        {
+            ArrayRenderer{out}(json::True{});
+        }
+        else
+        {
+            ArrayRenderer{out}(json::False{});
+        }
+    }
+
+    void Null()
+    {
+        Separate();
+        ArrayRenderer{out}(json::Null{});
+    }
+
+    void Value(const json::Value &value)
+    {
+        Separate();
+        mapbox::util::apply_visitor(ArrayRenderer(out), value);
+    }
+
+    // A string value whose characters are appended piece by piece, e.g. while they are encoded.
+    // The pieces are not escaped, they may only contain characters that need no escaping.
+    void StartString()
+    {
+        Separate();
+        out.push_back('\"');
+    }
+
+    void StringPiece(const std::string &piece)
+    {
+        out.insert(out.end(), piece.begin(), piece.end());
+    }
+
+    void EndString() { out.push_back('\"'); }
+
+    // Embeds a complete value that another Writer rendered, e.g. into a separate buffer
+    void Raw(const std::vector<char> &value)
+    {
+        Separate();
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+  private:
+    void Separate()
+    {
+        if (after_key)
+        {
+            after_key = false;
+            return;
+        }
+        if (!scopes.empty())
+        {
+            if (!scopes.back())
+            {
+                out.push_back(',');
+            }
+            scopes.back() = false;
+        }
+    }
+
+    void AppendInteger(std::int64_t value)
+    {
+        char digits[20];
+        auto position = sizeof(digits);
+        do
+        {
+            digits[--position] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        out.insert(out.end(), digits + position, digits + sizeof(digits));
+    }
+
+    std::vector<char> &out;
+    // one entry per open object or array, true until its first element was written
+    std::vector<bool> scopes;
+    bool after_key = false;
+};
+
+} // namespace json
+} // namespace util
+} // namespace osrm
+
+#endif // JSON_WRITER_HPP
@@ -0,0 +1,85 @@
+#ifndef LRU_CACHE_HPP
+#define LRU_CACHE_HPP
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace osrm
+{
+namespace util
+{
+
+// Fixed capacity cache that evicts the least recently used entry first.
+// Not thread-safe, callers have to synchronize access themselves.
+template <typename Key, typename Value, typename Hash = std::hash<Key>> class LRUCache
+{
+  public:
+    explicit LRUCache(const std::size_t capacity_) : capacity(capacity_)
+    {
+        index.reserve(capacity);
+    }
+
+    // Returns the cached value and marks it as most recently used, nullptr if there is none.
+    // The pointer stays valid until the entry gets evicted.
+    const Value *Get(const Key &key)
+    {
+        const auto iter = index.find(key);
+        if (iter == index.end())
+        {
+            return nullptr;
+        }
+        items.splice(items.begin(), items, iter->second);
+        return &iter->second->second;
+    }
+
+    void Put(const Key &key, Value value)
+    {
+        if (capacity == 0)
+        {
+            return;
+        }
+
+        const auto iter = index.find(key);
+        if (iter != index.end())
+        {
+            iter->second->second = std::move(value);
+            items.splice(items.begin(), items, iter->second);
+            return;
+        }
+
+        if (items.size() == capacity)
+        {
+            index.erase(items.back().first);
+            items.pop_back();
+        }
+        items.emplace_front(key, std::move(value));
+        index.emplace(key, items.begin());
+        BOOST_ASSERT(items.size() == index.size());
+    }
+
+    std::size_t Size() const { return items.size(); }
+
+    void Clear()
+    {
+        items.clear();
+        index.clear();
+    }
+
+  private:
+    using ItemList = std::list<std::pair<Key, Value>>;
+
+    const std::size_t capacity;
+    // most recently used first
+    ItemList items;
+    std::unordered_map<Key, typename ItemList::iterator, Hash> index;
+};
+}
+}
+
+#endif // LRU_CACHE_HPP
@@ -0,0 +1,102 @@
+#ifndef MEMORY_USAGE_HPP
+#define MEMORY_USAGE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace osrm
+{
+namespace util
+{
+
+// Peak resident memory of the process in bytes, since the start or the last call of
+// ResetPeakMemoryUsage where the system supports it. 0 if the system does not tell.
+inline std::size_t PeakMemoryUsage()
+{
+#ifdef __linux__
+    // VmHWM can be reset, unlike the maximum of getrusage
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);)
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            return std::stoull(line.substr(6)) * 1024;
+        }
+    }
+#endif
+#ifndef _WIN32
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef __APPLE__
+        return usage.ru_maxrss;
+#else
+        return usage.ru_maxrss * std::size_t{1024};
+#endif
+    }
+#endif
+    return 0;
+}
+
+// Bytes of the mapped memory at address that are resident in RAM, asked for page by page. Only
+// supported on Linux, 0 elsewhere and for memory that is not mapped.
+inline std::size_t ResidentSize(const void *address, const std::size_t size)
+{
+#ifdef __linux__
+    if (size == 0)
+    {
+        return 0;
+    }
+    const auto page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const auto begin = reinterpret_cast<std::uintptr_t>(address);
+    const auto end = begin + size;
+    const auto first_page = begin / page_size * page_size;
+    std::vector<unsigned char> residency((end - first_page + page_size - 1) / page_size);
+    if (mincore(reinterpret_cast<void *>(first_page), end - first_page, residency.data()) != 0)
+    {
+        return 0;
+    }
+
+    // the first and the last page may only partly belong to the memory
+    std::size_t resident_size = 0;
+    for (std::size_t page = 0; page < residency.size(); ++page)
+    {
+        if (residency[page] & 1)
+        {
+            const auto page_begin = first_page + page * page_size;
+            resident_size += std::min(end, page_begin + page_size) - std::max(begin, page_begin);
+        }
+    }
+    return resident_size;
+#else
+    (void)address;
+    (void)size;
+    return 0;
+#endif
+}
+
+// Starts a new measurement of the peak memory, the peak is reset to the current usage.
+// Only supported on Linux, elsewhere the peak stays the one of the whole process.
+inline void ResetPeakMemoryUsage()
+{
+#ifdef __linux__
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+#endif
+}
+}
+}
+
+#endif // MEMORY_USAGE_HPP
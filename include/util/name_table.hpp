@@ -1,30 +1,86 @@
 #ifndef OSRM_UTIL_NAME_TABLE_HPP
 #define OSRM_UTIL_NAME_TABLE_HPP
 
-#include "util/range_table.hpp"
 #include "util/shared_memory_vector_wrapper.hpp"
+#include "util/string_view.hpp"
 
+#include <boost/assert.hpp>
+
+#include <cstdint>
+#include <limits>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 namespace osrm
 {
 namespace util
 {
 
+// Reads the names, destinations and pronunciations of a .names file, stores every distinct string
+// once in chars and the position of the string of each name id in offsets and lengths. Strings
+// are at most 255 characters long, the same limit as for the RangeTable of the file.
+void ReadInternedNames(const std::string &filename,
+                       std::vector<std::uint32_t> &offsets,
+                       std::vector<std::uint8_t> &lengths,
+                       std::vector<char> &chars);
+
 // While this could, theoretically, hold any names in the fitting format,
 // the NameTable allows access to a part of the Datafacade to allow
 // processing based on name indices.
-class NameTable
+//
+// Lookups are two array reads, equal strings share their characters so equal views point to the
+// same memory.
+template <bool UseSharedMemory> class BasicNameTable
 {
-  private:
-    // FIXME should this use shared memory
-    RangeTable<16, false> m_name_table;
-    ShM<char, false>::vector m_names_char_list;
-
   public:
-    NameTable(const std::string &filename);
-    std::string GetNameForID(const unsigned name_id) const;
+    BasicNameTable() = default;
+
+    template <bool enabled = UseSharedMemory>
+    explicit BasicNameTable(
+        const typename std::enable_if<!enabled, std::string>::type &filename)
+    {
+        ReadInternedNames(filename, offsets, lengths, chars);
+    }
+
+    template <bool enabled = UseSharedMemory>
+    void reset(typename std::enable_if<enabled, std::uint32_t>::type *offsets_ptr,
+               std::uint8_t *lengths_ptr,
+               const std::size_t number_of_names,
+               char *chars_ptr,
+               const std::size_t number_of_chars)
+    {
+        offsets.reset(offsets_ptr, number_of_names);
+        lengths.reset(lengths_ptr, number_of_names);
+        chars.reset(chars_ptr, number_of_chars);
+    }
+
+    StringView GetNameViewForID(const unsigned name_id) const
+    {
+        // datasets without names, see osrm-datastore --weights-only, have empty names only
+        if (name_id >= lengths.size() || lengths[name_id] == 0)
+        {
+            return {};
+        }
+        BOOST_ASSERT(offsets[name_id] + lengths[name_id] <= chars.size());
+        const auto first = chars.data() + offsets[name_id];
+        return {first, first + lengths[name_id]};
+    }
+
+    std::string GetNameForID(const unsigned name_id) const
+    {
+        return ToString(GetNameViewForID(name_id));
+    }
+
+    std::size_t GetNumberOfNames() const { return offsets.size(); }
+
+  private:
+    typename ShM<std::uint32_t, UseSharedMemory>::vector offsets;
+    typename ShM<std::uint8_t, UseSharedMemory>::vector lengths;
+    typename ShM<char, UseSharedMemory>::vector chars;
 };
+
+using NameTable = BasicNameTable<false>;
 } // namespace util
 } // namespace osrm
 
@@ -21,7 +21,7 @@ struct NodeBasedEdgeData
         : distance(INVALID_EDGE_WEIGHT), edge_id(SPECIAL_NODEID),
           name_id(std::numeric_limits<unsigned>::max()), access_restricted(false), reversed(false),
           roundabout(false), travel_mode(TRAVEL_MODE_INACCESSIBLE),
-          lane_description_id(INVALID_LANE_DESCRIPTIONID)
+          lane_description_id(INVALID_LANE_DESCRIPTIONID), classes(EDGE_CLASS_NONE)
     {
     }
 
@@ -36,7 +36,8 @@ struct NodeBasedEdgeData
                       const LaneDescriptionID lane_description_id)
         : distance(distance), edge_id(edge_id), name_id(name_id),
           access_restricted(access_restricted), reversed(reversed), roundabout(roundabout),
-          startpoint(startpoint), travel_mode(travel_mode), lane_description_id(lane_description_id)
+          startpoint(startpoint), travel_mode(travel_mode),
+          lane_description_id(lane_description_id), classes(EDGE_CLASS_NONE)
     {
     }
 
@@ -50,6 +51,7 @@ struct NodeBasedEdgeData
     extractor::TravelMode travel_mode : 4;
     LaneDescriptionID lane_description_id;
     extractor::guidance::RoadClassificationData road_classification;
+    extractor::EdgeClasses classes;
 
     bool IsCompatibleTo(const NodeBasedEdgeData &other) const
     {
@@ -57,7 +59,7 @@ struct NodeBasedEdgeData
                (roundabout == other.roundabout) && (startpoint == other.startpoint) &&
                (access_restricted == other.access_restricted) &&
                (travel_mode == other.travel_mode) &&
-               (road_classification == other.road_classification);
+               (road_classification == other.road_classification) && (classes == other.classes);
     }
 };
 
@@ -84,6 +86,7 @@ NodeBasedDynamicGraphFromEdges(NodeID number_of_nodes,
             output_edge.data.startpoint = input_edge.startpoint;
             output_edge.data.road_classification = input_edge.road_classification;
             output_edge.data.lane_description_id = input_edge.lane_description_id;
+            output_edge.data.classes = input_edge.classes;
         });
 
     tbb::parallel_sort(edges_list.begin(), edges_list.end());
@@ -0,0 +1,41 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <cstddef>
+
+namespace osrm
+{
+namespace util
+{
+namespace numa
+{
+
+// Upper bound of the nodes the functions below address, further nodes are ignored
+static const constexpr unsigned MAX_NUMA_NODES = 32;
+
+// Number of NUMA nodes of this machine, 1 if the platform exposes no NUMA topology
+unsigned GetNumberOfNodes();
+
+// Restricts the calling thread to the CPUs of a NUMA node. Returns false if it could not.
+bool PinThreadToNode(const unsigned node);
+
+// Restricts the calling thread to a single CPU of a NUMA node, the index-th one modulo the
+// number of CPUs of the node. Without a NUMA topology node 0 has all CPUs of the process.
+// Returns false if it could not.
+bool PinThreadToCPU(const unsigned node, const unsigned index);
+
+// Node the calling thread was pinned to with PinThreadToNode or PinThreadToCPU, 0 for all other
+// threads
+unsigned GetThreadNode();
+
+// Spreads the pages of a page aligned memory range round-robin over the first number_of_nodes
+// nodes. Pages that are already resident are moved. Returns false if it could not.
+bool InterleaveMemory(void *address, const std::size_t size, const unsigned number_of_nodes);
+
+// Places the pages of a page aligned memory range on a single node, see InterleaveMemory
+bool BindMemory(void *address, const std::size_t size, const unsigned node);
+}
+}
+}
+
+#endif // NUMA_HPP
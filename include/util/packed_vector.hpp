@@ -4,7 +4,11 @@
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/typedefs.hpp"
 
-#include <cmath>
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
 namespace osrm
@@ -13,108 +17,87 @@ namespace util
 {
 
 /**
- * Since OSM node IDs are (at the time of writing) not quite yet overflowing 32 bits, and
- * will predictably be containable within 33 bits for a long time, the following packs
- * 64-bit OSM IDs as 33-bit numbers within a 64-bit vector.
+ * Stores values of type T with Bits bits each in a vector of 64-bit words. Element i occupies the
+ * bits [i * Bits, (i + 1) * Bits) counted from the least significant bit of the first word, so an
+ * element spans at most two words. Higher bits of incoming values are dropped.
  *
- * NOTE: this type is templated for future use, but will require a slight refactor to
- * configure BITSIZE and ELEMSIZE
+ * With UseSharedMemory the words are provided by reset() and elements can be written in any
+ * order with set(), the prior content of the words does not matter.
  */
-template <typename T, bool UseSharedMemory = false> class PackedVector
+template <typename T, std::size_t Bits, bool UseSharedMemory = false> class PackedVector
 {
-    static const constexpr std::size_t BITSIZE = 33;
-    static const constexpr std::size_t ELEMSIZE = 64;
-    static const constexpr std::size_t PACKSIZE = BITSIZE * ELEMSIZE;
+    static_assert(Bits > 0 && Bits < 64, "Bits has to be in [1, 63]");
+
+    static const constexpr std::size_t WORD_BITS = 64;
+    static const constexpr std::uint64_t MASK = (std::uint64_t{1} << Bits) - 1;
 
   public:
+    using value_type = T;
+
     /**
-     * Returns the size of the packed vector datastructure with `elements` packed elements (the size
-     * of
-     * its underlying uint64 vector)
+     * Returns the number of 64-bit words needed to store `elements` packed elements
      */
     inline static std::size_t elements_to_blocks(std::size_t elements)
     {
-        return std::ceil(static_cast<double>(elements) * BITSIZE / ELEMSIZE);
+        return (elements * Bits + WORD_BITS - 1) / WORD_BITS;
     }
 
-    void push_back(T incoming_node_id)
+    void push_back(const T value)
     {
-        std::uint64_t node_id = static_cast<std::uint64_t>(incoming_node_id);
-
-        // mask incoming values, just in case they are > bitsize
-        const std::uint64_t incoming_mask = static_cast<std::uint64_t>(pow(2, BITSIZE)) - 1;
-        node_id = node_id & incoming_mask;
-
-        const std::size_t available = (PACKSIZE - BITSIZE * num_elements) % ELEMSIZE;
-
-        if (available == 0)
-        {
-            // insert ID at the left side of this element
-            std::uint64_t at_left = node_id << (ELEMSIZE - BITSIZE);
-
-            add_last_elem(at_left);
-        }
-        else if (available >= BITSIZE)
-        {
-            // insert ID somewhere in the middle of this element; ID can be contained
-            // entirely within one element
-            const std::uint64_t shifted = node_id << (available - BITSIZE);
-
-            replace_last_elem(vec_back() | shifted);
-        }
-        else
-        {
-            // ID will be split between the end of this element and the beginning
-            // of the next element
-            const std::uint64_t left = node_id >> (BITSIZE - available);
-
-            std::uint64_t right = node_id << (ELEMSIZE - (BITSIZE - available));
-
-            replace_last_elem(vec_back() | left);
-            add_last_elem(right);
-        }
-
+        const auto blocks = elements_to_blocks(num_elements + 1);
+        grow(blocks);
+        BOOST_ASSERT(blocks <= vec.size());
+        set_bits(num_elements, static_cast<std::uint64_t>(value));
         num_elements++;
     }
 
-    T at(const std::size_t &a_index) const
+    void set(const std::size_t index, const T value)
     {
-        BOOST_ASSERT(a_index < num_elements);
-
-        const std::size_t pack_group = trunc(a_index / ELEMSIZE);
-        const std::size_t pack_index = (a_index + ELEMSIZE) % ELEMSIZE;
-        const std::size_t left_index = (PACKSIZE - BITSIZE * pack_index) % ELEMSIZE;
+        BOOST_ASSERT(index < num_elements);
+        set_bits(index, static_cast<std::uint64_t>(value));
+    }
 
-        const bool back_half = pack_index >= BITSIZE;
-        const std::size_t index = pack_group * BITSIZE + trunc(pack_index / BITSIZE) +
-                                  trunc((pack_index - back_half) / 2);
+    T at(const std::size_t index) const
+    {
+        BOOST_ASSERT(index < num_elements);
+        return to_value(get_bits(index));
+    }
 
-        BOOST_ASSERT(index < vec.size());
-        const std::uint64_t elem = static_cast<std::uint64_t>(vec.at(index));
+    T operator[](const std::size_t index) const { return at(index); }
 
-        if (left_index == 0)
-        {
-            // ID is at the far left side of this element
-            return T{elem >> (ELEMSIZE - BITSIZE)};
-        }
-        else if (left_index >= BITSIZE)
+    // Decodes the elements [first, first + count) into out, one word load per word instead of
+    // one or two per element
+    template <typename OutputIterator>
+    void decode(const std::size_t first, const std::size_t count, OutputIterator out) const
+    {
+        BOOST_ASSERT(first + count <= num_elements);
+        if (count == 0)
         {
-            // ID is entirely contained within this element
-            const std::uint64_t at_right = elem >> (left_index - BITSIZE);
-            const std::uint64_t left_mask = static_cast<std::uint64_t>(pow(2, BITSIZE)) - 1;
-            return T{at_right & left_mask};
+            return;
         }
-        else
-        {
-            // ID is split between this and the next element
-            const std::uint64_t left_mask = static_cast<std::uint64_t>(pow(2, left_index)) - 1;
-            const std::uint64_t left_side = (elem & left_mask) << (BITSIZE - left_index);
 
-            BOOST_ASSERT(index < vec.size() - 1);
-            const std::uint64_t next_elem = static_cast<std::uint64_t>(vec.at(index + 1));
-
-            const std::uint64_t right_side = next_elem >> (ELEMSIZE - (BITSIZE - left_index));
-            return T{left_side | right_side};
+        std::size_t word = first * Bits / WORD_BITS;
+        std::size_t offset = first * Bits % WORD_BITS;
+        std::uint64_t current = vec[word];
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::uint64_t value = current >> offset;
+            offset += Bits;
+            if (offset >= WORD_BITS)
+            {
+                offset -= WORD_BITS;
+                ++word;
+                if (offset > 0)
+                {
+                    current = vec[word];
+                    value |= current << (Bits - offset);
+                }
+                else if (i + 1 < count)
+                {
+                    current = vec[word];
+                }
+            }
+            *out++ = to_value(value & MASK);
         }
     }
 
@@ -136,58 +119,78 @@ template <typename T, bool UseSharedMemory = false> class PackedVector
     template <bool enabled = UseSharedMemory>
     void set_number_of_entries(typename std::enable_if<enabled, std::size_t>::type count)
     {
+        BOOST_ASSERT(elements_to_blocks(count) <= vec.size());
         num_elements = count;
     }
 
-    std::size_t capacity() const
-    {
-        return std::floor(static_cast<double>(vec.capacity()) * ELEMSIZE / BITSIZE);
-    }
+    std::size_t capacity() const { return vec.capacity() * WORD_BITS / Bits; }
 
   private:
     typename util::ShM<std::uint64_t, UseSharedMemory>::vector vec;
 
     std::size_t num_elements = 0;
 
-    signed cursor = -1;
-
-    template <bool enabled = UseSharedMemory>
-    void replace_last_elem(typename std::enable_if<enabled, std::uint64_t>::type last_elem)
+    // strong typedefs like OSMNodeID are aggregates and need braces, which do not narrow
+    template <typename U = T>
+    static typename std::enable_if<std::is_arithmetic<U>::value, T>::type
+    to_value(const std::uint64_t bits)
     {
-        vec[cursor] = last_elem;
+        return static_cast<T>(bits);
     }
 
-    template <bool enabled = UseSharedMemory>
-    void replace_last_elem(typename std::enable_if<!enabled, std::uint64_t>::type last_elem)
+    template <typename U = T>
+    static typename std::enable_if<!std::is_arithmetic<U>::value, T>::type
+    to_value(const std::uint64_t bits)
     {
-        vec.back() = last_elem;
+        return T{bits};
     }
 
-    template <bool enabled = UseSharedMemory>
-    void add_last_elem(typename std::enable_if<enabled, std::uint64_t>::type last_elem)
+    std::uint64_t get_bits(const std::size_t index) const
     {
-        vec[cursor + 1] = last_elem;
-        cursor++;
+        const std::size_t word = index * Bits / WORD_BITS;
+        const std::size_t offset = index * Bits % WORD_BITS;
+
+        std::uint64_t value = vec[word] >> offset;
+        if (offset + Bits > WORD_BITS)
+        {
+            value |= vec[word + 1] << (WORD_BITS - offset);
+        }
+        return value & MASK;
     }
 
-    template <bool enabled = UseSharedMemory>
-    void add_last_elem(typename std::enable_if<!enabled, std::uint64_t>::type last_elem)
+    void set_bits(const std::size_t index, std::uint64_t value)
     {
-        vec.push_back(last_elem);
+        const std::size_t word = index * Bits / WORD_BITS;
+        const std::size_t offset = index * Bits % WORD_BITS;
+        value &= MASK;
+
+        vec[word] = (vec[word] & ~(MASK << offset)) | (value << offset);
+        if (offset + Bits > WORD_BITS)
+        {
+            const std::size_t shift = WORD_BITS - offset;
+            vec[word + 1] = (vec[word + 1] & ~(MASK >> shift)) | (value >> shift);
+        }
     }
 
     template <bool enabled = UseSharedMemory>
-    std::uint64_t vec_back(typename std::enable_if<enabled>::type * = nullptr)
+    void grow(const typename std::enable_if<!enabled, std::size_t>::type blocks)
     {
-        return vec[cursor];
+        if (vec.size() < blocks)
+        {
+            vec.resize(blocks, 0);
+        }
     }
 
     template <bool enabled = UseSharedMemory>
-    std::uint64_t vec_back(typename std::enable_if<!enabled>::type * = nullptr)
+    void grow(const typename std::enable_if<enabled, std::size_t>::type)
     {
-        return vec.back();
     }
 };
+
+// OSM node IDs are (at the time of writing) not quite yet overflowing 32 bits, and will
+// predictably be containable within 33 bits for a long time
+template <bool UseSharedMemory = false>
+using PackedOSMNodeIDs = PackedVector<OSMNodeID, 33, UseSharedMemory>;
 }
 }
 
@@ -0,0 +1,75 @@
+#ifndef QUANTIZED_RECTANGLES_HPP
+#define QUANTIZED_RECTANGLES_HPP
+
+#include "util/rectangle.hpp"
+
+#include "osrm/coordinate.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace osrm
+{
+namespace util
+{
+
+// Bounding boxes stored relative to an enclosing frame, e.g. the boxes of the children of an
+// r-tree node relative to the box of the node. Each bound takes one byte, the frame is divided
+// into QUANTIZATION_STEPS steps per axis and minima are rounded down, maxima up. A quantized box
+// therefore always contains the box it was made from and distances to it are lower bounds.
+//
+// The boxes are passed as one array per bound so that all of them are evaluated at once.
+namespace quantized_rectangles
+{
+const constexpr std::int64_t QUANTIZATION_STEPS = 255;
+
+inline std::uint8_t quantizeMin(const std::int32_t value,
+                                const std::int32_t frame_min,
+                                const std::int32_t frame_max)
+{
+    const std::int64_t extent = std::int64_t{frame_max} - frame_min;
+    BOOST_ASSERT(frame_min <= value && value <= frame_max);
+    return extent == 0 ? 0 : (std::int64_t{value} - frame_min) * QUANTIZATION_STEPS / extent;
+}
+
+inline std::uint8_t quantizeMax(const std::int32_t value,
+                                const std::int32_t frame_min,
+                                const std::int32_t frame_max)
+{
+    const std::int64_t extent = std::int64_t{frame_max} - frame_min;
+    BOOST_ASSERT(frame_min <= value && value <= frame_max);
+    return extent == 0
+               ? 0
+               : ((std::int64_t{value} - frame_min) * QUANTIZATION_STEPS + extent - 1) / extent;
+}
+
+struct QuantizedRectangles
+{
+    const std::uint8_t *min_lons;
+    const std::uint8_t *max_lons;
+    const std::uint8_t *min_lats;
+    const std::uint8_t *max_lats;
+};
+
+// Lower bounds of RectangleInt2D::GetMinSquaredDist(location) for count rectangles of a frame.
+// Uses AVX2 if the CPU supports it.
+void minSquaredDistances(const RectangleInt2D &frame,
+                         const QuantizedRectangles &rectangles,
+                         const std::size_t count,
+                         const Coordinate location,
+                         std::uint64_t *distances);
+
+// Whether the quantized rectangles intersect the given one, true for some rectangles that only
+// intersect after quantization
+void intersects(const RectangleInt2D &frame,
+                const QuantizedRectangles &rectangles,
+                const std::size_t count,
+                const RectangleInt2D &rectangle,
+                bool *results);
+}
+}
+}
+
+#endif // QUANTIZED_RECTANGLES_HPP
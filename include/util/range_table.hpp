@@ -174,6 +174,12 @@ template <unsigned BLOCK_SIZE, bool USE_SHARED_MEMORY> class RangeTable
         return irange(begin_idx, end_idx);
     }
 
+    // ids past the last range of the table return empty ranges, up to the end of the last block
+    inline unsigned GetNumberOfRanges() const
+    {
+        return diff_blocks.empty() ? 0 : diff_blocks.size() * (BLOCK_SIZE + 1) - 1;
+    }
+
   private:
     inline unsigned PrefixSumAtIndex(int index, const BlockT &block) const;
 
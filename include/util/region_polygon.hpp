@@ -0,0 +1,53 @@
+#ifndef UTIL_REGION_POLYGON_HPP
+#define UTIL_REGION_POLYGON_HPP
+
+#include "util/coordinate.hpp"
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Region read from a polygon file in the osmosis format: a name line, then rings that each
+// consist of a name line, one "lon lat" line per vertex and an END line, followed by a final END
+// line. Rings whose name starts with '!' are holes. Rings must not overlap each other.
+class RegionPolygon
+{
+  public:
+    explicit RegionPolygon(const boost::filesystem::path &polygon_path);
+
+    bool Contains(const Coordinate coordinate) const;
+
+    std::size_t GetNumberOfRings() const { return number_of_rings; }
+
+  private:
+    struct Segment
+    {
+        Coordinate first;
+        Coordinate second;
+        bool is_hole;
+    };
+
+    void AddRing(const std::vector<Coordinate> &ring, const bool is_hole);
+    void BuildBands();
+
+    std::vector<Segment> segments;
+    std::size_t number_of_rings;
+
+    // bounding box of all rings
+    std::int32_t min_lon, max_lon, min_lat, max_lat;
+
+    // the segments that cross each horizontal band of the bounding box
+    std::int64_t band_height;
+    std::vector<std::size_t> band_offsets;
+    std::vector<std::uint32_t> band_segments;
+};
+}
+}
+
+#endif // UTIL_REGION_POLYGON_HPP
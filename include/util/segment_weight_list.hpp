@@ -0,0 +1,112 @@
+#ifndef SEGMENT_WEIGHT_LIST_HPP
+#define SEGMENT_WEIGHT_LIST_HPP
+
+#include "util/shared_memory_vector_wrapper.hpp"
+#include "util/strided_view.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+/**
+ * The weights of the geometry segments of all time slots and metrics, either as EdgeWeight or as
+ * 16 bit integers. Segments are short, so their weights rarely need more than 16 bits;
+ * osrm-contract records in the time slot header whether all of them fit and the facades then
+ * store the narrow form, which halves the memory of every overlay. INVALID_EDGE_WEIGHT has a
+ * narrow value of its own.
+ */
+template <bool UseSharedMemory = false> class SegmentWeightList
+{
+  public:
+    using WideVector = typename util::ShM<EdgeWeight, UseSharedMemory>::vector;
+    using NarrowVector = typename util::ShM<std::uint16_t, UseSharedMemory>::vector;
+
+    static const constexpr std::uint16_t NARROW_INVALID_WEIGHT =
+        std::numeric_limits<std::uint16_t>::max();
+
+    static bool FitsNarrow(const EdgeWeight weight)
+    {
+        return weight == INVALID_EDGE_WEIGHT || (weight >= 0 && weight < NARROW_INVALID_WEIGHT);
+    }
+
+    static std::uint16_t Narrow(const EdgeWeight weight)
+    {
+        BOOST_ASSERT(FitsNarrow(weight));
+        return weight == INVALID_EDGE_WEIGHT ? NARROW_INVALID_WEIGHT
+                                             : static_cast<std::uint16_t>(weight);
+    }
+
+    static EdgeWeight Widen(const std::uint16_t weight)
+    {
+        return weight == NARROW_INVALID_WEIGHT ? INVALID_EDGE_WEIGHT
+                                               : static_cast<EdgeWeight>(weight);
+    }
+
+    void Reset(WideVector wide_)
+    {
+        wide = std::move(wide_);
+        narrow = NarrowVector();
+    }
+
+    void Reset(NarrowVector narrow_)
+    {
+        narrow = std::move(narrow_);
+        wide = WideVector();
+    }
+
+    bool IsNarrow() const { return !narrow.empty(); }
+
+    std::size_t size() const { return IsNarrow() ? narrow.size() : wide.size(); }
+
+    bool empty() const { return size() == 0; }
+
+    std::size_t SizeInBytes() const
+    {
+        return IsNarrow() ? narrow.size() * sizeof(std::uint16_t)
+                          : wide.size() * sizeof(EdgeWeight);
+    }
+
+    EdgeWeight operator[](const std::size_t index) const
+    {
+        BOOST_ASSERT(index < size());
+        return IsNarrow() ? Widen(narrow[index]) : wide[index];
+    }
+
+    // The wide form is viewed in place, the narrow one is widened into a copy
+    StridedView<EdgeWeight> View(const std::size_t begin, const std::size_t count) const
+    {
+        BOOST_ASSERT(begin + count <= size());
+        if (count == 0)
+        {
+            return {};
+        }
+        if (!IsNarrow())
+        {
+            return {&wide[begin], count};
+        }
+        std::vector<EdgeWeight> weights(count);
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            weights[index] = Widen(narrow[begin + index]);
+        }
+        return StridedView<EdgeWeight>(std::move(weights));
+    }
+
+  private:
+    WideVector wide;
+    NarrowVector narrow;
+};
+}
+}
+
+#endif // SEGMENT_WEIGHT_LIST_HPP
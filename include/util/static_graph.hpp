@@ -65,6 +65,46 @@ template <typename EdgeDataT, bool UseSharedMemory = false> class StaticGraph
         return irange(BeginEdges(node), EndEdges(node));
     }
 
+    // The edges of node that a search in the given direction relaxes. This needs the edges of
+    // every node to be ordered into forward only, bidirectional and backward only edges, see
+    // IsDirectionOrdered, which halves the edges a search of a hierarchy touches.
+    EdgeRange GetDirectedEdgeRange(const NodeID node, const bool forward_direction) const
+    {
+        const auto begin = BeginEdges(node);
+        const auto end = EndEdges(node);
+        if (forward_direction)
+        {
+            return irange(begin, PartitionPoint(begin, end, [](const EdgeDataT &data) {
+                              return static_cast<bool>(data.forward);
+                          }));
+        }
+        return irange(PartitionPoint(begin,
+                                     end,
+                                     [](const EdgeDataT &data) { return !data.backward; }),
+                      end);
+    }
+
+    // Whether GetDirectedEdgeRange can be used, false for graphs of older osrm-contract versions
+    bool IsDirectionOrdered() const
+    {
+        for (const auto node : irange(0u, number_of_nodes))
+        {
+            bool seen_not_forward = false;
+            bool seen_backward = false;
+            for (const auto edge : GetAdjacentEdgeRange(node))
+            {
+                const auto &data = edge_array[edge].data;
+                if ((data.forward && seen_not_forward) || (!data.backward && seen_backward))
+                {
+                    return false;
+                }
+                seen_not_forward = seen_not_forward || !data.forward;
+                seen_backward = seen_backward || data.backward;
+            }
+        }
+        return true;
+    }
+
     template <typename ContainerT> StaticGraph(const int nodes, const ContainerT &graph)
     {
         BOOST_ASSERT(std::is_sorted(const_cast<ContainerT &>(graph).begin(),
@@ -188,6 +228,27 @@ template <typename EdgeDataT, bool UseSharedMemory = false> class StaticGraph
     }
 
   private:
+    // first edge of [first, last) whose data does not satisfy the predicate, which holds for a
+    // prefix of the edges
+    template <typename PredicateT>
+    EdgeIterator
+    PartitionPoint(EdgeIterator first, EdgeIterator last, const PredicateT predicate) const
+    {
+        while (first < last)
+        {
+            const auto middle = first + (last - first) / 2;
+            if (predicate(edge_array[middle].data))
+            {
+                first = middle + 1;
+            }
+            else
+            {
+                last = middle;
+            }
+        }
+        return first;
+    }
+
     NodeIterator number_of_nodes;
     EdgeIterator number_of_edges;
 
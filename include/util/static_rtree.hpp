@@ -7,6 +7,7 @@
 #include "util/exception.hpp"
 #include "util/hilbert_value.hpp"
 #include "util/integer_range.hpp"
+#include "util/quantized_rectangles.hpp"
 #include "util/rectangle.hpp"
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/typedefs.hpp"
@@ -18,16 +19,24 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/optional.hpp>
 
+#include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
 #include <tbb/parallel_sort.h>
 
 #include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstring>
 #include <limits>
 #include <memory>
+#include <numeric>
 #include <queue>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 // An extended alignment is implementation-defined, so use compiler attributes
@@ -60,10 +69,13 @@ class StaticRTree
     using EdgeData = EdgeDataT;
     using CoordinateList = CoordinateListT;
 
-    static_assert(LEAF_PAGE_SIZE >= sizeof(uint32_t) + sizeof(EdgeDataT), "page size is too small");
+    static_assert(LEAF_PAGE_SIZE >= sizeof(uint32_t) + sizeof(Rectangle) + sizeof(EdgeDataT) +
+                                        sizeof(std::uint16_t),
+                  "page size is too small");
     static_assert(((LEAF_PAGE_SIZE - 1) & LEAF_PAGE_SIZE) == 0, "page size is not a power of 2");
     static constexpr std::uint32_t LEAF_NODE_SIZE =
-        (LEAF_PAGE_SIZE - sizeof(uint32_t) - sizeof(Rectangle)) / sizeof(EdgeDataT);
+        (LEAF_PAGE_SIZE - sizeof(uint32_t) - sizeof(Rectangle)) /
+        (sizeof(EdgeDataT) + sizeof(std::uint16_t));
 
     struct CandidateSegment
     {
@@ -71,6 +83,14 @@ class StaticRTree
         EdgeDataT data;
     };
 
+    // Restricts a search to the directions of segments within range degrees of bearing, like
+    // bearing::CheckInBounds does for their rounded bearings
+    struct BearingFilter
+    {
+        int bearing;
+        int range;
+    };
+
     struct TreeIndex
     {
         TreeIndex() : index(0), is_leaf(false) {}
@@ -79,24 +99,107 @@ class StaticRTree
         std::uint32_t is_leaf : 1;
     };
 
+    // What the segments below a node or leaf have to offer to restricted searches: the bearing
+    // sectors their enabled directions fall into and whether any of them is of a big component
+    struct Contents
+    {
+        bearing::SectorMask sectors = 0;
+        bool big_components = false;
+
+        Contents &operator|=(const Contents &other)
+        {
+            sectors |= other.sectors;
+            big_components = big_components || other.big_components;
+            return *this;
+        }
+    };
+
+    // The children of a node are stored consecutively starting at first_child. Their bounding
+    // boxes are kept in the node, quantized relative to the bounding box of the node, so that a
+    // search never reads a child node or leaf page just to get its bounds. The same goes for the
+    // contents of the children.
     struct TreeNode
     {
         TreeNode() : child_count(0) {}
         std::uint32_t child_count;
+        TreeIndex first_child;
         Rectangle minimum_bounding_rectangle;
-        TreeIndex children[BRANCHING_FACTOR];
+        std::uint8_t child_min_lons[BRANCHING_FACTOR];
+        std::uint8_t child_max_lons[BRANCHING_FACTOR];
+        std::uint8_t child_min_lats[BRANCHING_FACTOR];
+        std::uint8_t child_max_lats[BRANCHING_FACTOR];
+        bearing::SectorMask child_sectors[BRANCHING_FACTOR];
+        std::uint8_t child_big_components[BRANCHING_FACTOR];
+
+        quantized_rectangles::QuantizedRectangles ChildRectangles() const
+        {
+            return {child_min_lons, child_max_lons, child_min_lats, child_max_lats};
+        }
+
+        Contents ChildContents(const std::uint32_t child) const
+        {
+            Contents contents;
+            contents.sectors = child_sectors[child];
+            contents.big_components = child_big_components[child] != 0;
+            return contents;
+        }
+
+        void SetChildContents(const std::uint32_t child, const Contents &contents)
+        {
+            child_sectors[child] = contents.sectors;
+            child_big_components[child] = contents.big_components;
+        }
+
+        Contents AllContents() const
+        {
+            Contents contents;
+            for (std::uint32_t child = 0; child < child_count; ++child)
+            {
+                contents |= ChildContents(child);
+            }
+            return contents;
+        }
+
+        void QuantizeChild(const std::uint32_t child, const Rectangle &rectangle)
+        {
+            const auto &frame = minimum_bounding_rectangle;
+            child_min_lons[child] = quantized_rectangles::quantizeMin(
+                static_cast<std::int32_t>(rectangle.min_lon),
+                static_cast<std::int32_t>(frame.min_lon),
+                static_cast<std::int32_t>(frame.max_lon));
+            child_max_lons[child] = quantized_rectangles::quantizeMax(
+                static_cast<std::int32_t>(rectangle.max_lon),
+                static_cast<std::int32_t>(frame.min_lon),
+                static_cast<std::int32_t>(frame.max_lon));
+            child_min_lats[child] = quantized_rectangles::quantizeMin(
+                static_cast<std::int32_t>(rectangle.min_lat),
+                static_cast<std::int32_t>(frame.min_lat),
+                static_cast<std::int32_t>(frame.max_lat));
+            child_max_lats[child] = quantized_rectangles::quantizeMax(
+                static_cast<std::int32_t>(rectangle.max_lat),
+                static_cast<std::int32_t>(frame.min_lat),
+                static_cast<std::int32_t>(frame.max_lat));
+        }
     };
 
+    // bearings holds the rounded bearing from u to v of each object, so that bearing filtered
+    // searches do not compute it for every object of the leaves they explore
     struct ALIGNED(LEAF_PAGE_SIZE) LeafNode
     {
-        LeafNode() : object_count(0), objects() {}
+        LeafNode() : object_count(0), objects(), bearings() {}
         std::uint32_t object_count;
         Rectangle minimum_bounding_rectangle;
         std::array<EdgeDataT, LEAF_NODE_SIZE> objects;
+        std::array<std::uint16_t, LEAF_NODE_SIZE> bearings;
     };
     static_assert(sizeof(LeafNode) == LEAF_PAGE_SIZE, "LeafNode size does not fit the page size");
 
   private:
+    // number of leaves that are packed in parallel and written to the leaf file at once
+    static constexpr std::uint32_t LEAF_BLOCK_SIZE = 1024;
+    // Queries of a batched Nearest that one worker answers with a shared leaf cache
+    static constexpr std::size_t NEAREST_BATCH_CHUNK_SIZE = 256;
+
     struct WrappedInputElement
     {
         explicit WrappedInputElement(const uint64_t _hilbert_value,
@@ -200,133 +303,112 @@ class StaticRTree
                 }
             });
 
-        // open leaf file
-        boost::filesystem::ofstream leaf_node_file(leaf_node_filename, std::ios::binary);
-
         // sort the hilbert-value representatives
         tbb::parallel_sort(input_wrapper_vector.begin(), input_wrapper_vector.end());
-        std::vector<TreeNode> tree_nodes_in_level;
 
-        // pack M elements into leaf node, write to leaf file and add child index to the parent node
-        uint64_t wrapped_element_index = 0;
-        for (std::uint32_t node_index = 0; wrapped_element_index < element_count; ++node_index)
+        const uint64_t number_of_leaves = (element_count + LEAF_NODE_SIZE - 1) / LEAF_NODE_SIZE;
+        std::vector<Rectangle> leaf_rectangles(number_of_leaves);
+        std::vector<Contents> leaf_contents(number_of_leaves);
+
+        // pack M elements into leaf node, the leaves of a block are packed in parallel
+        // and written to the leaf file at once
         {
-            TreeNode current_node;
-            for (std::uint32_t leaf_index = 0;
-                 leaf_index < BRANCHING_FACTOR && wrapped_element_index < element_count;
-                 ++leaf_index)
+            boost::filesystem::ofstream leaf_node_file(leaf_node_filename, std::ios::binary);
+            std::vector<char> leaf_block(LEAF_BLOCK_SIZE * sizeof(LeafNode));
+            for (uint64_t block_begin = 0; block_begin < number_of_leaves;
+                 block_begin += LEAF_BLOCK_SIZE)
             {
-                LeafNode current_leaf;
-                Rectangle &rectangle = current_leaf.minimum_bounding_rectangle;
-                for (std::uint32_t object_index = 0;
-                     object_index < LEAF_NODE_SIZE && wrapped_element_index < element_count;
-                     ++object_index, ++wrapped_element_index)
-                {
-                    const std::uint32_t input_object_index =
-                        input_wrapper_vector[wrapped_element_index].m_array_index;
-                    const EdgeDataT &object = input_data_vector[input_object_index];
-
-                    current_leaf.object_count += 1;
-                    current_leaf.objects[object_index] = object;
-
-                    Coordinate projected_u{
-                        web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.u]})};
-                    Coordinate projected_v{
-                        web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.v]})};
-
-                    BOOST_ASSERT(std::abs(toFloating(projected_u.lon).operator double()) <= 180.);
-                    BOOST_ASSERT(std::abs(toFloating(projected_u.lat).operator double()) <= 180.);
-                    BOOST_ASSERT(std::abs(toFloating(projected_v.lon).operator double()) <= 180.);
-                    BOOST_ASSERT(std::abs(toFloating(projected_v.lat).operator double()) <= 180.);
-
-                    rectangle.min_lon =
-                        std::min(rectangle.min_lon, std::min(projected_u.lon, projected_v.lon));
-                    rectangle.max_lon =
-                        std::max(rectangle.max_lon, std::max(projected_u.lon, projected_v.lon));
-
-                    rectangle.min_lat =
-                        std::min(rectangle.min_lat, std::min(projected_u.lat, projected_v.lat));
-                    rectangle.max_lat =
-                        std::max(rectangle.max_lat, std::max(projected_u.lat, projected_v.lat));
-
-                    BOOST_ASSERT(rectangle.IsValid());
-                }
-
-                // append the leaf node to the current tree node
-                current_node.child_count += 1;
-                current_node.children[leaf_index] =
-                    TreeIndex{node_index * BRANCHING_FACTOR + leaf_index, true};
-                current_node.minimum_bounding_rectangle.MergeBoundingBoxes(
-                    current_leaf.minimum_bounding_rectangle);
-
-                // write leaf_node to leaf node file
-                leaf_node_file.write((char *)&current_leaf, sizeof(current_leaf));
+                const uint64_t block_end =
+                    std::min<uint64_t>(number_of_leaves, block_begin + LEAF_BLOCK_SIZE);
+                tbb::parallel_for(
+                    tbb::blocked_range<uint64_t>(block_begin, block_end),
+                    [&](const tbb::blocked_range<uint64_t> &range) {
+                        for (auto leaf_index = range.begin(), end = range.end();
+                             leaf_index != end;
+                             ++leaf_index)
+                        {
+                            LeafNode current_leaf;
+                            const auto first_element = leaf_index * LEAF_NODE_SIZE;
+                            const auto last_element =
+                                std::min<uint64_t>(element_count, first_element + LEAF_NODE_SIZE);
+                            leaf_contents[leaf_index] =
+                                PackLeaf(input_data_vector,
+                                         input_wrapper_vector.begin() + first_element,
+                                         input_wrapper_vector.begin() + last_element,
+                                         current_leaf);
+                            leaf_rectangles[leaf_index] = current_leaf.minimum_bounding_rectangle;
+                            std::memcpy(&leaf_block[(leaf_index - block_begin) * sizeof(LeafNode)],
+                                        &current_leaf,
+                                        sizeof(LeafNode));
+                        }
+                    });
+                leaf_node_file.write(leaf_block.data(),
+                                     (block_end - block_begin) * sizeof(LeafNode));
             }
-
-            tree_nodes_in_level.emplace_back(current_node);
         }
-        leaf_node_file.flush();
-        leaf_node_file.close();
 
-        std::uint32_t processing_level = 0;
-        while (1 < tree_nodes_in_level.size())
+        // number of tree nodes per level, from the parents of the leaves up to the root
+        std::vector<uint64_t> level_sizes{
+            std::max<uint64_t>(1, (number_of_leaves + BRANCHING_FACTOR - 1) / BRANCHING_FACTOR)};
+        while (level_sizes.back() > 1)
         {
-            std::vector<TreeNode> tree_nodes_in_next_level;
-            std::uint32_t processed_tree_nodes_in_level = 0;
-            while (processed_tree_nodes_in_level < tree_nodes_in_level.size())
-            {
-                TreeNode parent_node;
-                // pack BRANCHING_FACTOR elements into tree_nodes each
-                for (std::uint32_t current_child_node_index = 0;
-                     current_child_node_index < BRANCHING_FACTOR;
-                     ++current_child_node_index)
-                {
-                    if (processed_tree_nodes_in_level < tree_nodes_in_level.size())
-                    {
-                        TreeNode &current_child_node =
-                            tree_nodes_in_level[processed_tree_nodes_in_level];
-                        // add tree node to parent entry
-                        parent_node.children[current_child_node_index] =
-                            TreeIndex{m_search_tree.size(), false};
-                        m_search_tree.emplace_back(current_child_node);
-                        // merge MBRs
-                        parent_node.minimum_bounding_rectangle.MergeBoundingBoxes(
-                            current_child_node.minimum_bounding_rectangle);
-                        // increase counters
-                        ++parent_node.child_count;
-                        ++processed_tree_nodes_in_level;
-                    }
-                }
-                tree_nodes_in_next_level.emplace_back(parent_node);
-            }
-            tree_nodes_in_level.swap(tree_nodes_in_next_level);
-            ++processing_level;
+            level_sizes.push_back((level_sizes.back() + BRANCHING_FACTOR - 1) / BRANCHING_FACTOR);
         }
-        BOOST_ASSERT_MSG(tree_nodes_in_level.size() == 1, "tree broken, more than one root node");
-        // last remaining entry is the root node, store it
-        m_search_tree.emplace_back(tree_nodes_in_level[0]);
-
-        // reverse and renumber tree to have root at index 0
-        std::reverse(m_search_tree.begin(), m_search_tree.end());
-
-        std::uint32_t search_tree_size = m_search_tree.size();
-        tbb::parallel_for(
-            tbb::blocked_range<std::uint32_t>(0, search_tree_size),
-            [this, &search_tree_size](const tbb::blocked_range<std::uint32_t> &range) {
-                for (std::uint32_t i = range.begin(), end = range.end(); i != end; ++i)
-                {
-                    TreeNode &current_tree_node = this->m_search_tree[i];
-                    for (std::uint32_t j = 0; j < current_tree_node.child_count; ++j)
+        const uint64_t search_tree_size =
+            std::accumulate(level_sizes.begin(), level_sizes.end(), uint64_t{0});
+        m_search_tree.resize(search_tree_size);
+
+        // The root is stored at index 0 and every level is stored behind the one above it, so
+        // the children of a node are consecutive. Each level is built in parallel from the level
+        // below it.
+        uint64_t level_end = search_tree_size;
+        uint64_t children_begin = 0;
+        for (const auto level : util::irange<std::size_t>(0, level_sizes.size()))
+        {
+            const uint64_t level_begin = level_end - level_sizes[level];
+            const uint64_t number_of_children =
+                level == 0 ? number_of_leaves : level_sizes[level - 1];
+            const auto child_rectangle = [&](const uint64_t child) -> const Rectangle & {
+                return level == 0
+                           ? leaf_rectangles[child]
+                           : m_search_tree[children_begin + child].minimum_bounding_rectangle;
+            };
+            const auto child_contents = [&](const uint64_t child) {
+                return level == 0 ? leaf_contents[child]
+                                  : m_search_tree[children_begin + child].AllContents();
+            };
+            tbb::parallel_for(
+                tbb::blocked_range<uint64_t>(0, level_sizes[level]),
+                [&](const tbb::blocked_range<uint64_t> &range) {
+                    for (auto node_index = range.begin(), end = range.end(); node_index != end;
+                         ++node_index)
                     {
-                        if (!current_tree_node.children[j].is_leaf)
+                        TreeNode &current_node = m_search_tree[level_begin + node_index];
+                        const auto first_child = node_index * BRANCHING_FACTOR;
+                        const auto last_child =
+                            std::min<uint64_t>(number_of_children, first_child + BRANCHING_FACTOR);
+                        current_node.first_child =
+                            level == 0 ? TreeIndex{first_child, true}
+                                       : TreeIndex{children_begin + first_child, false};
+                        current_node.child_count = last_child - first_child;
+                        for (auto child = first_child; child < last_child; ++child)
                         {
-                            const std::uint32_t old_id = current_tree_node.children[j].index;
-                            const std::uint32_t new_id = search_tree_size - old_id - 1;
-                            current_tree_node.children[j].index = new_id;
+                            current_node.minimum_bounding_rectangle.MergeBoundingBoxes(
+                                child_rectangle(child));
+                        }
+                        for (auto child = first_child; child < last_child; ++child)
+                        {
+                            current_node.QuantizeChild(child - first_child,
+                                                       child_rectangle(child));
+                            current_node.SetChildContents(child - first_child,
+                                                          child_contents(child));
                         }
                     }
-                }
-            });
+                });
+            children_begin = level_begin;
+            level_end = level_begin;
+        }
+        BOOST_ASSERT_MSG(level_end == 0, "tree broken, more than one root node");
 
         // open tree file
         boost::filesystem::ofstream tree_node_file(tree_node_filename, std::ios::binary);
@@ -357,6 +439,12 @@ class StaticRTree
 
         std::uint32_t tree_size = 0;
         tree_node_file.read((char *)&tree_size, sizeof(std::uint32_t));
+        if (boost::filesystem::file_size(node_file) !=
+            sizeof(std::uint32_t) + sizeof(TreeNode) * std::uint64_t{tree_size})
+        {
+            throw exception("ram index file has an unexpected size, it was probably created by an "
+                            "older version. Please run osrm-extract again.");
+        }
 
         m_search_tree.resize(tree_size);
         if (tree_size > 0)
@@ -376,6 +464,34 @@ class StaticRTree
         MapLeafNodesFile(leaf_file);
     }
 
+    // Leaves were already placed in memory, e.g. in the shared region by osrm-datastore
+    explicit StaticRTree(TreeNode *tree_node_ptr,
+                         const uint64_t number_of_nodes,
+                         const LeafNode *leaf_node_ptr,
+                         const uint64_t number_of_leaves,
+                         const CoordinateListT &coordinate_list)
+        : m_search_tree(tree_node_ptr, number_of_nodes), m_coordinate_list(coordinate_list)
+    {
+        m_leaves.reset(leaf_node_ptr, number_of_leaves);
+    }
+
+    // Touches every leaf page in parallel so that the page faults are taken up-front
+    // instead of by the first queries. Returns the number of indexed objects.
+    std::uint64_t WarmUpLeaves() const
+    {
+        return tbb::parallel_reduce(
+            tbb::blocked_range<std::size_t>(0, m_leaves.size()),
+            std::uint64_t{0},
+            [this](const tbb::blocked_range<std::size_t> &range, std::uint64_t num_objects) {
+                for (auto i = range.begin(), end = range.end(); i != end; ++i)
+                {
+                    num_objects += m_leaves[i].object_count;
+                }
+                return num_objects;
+            },
+            [](const std::uint64_t lhs, const std::uint64_t rhs) { return lhs + rhs; });
+    }
+
     void MapLeafNodesFile(const boost::filesystem::path &leaf_file)
     {
         // open leaf node file and return a pointer to the mapped leaves data
@@ -445,16 +561,17 @@ class StaticRTree
 
                 // If it's a tree node, look at all children and add them
                 // to the search queue if their bounding boxes intersect
+                bool intersects[BRANCHING_FACTOR];
+                quantized_rectangles::intersects(current_tree_node.minimum_bounding_rectangle,
+                                                 current_tree_node.ChildRectangles(),
+                                                 current_tree_node.child_count,
+                                                 projected_rectangle,
+                                                 intersects);
                 for (std::uint32_t i = 0; i < current_tree_node.child_count; ++i)
                 {
-                    const TreeIndex child_id = current_tree_node.children[i];
-                    const auto &child_rectangle =
-                        child_id.is_leaf ? m_leaves[child_id.index].minimum_bounding_rectangle
-                                         : m_search_tree[child_id.index].minimum_bounding_rectangle;
-
-                    if (child_rectangle.Intersects(projected_rectangle))
+                    if (intersects[i])
                     {
-                        traversal_queue.push(child_id);
+                        traversal_queue.push(ChildIndex(current_tree_node, i));
                     }
                 }
             }
@@ -466,11 +583,42 @@ class StaticRTree
     std::vector<EdgeDataT> Nearest(const Coordinate input_coordinate,
                                    const std::size_t max_results) const
     {
-        return Nearest(input_coordinate,
-                       [](const CandidateSegment &) { return std::make_pair(true, true); },
-                       [max_results](const std::size_t num_results, const CandidateSegment &) {
-                           return num_results >= max_results;
-                       });
+        return KNearest(input_coordinate,
+                        max_results,
+                        [](const CandidateSegment &) { return std::make_pair(true, true); },
+                        [](const CandidateSegment &) { return false; });
+    }
+
+    // The max_results nearest segments that pass the filter, nearest first. Finds the same as
+    // Nearest with a terminator that stops after max_results segments or at the first segment
+    // out_of_range holds for, but only subtrees are queued: the segments of an explored leaf go
+    // into a bounded heap of the nearest so far, and subtrees not nearer than the farthest of a
+    // full heap are skipped. Filter and out_of_range are thus called for segments in any order,
+    // also for some farther than the results, and must not have side effects.
+    template <typename FilterT, typename RangeT>
+    std::vector<EdgeDataT> KNearest(const Coordinate input_coordinate,
+                                    const std::size_t max_results,
+                                    const FilterT filter,
+                                    const RangeT out_of_range) const
+    {
+        return SearchKNearest(
+            input_coordinate, Restriction{}, max_results, filter, out_of_range, nullptr);
+    }
+
+    // Like above, restricted to the bearing filter like the corresponding Nearest
+    template <typename FilterT, typename RangeT>
+    std::vector<EdgeDataT> KNearest(const Coordinate input_coordinate,
+                                    const BearingFilter bearing_filter,
+                                    const std::size_t max_results,
+                                    const FilterT filter,
+                                    const RangeT out_of_range) const
+    {
+        return SearchKNearest(input_coordinate,
+                              Restriction{bearing_filter, false},
+                              max_results,
+                              filter,
+                              out_of_range,
+                              nullptr);
     }
 
     // Override filter and terminator for the desired behaviour.
@@ -478,6 +626,287 @@ class StaticRTree
     std::vector<EdgeDataT> Nearest(const Coordinate input_coordinate,
                                    const FilterT filter,
                                    const TerminationT terminate) const
+    {
+        return SearchNearest(input_coordinate, Restriction{}, filter, terminate, nullptr);
+    }
+
+    // Like above, but subtrees and segments none of whose enabled directions are within the
+    // bearing filter are skipped before the filter or the terminator see them. The filter still
+    // has to reject the directions outside of the bearing range of the segments it is called for.
+    template <typename FilterT, typename TerminationT>
+    std::vector<EdgeDataT> Nearest(const Coordinate input_coordinate,
+                                   const BearingFilter bearing_filter,
+                                   const FilterT filter,
+                                   const TerminationT terminate) const
+    {
+        return SearchNearest(
+            input_coordinate, Restriction{bearing_filter, false}, filter, terminate, nullptr);
+    }
+
+    // Like above, but only segments of big components are found. Subtrees and segments of tiny
+    // components are skipped before the filter or the terminator see them.
+    template <typename FilterT, typename TerminationT>
+    std::vector<EdgeDataT>
+    NearestInBigComponents(const Coordinate input_coordinate,
+                           const boost::optional<BearingFilter> bearing_filter,
+                           const FilterT filter,
+                           const TerminationT terminate) const
+    {
+        return SearchNearest(
+            input_coordinate, Restriction{bearing_filter, true}, filter, terminate, nullptr);
+    }
+
+    // Batched version of Nearest, see below
+    template <typename FilterT, typename TerminationT>
+    std::vector<std::vector<EdgeDataT>> Nearest(const std::vector<Coordinate> &input_coordinates,
+                                                const FilterT filter,
+                                                const TerminationT terminate) const
+    {
+        return Nearest(input_coordinates, {}, filter, terminate);
+    }
+
+    // Batched version of Nearest: answers all queries of a multi-coordinate request at once.
+    // Queries are processed in hilbert order so that consecutive queries descend into the same
+    // subtrees and the projected geometry of a leaf page is computed only once for all queries
+    // that touch it. Runs of NEAREST_BATCH_CHUNK_SIZE queries in that order are answered in
+    // parallel, so filter and terminator may only touch state of the query they are called for.
+    // They receive the index of the query as first argument, results are returned in input order.
+    // bearing_filters is either empty or has an optional bearing filter for every query.
+    template <typename FilterT, typename TerminationT>
+    std::vector<std::vector<EdgeDataT>>
+    Nearest(const std::vector<Coordinate> &input_coordinates,
+            const std::vector<boost::optional<BearingFilter>> &bearing_filters,
+            const FilterT filter,
+            const TerminationT terminate) const
+    {
+        BOOST_ASSERT(bearing_filters.empty() || bearing_filters.size() == input_coordinates.size());
+
+        return SearchBatch(
+            input_coordinates,
+            [&](const std::uint32_t query_index, ProjectedLeafCache &leaf_cache) {
+                const Restriction restriction(
+                    bearing_filters.empty() ? boost::none : bearing_filters[query_index], false);
+                return SearchNearest(
+                    input_coordinates[query_index],
+                    restriction,
+                    [&filter, query_index](const CandidateSegment &segment) {
+                        return filter(query_index, segment);
+                    },
+                    [&terminate, query_index](const std::size_t num_results,
+                                              const CandidateSegment &segment) {
+                        return terminate(query_index, num_results, segment);
+                    },
+                    &leaf_cache);
+            });
+    }
+
+    // Batched version of KNearest, in the order and with the parallelism of the batched Nearest
+    template <typename FilterT, typename RangeT>
+    std::vector<std::vector<EdgeDataT>>
+    KNearest(const std::vector<Coordinate> &input_coordinates,
+             const std::vector<boost::optional<BearingFilter>> &bearing_filters,
+             const std::size_t max_results,
+             const FilterT filter,
+             const RangeT out_of_range) const
+    {
+        BOOST_ASSERT(bearing_filters.empty() || bearing_filters.size() == input_coordinates.size());
+
+        return SearchBatch(
+            input_coordinates,
+            [&](const std::uint32_t query_index, ProjectedLeafCache &leaf_cache) {
+                const Restriction restriction(
+                    bearing_filters.empty() ? boost::none : bearing_filters[query_index], false);
+                return SearchKNearest(
+                    input_coordinates[query_index],
+                    restriction,
+                    max_results,
+                    [&filter, query_index](const CandidateSegment &segment) {
+                        return filter(query_index, segment);
+                    },
+                    [&out_of_range, query_index](const CandidateSegment &segment) {
+                        return out_of_range(query_index, segment);
+                    },
+                    &leaf_cache);
+            });
+    }
+
+  private:
+    // Answers the queries of a batch in hilbert order, see the batched Nearest. search is called
+    // with the index of a query and the leaf cache of its chunk.
+    template <typename SearchT>
+    std::vector<std::vector<EdgeDataT>>
+    SearchBatch(const std::vector<Coordinate> &input_coordinates, const SearchT &search) const
+    {
+        std::vector<std::uint32_t> query_order(input_coordinates.size());
+        std::iota(query_order.begin(), query_order.end(), 0);
+
+        std::vector<std::uint64_t> hilbert_codes(input_coordinates.size());
+        std::transform(input_coordinates.begin(),
+                       input_coordinates.end(),
+                       hilbert_codes.begin(),
+                       [](const Coordinate coordinate) { return hilbertCode(coordinate); });
+        std::sort(query_order.begin(),
+                  query_order.end(),
+                  [&hilbert_codes](const std::uint32_t lhs, const std::uint32_t rhs) {
+                      return hilbert_codes[lhs] < hilbert_codes[rhs];
+                  });
+
+        std::vector<std::vector<EdgeDataT>> results(input_coordinates.size());
+        const auto search_chunk = [&](const tbb::blocked_range<std::size_t> &range) {
+            // neighbouring queries of a chunk share its cache
+            ProjectedLeafCache leaf_cache;
+            for (const auto order_index : util::irange(range.begin(), range.end()))
+            {
+                const auto query_index = query_order[order_index];
+                results[query_index] = search(query_index, leaf_cache);
+            }
+        };
+
+        const tbb::blocked_range<std::size_t> all_queries(
+            0, query_order.size(), NEAREST_BATCH_CHUNK_SIZE);
+        if (query_order.size() <= NEAREST_BATCH_CHUNK_SIZE)
+        {
+            search_chunk(all_queries);
+        }
+        else
+        {
+            tbb::parallel_for(all_queries, search_chunk, tbb::simple_partitioner());
+        }
+
+        return results;
+    }
+
+    // Fills a leaf with the objects of a range of the sorted input and computes its bounding box.
+    // Returns the contents of the leaf.
+    template <typename WrapperIterator>
+    Contents PackLeaf(const std::vector<EdgeDataT> &input_data_vector,
+                      const WrapperIterator begin,
+                      const WrapperIterator end,
+                      LeafNode &current_leaf) const
+    {
+        Contents contents;
+        BOOST_ASSERT(std::distance(begin, end) <= LEAF_NODE_SIZE);
+        Rectangle &rectangle = current_leaf.minimum_bounding_rectangle;
+        for (auto wrapped_element = begin; wrapped_element != end; ++wrapped_element)
+        {
+            const EdgeDataT &object = input_data_vector[wrapped_element->m_array_index];
+
+            // rounded like the bearing filter of engine::GeospatialQuery does
+            const Coordinate u{m_coordinate_list[object.u]};
+            const Coordinate v{m_coordinate_list[object.v]};
+            const auto forward_bearing =
+                static_cast<std::uint16_t>(std::round(coordinate_calculation::bearing(u, v)));
+            if (object.forward_segment_id.enabled)
+            {
+                contents.sectors |= bearing::Sector(forward_bearing);
+            }
+            if (object.reverse_segment_id.enabled)
+            {
+                contents.sectors |= bearing::Sector(forward_bearing + 180);
+            }
+            contents.big_components = contents.big_components || !object.component.is_tiny;
+
+            current_leaf.objects[current_leaf.object_count] = object;
+            current_leaf.bearings[current_leaf.object_count] = forward_bearing;
+            current_leaf.object_count += 1;
+
+            Coordinate projected_u{
+                web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.u]})};
+            Coordinate projected_v{
+                web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.v]})};
+
+            BOOST_ASSERT(std::abs(toFloating(projected_u.lon).operator double()) <= 180.);
+            BOOST_ASSERT(std::abs(toFloating(projected_u.lat).operator double()) <= 180.);
+            BOOST_ASSERT(std::abs(toFloating(projected_v.lon).operator double()) <= 180.);
+            BOOST_ASSERT(std::abs(toFloating(projected_v.lat).operator double()) <= 180.);
+
+            rectangle.min_lon =
+                std::min(rectangle.min_lon, std::min(projected_u.lon, projected_v.lon));
+            rectangle.max_lon =
+                std::max(rectangle.max_lon, std::max(projected_u.lon, projected_v.lon));
+
+            rectangle.min_lat =
+                std::min(rectangle.min_lat, std::min(projected_u.lat, projected_v.lat));
+            rectangle.max_lat =
+                std::max(rectangle.max_lat, std::max(projected_u.lat, projected_v.lat));
+
+            BOOST_ASSERT(rectangle.IsValid());
+        }
+        return contents;
+    }
+
+    // Projected segment end points of recently explored leaves, shared by the queries of a
+    // batch. Direct mapped on the leaf index, which is enough since hilbert ordered queries
+    // revisit the leaves of their predecessors.
+    struct ProjectedLeafCache
+    {
+        static constexpr std::size_t NUM_SLOTS = 64;
+
+        ProjectedLeafCache() { leaf_ids.fill(std::numeric_limits<std::uint32_t>::max()); }
+
+        struct ProjectedLeaf
+        {
+            std::vector<FloatCoordinate> sources;
+            std::vector<FloatCoordinate> targets;
+        };
+
+        std::array<std::uint32_t, NUM_SLOTS> leaf_ids;
+        std::array<ProjectedLeaf, NUM_SLOTS> leaves;
+    };
+
+    // The segments a search is restricted to. Subtrees and segments outside of it are skipped.
+    class Restriction
+    {
+      public:
+        Restriction() = default;
+        Restriction(const boost::optional<BearingFilter> bearing_filter,
+                    const bool big_components_only)
+            : bearing_filter(bearing_filter), big_components_only(big_components_only)
+        {
+            if (bearing_filter)
+            {
+                sectors = bearing::SectorsInBounds(bearing_filter->bearing, bearing_filter->range);
+            }
+        }
+
+        bool Admits(const TreeNode &node, const std::uint32_t child) const
+        {
+            // without a bearing filter segments without enabled directions are found, too
+            return (sectors == bearing::ALL_SECTORS || (node.child_sectors[child] & sectors)) &&
+                   (!big_components_only || node.child_big_components[child]);
+        }
+
+        bool Admits(const LeafNode &leaf, const std::uint32_t object_index) const
+        {
+            return (!bearing_filter || InBearingRange(leaf, object_index)) &&
+                   (!big_components_only || !leaf.objects[object_index].component.is_tiny);
+        }
+
+      private:
+        // Whether an enabled direction of an object is within the bearing filter
+        bool InBearingRange(const LeafNode &leaf, const std::uint32_t object_index) const
+        {
+            const auto &object = leaf.objects[object_index];
+            const int forward_bearing = leaf.bearings[object_index];
+            return (object.forward_segment_id.enabled &&
+                    bearing::CheckInBounds(
+                        forward_bearing, bearing_filter->bearing, bearing_filter->range)) ||
+                   (object.reverse_segment_id.enabled &&
+                    bearing::CheckInBounds(
+                        forward_bearing + 180, bearing_filter->bearing, bearing_filter->range));
+        }
+
+        boost::optional<BearingFilter> bearing_filter;
+        bearing::SectorMask sectors = bearing::ALL_SECTORS;
+        bool big_components_only = false;
+    };
+
+    template <typename FilterT, typename TerminationT>
+    std::vector<EdgeDataT> SearchNearest(const Coordinate input_coordinate,
+                                         const Restriction &restriction,
+                                         const FilterT &filter,
+                                         const TerminationT &terminate,
+                                         ProjectedLeafCache *leaf_cache) const
     {
         std::vector<EdgeDataT> results;
         auto projected_coordinate = web_mercator::fromWGS84(input_coordinate);
@@ -500,12 +929,16 @@ class StaticRTree
                     ExploreLeafNode(current_tree_index,
                                     fixed_projected_coordinate,
                                     projected_coordinate,
-                                    traversal_queue);
+                                    restriction,
+                                    traversal_queue,
+                                    leaf_cache);
                 }
                 else
                 {
-                    ExploreTreeNode(
-                        current_tree_index, fixed_projected_coordinate, traversal_queue);
+                    ExploreTreeNode(current_tree_index,
+                                    fixed_projected_coordinate,
+                                    restriction,
+                                    traversal_queue);
                 }
             }
             else
@@ -539,53 +972,283 @@ class StaticRTree
         return results;
     }
 
-  private:
+    // A segment found by SearchKNearest. Segments of the same distance are ordered by rank, the
+    // order in which they were found.
+    struct Neighbour
+    {
+        std::uint64_t squared_distance;
+        std::uint32_t rank;
+        EdgeDataT data;
+
+        bool operator<(const Neighbour &other) const
+        {
+            return std::tie(squared_distance, rank) <
+                   std::tie(other.squared_distance, other.rank);
+        }
+    };
+
+    // Traversal state of SearchKNearest, kept per thread so that its vectors are not allocated
+    // again for every query
+    struct KNearestState
+    {
+        // subtrees still to explore, a heap with the nearest on top
+        std::vector<QueryCandidate> queue;
+        // the nearest segments so far, a heap with the farthest on top
+        std::vector<Neighbour> results;
+    };
+
+    // Takes the candidates of the Explore functions in place of the traversal queue of
+    // SearchNearest. Subtrees are queued, segments are checked right away and kept if they are
+    // among the max_results nearest. Candidates not nearer than the bound are dropped.
+    template <typename FilterT, typename RangeT> class KNearestQueue
+    {
+      public:
+        KNearestQueue(const StaticRTree &rtree,
+                      KNearestState &state,
+                      const std::size_t max_results,
+                      const FilterT &filter,
+                      const RangeT &out_of_range)
+            : rtree(rtree), state(state), max_results(max_results), filter(filter),
+              out_of_range(out_of_range)
+        {
+            state.queue.clear();
+            state.results.clear();
+        }
+
+        void push(const QueryCandidate &candidate)
+        {
+            if (candidate.squared_min_dist >= bound)
+            {
+                return;
+            }
+            if (!candidate.is_segment())
+            {
+                state.queue.push_back(candidate);
+                std::push_heap(state.queue.begin(), state.queue.end());
+                return;
+            }
+
+            auto edge_data =
+                rtree.m_leaves[candidate.tree_index.index].objects[candidate.segment_index];
+            const CandidateSegment segment{candidate.fixed_projected_coordinate, edge_data};
+            if (out_of_range(segment))
+            {
+                // a search in order of distance would have stopped here
+                bound = candidate.squared_min_dist;
+                while (!state.results.empty() && state.results.front().squared_distance >= bound)
+                {
+                    PopFarthest();
+                }
+                return;
+            }
+
+            const auto use_segment = filter(segment);
+            if (!use_segment.first && !use_segment.second)
+            {
+                return;
+            }
+            edge_data.forward_segment_id.enabled &= use_segment.first;
+            edge_data.reverse_segment_id.enabled &= use_segment.second;
+
+            state.results.push_back(
+                Neighbour{candidate.squared_min_dist, next_rank++, std::move(edge_data)});
+            std::push_heap(state.results.begin(), state.results.end());
+            if (state.results.size() > max_results)
+            {
+                PopFarthest();
+            }
+            if (state.results.size() == max_results)
+            {
+                bound = std::min(bound, state.results.front().squared_distance);
+            }
+        }
+
+        // Removes the nearest queued subtree, returns false if none is nearer than the bound
+        bool PopNearest(QueryCandidate &candidate)
+        {
+            if (state.queue.empty() || state.queue.front().squared_min_dist >= bound)
+            {
+                return false;
+            }
+            std::pop_heap(state.queue.begin(), state.queue.end());
+            candidate = state.queue.back();
+            state.queue.pop_back();
+            return true;
+        }
+
+        std::vector<EdgeDataT> Results()
+        {
+            std::sort_heap(state.results.begin(), state.results.end());
+            std::vector<EdgeDataT> results;
+            results.reserve(state.results.size());
+            for (auto &result : state.results)
+            {
+                results.push_back(std::move(result.data));
+            }
+            return results;
+        }
+
+      private:
+        void PopFarthest()
+        {
+            std::pop_heap(state.results.begin(), state.results.end());
+            state.results.pop_back();
+        }
+
+        const StaticRTree &rtree;
+        KNearestState &state;
+        const std::size_t max_results;
+        const FilterT &filter;
+        const RangeT &out_of_range;
+        // squared distance of the farthest result of a full heap, or of the nearest segment out
+        // of range if that is nearer
+        std::uint64_t bound = std::numeric_limits<std::uint64_t>::max();
+        std::uint32_t next_rank = 0;
+    };
+
+    template <typename FilterT, typename RangeT>
+    std::vector<EdgeDataT> SearchKNearest(const Coordinate input_coordinate,
+                                          const Restriction &restriction,
+                                          const std::size_t max_results,
+                                          const FilterT &filter,
+                                          const RangeT &out_of_range,
+                                          ProjectedLeafCache *leaf_cache) const
+    {
+        if (max_results == 0)
+        {
+            return {};
+        }
+
+        const auto projected_coordinate = web_mercator::fromWGS84(input_coordinate);
+        const Coordinate fixed_projected_coordinate{projected_coordinate};
+
+        static thread_local KNearestState state;
+        KNearestQueue<FilterT, RangeT> traversal_queue(
+            *this, state, max_results, filter, out_of_range);
+        traversal_queue.push(QueryCandidate{0, TreeIndex{}});
+
+        QueryCandidate current_query_node{0, TreeIndex{}};
+        while (traversal_queue.PopNearest(current_query_node))
+        {
+            const TreeIndex &current_tree_index = current_query_node.tree_index;
+            if (current_tree_index.is_leaf)
+            {
+                ExploreLeafNode(current_tree_index,
+                                fixed_projected_coordinate,
+                                projected_coordinate,
+                                restriction,
+                                traversal_queue,
+                                leaf_cache);
+            }
+            else
+            {
+                ExploreTreeNode(
+                    current_tree_index, fixed_projected_coordinate, restriction, traversal_queue);
+            }
+        }
+
+        return traversal_queue.Results();
+    }
+
     template <typename QueueT>
     void ExploreLeafNode(const TreeIndex &leaf_id,
                          const Coordinate &projected_input_coordinate_fixed,
                          const FloatCoordinate &projected_input_coordinate,
-                         QueueT &traversal_queue) const
+                         const Restriction &restriction,
+                         QueueT &traversal_queue,
+                         ProjectedLeafCache *leaf_cache) const
     {
         const LeafNode &current_leaf_node = m_leaves[leaf_id.index];
+        const auto object_count = current_leaf_node.object_count;
 
-        // current object represents a block on disk
-        for (const auto i : irange(0u, current_leaf_node.object_count))
+        std::array<FloatCoordinate, LEAF_NODE_SIZE> local_sources;
+        std::array<FloatCoordinate, LEAF_NODE_SIZE> local_targets;
+        const FloatCoordinate *projected_sources = local_sources.data();
+        const FloatCoordinate *projected_targets = local_targets.data();
+        if (leaf_cache)
+        {
+            const auto slot = leaf_id.index % ProjectedLeafCache::NUM_SLOTS;
+            auto &projected_leaf = leaf_cache->leaves[slot];
+            if (leaf_cache->leaf_ids[slot] != leaf_id.index)
+            {
+                leaf_cache->leaf_ids[slot] = leaf_id.index;
+                projected_leaf.sources.resize(object_count);
+                projected_leaf.targets.resize(object_count);
+                ProjectLeafNode(current_leaf_node,
+                                projected_leaf.sources.data(),
+                                projected_leaf.targets.data());
+            }
+            projected_sources = projected_leaf.sources.data();
+            projected_targets = projected_leaf.targets.data();
+        }
+        else
         {
-            const auto &current_edge = current_leaf_node.objects[i];
-            const auto projected_u = web_mercator::fromWGS84(m_coordinate_list[current_edge.u]);
-            const auto projected_v = web_mercator::fromWGS84(m_coordinate_list[current_edge.v]);
+            ProjectLeafNode(current_leaf_node, local_sources.data(), local_targets.data());
+        }
 
-            FloatCoordinate projected_nearest;
-            std::tie(std::ignore, projected_nearest) =
-                coordinate_calculation::projectPointOnSegment(
-                    projected_u, projected_v, projected_input_coordinate);
+        std::array<FloatCoordinate, LEAF_NODE_SIZE> projected_nearest;
+        coordinate_calculation::projectPointOnSegments(projected_sources,
+                                                       projected_targets,
+                                                       object_count,
+                                                       projected_input_coordinate,
+                                                       projected_nearest.data());
 
+        // current object represents a block on disk
+        for (const auto i : irange(0u, object_count))
+        {
+            if (!restriction.Admits(current_leaf_node, i))
+            {
+                continue;
+            }
             const auto squared_distance = coordinate_calculation::squaredEuclideanDistance(
-                projected_input_coordinate_fixed, projected_nearest);
+                projected_input_coordinate_fixed, projected_nearest[i]);
             // distance must be non-negative
             BOOST_ASSERT(0. <= squared_distance);
             traversal_queue.push(
-                QueryCandidate{squared_distance, leaf_id, i, Coordinate{projected_nearest}});
+                QueryCandidate{squared_distance, leaf_id, i, Coordinate{projected_nearest[i]}});
+        }
+    }
+
+    void ProjectLeafNode(const LeafNode &leaf_node,
+                         FloatCoordinate *projected_sources,
+                         FloatCoordinate *projected_targets) const
+    {
+        for (const auto i : irange(0u, leaf_node.object_count))
+        {
+            const auto &current_edge = leaf_node.objects[i];
+            projected_sources[i] = web_mercator::fromWGS84(m_coordinate_list[current_edge.u]);
+            projected_targets[i] = web_mercator::fromWGS84(m_coordinate_list[current_edge.v]);
         }
     }
 
     template <class QueueT>
     void ExploreTreeNode(const TreeIndex &parent_id,
                          const Coordinate &fixed_projected_input_coordinate,
+                         const Restriction &restriction,
                          QueueT &traversal_queue) const
     {
         const TreeNode &parent = m_search_tree[parent_id.index];
+        std::uint64_t squared_lower_bounds[BRANCHING_FACTOR];
+        quantized_rectangles::minSquaredDistances(parent.minimum_bounding_rectangle,
+                                                  parent.ChildRectangles(),
+                                                  parent.child_count,
+                                                  fixed_projected_input_coordinate,
+                                                  squared_lower_bounds);
         for (std::uint32_t i = 0; i < parent.child_count; ++i)
         {
-            const TreeIndex child_id = parent.children[i];
-            const auto &child_rectangle =
-                child_id.is_leaf ? m_leaves[child_id.index].minimum_bounding_rectangle
-                                 : m_search_tree[child_id.index].minimum_bounding_rectangle;
-            const auto squared_lower_bound_to_element =
-                child_rectangle.GetMinSquaredDist(fixed_projected_input_coordinate);
-            traversal_queue.push(QueryCandidate{squared_lower_bound_to_element, child_id});
+            if (!restriction.Admits(parent, i))
+            {
+                continue;
+            }
+            traversal_queue.push(QueryCandidate{squared_lower_bounds[i], ChildIndex(parent, i)});
         }
     }
+
+    static TreeIndex ChildIndex(const TreeNode &parent, const std::uint32_t child)
+    {
+        return TreeIndex{parent.first_child.index + child,
+                         static_cast<bool>(parent.first_child.is_leaf)};
+    }
 };
 
 //[1] "On Packing R-Trees"; I. Kamel, C. Faloutsos; 1993; DOI: 10.1145/170088.170403
@@ -0,0 +1,58 @@
+#ifndef STRIDED_VIEW_HPP
+#define STRIDED_VIEW_HPP
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Read-only view of values that are a fixed number of bytes apart in memory owned by someone
+// else, e.g. one member of every struct in an array. A stride of zero repeats a single value.
+// Values that only exist decoded, e.g. from compressed geometries, are owned by the view and
+// shared between its copies.
+template <typename T> class StridedView
+{
+  public:
+    StridedView() : first(nullptr), count(0), stride(0) {}
+
+    StridedView(const T *first, const std::size_t count, const std::size_t stride = sizeof(T))
+        : first(reinterpret_cast<const char *>(first)), count(count), stride(stride)
+    {
+        BOOST_ASSERT(count == 0 || first != nullptr);
+    }
+
+    explicit StridedView(std::vector<T> values)
+        : owned(std::make_shared<const std::vector<T>>(std::move(values))),
+          first(reinterpret_cast<const char *>(owned->data())), count(owned->size()),
+          stride(sizeof(T))
+    {
+    }
+
+    const T &operator[](const std::size_t index) const
+    {
+        BOOST_ASSERT(index < count);
+        return *reinterpret_cast<const T *>(first + index * stride);
+    }
+
+    const T &front() const { return (*this)[0]; }
+    const T &back() const { return (*this)[count - 1]; }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+  private:
+    std::shared_ptr<const std::vector<T>> owned;
+    const char *first;
+    std::size_t count;
+    std::size_t stride;
+};
+}
+}
+
+#endif // STRIDED_VIEW_HPP
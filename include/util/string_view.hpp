@@ -0,0 +1,20 @@
+#ifndef STRING_VIEW_HPP
+#define STRING_VIEW_HPP
+
+#include <boost/range/iterator_range_core.hpp>
+
+#include <string>
+
+namespace osrm
+{
+namespace util
+{
+
+// Characters of a string owned by someone else, e.g. a name in the memory of a data facade
+using StringView = boost::iterator_range<const char *>;
+
+inline std::string ToString(const StringView view) { return std::string(view.begin(), view.end()); }
+}
+}
+
+#endif // STRING_VIEW_HPP
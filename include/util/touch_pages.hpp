@@ -0,0 +1,44 @@
+#ifndef UTIL_TOUCH_PAGES_HPP
+#define UTIL_TOUCH_PAGES_HPP
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace osrm
+{
+namespace util
+{
+
+// Reads one byte of every page of [data, data + size) in parallel, so that mapped memory is
+// faulted in before the first query waits for it. Returns the number of bytes that were touched.
+inline std::uint64_t TouchPages(const void *data, const std::uint64_t size)
+{
+    static const constexpr std::uint64_t PAGE_SIZE = 4096;
+
+    if (!data || size == 0)
+    {
+        return 0;
+    }
+
+    const volatile char *const bytes = static_cast<const volatile char *>(data);
+    const auto number_of_pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    tbb::parallel_reduce(
+        tbb::blocked_range<std::uint64_t>(0, number_of_pages),
+        char{0},
+        [bytes](const tbb::blocked_range<std::uint64_t> &range, char checksum) {
+            for (auto page = range.begin(); page != range.end(); ++page)
+            {
+                checksum ^= bytes[page * PAGE_SIZE];
+            }
+            return checksum;
+        },
+        [](const char lhs, const char rhs) { return static_cast<char>(lhs ^ rhs); });
+    return size;
+}
+}
+}
+
+#endif // UTIL_TOUCH_PAGES_HPP
@@ -58,6 +58,8 @@ using NodeID = std::uint32_t;
 using EdgeID = std::uint32_t;
 using NameID = std::uint32_t;
 using EdgeWeight = std::int32_t;
+// in meters
+using EdgeLength = float;
 
 using LaneID = std::uint8_t;
 static const LaneID INVALID_LANEID = std::numeric_limits<LaneID>::max();
@@ -81,6 +83,10 @@ static const NameID INVALID_NAMEID = std::numeric_limits<NameID>::max();
 static const NameID EMPTY_NAMEID = 0;
 static const unsigned INVALID_COMPONENTID = 0;
 static const EdgeWeight INVALID_EDGE_WEIGHT = std::numeric_limits<EdgeWeight>::max();
+// Weight of the edges a metric excludes. Paths over them stay valid, routes whose weight reaches
+// it are not returned. Sums of a few of them still fit into the 30 bits of a QueryEdge.
+static const EdgeWeight EXCLUDED_EDGE_WEIGHT = 1 << 26;
+static const EdgeLength INVALID_EDGE_LENGTH = std::numeric_limits<EdgeLength>::max();
 
 struct SegmentID
 {
@@ -0,0 +1,92 @@
+#ifndef UTIL_WORK_QUEUE_HPP
+#define UTIL_WORK_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+/**
+ * Runs tasks on a fixed number of worker threads.
+ *
+ * Tasks are pushed into lanes. A worker always takes the oldest task of the lane with the lowest
+ * priority value, so cheap tasks do not queue up behind expensive ones. Every lane admits at most
+ * max_pending tasks that are queued or running, and all lanes together queue at most capacity
+ * tasks. Tasks beyond that are rejected instead of delaying everyone else.
+ */
+class WorkQueue
+{
+  public:
+    using Task = std::function<void()>;
+
+    struct Lane
+    {
+        unsigned priority;
+        // std::numeric_limits<std::size_t>::max() for no limit
+        std::size_t max_pending;
+    };
+
+    // initialize_worker runs on every worker thread before it takes tasks, e.g. to pin it
+    WorkQueue(const unsigned number_of_workers,
+              const std::size_t capacity,
+              std::vector<Lane> lanes,
+              std::function<void(unsigned worker)> initialize_worker = {});
+
+    // Running tasks are finished, queued ones are dropped without running them
+    ~WorkQueue();
+
+    WorkQueue(const WorkQueue &) = delete;
+    WorkQueue &operator=(const WorkQueue &) = delete;
+
+    // false if the lane or the queue is full, the task is then never run
+    bool TryPush(const std::size_t lane, Task task);
+
+    std::size_t NumberOfLanes() const { return lanes.size(); }
+
+    // Tasks waiting for a worker, the running ones not included
+    std::size_t NumberOfQueuedTasks() const;
+
+  private:
+    struct QueuedTask
+    {
+        unsigned priority;
+        std::uint64_t sequence;
+        std::size_t lane;
+        Task task;
+
+        // std::priority_queue takes the largest element first
+        bool operator<(const QueuedTask &other) const
+        {
+            return priority != other.priority ? priority > other.priority
+                                              : sequence > other.sequence;
+        }
+    };
+
+    void RunWorker(const unsigned worker);
+
+    const std::size_t capacity;
+    const std::vector<Lane> lanes;
+    std::function<void(unsigned)> initialize_worker;
+
+    mutable std::mutex mutex;
+    std::condition_variable task_available;
+    std::priority_queue<QueuedTask> queue;
+    std::vector<std::size_t> pending_tasks;
+    std::uint64_t next_sequence = 0;
+    bool stopped = false;
+
+    std::vector<std::thread> workers;
+};
+}
+}
+
+#endif // UTIL_WORK_QUEUE_HPP
@@ -1,6 +1,7 @@
 #ifndef XOR_FAST_HASH_STORAGE_HPP
 #define XOR_FAST_HASH_STORAGE_HPP
 
+#include "util/binary_heap.hpp"
 #include "util/xor_fast_hash.hpp"
 
 #include <limits>
@@ -63,6 +64,14 @@ class XORFastHashStorage
         return positions[position].key;
     }
 
+    static const constexpr bool CAN_PREFETCH = true;
+
+    // loads the cell the probing of node starts at
+    void Prefetch(const NodeID node) const
+    {
+        PrefetchForRead(&positions[fast_hasher(node)]);
+    }
+
     void Clear()
     {
         ++current_timestamp;
@@ -12,6 +12,15 @@ access_tags_hierarchy = { "motorcar", "motor_vehicle", "vehicle", "access" }
 service_tag_restricted = { ["parking_aisle"] = true }
 restriction_exception_tags = { "motorcar", "motor_vehicle", "vehicle" }
 
+-- Keys of all tags way_function reads, including the access tags above. A key also covers
+-- the keys that start with it and a colon, like "name" covers "name:pronunciation".
+-- Ways that agree on these tags share one way_function result, keep the list complete.
+way_tag_keys = { "access", "area", "barrier", "bridge", "capacity", "cycleway", "destination",
+                 "duration", "highway", "impassable", "junction", "lanes", "maxspeed",
+                 "motor_vehicle", "motorcar", "name", "oneway", "ref", "route", "service",
+                 "side_road", "smoothness", "status", "surface", "tracktype", "turn", "vehicle",
+                 "width" }
+
 -- A list of suffixes to suppress in name change instructions
 suffix_list = { "N", "NE", "E", "SE", "S", "SW", "W", "NW", "North", "South", "West", "East" }
 
@@ -166,6 +175,50 @@ function get_exceptions(vector)
   end
 end
 
+function get_way_tag_keys(vector)
+  for i,v in ipairs(way_tag_keys) do
+    vector:Add(v)
+  end
+end
+
+-- Ways the extractor can tell from their tags that way_function leaves unroutable: without a
+-- highway, route or bridge tag, without a speed, or closed by one of the early returns of
+-- way_function. Keep it in sync with way_function, it must never reject routable ways.
+function get_way_tag_filter(filter)
+  for i,key in ipairs({ "highway", "route", "bridge" }) do
+    filter:Require("tagged", key, "")
+  end
+
+  for class,speed in pairs(speed_profile) do
+    filter:Require("speed", "highway", class)
+    if speed > 0 then
+      filter:Require("speed", "route", class)
+      filter:Require("speed", "bridge", class)
+    end
+  end
+
+  for i,key in ipairs(access_tags_hierarchy) do
+    filter:AddAccessKey(key)
+  end
+  for access,allowed in pairs(access_tag_whitelist) do
+    if allowed then
+      filter:RequireAccess("speed", access)
+    end
+  end
+  for access,denied in pairs(access_tag_blacklist) do
+    if denied then
+      filter:RejectAccess(access)
+    end
+  end
+
+  if ignore_areas then
+    filter:Reject("area", "yes")
+  end
+  filter:Reject("oneway", "reversible")
+  filter:Reject("impassable", "yes")
+  filter:Reject("status", "impassable")
+end
+
 -- returns forward,backward psv lane count
 local function getPSVCounts(way)
     local psv = way:get_value_by_key("lanes:psv")
@@ -555,6 +608,19 @@ function way_function (way, result)
     result.backward_speed = math.min(penalized_speed, scaled_speed)
   end
 
+  -- classes route requests can exclude, see osrm-contract --exclude-classes
+  local classes = edge_class.none
+  if "yes" == way:get_value_by_key("toll") then
+    classes = classes + edge_class.toll
+  end
+  if "motorway" == highway or "motorway_link" == highway then
+    classes = classes + edge_class.motorway
+  end
+  if result.forward_mode == mode.ferry or result.backward_mode == mode.ferry then
+    classes = classes + edge_class.ferry
+  end
+  result.classes = classes
+
   -- only allow this road as start point if it not a ferry
   result.is_startpoint = result.forward_mode == mode.driving or result.backward_mode == mode.driving
 end
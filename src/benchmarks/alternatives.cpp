@@ -0,0 +1,98 @@
+#include "util/timing_util.hpp"
+
+#include "osrm/route_parameters.hpp"
+
+#include "osrm/coordinate.hpp"
+#include "osrm/engine_config.hpp"
+#include "osrm/json_container.hpp"
+
+#include "osrm/osrm.hpp"
+#include "osrm/status.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstdlib>
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " data.osrm [max alternative candidates]\n";
+        return EXIT_FAILURE;
+    }
+
+    using namespace osrm;
+
+    using osrm::util::FloatCoordinate;
+    using osrm::util::FloatLatitude;
+    using osrm::util::FloatLongitude;
+
+    // Routes between the corners and edge midpoints of a box in monaco
+    const double min_lon = 7.41337, max_lon = 7.42194;
+    const double min_lat = 43.7315, max_lat = 43.7426;
+    std::vector<FloatCoordinate> locations;
+    for (const auto lon : {min_lon, (min_lon + max_lon) / 2, max_lon})
+    {
+        for (const auto lat : {min_lat, (min_lat + max_lat) / 2, max_lat})
+        {
+            locations.push_back(FloatCoordinate{FloatLongitude{lon}, FloatLatitude{lat}});
+        }
+    }
+
+    const auto run = [&](const int max_alternative_candidates) {
+        // Configure based on a .osrm base path, and no datasets in shared mem from osrm-datastore
+        EngineConfig config;
+        config.storage_config = {argv[1]};
+        config.use_shared_memory = false;
+        config.max_alternative_candidates = max_alternative_candidates;
+
+        OSRM osrm{config};
+
+        RouteParameters params;
+        params.alternatives = true;
+        params.overview = RouteParameters::OverviewType::False;
+        params.coordinates.resize(2);
+
+        auto num_routes = 0;
+        auto num_alternatives = 0;
+        TIMER_START(routes);
+        for (const auto &source : locations)
+        {
+            for (const auto &target : locations)
+            {
+                params.coordinates[0] = source;
+                params.coordinates[1] = target;
+
+                json::Object result;
+                if (osrm.Route(params, result) != Status::Ok)
+                {
+                    continue;
+                }
+                ++num_routes;
+                num_alternatives +=
+                    result.values.at("routes").get<json::Array>().values.size() > 1 ? 1 : 0;
+            }
+        }
+        TIMER_STOP(routes);
+
+        std::cout << "max. " << max_alternative_candidates << " candidates: "
+                  << (TIMER_MSEC(routes) / std::max(1, num_routes)) << "ms/req, "
+                  << num_alternatives << "/" << num_routes << " with alternative" << std::endl;
+    };
+
+    // 0 inspects all via node candidates like the exhaustive search
+    run(0);
+    run(argc > 2 ? std::stoi(argv[2]) : 5);
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
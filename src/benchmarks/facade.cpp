@@ -0,0 +1,101 @@
+#include "engine/datafacade/datafacade_base.hpp"
+#include "engine/datafacade/internal_datafacade.hpp"
+#include "engine/routing_algorithms/many_to_many.hpp"
+#include "engine/search_engine_data.hpp"
+#include "storage/storage_config.hpp"
+#include "util/timing_util.hpp"
+
+#include "osrm/coordinate.hpp"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <cstdlib>
+
+namespace
+{
+using namespace osrm;
+
+// Runs the many-to-many search of the table plugin on the given facade type and returns the
+// time per table in ms
+template <typename DataFacadeT>
+double TimeTables(engine::datafacade::BaseDataFacade &facade,
+                  engine::SearchEngineData &heaps,
+                  const std::vector<engine::PhantomNode> &phantom_nodes,
+                  std::vector<EdgeWeight> &result)
+{
+    engine::routing_algorithms::ManyToManyRouting<DataFacadeT> table(
+        static_cast<DataFacadeT *>(&facade), heaps);
+    const std::vector<std::size_t> all_phantoms;
+
+    const auto NUM = 10;
+    TIMER_START(tables);
+    for (int i = 0; i < NUM; ++i)
+    {
+        result = table(phantom_nodes, all_phantoms, all_phantoms);
+    }
+    TIMER_STOP(tables);
+    return TIMER_MSEC(tables) / NUM;
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " data.osrm [grid size]\n";
+        return EXIT_FAILURE;
+    }
+
+    using namespace osrm;
+
+    engine::datafacade::InternalDataFacade facade{storage::StorageConfig{argv[1]}};
+
+    const auto grid_size = argc > 2 ? std::stoul(argv[2]) : 10ul;
+
+    using osrm::util::FloatCoordinate;
+    using osrm::util::FloatLatitude;
+    using osrm::util::FloatLongitude;
+
+    // Square grid of coordinates in monaco, every one is a source and a target
+    const double min_lon = 7.41337, max_lon = 7.42194;
+    const double min_lat = 43.7315, max_lat = 43.7426;
+    std::vector<engine::PhantomNode> phantom_nodes;
+    for (std::size_t row = 0; row < grid_size; ++row)
+    {
+        for (std::size_t column = 0; column < grid_size; ++column)
+        {
+            const auto lon = min_lon + (max_lon - min_lon) * column / grid_size;
+            const auto lat = min_lat + (max_lat - min_lat) * row / grid_size;
+            const util::Coordinate coordinate{FloatLongitude{lon}, FloatLatitude{lat}};
+            phantom_nodes.push_back(
+                facade.NearestPhantomNodeWithAlternativeFromBigComponent(coordinate).first);
+        }
+    }
+
+    engine::SearchEngineData heaps;
+    std::vector<EdgeWeight> virtual_result, direct_result;
+    const auto virtual_ms = TimeTables<engine::datafacade::BaseDataFacade>(
+        facade, heaps, phantom_nodes, virtual_result);
+    const auto direct_ms = TimeTables<engine::datafacade::InternalDataFacade>(
+        facade, heaps, phantom_nodes, direct_result);
+
+    if (virtual_result != direct_result)
+    {
+        std::cerr << "Tables of the two facade types differ" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << virtual_ms << "ms/req through BaseDataFacade, " << direct_ms
+              << "ms/req through InternalDataFacade at " << phantom_nodes.size() << "x"
+              << phantom_nodes.size() << " table" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,165 @@
+#include "extractor/compressed_edge_container.hpp"
+#include "util/delta_encoded_geometries.hpp"
+#include "util/timing_util.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace
+{
+using namespace osrm;
+using CompressedEdge = extractor::CompressedEdgeContainer::CompressedEdge;
+
+void ReadGeometries(const boost::filesystem::path &path,
+                    std::vector<unsigned> &indices,
+                    std::vector<CompressedEdge> &segments)
+{
+    boost::filesystem::ifstream stream(path, std::ios::binary);
+    unsigned number_of_indices = 0;
+    stream.read((char *)&number_of_indices, sizeof(unsigned));
+    indices.resize(number_of_indices);
+    stream.read((char *)indices.data(), number_of_indices * sizeof(unsigned));
+    unsigned number_of_segments = 0;
+    stream.read((char *)&number_of_segments, sizeof(unsigned));
+    segments.resize(number_of_segments);
+    stream.read((char *)segments.data(), number_of_segments * sizeof(CompressedEdge));
+    if (!stream || indices.empty() || indices.back() != number_of_segments)
+    {
+        throw std::runtime_error("Could not read " + path.string());
+    }
+}
+
+// Nodes and weights of the same random geometries as the routing plugins ask for them, the sums
+// keep the compiler from dropping the lookups
+template <typename GetNodes, typename GetWeights>
+void TimeLookups(const char *name,
+                 const std::vector<unsigned> &geometries,
+                 const std::size_t bytes,
+                 const std::size_t number_of_segments,
+                 GetNodes get_nodes,
+                 GetWeights get_weights)
+{
+    std::vector<NodeID> nodes;
+    std::vector<EdgeWeight> weights;
+    std::uint64_t checksum = 0;
+
+    TIMER_START(lookups);
+    for (const auto geometry : geometries)
+    {
+        get_nodes(geometry, nodes);
+        get_weights(geometry, weights);
+        for (std::size_t index = 0; index < nodes.size(); ++index)
+        {
+            checksum += nodes[index] + weights[index];
+        }
+    }
+    TIMER_STOP(lookups);
+
+    std::cout << name << ": " << bytes / (1024. * 1024.) << "MiB "
+              << bytes / static_cast<double>(number_of_segments) << " bytes/segment "
+              << TIMER_NSEC(lookups) / geometries.size() << "ns/geometry (checksum " << checksum
+              << ")" << std::endl;
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " file.osrm.geometry [lookups]\n";
+        return EXIT_FAILURE;
+    }
+    const auto number_of_lookups = argc > 2 ? std::stoul(argv[2]) : 1000000ul;
+
+    std::vector<unsigned> indices;
+    std::vector<CompressedEdge> segments;
+    ReadGeometries(argv[1], indices, segments);
+    const std::size_t number_of_geometries = indices.size() - 1;
+    if (number_of_geometries == 0)
+    {
+        throw std::runtime_error("There are no geometries");
+    }
+
+    TIMER_START(encoding);
+    std::vector<std::uint64_t> block_offsets;
+    std::vector<unsigned char> bytes;
+    util::DeltaEncodedGeometries<false>::Encode(indices, segments, block_offsets, bytes);
+    util::DeltaEncodedGeometries<false> encoded;
+    encoded.Reset(std::move(block_offsets), std::move(bytes));
+    TIMER_STOP(encoding);
+    std::cout << "encoded " << number_of_geometries << " geometries with " << segments.size()
+              << " segments in " << TIMER_MSEC(encoding) << "ms" << std::endl;
+
+    // the benchmark is only meaningful if the encoding is right
+    std::vector<NodeID> nodes;
+    std::vector<EdgeWeight> weights;
+    for (std::size_t geometry = 0; geometry < number_of_geometries; ++geometry)
+    {
+        encoded.GetNodes(indices, geometry, nodes);
+        encoded.GetWeights(indices, geometry, weights);
+        for (std::size_t index = 0; index < nodes.size(); ++index)
+        {
+            const auto &segment = segments[indices[geometry] + index];
+            if (nodes[index] != segment.node_id || weights[index] != segment.weight)
+            {
+                throw std::runtime_error("Geometry " + std::to_string(geometry) +
+                                         " does not decode to its segments");
+            }
+        }
+    }
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<unsigned> any_geometry(0, number_of_geometries - 1);
+    std::vector<unsigned> geometries(number_of_lookups);
+    for (auto &geometry : geometries)
+    {
+        geometry = any_geometry(generator);
+    }
+
+    TimeLookups("uncompressed",
+                geometries,
+                segments.size() * sizeof(CompressedEdge),
+                segments.size(),
+                [&](const unsigned geometry, std::vector<NodeID> &result) {
+                    result.clear();
+                    for (auto index = indices[geometry]; index < indices[geometry + 1]; ++index)
+                    {
+                        result.push_back(segments[index].node_id);
+                    }
+                },
+                [&](const unsigned geometry, std::vector<EdgeWeight> &result) {
+                    result.clear();
+                    for (auto index = indices[geometry]; index < indices[geometry + 1]; ++index)
+                    {
+                        result.push_back(segments[index].weight);
+                    }
+                });
+    TimeLookups("delta encoded",
+                geometries,
+                encoded.SizeInBytes(),
+                segments.size(),
+                [&](const unsigned geometry, std::vector<NodeID> &result) {
+                    encoded.GetNodes(indices, geometry, result);
+                },
+                [&](const unsigned geometry, std::vector<EdgeWeight> &result) {
+                    encoded.GetWeights(indices, geometry, result);
+                });
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
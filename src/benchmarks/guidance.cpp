@@ -0,0 +1,262 @@
+#include "engine/guidance/leg_geometry.hpp"
+#include "engine/guidance/post_processing.hpp"
+#include "engine/guidance/route_step.hpp"
+#include "engine/guidance/step_maneuver.hpp"
+#include "engine/phantom_node.hpp"
+#include "extractor/guidance/turn_instruction.hpp"
+#include "extractor/guidance/turn_lane_types.hpp"
+#include "util/guidance/turn_lanes.hpp"
+#include "util/timing_util.hpp"
+
+#include "osrm/coordinate.hpp"
+
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdlib>
+
+namespace
+{
+using namespace osrm;
+using namespace osrm::engine;
+using namespace osrm::extractor::guidance;
+
+const constexpr std::size_t COORDINATES_PER_SEGMENT = 4;
+
+util::Coordinate MakeCoordinate(const std::size_t index)
+{
+    // a straight line going north from Monaco, roughly 10m between coordinates
+    return util::Coordinate{util::FloatLongitude{7.41}, util::FloatLatitude{43.73 + index * 1e-4}};
+}
+
+guidance::Intersection MakeIntersection(const util::Coordinate location,
+                                        const DirectionModifier::Enum modifier)
+{
+    // a four way intersection entered from the south, the exit depends on the modifier
+    std::size_t out = 0;
+    if (modifier == DirectionModifier::Right || modifier == DirectionModifier::SlightRight ||
+        modifier == DirectionModifier::SharpRight)
+        out = 1;
+    else if (modifier == DirectionModifier::Left || modifier == DirectionModifier::SlightLeft ||
+             modifier == DirectionModifier::SharpLeft)
+        out = 3;
+
+    return guidance::Intersection{location, {0, 90, 180, 270}, {true, true, false, true}, 2, out};
+}
+
+guidance::RouteStep MakeStep(const std::size_t step_index,
+                             const std::size_t geometry_begin,
+                             const std::size_t geometry_end,
+                             const util::Coordinate location,
+                             const TurnInstruction instruction,
+                             const guidance::WaypointType waypoint_type)
+{
+    // names stay above the small string optimization, copying them costs an allocation
+    const auto name_id = static_cast<unsigned>(step_index / 3);
+    const auto name = "Boulevard de Suisse et des Moulins " + std::to_string(name_id);
+
+    const bool is_waypoint = waypoint_type != guidance::WaypointType::None;
+    guidance::Intersection intersection =
+        is_waypoint ? guidance::Intersection{location, {0}, {true}, 0, 0}
+                    : MakeIntersection(location, instruction.direction_modifier);
+    if (waypoint_type == guidance::WaypointType::Depart)
+        intersection.in = guidance::Intersection::NO_INDEX;
+    if (waypoint_type == guidance::WaypointType::Arrive)
+        intersection.out = guidance::Intersection::NO_INDEX;
+
+    guidance::StepManeuver maneuver{location,
+                                    0,
+                                    intersection.bearings[is_waypoint ? 0 : intersection.out],
+                                    instruction,
+                                    waypoint_type,
+                                    0,
+                                    util::guidance::LaneTupel(),
+                                    {}};
+    if (!is_waypoint && step_index % 5 == 0)
+    {
+        maneuver.lanes = util::guidance::LaneTupel(1, 1);
+        maneuver.lane_description = {TurnLaneType::left,
+                                     TurnLaneType::straight | TurnLaneType::left,
+                                     TurnLaneType::straight,
+                                     TurnLaneType::right};
+    }
+
+    const double length = (geometry_end - geometry_begin - 1) * 10.;
+    return guidance::RouteStep{name_id,
+                               name,
+                               "",
+                               "Monte-Carlo",
+                               "",
+                               length / 10.,
+                               length,
+                               TRAVEL_MODE_DRIVING,
+                               std::move(maneuver),
+                               geometry_begin,
+                               geometry_end,
+                               {std::move(intersection)}};
+}
+
+// The turns the post-processing merges, removes or annotates, mixed with plain turns
+TurnInstruction RandomInstruction(std::mt19937 &generator, bool &on_roundabout)
+{
+    const auto pick = std::uniform_int_distribution<int>(0, 9)(generator);
+    if (on_roundabout)
+    {
+        // leave again after a few exits
+        on_roundabout = pick < 6;
+        return on_roundabout ? TurnInstruction{TurnType::StayOnRoundabout,
+                                               DirectionModifier::Straight}
+                             : TurnInstruction{TurnType::ExitRoundabout, DirectionModifier::Right};
+    }
+
+    switch (pick)
+    {
+    case 0:
+        return {TurnType::Turn, DirectionModifier::Left};
+    case 1:
+        return {TurnType::Turn, DirectionModifier::Right};
+    case 2:
+        return {TurnType::NewName, DirectionModifier::Straight};
+    case 3:
+        return {TurnType::Suppressed, DirectionModifier::Straight};
+    case 4:
+        return {TurnType::Continue, DirectionModifier::SlightLeft};
+    case 5:
+        on_roundabout = true;
+        return {TurnType::EnterRoundabout, DirectionModifier::Right};
+    case 6:
+        return {TurnType::EndOfRoad, DirectionModifier::Left};
+    case 7:
+        return {TurnType::Merge, DirectionModifier::SlightRight};
+    case 8:
+        return {TurnType::Sliproad, DirectionModifier::Right};
+    default:
+        return {TurnType::UseLane, DirectionModifier::Straight};
+    }
+}
+
+struct Leg
+{
+    guidance::LegGeometry geometry;
+    std::vector<guidance::RouteStep> steps;
+};
+
+Leg MakeLeg(std::mt19937 &generator, const std::size_t number_of_turns)
+{
+    Leg leg;
+    const auto number_of_segments = number_of_turns + 1;
+    const auto number_of_coordinates = number_of_segments * COORDINATES_PER_SEGMENT + 1;
+
+    for (std::size_t index = 0; index < number_of_coordinates; ++index)
+    {
+        leg.geometry.locations.push_back(MakeCoordinate(index));
+        leg.geometry.osm_node_ids.push_back(OSMNodeID{index});
+        if (index + 1 < number_of_coordinates)
+            leg.geometry.annotations.push_back({10., 1.});
+    }
+    for (std::size_t segment = 0; segment <= number_of_segments; ++segment)
+    {
+        leg.geometry.segment_offsets.push_back(segment * COORDINATES_PER_SEGMENT);
+        if (segment < number_of_segments)
+            leg.geometry.segment_distances.push_back(COORDINATES_PER_SEGMENT * 10.);
+    }
+
+    const auto &offsets = leg.geometry.segment_offsets;
+    leg.steps.reserve(number_of_segments + 1);
+    leg.steps.push_back(MakeStep(0,
+                                 offsets[0],
+                                 offsets[1] + 1,
+                                 leg.geometry.locations[offsets[0]],
+                                 TurnInstruction::NO_TURN(),
+                                 guidance::WaypointType::Depart));
+
+    bool on_roundabout = false;
+    for (std::size_t segment = 1; segment < number_of_segments; ++segment)
+    {
+        auto instruction = RandomInstruction(generator, on_roundabout);
+        // the last turn has to leave the roundabout
+        if (on_roundabout && segment + 1 == number_of_segments)
+            instruction = {TurnType::Turn, DirectionModifier::Right};
+        leg.steps.push_back(MakeStep(segment,
+                                     offsets[segment],
+                                     offsets[segment + 1] + 1,
+                                     leg.geometry.locations[offsets[segment]],
+                                     instruction,
+                                     guidance::WaypointType::None));
+    }
+
+    const auto last = leg.geometry.locations.size() - 1;
+    leg.steps.push_back(MakeStep(number_of_segments,
+                                 last,
+                                 last + 1,
+                                 leg.geometry.locations[last],
+                                 TurnInstruction::NO_TURN(),
+                                 guidance::WaypointType::Arrive));
+    return leg;
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " [steps per leg] [iterations]\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto steps_per_leg = argc > 1 ? std::stoul(argv[1]) : 100ul;
+    const auto iterations = argc > 2 ? std::stoul(argv[2]) : 1000ul;
+    if (steps_per_leg < 3 || iterations == 0)
+    {
+        std::cerr << "Legs need at least 3 steps and at least 1 iteration is needed\n";
+        return EXIT_FAILURE;
+    }
+
+    // the same legs on every run, so timings stay comparable
+    const auto NUM_LEGS = 16;
+    std::mt19937 generator(42);
+    std::vector<Leg> legs;
+    for (int i = 0; i < NUM_LEGS; ++i)
+    {
+        legs.push_back(MakeLeg(generator, steps_per_leg - 2));
+    }
+
+    PhantomNode source, target;
+    source.location = source.input_location = legs.front().geometry.locations.front();
+    target.location = target.input_location = legs.front().geometry.locations.back();
+
+    std::size_t output_steps = 0;
+    std::chrono::steady_clock::duration post_processing{};
+    for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (const auto &leg : legs)
+        {
+            // copy outside the timed section, the route service owns its steps as well
+            auto geometry = leg.geometry;
+            auto steps = leg.steps;
+
+            TIMER_START(leg);
+            guidance::postProcessLeg(steps, geometry, source, target);
+            TIMER_STOP(leg);
+            post_processing += leg_stop - leg_start;
+            output_steps += steps.size();
+        }
+    }
+
+    const auto total_legs = static_cast<double>(iterations * NUM_LEGS);
+    const auto total_usec =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(post_processing).count() / 1000.;
+    std::cout << "post-processing " << steps_per_leg << " steps: " << total_usec / total_legs
+              << "us/leg " << total_usec / (total_legs * steps_per_leg) << "us/step, "
+              << output_steps / total_legs << " steps remain" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
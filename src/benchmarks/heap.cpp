@@ -0,0 +1,485 @@
+#include "engine/datafacade/internal_datafacade.hpp"
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "storage/storage_config.hpp"
+#include "util/binary_heap.hpp"
+#include "util/make_unique.hpp"
+#include "util/timing_util.hpp"
+#include "util/typedefs.hpp"
+#include "util/xor_fast_hash_storage.hpp"
+
+#include "osrm/coordinate.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstdlib>
+
+namespace
+{
+using namespace osrm;
+using namespace osrm::engine::routing_algorithms;
+
+using DataFacadeT = engine::datafacade::InternalDataFacade;
+
+// One call of a search on its heap, replayed in the same order on every heap variant
+struct HeapOperation
+{
+    enum Type : std::uint8_t
+    {
+        Clear,
+        Insert,
+        DecreaseKey,
+        DeleteMin,
+        DeleteAll,
+        WasInserted,
+        GetKey
+    };
+
+    Type type;
+    NodeID node;
+    int weight;
+};
+
+// The calls of all searches that used one heap, each search starts with Clear
+using HeapTrace = std::vector<HeapOperation>;
+
+// The data of the witness searches of the contractor, GraphContractor::ContractorHeapData is
+// private. Constructible from a node id like engine::HeapData so that the replay can fill both.
+struct WitnessData
+{
+    WitnessData(NodeID) {}
+    WitnessData(short hop_, bool target_) : hop(hop_), target(target_) {}
+
+    short hop = 0;
+    bool target = false;
+};
+
+// Forwards to the heap and appends every call to the trace. The searches are templated on the
+// heap type, so hiding the methods of the heap is enough to see all of its calls.
+template <typename HeapT> class RecordingHeap : public HeapT
+{
+  public:
+    using Weight = typename HeapT::WeightType;
+    using Data = typename HeapT::DataType;
+
+    RecordingHeap(const std::size_t number_of_nodes, HeapTrace &trace)
+        : HeapT(number_of_nodes), trace(trace)
+    {
+    }
+
+    void Clear()
+    {
+        trace.push_back({HeapOperation::Clear, SPECIAL_NODEID, 0});
+        HeapT::Clear();
+    }
+
+    void Insert(const NodeID node, const Weight weight, const Data &data)
+    {
+        trace.push_back({HeapOperation::Insert, node, weight});
+        HeapT::Insert(node, weight, data);
+    }
+
+    void DecreaseKey(const NodeID node, const Weight weight)
+    {
+        trace.push_back({HeapOperation::DecreaseKey, node, weight});
+        HeapT::DecreaseKey(node, weight);
+    }
+
+    NodeID DeleteMin()
+    {
+        trace.push_back({HeapOperation::DeleteMin, SPECIAL_NODEID, 0});
+        return HeapT::DeleteMin();
+    }
+
+    void DeleteAll()
+    {
+        trace.push_back({HeapOperation::DeleteAll, SPECIAL_NODEID, 0});
+        HeapT::DeleteAll();
+    }
+
+    bool WasInserted(const NodeID node) const
+    {
+        trace.push_back({HeapOperation::WasInserted, node, 0});
+        return HeapT::WasInserted(node);
+    }
+
+    Weight &GetKey(const NodeID node)
+    {
+        trace.push_back({HeapOperation::GetKey, node, 0});
+        return HeapT::GetKey(node);
+    }
+
+  private:
+    HeapTrace &trace;
+};
+
+using RouteHeap = RecordingHeap<engine::SearchEngineData::DenseQueryHeap>;
+using WitnessHeap = RecordingHeap<
+    util::BinaryHeap<NodeID, NodeID, int, WitnessData, util::ArrayStorage<NodeID, int>>>;
+
+// Point to point searches between phantom nodes, the same searches as DirectShortestPathRouting
+// runs on a graph without core
+class TracingRouting final : public BasicRoutingInterface<DataFacadeT, TracingRouting>
+{
+    using super = BasicRoutingInterface<DataFacadeT, TracingRouting>;
+
+  public:
+    explicit TracingRouting(DataFacadeT *facade) : super(facade) {}
+
+    void operator()(const engine::PhantomNode &source,
+                    const engine::PhantomNode &target,
+                    RouteHeap &forward_heap,
+                    RouteHeap &reverse_heap) const
+    {
+        forward_heap.Clear();
+        reverse_heap.Clear();
+        if (source.forward_segment_id.enabled)
+        {
+            forward_heap.Insert(source.forward_segment_id.id,
+                                -source.GetForwardWeightPlusOffset(),
+                                source.forward_segment_id.id);
+        }
+        if (source.reverse_segment_id.enabled)
+        {
+            forward_heap.Insert(source.reverse_segment_id.id,
+                                -source.GetReverseWeightPlusOffset(),
+                                source.reverse_segment_id.id);
+        }
+        if (target.forward_segment_id.enabled)
+        {
+            reverse_heap.Insert(target.forward_segment_id.id,
+                                target.GetForwardWeightPlusOffset(),
+                                target.forward_segment_id.id);
+        }
+        if (target.reverse_segment_id.enabled)
+        {
+            reverse_heap.Insert(target.reverse_segment_id.id,
+                                target.GetReverseWeightPlusOffset(),
+                                target.reverse_segment_id.id);
+        }
+
+        EdgeWeight distance = INVALID_EDGE_WEIGHT;
+        std::vector<NodeID> packed_leg;
+        super::Search(forward_heap, reverse_heap, distance, packed_leg, false, false);
+    }
+};
+
+// The searches of a distance table: one exhaustive search up the hierarchy from every source
+// and against the edge direction from every target, like ManyToManyRouting without stalling
+void TraceTableSearch(const DataFacadeT &facade,
+                      const NodeID start,
+                      const bool forward_direction,
+                      RouteHeap &heap)
+{
+    heap.Clear();
+    heap.Insert(start, 0, start);
+    while (!heap.Empty())
+    {
+        const NodeID node = heap.DeleteMin();
+        const int distance = heap.GetKey(node);
+        for (const auto edge : facade.GetAdjacentEdgeRange(node))
+        {
+            const auto &data = facade.GetEdgeData(edge);
+            if (forward_direction ? !data.forward : !data.backward)
+            {
+                continue;
+            }
+            const NodeID to = facade.GetTarget(edge);
+            const int to_distance = distance + data.distance;
+            if (!heap.WasInserted(to))
+            {
+                heap.Insert(to, to_distance, node);
+            }
+            else if (to_distance < heap.GetKey(to))
+            {
+                heap.GetData(to).parent = node;
+                heap.DecreaseKey(to, to_distance);
+            }
+        }
+    }
+}
+
+// The witness search of the contractor when it contracts middle_node, run on the contracted
+// graph: from the first neighbor to all others while bypassing middle_node, bounded by the
+// longest path through middle_node and by the search space of GraphContractor::Dijkstra.
+void TraceWitnessSearch(const DataFacadeT &facade, const NodeID middle_node, WitnessHeap &heap)
+{
+    static const constexpr int FULL_SEARCH_SPACE_SIZE = 2000;
+
+    std::vector<std::pair<NodeID, int>> neighbors;
+    for (const auto edge : facade.GetAdjacentEdgeRange(middle_node))
+    {
+        neighbors.emplace_back(facade.GetTarget(edge), facade.GetEdgeData(edge).distance);
+    }
+    if (neighbors.size() < 2)
+    {
+        return;
+    }
+
+    heap.Clear();
+    const auto source = neighbors.front();
+    heap.Insert(source.first, 0, WitnessData{0, false});
+    int max_distance = 0;
+    unsigned number_of_targets = 0;
+    for (const auto &target : neighbors)
+    {
+        max_distance = std::max(max_distance, source.second + target.second);
+        if (!heap.WasInserted(target.first))
+        {
+            heap.Insert(target.first, INVALID_EDGE_WEIGHT, WitnessData{0, true});
+            ++number_of_targets;
+        }
+    }
+
+    int nodes = 0;
+    unsigned number_of_targets_found = 0;
+    while (!heap.Empty())
+    {
+        const NodeID node = heap.DeleteMin();
+        const int distance = heap.GetKey(node);
+        if (++nodes > FULL_SEARCH_SPACE_SIZE || distance > max_distance)
+        {
+            return;
+        }
+        if (heap.GetData(node).target && ++number_of_targets_found >= number_of_targets)
+        {
+            return;
+        }
+        for (const auto edge : facade.GetAdjacentEdgeRange(node))
+        {
+            const NodeID to = facade.GetTarget(edge);
+            if (to == middle_node)
+            {
+                continue;
+            }
+            const int to_distance = distance + facade.GetEdgeData(edge).distance;
+            if (!heap.WasInserted(to))
+            {
+                heap.Insert(to, to_distance, WitnessData{0, false});
+            }
+            else if (to_distance < heap.GetKey(to))
+            {
+                heap.DecreaseKey(to, to_distance);
+            }
+        }
+    }
+}
+
+// The most nodes a single search of the trace inserts into its heap
+std::size_t MaxInsertedNodes(const HeapTrace &trace)
+{
+    std::size_t max_inserted = 0, inserted = 0;
+    for (const auto &operation : trace)
+    {
+        if (operation.type == HeapOperation::Clear)
+        {
+            inserted = 0;
+        }
+        else if (operation.type == HeapOperation::Insert)
+        {
+            max_inserted = std::max(max_inserted, ++inserted);
+        }
+    }
+    return max_inserted;
+}
+
+template <typename HeapT>
+void Replay(const HeapTrace &trace, HeapT &heap, std::uint64_t &checksum)
+{
+    for (const auto &operation : trace)
+    {
+        switch (operation.type)
+        {
+        case HeapOperation::Clear:
+            heap.Clear();
+            break;
+        case HeapOperation::Insert:
+            heap.Insert(
+                operation.node, operation.weight, typename HeapT::DataType(operation.node));
+            break;
+        case HeapOperation::DecreaseKey:
+            heap.DecreaseKey(operation.node, operation.weight);
+            break;
+        case HeapOperation::DeleteMin:
+            checksum += heap.DeleteMin();
+            break;
+        case HeapOperation::DeleteAll:
+            heap.DeleteAll();
+            break;
+        case HeapOperation::WasInserted:
+            checksum += heap.WasInserted(operation.node);
+            break;
+        case HeapOperation::GetKey:
+            checksum += heap.GetKey(operation.node);
+            break;
+        }
+    }
+}
+
+// Replays the traces, each on a heap of its own, and prints the time per search. The settled
+// nodes have to match the ones of the first variant, otherwise the heap is broken.
+template <typename HeapT>
+void TimeReplay(const std::string &name,
+                const std::vector<HeapTrace> &traces,
+                const std::size_t number_of_nodes,
+                const std::size_t number_of_searches,
+                std::uint64_t &expected_checksum)
+{
+    std::vector<std::unique_ptr<HeapT>> heaps;
+    for (std::size_t i = 0; i < traces.size(); ++i)
+    {
+        heaps.push_back(util::make_unique<HeapT>(number_of_nodes));
+    }
+
+    std::uint64_t checksum = 0;
+    TIMER_START(replay);
+    for (std::size_t i = 0; i < traces.size(); ++i)
+    {
+        Replay(traces[i], *heaps[i], checksum);
+    }
+    TIMER_STOP(replay);
+
+    std::cout << "  " << name << ": "
+              << TIMER_USEC(replay) / std::max<std::size_t>(1, number_of_searches) << "us/search";
+    if (expected_checksum == 0)
+    {
+        expected_checksum = checksum;
+    }
+    else if (checksum != expected_checksum)
+    {
+        std::cout << " (replay differs from the first heap)";
+    }
+    std::cout << std::endl;
+}
+
+void TimeVariants(const std::string &name,
+                  const std::vector<HeapTrace> &traces,
+                  const std::size_t number_of_nodes)
+{
+    std::size_t number_of_searches = 0, number_of_operations = 0, max_inserted = 0;
+    for (const auto &trace : traces)
+    {
+        number_of_searches +=
+            std::count_if(trace.begin(), trace.end(), [](const HeapOperation &operation) {
+                return operation.type == HeapOperation::Clear;
+            });
+        number_of_operations += trace.size();
+        max_inserted = std::max(max_inserted, MaxInsertedNodes(trace));
+    }
+    std::cout << name << ": " << number_of_searches << " searches, "
+              << number_of_operations / std::max<std::size_t>(1, number_of_searches)
+              << " heap operations/search, at most " << max_inserted << " nodes inserted"
+              << std::endl;
+
+    using util::BinaryHeap;
+    using engine::HeapData;
+    std::uint64_t checksum = 0;
+    TimeReplay<BinaryHeap<NodeID, NodeID, int, HeapData, util::ArrayStorage<NodeID, int>>>(
+        "ArrayStorage", traces, number_of_nodes, number_of_searches, checksum);
+    TimeReplay<BinaryHeap<NodeID, NodeID, int, HeapData, util::UnorderedMapStorage<NodeID, int>>>(
+        "UnorderedMapStorage", traces, number_of_nodes, number_of_searches, checksum);
+    TimeReplay<BinaryHeap<NodeID, NodeID, int, HeapData, util::MapStorage<NodeID, int>>>(
+        "MapStorage", traces, number_of_nodes, number_of_searches, checksum);
+
+    // the hash table of the storage has a fixed size and no room for larger searches
+    if (max_inserted >= (1u << 16u))
+    {
+        std::cout << "  XORFastHashStorage: skipped, searches insert too many nodes" << std::endl;
+        return;
+    }
+    TimeReplay<BinaryHeap<NodeID, NodeID, int, HeapData, util::XORFastHashStorage<NodeID, NodeID>>>(
+        "XORFastHashStorage", traces, number_of_nodes, number_of_searches, checksum);
+    // the heap of the contractor, the same storage with the data of the witness searches
+    TimeReplay<
+        BinaryHeap<NodeID, NodeID, int, WitnessData, util::XORFastHashStorage<NodeID, NodeID>>>(
+        "ContractorHeap", traces, number_of_nodes, number_of_searches, checksum);
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " data.osrm [grid size] [witness searches]\n";
+        return EXIT_FAILURE;
+    }
+
+    using namespace osrm;
+
+    engine::datafacade::InternalDataFacade facade{storage::StorageConfig{argv[1]}};
+
+    const auto grid_size = argc > 2 ? std::stoul(argv[2]) : 10ul;
+    const auto number_of_witness_searches = argc > 3 ? std::stoul(argv[3]) : 10000ul;
+    const auto number_of_nodes = facade.GetNumberOfNodes();
+
+    using osrm::util::FloatLatitude;
+    using osrm::util::FloatLongitude;
+
+    // Square grid of coordinates in monaco, every pair is routed
+    const double min_lon = 7.41337, max_lon = 7.42194;
+    const double min_lat = 43.7315, max_lat = 43.7426;
+    std::vector<engine::PhantomNode> phantom_nodes;
+    for (std::size_t row = 0; row < grid_size; ++row)
+    {
+        for (std::size_t column = 0; column < grid_size; ++column)
+        {
+            const auto lon = min_lon + (max_lon - min_lon) * column / grid_size;
+            const auto lat = min_lat + (max_lat - min_lat) * row / grid_size;
+            const util::Coordinate coordinate{FloatLongitude{lon}, FloatLatitude{lat}};
+            phantom_nodes.push_back(
+                facade.NearestPhantomNodeWithAlternativeFromBigComponent(coordinate).first);
+        }
+    }
+
+    std::vector<HeapTrace> route_traces(2);
+    {
+        TracingRouting routing(&facade);
+        RouteHeap forward_heap(number_of_nodes, route_traces[0]);
+        RouteHeap reverse_heap(number_of_nodes, route_traces[1]);
+        for (const auto &source : phantom_nodes)
+        {
+            for (const auto &target : phantom_nodes)
+            {
+                routing(source, target, forward_heap, reverse_heap);
+            }
+        }
+    }
+
+    std::vector<HeapTrace> table_traces(1);
+    {
+        RouteHeap heap(number_of_nodes, table_traces[0]);
+        for (const auto &phantom : phantom_nodes)
+        {
+            TraceTableSearch(facade, phantom.forward_segment_id.id, true, heap);
+            TraceTableSearch(facade, phantom.forward_segment_id.id, false, heap);
+        }
+    }
+
+    std::vector<HeapTrace> witness_traces(1);
+    {
+        WitnessHeap heap(number_of_nodes, witness_traces[0]);
+        const auto step =
+            std::max<std::size_t>(1, number_of_nodes / std::max(1ul, number_of_witness_searches));
+        for (NodeID node = 0; node < number_of_nodes; node += step)
+        {
+            TraceWitnessSearch(facade, node, heap);
+        }
+    }
+
+    TimeVariants("Route", route_traces, number_of_nodes);
+    TimeVariants("Table", table_traces, number_of_nodes);
+    TimeVariants("Witness", witness_traces, number_of_nodes);
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
@@ -12,9 +12,14 @@
 #include <boost/assert.hpp>
 
 #include <exception>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <numeric>
+#include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <cstdlib>
 
@@ -22,7 +27,8 @@ int main(int argc, const char *argv[]) try
 {
     if (argc < 2)
     {
-        std::cerr << "Usage: " << argv[0] << " data.osrm\n";
+        std::cerr << "Usage: " << argv[0] << " data.osrm [traces]\n"
+                  << "traces holds one trace per line, as lon,lat;lon,lat;...\n";
         return EXIT_FAILURE;
     }
 
@@ -33,10 +39,7 @@ int main(int argc, const char *argv[]) try
     config.storage_config = {argv[1]};
     config.use_shared_memory = false;
 
-    // Routing machine with several services (such as Route, Table, Nearest, Trip, Match)
-    OSRM osrm{config};
-
-    // Route in monaco
+    // Trace in monaco
     MatchParameters params;
     params.overview = RouteParameters::OverviewType::False;
     params.steps = false;
@@ -210,22 +213,130 @@ int main(int argc, const char *argv[]) try
     params.coordinates.push_back(
         FloatCoordinate{FloatLongitude{7.415342330932617}, FloatLatitude{43.733251335381205}});
 
-    TIMER_START(routes);
-    auto NUM = 100;
-    for (int i = 0; i < NUM; ++i)
+    std::vector<MatchParameters> traces;
+    if (argc > 2)
+    {
+        std::ifstream traces_file(argv[2]);
+        std::string line;
+        while (std::getline(traces_file, line))
+        {
+            MatchParameters trace;
+            trace.overview = RouteParameters::OverviewType::False;
+            trace.steps = false;
+            std::istringstream coordinates(line);
+            double lon, lat;
+            char comma, semicolon;
+            while (coordinates >> lon >> comma >> lat)
+            {
+                trace.coordinates.push_back(
+                    FloatCoordinate{FloatLongitude{lon}, FloatLatitude{lat}});
+                coordinates >> semicolon;
+            }
+            if (trace.coordinates.size() > 1)
+            {
+                traces.push_back(std::move(trace));
+            }
+        }
+    }
+    else
     {
-        json::Object result;
-        const auto rc = osrm.Match(params, result);
-        if (rc != Status::Ok || result.values.at("matchings").get<json::Array>().values.size() != 1)
+        traces.push_back(params);
+    }
+    const auto number_of_coordinates =
+        std::accumulate(traces.begin(),
+                        traces.end(),
+                        std::size_t{0},
+                        [](const std::size_t sum, const MatchParameters &trace) {
+                            return sum + trace.coordinates.size();
+                        });
+
+    // Matched locations of all trace coordinates, or null if a coordinate was not matched
+    const auto match = [&](OSRM &osrm, std::vector<json::Value> &tracepoints) {
+        tracepoints.clear();
+        double confidence = 0;
+        for (const auto &trace : traces)
+        {
+            json::Object result;
+            const auto rc = osrm.Match(trace, result);
+            if (rc != Status::Ok)
+            {
+                tracepoints.resize(tracepoints.size() + trace.coordinates.size(), json::Null());
+                continue;
+            }
+            for (const auto &matching : result.values.at("matchings").get<json::Array>().values)
+            {
+                confidence += matching.get<json::Object>()
+                                  .values.at("confidence")
+                                  .get<json::Number>()
+                                  .value;
+            }
+            for (const auto &tracepoint :
+                 result.values.at("tracepoints").get<json::Array>().values)
+            {
+                if (tracepoint.is<json::Null>())
+                {
+                    tracepoints.push_back(json::Null());
+                }
+                else
+                {
+                    tracepoints.push_back(tracepoint.get<json::Object>().values.at("location"));
+                }
+            }
+        }
+        return confidence;
+    };
+
+    const auto same_location = [](const json::Value &lhs, const json::Value &rhs) {
+        if (lhs.is<json::Null>() || rhs.is<json::Null>())
         {
-            return EXIT_FAILURE;
+            return lhs.is<json::Null>() && rhs.is<json::Null>();
         }
+        const auto &lhs_location = lhs.get<json::Array>().values;
+        const auto &rhs_location = rhs.get<json::Array>().values;
+        return lhs_location[0].get<json::Number>().value ==
+                   rhs_location[0].get<json::Number>().value &&
+               lhs_location[1].get<json::Number>().value ==
+                   rhs_location[1].get<json::Number>().value;
+    };
+
+    // Quality vs. speed of the Viterbi beams, compared with the matching that expands all states
+    const std::vector<std::pair<int, double>> beams = {
+        {0, 0.}, {10, 0.}, {5, 0.}, {3, 0.}, {2, 0.}, {0, 20.}, {0, 10.}, {5, 10.}};
+    std::vector<json::Value> reference_tracepoints;
+    std::vector<json::Value> tracepoints;
+    for (const auto &beam : beams)
+    {
+        config.matching_beam_width = beam.first;
+        config.matching_beam_range = beam.second;
+        OSRM osrm{config};
+
+        const auto confidence = match(osrm, tracepoints);
+        if (reference_tracepoints.empty())
+        {
+            reference_tracepoints = tracepoints;
+        }
+        const auto unchanged = std::inner_product(tracepoints.begin(),
+                                                  tracepoints.end(),
+                                                  reference_tracepoints.begin(),
+                                                  std::size_t{0},
+                                                  std::plus<std::size_t>(),
+                                                  same_location);
+
+        TIMER_START(routes);
+        auto NUM = 100;
+        for (int i = 0; i < NUM; ++i)
+        {
+            match(osrm, tracepoints);
+        }
+        TIMER_STOP(routes);
+
+        std::cout << "beam width " << beam.first << ", range " << beam.second << ": "
+                  << (TIMER_MSEC(routes) / NUM) << "ms/req at " << number_of_coordinates
+                  << " coordinates, " << (TIMER_MSEC(routes) / NUM / number_of_coordinates)
+                  << "ms/coordinate, confidence " << confidence << ", " << unchanged << "/"
+                  << number_of_coordinates << " coordinates matched as without beam"
+                  << std::endl;
     }
-    TIMER_STOP(routes);
-    std::cout << (TIMER_MSEC(routes) / NUM) << "ms/req at " << params.coordinates.size()
-              << " coordinate" << std::endl;
-    std::cout << (TIMER_MSEC(routes) / NUM / params.coordinates.size()) << "ms/coordinate"
-              << std::endl;
 
     return EXIT_SUCCESS;
 }
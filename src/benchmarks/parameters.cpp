@@ -0,0 +1,92 @@
+#include "server/api/parameters_parser.hpp"
+#include "server/api/url_parser.hpp"
+#include "util/timing_util.hpp"
+
+#include "osrm/nearest_parameters.hpp"
+#include "osrm/route_parameters.hpp"
+#include "osrm/table_parameters.hpp"
+
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <cstdlib>
+
+namespace
+{
+using namespace osrm;
+
+// Coordinates around Monaco with the six decimal places clients usually send
+std::string MakeCoordinates(const std::size_t number_of_coordinates)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> lon(7.40, 7.44);
+    std::uniform_real_distribution<double> lat(43.72, 43.75);
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(6);
+    for (std::size_t index = 0; index < number_of_coordinates; ++index)
+    {
+        if (index > 0)
+            out << ';';
+        out << lon(generator) << ',' << lat(generator);
+    }
+    return out.str();
+}
+
+template <typename ParameterT>
+void TimeParsing(const char *name, const std::string &url, const std::size_t iterations)
+{
+    std::size_t coordinates = 0;
+    TIMER_START(parsing);
+    for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+    {
+        auto parsed_url = server::api::parseURL(url);
+        if (!parsed_url)
+            throw std::runtime_error(std::string(name) + ": the url does not parse");
+
+        auto iter = parsed_url->query.begin();
+        const auto parameters =
+            server::api::parseParameters<ParameterT>(iter, parsed_url->query.end());
+        if (!parameters)
+            throw std::runtime_error(std::string(name) + ": the query does not parse");
+        coordinates += parameters->coordinates.size();
+    }
+    TIMER_STOP(parsing);
+
+    std::cout << name << ": " << TIMER_NSEC(parsing) / static_cast<double>(iterations)
+              << "ns/request " << TIMER_NSEC(parsing) / static_cast<double>(coordinates)
+              << "ns/coordinate" << std::endl;
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc > 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [iterations]\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto iterations = argc > 1 ? std::stoul(argv[1]) : 10000ul;
+
+    TimeParsing<engine::api::NearestParameters>(
+        "nearest", "/nearest/v1/driving/" + MakeCoordinates(1) + "?number=3", iterations);
+    TimeParsing<engine::api::RouteParameters>("route",
+                                              "/route/v1/driving/" + MakeCoordinates(25) +
+                                                  "?overview=false&steps=true&alternatives=true",
+                                              iterations);
+    TimeParsing<engine::api::TableParameters>(
+        "table", "/table/v1/driving/" + MakeCoordinates(500) + "?sources=0;1;2", iterations / 10);
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
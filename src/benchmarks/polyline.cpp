@@ -0,0 +1,90 @@
+#include "engine/polyline_compressor.hpp"
+#include "util/timing_util.hpp"
+
+#include "osrm/coordinate.hpp"
+
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace
+{
+using namespace osrm;
+
+// A random walk through Monaco with steps of up to about 50m, like the geometry of a long route
+std::vector<util::Coordinate> MakeGeometry(const std::size_t number_of_coordinates)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<std::int32_t> step(-500, 500);
+
+    std::vector<util::Coordinate> geometry;
+    geometry.reserve(number_of_coordinates);
+    util::Coordinate current{util::FloatLongitude{7.41}, util::FloatLatitude{43.73}};
+    for (std::size_t index = 0; index < number_of_coordinates; ++index)
+    {
+        geometry.push_back(current);
+        const auto lon = static_cast<std::int32_t>(current.lon) + step(generator);
+        const auto lat = static_cast<std::int32_t>(current.lat) + step(generator);
+        current = util::Coordinate{util::FixedLongitude{lon}, util::FixedLatitude{lat}};
+    }
+    return geometry;
+}
+
+void TimeEncoding(const char *name,
+                  const std::vector<util::Coordinate> &geometry,
+                  const std::size_t iterations,
+                  const double precision)
+{
+    std::size_t characters = 0;
+    TIMER_START(encoding);
+    for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+    {
+        characters += engine::encodePolyline(geometry.begin(), geometry.end(), precision).size();
+    }
+    TIMER_STOP(encoding);
+
+    const auto coordinates = static_cast<double>(geometry.size() * iterations);
+    std::cout << name << ": " << TIMER_NSEC(encoding) / coordinates << "ns/coordinate "
+              << characters / (TIMER_USEC(encoding) + 1.) << "MB/s "
+              << characters / coordinates << " characters/coordinate" << std::endl;
+
+    // the benchmark is only meaningful if the encoding is right
+    const auto polyline = engine::encodePolyline(geometry.begin(), geometry.end(), precision);
+    const auto decoded = engine::decodePolyline(polyline, precision);
+    if (decoded.size() != geometry.size() ||
+        (precision == engine::detail::POLYLINE6_PRECISION && decoded != geometry))
+    {
+        throw std::runtime_error(std::string(name) + " does not decode to the geometry");
+    }
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " [coordinates] [iterations]\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto number_of_coordinates = argc > 1 ? std::stoul(argv[1]) : 10000ul;
+    const auto iterations = argc > 2 ? std::stoul(argv[2]) : 1000ul;
+
+    const auto geometry = MakeGeometry(number_of_coordinates);
+
+    TimeEncoding("polyline", geometry, iterations, engine::detail::POLYLINE_PRECISION);
+    TimeEncoding("polyline6", geometry, iterations, engine::detail::POLYLINE6_PRECISION);
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
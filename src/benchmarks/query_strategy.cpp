@@ -0,0 +1,234 @@
+#include "engine/datafacade/internal_datafacade.hpp"
+#include "engine/routing_algorithms/query_strategy.hpp"
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "engine/search_statistics.hpp"
+#include "storage/storage_config.hpp"
+#include "util/timing_util.hpp"
+
+#include "osrm/coordinate.hpp"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <cstdlib>
+
+namespace
+{
+using namespace osrm;
+using namespace osrm::engine::routing_algorithms;
+
+using DataFacadeT = engine::datafacade::InternalDataFacade;
+using QueryHeap = engine::SearchEngineData::QueryHeap;
+using DenseQueryHeap = engine::SearchEngineData::DenseQueryHeap;
+
+// Point to point searches between phantom nodes with a given query strategy, the same searches
+// as DirectShortestPathRouting runs
+class StrategyRouting final : public BasicRoutingInterface<DataFacadeT, StrategyRouting>
+{
+    using super = BasicRoutingInterface<DataFacadeT, StrategyRouting>;
+
+  public:
+    explicit StrategyRouting(DataFacadeT *facade) : super(facade) {}
+
+    template <typename Strategy, typename HeapT = QueryHeap>
+    EdgeWeight operator()(const engine::PhantomNode &source, const engine::PhantomNode &target)
+    {
+        const auto number_of_nodes = facade->GetNumberOfNodes();
+        auto forward_heap_handle = engine::SearchEngineData::GetHeap<HeapT>(number_of_nodes);
+        auto reverse_heap_handle = engine::SearchEngineData::GetHeap<HeapT>(number_of_nodes);
+        HeapT &forward_heap = *forward_heap_handle;
+        HeapT &reverse_heap = *reverse_heap_handle;
+
+        if (source.forward_segment_id.enabled)
+        {
+            forward_heap.Insert(source.forward_segment_id.id,
+                                -source.GetForwardWeightPlusOffset(),
+                                source.forward_segment_id.id);
+        }
+        if (source.reverse_segment_id.enabled)
+        {
+            forward_heap.Insert(source.reverse_segment_id.id,
+                                -source.GetReverseWeightPlusOffset(),
+                                source.reverse_segment_id.id);
+        }
+        if (target.forward_segment_id.enabled)
+        {
+            reverse_heap.Insert(target.forward_segment_id.id,
+                                target.GetForwardWeightPlusOffset(),
+                                target.forward_segment_id.id);
+        }
+        if (target.reverse_segment_id.enabled)
+        {
+            reverse_heap.Insert(target.reverse_segment_id.id,
+                                target.GetReverseWeightPlusOffset(),
+                                target.reverse_segment_id.id);
+        }
+
+        return Search<Strategy>(forward_heap, reverse_heap);
+    }
+
+  private:
+    template <typename Strategy> EdgeWeight Search(QueryHeap &forward_heap, QueryHeap &reverse_heap)
+    {
+        EdgeWeight distance = INVALID_EDGE_WEIGHT;
+        std::vector<NodeID> packed_leg;
+        if (facade->GetCoreSize() > 0)
+        {
+            const auto number_of_nodes = facade->GetNumberOfNodes();
+            auto forward_core_heap_handle =
+                engine::SearchEngineData::GetHeap<QueryHeap>(number_of_nodes);
+            auto reverse_core_heap_handle =
+                engine::SearchEngineData::GetHeap<QueryHeap>(number_of_nodes);
+            super::SearchWithCore<Strategy>(forward_heap,
+                                            reverse_heap,
+                                            *forward_core_heap_handle,
+                                            *reverse_core_heap_handle,
+                                            distance,
+                                            packed_leg,
+                                            false,
+                                            false);
+        }
+        else
+        {
+            super::Search<Strategy>(forward_heap, reverse_heap, distance, packed_leg, false, false);
+        }
+        return distance;
+    }
+
+    // the core search only takes the hash map heaps, see main
+    template <typename Strategy, typename HeapT>
+    EdgeWeight Search(HeapT &forward_heap, HeapT &reverse_heap)
+    {
+        EdgeWeight distance = INVALID_EDGE_WEIGHT;
+        std::vector<NodeID> packed_leg;
+        super::Search<Strategy>(forward_heap, reverse_heap, distance, packed_leg, false, false);
+        return distance;
+    }
+};
+
+// Runs all searches with the strategy, prints the time per search and the size of the search
+// spaces and fails if a distance differs from the one of the default strategy
+template <typename Strategy, typename HeapT = QueryHeap>
+bool TimeStrategy(const std::string &name,
+                  StrategyRouting &routing,
+                  const std::vector<engine::PhantomNode> &phantom_nodes,
+                  const std::vector<EdgeWeight> &expected)
+{
+    std::vector<EdgeWeight> distances;
+    distances.reserve(phantom_nodes.size() * phantom_nodes.size());
+    engine::SearchStatistics statistics;
+    {
+        const engine::SearchStatisticsScope statistics_scope(&statistics);
+        TIMER_START(searches);
+        for (const auto &source : phantom_nodes)
+        {
+            for (const auto &target : phantom_nodes)
+            {
+                distances.push_back(routing.operator()<Strategy, HeapT>(source, target));
+            }
+        }
+        TIMER_STOP(searches);
+        std::cout << name << ": " << TIMER_MSEC(searches) * 1000 / distances.size()
+                  << "us/search, " << statistics.settled_nodes / distances.size()
+                  << " settled, " << statistics.stalled_nodes / distances.size() << " stalled, "
+                  << statistics.relaxed_edges / distances.size() << " relaxed" << std::endl;
+    }
+
+    if (!expected.empty() && distances != expected)
+    {
+        std::cerr << name << " finds different distances than the default strategy"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <typename Stalling, typename Termination>
+bool TimeInterleavings(const std::string &name,
+                       StrategyRouting &routing,
+                       const std::vector<engine::PhantomNode> &phantom_nodes,
+                       const std::vector<EdgeWeight> &expected)
+{
+    return TimeStrategy<QueryStrategy<Stalling, Termination, Alternating>>(
+               name + ", Alternating", routing, phantom_nodes, expected) &&
+           TimeStrategy<QueryStrategy<Stalling, Termination, SmallerKeyFirst>>(
+               name + ", SmallerKeyFirst", routing, phantom_nodes, expected) &&
+           TimeStrategy<QueryStrategy<Stalling, Termination, SmallerHeapFirst>>(
+               name + ", SmallerHeapFirst", routing, phantom_nodes, expected);
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " data.osrm [grid size]\n";
+        return EXIT_FAILURE;
+    }
+
+    using namespace osrm;
+
+    engine::datafacade::InternalDataFacade facade{storage::StorageConfig{argv[1]}};
+
+    const auto grid_size = argc > 2 ? std::stoul(argv[2]) : 10ul;
+
+    using osrm::util::FloatLatitude;
+    using osrm::util::FloatLongitude;
+
+    // Square grid of coordinates in monaco, every pair is searched
+    const double min_lon = 7.41337, max_lon = 7.42194;
+    const double min_lat = 43.7315, max_lat = 43.7426;
+    std::vector<engine::PhantomNode> phantom_nodes;
+    for (std::size_t row = 0; row < grid_size; ++row)
+    {
+        for (std::size_t column = 0; column < grid_size; ++column)
+        {
+            const auto lon = min_lon + (max_lon - min_lon) * column / grid_size;
+            const auto lat = min_lat + (max_lat - min_lat) * row / grid_size;
+            const util::Coordinate coordinate{FloatLongitude{lon}, FloatLatitude{lat}};
+            phantom_nodes.push_back(
+                facade.NearestPhantomNodeWithAlternativeFromBigComponent(coordinate).first);
+        }
+    }
+
+    StrategyRouting routing(&facade);
+    std::vector<EdgeWeight> expected;
+    expected.reserve(phantom_nodes.size() * phantom_nodes.size());
+    for (const auto &source : phantom_nodes)
+    {
+        for (const auto &target : phantom_nodes)
+        {
+            expected.push_back(routing.operator()<DefaultQueryStrategy>(source, target));
+        }
+    }
+
+    // the dense heap prefetches the heap slots of the targets of each settled node's edges, the
+    // search with a core only takes hash map heaps
+    const bool same_heap_distances =
+        facade.GetCoreSize() > 0 ||
+        (TimeStrategy<DefaultQueryStrategy, QueryHeap>(
+             "Hash map heap", routing, phantom_nodes, expected) &&
+         TimeStrategy<DefaultQueryStrategy, DenseQueryHeap>(
+             "Dense heap with prefetching", routing, phantom_nodes, expected));
+
+    const bool same_distances =
+        same_heap_distances &&
+        TimeInterleavings<StallOnDemand, StopAtUpperBound>(
+            "StallOnDemand, StopAtUpperBound", routing, phantom_nodes, expected) &&
+        TimeInterleavings<StallOnDemand, PruneAtUpperBound>(
+            "StallOnDemand, PruneAtUpperBound", routing, phantom_nodes, expected) &&
+        TimeInterleavings<NoStalling, StopAtUpperBound>(
+            "NoStalling, StopAtUpperBound", routing, phantom_nodes, expected) &&
+        TimeInterleavings<NoStalling, PruneAtUpperBound>(
+            "NoStalling, PruneAtUpperBound", routing, phantom_nodes, expected);
+
+    return same_distances ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
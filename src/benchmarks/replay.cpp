@@ -0,0 +1,356 @@
+#include "server/api/parameters_parser.hpp"
+#include "server/api/url_parser.hpp"
+#include "util/json_renderer.hpp"
+#include "util/string_util.hpp"
+
+#include "osrm/match_parameters.hpp"
+#include "osrm/nearest_parameters.hpp"
+#include "osrm/route_parameters.hpp"
+#include "osrm/table_parameters.hpp"
+#include "osrm/tile_parameters.hpp"
+#include "osrm/trip_parameters.hpp"
+
+#include "osrm/engine_config.hpp"
+#include "osrm/json_container.hpp"
+#include "osrm/osrm.hpp"
+#include "osrm/status.hpp"
+
+#include <boost/optional.hpp>
+#include <boost/variant.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cstdlib>
+
+namespace
+{
+using namespace osrm;
+
+using Clock = std::chrono::steady_clock;
+
+enum Service
+{
+    ROUTE,
+    TABLE,
+    NEAREST,
+    TRIP,
+    MATCH,
+    TILE,
+    NUM_SERVICES
+};
+const constexpr char *SERVICE_NAMES[NUM_SERVICES] = {
+    "route", "table", "nearest", "trip", "match", "tile"};
+
+using Parameters = boost::variant<RouteParameters,
+                                  TableParameters,
+                                  NearestParameters,
+                                  TripParameters,
+                                  MatchParameters,
+                                  TileParameters>;
+
+// Parameters of a request in the order of the variant, see Service
+struct Request
+{
+    Service service;
+    Parameters parameters;
+};
+
+// Returns the string value of a top-level "url" member of a JSON object on one line. Only the
+// escapes that can appear in URLs are decoded.
+boost::optional<std::string> ExtractJSONURL(const std::string &line)
+{
+    const std::string member = "\"url\"";
+    auto position = line.find(member);
+    if (position == std::string::npos)
+    {
+        return boost::none;
+    }
+    position = line.find('"', line.find(':', position + member.size()));
+    if (position == std::string::npos)
+    {
+        return boost::none;
+    }
+
+    std::string url;
+    for (++position; position < line.size() && line[position] != '"'; ++position)
+    {
+        if (line[position] == '\\' && position + 1 < line.size())
+        {
+            ++position;
+        }
+        url.push_back(line[position]);
+    }
+    if (position == line.size())
+    {
+        return boost::none;
+    }
+    return url;
+}
+
+// Lines are plain URLs (/route/v1/driving/... with or without http://host), lines of the
+// osrm-routed access log, which end with the requested URL, or JSON objects with a "url"
+// member.
+boost::optional<std::string> ExtractURL(const std::string &line)
+{
+    if (!line.empty() && line.front() == '{')
+    {
+        const auto url = ExtractJSONURL(line);
+        return url ? ExtractURL(*url) : boost::none;
+    }
+
+    const auto scheme = line.find("://");
+    if (scheme != std::string::npos)
+    {
+        const auto path = line.find('/', scheme + 3);
+        if (path == std::string::npos)
+        {
+            return boost::none;
+        }
+        return line.substr(path);
+    }
+    if (!line.empty() && line.front() == '/')
+    {
+        return line;
+    }
+    const auto path = line.rfind(" /");
+    if (path == std::string::npos)
+    {
+        return boost::none;
+    }
+    return line.substr(path + 1);
+}
+
+template <typename ParameterT>
+boost::optional<Request> ParseRequest(const Service service, const std::string &query)
+{
+    auto parameters = server::api::parseParameters<ParameterT>(query);
+    if (!parameters || !parameters->IsValid())
+    {
+        return boost::none;
+    }
+    return Request{service, std::move(*parameters)};
+}
+
+boost::optional<Request> ParseRequest(const std::string &line)
+{
+    const auto url = ExtractURL(line);
+    if (!url)
+    {
+        return boost::none;
+    }
+
+    std::string decoded_url;
+    util::URIDecode(*url, decoded_url);
+    const auto parsed_url = server::api::parseURL(decoded_url);
+    if (!parsed_url)
+    {
+        return boost::none;
+    }
+
+    const auto &service = parsed_url->service;
+    if (service == SERVICE_NAMES[ROUTE])
+        return ParseRequest<RouteParameters>(ROUTE, parsed_url->query);
+    if (service == SERVICE_NAMES[TABLE])
+        return ParseRequest<TableParameters>(TABLE, parsed_url->query);
+    if (service == SERVICE_NAMES[NEAREST])
+        return ParseRequest<NearestParameters>(NEAREST, parsed_url->query);
+    if (service == SERVICE_NAMES[TRIP])
+        return ParseRequest<TripParameters>(TRIP, parsed_url->query);
+    if (service == SERVICE_NAMES[MATCH])
+        return ParseRequest<MatchParameters>(MATCH, parsed_url->query);
+    if (service == SERVICE_NAMES[TILE])
+        return ParseRequest<TileParameters>(TILE, parsed_url->query);
+    return boost::none;
+}
+
+// Answers a request and renders the response the way osrm-routed does, so the replay runs the
+// same code as the server. This is what the profiles of make pgo-profile are collected from.
+struct RunRequest : boost::static_visitor<Status>
+{
+    explicit RunRequest(OSRM &osrm) : osrm(osrm) {}
+
+    template <typename ParameterT> Status operator()(const ParameterT &parameters) const
+    {
+        json::Object result;
+        const auto status = Run(parameters, result);
+        response.clear();
+        util::json::render(response, result);
+        return status;
+    }
+
+    Status operator()(const TileParameters &parameters) const
+    {
+        std::string result;
+        return osrm.Tile(parameters, result);
+    }
+
+    Status Run(const RouteParameters &parameters, json::Object &result) const
+    {
+        return osrm.Route(parameters, result);
+    }
+    Status Run(const TableParameters &parameters, json::Object &result) const
+    {
+        return osrm.Table(parameters, result);
+    }
+    Status Run(const NearestParameters &parameters, json::Object &result) const
+    {
+        return osrm.Nearest(parameters, result);
+    }
+    Status Run(const TripParameters &parameters, json::Object &result) const
+    {
+        return osrm.Trip(parameters, result);
+    }
+    Status Run(const MatchParameters &parameters, json::Object &result) const
+    {
+        return osrm.Match(parameters, result);
+    }
+
+    OSRM &osrm;
+    // reused by all requests of a thread
+    mutable std::vector<char> response;
+};
+
+struct Latencies
+{
+    std::array<std::vector<double>, NUM_SERVICES> ms;
+    std::array<std::size_t, NUM_SERVICES> errors{};
+};
+
+double Percentile(const std::vector<double> &sorted_ms, const double percentile)
+{
+    const auto rank = static_cast<std::size_t>(percentile / 100. * (sorted_ms.size() - 1) + 0.5);
+    return sorted_ms[rank];
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " data.osrm requests.log [threads] [passes]\n"
+                  << "Replays the route, table, nearest, trip, match and tile requests of a file "
+                     "with one URL, osrm-routed access log line or JSON object with a url per "
+                     "line.\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto number_of_threads =
+        argc > 3 ? std::stoul(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+    const auto number_of_passes = argc > 4 ? std::stoul(argv[4]) : 1ul;
+
+    std::vector<Request> requests;
+    std::size_t skipped_lines = 0;
+    {
+        std::ifstream log(argv[2]);
+        if (!log)
+        {
+            std::cerr << "Could not open " << argv[2] << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::string line;
+        while (std::getline(log, line))
+        {
+            if (auto request = ParseRequest(line))
+            {
+                requests.push_back(std::move(*request));
+            }
+            else
+            {
+                ++skipped_lines;
+            }
+        }
+    }
+    if (requests.empty())
+    {
+        std::cerr << "No requests to replay in " << argv[2] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Configure based on a .osrm base path, and no datasets in shared mem from osrm-datastore
+    EngineConfig config;
+    config.storage_config = {argv[1]};
+    config.use_shared_memory = false;
+    OSRM osrm{config};
+
+    // every thread takes the next request of the log, so they finish at about the same time
+    const auto number_of_runs = requests.size() * number_of_passes;
+    std::atomic<std::size_t> next_run{0};
+    std::vector<Latencies> thread_latencies(number_of_threads);
+    std::vector<std::thread> threads;
+
+    const auto start = Clock::now();
+    for (std::size_t thread = 0; thread < number_of_threads; ++thread)
+    {
+        threads.emplace_back([&, thread] {
+            const RunRequest run_request{osrm};
+            auto &latencies = thread_latencies[thread];
+            for (auto run = next_run++; run < number_of_runs; run = next_run++)
+            {
+                const auto &request = requests[run % requests.size()];
+                const auto request_start = Clock::now();
+                const auto status = boost::apply_visitor(run_request, request.parameters);
+                const std::chrono::duration<double, std::milli> duration =
+                    Clock::now() - request_start;
+
+                latencies.ms[request.service].push_back(duration.count());
+                latencies.errors[request.service] += status == Status::Ok ? 0 : 1;
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    const std::chrono::duration<double> wall_time = Clock::now() - start;
+
+    std::cout << "Replayed " << requests.size() << " requests " << number_of_passes
+              << "x on " << number_of_threads << " threads in " << wall_time.count() << "s, "
+              << skipped_lines << " lines skipped\n";
+    std::cout << std::left << std::setw(10) << "service" << std::right << std::setw(10)
+              << "requests" << std::setw(8) << "errors" << std::setw(12) << "req/s"
+              << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms" << std::setw(10)
+              << "p99 ms" << std::setw(10) << "p99.9 ms" << std::setw(10) << "max ms"
+              << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (std::size_t service = 0; service < NUM_SERVICES; ++service)
+    {
+        std::vector<double> ms;
+        std::size_t errors = 0;
+        for (const auto &latencies : thread_latencies)
+        {
+            ms.insert(ms.end(), latencies.ms[service].begin(), latencies.ms[service].end());
+            errors += latencies.errors[service];
+        }
+        if (ms.empty())
+        {
+            continue;
+        }
+        std::sort(ms.begin(), ms.end());
+
+        // throughput of the service while all threads were busy with the whole log
+        std::cout << std::left << std::setw(10) << SERVICE_NAMES[service] << std::right
+                  << std::setw(10) << ms.size() << std::setw(8) << errors << std::setw(12)
+                  << ms.size() / wall_time.count() << std::setw(10) << Percentile(ms, 50)
+                  << std::setw(10) << Percentile(ms, 90) << std::setw(10) << Percentile(ms, 99)
+                  << std::setw(10) << Percentile(ms, 99.9) << std::setw(10) << ms.back()
+                  << "\n";
+    }
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
@@ -4,8 +4,11 @@
 #include "mocks/mock_datafacade.hpp"
 #include "engine/geospatial_query.hpp"
 #include "util/coordinate.hpp"
+#include "util/coordinate_calculation.hpp"
 #include "util/timing_util.hpp"
+#include "util/web_mercator.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <random>
 
@@ -86,6 +89,57 @@ void benchmark(BenchStaticRTree &rtree, unsigned num_queries)
         return rtree.Nearest(q, 10);
     });
 }
+
+// Compares the scalar projection against the leaf scan kernel on leaf sized batches
+void benchmarkLeafScan(const std::vector<util::Coordinate> &coords, unsigned num_queries)
+{
+    const constexpr std::size_t LEAF_NODE_SIZE = BenchStaticRTree::LEAF_NODE_SIZE;
+
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<std::size_t> index_udist(0, coords.size() - 2);
+    std::vector<util::FloatCoordinate> sources(LEAF_NODE_SIZE);
+    std::vector<util::FloatCoordinate> targets(LEAF_NODE_SIZE);
+    std::vector<util::FloatCoordinate> queries(num_queries);
+    for (std::size_t i = 0; i < LEAF_NODE_SIZE; ++i)
+    {
+        const auto index = index_udist(mt_rand);
+        sources[i] = util::web_mercator::fromWGS84(coords[index]);
+        targets[i] = util::web_mercator::fromWGS84(coords[index + 1]);
+    }
+    std::generate(queries.begin(), queries.end(), [&] {
+        return util::web_mercator::fromWGS84(coords[index_udist(mt_rand)]);
+    });
+
+    std::vector<util::FloatCoordinate> nearest(LEAF_NODE_SIZE);
+    double checksum = 0;
+
+    TIMER_START(scalar);
+    for (const auto &q : queries)
+    {
+        for (std::size_t i = 0; i < LEAF_NODE_SIZE; ++i)
+        {
+            nearest[i] =
+                util::coordinate_calculation::projectPointOnSegment(sources[i], targets[i], q)
+                    .second;
+        }
+        checksum += static_cast<double>(nearest.back().lon);
+    }
+    TIMER_STOP(scalar);
+
+    TIMER_START(kernel);
+    for (const auto &q : queries)
+    {
+        util::coordinate_calculation::projectPointOnSegments(
+            sources.data(), targets.data(), LEAF_NODE_SIZE, q, nearest.data());
+        checksum -= static_cast<double>(nearest.back().lon);
+    }
+    TIMER_STOP(kernel);
+
+    std::cout << "Leaf scan of " << LEAF_NODE_SIZE << " segments: scalar "
+              << TIMER_USEC(scalar) / queries.size() << " us/leaf, kernel "
+              << TIMER_USEC(kernel) / queries.size() << " us/leaf (checksum " << checksum << ")"
+              << std::endl;
+}
 }
 }
 
@@ -107,6 +161,7 @@ int main(int argc, char **argv)
     osrm::benchmarks::BenchStaticRTree rtree(ram_path, file_path, coords);
 
     osrm::benchmarks::benchmark(rtree, 10000);
+    osrm::benchmarks::benchmarkLeafScan(coords, 100000);
 
     return 0;
 }
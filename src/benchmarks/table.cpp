@@ -0,0 +1,83 @@
+#include "util/timing_util.hpp"
+
+#include "osrm/table_parameters.hpp"
+
+#include "osrm/coordinate.hpp"
+#include "osrm/engine_config.hpp"
+#include "osrm/json_container.hpp"
+
+#include "osrm/osrm.hpp"
+#include "osrm/status.hpp"
+
+#include <boost/assert.hpp>
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include <cstdlib>
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " data.osrm [grid size]\n";
+        return EXIT_FAILURE;
+    }
+
+    using namespace osrm;
+
+    // Configure based on a .osrm base path, and no datasets in shared mem from osrm-datastore
+    EngineConfig config;
+    config.storage_config = {argv[1]};
+    config.use_shared_memory = false;
+
+    // Routing machine with several services (such as Route, Table, Nearest, Trip, Match)
+    OSRM osrm{config};
+
+    const auto grid_size = argc > 2 ? std::stoul(argv[2]) : 10ul;
+
+    // Square grid of coordinates in monaco, every one is a source and a target
+    TableParameters params;
+
+    using osrm::util::FloatCoordinate;
+    using osrm::util::FloatLatitude;
+    using osrm::util::FloatLongitude;
+
+    const double min_lon = 7.41337, max_lon = 7.42194;
+    const double min_lat = 43.7315, max_lat = 43.7426;
+    for (std::size_t row = 0; row < grid_size; ++row)
+    {
+        for (std::size_t column = 0; column < grid_size; ++column)
+        {
+            const auto lon = min_lon + (max_lon - min_lon) * column / grid_size;
+            const auto lat = min_lat + (max_lat - min_lat) * row / grid_size;
+            params.coordinates.push_back(FloatCoordinate{FloatLongitude{lon}, FloatLatitude{lat}});
+        }
+    }
+
+    TIMER_START(tables);
+    auto NUM = 10;
+    for (int i = 0; i < NUM; ++i)
+    {
+        json::Object result;
+        const auto rc = osrm.Table(params, result);
+        if (rc != Status::Ok ||
+            result.values.at("durations").get<json::Array>().values.size() !=
+                params.coordinates.size())
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    TIMER_STOP(tables);
+    std::cout << (TIMER_MSEC(tables) / NUM) << "ms/req at " << params.coordinates.size() << "x"
+              << params.coordinates.size() << " table" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,427 @@
+#include "extractor/query_node.hpp"
+#include "storage/storage_config.hpp"
+#include "util/coordinate_calculation.hpp"
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/intermediate_file.hpp"
+
+#include "osrm/match_parameters.hpp"
+#include "osrm/route_parameters.hpp"
+#include "osrm/table_parameters.hpp"
+#include "osrm/trip_parameters.hpp"
+
+#include "osrm/coordinate.hpp"
+#include "osrm/engine_config.hpp"
+#include "osrm/json_container.hpp"
+#include "osrm/osrm.hpp"
+#include "osrm/status.hpp"
+
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cstdlib>
+
+namespace
+{
+using namespace osrm;
+
+using Clock = std::chrono::steady_clock;
+
+// Requests are sampled from at most this many nodes of the dataset
+const constexpr std::size_t MAX_SAMPLED_NODES = 1 << 20;
+// Size of the cells nodes are looked up by location in, in degrees
+const constexpr double CELL_SIZE = 0.02;
+// Table and trip locations are within this distance of a random centre, in meters
+const constexpr double REGION_RADIUS = 25000.;
+// A trace drives to random nodes between these distances from where it is, in meters
+const constexpr double MIN_LEG_DISTANCE = 500.;
+const constexpr double MAX_LEG_DISTANCE = 3000.;
+// Distance between the positions of a trace and the standard deviation of their noise, in
+// meters. About a position every five seconds in town, with the noise of a phone.
+const constexpr double SAMPLE_DISTANCE = 60.;
+const constexpr double GPS_NOISE = 5.;
+const constexpr double METERS_PER_DEGREE = 111320.;
+// Attempts to find a node in range before giving up on a location or a trace
+const constexpr int MAX_ATTEMPTS = 100;
+
+// Random locations of the nodes of a dataset. Nodes are sampled as they are, so requests are
+// denser where the roads are.
+class LocationSampler
+{
+  public:
+    LocationSampler(const storage::StorageConfig &config, const unsigned seed) : generator(seed)
+    {
+        util::IntermediateInputFile nodes_file(config.nodes_data_path);
+        unsigned number_of_nodes = 0;
+        nodes_file.read(reinterpret_cast<char *>(&number_of_nodes), sizeof(number_of_nodes));
+        if (!nodes_file)
+        {
+            throw util::exception("Could not read " + config.nodes_data_path.string());
+        }
+
+        // every stride-th node, so that the sample covers the whole dataset
+        const std::size_t stride = (number_of_nodes + MAX_SAMPLED_NODES - 1) / MAX_SAMPLED_NODES;
+        extractor::QueryNode node;
+        for (const auto index : util::irange<std::size_t>(0UL, number_of_nodes))
+        {
+            nodes_file.read(reinterpret_cast<char *>(&node), sizeof(node));
+            if (!nodes_file)
+            {
+                throw util::exception("Could not read " + config.nodes_data_path.string());
+            }
+            if (index % stride == 0)
+            {
+                locations.push_back(util::Coordinate{node.lon, node.lat});
+            }
+        }
+        if (locations.empty())
+        {
+            throw util::exception(config.nodes_data_path.string() + " has no nodes");
+        }
+
+        // locations sorted by cell, so that the nodes of a cell are found by a binary search
+        std::sort(locations.begin(),
+                  locations.end(),
+                  [](const util::Coordinate lhs, const util::Coordinate rhs) {
+                      return Cell(lhs) < Cell(rhs);
+                  });
+        cells.resize(locations.size());
+        std::transform(locations.begin(), locations.end(), cells.begin(), Cell);
+    }
+
+    util::Coordinate Any()
+    {
+        std::uniform_int_distribution<std::size_t> index(0, locations.size() - 1);
+        return locations[index(generator)];
+    }
+
+    // A node between min_distance and max_distance meters of a location, if one is found
+    boost::optional<util::Coordinate>
+    Near(const util::Coordinate location, const double min_distance, const double max_distance)
+    {
+        const auto lat = static_cast<double>(util::toFloating(location.lat));
+        const auto lon_scale = std::max(std::cos(lat * M_PI / 180.), 0.01);
+        const auto lat_cells = static_cast<int>(max_distance / METERS_PER_DEGREE / CELL_SIZE) + 1;
+        const auto lon_cells = static_cast<int>(lat_cells / lon_scale) + 1;
+        std::uniform_int_distribution<int> lon_offset(-lon_cells, lon_cells);
+        std::uniform_int_distribution<int> lat_offset(-lat_cells, lat_cells);
+
+        const auto centre = Cell(location);
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt)
+        {
+            const auto cell = std::make_pair(centre.first + lon_offset(generator),
+                                             centre.second + lat_offset(generator));
+            const auto range = std::equal_range(cells.begin(), cells.end(), cell);
+            if (range.first == range.second)
+            {
+                continue;
+            }
+            std::uniform_int_distribution<std::size_t> index(range.first - cells.begin(),
+                                                             range.second - cells.begin() - 1);
+            const auto candidate = locations[index(generator)];
+            const auto distance =
+                util::coordinate_calculation::haversineDistance(location, candidate);
+            if (distance >= min_distance && distance <= max_distance)
+            {
+                return candidate;
+            }
+        }
+        return boost::none;
+    }
+
+    // A location moved by the noise of a GPS position
+    util::Coordinate AddNoise(const util::Coordinate location)
+    {
+        std::normal_distribution<double> noise(0., GPS_NOISE / METERS_PER_DEGREE);
+        const auto lon = static_cast<double>(util::toFloating(location.lon));
+        const auto lat = static_cast<double>(util::toFloating(location.lat));
+        const auto lon_scale = std::max(std::cos(lat * M_PI / 180.), 0.01);
+        const auto noisy_lon = lon + noise(generator) / lon_scale;
+        const auto noisy_lat = lat + noise(generator);
+        return util::Coordinate{util::FloatLongitude{std::max(-180., std::min(180., noisy_lon))},
+                                util::FloatLatitude{std::max(-90., std::min(90., noisy_lat))}};
+    }
+
+  private:
+    static std::pair<int, int> Cell(const util::Coordinate location)
+    {
+        return std::make_pair(
+            static_cast<int>(std::floor(static_cast<double>(util::toFloating(location.lon)) /
+                                        CELL_SIZE)),
+            static_cast<int>(std::floor(static_cast<double>(util::toFloating(location.lat)) /
+                                        CELL_SIZE)));
+    }
+
+    std::mt19937 generator;
+    std::vector<util::Coordinate> locations;
+    std::vector<std::pair<int, int>> cells;
+};
+
+// number_of_locations nodes around a random centre, as the stops of a delivery area
+std::vector<util::Coordinate> SampleRegion(LocationSampler &sampler,
+                                           const std::size_t number_of_locations)
+{
+    const auto centre = sampler.Any();
+    std::vector<util::Coordinate> region{centre};
+    while (region.size() < number_of_locations)
+    {
+        const auto location = sampler.Near(centre, 0., REGION_RADIUS);
+        region.push_back(location ? *location : sampler.Any());
+    }
+    return region;
+}
+
+// The positions of a vehicle driving the fastest routes to a chain of random nodes, every
+// SAMPLE_DISTANCE meters with GPS noise. Returns none if the vehicle gets stuck before the trace
+// has number_of_positions positions.
+boost::optional<std::vector<util::Coordinate>> SampleTrace(LocationSampler &sampler,
+                                                           OSRM &osrm,
+                                                           const std::size_t number_of_positions)
+{
+    RouteParameters leg;
+    leg.overview = RouteParameters::OverviewType::Full;
+    leg.geometries = RouteParameters::GeometriesType::GeoJSON;
+    leg.coordinates = {sampler.Any(), sampler.Any()};
+
+    std::vector<util::Coordinate> trace;
+    double to_next_position = 0.;
+    while (trace.size() < number_of_positions)
+    {
+        const auto destination =
+            sampler.Near(leg.coordinates[0], MIN_LEG_DISTANCE, MAX_LEG_DISTANCE);
+        if (!destination)
+        {
+            return boost::none;
+        }
+        leg.coordinates[1] = *destination;
+
+        json::Object result;
+        if (osrm.Route(leg, result) != Status::Ok)
+        {
+            return boost::none;
+        }
+        const auto &geometry = result.values.at("routes")
+                                   .get<json::Array>()
+                                   .values.at(0)
+                                   .get<json::Object>()
+                                   .values.at("geometry")
+                                   .get<json::Object>()
+                                   .values.at("coordinates")
+                                   .get<json::Array>()
+                                   .values;
+        std::vector<util::Coordinate> path;
+        for (const auto &point : geometry)
+        {
+            const auto &lon_lat = point.get<json::Array>().values;
+            path.push_back(
+                util::Coordinate{util::FloatLongitude{lon_lat[0].get<json::Number>().value},
+                                 util::FloatLatitude{lon_lat[1].get<json::Number>().value}});
+        }
+        if (path.size() < 2)
+        {
+            return boost::none;
+        }
+
+        for (std::size_t segment = 1; segment < path.size(); ++segment)
+        {
+            const auto length =
+                util::coordinate_calculation::haversineDistance(path[segment - 1], path[segment]);
+            double along = to_next_position;
+            while (along <= length && trace.size() < number_of_positions)
+            {
+                trace.push_back(sampler.AddNoise(util::coordinate_calculation::interpolateLinear(
+                    along / std::max(length, 1e-3), path[segment - 1], path[segment])));
+                along += SAMPLE_DISTANCE;
+            }
+            to_next_position = along - length;
+        }
+        // the next leg starts where the route ended
+        leg.coordinates[0] = path.back();
+    }
+    return trace;
+}
+
+// Requests of one service and size, e.g. tables of 100x100 locations
+struct Workload
+{
+    std::string service;
+    std::size_t size;
+    std::vector<std::function<Status(OSRM &)>> requests;
+};
+
+std::vector<Workload> GenerateWorkloads(LocationSampler &sampler,
+                                        OSRM &osrm,
+                                        const std::size_t requests_per_workload)
+{
+    std::vector<Workload> workloads;
+    for (const std::size_t size : {10, 50, 100, 250})
+    {
+        Workload workload{"table", size, {}};
+        for (std::size_t request = 0; request < requests_per_workload; ++request)
+        {
+            TableParameters params;
+            params.coordinates = SampleRegion(sampler, size);
+            workload.requests.push_back([params](OSRM &router) {
+                json::Object result;
+                return router.Table(params, result);
+            });
+        }
+        workloads.push_back(std::move(workload));
+    }
+
+    for (const std::size_t size : {10, 50, 100, 250})
+    {
+        Workload workload{"match", size, {}};
+        for (int attempt = 0; workload.requests.size() < requests_per_workload; ++attempt)
+        {
+            if (attempt == MAX_ATTEMPTS * static_cast<int>(requests_per_workload))
+            {
+                throw util::exception("Could not sample traces of " + std::to_string(size) +
+                                      " positions");
+            }
+            const auto trace = SampleTrace(sampler, osrm, size);
+            if (!trace)
+            {
+                continue;
+            }
+            MatchParameters params;
+            params.overview = RouteParameters::OverviewType::False;
+            params.coordinates = *trace;
+            workload.requests.push_back([params](OSRM &router) {
+                json::Object result;
+                return router.Match(params, result);
+            });
+        }
+        workloads.push_back(std::move(workload));
+    }
+
+    for (const std::size_t size : {5, 10, 25, 50})
+    {
+        Workload workload{"trip", size, {}};
+        for (std::size_t request = 0; request < requests_per_workload; ++request)
+        {
+            TripParameters params;
+            params.overview = RouteParameters::OverviewType::False;
+            params.coordinates = SampleRegion(sampler, size);
+            workload.requests.push_back([params](OSRM &router) {
+                json::Object result;
+                return router.Trip(params, result);
+            });
+        }
+        workloads.push_back(std::move(workload));
+    }
+    return workloads;
+}
+
+// Answers every request of the workload number_of_threads times on as many threads, returns
+// the requests per second and the number of errors
+std::pair<double, std::size_t>
+RunWorkload(OSRM &osrm, const Workload &workload, const std::size_t number_of_threads)
+{
+    const auto number_of_runs = workload.requests.size() * number_of_threads;
+    std::atomic<std::size_t> next_run{0};
+    std::atomic<std::size_t> errors{0};
+    std::vector<std::thread> threads;
+
+    const auto start = Clock::now();
+    for (std::size_t thread = 0; thread < number_of_threads; ++thread)
+    {
+        threads.emplace_back([&] {
+            for (auto run = next_run++; run < number_of_runs; run = next_run++)
+            {
+                const auto &request = workload.requests[run % workload.requests.size()];
+                if (request(osrm) != Status::Ok)
+                {
+                    ++errors;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    const std::chrono::duration<double> wall_time = Clock::now() - start;
+    return std::make_pair(number_of_runs / wall_time.count(), errors.load());
+}
+}
+
+int main(int argc, const char *argv[]) try
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " data.osrm [max threads] [requests per workload] [seed]\n"
+                  << "Runs table, match and trip requests sampled from the dataset at "
+                     "increasing sizes and thread counts.\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto max_threads =
+        argc > 2 ? std::stoul(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+    const auto requests_per_workload = argc > 3 ? std::stoul(argv[3]) : 32ul;
+    const auto seed = argc > 4 ? std::stoul(argv[4]) : 42ul;
+
+    // Configure based on a .osrm base path, and no datasets in shared mem from osrm-datastore
+    EngineConfig config;
+    config.storage_config = {argv[1]};
+    config.use_shared_memory = false;
+    OSRM osrm{config};
+
+    LocationSampler sampler(config.storage_config, seed);
+    const auto workloads = GenerateWorkloads(sampler, osrm, requests_per_workload);
+
+    std::vector<std::size_t> thread_counts;
+    for (std::size_t threads = 1; threads < max_threads; threads *= 2)
+    {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    // speedup over a single thread, efficiency is the speedup per thread
+    std::cout << std::left << std::setw(10) << "service" << std::right << std::setw(8) << "size"
+              << std::setw(10) << "threads" << std::setw(12) << "req/s" << std::setw(10)
+              << "speedup" << std::setw(12) << "efficiency" << std::setw(8) << "errors"
+              << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto &workload : workloads)
+    {
+        double single_thread_throughput = 0;
+        for (const auto threads : thread_counts)
+        {
+            const auto throughput_and_errors = RunWorkload(osrm, workload, threads);
+            const auto throughput = throughput_and_errors.first;
+            if (threads == 1)
+            {
+                single_thread_throughput = throughput;
+            }
+            const auto speedup = throughput / single_thread_throughput;
+            std::cout << std::left << std::setw(10) << workload.service << std::right
+                      << std::setw(8) << workload.size << std::setw(10) << threads
+                      << std::setw(12) << throughput << std::setw(10) << speedup << std::setw(12)
+                      << speedup / threads << std::setw(8) << throughput_and_errors.second
+                      << "\n";
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
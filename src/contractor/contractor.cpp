@@ -1,14 +1,28 @@
 #include "contractor/contractor.hpp"
-#include "contractor/crc32_processor.hpp"
+#include "contractor/edge_lengths.hpp"
 #include "contractor/graph_contractor.hpp"
+#include "contractor/node_renumbering.hpp"
+#include "contractor/time_slots.hpp"
+#include "contractor/traffic_lookup.hpp"
+#include "contractor/traffic_update_file.hpp"
+#include "engine/core_landmarks.hpp"
 
 #include "extractor/compressed_edge_container.hpp"
+#include "extractor/duplicated_node.hpp"
 #include "extractor/edge_based_graph_factory.hpp"
 #include "extractor/node_based_edge.hpp"
 
+#include "partition/cell_customizer.hpp"
+#include "partition/cell_storage.hpp"
+#include "partition/multi_level_partition.hpp"
+#include "partition/recursive_bisection.hpp"
+
+#include "util/buffered_file.hpp"
+#include "util/crc32c.hpp"
 #include "util/exception.hpp"
 #include "util/graph_loader.hpp"
 #include "util/integer_range.hpp"
+#include "util/intermediate_file.hpp"
 #include "util/io.hpp"
 #include "util/simple_logger.hpp"
 #include "util/static_graph.hpp"
@@ -19,23 +33,24 @@
 
 #include <boost/assert.hpp>
 #include <boost/filesystem/fstream.hpp>
-#include <boost/functional/hash.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/interprocess/file_mapping.hpp>
 #include <boost/interprocess/mapped_region.hpp>
-#include <boost/spirit/include/qi.hpp>
 
 #include <tbb/blocked_range.h>
-#include <tbb/concurrent_unordered_map.h>
 #include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_for_each.h>
 #include <tbb/parallel_invoke.h>
+#include <tbb/parallel_reduce.h>
 #include <tbb/parallel_sort.h>
-#include <tbb/spin_mutex.h>
 
 #include <algorithm>
+#include <atomic>
 #include <bitset>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iterator>
 #include <memory>
@@ -43,34 +58,72 @@
 #include <tuple>
 #include <vector>
 
-namespace std
+namespace osrm
+{
+namespace contractor
 {
 
-template <> struct hash<std::pair<OSMNodeID, OSMNodeID>>
+namespace
+{
+// see Contractor::Interrupt
+std::atomic<bool> contraction_interrupted{false};
+
+// objects copied by one task of ReadIntermediateArray
+static const constexpr std::size_t ARRAY_COPY_GRAIN = 1 << 16;
+
+// Reads an array, stored as its size followed by its objects, at offset of an intermediate file.
+// Plain files are mapped and copied by several threads, which keeps several page faults in
+// flight, compressed ones are decompressed in parallel frames. Returns the offset behind it.
+template <typename T>
+std::uint64_t
+ReadIntermediateArray(const std::string &path, const std::uint64_t offset, std::vector<T> &values)
 {
-    std::size_t operator()(const std::pair<OSMNodeID, OSMNodeID> &k) const noexcept
+    unsigned count = 0;
+    if (util::IsCompressedFile(path))
     {
-        return static_cast<uint64_t>(k.first) ^ (static_cast<uint64_t>(k.second) << 12);
+        util::IntermediateInputFile stream(path);
+        stream.seekg(offset);
+        stream.read(reinterpret_cast<char *>(&count), sizeof(count));
+        values.resize(stream ? count : 0);
+        stream.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(T));
+        if (!stream)
+        {
+            throw util::exception("Could not read " + path);
+        }
+        return offset + sizeof(count) + values.size() * sizeof(T);
     }
-};
 
-template <> struct hash<std::tuple<OSMNodeID, OSMNodeID, OSMNodeID>>
-{
-    std::size_t operator()(const std::tuple<OSMNodeID, OSMNodeID, OSMNodeID> &k) const noexcept
+    using boost::interprocess::file_mapping;
+    using boost::interprocess::mapped_region;
+    using boost::interprocess::read_only;
+
+    const file_mapping mapping{path.c_str(), read_only};
+    const mapped_region region{mapping, read_only};
+    const auto bytes = static_cast<const char *>(region.get_address());
+    if (region.get_size() < offset + sizeof(count))
     {
-        std::size_t seed = 0;
-        boost::hash_combine(seed, static_cast<uint64_t>(std::get<0>(k)));
-        boost::hash_combine(seed, static_cast<uint64_t>(std::get<1>(k)));
-        boost::hash_combine(seed, static_cast<uint64_t>(std::get<2>(k)));
-        return seed;
+        throw util::exception(path + " is truncated, run the preprocessing again");
     }
-};
+    std::memcpy(&count, bytes + offset, sizeof(count));
+    const auto end = offset + sizeof(count) + std::uint64_t{count} * sizeof(T);
+    if (region.get_size() < end)
+    {
+        throw util::exception(path + " is truncated, run the preprocessing again");
+    }
+
+    values.resize(count);
+    const auto first = bytes + offset + sizeof(count);
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, count, ARRAY_COPY_GRAIN),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          std::memcpy(values.data() + range.begin(),
+                                      first + range.begin() * sizeof(T),
+                                      range.size() * sizeof(T));
+                      });
+    return end;
+}
 }
 
-namespace osrm
-{
-namespace contractor
-{
+void Contractor::Interrupt() { contraction_interrupted = true; }
 
 int Contractor::Run()
 {
@@ -81,6 +134,9 @@ int Contractor::Run()
                   "changing extractor::NodeBasedEdge type has influence on memory consumption!");
     static_assert(sizeof(extractor::EdgeBasedEdge) == 16,
                   "changing EdgeBasedEdge type has influence on memory consumption!");
+    // target (32 bits), edge id (31), shortcut flag, weight (30) and direction flags
+    static_assert(sizeof(util::StaticGraph<EdgeData>::EdgeArrayEntry) == 12,
+                  "changing QueryEdge::EdgeData type has influence on memory consumption!");
 #endif
 
     if (config.core_factor > 1.0 || config.core_factor < 0)
@@ -88,6 +144,33 @@ int Contractor::Run()
         throw util::exception("Core factor must be between 0.0 to 1.0 (inclusive)");
     }
 
+    if (config.incremental)
+    {
+        if (!config.use_cached_priority)
+        {
+            throw util::exception("Incremental contraction requires --level-cache");
+        }
+        if (config.core_factor < 1.0)
+        {
+            throw util::exception("Incremental contraction requires a fully contracted graph");
+        }
+    }
+    else if (config.reorder_changed)
+    {
+        throw util::exception("Re-ordering changed nodes requires --incremental");
+    }
+
+    if (!config.time_slot_speed_lookup_paths.empty() && config.time_slot_duration == 0)
+    {
+        throw util::exception("Time slots must be at least one minute long");
+    }
+
+    if (config.renumber_nodes && boost::filesystem::exists(config.partition_path))
+    {
+        throw util::exception("Renumbered nodes do not match the multi-level partition in " +
+                              config.partition_path);
+    }
+
     TIMER_START(preparing);
 
     util::SimpleLogger().Write() << "Loading edge-expanded graph representation";
@@ -98,13 +181,12 @@ int Contractor::Run()
                                                edge_based_edge_list,
                                                config.edge_segment_lookup_path,
                                                config.edge_penalty_path,
+                                               config.segment_index_path,
                                                config.segment_speed_lookup_paths,
                                                config.turn_penalty_lookup_paths,
-                                               config.node_based_graph_path,
                                                config.geometry_path,
                                                config.datasource_names_path,
-                                               config.datasource_indexes_path,
-                                               config.rtree_leaf_path);
+                                               config.datasource_indexes_path);
 
     // Contracting the edge-expanded graph
 
@@ -128,24 +210,103 @@ int Contractor::Run()
         throw util::exception("Failed reading node weights.");
     }
 
+    // the .hsgr and the r-tree leaves of a previous run may use renumbered node ids
+    std::vector<NodeID> previous_node_ids;
+    if (boost::filesystem::exists(config.node_order_path))
+    {
+        if (!util::deserializeVector(config.node_order_path, previous_node_ids) ||
+            previous_node_ids.size() != max_edge_id + 1)
+        {
+            throw util::exception(config.node_order_path +
+                                  " does not match the edge-expanded graph");
+        }
+    }
+
+    std::vector<QueryEdge> previous_edge_list;
+    if (config.incremental)
+    {
+        ReadContractedGraph(previous_edge_list);
+        if (node_levels.size() != max_edge_id + 1)
+        {
+            throw util::exception(".level file does not match the edge-expanded graph");
+        }
+        if (!previous_node_ids.empty())
+        {
+            RenumberQueryEdges(previous_edge_list, InvertNodeOrder(previous_node_ids));
+        }
+    }
+
     util::DeallocatingVector<QueryEdge> contracted_edge_list;
     ContractGraph(max_edge_id,
                   edge_based_edge_list,
                   contracted_edge_list,
                   std::move(node_weights),
                   is_core_node,
-                  node_levels);
+                  node_levels,
+                  previous_edge_list);
     TIMER_STOP(contraction);
 
     util::SimpleLogger().Write() << "Contraction took " << TIMER_SEC(contraction) << " sec";
 
-    std::size_t number_of_used_edges = WriteContractedGraph(max_edge_id, contracted_edge_list);
+    std::vector<NodeID> node_ids;
+    if (config.renumber_nodes)
+    {
+        util::SimpleLogger().Write() << "Renumbering nodes by level";
+        node_ids = ComputeLevelOrder(max_edge_id + 1, contracted_edge_list, is_core_node);
+        RenumberQueryEdges(contracted_edge_list, node_ids);
+        is_core_node = RenumberNodeMarkers(is_core_node, node_ids);
+    }
+
+    if (config.core_landmarks > 0 && config.core_factor < 1.0)
+    {
+        WriteCoreLandmarks(contracted_edge_list, is_core_node);
+    }
+    else
+    {
+        if (config.core_landmarks > 0)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "The graph is fully contracted, core landmarks require --core < 1";
+        }
+        // landmarks of a previous run do not match the new weights
+        boost::filesystem::remove(config.core_landmarks_output_path);
+    }
+
+    std::size_t number_of_used_edges =
+        WriteContractedGraph(config.graph_output_path, max_edge_id, contracted_edge_list);
     WriteCoreNodeMarker(std::move(is_core_node));
-    if (!config.use_cached_priority)
+    if (node_ids != previous_node_ids)
+    {
+        RenumberRTreeLeaves(previous_node_ids, node_ids);
+        RenumberDuplicatedNodes(previous_node_ids, node_ids);
+    }
+    if (node_ids.empty())
+    {
+        boost::filesystem::remove(config.node_order_path);
+    }
+    else if (!util::serializeVector(config.node_order_path, node_ids))
+    {
+        throw util::exception("Failed writing " + config.node_order_path);
+    }
+    if (!config.use_cached_priority || config.reorder_changed)
     {
         WriteNodeLevels(std::move(node_levels));
     }
 
+    if (!config.time_slot_speed_lookup_paths.empty() || !config.metric_speed_lookup_paths.empty() ||
+        !config.exclude_classes.empty())
+    {
+        // reads back the .hsgr, the geometries and the r-tree leaves written above
+        WriteTimeSlots(config);
+    }
+    else
+    {
+        boost::filesystem::remove(config.time_slots_output_path);
+    }
+
+    // reads back the .hsgr and the r-tree leaves written above
+    WriteEdgeLengths(config);
+
     TIMER_STOP(preparing);
 
     util::SimpleLogger().Write() << "Preprocessing : " << TIMER_SEC(preparing) << " seconds";
@@ -158,210 +319,138 @@ int Contractor::Run()
     return 0;
 }
 
-// Utilities for LoadEdgeExpandedGraph to restore my sanity
-namespace
-{
-
-struct Segment final
-{
-    OSMNodeID from, to;
-};
-
-struct SpeedSource final
-{
-    unsigned speed;
-    std::uint8_t source;
-};
-
-struct SegmentSpeedSource final
+int Contractor::Partition()
 {
-    Segment segment;
-    SpeedSource speed_source;
-};
-
-using SegmentSpeedSourceFlatMap = std::vector<SegmentSpeedSource>;
-
-// Binary Search over a flattened key,val Segment storage
-SegmentSpeedSourceFlatMap::iterator find(SegmentSpeedSourceFlatMap &map, const Segment &key)
-{
-    const auto last = end(map);
-
-    const auto by_segment = [](const SegmentSpeedSource &lhs, const SegmentSpeedSource &rhs) {
-        return std::tie(lhs.segment.from, lhs.segment.to) >
-               std::tie(rhs.segment.from, rhs.segment.to);
-    };
-
-    auto it = std::lower_bound(begin(map), last, SegmentSpeedSource{key, {0, 0}}, by_segment);
-
-    if (it != last && (std::tie(it->segment.from, it->segment.to) == std::tie(key.from, key.to)))
-        return it;
-
-    return last;
-}
-
-// Convenience aliases. TODO: make actual types at some point in time.
-// TODO: turn penalties need flat map + binary search optimization, take a look at segment speeds
-
-using Turn = std::tuple<OSMNodeID, OSMNodeID, OSMNodeID>;
-using TurnHasher = std::hash<Turn>;
-using PenaltySource = std::pair<double, std::uint8_t>;
-using TurnPenaltySourceMap = tbb::concurrent_unordered_map<Turn, PenaltySource, TurnHasher>;
-
-// Functions for parsing files and creating lookup tables
-
-SegmentSpeedSourceFlatMap
-parse_segment_lookup_from_csv_files(const std::vector<std::string> &segment_speed_filenames)
-{
-    // TODO: shares code with turn penalty lookup parse function
-
-    using Mutex = tbb::spin_mutex;
-
-    // Loaded and parsed in parallel, at the end we combine results in a flattened map-ish view
-    SegmentSpeedSourceFlatMap flatten;
-    Mutex flatten_mutex;
-
-    const auto parse_segment_speed_file = [&](const std::size_t idx) {
-        const auto file_id = idx + 1; // starts at one, zero means we assigned the weight
-        const auto filename = segment_speed_filenames[idx];
-
-        std::ifstream segment_speed_file{filename, std::ios::binary};
-        if (!segment_speed_file)
-            throw util::exception{"Unable to open segment speed file " + filename};
-
-        SegmentSpeedSourceFlatMap local;
+    if (boost::filesystem::exists(config.node_order_path))
+    {
+        throw util::exception("The multi-level partition needs the node ids of osrm-extract, "
+                              "re-run osrm-contract without --renumber-nodes first");
+    }
 
-        std::uint64_t from_node_id{};
-        std::uint64_t to_node_id{};
-        unsigned speed{};
+    TIMER_START(partitioning);
 
-        for (std::string line; std::getline(segment_speed_file, line);)
+    util::DeallocatingVector<extractor::EdgeBasedEdge> edge_based_edge_list;
+    const EdgeID max_edge_id = LoadEdgeExpandedGraph(config.edge_based_graph_path,
+                                                     edge_based_edge_list,
+                                                     config.edge_segment_lookup_path,
+                                                     config.edge_penalty_path,
+                                                     config.segment_index_path,
+                                                     {},
+                                                     {},
+                                                     config.geometry_path,
+                                                     config.datasource_names_path,
+                                                     config.datasource_indexes_path);
+
+    // the partition only depends on the topology, weights may change afterwards
+    std::vector<std::pair<NodeID, NodeID>> edges;
+    edges.reserve(edge_based_edge_list.size());
+    for (const auto &edge : edge_based_edge_list)
+    {
+        if (edge.source != edge.target)
         {
-            using namespace boost::spirit::qi;
-
-            auto it = begin(line);
-            const auto last = end(line);
-
-            // The ulong_long -> uint64_t will likely break on 32bit platforms
-            const auto ok = parse(it,
-                                  last,                                              //
-                                  (ulong_long >> ',' >> ulong_long >> ',' >> uint_), //
-                                  from_node_id,
-                                  to_node_id,
-                                  speed); //
-
-            if (!ok || it != last)
-                throw util::exception{"Segment speed file " + filename + " malformed"};
-
-            SegmentSpeedSource val{
-                {OSMNodeID{from_node_id}, OSMNodeID{to_node_id}},
-                {speed, static_cast<std::uint8_t>(file_id)}};
-
-            local.push_back(std::move(val));
+            edges.emplace_back(edge.source, edge.target);
         }
+    }
+    edge_based_edge_list.clear();
 
-        util::SimpleLogger().Write() << "Loaded speed file " << filename << " with " << local.size()
-                                     << " speeds";
+    const auto partition = partition::bisectGraph(max_edge_id + 1, edges, config.max_cell_sizes);
+    for (partition::LevelID level = 1; level < partition.GetNumberOfLevels(); ++level)
+    {
+        util::SimpleLogger().Write() << "Level " << static_cast<unsigned>(level) << ": "
+                                     << partition.GetNumberOfCells(level) << " cells";
+    }
+    partition.Write(config.partition_path);
 
-        {
-            Mutex::scoped_lock _{flatten_mutex};
+    TIMER_STOP(partitioning);
+    util::SimpleLogger().Write() << "Partitioning took " << TIMER_SEC(partitioning) << " sec";
 
-            flatten.insert(end(flatten),
-                           std::make_move_iterator(begin(local)),
-                           std::make_move_iterator(end(local)));
-        }
-    };
+    return 0;
+}
 
-    tbb::parallel_for(std::size_t{0}, segment_speed_filenames.size(), parse_segment_speed_file);
+int Contractor::Customize()
+{
+    if (boost::filesystem::exists(config.node_order_path))
+    {
+        throw util::exception("The multi-level partition needs the node ids of osrm-extract, "
+                              "re-run osrm-contract without --renumber-nodes first");
+    }
 
-    // With flattened map-ish view of all the files, sort and unique them on from,to,source
-    // The greater '>' is used here since we want to give files later on higher precedence
-    const auto sort_by = [](const SegmentSpeedSource &lhs, const SegmentSpeedSource &rhs) {
-        return std::tie(lhs.segment.from, lhs.segment.to, lhs.speed_source.source) >
-               std::tie(rhs.segment.from, rhs.segment.to, rhs.speed_source.source);
-    };
+    TIMER_START(customizing);
 
-    std::stable_sort(begin(flatten), end(flatten), sort_by);
+    util::DeallocatingVector<extractor::EdgeBasedEdge> edge_based_edge_list;
+    const EdgeID max_edge_id = LoadEdgeExpandedGraph(config.edge_based_graph_path,
+                                                     edge_based_edge_list,
+                                                     config.edge_segment_lookup_path,
+                                                     config.edge_penalty_path,
+                                                     config.segment_index_path,
+                                                     config.segment_speed_lookup_paths,
+                                                     config.turn_penalty_lookup_paths,
+                                                     config.geometry_path,
+                                                     config.datasource_names_path,
+                                                     config.datasource_indexes_path);
+    const auto number_of_nodes = max_edge_id + 1;
+
+    partition::MultiLevelPartition partition;
+    partition.Read(config.partition_path);
+    if (partition.GetNumberOfNodes() != number_of_nodes)
+    {
+        throw util::exception(config.partition_path + " does not match the edge-expanded graph");
+    }
 
-    // Unique only on from,to to take the source precedence into account and remove duplicates
-    const auto unique_by = [](const SegmentSpeedSource &lhs, const SegmentSpeedSource &rhs) {
-        return std::tie(lhs.segment.from, lhs.segment.to) ==
-               std::tie(rhs.segment.from, rhs.segment.to);
+    // Every arc is stored at both of its end points, like the arcs of the .hsgr
+    util::DeallocatingVector<QueryEdge> base_edge_list;
+    const auto add_arc = [&base_edge_list](const NodeID from,
+                                           const NodeID to,
+                                           const NodeID id,
+                                           const EdgeWeight weight) {
+        QueryEdge::EdgeData data;
+        data.id = id;
+        data.shortcut = false;
+        data.distance = std::max(weight, 1);
+        data.forward = true;
+        data.backward = false;
+        base_edge_list.emplace_back(from, to, data);
+        data.forward = false;
+        data.backward = true;
+        base_edge_list.emplace_back(to, from, data);
     };
+    for (const auto &edge : edge_based_edge_list)
+    {
+        if (edge.source == edge.target)
+            continue;
+        if (edge.forward)
+            add_arc(edge.source, edge.target, edge.edge_id, edge.weight);
+        if (edge.backward)
+            add_arc(edge.target, edge.source, edge.edge_id, edge.weight);
+    }
+    edge_based_edge_list.clear();
 
-    const auto it = std::unique(begin(flatten), end(flatten), unique_by);
-
-    flatten.erase(it, end(flatten));
-
-    util::SimpleLogger().Write() << "In total loaded " << segment_speed_filenames.size()
-                                 << " speed file(s) with a total of " << flatten.size()
-                                 << " unique values";
-
-    return flatten;
-}
-
-TurnPenaltySourceMap
-parse_turn_penalty_lookup_from_csv_files(const std::vector<std::string> &turn_penalty_filenames)
-{
-    // TODO: shares code with turn penalty lookup parse function
-    TurnPenaltySourceMap map;
-
-    const auto parse_turn_penalty_file = [&](const std::size_t idx) {
-        const auto file_id = idx + 1; // starts at one, zero means we assigned the weight
-        const auto filename = turn_penalty_filenames[idx];
-
-        std::ifstream turn_penalty_file{filename, std::ios::binary};
-        if (!turn_penalty_file)
-            throw util::exception{"Unable to open turn penalty file " + filename};
+    WriteContractedGraph(config.mld_graph_path, max_edge_id, base_edge_list);
 
-        std::uint64_t from_node_id{};
-        std::uint64_t via_node_id{};
-        std::uint64_t to_node_id{};
-        double penalty{};
+    const partition::BaseGraph base_graph(number_of_nodes, base_edge_list);
+    base_edge_list.clear();
 
-        for (std::string line; std::getline(turn_penalty_file, line);)
-        {
-            using namespace boost::spirit::qi;
-
-            auto it = begin(line);
-            const auto last = end(line);
-
-            // The ulong_long -> uint64_t will likely break on 32bit platforms
-            const auto ok =
-                parse(it,
-                      last,                                                                     //
-                      (ulong_long >> ',' >> ulong_long >> ',' >> ulong_long >> ',' >> double_), //
-                      from_node_id,
-                      via_node_id,
-                      to_node_id,
-                      penalty); //
-
-            if (!ok || it != last)
-                throw util::exception{"Turn penalty file " + filename + " malformed"};
-
-            map[std::make_tuple(
-                OSMNodeID{from_node_id}, OSMNodeID{via_node_id}, OSMNodeID{to_node_id})] =
-                std::make_pair(penalty, file_id);
-        }
-    };
+    partition::CellStorage cells(partition, base_graph);
+    partition::CellCustomizer(partition).Customize(base_graph, cells);
+    cells.Write(config.cells_path);
 
-    tbb::parallel_for(std::size_t{0}, turn_penalty_filenames.size(), parse_turn_penalty_file);
+    TIMER_STOP(customizing);
+    util::SimpleLogger().Write() << "Customization took " << TIMER_SEC(customizing) << " sec";
 
-    return map;
+    return 0;
 }
-} // anon ns
 
 EdgeID Contractor::LoadEdgeExpandedGraph(
     std::string const &edge_based_graph_filename,
     util::DeallocatingVector<extractor::EdgeBasedEdge> &edge_based_edge_list,
     const std::string &edge_segment_lookup_filename,
     const std::string &edge_penalty_filename,
+    const std::string &segment_index_filename,
     const std::vector<std::string> &segment_speed_filenames,
     const std::vector<std::string> &turn_penalty_filenames,
-    const std::string &nodes_filename,
     const std::string &geometry_filename,
     const std::string &datasource_names_filename,
-    const std::string &datasource_indexes_filename,
-    const std::string &rtree_leaf_filename)
+    const std::string &datasource_indexes_filename)
 {
     if (segment_speed_filenames.size() > 255 || turn_penalty_filenames.size() > 255)
         throw util::exception("Limit of 255 segment speed and turn penalty files each reached");
@@ -379,7 +468,12 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
         return region;
     };
 
-    const auto edge_based_graph_region = mmap_file(edge_based_graph_filename);
+    // compressed graphs are decompressed into memory in parallel frames, plain ones are mapped
+    const bool compressed_graph = util::IsCompressedFile(edge_based_graph_filename);
+    std::vector<extractor::EdgeBasedEdge> decompressed_edges;
+    const auto edge_based_graph_region = compressed_graph
+                                             ? boost::interprocess::mapped_region()
+                                             : mmap_file(edge_based_graph_filename);
 
     const bool update_edge_weights = !segment_speed_filenames.empty();
     const bool update_turn_penalties = !turn_penalty_filenames.empty();
@@ -412,7 +506,24 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
     };
     #pragma pack(pop, r1)
 
-    const EdgeBasedGraphHeader graph_header = *(reinterpret_cast<const EdgeBasedGraphHeader *>(edge_based_graph_region.get_address()));
+    EdgeBasedGraphHeader graph_header;
+    if (compressed_graph)
+    {
+        util::IntermediateInputFile graph_stream(edge_based_graph_filename);
+        graph_stream.read(reinterpret_cast<char *>(&graph_header), sizeof(graph_header));
+        decompressed_edges.resize(graph_stream ? graph_header.number_of_edges : 0);
+        graph_stream.read(reinterpret_cast<char *>(decompressed_edges.data()),
+                          decompressed_edges.size() * sizeof(extractor::EdgeBasedEdge));
+        if (!graph_stream)
+        {
+            throw util::exception("Could not read " + edge_based_graph_filename);
+        }
+    }
+    else
+    {
+        graph_header = *(reinterpret_cast<const EdgeBasedGraphHeader *>(
+            edge_based_graph_region.get_address()));
+    }
 
     const util::FingerPrint fingerprint_valid = util::FingerPrint::GetValid();
     graph_header.fingerprint.TestContractor(fingerprint_valid);
@@ -421,91 +532,71 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
     util::SimpleLogger().Write() << "Reading " << graph_header.number_of_edges
                                  << " edges from the edge based graph";
 
-    SegmentSpeedSourceFlatMap segment_speed_lookup;
-    TurnPenaltySourceMap turn_penalty_lookup;
+    SegmentSpeeds segment_speeds;
+    TurnPenaltyLookup turn_penalty_lookup;
 
     const auto parse_segment_speeds = [&] {
         if (update_edge_weights)
-            segment_speed_lookup = parse_segment_lookup_from_csv_files(segment_speed_filenames);
+            segment_speeds = SegmentSpeeds(SegmentSpeedLookup(segment_speed_filenames,
+                                                              ParseSegmentSpeedCSV,
+                                                              SortSegmentSpeeds),
+                                           segment_index_filename);
     };
 
     const auto parse_turn_penalties = [&] {
         if (update_turn_penalties)
-            turn_penalty_lookup = parse_turn_penalty_lookup_from_csv_files(turn_penalty_filenames);
+            turn_penalty_lookup = TurnPenaltyLookup(
+                turn_penalty_filenames, ParseTurnPenaltyCSV, SortTurnPenalties);
     };
 
     // If we update the edge weights, this file will hold the datasource information for each
     // segment; the other files will also be conditionally filled concurrently if we make an update
     std::vector<uint8_t> m_geometry_datasource;
 
-    std::vector<extractor::QueryNode> internal_to_external_node_map;
     std::vector<unsigned> m_geometry_indices;
     std::vector<extractor::CompressedEdgeContainer::CompressedEdge> m_geometry_list;
 
-    const auto maybe_load_internal_to_external_node_map = [&] {
-        if (!(update_edge_weights || update_turn_penalties))
-            return;
-
-        boost::filesystem::ifstream nodes_input_stream(nodes_filename, std::ios::binary);
-
-        if (!nodes_input_stream)
-        {
-            throw util::exception("Failed to open " + nodes_filename);
-        }
-
-        unsigned number_of_nodes = 0;
-        nodes_input_stream.read((char *)&number_of_nodes, sizeof(unsigned));
-        internal_to_external_node_map.resize(number_of_nodes);
-
-        // Load all the query nodes into a vector
-        nodes_input_stream.read(reinterpret_cast<char *>(&(internal_to_external_node_map[0])),
-                                number_of_nodes * sizeof(extractor::QueryNode));
-    };
-
     const auto maybe_load_geometries = [&] {
         if (!(update_edge_weights || update_turn_penalties))
             return;
 
-        std::ifstream geometry_stream(geometry_filename, std::ios::binary);
-        if (!geometry_stream)
-        {
-            throw util::exception("Failed to open " + geometry_filename);
-        }
-        unsigned number_of_indices = 0;
-        unsigned number_of_compressed_geometries = 0;
-
-        geometry_stream.read((char *)&number_of_indices, sizeof(unsigned));
-
-        m_geometry_indices.resize(number_of_indices);
-        if (number_of_indices > 0)
-        {
-            geometry_stream.read((char *)&(m_geometry_indices[0]),
-                                 number_of_indices * sizeof(unsigned));
-        }
-
-        geometry_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
+        const auto list_offset =
+            ReadIntermediateArray(geometry_filename, 0, m_geometry_indices);
+        ReadIntermediateArray(geometry_filename, list_offset, m_geometry_list);
+        BOOST_ASSERT(m_geometry_indices.back() == m_geometry_list.size());
+    };
 
-        BOOST_ASSERT(m_geometry_indices.back() == number_of_compressed_geometries);
-        m_geometry_list.resize(number_of_compressed_geometries);
+    const auto penalty_blocks =
+        reinterpret_cast<const extractor::lookup::PenaltyBlock *>(edge_penalty_region.get_address());
+    const auto edge_segment_bytes = reinterpret_cast<const char *>(edge_segment_region.get_address());
 
-        if (number_of_compressed_geometries > 0)
-        {
-            geometry_stream.read((char *)&(m_geometry_list[0]),
-                                 number_of_compressed_geometries *
-                                     sizeof(extractor::CompressedEdgeContainer::CompressedEdge));
-        }
+    // The segments of an edge are stored as a header and a variable number of blocks, so finding
+    // where the segments of each edge start is the only part that has to run in order.
+    std::vector<std::size_t> edge_segment_offsets;
+    const auto maybe_find_edge_segments = [&] {
+        if (update_edge_weights || update_turn_penalties)
+            edge_segment_offsets =
+                GetEdgeSegmentOffsets(edge_segment_bytes, graph_header.number_of_edges);
     };
 
     // Folds all our actions into independently concurrently executing lambdas
     tbb::parallel_invoke(parse_segment_speeds,
                          parse_turn_penalties, //
-                         maybe_load_internal_to_external_node_map,
-                         maybe_load_geometries);
+                         maybe_load_geometries,
+                         maybe_find_edge_segments);
 
-    if (update_edge_weights || update_turn_penalties)
+    if (update_edge_weights && (segment_speeds.GetNumberOfSegments() != m_geometry_list.size() ||
+                                segment_speeds.GetNumberOfEdges() != graph_header.number_of_edges))
     {
+        throw util::exception(segment_index_filename +
+                              " does not match the edge based graph, run osrm-extract again");
+    }
+
+    const auto maybe_update_geometries = [&] {
+        if (!(update_edge_weights || update_turn_penalties))
+            return;
+
         // Here, we have to update the compressed geometry weights
-        // First, we need the external-to-internal node lookup table
 
         // This is a list of the "data source id" for every segment in the compressed
         // geometry container.  We assume that everything so far has come from the
@@ -515,20 +606,6 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
         // vector tiles later on.
         m_geometry_datasource.resize(m_geometry_list.size(), 0);
 
-        // Now, we iterate over all the segments stored in the StaticRTree, updating
-        // the packed geometry weights in the `.geometries` file (note: we do not
-        // update the RTree itself, we just use the leaf nodes to iterate over all segments)
-        using LeafNode = util::StaticRTree<extractor::EdgeBasedNode>::LeafNode;
-
-        using boost::interprocess::mapped_region;
-
-        auto region = mmap_file(rtree_leaf_filename.c_str());
-        region.advise(mapped_region::advice_willneed);
-
-        const auto bytes = region.get_size();
-        const auto first = static_cast<const LeafNode *>(region.get_address());
-        const auto last = first + (bytes / sizeof(LeafNode));
-
         // vector to count used speeds for logging
         // size offset by one since index 0 is used for speeds not from external file
         using counters_type = std::vector<std::size_t>;
@@ -537,115 +614,25 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
             counters_type(num_counters, 0));
         const constexpr auto LUA_SOURCE = 0;
 
-        tbb::parallel_for_each(first, last, [&](const LeafNode &current_node) {
-            auto &counters = segment_speeds_counters.local();
-            for (size_t i = 0; i < current_node.object_count; i++)
-            {
-                const auto &leaf_object = current_node.objects[i];
-                extractor::QueryNode *u;
-                extractor::QueryNode *v;
-
-                if (leaf_object.forward_packed_geometry_id != SPECIAL_EDGEID)
+        // The speeds were joined with the segments of the geometries by their position, so the
+        // geometries are updated in one pass without searching any speed.
+        const bool has_speeds = segment_speeds.GetNumberOfSegments() > 0;
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, m_geometry_list.size()),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                auto &counters = segment_speeds_counters.local();
+                for (const auto segment : util::irange(range.begin(), range.end()))
                 {
-                    const unsigned forward_begin =
-                        m_geometry_indices.at(leaf_object.forward_packed_geometry_id);
-
-                    if (leaf_object.fwd_segment_position == 0)
-                    {
-                        u = &(internal_to_external_node_map[leaf_object.u]);
-                        v = &(
-                            internal_to_external_node_map[m_geometry_list[forward_begin].node_id]);
-                    }
-                    else
+                    const auto source = has_speeds ? segment_speeds.GetSource(segment) : LUA_SOURCE;
+                    if (source != LUA_SOURCE)
                     {
-                        u = &(internal_to_external_node_map
-                                  [m_geometry_list[forward_begin +
-                                                   leaf_object.fwd_segment_position - 1]
-                                       .node_id]);
-                        v = &(internal_to_external_node_map
-                                  [m_geometry_list[forward_begin + leaf_object.fwd_segment_position]
-                                       .node_id]);
-                    }
-                    const double segment_length = util::coordinate_calculation::greatCircleDistance(
-                        util::Coordinate{u->lon, u->lat}, util::Coordinate{v->lon, v->lat});
-
-                    auto forward_speed_iter =
-                        find(segment_speed_lookup, Segment{u->node_id, v->node_id});
-                    if (forward_speed_iter != segment_speed_lookup.end())
-                    {
-                        int new_segment_weight =
-                            std::max(1,
-                                     static_cast<int>(std::floor(
-                                         (segment_length * 10.) /
-                                             (forward_speed_iter->speed_source.speed / 3.6) +
-                                         .5)));
-                        m_geometry_list[forward_begin + leaf_object.fwd_segment_position].weight =
-                            new_segment_weight;
-                        m_geometry_datasource[forward_begin + leaf_object.fwd_segment_position] =
-                            forward_speed_iter->speed_source.source;
-
-                        // count statistics for logging
-                        counters[forward_speed_iter->speed_source.source] += 1;
-                    }
-                    else
-                    {
-                        // count statistics for logging
-                        counters[LUA_SOURCE] += 1;
-                    }
-                }
-                if (leaf_object.reverse_packed_geometry_id != SPECIAL_EDGEID)
-                {
-                    const unsigned reverse_begin =
-                        m_geometry_indices.at(leaf_object.reverse_packed_geometry_id);
-                    const unsigned reverse_end =
-                        m_geometry_indices.at(leaf_object.reverse_packed_geometry_id + 1);
-
-                    int rev_segment_position =
-                        (reverse_end - reverse_begin) - leaf_object.fwd_segment_position - 1;
-                    if (rev_segment_position == 0)
-                    {
-                        u = &(internal_to_external_node_map[leaf_object.v]);
-                        v = &(
-                            internal_to_external_node_map[m_geometry_list[reverse_begin].node_id]);
-                    }
-                    else
-                    {
-                        u = &(
-                            internal_to_external_node_map[m_geometry_list[reverse_begin +
-                                                                          rev_segment_position - 1]
-                                                              .node_id]);
-                        v = &(internal_to_external_node_map
-                                  [m_geometry_list[reverse_begin + rev_segment_position].node_id]);
-                    }
-                    const double segment_length = util::coordinate_calculation::greatCircleDistance(
-                        util::Coordinate{u->lon, u->lat}, util::Coordinate{v->lon, v->lat});
-
-                    auto reverse_speed_iter =
-                        find(segment_speed_lookup, Segment{u->node_id, v->node_id});
-                    if (reverse_speed_iter != segment_speed_lookup.end())
-                    {
-                        int new_segment_weight =
-                            std::max(1,
-                                     static_cast<int>(std::floor(
-                                         (segment_length * 10.) /
-                                             (reverse_speed_iter->speed_source.speed / 3.6) +
-                                         .5)));
-                        m_geometry_list[reverse_begin + rev_segment_position].weight =
-                            new_segment_weight;
-                        m_geometry_datasource[reverse_begin + rev_segment_position] =
-                            reverse_speed_iter->speed_source.source;
-
-                        // count statistics for logging
-                        counters[reverse_speed_iter->speed_source.source] += 1;
-                    }
-                    else
-                    {
-                        // count statistics for logging
-                        counters[LUA_SOURCE] += 1;
+                        m_geometry_list[segment].weight = segment_speeds.GetWeight(segment);
+                        m_geometry_datasource[segment] = source;
                     }
+                    // count statistics for logging
+                    counters[source] += 1;
                 }
-            }
-        }); // parallel_for_each
+            });
 
         counters_type merged_counters(num_counters, 0);
         for (const auto &counters : segment_speeds_counters)
@@ -671,18 +658,14 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
                                              << segment_speed_filenames[i - 1];
             }
         }
-    }
+    };
 
     const auto maybe_save_geometries = [&] {
         if (!(update_edge_weights || update_turn_penalties))
             return;
 
         // Now save out the updated compressed geometries
-        std::ofstream geometry_stream(geometry_filename, std::ios::binary);
-        if (!geometry_stream)
-        {
-            throw util::exception("Failed to open " + geometry_filename + " for writing");
-        }
+        util::BufferedOutputFile geometry_stream(geometry_filename);
         const unsigned number_of_indices = m_geometry_indices.size();
         const unsigned number_of_compressed_geometries = m_geometry_list.size();
         geometry_stream.write(reinterpret_cast<const char *>(&number_of_indices), sizeof(unsigned));
@@ -693,14 +676,11 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
         geometry_stream.write(reinterpret_cast<char *>(&(m_geometry_list[0])),
                               number_of_compressed_geometries *
                                   sizeof(extractor::CompressedEdgeContainer::CompressedEdge));
+        geometry_stream.close();
     };
 
     const auto save_datasource_indexes = [&] {
-        std::ofstream datasource_stream(datasource_indexes_filename, std::ios::binary);
-        if (!datasource_stream)
-        {
-            throw util::exception("Failed to open " + datasource_indexes_filename + " for writing");
-        }
+        util::BufferedOutputFile datasource_stream(datasource_indexes_filename);
         std::uint64_t number_of_datasource_entries = m_geometry_datasource.size();
         datasource_stream.write(reinterpret_cast<const char *>(&number_of_datasource_entries),
                                 sizeof(number_of_datasource_entries));
@@ -709,6 +689,7 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
             datasource_stream.write(reinterpret_cast<char *>(&(m_geometry_datasource[0])),
                                     number_of_datasource_entries * sizeof(uint8_t));
         }
+        datasource_stream.close();
     };
 
     const auto save_datastore_names = [&] {
@@ -728,94 +709,47 @@ EdgeID Contractor::LoadEdgeExpandedGraph(
         }
     };
 
-    tbb::parallel_invoke(maybe_save_geometries, save_datasource_indexes, save_datastore_names);
-
-    auto penaltyblock =
-        reinterpret_cast<const extractor::lookup::PenaltyBlock *>(edge_penalty_region.get_address());
-    auto edge_segment_byte_ptr = reinterpret_cast<const char *>(edge_segment_region.get_address());
-    auto edge_based_edge_ptr = reinterpret_cast<extractor::EdgeBasedEdge *>(
-        reinterpret_cast<char *>(edge_based_graph_region.get_address()) + sizeof(EdgeBasedGraphHeader));
-
-    const auto edge_based_edge_last = reinterpret_cast<extractor::EdgeBasedEdge *>(
-        reinterpret_cast<char *>(edge_based_graph_region.get_address()) + sizeof(EdgeBasedGraphHeader) + sizeof(extractor::EdgeBasedEdge) * graph_header.number_of_edges);
+    const auto edge_based_edges =
+        compressed_graph
+            ? decompressed_edges.data()
+            : reinterpret_cast<const extractor::EdgeBasedEdge *>(
+                  reinterpret_cast<const char *>(edge_based_graph_region.get_address()) +
+                  sizeof(EdgeBasedGraphHeader));
 
-    while (edge_based_edge_ptr != edge_based_edge_last)
-    {
+    const auto update_edge = [&](const std::size_t edge) {
         // Make a copy of the data from the memory map
-        extractor::EdgeBasedEdge inbuffer = *edge_based_edge_ptr;
-        edge_based_edge_ptr++;
-
-        if (update_edge_weights || update_turn_penalties)
-        {
-            auto header = reinterpret_cast<const extractor::lookup::SegmentHeaderBlock *>(
-                edge_segment_byte_ptr);
-            edge_segment_byte_ptr += sizeof(extractor::lookup::SegmentHeaderBlock);
-
-            auto previous_osm_node_id = header->previous_osm_node_id;
-            int new_weight = 0;
-            int compressed_edge_nodes = static_cast<int>(header->num_osm_nodes);
-
-            auto segmentblocks =
-                reinterpret_cast<const extractor::lookup::SegmentBlock *>(edge_segment_byte_ptr);
-            edge_segment_byte_ptr +=
-                sizeof(extractor::lookup::SegmentBlock) * (header->num_osm_nodes - 1);
-
-            const auto num_segments = header->num_osm_nodes - 1;
-            for (auto i : util::irange<std::size_t>(0, num_segments))
-            {
-
-                auto speed_iter =
-                    find(segment_speed_lookup,
-                         Segment{previous_osm_node_id, segmentblocks[i].this_osm_node_id});
-                if (speed_iter != segment_speed_lookup.end())
-                {
-                    // This sets the segment weight using the same formula as the
-                    // EdgeBasedGraphFactory for consistency.  The *why* of this formula
-                    // is lost in the annals of time.
-                    int new_segment_weight = std::max(
-                        1,
-                        static_cast<int>(std::floor((segmentblocks[i].segment_length * 10.) /
-                                                        (speed_iter->speed_source.speed / 3.6) +
-                                                    .5)));
-                    new_weight += new_segment_weight;
-                }
-                else
-                {
-                    // If no lookup found, use the original weight value for this segment
-                    new_weight += segmentblocks[i].segment_weight;
-                }
-
-                previous_osm_node_id = segmentblocks[i].this_osm_node_id;
-            }
-
-            const auto turn_iter = turn_penalty_lookup.find(
-                std::make_tuple(penaltyblock->from_id, penaltyblock->via_id, penaltyblock->to_id));
-            if (turn_iter != turn_penalty_lookup.end())
-            {
-                int new_turn_weight = static_cast<int>(turn_iter->second.first * 10);
+        extractor::EdgeBasedEdge inbuffer = edge_based_edges[edge];
+        inbuffer.weight = GetUpdatedEdgeWeight(edge_segment_bytes + edge_segment_offsets[edge],
+                                               penalty_blocks[edge],
+                                               segment_speeds,
+                                               edge,
+                                               turn_penalty_lookup);
+        edge_based_edge_list[edge] = inbuffer;
+    };
 
-                if (new_turn_weight + new_weight < compressed_edge_nodes)
+    const auto load_edges = [&] {
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, graph_header.number_of_edges),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                for (const auto edge : util::irange(range.begin(), range.end()))
                 {
-                    util::SimpleLogger().Write(logWARNING)
-                        << "turn penalty " << turn_iter->second.first << " for turn "
-                        << penaltyblock->from_id << ", " << penaltyblock->via_id << ", "
-                        << penaltyblock->to_id << " is too negative: clamping turn weight to "
-                        << compressed_edge_nodes;
+                    if (update_edge_weights || update_turn_penalties)
+                        update_edge(edge);
+                    else
+                        edge_based_edge_list[edge] = edge_based_edges[edge];
                 }
+            });
+    };
 
-                inbuffer.weight = std::max(new_turn_weight + new_weight, compressed_edge_nodes);
-            }
-            else
-            {
-                inbuffer.weight = penaltyblock->fixed_penalty + new_weight;
-            }
-
-            // Increment the pointer
-            penaltyblock++;
-        }
-
-        edge_based_edge_list.emplace_back(std::move(inbuffer));
-    }
+    // The edge weights only depend on the segment lookups, not on the updated geometries, so the
+    // edges are copied from the mapped graph while the geometries are updated and written.
+    tbb::parallel_invoke(
+        [&] {
+            maybe_update_geometries();
+            tbb::parallel_invoke(
+                maybe_save_geometries, save_datasource_indexes, save_datastore_names);
+        },
+        load_edges);
 
     util::SimpleLogger().Write() << "Done reading edges";
     return graph_header.max_edge_id;
@@ -831,6 +765,96 @@ void Contractor::ReadNodeLevels(std::vector<float> &node_levels) const
     order_input_stream.read((char *)node_levels.data(), sizeof(float) * node_levels.size());
 }
 
+void Contractor::ReadContractedGraph(std::vector<QueryEdge> &contracted_edge_list) const
+{
+    std::vector<util::StaticGraph<EdgeData>::NodeArrayEntry> node_list;
+    std::vector<util::StaticGraph<EdgeData>::EdgeArrayEntry> edge_list;
+    unsigned check_sum = 0;
+    util::readHSGRFromStream(config.graph_output_path, node_list, edge_list, &check_sum);
+
+    contracted_edge_list.clear();
+    contracted_edge_list.reserve(edge_list.size());
+    for (const auto node : util::irange<std::size_t>(1UL, node_list.size()))
+    {
+        for (auto edge = node_list[node - 1].first_edge; edge < node_list[node].first_edge; ++edge)
+        {
+            contracted_edge_list.emplace_back(
+                static_cast<NodeID>(node - 1), edge_list[edge].target, edge_list[edge].data);
+        }
+    }
+    util::SimpleLogger().Write() << "Read " << contracted_edge_list.size()
+                                 << " edges of the previous hierarchy";
+}
+
+void Contractor::RenumberRTreeLeaves(const std::vector<NodeID> &previous_node_ids,
+                                     const std::vector<NodeID> &node_ids) const
+{
+    // empty orders are the ids of osrm-extract
+    const auto previous_to_extracted = InvertNodeOrder(previous_node_ids);
+    const auto renumber = [&](SegmentID &segment_id) {
+        if (!segment_id.enabled)
+            return;
+        const NodeID id = segment_id.id;
+        const auto extracted_id = previous_to_extracted.empty() ? id : previous_to_extracted[id];
+        segment_id.id = node_ids.empty() ? extracted_id : node_ids[extracted_id];
+    };
+
+    using LeafNode = util::StaticRTree<extractor::EdgeBasedNode>::LeafNode;
+    using boost::interprocess::file_mapping;
+    using boost::interprocess::mapped_region;
+    using boost::interprocess::read_write;
+
+    const file_mapping mapping{config.rtree_leaf_path.c_str(), read_write};
+    mapped_region region{mapping, read_write};
+    region.advise(mapped_region::advice_sequential);
+
+    const auto first = static_cast<LeafNode *>(region.get_address());
+    const auto last = first + (region.get_size() / sizeof(LeafNode));
+    tbb::parallel_for_each(first, last, [&](LeafNode &current_node) {
+        for (std::size_t i = 0; i < current_node.object_count; ++i)
+        {
+            auto &leaf_object = current_node.objects[i];
+            renumber(leaf_object.forward_segment_id);
+            renumber(leaf_object.reverse_segment_id);
+        }
+    });
+    region.flush();
+}
+
+void Contractor::RenumberDuplicatedNodes(const std::vector<NodeID> &previous_node_ids,
+                                         const std::vector<NodeID> &node_ids) const
+{
+    // missing in datasets of older osrm-extract versions
+    if (!boost::filesystem::exists(config.duplicated_nodes_path))
+    {
+        return;
+    }
+
+    std::vector<extractor::DuplicatedNode> duplicated_nodes;
+    if (!util::deserializeVector(config.duplicated_nodes_path, duplicated_nodes))
+    {
+        throw util::exception("Failed reading " + config.duplicated_nodes_path);
+    }
+
+    // empty orders are the ids of osrm-extract
+    const auto previous_to_extracted = InvertNodeOrder(previous_node_ids);
+    const auto renumber = [&](NodeID &id) {
+        const auto extracted_id = previous_to_extracted.empty() ? id : previous_to_extracted[id];
+        id = node_ids.empty() ? extracted_id : node_ids[extracted_id];
+    };
+    for (auto &duplicated_node : duplicated_nodes)
+    {
+        renumber(duplicated_node.original);
+        renumber(duplicated_node.duplicate);
+    }
+    std::sort(duplicated_nodes.begin(), duplicated_nodes.end());
+
+    if (!util::serializeVector(config.duplicated_nodes_path, duplicated_nodes))
+    {
+        throw util::exception("Failed writing " + config.duplicated_nodes_path);
+    }
+}
+
 void Contractor::WriteNodeLevels(std::vector<float> &&in_node_levels) const
 {
     std::vector<float> node_levels(std::move(in_node_levels));
@@ -859,71 +883,132 @@ void Contractor::WriteCoreNodeMarker(std::vector<bool> &&in_is_core_node) const
                                     sizeof(char) * unpacked_bool_flags.size());
 }
 
+void Contractor::WriteCoreLandmarks(const util::DeallocatingVector<QueryEdge> &contracted_edge_list,
+                                    const std::vector<bool> &is_core_node) const
+{
+    // the landmark searches only follow edges in between core nodes
+    std::vector<QueryEdge> core_edges;
+    for (const auto &edge : contracted_edge_list)
+    {
+        if (is_core_node[edge.source] && is_core_node[edge.target])
+        {
+            core_edges.push_back(edge);
+        }
+    }
+    tbb::parallel_sort(core_edges.begin(), core_edges.end());
+
+    struct CoreGraph : util::StaticGraph<EdgeData>
+    {
+        CoreGraph(const std::vector<bool> &is_core_node, const std::vector<QueryEdge> &edges)
+            : util::StaticGraph<EdgeData>(is_core_node.size(), edges), is_core_node(is_core_node)
+        {
+        }
+
+        bool IsCoreNode(const NodeID node) const { return is_core_node[node]; }
+
+        const std::vector<bool> &is_core_node;
+    };
+
+    TIMER_START(landmarks);
+    const CoreGraph core_graph(is_core_node, core_edges);
+    const engine::CoreLandmarks landmarks(core_graph, config.core_landmarks);
+    TIMER_STOP(landmarks);
+    util::SimpleLogger().Write() << "Computed " << landmarks.GetNumberOfLandmarks()
+                                 << " core landmarks in " << TIMER_SEC(landmarks) << "s";
+
+    boost::filesystem::ofstream landmarks_output_stream(config.core_landmarks_output_path,
+                                                        std::ios::binary);
+    const std::uint64_t number_of_distances = landmarks.GetNumberOfDistances();
+    landmarks_output_stream.write((char *)&number_of_distances, sizeof(std::uint64_t));
+    landmarks_output_stream.write((char *)landmarks.GetDistances(),
+                                  sizeof(EdgeWeight) * number_of_distances);
+}
+
 std::size_t
-Contractor::WriteContractedGraph(unsigned max_node_id,
+Contractor::WriteContractedGraph(const std::string &graph_path,
+                                 unsigned max_node_id,
                                  const util::DeallocatingVector<QueryEdge> &contracted_edge_list)
 {
     // Sorting contracted edges in a way that the static query graph can read some in in-place.
-    tbb::parallel_sort(contracted_edge_list.begin(), contracted_edge_list.end());
+    // The edges of each node are ordered into forward only, bidirectional and backward only ones,
+    // so each search direction relaxes a contiguous range, see StaticGraph::GetDirectedEdgeRange.
+    tbb::parallel_sort(contracted_edge_list.begin(),
+                       contracted_edge_list.end(),
+                       [](const QueryEdge &lhs, const QueryEdge &rhs) {
+                           return std::make_tuple(lhs.source,
+                                                  !lhs.data.forward,
+                                                  static_cast<bool>(lhs.data.backward),
+                                                  lhs.target) <
+                                  std::make_tuple(rhs.source,
+                                                  !rhs.data.forward,
+                                                  static_cast<bool>(rhs.data.backward),
+                                                  rhs.target);
+                       });
     const unsigned contracted_edge_count = contracted_edge_list.size();
     util::SimpleLogger().Write() << "Serializing compacted graph of " << contracted_edge_count
                                  << " edges";
 
     const util::FingerPrint fingerprint = util::FingerPrint::GetValid();
-    boost::filesystem::ofstream hsgr_output_stream(config.graph_output_path, std::ios::binary);
+    util::BufferedOutputFile hsgr_output_stream(graph_path);
     hsgr_output_stream.write((char *)&fingerprint, sizeof(util::FingerPrint));
-    const NodeID max_used_node_id = [&contracted_edge_list] {
-        NodeID tmp_max = 0;
-        for (const QueryEdge &edge : contracted_edge_list)
-        {
-            BOOST_ASSERT(SPECIAL_NODEID != edge.source);
-            BOOST_ASSERT(SPECIAL_NODEID != edge.target);
-            tmp_max = std::max(tmp_max, edge.source);
-            tmp_max = std::max(tmp_max, edge.target);
-        }
-        return tmp_max;
-    }();
+    const NodeID max_used_node_id = tbb::parallel_reduce(
+        tbb::blocked_range<std::size_t>(0, contracted_edge_count),
+        NodeID{0},
+        [&contracted_edge_list](const tbb::blocked_range<std::size_t> &range, NodeID tmp_max) {
+            for (const auto edge : util::irange(range.begin(), range.end()))
+            {
+                BOOST_ASSERT(SPECIAL_NODEID != contracted_edge_list[edge].source);
+                BOOST_ASSERT(SPECIAL_NODEID != contracted_edge_list[edge].target);
+                tmp_max = std::max(tmp_max, contracted_edge_list[edge].source);
+                tmp_max = std::max(tmp_max, contracted_edge_list[edge].target);
+            }
+            return tmp_max;
+        },
+        [](const NodeID lhs, const NodeID rhs) { return std::max(lhs, rhs); });
 
     util::SimpleLogger().Write(logDEBUG) << "input graph has " << (max_node_id + 1) << " nodes";
     util::SimpleLogger().Write(logDEBUG) << "contracted graph has " << (max_used_node_id + 1)
                                          << " nodes";
 
-    std::vector<util::StaticGraph<EdgeData>::NodeArrayEntry> node_array;
+    using NodeArrayEntry = util::StaticGraph<EdgeData>::NodeArrayEntry;
+    using EdgeArrayEntry = util::StaticGraph<EdgeData>::EdgeArrayEntry;
+
     // make sure we have at least one sentinel
-    node_array.resize(max_node_id + 2);
+    std::vector<NodeArrayEntry> node_array(max_node_id + 2);
 
     util::SimpleLogger().Write() << "Building node array";
-    util::StaticGraph<EdgeData>::EdgeIterator edge = 0;
-    util::StaticGraph<EdgeData>::EdgeIterator position = 0;
-    util::StaticGraph<EdgeData>::EdgeIterator last_edge;
-
-    // initializing 'first_edge'-field of nodes:
-    for (const auto node : util::irange(0u, max_used_node_id + 1))
-    {
-        last_edge = edge;
-        while ((edge < contracted_edge_count) && (contracted_edge_list[edge].source == node))
-        {
-            ++edge;
-        }
-        node_array[node].first_edge = position; //=edge
-        position += edge - last_edge;           // remove
-    }
-
-    for (const auto sentinel_counter :
-         util::irange<unsigned>(max_used_node_id + 1, node_array.size()))
-    {
-        // sentinel element, guarded against underflow
-        node_array[sentinel_counter].first_edge = contracted_edge_count;
-    }
+    // The first edge of a node is the number of edges of all nodes before it. As the edges are
+    // sorted by source, this prefix sum is filled in at the edges where the source changes: those
+    // set the nodes after the previous source up to their own source. Nodes after the last source
+    // are sentinels pointing behind the last edge.
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, contracted_edge_count),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (const auto edge : util::irange(range.begin(), range.end()))
+            {
+                const NodeID source = contracted_edge_list[edge].source;
+                if (edge > 0 && contracted_edge_list[edge - 1].source == source)
+                    continue;
+                const NodeID first_node = edge == 0 ? 0 : contracted_edge_list[edge - 1].source + 1;
+                for (const auto node : util::irange<std::size_t>(first_node, source + 1))
+                {
+                    node_array[node].first_edge = edge;
+                }
+            }
+        });
+    const std::size_t first_sentinel =
+        contracted_edge_count == 0 ? 0 : contracted_edge_list[contracted_edge_count - 1].source + 1;
+    std::fill(node_array.begin() + first_sentinel,
+              node_array.end(),
+              NodeArrayEntry{static_cast<EdgeID>(contracted_edge_count)});
 
     util::SimpleLogger().Write() << "Serializing node array";
 
-    RangebasedCRC32 crc32_calculator;
-    const unsigned edges_crc32 = crc32_calculator(contracted_edge_list);
-    util::SimpleLogger().Write() << "Writing CRC32: " << edges_crc32;
-
     const unsigned node_array_size = node_array.size();
-    // serialize crc32, aka checksum
+    // serialize crc32, aka checksum, of the edge array. It is only known once the edges are
+    // written, so this is a placeholder.
+    const auto checksum_position = hsgr_output_stream.tellp();
+    unsigned edges_crc32 = 0;
     hsgr_output_stream.write((char *)&edges_crc32, sizeof(unsigned));
     // serialize number of nodes
     hsgr_output_stream.write((char *)&node_array_size, sizeof(unsigned));
@@ -932,47 +1017,61 @@ Contractor::WriteContractedGraph(unsigned max_node_id,
     // serialize all nodes
     if (node_array_size > 0)
     {
-        hsgr_output_stream.write((char *)&node_array[0],
-                                 sizeof(util::StaticGraph<EdgeData>::NodeArrayEntry) *
-                                     node_array_size);
+        hsgr_output_stream.write((char *)&node_array[0], sizeof(NodeArrayEntry) * node_array_size);
     }
 
-    // serialize all edges
-    util::SimpleLogger().Write() << "Building edge array";
-    std::size_t number_of_used_edges = 0;
-
-    util::StaticGraph<EdgeData>::EdgeArrayEntry current_edge;
-    for (const auto edge : util::irange<std::size_t>(0UL, contracted_edge_list.size()))
-    {
-        // some self-loops are required for oneway handling. Need to assertthat we only keep these
-        // (TODO)
-        // no eigen loops
-        // BOOST_ASSERT(contracted_edge_list[edge].source != contracted_edge_list[edge].target ||
-        // node_represents_oneway[contracted_edge_list[edge].source]);
-        current_edge.target = contracted_edge_list[edge].target;
-        current_edge.data = contracted_edge_list[edge].data;
-
-        // every target needs to be valid
-        BOOST_ASSERT(current_edge.target <= max_used_node_id);
 #ifndef NDEBUG
-        if (current_edge.data.distance <= 0)
-        {
-            util::SimpleLogger().Write(logWARNING)
-                << "Edge: " << edge << ",source: " << contracted_edge_list[edge].source
-                << ", target: " << contracted_edge_list[edge].target
-                << ", dist: " << current_edge.data.distance;
-
-            util::SimpleLogger().Write(logWARNING) << "Failed at adjacency list of node "
-                                                   << contracted_edge_list[edge].source << "/"
-                                                   << node_array.size() - 1;
-            return 1;
-        }
+    const auto invalid_edge = std::find_if(contracted_edge_list.begin(),
+                                           contracted_edge_list.end(),
+                                           [](const QueryEdge &edge) {
+                                               return edge.data.distance <= 0;
+                                           });
+    if (invalid_edge != contracted_edge_list.end())
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "Edge: " << (invalid_edge - contracted_edge_list.begin())
+            << ",source: " << invalid_edge->source << ", target: " << invalid_edge->target
+            << ", dist: " << invalid_edge->data.distance;
+
+        util::SimpleLogger().Write(logWARNING) << "Failed at adjacency list of node "
+                                               << invalid_edge->source << "/"
+                                               << node_array.size() - 1;
+        return 1;
+    }
 #endif
-        hsgr_output_stream.write((char *)&current_edge,
-                                 sizeof(util::StaticGraph<EdgeData>::EdgeArrayEntry));
 
-        ++number_of_used_edges;
+    // serialize all edges, each block is converted in parallel while the previous one is written
+    util::SimpleLogger().Write() << "Building edge array";
+    const std::size_t edges_per_block = util::detail::FILE_BLOCK_SIZE / sizeof(EdgeArrayEntry);
+    std::vector<EdgeArrayEntry> edge_block(std::min<std::size_t>(edges_per_block,
+                                                                 contracted_edge_count));
+    for (std::size_t block_begin = 0; block_begin < contracted_edge_count;
+         block_begin += edges_per_block)
+    {
+        const auto block_end =
+            std::min<std::size_t>(block_begin + edges_per_block, contracted_edge_count);
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(block_begin, block_end),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (const auto edge : util::irange(range.begin(), range.end()))
+                              {
+                                  auto &current_edge = edge_block[edge - block_begin];
+                                  current_edge.target = contracted_edge_list[edge].target;
+                                  current_edge.data = contracted_edge_list[edge].data;
+                                  // every target needs to be valid
+                                  BOOST_ASSERT(current_edge.target <= max_used_node_id);
+                              }
+                          });
+        const auto block_data = reinterpret_cast<const char *>(edge_block.data());
+        const auto block_size = (block_end - block_begin) * sizeof(EdgeArrayEntry);
+        edges_crc32 = util::CombineCRC32C(
+            edges_crc32, util::ParallelCRC32C(block_data, block_size), block_size);
+        hsgr_output_stream.write(block_data, block_size);
     }
+    util::SimpleLogger().Write() << "Writing CRC32: " << edges_crc32;
+    hsgr_output_stream.seekp(checksum_position);
+    hsgr_output_stream.write((char *)&edges_crc32, sizeof(unsigned));
+    const std::size_t number_of_used_edges = contracted_edge_count;
+    hsgr_output_stream.close();
 
     return number_of_used_edges;
 }
@@ -986,14 +1085,32 @@ void Contractor::ContractGraph(
     util::DeallocatingVector<QueryEdge> &contracted_edge_list,
     std::vector<EdgeWeight> &&node_weights,
     std::vector<bool> &is_core_node,
-    std::vector<float> &inout_node_levels) const
+    std::vector<float> &inout_node_levels,
+    const std::vector<QueryEdge> &previous_edges) const
 {
     std::vector<float> node_levels;
     node_levels.swap(inout_node_levels);
 
     GraphContractor graph_contractor(
         max_edge_id + 1, edge_based_edge_list, std::move(node_levels), std::move(node_weights));
-    graph_contractor.Run(config.core_factor);
+    if (config.incremental)
+    {
+        graph_contractor.SetPreviousHierarchy(previous_edges, config.incremental_radius);
+        if (config.reorder_changed)
+        {
+            graph_contractor.ReorderDirtyNodes();
+        }
+    }
+    if (config.checkpoint_interval > 0)
+    {
+        graph_contractor.SetCheckpoint(config.checkpoint_path, config.checkpoint_interval * 60.);
+        graph_contractor.SetInterruptFlag(contraction_interrupted);
+    }
+    if (!graph_contractor.Run(config.core_factor))
+    {
+        throw util::exception("Contraction interrupted, run osrm-contract again to resume from " +
+                              config.checkpoint_path);
+    }
     graph_contractor.GetEdges(contracted_edge_list);
     graph_contractor.GetCoreMarker(is_core_node);
     graph_contractor.GetNodeLevels(inout_node_levels);
@@ -0,0 +1,208 @@
+#include "contractor/edge_lengths.hpp"
+#include "contractor/query_graph_update.hpp"
+
+#include "extractor/edge_based_node.hpp"
+#include "extractor/query_node.hpp"
+
+#include "util/coordinate_calculation.hpp"
+#include "util/exception.hpp"
+#include "util/graph_loader.hpp"
+#include "util/integer_range.hpp"
+#include "util/intermediate_file.hpp"
+#include "util/simple_logger.hpp"
+#include "util/static_rtree.hpp"
+#include "util/timing_util.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+namespace
+{
+using query_graph_update::QueryGraphData;
+using query_graph_update::GraphNode;
+using query_graph_update::GraphEdge;
+using LeafNode = util::StaticRTree<extractor::EdgeBasedNode>::LeafNode;
+
+std::vector<util::Coordinate> ReadCoordinates(const std::string &nodes_path)
+{
+    util::IntermediateInputFile nodes_stream(nodes_path);
+    unsigned number_of_coordinates = 0;
+    nodes_stream.read((char *)&number_of_coordinates, sizeof(unsigned));
+    std::vector<util::Coordinate> coordinates(number_of_coordinates);
+    extractor::QueryNode current_node;
+    for (const auto index : util::irange(0u, number_of_coordinates))
+    {
+        nodes_stream.read((char *)&current_node, sizeof(extractor::QueryNode));
+        coordinates[index] = util::Coordinate(current_node.lon, current_node.lat);
+    }
+    if (!nodes_stream)
+    {
+        throw util::exception("Could not read " + nodes_path);
+    }
+    return coordinates;
+}
+
+// Sums the segments of every edge-based node, the r-tree leaves are the only place that knows
+// both ends of each segment
+std::vector<double> ComputeNodeLengths(const NodeID number_of_nodes,
+                                       const std::string &rtree_leaf_path,
+                                       const std::vector<util::Coordinate> &coordinates)
+{
+    using boost::interprocess::file_mapping;
+    using boost::interprocess::mapped_region;
+    using boost::interprocess::read_only;
+
+    const file_mapping mapping{rtree_leaf_path.c_str(), read_only};
+    mapped_region region{mapping, read_only};
+    region.advise(mapped_region::advice_sequential);
+    const auto first = static_cast<const LeafNode *>(region.get_address());
+    const auto last = first + (region.get_size() / sizeof(LeafNode));
+
+    std::vector<double> node_lengths(number_of_nodes, 0.);
+    for (auto leaf = first; leaf != last; ++leaf)
+    {
+        for (std::size_t i = 0; i < leaf->object_count; ++i)
+        {
+            const auto &segment = leaf->objects[i];
+            const auto length = util::coordinate_calculation::haversineDistance(
+                coordinates.at(segment.u), coordinates.at(segment.v));
+            if (segment.forward_segment_id.enabled)
+            {
+                node_lengths.at(segment.forward_segment_id.id) += length;
+            }
+            if (segment.reverse_segment_id.enabled)
+            {
+                node_lengths.at(segment.reverse_segment_id.id) += length;
+            }
+        }
+    }
+    return node_lengths;
+}
+
+// Length of the edge of the middle node to target in the given direction that has the smallest
+// weight, that is the edge a shortcut over the middle node was built from
+EdgeLength FindMiddleEdgeLength(const QueryGraphData &data,
+                                const std::vector<EdgeLength> &edge_lengths,
+                                const NodeID middle,
+                                const NodeID target,
+                                const bool forward)
+{
+    int weight = INVALID_EDGE_WEIGHT;
+    EdgeLength length = 0;
+    for (const auto edge : util::irange(data.BeginEdges(middle), data.EndEdges(middle)))
+    {
+        const auto &edge_data = data.edges[edge].data;
+        if (data.edges[edge].target == target &&
+            (forward ? edge_data.forward : edge_data.backward) && edge_data.distance < weight)
+        {
+            weight = edge_data.distance;
+            length = edge_lengths[edge];
+        }
+    }
+    BOOST_ASSERT(weight != INVALID_EDGE_WEIGHT);
+    return length;
+}
+}
+
+void WriteEdgeLengths(const ContractorConfig &config)
+{
+    TIMER_START(edge_lengths);
+
+    std::vector<GraphNode> nodes;
+    std::vector<GraphEdge> edges;
+    unsigned checksum = 0;
+    util::readHSGRFromStream(config.graph_output_path, nodes, edges, &checksum);
+
+    QueryGraphData data;
+    data.nodes = nodes.data();
+    data.edges = edges.data();
+    data.number_of_nodes = nodes.empty() ? 0 : nodes.size() - 1;
+
+    const auto node_lengths = ComputeNodeLengths(data.number_of_nodes,
+                                                 config.rtree_leaf_path,
+                                                 ReadCoordinates(config.node_based_graph_path));
+
+    std::vector<EdgeLength> edge_lengths(edges.size(), 0);
+    for (const auto node : util::irange<NodeID>(0, data.number_of_nodes))
+    {
+        for (const auto edge : util::irange(data.BeginEdges(node), data.EndEdges(node)))
+        {
+            if (!edges[edge].data.shortcut)
+            {
+                edge_lengths[edge] = (node_lengths[node] + node_lengths[edges[edge].target]) / 2;
+            }
+        }
+    }
+
+    // the edges a shortcut replaces are at its middle node, which is in a lower layer
+    const auto layers = query_graph_update::GetShortcutLayers(data);
+    for (const auto layer_index : util::irange<std::size_t>(1, layers.size()))
+    {
+        const auto &layer = layers[layer_index];
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, layer.size()),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                for (const auto index : util::irange(range.begin(), range.end()))
+                {
+                    const auto node = layer[index];
+                    for (const auto edge :
+                         util::irange(data.BeginEdges(node), data.EndEdges(node)))
+                    {
+                        const auto &edge_data = edges[edge].data;
+                        if (!edge_data.shortcut)
+                        {
+                            continue;
+                        }
+                        const NodeID middle = edge_data.id;
+                        const NodeID target = edges[edge].target;
+
+                        const auto via_middle = [&](const NodeID from, const NodeID to) {
+                            return FindMiddleEdgeLength(data, edge_lengths, middle, from, false) +
+                                   FindMiddleEdgeLength(data, edge_lengths, middle, to, true);
+                        };
+                        EdgeLength length = 0;
+                        if (edge_data.forward)
+                        {
+                            length = std::max(length, via_middle(node, target));
+                        }
+                        if (edge_data.backward)
+                        {
+                            length = std::max(length, via_middle(target, node));
+                        }
+                        edge_lengths[edge] = length;
+                    }
+                }
+            });
+    }
+
+    boost::filesystem::ofstream edge_lengths_stream(config.edge_lengths_output_path,
+                                                    std::ios::binary);
+    const std::uint64_t number_of_edges = edge_lengths.size();
+    edge_lengths_stream.write((char *)&number_of_edges, sizeof(std::uint64_t));
+    edge_lengths_stream.write((char *)edge_lengths.data(), sizeof(EdgeLength) * number_of_edges);
+    if (!edge_lengths_stream)
+    {
+        throw util::exception("Could not write " + config.edge_lengths_output_path);
+    }
+
+    TIMER_STOP(edge_lengths);
+    util::SimpleLogger().Write() << "Computed the lengths of " << number_of_edges << " edges in "
+                                 << TIMER_SEC(edge_lengths) << "s";
+}
+}
+}
@@ -0,0 +1,307 @@
+#include "contractor/query_graph_update.hpp"
+
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace osrm
+{
+namespace contractor
+{
+namespace query_graph_update
+{
+
+namespace
+{
+boost::interprocess::mapped_region MapFile(const std::string &filename)
+{
+    using boost::interprocess::file_mapping;
+    using boost::interprocess::mapped_region;
+    using boost::interprocess::read_only;
+
+    const file_mapping mapping{filename.c_str(), read_only};
+    mapped_region region{mapping, read_only};
+    region.advise(mapped_region::advice_willneed);
+    return region;
+}
+
+// Smallest weight of the edges of the middle node to target in the given direction
+int FindMiddleEdgeWeight(const QueryGraphData &data,
+                         const NodeID middle,
+                         const NodeID target,
+                         const bool forward)
+{
+    int weight = INVALID_EDGE_WEIGHT;
+    for (const auto edge : util::irange(data.BeginEdges(middle), data.EndEdges(middle)))
+    {
+        const auto &edge_data = data.edges[edge].data;
+        if (data.edges[edge].target == target &&
+            (forward ? edge_data.forward : edge_data.backward))
+        {
+            weight = std::min<int>(weight, edge_data.distance);
+        }
+    }
+    return weight;
+}
+}
+
+std::vector<std::vector<NodeID>> GetShortcutLayers(const QueryGraphData &data)
+{
+    const constexpr auto UNKNOWN_LAYER = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::uint32_t> layer(data.number_of_nodes, UNKNOWN_LAYER);
+
+    // iterative depth-first search through the middle nodes, the layer of a node is one above the
+    // highest layer of the middle nodes of its shortcuts
+    std::vector<std::pair<NodeID, EdgeID>> stack;
+    for (const auto root : util::irange<NodeID>(0, data.number_of_nodes))
+    {
+        if (layer[root] != UNKNOWN_LAYER)
+        {
+            continue;
+        }
+        layer[root] = 0;
+        stack.emplace_back(root, data.BeginEdges(root));
+        while (!stack.empty())
+        {
+            const auto node = stack.back().first;
+            const auto edge = stack.back().second;
+            if (edge == data.EndEdges(node))
+            {
+                stack.pop_back();
+                if (!stack.empty())
+                {
+                    auto &parent_layer = layer[stack.back().first];
+                    parent_layer = std::max(parent_layer, layer[node] + 1);
+                }
+                continue;
+            }
+            ++stack.back().second;
+
+            const auto &edge_data = data.edges[edge].data;
+            if (!edge_data.shortcut)
+            {
+                continue;
+            }
+            const NodeID middle = edge_data.id;
+            BOOST_ASSERT(middle < data.number_of_nodes);
+            if (layer[middle] == UNKNOWN_LAYER)
+            {
+                layer[middle] = 0;
+                stack.emplace_back(middle, data.BeginEdges(middle));
+            }
+            else
+            {
+                layer[node] = std::max(layer[node], layer[middle] + 1);
+            }
+        }
+    }
+
+    const auto number_of_layers =
+        data.number_of_nodes == 0 ? 0 : *std::max_element(layer.begin(), layer.end()) + 1;
+    std::vector<std::vector<NodeID>> layers(number_of_layers);
+    for (const auto node : util::irange<NodeID>(0, data.number_of_nodes))
+    {
+        layers[layer[node]].push_back(node);
+    }
+    return layers;
+}
+
+std::size_t UpdateGeometryWeights(const QueryGraphData &data, const SegmentSpeeds &segment_speeds)
+{
+    if (segment_speeds.GetNumberOfSegments() != data.number_of_geometry_segments)
+    {
+        throw util::exception("Segment index does not match the loaded dataset");
+    }
+
+    std::atomic<std::size_t> number_of_updated_segments{0};
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, data.number_of_geometry_segments),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          std::size_t updated = 0;
+                          for (const auto segment : util::irange(range.begin(), range.end()))
+                          {
+                              if (segment_speeds.GetSource(segment) != 0)
+                              {
+                                  data.geometry_list[segment].weight =
+                                      segment_speeds.GetWeight(segment);
+                                  ++updated;
+                              }
+                          }
+                          number_of_updated_segments += updated;
+                      });
+    return number_of_updated_segments;
+}
+
+std::size_t UpdateOriginalEdges(const QueryGraphData &data,
+                                const ContractorConfig &config,
+                                const SegmentSpeeds &segment_speeds,
+                                const TurnPenaltyLookup &turn_penalty_lookup,
+                                std::vector<char> &is_changed)
+{
+    const auto edge_segment_region = MapFile(config.edge_segment_lookup_path);
+    const auto edge_penalty_region = MapFile(config.edge_penalty_path);
+
+    const auto edge_segment_bytes = static_cast<const char *>(edge_segment_region.get_address());
+    const auto penalty_blocks = static_cast<const extractor::lookup::PenaltyBlock *>(
+        edge_penalty_region.get_address());
+    const auto number_of_original_edges =
+        edge_penalty_region.get_size() / sizeof(extractor::lookup::PenaltyBlock);
+    const auto edge_segment_offsets =
+        GetEdgeSegmentOffsets(edge_segment_bytes, number_of_original_edges);
+    if (segment_speeds.GetNumberOfSegments() > 0 &&
+        segment_speeds.GetNumberOfEdges() != number_of_original_edges)
+    {
+        throw util::exception("Segment index does not match the edge lookup files");
+    }
+
+    std::atomic<std::size_t> number_of_changed_edges{0};
+    tbb::parallel_for(
+        tbb::blocked_range<NodeID>(0, data.number_of_nodes),
+        [&](const tbb::blocked_range<NodeID> &range) {
+            std::size_t changed = 0;
+            for (const auto node : util::irange(range.begin(), range.end()))
+            {
+                for (const auto edge : util::irange(data.BeginEdges(node), data.EndEdges(node)))
+                {
+                    auto &edge_data = data.edges[edge].data;
+                    if (edge_data.shortcut)
+                    {
+                        continue;
+                    }
+                    const EdgeID original_edge = edge_data.id;
+                    if (original_edge >= number_of_original_edges)
+                    {
+                        throw util::exception("Edge lookup files do not match the loaded dataset");
+                    }
+                    const auto weight = std::max(
+                        1,
+                        GetUpdatedEdgeWeight(edge_segment_bytes +
+                                                 edge_segment_offsets[original_edge],
+                                             penalty_blocks[original_edge],
+                                             segment_speeds,
+                                             original_edge,
+                                             turn_penalty_lookup));
+                    if (weight != edge_data.distance)
+                    {
+                        edge_data.distance = weight;
+                        is_changed[node] = true;
+                        ++changed;
+                    }
+                }
+            }
+            number_of_changed_edges += changed;
+        });
+    return number_of_changed_edges;
+}
+
+std::size_t ExcludeEdgeClasses(const QueryGraphData &data,
+                               const std::vector<extractor::OriginalEdgeData> &original_edges,
+                               const extractor::EdgeClasses classes,
+                               std::vector<char> &is_changed)
+{
+    std::atomic<std::size_t> number_of_changed_edges{0};
+    tbb::parallel_for(
+        tbb::blocked_range<NodeID>(0, data.number_of_nodes),
+        [&](const tbb::blocked_range<NodeID> &range) {
+            std::size_t changed = 0;
+            for (const auto node : util::irange(range.begin(), range.end()))
+            {
+                for (const auto edge : util::irange(data.BeginEdges(node), data.EndEdges(node)))
+                {
+                    auto &edge_data = data.edges[edge].data;
+                    if (edge_data.shortcut)
+                    {
+                        continue;
+                    }
+                    if (edge_data.id >= original_edges.size())
+                    {
+                        throw util::exception("Edge data file does not match the loaded dataset");
+                    }
+                    if ((original_edges[edge_data.id].classes & classes) != 0 &&
+                        edge_data.distance != EXCLUDED_EDGE_WEIGHT)
+                    {
+                        edge_data.distance = EXCLUDED_EDGE_WEIGHT;
+                        is_changed[node] = true;
+                        ++changed;
+                    }
+                }
+            }
+            number_of_changed_edges += changed;
+        });
+    return number_of_changed_edges;
+}
+
+std::size_t RepairShortcuts(const QueryGraphData &data, std::vector<char> &is_changed)
+{
+    const auto layers = GetShortcutLayers(data);
+
+    std::atomic<std::size_t> number_of_changed_shortcuts{0};
+    // layer 0 has no shortcuts
+    for (const auto layer_index : util::irange<std::size_t>(1, layers.size()))
+    {
+        const auto &layer = layers[layer_index];
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, layer.size()),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                std::size_t changed = 0;
+                for (const auto index : util::irange(range.begin(), range.end()))
+                {
+                    const auto node = layer[index];
+                    for (const auto edge :
+                         util::irange(data.BeginEdges(node), data.EndEdges(node)))
+                    {
+                        auto &edge_data = data.edges[edge].data;
+                        if (!edge_data.shortcut || !is_changed[edge_data.id])
+                        {
+                            continue;
+                        }
+                        const NodeID middle = edge_data.id;
+                        const NodeID target = data.edges[edge].target;
+
+                        // node -> middle -> target and target -> middle -> node
+                        const auto via_middle = [&](const NodeID from, const NodeID to) {
+                            const auto first = FindMiddleEdgeWeight(data, middle, from, false);
+                            const auto second = FindMiddleEdgeWeight(data, middle, to, true);
+                            BOOST_ASSERT(first != INVALID_EDGE_WEIGHT &&
+                                         second != INVALID_EDGE_WEIGHT);
+                            return static_cast<int>(std::min<std::int64_t>(
+                                std::int64_t{first} + second, EXCLUDED_EDGE_WEIGHT));
+                        };
+                        // both directions share one weight, the larger one is kept so the
+                        // cheaper direction is overestimated until the next osrm-contract run
+                        int weight = 0;
+                        if (edge_data.forward)
+                        {
+                            weight = std::max(weight, via_middle(node, target));
+                        }
+                        if (edge_data.backward)
+                        {
+                            weight = std::max(weight, via_middle(target, node));
+                        }
+                        if (weight != edge_data.distance)
+                        {
+                            edge_data.distance = weight;
+                            is_changed[node] = true;
+                            ++changed;
+                        }
+                    }
+                }
+                number_of_changed_shortcuts += changed;
+            });
+    }
+    return number_of_changed_shortcuts;
+}
+}
+}
+}
@@ -0,0 +1,209 @@
+#include "contractor/shared_traffic_update.hpp"
+#include "contractor/query_graph_update.hpp"
+#include "contractor/traffic_lookup.hpp"
+
+#include "storage/shared_barriers.hpp"
+#include "storage/shared_datatype.hpp"
+#include "storage/shared_memory.hpp"
+
+#include "util/exception.hpp"
+#include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
+
+#include <boost/interprocess/sync/scoped_lock.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+namespace
+{
+using query_graph_update::QueryGraphData;
+using query_graph_update::GraphNode;
+using query_graph_update::GraphEdge;
+using query_graph_update::CompressedEdge;
+
+// the data region is copied in blocks of this size in parallel
+const constexpr std::size_t COPY_BLOCK_SIZE = 64 * 1024 * 1024;
+
+void ParallelCopy(const char *source, const std::uint64_t size, char *destination)
+{
+    tbb::parallel_for(tbb::blocked_range<std::uint64_t>(0, size, COPY_BLOCK_SIZE),
+                      [&](const tbb::blocked_range<std::uint64_t> &range) {
+                          std::memcpy(destination + range.begin(),
+                                      source + range.begin(),
+                                      range.end() - range.begin());
+                      });
+}
+}
+
+SharedTrafficUpdate::SharedTrafficUpdate(ContractorConfig config_) : config(std::move(config_)) {}
+
+int SharedTrafficUpdate::Run()
+{
+    TIMER_START(update);
+    storage::SharedBarriers barrier;
+
+    // serializes concurrent updates
+    boost::interprocess::scoped_lock<storage::SharedBarriers::mutex_type> pending_lock(
+        barrier.pending_update_mutex);
+
+    if (!storage::SharedMemory::RegionExists(storage::CURRENT_REGIONS))
+    {
+        throw util::exception("No dataset loaded into shared memory, run osrm-datastore first");
+    }
+    auto *data_type_memory = storage::makeSharedMemory(
+        storage::CURRENT_REGIONS, sizeof(storage::SharedDataTimestamp), true, false);
+    auto *data_timestamp_ptr = static_cast<storage::SharedDataTimestamp *>(data_type_memory->Ptr());
+
+    const auto previous_layout_region = data_timestamp_ptr->layout;
+    const auto previous_data_region = data_timestamp_ptr->data;
+    if (previous_data_region != storage::DATA_1 && previous_data_region != storage::DATA_2)
+    {
+        throw util::exception("No dataset loaded into shared memory, run osrm-datastore first");
+    }
+    const auto layout_region =
+        previous_layout_region == storage::LAYOUT_1 ? storage::LAYOUT_2 : storage::LAYOUT_1;
+    const auto data_region =
+        previous_data_region == storage::DATA_1 ? storage::DATA_2 : storage::DATA_1;
+
+    SegmentSpeeds segment_speeds;
+    TurnPenaltyLookup turn_penalty_lookup;
+
+    const auto parse_segment_speeds = [&] {
+        if (!config.segment_speed_lookup_paths.empty())
+            segment_speeds = SegmentSpeeds(SegmentSpeedLookup(config.segment_speed_lookup_paths,
+                                                              ParseSegmentSpeedCSV,
+                                                              SortSegmentSpeeds),
+                                           config.segment_index_path);
+    };
+
+    const auto parse_turn_penalties = [&] {
+        if (!config.turn_penalty_lookup_paths.empty())
+            turn_penalty_lookup = TurnPenaltyLookup(
+                config.turn_penalty_lookup_paths, ParseTurnPenaltyCSV, SortTurnPenalties);
+    };
+
+    // Copy the current dataset into the unused regions. Like the ones of osrm-datastore, the new
+    // regions must outlive this process, so their SharedMemory objects are never deleted.
+    storage::SharedMemory *layout_memory = nullptr;
+    storage::SharedMemory *data_memory = nullptr;
+    const auto copy_dataset = [&] {
+        std::unique_ptr<storage::SharedMemory> previous_layout_memory{
+            storage::makeSharedMemory(previous_layout_region)};
+        std::unique_ptr<storage::SharedMemory> previous_data_memory{
+            storage::makeSharedMemory(previous_data_region)};
+        const auto previous_layout =
+            static_cast<const storage::SharedDataLayout *>(previous_layout_memory->Ptr());
+        // the weights are updated in place, which the delta encoded geometries do not allow
+        if (previous_layout->num_entries[storage::SharedDataLayout::GEOMETRIES_ENCODED] > 0)
+        {
+            throw util::exception("Traffic updates need uncompressed geometries, run "
+                                  "osrm-datastore without --compress-geometries");
+        }
+
+        layout_memory = storage::makeSharedMemory(layout_region, sizeof(storage::SharedDataLayout));
+        new (layout_memory->Ptr()) storage::SharedDataLayout(*previous_layout);
+
+        const auto size = previous_layout->GetSizeOfLayout();
+        util::SimpleLogger().Write() << "copying shared memory of " << size << " bytes";
+        data_memory = storage::makeSharedMemory(data_region, size);
+        ParallelCopy(static_cast<const char *>(previous_data_memory->Ptr()),
+                     size,
+                     static_cast<char *>(data_memory->Ptr()));
+    };
+
+    tbb::parallel_invoke(parse_segment_speeds, parse_turn_penalties, copy_dataset);
+
+    auto layout = static_cast<storage::SharedDataLayout *>(layout_memory->Ptr());
+    auto memory = static_cast<char *>(data_memory->Ptr());
+
+    QueryGraphData data;
+    data.nodes = layout->GetBlockPtr<GraphNode>(memory, storage::SharedDataLayout::GRAPH_NODE_LIST);
+    data.edges = layout->GetBlockPtr<GraphEdge>(memory, storage::SharedDataLayout::GRAPH_EDGE_LIST);
+    const auto number_of_graph_nodes =
+        layout->num_entries[storage::SharedDataLayout::GRAPH_NODE_LIST];
+    data.number_of_nodes = number_of_graph_nodes == 0 ? 0 : number_of_graph_nodes - 1;
+    data.geometry_indices =
+        layout->GetBlockPtr<unsigned>(memory, storage::SharedDataLayout::GEOMETRIES_INDEX);
+    data.geometry_list =
+        layout->GetBlockPtr<CompressedEdge>(memory, storage::SharedDataLayout::GEOMETRIES_LIST);
+    data.number_of_geometry_segments =
+        layout->num_entries[storage::SharedDataLayout::GEOMETRIES_LIST];
+
+    std::size_t number_of_updated_segments = 0;
+    if (!config.segment_speed_lookup_paths.empty())
+    {
+        number_of_updated_segments =
+            query_graph_update::UpdateGeometryWeights(data, segment_speeds);
+    }
+    util::SimpleLogger().Write() << "Updated " << number_of_updated_segments
+                                 << " geometry segments";
+
+    std::vector<char> is_changed(data.number_of_nodes, false);
+    const auto number_of_changed_edges = query_graph_update::UpdateOriginalEdges(
+        data, config, segment_speeds, turn_penalty_lookup, is_changed);
+    util::SimpleLogger().Write() << "Changed the weights of " << number_of_changed_edges
+                                 << " edges";
+
+    const auto number_of_changed_shortcuts = query_graph_update::RepairShortcuts(data, is_changed);
+    util::SimpleLogger().Write() << "Repaired the weights of " << number_of_changed_shortcuts
+                                 << " shortcuts";
+
+    // landmark distances stop being lower bounds once weights decrease, osrm-routed falls back to
+    // computing them itself if --core-landmarks is set
+    if (layout->num_entries[storage::SharedDataLayout::CORE_LANDMARK_DISTANCES] > 0)
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "Dropping the core landmarks, they do not match the updated weights";
+        layout->SetBlockSize<EdgeWeight>(storage::SharedDataLayout::CORE_LANDMARK_DISTANCES, 0);
+    }
+
+    {
+        // Publish the new generation. Queries never wait for this: new queries pick up the new
+        // data, queries running on the previous data finish undisturbed.
+        data_timestamp_ptr->layout = layout_region;
+        data_timestamp_ptr->data = data_region;
+        data_timestamp_ptr->timestamp += 1;
+
+        // queries count themselves before they check the timestamp once more, so a query the wait
+        // below does not see finds the previous data outdated and does not run on it
+        boost::interprocess::scoped_lock<storage::SharedBarriers::mutex_type> query_lock(
+            barrier.query_mutex);
+        barrier.counters->update_pending = true;
+
+        // wait until the last query on the previous data notifies us
+        while (0 < barrier.counters->QueriesOn(previous_data_region))
+        {
+            barrier.no_running_queries_condition.wait(query_lock);
+        }
+
+        barrier.counters->update_pending = false;
+    }
+    for (const auto region : {previous_data_region, previous_layout_region})
+    {
+        if (storage::SharedMemory::RegionExists(region) && !storage::SharedMemory::Remove(region))
+        {
+            util::SimpleLogger().Write(logWARNING) << "could not delete previous shared memory";
+        }
+    }
+
+    TIMER_STOP(update);
+    util::SimpleLogger().Write() << "Published the updated weights after " << TIMER_SEC(update)
+                                 << "s";
+    return 0;
+}
+}
+}
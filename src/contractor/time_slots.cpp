@@ -0,0 +1,204 @@
+#include "contractor/time_slots.hpp"
+#include "contractor/query_graph_update.hpp"
+#include "contractor/traffic_lookup.hpp"
+#include "contractor/traffic_update_file.hpp"
+
+#include "extractor/original_edge_data.hpp"
+
+#include "util/exception.hpp"
+#include "util/graph_loader.hpp"
+#include "util/integer_range.hpp"
+#include "util/intermediate_file.hpp"
+#include "util/segment_weight_list.hpp"
+#include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+namespace
+{
+using query_graph_update::QueryGraphData;
+using query_graph_update::GraphNode;
+using query_graph_update::GraphEdge;
+using query_graph_update::CompressedEdge;
+
+struct GeometryData
+{
+    std::vector<unsigned> indices;
+    std::vector<CompressedEdge> list;
+};
+
+GeometryData ReadGeometries(const std::string &geometry_path)
+{
+    GeometryData geometries;
+    util::IntermediateInputFile geometry_stream(geometry_path);
+    unsigned number_of_indices = 0;
+    geometry_stream.read((char *)&number_of_indices, sizeof(unsigned));
+    geometries.indices.resize(number_of_indices);
+    geometry_stream.read((char *)geometries.indices.data(), number_of_indices * sizeof(unsigned));
+
+    unsigned number_of_compressed_geometries = 0;
+    geometry_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
+    geometries.list.resize(number_of_compressed_geometries);
+    geometry_stream.read((char *)geometries.list.data(),
+                         number_of_compressed_geometries * sizeof(CompressedEdge));
+    if (!geometry_stream)
+    {
+        throw util::exception("Could not read " + geometry_path);
+    }
+    return geometries;
+}
+
+std::vector<extractor::OriginalEdgeData> ReadOriginalEdges(const std::string &edge_data_path)
+{
+    util::IntermediateInputFile edge_data_stream(edge_data_path);
+    unsigned number_of_edges = 0;
+    edge_data_stream.read((char *)&number_of_edges, sizeof(unsigned));
+    std::vector<extractor::OriginalEdgeData> original_edges(number_of_edges);
+    edge_data_stream.read((char *)original_edges.data(),
+                          number_of_edges * sizeof(extractor::OriginalEdgeData));
+    if (!edge_data_stream)
+    {
+        throw util::exception("Could not read " + edge_data_path);
+    }
+    return original_edges;
+}
+}
+
+void WriteTimeSlots(const ContractorConfig &config)
+{
+    TIMER_START(time_slots);
+
+    std::vector<GraphNode> nodes;
+    std::vector<GraphEdge> edges;
+    unsigned checksum = 0;
+    util::readHSGRFromStream(config.graph_output_path, nodes, edges, &checksum);
+    const auto geometries = ReadGeometries(config.geometry_path);
+
+    const TurnPenaltyLookup turn_penalty_lookup(
+        config.turn_penalty_lookup_paths, ParseTurnPenaltyCSV, SortTurnPenalties);
+
+    TimeSlotsHeader header;
+    header.number_of_slots = config.time_slot_speed_lookup_paths.size();
+    header.slot_duration = config.time_slot_duration * 60;
+    header.number_of_edges = edges.size();
+    header.number_of_geometry_segments = geometries.list.size();
+    header.number_of_metrics =
+        config.metric_speed_lookup_paths.size() + config.exclude_classes.size();
+    header.segment_weight_bytes = sizeof(std::uint16_t);
+    if (header.number_of_metrics > TimeSlotsHeader::MAX_METRICS)
+    {
+        throw util::exception("Too many metrics, at most " +
+                              std::to_string(TimeSlotsHeader::MAX_METRICS) + " are supported");
+    }
+    header.metric_excluded_classes.fill(EDGE_CLASS_NONE);
+    std::vector<extractor::EdgeClasses> overlay_excluded_classes(
+        header.number_of_slots + config.metric_speed_lookup_paths.size(), EDGE_CLASS_NONE);
+    for (const auto &classes : config.exclude_classes)
+    {
+        const auto metric = overlay_excluded_classes.size() - header.number_of_slots;
+        overlay_excluded_classes.push_back(extractor::ParseEdgeClasses(classes));
+        header.metric_excluded_classes[metric] = overlay_excluded_classes.back();
+    }
+    const auto original_edges = config.exclude_classes.empty()
+                                    ? std::vector<extractor::OriginalEdgeData>()
+                                    : ReadOriginalEdges(config.edge_data_path);
+
+    // the metrics follow the time slots
+    auto overlay_speed_paths = config.time_slot_speed_lookup_paths;
+    overlay_speed_paths.insert(overlay_speed_paths.end(),
+                               config.metric_speed_lookup_paths.begin(),
+                               config.metric_speed_lookup_paths.end());
+
+    boost::filesystem::ofstream time_slots_stream(config.time_slots_output_path,
+                                                  std::ios::binary);
+    time_slots_stream.write((char *)&header, sizeof(TimeSlotsHeader));
+
+    std::vector<GraphEdge> slot_edges;
+    std::vector<CompressedEdge> slot_geometries;
+    std::vector<QueryEdge::EdgeData> slot_edge_data(edges.size());
+    std::vector<EdgeWeight> slot_segment_weights(geometries.list.size());
+    for (const auto slot : util::irange<std::size_t>(0, overlay_excluded_classes.size()))
+    {
+        slot_edges = edges;
+        slot_geometries = geometries.list;
+
+        QueryGraphData data;
+        data.nodes = nodes.data();
+        data.edges = slot_edges.data();
+        data.number_of_nodes = nodes.empty() ? 0 : nodes.size() - 1;
+        data.geometry_indices = geometries.indices.data();
+        data.geometry_list = slot_geometries.data();
+        data.number_of_geometry_segments = slot_geometries.size();
+
+        std::size_t number_of_updated_segments = 0;
+        std::size_t number_of_changed_edges = 0;
+        std::vector<char> is_changed(data.number_of_nodes, false);
+        if (slot < overlay_speed_paths.size())
+        {
+            // the speeds of the overlay take precedence over the ones of the whole dataset
+            auto segment_speed_paths = config.segment_speed_lookup_paths;
+            segment_speed_paths.push_back(overlay_speed_paths[slot]);
+            const SegmentSpeeds segment_speeds(
+                SegmentSpeedLookup(segment_speed_paths, ParseSegmentSpeedCSV, SortSegmentSpeeds),
+                config.segment_index_path);
+
+            number_of_updated_segments =
+                query_graph_update::UpdateGeometryWeights(data, segment_speeds);
+            number_of_changed_edges = query_graph_update::UpdateOriginalEdges(
+                data, config, segment_speeds, turn_penalty_lookup, is_changed);
+        }
+        else
+        {
+            // the .hsgr already has the weights of the dataset
+            number_of_changed_edges = query_graph_update::ExcludeEdgeClasses(
+                data, original_edges, overlay_excluded_classes[slot], is_changed);
+        }
+        const auto number_of_changed_shortcuts =
+            query_graph_update::RepairShortcuts(data, is_changed);
+        const auto overlay_name =
+            slot < header.number_of_slots
+                ? "Time slot " + std::to_string(slot)
+                : "Metric " + std::to_string(slot - header.number_of_slots + 1);
+        util::SimpleLogger().Write() << overlay_name << ": updated " << number_of_updated_segments
+                                     << " geometry segments, "
+                                     << number_of_changed_edges << " edges and "
+                                     << number_of_changed_shortcuts << " shortcuts";
+
+        for (const auto edge : util::irange<std::size_t>(0, slot_edges.size()))
+        {
+            slot_edge_data[edge] = slot_edges[edge].data;
+        }
+        for (const auto segment : util::irange<std::size_t>(0, slot_geometries.size()))
+        {
+            slot_segment_weights[segment] = slot_geometries[segment].weight;
+            if (!util::SegmentWeightList<>::FitsNarrow(slot_segment_weights[segment]))
+            {
+                header.segment_weight_bytes = sizeof(EdgeWeight);
+            }
+        }
+        time_slots_stream.write((char *)slot_edge_data.data(),
+                                sizeof(QueryEdge::EdgeData) * slot_edge_data.size());
+        time_slots_stream.write((char *)slot_segment_weights.data(),
+                                sizeof(EdgeWeight) * slot_segment_weights.size());
+    }
+    // the width is only known once all overlays are written
+    time_slots_stream.seekp(0);
+    time_slots_stream.write((char *)&header, sizeof(TimeSlotsHeader));
+
+    TIMER_STOP(time_slots);
+    util::SimpleLogger().Write() << "Computed the weights of " << header.number_of_slots
+                                 << " time slots and " << header.number_of_metrics
+                                 << " metrics in " << TIMER_SEC(time_slots) << "s";
+}
+}
+}
@@ -0,0 +1,150 @@
+#include "contractor/traffic_lookup.hpp"
+
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstring>
+
+namespace osrm
+{
+namespace contractor
+{
+
+SegmentSpeeds::SegmentSpeeds(const SegmentSpeedLookup &segment_speed_lookup,
+                             const std::string &segment_index_filename)
+{
+    using boost::interprocess::file_mapping;
+    using boost::interprocess::mapped_region;
+    using boost::interprocess::read_only;
+
+    if (!boost::filesystem::exists(segment_index_filename))
+    {
+        throw util::exception(segment_index_filename +
+                              " not found, run osrm-extract with --generate-edge-lookup again");
+    }
+    const file_mapping mapping{segment_index_filename.c_str(), read_only};
+    mapped_region region{mapping, read_only};
+    region.advise(mapped_region::advice_sequential);
+    const auto bytes = static_cast<const char *>(region.get_address());
+
+    std::size_t offset = 0;
+    const auto read_size = [&] {
+        std::uint64_t size = 0;
+        if (region.get_size() < offset + sizeof(size))
+        {
+            throw util::exception(segment_index_filename +
+                                  " is truncated, run the preprocessing again");
+        }
+        std::memcpy(&size, bytes + offset, sizeof(size));
+        offset += sizeof(size);
+        return size;
+    };
+    const auto skip = [&](const std::uint64_t size) {
+        if (region.get_size() < offset + size)
+        {
+            throw util::exception(segment_index_filename +
+                                  " is truncated, run the preprocessing again");
+        }
+        const auto begin = bytes + offset;
+        offset += size;
+        return begin;
+    };
+
+    const auto number_of_geometry_segments = read_size();
+    const auto number_of_segments = read_size();
+    const auto segments = reinterpret_cast<const extractor::lookup::SegmentIndexBlock *>(
+        skip(number_of_segments * sizeof(extractor::lookup::SegmentIndexBlock)));
+    const auto number_of_edges = read_size();
+    const auto first_segments = skip(number_of_edges * sizeof(std::uint32_t));
+
+    edge_first_segments.resize(number_of_edges);
+    std::memcpy(
+        edge_first_segments.data(), first_segments, number_of_edges * sizeof(std::uint32_t));
+
+    weights.resize(number_of_geometry_segments, INVALID_EDGE_WEIGHT);
+    sources.resize(number_of_geometry_segments, 0);
+    segment_speed_lookup.Join(
+        number_of_segments,
+        [segments](const std::size_t position) {
+            return std::make_tuple(static_cast<std::uint64_t>(segments[position].from_id),
+                                   static_cast<std::uint64_t>(segments[position].to_id));
+        },
+        [&](const std::size_t position, const SegmentSpeedEntry &entry, const std::uint8_t file) {
+            const auto segment = segments[position].segment;
+            BOOST_ASSERT(segment < number_of_geometry_segments);
+            weights[segment] = GetSegmentWeight(segments[position].segment_length, entry.speed);
+            sources[segment] = file;
+        });
+}
+
+std::vector<std::size_t> GetEdgeSegmentOffsets(const char *edge_segment_bytes,
+                                               const std::size_t number_of_edges)
+{
+    std::vector<std::size_t> offsets(number_of_edges);
+    std::size_t offset = 0;
+    for (const auto edge : util::irange<std::size_t>(0, number_of_edges))
+    {
+        offsets[edge] = offset;
+        const auto header = reinterpret_cast<const extractor::lookup::SegmentHeaderBlock *>(
+            edge_segment_bytes + offset);
+        offset += sizeof(extractor::lookup::SegmentHeaderBlock) +
+                  sizeof(extractor::lookup::SegmentBlock) * (header->num_osm_nodes - 1);
+    }
+    return offsets;
+}
+
+int GetUpdatedEdgeWeight(const char *edge_segments,
+                         const extractor::lookup::PenaltyBlock &penalty,
+                         const SegmentSpeeds &segment_speeds,
+                         const EdgeID edge,
+                         const TurnPenaltyLookup &turn_penalty_lookup)
+{
+    const auto header =
+        reinterpret_cast<const extractor::lookup::SegmentHeaderBlock *>(edge_segments);
+    const auto segmentblocks = reinterpret_cast<const extractor::lookup::SegmentBlock *>(
+        edge_segments + sizeof(extractor::lookup::SegmentHeaderBlock));
+
+    int new_weight = 0;
+    int compressed_edge_nodes = static_cast<int>(header->num_osm_nodes);
+
+    // the segments of the edge are the ones of the geometry of its source
+    const bool has_speeds = segment_speeds.GetNumberOfSegments() > 0;
+    const auto first_segment = has_speeds ? segment_speeds.GetFirstSegment(edge) : 0;
+    const auto num_segments = header->num_osm_nodes - 1;
+    for (auto i : util::irange<std::size_t>(0, num_segments))
+    {
+        if (has_speeds && segment_speeds.GetSource(first_segment + i) != 0)
+        {
+            new_weight += segment_speeds.GetWeight(first_segment + i);
+        }
+        else
+        {
+            // If no lookup found, use the original weight value for this segment
+            new_weight += segmentblocks[i].segment_weight;
+        }
+    }
+
+    const auto turn_penalty =
+        FindTurnPenalty(turn_penalty_lookup, penalty.from_id, penalty.via_id, penalty.to_id);
+    if (turn_penalty.first)
+    {
+        int new_turn_weight = static_cast<int>(turn_penalty.first->penalty * 10);
+
+        if (new_turn_weight + new_weight < compressed_edge_nodes)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "turn penalty " << turn_penalty.first->penalty << " for turn "
+                << penalty.from_id << ", " << penalty.via_id << ", " << penalty.to_id
+                << " is too negative: clamping turn weight to " << compressed_edge_nodes;
+        }
+
+        return std::max(new_turn_weight + new_weight, compressed_edge_nodes);
+    }
+    return penalty.fixed_penalty + new_weight;
+}
+}
+}
@@ -0,0 +1,220 @@
+#include "contractor/traffic_update_file.hpp"
+
+#include "util/exception.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace osrm
+{
+namespace contractor
+{
+
+constexpr const char TrafficFileHeader::MAGIC[8];
+constexpr const std::uint32_t TrafficFileHeader::VERSION;
+
+namespace
+{
+// large files are split into chunks of about this size that are parsed in parallel
+const constexpr std::size_t CSV_CHUNK_SIZE = 4 * 1024 * 1024;
+
+// Parses every line of a CSV file with parse_line(begin, end, entry), the description names the
+// kind of file in errors and starts lower case
+template <typename Entry, typename ParseLine>
+std::vector<Entry> ParseCSV(const std::string &filename,
+                            const std::string &description,
+                            const ParseLine &parse_line)
+{
+    if (!boost::filesystem::exists(filename))
+    {
+        throw util::exception{"Unable to open " + description + " file " + filename};
+    }
+    const auto file_size = boost::filesystem::file_size(filename);
+    if (file_size == 0)
+    {
+        return {};
+    }
+
+    using boost::interprocess::file_mapping;
+    using boost::interprocess::mapped_region;
+    using boost::interprocess::read_only;
+    const file_mapping mapping{filename.c_str(), read_only};
+    mapped_region region{mapping, read_only};
+    region.advise(mapped_region::advice_sequential);
+
+    const auto data_begin = static_cast<const char *>(region.get_address());
+    const auto data_end = data_begin + region.get_size();
+
+    // chunks start at the beginning of a line
+    const auto number_of_chunks = std::max<std::size_t>(1, region.get_size() / CSV_CHUNK_SIZE);
+    std::vector<const char *> chunk_begins{data_begin};
+    for (std::size_t chunk = 1; chunk < number_of_chunks; ++chunk)
+    {
+        const auto line_end =
+            std::find(data_begin + chunk * region.get_size() / number_of_chunks, data_end, '\n');
+        const auto line_begin = line_end == data_end ? data_end : line_end + 1;
+        if (line_begin > chunk_begins.back())
+        {
+            chunk_begins.push_back(line_begin);
+        }
+    }
+    chunk_begins.push_back(data_end);
+
+    std::vector<std::vector<Entry>> chunk_entries(chunk_begins.size() - 1);
+    tbb::parallel_for(std::size_t{0}, chunk_entries.size(), [&](const std::size_t chunk) {
+        auto &entries = chunk_entries[chunk];
+        const auto chunk_end = chunk_begins[chunk + 1];
+        for (auto line_begin = chunk_begins[chunk]; line_begin != chunk_end;)
+        {
+            const auto line_end = std::find(line_begin, chunk_end, '\n');
+            Entry entry;
+            if (!parse_line(line_begin, line_end, entry))
+            {
+                throw util::exception{"Malformed line in " + description + " file " + filename};
+            }
+            entries.push_back(entry);
+            line_begin = line_end == chunk_end ? chunk_end : line_end + 1;
+        }
+    });
+
+    std::vector<Entry> entries;
+    std::size_t number_of_entries = 0;
+    for (const auto &chunk : chunk_entries)
+    {
+        number_of_entries += chunk.size();
+    }
+    entries.reserve(number_of_entries);
+    for (const auto &chunk : chunk_entries)
+    {
+        entries.insert(entries.end(), chunk.begin(), chunk.end());
+    }
+    return entries;
+}
+
+template <typename Entry>
+void WriteEntries(const std::string &filename, const std::vector<Entry> &entries)
+{
+    BOOST_ASSERT(std::is_sorted(
+        entries.begin(), entries.end(), [](const Entry &lhs, const Entry &rhs) {
+            return lhs.Key() < rhs.Key();
+        }));
+
+    TrafficFileHeader header;
+    std::copy(std::begin(TrafficFileHeader::MAGIC),
+              std::end(TrafficFileHeader::MAGIC),
+              std::begin(header.magic));
+    header.version = TrafficFileHeader::VERSION;
+    header.kind = TrafficFileKind<Entry>::value;
+    header.number_of_entries = entries.size();
+
+    boost::filesystem::ofstream output(filename, std::ios::binary);
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char *>(entries.data()), sizeof(Entry) * entries.size());
+    if (!output)
+    {
+        throw util::exception{"Unable to write traffic file " + filename};
+    }
+}
+
+template <typename Entry> void SortByKey(std::vector<Entry> &entries)
+{
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &lhs, const Entry &rhs) {
+        return lhs.Key() < rhs.Key();
+    });
+}
+}
+
+bool IsBinaryTrafficFile(const std::string &filename)
+{
+    boost::filesystem::ifstream input(filename, std::ios::binary);
+    char magic[sizeof(TrafficFileHeader::MAGIC)];
+    return input.read(magic, sizeof(magic)) &&
+           std::equal(std::begin(magic), std::end(magic), std::begin(TrafficFileHeader::MAGIC));
+}
+
+std::vector<SegmentSpeedEntry> ParseSegmentSpeedCSV(const std::string &filename)
+{
+    return ParseCSV<SegmentSpeedEntry>(
+        filename,
+        "segment speed",
+        [](const char *begin, const char *end, SegmentSpeedEntry &entry) {
+            using namespace boost::spirit::qi;
+
+            entry.reserved = 0;
+            // The ulong_long -> uint64_t will likely break on 32bit platforms
+            return parse(begin,
+                         end,
+                         (ulong_long >> ',' >> ulong_long >> ',' >> uint_),
+                         entry.from,
+                         entry.to,
+                         entry.speed) &&
+                   begin == end;
+        });
+}
+
+std::vector<TurnPenaltyEntry> ParseTurnPenaltyCSV(const std::string &filename)
+{
+    return ParseCSV<TurnPenaltyEntry>(
+        filename,
+        "turn penalty",
+        [](const char *begin, const char *end, TurnPenaltyEntry &entry) {
+            using namespace boost::spirit::qi;
+
+            // The ulong_long -> uint64_t will likely break on 32bit platforms
+            return parse(begin,
+                         end,
+                         (ulong_long >> ',' >> ulong_long >> ',' >> ulong_long >> ',' >> double_),
+                         entry.from,
+                         entry.via,
+                         entry.to,
+                         entry.penalty) &&
+                   begin == end;
+        });
+}
+
+void SortSegmentSpeeds(std::vector<SegmentSpeedEntry> &entries)
+{
+    SortByKey(entries);
+    const auto last = std::unique(
+        entries.begin(),
+        entries.end(),
+        [](const SegmentSpeedEntry &lhs, const SegmentSpeedEntry &rhs) {
+            return lhs.Key() == rhs.Key();
+        });
+    entries.erase(last, entries.end());
+}
+
+void SortTurnPenalties(std::vector<TurnPenaltyEntry> &entries)
+{
+    SortByKey(entries);
+    // keep the last of consecutive entries with the same key
+    auto output = entries.begin();
+    for (auto entry = entries.begin(); entry != entries.end(); ++entry)
+    {
+        const auto next = std::next(entry);
+        if (next == entries.end() || next->Key() != entry->Key())
+        {
+            *output++ = *entry;
+        }
+    }
+    entries.erase(output, entries.end());
+}
+
+void WriteTrafficFile(const std::string &filename, const std::vector<SegmentSpeedEntry> &entries)
+{
+    WriteEntries(filename, entries);
+}
+
+void WriteTrafficFile(const std::string &filename, const std::vector<TurnPenaltyEntry> &entries)
+{
+    WriteEntries(filename, entries);
+}
+}
+}
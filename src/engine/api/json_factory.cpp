@@ -268,7 +268,7 @@ util::json::Object makeWaypoint(const util::Coordinate location, std::string nam
     util::json::Object waypoint;
     waypoint.values["location"] = detail::coordinateToLonLat(location);
     waypoint.values["name"] = std::move(name);
-    waypoint.values["hint"] = hint.ToBase64();
+    waypoint.values["hint"] = hint.ToCompactBase64();
     return waypoint;
 }
 
@@ -9,7 +9,7 @@
 #include <algorithm>
 #include <cmath>
 #include <iterator>
-#include <stack>
+#include <limits>
 #include <utility>
 
 namespace osrm
@@ -31,59 +31,49 @@ std::uint64_t fastPerpendicularDistance(const util::FloatCoordinate &projected_s
     return squared_distance;
 }
 
-std::vector<util::Coordinate> douglasPeucker(std::vector<util::Coordinate>::const_iterator begin,
-                                             std::vector<util::Coordinate>::const_iterator end,
-                                             const unsigned zoom_level)
+void DouglasPeucker::Divide(const CoordinateIter begin,
+                            const CoordinateIter end,
+                            const std::uint64_t threshold)
 {
-    BOOST_ASSERT_MSG(zoom_level < detail::DOUGLAS_PEUCKER_THRESHOLDS_SIZE,
-                     "unsupported zoom level");
-
     const std::size_t size = std::distance(begin, end);
-    if (size < 2)
-    {
-        return {};
-    }
-
-    std::vector<util::FloatCoordinate> projected_coordinates(size);
+    projected_coordinates.resize(size);
     std::transform(begin, end, projected_coordinates.begin(), [](const util::Coordinate coord) {
         return util::web_mercator::fromWGS84(coord);
     });
 
-    std::vector<bool> is_necessary(size, false);
-    BOOST_ASSERT(is_necessary.size() >= 2);
-    is_necessary.front() = true;
-    is_necessary.back() = true;
-    using GeometryRange = std::pair<std::size_t, std::size_t>;
-
-    std::stack<GeometryRange> recursion_stack;
+    significance.assign(size, 0);
+    if (size < 2)
+    {
+        return;
+    }
+    significance.front() = std::numeric_limits<std::uint64_t>::max();
+    significance.back() = std::numeric_limits<std::uint64_t>::max();
 
-    recursion_stack.emplace(0UL, size - 1);
+    BOOST_ASSERT(ranges.empty());
+    ranges.push_back({0UL, size - 1, std::numeric_limits<std::uint64_t>::max()});
 
     // mark locations as 'necessary' by divide-and-conquer
-    while (!recursion_stack.empty())
+    while (!ranges.empty())
     {
-        // pop next element
-        const GeometryRange pair = recursion_stack.top();
-        recursion_stack.pop();
+        const Range range = ranges.back();
+        ranges.pop_back();
         // sanity checks
-        BOOST_ASSERT_MSG(is_necessary[pair.first], "left border must be necessary");
-        BOOST_ASSERT_MSG(is_necessary[pair.second], "right border must be necessary");
-        BOOST_ASSERT_MSG(pair.second < size, "right border outside of geometry");
-        BOOST_ASSERT_MSG(pair.first <= pair.second, "left border on the wrong side");
+        BOOST_ASSERT_MSG(significance[range.first] > threshold, "left border must be necessary");
+        BOOST_ASSERT_MSG(significance[range.last] > threshold, "right border must be necessary");
+        BOOST_ASSERT_MSG(range.last < size, "right border outside of geometry");
+        BOOST_ASSERT_MSG(range.first <= range.last, "left border on the wrong side");
 
         std::uint64_t max_distance = 0;
-        auto farthest_entry_index = pair.second;
+        auto farthest_entry_index = range.last;
 
         // sweep over range to find the maximum
-        for (auto idx = pair.first + 1; idx != pair.second; ++idx)
+        for (auto idx = range.first + 1; idx != range.last; ++idx)
         {
-            using namespace util::coordinate_calculation;
-            const auto distance = fastPerpendicularDistance(projected_coordinates[pair.first],
-                                                            projected_coordinates[pair.second],
+            const auto distance = fastPerpendicularDistance(projected_coordinates[range.first],
+                                                            projected_coordinates[range.last],
                                                             projected_coordinates[idx]);
             // found new feasible maximum?
-            if (distance > max_distance &&
-                distance > detail::DOUGLAS_PEUCKER_THRESHOLDS[zoom_level])
+            if (distance > max_distance && distance > threshold)
             {
                 farthest_entry_index = idx;
                 max_distance = distance;
@@ -91,32 +81,66 @@ std::vector<util::Coordinate> douglasPeucker(std::vector<util::Coordinate>::cons
         }
 
         // check if maximum violates a zoom level dependent threshold
-        if (max_distance > detail::DOUGLAS_PEUCKER_THRESHOLDS[zoom_level])
+        if (max_distance > threshold)
         {
-            //  mark idx as necessary
-            is_necessary[farthest_entry_index] = true;
-            if (pair.first < farthest_entry_index)
+            const auto split_significance = std::min(max_distance, range.max_significance);
+            significance[farthest_entry_index] = split_significance;
+            if (range.first < farthest_entry_index)
             {
-                recursion_stack.emplace(pair.first, farthest_entry_index);
+                ranges.push_back({range.first, farthest_entry_index, split_significance});
             }
-            if (farthest_entry_index < pair.second)
+            if (farthest_entry_index < range.last)
             {
-                recursion_stack.emplace(farthest_entry_index, pair.second);
+                ranges.push_back({farthest_entry_index, range.last, split_significance});
             }
         }
     }
+}
 
-    auto simplified_size = std::count(is_necessary.begin(), is_necessary.end(), true);
-    std::vector<util::Coordinate> simplified_geometry;
-    simplified_geometry.reserve(simplified_size);
-    for (auto idx : util::irange<std::size_t>(0UL, size))
+void DouglasPeucker::Simplify(const CoordinateIter begin,
+                              const CoordinateIter end,
+                              const unsigned zoom_level,
+                              std::vector<util::Coordinate> &output)
+{
+    BOOST_ASSERT_MSG(zoom_level < detail::DOUGLAS_PEUCKER_THRESHOLDS_SIZE,
+                     "unsupported zoom level");
+    Divide(begin, end, detail::DOUGLAS_PEUCKER_THRESHOLDS[zoom_level]);
+    Filter(begin, zoom_level, output);
+}
+
+void DouglasPeucker::ComputeSignificance(const CoordinateIter begin, const CoordinateIter end)
+{
+    // all thresholds are positive, dividing as long as anything is off the line covers them all
+    Divide(begin, end, 0);
+}
+
+void DouglasPeucker::Filter(const CoordinateIter begin,
+                            const unsigned zoom_level,
+                            std::vector<util::Coordinate> &output) const
+{
+    BOOST_ASSERT_MSG(zoom_level < detail::DOUGLAS_PEUCKER_THRESHOLDS_SIZE,
+                     "unsupported zoom level");
+    if (significance.size() < 2)
     {
-        if (is_necessary[idx])
+        return;
+    }
+
+    const auto threshold = detail::DOUGLAS_PEUCKER_THRESHOLDS[zoom_level];
+    for (auto idx : util::irange<std::size_t>(0UL, significance.size()))
+    {
+        if (significance[idx] > threshold)
         {
-            simplified_geometry.push_back(begin[idx]);
+            output.push_back(begin[idx]);
         }
     }
+}
 
+std::vector<util::Coordinate> douglasPeucker(std::vector<util::Coordinate>::const_iterator begin,
+                                             std::vector<util::Coordinate>::const_iterator end,
+                                             const unsigned zoom_level)
+{
+    std::vector<util::Coordinate> simplified_geometry;
+    DouglasPeucker().Simplify(begin, end, zoom_level, simplified_geometry);
     return simplified_geometry;
 }
 } // ns engine
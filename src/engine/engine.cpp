@@ -1,8 +1,18 @@
 #include "engine/engine.hpp"
 #include "engine/api/route_parameters.hpp"
+#include "engine/core_landmarks.hpp"
+#include "engine/dataset_generation.hpp"
 #include "engine/engine_config.hpp"
+#include "engine/phantom_node_cache.hpp"
+#include "engine/route_result_cache.hpp"
+#include "engine/query_deadline.hpp"
+#include "engine/search_engine_data.hpp"
+#include "engine/search_statistics.hpp"
 #include "engine/status.hpp"
+#include "engine/table_peers.hpp"
+#include "engine/unpacking_cache.hpp"
 
+#include "engine/plugins/isochrone.hpp"
 #include "engine/plugins/match.hpp"
 #include "engine/plugins/nearest.hpp"
 #include "engine/plugins/table.hpp"
@@ -15,16 +25,30 @@
 #include "engine/datafacade/shared_datafacade.hpp"
 
 #include "storage/shared_barriers.hpp"
+#include "util/integer_range.hpp"
+#include "util/json_renderer.hpp"
 #include "util/make_unique.hpp"
+#include "util/memory_usage.hpp"
 #include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
+#include "util/work_queue.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/interprocess/sync/named_condition.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
-#include <boost/thread/lock_types.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -36,85 +60,334 @@ struct Engine::EngineLock
 {
     // will only be initialized if shared memory is used
     storage::SharedBarriers barrier;
+    // serializes loading of new dataset generations within this process
+    std::mutex reload_mutex;
     // decrease number of concurrent queries
-    void DecreaseQueryCount();
+    void DecreaseQueryCount(const storage::SharedDataType data_region);
     // increase number of concurrent queries
-    void IncreaseQueryCount();
+    void IncreaseQueryCount(const storage::SharedDataType data_region);
+};
+
+struct Engine::QueryData
+{
+    QueryData(std::unique_ptr<datafacade::BaseDataFacade> facade_, const EngineConfig &config);
+
+    std::unique_ptr<datafacade::BaseDataFacade> facade;
+    // snapping results are only valid for this facade, dropped together with it
+    std::unique_ptr<PhantomNodeCache> phantom_node_cache;
+    // shortcut ids are only valid for this facade as well
+    std::unique_ptr<UnpackingCache> unpacking_cache;
+    // so are the segments that key the cached routes
+    std::unique_ptr<RouteResultCache> route_result_cache;
+    // and so are the distances in the core
+    std::unique_ptr<CoreLandmarks> core_landmarks;
+    // the peers have to serve the same dataset
+    std::unique_ptr<TablePeers> table_peers;
+
+    std::unique_ptr<plugins::ViaRoutePlugin> route_plugin;
+    std::unique_ptr<plugins::TablePlugin> table_plugin;
+    std::unique_ptr<plugins::NearestPlugin> nearest_plugin;
+    std::unique_ptr<plugins::TripPlugin> trip_plugin;
+    std::unique_ptr<plugins::MatchPlugin> match_plugin;
+    std::unique_ptr<plugins::IsochronePlugin> isochrone_plugin;
+    std::unique_ptr<plugins::TilePlugin> tile_plugin;
+
+    // only with shared memory, see AcquireGeneration
+    bool IsOutdated() const;
+    storage::SharedDataType GetDataRegion() const;
+};
+
+struct EngineSnapshot
+{
+    // with a lock the query data has to be counted as in use already, the snapshot releases it
+    EngineSnapshot(std::shared_ptr<Engine::QueryData> query_data_, Engine::EngineLock *lock_);
+    ~EngineSnapshot();
+
+    std::shared_ptr<Engine::QueryData> query_data;
+    // only with shared memory, the region counts as in use by one query as long as it is pinned
+    Engine::EngineLock *lock;
+    storage::SharedDataType data_region;
+};
+
+struct Engine::AsyncWorkers
+{
+    std::once_flag started;
+    std::unique_ptr<util::WorkQueue> queue;
 };
 
 // decrease number of concurrent queries
-void Engine::EngineLock::DecreaseQueryCount()
+void Engine::EngineLock::DecreaseQueryCount(const storage::SharedDataType data_region)
 {
-    // lock query
-    boost::interprocess::scoped_lock<boost::interprocess::named_mutex> query_lock(
-        barrier.query_mutex);
+    auto &counters = *barrier.counters;
 
-    // decrement query count
-    --(barrier.number_of_queries);
-    BOOST_ASSERT_MSG(0 <= barrier.number_of_queries, "invalid number of queries");
+    const auto running_queries = --counters.QueriesOn(data_region);
+    BOOST_ASSERT_MSG(0 <= running_queries, "invalid number of queries");
 
-    // notify all processes that were waiting for this condition
-    if (0 == barrier.number_of_queries)
+    // only the last query has to wake up an update waiting for all queries to finish,
+    // the query mutex makes sure the notification can not get lost
+    if (0 == running_queries && counters.update_pending)
     {
+        boost::interprocess::scoped_lock<storage::SharedBarriers::mutex_type> query_lock(
+            barrier.query_mutex);
         barrier.no_running_queries_condition.notify_all();
     }
 }
 
 // increase number of concurrent queries
-void Engine::EngineLock::IncreaseQueryCount()
+void Engine::EngineLock::IncreaseQueryCount(const storage::SharedDataType data_region)
 {
-    // lock update pending
-    boost::interprocess::scoped_lock<boost::interprocess::named_mutex> pending_lock(
-        barrier.pending_update_mutex);
-
-    // lock query
-    boost::interprocess::scoped_lock<boost::interprocess::named_mutex> query_lock(
-        barrier.query_mutex);
+    ++barrier.counters->QueriesOn(data_region);
+}
 
-    // unlock update pending
-    pending_lock.unlock();
+EngineSnapshot::EngineSnapshot(std::shared_ptr<Engine::QueryData> query_data_,
+                               Engine::EngineLock *lock_)
+    : query_data(std::move(query_data_)), lock(lock_), data_region(storage::DATA_NONE)
+{
+    if (lock)
+    {
+        data_region = query_data->GetDataRegion();
+    }
+}
 
-    // increment query count
-    ++(barrier.number_of_queries);
+EngineSnapshot::~EngineSnapshot()
+{
+    if (lock)
+    {
+        lock->DecreaseQueryCount(data_region);
+    }
 }
 } // ns engine
 } // ns osrm
 
 namespace
 {
-// Abstracted away the query locking into a template function
-// Works the same for every plugin.
+template <typename Plugin, typename Facade, typename... Args>
+std::unique_ptr<Plugin> create(Facade &facade, Args... args)
+{
+    return osrm::util::make_unique<Plugin>(facade, std::forward<Args>(args)...);
+}
+
+// Pages in a dataset before it answers queries, see EngineConfig::warm_up
+void WarmUp(const osrm::engine::datafacade::BaseDataFacade &facade)
+{
+    TIMER_START(warm_up);
+    facade.WarmUp();
+    TIMER_STOP(warm_up);
+    osrm::util::SimpleLogger().Write() << "warmed up dataset in " << TIMER_MSEC(warm_up) << "ms";
+}
+
+// Returns the query data of the newest dataset generation in shared memory counted as in use by
+// one more query, see AcquireGeneration
+std::shared_ptr<osrm::engine::Engine::QueryData>
+AcquireQueryData(osrm::engine::Engine::EngineLock &lock,
+                 std::shared_ptr<osrm::engine::Engine::QueryData> &query_data,
+                 const osrm::engine::EngineConfig &config)
+{
+    using namespace osrm::engine;
+
+    return AcquireGeneration(lock, query_data, [&config] {
+        // queries keep running on the previous generation until the new one is warmed up
+        auto facade = osrm::util::make_unique<datafacade::SharedDataFacade>(config.numa_node);
+        if (config.warm_up)
+        {
+            WarmUp(*facade);
+        }
+        return std::make_shared<Engine::QueryData>(std::move(facade), config);
+    });
+}
+
+// Adds the search statistics of a debug query to its response, only JSON responses have them
+void AddSearchStatistics(const osrm::engine::SearchStatistics &statistics,
+                         osrm::util::json::Object &result)
+{
+    osrm::util::json::Object debug;
+    debug.values["settled_nodes"] = static_cast<double>(statistics.settled_nodes);
+    debug.values["relaxed_edges"] = static_cast<double>(statistics.relaxed_edges);
+    debug.values["stalled_nodes"] = static_cast<double>(statistics.stalled_nodes);
+    debug.values["core_settled_nodes"] = static_cast<double>(statistics.core_settled_nodes);
+    result.values["debug"] = std::move(debug);
+}
+
+template <typename ResultT>
+void AddSearchStatistics(const osrm::engine::SearchStatistics &, ResultT &)
+{
+}
+
+// Response of an asynchronous query that threw, only JSON responses can tell why
+void SetInternalError(const std::exception &error, osrm::util::json::Object &result)
+{
+    result = osrm::util::json::Object();
+    result.values["code"] = "InternalError";
+    result.values["message"] = error.what();
+}
+
+template <typename ResultT> void SetInternalError(const std::exception &, ResultT &result)
+{
+    result = ResultT();
+}
+
+// Response of a query that ran past its deadline
+void SetTimeout(osrm::util::json::Object &result)
+{
+    result = osrm::util::json::Object();
+    result.values["code"] = "Timeout";
+    result.values["message"] = "Query took too long";
+}
+
+void SetTimeout(std::vector<char> &result)
+{
+    osrm::util::json::Object error;
+    SetTimeout(error);
+    result.clear();
+    osrm::util::json::render(result, error);
+}
+
+void SetTimeout(std::string &result) { result.clear(); }
+
+// Response of a query a dataset of osrm-datastore --weights-only can not answer
+void SetNotImplemented(osrm::util::json::Object &result)
+{
+    result = osrm::util::json::Object();
+    result.values["code"] = "NotImplemented";
+    result.values["message"] = "The dataset was loaded for distance tables only";
+}
+
+void SetNotImplemented(std::vector<char> &result)
+{
+    osrm::util::json::Object error;
+    SetNotImplemented(error);
+    result.clear();
+    osrm::util::json::render(result, error);
+}
+
+void SetNotImplemented(std::string &result) { result.clear(); }
+
+// Only distance tables work without the names and guidance data of a dataset
+template <typename PluginT> bool NeedsGuidanceData(const PluginT &) { return true; }
+
+bool NeedsGuidanceData(const osrm::engine::plugins::TablePlugin &) { return false; }
+
+bool IsDebugQuery(const osrm::engine::api::BaseParameters &parameters)
+{
+    return parameters.debug;
+}
+
+bool IsDebugQuery(const osrm::engine::api::TileParameters &) { return false; }
+
 template <typename ParameterT, typename PluginT, typename ResultT>
-osrm::engine::Status RunQuery(const std::unique_ptr<osrm::engine::Engine::EngineLock> &lock,
-                              osrm::engine::datafacade::BaseDataFacade &facade,
-                              const ParameterT &parameters,
-                              PluginT &plugin,
-                              ResultT &result)
+osrm::engine::Status
+HandleRequest(PluginT &plugin, const ParameterT &parameters, ResultT &result)
 {
-    if (!lock)
+    if (!IsDebugQuery(parameters))
     {
         return plugin.HandleRequest(parameters, result);
     }
 
-    BOOST_ASSERT(lock);
-    lock->IncreaseQueryCount();
+    osrm::engine::SearchStatistics statistics;
+    const osrm::engine::SearchStatisticsScope statistics_scope(&statistics);
+    const auto status = plugin.HandleRequest(parameters, result);
+    AddSearchStatistics(statistics, result);
+    return status;
+}
 
-    auto &shared_facade = static_cast<osrm::engine::datafacade::SharedDataFacade &>(facade);
-    shared_facade.CheckAndReloadFacade();
-    // Get a shared data lock so that other threads won't update
-    // things while the query is running
-    boost::shared_lock<boost::shared_mutex> data_lock{shared_facade.data_mutex};
+// The deadline of the searches starts here, a query that runs past it fails with the code Timeout
+template <typename QueryT, typename ResultT>
+osrm::engine::Status
+WithDeadline(const osrm::engine::EngineConfig &config, ResultT &result, QueryT &&query)
+{
+    using namespace osrm::engine;
 
-    osrm::engine::Status status = plugin.HandleRequest(parameters, result);
+    const QueryDeadline deadline{QueryDeadline::Clock::now() +
+                                 std::chrono::milliseconds(config.max_query_time)};
+    const QueryDeadlineScope deadline_scope(config.max_query_time > 0 ? &deadline : nullptr);
+    try
+    {
+        return query();
+    }
+    catch (const QueryTimeout &)
+    {
+        SetTimeout(result);
+        return Status::Error;
+    }
+}
 
-    lock->DecreaseQueryCount();
-    return status;
+// Abstracted away the query locking into a template function
+// Works the same for every plugin, a batch of queries is locked only once.
+template <typename QueryT, typename ResultT>
+osrm::engine::Status WithQueryData(const std::unique_ptr<osrm::engine::Engine::EngineLock> &lock,
+                                   std::shared_ptr<osrm::engine::Engine::QueryData> &query_data,
+                                   const osrm::engine::EngineConfig &config,
+                                   ResultT &result,
+                                   QueryT &&query)
+{
+    using namespace osrm::engine;
+
+    return WithDeadline(config, result, [&] {
+        if (!lock)
+        {
+            return query(*query_data);
+        }
+
+        BOOST_ASSERT(lock);
+        // keeps the facade and plugins alive until the query is done, even if a newer
+        // dataset generation gets published in the meantime
+        const auto current = AcquireQueryData(*lock, query_data, config);
+        const auto data_region = current->GetDataRegion();
+
+        // the query is no longer counted once it is done, also if it threw
+        struct QueryCount
+        {
+            Engine::EngineLock &lock;
+            const osrm::storage::SharedDataType data_region;
+            ~QueryCount() { lock.DecreaseQueryCount(data_region); }
+        };
+        const QueryCount query_count{*lock, data_region};
+
+        return query(*current);
+    });
 }
 
-template <typename Plugin, typename Facade, typename... Args>
-std::unique_ptr<Plugin> create(Facade &facade, Args... args)
+template <typename ParameterT, typename PluginT, typename ResultT>
+osrm::engine::Status RunPlugin(osrm::engine::Engine::QueryData &current,
+                               std::unique_ptr<PluginT> osrm::engine::Engine::QueryData::*plugin,
+                               const ParameterT &parameters,
+                               ResultT &result)
 {
-    return osrm::util::make_unique<Plugin>(facade, std::forward<Args>(args)...);
+    if (NeedsGuidanceData(*(current.*plugin)) && !current.facade->HasGuidanceData())
+    {
+        SetNotImplemented(result);
+        return osrm::engine::Status::Error;
+    }
+    return HandleRequest(*(current.*plugin), parameters, result);
+}
+
+template <typename ParameterT, typename PluginT, typename ResultT>
+osrm::engine::Status
+RunQuery(const std::unique_ptr<osrm::engine::Engine::EngineLock> &lock,
+         std::shared_ptr<osrm::engine::Engine::QueryData> &query_data,
+         const osrm::engine::EngineConfig &config,
+         std::unique_ptr<PluginT> osrm::engine::Engine::QueryData::*plugin,
+         const ParameterT &parameters,
+         ResultT &result)
+{
+    return WithQueryData(
+        lock, query_data, config, result, [&](osrm::engine::Engine::QueryData &current) {
+            return RunPlugin(current, plugin, parameters, result);
+        });
+}
+
+// The snapshot already pins its generation and counts as a running query
+template <typename ParameterT, typename PluginT, typename ResultT>
+osrm::engine::Status
+RunSnapshotQuery(const osrm::engine::EngineSnapshot &snapshot,
+                 const osrm::engine::EngineConfig &config,
+                 std::unique_ptr<PluginT> osrm::engine::Engine::QueryData::*plugin,
+                 const ParameterT &parameters,
+                 ResultT &result)
+{
+    return WithDeadline(config, result, [&] {
+        return RunPlugin(*snapshot.query_data, plugin, parameters, result);
+    });
 }
 
 } // anon. ns
@@ -124,12 +397,130 @@ namespace osrm
 namespace engine
 {
 
+Engine::QueryData::QueryData(std::unique_ptr<datafacade::BaseDataFacade> facade_,
+                             const EngineConfig &config)
+    : facade(std::move(facade_))
+{
+    // Register plugins
+    using namespace plugins;
+
+    route_plugin = create<ViaRoutePlugin>(
+        *facade,
+        config.max_locations_viaroute,
+        config.algorithm == EngineConfig::Algorithm::MLD,
+        static_cast<std::size_t>(std::max(0, config.max_alternative_candidates)),
+        config.use_parallel_route);
+    table_plugin =
+        create<TablePlugin>(*facade, config.max_locations_distance_table, config.use_parallel_table);
+    nearest_plugin = create<NearestPlugin>(*facade, config.max_locations_nearest);
+    trip_plugin = create<TripPlugin>(*facade,
+                                     config.max_locations_trip,
+                                     std::chrono::milliseconds(
+                                         std::max(0, config.max_trip_optimization_time)));
+    match_plugin = create<MatchPlugin>(*facade,
+                                       config.max_locations_map_matching,
+                                       static_cast<std::size_t>(config.matching_beam_width),
+                                       config.matching_beam_range);
+    isochrone_plugin = create<IsochronePlugin>(*facade, config.max_duration_isochrone);
+    tile_plugin = create<TilePlugin>(*facade,
+                                     static_cast<std::size_t>(std::max(0, config.tile_cache_size)),
+                                     static_cast<unsigned>(config.tile_metatile_size));
+
+    // only the plugins snapping single phantom node pairs benefit from the cache
+    if (config.phantom_node_cache_size > 0)
+    {
+        phantom_node_cache = util::make_unique<PhantomNodeCache>(
+            static_cast<std::size_t>(config.phantom_node_cache_size));
+        route_plugin->UsePhantomNodeCache(phantom_node_cache.get());
+        table_plugin->UsePhantomNodeCache(phantom_node_cache.get());
+        trip_plugin->UsePhantomNodeCache(phantom_node_cache.get());
+    }
+
+    if (!config.table_peers.empty())
+    {
+        table_peers =
+            util::make_unique<TablePeers>(config.table_peers,
+                                          config.table_peer_profile,
+                                          std::chrono::milliseconds(
+                                              config.max_query_time > 0
+                                                  ? config.max_query_time
+                                                  : TablePeers::DEFAULT_TIMEOUT));
+        table_plugin->UseTablePeers(table_peers.get());
+    }
+
+    if (config.unpacking_cache_size > 0)
+    {
+        unpacking_cache = util::make_unique<UnpackingCache>(
+            static_cast<std::size_t>(config.unpacking_cache_size));
+        route_plugin->UseUnpackingCache(unpacking_cache.get());
+        trip_plugin->UseUnpackingCache(unpacking_cache.get());
+        match_plugin->UseUnpackingCache(unpacking_cache.get());
+    }
+
+    if (config.route_result_cache_size > 0)
+    {
+        route_result_cache = util::make_unique<RouteResultCache>(
+            static_cast<std::size_t>(config.route_result_cache_size));
+        route_plugin->UseRouteResultCache(route_result_cache.get());
+    }
+
+    if (facade->GetNumberOfCoreLandmarkDistances() > 0)
+    {
+        core_landmarks =
+            util::make_unique<CoreLandmarks>(*facade,
+                                             facade->GetCoreLandmarkDistances(),
+                                             facade->GetNumberOfCoreLandmarkDistances());
+        util::SimpleLogger().Write() << "Using " << core_landmarks->GetNumberOfLandmarks()
+                                     << " core landmarks of the dataset";
+    }
+    else if (config.core_landmarks > 0 && facade->GetCoreSize() > 0)
+    {
+        TIMER_START(landmarks);
+        core_landmarks = util::make_unique<CoreLandmarks>(
+            *facade, static_cast<std::size_t>(config.core_landmarks));
+        TIMER_STOP(landmarks);
+        util::SimpleLogger().Write() << "Computed " << core_landmarks->GetNumberOfLandmarks()
+                                     << " core landmarks in " << TIMER_SEC(landmarks) << "s";
+    }
+    if (core_landmarks)
+    {
+        route_plugin->UseCoreLandmarks(core_landmarks.get());
+        trip_plugin->UseCoreLandmarks(core_landmarks.get());
+        match_plugin->UseCoreLandmarks(core_landmarks.get());
+    }
+}
+
+bool Engine::QueryData::IsOutdated() const
+{
+    return static_cast<const datafacade::SharedDataFacade &>(*facade).IsOutdated();
+}
+
+storage::SharedDataType Engine::QueryData::GetDataRegion() const
+{
+    return static_cast<const datafacade::SharedDataFacade &>(*facade).GetDataRegion();
+}
+
 Engine::Engine(EngineConfig &config)
+    : config(config), async_workers(util::make_unique<AsyncWorkers>())
 {
+    std::unique_ptr<datafacade::BaseDataFacade> query_data_facade;
     if (config.use_shared_memory)
     {
+        if (config.algorithm == EngineConfig::Algorithm::MLD)
+        {
+            throw util::exception("Multi-level Dijkstra is not supported with shared memory");
+        }
         lock = util::make_unique<EngineLock>();
-        query_data_facade = util::make_unique<datafacade::SharedDataFacade>();
+        query_data_facade = util::make_unique<datafacade::SharedDataFacade>(config.numa_node);
+    }
+    else if (config.use_dataset)
+    {
+        if (config.algorithm == EngineConfig::Algorithm::MLD)
+        {
+            throw util::exception("Multi-level Dijkstra is not supported with a dataset file");
+        }
+        query_data_facade =
+            util::make_unique<datafacade::SharedDataFacade>(config.storage_config.dataset_path);
     }
     else
     {
@@ -137,19 +528,15 @@ Engine::Engine(EngineConfig &config)
         {
             throw util::exception("Invalid file paths given!");
         }
-        query_data_facade =
-            util::make_unique<datafacade::InternalDataFacade>(config.storage_config);
+        query_data_facade = util::make_unique<datafacade::InternalDataFacade>(
+            config.storage_config, config.algorithm == EngineConfig::Algorithm::MLD);
     }
 
-    // Register plugins
-    using namespace plugins;
-
-    route_plugin = create<ViaRoutePlugin>(*query_data_facade, config.max_locations_viaroute);
-    table_plugin = create<TablePlugin>(*query_data_facade, config.max_locations_distance_table);
-    nearest_plugin = create<NearestPlugin>(*query_data_facade);
-    trip_plugin = create<TripPlugin>(*query_data_facade, config.max_locations_trip);
-    match_plugin = create<MatchPlugin>(*query_data_facade, config.max_locations_map_matching);
-    tile_plugin = create<TilePlugin>(*query_data_facade);
+    if (config.warm_up)
+    {
+        WarmUp(*query_data_facade);
+    }
+    query_data = std::make_shared<QueryData>(std::move(query_data_facade), config);
 }
 
 // make sure we deallocate the unique ptr at a position where we know the size of the plugins
@@ -159,32 +546,357 @@ Engine &Engine::operator=(Engine &&) noexcept = default;
 
 Status Engine::Route(const api::RouteParameters &params, util::json::Object &result)
 {
-    return RunQuery(lock, *query_data_facade, params, *route_plugin, result);
+    return RunQuery(lock, query_data, config, &QueryData::route_plugin, params, result);
+}
+
+Status Engine::Route(const std::vector<api::RouteParameters> &params, util::json::Object &result)
+{
+    if (params.empty())
+    {
+        result.values["code"] = "InvalidOptions";
+        result.values["message"] = "At least one route query is required.";
+        return Status::Error;
+    }
+
+    std::vector<util::json::Object> route_results;
+    std::vector<Status> statuses;
+    const auto status = WithQueryData(lock, query_data, config, result, [&](QueryData &current) {
+        if (!current.facade->HasGuidanceData())
+        {
+            SetNotImplemented(result);
+            return Status::Error;
+        }
+        current.route_plugin->HandleBatch(params, route_results, statuses);
+        return Status::Ok;
+    });
+    if (status != Status::Ok)
+    {
+        return status;
+    }
+
+    util::json::Array results;
+    results.values.reserve(route_results.size());
+    for (auto &route_result : route_results)
+    {
+        results.values.push_back(std::move(route_result));
+    }
+
+    result.values["code"] = "Ok";
+    result.values["results"] = std::move(results);
+    return Status::Ok;
 }
 
 Status Engine::Table(const api::TableParameters &params, util::json::Object &result)
 {
-    return RunQuery(lock, *query_data_facade, params, *table_plugin, result);
+    return RunQuery(lock, query_data, config, &QueryData::table_plugin, params, result);
+}
+
+Status Engine::Table(const api::TableParameters &params, std::vector<char> &result)
+{
+    return RunQuery(lock, query_data, config, &QueryData::table_plugin, params, result);
+}
+
+Status Engine::Table(const api::TableParameters &params,
+                     std::vector<char> &result,
+                     const ChunkHandler &handle_chunk)
+{
+    // rendered responses carry no search statistics, so debug queries need no special case
+    return WithQueryData(lock, query_data, config, result, [&](QueryData &current) {
+        return current.table_plugin->HandleRequest(params, result, handle_chunk);
+    });
 }
 
 Status Engine::Nearest(const api::NearestParameters &params, util::json::Object &result)
 {
-    return RunQuery(lock, *query_data_facade, params, *nearest_plugin, result);
+    return RunQuery(lock, query_data, config, &QueryData::nearest_plugin, params, result);
+}
+
+Status Engine::Nearest(const api::NearestParameters &params, std::vector<char> &result)
+{
+    return RunQuery(lock, query_data, config, &QueryData::nearest_plugin, params, result);
 }
 
 Status Engine::Trip(const api::TripParameters &params, util::json::Object &result)
 {
-    return RunQuery(lock, *query_data_facade, params, *trip_plugin, result);
+    return RunQuery(lock, query_data, config, &QueryData::trip_plugin, params, result);
 }
 
 Status Engine::Match(const api::MatchParameters &params, util::json::Object &result)
 {
-    return RunQuery(lock, *query_data_facade, params, *match_plugin, result);
+    return RunQuery(lock, query_data, config, &QueryData::match_plugin, params, result);
+}
+
+Status Engine::Match(const std::vector<api::MatchParameters> &params, util::json::Object &result)
+{
+    if (params.empty())
+    {
+        result.values["code"] = "InvalidOptions";
+        result.values["message"] = "At least one trace is required.";
+        return Status::Error;
+    }
+
+    // every trace is a query of its own, the heaps of the plugin are thread local
+    util::json::Array results;
+    results.values.resize(params.size());
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, params.size()),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          for (auto index = range.begin(); index != range.end(); ++index)
+                          {
+                              util::json::Object trace_result;
+                              Match(params[index], trace_result);
+                              results.values[index] = std::move(trace_result);
+                          }
+                      });
+
+    result.values["code"] = "Ok";
+    result.values["results"] = std::move(results);
+    return Status::Ok;
+}
+
+Status Engine::Isochrone(const api::IsochroneParameters &params, util::json::Object &result)
+{
+    return RunQuery(lock, query_data, config, &QueryData::isochrone_plugin, params, result);
 }
 
 Status Engine::Tile(const api::TileParameters &params, std::string &result)
 {
-    return RunQuery(lock, *query_data_facade, params, *tile_plugin, result);
+    return RunQuery(lock, query_data, config, &QueryData::tile_plugin, params, result);
+}
+
+template <typename ParameterT, typename ResultT>
+bool Engine::RunAsync(Status (Engine::*query)(const ParameterT &, ResultT &),
+                      ParameterT parameters,
+                      Callback<ResultT> callback)
+{
+    std::call_once(async_workers->started, [this] {
+        const auto number_of_workers =
+            config.async_workers > 0 ? static_cast<unsigned>(config.async_workers)
+                                     : std::max(1u, std::thread::hardware_concurrency());
+        async_workers->queue = util::make_unique<util::WorkQueue>(
+            number_of_workers,
+            static_cast<std::size_t>(std::max(0, config.max_queued_async_queries)),
+            std::vector<util::WorkQueue::Lane>{{0, std::numeric_limits<std::size_t>::max()}});
+    });
+
+    // the task only holds on to what it needs, parameters can be large for table and match
+    auto shared_parameters = std::make_shared<const ParameterT>(std::move(parameters));
+    auto shared_callback = std::make_shared<Callback<ResultT>>(std::move(callback));
+    return async_workers->queue->TryPush(0, [this, query, shared_parameters, shared_callback] {
+        ResultT result;
+        Status status;
+        try
+        {
+            status = (this->*query)(*shared_parameters, result);
+        }
+        catch (const std::exception &error)
+        {
+            SetInternalError(error, result);
+            status = Status::Error;
+        }
+        (*shared_callback)(status, result);
+    });
+}
+
+bool Engine::RouteAsync(api::RouteParameters params, Callback<util::json::Object> callback)
+{
+    return RunAsync<api::RouteParameters, util::json::Object>(
+        &Engine::Route, std::move(params), std::move(callback));
+}
+
+bool Engine::TableAsync(api::TableParameters params, Callback<util::json::Object> callback)
+{
+    return RunAsync<api::TableParameters, util::json::Object>(
+        &Engine::Table, std::move(params), std::move(callback));
+}
+
+bool Engine::NearestAsync(api::NearestParameters params, Callback<util::json::Object> callback)
+{
+    return RunAsync<api::NearestParameters, util::json::Object>(
+        &Engine::Nearest, std::move(params), std::move(callback));
+}
+
+bool Engine::TripAsync(api::TripParameters params, Callback<util::json::Object> callback)
+{
+    return RunAsync<api::TripParameters, util::json::Object>(
+        &Engine::Trip, std::move(params), std::move(callback));
+}
+
+bool Engine::MatchAsync(api::MatchParameters params, Callback<util::json::Object> callback)
+{
+    return RunAsync<api::MatchParameters, util::json::Object>(
+        &Engine::Match, std::move(params), std::move(callback));
+}
+
+bool Engine::IsochroneAsync(api::IsochroneParameters params,
+                            Callback<util::json::Object> callback)
+{
+    return RunAsync<api::IsochroneParameters, util::json::Object>(
+        &Engine::Isochrone, std::move(params), std::move(callback));
+}
+
+bool Engine::TileAsync(api::TileParameters params, Callback<std::string> callback)
+{
+    return RunAsync<api::TileParameters, std::string>(
+        &Engine::Tile, std::move(params), std::move(callback));
+}
+
+std::string Engine::GetTimestamp() const
+{
+    return std::atomic_load(&query_data)->facade->GetTimestamp();
+}
+
+void Engine::GetMemoryUsage(util::json::Object &result) const
+{
+    // the files of an internal facade are read into many buffers of their own
+    if (!lock && !config.use_dataset)
+    {
+        return;
+    }
+
+    const auto current = std::atomic_load(&query_data);
+    const auto &facade = static_cast<const datafacade::SharedDataFacade &>(*current->facade);
+    const auto &layout = facade.GetDataLayout();
+
+    util::json::Array blocks;
+    std::uint64_t size = 0;
+    std::uint64_t resident_size = 0;
+    for (const auto index : util::irange<int>(0, storage::SharedDataLayout::NUM_BLOCKS))
+    {
+        const auto block = static_cast<storage::SharedDataLayout::BlockID>(index);
+        const auto block_size = layout.GetBlockSize(block);
+        if (block_size == 0)
+        {
+            continue;
+        }
+        const auto block_resident_size =
+            util::ResidentSize(facade.GetData() + layout.GetBlockOffset(block), block_size);
+        size += block_size;
+        resident_size += block_resident_size;
+
+        util::json::Object entry;
+        entry.values["name"] = storage::block_id_to_name[index];
+        entry.values["size"] = static_cast<double>(block_size);
+        entry.values["resident_size"] = static_cast<double>(block_resident_size);
+        blocks.values.push_back(std::move(entry));
+    }
+    result.values["size"] = static_cast<double>(size);
+    result.values["resident_size"] = static_cast<double>(resident_size);
+    result.values["blocks"] = std::move(blocks);
+}
+
+void Engine::PrepareThread()
+{
+    if (!config.warm_up)
+    {
+        return;
+    }
+
+    // the heaps a route query holds at once, see the routing algorithms
+    const auto current = std::atomic_load(&query_data);
+    const auto number_of_nodes = current->facade->GetNumberOfNodes();
+    if (config.algorithm == EngineConfig::Algorithm::MLD)
+    {
+        SearchEngineData::ReserveHeaps<SearchEngineData::MultiLevelQueryHeap>(number_of_nodes, 2);
+        return;
+    }
+    SearchEngineData::ReserveHeaps<SearchEngineData::QueryHeap>(number_of_nodes, 4);
+    if (current->facade->GetCoreSize() == 0)
+    {
+        SearchEngineData::ReserveHeaps<SearchEngineData::DenseQueryHeap>(number_of_nodes, 2);
+    }
+}
+
+unsigned Engine::GetDatasetGeneration() const
+{
+    if (!lock)
+    {
+        return 0;
+    }
+
+    const auto current = std::atomic_load(&query_data);
+    return static_cast<const datafacade::SharedDataFacade &>(*current->facade)
+        .GetPublishedTimestamp();
+}
+
+std::shared_ptr<const EngineSnapshot> Engine::TakeSnapshot()
+{
+    if (!lock)
+    {
+        return std::make_shared<const EngineSnapshot>(std::atomic_load(&query_data), nullptr);
+    }
+    return std::make_shared<const EngineSnapshot>(
+        AcquireQueryData(*lock, query_data, config), lock.get());
+}
+
+Status Engine::Route(const EngineSnapshot &snapshot,
+                     const api::RouteParameters &params,
+                     util::json::Object &result) const
+{
+    return RunSnapshotQuery(snapshot, config, &QueryData::route_plugin, params, result);
+}
+
+Status Engine::Table(const EngineSnapshot &snapshot,
+                     const api::TableParameters &params,
+                     util::json::Object &result) const
+{
+    return RunSnapshotQuery(snapshot, config, &QueryData::table_plugin, params, result);
+}
+
+Status Engine::Table(const EngineSnapshot &snapshot,
+                     const api::TableParameters &params,
+                     std::vector<char> &result) const
+{
+    return RunSnapshotQuery(snapshot, config, &QueryData::table_plugin, params, result);
+}
+
+Status Engine::Nearest(const EngineSnapshot &snapshot,
+                       const api::NearestParameters &params,
+                       util::json::Object &result) const
+{
+    return RunSnapshotQuery(snapshot, config, &QueryData::nearest_plugin, params, result);
+}
+
+Status Engine::Trip(const EngineSnapshot &snapshot,
+                    const api::TripParameters &params,
+                    util::json::Object &result) const
+{
+    return RunSnapshotQuery(snapshot, config, &QueryData::trip_plugin, params, result);
+}
+
+Status Engine::Match(const EngineSnapshot &snapshot,
+                     const api::MatchParameters &params,
+                     util::json::Object &result) const
+{
+    return RunSnapshotQuery(snapshot, config, &QueryData::match_plugin, params, result);
+}
+
+Status Engine::Isochrone(const EngineSnapshot &snapshot,
+                         const api::IsochroneParameters &params,
+                         util::json::Object &result) const
+{
+    return RunSnapshotQuery(snapshot, config, &QueryData::isochrone_plugin, params, result);
+}
+
+Status Engine::Tile(const EngineSnapshot &snapshot,
+                    const api::TileParameters &params,
+                    std::string &result) const
+{
+    return RunSnapshotQuery(snapshot, config, &QueryData::tile_plugin, params, result);
+}
+
+unsigned Engine::GetDatasetGeneration(const EngineSnapshot &snapshot) const
+{
+    if (!snapshot.lock)
+    {
+        return 0;
+    }
+    return static_cast<const datafacade::SharedDataFacade &>(*snapshot.query_data->facade)
+        .GetPublishedTimestamp();
+}
+
+std::string Engine::GetTimestamp(const EngineSnapshot &snapshot) const
+{
+    return snapshot.query_data->facade->GetTimestamp();
 }
 
 } // engine ns
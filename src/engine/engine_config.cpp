@@ -1,5 +1,7 @@
 #include "engine/engine_config.hpp"
 
+#include <boost/filesystem/operations.hpp>
+
 namespace osrm
 {
 namespace engine
@@ -18,10 +20,28 @@ bool EngineConfig::IsValid() const
     const bool limits_valid =
         (max_locations_distance_table == -1 || max_locations_distance_table > 2) &&
         (max_locations_map_matching == -1 || max_locations_map_matching > 2) &&
+        (max_locations_nearest == -1 || max_locations_nearest > 0) &&
         (max_locations_trip == -1 || max_locations_trip > 2) &&
-        (max_locations_viaroute == -1 || max_locations_viaroute > 2);
+        (max_locations_viaroute == -1 || max_locations_viaroute > 2) &&
+        (max_duration_isochrone == -1 || max_duration_isochrone > 0) &&
+        max_alternative_candidates >= 0 && max_trip_optimization_time >= 0 &&
+        matching_beam_width >= 0 && matching_beam_range >= 0 && max_query_time >= 0 &&
+        core_landmarks >= 0 && tile_metatile_size >= 1 && tile_metatile_size <= 16;
+
+    const bool algorithm_valid =
+        algorithm == Algorithm::CH ||
+        (!use_shared_memory && !use_dataset &&
+         boost::filesystem::is_regular_file(storage_config.partition_path) &&
+         boost::filesystem::is_regular_file(storage_config.cells_path) &&
+         boost::filesystem::is_regular_file(storage_config.mld_graph_path));
+
+    const bool dataset_valid =
+        !use_shared_memory && use_dataset &&
+        boost::filesystem::is_regular_file(storage_config.dataset_path);
 
-    return ((use_shared_memory && all_path_are_empty) || storage_config.IsValid()) && limits_valid;
+    return ((use_shared_memory && all_path_are_empty) ||
+            (use_dataset ? dataset_valid : storage_config.IsValid())) &&
+           limits_valid && algorithm_valid;
 }
 }
 }
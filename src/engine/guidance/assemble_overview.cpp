@@ -46,19 +46,21 @@ unsigned calculateOverviewZoomLevel(const std::vector<LegGeometry> &leg_geometri
 std::vector<util::Coordinate> simplifyGeometry(const std::vector<LegGeometry> &leg_geometries,
                                                const unsigned zoom_level)
 {
+    // keeps its buffers for the next overview on this thread
+    static thread_local DouglasPeucker simplifier;
+
     std::vector<util::Coordinate> overview_geometry;
     auto leg_index = 0UL;
     for (const auto &geometry : leg_geometries)
     {
-        auto simplified_geometry =
-            douglasPeucker(geometry.locations.begin(), geometry.locations.end(), zoom_level);
+        const auto previous_size = overview_geometry.size();
+        simplifier.Simplify(
+            geometry.locations.begin(), geometry.locations.end(), zoom_level, overview_geometry);
         // not the last leg
-        if (leg_index < leg_geometries.size() - 1)
+        if (leg_index < leg_geometries.size() - 1 && overview_geometry.size() > previous_size)
         {
-            simplified_geometry.pop_back();
+            overview_geometry.pop_back();
         }
-        overview_geometry.insert(
-            overview_geometry.end(), simplified_geometry.begin(), simplified_geometry.end());
     }
     return overview_geometry;
 }
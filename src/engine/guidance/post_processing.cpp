@@ -2,6 +2,7 @@
 #include "engine/guidance/post_processing.hpp"
 
 #include "engine/guidance/assemble_steps.hpp"
+#include "engine/guidance/lane_processing.hpp"
 #include "engine/guidance/toolkit.hpp"
 
 #include "util/guidance/toolkit.hpp"
@@ -14,6 +15,7 @@
 #include <cmath>
 #include <cstddef>
 #include <iostream>
+#include <iterator>
 #include <limits>
 #include <utility>
 
@@ -84,8 +86,42 @@ double nameSegmentLength(std::size_t at, const std::vector<RouteStep> &steps)
     return result;
 }
 
-// invalidate a step and set its content to nothing
-void invalidateStep(RouteStep &step) { step = getInvalidRouteStep(); }
+// invalidate a step and set its content to nothing, the same as getInvalidRouteStep but reusing
+// the memory the step already holds
+void invalidateStep(RouteStep &step)
+{
+    step.name_id = 0;
+    step.name.clear();
+    step.pronunciation.clear();
+    step.destinations.clear();
+    step.rotary_name.clear();
+    step.duration = 0;
+    step.distance = 0;
+    step.mode = TRAVEL_MODE_INACCESSIBLE;
+    step.maneuver = getInvalidStepManeuver();
+    step.geometry_begin = 0;
+    step.geometry_end = 0;
+    step.intersections.resize(1);
+    step.intersections.front() = getInvalidIntersection();
+}
+
+// Adds the intersections of a step that is still used afterwards
+void insertIntersections(std::vector<Intersection> &intersections,
+                         const std::vector<Intersection>::iterator position,
+                         const std::vector<Intersection> &source)
+{
+    intersections.insert(position, source.begin(), source.end());
+}
+
+// Moves the intersections out of a step that is invalidated right afterwards
+void insertIntersections(std::vector<Intersection> &intersections,
+                         const std::vector<Intersection>::iterator position,
+                         std::vector<Intersection> &&source)
+{
+    intersections.insert(
+        position, std::make_move_iterator(source.begin()), std::make_move_iterator(source.end()));
+    source.clear();
+}
 
 // Compute the angle between two bearings on a normal turn circle
 //
@@ -118,29 +154,21 @@ double turn_angle(const double entry_bearing, const double exit_bearing)
     return angle > 360 ? angle - 360 : angle;
 }
 
-RouteStep forwardInto(RouteStep destination, const RouteStep &source)
+// Pass the source as rvalue if it is invalidated afterwards, its intersections are moved then
+template <typename StepT> void forwardInto(RouteStep &destination, StepT &&source)
 {
     // Merge a turn into a silent turn
     // Overwrites turn instruction and increases exit NR
     destination.duration += source.duration;
     destination.distance += source.distance;
     destination.maneuver.exit = source.maneuver.exit;
-    if (destination.geometry_begin < source.geometry_begin)
-    {
-        destination.intersections.insert(destination.intersections.end(),
-                                         source.intersections.begin(),
-                                         source.intersections.end());
-    }
-    else
-    {
-        destination.intersections.insert(destination.intersections.begin(),
-                                         source.intersections.begin(),
-                                         source.intersections.end());
-    }
-
+    const auto position = destination.geometry_begin < source.geometry_begin
+                              ? destination.intersections.end()
+                              : destination.intersections.begin();
     destination.geometry_begin = std::min(destination.geometry_begin, source.geometry_begin);
     destination.geometry_end = std::max(destination.geometry_end, source.geometry_end);
-    return destination;
+    insertIntersections(
+        destination.intersections, position, std::forward<StepT>(source).intersections);
 }
 
 void fixFinalRoundabout(std::vector<RouteStep> &steps)
@@ -172,8 +200,7 @@ void fixFinalRoundabout(std::vector<RouteStep> &steps)
             // TODO this operates on the data that is in the instructions.
             // We are missing out on the final segment after the last stay-on-roundabout
             // instruction though. it is not contained somewhere until now
-            steps[propagation_index - 1] =
-                forwardInto(std::move(steps[propagation_index - 1]), propagation_step);
+            forwardInto(steps[propagation_index - 1], std::move(propagation_step));
             invalidateStep(propagation_step);
         }
     }
@@ -235,7 +262,7 @@ void closeOffRoundabout(const bool on_roundabout,
                      steps[1].maneuver.instruction.type == TurnType::NoTurn);
         steps[0].geometry_end = 1;
         steps[1].geometry_begin = 0;
-        steps[1] = forwardInto(steps[1], steps[0]);
+        forwardInto(steps[1], steps[0]);
         steps[1].intersections.erase(steps[1].intersections.begin()); // otherwise we copy the
                                                                       // source
         if (leavesRoundabout(steps[1].maneuver.instruction))
@@ -264,7 +291,7 @@ void closeOffRoundabout(const bool on_roundabout,
     BOOST_ASSERT(!steps[step_index].intersections.empty());
     // the very first intersection in the steps represents the location of the turn. Following
     // intersections are locations passed along the way
-    const auto exit_intersection = steps[step_index].intersections.front();
+    const auto &exit_intersection = steps[step_index].intersections.front();
     const auto exit_bearing = exit_intersection.bearings[exit_intersection.out];
     const auto destination_name = step.name;
     const auto destinatino_name_id = step.name_id;
@@ -275,10 +302,11 @@ void closeOffRoundabout(const bool on_roundabout,
              --propagation_index)
         {
             auto &propagation_step = steps[propagation_index];
-            propagation_step = forwardInto(propagation_step, steps[propagation_index + 1]);
+            // the next step is invalidated in both branches below
+            forwardInto(propagation_step, std::move(steps[propagation_index + 1]));
             if (entersRoundabout(propagation_step.maneuver.instruction))
             {
-                const auto entry_intersection = propagation_step.intersections.front();
+                const auto &entry_intersection = propagation_step.intersections.front();
 
                 // remember rotary name
                 if (propagation_step.maneuver.instruction.type == TurnType::EnterRotary ||
@@ -316,7 +344,8 @@ void closeOffRoundabout(const bool on_roundabout,
 }
 
 // elongate a step by another. the data is added either at the front, or the back
-RouteStep elongate(RouteStep step, const RouteStep &by_step)
+// Pass by_step as rvalue if it is invalidated afterwards, its intersections are moved then
+template <typename StepT> void elongate(RouteStep &step, StepT &&by_step)
 {
     BOOST_ASSERT(step.mode == by_step.mode);
 
@@ -330,8 +359,9 @@ RouteStep elongate(RouteStep step, const RouteStep &by_step)
 
         // if we elongate in the back, we only need to copy the intersections to the beginning.
         // the bearings remain the same, as the location of the turn doesn't change
-        step.intersections.insert(
-            step.intersections.end(), by_step.intersections.begin(), by_step.intersections.end());
+        insertIntersections(step.intersections,
+                            step.intersections.end(),
+                            std::forward<StepT>(by_step).intersections);
     }
     // by_step comes before step -> we append at the front
     else
@@ -344,10 +374,10 @@ RouteStep elongate(RouteStep step, const RouteStep &by_step)
         // elongating in the front changes the location of the maneuver
         step.maneuver = by_step.maneuver;
 
-        step.intersections.insert(
-            step.intersections.begin(), by_step.intersections.begin(), by_step.intersections.end());
+        insertIntersections(step.intersections,
+                            step.intersections.begin(),
+                            std::forward<StepT>(by_step).intersections);
     }
-    return step;
 }
 
 void collapseTurnAt(std::vector<RouteStep> &steps,
@@ -399,7 +429,7 @@ void collapseTurnAt(std::vector<RouteStep> &steps,
                          DirectionModifier::Straight &&
                      one_back_step.intersections.front().bearings.size() > 2)
                 steps[step_index].maneuver.instruction.type = TurnType::Turn;
-            steps[two_back_index] = elongate(std::move(steps[two_back_index]), one_back_step);
+            elongate(steps[two_back_index], std::move(steps[one_back_index]));
             // If the previous instruction asked to continue, the name change will have to
             // be changed into a turn
             invalidateStep(steps[one_back_index]);
@@ -412,7 +442,7 @@ void collapseTurnAt(std::vector<RouteStep> &steps,
         // TODO check for lanes (https://github.com/Project-OSRM/osrm-backend/issues/2553)
         if (compatible(one_back_step, current_step))
         {
-            steps[one_back_index] = elongate(std::move(steps[one_back_index]), steps[step_index]);
+            elongate(steps[one_back_index], steps[step_index]);
             if ((TurnType::Continue == one_back_step.maneuver.instruction.type ||
                  TurnType::Suppressed == one_back_step.maneuver.instruction.type) &&
                 current_step.name_id != steps[two_back_index].name_id)
@@ -477,12 +507,11 @@ void collapseTurnAt(std::vector<RouteStep> &steps,
 
         if (direct_u_turn || u_turn_with_name_change)
         {
-            steps[one_back_index] = elongate(std::move(steps[one_back_index]), steps[step_index]);
+            elongate(steps[one_back_index], std::move(steps[step_index]));
             invalidateStep(steps[step_index]);
             if (u_turn_with_name_change)
             {
-                steps[one_back_index] =
-                    elongate(std::move(steps[one_back_index]), steps[step_index + 1]);
+                elongate(steps[one_back_index], std::move(steps[step_index + 1]));
                 invalidateStep(steps[step_index + 1]); // will be skipped due to the
                                                        // continue statement at the
                                                        // beginning of this function
@@ -677,15 +706,14 @@ std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
             }
             if (compatible(one_back_step, current_step))
             {
-                steps[one_back_index] =
-                    elongate(std::move(steps[one_back_index]), steps[step_index]);
+                elongate(steps[one_back_index], steps[step_index]);
                 steps[one_back_index].name_id = steps[step_index].name_id;
                 steps[one_back_index].name = steps[step_index].name;
 
-                const auto exit_intersection = steps[step_index].intersections.front();
+                const auto &exit_intersection = steps[step_index].intersections.front();
                 const auto exit_bearing = exit_intersection.bearings[exit_intersection.out];
 
-                const auto entry_intersection = steps[one_back_index].intersections.front();
+                const auto &entry_intersection = steps[one_back_index].intersections.front();
                 const auto entry_bearing = entry_intersection.bearings[entry_intersection.in];
 
                 const double angle =
@@ -707,8 +735,7 @@ std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
 
             for (std::size_t index = last_available_name_index + 1; index <= step_index; ++index)
             {
-                steps[last_available_name_index] =
-                    elongate(std::move(steps[last_available_name_index]), steps[index]);
+                elongate(steps[last_available_name_index], std::move(steps[index]));
                 invalidateStep(steps[index]);
             }
         }
@@ -727,9 +754,8 @@ std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
             {
                 if (compatible(one_back_step, steps[two_back_index]))
                 {
-                    steps[two_back_index] =
-                        elongate(elongate(std::move(steps[two_back_index]), steps[one_back_index]),
-                                 steps[step_index]);
+                    elongate(steps[two_back_index], std::move(steps[one_back_index]));
+                    elongate(steps[two_back_index], std::move(steps[step_index]));
                     invalidateStep(steps[one_back_index]);
                     invalidateStep(steps[step_index]);
                 }
@@ -739,13 +765,11 @@ std::vector<RouteStep> collapseTurns(std::vector<RouteStep> steps)
             else if (nameSegmentLength(one_back_index, steps) < name_segment_cutoff_length &&
                      isBasicNameChange(one_back_step) && isBasicNameChange(current_step))
             {
-                steps[two_back_index] =
-                    elongate(std::move(steps[two_back_index]), steps[one_back_index]);
+                elongate(steps[two_back_index], std::move(steps[one_back_index]));
                 invalidateStep(steps[one_back_index]);
                 if (nameSegmentLength(step_index, steps) < name_segment_cutoff_length)
                 {
-                    steps[two_back_index] =
-                        elongate(std::move(steps[two_back_index]), steps[step_index]);
+                    elongate(steps[two_back_index], std::move(steps[step_index]));
                     invalidateStep(steps[step_index]);
                 }
             }
@@ -1067,7 +1091,8 @@ std::vector<RouteStep> buildIntersections(std::vector<RouteStep> steps)
         {
             // count intersections. We cannot use exit, since intersections can follow directly
             // after a roundabout
-            steps[last_valid_instruction] = elongate(steps[last_valid_instruction], step);
+            // the step is removed below, only its instruction is used afterwards
+            elongate(steps[last_valid_instruction], std::move(step));
             step.maneuver.instruction = TurnInstruction::NO_TURN();
         }
         else if (!isSilent(instruction))
@@ -1095,6 +1120,20 @@ std::vector<RouteStep> buildIntersections(std::vector<RouteStep> steps)
     return removeNoTurnInstructions(std::move(steps));
 }
 
+void postProcessLeg(std::vector<RouteStep> &steps,
+                    LegGeometry &leg_geometry,
+                    const PhantomNode &source_node,
+                    const PhantomNode &target_node)
+{
+    trimShortSegments(steps, leg_geometry);
+    steps = postProcess(std::move(steps));
+    steps = collapseTurns(std::move(steps));
+    steps = buildIntersections(std::move(steps));
+    steps = assignRelativeLocations(std::move(steps), leg_geometry, source_node, target_node);
+    steps = anticipateLaneChange(std::move(steps));
+    leg_geometry = resyncGeometry(std::move(leg_geometry), steps);
+}
+
 } // namespace guidance
 } // namespace engine
 } // namespace osrm
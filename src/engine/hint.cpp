@@ -8,35 +8,123 @@
 #include <iterator>
 #include <ostream>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 namespace osrm
 {
 namespace engine
 {
 
+namespace
+{
+// Ties a compact hint to the coordinate it was snapped from, deterministic across builds
+std::uint32_t makeCompactChecksum(const std::uint32_t data_checksum,
+                                  const util::Coordinate input_coordinate)
+{
+    auto checksum = data_checksum;
+    checksum ^= static_cast<std::uint32_t>(static_cast<std::int32_t>(input_coordinate.lon)) *
+                0x9E3779B1u;
+    checksum = (checksum << 15) | (checksum >> 17);
+    checksum ^= static_cast<std::uint32_t>(static_cast<std::int32_t>(input_coordinate.lat)) *
+                0x85EBCA77u;
+    return checksum;
+}
+
+std::string makeURLSafe(std::string base64)
+{
+    // Make safe for usage as GET parameter in URLs
+    std::replace(begin(base64), end(base64), '+', '-');
+    std::replace(begin(base64), end(base64), '/', '_');
+    return base64;
+}
+
+// Sums up the offsets of a compact hint, false if it does not fit the packed geometries
+bool restoreOffsets(PhantomNode &phantom, const datafacade::BaseDataFacade &facade)
+{
+    const auto position = phantom.fwd_segment_position;
+
+    if (phantom.forward_packed_geometry_id != SPECIAL_EDGEID)
+    {
+        const auto weights = facade.GetUncompressedWeightsView(phantom.forward_packed_geometry_id);
+        if (position >= weights.size())
+            return false;
+
+        phantom.forward_offset = 0;
+        for (std::size_t i = 0; i < position; ++i)
+            phantom.forward_offset += weights[i];
+    }
+
+    if (phantom.reverse_packed_geometry_id != SPECIAL_EDGEID)
+    {
+        const auto weights = facade.GetUncompressedWeightsView(phantom.reverse_packed_geometry_id);
+        if (position >= weights.size())
+            return false;
+
+        phantom.reverse_offset = 0;
+        for (std::size_t i = 0; i < weights.size() - position - 1; ++i)
+            phantom.reverse_offset += weights[i];
+    }
+
+    return true;
+}
+} // anon. ns
+
+CompactHint::CompactHint()
+    : forward_segment_id{SPECIAL_SEGMENTID, false}, reverse_segment_id{SPECIAL_SEGMENTID, false}
+{
+}
+
+CompactHint::CompactHint(const PhantomNode &phantom, const std::uint32_t data_checksum)
+    : forward_segment_id{phantom.forward_segment_id},
+      reverse_segment_id{phantom.reverse_segment_id},
+      forward_packed_geometry_id{phantom.forward_packed_geometry_id},
+      reverse_packed_geometry_id{phantom.reverse_packed_geometry_id}, name_id{phantom.name_id},
+      component(phantom.component), forward_weight{phantom.forward_weight},
+      reverse_weight{phantom.reverse_weight}, location{phantom.location},
+      checksum{makeCompactChecksum(data_checksum, phantom.input_location)},
+      fwd_segment_position{phantom.fwd_segment_position},
+      forward_travel_mode{phantom.forward_travel_mode},
+      backward_travel_mode{phantom.backward_travel_mode}
+{
+}
+
 bool Hint::IsValid(const util::Coordinate new_input_coordinates,
                    const datafacade::BaseDataFacade &facade) const
 {
+    return IsValid(new_input_coordinates, facade.GetNumberOfNodes(), facade.GetCheckSum());
+}
+
+bool Hint::IsValid(const util::Coordinate new_input_coordinates,
+                   const unsigned number_of_nodes,
+                   const std::uint32_t checksum) const
+{
+    if (IsCompact())
+    {
+        return makeCompactChecksum(checksum, new_input_coordinates) == data_checksum &&
+               phantom.IsValid(number_of_nodes);
+    }
+
     auto is_same_input_coordinate = new_input_coordinates.lon == phantom.input_location.lon &&
                                     new_input_coordinates.lat == phantom.input_location.lat;
-    return is_same_input_coordinate && phantom.IsValid(facade.GetNumberOfNodes()) &&
-           facade.GetCheckSum() == data_checksum;
+    return is_same_input_coordinate && phantom.IsValid(number_of_nodes) &&
+           checksum == data_checksum;
 }
 
-std::string Hint::ToBase64() const
-{
-    auto base64 = encodeBase64Bytewise(*this);
+bool Hint::IsCompact() const { return !phantom.input_location.IsValid(); }
 
-    // Make safe for usage as GET parameter in URLs
-    std::replace(begin(base64), end(base64), '+', '-');
-    std::replace(begin(base64), end(base64), '/', '_');
+std::string Hint::ToBase64() const { return makeURLSafe(encodeBase64Bytewise(*this)); }
 
-    return base64;
+std::string Hint::ToCompactBase64() const
+{
+    return makeURLSafe(encodeBase64Bytewise(CompactHint{phantom, data_checksum}));
 }
 
 Hint Hint::FromBase64(const std::string &base64Hint)
 {
-    BOOST_ASSERT_MSG(base64Hint.size() == ENCODED_HINT_SIZE, "Hint has invalid size");
+    BOOST_ASSERT_MSG(base64Hint.size() == ENCODED_HINT_SIZE ||
+                         base64Hint.size() == ENCODED_COMPACT_HINT_SIZE,
+                     "Hint has invalid size");
 
     // We need mutability but don't want to change the API
     auto encoded = base64Hint;
@@ -45,7 +133,57 @@ Hint Hint::FromBase64(const std::string &base64Hint)
     std::replace(begin(encoded), end(encoded), '-', '+');
     std::replace(begin(encoded), end(encoded), '_', '/');
 
-    return decodeBase64Bytewise<Hint>(encoded);
+    if (encoded.size() != ENCODED_COMPACT_HINT_SIZE)
+        return decodeBase64Bytewise<Hint>(encoded);
+
+    const auto compact = decodeBase64Bytewise<CompactHint>(encoded);
+
+    Hint hint;
+    hint.phantom.forward_segment_id = compact.forward_segment_id;
+    hint.phantom.reverse_segment_id = compact.reverse_segment_id;
+    hint.phantom.forward_packed_geometry_id = compact.forward_packed_geometry_id;
+    hint.phantom.reverse_packed_geometry_id = compact.reverse_packed_geometry_id;
+    hint.phantom.name_id = compact.name_id;
+    hint.phantom.component = compact.component;
+    hint.phantom.forward_weight = compact.forward_weight;
+    hint.phantom.reverse_weight = compact.reverse_weight;
+    hint.phantom.location = compact.location;
+    hint.phantom.fwd_segment_position = compact.fwd_segment_position;
+    hint.phantom.forward_travel_mode = compact.forward_travel_mode;
+    hint.phantom.backward_travel_mode = compact.backward_travel_mode;
+    hint.data_checksum = compact.checksum;
+    BOOST_ASSERT(hint.IsCompact());
+    return hint;
+}
+
+std::vector<boost::optional<PhantomNode>>
+getHintedPhantomNodes(const std::vector<boost::optional<Hint>> &hints,
+                      const std::vector<util::Coordinate> &coordinates,
+                      const datafacade::BaseDataFacade &facade)
+{
+    BOOST_ASSERT(hints.size() == coordinates.size());
+
+    const auto number_of_nodes = facade.GetNumberOfNodes();
+    const auto checksum = facade.GetCheckSum();
+
+    std::vector<boost::optional<PhantomNode>> phantoms(hints.size());
+    for (std::size_t i = 0; i < hints.size(); ++i)
+    {
+        const auto &hint = hints[i];
+        if (!hint || !hint->IsValid(coordinates[i], number_of_nodes, checksum))
+            continue;
+
+        auto phantom = hint->phantom;
+        if (hint->IsCompact())
+        {
+            if (!restoreOffsets(phantom, facade))
+                continue;
+            phantom.input_location = coordinates[i];
+        }
+        phantoms[i] = std::move(phantom);
+    }
+
+    return phantoms;
 }
 
 bool operator==(const Hint &lhs, const Hint &rhs)
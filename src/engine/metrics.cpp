@@ -0,0 +1,451 @@
+#include "engine/metrics.hpp"
+
+#include "util/exception.hpp"
+#include "util/json_container.hpp"
+#include "util/json_renderer.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace metrics
+{
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+const constexpr char *SERVICE_NAMES[NUM_SERVICES] = {
+    "route", "table", "nearest", "trip", "match", "isochrone", "tile", "other"};
+const constexpr char *STAGE_NAMES[NUM_STAGES] = {
+    "parse", "snapping", "search", "unpacking", "guidance", "rendering", "compression"};
+
+// Upper bounds of the histogram buckets in ns, from 100us to 10s. Anything slower ends up in the
+// implicit +Inf bucket.
+const constexpr std::uint64_t BUCKET_BOUNDS[] = {
+    100000,    250000,    500000,     1000000,    2500000,    5000000,     10000000,   25000000,
+    50000000,  100000000, 250000000,  500000000,  1000000000, 2500000000,  5000000000, 10000000000};
+const constexpr char *BUCKET_LABELS[] = {"0.0001", "0.00025", "0.0005", "0.001", "0.0025",
+                                         "0.005",  "0.01",    "0.025",  "0.05",  "0.1",
+                                         "0.25",   "0.5",     "1",      "2.5",   "5",
+                                         "10",     "+Inf"};
+const constexpr std::size_t NUM_BUCKETS = std::extent<decltype(BUCKET_BOUNDS)>::value + 1;
+static_assert(std::extent<decltype(BUCKET_LABELS)>::value == NUM_BUCKETS,
+              "every bucket needs a label");
+
+// Only the owning thread writes its metrics, so updates are plain loads and stores without any
+// read-modify-write. Rendering the metrics reads them from another thread, which is why they are
+// atomics at all.
+using Counter = std::atomic<std::uint64_t>;
+
+inline void Add(Counter &counter, const std::uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct Histogram
+{
+    std::array<Counter, NUM_BUCKETS> buckets;
+    Counter sum_ns;
+
+    void Observe(const Clock::duration duration)
+    {
+        const auto ns = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        const auto bucket = std::distance(
+            std::begin(BUCKET_BOUNDS),
+            std::lower_bound(std::begin(BUCKET_BOUNDS), std::end(BUCKET_BOUNDS), ns));
+        Add(buckets[bucket], 1);
+        Add(sum_ns, ns);
+    }
+};
+
+struct ServiceMetrics
+{
+    Histogram request_duration;
+    std::array<Histogram, NUM_STAGES> stage_durations;
+    Counter settled_nodes;
+    Counter inserted_nodes;
+};
+
+struct ThreadMetrics
+{
+    std::array<ServiceMetrics, NUM_SERVICES> services;
+};
+
+// Metrics of every thread that ever finished a request. Threads live as long as the server, so
+// their metrics are never removed.
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadMetrics>> threads;
+};
+
+Registry &GetRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+ThreadMetrics &GetThreadMetrics()
+{
+    static thread_local ThreadMetrics *thread_metrics = nullptr;
+    if (!thread_metrics)
+    {
+        // value initialization zeroes all counters
+        std::unique_ptr<ThreadMetrics> metrics(new ThreadMetrics());
+        thread_metrics = metrics.get();
+
+        auto &registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.threads.push_back(std::move(metrics));
+    }
+    return *thread_metrics;
+}
+
+// The request the calling thread currently handles
+struct RequestState
+{
+    bool active;
+    bool has_service;
+    Service service;
+    Clock::time_point start;
+    std::array<Clock::duration, NUM_STAGES> stage_durations;
+    std::uint64_t settled_nodes;
+    std::uint64_t inserted_nodes;
+    StageTimer *timer;
+    // only set with a query log
+    std::string url;
+};
+
+thread_local RequestState current_request;
+
+struct QueryLog
+{
+    std::mutex mutex;
+    std::ofstream output;
+    Clock::duration slow_query_threshold;
+    double sample_rate;
+};
+
+// Set before the first request and never reset, so requests read it without synchronization
+QueryLog *query_log = nullptr;
+
+bool IsSampled(const double sample_rate)
+{
+    if (sample_rate <= 0)
+    {
+        return false;
+    }
+    static thread_local std::minstd_rand generator{std::random_device{}()};
+    return std::uniform_real_distribution<double>(0, 1)(generator) < sample_rate;
+}
+
+double ToMilliseconds(const Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void WriteQuery(QueryLog &log, const RequestState &request, const Clock::duration duration)
+{
+    util::json::Object query;
+    query.values["url"] = request.url;
+    query.values["service"] = SERVICE_NAMES[static_cast<std::size_t>(request.service)];
+    query.values["duration_ms"] = ToMilliseconds(duration);
+    if (duration >= log.slow_query_threshold)
+    {
+        query.values["slow"] = util::json::True();
+    }
+    else
+    {
+        query.values["slow"] = util::json::False();
+    }
+    util::json::Object stages;
+    for (std::size_t stage = 0; stage < NUM_STAGES; ++stage)
+    {
+        if (request.stage_durations[stage] != Clock::duration::zero())
+        {
+            stages.values[STAGE_NAMES[stage]] = ToMilliseconds(request.stage_durations[stage]);
+        }
+    }
+    query.values["stages_ms"] = std::move(stages);
+    query.values["settled_nodes"] = static_cast<double>(request.settled_nodes);
+    query.values["inserted_nodes"] = static_cast<double>(request.inserted_nodes);
+
+    std::ostringstream line;
+    util::json::render(line, query);
+    line << '\n';
+
+    std::lock_guard<std::mutex> lock(log.mutex);
+    log.output << line.str() << std::flush;
+}
+
+void Reset(RequestState &request)
+{
+    request.active = false;
+    request.has_service = false;
+    request.service = Service::Other;
+    request.stage_durations.fill(Clock::duration::zero());
+    request.settled_nodes = 0;
+    request.inserted_nodes = 0;
+    request.timer = nullptr;
+    request.url.clear();
+}
+
+std::uint64_t Load(const Counter &counter) { return counter.load(std::memory_order_relaxed); }
+
+void RenderHistogram(std::ostream &out,
+                     const std::string &name,
+                     const std::string &labels,
+                     const std::array<std::uint64_t, NUM_BUCKETS> &buckets,
+                     const std::uint64_t sum_ns)
+{
+    std::uint64_t count = 0;
+    for (std::size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+    {
+        count += buckets[bucket];
+        out << name << "_bucket{" << labels << ",le=\"" << BUCKET_LABELS[bucket] << "\"} "
+            << count << "\n";
+    }
+    out << name << "_sum{" << labels << "} " << std::fixed << std::setprecision(9)
+        << sum_ns / 1e9 << "\n";
+    out << name << "_count{" << labels << "} " << count << "\n";
+}
+}
+
+RequestScope::RequestScope()
+{
+    BOOST_ASSERT_MSG(!current_request.active, "requests can not be nested");
+    Reset(current_request);
+    current_request.active = true;
+    current_request.start = Clock::now();
+}
+
+RequestScope::~RequestScope()
+{
+    if (current_request.has_service)
+    {
+        auto &metrics =
+            GetThreadMetrics().services[static_cast<std::size_t>(current_request.service)];
+        const auto duration = Clock::now() - current_request.start;
+        metrics.request_duration.Observe(duration);
+        for (std::size_t stage = 0; stage < NUM_STAGES; ++stage)
+        {
+            if (current_request.stage_durations[stage] != Clock::duration::zero())
+            {
+                metrics.stage_durations[stage].Observe(current_request.stage_durations[stage]);
+            }
+        }
+        Add(metrics.settled_nodes, current_request.settled_nodes);
+        Add(metrics.inserted_nodes, current_request.inserted_nodes);
+
+        if (query_log && (duration >= query_log->slow_query_threshold ||
+                          IsSampled(query_log->sample_rate)))
+        {
+            WriteQuery(*query_log, current_request, duration);
+        }
+    }
+    Reset(current_request);
+}
+
+void SetService(const std::string &name)
+{
+    if (!current_request.active)
+    {
+        return;
+    }
+
+    const auto name_iter = std::find(std::begin(SERVICE_NAMES), std::end(SERVICE_NAMES), name);
+    current_request.has_service = true;
+    current_request.service = name_iter == std::end(SERVICE_NAMES)
+                                  ? Service::Other
+                                  : static_cast<Service>(
+                                        std::distance(std::begin(SERVICE_NAMES), name_iter));
+}
+
+void SetURL(const std::string &url)
+{
+    if (current_request.active && query_log)
+    {
+        current_request.url = url;
+    }
+}
+
+void UseQueryLog(const std::string &path,
+                 const std::chrono::milliseconds slow_query_threshold,
+                 const double sample_rate)
+{
+    BOOST_ASSERT_MSG(!query_log, "the query log can only be set once");
+    std::unique_ptr<QueryLog> log(new QueryLog());
+    log->output.open(path, std::ios::app);
+    if (!log->output)
+    {
+        throw util::exception("Could not open the query log " + path);
+    }
+    log->slow_query_threshold = slow_query_threshold;
+    log->sample_rate = sample_rate;
+    query_log = log.release();
+}
+
+StageTimer::StageTimer(const Stage stage)
+    : stage(stage), parent(current_request.timer), nested(Clock::duration::zero()),
+      active(current_request.active)
+{
+    if (active)
+    {
+        current_request.timer = this;
+        start = Clock::now();
+    }
+}
+
+StageTimer::~StageTimer()
+{
+    if (!active)
+    {
+        return;
+    }
+
+    const auto elapsed = Clock::now() - start;
+    current_request.stage_durations[static_cast<std::size_t>(stage)] += elapsed - nested;
+    if (parent)
+    {
+        parent->nested += elapsed;
+    }
+    current_request.timer = parent;
+}
+
+void CountSearch(const std::size_t inserted_nodes, const std::size_t settled_nodes)
+{
+    if (current_request.active)
+    {
+        current_request.inserted_nodes += inserted_nodes;
+        current_request.settled_nodes += settled_nodes;
+    }
+}
+
+std::string RenderPrometheus()
+{
+    struct HistogramSnapshot
+    {
+        std::array<std::uint64_t, NUM_BUCKETS> buckets;
+        std::uint64_t sum_ns;
+
+        void Add(const Histogram &histogram)
+        {
+            for (std::size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+            {
+                buckets[bucket] += Load(histogram.buckets[bucket]);
+            }
+            sum_ns += Load(histogram.sum_ns);
+        }
+
+        std::uint64_t Count() const
+        {
+            return std::accumulate(buckets.begin(), buckets.end(), std::uint64_t{0});
+        }
+    };
+    struct ServiceSnapshot
+    {
+        HistogramSnapshot request_duration;
+        std::array<HistogramSnapshot, NUM_STAGES> stage_durations;
+        std::uint64_t settled_nodes;
+        std::uint64_t inserted_nodes;
+    };
+
+    // value initialization zeroes the sums
+    std::vector<ServiceSnapshot> services(NUM_SERVICES, ServiceSnapshot());
+    {
+        auto &registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto &thread : registry.threads)
+        {
+            for (std::size_t service = 0; service < NUM_SERVICES; ++service)
+            {
+                const auto &metrics = thread->services[service];
+                auto &snapshot = services[service];
+                snapshot.request_duration.Add(metrics.request_duration);
+                for (std::size_t stage = 0; stage < NUM_STAGES; ++stage)
+                {
+                    snapshot.stage_durations[stage].Add(metrics.stage_durations[stage]);
+                }
+                snapshot.settled_nodes += Load(metrics.settled_nodes);
+                snapshot.inserted_nodes += Load(metrics.inserted_nodes);
+            }
+        }
+    }
+
+    std::ostringstream out;
+    out << "# HELP osrm_request_duration_seconds Time to handle a request.\n"
+        << "# TYPE osrm_request_duration_seconds histogram\n";
+    for (std::size_t service = 0; service < NUM_SERVICES; ++service)
+    {
+        const auto &histogram = services[service].request_duration;
+        if (histogram.Count() > 0)
+        {
+            RenderHistogram(out,
+                            "osrm_request_duration_seconds",
+                            std::string("service=\"") + SERVICE_NAMES[service] + "\"",
+                            histogram.buckets,
+                            histogram.sum_ns);
+        }
+    }
+
+    out << "# HELP osrm_stage_duration_seconds Time a request spent in a stage, without the time "
+           "of the stages nested in it.\n"
+        << "# TYPE osrm_stage_duration_seconds histogram\n";
+    for (std::size_t service = 0; service < NUM_SERVICES; ++service)
+    {
+        for (std::size_t stage = 0; stage < NUM_STAGES; ++stage)
+        {
+            const auto &histogram = services[service].stage_durations[stage];
+            if (histogram.Count() > 0)
+            {
+                RenderHistogram(out,
+                                "osrm_stage_duration_seconds",
+                                std::string("service=\"") + SERVICE_NAMES[service] +
+                                    "\",stage=\"" + STAGE_NAMES[stage] + "\"",
+                                histogram.buckets,
+                                histogram.sum_ns);
+            }
+        }
+    }
+
+    const auto render_counter = [&](const std::string &name,
+                                    const std::string &help,
+                                    std::uint64_t ServiceSnapshot::*const value) {
+        out << "# HELP " << name << " " << help << "\n"
+            << "# TYPE " << name << " counter\n";
+        for (std::size_t service = 0; service < NUM_SERVICES; ++service)
+        {
+            out << name << "{service=\"" << SERVICE_NAMES[service] << "\"} "
+                << services[service].*value << "\n";
+        }
+    };
+    render_counter("osrm_settled_nodes_total",
+                   "Nodes settled by the searches of requests.",
+                   &ServiceSnapshot::settled_nodes);
+    render_counter("osrm_heap_inserted_nodes_total",
+                   "Nodes inserted into the query heaps by the searches of requests.",
+                   &ServiceSnapshot::inserted_nodes);
+
+    return out.str();
+}
+}
+}
+}
@@ -0,0 +1,175 @@
+#include "engine/plugins/isochrone.hpp"
+#include "engine/api/isochrone_api.hpp"
+#include "engine/api/isochrone_parameters.hpp"
+#include "engine/phantom_node.hpp"
+#include "util/coordinate_calculation.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace plugins
+{
+
+namespace
+{
+// meters per second no road is faster than, everything reachable lies within the distance
+// this speed covers in the requested duration
+const constexpr double MAX_ISOCHRONE_SPEED = 45.;
+
+// The weight at which the road segment at position of a geometry is entered. INVALID_EDGE_WEIGHT
+// if the node is not reached or the segment lies behind the source.
+EdgeWeight SegmentStartWeight(const std::vector<EdgeWeight> &node_weights,
+                              const NodeID node,
+                              const std::vector<EdgeWeight> &segment_weights,
+                              const std::size_t position,
+                              const NodeID source_node,
+                              const std::size_t source_position)
+{
+    if (node_weights[node] == INVALID_EDGE_WEIGHT ||
+        (node == source_node && position < source_position))
+    {
+        return INVALID_EDGE_WEIGHT;
+    }
+    BOOST_ASSERT(position < segment_weights.size());
+    return std::accumulate(segment_weights.begin(),
+                           segment_weights.begin() + position,
+                           node_weights[node]);
+}
+}
+
+IsochronePlugin::IsochronePlugin(datafacade::BaseDataFacade &facade,
+                                 const int max_duration_isochrone)
+    : BasePlugin{facade}, isochrone(&facade, heaps), max_duration_isochrone(max_duration_isochrone)
+{
+}
+
+Status IsochronePlugin::HandleRequest(const api::IsochroneParameters &params,
+                                      util::json::Object &json_result)
+{
+    BOOST_ASSERT(params.IsValid());
+
+    if (!CheckAllCoordinates(params.coordinates))
+        return Error("InvalidOptions", "Coordinates are invalid", json_result);
+
+    if (params.coordinates.size() != 1)
+    {
+        return Error("InvalidOptions", "Only one input coordinate is supported", json_result);
+    }
+
+    if (max_duration_isochrone > 0 &&
+        params.duration > static_cast<unsigned>(max_duration_isochrone))
+    {
+        return Error("TooBig", "Isochrone duration is too large", json_result);
+    }
+
+    const auto phantom_node_pairs = GetPhantomNodes(params);
+    if (phantom_node_pairs.size() != params.coordinates.size())
+    {
+        return Error("NoSegment", "Could not find a matching segment for coordinate", json_result);
+    }
+    const auto source = SnapPhantomNodes(phantom_node_pairs).front();
+
+    // weights are in deci-seconds
+    const EdgeWeight max_weight = static_cast<EdgeWeight>(params.duration) * 10;
+    const auto node_weights = isochrone(source, max_weight);
+
+    using namespace util::coordinate_calculation::detail;
+    const double lon = static_cast<double>(util::toFloating(source.location.lon));
+    const double lat = static_cast<double>(util::toFloating(source.location.lat));
+    const double lat_delta =
+        params.duration * MAX_ISOCHRONE_SPEED / static_cast<double>(EARTH_RADIUS * DEGREE_TO_RAD);
+    const double lon_delta = std::min(
+        180., lat_delta / std::max(0.01, std::cos(lat * static_cast<double>(DEGREE_TO_RAD))));
+    const util::Coordinate southwest{util::FloatLongitude{std::max(-180., lon - lon_delta)},
+                                     util::FloatLatitude{std::max(-90., lat - lat_delta)}};
+    const util::Coordinate northeast{util::FloatLongitude{std::min(180., lon + lon_delta)},
+                                     util::FloatLatitude{std::min(90., lat + lat_delta)}};
+
+    const auto source_reverse_position =
+        [&](const std::size_t number_of_segments) -> std::size_t {
+        return number_of_segments - source.fwd_segment_position - 1;
+    };
+
+    std::vector<util::Coordinate> reachable{source.location};
+    std::vector<std::pair<util::Coordinate, util::Coordinate>> segments;
+    std::vector<EdgeWeight> segment_weights;
+    // adds the part of the segment from start to end that is reached within the duration, the
+    // segment of the source is entered at the source
+    const auto add_segment = [&](const EdgeWeight start_weight,
+                                 const EdgeWeight segment_weight,
+                                 util::Coordinate start,
+                                 const util::Coordinate end) {
+        if (start_weight > max_weight)
+            return false;
+
+        auto reached_end = end;
+        if (start_weight + segment_weight > max_weight)
+        {
+            const auto factor = static_cast<double>(max_weight - start_weight) / segment_weight;
+            reached_end = util::coordinate_calculation::interpolateLinear(
+                std::min(1., factor), start, end);
+        }
+        if (start_weight < 0)
+            start = source.location;
+        reachable.push_back(start);
+        reachable.push_back(reached_end);
+        segments.emplace_back(start, reached_end);
+        return true;
+    };
+
+    for (const auto &edge : facade.GetEdgesInBox(southwest, northeast))
+    {
+        const auto u = facade.GetCoordinateOfNode(edge.u);
+        const auto v = facade.GetCoordinateOfNode(edge.v);
+
+        bool added = false;
+        if (edge.forward_segment_id.enabled && edge.forward_packed_geometry_id != SPECIAL_EDGEID)
+        {
+            facade.GetUncompressedWeights(edge.forward_packed_geometry_id, segment_weights);
+            const auto start_weight = SegmentStartWeight(node_weights,
+                                                         edge.forward_segment_id.id,
+                                                         segment_weights,
+                                                         edge.fwd_segment_position,
+                                                         source.forward_segment_id.id,
+                                                         source.fwd_segment_position);
+            added = add_segment(
+                start_weight, segment_weights[edge.fwd_segment_position], u, v);
+        }
+        if (!added && edge.reverse_segment_id.enabled &&
+            edge.reverse_packed_geometry_id != SPECIAL_EDGEID)
+        {
+            facade.GetUncompressedWeights(edge.reverse_packed_geometry_id, segment_weights);
+            const auto position = segment_weights.size() - edge.fwd_segment_position - 1;
+            const auto start_weight =
+                SegmentStartWeight(node_weights,
+                                   edge.reverse_segment_id.id,
+                                   segment_weights,
+                                   position,
+                                   source.reverse_segment_id.id,
+                                   source_reverse_position(segment_weights.size()));
+            add_segment(start_weight, segment_weights[position], v, u);
+        }
+    }
+
+    api::IsochroneAPI isochrone_api(facade, params);
+    isochrone_api.MakeResponse(source,
+                               util::coordinate_calculation::convexHull(std::move(reachable)),
+                               segments,
+                               json_result);
+
+    return Status::Ok;
+}
+}
+}
+}
@@ -4,12 +4,15 @@
 #include "engine/api/match_api.hpp"
 #include "engine/api/match_parameters.hpp"
 #include "engine/map_matching/bayes_classifier.hpp"
+#include "engine/map_matching/trace_thinning.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/integer_range.hpp"
 #include "util/json_logger.hpp"
 #include "util/json_util.hpp"
 #include "util/string_util.hpp"
 
+#include <boost/optional.hpp>
+
 #include <cstdlib>
 
 #include <algorithm>
@@ -123,20 +126,28 @@ Status MatchPlugin::HandleRequest(const api::MatchParameters &parameters,
         return Error("InvalidValue", "Invalid coordinate value.", json_result);
     }
 
+    // a thinned trace is matched instead of the request's, its indices are mapped back below
+    boost::optional<map_matching::ThinnedTrace> thinned;
+    if (parameters.tidy && parameters.session.empty())
+    {
+        thinned = map_matching::ThinTrace(parameters);
+    }
+    const api::MatchParameters &trace = thinned ? thinned->parameters : parameters;
+
     // assuming radius is the standard deviation of a normal distribution
     // that models GPS noise (in this model), x3 should give us the correct
     // search radius with > 99% confidence
     std::vector<double> search_radiuses;
-    if (parameters.radiuses.empty())
+    if (trace.radiuses.empty())
     {
-        search_radiuses.resize(parameters.coordinates.size(),
+        search_radiuses.resize(trace.coordinates.size(),
                                DEFAULT_GPS_PRECISION * RADIUS_MULTIPLIER);
     }
     else
     {
-        search_radiuses.resize(parameters.coordinates.size());
-        std::transform(parameters.radiuses.begin(),
-                       parameters.radiuses.end(),
+        search_radiuses.resize(trace.coordinates.size());
+        std::transform(trace.radiuses.begin(),
+                       trace.radiuses.end(),
                        search_radiuses.begin(),
                        [](const boost::optional<double> &maybe_radius) {
                            if (maybe_radius)
@@ -151,9 +162,9 @@ Status MatchPlugin::HandleRequest(const api::MatchParameters &parameters,
                        });
     }
 
-    auto candidates_lists = GetPhantomNodesInRange(parameters, search_radiuses);
+    auto candidates_lists = GetPhantomNodesInRange(trace, search_radiuses);
 
-    filterCandidates(parameters.coordinates, candidates_lists);
+    filterCandidates(trace.coordinates, candidates_lists);
     if (std::all_of(candidates_lists.begin(),
                     candidates_lists.end(),
                     [](const std::vector<PhantomNodeWithDistance> &candidates) {
@@ -166,10 +177,50 @@ Status MatchPlugin::HandleRequest(const api::MatchParameters &parameters,
     }
 
     // call the actual map matching
-    SubMatchingList sub_matchings = map_matching(
-        candidates_lists, parameters.coordinates, parameters.timestamps, parameters.radiuses);
+    SubMatchingList sub_matchings;
+    bool session_open = false;
+    if (parameters.session.empty())
+    {
+        sub_matchings = map_matching(candidates_lists,
+                                     trace.coordinates,
+                                     trace.timestamps,
+                                     trace.radiuses,
+                                     thinned ? thinned->sample_time : 0u);
+    }
+    else
+    {
+        // only the new samples are matched, starting from the frontier of the previous request.
+        // Sessions are never thinned.
+        auto frontier = sessions.Get(parameters.session);
+        sub_matchings = map_matching(candidates_lists,
+                                     parameters.coordinates,
+                                     parameters.timestamps,
+                                     parameters.radiuses,
+                                     frontier);
+        session_open = frontier.IsValid();
+        if (session_open)
+        {
+            sessions.Store(parameters.session, std::move(frontier));
+        }
+        else
+        {
+            sessions.Erase(parameters.session);
+        }
+    }
+
+    if (thinned)
+    {
+        for (auto &sub_matching : sub_matchings)
+        {
+            for (auto &index : sub_matching.indices)
+            {
+                index = thinned->indices[index];
+            }
+        }
+    }
 
-    if (sub_matchings.size() == 0)
+    // an open session might just not have enough samples for a matching yet
+    if (sub_matchings.size() == 0 && !session_open)
     {
         return Error("NoMatch", "Could not match the trace.", json_result);
     }
@@ -193,7 +244,9 @@ Status MatchPlugin::HandleRequest(const api::MatchParameters &parameters,
         // force uturns to be on, since we split the phantom nodes anyway and only have
         // bi-directional
         // phantom nodes for possible uturns
-        shortest_path(sub_routes[index].segment_end_coordinates, {false}, sub_routes[index]);
+        shortest_path(sub_routes[index].segment_end_coordinates,
+                      boost::optional<bool>(false),
+                      sub_routes[index]);
         BOOST_ASSERT(sub_routes[index].shortest_path_length != INVALID_EDGE_WEIGHT);
     }
 
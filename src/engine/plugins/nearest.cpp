@@ -3,6 +3,7 @@
 #include "engine/api/nearest_parameters.hpp"
 #include "engine/phantom_node.hpp"
 #include "util/integer_range.hpp"
+#include "util/json_writer.hpp"
 
 #include <cstddef>
 #include <string>
@@ -16,34 +17,72 @@ namespace engine
 namespace plugins
 {
 
-NearestPlugin::NearestPlugin(datafacade::BaseDataFacade &facade) : BasePlugin{facade} {}
+namespace
+{
+void MakeResponse(const api::NearestAPI &nearest_api,
+                  const std::vector<std::vector<PhantomNodeWithDistance>> &phantom_nodes,
+                  util::json::Object &result)
+{
+    nearest_api.MakeResponse(phantom_nodes, result);
+}
 
-Status NearestPlugin::HandleRequest(const api::NearestParameters &params,
-                                    util::json::Object &json_result)
+void MakeResponse(const api::NearestAPI &nearest_api,
+                  const std::vector<std::vector<PhantomNodeWithDistance>> &phantom_nodes,
+                  std::vector<char> &result)
 {
-    BOOST_ASSERT(params.IsValid());
+    util::json::Writer writer(result);
+    nearest_api.MakeResponse(phantom_nodes, writer);
+}
+}
 
-    if (!CheckAllCoordinates(params.coordinates))
-        return Error("InvalidOptions", "Coordinates are invalid", json_result);
+NearestPlugin::NearestPlugin(datafacade::BaseDataFacade &facade, const int max_locations_nearest)
+    : BasePlugin{facade}, max_locations_nearest(max_locations_nearest)
+{
+}
+
+template <typename ResultT>
+Status NearestPlugin::HandleNearestRequest(const api::NearestParameters &params, ResultT &result)
+{
+    BOOST_ASSERT(params.IsValid());
 
-    if (params.coordinates.size() != 1)
+    if (max_locations_nearest > 0 &&
+        params.coordinates.size() > static_cast<std::size_t>(max_locations_nearest))
     {
-        return Error("InvalidOptions", "Only one input coordinate is supported", json_result);
+        return Error("TooBig", "Too many nearest coordinates", result);
     }
 
+    if (!CheckAllCoordinates(params.coordinates))
+        return Error("InvalidOptions", "Coordinates are invalid", result);
+
+    if (params.coordinates.empty())
+        return Error("InvalidOptions", "At least one input coordinate is required", result);
+
     auto phantom_nodes = GetPhantomNodes(params, params.number_of_results);
+    BOOST_ASSERT(phantom_nodes.size() == params.coordinates.size());
 
-    if (phantom_nodes.front().size() == 0)
+    // With several coordinates the ones without a segment get an empty list of waypoints
+    if (phantom_nodes.size() == 1 && phantom_nodes.front().size() == 0)
     {
-        return Error("NoSegment", "Could not find a matching segments for coordinate", json_result);
+        return Error("NoSegment", "Could not find a matching segments for coordinate", result);
     }
-    BOOST_ASSERT(phantom_nodes.front().size() > 0);
 
     api::NearestAPI nearest_api(facade, params);
-    nearest_api.MakeResponse(phantom_nodes, json_result);
+    MakeResponse(nearest_api, phantom_nodes, result);
 
     return Status::Ok;
 }
+
+Status NearestPlugin::HandleRequest(const api::NearestParameters &params,
+                                    util::json::Object &result)
+{
+    return HandleNearestRequest(params, result);
+}
+
+Status NearestPlugin::HandleRequest(const api::NearestParameters &params,
+                                    std::vector<char> &result)
+{
+    return HandleNearestRequest(params, result);
+}
 }
 }
 }
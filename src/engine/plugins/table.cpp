@@ -5,12 +5,18 @@
 #include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/search_engine_data.hpp"
 #include "util/json_container.hpp"
+#include "util/integer_range.hpp"
+#include "util/json_writer.hpp"
+#include "util/simple_logger.hpp"
 #include "util/string_util.hpp"
 
+#include <cmath>
 #include <cstdlib>
 
 #include <algorithm>
+#include <future>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -23,13 +29,65 @@ namespace engine
 namespace plugins
 {
 
-TablePlugin::TablePlugin(datafacade::BaseDataFacade &facade, const int max_locations_distance_table)
-    : BasePlugin{facade}, distance_table(&facade, heaps),
-      max_locations_distance_table(max_locations_distance_table)
+namespace
 {
+void MakeResponse(const api::TableAPI &table_api,
+                  const std::vector<EdgeWeight> &durations,
+                  const std::vector<EdgeWeight> &distances,
+                  const std::vector<PhantomNode> &phantoms,
+                  util::json::Object &result)
+{
+    table_api.MakeResponse(durations, distances, phantoms, result);
 }
 
-Status TablePlugin::HandleRequest(const api::TableParameters &params, util::json::Object &result)
+void MakeResponse(const api::TableAPI &table_api,
+                  const std::vector<EdgeWeight> &durations,
+                  const std::vector<EdgeWeight> &distances,
+                  const std::vector<PhantomNode> &phantoms,
+                  std::vector<char> &result)
+{
+    if (table_api.parameters.format == api::TableParameters::OutputFormatType::Binary)
+    {
+        table_api.MakeBinaryResponse(durations, distances, phantoms, result);
+    }
+    else
+    {
+        util::json::Writer writer(result);
+        table_api.MakeResponse(durations, distances, phantoms, writer);
+    }
+}
+
+// Tenth of meters, the same fixed point the durations use, INVALID_EDGE_WEIGHT if unreachable
+std::vector<EdgeWeight> MakeDistances(const std::vector<EdgeLength> &lengths)
+{
+    std::vector<EdgeWeight> distances(lengths.size());
+    std::transform(
+        lengths.begin(), lengths.end(), distances.begin(), [](const EdgeLength length) {
+            if (length == INVALID_EDGE_LENGTH)
+            {
+                return INVALID_EDGE_WEIGHT;
+            }
+            // a path inside one segment can come out a rounding error below zero
+            return static_cast<EdgeWeight>(std::lround(std::max(length, 0.f) * 10));
+        });
+    return distances;
+}
+}
+
+TablePlugin::TablePlugin(datafacade::BaseDataFacade &facade,
+                         const int max_locations_distance_table,
+                         const bool use_parallel_table)
+    : BasePlugin{facade}, distance_table(&facade, heaps, use_parallel_table),
+      max_locations_distance_table(max_locations_distance_table), target_sets(MAX_TARGET_SETS)
+{
+}
+
+constexpr std::size_t TablePlugin::RESPONSE_CHUNK_SIZE;
+
+template <typename ResultT>
+Status TablePlugin::HandleTableRequest(const api::TableParameters &params,
+                                       ResultT &result,
+                                       const ChunkHandler &handle_chunk)
 {
     BOOST_ASSERT(params.IsValid());
 
@@ -44,12 +102,30 @@ Status TablePlugin::HandleRequest(const api::TableParameters &params, util::json
             "InvalidOptions", "Number of bearings does not match number of coordinates", result);
     }
 
+    std::shared_ptr<const TargetSet> target_set;
+    if (params.UsesTargetSet())
+    {
+        std::lock_guard<std::mutex> lock(target_sets_mutex);
+        if (const auto registered_set = target_sets.Get(params.target_set))
+        {
+            target_set = *registered_set;
+        }
+    }
+    if (params.UsesTargetSet() && !target_set)
+    {
+        return Error("NoTargetSet",
+                     "Target set " + params.target_set + " is not registered",
+                     result);
+    }
+
     // Empty sources or destinations means the user wants all of them included, respectively
     // The ManyToMany routing algorithm we dispatch to below already handles this perfectly.
     const auto num_sources =
         params.sources.empty() ? params.coordinates.size() : params.sources.size();
     const auto num_destinations =
-        params.destinations.empty() ? params.coordinates.size() : params.destinations.size();
+        target_set ? target_set->phantoms.size()
+                   : params.destinations.empty() ? params.coordinates.size()
+                                                 : params.destinations.size();
 
     if (max_locations_distance_table > 0 &&
         ((num_sources * num_destinations) >
@@ -58,19 +134,258 @@ Status TablePlugin::HandleRequest(const api::TableParameters &params, util::json
         return Error("TooBig", "Too many table coordinates", result);
     }
 
+    const bool with_distances =
+        params.HasAnnotation(api::TableParameters::AnnotationsType::Distance);
+    if (with_distances && !facade.HasEdgeLengths())
+    {
+        return Error("InvalidOptions",
+                     "Distances are not available for this dataset, run osrm-contract again",
+                     result);
+    }
+
     auto snapped_phantoms = SnapPhantomNodes(GetPhantomNodes(params));
-    auto result_table = distance_table(snapped_phantoms, params.sources, params.destinations);
+
+    if (params.target_set.empty())
+    {
+        api::TableAPI table_api{facade, params};
+        return MakeTable(table_api, snapped_phantoms, nullptr, result, handle_chunk);
+    }
+
+    if (!target_set)
+    {
+        auto registered_set = std::make_shared<TargetSet>();
+        for (const auto index : params.destinations)
+        {
+            registered_set->coordinates.push_back(params.coordinates[index]);
+            registered_set->phantoms.push_back(snapped_phantoms[index]);
+        }
+        registered_set->prepared = distance_table(registered_set->phantoms);
+
+        std::lock_guard<std::mutex> lock(target_sets_mutex);
+        target_sets.Put(params.target_set, registered_set);
+        target_set = std::move(registered_set);
+    }
+
+    // the destinations of the target set are appended to the coordinates of the request
+    api::TableParameters set_params = params;
+    if (set_params.sources.empty())
+    {
+        set_params.sources.resize(params.coordinates.size());
+        std::iota(set_params.sources.begin(), set_params.sources.end(), 0);
+    }
+    set_params.destinations.resize(target_set->coordinates.size());
+    std::iota(set_params.destinations.begin(),
+              set_params.destinations.end(),
+              params.coordinates.size());
+    set_params.coordinates.insert(set_params.coordinates.end(),
+                                  target_set->coordinates.begin(),
+                                  target_set->coordinates.end());
+    snapped_phantoms.insert(
+        snapped_phantoms.end(), target_set->phantoms.begin(), target_set->phantoms.end());
+
+    api::TableAPI table_api{facade, set_params};
+    return MakeTable(
+        table_api, snapped_phantoms, target_set->prepared.get(), result, handle_chunk);
+}
+
+std::vector<EdgeWeight>
+TablePlugin::ComputeTable(const api::TableParameters &params,
+                          const std::vector<PhantomNode> &phantoms,
+                          const routing_algorithms::OneToManyTargets *prepared_targets,
+                          std::vector<EdgeLength> *length_table) const
+{
+    if (prepared_targets)
+    {
+        return distance_table(phantoms, params.sources, *prepared_targets, length_table);
+    }
+    return distance_table(phantoms, params.sources, params.destinations, length_table);
+}
+
+Status TablePlugin::MakeTable(const api::TableAPI &table_api,
+                              const std::vector<PhantomNode> &phantoms,
+                              const routing_algorithms::OneToManyTargets *prepared_targets,
+                              util::json::Object &result,
+                              const ChunkHandler & /*handle_chunk*/) const
+{
+    const auto &params = table_api.parameters;
+    const bool with_distances =
+        params.HasAnnotation(api::TableParameters::AnnotationsType::Distance);
+
+    std::vector<EdgeLength> length_table;
+    auto result_table = ComputeTable(
+        params, phantoms, prepared_targets, with_distances ? &length_table : nullptr);
 
     if (result_table.empty())
     {
         return Error("NoTable", "No table found", result);
     }
 
-    api::TableAPI table_api{facade, params};
-    table_api.MakeResponse(result_table, snapped_phantoms, result);
+    MakeResponse(table_api, result_table, MakeDistances(length_table), phantoms, result);
 
     return Status::Ok;
 }
+
+Status TablePlugin::MakeTable(const api::TableAPI &table_api,
+                              const std::vector<PhantomNode> &phantoms,
+                              const routing_algorithms::OneToManyTargets *prepared_targets,
+                              std::vector<char> &result,
+                              const ChunkHandler &handle_chunk) const
+{
+    const auto &params = table_api.parameters;
+    const auto number_of_sources = table_api.NumberOfSources(phantoms);
+    const auto number_of_destinations = table_api.NumberOfDestinations(phantoms);
+    const auto number_of_entries = number_of_sources * number_of_destinations;
+    if (prepared_targets || number_of_entries <= TiledTable::TILE_ENTRIES)
+    {
+        const bool with_distances =
+            params.HasAnnotation(api::TableParameters::AnnotationsType::Distance);
+
+        std::vector<EdgeLength> length_table;
+        auto result_table = ComputeTable(
+            params, phantoms, prepared_targets, with_distances ? &length_table : nullptr);
+
+        if (result_table.empty())
+        {
+            return Error("NoTable", "No table found", result);
+        }
+
+        MakeResponse(table_api, result_table, MakeDistances(length_table), phantoms, result);
+
+        return Status::Ok;
+    }
+
+    const auto hand_out_chunk = [&] {
+        if (handle_chunk && result.size() >= RESPONSE_CHUNK_SIZE)
+        {
+            handle_chunk(result);
+            result.clear();
+        }
+    };
+
+    // Larger tables are rendered block by block of rows as the searches finish them, so neither
+    // the durations nor the buckets of all targets are in memory at once
+    const auto search_rows = [&](const std::vector<std::size_t> &sources,
+                                 const api::TableAPI::RowsHandler &handle_rows) {
+        distance_table(phantoms,
+                       sources,
+                       params.destinations,
+                       params.HasAnnotation(api::TableParameters::AnnotationsType::Distance),
+                       [&](const std::size_t /*first_row*/,
+                           const std::size_t number_of_rows,
+                           const std::vector<EdgeWeight> &durations,
+                           const std::vector<EdgeLength> &lengths) {
+                           handle_rows(durations, MakeDistances(lengths), number_of_rows);
+                           hand_out_chunk();
+                       });
+    };
+
+    // The sources of the largest tables are split into consecutive shards, the first one is
+    // searched here while the peers are asked for the others. A shard a peer fails to deliver
+    // is searched here after all.
+    const auto distribute_rows = [&](const api::TableAPI::RowsHandler &handle_rows) {
+        std::vector<std::size_t> sources = params.sources;
+        if (sources.empty())
+        {
+            sources.resize(phantoms.size());
+            std::iota(sources.begin(), sources.end(), 0);
+        }
+        const auto number_of_shards = table_peers->Size() + 1;
+        const auto shard_size = (sources.size() + number_of_shards - 1) / number_of_shards;
+        const auto shard_sources = [&](const std::size_t shard) {
+            const auto begin = std::min(sources.size(), shard * shard_size);
+            const auto end = std::min(sources.size(), begin + shard_size);
+            return std::vector<std::size_t>(sources.begin() + begin, sources.begin() + end);
+        };
+
+        // only the last shards can be empty, their peers are not asked
+        std::vector<std::future<boost::optional<TablePeers::Rows>>> peer_rows;
+        for (const auto peer : util::irange<std::size_t>(0UL, table_peers->Size()))
+        {
+            auto shard = shard_sources(peer + 1);
+            if (shard.empty())
+            {
+                break;
+            }
+            peer_rows.push_back(std::async(
+                std::launch::async, [this, &params, peer, sources = std::move(shard)] {
+                    return table_peers->FetchRows(peer, params, sources);
+                }));
+        }
+
+        search_rows(shard_sources(0), handle_rows);
+
+        // handed on in blocks like the searched rows, so the response is sent while rendered
+        const auto rows_per_block =
+            std::max<std::size_t>(1, TiledTable::TILE_ENTRIES / number_of_destinations);
+        for (const auto peer : util::irange<std::size_t>(0UL, peer_rows.size()))
+        {
+            const auto shard = shard_sources(peer + 1);
+            const auto rows = peer_rows[peer].get();
+            if (!rows)
+            {
+                util::SimpleLogger().Write(logWARNING) << "Table peer " << peer
+                                                       << " failed, searching its rows instead";
+                search_rows(shard, handle_rows);
+                continue;
+            }
+            for (std::size_t first_row = 0; first_row < shard.size(); first_row += rows_per_block)
+            {
+                const auto number_of_rows = std::min(rows_per_block, shard.size() - first_row);
+                const auto block = [&](const std::vector<EdgeWeight> &matrix) {
+                    return matrix.empty() ? matrix
+                                          : std::vector<EdgeWeight>(
+                                                matrix.begin() + first_row * number_of_destinations,
+                                                matrix.begin() + (first_row + number_of_rows) *
+                                                                     number_of_destinations);
+                };
+                handle_rows(block(rows->durations), block(rows->distances), number_of_rows);
+                hand_out_chunk();
+            }
+        }
+    };
+
+    const auto produce_rows = [&](const api::TableAPI::RowsHandler &handle_rows) {
+        if (params.distribute && table_peers && table_peers->Size() > 0 &&
+            number_of_entries >= TablePeers::MIN_DISTRIBUTED_ENTRIES &&
+            number_of_sources > table_peers->Size())
+        {
+            distribute_rows(handle_rows);
+        }
+        else
+        {
+            search_rows(params.sources, handle_rows);
+        }
+    };
+
+    if (params.format == api::TableParameters::OutputFormatType::Binary)
+    {
+        table_api.MakeBinaryResponse(produce_rows, phantoms, result);
+    }
+    else
+    {
+        util::json::Writer writer(result);
+        table_api.MakeResponse(produce_rows, phantoms, writer);
+    }
+
+    return Status::Ok;
+}
+
+Status TablePlugin::HandleRequest(const api::TableParameters &params, util::json::Object &result)
+{
+    return HandleTableRequest(params, result, {});
+}
+
+Status TablePlugin::HandleRequest(const api::TableParameters &params, std::vector<char> &result)
+{
+    return HandleTableRequest(params, result, {});
+}
+
+Status TablePlugin::HandleRequest(const api::TableParameters &params,
+                                  std::vector<char> &result,
+                                  const ChunkHandler &handle_chunk)
+{
+    return HandleTableRequest(params, result, handle_chunk);
+}
 }
 }
 }
@@ -2,9 +2,13 @@
 #include "engine/plugins/plugin_base.hpp"
 
 #include "util/coordinate_calculation.hpp"
+#include "util/integer_range.hpp"
+#include "util/rectangle.hpp"
+#include "util/string_view.hpp"
 #include "util/vector_tile.hpp"
 #include "util/web_mercator.hpp"
 
+#include <boost/functional/hash.hpp>
 #include <boost/geometry.hpp>
 #include <boost/geometry/geometries/geometries.hpp>
 #include <boost/geometry/geometries/point_xy.hpp>
@@ -13,6 +17,13 @@
 #include <protozero/pbf_writer.hpp>
 #include <protozero/varint.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -37,6 +48,23 @@ template <typename T> struct Point final
     const T y;
 };
 
+// Names by their characters, the views point into the data facade
+struct StringViewHash
+{
+    std::size_t operator()(const util::StringView view) const
+    {
+        return boost::hash_range(view.begin(), view.end());
+    }
+};
+
+struct StringViewEqual
+{
+    bool operator()(const util::StringView lhs, const util::StringView rhs) const
+    {
+        return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+};
+
 // from mapnik-vector-tile
 namespace pbf
 {
@@ -113,29 +141,36 @@ inline bool encodeLinestring(const FixedLine &line,
     return true;
 }
 
-FixedLine coordinatesToTileLine(const util::Coordinate start,
-                                const util::Coordinate target,
-                                const detail::BBox &tile_bbox)
+// valid tiles have z < 20 and x, y < 2^z, so 20 bits per coordinate suffice
+inline std::uint64_t tileKey(const unsigned z, const unsigned x, const unsigned y)
 {
-    FloatLine geo_line;
-    geo_line.emplace_back(static_cast<double>(util::toFloating(start.lon)),
-                          static_cast<double>(util::toFloating(start.lat)));
-    geo_line.emplace_back(static_cast<double>(util::toFloating(target.lon)),
-                          static_cast<double>(util::toFloating(target.lat)));
+    return (static_cast<std::uint64_t>(z) << 40) | (static_cast<std::uint64_t>(x) << 20) | y;
+}
+
+// Projects a coordinate into web mercator pixels
+point_t coordinateToMercator(const util::Coordinate coordinate)
+{
+    const double px_merc =
+        static_cast<double>(util::toFloating(coordinate.lon)) * util::web_mercator::DEGREE_TO_PX;
+    const double py_merc =
+        util::web_mercator::latToY(util::toFloating(coordinate.lat)) *
+        util::web_mercator::DEGREE_TO_PX;
+    return point_t(px_merc, py_merc);
+}
 
+FixedLine
+mercatorToTileLine(const point_t start, const point_t target, const detail::BBox &tile_bbox)
+{
     linestring_t unclipped_line;
 
-    for (auto const &pt : geo_line)
+    for (auto const &pt : {start, target})
     {
-        double px_merc = pt.x * util::web_mercator::DEGREE_TO_PX;
-        double py_merc = util::web_mercator::latToY(util::FloatLatitude{pt.y}) *
-                         util::web_mercator::DEGREE_TO_PX;
-        // convert lon/lat to tile coordinates
+        // convert mercator pixels to tile coordinates
         const auto px = std::round(
-            ((px_merc - tile_bbox.minx) * util::web_mercator::TILE_SIZE / tile_bbox.width()) *
+            ((pt.get<0>() - tile_bbox.minx) * util::web_mercator::TILE_SIZE / tile_bbox.width()) *
             util::vector_tile::EXTENT / util::web_mercator::TILE_SIZE);
         const auto py = std::round(
-            ((tile_bbox.maxy - py_merc) * util::web_mercator::TILE_SIZE / tile_bbox.height()) *
+            ((tile_bbox.maxy - pt.get<1>()) * util::web_mercator::TILE_SIZE / tile_bbox.height()) *
             util::vector_tile::EXTENT / util::web_mercator::TILE_SIZE);
 
         boost::geometry::append(unclipped_line, point_t(px, py));
@@ -162,100 +197,195 @@ FixedLine coordinatesToTileLine(const util::Coordinate start,
 
     return tile_line;
 }
-}
 
-Status TilePlugin::HandleRequest(const api::TileParameters &parameters, std::string &pbf_buffer)
+// Everything the speeds layer needs of one direction of a segment
+struct DirectedSegmentFeature
 {
-    BOOST_ASSERT(parameters.IsValid());
+    // false if the segment has no geometry in this direction
+    bool valid = false;
+    // true if the direction is encoded into the tiles
+    bool encoded = false;
+    int weight = 0;
+    std::uint8_t datasource = 0;
+    std::uint32_t speed_kmh = 0;
+};
 
-    double min_lon, min_lat, max_lon, max_lat;
+// A segment of the box query, prepared once for all tiles it is encoded into
+struct SegmentFeature
+{
+    DirectedSegmentFeature forward;
+    DirectedSegmentFeature reverse;
+    // the bounding box the box query tests against
+    util::RectangleInt2D bbox;
+    // the end points in web mercator pixels
+    point_t source;
+    point_t target;
+};
 
-    // Convert the z,x,y mercator tile coordinates into WGS84 lon/lat values
-    util::web_mercator::xyzToWGS84(
-        parameters.x, parameters.y, parameters.z, min_lon, min_lat, max_lon, max_lat);
+// The lines of a segment clipped against one tile, empty if the direction is not encoded
+struct SegmentTileLines
+{
+    FixedLine forward;
+    FixedLine reverse;
+};
 
-    util::Coordinate southwest{util::FloatLongitude{min_lon}, util::FloatLatitude{min_lat}};
-    util::Coordinate northeast{util::FloatLongitude{max_lon}, util::FloatLatitude{max_lat}};
+using TileEdges = std::vector<datafacade::BaseDataFacade::RTreeLeaf>;
 
-    // Fetch all the segments that are in our bounding box.
-    // This hits the OSRM StaticRTree
-    const auto edges = facade.GetEdgesInBox(southwest, northeast);
+// Looking up the weights and projecting the coordinates is independent per segment, so it runs
+// in parallel. Every facade lookup of a segment happens here exactly once, no matter how many
+// tiles the segment is encoded into.
+std::vector<SegmentFeature> prepareSegments(const datafacade::BaseDataFacade &facade,
+                                            const TileEdges &edges)
+{
+    std::vector<SegmentFeature> features(edges.size());
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, edges.size(), 64),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                const auto &edge = edges[index];
+                auto &feature = features[index];
+
+                if (edge.forward_packed_geometry_id != SPECIAL_EDGEID)
+                {
+                    const auto forward_weights =
+                        facade.GetUncompressedWeightsView(edge.forward_packed_geometry_id);
+                    const auto forward_datasources =
+                        facade.GetUncompressedDatasourcesView(edge.forward_packed_geometry_id);
+
+                    feature.forward.valid = true;
+                    feature.forward.weight = forward_weights[edge.fwd_segment_position];
+                    feature.forward.datasource = forward_datasources[edge.fwd_segment_position];
+                }
+
+                if (edge.reverse_packed_geometry_id != SPECIAL_EDGEID)
+                {
+                    const auto reverse_weights =
+                        facade.GetUncompressedWeightsView(edge.reverse_packed_geometry_id);
+                    const auto reverse_datasources =
+                        facade.GetUncompressedDatasourcesView(edge.reverse_packed_geometry_id);
+
+                    BOOST_ASSERT(edge.fwd_segment_position < reverse_weights.size());
+
+                    feature.reverse.valid = true;
+                    feature.reverse.weight =
+                        reverse_weights[reverse_weights.size() - edge.fwd_segment_position - 1];
+                    feature.reverse.datasource =
+                        reverse_datasources[reverse_datasources.size() -
+                                            edge.fwd_segment_position - 1];
+                }
+
+                feature.forward.encoded =
+                    feature.forward.weight != 0 && edge.forward_segment_id.enabled;
+                feature.reverse.encoded =
+                    feature.reverse.weight != 0 && edge.reverse_segment_id.enabled;
+
+                // Get coordinates for start/end nodes of segmet (NodeIDs u and v)
+                const auto a = facade.GetCoordinateOfNode(edge.u);
+                const auto b = facade.GetCoordinateOfNode(edge.v);
+                feature.bbox = util::RectangleInt2D{std::min(a.lon, b.lon),
+                                                    std::max(a.lon, b.lon),
+                                                    std::min(a.lat, b.lat),
+                                                    std::max(a.lat, b.lat)};
+                feature.source = coordinateToMercator(a);
+                feature.target = coordinateToMercator(b);
+
+                // Calculate the length in meters
+                const double length = osrm::util::coordinate_calculation::haversineDistance(a, b);
+                if (feature.forward.encoded)
+                {
+                    feature.forward.speed_kmh = static_cast<std::uint32_t>(
+                        round(length / feature.forward.weight * 10 * 3.6));
+                }
+                if (feature.reverse.encoded)
+                {
+                    feature.reverse.speed_kmh = static_cast<std::uint32_t>(
+                        round(length / feature.reverse.weight * 10 * 3.6));
+                }
+            }
+        });
+    return features;
+}
+
+// Encodes the speeds layer of a tile from the given prepared segments
+void encodeTile(const datafacade::BaseDataFacade &facade,
+                const TileEdges &edges,
+                const std::vector<SegmentFeature> &features,
+                const std::vector<std::size_t> &segments,
+                const detail::BBox &tile_bbox,
+                std::string &pbf_buffer)
+{
+    // Clipping the lines against the tile is the bulk of the work left
+    std::vector<SegmentTileLines> tile_lines(segments.size());
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, segments.size(), 64),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          for (auto index = range.begin(); index != range.end(); ++index)
+                          {
+                              const auto &feature = features[segments[index]];
+                              if (feature.forward.encoded)
+                              {
+                                  tile_lines[index].forward = mercatorToTileLine(
+                                      feature.source, feature.target, tile_bbox);
+                              }
+                              // Repeat the above for the coordinates reversed
+                              if (feature.reverse.encoded)
+                              {
+                                  tile_lines[index].reverse = mercatorToTileLine(
+                                      feature.target, feature.source, tile_bbox);
+                              }
+                          }
+                      });
 
     std::vector<int> used_weights;
     std::unordered_map<int, std::size_t> weight_offsets;
     uint8_t max_datasource_id = 0;
-    std::vector<std::string> names;
-    std::unordered_map<std::string, std::size_t> name_offsets;
+    std::vector<util::StringView> names;
+    std::unordered_map<util::StringView,
+                       std::size_t,
+                       detail::StringViewHash,
+                       detail::StringViewEqual>
+        name_offsets;
+    // names are only looked up once per name id, the edges refer to them through this
+    std::unordered_map<unsigned, std::size_t> name_id_offsets;
 
     // Loop over all edges once to tally up all the attributes we'll need.
     // We need to do this so that we know the attribute offsets to use
-    // when we encode each feature in the tile.
-    for (const auto &edge : edges)
-    {
-        int forward_weight = 0, reverse_weight = 0;
-        uint8_t forward_datasource = 0;
-        uint8_t reverse_datasource = 0;
-
-        if (edge.forward_packed_geometry_id != SPECIAL_EDGEID)
+    // when we encode each feature in the tile. This runs in edge order, so the
+    // offsets do not depend on the scheduling of the passes above.
+    const auto add_weight = [&](const detail::DirectedSegmentFeature &feature) {
+        if (feature.valid && weight_offsets.find(feature.weight) == weight_offsets.end())
         {
-            std::vector<EdgeWeight> forward_weight_vector;
-            facade.GetUncompressedWeights(edge.forward_packed_geometry_id, forward_weight_vector);
-            forward_weight = forward_weight_vector[edge.fwd_segment_position];
-
-            std::vector<uint8_t> forward_datasource_vector;
-            facade.GetUncompressedDatasources(edge.forward_packed_geometry_id,
-                                              forward_datasource_vector);
-            forward_datasource = forward_datasource_vector[edge.fwd_segment_position];
-
-            if (weight_offsets.find(forward_weight) == weight_offsets.end())
-            {
-                used_weights.push_back(forward_weight);
-                weight_offsets[forward_weight] = used_weights.size() - 1;
-            }
+            used_weights.push_back(feature.weight);
+            weight_offsets[feature.weight] = used_weights.size() - 1;
         }
+    };
+    for (const auto segment : segments)
+    {
+        const auto &edge = edges[segment];
+        const auto &feature = features[segment];
 
-        if (edge.reverse_packed_geometry_id != SPECIAL_EDGEID)
-        {
-            std::vector<EdgeWeight> reverse_weight_vector;
-            facade.GetUncompressedWeights(edge.reverse_packed_geometry_id, reverse_weight_vector);
-
-            BOOST_ASSERT(edge.fwd_segment_position < reverse_weight_vector.size());
-
-            reverse_weight =
-                reverse_weight_vector[reverse_weight_vector.size() - edge.fwd_segment_position - 1];
+        add_weight(feature.forward);
+        add_weight(feature.reverse);
 
-            if (weight_offsets.find(reverse_weight) == weight_offsets.end())
-            {
-                used_weights.push_back(reverse_weight);
-                weight_offsets[reverse_weight] = used_weights.size() - 1;
-            }
-            std::vector<uint8_t> reverse_datasource_vector;
-            facade.GetUncompressedDatasources(edge.reverse_packed_geometry_id,
-                                              reverse_datasource_vector);
-            reverse_datasource = reverse_datasource_vector[reverse_datasource_vector.size() -
-                                                           edge.fwd_segment_position - 1];
-        }
         // Keep track of the highest datasource seen so that we don't write unnecessary
         // data to the layer attribute values
-        max_datasource_id = std::max(max_datasource_id, forward_datasource);
-        max_datasource_id = std::max(max_datasource_id, reverse_datasource);
-
-        std::string name = facade.GetNameForID(edge.name_id);
+        max_datasource_id = std::max(max_datasource_id, feature.forward.datasource);
+        max_datasource_id = std::max(max_datasource_id, feature.reverse.datasource);
 
-        if (name_offsets.find(name) == name_offsets.end())
+        if (name_id_offsets.find(edge.name_id) == name_id_offsets.end())
         {
-            names.push_back(name);
-            name_offsets[name] = names.size() - 1;
+            const auto name = facade.GetNameViewForID(edge.name_id);
+            const auto name_offset = name_offsets.emplace(name, names.size()).first;
+            if (name_offset->second == names.size())
+            {
+                names.push_back(name);
+            }
+            name_id_offsets[edge.name_id] = name_offset->second;
         }
     }
 
     // TODO: extract speed values for compressed and uncompressed geometries
 
-    // Convert tile coordinates into mercator coordinates
-    util::web_mercator::xyzToMercator(
-        parameters.x, parameters.y, parameters.z, min_lon, min_lat, max_lon, max_lat);
-    const detail::BBox tile_bbox{min_lon, min_lat, max_lon, max_lat};
-
     // Protobuf serialized blocks when objects go out of scope, hence
     // the extra scoping below.
     protozero::pbf_writer tile_writer{pbf_buffer};
@@ -275,70 +405,29 @@ Status TilePlugin::HandleRequest(const api::TileParameters &parameters, std::str
         {
             // Each feature gets a unique id, starting at 1
             unsigned id = 1;
-            for (const auto &edge : edges)
+            for (const auto index : util::irange<std::size_t>(0, segments.size()))
             {
-                // Get coordinates for start/end nodes of segmet (NodeIDs u and v)
-                const auto a = facade.GetCoordinateOfNode(edge.u);
-                const auto b = facade.GetCoordinateOfNode(edge.v);
-                // Calculate the length in meters
-                const double length = osrm::util::coordinate_calculation::haversineDistance(a, b);
-
-                int forward_weight = 0;
-                int reverse_weight = 0;
-
-                uint8_t forward_datasource = 0;
-                uint8_t reverse_datasource = 0;
-
-                std::string name = facade.GetNameForID(edge.name_id);
-
-                if (edge.forward_packed_geometry_id != SPECIAL_EDGEID)
-                {
-                    std::vector<EdgeWeight> forward_weight_vector;
-                    facade.GetUncompressedWeights(edge.forward_packed_geometry_id,
-                                                  forward_weight_vector);
-                    forward_weight = forward_weight_vector[edge.fwd_segment_position];
-
-                    std::vector<uint8_t> forward_datasource_vector;
-                    facade.GetUncompressedDatasources(edge.forward_packed_geometry_id,
-                                                      forward_datasource_vector);
-                    forward_datasource = forward_datasource_vector[edge.fwd_segment_position];
-                }
-
-                if (edge.reverse_packed_geometry_id != SPECIAL_EDGEID)
-                {
-                    std::vector<EdgeWeight> reverse_weight_vector;
-                    facade.GetUncompressedWeights(edge.reverse_packed_geometry_id,
-                                                  reverse_weight_vector);
-
-                    BOOST_ASSERT(edge.fwd_segment_position < reverse_weight_vector.size());
-
-                    reverse_weight = reverse_weight_vector[reverse_weight_vector.size() -
-                                                           edge.fwd_segment_position - 1];
-
-                    std::vector<uint8_t> reverse_datasource_vector;
-                    facade.GetUncompressedDatasources(edge.reverse_packed_geometry_id,
-                                                      reverse_datasource_vector);
-                    reverse_datasource =
-                        reverse_datasource_vector[reverse_datasource_vector.size() -
-                                                  edge.fwd_segment_position - 1];
-                }
-
-                // Keep track of the highest datasource seen so that we don't write unnecessary
-                // data to the layer attribute values
-                max_datasource_id = std::max(max_datasource_id, forward_datasource);
-                max_datasource_id = std::max(max_datasource_id, reverse_datasource);
+                const auto &edge = edges[segments[index]];
+                const auto &feature = features[segments[index]];
+                const auto name_offset = name_id_offsets[edge.name_id];
 
                 const auto encode_tile_line = [&layer_writer,
                                                &edge,
                                                &id,
                                                &max_datasource_id,
-                                               &used_weights](const detail::FixedLine &tile_line,
-                                                              const std::uint32_t speed_kmh,
-                                                              const std::size_t duration,
-                                                              const std::uint8_t datasource,
-                                                              const std::size_t name,
-                                                              std::int32_t &start_x,
-                                                              std::int32_t &start_y) {
+                                               &used_weights,
+                                               &weight_offsets,
+                                               name_offset](
+                    const detail::DirectedSegmentFeature &feature,
+                    const detail::FixedLine &tile_line) {
+                    if (tile_line.empty())
+                    {
+                        return;
+                    }
+                    std::int32_t start_x = 0;
+                    std::int32_t start_y = 0;
+                    const std::size_t duration = weight_offsets[feature.weight];
+
                     // Here, we save the two attributes for our feature: the speed and the
                     // is_small
                     // boolean.  We onl serve up speeds from 0-139, so all we do is save the
@@ -362,20 +451,20 @@ Status TilePlugin::HandleRequest(const api::TileParameters &parameters, std::str
                             feature_writer, util::vector_tile::FEATURE_ATTRIBUTES_TAG);
 
                         field.add_element(0); // "speed" tag key offset
-                        field.add_element(
-                            std::min(speed_kmh, 127u)); // save the speed value, capped at 127
-                        field.add_element(1);           // "is_small" tag key offset
+                        field.add_element(std::min(feature.speed_kmh,
+                                                   127u)); // save the speed value, capped at 127
+                        field.add_element(1);              // "is_small" tag key offset
                         field.add_element(128 +
                                           (edge.component.is_tiny ? 0 : 1)); // is_small feature
-                        field.add_element(2);                // "datasource" tag key offset
-                        field.add_element(130 + datasource); // datasource value offset
-                        field.add_element(3);                // "duration" tag key offset
+                        field.add_element(2);                        // "datasource" tag key offset
+                        field.add_element(130 + feature.datasource); // datasource value offset
+                        field.add_element(3);                        // "duration" tag key offset
                         field.add_element(130 + max_datasource_id + 1 +
                                           duration); // duration value offset
                         field.add_element(4);        // "name" tag key offset
 
                         field.add_element(130 + max_datasource_id + 1 + used_weights.size() +
-                                          name); // name value offset
+                                          name_offset); // name value offset
                     }
                     {
 
@@ -386,52 +475,8 @@ Status TilePlugin::HandleRequest(const api::TileParameters &parameters, std::str
                     }
                 };
 
-                // If this is a valid forward edge, go ahead and add it to the tile
-                if (forward_weight != 0 && edge.forward_segment_id.enabled)
-                {
-                    std::int32_t start_x = 0;
-                    std::int32_t start_y = 0;
-
-                    // Calculate the speed for this line
-                    std::uint32_t speed_kmh =
-                        static_cast<std::uint32_t>(round(length / forward_weight * 10 * 3.6));
-
-                    auto tile_line = coordinatesToTileLine(a, b, tile_bbox);
-                    if (!tile_line.empty())
-                    {
-                        encode_tile_line(tile_line,
-                                         speed_kmh,
-                                         weight_offsets[forward_weight],
-                                         forward_datasource,
-                                         name_offsets[name],
-                                         start_x,
-                                         start_y);
-                    }
-                }
-
-                // Repeat the above for the coordinates reversed and using the `reverse`
-                // properties
-                if (reverse_weight != 0 && edge.reverse_segment_id.enabled)
-                {
-                    std::int32_t start_x = 0;
-                    std::int32_t start_y = 0;
-
-                    // Calculate the speed for this line
-                    std::uint32_t speed_kmh =
-                        static_cast<std::uint32_t>(round(length / reverse_weight * 10 * 3.6));
-
-                    auto tile_line = coordinatesToTileLine(b, a, tile_bbox);
-                    if (!tile_line.empty())
-                    {
-                        encode_tile_line(tile_line,
-                                         speed_kmh,
-                                         weight_offsets[reverse_weight],
-                                         reverse_datasource,
-                                         name_offsets[name],
-                                         start_x,
-                                         start_y);
-                    }
-                }
+                encode_tile_line(feature.forward, tile_lines[index].forward);
+                encode_tile_line(feature.reverse, tile_lines[index].reverse);
             }
         }
 
@@ -487,9 +532,123 @@ Status TilePlugin::HandleRequest(const api::TileParameters &parameters, std::str
             // Writing field type 4 == variant type
             protozero::pbf_writer values_writer(layer_writer, util::vector_tile::VARIANT_TAG);
             // Attribute value 1 == string type
-            values_writer.add_string(util::vector_tile::VARIANT_TYPE_STRING, name);
+            values_writer.add_string(
+                util::vector_tile::VARIANT_TYPE_STRING, name.begin(), name.size());
+        }
+    }
+
+}
+}
+
+Status TilePlugin::HandleRequest(const api::TileParameters &parameters, std::string &pbf_buffer)
+{
+    BOOST_ASSERT(parameters.IsValid());
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        const auto key = detail::tileKey(parameters.z, parameters.x, parameters.y);
+        if (const auto cached = cache.Get(key))
+        {
+            pbf_buffer = *cached;
+            return Status::Ok;
+        }
+    }
+
+    // The metatile is the aligned block of tiles that contains the requested one. There are only
+    // 2^z tiles per row and column, and the cache has to be able to hold all of them.
+    const unsigned tiles_per_row = 1u << parameters.z;
+    const unsigned size = metatile_size * metatile_size <= cache_size
+                              ? std::min(metatile_size, tiles_per_row)
+                              : 1;
+    const unsigned min_x = parameters.x / size * size;
+    const unsigned min_y = parameters.y / size * size;
+
+    // concurrent requests for the same tile may encode it twice, which is harmless
+    std::vector<std::string> pbf_buffers;
+    const auto status = EncodeTiles(parameters.z, min_x, min_y, size, pbf_buffers);
+    if (status != Status::Ok)
+    {
+        return status;
+    }
+
+    pbf_buffer = pbf_buffers[(parameters.y - min_y) * size + (parameters.x - min_x)];
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    for (const auto y : util::irange(0u, size))
+    {
+        for (const auto x : util::irange(0u, size))
+        {
+            cache.Put(detail::tileKey(parameters.z, min_x + x, min_y + y),
+                      std::move(pbf_buffers[y * size + x]));
         }
     }
+    return status;
+}
+
+Status TilePlugin::EncodeTiles(const unsigned z,
+                               const unsigned min_x,
+                               const unsigned min_y,
+                               const unsigned size,
+                               std::vector<std::string> &pbf_buffers)
+{
+    // Convert the z,x,y mercator tile coordinates into WGS84 lon/lat values
+    const auto tile_box = [z](const unsigned x, const unsigned y) {
+        double min_lon, min_lat, max_lon, max_lat;
+        util::web_mercator::xyzToWGS84(x, y, z, min_lon, min_lat, max_lon, max_lat);
+        return util::RectangleInt2D{util::FloatLongitude{min_lon},
+                                    util::FloatLongitude{max_lon},
+                                    util::FloatLatitude{min_lat},
+                                    util::FloatLatitude{max_lat}};
+    };
+
+    // Fetch all the segments that are in the bounding box of all tiles at once.
+    // This hits the OSRM StaticRTree
+    auto metatile_box = tile_box(min_x, min_y);
+    metatile_box.MergeBoundingBoxes(tile_box(min_x + size - 1, min_y + size - 1));
+    const util::Coordinate southwest{metatile_box.min_lon, metatile_box.min_lat};
+    const util::Coordinate northeast{metatile_box.max_lon, metatile_box.max_lat};
+    const auto edges = facade.GetEdgesInBox(southwest, northeast);
+
+    const auto features = detail::prepareSegments(facade, edges);
+
+    pbf_buffers.clear();
+    pbf_buffers.resize(size * size);
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, size * size, 1),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                const unsigned x = min_x + index % size;
+                const unsigned y = min_y + index / size;
+
+                // the segments the box query of this tile alone would have returned
+                std::vector<std::size_t> segments;
+                if (size == 1)
+                {
+                    segments.resize(edges.size());
+                    std::iota(segments.begin(), segments.end(), 0);
+                }
+                else
+                {
+                    const auto box = tile_box(x, y);
+                    for (const auto segment : util::irange<std::size_t>(0, edges.size()))
+                    {
+                        if (features[segment].bbox.Intersects(box))
+                        {
+                            segments.push_back(segment);
+                        }
+                    }
+                }
+
+                // Convert tile coordinates into mercator coordinates
+                double min_lon, min_lat, max_lon, max_lat;
+                util::web_mercator::xyzToMercator(x, y, z, min_lon, min_lat, max_lon, max_lat);
+                const detail::BBox tile_bbox{min_lon, min_lat, max_lon, max_lat};
+
+                detail::encodeTile(
+                    facade, edges, features, segments, tile_bbox, pbf_buffers[index]);
+            }
+        });
 
     return Status::Ok;
 }
@@ -1,18 +1,22 @@
 #include "engine/plugins/trip.hpp"
 
-#include "extractor/tarjan_scc.hpp"
+#include "extractor/matrix_scc.hpp"
 
 #include "engine/api/trip_api.hpp"
 #include "engine/api/trip_parameters.hpp"
+#include "engine/query_deadline.hpp"
 #include "engine/trip/trip_brute_force.hpp"
 #include "engine/trip/trip_farthest_insertion.hpp"
+#include "engine/trip/trip_local_search.hpp"
 #include "engine/trip/trip_nearest_neighbour.hpp"
 #include "util/dist_table_wrapper.hpp" // to access the dist table more easily
 #include "util/json_container.hpp"
-#include "util/matrix_graph_wrapper.hpp" // wrapper to use tarjan scc on dist table
 
 #include <boost/assert.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <algorithm>
 #include <cstdlib>
 #include <iterator>
@@ -80,11 +84,8 @@ SCC_Component SplitUnaccessibleLocations(const std::size_t number_of_locations,
         return SCC_Component(std::move(location_ids), std::move(range));
     }
 
-    // Run TarjanSCC
-    auto wrapper = std::make_shared<util::MatrixGraphWrapper<EdgeWeight>>(result_table.GetTable(),
-                                                                          number_of_locations);
-    auto scc = extractor::TarjanSCC<util::MatrixGraphWrapper<EdgeWeight>>(wrapper);
-    scc.Run();
+    extractor::MatrixSCC scc;
+    scc.Run(result_table);
 
     const auto number_of_components = scc.GetNumberOfComponents();
 
@@ -134,7 +135,7 @@ InternalRouteResult TripPlugin::ComputeRoute(const std::vector<PhantomNode> &sna
     }
     BOOST_ASSERT(min_route.segment_end_coordinates.size() == trip.size());
 
-    shortest_path(min_route.segment_end_coordinates, {false}, min_route);
+    shortest_path(min_route.segment_end_coordinates, boost::optional<bool>(false), min_route);
 
     BOOST_ASSERT_MSG(min_route.shortest_path_length < INVALID_EDGE_WEIGHT, "unroutable route");
     return min_route;
@@ -171,68 +172,80 @@ Status TripPlugin::HandleRequest(const api::TripParameters &parameters,
 
     const auto number_of_locations = snapped_phantoms.size();
 
-    // compute the duration table of all phantom nodes
+    // compute the duration table of all phantom nodes, empty index lists select all of them
+    const std::vector<std::size_t> all_phantoms;
     const auto result_table = util::DistTableWrapper<EdgeWeight>(
-        duration_table(snapped_phantoms, {}, {}), number_of_locations);
+        duration_table(snapped_phantoms, all_phantoms, all_phantoms), number_of_locations);
 
     if (result_table.size() == 0)
     {
         return Status::Error;
     }
 
-    const constexpr std::size_t BF_MAX_FEASABLE = 10;
+    // the branch and bound of BruteForceTrip solves up to 12 locations in parallel
+    const constexpr std::size_t BF_MAX_FEASABLE = 13;
     BOOST_ASSERT_MSG(result_table.size() == number_of_locations * number_of_locations,
                      "Distance Table has wrong size");
 
     // get scc components
     SCC_Component scc = SplitUnaccessibleLocations(number_of_locations, result_table);
 
-    std::vector<std::vector<NodeID>> trips;
-    trips.reserve(scc.GetNumberOfComponents());
-    // run Trip computation for every SCC
-    for (std::size_t k = 0; k < scc.GetNumberOfComponents(); ++k)
-    {
-        const auto component_size = scc.range[k + 1] - scc.range[k];
-
-        BOOST_ASSERT_MSG(component_size > 0, "invalid component size");
-
-        std::vector<NodeID> scc_route;
-        auto route_begin = std::begin(scc.component) + scc.range[k];
-        auto route_end = std::begin(scc.component) + scc.range[k + 1];
-
-        if (component_size > 1)
-        {
-
-            if (component_size < BF_MAX_FEASABLE)
+    // components do not share any locations, so their trips are solved independently
+    std::vector<std::vector<NodeID>> trips(scc.GetNumberOfComponents());
+    const auto *const deadline = ActiveQueryDeadline();
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, scc.GetNumberOfComponents(), 1),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            const QueryDeadlineScope deadline_scope(deadline);
+            for (auto k = range.begin(); k != range.end(); ++k)
             {
-                scc_route =
-                    trip::BruteForceTrip(route_begin, route_end, number_of_locations, result_table);
+                const auto component_size = scc.range[k + 1] - scc.range[k];
+
+                BOOST_ASSERT_MSG(component_size > 0, "invalid component size");
+
+                auto route_begin = std::begin(scc.component) + scc.range[k];
+                auto route_end = std::begin(scc.component) + scc.range[k + 1];
+
+                if (component_size > 1)
+                {
+                    if (component_size < BF_MAX_FEASABLE)
+                    {
+                        trips[k] = trip::BruteForceTrip(
+                            route_begin, route_end, number_of_locations, result_table);
+                    }
+                    else
+                    {
+                        trips[k] = trip::FarthestInsertionTrip(
+                            route_begin, route_end, number_of_locations, result_table);
+                        if (max_optimization_time.count() > 0)
+                        {
+                            trips[k] = trip::LocalSearchTrip(
+                                trips[k], result_table, max_optimization_time);
+                        }
+                    }
+                }
+                else
+                {
+                    trips[k] = std::vector<NodeID>(route_begin, route_end);
+                }
             }
-            else
-            {
-                scc_route = trip::FarthestInsertionTrip(
-                    route_begin, route_end, number_of_locations, result_table);
-            }
-        }
-        else
-        {
-            scc_route = std::vector<NodeID>(route_begin, route_end);
-        }
-
-        trips.push_back(std::move(scc_route));
-    }
+        });
     if (trips.empty())
     {
         return Error("NoTrips", "Cannot find trips", json_result);
     }
 
-    // compute all round trip routes
-    std::vector<InternalRouteResult> routes;
-    routes.reserve(trips.size());
-    for (const auto &trip : trips)
-    {
-        routes.push_back(ComputeRoute(snapped_phantoms, trip));
-    }
+    // compute all round trip routes, every trip is routed by one query over all of its legs
+    // and the query heaps are thread local
+    std::vector<InternalRouteResult> routes(trips.size());
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, trips.size(), 1),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          const QueryDeadlineScope deadline_scope(deadline);
+                          for (auto k = range.begin(); k != range.end(); ++k)
+                          {
+                              routes[k] = ComputeRoute(snapped_phantoms, trips[k]);
+                          }
+                      });
 
     api::TripAPI trip_api{BasePlugin::facade, parameters};
     trip_api.MakeResponse(trips, routes, snapped_phantoms, json_result);
@@ -1,16 +1,23 @@
 #include "engine/plugins/viaroute.hpp"
 #include "engine/api/route_api.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
+#include "engine/query_deadline.hpp"
 #include "engine/status.hpp"
+#include "engine/time_slot.hpp"
 
 #include "util/for_each_pair.hpp"
+#include "util/hilbert_value.hpp"
 #include "util/integer_range.hpp"
 #include "util/json_container.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <cstdlib>
 
 #include <algorithm>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -21,14 +28,23 @@ namespace engine
 namespace plugins
 {
 
-ViaRoutePlugin::ViaRoutePlugin(datafacade::BaseDataFacade &facade_, int max_locations_viaroute)
-    : BasePlugin(facade_), shortest_path(&facade_, heaps), alternative_path(&facade_, heaps),
-      direct_shortest_path(&facade_, heaps), max_locations_viaroute(max_locations_viaroute)
+ViaRoutePlugin::ViaRoutePlugin(datafacade::BaseDataFacade &facade_,
+                               int max_locations_viaroute,
+                               bool use_multi_level_dijkstra,
+                               std::size_t max_alternative_candidates,
+                               bool use_parallel_route)
+    : BasePlugin(facade_), shortest_path(&facade_, heaps, use_parallel_route),
+      alternative_path(&facade_, heaps, max_alternative_candidates),
+      penalty_alternative_path(&facade_, heaps),
+      direct_shortest_path(&facade_, heaps), multi_level_dijkstra(&facade_, heaps),
+      max_locations_viaroute(max_locations_viaroute),
+      use_multi_level_dijkstra(use_multi_level_dijkstra), use_parallel_route(use_parallel_route)
 {
 }
 
 Status ViaRoutePlugin::HandleRequest(const api::RouteParameters &route_parameters,
-                                     util::json::Object &json_result)
+                                     util::json::Object &json_result,
+                                     const SnappedCoordinates *snapped)
 {
     BOOST_ASSERT(route_parameters.IsValid());
 
@@ -47,7 +63,54 @@ Status ViaRoutePlugin::HandleRequest(const api::RouteParameters &route_parameter
         return Error("InvalidValue", "Invalid coordinate value.", json_result);
     }
 
-    auto phantom_node_pairs = GetPhantomNodes(route_parameters);
+    unsigned time_slot = INVALID_TIME_SLOT;
+    if (route_parameters.departure_time)
+    {
+        if (facade.GetNumberOfTimeSlots() == 0 || use_multi_level_dijkstra)
+        {
+            return Error("InvalidValue",
+                         "departure_time needs a dataset with time slots and no overlay graphs.",
+                         json_result);
+        }
+        time_slot = (*route_parameters.departure_time / facade.GetTimeSlotDuration()) %
+                    facade.GetNumberOfTimeSlots();
+    }
+    if (route_parameters.metric > 0)
+    {
+        if (route_parameters.metric > facade.GetNumberOfMetrics() ||
+            route_parameters.departure_time || use_multi_level_dijkstra)
+        {
+            return Error("InvalidValue",
+                         "metric needs a dataset with that many metrics, no departure_time and no "
+                         "overlay graphs.",
+                         json_result);
+        }
+        time_slot = MetricTimeSlot(facade.GetNumberOfTimeSlots(), route_parameters.metric);
+    }
+    if (route_parameters.exclude != EDGE_CLASS_NONE)
+    {
+        unsigned exclude_metric = 0;
+        for (unsigned metric = 1; metric <= facade.GetNumberOfMetrics(); ++metric)
+        {
+            if (facade.GetExcludedClasses(metric) == route_parameters.exclude)
+            {
+                exclude_metric = metric;
+            }
+        }
+        if (exclude_metric == 0 || route_parameters.metric > 0 || route_parameters.departure_time ||
+            use_multi_level_dijkstra)
+        {
+            return Error("InvalidValue",
+                         "exclude needs a dataset contracted with these --exclude-classes, no "
+                         "metric, no departure_time and no overlay graphs.",
+                         json_result);
+        }
+        time_slot = MetricTimeSlot(facade.GetNumberOfTimeSlots(), exclude_metric);
+    }
+    // snapping and routing both see the weights of the departure slot or of the metric
+    const TimeSlotScope time_slot_scope(time_slot);
+
+    auto phantom_node_pairs = GetPhantomNodes(route_parameters, snapped);
     if (phantom_node_pairs.size() != route_parameters.coordinates.size())
     {
         return Error("NoSegment",
@@ -83,11 +146,55 @@ Status ViaRoutePlugin::HandleRequest(const api::RouteParameters &route_parameter
     };
     util::for_each_pair(snapped_phantoms, build_phantom_pairs);
 
-    if (1 == raw_route.segment_end_coordinates.size())
+    const bool use_route_result_cache =
+        route_result_cache && !use_multi_level_dijkstra &&
+        1 == raw_route.segment_end_coordinates.size() && !route_parameters.alternatives &&
+        RouteResultCache::IsCacheable(raw_route.segment_end_coordinates.front());
+    boost::optional<RouteResultCache::Key> route_result_key;
+    if (use_route_result_cache)
+    {
+        route_result_key =
+            RouteResultCache::MakeKey(raw_route.segment_end_coordinates.front(), time_slot);
+    }
+
+    if (route_result_key)
+    {
+        if (auto cached = route_result_cache->Get(*route_result_key,
+                                                  raw_route.segment_end_coordinates.front()))
+        {
+            raw_route = std::move(*cached);
+        }
+        else
+        {
+            direct_shortest_path(raw_route.segment_end_coordinates, raw_route);
+            if (raw_route.is_valid())
+            {
+                route_result_cache->Put(*route_result_key, raw_route);
+            }
+        }
+    }
+    else if (use_multi_level_dijkstra)
+    {
+        // neither alternatives nor continue_straight are supported on the overlay graphs
+        multi_level_dijkstra(raw_route.segment_end_coordinates, raw_route);
+    }
+    else if (1 == raw_route.segment_end_coordinates.size())
     {
-        if (route_parameters.alternatives && facade.GetCoreSize() == 0)
+        // the alternative search is tuned to the weights of the dataset
+        if (route_parameters.alternatives && facade.GetCoreSize() == 0 &&
+            time_slot == INVALID_TIME_SLOT)
         {
-            alternative_path(raw_route.segment_end_coordinates.front(), raw_route);
+            // the via node search finds a single alternative
+            if (route_parameters.number_of_alternatives > 1)
+            {
+                penalty_alternative_path(raw_route.segment_end_coordinates.front(),
+                                         route_parameters.number_of_alternatives,
+                                         raw_route);
+            }
+            else
+            {
+                alternative_path(raw_route.segment_end_coordinates.front(), raw_route);
+            }
         }
         else
         {
@@ -102,9 +209,13 @@ Status ViaRoutePlugin::HandleRequest(const api::RouteParameters &route_parameter
 
     // we can only know this after the fact, different SCC ids still
     // allow for connection in one direction.
+    if (raw_route.is_valid() && raw_route.shortest_path_length >= EXCLUDED_EDGE_WEIGHT)
+    {
+        return Error("NoRoute", "No route found that avoids the excluded classes", json_result);
+    }
     if (raw_route.is_valid())
     {
-        api::RouteAPI route_api{BasePlugin::facade, route_parameters};
+        api::RouteAPI route_api{BasePlugin::facade, route_parameters, use_parallel_route};
         route_api.MakeResponse(raw_route, json_result);
     }
     else
@@ -128,6 +239,91 @@ Status ViaRoutePlugin::HandleRequest(const api::RouteParameters &route_parameter
 
     return Status::Ok;
 }
+
+void ViaRoutePlugin::HandleBatch(const std::vector<api::RouteParameters> &route_parameters,
+                                 std::vector<util::json::Object> &json_results,
+                                 std::vector<Status> &statuses)
+{
+    json_results.clear();
+    json_results.resize(route_parameters.size());
+    statuses.assign(route_parameters.size(), Status::Error);
+
+    // Only plain coordinates are snapped up front, hints, bearings, radiuses, departure times,
+    // metrics and exclusions leave the snapping of their query to GetPhantomNodes
+    std::vector<PhantomNodeCache::Key> keys;
+    std::vector<util::Coordinate> coordinates;
+    SnappedCoordinates snapped;
+    for (const auto &parameters : route_parameters)
+    {
+        if (!parameters.hints.empty() || !parameters.bearings.empty() ||
+            !parameters.radiuses.empty() || parameters.departure_time || parameters.metric > 0 ||
+            parameters.exclude != EDGE_CLASS_NONE ||
+            !CheckAllCoordinates(parameters.coordinates))
+        {
+            continue;
+        }
+        for (const auto coordinate : parameters.coordinates)
+        {
+            const auto key = PhantomNodeCache::MakeKey(coordinate, boost::none, boost::none);
+            if (snapped.emplace(key, PhantomNodePair{}).second)
+            {
+                keys.push_back(key);
+                coordinates.push_back(coordinate);
+            }
+        }
+    }
+
+    std::vector<PhantomNodePair> phantom_node_pairs(coordinates.size());
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, coordinates.size(), 1024),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            const std::vector<util::Coordinate> range_coordinates(
+                coordinates.begin() + range.begin(), coordinates.begin() + range.end());
+            auto range_pairs =
+                facade.NearestPhantomNodesWithAlternativeFromBigComponent(range_coordinates);
+            BOOST_ASSERT(range_pairs.size() == range.size());
+            std::move(
+                range_pairs.begin(), range_pairs.end(), phantom_node_pairs.begin() + range.begin());
+        });
+    for (const auto index : util::irange<std::size_t>(0, keys.size()))
+    {
+        snapped[keys[index]] = std::move(phantom_node_pairs[index]);
+    }
+
+    std::vector<std::uint64_t> hilbert_codes(route_parameters.size(), 0);
+    for (const auto index : util::irange<std::size_t>(0, route_parameters.size()))
+    {
+        const auto &parameters = route_parameters[index];
+        if (!parameters.coordinates.empty() && parameters.coordinates.front().IsValid())
+        {
+            hilbert_codes[index] = util::hilbertCode(parameters.coordinates.front());
+        }
+    }
+    std::vector<std::size_t> order(route_parameters.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](const std::size_t lhs, const std::size_t rhs) {
+        return hilbert_codes[lhs] < hilbert_codes[rhs];
+    });
+
+    const auto *const deadline = ActiveQueryDeadline();
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, order.size(), 16),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          const QueryDeadlineScope deadline_scope(deadline);
+                          for (auto position = range.begin(); position != range.end(); ++position)
+                          {
+                              const auto index = order[position];
+                              if (!route_parameters[index].IsValid())
+                              {
+                                  statuses[index] = Error("InvalidOptions",
+                                                          "Invalid route parameters.",
+                                                          json_results[index]);
+                                  continue;
+                              }
+                              statuses[index] = HandleRequest(
+                                  route_parameters[index], json_results[index], &snapped);
+                          }
+                      });
+}
 }
 }
 }
@@ -4,7 +4,8 @@
 #include <boost/assert.hpp>
 #include <cmath>
 #include <cstddef>
-#include <cstdlib>
+#include <cstdint>
+#include <iterator>
 
 namespace osrm
 {
@@ -13,81 +14,63 @@ namespace engine
 namespace /*detail*/ // anonymous to keep TU local
 {
 
-std::string encode(int number_to_encode)
+// Appends the zig-zag encoded number as chunks of 5 bits, the least significant first
+void encode(const int number, std::string &output)
 {
-    std::string output;
-    while (number_to_encode >= 0x20)
+    // the sign goes into the lowest bit, negative numbers get their other bits flipped
+    auto value = static_cast<std::uint32_t>(number) << 1u;
+    if (number < 0)
     {
-        const int next_value = (0x20 | (number_to_encode & 0x1f)) + 63;
-        output += static_cast<char>(next_value);
-        number_to_encode >>= 5;
+        value = ~value;
     }
 
-    number_to_encode += 63;
-    output += static_cast<char>(number_to_encode);
-    return output;
+    while (value >= 0x20)
+    {
+        output += static_cast<char>((0x20 | (value & 0x1f)) + 63);
+        value >>= 5;
+    }
+    output += static_cast<char>(value + 63);
 }
 
-std::string encode(std::vector<int> &numbers)
+int toPolyline(const std::int32_t fixed, const double coordinate_to_polyline)
 {
-    std::string output;
-    for (auto &number : numbers)
-    {
-        bool isNegative = number < 0;
-
-        if (isNegative)
-        {
-            const unsigned binary = std::llabs(number);
-            const unsigned twos = (~binary) + 1u;
-            number = twos;
-        }
-
-        number <<= 1u;
-
-        if (isNegative)
-        {
-            number = ~number;
-        }
-    }
-    for (const int number : numbers)
-    {
-        output += encode(number);
-    }
-    return output;
+    return static_cast<int>(std::round(fixed * coordinate_to_polyline));
 }
 } // anonymous ns
 
-std::string encodePolyline(CoordVectorForwardIter begin, CoordVectorForwardIter end)
+std::string
+encodePolyline(CoordVectorForwardIter begin, CoordVectorForwardIter end, const double precision)
 {
-    auto size = std::distance(begin, end);
+    const auto size = std::distance(begin, end);
     if (size == 0)
     {
         return {};
     }
 
-    std::vector<int> delta_numbers;
-    BOOST_ASSERT(size > 0);
-    delta_numbers.reserve((size - 1) * 2);
+    const double coordinate_to_polyline = precision / COORDINATE_PRECISION;
+
+    // deltas between close coordinates take about 4 characters, the first coordinate more
+    std::string output;
+    output.reserve(size * 8 + 16);
+
     int current_lat = 0;
     int current_lon = 0;
-    std::for_each(
-        begin, end, [&delta_numbers, &current_lat, &current_lon](const util::Coordinate loc) {
-            const int lat_diff =
-                std::round(static_cast<int>(loc.lat) * detail::COORDINATE_TO_POLYLINE) -
-                current_lat;
-            const int lon_diff =
-                std::round(static_cast<int>(loc.lon) * detail::COORDINATE_TO_POLYLINE) -
-                current_lon;
-            delta_numbers.emplace_back(lat_diff);
-            delta_numbers.emplace_back(lon_diff);
-            current_lat += lat_diff;
-            current_lon += lon_diff;
-        });
-    return encode(delta_numbers);
+    std::for_each(begin, end, [&](const util::Coordinate loc) {
+        const int lat = toPolyline(static_cast<std::int32_t>(loc.lat), coordinate_to_polyline);
+        const int lon = toPolyline(static_cast<std::int32_t>(loc.lon), coordinate_to_polyline);
+        encode(lat - current_lat, output);
+        encode(lon - current_lon, output);
+        current_lat = lat;
+        current_lon = lon;
+    });
+    return output;
 }
 
-std::vector<util::Coordinate> decodePolyline(const std::string &geometry_string)
+std::vector<util::Coordinate> decodePolyline(const std::string &geometry_string,
+                                             const double precision)
 {
+    const double polyline_to_coordinate = COORDINATE_PRECISION / precision;
+
     std::vector<util::Coordinate> new_coordinates;
     int index = 0, len = geometry_string.size();
     int lat = 0, lng = 0;
@@ -116,8 +99,8 @@ std::vector<util::Coordinate> decodePolyline(const std::string &geometry_string)
         lng += dlng;
 
         util::Coordinate p;
-        p.lat = util::FixedLatitude{static_cast<std::int32_t>(lat * detail::POLYLINE_TO_COORDINATE)};
-        p.lon = util::FixedLongitude{static_cast<std::int32_t>(lng * detail::POLYLINE_TO_COORDINATE)};
+        p.lat = util::FixedLatitude{static_cast<std::int32_t>(lat * polyline_to_coordinate)};
+        p.lon = util::FixedLongitude{static_cast<std::int32_t>(lng * polyline_to_coordinate)};
         new_coordinates.push_back(p);
     }
 
@@ -0,0 +1,221 @@
+#include "engine/table_peers.hpp"
+
+#include "engine/hint.hpp"
+#include "util/exception.hpp"
+#include "util/http_client.hpp"
+#include "util/integer_range.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace osrm
+{
+namespace engine
+{
+
+namespace
+{
+std::string FormatRadius(const double radius)
+{
+    return std::isinf(radius) ? "unlimited" : std::to_string(radius);
+}
+
+// Appends name=values, with the value of each coordinate separated by ';'
+template <typename ValueT, typename FormatT>
+void AppendPerCoordinate(std::string &query,
+                         const char *name,
+                         const std::vector<ValueT> &values,
+                         const std::vector<std::size_t> &indices,
+                         const FormatT format)
+{
+    if (values.empty())
+    {
+        return;
+    }
+    query += '&';
+    query += name;
+    query += '=';
+    for (const auto position : util::irange<std::size_t>(0UL, indices.size()))
+    {
+        if (position > 0)
+        {
+            query += ';';
+        }
+        if (const auto &value = values[indices[position]])
+        {
+            query += format(*value);
+        }
+    }
+}
+}
+
+TablePeers::TablePeers(const std::vector<std::string> &peers_,
+                       std::string profile_,
+                       const std::chrono::milliseconds timeout)
+    : profile(std::move(profile_)), timeout(timeout)
+{
+    for (const auto &peer : peers_)
+    {
+        const auto separator = peer.rfind(':');
+        if (separator == std::string::npos || separator == 0 || separator + 1 == peer.size())
+        {
+            throw util::exception("Table peer " + peer + " is not of the form host:port");
+        }
+        auto host = peer.substr(0, separator);
+        // IPv6 addresses are enclosed in brackets, like in URLs
+        if (host.size() > 2 && host.front() == '[' && host.back() == ']')
+        {
+            host = host.substr(1, host.size() - 2);
+        }
+        peers.push_back({std::move(host), peer.substr(separator + 1)});
+    }
+}
+
+boost::optional<TablePeers::Rows>
+TablePeers::FetchRows(const std::size_t peer,
+                      const api::TableParameters &params,
+                      const std::vector<std::size_t> &sources) const
+{
+    BOOST_ASSERT(peer < peers.size());
+    const auto response =
+        util::HttpGet(peers[peer].host, peers[peer].port, MakeQuery(params, sources), timeout);
+    if (!response || response->status != 200)
+    {
+        return boost::none;
+    }
+    const auto number_of_destinations =
+        params.destinations.empty() ? params.coordinates.size() : params.destinations.size();
+    return ParseBinaryTable(response->body, sources.size(), number_of_destinations);
+}
+
+std::string TablePeers::MakeQuery(const api::TableParameters &params,
+                                  const std::vector<std::size_t> &sources) const
+{
+    // the sources are followed by the destinations, which are all coordinates if none are given
+    std::vector<std::size_t> indices = sources;
+    if (params.destinations.empty())
+    {
+        for (const auto index : util::irange<std::size_t>(0UL, params.coordinates.size()))
+        {
+            indices.push_back(index);
+        }
+    }
+    else
+    {
+        indices.insert(indices.end(), params.destinations.begin(), params.destinations.end());
+    }
+
+    std::string query = "/table/v1/" + profile + "/";
+    for (const auto position : util::irange<std::size_t>(0UL, indices.size()))
+    {
+        const auto &coordinate = params.coordinates[indices[position]];
+        if (position > 0)
+        {
+            query += ';';
+        }
+        query += std::to_string(static_cast<double>(util::toFloating(coordinate.lon))) + ',' +
+                 std::to_string(static_cast<double>(util::toFloating(coordinate.lat)));
+    }
+    // fixed decimals, so the format is never taken for a part of the last latitude
+    query += ".binary?sources=";
+    for (const auto position : util::irange<std::size_t>(0UL, indices.size()))
+    {
+        if (position == sources.size())
+        {
+            query += "&destinations=";
+        }
+        else if (position > 0)
+        {
+            query += ';';
+        }
+        query += std::to_string(position);
+    }
+
+    const auto annotations = static_cast<int>(params.annotations);
+    query += "&annotations=";
+    query += annotations == static_cast<int>(api::TableParameters::AnnotationsType::All)
+                 ? "duration,distance"
+                 : annotations == static_cast<int>(api::TableParameters::AnnotationsType::Distance)
+                       ? "distance"
+                       : "duration";
+
+    AppendPerCoordinate(
+        query, "hints", params.hints, indices, [](const Hint &hint) { return hint.ToBase64(); });
+    AppendPerCoordinate(query, "radiuses", params.radiuses, indices, FormatRadius);
+    AppendPerCoordinate(query, "bearings", params.bearings, indices, [](const Bearing bearing) {
+        return std::to_string(bearing.bearing) + ',' + std::to_string(bearing.range);
+    });
+    // the peer has to search the shard itself
+    query += "&distribute=false";
+
+    return query;
+}
+
+boost::optional<TablePeers::Rows>
+TablePeers::ParseBinaryTable(const std::string &body,
+                             const std::size_t number_of_sources,
+                             const std::size_t number_of_destinations)
+{
+    std::size_t offset = 4;
+    const auto read_uint32 = [&body, &offset](std::uint32_t &value) {
+        if (offset + sizeof(value) > body.size())
+        {
+            return false;
+        }
+        std::memcpy(&value, body.data() + offset, sizeof(value));
+        offset += sizeof(value);
+        return true;
+    };
+
+    std::uint32_t version = 0;
+    std::uint32_t sources = 0;
+    std::uint32_t destinations = 0;
+    if (body.compare(0, 4, "OSRT") != 0 || !read_uint32(version) || !read_uint32(sources) ||
+        !read_uint32(destinations) || sources != number_of_sources ||
+        destinations != number_of_destinations)
+    {
+        return boost::none;
+    }
+
+    // version 1 only has durations
+    std::uint32_t annotations =
+        static_cast<std::uint32_t>(api::TableParameters::AnnotationsType::Duration);
+    if (version > 1 && !read_uint32(annotations))
+    {
+        return boost::none;
+    }
+    const bool with_durations =
+        annotations & static_cast<std::uint32_t>(api::TableParameters::AnnotationsType::Duration);
+    const bool with_distances =
+        annotations & static_cast<std::uint32_t>(api::TableParameters::AnnotationsType::Distance);
+
+    // the locations of the sources and the destinations are known already
+    offset += 2 * sizeof(std::int32_t) * (number_of_sources + number_of_destinations);
+
+    const auto number_of_entries = number_of_sources * number_of_destinations;
+    if (offset + (with_durations + with_distances) * number_of_entries * sizeof(EdgeWeight) !=
+        body.size())
+    {
+        return boost::none;
+    }
+
+    Rows rows;
+    const auto read_matrix = [&](std::vector<EdgeWeight> &matrix) {
+        matrix.resize(number_of_entries);
+        std::memcpy(matrix.data(), body.data() + offset, number_of_entries * sizeof(EdgeWeight));
+        offset += number_of_entries * sizeof(EdgeWeight);
+    };
+    if (with_durations)
+    {
+        read_matrix(rows.durations);
+    }
+    if (with_distances)
+    {
+        read_matrix(rows.distances);
+    }
+    return rows;
+}
+}
+}
@@ -0,0 +1,169 @@
+#include "extractor/change_applier.hpp"
+
+#include "util/exception.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+#include <osmium/io/any_input.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace osrm
+{
+namespace extractor
+{
+
+namespace
+{
+// buffers of the input are about this large, the output grows if changes are inserted
+const constexpr std::size_t MIN_BUFFER_SIZE = 1024 * 1024;
+
+bool IsObject(const osmium::OSMEntity &entity)
+{
+    return entity.type() == osmium::item_type::node || entity.type() == osmium::item_type::way ||
+           entity.type() == osmium::item_type::relation;
+}
+
+// order of the objects in sorted OSM files, regardless of their version
+bool ComesBefore(const osmium::OSMObject &lhs, const osmium::OSMObject &rhs)
+{
+    if (lhs.type() != rhs.type())
+    {
+        return lhs.type() < rhs.type();
+    }
+    return lhs.positive_id() < rhs.positive_id();
+}
+
+void Add(const osmium::OSMEntity &entity, osmium::memory::Buffer &output)
+{
+    output.add_item(entity);
+    output.commit();
+}
+
+OSMWayID MakeWayID(const osmium::OSMObject &way)
+{
+    return OSMWayID{static_cast<std::uint32_t>(way.id())};
+}
+}
+
+ChangeApplier::ChangeApplier(const std::vector<boost::filesystem::path> &change_paths)
+    : change_buffer(MIN_BUFFER_SIZE)
+{
+    for (const auto &change_path : change_paths)
+    {
+        if (!boost::filesystem::is_regular_file(change_path))
+        {
+            throw util::exception("Change file " + change_path.string() + " not found");
+        }
+
+        osmium::io::Reader reader(change_path.string(), osmium::osm_entity_bits::nwr);
+        while (const auto buffer = reader.read())
+        {
+            change_buffer.add_buffer(buffer);
+            change_buffer.commit();
+        }
+        reader.close();
+    }
+
+    std::for_each(change_buffer.cbegin<osmium::OSMObject>(),
+                  change_buffer.cend<osmium::OSMObject>(),
+                  [this](const osmium::OSMObject &object) { changes.push_back(&object); });
+    // keep the last, i.e. newest, version of every object
+    std::stable_sort(changes.begin(), changes.end(), osmium::object_order_type_id_version());
+    const auto last_versions =
+        std::unique(changes.rbegin(), changes.rend(), osmium::object_equal_type_id());
+    changes.erase(changes.begin(), last_versions.base());
+
+    for (const auto *change : changes)
+    {
+        if (change->type() == osmium::item_type::node)
+        {
+            changed_nodes.push_back(change->id());
+        }
+    }
+    std::sort(changed_nodes.begin(), changed_nodes.end());
+
+    next_change = changes.begin();
+}
+
+osmium::memory::Buffer ChangeApplier::Apply(const osmium::memory::Buffer &input)
+{
+    osmium::memory::Buffer output(std::max(input.committed(), MIN_BUFFER_SIZE));
+
+    for (const auto &entity : input)
+    {
+        if (!IsObject(entity))
+        {
+            Add(entity, output);
+            continue;
+        }
+
+        const auto &object = static_cast<const osmium::OSMObject &>(entity);
+        ApplyChangesBefore(object, output);
+        if (next_change != changes.end() && !ComesBefore(object, **next_change))
+        {
+            ApplyNextChange(output);
+            continue;
+        }
+
+        if (object.type() == osmium::item_type::way)
+        {
+            const auto &nodes = static_cast<const osmium::Way &>(object).nodes();
+            const auto changed_node =
+                std::find_if(nodes.begin(), nodes.end(), [this](const osmium::NodeRef &node) {
+                    return std::binary_search(
+                        changed_nodes.begin(), changed_nodes.end(), node.ref());
+                });
+            if (changed_node != nodes.end())
+            {
+                affected_ways.push_back(MakeWayID(object));
+            }
+        }
+        Add(object, output);
+    }
+
+    return output;
+}
+
+osmium::memory::Buffer ChangeApplier::Finish()
+{
+    if (next_change == changes.end())
+    {
+        return osmium::memory::Buffer{};
+    }
+
+    osmium::memory::Buffer output(MIN_BUFFER_SIZE);
+    while (next_change != changes.end())
+    {
+        ApplyNextChange(output);
+    }
+    return output;
+}
+
+void ChangeApplier::ApplyChangesBefore(const osmium::OSMObject &object,
+                                       osmium::memory::Buffer &output)
+{
+    while (next_change != changes.end() && ComesBefore(**next_change, object))
+    {
+        ApplyNextChange(output);
+    }
+}
+
+void ChangeApplier::ApplyNextChange(osmium::memory::Buffer &output)
+{
+    const auto &change = **next_change++;
+    if (change.type() == osmium::item_type::way)
+    {
+        affected_ways.push_back(MakeWayID(change));
+    }
+    // deleted objects are not visible
+    if (change.visible())
+    {
+        Add(change, output);
+    }
+}
+}
+}
@@ -1,10 +1,13 @@
 #include "extractor/compressed_edge_container.hpp"
+#include "util/intermediate_file.hpp"
 #include "util/simple_logger.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 
+#include <algorithm>
+#include <iterator>
 #include <limits>
 #include <string>
 
@@ -15,20 +18,61 @@ namespace osrm
 namespace extractor
 {
 
-CompressedEdgeContainer::CompressedEdgeContainer()
+CompressedEdgeContainer::CompressedEdgeContainer() {}
+
+// Returns the bucket of an edge, a new bucket is created if it does not exist
+unsigned CompressedEdgeContainer::GetOrAddBucket(const EdgeID edge_id)
 {
-    m_free_list.reserve(100);
-    IncreaseFreeList();
+    const auto iter = m_edge_id_to_list_index_map.find(edge_id);
+    if (iter != m_edge_id_to_list_index_map.end())
+    {
+        return iter->second;
+    }
+
+    unsigned bucket_id;
+    if (m_free_list.empty())
+    {
+        bucket_id = m_compressed_geometries.size();
+        m_compressed_geometries.push_back({0, 0});
+    }
+    else
+    {
+        bucket_id = m_free_list.back();
+        m_free_list.pop_back();
+    }
+    m_edge_id_to_list_index_map.emplace(edge_id, bucket_id);
+    return bucket_id;
+}
+
+// Grows the arena geometrically, so entries of the arena can be appended without reallocation
+void CompressedEdgeContainer::ReserveGeometries(const std::size_t additional_entries)
+{
+    const auto required = m_geometries.size() + additional_entries;
+    if (m_geometries.capacity() < required)
+    {
+        m_geometries.reserve(std::max(required, 2 * m_geometries.capacity()));
+    }
 }
 
-void CompressedEdgeContainer::IncreaseFreeList()
+// Copies a bucket to the end of the arena unless it is there already, so that it can grow
+void CompressedEdgeContainer::MoveBucketToEnd(const unsigned bucket_id)
 {
-    m_compressed_geometries.resize(m_compressed_geometries.size() + 100);
-    for (unsigned i = 100; i > 0; --i)
+    BOOST_ASSERT(bucket_id < m_compressed_geometries.size());
+    auto &range = m_compressed_geometries[bucket_id];
+    if (range.size == 0)
+    {
+        range.begin = m_geometries.size();
+        return;
+    }
+    if (range.begin + range.size == m_geometries.size())
     {
-        m_free_list.emplace_back(free_list_maximum);
-        ++free_list_maximum;
+        return;
     }
+
+    ReserveGeometries(range.size);
+    const auto old_begin = m_geometries.begin() + range.begin;
+    range.begin = m_geometries.size();
+    std::copy_n(old_begin, range.size, std::back_inserter(m_geometries));
 }
 
 bool CompressedEdgeContainer::HasEntryForID(const EdgeID edge_id) const
@@ -45,45 +89,61 @@ unsigned CompressedEdgeContainer::GetPositionForID(const EdgeID edge_id) const
     return map_iterator->second;
 }
 
-void CompressedEdgeContainer::SerializeInternalVector(const std::string &path) const
+// Writes the geometries without the entries that were left behind in the arena
+void CompressedEdgeContainer::SerializeInternalVector(const std::string &path,
+                                                      const bool compress) const
 {
-
-    boost::filesystem::fstream geometry_out_stream(path, std::ios::binary | std::ios::out);
+    util::IntermediateOutputFile geometry_out_stream(path, compress);
     const unsigned compressed_geometries = m_compressed_geometries.size() + 1;
     BOOST_ASSERT(std::numeric_limits<unsigned>::max() != compressed_geometries);
     geometry_out_stream.write((char *)&compressed_geometries, sizeof(unsigned));
 
-    // write indices array
-    unsigned prefix_sum_of_list_indices = 0;
-    for (const auto &elem : m_compressed_geometries)
-    {
-        geometry_out_stream.write((char *)&prefix_sum_of_list_indices, sizeof(unsigned));
-
-        const std::vector<CompressedEdge> &current_vector = elem;
-        const unsigned unpacked_size = current_vector.size();
-        BOOST_ASSERT(std::numeric_limits<unsigned>::max() != unpacked_size);
-        prefix_sum_of_list_indices += unpacked_size;
-    }
-    // sentinel element
-    geometry_out_stream.write((char *)&prefix_sum_of_list_indices, sizeof(unsigned));
+    // write indices array with its sentinel element
+    const auto indices = GetGeometryIndices();
+    geometry_out_stream.write((char *)indices.data(), indices.size() * sizeof(unsigned));
+    const unsigned prefix_sum_of_list_indices = indices.back();
 
     // number of geometry entries to follow, it is the (inclusive) prefix sum
     geometry_out_stream.write((char *)&prefix_sum_of_list_indices, sizeof(unsigned));
 
     unsigned control_sum = 0;
-    // write compressed geometries
-    for (auto &elem : m_compressed_geometries)
+    // write compressed geometries, consecutive ranges of the arena in one go
+    for (std::size_t index = 0; index < m_compressed_geometries.size();)
     {
-        const std::vector<CompressedEdge> &current_vector = elem;
-        const unsigned unpacked_size = current_vector.size();
-        control_sum += unpacked_size;
-        BOOST_ASSERT(std::numeric_limits<unsigned>::max() != unpacked_size);
-        for (const auto &current_node : current_vector)
+        const auto begin = m_compressed_geometries[index].begin;
+        auto end = begin;
+        for (; index < m_compressed_geometries.size() &&
+               (m_compressed_geometries[index].size == 0 ||
+                m_compressed_geometries[index].begin == end);
+             ++index)
+        {
+            end += m_compressed_geometries[index].size;
+        }
+        if (end > begin)
         {
-            geometry_out_stream.write((char *)&(current_node), sizeof(CompressedEdge));
+            control_sum += end - begin;
+            geometry_out_stream.write((char *)(m_geometries.data() + begin),
+                                      (end - begin) * sizeof(CompressedEdge));
         }
     }
     BOOST_ASSERT(control_sum == prefix_sum_of_list_indices);
+    geometry_out_stream.close();
+}
+
+std::vector<unsigned> CompressedEdgeContainer::GetGeometryIndices() const
+{
+    std::vector<unsigned> indices;
+    indices.reserve(m_compressed_geometries.size() + 1);
+    unsigned prefix_sum_of_list_indices = 0;
+    for (const auto &range : m_compressed_geometries)
+    {
+        indices.push_back(prefix_sum_of_list_indices);
+
+        BOOST_ASSERT(std::numeric_limits<unsigned>::max() != range.size);
+        prefix_sum_of_list_indices += range.size;
+    }
+    indices.push_back(prefix_sum_of_list_indices);
+    return indices;
 }
 
 // Adds info for a compressed edge to the container.   edge_id_2
@@ -117,64 +177,52 @@ void CompressedEdgeContainer::CompressEdge(const EdgeID edge_id_1,
     // 2. find list for edge_id_2, if yes add all elements and delete it
 
     // Add via node id. List is created if it does not exist
-    if (!HasEntryForID(edge_id_1))
-    {
-        // create a new entry in the map
-        if (0 == m_free_list.size())
-        {
-            // make sure there is a place to put the entries
-            IncreaseFreeList();
-        }
-        BOOST_ASSERT(!m_free_list.empty());
-        m_edge_id_to_list_index_map[edge_id_1] = m_free_list.back();
-        m_free_list.pop_back();
-    }
-
-    // find bucket index
-    const auto iter = m_edge_id_to_list_index_map.find(edge_id_1);
-    BOOST_ASSERT(iter != m_edge_id_to_list_index_map.end());
-    const unsigned edge_bucket_id1 = iter->second;
+    const unsigned edge_bucket_id1 = GetOrAddBucket(edge_id_1);
     BOOST_ASSERT(edge_bucket_id1 == GetPositionForID(edge_id_1));
     BOOST_ASSERT(edge_bucket_id1 < m_compressed_geometries.size());
 
-    std::vector<CompressedEdge> &edge_bucket_list1 = m_compressed_geometries[edge_bucket_id1];
+    // the list of edge_id_1 grows at the end of the arena
+    MoveBucketToEnd(edge_bucket_id1);
 
     // note we don't save the start coordinate: it is implicitly given by edge 1
     // weight1 is the distance to the (currently) last coordinate in the bucket
-    if (edge_bucket_list1.empty())
+    if (m_compressed_geometries[edge_bucket_id1].size == 0)
     {
-        edge_bucket_list1.emplace_back(CompressedEdge{via_node_id, weight1});
+        m_geometries.emplace_back(CompressedEdge{via_node_id, weight1});
+        ++m_compressed_geometries[edge_bucket_id1].size;
     }
 
-    BOOST_ASSERT(0 < edge_bucket_list1.size());
-    BOOST_ASSERT(!edge_bucket_list1.empty());
+    BOOST_ASSERT(0 < m_compressed_geometries[edge_bucket_id1].size);
 
     if (HasEntryForID(edge_id_2))
     {
         // second edge is not atomic anymore
         const unsigned list_to_remove_index = GetPositionForID(edge_id_2);
         BOOST_ASSERT(list_to_remove_index < m_compressed_geometries.size());
+        BOOST_ASSERT(list_to_remove_index != edge_bucket_id1);
 
-        std::vector<CompressedEdge> &edge_bucket_list2 =
-            m_compressed_geometries[list_to_remove_index];
+        auto &edge_bucket_range2 = m_compressed_geometries[list_to_remove_index];
 
         // found an existing list, append it to the list of edge_id_1
-        edge_bucket_list1.insert(
-            edge_bucket_list1.end(), edge_bucket_list2.begin(), edge_bucket_list2.end());
+        ReserveGeometries(edge_bucket_range2.size);
+        std::copy_n(m_geometries.begin() + edge_bucket_range2.begin,
+                    edge_bucket_range2.size,
+                    std::back_inserter(m_geometries));
+        m_compressed_geometries[edge_bucket_id1].size += edge_bucket_range2.size;
 
         // remove the list of edge_id_2
         m_edge_id_to_list_index_map.erase(edge_id_2);
         BOOST_ASSERT(m_edge_id_to_list_index_map.end() ==
                      m_edge_id_to_list_index_map.find(edge_id_2));
-        edge_bucket_list2.clear();
-        BOOST_ASSERT(0 == edge_bucket_list2.size());
+        edge_bucket_range2 = {0, 0};
         m_free_list.emplace_back(list_to_remove_index);
         BOOST_ASSERT(list_to_remove_index == m_free_list.back());
     }
     else
     {
         // we are certain that the second edge is atomic.
-        edge_bucket_list1.emplace_back(CompressedEdge{target_node_id, weight2});
+        m_geometries.emplace_back(CompressedEdge{target_node_id, weight2});
+        ++m_compressed_geometries[edge_bucket_id1].size;
     }
 }
 
@@ -188,49 +236,61 @@ void CompressedEdgeContainer::AddUncompressedEdge(const EdgeID edge_id,
     BOOST_ASSERT(INVALID_EDGE_WEIGHT != weight);
 
     // Add via node id. List is created if it does not exist
-    if (!HasEntryForID(edge_id))
-    {
-        // create a new entry in the map
-        if (0 == m_free_list.size())
-        {
-            // make sure there is a place to put the entries
-            IncreaseFreeList();
-        }
-        BOOST_ASSERT(!m_free_list.empty());
-        m_edge_id_to_list_index_map[edge_id] = m_free_list.back();
-        m_free_list.pop_back();
-    }
-
-    // find bucket index
-    const auto iter = m_edge_id_to_list_index_map.find(edge_id);
-    BOOST_ASSERT(iter != m_edge_id_to_list_index_map.end());
-    const unsigned edge_bucket_id = iter->second;
+    const unsigned edge_bucket_id = GetOrAddBucket(edge_id);
     BOOST_ASSERT(edge_bucket_id == GetPositionForID(edge_id));
     BOOST_ASSERT(edge_bucket_id < m_compressed_geometries.size());
 
-    std::vector<CompressedEdge> &edge_bucket_list = m_compressed_geometries[edge_bucket_id];
-
     // note we don't save the start coordinate: it is implicitly given by edge_id
     // weight is the distance to the (currently) last coordinate in the bucket
     // Don't re-add this if it's already in there.
-    if (edge_bucket_list.empty())
+    if (m_compressed_geometries[edge_bucket_id].size == 0)
+    {
+        MoveBucketToEnd(edge_bucket_id);
+        m_geometries.emplace_back(CompressedEdge{target_node_id, weight});
+        ++m_compressed_geometries[edge_bucket_id].size;
+    }
+}
+
+void CompressedEdgeContainer::AddEdgeGeometries(const std::vector<EdgeID> &edge_ids,
+                                                const std::vector<unsigned> &offsets,
+                                                std::vector<CompressedEdge> geometries)
+{
+    BOOST_ASSERT(offsets.size() == edge_ids.size() + 1);
+    BOOST_ASSERT(offsets.back() == geometries.size());
+
+    const unsigned first_entry = m_geometries.size();
+    if (m_geometries.empty())
+    {
+        m_geometries = std::move(geometries);
+    }
+    else
+    {
+        m_geometries.insert(m_geometries.end(), geometries.begin(), geometries.end());
+    }
+
+    m_compressed_geometries.reserve(m_compressed_geometries.size() + edge_ids.size());
+    m_edge_id_to_list_index_map.reserve(m_edge_id_to_list_index_map.size() + edge_ids.size());
+    for (std::size_t index = 0; index < edge_ids.size(); ++index)
     {
-        edge_bucket_list.emplace_back(CompressedEdge{target_node_id, weight});
+        BOOST_ASSERT(SPECIAL_EDGEID != edge_ids[index]);
+        BOOST_ASSERT(offsets[index] < offsets[index + 1]);
+        BOOST_ASSERT(!HasEntryForID(edge_ids[index]));
+        m_edge_id_to_list_index_map[edge_ids[index]] = m_compressed_geometries.size();
+        m_compressed_geometries.push_back(
+            {first_entry + offsets[index], offsets[index + 1] - offsets[index]});
     }
 }
 
 void CompressedEdgeContainer::PrintStatistics() const
 {
     const uint64_t compressed_edges = m_compressed_geometries.size();
-    BOOST_ASSERT(0 == compressed_edges % 2);
-    BOOST_ASSERT(m_compressed_geometries.size() + m_free_list.size() > 0);
 
     uint64_t compressed_geometries = 0;
     uint64_t longest_chain_length = 0;
-    for (const std::vector<CompressedEdge> &current_vector : m_compressed_geometries)
+    for (const auto &range : m_compressed_geometries)
     {
-        compressed_geometries += current_vector.size();
-        longest_chain_length = std::max(longest_chain_length, (uint64_t)current_vector.size());
+        compressed_geometries += range.size;
+        longest_chain_length = std::max(longest_chain_length, (uint64_t)range.size);
     }
 
     util::SimpleLogger().Write()
@@ -243,11 +303,13 @@ void CompressedEdgeContainer::PrintStatistics() const
         << (float)compressed_geometries / std::max((uint64_t)1, compressed_edges);
 }
 
-const CompressedEdgeContainer::EdgeBucket &
+CompressedEdgeContainer::EdgeBucket
 CompressedEdgeContainer::GetBucketReference(const EdgeID edge_id) const
 {
     const unsigned index = m_edge_id_to_list_index_map.at(edge_id);
-    return m_compressed_geometries.at(index);
+    const auto &range = m_compressed_geometries.at(index);
+    const auto begin = m_geometries.begin() + range.begin;
+    return boost::make_iterator_range(begin, begin + range.size);
 }
 
 // Since all edges are technically in the compressed geometry container,
@@ -256,25 +318,25 @@ CompressedEdgeContainer::GetBucketReference(const EdgeID edge_id) const
 // that only contain one original segment
 bool CompressedEdgeContainer::IsTrivial(const EdgeID edge_id) const
 {
-    const auto &bucket = GetBucketReference(edge_id);
+    const auto bucket = GetBucketReference(edge_id);
     return bucket.size() == 1;
 }
 
 NodeID CompressedEdgeContainer::GetFirstEdgeTargetID(const EdgeID edge_id) const
 {
-    const auto &bucket = GetBucketReference(edge_id);
+    const auto bucket = GetBucketReference(edge_id);
     BOOST_ASSERT(bucket.size() >= 1);
     return bucket.front().node_id;
 }
 NodeID CompressedEdgeContainer::GetLastEdgeTargetID(const EdgeID edge_id) const
 {
-    const auto &bucket = GetBucketReference(edge_id);
+    const auto bucket = GetBucketReference(edge_id);
     BOOST_ASSERT(bucket.size() >= 1);
     return bucket.back().node_id;
 }
 NodeID CompressedEdgeContainer::GetLastEdgeSourceID(const EdgeID edge_id) const
 {
-    const auto &bucket = GetBucketReference(edge_id);
+    const auto bucket = GetBucketReference(edge_id);
     BOOST_ASSERT(bucket.size() >= 2);
     return bucket[bucket.size() - 2].node_id;
 }
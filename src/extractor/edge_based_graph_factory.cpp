@@ -1,10 +1,13 @@
 #include "extractor/edge_based_edge.hpp"
 #include "extractor/edge_based_graph_factory.hpp"
+#include "util/buffered_file.hpp"
+#include "util/intermediate_file.hpp"
 #include "util/coordinate.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/exception.hpp"
 #include "util/integer_range.hpp"
 #include "util/lua_util.hpp"
+#include "util/make_unique.hpp"
 #include "util/percent.hpp"
 #include "util/simple_logger.hpp"
 #include "util/timing_util.hpp"
@@ -12,16 +15,23 @@
 #include "extractor/guidance/toolkit.hpp"
 #include "extractor/guidance/turn_analysis.hpp"
 #include "extractor/guidance/turn_lane_handler.hpp"
+#include "extractor/scripting_environment.hpp"
 #include "extractor/suffix_table.hpp"
+#include "extractor/turn_cost_tables.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
 #include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <limits>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <unordered_map>
@@ -30,6 +40,84 @@ namespace osrm
 {
 namespace extractor
 {
+
+namespace
+{
+// number of node-based nodes that are analysed by one task of the edge expansion
+const constexpr NodeID EXPANSION_GRAINSIZE = 128;
+// number of node ranges that are analysed in parallel before their results are merged
+const constexpr NodeID EXPANSION_BATCH_RANGES = 1024;
+
+std::uint64_t ViaWayTurnKey(const EdgeID from_edge, const EdgeID via_edge)
+{
+    return static_cast<std::uint64_t>(from_edge) << 32 | via_edge;
+}
+
+// Interns a value into a table that numbers values in the order of their first appearance
+template <typename TableT>
+typename TableT::mapped_type InternValue(TableT &table, const typename TableT::key_type &value)
+{
+    const auto id = boost::numeric_cast<typename TableT::mapped_type>(table.size());
+    return table.insert({value, id}).first->second;
+}
+
+// Interns the values of a local table into the global one in local order and returns the global
+// id of every local id
+template <typename TableT>
+std::vector<typename TableT::mapped_type> MergeInternTable(const TableT &local, TableT &global)
+{
+    std::vector<const typename TableT::key_type *> local_values(local.size());
+    for (const auto &entry : local)
+        local_values[entry.second] = &entry.first;
+
+    std::vector<typename TableT::mapped_type> global_ids;
+    global_ids.reserve(local_values.size());
+    for (const auto *value : local_values)
+        global_ids.push_back(InternValue(global, *value));
+    return global_ids;
+}
+
+// The turns of a range of node-based nodes. The classes and lane data are interned into tables of
+// the buffer while the ranges are analysed in parallel. Their ids refer to these tables until the
+// buffers are merged in node order, so the output of the edge expansion does not depend on the
+// number of threads.
+struct EdgeExpansionBuffer
+{
+    struct IncomingEdge
+    {
+        NodeID node_u;
+        EdgeID edge_from_u;
+        EntryClassID entry_class;
+        BearingClassID bearing_class;
+        // the turns of this edge end at this index into turns
+        std::size_t turns_end;
+    };
+
+    struct Turn
+    {
+        EdgeID eid;
+        unsigned distance;
+        // entry class is unset, lane data id refers to lane_data_map
+        OriginalEdgeData data;
+    };
+
+    void Clear()
+    {
+        incoming_edges.clear();
+        turns.clear();
+        lane_data_map.clear();
+        entry_classes.clear();
+        bearing_classes.clear();
+    }
+
+    std::vector<IncomingEdge> incoming_edges;
+    std::vector<Turn> turns;
+    guidance::LaneDataIdMap lane_data_map;
+    std::unordered_map<util::guidance::EntryClass, EntryClassID> entry_classes;
+    std::unordered_map<util::guidance::BearingClass, BearingClassID> bearing_classes;
+};
+}
+
 // Configuration to find representative candidate for turn angle calculations
 
 EdgeBasedGraphFactory::EdgeBasedGraphFactory(
@@ -45,11 +133,23 @@ EdgeBasedGraphFactory::EdgeBasedGraphFactory(
     const std::vector<guidance::TurnLaneType::Mask> &turn_lane_masks)
     : m_max_edge_id(0), m_node_info_list(node_info_list),
       m_node_based_graph(std::move(node_based_graph)),
-      m_restriction_map(std::move(restriction_map)), m_barrier_nodes(barrier_nodes),
-      m_traffic_lights(traffic_lights), m_compressed_edge_container(compressed_edge_container),
+      m_restriction_map(std::move(restriction_map)),
+      m_compressed_edge_container(compressed_edge_container),
       profile_properties(std::move(profile_properties)), name_table(name_table),
       turn_lane_offsets(turn_lane_offsets), turn_lane_masks(turn_lane_masks)
 {
+    const auto number_of_nodes = m_node_based_graph->GetNumberOfNodes();
+    const auto to_flags = [number_of_nodes](const std::unordered_set<NodeID> &nodes) {
+        std::vector<bool> flags(number_of_nodes, false);
+        for (const auto node : nodes)
+        {
+            BOOST_ASSERT(node < number_of_nodes);
+            flags[node] = true;
+        }
+        return flags;
+    };
+    m_barrier_nodes = to_flags(barrier_nodes);
+    m_traffic_lights = to_flags(traffic_lights);
 }
 
 void EdgeBasedGraphFactory::GetEdgeBasedEdges(
@@ -87,6 +187,21 @@ void EdgeBasedGraphFactory::GetEdgeBasedNodeWeights(std::vector<EdgeWeight> &out
     swap(m_edge_based_node_weights, output_node_weights);
 }
 
+void EdgeBasedGraphFactory::GetDuplicatedNodes(std::vector<DuplicatedNode> &duplicated_nodes) const
+{
+    duplicated_nodes.clear();
+    for (const auto &via_edge_duplicates : m_via_way_duplicates_by_edge)
+    {
+        const auto original = m_node_based_graph->GetEdgeData(via_edge_duplicates.first).edge_id;
+        for (const auto duplicate_index : via_edge_duplicates.second)
+        {
+            duplicated_nodes.push_back(
+                {original, m_via_way_duplicates[duplicate_index].edge_based_node});
+        }
+    }
+    std::sort(duplicated_nodes.begin(), duplicated_nodes.end());
+}
+
 EdgeID EdgeBasedGraphFactory::GetHighestEdgeID() { return m_max_edge_id; }
 
 void EdgeBasedGraphFactory::InsertEdgeBasedNode(const NodeID node_u, const NodeID node_v)
@@ -171,7 +286,7 @@ void EdgeBasedGraphFactory::InsertEdgeBasedNode(const NodeID node_u, const NodeI
 }
 
 void EdgeBasedGraphFactory::FlushVectorToStream(
-    std::ofstream &edge_data_file, std::vector<OriginalEdgeData> &original_edge_data_vector) const
+    std::ostream &edge_data_file, std::vector<OriginalEdgeData> &original_edge_data_vector) const
 {
     if (original_edge_data_vector.empty())
     {
@@ -184,10 +299,14 @@ void EdgeBasedGraphFactory::FlushVectorToStream(
 
 void EdgeBasedGraphFactory::Run(const std::string &original_edge_data_filename,
                                 const std::string &turn_lane_data_filename,
-                                lua_State *lua_state,
+                                ScriptingEnvironment &scripting_environment,
                                 const std::string &edge_segment_lookup_filename,
                                 const std::string &edge_penalty_filename,
-                                const bool generate_edge_lookup)
+                                const std::string &segment_index_filename,
+                                const bool generate_edge_lookup,
+                                const bool compress_edge_data,
+                                const std::string &turn_cost_tables_filename,
+                                const bool generate_turn_cost_tables)
 {
     TIMER_START(renumber);
     m_max_edge_id = RenumberEdges() - 1;
@@ -196,15 +315,20 @@ void EdgeBasedGraphFactory::Run(const std::string &original_edge_data_filename,
     TIMER_START(generate_nodes);
     m_edge_based_node_weights.reserve(m_max_edge_id + 1);
     GenerateEdgeExpandedNodes();
+    GenerateViaWayNodes();
     TIMER_STOP(generate_nodes);
 
     TIMER_START(generate_edges);
     GenerateEdgeExpandedEdges(original_edge_data_filename,
                               turn_lane_data_filename,
-                              lua_state,
+                              scripting_environment,
                               edge_segment_lookup_filename,
                               edge_penalty_filename,
-                              generate_edge_lookup);
+                              segment_index_filename,
+                              generate_edge_lookup,
+                              compress_edge_data,
+                              turn_cost_tables_filename,
+                              generate_turn_cost_tables);
 
     TIMER_STOP(generate_edges);
 
@@ -296,34 +420,108 @@ void EdgeBasedGraphFactory::GenerateEdgeExpandedNodes()
                                  << " nodes in edge-expanded graph";
 }
 
+/// Creates the copies of via ways for the via-way restrictions. A copy has no geometry of its own
+/// and is never a start point, it is only reachable over the restricted from edge.
+void EdgeBasedGraphFactory::GenerateViaWayNodes()
+{
+    const auto forward_edge = [this](const NodeID from, const NodeID to) {
+        const auto edge = m_node_based_graph->FindEdge(from, to);
+        if (edge == SPECIAL_EDGEID || m_node_based_graph->GetEdgeData(edge).reversed)
+        {
+            return SPECIAL_EDGEID;
+        }
+        return edge;
+    };
+
+    std::size_t unsupported_restrictions = 0;
+    for (const auto &restriction : m_restriction_map->GetViaWayRestrictions())
+    {
+        // the via way has to be a single edge of the compressed graph
+        const auto from_edge = forward_edge(restriction.from, restriction.via_start);
+        const auto via_edge = forward_edge(restriction.via_start, restriction.via_end);
+        const auto to_edge = forward_edge(restriction.via_end, restriction.to);
+        if (from_edge == SPECIAL_EDGEID || via_edge == SPECIAL_EDGEID ||
+            to_edge == SPECIAL_EDGEID)
+        {
+            ++unsupported_restrictions;
+            continue;
+        }
+
+        const auto key = ViaWayTurnKey(from_edge, via_edge);
+        auto duplicate_iter = m_via_way_duplicate_by_turn.find(key);
+        if (duplicate_iter == m_via_way_duplicate_by_turn.end())
+        {
+            const auto via_node = m_node_based_graph->GetEdgeData(via_edge).edge_id;
+            m_edge_based_node_weights.push_back(m_edge_based_node_weights[via_node]);
+            m_via_way_duplicates.push_back({++m_max_edge_id, false, {}});
+            m_via_way_duplicates_by_edge[via_edge].push_back(m_via_way_duplicates.size() - 1);
+            duplicate_iter =
+                m_via_way_duplicate_by_turn.emplace(key, m_via_way_duplicates.size() - 1).first;
+        }
+
+        // same rules as for via nodes: there can be only one only_* restriction
+        auto &duplicate = m_via_way_duplicates[duplicate_iter->second];
+        if (duplicate.is_only && !duplicate.to_edges.empty())
+        {
+            continue;
+        }
+        if (restriction.is_only)
+        {
+            duplicate.is_only = true;
+            duplicate.to_edges.clear();
+        }
+        duplicate.to_edges.push_back(to_edge);
+    }
+
+    BOOST_ASSERT(m_max_edge_id + 1 == m_edge_based_node_weights.size());
+
+    util::SimpleLogger().Write() << "Duplicated " << m_via_way_duplicates.size()
+                                 << " edge-based nodes for "
+                                 << m_restriction_map->GetViaWayRestrictions().size()
+                                 << " via-way restrictions, " << unsupported_restrictions
+                                 << " skipped since their via way is not a single edge";
+}
+
 /// Actually it also generates OriginalEdgeData and serializes them...
 void EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(
     const std::string &original_edge_data_filename,
     const std::string &turn_lane_data_filename,
-    lua_State *lua_state,
+    ScriptingEnvironment &scripting_environment,
     const std::string &edge_segment_lookup_filename,
     const std::string &edge_fixed_penalties_filename,
-    const bool generate_edge_lookup)
+    const std::string &segment_index_filename,
+    const bool generate_edge_lookup,
+    const bool compress_edge_data,
+    const std::string &turn_cost_tables_filename,
+    const bool generate_turn_cost_tables)
 {
     util::SimpleLogger().Write() << "generating edge-expanded edges";
 
+    lua_State *lua_state = scripting_environment.GetContex().state;
     BOOST_ASSERT(lua_state != nullptr);
     const bool use_turn_function = util::luaFunctionExists(lua_state, "turn_function");
 
     std::size_t node_based_edge_counter = 0;
     std::size_t original_edges_counter = 0;
+    std::size_t via_way_turns_counter = 0;
     restricted_turns_counter = 0;
     skipped_uturns_counter = 0;
     skipped_barrier_turns_counter = 0;
 
-    std::ofstream edge_data_file(original_edge_data_filename.c_str(), std::ios::binary);
-    std::ofstream edge_segment_file;
-    std::ofstream edge_penalty_file;
+    util::IntermediateOutputFile edge_data_file(original_edge_data_filename, compress_edge_data);
+    std::unique_ptr<util::BufferedOutputFile> edge_segment_file;
+    std::unique_ptr<util::BufferedOutputFile> edge_penalty_file;
+    // position of the first segment of every edge-based edge in the .geometry file
+    std::vector<unsigned> geometry_indices;
+    std::vector<std::uint32_t> edge_first_segments;
 
     if (generate_edge_lookup)
     {
-        edge_segment_file.open(edge_segment_lookup_filename.c_str(), std::ios::binary);
-        edge_penalty_file.open(edge_fixed_penalties_filename.c_str(), std::ios::binary);
+        geometry_indices = m_compressed_edge_container.GetGeometryIndices();
+        edge_segment_file =
+            util::make_unique<util::BufferedOutputFile>(edge_segment_lookup_filename);
+        edge_penalty_file =
+            util::make_unique<util::BufferedOutputFile>(edge_fixed_penalties_filename);
     }
 
     // Writes a dummy value at the front that is updated later with the total length
@@ -339,113 +537,158 @@ void EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(
     // linear number of turns only.
     util::Percent progress(m_node_based_graph->GetNumberOfNodes());
     SuffixTable street_name_suffix_table(lua_state);
-    guidance::TurnAnalysis turn_analysis(*m_node_based_graph,
-                                         m_node_info_list,
-                                         *m_restriction_map,
-                                         m_barrier_nodes,
-                                         m_compressed_edge_container,
-                                         name_table,
-                                         street_name_suffix_table);
-    guidance::lanes::TurnLaneHandler turn_lane_handler(
+    // the turn analysis only has const members, all threads share it
+    const guidance::TurnAnalysis turn_analysis(*m_node_based_graph,
+                                               m_node_info_list,
+                                               *m_restriction_map,
+                                               m_barrier_nodes,
+                                               m_compressed_edge_container,
+                                               name_table,
+                                               street_name_suffix_table);
+    const guidance::lanes::TurnLaneHandler turn_lane_handler(
         *m_node_based_graph, turn_lane_offsets, turn_lane_masks, m_node_info_list, turn_analysis);
 
     bearing_class_by_node_based_node.resize(m_node_based_graph->GetNumberOfNodes(),
                                             std::numeric_limits<std::uint32_t>::max());
 
-    guidance::LaneDataIdMap lane_data_map;
-    for (const auto node_u : util::irange(0u, m_node_based_graph->GetNumberOfNodes()))
-    {
-        progress.PrintStatus(node_u);
-        for (const EdgeID edge_from_u : m_node_based_graph->GetAdjacentEdgeRange(node_u))
+    // Analyses all turns of the node-based nodes [begin, end). Runs concurrently for different
+    // ranges, so it must not touch anything but the buffer.
+    const auto expand_nodes = [&](const NodeID begin,
+                                  const NodeID end,
+                                  lua_State *local_lua_state,
+                                  EdgeExpansionBuffer &buffer) {
+        buffer.Clear();
+        for (const auto node_u : util::irange(begin, end))
         {
-            if (m_node_based_graph->GetEdgeData(edge_from_u).reversed)
+            for (const EdgeID edge_from_u : m_node_based_graph->GetAdjacentEdgeRange(node_u))
             {
-                continue;
-            }
-
-            const NodeID node_v = m_node_based_graph->GetTarget(edge_from_u);
-            ++node_based_edge_counter;
-            auto intersection = turn_analysis.getIntersection(node_u, edge_from_u);
-            intersection =
-                turn_analysis.assignTurnTypes(node_u, edge_from_u, std::move(intersection));
-
-            intersection = turn_lane_handler.assignTurnLanes(
-                node_u, edge_from_u, std::move(intersection), lane_data_map);
-            const auto possible_turns = turn_analysis.transformIntersectionIntoTurns(intersection);
-
-            // the entry class depends on the turn, so we have to classify the interesction for
-            // every edge
-            const auto turn_classification = classifyIntersection(node_v,
-                                                                  intersection,
-                                                                  *m_node_based_graph,
-                                                                  m_compressed_edge_container,
-                                                                  m_node_info_list);
-
-            const auto entry_class_id = [&](const util::guidance::EntryClass entry_class) {
-                if (0 == entry_class_hash.count(entry_class))
+                if (m_node_based_graph->GetEdgeData(edge_from_u).reversed)
                 {
-                    const auto id = static_cast<std::uint16_t>(entry_class_hash.size());
-                    entry_class_hash[entry_class] = id;
-                    return id;
+                    continue;
                 }
-                else
-                {
-                    return entry_class_hash.find(entry_class)->second;
-                }
-            }(turn_classification.first);
 
-            const auto bearing_class_id = [&](const util::guidance::BearingClass bearing_class) {
-                if (0 == bearing_class_hash.count(bearing_class))
-                {
-                    const auto id = static_cast<std::uint32_t>(bearing_class_hash.size());
-                    bearing_class_hash[bearing_class] = id;
-                    return id;
-                }
-                else
-                {
-                    return bearing_class_hash.find(bearing_class)->second;
-                }
-            }(turn_classification.second);
-            bearing_class_by_node_based_node[node_v] = bearing_class_id;
+                const NodeID node_v = m_node_based_graph->GetTarget(edge_from_u);
+                auto intersection = turn_analysis.getIntersection(node_u, edge_from_u);
+                intersection =
+                    turn_analysis.assignTurnTypes(node_u, edge_from_u, std::move(intersection));
 
-            for (const auto turn : possible_turns)
-            {
-                const double turn_angle = turn.angle;
+                intersection = turn_lane_handler.assignTurnLanes(
+                    node_u, edge_from_u, std::move(intersection), buffer.lane_data_map);
+                const auto possible_turns =
+                    turn_analysis.transformIntersectionIntoTurns(intersection);
+
+                // the entry class depends on the turn, so we have to classify the interesction
+                // for every edge
+                auto turn_classification = classifyIntersection(node_v,
+                                                                intersection,
+                                                                *m_node_based_graph,
+                                                                m_compressed_edge_container,
+                                                                m_node_info_list);
 
-                // only add an edge if turn is not prohibited
                 const EdgeData &edge_data1 = m_node_based_graph->GetEdgeData(edge_from_u);
-                const EdgeData &edge_data2 = m_node_based_graph->GetEdgeData(turn.eid);
+                for (const auto turn : possible_turns)
+                {
+                    // only add an edge if turn is not prohibited
+                    BOOST_ASSERT(edge_data1.edge_id !=
+                                 m_node_based_graph->GetEdgeData(turn.eid).edge_id);
+                    BOOST_ASSERT(!edge_data1.reversed);
+                    BOOST_ASSERT(!m_node_based_graph->GetEdgeData(turn.eid).reversed);
+
+                    // the following is the core of the loop.
+                    unsigned distance = edge_data1.distance;
+                    if (m_traffic_lights[node_v])
+                    {
+                        distance += profile_properties.traffic_signal_penalty;
+                    }
 
-                BOOST_ASSERT(edge_data1.edge_id != edge_data2.edge_id);
-                BOOST_ASSERT(!edge_data1.reversed);
-                BOOST_ASSERT(!edge_data2.reversed);
+                    const int turn_penalty =
+                        use_turn_function ? GetTurnPenalty(turn.angle, local_lua_state) : 0;
 
-                // the following is the core of the loop.
-                unsigned distance = edge_data1.distance;
-                if (m_traffic_lights.find(node_v) != m_traffic_lights.end())
-                {
-                    distance += profile_properties.traffic_signal_penalty;
+                    if (guidance::isUturn(turn.instruction))
+                    {
+                        distance += profile_properties.u_turn_penalty;
+                    }
+
+                    distance += turn_penalty;
+
+                    BOOST_ASSERT(m_compressed_edge_container.HasEntryForID(edge_from_u));
+                    buffer.turns.push_back(
+                        {turn.eid,
+                         distance,
+                         OriginalEdgeData(m_compressed_edge_container.GetPositionForID(edge_from_u),
+                                          edge_data1.name_id,
+                                          turn.lane_data_id,
+                                          turn.instruction,
+                                          INVALID_ENTRY_CLASSID,
+                                          edge_data1.travel_mode,
+                                          edge_data1.classes)});
                 }
 
-                const int turn_penalty =
-                    use_turn_function ? GetTurnPenalty(turn_angle, lua_state) : 0;
-                const auto turn_instruction = turn.instruction;
+                buffer.incoming_edges.push_back({node_u,
+                                                 edge_from_u,
+                                                 InternValue(buffer.entry_classes,
+                                                             turn_classification.first),
+                                                 InternValue(buffer.bearing_classes,
+                                                             turn_classification.second),
+                                                 buffer.turns.size()});
+            }
+        }
+    };
 
-                if (guidance::isUturn(turn_instruction))
-                {
-                    distance += profile_properties.u_turn_penalty;
-                }
+    guidance::LaneDataIdMap lane_data_map;
 
-                distance += turn_penalty;
+    // The turn costs of every node-based node as a degree x degree matrix over its adjacent edges,
+    // collected from the turns of its incoming edges
+    std::vector<std::vector<EdgeWeight>> intersection_costs;
+    if (generate_turn_cost_tables)
+    {
+        intersection_costs.resize(m_node_based_graph->GetNumberOfNodes());
+    }
+    const auto get_intersection_costs = [&](const NodeID node) -> std::vector<EdgeWeight> & {
+        auto &costs = intersection_costs[node];
+        if (costs.empty())
+        {
+            const std::size_t degree = m_node_based_graph->GetOutDegree(node);
+            costs.resize(degree * degree, INVALID_EDGE_WEIGHT);
+        }
+        return costs;
+    };
+
+    // Assigns ids in the same order as a sequential loop over all nodes would and writes out the
+    // turns of a buffer. Buffers need to be merged in the order of their node ranges.
+    const auto merge_buffer = [&](const EdgeExpansionBuffer &buffer) {
+        const auto lane_data_ids = MergeInternTable(buffer.lane_data_map, lane_data_map);
+        const auto entry_class_ids = MergeInternTable(buffer.entry_classes, entry_class_hash);
+        const auto bearing_class_ids =
+            MergeInternTable(buffer.bearing_classes, bearing_class_hash);
+
+        std::size_t turn_index = 0;
+        for (const auto &incoming_edge : buffer.incoming_edges)
+        {
+            ++node_based_edge_counter;
+            const NodeID node_u = incoming_edge.node_u;
+            const EdgeID edge_from_u = incoming_edge.edge_from_u;
+            const NodeID node_v = m_node_based_graph->GetTarget(edge_from_u);
+
+            const auto entry_class_id = entry_class_ids[incoming_edge.entry_class];
+            const auto bearing_class_id = bearing_class_ids[incoming_edge.bearing_class];
+            bearing_class_by_node_based_node[node_v] = bearing_class_id;
+
+            // Writes out the turn from edge_from_u as the edge-based edge between the given
+            // edge-based nodes, they differ from the ones of the node-based edges for via ways
+            const auto write_turn = [&](const EdgeExpansionBuffer::Turn &turn,
+                                        const NodeID source_edge_based_node,
+                                        const NodeID target_edge_based_node) {
+                const EdgeData &edge_data1 = m_node_based_graph->GetEdgeData(edge_from_u);
 
-                BOOST_ASSERT(m_compressed_edge_container.HasEntryForID(edge_from_u));
-                original_edge_data_vector.emplace_back(
-                    m_compressed_edge_container.GetPositionForID(edge_from_u),
-                    edge_data1.name_id,
-                    turn.lane_data_id,
-                    turn_instruction,
-                    entry_class_id,
-                    edge_data1.travel_mode);
+                original_edge_data_vector.push_back(turn.data);
+                auto &original_edge_data = original_edge_data_vector.back();
+                original_edge_data.entry_classid = entry_class_id;
+                if (original_edge_data.lane_data_id < lane_data_ids.size())
+                {
+                    original_edge_data.lane_data_id =
+                        lane_data_ids[original_edge_data.lane_data_id];
+                }
 
                 ++original_edges_counter;
 
@@ -454,21 +697,21 @@ void EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(
                     FlushVectorToStream(edge_data_file, original_edge_data_vector);
                 }
 
-                BOOST_ASSERT(SPECIAL_NODEID != edge_data1.edge_id);
-                BOOST_ASSERT(SPECIAL_NODEID != edge_data2.edge_id);
+                BOOST_ASSERT(SPECIAL_NODEID != source_edge_based_node);
+                BOOST_ASSERT(SPECIAL_NODEID != target_edge_based_node);
 
                 // NOTE: potential overflow here if we hit 2^32 routable edges
                 BOOST_ASSERT(m_edge_based_edge_list.size() <= std::numeric_limits<NodeID>::max());
-                m_edge_based_edge_list.emplace_back(edge_data1.edge_id,
-                                                    edge_data2.edge_id,
+                m_edge_based_edge_list.emplace_back(source_edge_based_node,
+                                                    target_edge_based_node,
                                                     m_edge_based_edge_list.size(),
-                                                    distance,
+                                                    turn.distance,
                                                     true,
                                                     false);
 
                 // Here is where we write out the mapping between the edge-expanded edges, and
                 // the node-based edges that are originally used to calculate the `distance`
-                // for the edge-expanded edges.  About 40 lines back, there is:
+                // for the edge-expanded edges.  In expand_nodes, there is:
                 //
                 //                 unsigned distance = edge_data1.distance;
                 //
@@ -489,8 +732,11 @@ void EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(
 
                     lookup::SegmentHeaderBlock header = {node_count, first_node.node_id};
 
-                    edge_segment_file.write(reinterpret_cast<const char *>(&header),
-                                            sizeof(header));
+                    edge_segment_file->write(reinterpret_cast<const char *>(&header),
+                                             sizeof(header));
+                    edge_first_segments.push_back(
+                        geometry_indices[m_compressed_edge_container.GetPositionForID(
+                            edge_from_u)]);
 
                     for (auto target_node : node_based_edges)
                     {
@@ -502,8 +748,8 @@ void EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(
                         lookup::SegmentBlock nodeblock = {
                             to.node_id, segment_length, target_node.weight};
 
-                        edge_segment_file.write(reinterpret_cast<const char *>(&nodeblock),
-                                                sizeof(nodeblock));
+                        edge_segment_file->write(reinterpret_cast<const char *>(&nodeblock),
+                                                 sizeof(nodeblock));
                         previous = target_node.node_id;
                     }
 
@@ -530,21 +776,110 @@ void EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(
                         m_node_info_list[m_compressed_edge_container.GetFirstEdgeTargetID(
                             turn.eid)];
 
-                    const unsigned fixed_penalty = distance - edge_data1.distance;
+                    const unsigned fixed_penalty = turn.distance - edge_data1.distance;
                     lookup::PenaltyBlock penaltyblock = {
                         fixed_penalty, from_node.node_id, via_node.node_id, to_node.node_id};
-                    edge_penalty_file.write(reinterpret_cast<const char *>(&penaltyblock),
-                                            sizeof(penaltyblock));
+                    edge_penalty_file->write(reinterpret_cast<const char *>(&penaltyblock),
+                                             sizeof(penaltyblock));
+                }
+            };
+
+            const auto duplicates_iter = m_via_way_duplicates_by_edge.find(edge_from_u);
+            for (; turn_index < incoming_edge.turns_end; ++turn_index)
+            {
+                const auto &turn = buffer.turns[turn_index];
+                if (generate_turn_cost_tables)
+                {
+                    auto &costs = get_intersection_costs(node_v);
+                    const auto degree = m_node_based_graph->GetOutDegree(node_v);
+                    const auto first_edge = m_node_based_graph->BeginEdges(node_v);
+                    const auto from = m_node_based_graph->FindEdge(node_v, node_u) - first_edge;
+                    const auto to = turn.eid - first_edge;
+                    costs[from * degree + to] =
+                        turn.distance - m_node_based_graph->GetEdgeData(edge_from_u).distance;
+                }
+                const NodeID source_node = m_node_based_graph->GetEdgeData(edge_from_u).edge_id;
+                NodeID target_node = m_node_based_graph->GetEdgeData(turn.eid).edge_id;
+
+                // turning from the from edge of a via-way restriction enters its duplicate
+                const auto duplicate_iter =
+                    m_via_way_duplicate_by_turn.find(ViaWayTurnKey(edge_from_u, turn.eid));
+                if (duplicate_iter != m_via_way_duplicate_by_turn.end())
+                {
+                    target_node = m_via_way_duplicates[duplicate_iter->second].edge_based_node;
+                }
+
+                write_turn(turn, source_node, target_node);
+
+                // the duplicates of a via way leave it by the turns their restriction allows
+                if (duplicates_iter != m_via_way_duplicates_by_edge.end())
+                {
+                    for (const auto duplicate_index : duplicates_iter->second)
+                    {
+                        const auto &duplicate = m_via_way_duplicates[duplicate_index];
+                        if (duplicate.IsAllowed(turn.eid))
+                        {
+                            write_turn(turn, duplicate.edge_based_node, target_node);
+                            ++via_way_turns_counter;
+                        }
+                    }
                 }
             }
         }
+    };
+
+    // The nodes are expanded in batches of ranges: the ranges of a batch are analysed in
+    // parallel, then their buffers are merged in order. This bounds the size of the buffers.
+    const NodeID number_of_nodes = m_node_based_graph->GetNumberOfNodes();
+    const NodeID batch_size = EXPANSION_GRAINSIZE * EXPANSION_BATCH_RANGES;
+    std::vector<EdgeExpansionBuffer> buffers;
+    for (NodeID batch_begin = 0; batch_begin < number_of_nodes; batch_begin += batch_size)
+    {
+        const NodeID batch_end = std::min(number_of_nodes, batch_begin + batch_size);
+        buffers.resize((batch_end - batch_begin + EXPANSION_GRAINSIZE - 1) / EXPANSION_GRAINSIZE);
+
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, buffers.size()),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                // every thread needs its own lua state for the turn penalties
+                lua_State *local_lua_state = scripting_environment.GetContex().state;
+                for (auto index = range.begin(); index != range.end(); ++index)
+                {
+                    const NodeID begin = batch_begin + index * EXPANSION_GRAINSIZE;
+                    const NodeID end = std::min(batch_end, begin + EXPANSION_GRAINSIZE);
+                    expand_nodes(begin, end, local_lua_state, buffers[index]);
+                }
+            });
+
+        for (const auto &buffer : buffers)
+        {
+            merge_buffer(buffer);
+        }
+        progress.PrintStatus(batch_end - 1);
     }
 
     util::SimpleLogger().Write() << "Created " << entry_class_hash.size() << " entry classes and "
                                  << bearing_class_hash.size() << " Bearing Classes";
 
+    if (generate_turn_cost_tables)
+    {
+        TurnCostTables turn_cost_tables;
+        for (const auto node : util::irange(0u, m_node_based_graph->GetNumberOfNodes()))
+        {
+            turn_cost_tables.AddIntersection(get_intersection_costs(node));
+            std::vector<EdgeWeight>().swap(intersection_costs[node]);
+        }
+        turn_cost_tables.Write(turn_cost_tables_filename);
+        util::SimpleLogger().Write()
+            << "Wrote " << turn_cost_tables.GetNumberOfTables() << " turn cost tables for "
+            << turn_cost_tables.GetNumberOfIntersections() << " intersections, "
+            << turn_cost_tables.GetSize() / (1024 * 1024) << " MiB instead of "
+            << m_edge_based_edge_list.size() * sizeof(EdgeBasedEdge) / (1024 * 1024)
+            << " MiB of edge-based edges";
+    }
+
     util::SimpleLogger().Write() << "Writing Turn Lane Data to File...";
-    std::ofstream turn_lane_data_file(turn_lane_data_filename.c_str(), std::ios::binary);
+    util::BufferedOutputFile turn_lane_data_file(turn_lane_data_filename);
     std::vector<util::guidance::LaneTupelIdPair> lane_data(lane_data_map.size());
     // extract lane data sorted by ID
     for (auto itr : lane_data_map)
@@ -556,6 +891,7 @@ void EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(
     if (!lane_data.empty())
         turn_lane_data_file.write(reinterpret_cast<const char *>(&lane_data[0]),
                                   sizeof(util::guidance::LaneTupelIdPair) * lane_data.size());
+    turn_lane_data_file.close();
 
     util::SimpleLogger().Write() << "done.";
 
@@ -568,6 +904,13 @@ void EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(
     static_assert(sizeof(length_prefix_empty_space) == sizeof(length_prefix), "type mismatch");
 
     edge_data_file.write(reinterpret_cast<const char *>(&length_prefix), sizeof(length_prefix));
+    edge_data_file.close();
+    if (generate_edge_lookup)
+    {
+        edge_segment_file->close();
+        edge_penalty_file->close();
+        WriteSegmentIndex(segment_index_filename, geometry_indices, edge_first_segments);
+    }
 
     util::SimpleLogger().Write() << "Generated " << m_edge_based_node_list.size()
                                  << " edge based nodes";
@@ -578,11 +921,72 @@ void EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(
     util::SimpleLogger().Write() << "  skips " << restricted_turns_counter << " turns, "
                                                                               "defined by "
                                  << m_restriction_map->size() << " restrictions";
+    util::SimpleLogger().Write() << "  contains " << via_way_turns_counter
+                                 << " edges leaving the duplicates of "
+                                 << m_via_way_duplicates.size() << " via ways";
     util::SimpleLogger().Write() << "  skips " << skipped_uturns_counter << " U turns";
     util::SimpleLogger().Write() << "  skips " << skipped_barrier_turns_counter
                                  << " turns over barriers";
 }
 
+void EdgeBasedGraphFactory::WriteSegmentIndex(
+    const std::string &segment_index_filename,
+    const std::vector<unsigned> &geometry_indices,
+    const std::vector<std::uint32_t> &edge_first_segments) const
+{
+    // every directed node-based edge has a geometry of its own, starting at its source
+    std::vector<lookup::SegmentIndexBlock> segments;
+    segments.reserve(geometry_indices.back());
+    for (const auto node_u : util::irange(0u, m_node_based_graph->GetNumberOfNodes()))
+    {
+        for (const EdgeID edge : m_node_based_graph->GetAdjacentEdgeRange(node_u))
+        {
+            if (!m_compressed_edge_container.HasEntryForID(edge))
+            {
+                continue;
+            }
+            std::uint32_t segment =
+                geometry_indices[m_compressed_edge_container.GetPositionForID(edge)];
+            NodeID previous = node_u;
+            for (const auto &target : m_compressed_edge_container.GetBucketReference(edge))
+            {
+                const QueryNode &from = m_node_info_list[previous];
+                const QueryNode &to = m_node_info_list[target.node_id];
+                segments.push_back({from.node_id,
+                                    to.node_id,
+                                    segment++,
+                                    util::coordinate_calculation::greatCircleDistance(from, to)});
+                previous = target.node_id;
+            }
+        }
+    }
+    tbb::parallel_sort(segments.begin(),
+                       segments.end(),
+                       [](const lookup::SegmentIndexBlock &lhs,
+                          const lookup::SegmentIndexBlock &rhs) {
+                           return lhs.from_id < rhs.from_id ||
+                                  (lhs.from_id == rhs.from_id && lhs.to_id < rhs.to_id);
+                       });
+
+    util::BufferedOutputFile segment_index_file(segment_index_filename);
+    const std::uint64_t number_of_geometry_segments = geometry_indices.back();
+    const std::uint64_t number_of_segments = segments.size();
+    const std::uint64_t number_of_edges = edge_first_segments.size();
+    segment_index_file.write(reinterpret_cast<const char *>(&number_of_geometry_segments),
+                             sizeof(number_of_geometry_segments));
+    segment_index_file.write(reinterpret_cast<const char *>(&number_of_segments),
+                             sizeof(number_of_segments));
+    segment_index_file.write(reinterpret_cast<const char *>(segments.data()),
+                             segments.size() * sizeof(lookup::SegmentIndexBlock));
+    segment_index_file.write(reinterpret_cast<const char *>(&number_of_edges),
+                             sizeof(number_of_edges));
+    segment_index_file.write(reinterpret_cast<const char *>(edge_first_segments.data()),
+                             edge_first_segments.size() * sizeof(std::uint32_t));
+    segment_index_file.close();
+
+    util::SimpleLogger().Write() << "Wrote the index of " << number_of_segments << " segments";
+}
+
 std::vector<util::guidance::BearingClass> EdgeBasedGraphFactory::GetBearingClasses() const
 {
     std::vector<util::guidance::BearingClass> result(bearing_class_hash.size());
@@ -1,11 +1,14 @@
 #include "extractor/extraction_containers.hpp"
 #include "extractor/extraction_way.hpp"
 
+#include "util/buffered_file.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/range_table.hpp"
 
 #include "util/exception.hpp"
 #include "util/fingerprint.hpp"
+#include "util/hilbert_value.hpp"
+#include "util/integer_range.hpp"
 #include "util/io.hpp"
 #include "util/lua_util.hpp"
 #include "util/simple_logger.hpp"
@@ -15,14 +18,23 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/numeric/conversion/cast.hpp>
+#include <boost/optional.hpp>
 #include <boost/ref.hpp>
 
 #include <luabind/luabind.hpp>
 
 #include <stxxl/sort>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
 #include <chrono>
+#include <iterator>
 #include <limits>
+#include <utility>
+#include <vector>
 
 namespace
 {
@@ -42,9 +54,14 @@ namespace osrm
 namespace extractor
 {
 
-static const int WRITE_BLOCK_BUFFER_SIZE = 8000;
+// number of edges PrepareEdges holds in main memory to process them in parallel
+static const constexpr std::size_t EDGE_BATCH_SIZE = 1 << 20;
 
-ExtractionContainers::ExtractionContainers()
+ExtractionContainers::ExtractionContainers(const ExtractorConfig &config)
+    : sort_algorithm(config.sort_algorithm),
+      sorter(config.sort_memory,
+             boost::filesystem::absolute(config.output_file_name).parent_path()),
+      spatial_node_order(config.spatial_node_order)
 {
     // Check if stxxl can be instantiated
     stxxl::vector<unsigned> dummy_vector;
@@ -59,6 +76,80 @@ ExtractionContainers::ExtractionContainers()
     turn_lane_offsets.push_back(0);
 }
 
+template <typename VectorT, typename Compare>
+void ExtractionContainers::Sort(VectorT &vector, Compare compare)
+{
+    if (sort_algorithm == ExtractorConfig::SortAlgorithm::STXXL)
+    {
+        stxxl::sort(vector.begin(), vector.end(), compare, stxxl_memory);
+    }
+    else
+    {
+        sorter.Sort(vector.begin(), vector.end(), compare);
+    }
+}
+
+// The merge join with the nodes runs sequentially over the external memory. The callbacks for
+// a batch of edges copied to main memory run in parallel.
+template <typename GetNodeID, typename OnMatch, typename OnMiss>
+void ExtractionContainers::JoinEdgesWithNodes(GetNodeID get_node_id,
+                                              OnMatch on_match,
+                                              OnMiss on_miss,
+                                              const bool skip_invalid_sources)
+{
+    const auto is_skipped = [skip_invalid_sources](const InternalExtractorEdge &edge) {
+        return skip_invalid_sources && edge.result.source == SPECIAL_NODEID;
+    };
+
+    std::vector<InternalExtractorEdge> edge_batch;
+    // matched node of every edge in the batch, nullptr if there is none
+    std::vector<const ExternalMemoryNode *> edge_nodes;
+    std::vector<ExternalMemoryNode> node_batch;
+
+    auto node_iterator = all_nodes_list.begin();
+    const auto all_nodes_list_end = all_nodes_list.end();
+    for (auto batch_begin = all_edges_list.begin(); batch_begin != all_edges_list.end();)
+    {
+        const auto batch_size = std::min<std::size_t>(
+            EDGE_BATCH_SIZE, std::distance(batch_begin, all_edges_list.end()));
+        const auto batch_end = batch_begin + batch_size;
+        edge_batch.assign(batch_begin, batch_end);
+        edge_nodes.assign(batch_size, nullptr);
+        node_batch.clear();
+        node_batch.reserve(batch_size);
+
+        for (std::size_t index = 0; index < batch_size; ++index)
+        {
+            const auto &edge = edge_batch[index];
+            if (is_skipped(edge))
+                continue;
+            const auto node_id = get_node_id(edge);
+            while (node_iterator != all_nodes_list_end && node_iterator->node_id < node_id)
+                ++node_iterator;
+            if (node_iterator != all_nodes_list_end && node_iterator->node_id == node_id)
+            {
+                // the batch has the capacity for all edges, pointers into it stay valid
+                node_batch.push_back(*node_iterator);
+                edge_nodes[index] = &node_batch.back();
+            }
+        }
+
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, batch_size),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto index = range.begin(); index != range.end(); ++index)
+                              {
+                                  if (edge_nodes[index])
+                                      on_match(edge_batch[index], *edge_nodes[index]);
+                                  else if (!is_skipped(edge_batch[index]))
+                                      on_miss(edge_batch[index]);
+                              }
+                          });
+
+        std::copy(edge_batch.begin(), edge_batch.end(), batch_begin);
+        batch_begin = batch_end;
+    }
+}
+
 /**
  * Processes the collected data and serializes it.
  * At this point nodes are still referenced by their OSM id.
@@ -73,21 +164,22 @@ void ExtractionContainers::PrepareData(const std::string &output_file_name,
                                        const std::string &restrictions_file_name,
                                        const std::string &name_file_name,
                                        const std::string &turn_lane_file_name,
-                                       lua_State *segment_state)
+                                       ScriptingEnvironment &scripting_environment)
 {
     try
     {
-        std::ofstream file_out_stream;
-        file_out_stream.open(output_file_name.c_str(), std::ios::binary);
+        util::BufferedOutputFile file_out_stream(output_file_name);
         const util::FingerPrint fingerprint = util::FingerPrint::GetValid();
         file_out_stream.write((char *)&fingerprint, sizeof(util::FingerPrint));
 
         PrepareNodes();
         WriteNodes(file_out_stream);
-        PrepareEdges(segment_state);
+        PrepareEdges(scripting_environment);
         WriteEdges(file_out_stream);
+        file_out_stream.close();
 
         PrepareRestrictions();
+        PrepareViaWayRestrictions();
         WriteRestrictions(restrictions_file_name);
 
         WriteCharData(name_file_name, name_lengths, name_char_data);
@@ -107,7 +199,7 @@ void ExtractionContainers::WriteTurnLaneMasks(
     util::SimpleLogger().Write() << "Writing turn lane masks...";
     TIMER_START(turn_lane_timer);
 
-    std::ofstream ofs(file_name, std::ios::binary);
+    util::BufferedOutputFile ofs(file_name);
 
     if (!util::serializeVector(ofs, offsets))
     {
@@ -120,6 +212,7 @@ void ExtractionContainers::WriteTurnLaneMasks(
         util::SimpleLogger().Write(logWARNING) << "Error while writing.";
         return;
     }
+    ofs.close();
 
     TIMER_STOP(turn_lane_timer);
     util::SimpleLogger().Write() << "done (" << TIMER_SEC(turn_lane_timer) << ")";
@@ -131,7 +224,7 @@ void ExtractionContainers::WriteCharData(const std::string &file_name,
 {
     std::cout << "[extractor] writing street name index ... " << std::flush;
     TIMER_START(write_index);
-    boost::filesystem::ofstream file_stream(file_name, std::ios::binary);
+    util::BufferedOutputFile file_stream(file_name);
 
     unsigned total_length = 0;
 
@@ -147,21 +240,11 @@ void ExtractionContainers::WriteCharData(const std::string &file_name,
     file_stream.write((char *)&total_length, sizeof(unsigned));
 
     // write all chars consecutively
-    char write_buffer[WRITE_BLOCK_BUFFER_SIZE];
-    unsigned buffer_len = 0;
-
     for (const auto c : char_data)
     {
-        write_buffer[buffer_len++] = c;
-
-        if (buffer_len >= WRITE_BLOCK_BUFFER_SIZE)
-        {
-            file_stream.write(write_buffer, WRITE_BLOCK_BUFFER_SIZE);
-            buffer_len = 0;
-        }
+        file_stream.put(c);
     }
-
-    file_stream.write(write_buffer, buffer_len);
+    file_stream.close();
 
     TIMER_STOP(write_index);
     std::cout << "ok, after " << TIMER_SEC(write_index) << "s" << std::endl;
@@ -171,8 +254,7 @@ void ExtractionContainers::PrepareNodes()
 {
     std::cout << "[extractor] Sorting used nodes        ... " << std::flush;
     TIMER_START(sorting_used_nodes);
-    stxxl::sort(
-        used_node_id_list.begin(), used_node_id_list.end(), OSMNodeIDSTXXLLess(), stxxl_memory);
+    Sort(used_node_id_list, OSMNodeIDSTXXLLess());
     TIMER_STOP(sorting_used_nodes);
     std::cout << "ok, after " << TIMER_SEC(sorting_used_nodes) << "s" << std::endl;
 
@@ -185,10 +267,7 @@ void ExtractionContainers::PrepareNodes()
 
     std::cout << "[extractor] Sorting all nodes         ... " << std::flush;
     TIMER_START(sorting_nodes);
-    stxxl::sort(all_nodes_list.begin(),
-                all_nodes_list.end(),
-                ExternalMemoryNodeSTXXLCompare(),
-                stxxl_memory);
+    Sort(all_nodes_list, ExternalMemoryNodeSTXXLCompare());
     TIMER_STOP(sorting_nodes);
     std::cout << "ok, after " << TIMER_SEC(sorting_nodes) << "s" << std::endl;
 
@@ -204,6 +283,12 @@ void ExtractionContainers::PrepareNodes()
     // because we usually route on a *lot* less than 2^32 of the OSM
     // graph nodes.
     std::uint64_t internal_id = 0;
+    // hilbert code of every used node, with its id in OSM order
+    std::vector<std::pair<std::uint64_t, NodeID>> spatial_order;
+    if (spatial_node_order)
+    {
+        spatial_order.reserve(used_node_id_list.size());
+    }
 
     // compute the intersection of nodes that were referenced and nodes we actually have
     while (node_iter != all_nodes_list_end && ref_iter != used_node_id_list_end)
@@ -219,6 +304,12 @@ void ExtractionContainers::PrepareNodes()
             continue;
         }
         BOOST_ASSERT(node_iter->node_id == *ref_iter);
+        if (spatial_node_order)
+        {
+            spatial_order.emplace_back(
+                util::hilbertCode(util::Coordinate(node_iter->lon, node_iter->lat)),
+                static_cast<NodeID>(internal_id));
+        }
         external_to_internal_node_id_map[*ref_iter] = static_cast<NodeID>(internal_id++);
         node_iter++;
         ref_iter++;
@@ -231,193 +322,161 @@ void ExtractionContainers::PrepareNodes()
     max_internal_node_id = boost::numeric_cast<NodeID>(internal_id);
     TIMER_STOP(id_map);
     std::cout << "ok, after " << TIMER_SEC(id_map) << "s" << std::endl;
+
+    if (spatial_node_order)
+    {
+        // Neighbouring nodes of a path get close ids, so unpacking and assembling its geometry
+        // reads the coordinates from few pages. The edge based nodes are numbered by their node
+        // based nodes and the compressed geometries in the order they are compressed, both
+        // follow the new order.
+        std::cout << "[extractor] Ordering nodes spatially  ... " << std::flush;
+        TIMER_START(spatial_order_timer);
+        tbb::parallel_sort(spatial_order.begin(), spatial_order.end());
+        std::vector<NodeID> spatial_ids(spatial_order.size());
+        for (const auto spatial_id : util::irange<NodeID>(0, spatial_order.size()))
+        {
+            spatial_ids[spatial_order[spatial_id].second] = spatial_id;
+        }
+        for (auto &osm_and_internal_id : external_to_internal_node_id_map)
+        {
+            osm_and_internal_id.second = spatial_ids[osm_and_internal_id.second];
+        }
+        TIMER_STOP(spatial_order_timer);
+        std::cout << "ok, after " << TIMER_SEC(spatial_order_timer) << "s" << std::endl;
+    }
 }
 
-void ExtractionContainers::PrepareEdges(lua_State *segment_state)
+void ExtractionContainers::PrepareEdges(ScriptingEnvironment &scripting_environment)
 {
     // Sort edges by start.
     std::cout << "[extractor] Sorting edges by start    ... " << std::flush;
     TIMER_START(sort_edges_by_start);
-    stxxl::sort(all_edges_list.begin(), all_edges_list.end(), CmpEdgeByOSMStartID(), stxxl_memory);
+    Sort(all_edges_list, CmpEdgeByOSMStartID());
     TIMER_STOP(sort_edges_by_start);
     std::cout << "ok, after " << TIMER_SEC(sort_edges_by_start) << "s" << std::endl;
 
     std::cout << "[extractor] Setting start coords      ... " << std::flush;
     TIMER_START(set_start_coords);
     // Traverse list of edges and nodes in parallel and set start coord
-    auto node_iterator = all_nodes_list.begin();
-    auto edge_iterator = all_edges_list.begin();
-
-    const auto all_edges_list_end = all_edges_list.end();
-    const auto all_nodes_list_end = all_nodes_list.end();
-
-    while (edge_iterator != all_edges_list_end && node_iterator != all_nodes_list_end)
-    {
-        if (edge_iterator->result.osm_source_id < node_iterator->node_id)
-        {
-            util::SimpleLogger().Write(LogLevel::logWARNING) << "Found invalid node reference "
-                                                             << edge_iterator->result.source;
-            edge_iterator->result.source = SPECIAL_NODEID;
-            ++edge_iterator;
-            continue;
-        }
-        if (edge_iterator->result.osm_source_id > node_iterator->node_id)
-        {
-            node_iterator++;
-            continue;
-        }
-
-        // remove loops
-        if (edge_iterator->result.osm_source_id == edge_iterator->result.osm_target_id)
-        {
-            edge_iterator->result.source = SPECIAL_NODEID;
-            edge_iterator->result.target = SPECIAL_NODEID;
-            ++edge_iterator;
-            continue;
-        }
-
-        BOOST_ASSERT(edge_iterator->result.osm_source_id == node_iterator->node_id);
-
-        // assign new node id
-        auto id_iter = external_to_internal_node_id_map.find(node_iterator->node_id);
-        BOOST_ASSERT(id_iter != external_to_internal_node_id_map.end());
-        edge_iterator->result.source = id_iter->second;
-
-        edge_iterator->source_coordinate.lat = node_iterator->lat;
-        edge_iterator->source_coordinate.lon = node_iterator->lon;
-        ++edge_iterator;
-    }
+    JoinEdgesWithNodes(
+        [](const InternalExtractorEdge &edge) { return edge.result.osm_source_id; },
+        [&](InternalExtractorEdge &edge, const ExternalMemoryNode &node) {
+            // remove loops
+            if (edge.result.osm_source_id == edge.result.osm_target_id)
+            {
+                edge.result.source = SPECIAL_NODEID;
+                edge.result.target = SPECIAL_NODEID;
+                return;
+            }
 
-    // Remove all remaining edges. They are invalid because there are no corresponding nodes for
-    // them. This happens when using osmosis with bbox or polygon to extract smaller areas.
-    auto markSourcesInvalid = [](InternalExtractorEdge &edge) {
-        util::SimpleLogger().Write(LogLevel::logWARNING) << "Found invalid node reference "
-                                                         << edge.result.source;
-        edge.result.source = SPECIAL_NODEID;
-        edge.result.osm_source_id = SPECIAL_OSM_NODEID;
-    };
-    std::for_each(edge_iterator, all_edges_list_end, markSourcesInvalid);
+            // assign new node id
+            auto id_iter = external_to_internal_node_id_map.find(node.node_id);
+            BOOST_ASSERT(id_iter != external_to_internal_node_id_map.end());
+            edge.result.source = id_iter->second;
+
+            edge.source_coordinate.lat = node.lat;
+            edge.source_coordinate.lon = node.lon;
+        },
+        // Invalid because there are no corresponding nodes for them. This happens when using
+        // osmosis with bbox or polygon to extract smaller areas.
+        [](InternalExtractorEdge &edge) {
+            util::SimpleLogger().Write(LogLevel::logWARNING)
+                << "Found invalid node reference "
+                << static_cast<uint64_t>(edge.result.osm_source_id);
+            edge.result.source = SPECIAL_NODEID;
+            edge.result.osm_source_id = SPECIAL_OSM_NODEID;
+        },
+        false);
     TIMER_STOP(set_start_coords);
     std::cout << "ok, after " << TIMER_SEC(set_start_coords) << "s" << std::endl;
 
     // Sort Edges by target
     std::cout << "[extractor] Sorting edges by target   ... " << std::flush;
     TIMER_START(sort_edges_by_target);
-    stxxl::sort(all_edges_list.begin(), all_edges_list.end(), CmpEdgeByOSMTargetID(), stxxl_memory);
+    Sort(all_edges_list, CmpEdgeByOSMTargetID());
     TIMER_STOP(sort_edges_by_target);
     std::cout << "ok, after " << TIMER_SEC(sort_edges_by_target) << "s" << std::endl;
 
     // Compute edge weights
     std::cout << "[extractor] Computing edge weights    ... " << std::flush;
     TIMER_START(compute_weights);
-    node_iterator = all_nodes_list.begin();
-    edge_iterator = all_edges_list.begin();
-    const auto all_edges_list_end_ = all_edges_list.end();
-    const auto all_nodes_list_end_ = all_nodes_list.end();
 
-    const auto has_segment_function = util::luaFunctionExists(segment_state, "segment_function");
+    // the segment function runs with the profile state of the thread processing the edge
+    const auto has_segment_function =
+        util::luaFunctionExists(scripting_environment.GetContex().state, "segment_function");
 
-    while (edge_iterator != all_edges_list_end_ && node_iterator != all_nodes_list_end_)
-    {
-        // skip all invalid edges
-        if (edge_iterator->result.source == SPECIAL_NODEID)
-        {
-            ++edge_iterator;
-            continue;
-        }
+    JoinEdgesWithNodes(
+        [](const InternalExtractorEdge &edge) { return edge.result.osm_target_id; },
+        [&](InternalExtractorEdge &edge, const ExternalMemoryNode &node) {
+            BOOST_ASSERT(edge.weight_data.speed >= 0);
+            BOOST_ASSERT(edge.source_coordinate.lat !=
+                         util::FixedLatitude{std::numeric_limits<std::int32_t>::min()});
+            BOOST_ASSERT(edge.source_coordinate.lon !=
+                         util::FixedLongitude{std::numeric_limits<std::int32_t>::min()});
 
-        if (edge_iterator->result.osm_target_id < node_iterator->node_id)
-        {
-            util::SimpleLogger().Write(LogLevel::logWARNING)
-                << "Found invalid node reference "
-                << static_cast<uint64_t>(edge_iterator->result.osm_target_id);
-            edge_iterator->result.target = SPECIAL_NODEID;
-            ++edge_iterator;
-            continue;
-        }
-        if (edge_iterator->result.osm_target_id > node_iterator->node_id)
-        {
-            ++node_iterator;
-            continue;
-        }
-
-        BOOST_ASSERT(edge_iterator->result.osm_target_id == node_iterator->node_id);
-        BOOST_ASSERT(edge_iterator->weight_data.speed >= 0);
-        BOOST_ASSERT(edge_iterator->source_coordinate.lat !=
-                     util::FixedLatitude{std::numeric_limits<std::int32_t>::min()});
-        BOOST_ASSERT(edge_iterator->source_coordinate.lon !=
-                     util::FixedLongitude{std::numeric_limits<std::int32_t>::min()});
-
-        const double distance = util::coordinate_calculation::greatCircleDistance(
-            edge_iterator->source_coordinate,
-            util::Coordinate(node_iterator->lon, node_iterator->lat));
-
-        if (has_segment_function)
-        {
-            luabind::call_function<void>(segment_state,
-                                         "segment_function",
-                                         boost::cref(edge_iterator->source_coordinate),
-                                         boost::cref(*node_iterator),
-                                         distance,
-                                         boost::ref(edge_iterator->weight_data));
-        }
+            const double distance = util::coordinate_calculation::greatCircleDistance(
+                edge.source_coordinate, util::Coordinate(node.lon, node.lat));
 
-        const double weight = [distance](const InternalExtractorEdge::WeightData &data) {
-            switch (data.type)
+            if (has_segment_function)
             {
-            case InternalExtractorEdge::WeightType::EDGE_DURATION:
-            case InternalExtractorEdge::WeightType::WAY_DURATION:
-                return data.duration * 10.;
-                break;
-            case InternalExtractorEdge::WeightType::SPEED:
-                return (distance * 10.) / (data.speed / 3.6);
-                break;
-            case InternalExtractorEdge::WeightType::INVALID:
-                util::exception("invalid weight type");
+                luabind::call_function<void>(scripting_environment.GetContex().state,
+                                             "segment_function",
+                                             boost::cref(edge.source_coordinate),
+                                             boost::cref(node),
+                                             distance,
+                                             boost::ref(edge.weight_data));
             }
-            return -1.0;
-        }(edge_iterator->weight_data);
-
-        auto &edge = edge_iterator->result;
-        edge.weight = std::max(1, static_cast<int>(std::floor(weight + .5)));
-
-        // assign new node id
-        auto id_iter = external_to_internal_node_id_map.find(node_iterator->node_id);
-        BOOST_ASSERT(id_iter != external_to_internal_node_id_map.end());
-        edge.target = id_iter->second;
 
-        // orient edges consistently: source id < target id
-        // important for multi-edge removal
-        if (edge.source > edge.target)
-        {
-            std::swap(edge.source, edge.target);
-
-            // std::swap does not work with bit-fields
-            bool temp = edge.forward;
-            edge.forward = edge.backward;
-            edge.backward = temp;
-        }
-        ++edge_iterator;
-    }
+            const double weight = [distance](const InternalExtractorEdge::WeightData &data) {
+                switch (data.type)
+                {
+                case InternalExtractorEdge::WeightType::EDGE_DURATION:
+                case InternalExtractorEdge::WeightType::WAY_DURATION:
+                    return data.duration * 10.;
+                    break;
+                case InternalExtractorEdge::WeightType::SPEED:
+                    return (distance * 10.) / (data.speed / 3.6);
+                    break;
+                case InternalExtractorEdge::WeightType::INVALID:
+                    util::exception("invalid weight type");
+                }
+                return -1.0;
+            }(edge.weight_data);
+
+            auto &result = edge.result;
+            result.weight = std::max(1, static_cast<int>(std::floor(weight + .5)));
+
+            // assign new node id
+            auto id_iter = external_to_internal_node_id_map.find(node.node_id);
+            BOOST_ASSERT(id_iter != external_to_internal_node_id_map.end());
+            result.target = id_iter->second;
+
+            // orient edges consistently: source id < target id
+            // important for multi-edge removal
+            if (result.source > result.target)
+            {
+                std::swap(result.source, result.target);
 
-    // Remove all remaining edges. They are invalid because there are no corresponding nodes for
-    // them. This happens when using osmosis with bbox or polygon to extract smaller areas.
-    auto markTargetsInvalid = [](InternalExtractorEdge &edge) {
-        util::SimpleLogger().Write(LogLevel::logWARNING) << "Found invalid node reference "
-                                                         << edge.result.target;
-        edge.result.target = SPECIAL_NODEID;
-    };
-    std::for_each(edge_iterator, all_edges_list_end_, markTargetsInvalid);
+                // std::swap does not work with bit-fields
+                bool temp = result.forward;
+                result.forward = result.backward;
+                result.backward = temp;
+            }
+        },
+        [](InternalExtractorEdge &edge) {
+            util::SimpleLogger().Write(LogLevel::logWARNING)
+                << "Found invalid node reference "
+                << static_cast<uint64_t>(edge.result.osm_target_id);
+            edge.result.target = SPECIAL_NODEID;
+        },
+        true);
     TIMER_STOP(compute_weights);
     std::cout << "ok, after " << TIMER_SEC(compute_weights) << "s" << std::endl;
 
     // Sort edges by start.
     std::cout << "[extractor] Sorting edges by renumbered start ... " << std::flush;
     TIMER_START(sort_edges_by_renumbered_start);
-    stxxl::sort(all_edges_list.begin(),
-                all_edges_list.end(),
-                CmpEdgeByInternalStartThenInternalTargetID(),
-                stxxl_memory);
+    Sort(all_edges_list, CmpEdgeByInternalStartThenInternalTargetID());
     TIMER_STOP(sort_edges_by_renumbered_start);
     std::cout << "ok, after " << TIMER_SEC(sort_edges_by_renumbered_start) << "s" << std::endl;
 
@@ -510,7 +569,7 @@ void ExtractionContainers::PrepareEdges(lua_State *segment_state)
     }
 }
 
-void ExtractionContainers::WriteEdges(std::ofstream &file_out_stream) const
+void ExtractionContainers::WriteEdges(std::ostream &file_out_stream) const
 {
     std::cout << "[extractor] Writing used edges       ... " << std::flush;
     TIMER_START(write_edges);
@@ -553,7 +612,7 @@ void ExtractionContainers::WriteEdges(std::ofstream &file_out_stream) const
     util::SimpleLogger().Write() << "Processed " << used_edges_counter << " edges";
 }
 
-void ExtractionContainers::WriteNodes(std::ofstream &file_out_stream) const
+void ExtractionContainers::WriteNodes(std::ostream &file_out_stream) const
 {
     // write dummy value, will be overwritten later
     std::cout << "[extractor] setting number of nodes   ... " << std::flush;
@@ -562,6 +621,9 @@ void ExtractionContainers::WriteNodes(std::ofstream &file_out_stream) const
 
     std::cout << "[extractor] Confirming/Writing used nodes     ... " << std::flush;
     TIMER_START(write_nodes);
+    // the nodes are written in the order of their internal ids, in spatial order they differ
+    // from the OSM order of the lists
+    std::vector<ExternalMemoryNode> ordered_nodes(spatial_node_order ? max_internal_node_id : 0);
     // identify all used nodes by a merging step of two sorted lists
     auto node_iterator = all_nodes_list.begin();
     auto node_id_iterator = used_node_id_list.begin();
@@ -582,11 +644,22 @@ void ExtractionContainers::WriteNodes(std::ofstream &file_out_stream) const
         }
         BOOST_ASSERT(*node_id_iterator == node_iterator->node_id);
 
-        file_out_stream.write((char *)&(*node_iterator), sizeof(ExternalMemoryNode));
+        if (spatial_node_order)
+        {
+            const auto id_iter = external_to_internal_node_id_map.find(node_iterator->node_id);
+            BOOST_ASSERT(id_iter != external_to_internal_node_id_map.end());
+            ordered_nodes[id_iter->second] = *node_iterator;
+        }
+        else
+        {
+            file_out_stream.write((char *)&(*node_iterator), sizeof(ExternalMemoryNode));
+        }
 
         ++node_id_iterator;
         ++node_iterator;
     }
+    file_out_stream.write(reinterpret_cast<const char *>(ordered_nodes.data()),
+                          ordered_nodes.size() * sizeof(ExternalMemoryNode));
     TIMER_STOP(write_nodes);
     std::cout << "ok, after " << TIMER_SEC(write_nodes) << "s" << std::endl;
 
@@ -596,9 +669,8 @@ void ExtractionContainers::WriteNodes(std::ofstream &file_out_stream) const
 void ExtractionContainers::WriteRestrictions(const std::string &path) const
 {
     // serialize restrictions
-    std::ofstream restrictions_out_stream;
+    util::BufferedOutputFile restrictions_out_stream(path);
     unsigned written_restriction_count = 0;
-    restrictions_out_stream.open(path.c_str(), std::ios::binary);
     const util::FingerPrint fingerprint = util::FingerPrint::GetValid();
     restrictions_out_stream.write((char *)&fingerprint, sizeof(util::FingerPrint));
     const auto count_position = restrictions_out_stream.tellp();
@@ -617,6 +689,7 @@ void ExtractionContainers::WriteRestrictions(const std::string &path) const
     }
     restrictions_out_stream.seekp(count_position);
     restrictions_out_stream.write((char *)&written_restriction_count, sizeof(unsigned));
+    restrictions_out_stream.close();
     util::SimpleLogger().Write() << "usable restrictions: " << written_restriction_count;
 }
 
@@ -624,20 +697,14 @@ void ExtractionContainers::PrepareRestrictions()
 {
     std::cout << "[extractor] Sorting used ways         ... " << std::flush;
     TIMER_START(sort_ways);
-    stxxl::sort(way_start_end_id_list.begin(),
-                way_start_end_id_list.end(),
-                FirstAndLastSegmentOfWayStxxlCompare(),
-                stxxl_memory);
+    Sort(way_start_end_id_list, FirstAndLastSegmentOfWayStxxlCompare());
     TIMER_STOP(sort_ways);
     std::cout << "ok, after " << TIMER_SEC(sort_ways) << "s" << std::endl;
 
     std::cout << "[extractor] Sorting " << restrictions_list.size() << " restriction. by from... "
               << std::flush;
     TIMER_START(sort_restrictions);
-    stxxl::sort(restrictions_list.begin(),
-                restrictions_list.end(),
-                CmpRestrictionContainerByFrom(),
-                stxxl_memory);
+    Sort(restrictions_list, CmpRestrictionContainerByFrom());
     TIMER_STOP(sort_restrictions);
     std::cout << "ok, after " << TIMER_SEC(sort_restrictions) << "s" << std::endl;
 
@@ -728,10 +795,7 @@ void ExtractionContainers::PrepareRestrictions()
 
     std::cout << "[extractor] Sorting restrictions. by to  ... " << std::flush;
     TIMER_START(sort_restrictions_to);
-    stxxl::sort(restrictions_list.begin(),
-                restrictions_list.end(),
-                CmpRestrictionContainerByTo(),
-                stxxl_memory);
+    Sort(restrictions_list, CmpRestrictionContainerByTo());
     TIMER_STOP(sort_restrictions_to);
     std::cout << "ok, after " << TIMER_SEC(sort_restrictions_to) << "s" << std::endl;
 
@@ -813,5 +877,98 @@ void ExtractionContainers::PrepareRestrictions()
     TIMER_STOP(fix_restriction_ends);
     std::cout << "ok, after " << TIMER_SEC(fix_restriction_ends) << "s" << std::endl;
 }
+
+// Restrictions over a via way refer to the nodes next to both ends of the via way. Like for via
+// nodes, the from and to ways have to start or end at the via way.
+void ExtractionContainers::PrepareViaWayRestrictions()
+{
+    std::cout << "[extractor] Fixing via-way restrictions ... " << std::flush;
+    TIMER_START(fix_via_way_restrictions);
+
+    // the way list is sorted by PrepareRestrictions
+    const auto find_way = [this](const OSMEdgeID_weak way_id) {
+        const OSMWayID id{static_cast<std::uint32_t>(way_id)};
+        const auto way = std::lower_bound(way_start_end_id_list.cbegin(),
+                                          way_start_end_id_list.cend(),
+                                          id,
+                                          [](const FirstAndLastSegmentOfWay &lhs,
+                                             const OSMWayID rhs) { return lhs.way_id < rhs; });
+        if (way == way_start_end_id_list.cend() || way->way_id != id)
+        {
+            return boost::optional<FirstAndLastSegmentOfWay>{};
+        }
+        return boost::make_optional(*way);
+    };
+
+    // node of the way next to its end node, if the way starts or ends at that node
+    const auto next_to_end = [](const FirstAndLastSegmentOfWay &way, const OSMNodeID node) {
+        if (way.first_segment_source_id == node)
+        {
+            return way.first_segment_target_id;
+        }
+        if (way.last_segment_target_id == node)
+        {
+            return way.last_segment_source_id;
+        }
+        return SPECIAL_OSM_NODEID;
+    };
+
+    const auto internal_id = [this](const OSMNodeID node) {
+        const auto id_iter = external_to_internal_node_id_map.find(node);
+        return id_iter == external_to_internal_node_id_map.end() ? SPECIAL_NODEID
+                                                                 : id_iter->second;
+    };
+
+    std::size_t usable_restrictions = 0;
+    for (auto restriction_container : via_way_restrictions_list)
+    {
+        auto &restriction = restriction_container.restriction;
+        const auto via_way_id = restriction.via.way;
+        const auto from_way = find_way(restriction.from.way);
+        const auto via_way = find_way(via_way_id);
+        const auto to_way = find_way(restriction.to.way);
+        if (!from_way || !via_way || !to_way)
+        {
+            util::SimpleLogger().Write(LogLevel::logDEBUG)
+                << "Restriction references invalid way: " << via_way_id;
+            continue;
+        }
+
+        auto via_start = via_way->first_segment_source_id;
+        auto via_end = via_way->last_segment_target_id;
+        if (next_to_end(*from_way, via_start) == SPECIAL_OSM_NODEID)
+        {
+            std::swap(via_start, via_end);
+        }
+        const auto from_node = next_to_end(*from_way, via_start);
+        const auto to_node = next_to_end(*to_way, via_end);
+        if (from_node == SPECIAL_OSM_NODEID || to_node == SPECIAL_OSM_NODEID)
+        {
+            util::SimpleLogger().Write(LogLevel::logDEBUG)
+                << "Restriction ways are not connected at the via way: " << via_way_id;
+            continue;
+        }
+
+        restriction.from.node = internal_id(from_node);
+        restriction.via.node = internal_id(via_start);
+        restriction.via_end.node = internal_id(via_end);
+        restriction.to.node = internal_id(to_node);
+        if (restriction.from.node == SPECIAL_NODEID || restriction.via.node == SPECIAL_NODEID ||
+            restriction.via_end.node == SPECIAL_NODEID || restriction.to.node == SPECIAL_NODEID)
+        {
+            util::SimpleLogger().Write(LogLevel::logWARNING)
+                << "Restriction references invalid node on way: " << via_way_id;
+            continue;
+        }
+
+        restrictions_list.push_back(restriction_container);
+        ++usable_restrictions;
+    }
+
+    TIMER_STOP(fix_via_way_restrictions);
+    std::cout << "ok, after " << TIMER_SEC(fix_via_way_restrictions) << "s" << std::endl;
+    util::SimpleLogger().Write() << "usable via-way restrictions: " << usable_restrictions
+                                 << " of " << via_way_restrictions_list.size();
+}
 }
 }
@@ -1,4 +1,5 @@
 #include "extractor/extractor.hpp"
+#include "extractor/change_applier.hpp"
 
 #include "extractor/edge_based_edge.hpp"
 #include "extractor/extraction_containers.hpp"
@@ -7,12 +8,17 @@
 #include "extractor/extractor_callbacks.hpp"
 #include "extractor/restriction_parser.hpp"
 #include "extractor/scripting_environment.hpp"
+#include "extractor/way_tag_filter.hpp"
 
 #include "extractor/raster_source.hpp"
+#include "extractor/region_filter.hpp"
 #include "util/graph_loader.hpp"
+#include "util/intermediate_file.hpp"
 #include "util/io.hpp"
+#include "util/lru_cache.hpp"
 #include "util/lua_util.hpp"
 #include "util/make_unique.hpp"
+#include "util/memory_usage.hpp"
 #include "util/name_table.hpp"
 #include "util/range_table.hpp"
 #include "util/simple_logger.hpp"
@@ -23,7 +29,7 @@
 #include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
 
-#include "extractor/tarjan_scc.hpp"
+#include "extractor/parallel_scc.hpp"
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
@@ -33,7 +39,8 @@
 
 #include <osmium/io/any_input.hpp>
 
-#include <tbb/parallel_for.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/pipeline.h>
 #include <tbb/task_scheduler_init.h>
 
 #include <cstdlib>
@@ -45,9 +52,12 @@
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <thread>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -55,6 +65,114 @@ namespace osrm
 namespace extractor
 {
 
+namespace
+{
+// number of distinct tag sets a thread remembers the way_function result of
+const constexpr std::size_t WAY_CACHE_SIZE = 1 << 16;
+
+using WayCache = util::LRUCache<std::string, ExtractionWay>;
+
+// number of distinct turn:lanes strings a thread remembers the lane description of
+const constexpr std::size_t TURN_LANE_CACHE_SIZE = 1 << 12;
+
+// Logs the peak memory of a phase of the extraction and starts measuring the next one
+void ReportPeakMemory(const char *phase, const std::size_t memory_budget)
+{
+    const auto peak_memory = util::PeakMemoryUsage();
+    if (peak_memory == 0)
+    {
+        return;
+    }
+    util::SimpleLogger().Write() << "Peak memory of " << phase << ": " << (peak_memory >> 20)
+                                 << " MiB";
+    if (memory_budget > 0 && peak_memory > memory_budget)
+    {
+        util::SimpleLogger().Write(logWARNING) << "Peak memory of " << phase
+                                               << " exceeds the memory budget of "
+                                               << (memory_budget >> 20) << " MiB";
+    }
+    util::ResetPeakMemoryUsage();
+}
+
+// One OSM way id per line
+void WriteAffectedWays(const std::string &output_path, const std::vector<OSMWayID> &ways)
+{
+    boost::filesystem::ofstream out_stream(output_path);
+    if (!out_stream)
+    {
+        throw util::exception("Could not open " + output_path + " for writing.");
+    }
+
+    for (const auto way : ways)
+    {
+        out_stream << static_cast<std::uint32_t>(way) << '\n';
+    }
+}
+
+// Returns the tag keys the profile declares that way_function reads, sorted.
+// An empty result means the profile reads arbitrary tags and results can not be shared.
+std::vector<std::string> ReadWayTagKeys(lua_State *lua_state)
+{
+    std::vector<std::string> tag_keys;
+    if (util::luaFunctionExists(lua_state, "get_way_tag_keys"))
+    {
+        luabind::call_function<void>(lua_state, "get_way_tag_keys", boost::ref(tag_keys));
+        std::sort(tag_keys.begin(), tag_keys.end());
+    }
+    return tag_keys;
+}
+
+// Rules of the ways that way_function does not make routable, empty if the profile declares none
+WayTagFilter ReadWayTagFilter(lua_State *lua_state)
+{
+    WayTagFilter filter;
+    if (util::luaFunctionExists(lua_state, "get_way_tag_filter"))
+    {
+        luabind::call_function<void>(lua_state, "get_way_tag_filter", boost::ref(filter));
+    }
+    return filter;
+}
+
+// A declared key covers itself and all keys that start with it and a colon
+bool IsDeclaredTagKey(const std::string &key, const std::vector<std::string> &tag_keys)
+{
+    for (auto length = key.find(':');; length = key.find(':', length + 1))
+    {
+        if (std::binary_search(tag_keys.begin(), tag_keys.end(), key.substr(0, length)))
+        {
+            return true;
+        }
+        if (length == std::string::npos)
+        {
+            return false;
+        }
+    }
+}
+
+// Canonical form of the declared tags of a way, the input order of tags is arbitrary
+std::string MakeWayCacheKey(const osmium::TagList &tags, const std::vector<std::string> &tag_keys)
+{
+    std::vector<std::pair<std::string, const char *>> declared_tags;
+    for (const auto &tag : tags)
+    {
+        std::string key = tag.key();
+        if (IsDeclaredTagKey(key, tag_keys))
+        {
+            declared_tags.emplace_back(std::move(key), tag.value());
+        }
+    }
+    std::sort(declared_tags.begin(), declared_tags.end());
+
+    std::string cache_key;
+    for (const auto &tag : declared_tags)
+    {
+        cache_key.append(tag.first).push_back('\0');
+        cache_key.append(tag.second).push_back('\0');
+    }
+    return cache_key;
+}
+}
+
 /**
  * TODO: Refactor this function into smaller functions for better readability.
  *
@@ -79,43 +197,51 @@ int Extractor::run()
     // setup scripting environment
     ScriptingEnvironment scripting_environment(config.profile_path.string().c_str());
 
+    // limits the threads of the extraction and of the edge expansion
+    const unsigned recommended_num_threads = tbb::task_scheduler_init::default_num_threads();
+    const auto number_of_threads = std::min(recommended_num_threads, config.requested_num_threads);
+    tbb::task_scheduler_init init(number_of_threads);
+
     try
     {
         util::LogPolicy::GetInstance().Unmute();
         TIMER_START(extracting);
-
-        const unsigned recommended_num_threads = tbb::task_scheduler_init::default_num_threads();
-        const auto number_of_threads =
-            std::min(recommended_num_threads, config.requested_num_threads);
-        tbb::task_scheduler_init init(number_of_threads);
+        util::ResetPeakMemoryUsage();
 
         util::SimpleLogger().Write() << "Input file: " << config.input_path.filename().string();
         util::SimpleLogger().Write() << "Profile: " << config.profile_path.filename().string();
         util::SimpleLogger().Write() << "Threads: " << number_of_threads;
 
-        ExtractionContainers extraction_containers;
+        ExtractionContainers extraction_containers(config);
         auto extractor_callbacks = util::make_unique<ExtractorCallbacks>(extraction_containers);
 
         const osmium::io::File input_file(config.input_path.string());
         osmium::io::Reader reader(input_file);
         const osmium::io::Header header = reader.header();
 
+        // the changes are merged into the buffers as they are read
+        std::unique_ptr<ChangeApplier> change_applier;
+        if (!config.change_paths.empty())
+        {
+            change_applier = util::make_unique<ChangeApplier>(config.change_paths);
+            util::SimpleLogger().Write() << "Applying " << change_applier->GetNumberOfChanges()
+                                         << " changed objects of " << config.change_paths.size()
+                                         << " change files";
+        }
+
         std::atomic<unsigned> number_of_nodes{0};
         std::atomic<unsigned> number_of_ways{0};
         std::atomic<unsigned> number_of_relations{0};
         std::atomic<unsigned> number_of_others{0};
+        std::atomic<std::uint64_t> number_of_dropped_nodes{0};
+        std::uint64_t number_of_dropped_ways = 0;
 
         util::SimpleLogger().Write() << "Parsing in progress..";
         TIMER_START(parsing);
 
+        // sets up the raster sources of the profile
         auto &main_context = scripting_environment.GetContex();
 
-        // setup raster sources
-        if (util::luaFunctionExists(main_context.state, "source_function"))
-        {
-            luabind::call_function<void>(main_context.state, "source_function");
-        }
-
         std::string generator = header.get("generator");
         if (generator.empty())
         {
@@ -134,91 +260,210 @@ int Extractor::run()
         boost::filesystem::ofstream timestamp_out(config.timestamp_file_name);
         timestamp_out.write(timestamp.c_str(), timestamp.length());
 
-        // initialize vectors holding parsed objects
-        tbb::concurrent_vector<std::pair<std::size_t, ExtractionNode>> resulting_nodes;
-        tbb::concurrent_vector<std::pair<std::size_t, ExtractionWay>> resulting_ways;
-        tbb::concurrent_vector<boost::optional<InputRestrictionContainer>> resulting_restrictions;
-
         // setup restriction parser
         const RestrictionParser restriction_parser(main_context.state, main_context.properties);
 
-        while (const osmium::memory::Buffer buffer = reader.read())
+        // way_function results are shared by ways with the same tags the profile reads
+        const auto way_tag_keys = ReadWayTagKeys(main_context.state);
+        if (!way_tag_keys.empty())
+        {
+            util::SimpleLogger().Write() << "Profile reads " << way_tag_keys.size()
+                                         << " way tag keys, caching way results";
+        }
+        // ways the filter rejects are not routable and skip way_function
+        const auto way_tag_filter = ReadWayTagFilter(main_context.state);
+        if (!way_tag_filter.Empty())
+        {
+            util::SimpleLogger().Write() << "Profile declares a way tag filter, way_function "
+                                            "only runs for the ways it admits";
+        }
+        std::atomic<std::uint64_t> number_of_filtered_ways{0};
+        tbb::enumerable_thread_specific<WayCache> way_caches(
+            [] { return WayCache(WAY_CACHE_SIZE); });
+        tbb::enumerable_thread_specific<ExtractorCallbacks::TurnLaneCache> turn_lane_caches(
+            [] { return ExtractorCallbacks::TurnLaneCache(TURN_LANE_CACHE_SIZE); });
+
+        // Nodes outside of the region are dropped when they are parsed, ways when none of their
+        // nodes was kept. Parts of kept ways outside of the region are removed with the nodes
+        // they reference when the data is prepared.
+        std::unique_ptr<const RegionFilter> region_filter;
+        RegionNodeSet region_nodes;
+        if (!config.region_polygon_path.empty())
+        {
+            region_filter = util::make_unique<const RegionFilter>(config.region_polygon_path);
+            util::SimpleLogger().Write() << "Extracting the region of "
+                                         << region_filter->GetNumberOfRings() << " rings in "
+                                         << config.region_polygon_path.filename().string();
+        }
+
+        // Buffers are read, parsed by the profile and handed to the extractor callbacks in a
+        // pipeline, so that the next buffers are read and parsed while the callbacks run.
+        // The callbacks see the buffers in input order.
+        using SharedBuffer = std::shared_ptr<const osmium::memory::Buffer>;
+        struct ParsedBuffer
         {
-            // create a vector of iterators into the buffer
-            std::vector<osmium::memory::Buffer::const_iterator> osm_elements;
-            for (auto iter = std::begin(buffer), end = std::end(buffer); iter != end; ++iter)
+            SharedBuffer buffer;
+            std::vector<std::pair<const osmium::Node *, ExtractionNode>> resulting_nodes;
+            struct ParsedWay
             {
-                osm_elements.push_back(iter);
-            }
-
-            // clear resulting vectors
-            resulting_nodes.clear();
-            resulting_ways.clear();
-            resulting_restrictions.clear();
-
-            // parse OSM entities in parallel, store in resulting vectors
-            tbb::parallel_for(
-                tbb::blocked_range<std::size_t>(0, osm_elements.size()),
-                [&](const tbb::blocked_range<std::size_t> &range) {
-                    ExtractionNode result_node;
-                    ExtractionWay result_way;
-                    auto &local_context = scripting_environment.GetContex();
-
-                    for (auto x = range.begin(), end = range.end(); x != end; ++x)
+                const osmium::Way *way;
+                ExtractionWay result;
+                ExtractorCallbacks::WayTurnLanes turn_lanes;
+            };
+            std::vector<ParsedWay> resulting_ways;
+            std::vector<boost::optional<InputRestrictionContainer>> resulting_restrictions;
+        };
+        using SharedParsedBuffer = std::shared_ptr<ParsedBuffer>;
+
+        const auto buffer_reader = tbb::make_filter<void, SharedBuffer>(
+            tbb::filter::serial_in_order, [&](tbb::flow_control &control) {
+                if (auto buffer = reader.read())
+                {
+                    if (change_applier)
                     {
-                        const auto entity = osm_elements[x];
-
-                        switch (entity->type())
+                        buffer = change_applier->Apply(buffer);
+                    }
+                    return std::make_shared<const osmium::memory::Buffer>(std::move(buffer));
+                }
+                if (change_applier)
+                {
+                    if (auto buffer = change_applier->Finish())
+                    {
+                        return std::make_shared<const osmium::memory::Buffer>(std::move(buffer));
+                    }
+                }
+                control.stop();
+                return SharedBuffer{};
+            });
+
+        // parse OSM entities of a buffer with the profile state of the current thread
+        const auto buffer_transform = tbb::make_filter<SharedBuffer, SharedParsedBuffer>(
+            tbb::filter::parallel, [&](const SharedBuffer buffer) {
+                auto parsed_buffer = std::make_shared<ParsedBuffer>();
+                parsed_buffer->buffer = buffer;
+                auto &local_context = scripting_environment.GetContex();
+
+                for (auto entity = buffer->cbegin(), end = buffer->cend(); entity != end;
+                     ++entity)
+                {
+                    switch (entity->type())
+                    {
+                    case osmium::item_type::node:
+                    {
+                        const auto &node = static_cast<const osmium::Node &>(*entity);
+                        ExtractionNode result_node;
+                        ++number_of_nodes;
+                        if (region_filter &&
+                            (!node.location().valid() ||
+                             !region_filter->Contains(
+                                 util::Coordinate{util::FloatLongitude{node.location().lon()},
+                                                  util::FloatLatitude{node.location().lat()}})))
                         {
-                        case osmium::item_type::node:
-                            result_node.clear();
-                            ++number_of_nodes;
-                            luabind::call_function<void>(
-                                local_context.state,
-                                "node_function",
-                                boost::cref(static_cast<const osmium::Node &>(*entity)),
-                                boost::ref(result_node));
-                            resulting_nodes.push_back(std::make_pair(x, std::move(result_node)));
-                            break;
-                        case osmium::item_type::way:
-                            result_way.clear();
-                            ++number_of_ways;
-                            luabind::call_function<void>(
-                                local_context.state,
-                                "way_function",
-                                boost::cref(static_cast<const osmium::Way &>(*entity)),
-                                boost::ref(result_way));
-                            resulting_ways.push_back(std::make_pair(x, std::move(result_way)));
+                            ++number_of_dropped_nodes;
                             break;
-                        case osmium::item_type::relation:
-                            ++number_of_relations;
-                            resulting_restrictions.push_back(restriction_parser.TryParse(
-                                static_cast<const osmium::Relation &>(*entity)));
-                            break;
-                        default:
-                            ++number_of_others;
+                        }
+                        // most nodes only carry a location, the profile has nothing to read
+                        if (!node.tags().empty())
+                        {
+                            luabind::call_function<void>(local_context.state,
+                                                         "node_function",
+                                                         boost::cref(node),
+                                                         boost::ref(result_node));
+                        }
+                        parsed_buffer->resulting_nodes.emplace_back(&node, std::move(result_node));
+                        break;
+                    }
+                    case osmium::item_type::way:
+                    {
+                        const auto &way = static_cast<const osmium::Way &>(*entity);
+                        ExtractionWay result_way;
+                        ++number_of_ways;
+                        if (!way_tag_filter.Empty() && way_tag_filter.Rejects(way.tags()))
+                        {
+                            ++number_of_filtered_ways;
                             break;
                         }
+                        const auto call_way_function = [&] {
+                            luabind::call_function<void>(local_context.state,
+                                                         "way_function",
+                                                         boost::cref(way),
+                                                         boost::ref(result_way));
+                        };
+                        if (way_tag_keys.empty())
+                        {
+                            call_way_function();
+                        }
+                        else
+                        {
+                            auto &way_cache = way_caches.local();
+                            const auto cache_key = MakeWayCacheKey(way.tags(), way_tag_keys);
+                            if (const auto cached_way = way_cache.Get(cache_key))
+                            {
+                                result_way = *cached_way;
+                            }
+                            else
+                            {
+                                call_way_function();
+                                way_cache.Put(cache_key, result_way);
+                            }
+                        }
+                        // leaves only the id lookups of ProcessWay to the serial stage
+                        auto turn_lanes = ExtractorCallbacks::ParseTurnLanes(
+                            result_way, turn_lane_caches.local());
+                        parsed_buffer->resulting_ways.push_back(
+                            {&way, std::move(result_way), std::move(turn_lanes)});
+                        break;
                     }
-                });
-
-            // put parsed objects thru extractor callbacks
-            for (const auto &result : resulting_nodes)
-            {
-                extractor_callbacks->ProcessNode(
-                    static_cast<const osmium::Node &>(*(osm_elements[result.first])),
-                    result.second);
-            }
-            for (const auto &result : resulting_ways)
-            {
-                extractor_callbacks->ProcessWay(
-                    static_cast<const osmium::Way &>(*(osm_elements[result.first])), result.second);
-            }
-            for (const auto &result : resulting_restrictions)
-            {
-                extractor_callbacks->ProcessRestriction(result);
-            }
-        }
+                    case osmium::item_type::relation:
+                        ++number_of_relations;
+                        parsed_buffer->resulting_restrictions.push_back(restriction_parser.TryParse(
+                            static_cast<const osmium::Relation &>(*entity)));
+                        break;
+                    default:
+                        ++number_of_others;
+                        break;
+                    }
+                }
+                return parsed_buffer;
+            });
+
+        // put parsed objects thru extractor callbacks
+        const auto buffer_storage = tbb::make_filter<SharedParsedBuffer, void>(
+            tbb::filter::serial_in_order, [&](const SharedParsedBuffer parsed_buffer) {
+                for (const auto &result : parsed_buffer->resulting_nodes)
+                {
+                    extractor_callbacks->ProcessNode(*result.first, result.second);
+                    if (region_filter)
+                    {
+                        region_nodes.Insert(OSMNodeID{
+                            static_cast<std::uint64_t>(result.first->id())});
+                    }
+                }
+                for (const auto &result : parsed_buffer->resulting_ways)
+                {
+                    if (region_filter &&
+                        std::none_of(result.way->nodes().begin(),
+                                     result.way->nodes().end(),
+                                     [&](const osmium::NodeRef &node) {
+                                         return region_nodes.Contains(
+                                             OSMNodeID{static_cast<std::uint64_t>(node.ref())});
+                                     }))
+                    {
+                        ++number_of_dropped_ways;
+                        continue;
+                    }
+                    extractor_callbacks->ProcessWay(*result.way, result.result, result.turn_lanes);
+                }
+                for (const auto &result : parsed_buffer->resulting_restrictions)
+                {
+                    extractor_callbacks->ProcessRestriction(result);
+                }
+            });
+
+        // bounds the number of buffers in memory, every thread can parse one while the
+        // callbacks and the reader are busy with others
+        tbb::parallel_pipeline(number_of_threads + 2,
+                               buffer_reader & buffer_transform & buffer_storage);
         TIMER_STOP(parsing);
         util::SimpleLogger().Write() << "Parsing finished after " << TIMER_SEC(parsing)
                                      << " seconds";
@@ -227,8 +472,28 @@ int Extractor::run()
                                      << " nodes, " << number_of_ways.load() << " ways, and "
                                      << number_of_relations.load() << " relations, and "
                                      << number_of_others.load() << " unknown entities";
+        if (!way_tag_filter.Empty())
+        {
+            util::SimpleLogger().Write() << number_of_filtered_ways.load()
+                                         << " ways were rejected by the way tag filter";
+        }
+        if (region_filter)
+        {
+            util::SimpleLogger().Write() << "Dropped " << number_of_dropped_nodes.load()
+                                         << " nodes and " << number_of_dropped_ways
+                                         << " ways outside of the region";
+        }
+        if (change_applier)
+        {
+            const auto &affected_ways = change_applier->GetAffectedWays();
+            util::SimpleLogger().Write() << affected_ways.size()
+                                         << " ways are affected by the changes";
+            WriteAffectedWays(config.changed_ways_output_path, affected_ways);
+            change_applier.reset();
+        }
 
         extractor_callbacks.reset();
+        ReportPeakMemory("parsing", config.memory_budget);
 
         if (extraction_containers.all_edges_list.empty())
         {
@@ -240,9 +505,10 @@ int Extractor::run()
                                           config.restriction_file_name,
                                           config.names_file_name,
                                           config.turn_lane_descriptions_file_name,
-                                          main_context.state);
+                                          scripting_environment);
 
         WriteProfileProperties(config.profile_properties_output_path, main_context.properties);
+        ReportPeakMemory("preparing extracted data", config.memory_budget);
 
         TIMER_STOP(extracting);
         util::SimpleLogger().Write() << "extraction finished after " << TIMER_SEC(extracting)
@@ -273,7 +539,7 @@ int Extractor::run()
         std::vector<bool> node_is_startpoint;
         std::vector<EdgeWeight> edge_based_node_weights;
         std::vector<QueryNode> internal_to_external_node_map;
-        auto graph_size = BuildEdgeExpandedGraph(main_context.state,
+        auto graph_size = BuildEdgeExpandedGraph(scripting_environment,
                                                  main_context.properties,
                                                  internal_to_external_node_map,
                                                  edge_based_node_list,
@@ -286,6 +552,7 @@ int Extractor::run()
         auto max_edge_id = graph_size.second;
 
         TIMER_STOP(expansion);
+        ReportPeakMemory("edge expansion", config.memory_budget);
 
         util::SimpleLogger().Write() << "Saving edge-based node weights to file.";
         TIMER_START(timer_write_node_weights);
@@ -304,11 +571,13 @@ int Extractor::run()
                    internal_to_external_node_map);
 
         TIMER_STOP(rtree);
+        ReportPeakMemory("r-tree construction", config.memory_budget);
 
         util::SimpleLogger().Write() << "writing node map ...";
         WriteNodeMapping(internal_to_external_node_map);
 
         WriteEdgeBasedGraph(config.edge_graph_output_path, max_edge_id, edge_based_edge_list);
+        ReportPeakMemory("writing the edge-based graph", config.memory_budget);
 
         util::SimpleLogger().Write()
             << "Expansion  : " << (number_of_node_based_nodes / TIMER_SEC(expansion))
@@ -399,7 +668,7 @@ void Extractor::FindComponents(unsigned max_edge_id,
 
     auto uncontractor_graph = std::make_shared<UncontractedGraph>(max_edge_id + 1, edges);
 
-    TarjanSCC<UncontractedGraph> component_search(
+    ParallelSCC<UncontractedGraph> component_search(
         std::const_pointer_cast<const UncontractedGraph>(uncontractor_graph));
     component_search.Run();
 
@@ -477,7 +746,7 @@ Extractor::LoadNodeBasedGraph(std::unordered_set<NodeID> &barrier_nodes,
  \brief Building an edge-expanded graph from node-based input and turn restrictions
 */
 std::pair<std::size_t, EdgeID>
-Extractor::BuildEdgeExpandedGraph(lua_State *lua_state,
+Extractor::BuildEdgeExpandedGraph(ScriptingEnvironment &scripting_environment,
                                   const ProfileProperties &profile_properties,
                                   std::vector<QueryNode> &internal_to_external_node_map,
                                   std::vector<EdgeBasedNode> &node_based_edge_list,
@@ -501,7 +770,10 @@ Extractor::BuildEdgeExpandedGraph(lua_State *lua_state,
                               *node_based_graph,
                               compressed_edge_container);
 
-    compressed_edge_container.SerializeInternalVector(config.geometry_output_path);
+    compressed_edge_container.SerializeInternalVector(config.geometry_output_path,
+                                                      config.compress_intermediates);
+
+    restriction_map->BuildFlatIndex(node_based_graph->GetNumberOfNodes());
 
     util::NameTable name_table(config.names_file_name);
 
@@ -527,10 +799,14 @@ Extractor::BuildEdgeExpandedGraph(lua_State *lua_state,
 
     edge_based_graph_factory.Run(config.edge_output_path,
                                  config.turn_lane_data_file_name,
-                                 lua_state,
+                                 scripting_environment,
                                  config.edge_segment_lookup_path,
                                  config.edge_penalty_path,
-                                 config.generate_edge_lookup);
+                                 config.segment_index_path,
+                                 config.generate_edge_lookup,
+                                 config.compress_intermediates,
+                                 config.turn_cost_tables_output_path,
+                                 config.generate_turn_cost_tables);
 
     edge_based_graph_factory.GetEdgeBasedEdges(edge_based_edge_list);
     edge_based_graph_factory.GetEdgeBasedNodes(node_based_edge_list);
@@ -538,6 +814,10 @@ Extractor::BuildEdgeExpandedGraph(lua_State *lua_state,
     edge_based_graph_factory.GetEdgeBasedNodeWeights(edge_based_node_weights);
     auto max_edge_id = edge_based_graph_factory.GetHighestEdgeID();
 
+    std::vector<DuplicatedNode> duplicated_nodes;
+    edge_based_graph_factory.GetDuplicatedNodes(duplicated_nodes);
+    util::serializeVector(config.duplicated_nodes_output_path, duplicated_nodes);
+
     const std::size_t number_of_node_based_nodes = node_based_graph->GetNumberOfNodes();
 
     WriteIntersectionClassificationData(intersection_class_output_file,
@@ -553,7 +833,8 @@ Extractor::BuildEdgeExpandedGraph(lua_State *lua_state,
  */
 void Extractor::WriteNodeMapping(const std::vector<QueryNode> &internal_to_external_node_map)
 {
-    boost::filesystem::ofstream node_stream(config.node_output_path, std::ios::binary);
+    util::IntermediateOutputFile node_stream(config.node_output_path,
+                                             config.compress_intermediates);
     const unsigned size_of_mapping = internal_to_external_node_map.size();
     node_stream.write((char *)&size_of_mapping, sizeof(unsigned));
     if (size_of_mapping > 0)
@@ -561,6 +842,7 @@ void Extractor::WriteNodeMapping(const std::vector<QueryNode> &internal_to_exter
         node_stream.write((char *)internal_to_external_node_map.data(),
                           size_of_mapping * sizeof(QueryNode));
     }
+    node_stream.close();
 }
 
 /**
@@ -608,6 +890,9 @@ void Extractor::BuildRTree(std::vector<EdgeBasedNode> node_based_edge_list,
     TIMER_STOP(construction);
     util::SimpleLogger().Write() << "finished r-tree construction in " << TIMER_SEC(construction)
                                  << " seconds";
+
+    // the new leaves use the node ids of this run, not the ones of a renumbered hierarchy
+    boost::filesystem::remove(config.node_order_output_path);
 }
 
 void Extractor::WriteEdgeBasedGraph(
@@ -616,8 +901,8 @@ void Extractor::WriteEdgeBasedGraph(
     util::DeallocatingVector<EdgeBasedEdge> const &edge_based_edge_list)
 {
 
-    std::ofstream file_out_stream;
-    file_out_stream.open(output_file_filename.c_str(), std::ios::binary);
+    util::IntermediateOutputFile file_out_stream(output_file_filename,
+                                                 config.compress_intermediates);
     const util::FingerPrint fingerprint = util::FingerPrint::GetValid();
     file_out_stream.write((char *)&fingerprint, sizeof(util::FingerPrint));
 
@@ -633,6 +918,7 @@ void Extractor::WriteEdgeBasedGraph(
     {
         file_out_stream.write((char *)&edge, sizeof(EdgeBasedEdge));
     }
+    file_out_stream.close();
 
     TIMER_STOP(write_edges);
     util::SimpleLogger().Write() << "ok, after " << TIMER_SEC(write_edges) << "s" << std::endl;
@@ -646,13 +932,7 @@ void Extractor::WriteIntersectionClassificationData(
     const std::vector<util::guidance::BearingClass> &bearing_classes,
     const std::vector<util::guidance::EntryClass> &entry_classes) const
 {
-    std::ofstream file_out_stream(output_file_name.c_str(), std::ios::binary);
-    if (!file_out_stream)
-    {
-        util::SimpleLogger().Write(logWARNING) << "Failed to open " << output_file_name
-                                               << " for writing";
-        return;
-    }
+    util::BufferedOutputFile file_out_stream(output_file_name);
 
     util::SimpleLogger().Write() << "Writing Intersection Classification Data";
     TIMER_START(write_edges);
@@ -687,6 +967,7 @@ void Extractor::WriteIntersectionClassificationData(
     //              "EntryClass Serialization requires trivial copyable entry classes");
 
     util::serializeVector(file_out_stream, entry_classes);
+    file_out_stream.close();
     TIMER_STOP(write_edges);
     util::SimpleLogger().Write() << "ok, after " << TIMER_SEC(write_edges) << "s for "
                                  << node_based_intersection_classes.size() << " Indices into "
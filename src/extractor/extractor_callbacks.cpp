@@ -30,6 +30,76 @@ namespace extractor
 using TurnLaneDescription = guidance::TurnLaneDescription;
 namespace TurnLaneType = guidance::TurnLaneType;
 
+namespace
+{
+// Parses the turn:lanes syntax of OSM into masks, one per lane
+TurnLaneDescription laneStringToDescription(const std::string &lane_string)
+{
+    if (lane_string.empty())
+        return {};
+
+    TurnLaneDescription lane_description;
+
+    typedef boost::tokenizer<boost::char_separator<char>> tokenizer;
+    boost::char_separator<char> sep("|&", "", boost::keep_empty_tokens);
+    boost::char_separator<char> inner_sep(";", "");
+    tokenizer tokens(lane_string, sep);
+
+    const constexpr std::size_t num_osm_tags = 11;
+    const constexpr char *osm_lane_strings[num_osm_tags] = {"none",
+                                                            "through",
+                                                            "sharp_left",
+                                                            "left",
+                                                            "slight_left",
+                                                            "slight_right",
+                                                            "right",
+                                                            "sharp_right",
+                                                            "reverse",
+                                                            "merge_to_left",
+                                                            "merge_to_right"};
+    const constexpr TurnLaneType::Mask masks_by_osm_string[num_osm_tags + 1] = {
+        TurnLaneType::none,
+        TurnLaneType::straight,
+        TurnLaneType::sharp_left,
+        TurnLaneType::left,
+        TurnLaneType::slight_left,
+        TurnLaneType::slight_right,
+        TurnLaneType::right,
+        TurnLaneType::sharp_right,
+        TurnLaneType::uturn,
+        TurnLaneType::merge_to_left,
+        TurnLaneType::merge_to_right,
+        TurnLaneType::empty}; // fallback, if string not found
+
+    for (auto iter = tokens.begin(); iter != tokens.end(); ++iter)
+    {
+        tokenizer inner_tokens(*iter, inner_sep);
+        guidance::TurnLaneType::Mask lane_mask = inner_tokens.begin() == inner_tokens.end()
+                                                     ? TurnLaneType::none
+                                                     : TurnLaneType::empty;
+        for (auto token_itr = inner_tokens.begin(); token_itr != inner_tokens.end();
+             ++token_itr)
+        {
+            auto position = std::find(osm_lane_strings, osm_lane_strings + num_osm_tags, *token_itr);
+            const auto translated_mask =
+                masks_by_osm_string[std::distance(osm_lane_strings, position)];
+            if (translated_mask == TurnLaneType::empty)
+            {
+                // if we have unsupported tags, don't handle them
+                util::SimpleLogger().Write(logDEBUG) << "Unsupported lane tag found: \""
+                                                     << *token_itr << "\"";
+                return {};
+            }
+            BOOST_ASSERT((lane_mask & translated_mask) == 0); // make sure the mask is valid
+            lane_mask |= translated_mask;
+        }
+        // add the lane to the description
+        lane_description.push_back(lane_mask);
+    }
+    return lane_description;
+}
+}
+
 ExtractorCallbacks::ExtractorCallbacks(ExtractionContainers &extraction_containers)
     : external_memory(extraction_containers)
 {
@@ -58,7 +128,11 @@ void ExtractorCallbacks::ProcessNode(const osmium::Node &input_node,
 void ExtractorCallbacks::ProcessRestriction(
     const boost::optional<InputRestrictionContainer> &restriction)
 {
-    if (restriction)
+    if (restriction && restriction->restriction.flags.uses_via_way)
+    {
+        external_memory.via_way_restrictions_list.push_back(restriction.get());
+    }
+    else if (restriction)
     {
         external_memory.restrictions_list.push_back(restriction.get());
         // util::SimpleLogger().Write() << "from: " << restriction.get().restriction.from.node <<
@@ -78,6 +152,52 @@ void ExtractorCallbacks::ProcessRestriction(
  * warning: caller needs to take care of synchronization!
  */
 void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const ExtractionWay &parsed_way)
+{
+    ProcessWay(input_way, parsed_way, ParseTurnLanes(parsed_way));
+}
+
+ExtractorCallbacks::WayTurnLanes ExtractorCallbacks::ParseTurnLanes(const ExtractionWay &parsed_way)
+{
+    WayTurnLanes turn_lanes;
+    if (!parsed_way.turn_lanes_forward.empty())
+    {
+        turn_lanes.forward = laneStringToDescription(parsed_way.turn_lanes_forward);
+    }
+    if (!parsed_way.turn_lanes_backward.empty())
+    {
+        turn_lanes.backward = laneStringToDescription(parsed_way.turn_lanes_backward);
+    }
+    return turn_lanes;
+}
+
+ExtractorCallbacks::WayTurnLanes ExtractorCallbacks::ParseTurnLanes(const ExtractionWay &parsed_way,
+                                                                    TurnLaneCache &cache)
+{
+    const auto parse = [&cache](const std::string &lane_string) {
+        if (const auto cached = cache.Get(lane_string))
+        {
+            return *cached;
+        }
+        auto lane_description = laneStringToDescription(lane_string);
+        cache.Put(lane_string, lane_description);
+        return lane_description;
+    };
+
+    WayTurnLanes turn_lanes;
+    if (!parsed_way.turn_lanes_forward.empty())
+    {
+        turn_lanes.forward = parse(parsed_way.turn_lanes_forward);
+    }
+    if (!parsed_way.turn_lanes_backward.empty())
+    {
+        turn_lanes.backward = parse(parsed_way.turn_lanes_backward);
+    }
+    return turn_lanes;
+}
+
+void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way,
+                                    const ExtractionWay &parsed_way,
+                                    const WayTurnLanes &turn_lanes)
 {
     if (((0 >= parsed_way.forward_speed) ||
          (TRAVEL_MODE_INACCESSIBLE == parsed_way.forward_travel_mode)) &&
@@ -147,77 +267,12 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
         road_classification.road_class = guidance::functionalRoadClassFromTag(data);
     }
 
-    const auto laneStringToDescription = [](std::string lane_string) -> TurnLaneDescription {
-        if (lane_string.empty())
-            return {};
-
-        TurnLaneDescription lane_description;
-
-        typedef boost::tokenizer<boost::char_separator<char>> tokenizer;
-        boost::char_separator<char> sep("|&", "", boost::keep_empty_tokens);
-        boost::char_separator<char> inner_sep(";", "");
-        tokenizer tokens(lane_string, sep);
-
-        const constexpr std::size_t num_osm_tags = 11;
-        const constexpr char *osm_lane_strings[num_osm_tags] = {"none",
-                                                                "through",
-                                                                "sharp_left",
-                                                                "left",
-                                                                "slight_left",
-                                                                "slight_right",
-                                                                "right",
-                                                                "sharp_right",
-                                                                "reverse",
-                                                                "merge_to_left",
-                                                                "merge_to_right"};
-        const constexpr TurnLaneType::Mask masks_by_osm_string[num_osm_tags + 1] = {
-            TurnLaneType::none,
-            TurnLaneType::straight,
-            TurnLaneType::sharp_left,
-            TurnLaneType::left,
-            TurnLaneType::slight_left,
-            TurnLaneType::slight_right,
-            TurnLaneType::right,
-            TurnLaneType::sharp_right,
-            TurnLaneType::uturn,
-            TurnLaneType::merge_to_left,
-            TurnLaneType::merge_to_right,
-            TurnLaneType::empty}; // fallback, if string not found
-
-        for (auto iter = tokens.begin(); iter != tokens.end(); ++iter)
-        {
-            tokenizer inner_tokens(*iter, inner_sep);
-            guidance::TurnLaneType::Mask lane_mask = inner_tokens.begin() == inner_tokens.end()
-                                                         ? TurnLaneType::none
-                                                         : TurnLaneType::empty;
-            for (auto token_itr = inner_tokens.begin(); token_itr != inner_tokens.end();
-                 ++token_itr)
-            {
-                auto position = std::find(osm_lane_strings, osm_lane_strings + num_osm_tags, *token_itr);
-                const auto translated_mask =
-                    masks_by_osm_string[std::distance(osm_lane_strings, position)];
-                if (translated_mask == TurnLaneType::empty)
-                {
-                    // if we have unsupported tags, don't handle them
-                    util::SimpleLogger().Write(logDEBUG) << "Unsupported lane tag found: \""
-                                                         << *token_itr << "\"";
-                    return {};
-                }
-                BOOST_ASSERT((lane_mask & translated_mask) == 0); // make sure the mask is valid
-                lane_mask |= translated_mask;
-            }
-            // add the lane to the description
-            lane_description.push_back(lane_mask);
-        }
-        return lane_description;
-    };
-
     // convert the lane description into an ID and, if necessary, remembr the description in the
     // description_map
-    const auto requestId = [&](std::string lane_string) {
-        if( lane_string.empty() )
+    const auto requestId = [&](const boost::optional<TurnLaneDescription> &turn_lanes) {
+        if (!turn_lanes)
             return INVALID_LANE_DESCRIPTIONID;
-        TurnLaneDescription lane_description = laneStringToDescription(std::move(lane_string));
+        const TurnLaneDescription &lane_description = *turn_lanes;
 
         const auto lane_description_itr = lane_description_map.find(lane_description);
         if (lane_description_itr == lane_description_map.end())
@@ -246,8 +301,8 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
     // Deduplicates street names and street destination names based on the street_map map.
     // In case we do not already store the name, inserts (name, id) tuple and return id.
     // Otherwise fetches the id based on the name and returns it without insertion.
-    const auto turn_lane_id_forward = requestId(parsed_way.turn_lanes_forward);
-    const auto turn_lane_id_backward = requestId(parsed_way.turn_lanes_backward);
+    const auto turn_lane_id_forward = requestId(turn_lanes.forward);
+    const auto turn_lane_id_backward = requestId(turn_lanes.backward);
 
     const constexpr auto MAX_STRING_LENGTH = 255u;
     // Get the unique identifier for the street name
@@ -330,7 +385,8 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
                                           parsed_way.backward_travel_mode,
                                           false,
                                           turn_lane_id_backward,
-                                          road_classification));
+                                          road_classification,
+                                          parsed_way.classes));
             });
 
         external_memory.way_start_end_id_list.push_back(
@@ -361,7 +417,8 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
                                           parsed_way.forward_travel_mode,
                                           split_edge,
                                           turn_lane_id_forward,
-                                          road_classification));
+                                          road_classification,
+                                          parsed_way.classes));
             });
         if (split_edge)
         {
@@ -383,7 +440,8 @@ void ExtractorCallbacks::ProcessWay(const osmium::Way &input_way, const Extracti
                                               parsed_way.backward_travel_mode,
                                               true,
                                               turn_lane_id_backward,
-                                              road_classification));
+                                              road_classification,
+                                              parsed_way.classes));
                 });
         }
 
@@ -4,15 +4,171 @@
 #include "extractor/restriction_map.hpp"
 #include "util/dynamic_graph.hpp"
 #include "util/node_based_graph.hpp"
-#include "util/percent.hpp"
 
 #include "util/simple_logger.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <utility>
+#include <vector>
+
 namespace osrm
 {
 namespace extractor
 {
 
+namespace
+{
+using EdgeData = util::NodeBasedDynamicGraph::EdgeData;
+using CompressedEdge = CompressedEdgeContainer::CompressedEdge;
+
+// A run of compressible nodes between two nodes that are kept. It is entered by source_edge
+// from source and by target_edge from target.
+struct Chain
+{
+    NodeID source;
+    EdgeID source_edge;
+    NodeID target;
+    EdgeID target_edge;
+    NodeID first;
+    NodeID last;
+    NodeID max_node;
+    unsigned length;
+};
+
+/*
+ * Remember Lane Data for compressed parts. This handles scenarios where lane-data is
+ * only kept up until a traffic light.
+ *
+ *                |    |
+ * ----------------    |
+ *         -^ |        |
+ * -----------         |
+ *         -v |        |
+ * ---------------     |
+ *                |    |
+ *
+ *  u ------- v ---- w
+ *
+ * Since the edge is compressable, we can transfer:
+ * "left|right" (uv) and "" (uw) into a string with "left|right" (uw) for the compressed
+ * edge.
+ * Doing so, we might mess up the point from where the lanes are shown. It should be
+ * reasonable, since the announcements have to come early anyhow. So there is a
+ * potential danger in here, but it saves us from adding a lot of additional edges for
+ * turn-lanes. Without this,we would have to treat any turn-lane beginning/ending just
+ * like a barrier.
+ */
+LaneDescriptionID SelectLaneID(const LaneDescriptionID front, const LaneDescriptionID back)
+{
+    // A lane has tags: u - (front) - v - (back) - w
+    // During contraction, we keep only one of the tags. Usually the one closer to the
+    // intersection is preferred. If its empty, however, we keep the non-empty one
+    if (back == INVALID_LANE_DESCRIPTIONID)
+        return front;
+    return back;
+}
+
+// Follows the compressible nodes behind source_edge up to the next node that is kept. For every
+// compressible node visit is called with its edges towards the previous and the next node.
+template <typename Visitor>
+Chain WalkChain(const util::NodeBasedDynamicGraph &graph,
+                const std::vector<std::uint8_t> &is_compressible,
+                const NodeID source,
+                const EdgeID source_edge,
+                Visitor &&visit)
+{
+    Chain chain{source, source_edge, SPECIAL_NODEID, SPECIAL_EDGEID, SPECIAL_NODEID, 0, 0, 0};
+    NodeID previous = source;
+    NodeID node = graph.GetTarget(source_edge);
+    chain.first = node;
+    while (is_compressible[node])
+    {
+        // compressible nodes have two distinct neighbours
+        const EdgeID begin = graph.BeginEdges(node);
+        const bool previous_is_first = graph.GetTarget(begin) == previous;
+        const EdgeID back_edge = previous_is_first ? begin : begin + 1;
+        const EdgeID next_edge = previous_is_first ? begin + 1 : begin;
+        visit(node, back_edge, next_edge);
+
+        chain.max_node = std::max(chain.max_node, node);
+        ++chain.length;
+        previous = node;
+        node = graph.GetTarget(next_edge);
+    }
+    chain.last = previous;
+    chain.target = node;
+    chain.target_edge = graph.FindEdge(node, previous);
+    BOOST_ASSERT(chain.target_edge != SPECIAL_EDGEID);
+    return chain;
+}
+
+Chain WalkChain(const util::NodeBasedDynamicGraph &graph,
+                const std::vector<std::uint8_t> &is_compressible,
+                const NodeID source,
+                const EdgeID source_edge)
+{
+    return WalkChain(graph, is_compressible, source, source_edge, [](NodeID, EdgeID, EdgeID) {});
+}
+
+// Finds every chain once, from the end whose edge into the chain has the smaller id
+std::vector<Chain> FindChains(const util::NodeBasedDynamicGraph &graph,
+                              const std::vector<std::uint8_t> &is_compressible)
+{
+    tbb::enumerable_thread_specific<std::vector<Chain>> thread_chains;
+    const auto find_chains = [&](const tbb::blocked_range<NodeID> &range) {
+        auto &chains = thread_chains.local();
+        for (auto source = range.begin(); source != range.end(); ++source)
+        {
+            if (is_compressible[source])
+                continue;
+            for (const auto edge : graph.GetAdjacentEdgeRange(source))
+            {
+                if (!is_compressible[graph.GetTarget(edge)])
+                    continue;
+                const auto chain = WalkChain(graph, is_compressible, source, edge);
+                if (chain.source_edge < chain.target_edge)
+                    chains.push_back(chain);
+            }
+        }
+    };
+    tbb::parallel_for(tbb::blocked_range<NodeID>(0, graph.GetNumberOfNodes()), find_chains);
+
+    std::vector<Chain> chains;
+    thread_chains.combine_each([&](const std::vector<Chain> &local_chains) {
+        chains.insert(chains.end(), local_chains.begin(), local_chains.end());
+    });
+    return chains;
+}
+
+// Keeps the count nodes with the highest ids, the ones that are left over when the nodes of a
+// cycle are compressed in order of their ids.
+void KeepHighestNodes(std::vector<NodeID> nodes,
+                      const std::size_t count,
+                      std::vector<std::uint8_t> &is_compressible)
+{
+    const auto kept = std::min(count, nodes.size());
+    std::nth_element(nodes.begin(), nodes.begin() + kept, nodes.end(), std::greater<NodeID>());
+    std::for_each(nodes.begin(), nodes.begin() + kept, [&](const NodeID node) {
+        is_compressible[node] = false;
+    });
+}
+}
+
+// Compresses all nodes with two compatible edges that are not barriers, traffic lights or via
+// nodes of turn restrictions.
+//
+// The result is the same as compressing the nodes one after another in order of their ids. A
+// node is not compressed if its neighbours are already connected, so of the chains between the
+// same two nodes only the one whose highest node comes first is compressed to a single edge,
+// the others keep their highest node. The nodes of a cycle are compressed down to a triangle.
+// These nodes are marked first, then all chains are compressed independently.
 void GraphCompressor::Compress(const std::unordered_set<NodeID> &barrier_nodes,
                                const std::unordered_set<NodeID> &traffic_lights,
                                RestrictionMap &restriction_map,
@@ -22,190 +178,309 @@ void GraphCompressor::Compress(const std::unordered_set<NodeID> &barrier_nodes,
     const unsigned original_number_of_nodes = graph.GetNumberOfNodes();
     const unsigned original_number_of_edges = graph.GetNumberOfEdges();
 
-    util::Percent progress(original_number_of_nodes);
-
-    for (const NodeID node_v : util::irange(0u, original_number_of_nodes))
+    std::vector<std::uint8_t> is_compressible(original_number_of_nodes, false);
+    tbb::parallel_for(tbb::blocked_range<NodeID>(0, original_number_of_nodes),
+                      [&](const tbb::blocked_range<NodeID> &range) {
+                          for (auto node_v = range.begin(); node_v != range.end(); ++node_v)
+                          {
+                              is_compressible[node_v] = IsCompressible(
+                                  barrier_nodes, traffic_lights, restriction_map, graph, node_v);
+                          }
+                      });
+
+    // chains between the same nodes, the first one in order of its highest node is compressed
+    // unless the nodes are connected already
+    auto chains = FindChains(graph, is_compressible);
+    const auto chain_ends = [](const Chain &chain) {
+        return std::make_pair(std::min(chain.source, chain.target),
+                              std::max(chain.source, chain.target));
+    };
+    std::sort(chains.begin(), chains.end(), [&](const Chain &lhs, const Chain &rhs) {
+        return std::make_pair(chain_ends(lhs), lhs.max_node) <
+               std::make_pair(chain_ends(rhs), rhs.max_node);
+    });
+    std::vector<std::uint8_t> is_on_chain(original_number_of_nodes, false);
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, chains.size()),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          for (auto index = range.begin(); index != range.end(); ++index)
+                          {
+                              const auto &chain = chains[index];
+                              WalkChain(graph,
+                                        is_compressible,
+                                        chain.source,
+                                        chain.source_edge,
+                                        [&](const NodeID node, EdgeID, EdgeID) {
+                                            is_on_chain[node] = true;
+                                        });
+                          }
+                      });
+    std::vector<NodeID> cycle;
+    for (const auto index : util::irange<std::size_t>(0, chains.size()))
     {
-        progress.PrintStatus(node_v);
-
-        // only contract degree 2 vertices
-        if (2 != graph.GetOutDegree(node_v))
+        const auto &chain = chains[index];
+        if (chain.source == chain.target)
         {
-            continue;
+            // together with the source the two highest nodes form a triangle
+            cycle.clear();
+            WalkChain(graph,
+                      is_compressible,
+                      chain.source,
+                      chain.source_edge,
+                      [&](const NodeID node, EdgeID, EdgeID) { cycle.push_back(node); });
+            KeepHighestNodes(cycle, 2, is_compressible);
         }
-
-        // don't contract barrier node
-        if (barrier_nodes.end() != barrier_nodes.find(node_v))
+        else if ((index > 0 && chain_ends(chains[index - 1]) == chain_ends(chain)) ||
+                 graph.FindEdgeInEitherDirection(chain.source, chain.target) != SPECIAL_EDGEID)
         {
-            continue;
+            is_compressible[chain.max_node] = false;
         }
-
-        // check if v is a via node for a turn restriction, i.e. a 'directed' barrier node
-        if (restriction_map.IsViaNode(node_v))
-        {
+    }
+    // cycles that consist of compressible nodes only
+    for (const NodeID node : util::irange(0u, original_number_of_nodes))
+    {
+        if (!is_compressible[node] || is_on_chain[node])
             continue;
-        }
-
-        //    reverse_e2   forward_e2
-        // u <---------- v -----------> w
-        //    ----------> <-----------
-        //    forward_e1   reverse_e1
-        //
-        // Will be compressed to:
-        //
-        //    reverse_e1
-        // u <---------- w
-        //    ---------->
-        //    forward_e1
-        //
-        // If the edges are compatible.
-
-        const bool reverse_edge_order = graph.GetEdgeData(graph.BeginEdges(node_v)).reversed;
-        const EdgeID forward_e2 = graph.BeginEdges(node_v) + reverse_edge_order;
-        BOOST_ASSERT(SPECIAL_EDGEID != forward_e2);
-        BOOST_ASSERT(forward_e2 >= graph.BeginEdges(node_v) && forward_e2 < graph.EndEdges(node_v));
-        const EdgeID reverse_e2 = graph.BeginEdges(node_v) + 1 - reverse_edge_order;
-        BOOST_ASSERT(SPECIAL_EDGEID != reverse_e2);
-        BOOST_ASSERT(reverse_e2 >= graph.BeginEdges(node_v) && reverse_e2 < graph.EndEdges(node_v));
-
-        const EdgeData &fwd_edge_data2 = graph.GetEdgeData(forward_e2);
-        const EdgeData &rev_edge_data2 = graph.GetEdgeData(reverse_e2);
-
-        const NodeID node_w = graph.GetTarget(forward_e2);
-        BOOST_ASSERT(SPECIAL_NODEID != node_w);
-        BOOST_ASSERT(node_v != node_w);
-        const NodeID node_u = graph.GetTarget(reverse_e2);
-        BOOST_ASSERT(SPECIAL_NODEID != node_u);
-        BOOST_ASSERT(node_u != node_v);
-
-        const EdgeID forward_e1 = graph.FindEdge(node_u, node_v);
-        BOOST_ASSERT(SPECIAL_EDGEID != forward_e1);
-        BOOST_ASSERT(node_v == graph.GetTarget(forward_e1));
-        const EdgeID reverse_e1 = graph.FindEdge(node_w, node_v);
-        BOOST_ASSERT(SPECIAL_EDGEID != reverse_e1);
-        BOOST_ASSERT(node_v == graph.GetTarget(reverse_e1));
-
-        const EdgeData &fwd_edge_data1 = graph.GetEdgeData(forward_e1);
-        const EdgeData &rev_edge_data1 = graph.GetEdgeData(reverse_e1);
-
-        if (graph.FindEdgeInEitherDirection(node_u, node_w) != SPECIAL_EDGEID)
+        cycle.clear();
+        for (NodeID previous = graph.GetTarget(graph.BeginEdges(node)), current = node;
+             !is_on_chain[current];)
         {
-            continue;
+            is_on_chain[current] = true;
+            cycle.push_back(current);
+            const auto begin = graph.BeginEdges(current);
+            const auto next_edge = graph.GetTarget(begin) == previous ? begin + 1 : begin;
+            previous = current;
+            current = graph.GetTarget(next_edge);
         }
+        KeepHighestNodes(cycle, 3, is_compressible);
+    }
 
-        // this case can happen if two ways with different names overlap
-        if (fwd_edge_data1.name_id != rev_edge_data1.name_id ||
-            fwd_edge_data2.name_id != rev_edge_data2.name_id)
-        {
-            continue;
-        }
+    // the remaining chains all have two different ends and share no edges
+    chains = FindChains(graph, is_compressible);
 
-        if (fwd_edge_data1.IsCompatibleTo(fwd_edge_data2) &&
-            rev_edge_data1.IsCompatibleTo(rev_edge_data2))
+    // the geometry of every edge that is left, stored one after another in the order of the edges
+    std::vector<unsigned> edge_offsets(original_number_of_nodes + 1, 0);
+    for (const NodeID node : util::irange(0u, original_number_of_nodes))
+    {
+        edge_offsets[node + 1] =
+            edge_offsets[node] + (is_compressible[node] ? 0 : graph.GetOutDegree(node));
+    }
+    const auto bucket_index = [&](const NodeID node, const EdgeID edge) {
+        return edge_offsets[node] + (edge - graph.BeginEdges(node));
+    };
+    std::vector<unsigned> geometry_offsets(edge_offsets.back() + 1, 1);
+    geometry_offsets.front() = 0;
+    for (const auto &chain : chains)
+    {
+        geometry_offsets[bucket_index(chain.source, chain.source_edge) + 1] = chain.length + 1;
+        geometry_offsets[bucket_index(chain.target, chain.target_edge) + 1] = chain.length + 1;
+    }
+    std::partial_sum(geometry_offsets.begin(), geometry_offsets.end(), geometry_offsets.begin());
+    std::vector<CompressedEdge> geometries(geometry_offsets.back());
+
+    //    source_edge    next_edge        next_edge
+    // u ------------> x ---------> .. x ----------> w
+    //   <------------   <---------       <----------
+    //     back_edge       back_edge      target_edge
+    //
+    // Will be compressed to:
+    //
+    //    target_edge
+    // u <------------ w
+    //   ------------>
+    //    source_edge
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, chains.size()),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                const auto &chain = chains[index];
+                EdgeData &forward_data = graph.GetEdgeData(chain.source_edge);
+                EdgeData &reverse_data = graph.GetEdgeData(chain.target_edge);
+
+                // the reverse geometry is filled from its end
+                auto forward_entry =
+                    geometry_offsets[bucket_index(chain.source, chain.source_edge)];
+                auto reverse_entry =
+                    geometry_offsets[bucket_index(chain.target, chain.target_edge) + 1];
+                geometries[forward_entry++] = {chain.first, forward_data.distance};
+
+                // the reverse lane is the first one along the chain
+                auto reverse_lane_description_id = INVALID_LANE_DESCRIPTIONID;
+                EdgeWeight reverse_distance = 0;
+                WalkChain(graph,
+                          is_compressible,
+                          chain.source,
+                          chain.source_edge,
+                          [&](NodeID, const EdgeID back_edge, const EdgeID next_edge) {
+                              const EdgeData &next_data = graph.GetEdgeData(next_edge);
+                              geometries[forward_entry++] = {graph.GetTarget(next_edge),
+                                                             next_data.distance};
+                              forward_data.distance += next_data.distance;
+                              forward_data.lane_description_id =
+                                  SelectLaneID(forward_data.lane_description_id,
+                                               next_data.lane_description_id);
+
+                              const EdgeData &back_data = graph.GetEdgeData(back_edge);
+                              geometries[--reverse_entry] = {graph.GetTarget(back_edge),
+                                                             back_data.distance};
+                              reverse_distance += back_data.distance;
+                              reverse_lane_description_id = SelectLaneID(
+                                  back_data.lane_description_id, reverse_lane_description_id);
+                          });
+                geometries[--reverse_entry] = {chain.last, reverse_data.distance};
+                reverse_data.distance += reverse_distance;
+                reverse_data.lane_description_id =
+                    SelectLaneID(reverse_data.lane_description_id, reverse_lane_description_id);
+
+                BOOST_ASSERT(forward_entry ==
+                             geometry_offsets[bucket_index(chain.source, chain.source_edge) + 1]);
+                BOOST_ASSERT(reverse_entry ==
+                             geometry_offsets[bucket_index(chain.target, chain.target_edge)]);
+                BOOST_ASSERT(graph.FindEdgeInEitherDirection(chain.source, chain.target) ==
+                             SPECIAL_EDGEID);
+            }
+        });
+
+    // the ends of the chains are only changed once the chains are not followed any more
+    for (const auto &chain : chains)
+    {
+        graph.SetTarget(chain.source_edge, chain.target);
+        graph.SetTarget(chain.target_edge, chain.source);
+    }
+    for (const NodeID node_v : util::irange(0u, original_number_of_nodes))
+    {
+        if (is_compressible[node_v])
         {
-            BOOST_ASSERT(graph.GetEdgeData(forward_e1).name_id ==
-                         graph.GetEdgeData(reverse_e1).name_id);
-            BOOST_ASSERT(graph.GetEdgeData(forward_e2).name_id ==
-                         graph.GetEdgeData(reverse_e2).name_id);
-
-            // Do not compress edge if it crosses a traffic signal.
-            // This can't be done in IsCompatibleTo, becase we only store the
-            // traffic signals in the `traffic_lights` list, which EdgeData
-            // doesn't have access to.
-            const bool has_node_penalty = traffic_lights.find(node_v) != traffic_lights.end();
-            if (has_node_penalty)
-                continue;
-
-            // Get distances before graph is modified
-            const int forward_weight1 = graph.GetEdgeData(forward_e1).distance;
-            const int forward_weight2 = graph.GetEdgeData(forward_e2).distance;
-
-            BOOST_ASSERT(0 != forward_weight1);
-            BOOST_ASSERT(0 != forward_weight2);
-
-            const int reverse_weight1 = graph.GetEdgeData(reverse_e1).distance;
-            const int reverse_weight2 = graph.GetEdgeData(reverse_e2).distance;
-
-            BOOST_ASSERT(0 != reverse_weight1);
-            BOOST_ASSERT(0 != reverse_weight2);
-
-            // add weight of e2's to e1
-            graph.GetEdgeData(forward_e1).distance += fwd_edge_data2.distance;
-            graph.GetEdgeData(reverse_e1).distance += rev_edge_data2.distance;
-
-            // extend e1's to targets of e2's
-            graph.SetTarget(forward_e1, node_w);
-            graph.SetTarget(reverse_e1, node_u);
-
-            /*
-             * Remember Lane Data for compressed parts. This handles scenarios where lane-data is
-             * only kept up until a traffic light.
-             *
-             *                |    |
-             * ----------------    |
-             *         -^ |        |
-             * -----------         |
-             *         -v |        |
-             * ---------------     |
-             *                |    |
-             *
-             *  u ------- v ---- w
-             *
-             * Since the edge is compressable, we can transfer:
-             * "left|right" (uv) and "" (uw) into a string with "left|right" (uw) for the compressed
-             * edge.
-             * Doing so, we might mess up the point from where the lanes are shown. It should be
-             * reasonable, since the announcements have to come early anyhow. So there is a
-             * potential danger in here, but it saves us from adding a lot of additional edges for
-             * turn-lanes. Without this,we would have to treat any turn-lane beginning/ending just
-             * like a barrier.
-             */
-            const auto selectLaneID = [](const LaneDescriptionID front, const LaneDescriptionID back) {
-                // A lane has tags: u - (front) - v - (back) - w
-                // During contraction, we keep only one of the tags. Usually the one closer to the
-                // intersection is preferred. If its empty, however, we keep the non-empty one
-                if (back == INVALID_LANE_DESCRIPTIONID)
-                    return front;
-                return back;
-            };
-            graph.GetEdgeData(forward_e1).lane_description_id = selectLaneID(
-                graph.GetEdgeData(forward_e1).lane_description_id, fwd_edge_data2.lane_description_id);
-            graph.GetEdgeData(reverse_e1).lane_description_id = selectLaneID(
-                graph.GetEdgeData(reverse_e1).lane_description_id, rev_edge_data2.lane_description_id);
-
-            // remove e2's (if bidir, otherwise only one)
-            graph.DeleteEdge(node_v, forward_e2);
-            graph.DeleteEdge(node_v, reverse_e2);
-
-            // update any involved turn restrictions
-            restriction_map.FixupStartingTurnRestriction(node_u, node_v, node_w);
-            restriction_map.FixupArrivingTurnRestriction(node_u, node_v, node_w, graph);
-
-            restriction_map.FixupStartingTurnRestriction(node_w, node_v, node_u);
-            restriction_map.FixupArrivingTurnRestriction(node_w, node_v, node_u, graph);
-
-            // store compressed geometry in container
-            geometry_compressor.CompressEdge(
-                forward_e1, forward_e2, node_v, node_w, forward_weight1, forward_weight2);
-            geometry_compressor.CompressEdge(
-                reverse_e1, reverse_e2, node_v, node_u, reverse_weight1, reverse_weight2);
+            graph.DeleteEdge(node_v, graph.BeginEdges(node_v) + 1);
+            graph.DeleteEdge(node_v, graph.BeginEdges(node_v));
         }
     }
 
+    // update any involved turn restrictions, the arriving ones need the compressed graph
+    for (const auto &chain : chains)
+    {
+        restriction_map.FixupStartingTurnRestriction(chain.source, chain.last, chain.target);
+        restriction_map.FixupStartingTurnRestriction(chain.target, chain.first, chain.source);
+    }
+    for (const auto &chain : chains)
+    {
+        restriction_map.FixupArrivingTurnRestriction(
+            chain.source, chain.first, chain.target, graph);
+        restriction_map.FixupArrivingTurnRestriction(
+            chain.target, chain.last, chain.source, graph);
+    }
+
     PrintStatistics(original_number_of_nodes, original_number_of_edges, graph);
 
-    // Repeate the loop, but now add all edges as uncompressed values.
-    // The function AddUncompressedEdge does nothing if the edge is already
-    // in the CompressedEdgeContainer.
-    for (const NodeID node_u : util::irange(0u, original_number_of_nodes))
+    // all edges that were not compressed are added as uncompressed values
+    std::vector<EdgeID> edge_ids(edge_offsets.back());
+    tbb::parallel_for(
+        tbb::blocked_range<NodeID>(0, original_number_of_nodes),
+        [&](const tbb::blocked_range<NodeID> &range) {
+            for (auto node_u = range.begin(); node_u != range.end(); ++node_u)
+            {
+                for (const auto edge_id : graph.GetAdjacentEdgeRange(node_u))
+                {
+                    const auto index = bucket_index(node_u, edge_id);
+                    edge_ids[index] = edge_id;
+                    if (geometry_offsets[index + 1] - geometry_offsets[index] == 1)
+                    {
+                        geometries[geometry_offsets[index]] = {
+                            graph.GetTarget(edge_id), graph.GetEdgeData(edge_id).distance};
+                    }
+                }
+            }
+        });
+    geometry_compressor.AddEdgeGeometries(edge_ids, geometry_offsets, std::move(geometries));
+}
+
+bool GraphCompressor::IsCompressible(const std::unordered_set<NodeID> &barrier_nodes,
+                                     const std::unordered_set<NodeID> &traffic_lights,
+                                     const RestrictionMap &restriction_map,
+                                     const util::NodeBasedDynamicGraph &graph,
+                                     const NodeID node_v) const
+{
+    // only contract degree 2 vertices
+    if (2 != graph.GetOutDegree(node_v))
     {
-        for (const auto edge_id : util::irange(graph.BeginEdges(node_u), graph.EndEdges(node_u)))
-        {
-            const EdgeData &data = graph.GetEdgeData(edge_id);
-            const NodeID target = graph.GetTarget(edge_id);
-            geometry_compressor.AddUncompressedEdge(edge_id, target, data.distance);
-        }
+        return false;
+    }
+
+    // don't contract barrier node
+    if (barrier_nodes.end() != barrier_nodes.find(node_v))
+    {
+        return false;
     }
+
+    // check if v is a via node for a turn restriction, i.e. a 'directed' barrier node
+    if (restriction_map.IsViaNode(node_v))
+    {
+        return false;
+    }
+
+    //    reverse_e2   forward_e2
+    // u <---------- v -----------> w
+    //    ----------> <-----------
+    //    forward_e1   reverse_e1
+    //
+    // Will be compressed to:
+    //
+    //    reverse_e1
+    // u <---------- w
+    //    ---------->
+    //    forward_e1
+    //
+    // If the edges are compatible.
+
+    const bool reverse_edge_order = graph.GetEdgeData(graph.BeginEdges(node_v)).reversed;
+    const EdgeID forward_e2 = graph.BeginEdges(node_v) + reverse_edge_order;
+    BOOST_ASSERT(SPECIAL_EDGEID != forward_e2);
+    BOOST_ASSERT(forward_e2 >= graph.BeginEdges(node_v) && forward_e2 < graph.EndEdges(node_v));
+    const EdgeID reverse_e2 = graph.BeginEdges(node_v) + 1 - reverse_edge_order;
+    BOOST_ASSERT(SPECIAL_EDGEID != reverse_e2);
+    BOOST_ASSERT(reverse_e2 >= graph.BeginEdges(node_v) && reverse_e2 < graph.EndEdges(node_v));
+
+    const EdgeData &fwd_edge_data2 = graph.GetEdgeData(forward_e2);
+    const EdgeData &rev_edge_data2 = graph.GetEdgeData(reverse_e2);
+
+    const NodeID node_w = graph.GetTarget(forward_e2);
+    BOOST_ASSERT(SPECIAL_NODEID != node_w);
+    BOOST_ASSERT(node_v != node_w);
+    const NodeID node_u = graph.GetTarget(reverse_e2);
+    BOOST_ASSERT(SPECIAL_NODEID != node_u);
+    BOOST_ASSERT(node_u != node_v);
+
+    // both edges lead to the same node, compressing would leave the node with a loop
+    if (node_u == node_w)
+    {
+        return false;
+    }
+
+    const EdgeID forward_e1 = graph.FindEdge(node_u, node_v);
+    BOOST_ASSERT(SPECIAL_EDGEID != forward_e1);
+    BOOST_ASSERT(node_v == graph.GetTarget(forward_e1));
+    const EdgeID reverse_e1 = graph.FindEdge(node_w, node_v);
+    BOOST_ASSERT(SPECIAL_EDGEID != reverse_e1);
+    BOOST_ASSERT(node_v == graph.GetTarget(reverse_e1));
+
+    const EdgeData &fwd_edge_data1 = graph.GetEdgeData(forward_e1);
+    const EdgeData &rev_edge_data1 = graph.GetEdgeData(reverse_e1);
+
+    // this case can happen if two ways with different names overlap
+    if (fwd_edge_data1.name_id != rev_edge_data1.name_id ||
+        fwd_edge_data2.name_id != rev_edge_data2.name_id)
+    {
+        return false;
+    }
+
+    // Do not compress edge if it crosses a traffic signal.
+    // This can't be done in IsCompatibleTo, becase we only store the
+    // traffic signals in the `traffic_lights` list, which EdgeData
+    // doesn't have access to.
+    const bool has_node_penalty = traffic_lights.find(node_v) != traffic_lights.end();
+
+    return fwd_edge_data1.IsCompatibleTo(fwd_edge_data2) &&
+           rev_edge_data1.IsCompatibleTo(rev_edge_data2) && !has_node_penalty;
 }
 
 void GraphCompressor::PrintStatistics(unsigned original_number_of_nodes,
@@ -1,6 +1,7 @@
 #include "extractor/guidance/intersection_generator.hpp"
 #include "extractor/guidance/constants.hpp"
 #include "extractor/guidance/toolkit.hpp"
+#include "util/integer_range.hpp"
 
 #include <algorithm>
 #include <iterator>
@@ -9,6 +10,9 @@
 
 #include <boost/range/algorithm/count_if.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 namespace osrm
 {
 namespace extractor
@@ -19,13 +23,38 @@ namespace guidance
 IntersectionGenerator::IntersectionGenerator(
     const util::NodeBasedDynamicGraph &node_based_graph,
     const RestrictionMap &restriction_map,
-    const std::unordered_set<NodeID> &barrier_nodes,
+    const std::vector<bool> &barrier_nodes,
     const std::vector<QueryNode> &node_info_list,
     const CompressedEdgeContainer &compressed_edge_container)
     : node_based_graph(node_based_graph), restriction_map(restriction_map),
       barrier_nodes(barrier_nodes), node_info_list(node_info_list),
       compressed_edge_container(compressed_edge_container)
 {
+    const auto number_of_nodes = node_based_graph.GetNumberOfNodes();
+    shape_offsets.resize(number_of_nodes + 1, 0);
+    for (const auto node : util::irange(0u, number_of_nodes))
+    {
+        shape_offsets[node + 1] = shape_offsets[node] + node_based_graph.GetOutDegree(node);
+    }
+    shape_coordinates.resize(shape_offsets.back());
+
+    tbb::parallel_for(tbb::blocked_range<NodeID>(0, number_of_nodes),
+                      [&](const tbb::blocked_range<NodeID> &range) {
+                          for (auto node = range.begin(); node != range.end(); ++node)
+                          {
+                              auto shape_index = shape_offsets[node];
+                              for (const auto edge : node_based_graph.GetAdjacentEdgeRange(node))
+                              {
+                                  shape_coordinates[shape_index++] = getRepresentativeCoordinate(
+                                      node,
+                                      node_based_graph.GetTarget(edge),
+                                      edge,
+                                      !INVERT,
+                                      compressed_edge_container,
+                                      node_info_list);
+                              }
+                          }
+                      });
 }
 
 Intersection IntersectionGenerator::operator()(const NodeID from_node, const EdgeID via_eid) const
@@ -53,14 +82,19 @@ Intersection IntersectionGenerator::getConnectedRoads(const NodeID from_node,
     const NodeID turn_node = node_based_graph.GetTarget(via_eid);
     const NodeID only_restriction_to_node =
         restriction_map.CheckForEmanatingIsOnlyTurn(from_node, turn_node);
-    const bool is_barrier_node = barrier_nodes.find(turn_node) != barrier_nodes.end();
+    const bool is_barrier_node = barrier_nodes[turn_node];
 
     bool has_uturn_edge = false;
     bool uturn_could_be_valid = false;
+    // unpack first node of second segment if packed
+    const auto first_coordinate = getRepresentativeCoordinate(
+        from_node, turn_node, via_eid, INVERT, compressed_edge_container, node_info_list);
+    auto shape_index = shape_offsets[turn_node];
     for (const EdgeID onto_edge : node_based_graph.GetAdjacentEdgeRange(turn_node))
     {
         BOOST_ASSERT(onto_edge != SPECIAL_EDGEID);
         const NodeID to_node = node_based_graph.GetTarget(onto_edge);
+        const auto &third_coordinate = shape_coordinates[shape_index++];
 
         bool turn_is_valid =
             // reverse edges are never valid turns because the resulting turn would look like this:
@@ -103,11 +137,6 @@ Intersection IntersectionGenerator::getConnectedRoads(const NodeID from_node,
         }
         else
         {
-            // unpack first node of second segment if packed
-            const auto first_coordinate = getRepresentativeCoordinate(
-                from_node, turn_node, via_eid, INVERT, compressed_edge_container, node_info_list);
-            const auto third_coordinate = getRepresentativeCoordinate(
-                turn_node, to_node, onto_edge, !INVERT, compressed_edge_container, node_info_list);
             angle = util::coordinate_calculation::computeAngle(
                 first_coordinate, node_info_list[turn_node], third_coordinate);
             if (std::abs(angle) < std::numeric_limits<double>::epsilon())
@@ -28,9 +28,9 @@ inline bool requiresAnnouncement(const EdgeData &from, const EdgeData &to)
 IntersectionHandler::IntersectionHandler(const util::NodeBasedDynamicGraph &node_based_graph,
                                          const std::vector<QueryNode> &node_info_list,
                                          const util::NameTable &name_table,
-                                         const SuffixTable &street_name_suffix_table)
+                                         const NameAnnouncements &name_announcements)
     : node_based_graph(node_based_graph), node_info_list(node_info_list), name_table(name_table),
-      street_name_suffix_table(street_name_suffix_table)
+      name_announcements(name_announcements)
 {
 }
 
@@ -88,9 +88,7 @@ TurnInstruction IntersectionHandler::getInstructionForObvious(const std::size_t
         const auto &in_data = node_based_graph.GetEdgeData(via_edge);
         const auto &out_data = node_based_graph.GetEdgeData(road.turn.eid);
         if (in_data.name_id != out_data.name_id &&
-            requiresNameAnnounced(name_table.GetNameForID(in_data.name_id),
-                                  name_table.GetNameForID(out_data.name_id),
-                                  street_name_suffix_table))
+            name_announcements.requiresNameAnnounced(in_data.name_id, out_data.name_id))
         {
             // obvious turn onto a through street is a merge
             if (through_street)
@@ -0,0 +1,133 @@
+#include "extractor/guidance/name_announcements.hpp"
+
+#include "util/integer_range.hpp"
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/assert.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace osrm
+{
+namespace extractor
+{
+namespace guidance
+{
+
+NameAnnouncements::NameAnnouncements(const util::NodeBasedDynamicGraph &node_based_graph,
+                                     const util::NameTable &name_table,
+                                     const SuffixTable &street_name_suffix_table)
+    : name_table(name_table)
+{
+    // only the names of the graph are ever compared
+    std::vector<bool> is_used(name_table.GetNumberOfNames(), false);
+    for (const auto node : util::irange(0u, node_based_graph.GetNumberOfNodes()))
+    {
+        for (const auto edge : node_based_graph.GetAdjacentEdgeRange(node))
+        {
+            const auto name_id = node_based_graph.GetEdgeData(edge).name_id;
+            BOOST_ASSERT(name_id < is_used.size());
+            if (name_id < is_used.size())
+            {
+                is_used[name_id] = true;
+            }
+        }
+    }
+    name_parts.resize(is_used.size());
+
+    std::unordered_map<std::string, std::uint32_t> interned;
+    const auto intern = [&interned](std::string value) {
+        return interned.emplace(std::move(value), interned.size()).first->second;
+    };
+    const auto is_suffix = [&street_name_suffix_table](std::string word) {
+        boost::to_lower(word);
+        return word.empty() || street_name_suffix_table.isSuffix(word);
+    };
+
+    for (const auto name_id : util::irange<NameID>(0, is_used.size()))
+    {
+        if (!is_used[name_id])
+        {
+            continue;
+        }
+        const auto full_name = name_table.GetNameForID(name_id);
+        auto &parts = name_parts[name_id];
+
+        // Split from the format "{name} ({ref})" -> name, ref
+        std::string name = full_name;
+        const auto ref_begin = full_name.find_first_of('(');
+        if (ref_begin != std::string::npos)
+        {
+            name = ref_begin != 0 ? full_name.substr(0, ref_begin - 1) : std::string();
+            const auto ref_end = full_name.find_first_of(')');
+            parts.ref_begin = ref_begin + 1;
+            parts.ref_length = full_name.substr(ref_begin + 1, ref_end - ref_begin - 1).size();
+        }
+        parts.name_length = name.size();
+
+        // the first and the last word, only if the name has more than one
+        std::string prefix;
+        std::string suffix;
+        const auto suffix_pos = name.find_last_of(' ');
+        if (suffix_pos != std::string::npos)
+        {
+            prefix = name.substr(0, name.find_first_of(' '));
+            suffix = name.substr(suffix_pos + 1);
+        }
+        parts.has_suffix_prefix = is_suffix(prefix);
+        parts.has_suffix_suffix = is_suffix(suffix);
+        parts.without_prefix = intern(name.substr(prefix.size()));
+        parts.without_suffix = intern(name.substr(0, name.size() - suffix.size()));
+    }
+}
+
+bool NameAnnouncements::requiresNameAnnounced(const NameID from_id, const NameID to_id) const
+{
+    BOOST_ASSERT(from_id < name_parts.size() && to_id < name_parts.size());
+    const auto from_string = name_table.GetNameViewForID(from_id);
+    const auto to_string = name_table.GetNameViewForID(to_id);
+
+    // first is empty and the second is not
+    if (from_string.empty() && !to_string.empty())
+        return true;
+
+    const auto &from = name_parts[from_id];
+    const auto &to = name_parts[to_id];
+    const util::StringView from_name{from_string.begin(), from_string.begin() + from.name_length};
+    const util::StringView to_name{to_string.begin(), to_string.begin() + to.name_length};
+    const auto from_ref_begin = from_string.begin() + from.ref_begin;
+    const auto to_ref_begin = to_string.begin() + to.ref_begin;
+    const util::StringView from_ref{from_ref_begin, from_ref_begin + from.ref_length};
+    const util::StringView to_ref{to_ref_begin, to_ref_begin + to.ref_length};
+
+    // check similarity of names
+    const auto names_are_empty = from_name.empty() && to_name.empty();
+    const auto name_is_contained =
+        boost::starts_with(from_name, to_name) || boost::starts_with(to_name, from_name);
+    // the first or the last word of the first name is a suffix and the rest of both names is equal
+    const auto is_suffix_change =
+        (from.has_suffix_prefix && from.without_prefix == to.without_prefix) ||
+        (from.has_suffix_suffix && from.without_suffix == to.without_suffix);
+    const auto names_are_equal = name_is_contained || is_suffix_change;
+    const auto name_is_removed = !from_name.empty() && to_name.empty();
+    // references are contained in one another
+    const auto refs_are_empty = from_ref.empty() && to_ref.empty();
+    const auto ref_is_contained = from_ref.empty() || to_ref.empty() ||
+                                  boost::contains(from_ref, to_ref) ||
+                                  boost::contains(to_ref, from_ref);
+    const auto ref_is_removed = !from_ref.empty() && to_ref.empty();
+
+    const auto obvious_change =
+        (names_are_empty && refs_are_empty) || (names_are_equal && ref_is_contained) ||
+        (names_are_equal && refs_are_empty) || (ref_is_contained && name_is_removed) ||
+        (names_are_equal && ref_is_removed) || is_suffix_change;
+
+    return !obvious_change;
+}
+
+} // namespace guidance
+} // namespace extractor
+} // namespace osrm
@@ -25,8 +25,8 @@ RoundaboutHandler::RoundaboutHandler(const util::NodeBasedDynamicGraph &node_bas
                                      const std::vector<QueryNode> &node_info_list,
                                      const CompressedEdgeContainer &compressed_edge_container,
                                      const util::NameTable &name_table,
-                                     const SuffixTable &street_name_suffix_table)
-    : IntersectionHandler(node_based_graph, node_info_list, name_table, street_name_suffix_table),
+                                     const NameAnnouncements &name_announcements)
+    : IntersectionHandler(node_based_graph, node_info_list, name_table, name_announcements),
       compressed_edge_container(compressed_edge_container)
 {
 }
@@ -233,9 +233,8 @@ RoundaboutType RoundaboutHandler::getRoundaboutType(const NodeID nid) const
                         for (auto name_id : roundabout_name_ids)
                         {
 
-                            if (!requiresNameAnnounced(name_table.GetNameForID(name_id),
-                                                       name_table.GetNameForID(edge_data.name_id),
-                                                       street_name_suffix_table))
+                            if (!name_announcements.requiresNameAnnounced(name_id,
+                                                                          edge_data.name_id))
                             {
                                 add = false;
                                 break;
@@ -34,7 +34,7 @@ bool requiresAnnouncement(const EdgeData &from, const EdgeData &to)
 TurnAnalysis::TurnAnalysis(const util::NodeBasedDynamicGraph &node_based_graph,
                            const std::vector<QueryNode> &node_info_list,
                            const RestrictionMap &restriction_map,
-                           const std::unordered_set<NodeID> &barrier_nodes,
+                           const std::vector<bool> &barrier_nodes,
                            const CompressedEdgeContainer &compressed_edge_container,
                            const util::NameTable &name_table,
                            const SuffixTable &street_name_suffix_table)
@@ -43,13 +43,14 @@ TurnAnalysis::TurnAnalysis(const util::NodeBasedDynamicGraph &node_based_graph,
                                                                  barrier_nodes,
                                                                  node_info_list,
                                                                  compressed_edge_container),
+      name_announcements(node_based_graph, name_table, street_name_suffix_table),
       roundabout_handler(node_based_graph,
                          node_info_list,
                          compressed_edge_container,
                          name_table,
-                         street_name_suffix_table),
-      motorway_handler(node_based_graph, node_info_list, name_table, street_name_suffix_table),
-      turn_handler(node_based_graph, node_info_list, name_table, street_name_suffix_table)
+                         name_announcements),
+      motorway_handler(node_based_graph, node_info_list, name_table, name_announcements),
+      turn_handler(node_based_graph, node_info_list, name_table, name_announcements)
 {
 }
 
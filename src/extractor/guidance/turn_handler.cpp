@@ -24,8 +24,8 @@ namespace guidance
 TurnHandler::TurnHandler(const util::NodeBasedDynamicGraph &node_based_graph,
                          const std::vector<QueryNode> &node_info_list,
                          const util::NameTable &name_table,
-                         const SuffixTable &street_name_suffix_table)
-    : IntersectionHandler(node_based_graph, node_info_list, name_table, street_name_suffix_table)
+                         const NameAnnouncements &name_announcements)
+    : IntersectionHandler(node_based_graph, node_info_list, name_table, name_announcements)
 {
 }
 
@@ -3,13 +3,162 @@
 #include "util/simple_logger.hpp"
 #include "util/timing_util.hpp"
 
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
 #include <cmath>
+#include <mutex>
+#include <numeric>
+#include <string>
 
 namespace osrm
 {
 namespace extractor
 {
 
+namespace
+{
+bool isSpace(const char character)
+{
+    return character == ' ' || character == '\n' || character == '\r' || character == '\t' ||
+           character == '\v' || character == '\f';
+}
+
+// Parses the whitespace separated integers in [begin, end) and counts them. The values are only
+// written if output is set, so the same function sizes and fills the grid.
+bool parseIntegers(const char *begin, const char *end, std::int32_t *output, std::size_t &count)
+{
+    count = 0;
+    auto itr = begin;
+    while (true)
+    {
+        while (itr != end && isSpace(*itr))
+        {
+            ++itr;
+        }
+        if (itr == end)
+        {
+            return true;
+        }
+
+        const bool negative = *itr == '-';
+        if (*itr == '-' || *itr == '+')
+        {
+            ++itr;
+        }
+        if (itr == end || *itr < '0' || *itr > '9')
+        {
+            return false;
+        }
+
+        std::int64_t value = 0;
+        while (itr != end && *itr >= '0' && *itr <= '9')
+        {
+            value = value * 10 + (*itr - '0');
+            if (value > std::int64_t{std::numeric_limits<std::int32_t>::max()} + 1)
+            {
+                return false;
+            }
+            ++itr;
+        }
+        if (itr != end && !isSpace(*itr))
+        {
+            return false;
+        }
+
+        value = negative ? -value : value;
+        if (value > std::numeric_limits<std::int32_t>::max())
+        {
+            return false;
+        }
+        if (output)
+        {
+            output[count] = static_cast<std::int32_t>(value);
+        }
+        ++count;
+    }
+}
+
+const constexpr std::size_t RASTER_PARSE_CHUNK_SIZE = 1 << 20;
+const constexpr std::size_t RASTER_LOOKUP_GRAIN_SIZE = 1024;
+
+// Every thread has its own profile state that loads the sources, a source is only read once
+// and shared by the containers of all states.
+struct SharedSources
+{
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const RasterSource>> sources;
+};
+
+SharedSources &GetSharedSources()
+{
+    static SharedSources shared_sources;
+    return shared_sources;
+}
+}
+
+RasterGrid::RasterGrid(const boost::filesystem::path &filepath,
+                       std::size_t _xdim,
+                       std::size_t _ydim)
+    : xdim(_xdim), ydim(_ydim)
+{
+    if (boost::filesystem::file_size(filepath) == 0)
+    {
+        throw util::exception("Failed to parse raster source correctly.");
+    }
+
+    boost::iostreams::mapped_file_source mapped_file;
+    try
+    {
+        mapped_file.open(filepath);
+    }
+    catch (const std::exception &)
+    {
+        throw util::exception("Unable to open raster file.");
+    }
+
+    const char *const begin = mapped_file.data();
+    const char *const end = begin + mapped_file.size();
+
+    // Chunk borders are moved to the next whitespace, so no value is split between chunks
+    std::vector<const char *> borders{begin};
+    for (auto border = begin + RASTER_PARSE_CHUNK_SIZE; border < end;
+         border += RASTER_PARSE_CHUNK_SIZE)
+    {
+        border = std::max(border, borders.back());
+        border = std::find_if(border, end, isSpace);
+        borders.push_back(border);
+    }
+    borders.push_back(end);
+    const auto number_of_chunks = borders.size() - 1;
+
+    std::vector<std::size_t> offsets(number_of_chunks + 1, 0);
+    std::vector<char> parsed(number_of_chunks, false);
+    tbb::parallel_for(std::size_t{0}, number_of_chunks, [&](const std::size_t chunk) {
+        parsed[chunk] =
+            parseIntegers(borders[chunk], borders[chunk + 1], nullptr, offsets[chunk + 1]);
+    });
+    if (std::find(parsed.begin(), parsed.end(), false) != parsed.end())
+    {
+        throw util::exception("Failed to parse raster source correctly.");
+    }
+
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    if (offsets.back() < xdim * ydim)
+    {
+        throw util::exception("Raster source has fewer values than nrows * ncols.");
+    }
+
+    _data.resize(offsets.back());
+    tbb::parallel_for(std::size_t{0}, number_of_chunks, [&](const std::size_t chunk) {
+        std::size_t count;
+        parseIntegers(borders[chunk], borders[chunk + 1], _data.data() + offsets[chunk], count);
+    });
+}
+
 RasterSource::RasterSource(RasterGrid _raster_data,
                            std::size_t _width,
                            std::size_t _height,
@@ -99,63 +248,134 @@ int SourceContainer::LoadRasterSource(const std::string &path_string,
 
     int source_id = static_cast<int>(LoadedSources.size());
 
-    util::SimpleLogger().Write() << "[source loader] Loading from " << path_string << "  ... ";
-    TIMER_START(loading_source);
-
-    boost::filesystem::path filepath(path_string);
-    if (!boost::filesystem::exists(filepath))
+    // the same file with other dimensions is another source
+    const auto shared_key = path_string + '\0' + std::to_string(_xmin) + ' ' +
+                            std::to_string(_xmax) + ' ' + std::to_string(_ymin) + ' ' +
+                            std::to_string(_ymax) + ' ' + std::to_string(nrows) + ' ' +
+                            std::to_string(ncols);
+    auto &shared_sources = GetSharedSources();
+    std::lock_guard<std::mutex> lock(shared_sources.mutex);
+    auto &shared_source = shared_sources.sources[shared_key];
+    if (!shared_source)
     {
-        throw util::exception("error reading: no such path");
-    }
+        util::SimpleLogger().Write() << "[source loader] Loading from " << path_string
+                                     << "  ... ";
+        TIMER_START(loading_source);
 
-    RasterGrid rasterData{filepath, ncols, nrows};
+        boost::filesystem::path filepath(path_string);
+        if (!boost::filesystem::exists(filepath))
+        {
+            throw util::exception("error reading: no such path");
+        }
 
-    RasterSource source{std::move(rasterData), ncols, nrows, _xmin, _xmax, _ymin, _ymax};
-    TIMER_STOP(loading_source);
-    LoadedSourcePaths.emplace(path_string, source_id);
-    LoadedSources.push_back(std::move(source));
+        RasterGrid rasterData{filepath, ncols, nrows};
+
+        shared_source = std::make_shared<const RasterSource>(
+            std::move(rasterData), ncols, nrows, _xmin, _xmax, _ymin, _ymax);
+        TIMER_STOP(loading_source);
 
-    util::SimpleLogger().Write() << "[source loader] ok, after " << TIMER_SEC(loading_source)
-                                 << "s";
+        util::SimpleLogger().Write() << "[source loader] ok, after "
+                                     << TIMER_SEC(loading_source) << "s";
+    }
+    LoadedSourcePaths.emplace(path_string, source_id);
+    LoadedSources.push_back(shared_source);
 
     return source_id;
 }
 
-// External function for looking up nearest data point from a specified source
-RasterDatum SourceContainer::GetRasterDataFromSource(unsigned int source_id, double lon, double lat)
+const RasterSource &SourceContainer::GetSource(unsigned int source_id) const
 {
     if (LoadedSources.size() < source_id + 1)
     {
         throw util::exception("error reading: no such loaded source");
     }
+    return *LoadedSources[source_id];
+}
+
+// Sources are never changed after loading, so a cached datum stays valid
+template <typename LookupT>
+RasterDatum SourceContainer::CachedLookupFromSource(
+    LookupCache &cache, unsigned int source_id, double lon, double lat, LookupT lookup)
+{
+    const auto &found = GetSource(source_id);
 
     BOOST_ASSERT(lat < 90);
     BOOST_ASSERT(lat > -90);
     BOOST_ASSERT(lon < 180);
     BOOST_ASSERT(lon > -180);
 
-    const auto &found = LoadedSources[source_id];
-    return found.GetRasterData(static_cast<std::int32_t>(util::toFixed(util::FloatLongitude{lon})),
-                               static_cast<std::int32_t>(util::toFixed(util::FloatLatitude{lat})));
+    const auto fixed_lon = static_cast<std::int32_t>(util::toFixed(util::FloatLongitude{lon}));
+    const auto fixed_lat = static_cast<std::int32_t>(util::toFixed(util::FloatLatitude{lat}));
+
+    const auto hash = static_cast<std::uint32_t>(fixed_lon) * 73856093u ^
+                      static_cast<std::uint32_t>(fixed_lat) * 19349663u ^ source_id;
+    auto &entry = cache[hash % LOOKUP_CACHE_SIZE];
+    if (entry.source_id != source_id || entry.lon != fixed_lon || entry.lat != fixed_lat)
+    {
+        entry.lon = fixed_lon;
+        entry.lat = fixed_lat;
+        entry.source_id = source_id;
+        entry.datum = lookup(found, fixed_lon, fixed_lat);
+    }
+    return entry.datum;
+}
+
+// External function for looking up nearest data point from a specified source
+RasterDatum SourceContainer::GetRasterDataFromSource(unsigned int source_id, double lon, double lat)
+{
+    return CachedLookupFromSource(
+        data_cache, source_id, lon, lat, [](const RasterSource &source, int x, int y) {
+            return source.GetRasterData(x, y);
+        });
 }
 
 // External function for looking up interpolated data from a specified source
 RasterDatum
 SourceContainer::GetRasterInterpolateFromSource(unsigned int source_id, double lon, double lat)
 {
-    if (LoadedSources.size() < source_id + 1)
-    {
-        throw util::exception("error reading: no such loaded source");
-    }
+    return CachedLookupFromSource(
+        interpolate_cache, source_id, lon, lat, [](const RasterSource &source, int x, int y) {
+            return source.GetRasterInterpolate(x, y);
+        });
+}
 
-    BOOST_ASSERT(lat < 90);
-    BOOST_ASSERT(lat > -90);
-    BOOST_ASSERT(lon < 180);
-    BOOST_ASSERT(lon > -180);
+std::vector<RasterDatum>
+SourceContainer::GetRasterDataFromSource(unsigned int source_id,
+                                         const std::vector<util::Coordinate> &coordinates) const
+{
+    const auto &found = GetSource(source_id);
+
+    std::vector<RasterDatum> data(coordinates.size());
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, coordinates.size(), RASTER_LOOKUP_GRAIN_SIZE),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                data[index] =
+                    found.GetRasterData(static_cast<std::int32_t>(coordinates[index].lon),
+                                        static_cast<std::int32_t>(coordinates[index].lat));
+            }
+        });
+    return data;
+}
+
+std::vector<RasterDatum> SourceContainer::GetRasterInterpolateFromSource(
+    unsigned int source_id, const std::vector<util::Coordinate> &coordinates) const
+{
+    const auto &found = GetSource(source_id);
 
-    const auto &found = LoadedSources[source_id];
-    return found.GetRasterInterpolate(static_cast<std::int32_t>(util::toFixed(util::FloatLongitude{lon})),
-                                      static_cast<std::int32_t>(util::toFixed(util::FloatLatitude{lat})));
+    std::vector<RasterDatum> data(coordinates.size());
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, coordinates.size(), RASTER_LOOKUP_GRAIN_SIZE),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                data[index] = found.GetRasterInterpolate(
+                    static_cast<std::int32_t>(coordinates[index].lon),
+                    static_cast<std::int32_t>(coordinates[index].lat));
+            }
+        });
+    return data;
 }
 }
 }
@@ -1,5 +1,11 @@
 #include "extractor/restriction_map.hpp"
 
+#include "util/integer_range.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
 namespace osrm
 {
 namespace extractor
@@ -16,6 +22,25 @@ RestrictionMap::RestrictionMap(const std::vector<TurnRestriction> &restriction_l
         // This will be a problem if we have more than 2^32 actual restrictions
         BOOST_ASSERT(restriction.from.node < std::numeric_limits<NodeID>::max());
         BOOST_ASSERT(restriction.via.node < std::numeric_limits<NodeID>::max());
+
+        // All nodes of a via-way restriction are kept out of the graph compression, so the
+        // restriction still refers to the same edges afterwards
+        if (restriction.flags.uses_via_way)
+        {
+            const ViaWayRestriction via_way_restriction{
+                static_cast<NodeID>(restriction.from.node),
+                static_cast<NodeID>(restriction.via.node),
+                static_cast<NodeID>(restriction.via_end.node),
+                static_cast<NodeID>(restriction.to.node),
+                restriction.flags.is_only};
+            m_no_turn_via_node_set.insert(via_way_restriction.from);
+            m_no_turn_via_node_set.insert(via_way_restriction.via_start);
+            m_no_turn_via_node_set.insert(via_way_restriction.via_end);
+            m_no_turn_via_node_set.insert(via_way_restriction.to);
+            m_via_way_restrictions.push_back(via_way_restriction);
+            continue;
+        }
+
         m_restriction_start_nodes.insert(restriction.from.node);
         m_no_turn_via_node_set.insert(restriction.via.node);
 
@@ -58,6 +83,59 @@ bool RestrictionMap::IsViaNode(const NodeID node) const
     return m_no_turn_via_node_set.find(node) != m_no_turn_via_node_set.end();
 }
 
+void RestrictionMap::BuildFlatIndex(const std::size_t number_of_nodes)
+{
+    using SourceEntry = std::pair<RestrictionSource, unsigned>;
+    std::vector<SourceEntry> sources(m_restriction_map.begin(), m_restriction_map.end());
+    std::sort(sources.begin(), sources.end(), [](const SourceEntry &lhs, const SourceEntry &rhs) {
+        return std::tie(lhs.first.start_node, lhs.first.via_node) <
+               std::tie(rhs.first.start_node, rhs.first.via_node);
+    });
+
+    m_flat_start_offsets.assign(number_of_nodes + 1, 0);
+    m_flat_via_nodes.clear();
+    m_flat_via_nodes.reserve(sources.size());
+    m_flat_target_offsets.assign(1, 0);
+    m_flat_target_offsets.reserve(sources.size() + 1);
+    m_flat_targets.clear();
+    m_flat_targets.reserve(m_count);
+
+    for (const auto &source : sources)
+    {
+        BOOST_ASSERT(source.first.start_node < number_of_nodes);
+        ++m_flat_start_offsets[source.first.start_node + 1];
+        m_flat_via_nodes.push_back(source.first.via_node);
+
+        const auto &bucket = m_restriction_bucket_list[source.second];
+        m_flat_targets.insert(m_flat_targets.end(), bucket.begin(), bucket.end());
+        m_flat_target_offsets.push_back(static_cast<std::uint32_t>(m_flat_targets.size()));
+    }
+    std::partial_sum(
+        m_flat_start_offsets.begin(), m_flat_start_offsets.end(), m_flat_start_offsets.begin());
+}
+
+std::pair<std::uint32_t, std::uint32_t>
+RestrictionMap::GetFlatTargetRange(const NodeID node_u, const NodeID node_v) const
+{
+    BOOST_ASSERT_MSG(!m_flat_start_offsets.empty(), "flat restriction index not built");
+
+    if (node_u + 1 >= m_flat_start_offsets.size())
+    {
+        return {0, 0};
+    }
+
+    const auto vias_begin = m_flat_via_nodes.begin() + m_flat_start_offsets[node_u];
+    const auto vias_end = m_flat_via_nodes.begin() + m_flat_start_offsets[node_u + 1];
+    const auto via = std::lower_bound(vias_begin, vias_end, node_v);
+    if (via == vias_end || *via != node_v)
+    {
+        return {0, 0};
+    }
+
+    const auto index = std::distance(m_flat_via_nodes.begin(), via);
+    return {m_flat_target_offsets[index], m_flat_target_offsets[index + 1]};
+}
+
 // Replaces start edge (v, w) with (u, w). Only start node changes.
 void RestrictionMap::FixupStartingTurnRestriction(const NodeID node_u,
                                                   const NodeID node_v,
@@ -66,6 +144,7 @@ void RestrictionMap::FixupStartingTurnRestriction(const NodeID node_u,
     BOOST_ASSERT(node_u != SPECIAL_NODEID);
     BOOST_ASSERT(node_v != SPECIAL_NODEID);
     BOOST_ASSERT(node_w != SPECIAL_NODEID);
+    BOOST_ASSERT_MSG(m_flat_start_offsets.empty(), "restrictions changed after BuildFlatIndex");
 
     if (!IsSourceNode(node_v))
     {
@@ -92,22 +171,12 @@ NodeID RestrictionMap::CheckForEmanatingIsOnlyTurn(const NodeID node_u, const No
     BOOST_ASSERT(node_u != SPECIAL_NODEID);
     BOOST_ASSERT(node_v != SPECIAL_NODEID);
 
-    if (!IsSourceNode(node_u))
+    const auto range = GetFlatTargetRange(node_u, node_v);
+    for (const auto index : util::irange(range.first, range.second))
     {
-        return SPECIAL_NODEID;
-    }
-
-    const auto restriction_iter = m_restriction_map.find({node_u, node_v});
-    if (restriction_iter != m_restriction_map.end())
-    {
-        const unsigned index = restriction_iter->second;
-        const auto &bucket = m_restriction_bucket_list.at(index);
-        for (const RestrictionTarget &restriction_target : bucket)
+        if (m_flat_targets[index].is_only)
         {
-            if (restriction_target.is_only)
-            {
-                return restriction_target.target_node;
-            }
+            return m_flat_targets[index].target_node;
         }
     }
     return SPECIAL_NODEID;
@@ -122,22 +191,10 @@ bool RestrictionMap::CheckIfTurnIsRestricted(const NodeID node_u,
     BOOST_ASSERT(node_v != SPECIAL_NODEID);
     BOOST_ASSERT(node_w != SPECIAL_NODEID);
 
-    if (!IsSourceNode(node_u))
-    {
-        return false;
-    }
-
-    const auto restriction_iter = m_restriction_map.find({node_u, node_v});
-    if (restriction_iter == m_restriction_map.end())
-    {
-        return false;
-    }
-
-    const unsigned index = restriction_iter->second;
-    const auto &bucket = m_restriction_bucket_list.at(index);
-
-    for (const RestrictionTarget &restriction_target : bucket)
+    const auto range = GetFlatTargetRange(node_u, node_v);
+    for (const auto index : util::irange(range.first, range.second))
     {
+        const RestrictionTarget &restriction_target = m_flat_targets[index];
         if (node_w == restriction_target.target_node && // target found
             !restriction_target.is_only)                // and not an only_-restr.
         {
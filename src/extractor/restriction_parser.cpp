@@ -165,11 +165,11 @@ RestrictionParser::TryParse(const osmium::Relation &relation) const
             {
                 restriction_container.restriction.to.way = member.ref();
             }
-            // else if (0 == strcmp("via", role))
-            // {
-            //     not yet suppported
-            //     restriction_container.restriction.via.way = member.ref();
-            // }
+            else if (0 == strcmp("via", role))
+            {
+                restriction_container.restriction.via.way = member.ref();
+                restriction_container.restriction.flags.uses_via_way = true;
+            }
             break;
         case osmium::item_type::relation:
             // not yet supported, but who knows what the future holds...
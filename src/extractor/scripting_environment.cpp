@@ -7,6 +7,7 @@
 #include "extractor/internal_extractor_edge.hpp"
 #include "extractor/profile_properties.hpp"
 #include "extractor/raster_source.hpp"
+#include "extractor/way_tag_filter.hpp"
 #include "util/exception.hpp"
 #include "util/lua_util.hpp"
 #include "util/make_unique.hpp"
@@ -48,6 +49,11 @@ template <class T> double lonToDouble(T const &object)
 // simply wrap it
 auto get_nodes_for_way(const osmium::Way &way) -> decltype(way.nodes()) { return way.nodes(); }
 
+// EdgeClasses is the same type as TravelMode, the constants need a class of their own
+struct EdgeClassConstants
+{
+};
+
 // Error handler
 int luaErrorCallback(lua_State *state)
 {
@@ -61,6 +67,9 @@ int luaErrorCallback(lua_State *state)
 ScriptingEnvironment::ScriptingEnvironment(const std::string &file_name) : file_name(file_name)
 {
     util::SimpleLogger().Write() << "Using script " << file_name;
+#ifdef OSRM_LUAJIT
+    util::SimpleLogger().Write() << "Running the profile with LuaJIT";
+#endif
 }
 
 void ScriptingEnvironment::InitContext(ScriptingEnvironment::Context &context)
@@ -98,6 +107,11 @@ void ScriptingEnvironment::InitContext(ScriptingEnvironment::Context &context)
              .def("interpolate", &SourceContainer::GetRasterInterpolateFromSource),
          luabind::class_<const float>("constants")
              .enum_("enums")[luabind::value("precision", COORDINATE_PRECISION)],
+         luabind::class_<EdgeClassConstants>("edge_class")
+             .enum_("enums")[luabind::value("none", EDGE_CLASS_NONE),
+                             luabind::value("toll", EDGE_CLASS_TOLL),
+                             luabind::value("motorway", EDGE_CLASS_MOTORWAY),
+                             luabind::value("ferry", EDGE_CLASS_FERRY)],
 
          luabind::class_<ProfileProperties>("ProfileProperties")
              .def(luabind::constructor<>())
@@ -116,6 +130,13 @@ void ScriptingEnvironment::InitContext(ScriptingEnvironment::Context &context)
              static_cast<void (std::vector<std::string>::*)(const std::string &)>(
                  &std::vector<std::string>::push_back)),
 
+         luabind::class_<WayTagFilter>("WayTagFilter")
+             .def("Require", &WayTagFilter::Require)
+             .def("Reject", &WayTagFilter::Reject)
+             .def("AddAccessKey", &WayTagFilter::AddAccessKey)
+             .def("RequireAccess", &WayTagFilter::RequireAccess)
+             .def("RejectAccess", &WayTagFilter::RejectAccess),
+
          luabind::class_<osmium::Location>("Location")
              .def<location_member_ptr_type>("lat", &osmium::Location::lat)
              .def<location_member_ptr_type>("lon", &osmium::Location::lon),
@@ -148,7 +169,8 @@ void ScriptingEnvironment::InitContext(ScriptingEnvironment::Context &context)
                  "forward_mode", &ExtractionWay::get_forward_mode, &ExtractionWay::set_forward_mode)
              .property("backward_mode",
                        &ExtractionWay::get_backward_mode,
-                       &ExtractionWay::set_backward_mode),
+                       &ExtractionWay::set_backward_mode)
+             .property("classes", &ExtractionWay::get_classes, &ExtractionWay::set_classes),
          luabind::class_<osmium::WayNodeList>("WayNodeList").def(luabind::constructor<>()),
          luabind::class_<osmium::NodeRef>("NodeRef")
              .def(luabind::constructor<>())
@@ -187,19 +209,27 @@ void ScriptingEnvironment::InitContext(ScriptingEnvironment::Context &context)
         error_stream << error_msg;
         throw util::exception("ERROR occurred in profile script:\n" + error_stream.str());
     }
+
+    // every state loads the raster sources, they are read once and shared between the states
+    if (util::luaFunctionExists(context.state, "source_function"))
+    {
+        luabind::call_function<void>(context.state, "source_function");
+    }
 }
 
 ScriptingEnvironment::Context &ScriptingEnvironment::GetContex()
 {
-    std::lock_guard<std::mutex> lock(init_mutex);
-    bool initialized = false;
-    auto &ref = script_contexts.local(initialized);
-    if (!initialized)
+    // The context of a thread is kept for all phases of the extraction, only setting one up
+    // needs the lock, as loading the profile registers classes with luabind.
+    bool exists = false;
+    auto &ref = script_contexts.local(exists);
+    if (!exists || !ref)
     {
+        std::lock_guard<std::mutex> lock(init_mutex);
         ref = util::make_unique<Context>();
         InitContext(*ref);
+        luabind::set_pcall_callback(&luaErrorCallback);
     }
-    luabind::set_pcall_callback(&luaErrorCallback);
 
     return *ref;
 }
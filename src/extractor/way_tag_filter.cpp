@@ -0,0 +1,108 @@
+#include "extractor/way_tag_filter.hpp"
+
+#include "util/exception.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace osrm
+{
+namespace extractor
+{
+
+void WayTagFilter::Require(const std::string &group,
+                           const std::string &key,
+                           const std::string &value)
+{
+    auto &rules = key_rules[key];
+    auto &rule = value.empty() ? rules.any_value : rules.values[value];
+    rule.groups |= GetGroup(group);
+}
+
+void WayTagFilter::Reject(const std::string &key, const std::string &value)
+{
+    auto &rules = key_rules[key];
+    auto &rule = value.empty() ? rules.any_value : rules.values[value];
+    rule.rejects = true;
+}
+
+void WayTagFilter::AddAccessKey(const std::string &key) { access_keys.push_back(key); }
+
+void WayTagFilter::RequireAccess(const std::string &group, const std::string &value)
+{
+    access_rules.values[value].groups |= GetGroup(group);
+}
+
+void WayTagFilter::RejectAccess(const std::string &value)
+{
+    access_rules.values[value].rejects = true;
+}
+
+bool WayTagFilter::Rejects(const osmium::TagList &tags) const
+{
+    std::uint32_t satisfied_groups = 0;
+    bool rejected = false;
+
+    for (const auto &tag : tags)
+    {
+        if (*tag.value() == '\0')
+        {
+            continue;
+        }
+        const auto rules = key_rules.find(tag.key());
+        if (rules != key_rules.end())
+        {
+            rules->second.Apply(tag.value(), satisfied_groups, rejected);
+        }
+    }
+
+    for (const auto &key : access_keys)
+    {
+        const char *value = tags.get_value_by_key(key.c_str(), "");
+        if (*value != '\0')
+        {
+            access_rules.Apply(value, satisfied_groups, rejected);
+            break;
+        }
+    }
+
+    return rejected || (satisfied_groups & required_groups) != required_groups;
+}
+
+void WayTagFilter::ValueRules::Apply(const char *value,
+                                     std::uint32_t &satisfied_groups,
+                                     bool &rejected) const
+{
+    satisfied_groups |= any_value.groups;
+    rejected |= any_value.rejects;
+
+    if (values.empty())
+    {
+        return;
+    }
+    const auto rule = values.find(value);
+    if (rule != values.end())
+    {
+        satisfied_groups |= rule->second.groups;
+        rejected |= rule->second.rejects;
+    }
+}
+
+std::uint32_t WayTagFilter::GetGroup(const std::string &group)
+{
+    auto name = std::find(group_names.begin(), group_names.end(), group);
+    if (name == group_names.end())
+    {
+        if (group_names.size() == 32)
+        {
+            throw util::exception("Way tag filter has more than 32 groups");
+        }
+        name = group_names.insert(group_names.end(), group);
+    }
+
+    const std::uint32_t group_bit = 1u << std::distance(group_names.begin(), name);
+    required_groups |= group_bit;
+    return group_bit;
+}
+}
+}
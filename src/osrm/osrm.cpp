@@ -1,14 +1,18 @@
 #include "osrm/osrm.hpp"
+#include "engine/api/isochrone_parameters.hpp"
 #include "engine/api/match_parameters.hpp"
 #include "engine/api/nearest_parameters.hpp"
 #include "engine/api/route_parameters.hpp"
 #include "engine/api/table_parameters.hpp"
+#include "engine/api/tile_parameters.hpp"
 #include "engine/api/trip_parameters.hpp"
 #include "engine/engine.hpp"
 #include "engine/engine_config.hpp"
 #include "engine/status.hpp"
 #include "util/make_unique.hpp"
 
+#include <utility>
+
 namespace osrm
 {
 
@@ -26,16 +30,40 @@ engine::Status OSRM::Route(const engine::api::RouteParameters &params, util::jso
     return engine_->Route(params, result);
 }
 
+engine::Status OSRM::Route(const std::vector<engine::api::RouteParameters> &params,
+                           json::Object &result)
+{
+    return engine_->Route(params, result);
+}
+
 engine::Status OSRM::Table(const engine::api::TableParameters &params, json::Object &result)
 {
     return engine_->Table(params, result);
 }
 
+engine::Status OSRM::Table(const engine::api::TableParameters &params, std::vector<char> &result)
+{
+    return engine_->Table(params, result);
+}
+
+engine::Status OSRM::Table(const engine::api::TableParameters &params,
+                           std::vector<char> &result,
+                           const ChunkHandler &handle_chunk)
+{
+    return engine_->Table(params, result, handle_chunk);
+}
+
 engine::Status OSRM::Nearest(const engine::api::NearestParameters &params, json::Object &result)
 {
     return engine_->Nearest(params, result);
 }
 
+engine::Status OSRM::Nearest(const engine::api::NearestParameters &params,
+                             std::vector<char> &result)
+{
+    return engine_->Nearest(params, result);
+}
+
 engine::Status OSRM::Trip(const engine::api::TripParameters &params, json::Object &result)
 {
     return engine_->Trip(params, result);
@@ -46,9 +74,127 @@ engine::Status OSRM::Match(const engine::api::MatchParameters &params, json::Obj
     return engine_->Match(params, result);
 }
 
+engine::Status OSRM::Match(const std::vector<engine::api::MatchParameters> &params,
+                           json::Object &result)
+{
+    return engine_->Match(params, result);
+}
+
+engine::Status OSRM::Isochrone(const engine::api::IsochroneParameters &params,
+                               json::Object &result)
+{
+    return engine_->Isochrone(params, result);
+}
+
 engine::Status OSRM::Tile(const engine::api::TileParameters &params, std::string &result)
 {
     return engine_->Tile(params, result);
 }
 
+bool OSRM::RouteAsync(engine::api::RouteParameters params, Callback callback)
+{
+    return engine_->RouteAsync(std::move(params), std::move(callback));
+}
+
+bool OSRM::TableAsync(engine::api::TableParameters params, Callback callback)
+{
+    return engine_->TableAsync(std::move(params), std::move(callback));
+}
+
+bool OSRM::NearestAsync(engine::api::NearestParameters params, Callback callback)
+{
+    return engine_->NearestAsync(std::move(params), std::move(callback));
+}
+
+bool OSRM::TripAsync(engine::api::TripParameters params, Callback callback)
+{
+    return engine_->TripAsync(std::move(params), std::move(callback));
+}
+
+bool OSRM::MatchAsync(engine::api::MatchParameters params, Callback callback)
+{
+    return engine_->MatchAsync(std::move(params), std::move(callback));
+}
+
+bool OSRM::IsochroneAsync(engine::api::IsochroneParameters params, Callback callback)
+{
+    return engine_->IsochroneAsync(std::move(params), std::move(callback));
+}
+
+bool OSRM::TileAsync(engine::api::TileParameters params, TileCallback callback)
+{
+    return engine_->TileAsync(std::move(params), std::move(callback));
+}
+
+unsigned OSRM::GetDatasetGeneration() const { return engine_->GetDatasetGeneration(); }
+
+std::string OSRM::GetTimestamp() const { return engine_->GetTimestamp(); }
+
+void OSRM::GetMemoryUsage(json::Object &result) const { engine_->GetMemoryUsage(result); }
+
+void OSRM::PrepareThread() { engine_->PrepareThread(); }
+
+OSRM::Snapshot OSRM::GetSnapshot() { return Snapshot(*engine_, engine_->TakeSnapshot()); }
+
+OSRM::Snapshot::Snapshot(const engine::Engine &engine,
+                         std::shared_ptr<const engine::EngineSnapshot> snapshot)
+    : engine_(&engine), snapshot_(std::move(snapshot))
+{
+}
+
+engine::Status OSRM::Snapshot::Route(const engine::api::RouteParameters &params,
+                                     json::Object &result) const
+{
+    return engine_->Route(*snapshot_, params, result);
+}
+
+engine::Status OSRM::Snapshot::Table(const engine::api::TableParameters &params,
+                                     json::Object &result) const
+{
+    return engine_->Table(*snapshot_, params, result);
+}
+
+engine::Status OSRM::Snapshot::Table(const engine::api::TableParameters &params,
+                                     std::vector<char> &result) const
+{
+    return engine_->Table(*snapshot_, params, result);
+}
+
+engine::Status OSRM::Snapshot::Nearest(const engine::api::NearestParameters &params,
+                                       json::Object &result) const
+{
+    return engine_->Nearest(*snapshot_, params, result);
+}
+
+engine::Status OSRM::Snapshot::Trip(const engine::api::TripParameters &params,
+                                    json::Object &result) const
+{
+    return engine_->Trip(*snapshot_, params, result);
+}
+
+engine::Status OSRM::Snapshot::Match(const engine::api::MatchParameters &params,
+                                     json::Object &result) const
+{
+    return engine_->Match(*snapshot_, params, result);
+}
+
+engine::Status OSRM::Snapshot::Isochrone(const engine::api::IsochroneParameters &params,
+                                         json::Object &result) const
+{
+    return engine_->Isochrone(*snapshot_, params, result);
+}
+
+engine::Status OSRM::Snapshot::Tile(const engine::api::TileParameters &params,
+                                    std::string &result) const
+{
+    return engine_->Tile(*snapshot_, params, result);
+}
+
+unsigned OSRM::Snapshot::GetDatasetGeneration() const
+{
+    return engine_->GetDatasetGeneration(*snapshot_);
+}
+
+std::string OSRM::Snapshot::GetTimestamp() const { return engine_->GetTimestamp(*snapshot_); }
+
 } // ns osrm
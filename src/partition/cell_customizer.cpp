@@ -0,0 +1,112 @@
+#include "partition/cell_customizer.hpp"
+
+#include "util/integer_range.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+namespace osrm
+{
+namespace partition
+{
+
+void CellCustomizer::Customize(const BaseGraph &graph, CellStorage &cells) const
+{
+    tbb::enumerable_thread_specific<Heap> heaps(graph.GetNumberOfNodes());
+
+    // the cliques of a level are built from the cliques of the level below
+    for (LevelID level = 1; level < partition.GetNumberOfLevels(); ++level)
+    {
+        tbb::parallel_for(tbb::blocked_range<CellID>(0, partition.GetNumberOfCells(level)),
+                          [&](const tbb::blocked_range<CellID> &range) {
+                              auto &heap = heaps.local();
+                              for (auto id = range.begin(), end = range.end(); id != end; ++id)
+                              {
+                                  CustomizeCell(graph, heap, cells, level, id);
+                              }
+                          });
+    }
+}
+
+void CellCustomizer::CustomizeCell(const BaseGraph &graph,
+                                   Heap &heap,
+                                   CellStorage &cells,
+                                   const LevelID level,
+                                   const CellID id) const
+{
+    const LevelID sub_level = level - 1;
+    auto cell = cells.GetCell(level, id);
+
+    const auto relax = [&heap](const NodeID target, const EdgeWeight weight) {
+        if (!heap.WasInserted(target))
+        {
+            heap.Insert(target, weight, {});
+        }
+        else if (weight < heap.GetKey(target))
+        {
+            heap.DecreaseKey(target, weight);
+        }
+    };
+
+    for (const auto source_index : util::irange<std::uint32_t>(0, cell.GetNumberOfSources()))
+    {
+        heap.Clear();
+        heap.Insert(cell.GetSource(source_index), 0, {});
+
+        while (!heap.Empty())
+        {
+            const NodeID node = heap.DeleteMin();
+            const EdgeWeight weight = heap.GetKey(node);
+
+            if (sub_level > 0)
+            {
+                const auto sub_cell = cells.GetCell(sub_level, partition.GetCell(sub_level, node));
+                const auto sub_source_index = sub_cell.GetSourceIndex(node);
+                if (sub_source_index < sub_cell.GetNumberOfSources())
+                {
+                    for (const auto destination_index :
+                         util::irange<std::uint32_t>(0, sub_cell.GetNumberOfDestinations()))
+                    {
+                        const auto clique_weight =
+                            sub_cell.GetWeight(sub_source_index, destination_index);
+                        if (clique_weight != INVALID_EDGE_WEIGHT)
+                        {
+                            relax(sub_cell.GetDestination(destination_index),
+                                  weight + clique_weight);
+                        }
+                    }
+                }
+            }
+
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                const auto &data = graph.GetEdgeData(edge);
+                if (!data.forward)
+                    continue;
+
+                const NodeID target = graph.GetTarget(edge);
+                if (partition.GetCell(level, target) != id)
+                    continue;
+                // arcs inside of a sub-cell are covered by its clique
+                if (sub_level > 0 &&
+                    partition.GetCell(sub_level, node) == partition.GetCell(sub_level, target))
+                    continue;
+
+                relax(target, weight + data.distance);
+            }
+        }
+
+        for (const auto destination_index :
+             util::irange<std::uint32_t>(0, cell.GetNumberOfDestinations()))
+        {
+            const NodeID destination = cell.GetDestination(destination_index);
+            if (heap.WasInserted(destination))
+            {
+                cell.SetWeight(source_index, destination_index, heap.GetKey(destination));
+            }
+        }
+    }
+}
+}
+}
@@ -0,0 +1,176 @@
+#include "partition/recursive_bisection.hpp"
+
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+
+namespace osrm
+{
+namespace partition
+{
+
+namespace
+{
+const constexpr CellID INVALID_CELL_ID = std::numeric_limits<CellID>::max();
+
+struct UndirectedGraph
+{
+    UndirectedGraph(const std::size_t number_of_nodes,
+                    const std::vector<std::pair<NodeID, NodeID>> &edges)
+        : offsets(number_of_nodes + 1, 0)
+    {
+        for (const auto &edge : edges)
+        {
+            ++offsets[edge.first + 1];
+            ++offsets[edge.second + 1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        targets.resize(offsets.back());
+        std::vector<std::size_t> position(offsets.begin(), offsets.end() - 1);
+        for (const auto &edge : edges)
+        {
+            targets[position[edge.first]++] = edge.second;
+            targets[position[edge.second]++] = edge.first;
+        }
+    }
+
+    std::vector<std::size_t> offsets;
+    std::vector<NodeID> targets;
+};
+
+// Breadth-first search restricted to the nodes tagged with set_tag. Appends the visited nodes in
+// the order they were discovered.
+void orderBreadthFirst(const UndirectedGraph &graph,
+                       const std::vector<std::uint32_t> &node_to_set,
+                       const std::uint32_t set_tag,
+                       std::vector<std::uint32_t> &node_to_visit,
+                       const std::uint32_t visit_tag,
+                       const NodeID start,
+                       std::vector<NodeID> &order)
+{
+    auto queue_position = order.size();
+    order.push_back(start);
+    node_to_visit[start] = visit_tag;
+    while (queue_position < order.size())
+    {
+        const NodeID node = order[queue_position++];
+        for (auto index = graph.offsets[node]; index != graph.offsets[node + 1]; ++index)
+        {
+            const NodeID target = graph.targets[index];
+            if (node_to_set[target] == set_tag && node_to_visit[target] != visit_tag)
+            {
+                node_to_visit[target] = visit_tag;
+                order.push_back(target);
+            }
+        }
+    }
+}
+}
+
+MultiLevelPartition bisectGraph(const std::size_t number_of_nodes,
+                                const std::vector<std::pair<NodeID, NodeID>> &edges,
+                                const std::vector<std::size_t> &max_cell_sizes)
+{
+    if (max_cell_sizes.empty() || max_cell_sizes.front() == 0 ||
+        !std::is_sorted(max_cell_sizes.begin(),
+                        max_cell_sizes.end(),
+                        [](const std::size_t lhs, const std::size_t rhs) { return lhs <= rhs; }))
+    {
+        throw util::exception("Cell sizes need to be positive and strictly increasing");
+    }
+    if (max_cell_sizes.size() >= std::numeric_limits<LevelID>::max())
+    {
+        throw util::exception("Too many partition levels");
+    }
+
+    const UndirectedGraph graph(number_of_nodes, edges);
+    const auto number_of_levels = static_cast<LevelID>(max_cell_sizes.size());
+
+    std::vector<std::vector<CellID>> level_to_cell_ids(
+        number_of_levels, std::vector<CellID>(number_of_nodes, INVALID_CELL_ID));
+    std::vector<CellID> number_of_cells(number_of_levels, 0);
+
+    std::vector<std::uint32_t> node_to_set(number_of_nodes, 0);
+    std::vector<std::uint32_t> node_to_visit(number_of_nodes, 0);
+    std::uint32_t set_tag = 0;
+    std::uint32_t visit_tag = 0;
+
+    // a set of nodes together with the highest level that has no cell assigned yet
+    struct NodeSet
+    {
+        std::vector<NodeID> nodes;
+        LevelID unassigned_level;
+    };
+    std::vector<NodeSet> stack;
+    {
+        NodeSet all_nodes{std::vector<NodeID>(number_of_nodes), number_of_levels};
+        std::iota(all_nodes.nodes.begin(), all_nodes.nodes.end(), 0);
+        stack.push_back(std::move(all_nodes));
+    }
+
+    std::vector<NodeID> order;
+    while (!stack.empty())
+    {
+        NodeSet set = std::move(stack.back());
+        stack.pop_back();
+
+        // the largest set that fits a level forms a cell of that level
+        while (set.unassigned_level > 0 &&
+               set.nodes.size() <= max_cell_sizes[set.unassigned_level - 1])
+        {
+            const auto level = set.unassigned_level - 1;
+            const auto cell = number_of_cells[level]++;
+            for (const auto node : set.nodes)
+            {
+                level_to_cell_ids[level][node] = cell;
+            }
+            --set.unassigned_level;
+        }
+        if (set.unassigned_level == 0 || set.nodes.empty())
+        {
+            continue;
+        }
+
+        ++set_tag;
+        for (const auto node : set.nodes)
+        {
+            node_to_set[node] = set_tag;
+        }
+
+        // the last node of a breadth-first search is far away from its start
+        order.clear();
+        orderBreadthFirst(
+            graph, node_to_set, set_tag, node_to_visit, ++visit_tag, set.nodes.front(), order);
+        const NodeID peripheral_node = order.back();
+
+        order.clear();
+        ++visit_tag;
+        orderBreadthFirst(
+            graph, node_to_set, set_tag, node_to_visit, visit_tag, peripheral_node, order);
+        // disconnected parts are appended one after another
+        for (const auto node : set.nodes)
+        {
+            if (node_to_visit[node] != visit_tag)
+            {
+                orderBreadthFirst(
+                    graph, node_to_set, set_tag, node_to_visit, visit_tag, node, order);
+            }
+        }
+        BOOST_ASSERT(order.size() == set.nodes.size());
+
+        const auto middle = order.begin() + order.size() / 2;
+        stack.push_back(NodeSet{std::vector<NodeID>(middle, order.end()), set.unassigned_level});
+        stack.push_back(NodeSet{std::vector<NodeID>(order.begin(), middle), set.unassigned_level});
+    }
+
+    return MultiLevelPartition(std::move(level_to_cell_ids));
+}
+}
+}
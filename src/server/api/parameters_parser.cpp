@@ -1,5 +1,6 @@
 #include "server/api/parameters_parser.hpp"
 
+#include "server/api/isochrone_parameter_grammar.hpp"
 #include "server/api/match_parameter_grammar.hpp"
 #include "server/api/nearest_parameter_grammar.hpp"
 #include "server/api/route_parameters_grammar.hpp"
@@ -7,6 +8,8 @@
 #include "server/api/tile_parameter_grammar.hpp"
 #include "server/api/trip_parameter_grammar.hpp"
 
+#include "engine/metrics.hpp"
+
 #include <type_traits>
 
 namespace osrm
@@ -26,6 +29,7 @@ using is_grammar_t =
                                std::is_same<NearestParametersGrammar<>, T>::value ||
                                std::is_same<TripParametersGrammar<>, T>::value ||
                                std::is_same<MatchParametersGrammar<>, T>::value ||
+                               std::is_same<IsochroneParametersGrammar<>, T>::value ||
                                std::is_same<TileParametersGrammar<>, T>::value>;
 
 template <typename ParameterT,
@@ -38,6 +42,7 @@ boost::optional<ParameterT> parseParameters(std::string::iterator &iter,
     using It = std::decay<decltype(iter)>::type;
 
     static const GrammarT grammar;
+    engine::metrics::StageTimer timer(engine::metrics::Stage::Parse);
 
     try
     {
@@ -99,6 +104,14 @@ boost::optional<engine::api::MatchParameters> parseParameters(std::string::itera
                                                                                            end);
 }
 
+template <>
+boost::optional<engine::api::IsochroneParameters> parseParameters(std::string::iterator &iter,
+                                                                  const std::string::iterator end)
+{
+    return detail::parseParameters<engine::api::IsochroneParameters,
+                                   IsochroneParametersGrammar<>>(iter, end);
+}
+
 template <>
 boost::optional<engine::api::TileParameters> parseParameters(std::string::iterator &iter,
                                                              const std::string::iterator end)
@@ -1,61 +1,84 @@
 #include "server/api/url_parser.hpp"
-#include "engine/polyline_compressor.hpp"
-
-#include <boost/fusion/include/adapt_struct.hpp>
-#include <boost/spirit/include/phoenix.hpp>
-#include <boost/spirit/include/qi.hpp>
-#include <boost/spirit/repository/include/qi_iter_pos.hpp>
 
+#include <limits>
 #include <string>
-#include <type_traits>
-
-BOOST_FUSION_ADAPT_STRUCT(osrm::server::api::ParsedURL,
-                          (std::string, service)(unsigned, version)(std::string,
-                                                                    profile)(std::string, query))
+#include <utility>
 
 // Keep impl. TU local
 namespace
 {
-namespace ph = boost::phoenix;
-namespace qi = boost::spirit::qi;
+using Iterator = std::string::iterator;
+
+bool isAlphaNumeral(const char character)
+{
+    return (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z') ||
+           (character >= '0' && character <= '9');
+}
 
-template <typename Iterator, typename Into> //
-struct URLParser final : qi::grammar<Iterator, Into>
+// Everything the option grammars and encoded polylines use: printable ASCII without
+// the space and !"#$'*+/<>
+bool isQueryCharacter(const char character)
 {
-    URLParser() : URLParser::base_type(start)
+    if (character <= ' ' || character >= '\x7f')
+        return false;
+
+    switch (character)
     {
-        using boost::spirit::repository::qi::iter_pos;
+    case '!':
+    case '"':
+    case '#':
+    case '$':
+    case '\'':
+    case '*':
+    case '+':
+    case '/':
+    case '<':
+    case '>':
+        return false;
+    default:
+        return true;
+    }
+}
 
-        alpha_numeral = qi::char_("a-zA-Z0-9");
-        polyline_chars = qi::char_("a-zA-Z0-9_.--[]{}@?|\\%~`^");
-        all_chars = polyline_chars | qi::char_("=,;:&().");
+bool parseLiteral(Iterator &iter, const Iterator end, const char literal)
+{
+    if (iter == end || *iter != literal)
+        return false;
 
-        service = +alpha_numeral;
-        version = qi::uint_;
-        profile = +alpha_numeral;
-        query = +all_chars;
+    ++iter;
+    return true;
+}
 
-        // Example input: /route/v1/driving/7.416351,43.731205;7.420363,43.736189
+template <typename Predicate>
+bool parseString(Iterator &iter, const Iterator end, Predicate predicate, std::string &out)
+{
+    const auto first = iter;
+    while (iter != end && predicate(*iter))
+        ++iter;
 
-        start = qi::lit('/') > service > qi::lit('/') > qi::lit('v') > version > qi::lit('/') >
-                profile > qi::lit('/') >
-                qi::omit[iter_pos[ph::bind(&osrm::server::api::ParsedURL::prefix_length, qi::_val) =
-                                      qi::_1 - qi::_r1]] > query;
+    out.assign(first, iter);
+    return first != iter;
+}
 
-        BOOST_SPIRIT_DEBUG_NODES((start)(service)(version)(profile)(query))
+bool parseVersion(Iterator &iter, const Iterator end, unsigned &out)
+{
+    auto first = iter;
+    unsigned version = 0;
+    for (; first != end && *first >= '0' && *first <= '9'; ++first)
+    {
+        const unsigned digit = *first - '0';
+        if (version > (std::numeric_limits<unsigned>::max() - digit) / 10)
+            return false;
+        version = version * 10 + digit;
     }
 
-    qi::rule<Iterator, Into> start;
+    if (first == iter)
+        return false;
 
-    qi::rule<Iterator, std::string()> service;
-    qi::rule<Iterator, unsigned()> version;
-    qi::rule<Iterator, std::string()> profile;
-    qi::rule<Iterator, std::string()> query;
-
-    qi::rule<Iterator, char()> alpha_numeral;
-    qi::rule<Iterator, char()> all_chars;
-    qi::rule<Iterator, char()> polyline_chars;
-};
+    iter = first;
+    out = version;
+    return true;
+}
 
 } // anon.
 
@@ -66,28 +89,67 @@ namespace server
 namespace api
 {
 
+// Example input: /route/v1/driving/7.416351,43.731205;7.420363,43.736189
+//
+// On failure iter points to the first character that does not fit, the same as the
+// expectation failures of a grammar '/' > service > "/v" > version > '/' > profile > '/' > query
 boost::optional<ParsedURL> parseURL(std::string::iterator &iter, const std::string::iterator end)
 {
-    using It = std::decay<decltype(iter)>::type;
-
-    static URLParser<It, ParsedURL(It)> const parser;
+    const auto begin = iter;
     ParsedURL out;
 
-    try
-    {
-        const auto ok = boost::spirit::qi::parse(iter, end, parser(boost::phoenix::val(iter)), out);
+    if (!parseLiteral(iter, end, '/'))
+        return boost::none;
 
-        if (ok && iter == end)
-            return boost::make_optional(out);
-    }
-    catch (const qi::expectation_failure<It> &failure)
+    const auto ok = parseString(iter, end, isAlphaNumeral, out.service) &&
+                    parseLiteral(iter, end, '/') && parseLiteral(iter, end, 'v') &&
+                    parseVersion(iter, end, out.version) && parseLiteral(iter, end, '/') &&
+                    parseString(iter, end, isAlphaNumeral, out.profile) &&
+                    parseLiteral(iter, end, '/');
+    if (!ok)
+        return boost::none;
+
+    out.prefix_length = std::distance(begin, iter);
+
+    if (!parseString(iter, end, isQueryCharacter, out.query) || iter != end)
+        return boost::none;
+
+    return boost::make_optional(std::move(out));
+}
+
+namespace
+{
+// The position of the value of the option, npos without it
+std::size_t findOption(const std::string &query, const std::string &name)
+{
+    // options start after '?' or '&', polylines may contain '?' as well but never '='
+    const auto option = name + '=';
+    for (auto position = query.find(option); position != std::string::npos;
+         position = query.find(option, position + 1))
     {
-        // The grammar above using expectation parsers ">" does not automatically increment the
-        // iterator to the failing position. Extract the position from the exception ourselves.
-        iter = failure.first;
+        if (position > 0 && (query[position - 1] == '?' || query[position - 1] == '&'))
+        {
+            return position + option.size();
+        }
     }
+    return std::string::npos;
+}
+}
+
+bool hasOption(const std::string &query, const std::string &name)
+{
+    return findOption(query, name) != std::string::npos;
+}
 
-    return boost::none;
+std::string getOption(const std::string &query, const std::string &name)
+{
+    const auto value = findOption(query, name);
+    if (value == std::string::npos)
+    {
+        return {};
+    }
+    // values end at the next option or the next query of a batch
+    return query.substr(value, query.find_first_of("&:", value) - value);
 }
 
 } // api
@@ -0,0 +1,176 @@
+#include "server/compressor.hpp"
+
+#include "util/exception.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/thread/tss.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace osrm
+{
+namespace server
+{
+
+namespace
+{
+Compressor::Statistics statistics;
+boost::thread_specific_ptr<Compressor> thread_compressor;
+
+// there's a trade-off between speed and size, by default speed wins
+int compression_level = Compressor::DEFAULT_LEVEL;
+std::size_t min_compressed_size = Compressor::DEFAULT_MIN_SIZE;
+const constexpr int MEMORY_LEVEL = 8;
+// negative window bits produce raw deflate data, adding 16 wraps it into a gzip header
+const constexpr int DEFLATE_WINDOW_BITS = -MAX_WBITS;
+const constexpr int GZIP_WINDOW_BITS = MAX_WBITS + 16;
+}
+
+constexpr int Compressor::DEFAULT_LEVEL;
+constexpr std::size_t Compressor::DEFAULT_MIN_SIZE;
+
+Compressor::Compressor() : gzip_initialized(false), deflate_initialized(false) {}
+
+Compressor::~Compressor()
+{
+    if (gzip_initialized)
+    {
+        deflateEnd(&gzip_stream);
+    }
+    if (deflate_initialized)
+    {
+        deflateEnd(&deflate_stream);
+    }
+}
+
+Compressor &Compressor::ForCurrentThread()
+{
+    if (!thread_compressor.get())
+    {
+        thread_compressor.reset(new Compressor());
+    }
+    return *thread_compressor;
+}
+
+const Compressor::Statistics &Compressor::GetStatistics() { return statistics; }
+
+void Compressor::Configure(const int level, const std::size_t min_size)
+{
+    BOOST_ASSERT(level >= Z_BEST_SPEED && level <= Z_BEST_COMPRESSION);
+    compression_level = level;
+    min_compressed_size = min_size;
+}
+
+bool Compressor::ShouldCompress(const std::size_t size)
+{
+    if (size < min_compressed_size)
+    {
+        ++statistics.skipped_replies;
+        return false;
+    }
+    return true;
+}
+
+z_stream &Compressor::GetStream(const http::compression_type compression_type)
+{
+    BOOST_ASSERT(compression_type != http::no_compression);
+    const bool use_gzip = compression_type == http::gzip_rfc1952;
+    auto &stream = use_gzip ? gzip_stream : deflate_stream;
+    auto &initialized = use_gzip ? gzip_initialized : deflate_initialized;
+
+    if (initialized)
+    {
+        deflateReset(&stream);
+        return stream;
+    }
+
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    if (Z_OK != deflateInit2(&stream,
+                             compression_level,
+                             Z_DEFLATED,
+                             use_gzip ? GZIP_WINDOW_BITS : DEFLATE_WINDOW_BITS,
+                             MEMORY_LEVEL,
+                             Z_DEFAULT_STRATEGY))
+    {
+        throw util::exception("Could not initialize zlib stream");
+    }
+    initialized = true;
+    ++statistics.stream_initializations;
+
+    return stream;
+}
+
+void Compressor::Compress(const std::vector<char> &input,
+                          const http::compression_type compression_type,
+                          std::vector<char> &output)
+{
+    BOOST_ASSERT(input.size() <= std::numeric_limits<uInt>::max());
+    auto &stream = GetStream(compression_type);
+
+    // with enough space the whole reply is compressed in a single deflate call
+    const auto bound = deflateBound(&stream, static_cast<uLong>(input.size()));
+    if (output.capacity() < bound)
+    {
+        ++statistics.buffer_growths;
+    }
+    output.resize(bound);
+
+    // zlib does not modify the input, its API just predates const
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef *>(output.data());
+    stream.avail_out = static_cast<uInt>(output.size());
+
+    const auto result = deflate(&stream, Z_FINISH);
+    if (result != Z_STREAM_END)
+    {
+        throw util::exception("Could not compress reply");
+    }
+    output.resize(stream.total_out);
+
+    ++statistics.compressed_replies;
+}
+
+void Compressor::CompressChunk(const std::vector<char> &input,
+                               const http::compression_type compression_type,
+                               std::vector<char> &output,
+                               const bool first,
+                               const bool last)
+{
+    BOOST_ASSERT(input.size() <= std::numeric_limits<uInt>::max());
+    BOOST_ASSERT(compression_type != http::no_compression);
+    auto &stream = first ? GetStream(compression_type) : compression_type == http::gzip_rfc1952
+                                                             ? gzip_stream
+                                                             : deflate_stream;
+
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+
+    const auto flush = last ? Z_FINISH : Z_NO_FLUSH;
+    auto result = Z_OK;
+    do
+    {
+        // grows the output until deflate leaves some of it unused, i.e. has nothing left to write
+        const auto offset = output.size();
+        output.resize(offset + std::max<uLong>(deflateBound(&stream, stream.avail_in), 4096));
+        stream.next_out = reinterpret_cast<Bytef *>(output.data() + offset);
+        stream.avail_out = static_cast<uInt>(output.size() - offset);
+
+        result = deflate(&stream, flush);
+        if (result == Z_STREAM_ERROR)
+        {
+            throw util::exception("Could not compress reply");
+        }
+        output.resize(output.size() - stream.avail_out);
+    } while (stream.avail_out == 0 || (last && result != Z_STREAM_END));
+
+    if (last)
+    {
+        ++statistics.compressed_replies;
+    }
+}
+}
+}
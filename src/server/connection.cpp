@@ -1,14 +1,22 @@
 #include "server/connection.hpp"
+#include "server/compressor.hpp"
 #include "server/request_handler.hpp"
 #include "server/request_parser.hpp"
 
+#include "engine/metrics.hpp"
+
+#include "util/exception.hpp"
+#include "util/make_unique.hpp"
+
 #include <boost/assert.hpp>
 #include <boost/bind.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
-#include <boost/iostreams/filtering_stream.hpp>
 
+#include <cstdio>
+#include <cstring>
 #include <iterator>
 #include <string>
+#include <utility>
+#include <tuple>
 #include <vector>
 
 namespace osrm
@@ -16,17 +24,69 @@ namespace osrm
 namespace server
 {
 
-Connection::Connection(boost::asio::io_service &io_service, RequestHandler &handler)
-    : strand(io_service), TCP_socket(io_service), request_handler(handler)
+constexpr std::size_t Connection::MAX_PIPELINED_REQUESTS;
+constexpr std::size_t Connection::MAX_UNWRITTEN_BYTES;
+
+namespace
+{
+// Appends data as one chunk of the chunked transfer coding, empty data would end the body
+void AppendChunk(const std::vector<char> &data, std::vector<char> &output)
+{
+    if (data.empty())
+    {
+        return;
+    }
+
+    char size_line[20];
+    const auto length = std::snprintf(size_line, sizeof(size_line), "%zx\r\n", data.size());
+    output.insert(output.end(), size_line, size_line + length);
+    output.insert(output.end(), data.begin(), data.end());
+    output.push_back('\r');
+    output.push_back('\n');
+}
+// Address of a TCP client, clients of a Unix domain socket all share the loopback address
+boost::asio::ip::address RemoteAddress(const Connection::Socket &socket)
+{
+    boost::system::error_code error;
+    const auto endpoint = socket.remote_endpoint(error);
+    if (!error && (endpoint.protocol().family() == AF_INET ||
+                   endpoint.protocol().family() == AF_INET6))
+    {
+        boost::asio::ip::tcp::endpoint tcp_endpoint;
+        std::memcpy(tcp_endpoint.data(), endpoint.data(), endpoint.size());
+        tcp_endpoint.resize(endpoint.size());
+        return tcp_endpoint.address();
+    }
+    return boost::asio::ip::address_v4::loopback();
+}
+}
+
+Connection::Connection(boost::asio::io_service &io_service,
+                       RequestHandler &handler,
+                       const unsigned keepalive_timeout,
+                       const unsigned keepalive_requests)
+    : strand(io_service), stream_socket(io_service), timer(io_service), request_handler(handler),
+      unparsed_begin(incoming_data_buffer.data()), unparsed_end(incoming_data_buffer.data()),
+      keepalive_timeout(keepalive_timeout), keepalive_requests(keepalive_requests),
+      processed_requests(0), reading(false), writing(false), closing(false),
+      write_failed(false)
 {
 }
 
-boost::asio::ip::tcp::socket &Connection::socket() { return TCP_socket; }
+Connection::Socket &Connection::socket() { return stream_socket; }
 
 /// Start the first asynchronous operation for the connection.
-void Connection::start()
+void Connection::start() { read_more(); }
+
+void Connection::read_more()
 {
-    TCP_socket.async_read_some(
+    reading = true;
+    if (pending_requests.empty())
+    {
+        arm_idle_timer();
+    }
+
+    stream_socket.async_read_some(
         boost::asio::buffer(incoming_data_buffer),
         strand.wrap(boost::bind(&Connection::handle_read,
                                 this->shared_from_this(),
@@ -34,26 +94,147 @@ void Connection::start()
                                 boost::asio::placeholders::bytes_transferred)));
 }
 
+void Connection::arm_idle_timer()
+{
+    // the idle timeout only applies to connections that were kept alive
+    if (processed_requests > 0)
+    {
+        timer.expires_from_now(boost::posix_time::seconds(keepalive_timeout));
+        timer.async_wait(strand.wrap(boost::bind(&Connection::handle_timeout,
+                                                 this->shared_from_this(),
+                                                 boost::asio::placeholders::error)));
+    }
+}
+
 void Connection::handle_read(const boost::system::error_code &error, std::size_t bytes_transferred)
 {
+    reading = false;
     if (error)
     {
+        // requests still in flight keep the connection alive until their replies are written
+        closing = true;
+        return;
+    }
+
+    if (processed_requests > 0)
+    {
+        // cancels the pending wait, also disarms a timeout handler that is already queued
+        timer.expires_at(boost::posix_time::pos_infin);
+    }
+
+    handle_data(incoming_data_buffer.data(), incoming_data_buffer.data() + bytes_transferred);
+}
+
+void Connection::handle_data(char *begin, char *end)
+{
+    while (begin != end && !closing && pending_requests.size() < MAX_PIPELINED_REQUESTS)
+    {
+        if (!parsed_request)
+        {
+            parsed_request = make_request();
+        }
+
+        RequestParser::RequestStatus result;
+        std::tie(result, parsed_request->compression_type, begin) =
+            request_parser.parse(parsed_request->request, begin, end);
+
+        if (result != RequestParser::RequestStatus::indeterminate)
+        {
+            request_parser = RequestParser();
+            dispatch(std::move(parsed_request), result == RequestParser::RequestStatus::valid);
+        }
+    }
+    // the buffer is only read into again once everything in it has been parsed
+    unparsed_begin = begin;
+    unparsed_end = end;
+
+    write_next();
+
+    if (begin == end && !closing && !reading && pending_requests.size() < MAX_PIPELINED_REQUESTS)
+    {
+        read_more();
+    }
+}
+
+void Connection::dispatch(std::unique_ptr<PipelinedRequest> pipelined, const bool valid)
+{
+    pending_requests.push_back(std::move(pipelined));
+    auto &current = *pending_requests.back();
+
+    if (!valid)
+    { // request is not parseable
+        current.reply = http::reply::stock_reply(http::reply::bad_request);
+        current.output_buffer = current.reply.to_buffers();
+        current.answered = true;
+        closing = true;
         return;
     }
 
-    // no error detected, let's parse the request
-    http::compression_type compression_type(http::no_compression);
-    RequestParser::RequestStatus result;
-    std::tie(result, compression_type) =
-        request_parser.parse(current_request,
-                             incoming_data_buffer.data(),
-                             incoming_data_buffer.data() + bytes_transferred);
+    current.request.endpoint = RemoteAddress(stream_socket);
+
+    ++processed_requests;
+    current.keep_alive = current.request.keep_alive && keepalive_timeout > 0 &&
+                         processed_requests < keepalive_requests;
+    current.remaining_requests = keepalive_requests - processed_requests;
+    closing = !current.keep_alive;
+    // streaming stalls the worker until the client read the reply, replies of requests before
+    // this one would have to be held back meanwhile
+    current.may_stream = current.request.accepts_chunked && pending_requests.size() == 1;
 
-    // the request has been parsed
-    if (result == RequestParser::RequestStatus::valid)
+    // the request is not touched on the strand until it is answered, so a worker can answer it
+    // without synchronizing with the strand
+    auto self = this->shared_from_this();
+    auto *const request = &current;
+    const bool scheduled = request_handler.Schedule(
+        current.request, [self, request] { self->handle_request(*request); });
+    if (!scheduled)
     {
-        current_request.endpoint = TCP_socket.remote_endpoint().address();
-        request_handler.HandleRequest(current_request, current_reply);
+        current.reply = http::reply::stock_reply(http::reply::service_unavailable);
+        current.keep_alive = false;
+        current.output_buffer = current.reply.to_buffers();
+        current.answered = true;
+        closing = true;
+    }
+}
+
+void Connection::handle_request(PipelinedRequest &pipelined)
+{
+    auto &current_reply = pipelined.reply;
+    auto &compressed_output = pipelined.compressed_output;
+    {
+        // times the request up to its compression, the reply is written asynchronously
+        engine::metrics::RequestScope request_metrics;
+
+        // a request answered on the strand cannot wait for its chunks to be written
+        RequestHandler::ChunkHandler handle_chunk;
+        if (pipelined.may_stream && !strand.running_in_this_thread())
+        {
+            handle_chunk = [this, &pipelined](std::vector<char> &chunk) {
+                stream_chunk(pipelined, chunk);
+            };
+        }
+
+        request_handler.HandleRequest(pipelined.request, current_reply, handle_chunk);
+
+        if (pipelined.streamed)
+        {
+            finish_stream(pipelined);
+            strand.post(
+                boost::bind(&Connection::handle_answered, this->shared_from_this(), &pipelined));
+            return;
+        }
+
+        if (pipelined.keep_alive)
+        {
+            current_reply.set_keep_alive(keepalive_timeout, pipelined.remaining_requests);
+        }
+
+        auto compression_type = pipelined.compression_type;
+        if (compression_type != http::no_compression &&
+            !Compressor::ShouldCompress(current_reply.content.size()))
+        {
+            compression_type = http::no_compression;
+        }
 
         // compress the result w/ gzip/deflate if requested
         switch (compression_type)
@@ -62,88 +243,285 @@ void Connection::handle_read(const boost::system::error_code &error, std::size_t
             // use deflate for compression
             current_reply.headers.insert(current_reply.headers.begin(),
                                          {"Content-Encoding", "deflate"});
-            compressed_output = compress_buffers(current_reply.content, compression_type);
+            {
+                engine::metrics::StageTimer timer(engine::metrics::Stage::Compression);
+                Compressor::ForCurrentThread().Compress(
+                    current_reply.content, compression_type, compressed_output);
+            }
             current_reply.set_size(static_cast<unsigned>(compressed_output.size()));
-            output_buffer = current_reply.headers_to_buffers();
-            output_buffer.push_back(boost::asio::buffer(compressed_output));
+            pipelined.output_buffer = current_reply.headers_to_buffers();
+            pipelined.output_buffer.push_back(boost::asio::buffer(compressed_output));
             break;
         case http::gzip_rfc1952:
             // use gzip for compression
             current_reply.headers.insert(current_reply.headers.begin(),
                                          {"Content-Encoding", "gzip"});
-            compressed_output = compress_buffers(current_reply.content, compression_type);
+            {
+                engine::metrics::StageTimer timer(engine::metrics::Stage::Compression);
+                Compressor::ForCurrentThread().Compress(
+                    current_reply.content, compression_type, compressed_output);
+            }
             current_reply.set_size(static_cast<unsigned>(compressed_output.size()));
-            output_buffer = current_reply.headers_to_buffers();
-            output_buffer.push_back(boost::asio::buffer(compressed_output));
+            pipelined.output_buffer = current_reply.headers_to_buffers();
+            pipelined.output_buffer.push_back(boost::asio::buffer(compressed_output));
             break;
         case http::no_compression:
             // don't use any compression
             current_reply.set_uncompressed_size();
-            output_buffer = current_reply.to_buffers();
+            pipelined.output_buffer = current_reply.to_buffers();
             break;
         }
-        // write result to stream
-        boost::asio::async_write(TCP_socket,
-                                 output_buffer,
-                                 strand.wrap(boost::bind(&Connection::handle_write,
-                                                         this->shared_from_this(),
-                                                         boost::asio::placeholders::error)));
     }
-    else if (result == RequestParser::RequestStatus::invalid)
-    { // request is not parseable
-        current_reply = http::reply::stock_reply(http::reply::bad_request);
 
-        boost::asio::async_write(TCP_socket,
-                                 current_reply.to_buffers(),
-                                 strand.wrap(boost::bind(&Connection::handle_write,
-                                                         this->shared_from_this(),
-                                                         boost::asio::placeholders::error)));
+    // back on the strand, which might be another thread if a worker answered the request
+    strand.post(boost::bind(&Connection::handle_answered, this->shared_from_this(), &pipelined));
+}
+
+void Connection::stream_chunk(PipelinedRequest &pipelined, std::vector<char> &chunk)
+{
+    auto &current_reply = pipelined.reply;
+    auto &compressed_output = pipelined.compressed_output;
+    const bool first = !pipelined.streamed;
+
+    std::vector<char> framed;
+    if (first)
+    {
+        pipelined.streamed = true;
+        if (pipelined.compression_type != http::no_compression &&
+            !Compressor::ShouldCompress(chunk.size()))
+        {
+            pipelined.compression_type = http::no_compression;
+        }
+        if (pipelined.compression_type == http::deflate_rfc1951)
+        {
+            current_reply.headers.insert(current_reply.headers.begin(),
+                                         {"Content-Encoding", "deflate"});
+        }
+        else if (pipelined.compression_type == http::gzip_rfc1952)
+        {
+            current_reply.headers.insert(current_reply.headers.begin(),
+                                         {"Content-Encoding", "gzip"});
+        }
+        if (pipelined.keep_alive)
+        {
+            current_reply.set_keep_alive(keepalive_timeout, pipelined.remaining_requests);
+        }
+        current_reply.append_chunked_headers(framed);
+    }
+
+    if (pipelined.compression_type == http::no_compression)
+    {
+        AppendChunk(chunk, framed);
     }
     else
     {
-        // we don't have a result yet, so continue reading
-        TCP_socket.async_read_some(
-            boost::asio::buffer(incoming_data_buffer),
-            strand.wrap(boost::bind(&Connection::handle_read,
-                                    this->shared_from_this(),
-                                    boost::asio::placeholders::error,
-                                    boost::asio::placeholders::bytes_transferred)));
+        compressed_output.clear();
+        {
+            engine::metrics::StageTimer timer(engine::metrics::Stage::Compression);
+            Compressor::ForCurrentThread().CompressChunk(
+                chunk, pipelined.compression_type, compressed_output, first, false);
+        }
+        AppendChunk(compressed_output, framed);
+    }
+
+    std::unique_lock<std::mutex> lock(pipelined.stream_mutex);
+    if (!framed.empty())
+    {
+        pipelined.unwritten_bytes += framed.size();
+        pipelined.chunks.push_back(std::move(framed));
+        strand.post(boost::bind(&Connection::write_next, this->shared_from_this()));
+    }
+    pipelined.stream_written.wait(lock, [&pipelined] {
+        return pipelined.unwritten_bytes <= MAX_UNWRITTEN_BYTES || pipelined.stream_failed;
+    });
+    if (pipelined.stream_failed)
+    {
+        // unwinds the plugin, the reply it would turn into is never written
+        throw util::exception("Connection closed while the reply was streamed");
+    }
+}
+
+void Connection::finish_stream(PipelinedRequest &pipelined)
+{
+    auto &current_reply = pipelined.reply;
+    auto &stream_tail = pipelined.stream_tail;
+    stream_tail.clear();
+    pipelined.output_buffer.clear();
+
+    if (current_reply.status != http::reply::ok)
+    {
+        // the request failed after its status line was sent, the client can only tell by the
+        // missing last chunk
+        pipelined.keep_alive = false;
+        return;
+    }
+
+    if (pipelined.compression_type == http::no_compression)
+    {
+        AppendChunk(current_reply.content, stream_tail);
+    }
+    else
+    {
+        pipelined.compressed_output.clear();
+        {
+            engine::metrics::StageTimer timer(engine::metrics::Stage::Compression);
+            Compressor::ForCurrentThread().CompressChunk(current_reply.content,
+                                                         pipelined.compression_type,
+                                                         pipelined.compressed_output,
+                                                         false,
+                                                         true);
+        }
+        AppendChunk(pipelined.compressed_output, stream_tail);
+    }
+    const std::string last_chunk = "0\r\n\r\n";
+    stream_tail.insert(stream_tail.end(), last_chunk.begin(), last_chunk.end());
+    pipelined.output_buffer.push_back(boost::asio::buffer(stream_tail));
+}
+
+void Connection::handle_answered(PipelinedRequest *pipelined)
+{
+    pipelined->answered = true;
+    write_next();
+}
+
+void Connection::write_next()
+{
+    if (writing || write_failed || pending_requests.empty())
+    {
+        return;
+    }
+
+    auto &front = *pending_requests.front();
+    if (front.may_stream)
+    {
+        std::lock_guard<std::mutex> lock(front.stream_mutex);
+        if (!front.chunks.empty())
+        {
+            // the worker only appends to the chunks, the one written stays in place
+            writing = true;
+            boost::asio::async_write(stream_socket,
+                                     boost::asio::buffer(front.chunks.front()),
+                                     strand.wrap(boost::bind(&Connection::handle_chunk_write,
+                                                             this->shared_from_this(),
+                                                             boost::asio::placeholders::error)));
+            return;
+        }
     }
+
+    if (!front.answered)
+    {
+        return;
+    }
+
+    writing = true;
+    boost::asio::async_write(stream_socket,
+                             pending_requests.front()->output_buffer,
+                             strand.wrap(boost::bind(&Connection::handle_write,
+                                                     this->shared_from_this(),
+                                                     boost::asio::placeholders::error)));
 }
 
 /// Handle completion of a write operation.
 void Connection::handle_write(const boost::system::error_code &error)
 {
-    if (!error)
+    writing = false;
+    if (error)
+    {
+        write_failed = true;
+        return;
+    }
+
+    auto written = std::move(pending_requests.front());
+    pending_requests.pop_front();
+    const bool keep_alive = written->keep_alive;
+    spare_requests.push_back(std::move(written));
+
+    if (!keep_alive)
     {
         // Initiate graceful connection closure.
         boost::system::error_code ignore_error;
-        TCP_socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignore_error);
+        stream_socket.shutdown(Socket::shutdown_both, ignore_error);
+        return;
+    }
+
+    if (unparsed_begin != unparsed_end)
+    {
+        // pipelined requests that did not fit into the pipeline are still in the buffer, no read
+        // overwrote them while they waited
+        handle_data(unparsed_begin, unparsed_end);
+    }
+    else
+    {
+        if (!reading && !closing)
+        {
+            read_more();
+        }
+        else if (reading && pending_requests.empty())
+        {
+            arm_idle_timer();
+        }
+        write_next();
     }
 }
 
-std::vector<char> Connection::compress_buffers(const std::vector<char> &uncompressed_data,
-                                               const http::compression_type compression_type)
+void Connection::handle_chunk_write(const boost::system::error_code &error)
 {
-    boost::iostreams::gzip_params compression_parameters;
+    writing = false;
+    auto &front = *pending_requests.front();
+    {
+        std::lock_guard<std::mutex> lock(front.stream_mutex);
+        if (error)
+        {
+            write_failed = true;
+            front.stream_failed = true;
+        }
+        else
+        {
+            front.unwritten_bytes -= front.chunks.front().size();
+            front.chunks.pop_front();
+        }
+    }
+    front.stream_written.notify_one();
+
+    write_next();
+}
 
-    // there's a trade-off between speed and size. speed wins
-    compression_parameters.level = boost::iostreams::zlib::best_speed;
-    // check which compression flavor is used
-    if (http::deflate_rfc1951 == compression_type)
+std::unique_ptr<Connection::PipelinedRequest> Connection::make_request()
+{
+    if (spare_requests.empty())
     {
-        compression_parameters.noheader = true;
+        return util::make_unique<PipelinedRequest>();
     }
 
-    std::vector<char> compressed_data;
-    // plug data into boost's compression stream
-    boost::iostreams::filtering_ostream gzip_stream;
-    gzip_stream.push(boost::iostreams::gzip_compressor(compression_parameters));
-    gzip_stream.push(boost::iostreams::back_inserter(compressed_data));
-    gzip_stream.write(&uncompressed_data[0], uncompressed_data.size());
-    boost::iostreams::close(gzip_stream);
+    // start over with a clean state but keep the buffers of a former request
+    auto recycled = std::move(spare_requests.back());
+    spare_requests.pop_back();
+    recycled->request = http::request();
+    recycled->reply.clear();
+    recycled->compression_type = http::no_compression;
+    recycled->keep_alive = false;
+    recycled->remaining_requests = 0;
+    recycled->answered = false;
+    recycled->may_stream = false;
+    recycled->streamed = false;
+    recycled->chunks.clear();
+    recycled->unwritten_bytes = 0;
+    recycled->stream_failed = false;
+    return recycled;
+}
+
+void Connection::handle_timeout(const boost::system::error_code &error)
+{
+    // a stale timer can fire after a new read re-armed it, only act on the latest deadline
+    if (error == boost::asio::error::operation_aborted ||
+        timer.expires_at() > boost::asio::deadline_timer::traits_type::now())
+    {
+        return;
+    }
 
-    return compressed_data;
+    boost::system::error_code ignore_error;
+    stream_socket.shutdown(Socket::shutdown_both, ignore_error);
+    stream_socket.close(ignore_error);
 }
 }
 }
@@ -1,5 +1,8 @@
 #include "server/http/reply.hpp"
 
+#include <boost/assert.hpp>
+
+#include <iterator>
 #include <string>
 
 namespace osrm
@@ -13,11 +16,19 @@ const char ok_html[] = "";
 const char bad_request_html[] = "";
 const char internal_server_error_html[] =
     "{\"code\": \"InternalError\",\"message\":\"Internal Server Error\"}";
+const char too_many_requests_html[] =
+    "{\"code\": \"TooManyRequests\",\"message\":\"Request rate limit exceeded\"}";
+const char service_unavailable_html[] =
+    "{\"code\": \"Overloaded\",\"message\":\"Too many requests, try again later\"}";
 const char seperators[] = {':', ' '};
 const char crlf[] = {'\r', '\n'};
 const std::string http_ok_string = "HTTP/1.0 200 OK\r\n";
 const std::string http_bad_request_string = "HTTP/1.0 400 Bad Request\r\n";
+const std::string http_too_many_requests_string = "HTTP/1.0 429 Too Many Requests\r\n";
 const std::string http_internal_server_error_string = "HTTP/1.0 500 Internal Server Error\r\n";
+const std::string http_service_unavailable_string = "HTTP/1.0 503 Service Unavailable\r\n";
+const std::string http_1_1_ok_string = "HTTP/1.1 200 OK\r\n";
+const std::string chunked_transfer_encoding_string = "Transfer-Encoding: chunked\r\n";
 
 void reply::set_size(const std::size_t size)
 {
@@ -32,6 +43,20 @@ void reply::set_size(const std::size_t size)
 
 void reply::set_uncompressed_size() { set_size(content.size()); }
 
+void reply::set_keep_alive(const unsigned timeout_seconds, const unsigned remaining_requests)
+{
+    for (header &h : headers)
+    {
+        if ("Connection" == h.name)
+        {
+            h.value = "keep-alive";
+        }
+    }
+    headers.emplace_back("Keep-Alive",
+                         "timeout=" + std::to_string(timeout_seconds) + ", max=" +
+                             std::to_string(remaining_requests));
+}
+
 std::vector<boost::asio::const_buffer> reply::to_buffers()
 {
     std::vector<boost::asio::const_buffer> buffers;
@@ -63,6 +88,24 @@ std::vector<boost::asio::const_buffer> reply::headers_to_buffers()
     return buffers;
 }
 
+void reply::append_chunked_headers(std::vector<char> &output) const
+{
+    // only successful replies are streamed
+    BOOST_ASSERT(status == reply::ok);
+    output.insert(output.end(), http_1_1_ok_string.begin(), http_1_1_ok_string.end());
+    for (const header &current_header : headers)
+    {
+        output.insert(output.end(), current_header.name.begin(), current_header.name.end());
+        output.insert(output.end(), std::begin(seperators), std::end(seperators));
+        output.insert(output.end(), current_header.value.begin(), current_header.value.end());
+        output.insert(output.end(), std::begin(crlf), std::end(crlf));
+    }
+    output.insert(output.end(),
+                  chunked_transfer_encoding_string.begin(),
+                  chunked_transfer_encoding_string.end());
+    output.insert(output.end(), std::begin(crlf), std::end(crlf));
+}
+
 reply reply::stock_reply(const reply::status_type status)
 {
     reply reply;
@@ -87,6 +130,14 @@ std::string reply::status_to_string(const reply::status_type status)
     {
         return bad_request_html;
     }
+    if (reply::too_many_requests == status)
+    {
+        return too_many_requests_html;
+    }
+    if (reply::service_unavailable == status)
+    {
+        return service_unavailable_html;
+    }
     return internal_server_error_html;
 }
 
@@ -100,14 +151,27 @@ boost::asio::const_buffer reply::status_to_buffer(const reply::status_type statu
     {
         return boost::asio::buffer(http_internal_server_error_string);
     }
+    if (reply::too_many_requests == status)
+    {
+        return boost::asio::buffer(http_too_many_requests_string);
+    }
+    if (reply::service_unavailable == status)
+    {
+        return boost::asio::buffer(http_service_unavailable_string);
+    }
     return boost::asio::buffer(http_bad_request_string);
 }
 
-reply::reply() : status(ok)
+void reply::clear()
 {
-    // We do not currently support keep alive. Always set 'Connection: close'.
+    status = ok;
+    content.clear();
+    headers.clear();
+    // Connections are closed unless the Connection decides to keep it alive, see set_keep_alive
     headers.emplace_back("Connection", "close");
 }
+
+reply::reply() { clear(); }
 }
 }
 }
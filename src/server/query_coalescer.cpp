@@ -0,0 +1,187 @@
+#include "server/query_coalescer.hpp"
+#include "server/api/url_parser.hpp"
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+QueryCoalescer::QueryCoalescer(const std::chrono::milliseconds time_to_live,
+                               const std::size_t max_entries)
+    : time_to_live(time_to_live), max_entries(max_entries)
+{
+}
+
+engine::Status QueryCoalescer::Run(const std::string &key,
+                                   const unsigned generation,
+                                   const QueryT &query,
+                                   ResultT &result)
+{
+    std::promise<std::shared_ptr<const Outcome>> promise;
+    std::uint64_t id;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        const auto now = Clock::now();
+
+        auto iter = entries.find(key);
+        if (iter != entries.end() && iter->second.generation == generation &&
+            (!iter->second.done || now < iter->second.expiry))
+        {
+            ++iter->second.waiting_queries;
+            const auto outcome = iter->second.outcome;
+            lock.unlock();
+
+            const auto &shared_outcome = outcome.get();
+            result = shared_outcome->result;
+            return shared_outcome->status;
+        }
+
+        if (iter != entries.end() && !iter->second.done)
+        {
+            // still computed on a previous generation, this query has to run on its own
+            lock.unlock();
+            return query(result);
+        }
+
+        if (iter == entries.end() && entries.size() >= max_entries)
+        {
+            RemoveExpired(now);
+        }
+
+        id = next_id++;
+        entries[key] = Entry{id, generation, promise.get_future().share(), 0, false, {}};
+    }
+
+    // the entry of this query unless it got replaced in the meantime, the caller holds the mutex
+    const auto find_own_entry = [&] {
+        const auto iter = entries.find(key);
+        return iter != entries.end() && iter->second.id == id ? iter : entries.end();
+    };
+
+    engine::Status status;
+    try
+    {
+        status = query(result);
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto iter = find_own_entry();
+            if (iter != entries.end())
+            {
+                entries.erase(iter);
+            }
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    // the result is only copied if other queries wait for it or it is kept
+    std::shared_ptr<const Outcome> outcome;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto iter = find_own_entry();
+        if (iter != entries.end())
+        {
+            const bool keep = time_to_live > Clock::duration::zero() &&
+                              entries.size() <= max_entries;
+            if (keep || iter->second.waiting_queries > 0)
+            {
+                outcome = std::make_shared<const Outcome>(Outcome{status, result});
+            }
+
+            if (keep)
+            {
+                iter->second.done = true;
+                iter->second.expiry = Clock::now() + time_to_live;
+            }
+            else
+            {
+                entries.erase(iter);
+            }
+        }
+    }
+    promise.set_value(std::move(outcome));
+
+    return status;
+}
+
+void QueryCoalescer::RemoveExpired(const Clock::time_point now)
+{
+    for (auto iter = entries.begin(); iter != entries.end();)
+    {
+        if (iter->second.done && iter->second.expiry <= now)
+        {
+            iter = entries.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+bool QueryCoalescer::IsShareable(const std::string &service, const std::string &query)
+{
+    if (service == "match")
+    {
+        // a session advances its frontier with every query
+        return !api::hasOption(query, "session");
+    }
+    if (service == "table")
+    {
+        // a registration has to be repeated once the set got dropped, and registering the name
+        // again changes the answers of the queries using it
+        return !api::hasOption(query, "target_set");
+    }
+    return true;
+}
+
+std::string QueryCoalescer::MakeKey(const std::string &service,
+                                    const unsigned version,
+                                    const std::string &query)
+{
+    const auto prefix = service + "/v" + std::to_string(version) + "/";
+
+    const auto options_begin = query.find('?');
+    if (options_begin == std::string::npos)
+    {
+        return prefix + query;
+    }
+
+    std::vector<std::string> options;
+    boost::split(options, query.substr(options_begin + 1), boost::is_any_of("&"));
+
+    // a later option overrides an earlier one of the same name, their order matters then
+    std::vector<std::string> names;
+    names.reserve(options.size());
+    for (const auto &option : options)
+    {
+        names.push_back(option.substr(0, option.find('=')));
+    }
+    std::sort(names.begin(), names.end());
+    if (std::adjacent_find(names.begin(), names.end()) == names.end())
+    {
+        std::sort(options.begin(), options.end());
+    }
+
+    auto key = prefix + query.substr(0, options_begin + 1);
+    for (const auto &option : options)
+    {
+        key += option;
+        key += '&';
+    }
+    key.pop_back();
+    return key;
+}
+}
+}
@@ -0,0 +1,162 @@
+#include "server/rate_limiter.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+namespace osrm
+{
+namespace server
+{
+
+namespace
+{
+const constexpr char POLYLINE_PREFIX[] = "polyline(";
+// separates the traces of a match batch, see MatchService
+const constexpr char BATCH_SEPARATOR = ':';
+
+// The {coordinates} or polyline({polyline}) part of the query
+std::string::size_type CoordinatesEnd(const std::string &query)
+{
+    if (query.compare(0, sizeof(POLYLINE_PREFIX) - 1, POLYLINE_PREFIX) == 0)
+    {
+        // encoded polylines may contain '?', but never ')'
+        const auto end = query.find(')');
+        return end == std::string::npos ? query.size() : end;
+    }
+    const auto end = query.find('?');
+    return end == std::string::npos ? query.size() : end;
+}
+
+std::size_t CountCoordinates(const std::string &query, const std::string::size_type end)
+{
+    if (query.compare(0, sizeof(POLYLINE_PREFIX) - 1, POLYLINE_PREFIX) == 0)
+    {
+        // the last character of each encoded value has no continuation bit, two values make up
+        // a coordinate
+        const auto values = std::count_if(
+            query.begin() + sizeof(POLYLINE_PREFIX) - 1, query.begin() + end, [](const char c) {
+                return c >= 63 && ((c - 63) & 0x20) == 0;
+            });
+        return std::max<std::size_t>(1, values / 2);
+    }
+    return std::count(query.begin(), query.begin() + end, ';') + 1;
+}
+
+// Number of indices the option lists, all_indices if it is missing or all
+std::size_t CountIndices(const std::string &query,
+                         const std::string::size_type options_begin,
+                         const std::string &option,
+                         const std::size_t all_indices)
+{
+    const auto key = option + "=";
+    auto begin = options_begin;
+    while (begin < query.size())
+    {
+        auto end = query.find('&', begin);
+        if (end == std::string::npos)
+        {
+            end = query.size();
+        }
+        if (query.compare(begin, key.size(), key) == 0)
+        {
+            const auto value = query.substr(begin + key.size(), end - begin - key.size());
+            return value == "all" ? all_indices
+                                  : std::count(value.begin(), value.end(), ';') + 1;
+        }
+        begin = end + 1;
+    }
+    return all_indices;
+}
+}
+
+constexpr std::size_t RateLimiter::MAX_CLIENTS;
+
+RateLimiter::RateLimiter(const double cost_per_second, const double burst_cost)
+    : cost_per_second(cost_per_second), burst_cost(burst_cost)
+{
+    BOOST_ASSERT(cost_per_second > 0);
+    BOOST_ASSERT(burst_cost > 0);
+}
+
+double RateLimiter::Refill(const Bucket &bucket, const Clock::time_point now) const
+{
+    const std::chrono::duration<double> elapsed = now - bucket.updated;
+    return std::min(burst_cost, bucket.cost + std::max(0., elapsed.count()) * cost_per_second);
+}
+
+RateLimiter::Clock::duration
+RateLimiter::Acquire(const std::string &client, double cost, const Clock::time_point now)
+{
+    cost = std::min(cost, burst_cost);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = buckets.find(client);
+    if (iter == buckets.end())
+    {
+        if (buckets.size() >= MAX_CLIENTS)
+        {
+            for (auto bucket = buckets.begin(); bucket != buckets.end();)
+            {
+                bucket = Refill(bucket->second, now) >= burst_cost ? buckets.erase(bucket)
+                                                                    : std::next(bucket);
+            }
+            if (buckets.size() >= MAX_CLIENTS)
+            {
+                return Clock::duration::zero();
+            }
+        }
+        iter = buckets.emplace(client, Bucket{burst_cost, now}).first;
+    }
+
+    auto &bucket = iter->second;
+    bucket.cost = Refill(bucket, now);
+    bucket.updated = std::max(bucket.updated, now);
+    if (bucket.cost >= cost)
+    {
+        bucket.cost -= cost;
+        return Clock::duration::zero();
+    }
+
+    const std::chrono::duration<double> wait((cost - bucket.cost) / cost_per_second);
+    return std::max<Clock::duration>(std::chrono::duration_cast<Clock::duration>(wait),
+                                     Clock::duration(1));
+}
+
+double RateLimiter::EstimateCost(const std::string &service, const std::string &query)
+{
+    // each trace of a batch has its own coordinates and options
+    const auto batch_end = query.find(BATCH_SEPARATOR);
+    if (service == "match" && batch_end != std::string::npos)
+    {
+        return EstimateCost(service, query.substr(0, batch_end)) +
+               EstimateCost(service, query.substr(batch_end + 1));
+    }
+
+    const auto coordinates_end = CoordinatesEnd(query);
+    const auto coordinates = CountCoordinates(query, coordinates_end);
+    const auto options_begin = query.find('?', coordinates_end);
+
+    if (service == "route" || service == "match")
+    {
+        return static_cast<double>(coordinates);
+    }
+    if (service == "trip")
+    {
+        return static_cast<double>(coordinates) * coordinates;
+    }
+    if (service == "table")
+    {
+        if (options_begin == std::string::npos)
+        {
+            return static_cast<double>(coordinates) * coordinates;
+        }
+        return static_cast<double>(CountIndices(query, options_begin + 1, "sources", coordinates)) *
+               CountIndices(query, options_begin + 1, "destinations", coordinates);
+    }
+    return 1.;
+}
+}
+}
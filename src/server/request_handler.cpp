@@ -5,15 +5,19 @@
 #include "server/http/reply.hpp"
 #include "server/http/request.hpp"
 
+#include "util/arena.hpp"
 #include "util/json_renderer.hpp"
+#include "util/make_unique.hpp"
 #include "util/simple_logger.hpp"
 #include "util/string_util.hpp"
 #include "util/typedefs.hpp"
 
+#include "engine/metrics.hpp"
 #include "engine/status.hpp"
 #include "osrm/osrm.hpp"
 #include "util/json_container.hpp"
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 #include <boost/iostreams/filtering_streambuf.hpp>
@@ -21,23 +25,372 @@
 #include <ctime>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace osrm
 {
 namespace server
 {
 
+namespace
+{
+struct ServicePriority
+{
+    const char *service;
+    unsigned priority;
+};
+
+// Services answering from a handful of searches go first, the ones whose costs grow with the
+// number of coordinates last
+const constexpr ServicePriority SERVICE_PRIORITIES[] = {{"nearest", 0},
+                                                        {"tile", 0},
+                                                        {"route", 1},
+                                                        {"match", 2},
+                                                        {"isochrone", 2},
+                                                        {"table", 2},
+                                                        {"trip", 2}};
+
+// /{service}/v1/..., the request is decoded before parsing but service names are plain ASCII
+std::string GetServiceName(const std::string &uri)
+{
+    const auto begin = uri.empty() || uri.front() != '/' ? 0 : 1;
+    const auto end = uri.find_first_of("/?", begin);
+    return uri.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+}
+
+// Counts a request as running during its lifetime
+struct RunningRequest
+{
+    explicit RunningRequest(std::atomic<std::size_t> &running_requests)
+        : running_requests(running_requests)
+    {
+        ++running_requests;
+    }
+    ~RunningRequest() { --running_requests; }
+
+    std::atomic<std::size_t> &running_requests;
+};
+
+// The dataset a service handler answers queries on, as reported by /health
+util::json::Object GetDatasetStatus(const ServiceHandler &handler)
+{
+    util::json::Object dataset;
+    dataset.values["generation"] = static_cast<double>(handler.GetDatasetGeneration());
+    dataset.values["timestamp"] = handler.GetTimestamp();
+    return dataset;
+}
+
+// The headers that only depend on the type of the result, not on the body itself
+void AddContentHeaders(const ServiceHandler::ResultT &result, http::reply &current_reply)
+{
+    current_reply.headers.emplace_back("Access-Control-Allow-Origin", "*");
+    current_reply.headers.emplace_back("Access-Control-Allow-Methods", "GET");
+    current_reply.headers.emplace_back("Access-Control-Allow-Headers",
+                                       "X-Requested-With, Content-Type");
+    if (result.is<util::json::Object>() || result.is<std::vector<char>>())
+    {
+        current_reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
+        current_reply.headers.emplace_back("Content-Disposition",
+                                           "inline; filename=\"response.json\"");
+    }
+    else if (result.is<service::BinaryResult>())
+    {
+        current_reply.headers.emplace_back("Content-Type", "application/octet-stream");
+    }
+    else
+    {
+        BOOST_ASSERT(result.is<std::string>());
+        current_reply.headers.emplace_back("Content-Type", "application/x-protobuf");
+    }
+}
+
+// The result of a service with the body of a shard's response, which has the same headers
+ServiceHandler::ResultT ToResult(util::HttpResponse response)
+{
+    if (boost::starts_with(response.content_type, "application/x-protobuf"))
+    {
+        return std::move(response.body);
+    }
+    std::vector<char> body(response.body.begin(), response.body.end());
+    if (boost::starts_with(response.content_type, "application/octet-stream"))
+    {
+        return service::BinaryResult{std::move(body)};
+    }
+    // JSON that is rendered already
+    return body;
+}
+}
+
+RequestHandler::RequestHandler()
+{
+    for (const auto &service : SERVICE_PRIORITIES)
+    {
+        service_statistics[service.service];
+    }
+}
+
 void RequestHandler::RegisterServiceHandler(std::unique_ptr<ServiceHandler> service_handler_)
 {
     service_handler = std::move(service_handler_);
 }
 
-void RequestHandler::HandleRequest(const http::request &current_request, http::reply &current_reply)
+void RequestHandler::RegisterServiceHandler(const std::string &profile,
+                                            std::unique_ptr<ServiceHandler> service_handler_)
+{
+    profile_service_handlers[profile] = std::move(service_handler_);
+}
+
+ServiceHandler *RequestHandler::GetServiceHandler(const std::string &profile) const
+{
+    const auto iter = profile_service_handlers.find(profile);
+    if (iter != profile_service_handlers.end())
+    {
+        return iter->second.get();
+    }
+    return service_handler.get();
+}
+
+void RequestHandler::UseWorkers(
+    const unsigned number_of_workers,
+    const std::size_t max_queued_requests,
+    const std::unordered_map<std::string, std::size_t> &max_pending_requests,
+    std::function<void(unsigned)> initialize_worker)
+{
+    std::vector<util::WorkQueue::Lane> lanes;
+    service_lanes.clear();
+    for (const auto &service_priority : SERVICE_PRIORITIES)
+    {
+        const auto max_pending = max_pending_requests.find(service_priority.service);
+        service_lanes[service_priority.service] = lanes.size();
+        lanes.push_back({service_priority.priority,
+                         max_pending == max_pending_requests.end()
+                             ? std::numeric_limits<std::size_t>::max()
+                             : max_pending->second});
+    }
+    for (const auto &max_pending : max_pending_requests)
+    {
+        if (service_lanes.find(max_pending.first) == service_lanes.end())
+        {
+            util::SimpleLogger().Write(logWARNING) << "Unknown service " << max_pending.first
+                                                   << " has no request limit";
+        }
+    }
+
+    work_queue = util::make_unique<util::WorkQueue>(
+        number_of_workers, max_queued_requests, std::move(lanes), std::move(initialize_worker));
+}
+
+bool RequestHandler::Schedule(const http::request &current_request, util::WorkQueue::Task task)
+{
+    if (work_queue)
+    {
+        const auto lane = service_lanes.find(GetServiceName(current_request.uri));
+        if (lane != service_lanes.end())
+        {
+            return work_queue->TryPush(lane->second, std::move(task));
+        }
+    }
+
+    task();
+    return true;
+}
+
+void RequestHandler::UseRateLimit(const double cost_per_second, const double burst_cost)
+{
+    rate_limiter = util::make_unique<RateLimiter>(cost_per_second, burst_cost);
+}
+
+void RequestHandler::UseShards(std::unique_ptr<ShardRouter> shard_router_)
+{
+    shard_router = std::move(shard_router_);
+}
+
+void RequestHandler::HandleHealthRequest(http::reply &current_reply) const
+{
+    util::json::Object health;
+    util::json::Array datasets;
+    if (service_handler)
+    {
+        datasets.values.push_back(GetDatasetStatus(*service_handler));
+    }
+    for (const auto &profile_service_handler : profile_service_handlers)
+    {
+        auto dataset = GetDatasetStatus(*profile_service_handler.second);
+        dataset.values["profile"] = profile_service_handler.first;
+        datasets.values.push_back(std::move(dataset));
+    }
+
+    // the server only takes requests once the services are warmed up, so any that are
+    // registered can answer queries
+    const bool ready = !datasets.values.empty();
+    current_reply.status = ready ? http::reply::ok : http::reply::service_unavailable;
+    health.values["status"] = ready ? "ready" : "unavailable";
+    health.values["uptime"] =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    health.values["running_requests"] = static_cast<double>(running_requests.load());
+    health.values["queued_requests"] =
+        static_cast<double>(work_queue ? work_queue->NumberOfQueuedTasks() : 0);
+    health.values["datasets"] = std::move(datasets);
+
+    util::json::render(current_reply.content, health);
+    current_reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
+    current_reply.headers.emplace_back("Cache-Control", "no-cache");
+    current_reply.headers.emplace_back("Content-Length",
+                                       std::to_string(current_reply.content.size()));
+}
+
+void RequestHandler::HandleStatsRequest(http::reply &current_reply) const
+{
+    util::json::Object stats;
+    util::json::Object services;
+    for (const auto &service : SERVICE_PRIORITIES)
+    {
+        const auto &statistics = service_statistics.at(service.service);
+        util::json::Object counters;
+        counters.values["requests"] = static_cast<double>(statistics.requests.load());
+        counters.values["cost"] = static_cast<double>(statistics.cost.load());
+        services.values[service.service] = std::move(counters);
+    }
+
+    util::json::Array datasets;
+    if (service_handler)
+    {
+        auto dataset = GetDatasetStatus(*service_handler);
+        service_handler->GetMemoryUsage(dataset);
+        datasets.values.push_back(std::move(dataset));
+    }
+    for (const auto &profile_service_handler : profile_service_handlers)
+    {
+        auto dataset = GetDatasetStatus(*profile_service_handler.second);
+        dataset.values["profile"] = profile_service_handler.first;
+        profile_service_handler.second->GetMemoryUsage(dataset);
+        datasets.values.push_back(std::move(dataset));
+    }
+
+    stats.values["services"] = std::move(services);
+    stats.values["datasets"] = std::move(datasets);
+
+    util::json::render(current_reply.content, stats);
+    current_reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
+    current_reply.headers.emplace_back("Cache-Control", "no-cache");
+    current_reply.headers.emplace_back("Content-Length",
+                                       std::to_string(current_reply.content.size()));
+}
+
+void RequestHandler::PrepareThread()
 {
-    if (!service_handler)
+    if (service_handler)
+    {
+        service_handler->PrepareThread();
+    }
+    for (auto &profile_service_handler : profile_service_handlers)
+    {
+        profile_service_handler.second->PrepareThread();
+    }
+}
+
+std::size_t RequestHandler::Replay(std::istream &requests, const unsigned number_of_threads)
+{
+    std::vector<std::string> urls;
+    for (std::string line; std::getline(requests, line);)
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (!line.empty())
+        {
+            urls.push_back(std::move(line));
+        }
+    }
+
+    std::atomic<std::size_t> next_url{0};
+    std::atomic<std::size_t> answered_requests{0};
+    const auto replay = [&] {
+        for (auto index = next_url++; index < urls.size(); index = next_url++)
+        {
+            std::string request_string;
+            util::URIDecode(urls[index], request_string);
+            auto api_iterator = request_string.begin();
+            auto parsed_url = api::parseURL(api_iterator, request_string.end());
+            auto *const profile_service_handler =
+                parsed_url && api_iterator == request_string.end()
+                    ? GetServiceHandler(parsed_url->profile)
+                    : nullptr;
+            if (!profile_service_handler)
+            {
+                continue;
+            }
+
+            // a broken sample must not keep the server from starting
+            try
+            {
+                ServiceHandler::ResultT result;
+                if (profile_service_handler->RunQuery(*std::move(parsed_url), result) ==
+                    engine::Status::Ok)
+                {
+                    ++answered_requests;
+                }
+            }
+            catch (const std::exception &error)
+            {
+                util::SimpleLogger().Write(logWARNING) << "Replaying " << urls[index]
+                                                       << " failed: " << error.what();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned thread = 1; thread < number_of_threads; ++thread)
+    {
+        threads.emplace_back(replay);
+    }
+    replay();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    return answered_requests;
+}
+
+void RequestHandler::HandleRequest(const http::request &current_request,
+                                   http::reply &current_reply,
+                                   const ChunkHandler &handle_chunk)
+{
+    // the temporaries of the request are freed at once when its reply is rendered
+    const util::ArenaScope arena_scope;
+
+    if (current_request.uri == "/metrics")
+    {
+        const auto metrics = engine::metrics::RenderPrometheus();
+        current_reply.content.assign(metrics.begin(), metrics.end());
+        current_reply.headers.emplace_back("Content-Type", "text/plain; version=0.0.4");
+        current_reply.headers.emplace_back("Content-Length",
+                                           std::to_string(current_reply.content.size()));
+        return;
+    }
+
+    if (current_request.uri == "/health")
+    {
+        HandleHealthRequest(current_reply);
+        return;
+    }
+
+    if (current_request.uri == "/stats")
+    {
+        HandleStatsRequest(current_reply);
+        return;
+    }
+
+    if (!service_handler && profile_service_handlers.empty())
     {
         current_reply = http::reply::stock_reply(http::reply::internal_server_error);
         util::SimpleLogger().Write(logWARNING) << "No service handler registered." << std::endl;
@@ -48,18 +401,113 @@ void RequestHandler::HandleRequest(const http::request &current_request, http::r
     try
     {
         std::string request_string;
-        util::URIDecode(current_request.uri, request_string);
-
         auto api_iterator = request_string.begin();
-        auto maybe_parsed_url = api::parseURL(api_iterator, request_string.end());
+        boost::optional<api::ParsedURL> maybe_parsed_url;
+        {
+            engine::metrics::StageTimer timer(engine::metrics::Stage::Parse);
+            util::URIDecode(current_request.uri, request_string);
+
+            api_iterator = request_string.begin();
+            maybe_parsed_url = api::parseURL(api_iterator, request_string.end());
+        }
+        if (maybe_parsed_url)
+        {
+            engine::metrics::SetService(maybe_parsed_url->service);
+            engine::metrics::SetURL(current_request.uri);
+        }
         ServiceHandler::ResultT result;
 
+        // set once the first piece of the body was handed to handle_chunk
+        bool streamed = false;
+        service::BaseService::ChunkHandler handle_service_chunk;
+        if (handle_chunk)
+        {
+            handle_service_chunk = [&](std::vector<char> &rendered) {
+                if (!streamed)
+                {
+                    streamed = true;
+                    AddContentHeaders(result, current_reply);
+                }
+                handle_chunk(rendered);
+            };
+        }
+
         // check if the was an error with the request
-        if (maybe_parsed_url && api_iterator == request_string.end())
+        auto *const profile_service_handler =
+            maybe_parsed_url ? GetServiceHandler(maybe_parsed_url->profile) : nullptr;
+
+        // only queries that would run are charged and counted, malformed ones are rejected
+        // cheaply anyway
+        RateLimiter::Clock::duration retry_after{};
+        if (maybe_parsed_url && api_iterator == request_string.end() && profile_service_handler)
         {
+            const auto cost =
+                RateLimiter::EstimateCost(maybe_parsed_url->service, maybe_parsed_url->query);
+            if (rate_limiter)
+            {
+                retry_after = rate_limiter->Acquire(current_request.endpoint.to_string(), cost);
+            }
+            const auto statistics = service_statistics.find(maybe_parsed_url->service);
+            if (retry_after <= RateLimiter::Clock::duration::zero() &&
+                statistics != service_statistics.end())
+            {
+                ++statistics->second.requests;
+                statistics->second.cost += static_cast<std::uint64_t>(cost);
+            }
+        }
 
+        // queries within the region of a shard are answered by it, unless it fails to
+        boost::optional<util::HttpResponse> shard_response;
+        if (shard_router && maybe_parsed_url && api_iterator == request_string.end() &&
+            profile_service_handler && retry_after <= RateLimiter::Clock::duration::zero())
+        {
+            if (const auto shard = shard_router->SelectShard(maybe_parsed_url->query))
+            {
+                const RunningRequest running_request(running_requests);
+                shard_response = shard_router->Forward(*shard, current_request.uri);
+                if (!shard_response ||
+                    (shard_response->status != http::reply::ok &&
+                     shard_response->status != http::reply::bad_request))
+                {
+                    util::SimpleLogger().Write(logWARNING)
+                        << "Shard " << *shard << " did not answer " << current_request.uri
+                        << ", answering it here";
+                    shard_response = boost::none;
+                }
+            }
+        }
+
+        if (maybe_parsed_url && api_iterator == request_string.end() && !profile_service_handler)
+        {
+            current_reply.status = http::reply::bad_request;
+            result = util::json::Object();
+            auto &json_result = result.get<util::json::Object>();
+            json_result.values["code"] = "InvalidProfile";
+            json_result.values["message"] = "Profile " + maybe_parsed_url->profile + " not found!";
+        }
+        else if (retry_after > RateLimiter::Clock::duration::zero())
+        {
+            const auto seconds =
+                std::chrono::duration_cast<std::chrono::seconds>(retry_after).count() + 1;
+            current_reply.status = http::reply::too_many_requests;
+            current_reply.headers.emplace_back("Retry-After", std::to_string(seconds));
+            result = util::json::Object();
+            auto &json_result = result.get<util::json::Object>();
+            json_result.values["code"] = "TooManyRequests";
+            json_result.values["message"] =
+                "Request rate limit exceeded, retry in " + std::to_string(seconds) + " seconds";
+        }
+        else if (shard_response)
+        {
+            current_reply.status = static_cast<http::reply::status_type>(shard_response->status);
+            result = ToResult(*std::move(shard_response));
+        }
+        else if (maybe_parsed_url && api_iterator == request_string.end())
+        {
+            const RunningRequest running_request(running_requests);
             const engine::Status status =
-                service_handler->RunQuery(*std::move(maybe_parsed_url), result);
+                profile_service_handler->RunQuery(
+                    *std::move(maybe_parsed_url), result, handle_service_chunk);
             if (status != engine::Status::Ok)
             {
                 // 4xx bad request return code
@@ -90,18 +538,23 @@ void RequestHandler::HandleRequest(const http::request &current_request, http::r
                                             std::to_string(position) + ": \"" + context + "\"";
         }
 
-        current_reply.headers.emplace_back("Access-Control-Allow-Origin", "*");
-        current_reply.headers.emplace_back("Access-Control-Allow-Methods", "GET");
-        current_reply.headers.emplace_back("Access-Control-Allow-Headers",
-                                           "X-Requested-With, Content-Type");
+        if (!streamed)
+        {
+            AddContentHeaders(result, current_reply);
+        }
         if (result.is<util::json::Object>())
         {
-            current_reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
-            current_reply.headers.emplace_back("Content-Disposition",
-                                               "inline; filename=\"response.json\"");
-
+            engine::metrics::StageTimer timer(engine::metrics::Stage::Rendering);
             util::json::render(current_reply.content, result.get<util::json::Object>());
         }
+        else if (result.is<std::vector<char>>())
+        {
+            current_reply.content = std::move(result.get<std::vector<char>>());
+        }
+        else if (result.is<service::BinaryResult>())
+        {
+            current_reply.content = std::move(result.get<service::BinaryResult>().content);
+        }
         else
         {
             BOOST_ASSERT(result.is<std::string>());
@@ -109,13 +562,14 @@ void RequestHandler::HandleRequest(const http::request &current_request, http::r
             std::copy(result.get<std::string>().cbegin(),
                       result.get<std::string>().cend(),
                       current_reply.content.begin());
-
-            current_reply.headers.emplace_back("Content-Type", "application/x-protobuf");
         }
 
-        // set headers
-        current_reply.headers.emplace_back("Content-Length",
-                                           std::to_string(current_reply.content.size()));
+        // set headers, the end of a streamed body is marked by its last chunk instead
+        if (!streamed)
+        {
+            current_reply.headers.emplace_back("Content-Length",
+                                               std::to_string(current_reply.content.size()));
+        }
 
         if (!std::getenv("DISABLE_ACCESS_LOGGING"))
         {
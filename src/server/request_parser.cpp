@@ -1,11 +1,14 @@
 #include "server/request_parser.hpp"
 
 #include "server/http/compression_type.hpp"
-#include "server/http/header.hpp"
 #include "server/http/request.hpp"
 
+#include "util/string_view.hpp"
+
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 namespace osrm
@@ -13,287 +16,262 @@ namespace osrm
 namespace server
 {
 
-RequestParser::RequestParser()
-    : state(internal_state::method_start), current_header({"", ""}),
-      selected_compression(http::no_compression)
+namespace
+{
+bool is_char(const int character) { return character >= 0 && character <= 127; }
+
+bool is_CTL(const int character)
 {
+    return (character >= 0 && character <= 31) || (character == 127);
 }
 
-std::tuple<RequestParser::RequestStatus, http::compression_type>
-RequestParser::parse(http::request &current_request, char *begin, char *end)
+bool is_special(const int character)
 {
-    while (begin != end)
+    switch (character)
     {
-        RequestStatus result = consume(current_request, *begin++);
-        if (result != RequestStatus::indeterminate)
-        {
-            return std::make_tuple(result, selected_compression);
-        }
+    case '(':
+    case ')':
+    case '<':
+    case '>':
+    case '@':
+    case ',':
+    case ';':
+    case ':':
+    case '\\':
+    case '"':
+    case '/':
+    case '[':
+    case ']':
+    case '?':
+    case '=':
+    case '{':
+    case '}':
+    case ' ':
+    case '\t':
+        return true;
+    default:
+        return false;
     }
-    RequestStatus result = RequestStatus::indeterminate;
+}
+
+bool is_digit(const int character) { return character >= '0' && character <= '9'; }
 
-    return std::make_tuple(result, selected_compression);
+bool is_token(const char character)
+{
+    return is_char(character) && !is_CTL(character) && !is_special(character);
 }
 
-RequestParser::RequestStatus RequestParser::consume(http::request &current_request,
-                                                    const char input)
+bool is_text(const char character) { return character == '\t' || !is_CTL(character); }
+
+bool is_whitespace(const char character) { return character == ' ' || character == '\t'; }
+
+// Returns the first occurrence of character in [begin, end) or end
+const char *find(const char *begin, const char *end, const char character)
 {
-    switch (state)
+    const auto found = std::memchr(begin, character, end - begin);
+    return found == nullptr ? end : static_cast<const char *>(found);
+}
+
+bool parse_number(const char *begin, const char *end, unsigned &number)
+{
+    if (begin == end || !std::all_of(begin, end, is_digit))
     {
-    case internal_state::method_start:
-        if (!is_char(input) || is_CTL(input) || is_special(input))
-        {
-            return RequestStatus::invalid;
-        }
-        state = internal_state::method;
-        return RequestStatus::indeterminate;
-    case internal_state::method:
-        if (input == ' ')
-        {
-            state = internal_state::uri;
-            return RequestStatus::indeterminate;
-        }
-        if (!is_char(input) || is_CTL(input) || is_special(input))
-        {
-            return RequestStatus::invalid;
-        }
-        return RequestStatus::indeterminate;
-    case internal_state::uri_start:
-        if (is_CTL(input))
-        {
-            return RequestStatus::invalid;
-        }
-        state = internal_state::uri;
-        current_request.uri.push_back(input);
-        return RequestStatus::indeterminate;
-    case internal_state::uri:
-        if (input == ' ')
-        {
-            state = internal_state::http_version_h;
-            return RequestStatus::indeterminate;
-        }
-        if (is_CTL(input))
-        {
-            return RequestStatus::invalid;
-        }
-        current_request.uri.push_back(input);
-        return RequestStatus::indeterminate;
-    case internal_state::http_version_h:
-        if (input == 'H')
-        {
-            state = internal_state::http_version_t_1;
-            return RequestStatus::indeterminate;
-        }
-        return RequestStatus::invalid;
-    case internal_state::http_version_t_1:
-        if (input == 'T')
-        {
-            state = internal_state::http_version_t_2;
-            return RequestStatus::indeterminate;
-        }
-        return RequestStatus::invalid;
-    case internal_state::http_version_t_2:
-        if (input == 'T')
+        return false;
+    }
+    number = 0;
+    for (; begin != end; ++begin)
+    {
+        number = number * 10 + *begin - '0';
+    }
+    return true;
+}
+
+// Parses HTTP/<major>.<minor>
+bool parse_version(const char *begin, const char *end, unsigned &major, unsigned &minor)
+{
+    static const char prefix[] = "HTTP/";
+    const std::size_t prefix_length = sizeof(prefix) - 1;
+    if (static_cast<std::size_t>(end - begin) < prefix_length ||
+        std::memcmp(begin, prefix, prefix_length) != 0)
+    {
+        return false;
+    }
+    begin += prefix_length;
+
+    const auto dot = find(begin, end, '.');
+    return dot != end && parse_number(begin, dot, major) && parse_number(dot + 1, end, minor);
+}
+}
+
+RequestParser::RequestParser()
+    : state(internal_state::request_line), selected_compression(http::no_compression)
+{
+}
+
+std::tuple<RequestParser::RequestStatus, http::compression_type, char *>
+RequestParser::parse(http::request &current_request, char *begin, char *end)
+{
+    while (begin != end)
+    {
+        const auto line_end = static_cast<char *>(std::memchr(begin, '\n', end - begin));
+        if (line_end == nullptr)
         {
-            state = internal_state::http_version_p;
-            return RequestStatus::indeterminate;
+            // the line continues in the next read, which overwrites this buffer
+            partial_line.append(begin, end);
+            break;
         }
-        return RequestStatus::invalid;
-    case internal_state::http_version_p:
-        if (input == 'P')
+
+        RequestStatus result;
+        if (partial_line.empty())
         {
-            state = internal_state::http_version_slash;
-            return RequestStatus::indeterminate;
+            result = consume_line(current_request, begin, line_end);
         }
-        return RequestStatus::invalid;
-    case internal_state::http_version_slash:
-        if (input == '/')
+        else
         {
-            state = internal_state::http_version_major_start;
-            return RequestStatus::indeterminate;
+            partial_line.append(begin, line_end);
+            result = consume_line(current_request,
+                                  partial_line.data(),
+                                  partial_line.data() + partial_line.size());
+            partial_line.clear();
         }
-        return RequestStatus::invalid;
-    case internal_state::http_version_major_start:
-        if (is_digit(input))
+
+        begin = line_end + 1;
+        if (result != RequestStatus::indeterminate)
         {
-            state = internal_state::http_version_major;
-            return RequestStatus::indeterminate;
+            return std::make_tuple(result, selected_compression, begin);
         }
+    }
+    RequestStatus result = RequestStatus::indeterminate;
+
+    return std::make_tuple(result, selected_compression, end);
+}
+
+RequestParser::RequestStatus
+RequestParser::consume_line(http::request &current_request, const char *begin, const char *end)
+{
+    // lines end in CRLF
+    if (begin == end || *(end - 1) != '\r')
+    {
         return RequestStatus::invalid;
-    case internal_state::http_version_major:
-        if (input == '.')
-        {
-            state = internal_state::http_version_minor_start;
-            return RequestStatus::indeterminate;
-        }
-        if (is_digit(input))
-        {
-            return RequestStatus::indeterminate;
-        }
+    }
+    --end;
+
+    if (state == internal_state::request_line)
+    {
+        return consume_request_line(current_request, begin, end);
+    }
+    return consume_header_line(current_request, begin, end);
+}
+
+RequestParser::RequestStatus RequestParser::consume_request_line(http::request &current_request,
+                                                                 const char *begin,
+                                                                 const char *end)
+{
+    const auto method_end = find(begin, end, ' ');
+    if (method_end == begin || method_end == end || !std::all_of(begin, method_end, is_token))
+    {
         return RequestStatus::invalid;
-    case internal_state::http_version_minor_start:
-        if (is_digit(input))
-        {
-            state = internal_state::http_version_minor;
-            return RequestStatus::indeterminate;
-        }
+    }
+
+    const auto uri_begin = method_end + 1;
+    const auto uri_end = find(uri_begin, end, ' ');
+    if (uri_end == uri_begin || uri_end == end || std::any_of(uri_begin, uri_end, is_CTL))
+    {
         return RequestStatus::invalid;
-    case internal_state::http_version_minor:
-        if (input == '\r')
-        {
-            state = internal_state::expecting_newline_1;
-            return RequestStatus::indeterminate;
-        }
-        if (is_digit(input))
-        {
-            return RequestStatus::indeterminate;
-        }
+    }
+
+    unsigned http_version_major;
+    unsigned http_version_minor;
+    if (!parse_version(uri_end + 1, end, http_version_major, http_version_minor))
+    {
         return RequestStatus::invalid;
-    case internal_state::expecting_newline_1:
-        if (input == '\n')
-        {
-            state = internal_state::header_line_start;
-            return RequestStatus::indeterminate;
-        }
+    }
+
+    current_request.uri.assign(uri_begin, uri_end);
+    // HTTP/1.1 connections are persistent unless the client says otherwise
+    current_request.keep_alive =
+        http_version_major > 1 || (http_version_major == 1 && http_version_minor >= 1);
+    current_request.accepts_chunked = current_request.keep_alive;
+
+    state = internal_state::header_line;
+    return RequestStatus::indeterminate;
+}
+
+RequestParser::RequestStatus RequestParser::consume_header_line(http::request &current_request,
+                                                                const char *begin,
+                                                                const char *end)
+{
+    // an empty line ends the header
+    if (begin == end)
+    {
+        return RequestStatus::valid;
+    }
+
+    // continuation of a folded header value, none of the headers we look at need it
+    if (is_whitespace(*begin))
+    {
+        return std::all_of(begin, end, is_text) ? RequestStatus::indeterminate
+                                                : RequestStatus::invalid;
+    }
+
+    const auto colon = find(begin, end, ':');
+    if (colon == end || !std::all_of(begin, colon, is_token))
+    {
         return RequestStatus::invalid;
-    case internal_state::header_line_start:
-        if (boost::iequals(current_header.name, "Accept-Encoding"))
-        {
-            /* giving gzip precedence over deflate */
-            if (boost::icontains(current_header.value, "deflate"))
-            {
-                selected_compression = http::deflate_rfc1951;
-            }
-            if (boost::icontains(current_header.value, "gzip"))
-            {
-                selected_compression = http::gzip_rfc1952;
-            }
-        }
+    }
 
-        if (boost::iequals(current_header.name, "Referer"))
-        {
-            current_request.referrer = current_header.value;
-        }
+    auto value_begin = colon + 1;
+    auto value_end = end;
+    while (value_begin != value_end && is_whitespace(*value_begin))
+    {
+        ++value_begin;
+    }
+    while (value_begin != value_end && is_whitespace(*(value_end - 1)))
+    {
+        --value_end;
+    }
+    if (!std::all_of(value_begin, value_end, is_text))
+    {
+        return RequestStatus::invalid;
+    }
 
-        if (boost::iequals(current_header.name, "User-Agent"))
-        {
-            current_request.agent = current_header.value;
-        }
+    const util::StringView name(begin, colon);
+    const util::StringView value(value_begin, value_end);
 
-        if (input == '\r')
-        {
-            state = internal_state::expecting_newline_3;
-            return RequestStatus::indeterminate;
-        }
-        if (!is_char(input) || is_CTL(input) || is_special(input))
-        {
-            return RequestStatus::invalid;
-        }
-        state = internal_state::header_name;
-        current_header.clear();
-        current_header.name.push_back(input);
-        return RequestStatus::indeterminate;
-    case internal_state::header_lws:
-        if (input == '\r')
-        {
-            state = internal_state::expecting_newline_2;
-            return RequestStatus::indeterminate;
-        }
-        if (input == ' ' || input == '\t')
-        {
-            return RequestStatus::indeterminate;
-        }
-        if (is_CTL(input))
-        {
-            return RequestStatus::invalid;
-        }
-        state = internal_state::header_value;
-        return RequestStatus::indeterminate;
-    case internal_state::header_name:
-        if (input == ':')
-        {
-            state = internal_state::space_before_header_value;
-            return RequestStatus::indeterminate;
-        }
-        if (!is_char(input) || is_CTL(input) || is_special(input))
-        {
-            return RequestStatus::invalid;
-        }
-        current_header.name.push_back(input);
-        return RequestStatus::indeterminate;
-    case internal_state::space_before_header_value:
-        if (input == ' ')
+    if (boost::iequals(name, "Accept-Encoding"))
+    {
+        /* giving gzip precedence over deflate */
+        if (boost::icontains(value, "deflate"))
         {
-            state = internal_state::header_value;
-            return RequestStatus::indeterminate;
+            selected_compression = http::deflate_rfc1951;
         }
-        return RequestStatus::invalid;
-    case internal_state::header_value:
-        if (input == '\r')
+        if (boost::icontains(value, "gzip"))
         {
-            state = internal_state::expecting_newline_2;
-            return RequestStatus::indeterminate;
+            selected_compression = http::gzip_rfc1952;
         }
-        if (is_CTL(input))
+    }
+    else if (boost::iequals(name, "Connection"))
+    {
+        if (boost::icontains(value, "close"))
         {
-            return RequestStatus::invalid;
+            current_request.keep_alive = false;
         }
-        current_header.value.push_back(input);
-        return RequestStatus::indeterminate;
-    case internal_state::expecting_newline_2:
-        if (input == '\n')
+        else if (boost::icontains(value, "keep-alive"))
         {
-            state = internal_state::header_line_start;
-            return RequestStatus::indeterminate;
+            current_request.keep_alive = true;
         }
-        return RequestStatus::invalid;
-    default: // expecting_newline_3
-        return input == '\n' ? RequestStatus::valid : RequestStatus::invalid;
     }
-}
-
-bool RequestParser::is_char(const int character) const
-{
-    return character >= 0 && character <= 127;
-}
-
-bool RequestParser::is_CTL(const int character) const
-{
-    return (character >= 0 && character <= 31) || (character == 127);
-}
-
-bool RequestParser::is_special(const int character) const
-{
-    switch (character)
+    // only kept for the access log
+    else if (boost::iequals(name, "Referer"))
     {
-    case '(':
-    case ')':
-    case '<':
-    case '>':
-    case '@':
-    case ',':
-    case ';':
-    case ':':
-    case '\\':
-    case '"':
-    case '/':
-    case '[':
-    case ']':
-    case '?':
-    case '=':
-    case '{':
-    case '}':
-    case ' ':
-    case '\t':
-        return true;
-    default:
-        return false;
+        current_request.referrer = util::ToString(value);
+    }
+    else if (boost::iequals(name, "User-Agent"))
+    {
+        current_request.agent = util::ToString(value);
     }
-}
 
-bool RequestParser::is_digit(const int character) const
-{
-    return character >= '0' && character <= '9';
+    return RequestStatus::indeterminate;
 }
 }
 }
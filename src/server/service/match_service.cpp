@@ -8,6 +8,10 @@
 
 #include <boost/format.hpp>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 namespace osrm
 {
 namespace server
@@ -16,6 +20,9 @@ namespace service
 {
 namespace
 {
+// no location, polyline or option value contains it
+const constexpr char BATCH_SEPARATOR = ':';
+
 std::string getWrongOptionHelp(const engine::api::MatchParameters &parameters)
 {
     std::string help;
@@ -32,11 +39,21 @@ std::string getWrongOptionHelp(const engine::api::MatchParameters &parameters)
         constrainParamSize(
             PARAMETER_SIZE_MISMATCH_MSG, "timestamps", parameters.timestamps, coord_size, help);
 
-    if (!param_size_mismatch && parameters.coordinates.size() < 2)
+    if (!param_size_mismatch && parameters.session.empty() && parameters.coordinates.size() < 2)
     {
         help = "Number of coordinates needs to be at least two.";
     }
 
+    if (!param_size_mismatch && parameters.coordinates.empty())
+    {
+        help = "Number of coordinates needs to be at least one.";
+    }
+
+    if (parameters.format != engine::api::BaseParameters::OutputFormatType::JSON)
+    {
+        help = UNSUPPORTED_FORMAT_MSG;
+    }
+
     return help;
 }
 } // anon. ns
@@ -47,28 +64,49 @@ MatchService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &r
     result = util::json::Object();
     auto &json_result = result.get<util::json::Object>();
 
-    auto query_iterator = query.begin();
-    auto parameters =
-        api::parseParameters<engine::api::MatchParameters>(query_iterator, query.end());
-    if (!parameters || query_iterator != query.end())
+    // a batch holds several complete match queries that are matched in parallel
+    std::vector<engine::api::MatchParameters> batch;
+    std::size_t trace_begin = 0;
+    while (true)
     {
-        const auto position = std::distance(query.begin(), query_iterator);
-        json_result.values["code"] = "InvalidQuery";
-        json_result.values["message"] =
-            "Query string malformed close to position " + std::to_string(prefix_length + position);
-        return engine::Status::Error;
+        const auto trace_end = std::min(query.find(BATCH_SEPARATOR, trace_begin), query.size());
+        std::string trace_query = query.substr(trace_begin, trace_end - trace_begin);
+
+        auto query_iterator = trace_query.begin();
+        auto parameters = api::parseParameters<engine::api::MatchParameters>(query_iterator,
+                                                                            trace_query.end());
+        if (!parameters || query_iterator != trace_query.end())
+        {
+            const auto position = std::distance(trace_query.begin(), query_iterator);
+            json_result.values["code"] = "InvalidQuery";
+            json_result.values["message"] =
+                "Query string malformed close to position " +
+                std::to_string(prefix_length + trace_begin + position);
+            return engine::Status::Error;
+        }
+
+        BOOST_ASSERT(parameters);
+        if (!parameters->IsValid())
+        {
+            json_result.values["code"] = "InvalidOptions";
+            json_result.values["message"] = getWrongOptionHelp(*parameters);
+            return engine::Status::Error;
+        }
+        BOOST_ASSERT(parameters->IsValid());
+        batch.push_back(std::move(*parameters));
+
+        if (trace_end == query.size())
+        {
+            break;
+        }
+        trace_begin = trace_end + 1;
     }
 
-    BOOST_ASSERT(parameters);
-    if (!parameters->IsValid())
+    if (batch.size() == 1)
     {
-        json_result.values["code"] = "InvalidOptions";
-        json_result.values["message"] = getWrongOptionHelp(*parameters);
-        return engine::Status::Error;
+        return BaseService::routing_machine.Match(batch.front(), json_result);
     }
-    BOOST_ASSERT(parameters->IsValid());
-
-    return BaseService::routing_machine.Match(*parameters, json_result);
+    return BaseService::routing_machine.Match(batch, json_result);
 }
 }
 }
@@ -31,9 +31,14 @@ std::string getWrongOptionHelp(const engine::api::NearestParameters &parameters)
         constrainParamSize(
             PARAMETER_SIZE_MISMATCH_MSG, "radiuses", parameters.radiuses, coord_size, help);
 
-    if (!param_size_mismatch && parameters.coordinates.size() < 2)
+    if (!param_size_mismatch && parameters.coordinates.empty())
     {
-        help = "Number of coordinates needs to be at least two.";
+        help = "Number of coordinates needs to be at least one.";
+    }
+
+    if (parameters.format != engine::api::BaseParameters::OutputFormatType::JSON)
+    {
+        help = UNSUPPORTED_FORMAT_MSG;
     }
 
     return help;
@@ -67,7 +72,8 @@ NearestService::RunQuery(std::size_t prefix_length, std::string &query, ResultT
     }
     BOOST_ASSERT(parameters->IsValid());
 
-    return BaseService::routing_machine.Nearest(*parameters, json_result);
+    result = std::vector<char>();
+    return BaseService::routing_machine.Nearest(*parameters, result.get<std::vector<char>>());
 }
 }
 }
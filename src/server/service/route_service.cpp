@@ -33,6 +33,11 @@ std::string getWrongOptionHelp(const engine::api::RouteParameters &parameters)
         help = "Number of coordinates needs to be at least two.";
     }
 
+    if (parameters.format != engine::api::BaseParameters::OutputFormatType::JSON)
+    {
+        help = UNSUPPORTED_FORMAT_MSG;
+    }
+
     return help;
 }
 } // anon. ns
@@ -60,6 +60,14 @@ std::string getWrongOptionHelp(const engine::api::TableParameters &parameters)
 
 engine::Status
 TableService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &result)
+{
+    return RunStreamedQuery(prefix_length, query, result, {});
+}
+
+engine::Status TableService::RunStreamedQuery(std::size_t prefix_length,
+                                              std::string &query,
+                                              ResultT &result,
+                                              const ChunkHandler &handle_chunk)
 {
     result = util::json::Object();
     auto &json_result = result.get<util::json::Object>();
@@ -85,7 +93,34 @@ TableService::RunQuery(std::size_t prefix_length, std::string &query, ResultT &r
     }
     BOOST_ASSERT(parameters->IsValid());
 
-    return BaseService::routing_machine.Table(*parameters, json_result);
+    // the type of the result tells the content type, also of the chunks handed out before the
+    // table is complete
+    const bool binary =
+        parameters->format == engine::api::TableParameters::OutputFormatType::Binary;
+    if (binary)
+    {
+        result = BinaryResult{};
+    }
+    else
+    {
+        result = std::vector<char>();
+    }
+    auto &rendered_result =
+        binary ? result.get<BinaryResult>().content : result.get<std::vector<char>>();
+
+    const auto status =
+        handle_chunk
+            ? BaseService::routing_machine.Table(*parameters, rendered_result, handle_chunk)
+            : BaseService::routing_machine.Table(*parameters, rendered_result);
+
+    // errors are reported as JSON regardless of the requested format
+    if (status != engine::Status::Ok && binary)
+    {
+        auto error = std::move(rendered_result);
+        result = std::move(error);
+    }
+
+    return status;
 }
 }
 }
@@ -1,5 +1,6 @@
 #include "server/service_handler.hpp"
 
+#include "server/service/isochrone_service.hpp"
 #include "server/service/match_service.hpp"
 #include "server/service/nearest_service.hpp"
 #include "server/service/route_service.hpp"
@@ -8,26 +9,91 @@
 #include "server/service/trip_service.hpp"
 
 #include "server/api/parsed_url.hpp"
+#include "server/api/url_parser.hpp"
+#include "engine/engine_config.hpp"
 #include "util/json_util.hpp"
 #include "util/make_unique.hpp"
+#include "util/numa.hpp"
+#include "util/simple_logger.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <utility>
 
 namespace osrm
 {
 namespace server
 {
-ServiceHandler::ServiceHandler(osrm::EngineConfig &config) : routing_machine(config)
+ServiceHandler::NodeServices::NodeServices(osrm::EngineConfig &config) : routing_machine(config)
 {
     service_map["route"] = util::make_unique<service::RouteService>(routing_machine);
     service_map["table"] = util::make_unique<service::TableService>(routing_machine);
     service_map["nearest"] = util::make_unique<service::NearestService>(routing_machine);
     service_map["trip"] = util::make_unique<service::TripService>(routing_machine);
     service_map["match"] = util::make_unique<service::MatchService>(routing_machine);
+    service_map["isochrone"] = util::make_unique<service::IsochroneService>(routing_machine);
     service_map["tile"] = util::make_unique<service::TileService>(routing_machine);
 }
 
+ServiceHandler::ServiceHandler(osrm::EngineConfig &config, const unsigned numa_nodes)
+    : node_services(std::max(1u, numa_nodes))
+{
+    if (node_services.size() == 1)
+    {
+        node_services.front() = util::make_unique<NodeServices>(config);
+        return;
+    }
+
+    // memory is placed on the node of the thread touching it first
+    std::vector<std::exception_ptr> errors(node_services.size());
+    std::vector<std::thread> loaders;
+    for (unsigned node = 0; node < node_services.size(); ++node)
+    {
+        loaders.emplace_back([this, &config, &errors, node] {
+            try
+            {
+                if (!util::numa::PinThreadToNode(node))
+                {
+                    util::SimpleLogger().Write(logWARNING)
+                        << "Could not pin the engine loader to NUMA node " << node;
+                }
+                auto node_config = config;
+                node_config.numa_node = node;
+                node_services[node] = util::make_unique<NodeServices>(node_config);
+            }
+            catch (...)
+            {
+                errors[node] = std::current_exception();
+            }
+        });
+    }
+    for (auto &loader : loaders)
+    {
+        loader.join();
+    }
+    for (const auto &error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
 engine::Status ServiceHandler::RunQuery(api::ParsedURL parsed_url,
                                         service::BaseService::ResultT &result)
 {
+    return RunQuery(std::move(parsed_url), result, {});
+}
+
+engine::Status ServiceHandler::RunQuery(api::ParsedURL parsed_url,
+                                        service::BaseService::ResultT &result,
+                                        const service::BaseService::ChunkHandler &handle_chunk)
+{
+    auto &services = SelectNode(parsed_url);
+    auto &service_map = services.service_map;
     const auto &service_iter = service_map.find(parsed_url.service);
     if (service_iter == service_map.end())
     {
@@ -48,7 +114,77 @@ engine::Status ServiceHandler::RunQuery(api::ParsedURL parsed_url,
         return engine::Status::Error;
     }
 
-    return service->RunQuery(parsed_url.prefix_length, parsed_url.query, result);
+    if (!coalescer || !QueryCoalescer::IsShareable(parsed_url.service, parsed_url.query))
+    {
+        if (handle_chunk)
+        {
+            return service->RunStreamedQuery(
+                parsed_url.prefix_length, parsed_url.query, result, handle_chunk);
+        }
+        return service->RunQuery(parsed_url.prefix_length, parsed_url.query, result);
+    }
+
+    const auto key =
+        QueryCoalescer::MakeKey(parsed_url.service, parsed_url.version, parsed_url.query);
+    return coalescer->Run(key,
+                          services.routing_machine.GetDatasetGeneration(),
+                          [&](ResultT &query_result) {
+                              return service->RunQuery(
+                                  parsed_url.prefix_length, parsed_url.query, query_result);
+                          },
+                          result);
+}
+
+ServiceHandler::NodeServices &ServiceHandler::SelectNode(const api::ParsedURL &parsed_url) const
+{
+    if (node_services.size() > 1)
+    {
+        // state of the engine of a node that later requests have to find again
+        std::string key;
+        if (parsed_url.service == "match")
+        {
+            key = api::getOption(parsed_url.query, "session");
+        }
+        else if (parsed_url.service == "table")
+        {
+            key = api::getOption(parsed_url.query, "target_set");
+        }
+        if (!key.empty())
+        {
+            return *node_services[std::hash<std::string>()(key) % node_services.size()];
+        }
+    }
+    return *node_services[util::numa::GetThreadNode() % node_services.size()];
+}
+
+void ServiceHandler::CoalesceQueries(const std::chrono::milliseconds time_to_live,
+                                     const std::size_t max_entries)
+{
+    coalescer = util::make_unique<QueryCoalescer>(time_to_live, max_entries);
+}
+
+void ServiceHandler::PrepareThread()
+{
+    node_services[util::numa::GetThreadNode() % node_services.size()]
+        ->routing_machine.PrepareThread();
+}
+
+unsigned ServiceHandler::GetDatasetGeneration() const
+{
+    return node_services[util::numa::GetThreadNode() % node_services.size()]
+        ->routing_machine.GetDatasetGeneration();
+}
+
+std::string ServiceHandler::GetTimestamp() const
+{
+    return node_services[util::numa::GetThreadNode() % node_services.size()]
+        ->routing_machine.GetTimestamp();
+}
+
+void ServiceHandler::GetMemoryUsage(util::json::Object &result) const
+{
+    node_services[util::numa::GetThreadNode() % node_services.size()]
+        ->routing_machine.GetMemoryUsage(result);
 }
 }
 }
@@ -0,0 +1,175 @@
+#include "server/shard_router.hpp"
+
+#include "server/api/url_parser.hpp"
+#include "engine/polyline_compressor.hpp"
+#include "util/exception.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace osrm
+{
+namespace server
+{
+
+namespace
+{
+// Parses a number of a coordinate list, which ends at the separator or at the end of the list
+bool ParseNumber(const char *&position, const char *const end, double &value)
+{
+    char *number_end = nullptr;
+    value = std::strtod(position, &number_end);
+    if (number_end == position || number_end > end || !std::isfinite(value))
+    {
+        return false;
+    }
+    position = number_end;
+    return true;
+}
+
+// The end of the coordinates, before the format suffix of the output format, if any
+std::size_t StripFormat(const std::string &query, const std::size_t end)
+{
+    for (const std::string format : {".json", ".binary"})
+    {
+        if (end >= format.size() && query.compare(end - format.size(), format.size(), format) == 0)
+        {
+            return end - format.size();
+        }
+    }
+    return end;
+}
+}
+
+ShardRouter::ShardRouter(const std::vector<std::string> &shards_,
+                         const std::chrono::milliseconds timeout)
+    : timeout(timeout)
+{
+    for (const auto &shard : shards_)
+    {
+        const auto equals = shard.rfind('=');
+        const auto separator = shard.rfind(':');
+        if (equals == std::string::npos || equals == 0 || separator == std::string::npos ||
+            separator < equals + 2 || separator + 1 == shard.size())
+        {
+            throw util::exception("Shard " + shard + " is not of the form <polygon>=host:port");
+        }
+        auto host = shard.substr(equals + 1, separator - equals - 1);
+        // IPv6 addresses are enclosed in brackets, like in URLs
+        if (host.size() > 2 && host.front() == '[' && host.back() == ']')
+        {
+            host = host.substr(1, host.size() - 2);
+        }
+        shards.push_back({util::RegionPolygon(shard.substr(0, equals)),
+                          std::move(host),
+                          shard.substr(separator + 1)});
+    }
+}
+
+boost::optional<std::size_t> ShardRouter::SelectShard(const std::string &query) const
+{
+    // the traces of a match batch after the first are not checked, and the shards hold neither
+    // the sessions nor the target sets of this server
+    if (query.find(':') != std::string::npos || api::hasOption(query, "session") ||
+        api::hasOption(query, "target_set"))
+    {
+        return boost::none;
+    }
+
+    const auto coordinates = ParseCoordinates(query);
+    if (coordinates.empty())
+    {
+        return boost::none;
+    }
+
+    const auto shard = std::find_if(shards.begin(), shards.end(), [&](const Shard &shard) {
+        return std::all_of(
+            coordinates.begin(), coordinates.end(), [&](const util::Coordinate coordinate) {
+                return shard.region.Contains(coordinate);
+            });
+    });
+    if (shard == shards.end())
+    {
+        return boost::none;
+    }
+    return static_cast<std::size_t>(std::distance(shards.begin(), shard));
+}
+
+boost::optional<util::HttpResponse> ShardRouter::Forward(const std::size_t shard,
+                                                         const std::string &uri) const
+{
+    BOOST_ASSERT(shard < shards.size());
+    return util::HttpGet(shards[shard].host, shards[shard].port, uri, timeout);
+}
+
+std::vector<util::Coordinate> ShardRouter::ParseCoordinates(const std::string &query)
+{
+    std::vector<util::Coordinate> coordinates;
+
+    if (boost::starts_with(query, "polyline("))
+    {
+        // polylines may contain '?', so the options start after them
+        const auto polyline_end = query.find(')');
+        if (polyline_end == std::string::npos ||
+            StripFormat(query, std::min(query.find('?', polyline_end), query.size())) !=
+                polyline_end + 1)
+        {
+            return {};
+        }
+        const auto polyline = query.substr(9, polyline_end - 9);
+        try
+        {
+            coordinates = engine::decodePolyline(polyline);
+        }
+        catch (const std::exception &)
+        {
+            return {};
+        }
+    }
+    else
+    {
+        // lon,lat;lon,lat;... followed by the format, e.g. .json, and the options. The list is
+        // copied so that the last number ends there and not in the format suffix.
+        const auto options = std::min(query.find('?'), query.size());
+        const auto list = query.substr(0, StripFormat(query, options));
+        const char *position = list.c_str();
+        const char *const end = position + list.size();
+        while (true)
+        {
+            double lon = 0;
+            double lat = 0;
+            if (!ParseNumber(position, end, lon) || position == end || *position != ',')
+            {
+                return {};
+            }
+            ++position;
+            // out of range values are not even converted to fixed point
+            if (!ParseNumber(position, end, lat) || std::abs(lon) > 180 || std::abs(lat) > 90)
+            {
+                return {};
+            }
+            coordinates.emplace_back(util::FloatLongitude{lon}, util::FloatLatitude{lat});
+            if (position == end)
+            {
+                break;
+            }
+            if (*position != ';')
+            {
+                return {};
+            }
+            ++position;
+        }
+    }
+
+    const auto is_valid = [](const util::Coordinate coordinate) { return coordinate.IsValid(); };
+    if (!std::all_of(coordinates.begin(), coordinates.end(), is_valid))
+    {
+        return {};
+    }
+    return coordinates;
+}
+}
+}
@@ -0,0 +1,156 @@
+#include "storage/dataset.hpp"
+
+#include "util/crc32c.hpp"
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/simple_logger.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace osrm
+{
+namespace storage
+{
+
+namespace
+{
+const constexpr char DATASET_MAGIC[8] = {'O', 'S', 'R', 'M', 'D', 'S', 'E', 'T'};
+// 2 added the EDGE_LENGTHS block
+// 3 packs OSM node IDs word aligned and TRAVEL_MODE with 4 bits per mode
+// 4 added the GEOMETRIES_BLOCK_OFFSETS and GEOMETRIES_ENCODED blocks
+// 5 replaced the range table of the names by interned strings with offsets and lengths
+// 6 stores quantized bounding boxes of the children in the r-tree nodes
+// 7 checksums the blocks with CRC32C
+// 8 added the number of metrics to the TIME_SLOTS header
+// 10 added the COORDINATE_BLOCKS and COORDINATE_WORDS blocks
+// 11 added the DUPLICATED_NODES block
+const constexpr std::uint32_t DATASET_VERSION = 11;
+
+std::uint32_t GetBlockChecksum(const SharedDataLayout &layout,
+                               const char *data,
+                               const SharedDataLayout::BlockID block)
+{
+    return util::ParallelCRC32C(data + layout.GetBlockOffset(block), layout.GetBlockSize(block));
+}
+}
+
+DatasetWriter::DatasetWriter(const boost::filesystem::path &path_, const SharedDataLayout &layout)
+    : path(path_), temporary_path(path_.string() + ".tmp")
+{
+    std::copy(std::begin(DATASET_MAGIC), std::end(DATASET_MAGIC), header.magic);
+    header.version = DATASET_VERSION;
+    header.fingerprint = util::FingerPrint::GetValid();
+    header.data_offset = (sizeof(DatasetHeader) + DATASET_DATA_ALIGNMENT - 1) /
+                         DATASET_DATA_ALIGNMENT * DATASET_DATA_ALIGNMENT;
+    header.data_size = layout.GetSizeOfLayout();
+    header.layout = layout;
+    header.block_checksums.fill(0);
+
+    {
+        boost::filesystem::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            throw util::exception("Could not open " + temporary_path.string() + " for writing.");
+        }
+    }
+    boost::filesystem::resize_file(temporary_path, header.data_offset + header.data_size);
+
+    mapping = boost::interprocess::file_mapping(temporary_path.string().c_str(),
+                                                boost::interprocess::read_write);
+    region = boost::interprocess::mapped_region(mapping, boost::interprocess::read_write);
+}
+
+DatasetWriter::~DatasetWriter()
+{
+    // only left over if the dataset was not finished
+    boost::system::error_code error;
+    boost::filesystem::remove(temporary_path, error);
+}
+
+char *DatasetWriter::GetData()
+{
+    return static_cast<char *>(region.get_address()) + header.data_offset;
+}
+
+void DatasetWriter::Finish()
+{
+    const auto data = GetData();
+    for (const auto block : util::irange(0, static_cast<int>(SharedDataLayout::NUM_BLOCKS)))
+    {
+        header.block_checksums[block] = GetBlockChecksum(
+            header.layout, data, static_cast<SharedDataLayout::BlockID>(block));
+    }
+    std::memcpy(region.get_address(), &header, sizeof(DatasetHeader));
+
+    if (!region.flush())
+    {
+        throw util::exception("Could not write " + temporary_path.string());
+    }
+    region = boost::interprocess::mapped_region();
+    mapping = boost::interprocess::file_mapping();
+    boost::filesystem::rename(temporary_path, path);
+}
+
+DatasetFile::DatasetFile(const boost::filesystem::path &path)
+{
+    if (!boost::filesystem::is_regular_file(path))
+    {
+        throw util::exception("Could not open " + path.string() + " for reading.");
+    }
+    const auto file_size = boost::filesystem::file_size(path);
+    if (file_size < sizeof(DatasetHeader))
+    {
+        throw util::exception(path.string() + " is not a dataset");
+    }
+
+    mapping = boost::interprocess::file_mapping(path.string().c_str(),
+                                                boost::interprocess::read_only);
+    region = boost::interprocess::mapped_region(mapping, boost::interprocess::copy_on_write);
+    header = static_cast<DatasetHeader *>(region.get_address());
+
+    if (!std::equal(std::begin(DATASET_MAGIC), std::end(DATASET_MAGIC), header->magic) ||
+        header->version != DATASET_VERSION)
+    {
+        throw util::exception(path.string() + " is not a dataset of this version");
+    }
+    if (!header->fingerprint.TestQueryObjects(util::FingerPrint::GetValid()))
+    {
+        util::SimpleLogger().Write(logWARNING) << path.string()
+                                               << " was written by a different build. "
+                                                  "Run osrm-datastore --dataset again.";
+    }
+    if (header->data_offset % DATASET_DATA_ALIGNMENT != 0 ||
+        header->data_size != header->layout.GetSizeOfLayout() ||
+        file_size < header->data_offset + header->data_size)
+    {
+        throw util::exception(path.string() + " is truncated or corrupted");
+    }
+}
+
+SharedDataLayout &DatasetFile::GetLayout() { return header->layout; }
+
+char *DatasetFile::GetData()
+{
+    return static_cast<char *>(region.get_address()) + header->data_offset;
+}
+
+std::vector<std::string> DatasetFile::FindCorruptBlocks() const
+{
+    const auto data = static_cast<const char *>(region.get_address()) + header->data_offset;
+    std::vector<std::string> corrupt_blocks;
+    for (const auto block : util::irange(0, static_cast<int>(SharedDataLayout::NUM_BLOCKS)))
+    {
+        if (header->block_checksums[block] !=
+            GetBlockChecksum(header->layout, data, static_cast<SharedDataLayout::BlockID>(block)))
+        {
+            corrupt_blocks.push_back(block_id_to_name[block]);
+        }
+    }
+    return corrupt_blocks;
+}
+}
+}
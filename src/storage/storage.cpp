@@ -1,25 +1,38 @@
 #include "contractor/query_edge.hpp"
+#include "contractor/time_slots.hpp"
 #include "extractor/compressed_edge_container.hpp"
+#include "extractor/duplicated_node.hpp"
 #include "extractor/guidance/turn_instruction.hpp"
 #include "extractor/original_edge_data.hpp"
 #include "extractor/profile_properties.hpp"
 #include "extractor/query_node.hpp"
 #include "extractor/travel_mode.hpp"
+#include "storage/dataset.hpp"
 #include "storage/shared_barriers.hpp"
 #include "storage/shared_datatype.hpp"
 #include "storage/shared_memory.hpp"
 #include "storage/storage.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
+#include "util/block_encoded_coordinates.hpp"
 #include "util/coordinate.hpp"
+#include "util/crc32c.hpp"
+#include "util/delta_encoded_geometries.hpp"
 #include "util/exception.hpp"
 #include "util/fingerprint.hpp"
+#include "util/integer_range.hpp"
+#include "util/intermediate_file.hpp"
 #include "util/io.hpp"
+#include "util/make_unique.hpp"
+#include "util/name_table.hpp"
+#include "util/numa.hpp"
 #include "util/packed_vector.hpp"
 #include "util/range_table.hpp"
+#include "util/segment_weight_list.hpp"
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/simple_logger.hpp"
 #include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
+#include "util/timing_util.hpp"
 #include "util/typedefs.hpp"
 
 #ifdef __linux__
@@ -27,13 +40,24 @@
 #endif
 
 #include <boost/filesystem/fstream.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/iostreams/seek.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_for_each.h>
+
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
 
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <new>
 #include <string>
 
@@ -43,9 +67,12 @@ namespace storage
 {
 
 using RTreeLeaf = engine::datafacade::BaseDataFacade::RTreeLeaf;
-using RTreeNode =
-    util::StaticRTree<RTreeLeaf, util::ShM<util::Coordinate, true>::vector, true>::TreeNode;
+using RTree = util::StaticRTree<RTreeLeaf, util::CoordinateList<true>, true>;
+using EncodedCoordinates = util::BlockEncodedCoordinates<true>;
+using RTreeNode = RTree::TreeNode;
+using RTreeLeafNode = RTree::LeafNode;
 using QueryGraph = util::StaticGraph<contractor::QueryEdge::EdgeData>;
+using PackedTravelModes = util::PackedVector<extractor::TravelMode, TRAVEL_MODE_BITS, true>;
 
 // delete a shared memory region. report warning if it could not be deleted
 void deleteRegion(const SharedDataType region)
@@ -76,6 +103,151 @@ void deleteRegion(const SharedDataType region)
     }
 }
 
+// delete the NUMA replicas of a data region
+void deleteReplicaRegions(const SharedDataType data_region)
+{
+    for (const auto node : util::irange(1u, MAX_NUMA_REPLICAS))
+    {
+        const auto replica_region = GetReplicaRegion(data_region, node);
+        if (SharedMemory::RegionExists(replica_region) && !SharedMemory::Remove(replica_region))
+        {
+            util::SimpleLogger().Write(logWARNING) << "could not delete NUMA replica " << node;
+        }
+    }
+}
+
+namespace
+{
+// upper bound of the file range mapped at a time, mlockall makes every mapping resident
+const constexpr std::uint64_t MAX_FILE_WINDOW_SIZE = 64 * 1024 * 1024;
+
+// Maps [offset, offset + size) of a file window by window and hands each window to the callback.
+// Windows end on multiples of record_size so that no record straddles two windows.
+template <typename Callback>
+void ForEachFileWindow(const boost::filesystem::path &path,
+                       const std::uint64_t offset,
+                       const std::uint64_t size,
+                       const std::uint64_t record_size,
+                       Callback callback)
+{
+    if (size == 0)
+        return;
+    const auto window_size =
+        std::max<std::uint64_t>(1, MAX_FILE_WINDOW_SIZE / record_size) * record_size;
+
+    // compressed intermediates are decompressed in parallel frames instead of being mapped
+    if (util::IsCompressedFile(path))
+    {
+        util::IntermediateInputFile stream(path);
+        stream.seekg(offset);
+        std::vector<char> window(std::min(window_size, size));
+        for (std::uint64_t window_offset = 0; window_offset < size; window_offset += window_size)
+        {
+            const auto current_size = std::min(window_size, size - window_offset);
+            stream.read(window.data(), current_size);
+            if (!stream)
+                throw util::exception(path.string() +
+                                      " is truncated, run the preprocessing again");
+            callback(window.data(), current_size);
+        }
+        return;
+    }
+
+    if (boost::filesystem::file_size(path) < offset + size)
+        throw util::exception(path.string() + " is truncated, run the preprocessing again");
+
+    const boost::interprocess::file_mapping mapping(path.string().c_str(),
+                                                    boost::interprocess::read_only);
+    for (std::uint64_t window_offset = 0; window_offset < size; window_offset += window_size)
+    {
+        const auto current_size = std::min(window_size, size - window_offset);
+        const boost::interprocess::mapped_region region(
+            mapping, boost::interprocess::read_only, offset + window_offset, current_size);
+        callback(static_cast<const char *>(region.get_address()), current_size);
+    }
+}
+
+// Copies [offset, offset + size) of a file into a block of the shared memory region
+void CopyFileRange(const boost::filesystem::path &path,
+                   const std::uint64_t offset,
+                   const std::uint64_t size,
+                   char *destination)
+{
+    ForEachFileWindow(
+        path, offset, size, 1, [&](const char *window, const std::uint64_t window_size) {
+            std::memcpy(destination, window, window_size);
+            destination += window_size;
+        });
+}
+
+// Fills the blocks of one input file, returns the number of bytes read
+struct LoadTask
+{
+    std::string name;
+    std::function<std::uint64_t()> load;
+};
+
+double GetMegabytesPerSecond(const std::uint64_t bytes, const double seconds)
+{
+    return seconds > 0 ? bytes / (1024. * 1024.) / seconds : 0.;
+}
+
+// The input files are independent of each other, so they are read concurrently to keep several
+// requests in flight on the disk
+void RunLoadTasks(const std::vector<LoadTask> &tasks)
+{
+    std::atomic<std::uint64_t> total_bytes{0};
+    TIMER_START(load);
+    tbb::parallel_for_each(tasks.begin(), tasks.end(), [&](const LoadTask &task) {
+        TIMER_START(block);
+        const auto bytes = task.load();
+        TIMER_STOP(block);
+        total_bytes += bytes;
+        if (bytes > 0)
+        {
+            util::SimpleLogger().Write()
+                << "loaded " << task.name << ": " << bytes << " bytes in " << TIMER_MSEC(block)
+                << "ms (" << GetMegabytesPerSecond(bytes, TIMER_SEC(block)) << " MB/s)";
+        }
+    });
+    TIMER_STOP(load);
+    util::SimpleLogger().Write() << "loaded " << total_bytes << " bytes in " << TIMER_SEC(load)
+                                 << "s (" << GetMegabytesPerSecond(total_bytes, TIMER_SEC(load))
+                                 << " MB/s)";
+}
+
+// Copies the data region into a replica bound to each further NUMA node. Returns the number of
+// nodes holding the dataset afterwards.
+unsigned ReplicateDataRegion(const SharedDataType data_region,
+                             const char *data,
+                             const std::uint64_t size,
+                             const unsigned number_of_nodes)
+{
+    const auto number_of_replicas = std::min(number_of_nodes, MAX_NUMA_REPLICAS);
+    for (const auto node : util::irange(1u, number_of_replicas))
+    {
+        TIMER_START(replicate);
+        auto *replica_memory = makeSharedMemory(GetReplicaRegion(data_region, node), size);
+        auto *replica = static_cast<char *>(replica_memory->Ptr());
+        if (!util::numa::BindMemory(replica, size, node))
+        {
+            util::SimpleLogger().Write(logWARNING) << "Could not bind the replica to NUMA node "
+                                                   << node;
+        }
+        tbb::parallel_for(tbb::blocked_range<std::uint64_t>(0, size, MAX_FILE_WINDOW_SIZE),
+                          [&](const tbb::blocked_range<std::uint64_t> &range) {
+                              std::memcpy(replica + range.begin(),
+                                          data + range.begin(),
+                                          range.end() - range.begin());
+                          });
+        TIMER_STOP(replicate);
+        util::SimpleLogger().Write() << "replicated " << size << " bytes to NUMA node " << node
+                                     << " in " << TIMER_SEC(replicate) << "s";
+    }
+    return number_of_replicas;
+}
+}
+
 Storage::Storage(StorageConfig config_) : config(std::move(config_)) {}
 
 int Storage::Run()
@@ -86,9 +258,9 @@ int Storage::Run()
     SharedBarriers barrier;
 
 #ifdef __linux__
-    // try to disable swapping on Linux
+    // try to disable swapping on Linux, a dataset file is written through the page cache instead
     const bool lock_flags = MCL_CURRENT | MCL_FUTURE;
-    if (-1 == mlockall(lock_flags))
+    if (!config.write_dataset && -1 == mlockall(lock_flags))
     {
         util::SimpleLogger().Write(logWARNING) << "Could not request RAM lock";
     }
@@ -96,7 +268,7 @@ int Storage::Run()
 
     try
     {
-        boost::interprocess::scoped_lock<boost::interprocess::named_mutex> pending_lock(
+        boost::interprocess::scoped_lock<SharedBarriers::mutex_type> pending_lock(
             barrier.pending_update_mutex);
     }
     catch (...)
@@ -119,8 +291,13 @@ int Storage::Run()
     }();
 
     // Allocate a memory layout in shared memory, deallocate previous
-    auto *layout_memory = makeSharedMemory(layout_region, sizeof(SharedDataLayout));
-    auto shared_layout_ptr = new (layout_memory->Ptr()) SharedDataLayout();
+    SharedDataLayout dataset_layout;
+    SharedDataLayout *shared_layout_ptr = &dataset_layout;
+    if (!config.write_dataset)
+    {
+        auto *layout_memory = makeSharedMemory(layout_region, sizeof(SharedDataLayout));
+        shared_layout_ptr = new (layout_memory->Ptr()) SharedDataLayout();
+    }
     auto absolute_file_index_path = boost::filesystem::absolute(config.file_index_path);
 
     shared_layout_ptr->SetBlockSize<char>(SharedDataLayout::FILE_INDEX_PATH,
@@ -128,24 +305,21 @@ int Storage::Run()
 
     // collect number of elements to store in shared memory object
     util::SimpleLogger().Write() << "load names from: " << config.names_data_path;
-    // number of entries in name index
-    boost::filesystem::ifstream name_stream(config.names_data_path, std::ios::binary);
-    if (!name_stream)
+    // the strings are interned while loading, so their sizes are only known afterwards
+    std::vector<std::uint32_t> name_offsets;
+    std::vector<std::uint8_t> name_lengths;
+    std::vector<char> name_chars;
+    if (!config.weights_only)
     {
-        throw util::exception("Could not open " + config.names_data_path.string() +
-                              " for reading.");
+        util::ReadInternedNames(
+            config.names_data_path.string(), name_offsets, name_lengths, name_chars);
     }
-    unsigned name_blocks = 0;
-    name_stream.read((char *)&name_blocks, sizeof(unsigned));
-    shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::NAME_OFFSETS, name_blocks);
-    shared_layout_ptr->SetBlockSize<typename util::RangeTable<16, true>::BlockT>(
-        SharedDataLayout::NAME_BLOCKS, name_blocks);
-    util::SimpleLogger().Write() << "name offsets size: " << name_blocks;
-    BOOST_ASSERT_MSG(0 != name_blocks, "name file broken");
-
-    unsigned number_of_chars = 0;
-    name_stream.read((char *)&number_of_chars, sizeof(unsigned));
-    shared_layout_ptr->SetBlockSize<char>(SharedDataLayout::NAME_CHAR_LIST, number_of_chars);
+    shared_layout_ptr->SetBlockSize<std::uint32_t>(SharedDataLayout::NAME_OFFSETS,
+                                                   name_offsets.size());
+    shared_layout_ptr->SetBlockSize<std::uint8_t>(SharedDataLayout::NAME_LENGTHS,
+                                                  name_lengths.size());
+    shared_layout_ptr->SetBlockSize<char>(SharedDataLayout::NAME_CHAR_LIST, name_chars.size());
+    util::SimpleLogger().Write() << "name offsets size: " << name_offsets.size();
 
     std::vector<std::uint32_t> lane_description_offsets;
     std::vector<extractor::guidance::TurnLaneType::Mask> lane_description_masks;
@@ -160,7 +334,7 @@ int Storage::Run()
         SharedDataLayout::LANE_DESCRIPTION_MASKS, lane_description_masks.size());
 
     // Loading information for original edges
-    boost::filesystem::ifstream edges_input_stream(config.edges_data_path, std::ios::binary);
+    util::IntermediateInputFile edges_input_stream(config.edges_data_path);
     if (!edges_input_stream)
     {
         throw util::exception("Could not open " + config.edges_data_path.string() +
@@ -168,14 +342,16 @@ int Storage::Run()
     }
     unsigned number_of_original_edges = 0;
     edges_input_stream.read((char *)&number_of_original_edges, sizeof(unsigned));
+    const std::uint64_t original_edges_file_offset = edges_input_stream.tellg();
 
     // note: settings this all to the same size is correct, we extract them from the same struct
     shared_layout_ptr->SetBlockSize<NodeID>(SharedDataLayout::VIA_NODE_LIST,
                                             number_of_original_edges);
     shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::NAME_ID_LIST,
                                               number_of_original_edges);
-    shared_layout_ptr->SetBlockSize<extractor::TravelMode>(SharedDataLayout::TRAVEL_MODE,
-                                                           number_of_original_edges);
+    shared_layout_ptr->SetBlockSize<std::uint64_t>(
+        SharedDataLayout::TRAVEL_MODE,
+        PackedTravelModes::elements_to_blocks(number_of_original_edges));
     shared_layout_ptr->SetBlockSize<extractor::guidance::TurnInstruction>(
         SharedDataLayout::TURN_INSTRUCTION, number_of_original_edges);
     shared_layout_ptr->SetBlockSize<LaneDataID>(SharedDataLayout::LANE_DATA_ID,
@@ -220,13 +396,41 @@ int Storage::Run()
     // BOOST_ASSERT_MSG(0 != number_of_graph_edges, "number of graph edges is zero");
     shared_layout_ptr->SetBlockSize<QueryGraph::EdgeArrayEntry>(SharedDataLayout::GRAPH_EDGE_LIST,
                                                                 number_of_graph_edges);
+    const std::uint64_t graph_nodes_file_offset = hsgr_input_stream.tellg();
+    hsgr_input_stream.close();
 
     // load rsearch tree size
     boost::filesystem::ifstream tree_node_file(config.ram_index_path, std::ios::binary);
 
     uint32_t tree_size = 0;
     tree_node_file.read((char *)&tree_size, sizeof(uint32_t));
+    if (boost::filesystem::file_size(config.ram_index_path) !=
+        sizeof(uint32_t) + sizeof(RTreeNode) * std::uint64_t{tree_size})
+    {
+        throw util::exception("ram index file has an unexpected size, it was probably created "
+                              "by an older version. Please run osrm-extract again.");
+    }
     shared_layout_ptr->SetBlockSize<RTreeNode>(SharedDataLayout::R_SEARCH_TREE, tree_size);
+    const std::uint64_t tree_nodes_file_offset = tree_node_file.tellg();
+    tree_node_file.close();
+
+    // load rsearch tree leaves size, leaves stay in .fileIndex unless requested otherwise or the
+    // data goes to a dataset, which needs to be self-contained
+    std::uint64_t leaves_size = 0;
+    if (config.share_rtree_leaves || config.write_dataset)
+    {
+        boost::filesystem::ifstream leaf_node_file(config.file_index_path, std::ios::binary);
+        if (!leaf_node_file)
+        {
+            throw util::exception("Could not open " + config.file_index_path.string() +
+                                  " for reading.");
+        }
+        leaves_size = boost::filesystem::file_size(config.file_index_path);
+    }
+    // leaves need page alignment, reserve slack to round up the block start
+    shared_layout_ptr->SetBlockSize<char>(SharedDataLayout::R_SEARCH_TREE_LEAVES,
+                                          leaves_size > 0 ? leaves_size + sizeof(RTreeLeafNode) - 1
+                                                          : 0);
 
     // load profile properties
     shared_layout_ptr->SetBlockSize<extractor::ProfileProperties>(SharedDataLayout::PROPERTIES, 1);
@@ -248,25 +452,51 @@ int Storage::Run()
     core_marker_file.read((char *)&number_of_core_markers, sizeof(uint32_t));
     shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::CORE_MARKER,
                                               number_of_core_markers);
+    const std::uint64_t core_markers_file_offset = core_marker_file.tellg();
+    core_marker_file.close();
 
     // load coordinate size
-    boost::filesystem::ifstream nodes_input_stream(config.nodes_data_path, std::ios::binary);
+    util::IntermediateInputFile nodes_input_stream(config.nodes_data_path);
     if (!nodes_input_stream)
     {
         throw util::exception("Could not open " + config.core_data_path.string() + " for reading.");
     }
     unsigned coordinate_list_size = 0;
     nodes_input_stream.read((char *)&coordinate_list_size, sizeof(unsigned));
-    shared_layout_ptr->SetBlockSize<util::Coordinate>(SharedDataLayout::COORDINATE_LIST,
-                                                      coordinate_list_size);
+    const std::uint64_t nodes_file_offset = nodes_input_stream.tellg();
+    // like the geometries, the compressed form is only known after encoding all coordinates
+    std::vector<EncodedCoordinates::Block> coordinate_blocks;
+    std::vector<std::uint64_t> coordinate_words;
+    if (config.compress_coordinates)
+    {
+        std::vector<extractor::QueryNode> nodes(coordinate_list_size);
+        nodes_input_stream.read((char *)nodes.data(),
+                                coordinate_list_size * sizeof(extractor::QueryNode));
+        if (!nodes_input_stream)
+        {
+            throw util::exception("Could not read " + config.nodes_data_path.string());
+        }
+        EncodedCoordinates::Encode(nodes, coordinate_blocks, coordinate_words);
+        util::SimpleLogger().Write()
+            << "Compressed " << coordinate_list_size << " coordinates to "
+            << sizeof(EncodedCoordinates::Block) * coordinate_blocks.size() +
+                   sizeof(std::uint64_t) * coordinate_words.size()
+            << " bytes";
+    }
+    shared_layout_ptr->SetBlockSize<util::Coordinate>(
+        SharedDataLayout::COORDINATE_LIST, config.compress_coordinates ? 0 : coordinate_list_size);
+    shared_layout_ptr->SetBlockSize<EncodedCoordinates::Block>(
+        SharedDataLayout::COORDINATE_BLOCKS, coordinate_blocks.size());
+    shared_layout_ptr->SetBlockSize<std::uint64_t>(SharedDataLayout::COORDINATE_WORDS,
+                                                   coordinate_words.size());
     // we'll read a list of OSM node IDs from the same data, so set the block size for the same
     // number of items:
     shared_layout_ptr->SetBlockSize<std::uint64_t>(
         SharedDataLayout::OSM_NODE_ID_LIST,
-        util::PackedVector<OSMNodeID>::elements_to_blocks(coordinate_list_size));
+        util::PackedOSMNodeIDs<>::elements_to_blocks(coordinate_list_size));
 
     // load geometries sizes
-    boost::filesystem::ifstream geometry_input_stream(config.geometries_path, std::ios::binary);
+    util::IntermediateInputFile geometry_input_stream(config.geometries_path);
     if (!geometry_input_stream)
     {
         throw util::exception("Could not open " + config.geometries_path.string() +
@@ -276,13 +506,48 @@ int Storage::Run()
     unsigned number_of_compressed_geometries = 0;
 
     geometry_input_stream.read((char *)&number_of_geometries_indices, sizeof(unsigned));
+    const std::uint64_t geometries_index_file_offset = geometry_input_stream.tellg();
     shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::GEOMETRIES_INDEX,
                                               number_of_geometries_indices);
     boost::iostreams::seek(
         geometry_input_stream, number_of_geometries_indices * sizeof(unsigned), BOOST_IOS::cur);
     geometry_input_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
+    const std::uint64_t geometries_list_file_offset = geometry_input_stream.tellg();
+
+    // the compressed form is only known after encoding all of the geometries
+    std::vector<std::uint64_t> geometries_block_offsets;
+    std::vector<unsigned char> geometries_encoded;
+    if (config.compress_geometries)
+    {
+        std::vector<unsigned> geometries_index(number_of_geometries_indices);
+        std::vector<extractor::CompressedEdgeContainer::CompressedEdge> geometries_list(
+            number_of_compressed_geometries);
+        geometry_input_stream.seekg(geometries_index_file_offset);
+        geometry_input_stream.read((char *)geometries_index.data(),
+                                   number_of_geometries_indices * sizeof(unsigned));
+        geometry_input_stream.seekg(geometries_list_file_offset);
+        geometry_input_stream.read(
+            (char *)geometries_list.data(),
+            number_of_compressed_geometries *
+                sizeof(extractor::CompressedEdgeContainer::CompressedEdge));
+        if (!geometry_input_stream)
+        {
+            throw util::exception("Could not read " + config.geometries_path.string());
+        }
+        util::DeltaEncodedGeometries<true>::Encode(
+            geometries_index, geometries_list, geometries_block_offsets, geometries_encoded);
+        util::SimpleLogger().Write()
+            << "Compressed " << number_of_compressed_geometries << " geometry segments to "
+            << geometries_encoded.size() + sizeof(std::uint64_t) * geometries_block_offsets.size()
+            << " bytes";
+    }
     shared_layout_ptr->SetBlockSize<extractor::CompressedEdgeContainer::CompressedEdge>(
-        SharedDataLayout::GEOMETRIES_LIST, number_of_compressed_geometries);
+        SharedDataLayout::GEOMETRIES_LIST,
+        config.compress_geometries ? 0 : number_of_compressed_geometries);
+    shared_layout_ptr->SetBlockSize<std::uint64_t>(SharedDataLayout::GEOMETRIES_BLOCK_OFFSETS,
+                                                   geometries_block_offsets.size());
+    shared_layout_ptr->SetBlockSize<unsigned char>(SharedDataLayout::GEOMETRIES_ENCODED,
+                                                   geometries_encoded.size());
 
     // load datasource sizes.  This file is optional, and it's non-fatal if it doesn't
     // exist.
@@ -299,6 +564,8 @@ int Storage::Run()
         geometry_datasource_input_stream.read(
             reinterpret_cast<char *>(&number_of_compressed_datasources), sizeof(std::size_t));
     }
+    const std::uint64_t datasources_file_offset = sizeof(std::size_t);
+    geometry_datasource_input_stream.close();
     shared_layout_ptr->SetBlockSize<uint8_t>(SharedDataLayout::DATASOURCES_LIST,
                                              number_of_compressed_datasources);
 
@@ -387,6 +654,8 @@ int Storage::Run()
     boost::filesystem::ifstream lane_data_stream(config.turn_lane_data_path, std::ios::binary);
     std::uint64_t lane_tupel_count = 0;
     lane_data_stream.read(reinterpret_cast<char *>(&lane_tupel_count), sizeof(lane_tupel_count));
+    const std::uint64_t lane_data_file_offset = sizeof(lane_tupel_count);
+    lane_data_stream.close();
     shared_layout_ptr->SetBlockSize<util::guidance::LaneTupelIdPair>(
         SharedDataLayout::TURN_LANE_DATA, lane_tupel_count);
 
@@ -402,11 +671,178 @@ int Storage::Run()
     shared_layout_ptr->SetBlockSize<util::guidance::EntryClass>(SharedDataLayout::ENTRY_CLASS,
                                                                 entry_class_table.size());
 
-    // allocate shared memory block
-    util::SimpleLogger().Write() << "allocating shared memory of "
-                                 << shared_layout_ptr->GetSizeOfLayout() << " bytes";
-    auto *shared_memory = makeSharedMemory(data_region, shared_layout_ptr->GetSizeOfLayout());
-    char *shared_memory_ptr = static_cast<char *>(shared_memory->Ptr());
+    // distance tables neither need the data of the responses nor guidance, the original edges and
+    // the OSM node ids are not even read then
+    if (config.weights_only)
+    {
+        for (const auto block : {SharedDataLayout::LANE_DESCRIPTION_OFFSETS,
+                                 SharedDataLayout::LANE_DESCRIPTION_MASKS,
+                                 SharedDataLayout::VIA_NODE_LIST,
+                                 SharedDataLayout::NAME_ID_LIST,
+                                 SharedDataLayout::TRAVEL_MODE,
+                                 SharedDataLayout::TURN_INSTRUCTION,
+                                 SharedDataLayout::LANE_DATA_ID,
+                                 SharedDataLayout::ENTRY_CLASSID,
+                                 SharedDataLayout::OSM_NODE_ID_LIST,
+                                 SharedDataLayout::DATASOURCES_LIST,
+                                 SharedDataLayout::DATASOURCE_NAME_DATA,
+                                 SharedDataLayout::DATASOURCE_NAME_OFFSETS,
+                                 SharedDataLayout::DATASOURCE_NAME_LENGTHS,
+                                 SharedDataLayout::BEARING_CLASSID,
+                                 SharedDataLayout::BEARING_OFFSETS,
+                                 SharedDataLayout::BEARING_BLOCKS,
+                                 SharedDataLayout::BEARING_VALUES,
+                                 SharedDataLayout::TURN_LANE_DATA,
+                                 SharedDataLayout::ENTRY_CLASS})
+        {
+            shared_layout_ptr->num_entries[block] = 0;
+        }
+        lane_description_offsets.clear();
+        lane_description_masks.clear();
+        number_of_compressed_datasources = 0;
+        m_datasource_name_data.clear();
+        m_datasource_name_offsets.clear();
+        m_datasource_name_lengths.clear();
+        bearing_class_id_table.clear();
+        bearing_offsets_data.clear();
+        bearing_blocks_data.clear();
+        bearing_class_table.clear();
+        lane_tupel_count = 0;
+        entry_class_table.clear();
+    }
+
+    // load time slot sizes, the file only exists if osrm-contract --time-slot-speed-file or
+    // --metric-speed-file wrote it
+    contractor::TimeSlotsHeader time_slots_header{0, 0, 0, 0, 0, 0};
+    if (boost::filesystem::exists(config.time_slots_path))
+    {
+        boost::filesystem::ifstream time_slots_stream(config.time_slots_path, std::ios::binary);
+        time_slots_stream.read(reinterpret_cast<char *>(&time_slots_header),
+                               sizeof(contractor::TimeSlotsHeader));
+        if (!time_slots_stream)
+            throw util::exception("Could not read " + config.time_slots_path.string());
+        if (time_slots_header.number_of_edges != number_of_graph_edges ||
+            time_slots_header.number_of_geometry_segments != number_of_compressed_geometries)
+            throw util::exception(config.time_slots_path.string() +
+                                  " does not match the graph, run osrm-contract again");
+    }
+    shared_layout_ptr->SetBlockSize<contractor::TimeSlotsHeader>(
+        SharedDataLayout::TIME_SLOTS, time_slots_header.GetNumberOfOverlays() > 0 ? 1 : 0);
+    shared_layout_ptr->SetBlockSize<QueryGraph::EdgeData>(
+        SharedDataLayout::TIME_SLOT_EDGE_DATA,
+        time_slots_header.GetNumberOfOverlays() * time_slots_header.number_of_edges);
+    // segment weights that all fit into 16 bits are stored as such
+    const bool narrow_segment_weights =
+        time_slots_header.segment_weight_bytes == sizeof(std::uint16_t);
+    const auto number_of_time_slot_segment_weights =
+        time_slots_header.GetNumberOfOverlays() * time_slots_header.number_of_geometry_segments;
+    if (narrow_segment_weights)
+    {
+        shared_layout_ptr->SetBlockSize<std::uint16_t>(
+            SharedDataLayout::TIME_SLOT_GEOMETRY_WEIGHTS, number_of_time_slot_segment_weights);
+    }
+    else
+    {
+        shared_layout_ptr->SetBlockSize<EdgeWeight>(SharedDataLayout::TIME_SLOT_GEOMETRY_WEIGHTS,
+                                                    number_of_time_slot_segment_weights);
+    }
+
+    // load edge length size, datasets of older osrm-contract versions do not have them
+    std::uint64_t number_of_edge_lengths = 0;
+    if (boost::filesystem::exists(config.edge_lengths_path))
+    {
+        boost::filesystem::ifstream edge_lengths_stream(config.edge_lengths_path,
+                                                        std::ios::binary);
+        edge_lengths_stream.read(reinterpret_cast<char *>(&number_of_edge_lengths),
+                                 sizeof(std::uint64_t));
+        if (!edge_lengths_stream)
+            throw util::exception("Could not read " + config.edge_lengths_path.string());
+        if (number_of_edge_lengths != number_of_graph_edges)
+            throw util::exception(config.edge_lengths_path.string() +
+                                  " does not match the graph, run osrm-contract again");
+    }
+    shared_layout_ptr->SetBlockSize<EdgeLength>(SharedDataLayout::EDGE_LENGTHS,
+                                                number_of_edge_lengths);
+
+    // load the number of via way copies, datasets of older osrm-extract versions do not have them
+    std::uint64_t number_of_duplicated_nodes = 0;
+    if (boost::filesystem::exists(config.duplicated_nodes_path))
+    {
+        boost::filesystem::ifstream duplicated_nodes_stream(config.duplicated_nodes_path,
+                                                            std::ios::binary);
+        if (!util::readAndCheckFingerprint(duplicated_nodes_stream))
+            throw util::exception("Fingerprint of " + config.duplicated_nodes_path.string() +
+                                  " does not match or could not read from file");
+        duplicated_nodes_stream.read(reinterpret_cast<char *>(&number_of_duplicated_nodes),
+                                     sizeof(std::uint64_t));
+        if (!duplicated_nodes_stream)
+            throw util::exception("Could not read " + config.duplicated_nodes_path.string());
+    }
+    shared_layout_ptr->SetBlockSize<extractor::DuplicatedNode>(SharedDataLayout::DUPLICATED_NODES,
+                                                               number_of_duplicated_nodes);
+
+    // load core landmark size, the file only exists if osrm-contract --core-landmarks wrote it
+    std::uint64_t number_of_core_landmark_distances = 0;
+    if (boost::filesystem::exists(config.core_landmarks_path))
+    {
+        boost::filesystem::ifstream core_landmarks_stream(config.core_landmarks_path,
+                                                          std::ios::binary);
+        core_landmarks_stream.read(reinterpret_cast<char *>(&number_of_core_landmark_distances),
+                                   sizeof(std::uint64_t));
+        if (!core_landmarks_stream)
+            throw util::exception("Could not read " + config.core_landmarks_path.string());
+    }
+    shared_layout_ptr->SetBlockSize<EdgeWeight>(SharedDataLayout::CORE_LANDMARK_DISTANCES,
+                                                number_of_core_landmark_distances);
+
+    std::unique_ptr<DatasetWriter> dataset_writer;
+    char *shared_memory_ptr = nullptr;
+    if (config.write_dataset)
+    {
+        util::SimpleLogger().Write() << "writing " << shared_layout_ptr->GetSizeOfLayout()
+                                     << " bytes to " << config.dataset_path.string();
+        dataset_writer = util::make_unique<DatasetWriter>(config.dataset_path, *shared_layout_ptr);
+        shared_memory_ptr = dataset_writer->GetData();
+    }
+    else
+    {
+        // allocate shared memory block
+        util::SimpleLogger().Write() << "allocating shared memory of "
+                                     << shared_layout_ptr->GetSizeOfLayout() << " bytes";
+        auto *shared_memory = makeSharedMemory(data_region, shared_layout_ptr->GetSizeOfLayout());
+        shared_memory_ptr = static_cast<char *>(shared_memory->Ptr());
+    }
+
+    const auto number_of_numa_nodes = util::numa::GetNumberOfNodes();
+    if (!config.write_dataset && number_of_numa_nodes > 1)
+    {
+        // must happen before the pages are copied in, mlockall has them resident already
+        if (config.interleave_numa_nodes &&
+            !util::numa::InterleaveMemory(
+                shared_memory_ptr, shared_layout_ptr->GetSizeOfLayout(), number_of_numa_nodes))
+        {
+            util::SimpleLogger().Write(logWARNING) << "Could not interleave the NUMA nodes";
+        }
+        if (config.replicate_numa_nodes &&
+            !util::numa::BindMemory(shared_memory_ptr, shared_layout_ptr->GetSizeOfLayout(), 0))
+        {
+            util::SimpleLogger().Write(logWARNING) << "Could not bind the data to NUMA node 0";
+        }
+    }
+
+    if (config.use_huge_pages && !config.write_dataset)
+    {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        // needs shmem_enabled=advise in /sys/kernel/mm/transparent_hugepage, pages populated
+        // already by the locked address space are collapsed by khugepaged later on
+        if (-1 == madvise(shared_memory_ptr, shared_layout_ptr->GetSizeOfLayout(), MADV_HUGEPAGE))
+        {
+            util::SimpleLogger().Write(logWARNING) << "Could not request huge pages";
+        }
+#else
+        util::SimpleLogger().Write(logWARNING) << "Huge pages are not supported on this platform";
+#endif
+    }
 
     // read actual data into shared memory object //
 
@@ -427,49 +863,377 @@ int Storage::Run()
               absolute_file_index_path.string().end(),
               file_index_path_ptr);
 
-    // Loading street names
-    unsigned *name_offsets_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+    // make sure do write canary for every block before the blocks are loaded concurrently
+    std::uint32_t *name_offsets_ptr = shared_layout_ptr->GetBlockPtr<std::uint32_t, true>(
         shared_memory_ptr, SharedDataLayout::NAME_OFFSETS);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_OFFSETS) > 0)
-    {
-        name_stream.read((char *)name_offsets_ptr,
-                         shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_OFFSETS));
-    }
-
-    unsigned *name_blocks_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::NAME_BLOCKS);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_BLOCKS) > 0)
-    {
-        name_stream.read((char *)name_blocks_ptr,
-                         shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_BLOCKS));
-    }
-
+    std::uint8_t *name_lengths_ptr = shared_layout_ptr->GetBlockPtr<std::uint8_t, true>(
+        shared_memory_ptr, SharedDataLayout::NAME_LENGTHS);
     char *name_char_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
         shared_memory_ptr, SharedDataLayout::NAME_CHAR_LIST);
-    unsigned temp_length = 0;
-    name_stream.read((char *)&temp_length, sizeof(unsigned));
-
-    BOOST_ASSERT_MSG(shared_layout_ptr->AlignBlockSize(temp_length) ==
-                         shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST),
-                     "Name file corrupted!");
-
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST) > 0)
-    {
-        name_stream.read(name_char_ptr,
-                         shared_layout_ptr->GetBlockSize(SharedDataLayout::NAME_CHAR_LIST));
-    }
-    name_stream.close();
-
-    // make sure do write canary...
     auto *turn_lane_data_ptr =
         shared_layout_ptr->GetBlockPtr<util::guidance::LaneTupelIdPair, true>(
             shared_memory_ptr, SharedDataLayout::TURN_LANE_DATA);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::TURN_LANE_DATA) > 0)
+    NodeID *via_node_ptr = shared_layout_ptr->GetBlockPtr<NodeID, true>(
+        shared_memory_ptr, SharedDataLayout::VIA_NODE_LIST);
+    unsigned *name_id_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+        shared_memory_ptr, SharedDataLayout::NAME_ID_LIST);
+    std::uint64_t *travel_mode_ptr = shared_layout_ptr->GetBlockPtr<std::uint64_t, true>(
+        shared_memory_ptr, SharedDataLayout::TRAVEL_MODE);
+    LaneDataID *lane_data_id_ptr = shared_layout_ptr->GetBlockPtr<LaneDataID, true>(
+        shared_memory_ptr, SharedDataLayout::LANE_DATA_ID);
+    extractor::guidance::TurnInstruction *turn_instructions_ptr =
+        shared_layout_ptr->GetBlockPtr<extractor::guidance::TurnInstruction, true>(
+            shared_memory_ptr, SharedDataLayout::TURN_INSTRUCTION);
+    EntryClassID *entry_class_id_ptr = shared_layout_ptr->GetBlockPtr<EntryClassID, true>(
+        shared_memory_ptr, SharedDataLayout::ENTRY_CLASSID);
+    unsigned *geometries_index_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+        shared_memory_ptr, SharedDataLayout::GEOMETRIES_INDEX);
+    extractor::CompressedEdgeContainer::CompressedEdge *geometries_list_ptr =
+        shared_layout_ptr->GetBlockPtr<extractor::CompressedEdgeContainer::CompressedEdge, true>(
+            shared_memory_ptr, SharedDataLayout::GEOMETRIES_LIST);
+    std::uint64_t *geometries_block_offsets_ptr =
+        shared_layout_ptr->GetBlockPtr<std::uint64_t, true>(
+            shared_memory_ptr, SharedDataLayout::GEOMETRIES_BLOCK_OFFSETS);
+    unsigned char *geometries_encoded_ptr = shared_layout_ptr->GetBlockPtr<unsigned char, true>(
+        shared_memory_ptr, SharedDataLayout::GEOMETRIES_ENCODED);
+    uint8_t *datasources_list_ptr = shared_layout_ptr->GetBlockPtr<uint8_t, true>(
+        shared_memory_ptr, SharedDataLayout::DATASOURCES_LIST);
+    util::Coordinate *coordinates_ptr = shared_layout_ptr->GetBlockPtr<util::Coordinate, true>(
+        shared_memory_ptr, SharedDataLayout::COORDINATE_LIST);
+    auto coordinate_blocks_ptr = shared_layout_ptr->GetBlockPtr<EncodedCoordinates::Block, true>(
+        shared_memory_ptr, SharedDataLayout::COORDINATE_BLOCKS);
+    auto coordinate_words_ptr = shared_layout_ptr->GetBlockPtr<std::uint64_t, true>(
+        shared_memory_ptr, SharedDataLayout::COORDINATE_WORDS);
+    std::uint64_t *osmnodeid_ptr = shared_layout_ptr->GetBlockPtr<std::uint64_t, true>(
+        shared_memory_ptr, SharedDataLayout::OSM_NODE_ID_LIST);
+    char *rtree_ptr = shared_layout_ptr->GetBlockPtr<char, true>(shared_memory_ptr,
+                                                                 SharedDataLayout::R_SEARCH_TREE);
+    char *rtree_leaves_ptr = shared_layout_ptr->GetAlignedBlockPtr<char, true>(
+        shared_memory_ptr, SharedDataLayout::R_SEARCH_TREE_LEAVES, sizeof(RTreeLeafNode));
+    unsigned *core_marker_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+        shared_memory_ptr, SharedDataLayout::CORE_MARKER);
+    QueryGraph::NodeArrayEntry *graph_node_list_ptr =
+        shared_layout_ptr->GetBlockPtr<QueryGraph::NodeArrayEntry, true>(
+            shared_memory_ptr, SharedDataLayout::GRAPH_NODE_LIST);
+    QueryGraph::EdgeArrayEntry *graph_edge_list_ptr =
+        shared_layout_ptr->GetBlockPtr<QueryGraph::EdgeArrayEntry, true>(
+            shared_memory_ptr, SharedDataLayout::GRAPH_EDGE_LIST);
+    auto time_slots_ptr = shared_layout_ptr->GetBlockPtr<contractor::TimeSlotsHeader, true>(
+        shared_memory_ptr, SharedDataLayout::TIME_SLOTS);
+    auto time_slot_edge_data_ptr = shared_layout_ptr->GetBlockPtr<QueryGraph::EdgeData, true>(
+        shared_memory_ptr, SharedDataLayout::TIME_SLOT_EDGE_DATA);
+    auto time_slot_segment_weights_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
+        shared_memory_ptr, SharedDataLayout::TIME_SLOT_GEOMETRY_WEIGHTS);
+    auto edge_lengths_ptr = shared_layout_ptr->GetBlockPtr<EdgeLength, true>(
+        shared_memory_ptr, SharedDataLayout::EDGE_LENGTHS);
+    auto duplicated_nodes_ptr = shared_layout_ptr->GetBlockPtr<extractor::DuplicatedNode, true>(
+        shared_memory_ptr, SharedDataLayout::DUPLICATED_NODES);
+    auto core_landmark_distances_ptr = shared_layout_ptr->GetBlockPtr<EdgeWeight, true>(
+        shared_memory_ptr, SharedDataLayout::CORE_LANDMARK_DISTANCES);
+
+    // Every task fills its own blocks from its own file, the tasks run concurrently
+    std::vector<LoadTask> load_tasks;
+
+    // Loading street names
+    load_tasks.push_back({"names", [&] {
+                              std::copy(
+                                  name_offsets.begin(), name_offsets.end(), name_offsets_ptr);
+                              std::copy(
+                                  name_lengths.begin(), name_lengths.end(), name_lengths_ptr);
+                              std::copy(name_chars.begin(), name_chars.end(), name_char_ptr);
+                              return name_offsets.size() * sizeof(std::uint32_t) +
+                                     name_lengths.size() + name_chars.size();
+                          }});
+
+    load_tasks.push_back({"turn lane data", [&] {
+                              const auto size =
+                                  lane_tupel_count * sizeof(util::guidance::LaneTupelIdPair);
+                              CopyFileRange(config.turn_lane_data_path,
+                                            lane_data_file_offset,
+                                            size,
+                                            reinterpret_cast<char *>(turn_lane_data_ptr));
+                              return size;
+                          }});
+
+    // load original edge information
+    load_tasks.push_back({"original edges", [&]() -> std::uint64_t {
+                              if (config.weights_only)
+                              {
+                                  return 0;
+                              }
+                              const auto size =
+                                  number_of_original_edges * sizeof(extractor::OriginalEdgeData);
+                              PackedTravelModes travel_modes;
+                              travel_modes.reset(
+                                  travel_mode_ptr,
+                                  shared_layout_ptr
+                                      ->num_entries[storage::SharedDataLayout::TRAVEL_MODE]);
+                              std::size_t index = 0;
+                              ForEachFileWindow(
+                                  config.edges_data_path,
+                                  original_edges_file_offset,
+                                  size,
+                                  sizeof(extractor::OriginalEdgeData),
+                                  [&](const char *window, const std::uint64_t window_size) {
+                                      extractor::OriginalEdgeData current_edge_data;
+                                      for (const char *record = window;
+                                           record < window + window_size;
+                                           record += sizeof(extractor::OriginalEdgeData), ++index)
+                                      {
+                                          std::memcpy(&current_edge_data,
+                                                      record,
+                                                      sizeof(extractor::OriginalEdgeData));
+                                          via_node_ptr[index] = current_edge_data.via_node;
+                                          name_id_ptr[index] = current_edge_data.name_id;
+                                          BOOST_ASSERT(current_edge_data.travel_mode <
+                                                       (1u << TRAVEL_MODE_BITS));
+                                          travel_modes.push_back(current_edge_data.travel_mode);
+                                          lane_data_id_ptr[index] = current_edge_data.lane_data_id;
+                                          turn_instructions_ptr[index] =
+                                              current_edge_data.turn_instruction;
+                                          entry_class_id_ptr[index] =
+                                              current_edge_data.entry_classid;
+                                      }
+                                  });
+                              return size;
+                          }});
+
+    // load compressed geometry
+    load_tasks.push_back({"geometries", [&] {
+                              const auto index_size =
+                                  number_of_geometries_indices * sizeof(unsigned);
+                              const auto list_size =
+                                  number_of_compressed_geometries *
+                                  sizeof(extractor::CompressedEdgeContainer::CompressedEdge);
+                              CopyFileRange(config.geometries_path,
+                                            geometries_index_file_offset,
+                                            index_size,
+                                            reinterpret_cast<char *>(geometries_index_ptr));
+                              if (config.compress_geometries)
+                              {
+                                  std::copy(geometries_block_offsets.begin(),
+                                            geometries_block_offsets.end(),
+                                            geometries_block_offsets_ptr);
+                                  std::copy(geometries_encoded.begin(),
+                                            geometries_encoded.end(),
+                                            geometries_encoded_ptr);
+                                  return index_size +
+                                         sizeof(std::uint64_t) * geometries_block_offsets.size() +
+                                         geometries_encoded.size();
+                              }
+                              CopyFileRange(config.geometries_path,
+                                            geometries_list_file_offset,
+                                            list_size,
+                                            reinterpret_cast<char *>(geometries_list_ptr));
+                              return index_size + list_size;
+                          }});
+
+    // load datasource information (if it exists)
+    load_tasks.push_back({"datasources", [&] {
+                              CopyFileRange(config.datasource_indexes_path,
+                                            datasources_file_offset,
+                                            number_of_compressed_datasources,
+                                            reinterpret_cast<char *>(datasources_list_ptr));
+                              return number_of_compressed_datasources;
+                          }});
+
+    // Loading list of coordinates
+    load_tasks.push_back({"coordinates", [&] {
+                              util::PackedOSMNodeIDs<true> osmnodeid_list;
+                              osmnodeid_list.reset(
+                                  osmnodeid_ptr,
+                                  shared_layout_ptr
+                                      ->num_entries[storage::SharedDataLayout::OSM_NODE_ID_LIST]);
+                              std::copy(coordinate_blocks.begin(),
+                                        coordinate_blocks.end(),
+                                        coordinate_blocks_ptr);
+                              std::copy(coordinate_words.begin(),
+                                        coordinate_words.end(),
+                                        coordinate_words_ptr);
+                              const auto size = coordinate_list_size * sizeof(extractor::QueryNode);
+                              std::size_t index = 0;
+                              ForEachFileWindow(
+                                  config.nodes_data_path,
+                                  nodes_file_offset,
+                                  size,
+                                  sizeof(extractor::QueryNode),
+                                  [&](const char *window, const std::uint64_t window_size) {
+                                      extractor::QueryNode current_node;
+                                      for (const char *record = window;
+                                           record < window + window_size;
+                                           record += sizeof(extractor::QueryNode), ++index)
+                                      {
+                                          std::memcpy(
+                                              &current_node, record, sizeof(extractor::QueryNode));
+                                          if (!config.compress_coordinates)
+                                          {
+                                              coordinates_ptr[index] = util::Coordinate(
+                                                  current_node.lon, current_node.lat);
+                                          }
+                                          if (!config.weights_only)
+                                          {
+                                              osmnodeid_list.push_back(current_node.node_id);
+                                          }
+                                      }
+                                  });
+                              return size;
+                          }});
+
+    // store search tree portion of rtree
+    load_tasks.push_back({"r-tree", [&] {
+                              CopyFileRange(config.ram_index_path,
+                                            tree_nodes_file_offset,
+                                            sizeof(RTreeNode) * tree_size,
+                                            rtree_ptr);
+                              return sizeof(RTreeNode) * tree_size;
+                          }});
+
+    // store leaves of rtree
+    load_tasks.push_back({"r-tree leaves", [&] {
+                              CopyFileRange(
+                                  config.file_index_path, 0, leaves_size, rtree_leaves_ptr);
+                              return leaves_size;
+                          }});
+
+    // load core markers
+    load_tasks.push_back(
+        {"core markers", [&] {
+             std::size_t index = 0;
+             ForEachFileWindow(config.core_data_path,
+                               core_markers_file_offset,
+                               number_of_core_markers,
+                               1,
+                               [&](const char *window, const std::uint64_t window_size) {
+                                   for (const char *marker = window; marker < window + window_size;
+                                        ++marker, ++index)
+                                   {
+                                       BOOST_ASSERT(*marker == 0 || *marker == 1);
+                                       const unsigned bucket = index / 32;
+                                       const unsigned offset = index % 32;
+                                       if (0 == offset)
+                                       {
+                                           core_marker_ptr[bucket] = 0;
+                                       }
+                                       if (*marker == 1)
+                                       {
+                                           core_marker_ptr[bucket] |= (1u << offset);
+                                       }
+                                   }
+                               });
+             return number_of_core_markers;
+         }});
+
+    // load the nodes and edges of the search graph
+    load_tasks.push_back({"search graph", [&] {
+                              const auto nodes_size =
+                                  number_of_graph_nodes * sizeof(QueryGraph::NodeArrayEntry);
+                              const auto edges_size =
+                                  number_of_graph_edges * sizeof(QueryGraph::EdgeArrayEntry);
+                              CopyFileRange(config.hsgr_data_path,
+                                            graph_nodes_file_offset,
+                                            nodes_size,
+                                            reinterpret_cast<char *>(graph_node_list_ptr));
+                              CopyFileRange(config.hsgr_data_path,
+                                            graph_nodes_file_offset + nodes_size,
+                                            edges_size,
+                                            reinterpret_cast<char *>(graph_edge_list_ptr));
+                              // the checksum covers the edges exactly as osrm-contract wrote them
+                              if (util::ParallelCRC32C(
+                                      reinterpret_cast<const char *>(graph_edge_list_ptr),
+                                      edges_size) != checksum)
+                              {
+                                  throw util::exception(
+                                      "The edges in " + config.hsgr_data_path.string() +
+                                      " do not match their checksum. Run osrm-contract again.");
+                              }
+                              return nodes_size + edges_size;
+                          }});
+
+    // the file stores the edge data and the segment weights of each slot and metric after each
+    // other
+    load_tasks.push_back(
+        {"time slots", [&] {
+             const auto edge_data_size =
+                 sizeof(QueryGraph::EdgeData) * time_slots_header.number_of_edges;
+             const auto segment_weights_size =
+                 sizeof(EdgeWeight) * time_slots_header.number_of_geometry_segments;
+             std::uint64_t file_offset = sizeof(contractor::TimeSlotsHeader);
+             std::vector<EdgeWeight> segment_weights(
+                 narrow_segment_weights ? time_slots_header.number_of_geometry_segments : 0);
+             for (const auto slot : util::irange(0u, time_slots_header.GetNumberOfOverlays()))
+             {
+                 CopyFileRange(config.time_slots_path,
+                               file_offset,
+                               edge_data_size,
+                               reinterpret_cast<char *>(time_slot_edge_data_ptr +
+                                                        slot * time_slots_header.number_of_edges));
+                 file_offset += edge_data_size;
+                 const auto slot_offset = slot * time_slots_header.number_of_geometry_segments;
+                 if (narrow_segment_weights)
+                 {
+                     CopyFileRange(config.time_slots_path,
+                                   file_offset,
+                                   segment_weights_size,
+                                   reinterpret_cast<char *>(segment_weights.data()));
+                     auto narrow_ptr =
+                         reinterpret_cast<std::uint16_t *>(time_slot_segment_weights_ptr) +
+                         slot_offset;
+                     std::transform(segment_weights.begin(),
+                                    segment_weights.end(),
+                                    narrow_ptr,
+                                    util::SegmentWeightList<true>::Narrow);
+                 }
+                 else
+                 {
+                     CopyFileRange(
+                         config.time_slots_path,
+                         file_offset,
+                         segment_weights_size,
+                         reinterpret_cast<char *>(
+                             reinterpret_cast<EdgeWeight *>(time_slot_segment_weights_ptr) +
+                             slot_offset));
+                 }
+                 file_offset += segment_weights_size;
+             }
+             return time_slots_header.GetNumberOfOverlays() * edge_data_size +
+                    shared_layout_ptr->GetBlockSize(SharedDataLayout::TIME_SLOT_GEOMETRY_WEIGHTS);
+         }});
+
+    load_tasks.push_back({"edge lengths", [&] {
+                              const auto size = sizeof(EdgeLength) * number_of_edge_lengths;
+                              CopyFileRange(config.edge_lengths_path,
+                                            sizeof(std::uint64_t),
+                                            size,
+                                            reinterpret_cast<char *>(edge_lengths_ptr));
+                              return size;
+                          }});
+
+    load_tasks.push_back(
+        {"duplicated nodes", [&] {
+             const auto size = sizeof(extractor::DuplicatedNode) * number_of_duplicated_nodes;
+             CopyFileRange(config.duplicated_nodes_path,
+                           sizeof(util::FingerPrint) + sizeof(std::uint64_t),
+                           size,
+                           reinterpret_cast<char *>(duplicated_nodes_ptr));
+             return size;
+         }});
+
+    load_tasks.push_back({"core landmarks", [&] {
+                              const auto size =
+                                  sizeof(EdgeWeight) * number_of_core_landmark_distances;
+                              CopyFileRange(config.core_landmarks_path,
+                                            sizeof(std::uint64_t),
+                                            size,
+                                            reinterpret_cast<char *>(core_landmark_distances_ptr));
+                              return size;
+                          }});
+
+    RunLoadTasks(load_tasks);
+
+    if (time_slots_header.GetNumberOfOverlays() > 0)
     {
-        lane_data_stream.read(reinterpret_cast<char *>(turn_lane_data_ptr),
-                              shared_layout_ptr->GetBlockSize(SharedDataLayout::TURN_LANE_DATA));
+        *time_slots_ptr = time_slots_header;
     }
-    lane_data_stream.close();
 
     auto *turn_lane_offset_ptr = shared_layout_ptr->GetBlockPtr<std::uint32_t, true>(
         shared_memory_ptr, SharedDataLayout::LANE_DESCRIPTION_OFFSETS);
@@ -495,80 +1259,6 @@ int Storage::Run()
         lane_description_masks.swap(tmp);
     }
 
-    // load original edge information
-    NodeID *via_node_ptr = shared_layout_ptr->GetBlockPtr<NodeID, true>(
-        shared_memory_ptr, SharedDataLayout::VIA_NODE_LIST);
-
-    unsigned *name_id_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::NAME_ID_LIST);
-
-    extractor::TravelMode *travel_mode_ptr =
-        shared_layout_ptr->GetBlockPtr<extractor::TravelMode, true>(shared_memory_ptr,
-                                                                    SharedDataLayout::TRAVEL_MODE);
-
-    LaneDataID *lane_data_id_ptr = shared_layout_ptr->GetBlockPtr<LaneDataID, true>(
-        shared_memory_ptr, SharedDataLayout::LANE_DATA_ID);
-
-    extractor::guidance::TurnInstruction *turn_instructions_ptr =
-        shared_layout_ptr->GetBlockPtr<extractor::guidance::TurnInstruction, true>(
-            shared_memory_ptr, SharedDataLayout::TURN_INSTRUCTION);
-
-    EntryClassID *entry_class_id_ptr = shared_layout_ptr->GetBlockPtr<EntryClassID, true>(
-        shared_memory_ptr, SharedDataLayout::ENTRY_CLASSID);
-
-    extractor::OriginalEdgeData current_edge_data;
-    for (unsigned i = 0; i < number_of_original_edges; ++i)
-    {
-        edges_input_stream.read((char *)&(current_edge_data), sizeof(extractor::OriginalEdgeData));
-        via_node_ptr[i] = current_edge_data.via_node;
-        name_id_ptr[i] = current_edge_data.name_id;
-        travel_mode_ptr[i] = current_edge_data.travel_mode;
-        lane_data_id_ptr[i] = current_edge_data.lane_data_id;
-        turn_instructions_ptr[i] = current_edge_data.turn_instruction;
-        entry_class_id_ptr[i] = current_edge_data.entry_classid;
-    }
-    edges_input_stream.close();
-
-    // load compressed geometry
-    unsigned temporary_value;
-    unsigned *geometries_index_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::GEOMETRIES_INDEX);
-    geometry_input_stream.seekg(0, geometry_input_stream.beg);
-    geometry_input_stream.read((char *)&temporary_value, sizeof(unsigned));
-    BOOST_ASSERT(temporary_value ==
-                 shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_INDEX]);
-
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_INDEX) > 0)
-    {
-        geometry_input_stream.read(
-            (char *)geometries_index_ptr,
-            shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_INDEX));
-    }
-    extractor::CompressedEdgeContainer::CompressedEdge *geometries_list_ptr =
-        shared_layout_ptr->GetBlockPtr<extractor::CompressedEdgeContainer::CompressedEdge, true>(
-            shared_memory_ptr, SharedDataLayout::GEOMETRIES_LIST);
-
-    geometry_input_stream.read((char *)&temporary_value, sizeof(unsigned));
-    BOOST_ASSERT(temporary_value ==
-                 shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_LIST]);
-
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_LIST) > 0)
-    {
-        geometry_input_stream.read(
-            (char *)geometries_list_ptr,
-            shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_LIST));
-    }
-
-    // load datasource information (if it exists)
-    uint8_t *datasources_list_ptr = shared_layout_ptr->GetBlockPtr<uint8_t, true>(
-        shared_memory_ptr, SharedDataLayout::DATASOURCES_LIST);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCES_LIST) > 0)
-    {
-        geometry_datasource_input_stream.read(
-            reinterpret_cast<char *>(datasources_list_ptr),
-            shared_layout_ptr->GetBlockSize(SharedDataLayout::DATASOURCES_LIST));
-    }
-
     // load datasource name information (if it exists)
     char *datasource_name_data_ptr = shared_layout_ptr->GetBlockPtr<char, true>(
         shared_memory_ptr, SharedDataLayout::DATASOURCE_NAME_DATA);
@@ -599,89 +1289,57 @@ int Storage::Run()
                   datasource_name_lengths_ptr);
     }
 
-    // Loading list of coordinates
-    util::Coordinate *coordinates_ptr = shared_layout_ptr->GetBlockPtr<util::Coordinate, true>(
-        shared_memory_ptr, SharedDataLayout::COORDINATE_LIST);
-    std::uint64_t *osmnodeid_ptr = shared_layout_ptr->GetBlockPtr<std::uint64_t, true>(
-        shared_memory_ptr, SharedDataLayout::OSM_NODE_ID_LIST);
-    util::PackedVector<OSMNodeID, true> osmnodeid_list;
-    osmnodeid_list.reset(
-        osmnodeid_ptr, shared_layout_ptr->num_entries[storage::SharedDataLayout::OSM_NODE_ID_LIST]);
-
-    extractor::QueryNode current_node;
-    for (unsigned i = 0; i < coordinate_list_size; ++i)
-    {
-        nodes_input_stream.read((char *)&current_node, sizeof(extractor::QueryNode));
-        coordinates_ptr[i] = util::Coordinate(current_node.lon, current_node.lat);
-        osmnodeid_list.push_back(current_node.node_id);
-    }
-    nodes_input_stream.close();
-
     // store timestamp
     char *timestamp_ptr =
         shared_layout_ptr->GetBlockPtr<char, true>(shared_memory_ptr, SharedDataLayout::TIMESTAMP);
     std::copy(m_timestamp.c_str(), m_timestamp.c_str() + m_timestamp.length(), timestamp_ptr);
 
-    // store search tree portion of rtree
-    char *rtree_ptr = shared_layout_ptr->GetBlockPtr<char, true>(shared_memory_ptr,
-                                                                 SharedDataLayout::R_SEARCH_TREE);
-
-    if (tree_size > 0)
-    {
-        tree_node_file.read(rtree_ptr, sizeof(RTreeNode) * tree_size);
-    }
-    tree_node_file.close();
-
-    // load core markers
-    std::vector<char> unpacked_core_markers(number_of_core_markers);
-    core_marker_file.read((char *)unpacked_core_markers.data(),
-                          sizeof(char) * number_of_core_markers);
-
-    unsigned *core_marker_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
-        shared_memory_ptr, SharedDataLayout::CORE_MARKER);
-
-    for (auto i = 0u; i < number_of_core_markers; ++i)
+    if (config.warm_up_rtree_leaves)
     {
-        BOOST_ASSERT(unpacked_core_markers[i] == 0 || unpacked_core_markers[i] == 1);
-
-        if (unpacked_core_markers[i] == 1)
+        // Leaves in shared memory are resident already. Leaves in .fileIndex are faulted into the
+        // page cache so that the servers mapping the file afterwards only take minor faults.
+        util::CoordinateList<true> coordinates;
+        if (config.compress_coordinates)
         {
-            const unsigned bucket = i / 32;
-            const unsigned offset = i % 32;
-            const unsigned value = [&] {
-                unsigned return_value = 0;
-                if (0 != offset)
-                {
-                    return_value = core_marker_ptr[bucket];
-                }
-                return return_value;
-            }();
-
-            core_marker_ptr[bucket] = (value | (1u << offset));
+            EncodedCoordinates encoded;
+            encoded.Reset(coordinate_blocks_ptr,
+                          coordinate_blocks.size(),
+                          coordinate_words_ptr,
+                          coordinate_words.size());
+            coordinates.Reset(std::move(encoded));
+        }
+        else
+        {
+            coordinates.Reset(util::ShM<util::Coordinate, true>::vector(coordinates_ptr,
+                                                                         coordinate_list_size));
+        }
+        std::unique_ptr<RTree> rtree;
+        if (leaves_size > 0)
+        {
+            rtree.reset(new RTree(reinterpret_cast<RTreeNode *>(rtree_ptr),
+                                  tree_size,
+                                  shared_layout_ptr->GetAlignedBlockPtr<RTreeLeafNode>(
+                                      shared_memory_ptr,
+                                      SharedDataLayout::R_SEARCH_TREE_LEAVES,
+                                      sizeof(RTreeLeafNode)),
+                                  leaves_size / sizeof(RTreeLeafNode),
+                                  coordinates));
+        }
+        else
+        {
+            rtree.reset(new RTree(reinterpret_cast<RTreeNode *>(rtree_ptr),
+                                  tree_size,
+                                  config.file_index_path,
+                                  coordinates));
         }
-    }
 
-    // load the nodes of the search graph
-    QueryGraph::NodeArrayEntry *graph_node_list_ptr =
-        shared_layout_ptr->GetBlockPtr<QueryGraph::NodeArrayEntry, true>(
-            shared_memory_ptr, SharedDataLayout::GRAPH_NODE_LIST);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GRAPH_NODE_LIST) > 0)
-    {
-        hsgr_input_stream.read((char *)graph_node_list_ptr,
-                               shared_layout_ptr->GetBlockSize(SharedDataLayout::GRAPH_NODE_LIST));
+        TIMER_START(warm_up);
+        const auto num_objects = rtree->WarmUpLeaves();
+        TIMER_STOP(warm_up);
+        util::SimpleLogger().Write() << "warmed up r-tree leaves with " << num_objects
+                                     << " segments in " << TIMER_MSEC(warm_up) << "ms";
     }
 
-    // load the edges of the search graph
-    QueryGraph::EdgeArrayEntry *graph_edge_list_ptr =
-        shared_layout_ptr->GetBlockPtr<QueryGraph::EdgeArrayEntry, true>(
-            shared_memory_ptr, SharedDataLayout::GRAPH_EDGE_LIST);
-    if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GRAPH_EDGE_LIST) > 0)
-    {
-        hsgr_input_stream.read((char *)graph_edge_list_ptr,
-                               shared_layout_ptr->GetBlockSize(SharedDataLayout::GRAPH_EDGE_LIST));
-    }
-    hsgr_input_stream.close();
-
     // load profile properties
     auto profile_properties_ptr =
         shared_layout_ptr->GetBlockPtr<extractor::ProfileProperties, true>(
@@ -731,25 +1389,56 @@ int Storage::Run()
         std::copy(entry_class_table.begin(), entry_class_table.end(), entry_class_ptr);
     }
 
+    if (config.write_dataset)
+    {
+        dataset_writer->Finish();
+        util::SimpleLogger().Write() << "wrote dataset " << config.dataset_path.string();
+        return EXIT_SUCCESS;
+    }
+
+    unsigned numa_replicas = 0;
+    if (config.replicate_numa_nodes && number_of_numa_nodes > 1)
+    {
+        numa_replicas = ReplicateDataRegion(data_region,
+                                            shared_memory_ptr,
+                                            shared_layout_ptr->GetSizeOfLayout(),
+                                            number_of_numa_nodes);
+    }
+
     // acquire lock
     SharedMemory *data_type_memory =
         makeSharedMemory(CURRENT_REGIONS, sizeof(SharedDataTimestamp), true, false);
     SharedDataTimestamp *data_timestamp_ptr =
         static_cast<SharedDataTimestamp *>(data_type_memory->Ptr());
 
-    boost::interprocess::scoped_lock<boost::interprocess::named_mutex> query_lock(
-        barrier.query_mutex);
-
-    // notify all processes that were waiting for this condition
-    if (0 < barrier.number_of_queries)
     {
-        barrier.no_running_queries_condition.wait(query_lock);
-    }
+        // serializes concurrent updates
+        boost::interprocess::scoped_lock<SharedBarriers::mutex_type> pending_lock(
+            barrier.pending_update_mutex);
 
-    data_timestamp_ptr->layout = layout_region;
-    data_timestamp_ptr->data = data_region;
-    data_timestamp_ptr->timestamp += 1;
+        // Publish the new generation. Queries never wait for this: new queries pick up the new
+        // data, queries running on the previous data finish undisturbed.
+        data_timestamp_ptr->layout = layout_region;
+        data_timestamp_ptr->data = data_region;
+        data_timestamp_ptr->numa_replicas = numa_replicas;
+        data_timestamp_ptr->timestamp += 1;
+
+        // queries count themselves before they check the timestamp once more, so a query the wait
+        // below does not see finds the previous data outdated and does not run on it
+        boost::interprocess::scoped_lock<SharedBarriers::mutex_type> query_lock(
+            barrier.query_mutex);
+        barrier.counters->update_pending = true;
+
+        // wait until the last query on the previous data notifies us
+        while (0 < barrier.counters->QueriesOn(previous_data_region))
+        {
+            barrier.no_running_queries_condition.wait(query_lock);
+        }
+
+        barrier.counters->update_pending = false;
+    }
     deleteRegion(previous_data_region);
+    deleteReplicaRegions(previous_data_region);
     deleteRegion(previous_layout_region);
     util::SimpleLogger().Write() << "all data loaded";
 
@@ -12,12 +12,18 @@ StorageConfig::StorageConfig(const boost::filesystem::path &base)
     : ram_index_path{base.string() + ".ramIndex"}, file_index_path{base.string() + ".fileIndex"},
       hsgr_data_path{base.string() + ".hsgr"}, nodes_data_path{base.string() + ".nodes"},
       edges_data_path{base.string() + ".edges"}, core_data_path{base.string() + ".core"},
+      core_landmarks_path{base.string() + ".core_landmarks"},
+      edge_lengths_path{base.string() + ".edge_lengths"},
+      duplicated_nodes_path{base.string() + ".duplicated_nodes"},
+      time_slots_path{base.string() + ".time_slots"},
       geometries_path{base.string() + ".geometry"}, timestamp_path{base.string() + ".timestamp"},
       datasource_names_path{base.string() + ".datasource_names"},
       datasource_indexes_path{base.string() + ".datasource_indexes"},
       names_data_path{base.string() + ".names"}, properties_path{base.string() + ".properties"},
       intersection_class_path{base.string() + ".icd"}, turn_lane_data_path{base.string() + ".tld"},
-      turn_lane_description_path{base.string() + ".tls"}
+      turn_lane_description_path{base.string() + ".tls"},
+      partition_path{base.string() + ".partition"}, cells_path{base.string() + ".cells"},
+      mld_graph_path{base.string() + ".mldgr"}, dataset_path{base.string() + ".dataset"}
 {
 }
 
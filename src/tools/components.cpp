@@ -1,4 +1,4 @@
-#include "extractor/tarjan_scc.hpp"
+#include "extractor/parallel_scc.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/dynamic_graph.hpp"
 #include "util/exception.hpp"
@@ -11,16 +11,13 @@
 
 #include <boost/filesystem.hpp>
 
-#if defined(__APPLE__) || defined(_WIN32)
-#include <gdal.h>
-#include <ogrsf_frmts.h>
-#else
-#include <gdal/gdal.h>
-#include <gdal/ogrsf_frmts.h>
-#endif
+#include <tbb/parallel_sort.h>
+#include <tbb/pipeline.h>
+#include <tbb/task_scheduler_init.h>
 
 #include "osrm/coordinate.hpp"
 
+#include <cstdio>
 #include <fstream>
 #include <memory>
 #include <string>
@@ -42,11 +39,77 @@ struct TarjanEdgeData
 using TarjanGraph = util::StaticGraph<TarjanEdgeData>;
 using TarjanEdge = TarjanGraph::InputEdge;
 
-void deleteFileIfExists(const std::string &file_name)
+// edges of components with fewer nodes are written to the output
+const constexpr unsigned MAX_WRITTEN_COMPONENT_SIZE = 1000;
+
+// number of nodes whose edges are formatted as one chunk of the output
+const constexpr NodeID NODES_PER_CHUNK = 64 * 1024;
+
+struct OutputChunk
+{
+    NodeID begin;
+    NodeID end;
+    std::string features;
+    std::uint64_t network_length = 0;
+};
+
+void appendCoordinate(std::string &output, const extractor::QueryNode &node)
 {
-    if (boost::filesystem::exists(file_name))
+    char buffer[64];
+    const auto length = std::snprintf(buffer,
+                                      sizeof(buffer),
+                                      "[%.6f,%.6f]",
+                                      static_cast<double>(util::toFloating(node.lon)),
+                                      static_cast<double>(util::toFloating(node.lat)));
+    output.append(buffer, length);
+}
+
+// Formats the edges of the chunk that belong to small components as GeoJSON features. Edges in
+// both directions are written once, from their smaller node.
+template <typename SCC>
+void formatChunk(const TarjanGraph &graph,
+                 const SCC &scc,
+                 const std::vector<extractor::QueryNode> &coordinate_list,
+                 OutputChunk &chunk)
+{
+    for (const NodeID source : util::irange(chunk.begin, chunk.end))
     {
-        boost::filesystem::remove(file_name);
+        for (const auto current_edge : graph.GetAdjacentEdgeRange(source))
+        {
+            const auto target = graph.GetTarget(current_edge);
+            if (source > target && SPECIAL_EDGEID != graph.FindEdge(target, source))
+            {
+                continue;
+            }
+
+            chunk.network_length += 100 * util::coordinate_calculation::greatCircleDistance(
+                                              coordinate_list[source], coordinate_list[target]);
+
+            const auto source_component = scc.GetComponentID(source);
+            const auto target_component = scc.GetComponentID(target);
+            const unsigned size_of_containing_component =
+                std::min(scc.GetComponentSize(source_component),
+                         scc.GetComponentSize(target_component));
+
+            // edges that end on bollard nodes may actually be in two distinct components
+            if (size_of_containing_component < MAX_WRITTEN_COMPONENT_SIZE)
+            {
+                const auto component =
+                    scc.GetComponentSize(source_component) <= scc.GetComponentSize(target_component)
+                        ? source_component
+                        : target_component;
+                chunk.features += ",\n";
+                chunk.features += R"({"type":"Feature","properties":{"component":)";
+                chunk.features += std::to_string(component);
+                chunk.features += R"(,"size":)";
+                chunk.features += std::to_string(size_of_containing_component);
+                chunk.features += R"(},"geometry":{"type":"LineString","coordinates":[)";
+                appendCoordinate(chunk.features, coordinate_list[source]);
+                chunk.features += ',';
+                appendCoordinate(chunk.features, coordinate_list[target]);
+                chunk.features += "]}}";
+            }
+        }
     }
 }
 
@@ -110,9 +173,13 @@ int main(int argc, char *argv[]) try
     // enable logging
     if (argc < 2)
     {
-        osrm::util::SimpleLogger().Write(logWARNING) << "usage:\n" << argv[0] << " <osrm>";
+        osrm::util::SimpleLogger().Write(logWARNING) << "usage:\n"
+                                                     << argv[0] << " <osrm> [<output.geojson>]";
         return EXIT_FAILURE;
     }
+    const std::string output_path = argc > 2 ? argv[2] : "component.geojson";
+
+    tbb::task_scheduler_init init;
 
     std::vector<osrm::tools::TarjanEdge> graph_edge_list;
     auto number_of_nodes = osrm::tools::loadGraph(argv[1], coordinate_list, graph_edge_list);
@@ -124,99 +191,71 @@ int main(int argc, char *argv[]) try
 
     osrm::util::SimpleLogger().Write() << "Starting SCC graph traversal";
 
-    auto tarjan =
-        osrm::util::make_unique<osrm::extractor::TarjanSCC<osrm::tools::TarjanGraph>>(graph);
-    tarjan->Run();
-    osrm::util::SimpleLogger().Write() << "identified: " << tarjan->GetNumberOfComponents()
+    auto scc =
+        osrm::util::make_unique<osrm::extractor::ParallelSCC<osrm::tools::TarjanGraph>>(graph);
+    scc->Run();
+    osrm::util::SimpleLogger().Write() << "identified: " << scc->GetNumberOfComponents()
                                        << " many components";
-    osrm::util::SimpleLogger().Write() << "identified " << tarjan->GetSizeOneCount()
+    osrm::util::SimpleLogger().Write() << "identified " << scc->GetSizeOneCount()
                                        << " size 1 SCCs";
 
     // output
-    TIMER_START(SCC_RUN_SETUP);
-
-    // remove files from previous run if exist
-    osrm::tools::deleteFileIfExists("component.dbf");
-    osrm::tools::deleteFileIfExists("component.shx");
-    osrm::tools::deleteFileIfExists("component.shp");
-
-    OGRRegisterAll();
-
-    const char *psz_driver_name = "ESRI Shapefile";
-    auto *po_driver = OGRSFDriverRegistrar::GetRegistrar()->GetDriverByName(psz_driver_name);
-    if (nullptr == po_driver)
-    {
-        throw osrm::util::exception("ESRI Shapefile driver not available");
-    }
-    auto *po_datasource = po_driver->CreateDataSource("component.shp", nullptr);
-
-    if (nullptr == po_datasource)
-    {
-        throw osrm::util::exception("Creation of output file failed");
-    }
-
-    auto *po_srs = new OGRSpatialReference();
-    po_srs->importFromEPSG(4326);
-
-    auto *po_layer = po_datasource->CreateLayer("component", po_srs, wkbLineString, nullptr);
-
-    if (nullptr == po_layer)
+    std::ofstream output(output_path, std::ios::binary);
+    if (!output.is_open())
     {
-        throw osrm::util::exception("Layer creation failed.");
+        throw osrm::util::exception("Creation of output file " + output_path + " failed");
     }
-    TIMER_STOP(SCC_RUN_SETUP);
-    osrm::util::SimpleLogger().Write() << "shapefile setup took "
-                                       << TIMER_MSEC(SCC_RUN_SETUP) / 1000. << "s";
+    output << R"({"type":"FeatureCollection","features":[)";
 
+    // Chunks of nodes are formatted in parallel and written in order as soon as they are done,
+    // the number of tokens bounds the formatted output in memory.
     uint64_t total_network_length = 0;
     osrm::util::Percent percentage(graph->GetNumberOfNodes());
     TIMER_START(SCC_OUTPUT);
-    for (const NodeID source : osrm::util::irange(0u, graph->GetNumberOfNodes()))
-    {
-        percentage.PrintIncrement();
-        for (const auto current_edge : graph->GetAdjacentEdgeRange(source))
-        {
-            const auto target = graph->GetTarget(current_edge);
-
-            if (source < target || SPECIAL_EDGEID == graph->FindEdge(target, source))
+    NodeID next_node = 0;
+    const auto chunk_reader = tbb::make_filter<void, std::shared_ptr<osrm::tools::OutputChunk>>(
+        tbb::filter::serial_in_order, [&](tbb::flow_control &control) {
+            if (next_node == graph->GetNumberOfNodes())
             {
-                total_network_length +=
-                    100 * osrm::util::coordinate_calculation::greatCircleDistance(
-                              coordinate_list[source], coordinate_list[target]);
-
-                BOOST_ASSERT(current_edge != SPECIAL_EDGEID);
-                BOOST_ASSERT(source != SPECIAL_NODEID);
-                BOOST_ASSERT(target != SPECIAL_NODEID);
-
-                const unsigned size_of_containing_component =
-                    std::min(tarjan->GetComponentSize(tarjan->GetComponentID(source)),
-                             tarjan->GetComponentSize(tarjan->GetComponentID(target)));
-
-                // edges that end on bollard nodes may actually be in two distinct components
-                if (size_of_containing_component < 1000)
-                {
-                    OGRLineString line_string;
-                    line_string.addPoint(
-                        static_cast<double>(osrm::util::toFloating(coordinate_list[source].lon)),
-                        static_cast<double>(osrm::util::toFloating(coordinate_list[source].lat)));
-                    line_string.addPoint(
-                        static_cast<double>(osrm::util::toFloating(coordinate_list[target].lon)),
-                        static_cast<double>(osrm::util::toFloating(coordinate_list[target].lat)));
-
-                    OGRFeature *po_feature = OGRFeature::CreateFeature(po_layer->GetLayerDefn());
-
-                    po_feature->SetGeometry(&line_string);
-                    if (OGRERR_NONE != po_layer->CreateFeature(po_feature))
-                    {
-                        throw osrm::util::exception("Failed to create feature in shapefile.");
-                    }
-                    OGRFeature::DestroyFeature(po_feature);
-                }
+                control.stop();
+                return std::shared_ptr<osrm::tools::OutputChunk>{};
             }
-        }
+            auto chunk = std::make_shared<osrm::tools::OutputChunk>();
+            chunk->begin = next_node;
+            chunk->end = std::min<NodeID>(graph->GetNumberOfNodes() - next_node,
+                                          osrm::tools::NODES_PER_CHUNK) +
+                         next_node;
+            next_node = chunk->end;
+            return chunk;
+        });
+    const auto chunk_formatter = tbb::make_filter<std::shared_ptr<osrm::tools::OutputChunk>,
+                                                  std::shared_ptr<osrm::tools::OutputChunk>>(
+        tbb::filter::parallel, [&](std::shared_ptr<osrm::tools::OutputChunk> chunk) {
+            osrm::tools::formatChunk(*graph, *scc, coordinate_list, *chunk);
+            return chunk;
+        });
+    bool first_feature = true;
+    const auto chunk_writer = tbb::make_filter<std::shared_ptr<osrm::tools::OutputChunk>, void>(
+        tbb::filter::serial_in_order, [&](const std::shared_ptr<osrm::tools::OutputChunk> chunk) {
+            if (!chunk->features.empty())
+            {
+                // every feature starts with a separator, which the first one must not have
+                output.write(chunk->features.data() + (first_feature ? 1 : 0),
+                             chunk->features.size() - (first_feature ? 1 : 0));
+                first_feature = false;
+            }
+            total_network_length += chunk->network_length;
+            percentage.PrintStatus(chunk->end);
+        });
+    tbb::parallel_pipeline(2 * tbb::task_scheduler_init::default_num_threads(),
+                           chunk_reader & chunk_formatter & chunk_writer);
+
+    output << "\n]}\n";
+    output.close();
+    if (!output)
+    {
+        throw osrm::util::exception("Writing " + output_path + " failed");
     }
-    OGRSpatialReference::DestroySpatialReference(po_srs);
-    OGRDataSource::DestroyDataSource(po_datasource);
     TIMER_STOP(SCC_OUTPUT);
     osrm::util::SimpleLogger().Write()
         << "generating output took: " << TIMER_MSEC(SCC_OUTPUT) / 1000. << "s";
@@ -1,5 +1,7 @@
 #include "contractor/contractor.hpp"
 #include "contractor/contractor_config.hpp"
+#include "contractor/time_slots.hpp"
+#include "extractor/edge_classes.hpp"
 #include "util/simple_logger.hpp"
 #include "util/version.hpp"
 
@@ -9,6 +11,7 @@
 
 #include <tbb/task_scheduler_init.h>
 
+#include <csignal>
 #include <cstdlib>
 #include <exception>
 #include <new>
@@ -23,6 +26,14 @@ enum class return_code : unsigned
     exit
 };
 
+// The first SIGINT or SIGTERM lets the contraction stop at its next checkpoint, another one ends
+// the process right away
+extern "C" void interruptContraction(int signal)
+{
+    std::signal(signal, SIG_DFL);
+    contractor::Contractor::Interrupt();
+}
+
 return_code parseArguments(int argc, char *argv[], contractor::ContractorConfig &contractor_config)
 {
     // declare a group of options that will be allowed only on command line
@@ -39,20 +50,77 @@ return_code parseArguments(int argc, char *argv[], contractor::ContractorConfig
         "core,k",
         boost::program_options::value<double>(&contractor_config.core_factor)->default_value(1.0),
         "Percentage of the graph (in vertices) to contract [0..1]")(
+        "core-landmarks",
+        boost::program_options::value<unsigned>(&contractor_config.core_landmarks)
+            ->default_value(0),
+        "Number of landmarks to precompute in the core for goal-directed queries (requires "
+        "--core < 1)")(
         "segment-speed-file",
         boost::program_options::value<std::vector<std::string>>(
             &contractor_config.segment_speed_lookup_paths)
             ->composing(),
-        "Lookup files containing nodeA, nodeB, speed data to adjust edge weights")(
+        "Lookup files containing nodeA, nodeB, speed data to adjust edge weights, as CSV or "
+        "converted by osrm-traffic-convert")(
         "turn-penalty-file",
         boost::program_options::value<std::vector<std::string>>(
             &contractor_config.turn_penalty_lookup_paths)
             ->composing(),
-        "Lookup files containing from_, to_, via_nodes, and turn penalties to adjust turn weights")(
+        "Lookup files containing from_, to_, via_nodes, and turn penalties to adjust turn weights, "
+        "as CSV or converted by osrm-traffic-convert")(
+        "time-slot-speed-file",
+        boost::program_options::value<std::vector<std::string>>(
+            &contractor_config.time_slot_speed_lookup_paths)
+            ->composing(),
+        "Speed files of consecutive time slots, applied on top of --segment-speed-file for routes "
+        "with a departure time")(
+        "time-slot-duration",
+        boost::program_options::value<unsigned>(&contractor_config.time_slot_duration)
+            ->default_value(60),
+        "Length of a time slot in minutes")(
+        "metric-speed-file",
+        boost::program_options::value<std::vector<std::string>>(
+            &contractor_config.metric_speed_lookup_paths)
+            ->composing(),
+        "Speed files of further metrics over the same hierarchy, applied on top of "
+        "--segment-speed-file. Route requests select the n-th file with metric=n")(
+        "exclude-classes",
+        boost::program_options::value<std::vector<std::string>>(
+            &contractor_config.exclude_classes)
+            ->composing(),
+        "Comma separated edge classes (toll, motorway, ferry) that route requests can exclude "
+        "with exclude=, one metric per value")(
         "level-cache,o",
         boost::program_options::value<bool>(&contractor_config.use_cached_priority)
             ->default_value(false),
-        "Use .level file to retain the contaction level for each node from the last run.");
+        "Use .level file to retain the contaction level for each node from the last run.")(
+        "incremental",
+        boost::program_options::value<bool>(&contractor_config.incremental)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Reuse the existing .hsgr and only re-contract nodes near changed weights (requires "
+        "--level-cache)")(
+        "incremental-radius",
+        boost::program_options::value<unsigned>(&contractor_config.incremental_radius)
+            ->default_value(3),
+        "Number of hops around a changed edge that are re-contracted in incremental mode")(
+        "reorder-changed",
+        boost::program_options::value<bool>(&contractor_config.reorder_changed)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Recompute the contraction order of the nodes that are re-contracted in incremental mode "
+        "and update the .level file")(
+        "renumber-nodes",
+        boost::program_options::value<bool>(&contractor_config.renumber_nodes)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Order the nodes of the contracted graph by level for faster queries (not compatible "
+        "with osrm-partition)")(
+        "checkpoint-interval",
+        boost::program_options::value<unsigned>(&contractor_config.checkpoint_interval)
+            ->default_value(0),
+        "Minutes between checkpoints of the contraction, an interrupted run resumes from the last "
+        "one (0 disables checkpoints). SIGINT or SIGTERM writes a checkpoint after the current "
+        "round of the contraction and stops");
 
     // hidden options, will be allowed on command line, but will not be shown to the user
     boost::program_options::options_description hidden_options("Hidden options");
@@ -131,6 +199,21 @@ int main(int argc, char *argv[]) try
         return EXIT_FAILURE;
     }
 
+    for (const auto &classes : contractor_config.exclude_classes)
+    {
+        // throws for unknown classes
+        extractor::ParseEdgeClasses(classes);
+    }
+    if (contractor_config.metric_speed_lookup_paths.size() +
+            contractor_config.exclude_classes.size() >
+        contractor::TimeSlotsHeader::MAX_METRICS)
+    {
+        util::SimpleLogger().Write(logWARNING) << "At most "
+                                               << contractor::TimeSlotsHeader::MAX_METRICS
+                                               << " metrics are supported";
+        return EXIT_FAILURE;
+    }
+
     const unsigned recommended_num_threads = tbb::task_scheduler_init::default_num_threads();
 
     if (recommended_num_threads != contractor_config.requested_num_threads)
@@ -153,6 +236,12 @@ int main(int argc, char *argv[]) try
 
     tbb::task_scheduler_init init(contractor_config.requested_num_threads);
 
+    if (contractor_config.checkpoint_interval > 0)
+    {
+        std::signal(SIGINT, interruptContraction);
+        std::signal(SIGTERM, interruptContraction);
+    }
+
     return contractor::Contractor(contractor_config).Run();
 }
 catch (const std::bad_alloc &e)
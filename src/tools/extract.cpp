@@ -8,9 +8,12 @@
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 
+#include <cstddef>
 #include <cstdlib>
 #include <exception>
 #include <new>
+#include <string>
+#include <vector>
 
 using namespace osrm;
 
@@ -27,6 +30,10 @@ return_code parseArguments(int argc, char *argv[], extractor::ExtractorConfig &e
     boost::program_options::options_description generic_options("Options");
     generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message");
 
+    std::string sort_algorithm;
+    std::size_t sort_memory;
+    std::size_t memory_budget;
+
     // declare a group of options that will be allowed both on command line
     boost::program_options::options_description config_options("Configuration");
     config_options.add_options()(
@@ -43,11 +50,50 @@ return_code parseArguments(int argc, char *argv[], extractor::ExtractorConfig &e
             ->implicit_value(true)
             ->default_value(false),
         "Generate a lookup table for internal edge-expanded-edge IDs to OSM node pairs")(
+        "generate-turn-cost-tables",
+        boost::program_options::value<bool>(&extractor_config.generate_turn_cost_tables)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Write the turn costs of every intersection of the node-based graph to "
+        ".osrm.turn_costs, equal tables are stored once")(
         "small-component-size",
         boost::program_options::value<unsigned int>(&extractor_config.small_component_size)
             ->default_value(1000),
         "Number of nodes required before a strongly-connected-componennt is considered big "
-        "(affects nearest neighbor snapping)");
+        "(affects nearest neighbor snapping)")(
+        "sort-algorithm",
+        boost::program_options::value<std::string>(&sort_algorithm)->default_value("parallel"),
+        "Sorting of the extracted data: parallel or stxxl")(
+        "sort-memory",
+        boost::program_options::value<std::size_t>(&sort_memory)->default_value(4096),
+        "Memory budget of the parallel sort in MiB, larger data is spilled to disk")(
+        "memory-budget",
+        boost::program_options::value<std::size_t>(&memory_budget)->default_value(0),
+        "Peak memory of each extraction phase in MiB, sets the sort memory to half of it "
+        "unless given (0 for no limit)")(
+        "region",
+        boost::program_options::value<boost::filesystem::path>(
+            &extractor_config.region_polygon_path),
+        "Polygon file (.poly) of the region to extract, nodes outside of it and ways without "
+        "nodes inside of it are dropped")(
+        "change-file",
+        boost::program_options::value<std::vector<boost::filesystem::path>>(
+            &extractor_config.change_paths)
+            ->composing(),
+        "OSM change file (.osc) to apply to the input, can be given several times. The ids of "
+        "the affected ways are written to .osrm.changed_ways")(
+        "compress-intermediates",
+        boost::program_options::value<bool>(&extractor_config.compress_intermediates)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Compress the .ebg, .edges, .geometry and .nodes files, e.g. to copy them to the "
+        "machine that runs osrm-contract. They are decompressed on the fly when read.")(
+        "spatial-node-order",
+        boost::program_options::value<bool>(&extractor_config.spatial_node_order)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Number the nodes along a hilbert curve, so that nodes close to each other are close "
+        "in memory. The edge based nodes follow the order of their node based nodes.");
 
     // hidden options, will be allowed on command line, but will not be
     // shown to the user
@@ -99,6 +145,31 @@ return_code parseArguments(int argc, char *argv[], extractor::ExtractorConfig &e
             util::SimpleLogger().Write() << visible_options;
             return return_code::exit;
         }
+
+        if (sort_algorithm == "parallel")
+        {
+            extractor_config.sort_algorithm = extractor::ExtractorConfig::SortAlgorithm::Parallel;
+        }
+        else if (sort_algorithm == "stxxl")
+        {
+            extractor_config.sort_algorithm = extractor::ExtractorConfig::SortAlgorithm::STXXL;
+        }
+        else
+        {
+            util::SimpleLogger().Write(logWARNING) << "Unknown sort algorithm " << sort_algorithm;
+            return return_code::fail;
+        }
+        if (sort_memory == 0)
+        {
+            util::SimpleLogger().Write(logWARNING) << "Sort memory must be 1 MiB or larger";
+            return return_code::fail;
+        }
+        extractor_config.memory_budget = memory_budget * 1024 * 1024;
+        if (memory_budget > 0 && option_variables["sort-memory"].defaulted())
+        {
+            sort_memory = std::max<std::size_t>(1, memory_budget / 2);
+        }
+        extractor_config.sort_memory = sort_memory * 1024 * 1024;
     }
     catch (std::exception &e)
     {
@@ -1,22 +1,36 @@
+#include "engine/datafacade/internal_datafacade.hpp"
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "extractor/edge_based_node.hpp"
+#include "extractor/query_node.hpp"
+#include "storage/storage_config.hpp"
+#include "util/coordinate.hpp"
 #include "util/exception.hpp"
 #include "util/simple_logger.hpp"
+#include "util/static_rtree.hpp"
 #include "util/timing_util.hpp"
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 
+#include <cctype>
 #include <cmath>
 #include <cstdio>
 #include <fcntl.h>
 #ifdef __linux__
 #include <malloc.h>
 #endif
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
 
 #include <algorithm>
 #include <chrono>
 #include <iomanip>
 #include <numeric>
 #include <random>
+#include <sstream>
+#include <string>
 #include <vector>
 
 namespace osrm
@@ -44,6 +58,352 @@ void runStatistics(std::vector<double> &timings_vector, Statistics &stats)
         timings_vector.begin(), timings_vector.end(), timings_vector.begin(), 0.0);
     stats.dev = std::sqrt(primary_sq_sum / timings_vector.size() - (stats.mean * stats.mean));
 }
+
+using RTree = util::StaticRTree<extractor::EdgeBasedNode, std::vector<util::Coordinate>, false>;
+
+std::vector<util::Coordinate> loadCoordinates(const boost::filesystem::path &nodes_file)
+{
+    boost::filesystem::ifstream nodes_input_stream(nodes_file, std::ios::binary);
+    if (!nodes_input_stream)
+    {
+        throw util::exception("Could not open " + nodes_file.string() + " for reading.");
+    }
+
+    unsigned number_of_coordinates = 0;
+    nodes_input_stream.read((char *)&number_of_coordinates, sizeof(unsigned));
+    std::vector<util::Coordinate> coordinates(number_of_coordinates);
+    extractor::QueryNode current_node;
+    for (unsigned i = 0; i < number_of_coordinates; ++i)
+    {
+        nodes_input_stream.read((char *)&current_node, sizeof(extractor::QueryNode));
+        coordinates[i] = util::Coordinate(current_node.lon, current_node.lat);
+    }
+    return coordinates;
+}
+
+std::vector<double> timeSnapping(const RTree &rtree, const std::vector<util::Coordinate> &queries)
+{
+    std::vector<double> timings;
+    timings.reserve(queries.size());
+    for (const auto &query : queries)
+    {
+        TIMER_START(nearest);
+        const auto result = rtree.Nearest(query, 1);
+        TIMER_STOP(nearest);
+        if (result.empty())
+        {
+            throw util::exception("snapping returned no result");
+        }
+        timings.push_back(TIMER_MSEC(nearest));
+    }
+    return timings;
+}
+
+void logStatistics(const std::string &name, std::vector<double> &timings)
+{
+    Statistics stats;
+    runStatistics(timings, stats);
+    util::SimpleLogger().Write() << name << ": " << std::setprecision(5) << std::fixed
+                                 << "min: " << stats.min << "ms, "
+                                 << "mean: " << stats.mean << "ms, "
+                                 << "med: " << stats.med << "ms, "
+                                 << "max: " << stats.max << "ms, "
+                                 << "dev: " << stats.dev << "ms";
+}
+
+// Measures snapping latency on freshly mapped r-tree leaves and again after warming them up.
+// Flush the disk cache before running to see the cost of major page faults.
+void runSnappingBenchmark(const boost::filesystem::path &base_path, const unsigned num_queries)
+{
+    const auto coordinates = loadCoordinates(base_path.string() + ".nodes");
+    if (coordinates.empty())
+    {
+        throw util::exception("no coordinates in " + base_path.string() + ".nodes");
+    }
+
+    TIMER_START(map_rtree);
+    RTree rtree(base_path.string() + ".ramIndex", base_path.string() + ".fileIndex", coordinates);
+    TIMER_STOP(map_rtree);
+    util::SimpleLogger().Write() << "mapping r-tree took " << TIMER_MSEC(map_rtree) << "ms";
+
+    std::random_device rd;
+    std::default_random_engine e1(rd());
+    std::uniform_int_distribution<std::size_t> uniform_dist(0, coordinates.size() - 1);
+    std::vector<util::Coordinate> queries(num_queries);
+    std::generate(queries.begin(), queries.end(), [&] { return coordinates[uniform_dist(e1)]; });
+
+    auto cold_timings = timeSnapping(rtree, queries);
+
+    TIMER_START(warm_up);
+    const auto num_objects = rtree.WarmUpLeaves();
+    TIMER_STOP(warm_up);
+    util::SimpleLogger().Write() << "warming up " << num_objects << " segments took "
+                                 << TIMER_MSEC(warm_up) << "ms";
+
+    std::shuffle(queries.begin(), queries.end(), e1);
+    auto warm_timings = timeSnapping(rtree, queries);
+
+    logStatistics("cold snapping", cold_timings);
+    logStatistics("warm snapping", warm_timings);
+}
+
+#ifndef _WIN32
+struct PageFaults
+{
+    long minor;
+    long major;
+};
+
+PageFaults currentPageFaults()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return {usage.ru_minflt, usage.ru_majflt};
+}
+
+// Latency per query and page faults of all queries while replaying the accesses to one kind of
+// block of the dataset
+class BlockTimer
+{
+  public:
+    explicit BlockTimer(std::string name_) : name(std::move(name_)) {}
+
+    template <typename Accesses> void Time(Accesses &&accesses)
+    {
+        const auto faults_before = currentPageFaults();
+        TIMER_START(accesses);
+        accesses();
+        TIMER_STOP(accesses);
+        const auto faults_after = currentPageFaults();
+        minor_faults += faults_after.minor - faults_before.minor;
+        major_faults += faults_after.major - faults_before.major;
+        timings.push_back(TIMER_MSEC(accesses));
+    }
+
+    void Log()
+    {
+        if (timings.empty())
+        {
+            return;
+        }
+        util::SimpleLogger().Write() << name << ": " << major_faults << " major and "
+                                     << minor_faults << " minor page faults, "
+                                     << std::setprecision(2) << std::fixed
+                                     << static_cast<double>(major_faults) / timings.size()
+                                     << " major per query";
+        logStatistics(name, timings);
+    }
+
+  private:
+    std::string name;
+    std::vector<double> timings;
+    long minor_faults = 0;
+    long major_faults = 0;
+};
+
+using DataFacade = engine::datafacade::InternalDataFacade;
+
+// The accesses of a route query to the graph: the search between two phantom nodes and the
+// unpacking of the shortcuts of the packed path, without guidance
+class TracedRouting final
+    : public engine::routing_algorithms::BasicRoutingInterface<DataFacade, TracedRouting>
+{
+    using super = engine::routing_algorithms::BasicRoutingInterface<DataFacade, TracedRouting>;
+    using QueryHeap = engine::SearchEngineData::DenseQueryHeap;
+
+  public:
+    explicit TracedRouting(DataFacade *facade) : super(facade) {}
+
+    std::vector<NodeID> Search(const engine::PhantomNode &source,
+                               const engine::PhantomNode &target) const
+    {
+        const auto number_of_nodes = super::facade->GetNumberOfNodes();
+        auto forward_heap = engine::SearchEngineData::GetHeap<QueryHeap>(number_of_nodes);
+        auto reverse_heap = engine::SearchEngineData::GetHeap<QueryHeap>(number_of_nodes);
+        if (source.forward_segment_id.enabled)
+        {
+            forward_heap->Insert(source.forward_segment_id.id,
+                                 -source.GetForwardWeightPlusOffset(),
+                                 source.forward_segment_id.id);
+        }
+        if (source.reverse_segment_id.enabled)
+        {
+            forward_heap->Insert(source.reverse_segment_id.id,
+                                 -source.GetReverseWeightPlusOffset(),
+                                 source.reverse_segment_id.id);
+        }
+        if (target.forward_segment_id.enabled)
+        {
+            reverse_heap->Insert(target.forward_segment_id.id,
+                                 target.GetForwardWeightPlusOffset(),
+                                 target.forward_segment_id.id);
+        }
+        if (target.reverse_segment_id.enabled)
+        {
+            reverse_heap->Insert(target.reverse_segment_id.id,
+                                 target.GetReverseWeightPlusOffset(),
+                                 target.reverse_segment_id.id);
+        }
+
+        EdgeWeight distance = INVALID_EDGE_WEIGHT;
+        std::vector<NodeID> packed_path;
+        super::Search(*forward_heap, *reverse_heap, distance, packed_path, false, false);
+        return packed_path;
+    }
+
+    std::vector<EdgeID> Unpack(const std::vector<NodeID> &packed_path) const
+    {
+        std::vector<EdgeID> original_edges;
+        for (std::size_t i = 1; i < packed_path.size(); ++i)
+        {
+            super::UnpackPackedEdge(packed_path[i - 1], packed_path[i], original_edges);
+        }
+        return original_edges;
+    }
+};
+
+// Parses one query per line, its coordinates as in a request URL: lon,lat;lon,lat;...
+std::vector<std::vector<util::Coordinate>> loadQueries(const boost::filesystem::path &trace_file)
+{
+    boost::filesystem::ifstream trace_stream(trace_file);
+    if (!trace_stream)
+    {
+        throw util::exception("Could not open " + trace_file.string() + " for reading.");
+    }
+
+    std::vector<std::vector<util::Coordinate>> queries;
+    std::string line;
+    while (std::getline(trace_stream, line))
+    {
+        std::vector<util::Coordinate> query;
+        std::istringstream line_stream(line);
+        std::string pair;
+        while (std::getline(line_stream, pair, ';'))
+        {
+            double lon, lat;
+            char comma;
+            std::istringstream pair_stream(pair);
+            if (pair_stream >> lon >> comma >> lat && comma == ',')
+            {
+                query.emplace_back(util::FloatLongitude{lon}, util::FloatLatitude{lat});
+            }
+        }
+        if (!query.empty())
+        {
+            queries.push_back(std::move(query));
+        }
+    }
+    return queries;
+}
+
+// Replays the block accesses of route queries on a dataset mapped like osrm-routed
+// --lazy-loading does. The accesses of all queries to one kind of block run back to back, so
+// the page faults and latencies of r-tree leaves, graph nodes, shortcuts and geometries can be
+// told apart. Flush the disk cache before running to see the cost of major page faults.
+void runDatasetBenchmark(const boost::filesystem::path &base_path,
+                         const boost::filesystem::path &trace_file,
+                         const unsigned num_queries)
+{
+    storage::StorageConfig config(base_path);
+    config.lazy_loading = true;
+    TIMER_START(load);
+    DataFacade facade(config);
+    TIMER_STOP(load);
+    util::SimpleLogger().Write() << "mapping the dataset took " << TIMER_MSEC(load) << "ms";
+
+    std::vector<std::vector<util::Coordinate>> queries;
+    if (!trace_file.empty())
+    {
+        queries = loadQueries(trace_file);
+    }
+    else
+    {
+        // routes between random nodes of the graph
+        const auto coordinates = loadCoordinates(base_path.string() + ".nodes");
+        if (coordinates.empty())
+        {
+            throw util::exception("no coordinates in " + base_path.string() + ".nodes");
+        }
+        std::random_device rd;
+        std::default_random_engine e1(rd());
+        std::uniform_int_distribution<std::size_t> uniform_dist(0, coordinates.size() - 1);
+        queries.resize(num_queries);
+        for (auto &query : queries)
+        {
+            query = {coordinates[uniform_dist(e1)], coordinates[uniform_dist(e1)]};
+        }
+    }
+    util::SimpleLogger().Write() << "replaying " << queries.size() << " queries";
+
+    BlockTimer rtree_timer("r-tree leaves");
+    std::vector<std::vector<engine::PhantomNode>> phantom_nodes(queries.size());
+    for (std::size_t query = 0; query < queries.size(); ++query)
+    {
+        rtree_timer.Time([&] {
+            for (const auto &coordinate : queries[query])
+            {
+                phantom_nodes[query].push_back(
+                    facade.NearestPhantomNodeWithAlternativeFromBigComponent(coordinate).first);
+            }
+        });
+    }
+
+    TracedRouting routing(&facade);
+    BlockTimer graph_timer("graph nodes");
+    std::vector<std::vector<std::vector<NodeID>>> packed_paths(queries.size());
+    for (std::size_t query = 0; query < queries.size(); ++query)
+    {
+        graph_timer.Time([&] {
+            const auto &legs = phantom_nodes[query];
+            for (std::size_t leg = 1; leg < legs.size(); ++leg)
+            {
+                packed_paths[query].push_back(routing.Search(legs[leg - 1], legs[leg]));
+            }
+        });
+    }
+
+    BlockTimer shortcut_timer("shortcuts");
+    std::vector<std::vector<EdgeID>> original_edges(queries.size());
+    for (std::size_t query = 0; query < queries.size(); ++query)
+    {
+        shortcut_timer.Time([&] {
+            for (const auto &packed_path : packed_paths[query])
+            {
+                const auto edges = routing.Unpack(packed_path);
+                original_edges[query].insert(
+                    original_edges[query].end(), edges.begin(), edges.end());
+            }
+        });
+    }
+
+    BlockTimer geometry_timer("geometries");
+    std::uint64_t checksum = 0;
+    for (std::size_t query = 0; query < queries.size(); ++query)
+    {
+        geometry_timer.Time([&] {
+            std::vector<NodeID> nodes;
+            std::vector<EdgeWeight> weights;
+            for (const auto edge : original_edges[query])
+            {
+                const auto &data = facade.GetEdgeData(edge);
+                const auto geometry = facade.GetGeometryIndexForEdgeID(data.id);
+                facade.GetUncompressedGeometry(geometry, nodes);
+                facade.GetUncompressedWeights(geometry, weights);
+                for (const auto node : nodes)
+                {
+                    checksum += static_cast<std::int32_t>(facade.GetCoordinateOfNode(node).lon);
+                }
+            }
+        });
+    }
+    util::SimpleLogger().Write(logDEBUG) << "checksum " << checksum;
+
+    rtree_timer.Log();
+    graph_timer.Log();
+    shortcut_timer.Log();
+    geometry_timer.Log();
+}
+#endif
 }
 }
 
@@ -65,9 +425,32 @@ int main(int argc, char *argv[]) try
     if (1 == argc)
     {
         osrm::util::SimpleLogger().Write(logWARNING) << "usage: " << argv[0] << " /path/on/device";
+        osrm::util::SimpleLogger().Write(logWARNING) << "       " << argv[0]
+                                                     << " --rtree <file.osrm> [num_queries]";
+        osrm::util::SimpleLogger().Write(logWARNING)
+            << "       " << argv[0] << " --dataset <file.osrm> [queries.txt | num_queries]";
         return -1;
     }
 
+    if (3 <= argc && std::string(argv[1]) == "--dataset")
+    {
+        // a number of random queries or a file with the coordinates of a query per line
+        const std::string queries = 4 == argc ? argv[3] : "1000";
+        const bool random_queries = std::all_of(
+            queries.begin(), queries.end(), [](const char c) { return std::isdigit(c) != 0; });
+        osrm::tools::runDatasetBenchmark(argv[2],
+                                         random_queries ? "" : queries,
+                                         random_queries ? std::stoul(queries) : 0);
+        return EXIT_SUCCESS;
+    }
+
+    if (3 <= argc && std::string(argv[1]) == "--rtree")
+    {
+        const unsigned num_queries = 4 == argc ? std::stoul(argv[3]) : 1000;
+        osrm::tools::runSnappingBenchmark(argv[2], num_queries);
+        return EXIT_SUCCESS;
+    }
+
     test_path = boost::filesystem::path(argv[1]);
     test_path /= "osrm.tst";
     osrm::util::SimpleLogger().Write(logDEBUG) << "temporary file: " << test_path.string();
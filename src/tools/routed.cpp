@@ -1,6 +1,10 @@
+#include "engine/metrics.hpp"
+#include "server/compressor.hpp"
 #include "server/server.hpp"
 #include "util/make_unique.hpp"
+#include "util/numa.hpp"
 #include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
 #include "util/version.hpp"
 
 #include "osrm/engine_config.hpp"
@@ -19,12 +23,17 @@
 
 #include <signal.h>
 
+#include <algorithm>
 #include <chrono>
+#include <fstream>
 #include <future>
 #include <iostream>
 #include <new>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #ifdef _WIN32
 boost::function0<void> console_ctrl_function;
@@ -58,12 +67,56 @@ inline unsigned generateServerProgramOptions(const int argc,
                                              std::string &ip_address,
                                              int &ip_port,
                                              int &requested_num_threads,
+                                             int &io_threads,
+                                             bool &listener_per_thread,
+                                             std::string &unix_socket,
+                                             int &max_queued_requests,
+                                             std::vector<std::string> &max_pending_requests,
                                              bool &use_shared_memory,
+                                             bool &use_dataset,
+                                             bool &use_numa,
+                                             bool &pin_threads,
+                                             bool &compress_geometries,
+                                             bool &compress_coordinates,
+                                             bool &lazy_loading,
+                                             bool &warm_up,
+                                             std::string &warm_up_requests,
                                              bool &trial,
                                              int &max_locations_trip,
                                              int &max_locations_viaroute,
                                              int &max_locations_distance_table,
-                                             int &max_locations_map_matching)
+                                             int &max_locations_map_matching,
+                                             int &max_locations_nearest,
+                                             int &max_duration_isochrone,
+                                             bool &use_parallel_table,
+                                             bool &use_parallel_route,
+                                             std::vector<std::string> &table_peers,
+                                             int &tile_cache_size,
+                                             int &tile_metatile_size,
+                                             int &phantom_node_cache_size,
+                                             int &max_alternative_candidates,
+                                             int &unpacking_cache_size,
+                                             int &route_result_cache_size,
+                                             int &max_trip_optimization_time,
+                                             int &matching_beam_width,
+                                             double &matching_beam_range,
+                                             int &max_query_time,
+                                             int &core_landmarks,
+                                             int &keepalive_timeout,
+                                             int &keepalive_requests,
+                                             int &compression_level,
+                                             int &compression_min_size,
+                                             bool &coalesce_requests,
+                                             int &response_cache_ttl,
+                                             int &response_cache_size,
+                                             double &rate_limit,
+                                             double &rate_limit_burst,
+                                             std::vector<std::string> &shards,
+                                             std::string &query_log,
+                                             int &slow_query_threshold,
+                                             double &query_log_sample_rate,
+                                             std::string &algorithm,
+                                             std::vector<std::string> &datasets)
 {
     using boost::program_options::value;
     using boost::filesystem::path;
@@ -86,9 +139,62 @@ inline unsigned generateServerProgramOptions(const int argc,
         ("threads,t",
          value<int>(&requested_num_threads)->default_value(8),
          "Number of threads to use") //
+        ("io-threads",
+         value<int>(&io_threads)->default_value(1),
+         "Threads reading requests and writing replies while the --threads workers answer the "
+         "requests, 0 answers the requests on the I/O threads") //
+        ("listener-per-thread",
+         value<bool>(&listener_per_thread)->implicit_value(true)->default_value(false),
+         "Give each I/O thread its own listening socket bound with SO_REUSEPORT, the thread "
+         "then handles the connections it accepted on its own") //
+        ("unix-socket",
+         value<std::string>(&unix_socket),
+         "Also accept connections on a Unix domain socket at this path, for clients on the "
+         "same host") //
+        ("max-queued-requests",
+         value<int>(&max_queued_requests)->default_value(1024),
+         "Max. requests waiting for a worker, further ones are answered with 503") //
+        ("max-pending-requests",
+         value<std::vector<std::string>>(&max_pending_requests)->composing(),
+         "Max. queued or running requests of a service, as {service}=<number>. "
+         "Can be given multiple times, further requests are answered with 503") //
         ("shared-memory,s",
          value<bool>(&use_shared_memory)->implicit_value(true)->default_value(false),
          "Load data from shared memory") //
+        ("dataset-file",
+         value<bool>(&use_dataset)->implicit_value(true)->default_value(false),
+         "Map <base.osrm>.dataset written by osrm-datastore --dataset") //
+        ("numa",
+         value<bool>(&use_numa)->implicit_value(true)->default_value(false),
+         "Run one engine per NUMA node and pin the threads to the nodes. Each engine loads its "
+         "own copy of the data, or maps the replica of osrm-datastore --numa replicate. Matching "
+         "sessions and target sets are held by the engine of the node their token or name "
+         "hashes to, which answers all requests using them") //
+        ("pin-threads",
+         value<bool>(&pin_threads)->implicit_value(true)->default_value(false),
+         "Pin each thread answering requests to its own CPU, of its node with --numa. The "
+         "search heaps are allocated by the pinned threads, with --warm-up before the first "
+         "request") //
+        ("compress-geometries",
+         value<bool>(&compress_geometries)->implicit_value(true)->default_value(false),
+         "Keep the geometries delta encoded in memory, smaller but slower to read. "
+         "Use osrm-datastore --compress-geometries for shared memory") //
+        ("compress-coordinates",
+         value<bool>(&compress_coordinates)->implicit_value(true)->default_value(false),
+         "Keep the node coordinates bit packed in blocks in memory, smaller but slower to read. "
+         "Use osrm-datastore --compress-coordinates for shared memory") //
+        ("lazy-loading",
+         value<bool>(&lazy_loading)->implicit_value(true)->default_value(false),
+         "Map the graph, geometries, edge lengths and core landmarks from the files and read "
+         "them on first access instead of at startup") //
+        ("warm-up",
+         value<bool>(&warm_up)->implicit_value(true)->default_value(false),
+         "Page in the dataset and allocate the search heaps of all threads before taking "
+         "requests, and page in new shared memory datasets before switching to them") //
+        ("warm-up-requests",
+         value<std::string>(&warm_up_requests),
+         "File with a request URL per line, e.g. /route/v1/driving/..., that is answered "
+         "before taking requests") //
         ("max-viaroute-size",
          value<int>(&max_locations_viaroute)->default_value(500),
          "Max. locations supported in viaroute query") //
@@ -100,7 +206,122 @@ inline unsigned generateServerProgramOptions(const int argc,
          "Max. locations supported in distance table query") //
         ("max-matching-size",
          value<int>(&max_locations_map_matching)->default_value(100),
-         "Max. locations supported in map matching query");
+         "Max. locations supported in map matching query") //
+        ("max-nearest-size",
+         value<int>(&max_locations_nearest)->default_value(100),
+         "Max. locations supported in nearest query") //
+        ("max-isochrone-duration",
+         value<int>(&max_duration_isochrone)->default_value(1800),
+         "Max. seconds an isochrone query can cover") //
+        ("parallel-table",
+         value<bool>(&use_parallel_table)->implicit_value(true)->default_value(false),
+         "Run the searches of large distance tables on all cores") //
+        ("parallel-route",
+         value<bool>(&use_parallel_route)->implicit_value(true)->default_value(false),
+         "Run the searches and the assembly of routes via many waypoints on all cores") //
+        ("table-peer",
+         value<std::vector<std::string>>(&table_peers)->composing(),
+         "Another osrm-routed serving the same dataset as host:port, which searches a share of "
+         "the rows of very large distance tables. Peers are asked with distribute=false and "
+         "search their share themselves, never passing it on to peers of their own. A peer "
+         "that does not answer within --max-query-time, or 60 seconds without it, has its "
+         "share searched here. Can be given multiple times") //
+        ("tile-cache-size",
+         value<int>(&tile_cache_size)->default_value(512),
+         "Number of encoded vector tiles to keep in memory, 0 disables the cache") //
+        ("tile-metatile-size",
+         value<int>(&tile_metatile_size)->default_value(1),
+         "Encode blocks of n x n neighboring vector tiles at once into the cache, 1 to 16") //
+        ("phantom-node-cache-size",
+         value<int>(&phantom_node_cache_size)->default_value(0),
+         "Number of snapped coordinates to remember for route, table and trip queries") //
+        ("max-alternative-candidates",
+         value<int>(&max_alternative_candidates)->default_value(0),
+         "Max. via nodes inspected in depth for alternative routes, 0 inspects all") //
+        ("unpacking-cache-size",
+         value<int>(&unpacking_cache_size)->default_value(0),
+         "Number of unpacked shortcuts to remember for route, trip and match queries") //
+        ("route-result-cache-size",
+         value<int>(&route_result_cache_size)->default_value(0),
+         "Number of routes between snapped segments to remember for route queries") //
+        ("max-trip-optimization-time",
+         value<int>(&max_trip_optimization_time)->default_value(10),
+         "Max. milliseconds spent improving a trip by local search, 0 disables it") //
+        ("matching-beam-width",
+         value<int>(&matching_beam_width)->default_value(0),
+         "Max. states of a trace coordinate that map matching expands, the most likely ones, "
+         "0 expands all") //
+        ("matching-beam-range",
+         value<double>(&matching_beam_range)->default_value(0),
+         "Map matching only expands states whose log probability is within this range of the "
+         "most likely state of their trace coordinate, 0 expands all") //
+        ("max-query-time",
+         value<int>(&max_query_time)->default_value(0),
+         "Max. milliseconds the searches of a query may take before it fails with Timeout, "
+         "0 disables the limit") //
+        ("core-landmarks",
+         value<int>(&core_landmarks)->default_value(0),
+         "Number of landmarks that direct searches in the core of a partially contracted graph, "
+         "computed at startup unless osrm-contract --core-landmarks stored them in the dataset") //
+        ("keepalive-timeout",
+         value<int>(&keepalive_timeout)->default_value(5),
+         "Seconds an idle connection is kept open, 0 disables keep-alive") //
+        ("keepalive-requests",
+         value<int>(&keepalive_requests)->default_value(512),
+         "Max. requests served over a single connection") //
+        ("compression-level",
+         value<int>(&compression_level)->default_value(server::Compressor::DEFAULT_LEVEL),
+         "zlib level of gzip/deflate compressed replies, from 1 (fastest) to 9 (smallest)") //
+        ("compression-min-size",
+         value<int>(&compression_min_size)
+             ->default_value(static_cast<int>(server::Compressor::DEFAULT_MIN_SIZE)),
+         "Replies smaller than this many bytes are sent uncompressed") //
+        ("coalesce-requests",
+         value<bool>(&coalesce_requests)->implicit_value(true)->default_value(false),
+         "Compute identical requests that arrive while one of them is computed only once, "
+         "except match requests with a session and tables with a target_set") //
+        ("response-cache-ttl",
+         value<int>(&response_cache_ttl)->default_value(0),
+         "Milliseconds the responses of coalesced requests are kept to answer repeated ones, "
+         "implies --coalesce-requests") //
+        ("response-cache-size",
+         value<int>(&response_cache_size)->default_value(1024),
+         "Max. number of responses kept by --response-cache-ttl") //
+        ("rate-limit",
+         value<double>(&rate_limit)->default_value(0),
+         "Cost of the queries a client address may run per second, 0 disables the limit. "
+         "A query costs its number of coordinates, or its number of entries for table and "
+         "trip, other services cost 1") //
+        ("rate-limit-burst",
+         value<double>(&rate_limit_burst)->default_value(0),
+         "Cost a client may run at once after being idle, defaults to 10 seconds of "
+         "--rate-limit") //
+        ("shard",
+         value<std::vector<std::string>>(&shards)->composing(),
+         "Another osrm-routed serving the dataset of a region, as <region.poly>=host:port. "
+         "Queries with all coordinates in the region are forwarded to it, the others, match "
+         "batches and queries using sessions or target sets are answered here, and so are "
+         "queries the shard does not answer within --max-query-time, or 60 seconds without it. "
+         "Can be given multiple times") //
+        ("query-log",
+         value<std::string>(&query_log),
+         "File to append a line of JSON to for every slow or sampled query, with its URL, the "
+         "time of its stages and its search counters") //
+        ("slow-query-threshold",
+         value<int>(&slow_query_threshold)->default_value(1000),
+         "Milliseconds from which on a query is written to --query-log") //
+        ("query-log-sample-rate",
+         value<double>(&query_log_sample_rate)->default_value(0),
+         "Fraction of the faster queries that are written to --query-log as well, 0 to 1") //
+        ("algorithm",
+         value<std::string>(&algorithm)->default_value("ch"),
+         "Routing algorithm of the route service: ch or mld (needs osrm-partition and "
+         "osrm-customize, not supported with shared memory). Table, trip and match always "
+         "use the .hsgr of osrm-contract and ignore the weights of osrm-customize") //
+        ("dataset",
+         value<std::vector<std::string>>(&datasets)->composing(),
+         "Additional dataset served for one profile, as {profile}=<base.osrm>. "
+         "Can be given multiple times, the main dataset serves all other profiles");
 
     // hidden options, will be allowed on command line, but will not be shown to the user
     boost::program_options::options_description hidden_options("Hidden options");
@@ -167,6 +388,27 @@ int main(int argc, const char *argv[]) try
     bool trial_run = false;
     std::string ip_address;
     int ip_port, requested_thread_num;
+    int io_threads, max_queued_requests;
+    bool listener_per_thread = false;
+    std::string unix_socket;
+    std::vector<std::string> max_pending_requests;
+    int keepalive_timeout, keepalive_requests;
+    int compression_level, compression_min_size;
+    bool coalesce_requests = false;
+    int response_cache_ttl, response_cache_size;
+    double rate_limit, rate_limit_burst;
+    std::vector<std::string> shards;
+    std::string query_log;
+    int slow_query_threshold;
+    double query_log_sample_rate;
+    std::string algorithm;
+    std::vector<std::string> datasets;
+    bool use_numa = false;
+    bool pin_threads = false;
+    bool compress_geometries = false;
+    bool compress_coordinates = false;
+    bool lazy_loading = false;
+    std::string warm_up_requests;
 
     EngineConfig config;
     boost::filesystem::path base_path;
@@ -176,12 +418,56 @@ int main(int argc, const char *argv[]) try
                                                               ip_address,
                                                               ip_port,
                                                               requested_thread_num,
+                                                              io_threads,
+                                                              listener_per_thread,
+                                                              unix_socket,
+                                                              max_queued_requests,
+                                                              max_pending_requests,
                                                               config.use_shared_memory,
+                                                              config.use_dataset,
+                                                              use_numa,
+                                                              pin_threads,
+                                                              compress_geometries,
+                                                              compress_coordinates,
+                                                              lazy_loading,
+                                                              config.warm_up,
+                                                              warm_up_requests,
                                                               trial_run,
                                                               config.max_locations_trip,
                                                               config.max_locations_viaroute,
                                                               config.max_locations_distance_table,
-                                                              config.max_locations_map_matching);
+                                                              config.max_locations_map_matching,
+                                                              config.max_locations_nearest,
+                                                              config.max_duration_isochrone,
+                                                              config.use_parallel_table,
+                                                              config.use_parallel_route,
+                                                              config.table_peers,
+                                                              config.tile_cache_size,
+                                                              config.tile_metatile_size,
+                                                              config.phantom_node_cache_size,
+                                                              config.max_alternative_candidates,
+                                                              config.unpacking_cache_size,
+                                                              config.route_result_cache_size,
+                                                              config.max_trip_optimization_time,
+                                                              config.matching_beam_width,
+                                                              config.matching_beam_range,
+                                                              config.max_query_time,
+                                                              config.core_landmarks,
+                                                              keepalive_timeout,
+                                                              keepalive_requests,
+                                                              compression_level,
+                                                              compression_min_size,
+                                                              coalesce_requests,
+                                                              response_cache_ttl,
+                                                              response_cache_size,
+                                                              rate_limit,
+                                                              rate_limit_burst,
+                                                              shards,
+                                                              query_log,
+                                                              slow_query_threshold,
+                                                              query_log_sample_rate,
+                                                              algorithm,
+                                                              datasets);
     if (init_result == INIT_OK_DO_NOT_START_ENGINE)
     {
         return EXIT_SUCCESS;
@@ -190,9 +476,52 @@ int main(int argc, const char *argv[]) try
     {
         return EXIT_FAILURE;
     }
+    if (compression_level < 1 || compression_level > 9)
+    {
+        util::SimpleLogger().Write(logWARNING) << "compression-level must be between 1 and 9";
+        return EXIT_FAILURE;
+    }
+    server::Compressor::Configure(compression_level,
+                                  static_cast<std::size_t>(std::max(0, compression_min_size)));
+    if (!query_log.empty())
+    {
+        if (query_log_sample_rate < 0 || query_log_sample_rate > 1)
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << "query-log-sample-rate must be between 0 and 1";
+            return EXIT_FAILURE;
+        }
+        engine::metrics::UseQueryLog(query_log,
+                                     std::chrono::milliseconds(std::max(0, slow_query_threshold)),
+                                     query_log_sample_rate);
+        util::SimpleLogger().Write() << "Logging queries slower than " << slow_query_threshold
+                                     << "ms to " << query_log;
+    }
+    if (algorithm == "mld")
+    {
+        if (config.use_shared_memory)
+        {
+            util::SimpleLogger().Write(logWARNING) << "mld is not supported with shared memory";
+            return EXIT_FAILURE;
+        }
+        if (config.use_dataset)
+        {
+            util::SimpleLogger().Write(logWARNING) << "mld is not supported with a dataset file";
+            return EXIT_FAILURE;
+        }
+        config.algorithm = EngineConfig::Algorithm::MLD;
+    }
+    else if (algorithm != "ch")
+    {
+        util::SimpleLogger().Write(logWARNING) << "Unknown algorithm " << algorithm;
+        return EXIT_FAILURE;
+    }
     if (!base_path.empty())
     {
         config.storage_config = storage::StorageConfig(base_path);
+        config.storage_config.compress_geometries = compress_geometries;
+        config.storage_config.compress_coordinates = compress_coordinates;
+        config.storage_config.lazy_loading = lazy_loading;
     }
     if (!config.IsValid())
     {
@@ -200,6 +529,11 @@ int main(int argc, const char *argv[]) try
         {
             util::SimpleLogger().Write(logWARNING) << "Path settings and shared memory conflicts.";
         }
+        else if (config.use_dataset)
+        {
+            util::SimpleLogger().Write(logWARNING) << config.storage_config.dataset_path
+                                                   << " is not found";
+        }
         else
         {
             if (!boost::filesystem::is_regular_file(config.storage_config.ram_index_path))
@@ -262,9 +596,85 @@ int main(int argc, const char *argv[]) try
                 util::SimpleLogger().Write(logWARNING) << config.storage_config.properties_path
                                                        << " is not found";
             }
+            if (config.algorithm == EngineConfig::Algorithm::MLD)
+            {
+                if (!boost::filesystem::is_regular_file(config.storage_config.partition_path))
+                {
+                    util::SimpleLogger().Write(logWARNING)
+                        << config.storage_config.partition_path << " is not found";
+                }
+                if (!boost::filesystem::is_regular_file(config.storage_config.cells_path))
+                {
+                    util::SimpleLogger().Write(logWARNING) << config.storage_config.cells_path
+                                                           << " is not found";
+                }
+                if (!boost::filesystem::is_regular_file(config.storage_config.mld_graph_path))
+                {
+                    util::SimpleLogger().Write(logWARNING)
+                        << config.storage_config.mld_graph_path << " is not found";
+                }
+            }
         }
         return EXIT_FAILURE;
     }
+    // only the route service uses the weights osrm-customize applied, the others search the .hsgr
+    if (config.algorithm == EngineConfig::Algorithm::MLD &&
+        boost::filesystem::last_write_time(config.storage_config.mld_graph_path) >
+            boost::filesystem::last_write_time(config.storage_config.hsgr_data_path))
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << config.storage_config.hsgr_data_path << " is older than "
+            << config.storage_config.mld_graph_path
+            << ": table, trip and match answer with the weights of the last osrm-contract run";
+    }
+
+    std::unordered_map<std::string, std::size_t> service_request_limits;
+    for (const auto &limit : max_pending_requests)
+    {
+        const auto separator = limit.find('=');
+        const auto number = separator == std::string::npos
+                                ? std::string()
+                                : limit.substr(separator + 1);
+        if (separator == 0 || number.empty() ||
+            number.find_first_not_of("0123456789") != std::string::npos)
+        {
+            util::SimpleLogger().Write(logWARNING) << "Request limit " << limit
+                                                   << " is not of the form {service}=<number>";
+            return EXIT_FAILURE;
+        }
+        service_request_limits[limit.substr(0, separator)] = std::stoul(number);
+    }
+
+    // additional datasets are always loaded from disk, shared memory only holds one dataset
+    std::vector<std::pair<std::string, EngineConfig>> profile_configs;
+    for (const auto &dataset : datasets)
+    {
+        const auto separator = dataset.find('=');
+        if (separator == std::string::npos || separator == 0)
+        {
+            util::SimpleLogger().Write(logWARNING) << "Dataset " << dataset
+                                                   << " is not of the form {profile}=<base.osrm>";
+            return EXIT_FAILURE;
+        }
+
+        EngineConfig profile_config = config;
+        profile_config.use_shared_memory = false;
+        profile_config.storage_config =
+            storage::StorageConfig(boost::filesystem::path(dataset.substr(separator + 1)));
+        profile_config.storage_config.compress_geometries = compress_geometries;
+        profile_config.storage_config.compress_coordinates = compress_coordinates;
+        profile_config.storage_config.lazy_loading = lazy_loading;
+        profile_config.table_peer_profile = dataset.substr(0, separator);
+        if (!profile_config.IsValid())
+        {
+            util::SimpleLogger().Write(logWARNING) << "Dataset " << dataset
+                                                   << " is missing some of its files";
+            return EXIT_FAILURE;
+        }
+        util::SimpleLogger().Write() << "Profile " << dataset.substr(0, separator) << ": "
+                                     << dataset.substr(separator + 1);
+        profile_configs.emplace_back(dataset.substr(0, separator), std::move(profile_config));
+    }
 
 #ifdef __linux__
     struct MemoryLocker final
@@ -293,6 +703,15 @@ int main(int argc, const char *argv[]) try
     }
 
     util::SimpleLogger().Write() << "Threads: " << requested_thread_num;
+    if (io_threads > 0)
+    {
+        util::SimpleLogger().Write() << "I/O threads: " << io_threads;
+    }
+    const unsigned numa_nodes = use_numa ? util::numa::GetNumberOfNodes() : 1;
+    if (use_numa)
+    {
+        util::SimpleLogger().Write() << "NUMA nodes: " << numa_nodes;
+    }
     util::SimpleLogger().Write() << "IP address: " << ip_address;
     util::SimpleLogger().Write() << "IP port: " << ip_port;
 
@@ -304,10 +723,90 @@ int main(int argc, const char *argv[]) try
     pthread_sigmask(SIG_BLOCK, &new_mask, &old_mask);
 #endif
 
-    auto routing_server = server::Server::CreateServer(ip_address, ip_port, requested_thread_num);
-    auto service_handler = util::make_unique<server::ServiceHandler>(config);
+    auto routing_server =
+        server::Server::CreateServer(ip_address,
+                                     ip_port,
+                                     io_threads > 0 ? io_threads : requested_thread_num,
+                                     static_cast<unsigned>(std::max(0, keepalive_timeout)),
+                                     static_cast<unsigned>(std::max(1, keepalive_requests)),
+                                     numa_nodes,
+                                     listener_per_thread);
+    if (pin_threads)
+    {
+        routing_server->PinThreadsToCPUs();
+    }
+    if (!unix_socket.empty())
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        routing_server->ListenLocal(unix_socket);
+#else
+        util::SimpleLogger().Write(logWARNING) << "Unix domain sockets are not supported";
+        return EXIT_FAILURE;
+#endif
+    }
+    const auto make_service_handler = [&](EngineConfig &engine_config) {
+        auto handler = util::make_unique<server::ServiceHandler>(engine_config, numa_nodes);
+        if (coalesce_requests || response_cache_ttl > 0)
+        {
+            handler->CoalesceQueries(std::chrono::milliseconds(std::max(0, response_cache_ttl)),
+                                     static_cast<std::size_t>(std::max(0, response_cache_size)));
+        }
+        return handler;
+    };
+
+    routing_server->RegisterServiceHandler(make_service_handler(config));
+
+    // all engines share the server's thread pool, only the profile in the URL decides
+    for (auto &profile_config : profile_configs)
+    {
+        routing_server->RegisterServiceHandler(profile_config.first,
+                                               make_service_handler(profile_config.second));
+    }
+
+    // the server only reports to be running once the samples are answered
+    if (!warm_up_requests.empty())
+    {
+        std::ifstream requests(warm_up_requests);
+        if (!requests)
+        {
+            util::SimpleLogger().Write(logWARNING) << "Could not open " << warm_up_requests;
+            return EXIT_FAILURE;
+        }
+        TIMER_START(replay);
+        const auto answered_requests = routing_server->Replay(
+            requests, static_cast<unsigned>(std::max(1, requested_thread_num)));
+        TIMER_STOP(replay);
+        util::SimpleLogger().Write() << "warmed up with " << answered_requests
+                                     << " requests in " << TIMER_SEC(replay) << "s";
+    }
 
-    routing_server->RegisterServiceHandler(std::move(service_handler));
+    // workers start right away and prepare themselves for the registered services
+    if (io_threads > 0)
+    {
+        const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+        routing_server->UseWorkers(
+            std::max(1u, std::min(hardware_threads, static_cast<unsigned>(requested_thread_num))),
+            static_cast<std::size_t>(std::max(0, max_queued_requests)),
+            service_request_limits);
+    }
+    if (rate_limit > 0)
+    {
+        const auto burst = rate_limit_burst > 0 ? rate_limit_burst : 10 * rate_limit;
+        util::SimpleLogger().Write() << "Rate limit: " << rate_limit << " per second, bursts of "
+                                     << burst;
+        routing_server->UseRateLimit(rate_limit, burst);
+    }
+    if (!shards.empty())
+    {
+        const auto shard_timeout = config.max_query_time > 0
+                                       ? config.max_query_time
+                                       : server::ShardRouter::DEFAULT_TIMEOUT;
+        auto shard_router = util::make_unique<server::ShardRouter>(
+            shards, std::chrono::milliseconds(shard_timeout));
+        util::SimpleLogger().Write() << "Forwarding regional queries to " << shard_router->Size()
+                                     << " shards";
+        routing_server->UseShards(std::move(shard_router));
+    }
 
     if (trial_run)
     {
@@ -347,6 +846,13 @@ int main(int argc, const char *argv[]) try
         routing_server->Stop();
         util::SimpleLogger().Write() << "stopping threads";
 
+        const auto &compression = server::Compressor::GetStatistics();
+        util::SimpleLogger().Write() << "compressed " << compression.compressed_replies
+                                     << " replies with " << compression.stream_initializations
+                                     << " zlib streams, output buffers grew "
+                                     << compression.buffer_growths << " times, "
+                                     << compression.skipped_replies << " replies were too small";
+
         auto status = future.wait_for(std::chrono::seconds(2));
 
         if (status == std::future_status::ready)
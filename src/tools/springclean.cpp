@@ -2,6 +2,7 @@
 
 #include "storage/shared_datatype.hpp"
 #include "storage/shared_memory.hpp"
+#include "util/integer_range.hpp"
 #include "util/simple_logger.hpp"
 
 namespace osrm
@@ -41,12 +42,26 @@ void deleteRegion(const SharedDataType region)
 }
 
 // find all existing shmem regions and remove them.
+void deleteReplicaRegions(const SharedDataType data_region)
+{
+    for (const auto node : util::irange(1u, MAX_NUMA_REPLICAS))
+    {
+        const auto replica_region = GetReplicaRegion(data_region, node);
+        if (SharedMemory::RegionExists(replica_region) && !SharedMemory::Remove(replica_region))
+        {
+            util::SimpleLogger().Write(logWARNING) << "could not delete NUMA replica " << node;
+        }
+    }
+}
+
 void springclean()
 {
     util::SimpleLogger().Write() << "spring-cleaning all shared memory regions";
     deleteRegion(DATA_1);
+    deleteReplicaRegions(DATA_1);
     deleteRegion(LAYOUT_1);
     deleteRegion(DATA_2);
+    deleteReplicaRegions(DATA_2);
     deleteRegion(LAYOUT_2);
     deleteRegion(CURRENT_REGIONS);
 }
@@ -1,3 +1,4 @@
+#include "storage/dataset.hpp"
 #include "storage/storage.hpp"
 #include "util/exception.hpp"
 #include "util/simple_logger.hpp"
@@ -7,12 +8,23 @@
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 
+#include <string>
+
 using namespace osrm;
 
 // generate boost::program_options object for the routing part
 bool generateDataStoreOptions(const int argc,
                               const char *argv[],
-                              boost::filesystem::path &base_path)
+                              boost::filesystem::path &base_path,
+                              bool &share_rtree_leaves,
+                              bool &use_huge_pages,
+                              bool &warm_up_rtree_leaves,
+                              bool &write_dataset,
+                              bool &verify_dataset,
+                              bool &compress_geometries,
+                              bool &compress_coordinates,
+                              bool &weights_only,
+                              std::string &numa_placement)
 {
     // declare a group of options that will be allowed only on command line
     boost::program_options::options_description generic_options("Options");
@@ -21,6 +33,54 @@ bool generateDataStoreOptions(const int argc,
     // declare a group of options that will be allowed both on command line
     // as well as in a config file
     boost::program_options::options_description config_options("Configuration");
+    config_options.add_options()(
+        "shared-rtree-leaves",
+        boost::program_options::value<bool>(&share_rtree_leaves)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Load the r-tree leaves into shared memory instead of mapping the .fileIndex")(
+        "huge-pages",
+        boost::program_options::value<bool>(&use_huge_pages)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Back the shared memory region with transparent huge pages (Linux only)")(
+        "warm-up",
+        boost::program_options::value<bool>(&warm_up_rtree_leaves)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Touch all r-tree leaf pages after loading")(
+        "dataset",
+        boost::program_options::value<bool>(&write_dataset)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Write all data to <base.osrm>.dataset for osrm-routed --dataset-file instead of loading "
+        "it into shared memory")(
+        "verify-dataset",
+        boost::program_options::value<bool>(&verify_dataset)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Check the block checksums of <base.osrm>.dataset and exit")(
+        "compress-geometries",
+        boost::program_options::value<bool>(&compress_geometries)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Store the geometries delta encoded, smaller but slower to read. Does not work with "
+        "osrm-traffic-update")(
+        "compress-coordinates",
+        boost::program_options::value<bool>(&compress_coordinates)
+            ->implicit_value(true)
+            ->default_value(false),
+        "Store the node coordinates bit packed in blocks, smaller but slower to read. Best "
+        "with osrm-extract --spatial-node-order")(
+        "weights-only",
+        boost::program_options::value<bool>(&weights_only)->implicit_value(true)->default_value(
+            false),
+        "Only load the data distance tables need, leaving out names, geometries of the "
+        "responses and guidance. osrm-routed only answers table requests for such a dataset")(
+        "numa",
+        boost::program_options::value<std::string>(&numa_placement)->default_value("none"),
+        "Placement of the data on NUMA machines: none, interleave (spread the pages over all "
+        "nodes) or replicate (one copy per node for osrm-routed --numa, Linux only)");
 
     // hidden options, will be allowed on command line but will not be shown to the user
     boost::program_options::options_description hidden_options("Hidden options");
@@ -78,11 +138,61 @@ int main(const int argc, const char *argv[]) try
     util::LogPolicy::GetInstance().Unmute();
 
     boost::filesystem::path base_path;
-    if (!generateDataStoreOptions(argc, argv, base_path))
+    bool share_rtree_leaves = false;
+    bool use_huge_pages = false;
+    bool warm_up_rtree_leaves = false;
+    bool write_dataset = false;
+    bool verify_dataset = false;
+    bool compress_geometries = false;
+    bool compress_coordinates = false;
+    bool weights_only = false;
+    std::string numa_placement;
+    if (!generateDataStoreOptions(argc,
+                                  argv,
+                                  base_path,
+                                  share_rtree_leaves,
+                                  use_huge_pages,
+                                  warm_up_rtree_leaves,
+                                  write_dataset,
+                                  verify_dataset,
+                                  compress_geometries,
+                                  compress_coordinates,
+                                  weights_only,
+                                  numa_placement))
     {
         return EXIT_SUCCESS;
     }
+    if (numa_placement != "none" && numa_placement != "interleave" &&
+        numa_placement != "replicate")
+    {
+        util::SimpleLogger().Write(logWARNING) << "Unknown NUMA placement " << numa_placement;
+        return EXIT_FAILURE;
+    }
     storage::StorageConfig config(base_path);
+    config.share_rtree_leaves = share_rtree_leaves;
+    config.use_huge_pages = use_huge_pages;
+    config.warm_up_rtree_leaves = warm_up_rtree_leaves;
+    config.write_dataset = write_dataset;
+    config.interleave_numa_nodes = numa_placement == "interleave";
+    config.replicate_numa_nodes = numa_placement == "replicate";
+    config.compress_geometries = compress_geometries;
+    config.compress_coordinates = compress_coordinates;
+    config.weights_only = weights_only;
+    if (verify_dataset)
+    {
+        const storage::DatasetFile dataset(config.dataset_path);
+        const auto corrupt_blocks = dataset.FindCorruptBlocks();
+        for (const auto &block : corrupt_blocks)
+        {
+            util::SimpleLogger().Write(logWARNING) << "Block " << block << " is corrupted";
+        }
+        if (!corrupt_blocks.empty())
+        {
+            return EXIT_FAILURE;
+        }
+        util::SimpleLogger().Write() << config.dataset_path.string() << " is intact";
+        return EXIT_SUCCESS;
+    }
     if (!config.IsValid())
     {
         util::SimpleLogger().Write(logWARNING) << "Config contains invalid file paths. Exiting!";
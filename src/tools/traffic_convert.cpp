@@ -0,0 +1,171 @@
+#include "contractor/traffic_update_file.hpp"
+#include "util/simple_logger.hpp"
+#include "util/timing_util.hpp"
+#include "util/version.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/program_options/errors.hpp>
+
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <ostream>
+#include <string>
+
+using namespace osrm;
+
+enum class return_code : unsigned
+{
+    ok,
+    fail,
+    exit
+};
+
+struct ConvertConfig
+{
+    std::string input_path;
+    std::string output_path;
+    std::string kind;
+};
+
+return_code parseArguments(int argc, char *argv[], ConvertConfig &config)
+{
+    // declare a group of options that will be allowed only on command line
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message");
+
+    // declare a group of options that will be allowed on command line
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options()(
+        "kind,k",
+        boost::program_options::value<std::string>(&config.kind)->default_value("speeds"),
+        "Content of the input file: speeds (nodeA, nodeB, speed) or penalties (from_, via_, "
+        "to_node, penalty)")(
+        "output,o",
+        boost::program_options::value<std::string>(&config.output_path),
+        "Binary file that is written, defaults to the input file with a .bin extension");
+
+    // hidden options, will be allowed on command line, but will not be shown to the user
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()("input,i",
+                                 boost::program_options::value<std::string>(&config.input_path),
+                                 "Input file in CSV format");
+
+    // positional option
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("input", 1);
+
+    // combine above options for parsing
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+    const auto *executable = argv[0];
+    boost::program_options::options_description visible_options(
+        "Usage: " + boost::filesystem::path(executable).filename().string() +
+        " <input.csv> [options]");
+    visible_options.add(generic_options).add(config_options);
+
+    // parse command line options
+    boost::program_options::variables_map option_variables;
+    boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                      .options(cmdline_options)
+                                      .positional(positional_options)
+                                      .run(),
+                                  option_variables);
+
+    if (option_variables.count("version"))
+    {
+        util::SimpleLogger().Write() << OSRM_VERSION;
+        return return_code::exit;
+    }
+
+    if (option_variables.count("help"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return return_code::exit;
+    }
+
+    boost::program_options::notify(option_variables);
+
+    if (!option_variables.count("input"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return return_code::fail;
+    }
+
+    if (config.kind != "speeds" && config.kind != "penalties")
+    {
+        util::SimpleLogger().Write(logWARNING) << "Unknown kind " << config.kind
+                                               << ", must be speeds or penalties";
+        return return_code::fail;
+    }
+
+    if (config.output_path.empty())
+    {
+        config.output_path =
+            boost::filesystem::path(config.input_path).replace_extension(".bin").string();
+    }
+
+    return return_code::ok;
+}
+
+template <typename Entry, typename ParseCSV, typename SortEntries>
+void Convert(const ConvertConfig &config,
+             const ParseCSV &parse_csv,
+             const SortEntries &sort_entries)
+{
+    TIMER_START(convert);
+    auto entries = parse_csv(config.input_path);
+    const auto number_of_lines = entries.size();
+    sort_entries(entries);
+    contractor::WriteTrafficFile(config.output_path, entries);
+    TIMER_STOP(convert);
+
+    util::SimpleLogger().Write() << "Wrote " << entries.size() << " unique values of "
+                                 << number_of_lines << " lines to " << config.output_path
+                                 << " in " << TIMER_SEC(convert) << "s";
+}
+
+int main(int argc, char *argv[]) try
+{
+    util::LogPolicy::GetInstance().Unmute();
+    ConvertConfig config;
+
+    const return_code result = parseArguments(argc, argv, config);
+
+    if (return_code::fail == result)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (return_code::exit == result)
+    {
+        return EXIT_SUCCESS;
+    }
+
+    if (config.kind == "speeds")
+    {
+        Convert<contractor::SegmentSpeedEntry>(
+            config, contractor::ParseSegmentSpeedCSV, contractor::SortSegmentSpeeds);
+    }
+    else
+    {
+        Convert<contractor::TurnPenaltyEntry>(
+            config, contractor::ParseTurnPenaltyCSV, contractor::SortTurnPenalties);
+    }
+
+    return EXIT_SUCCESS;
+}
+catch (const std::bad_alloc &e)
+{
+    util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    util::SimpleLogger().Write(logWARNING)
+        << "Please provide more memory or consider using a larger swapfile";
+    return EXIT_FAILURE;
+}
+catch (const std::exception &e)
+{
+    util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
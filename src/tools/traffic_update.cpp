@@ -0,0 +1,164 @@
+#include "contractor/contractor_config.hpp"
+#include "contractor/shared_traffic_update.hpp"
+#include "util/simple_logger.hpp"
+#include "util/version.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/program_options/errors.hpp>
+
+#include <tbb/task_scheduler_init.h>
+
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <ostream>
+
+using namespace osrm;
+
+enum class return_code : unsigned
+{
+    ok,
+    fail,
+    exit
+};
+
+return_code parseArguments(int argc, char *argv[], contractor::ContractorConfig &contractor_config)
+{
+    // declare a group of options that will be allowed only on command line
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message");
+
+    // declare a group of options that will be allowed on command line
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options()(
+        "threads,t",
+        boost::program_options::value<unsigned int>(&contractor_config.requested_num_threads)
+            ->default_value(tbb::task_scheduler_init::default_num_threads()),
+        "Number of threads to use")(
+        "segment-speed-file",
+        boost::program_options::value<std::vector<std::string>>(
+            &contractor_config.segment_speed_lookup_paths)
+            ->composing(),
+        "Lookup files containing nodeA, nodeB, speed data to adjust edge weights, as CSV or "
+        "converted by osrm-traffic-convert")(
+        "turn-penalty-file",
+        boost::program_options::value<std::vector<std::string>>(
+            &contractor_config.turn_penalty_lookup_paths)
+            ->composing(),
+        "Lookup files containing from_, to_, via_nodes, and turn penalties to adjust turn weights, "
+        "as CSV or converted by osrm-traffic-convert");
+
+    // hidden options, will be allowed on command line, but will not be shown to the user
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()(
+        "input,i",
+        boost::program_options::value<boost::filesystem::path>(&contractor_config.osrm_input_path),
+        "The .osrm file of the dataset that is loaded into shared memory");
+
+    // positional option
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("input", 1);
+
+    // combine above options for parsing
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+    const auto *executable = argv[0];
+    boost::program_options::options_description visible_options(
+        "Usage: " + boost::filesystem::path(executable).filename().string() +
+        " <input.osrm> [options]\n\nUpdates the weights of the dataset in shared memory without "
+        "contracting it again. Routes can be suboptimal until the next run of osrm-contract: "
+        "shortcuts are not added for slower witness paths, and a shortcut for both directions "
+        "keeps the larger weight when they differ, overestimating the cheaper direction");
+    visible_options.add(generic_options).add(config_options);
+
+    // parse command line options
+    boost::program_options::variables_map option_variables;
+    boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                      .options(cmdline_options)
+                                      .positional(positional_options)
+                                      .run(),
+                                  option_variables);
+
+    if (option_variables.count("version"))
+    {
+        util::SimpleLogger().Write() << OSRM_VERSION;
+        return return_code::exit;
+    }
+
+    if (option_variables.count("help"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return return_code::exit;
+    }
+
+    boost::program_options::notify(option_variables);
+
+    if (!option_variables.count("input"))
+    {
+        util::SimpleLogger().Write() << visible_options;
+        return return_code::fail;
+    }
+
+    return return_code::ok;
+}
+
+int main(int argc, char *argv[]) try
+{
+    util::LogPolicy::GetInstance().Unmute();
+    contractor::ContractorConfig contractor_config;
+
+    const return_code result = parseArguments(argc, argv, contractor_config);
+
+    if (return_code::fail == result)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (return_code::exit == result)
+    {
+        return EXIT_SUCCESS;
+    }
+
+    contractor_config.UseDefaultOutputNames();
+
+    if (1 > contractor_config.requested_num_threads)
+    {
+        util::SimpleLogger().Write(logWARNING) << "Number of threads must be 1 or larger";
+        return EXIT_FAILURE;
+    }
+
+    if (contractor_config.segment_speed_lookup_paths.empty() &&
+        contractor_config.turn_penalty_lookup_paths.empty())
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "Nothing to update, pass --segment-speed-file or --turn-penalty-file";
+        return EXIT_FAILURE;
+    }
+
+    if (!boost::filesystem::is_regular_file(contractor_config.edge_segment_lookup_path) ||
+        !boost::filesystem::is_regular_file(contractor_config.edge_penalty_path) ||
+        !boost::filesystem::is_regular_file(contractor_config.segment_index_path))
+    {
+        util::SimpleLogger().Write(logWARNING)
+            << "Edge lookup files not found, run osrm-extract with --generate-edge-lookup";
+        return EXIT_FAILURE;
+    }
+
+    tbb::task_scheduler_init init(contractor_config.requested_num_threads);
+
+    return contractor::SharedTrafficUpdate(contractor_config).Run();
+}
+catch (const std::bad_alloc &e)
+{
+    util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    util::SimpleLogger().Write(logWARNING)
+        << "Please provide more memory or consider using a larger swapfile";
+    return EXIT_FAILURE;
+}
+catch (const std::exception &e)
+{
+    util::SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
@@ -8,9 +8,16 @@ int main() try
     osrm::util::LogPolicy::GetInstance().Unmute();
     osrm::util::SimpleLogger().Write() << "Releasing all locks";
     osrm::storage::SharedBarriers barrier;
+#ifndef OSRM_POSIX_SHARED_MEMORY
+    // robust locks are recovered by the next process that locks them
     barrier.pending_update_mutex.unlock();
     barrier.query_mutex.unlock();
     barrier.update_mutex.unlock();
+#endif
+    // queries of crashed processes stay registered forever otherwise
+    barrier.counters->number_of_queries[0] = 0;
+    barrier.counters->number_of_queries[1] = 0;
+    barrier.counters->update_pending = false;
     return 0;
 }
 catch (const std::exception &e)
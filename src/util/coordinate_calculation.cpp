@@ -7,8 +7,22 @@
 
 #include <cmath>
 
+// The AVX2 kernel is compiled via function attributes and selected at runtime, no global
+// compiler flags are required.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OSRM_HAS_AVX2_KERNEL 1
+#include <immintrin.h>
+#else
+#define OSRM_HAS_AVX2_KERNEL 0
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <limits>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 namespace osrm
 {
@@ -18,6 +32,11 @@ namespace util
 namespace coordinate_calculation
 {
 
+static_assert(sizeof(FloatCoordinate) == 2 * sizeof(double),
+              "projectPointOnSegments expects densely packed coordinates");
+static_assert(sizeof(Coordinate) == 2 * sizeof(std::int32_t),
+              "haversineDistances expects densely packed coordinates");
+
 // Does not project the coordinates!
 std::uint64_t squaredEuclideanDistance(const Coordinate lhs, const Coordinate rhs)
 {
@@ -99,6 +118,354 @@ double perpendicularDistance(const Coordinate segment_source,
     return approximate_distance;
 }
 
+namespace
+{
+void projectPointOnSegmentsScalar(const FloatCoordinate *sources,
+                                  const FloatCoordinate *targets,
+                                  const std::size_t count,
+                                  const FloatCoordinate &coordinate,
+                                  FloatCoordinate *nearest)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        nearest[i] = projectPointOnSegment(sources[i], targets[i], coordinate).second;
+    }
+}
+
+#if OSRM_HAS_AVX2_KERNEL
+// Processes four segments per iteration. Coordinates are stored as interleaved (lon, lat)
+// pairs, unpacking two registers yields lanes in the order 0, 2, 1, 3 which is undone
+// symmetrically when storing. Only separate multiplies and adds are used (no FMA) so that
+// rounding matches the scalar code exactly.
+__attribute__((target("avx2"))) void projectPointOnSegmentsAVX2(const FloatCoordinate *sources,
+                                                                const FloatCoordinate *targets,
+                                                                const std::size_t count,
+                                                                const FloatCoordinate &coordinate,
+                                                                FloatCoordinate *nearest)
+{
+    const auto *source_ptr = reinterpret_cast<const double *>(sources);
+    const auto *target_ptr = reinterpret_cast<const double *>(targets);
+    auto *nearest_ptr = reinterpret_cast<double *>(nearest);
+
+    const __m256d query_lon = _mm256_set1_pd(static_cast<double>(coordinate.lon));
+    const __m256d query_lat = _mm256_set1_pd(static_cast<double>(coordinate.lat));
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.);
+    const __m256d epsilon = _mm256_set1_pd(std::numeric_limits<double>::epsilon());
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m256d source_01 = _mm256_loadu_pd(source_ptr + 2 * i);
+        const __m256d source_23 = _mm256_loadu_pd(source_ptr + 2 * i + 4);
+        const __m256d target_01 = _mm256_loadu_pd(target_ptr + 2 * i);
+        const __m256d target_23 = _mm256_loadu_pd(target_ptr + 2 * i + 4);
+
+        const __m256d source_lon = _mm256_unpacklo_pd(source_01, source_23);
+        const __m256d source_lat = _mm256_unpackhi_pd(source_01, source_23);
+        const __m256d target_lon = _mm256_unpacklo_pd(target_01, target_23);
+        const __m256d target_lat = _mm256_unpackhi_pd(target_01, target_23);
+
+        const __m256d slope_lon = _mm256_sub_pd(target_lon, source_lon);
+        const __m256d slope_lat = _mm256_sub_pd(target_lat, source_lat);
+        const __m256d rel_lon = _mm256_sub_pd(query_lon, source_lon);
+        const __m256d rel_lat = _mm256_sub_pd(query_lat, source_lat);
+
+        const __m256d unnormed_ratio =
+            _mm256_add_pd(_mm256_mul_pd(slope_lon, rel_lon), _mm256_mul_pd(slope_lat, rel_lat));
+        const __m256d squared_length = _mm256_add_pd(_mm256_mul_pd(slope_lon, slope_lon),
+                                                     _mm256_mul_pd(slope_lat, slope_lat));
+
+        const __m256d ratio =
+            _mm256_max_pd(_mm256_min_pd(_mm256_div_pd(unnormed_ratio, squared_length), one), zero);
+        const __m256d inverse_ratio = _mm256_sub_pd(one, ratio);
+
+        const __m256d projected_lon = _mm256_add_pd(_mm256_mul_pd(inverse_ratio, source_lon),
+                                                    _mm256_mul_pd(target_lon, ratio));
+        const __m256d projected_lat = _mm256_add_pd(_mm256_mul_pd(inverse_ratio, source_lat),
+                                                    _mm256_mul_pd(target_lat, ratio));
+
+        // degenerated segments snap to their source
+        const __m256d degenerated = _mm256_cmp_pd(squared_length, epsilon, _CMP_LT_OQ);
+        const __m256d nearest_lon = _mm256_blendv_pd(projected_lon, source_lon, degenerated);
+        const __m256d nearest_lat = _mm256_blendv_pd(projected_lat, source_lat, degenerated);
+
+        _mm256_storeu_pd(nearest_ptr + 2 * i, _mm256_unpacklo_pd(nearest_lon, nearest_lat));
+        _mm256_storeu_pd(nearest_ptr + 2 * i + 4, _mm256_unpackhi_pd(nearest_lon, nearest_lat));
+    }
+
+    projectPointOnSegmentsScalar(sources + i, targets + i, count - i, coordinate, nearest + i);
+}
+#endif
+}
+
+void projectPointOnSegments(const FloatCoordinate *sources,
+                            const FloatCoordinate *targets,
+                            const std::size_t count,
+                            const FloatCoordinate &coordinate,
+                            FloatCoordinate *nearest)
+{
+#if OSRM_HAS_AVX2_KERNEL
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2)
+    {
+        projectPointOnSegmentsAVX2(sources, targets, count, coordinate, nearest);
+        return;
+    }
+#endif
+    projectPointOnSegmentsScalar(sources, targets, count, coordinate, nearest);
+}
+
+namespace
+{
+template <typename DistanceT>
+void distancesScalar(const Coordinate *firsts,
+                     const Coordinate *seconds,
+                     const std::size_t count,
+                     double *distances,
+                     DistanceT distance)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        distances[i] = distance(firsts[i], seconds[i]);
+    }
+}
+
+#if OSRM_HAS_AVX2_KERNEL
+// Loads four coordinates and converts them to radians the same way the scalar versions do,
+// up to the rounding of the long double conversion factor
+__attribute__((target("avx2"))) inline void
+loadRadiansAVX2(const Coordinate *coordinates, __m256d &lon, __m256d &lat)
+{
+    const __m256i lon_lat = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(coordinates));
+    const __m256i lons_lats =
+        _mm256_permutevar8x32_epi32(lon_lat, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+    const __m256d precision = _mm256_set1_pd(COORDINATE_PRECISION);
+    const __m256d degree_to_rad = _mm256_set1_pd(static_cast<double>(detail::DEGREE_TO_RAD));
+
+    const __m256d degree_lon =
+        _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(lons_lats)), precision);
+    const __m256d degree_lat =
+        _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(lons_lats, 1)), precision);
+    lon = _mm256_mul_pd(degree_lon, degree_to_rad);
+    lat = _mm256_mul_pd(degree_lat, degree_to_rad);
+}
+
+// Coefficients of the highest power first. The sine and cosine kernels are the ones of fdlibm,
+// the arc tangent is the rational approximation P(z) / Q(z) of Cephes.
+const constexpr double SIN_COEFFICIENTS[] = {1.58969099521155010221e-10,
+                                             -2.50507602534068634195e-08,
+                                             2.75573137070700676789e-06,
+                                             -1.98412698298579493134e-04,
+                                             8.33333333332248946124e-03,
+                                             -1.66666666666666324348e-01};
+const constexpr double COS_COEFFICIENTS[] = {-1.13596475577881948265e-11,
+                                             2.08757232129817482790e-09,
+                                             -2.75573143513906633035e-07,
+                                             2.48015872894767294178e-05,
+                                             -1.38888888888741095749e-03,
+                                             4.16666666666666019037e-02};
+const constexpr double ATAN_P_COEFFICIENTS[] = {-8.750608600031904122785e-01,
+                                                -1.615753718733365076637e+01,
+                                                -7.500855792314704667340e+01,
+                                                -1.228866684490136173410e+02,
+                                                -6.485021904942025371773e+01};
+const constexpr double ATAN_Q_COEFFICIENTS[] = {1.,
+                                                2.485846490142306297962e+01,
+                                                1.650270098316988542046e+02,
+                                                4.328810604912902668951e+02,
+                                                4.853903996359136964868e+02,
+                                                1.945506571482613964425e+02};
+
+template <std::size_t N>
+__attribute__((target("avx2"))) inline __m256d hornerAVX2(const __m256d &z,
+                                                          const double (&coefficients)[N])
+{
+    __m256d result = _mm256_set1_pd(coefficients[0]);
+    for (std::size_t i = 1; i < N; ++i)
+    {
+        result = _mm256_add_pd(_mm256_mul_pd(result, z), _mm256_set1_pd(coefficients[i]));
+    }
+    return result;
+}
+
+// Sine and cosine of |x| <= pi. Reduces by multiples of pi/2 and evaluates the polynomial
+// kernels of fdlibm, which are accurate to about one ulp.
+__attribute__((target("avx2"))) inline void
+sinCosAVX2(const __m256d &x, __m256d &sin, __m256d &cos)
+{
+    const __m256d one = _mm256_set1_pd(1.);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d sign = _mm256_set1_pd(-0.);
+
+    const __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(0.63661977236758134308)),
+                                      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    const __m256d r =
+        _mm256_sub_pd(_mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(1.57079632673412561417))),
+                      _mm256_mul_pd(n, _mm256_set1_pd(6.07710050650619224932e-11)));
+    const __m256d z = _mm256_mul_pd(r, r);
+
+    const __m256d sin_r = _mm256_add_pd(
+        r, _mm256_mul_pd(_mm256_mul_pd(z, r), hornerAVX2(z, SIN_COEFFICIENTS)));
+    const __m256d cos_poly = hornerAVX2(z, COS_COEFFICIENTS);
+    const __m256d half_z = _mm256_mul_pd(half, z);
+    const __m256d w = _mm256_sub_pd(one, half_z);
+    const __m256d cos_r = _mm256_add_pd(
+        w,
+        _mm256_add_pd(_mm256_sub_pd(_mm256_sub_pd(one, w), half_z),
+                      _mm256_mul_pd(z, _mm256_mul_pd(z, cos_poly))));
+
+    // quadrant of x in 0..3, sin(r + q pi/2) cycles through sin, cos, -sin, -cos
+    const __m256d quarter = _mm256_set1_pd(0.25);
+    const __m256d four = _mm256_set1_pd(4.);
+    const __m256d q =
+        _mm256_sub_pd(n, _mm256_mul_pd(four, _mm256_floor_pd(_mm256_mul_pd(n, quarter))));
+    const __m256d q_is_1 = _mm256_cmp_pd(q, one, _CMP_EQ_OQ);
+    const __m256d q_is_2 = _mm256_cmp_pd(q, _mm256_set1_pd(2.), _CMP_EQ_OQ);
+    const __m256d q_is_3 = _mm256_cmp_pd(q, _mm256_set1_pd(3.), _CMP_EQ_OQ);
+    const __m256d odd = _mm256_or_pd(q_is_1, q_is_3);
+
+    sin = _mm256_xor_pd(_mm256_blendv_pd(sin_r, cos_r, odd),
+                        _mm256_and_pd(_mm256_or_pd(q_is_2, q_is_3), sign));
+    cos = _mm256_xor_pd(_mm256_blendv_pd(cos_r, sin_r, odd),
+                        _mm256_and_pd(_mm256_or_pd(q_is_1, q_is_2), sign));
+}
+
+// Arc tangent of x >= 0 with the rational approximation of Cephes, accurate to about one ulp
+__attribute__((target("avx2"))) inline __m256d atanAVX2(const __m256d &x)
+{
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.);
+    const __m256d more_bits = _mm256_set1_pd(6.123233995736765886130e-17);
+
+    // above tan(3 pi/8) use pi/2 - atan(1/x), above 0.66 use pi/4 + atan((x-1)/(x+1))
+    const __m256d big = _mm256_cmp_pd(x, _mm256_set1_pd(2.41421356237309504880), _CMP_GT_OQ);
+    const __m256d medium =
+        _mm256_andnot_pd(big, _mm256_cmp_pd(x, _mm256_set1_pd(0.66), _CMP_GT_OQ));
+
+    __m256d reduced = _mm256_blendv_pd(
+        x, _mm256_div_pd(_mm256_sub_pd(x, one), _mm256_add_pd(x, one)), medium);
+    reduced = _mm256_blendv_pd(reduced, _mm256_div_pd(_mm256_set1_pd(-1.), x), big);
+    const __m256d offset =
+        _mm256_blendv_pd(_mm256_blendv_pd(zero, _mm256_set1_pd(0.78539816339744830962), medium),
+                         _mm256_set1_pd(1.57079632679489661923),
+                         big);
+    const __m256d correction = _mm256_blendv_pd(
+        _mm256_blendv_pd(zero, _mm256_mul_pd(_mm256_set1_pd(0.5), more_bits), medium),
+        more_bits,
+        big);
+
+    const __m256d z = _mm256_mul_pd(reduced, reduced);
+    const __m256d ratio = _mm256_div_pd(_mm256_mul_pd(z, hornerAVX2(z, ATAN_P_COEFFICIENTS)),
+                                        hornerAVX2(z, ATAN_Q_COEFFICIENTS));
+    const __m256d atan_reduced = _mm256_add_pd(_mm256_mul_pd(reduced, ratio), reduced);
+    return _mm256_add_pd(offset, _mm256_add_pd(atan_reduced, correction));
+}
+
+// Four pairs per iteration, see haversineDistance for the formula
+__attribute__((target("avx2"))) void haversineDistancesAVX2(const Coordinate *firsts,
+                                                            const Coordinate *seconds,
+                                                            const std::size_t count,
+                                                            double *distances)
+{
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d one = _mm256_set1_pd(1.);
+    const __m256d two = _mm256_set1_pd(2.);
+    const __m256d earth_radius = _mm256_set1_pd(static_cast<double>(detail::EARTH_RADIUS));
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d lon1, lat1, lon2, lat2;
+        loadRadiansAVX2(firsts + i, lon1, lat1);
+        loadRadiansAVX2(seconds + i, lon2, lat2);
+
+        __m256d sin_half_dlat, sin_half_dlon, cos_lat1, cos_lat2, unused;
+        sinCosAVX2(_mm256_mul_pd(_mm256_sub_pd(lat1, lat2), half), sin_half_dlat, unused);
+        sinCosAVX2(_mm256_mul_pd(_mm256_sub_pd(lon1, lon2), half), sin_half_dlon, unused);
+        sinCosAVX2(lat1, unused, cos_lat1);
+        sinCosAVX2(lat2, unused, cos_lat2);
+
+        const __m256d aharv = _mm256_add_pd(
+            _mm256_mul_pd(sin_half_dlat, sin_half_dlat),
+            _mm256_mul_pd(_mm256_mul_pd(cos_lat1, cos_lat2),
+                          _mm256_mul_pd(sin_half_dlon, sin_half_dlon)));
+        // atan2(y, x) of y, x >= 0 is atan(y / x), including x = 0
+        const __m256d charv = _mm256_mul_pd(
+            two,
+            atanAVX2(_mm256_div_pd(_mm256_sqrt_pd(aharv),
+                                   _mm256_sqrt_pd(_mm256_sub_pd(one, aharv)))));
+
+        _mm256_storeu_pd(distances + i, _mm256_mul_pd(earth_radius, charv));
+    }
+
+    distancesScalar(firsts + i, seconds + i, count - i, distances + i, haversineDistance);
+}
+
+// Four pairs per iteration, see greatCircleDistance for the formula
+__attribute__((target("avx2"))) void greatCircleDistancesAVX2(const Coordinate *firsts,
+                                                              const Coordinate *seconds,
+                                                              const std::size_t count,
+                                                              double *distances)
+{
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d earth_radius = _mm256_set1_pd(static_cast<double>(detail::EARTH_RADIUS));
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d lon1, lat1, lon2, lat2;
+        loadRadiansAVX2(firsts + i, lon1, lat1);
+        loadRadiansAVX2(seconds + i, lon2, lat2);
+
+        __m256d cos_mean_lat, unused;
+        sinCosAVX2(_mm256_mul_pd(_mm256_add_pd(lat1, lat2), half), unused, cos_mean_lat);
+
+        const __m256d x_value = _mm256_mul_pd(_mm256_sub_pd(lon2, lon1), cos_mean_lat);
+        const __m256d y_value = _mm256_sub_pd(lat2, lat1);
+        const __m256d length = _mm256_sqrt_pd(
+            _mm256_add_pd(_mm256_mul_pd(x_value, x_value), _mm256_mul_pd(y_value, y_value)));
+
+        _mm256_storeu_pd(distances + i, _mm256_mul_pd(length, earth_radius));
+    }
+
+    distancesScalar(firsts + i, seconds + i, count - i, distances + i, greatCircleDistance);
+}
+#endif
+}
+
+void haversineDistances(const Coordinate *firsts,
+                        const Coordinate *seconds,
+                        const std::size_t count,
+                        double *distances)
+{
+#if OSRM_HAS_AVX2_KERNEL
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2)
+    {
+        haversineDistancesAVX2(firsts, seconds, count, distances);
+        return;
+    }
+#endif
+    distancesScalar(firsts, seconds, count, distances, haversineDistance);
+}
+
+void greatCircleDistances(const Coordinate *firsts,
+                          const Coordinate *seconds,
+                          const std::size_t count,
+                          double *distances)
+{
+#if OSRM_HAS_AVX2_KERNEL
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2)
+    {
+        greatCircleDistancesAVX2(firsts, seconds, count, distances);
+        return;
+    }
+#endif
+    distancesScalar(firsts, seconds, count, distances, greatCircleDistance);
+}
+
 double perpendicularDistance(const Coordinate source_coordinate,
                              const Coordinate target_coordinate,
                              const Coordinate query_location)
@@ -290,6 +657,50 @@ Coordinate interpolateLinear(double factor, const Coordinate from, const Coordin
     return {std::move(interpolated_lon), std::move(interpolated_lat)};
 }
 
+std::vector<Coordinate> convexHull(std::vector<Coordinate> coordinates)
+{
+    const auto less = [](const Coordinate lhs, const Coordinate rhs) {
+        return std::tie(lhs.lon, lhs.lat) < std::tie(rhs.lon, rhs.lat);
+    };
+    std::sort(coordinates.begin(), coordinates.end(), less);
+    coordinates.erase(std::unique(coordinates.begin(), coordinates.end()), coordinates.end());
+    if (coordinates.size() < 3)
+    {
+        return coordinates;
+    }
+
+    // > 0 if the turn from first over second to third is counter-clockwise
+    const auto cross = [](const Coordinate first, const Coordinate second, const Coordinate third) {
+        const auto first_lon = static_cast<std::int64_t>(static_cast<std::int32_t>(first.lon));
+        const auto first_lat = static_cast<std::int64_t>(static_cast<std::int32_t>(first.lat));
+        return (static_cast<std::int32_t>(second.lon) - first_lon) *
+                   (static_cast<std::int32_t>(third.lat) - first_lat) -
+               (static_cast<std::int32_t>(second.lat) - first_lat) *
+                   (static_cast<std::int32_t>(third.lon) - first_lon);
+    };
+
+    // Andrew's monotone chain: the lower hull from west to east, then the upper hull back
+    std::vector<Coordinate> hull(2 * coordinates.size());
+    std::size_t size = 0;
+    for (const auto coordinate : coordinates)
+    {
+        while (size >= 2 && cross(hull[size - 2], hull[size - 1], coordinate) <= 0)
+            --size;
+        hull[size++] = coordinate;
+    }
+    const auto lower_size = size + 1;
+    for (auto coordinate = std::next(coordinates.rbegin()); coordinate != coordinates.rend();
+         ++coordinate)
+    {
+        while (size >= lower_size && cross(hull[size - 2], hull[size - 1], *coordinate) <= 0)
+            --size;
+        hull[size++] = *coordinate;
+    }
+    // the last coordinate is the first one again
+    hull.resize(size - 1);
+    return hull;
+}
+
 } // ns coordinate_calculation
 } // ns util
 } // ns osrm
@@ -0,0 +1,185 @@
+#include "util/crc32c.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+// reflected Castagnoli polynomial 0x1EDC6F41
+const constexpr std::uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;
+
+std::uint32_t ComputeInSoftware(const char *data, std::size_t size, std::uint32_t crc)
+{
+    static const auto table = [] {
+        std::array<std::uint32_t, 256> table;
+        for (std::uint32_t byte = 0; byte < table.size(); ++byte)
+        {
+            std::uint32_t value = byte;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                value = (value >> 1) ^ ((value & 1) ? CRC32C_POLYNOMIAL : 0);
+            }
+            table[byte] = value;
+        }
+        return table;
+    }();
+
+    while (size--)
+    {
+        crc = table[(crc ^ static_cast<unsigned char>(*data++)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("sse4.2"))) std::uint32_t
+ComputeInHardware(const char *data, std::size_t size, std::uint32_t crc)
+{
+    std::uint64_t wide_crc = crc;
+    for (; size >= sizeof(std::uint64_t); size -= sizeof(std::uint64_t))
+    {
+        std::uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        wide_crc = __builtin_ia32_crc32di(wide_crc, word);
+        data += sizeof(word);
+    }
+    crc = static_cast<std::uint32_t>(wide_crc);
+    while (size--)
+    {
+        crc = __builtin_ia32_crc32qi(crc, static_cast<unsigned char>(*data++));
+    }
+    return crc;
+}
+#endif
+
+// Linear map over GF(2) of a 32 bit CRC register, one column per bit
+using Operator = std::array<std::uint32_t, 32>;
+
+std::uint32_t Apply(const Operator &op, std::uint32_t crc)
+{
+    std::uint32_t result = 0;
+    for (std::size_t bit = 0; crc != 0; crc >>= 1, ++bit)
+    {
+        if (crc & 1)
+        {
+            result ^= op[bit];
+        }
+    }
+    return result;
+}
+
+Operator Compose(const Operator &lhs, const Operator &rhs)
+{
+    Operator result;
+    for (std::size_t bit = 0; bit < result.size(); ++bit)
+    {
+        result[bit] = Apply(lhs, rhs[bit]);
+    }
+    return result;
+}
+
+// Operator that advances a CRC register over size zero bytes
+Operator ZeroBytesOperator(std::uint64_t size)
+{
+    Operator power;
+    power[0] = CRC32C_POLYNOMIAL;
+    for (std::size_t bit = 1; bit < power.size(); ++bit)
+    {
+        power[bit] = 1u << (bit - 1);
+    }
+    // one zero bit to one zero byte
+    for (int square = 0; square < 3; ++square)
+    {
+        power = Compose(power, power);
+    }
+
+    Operator result;
+    for (std::size_t bit = 0; bit < result.size(); ++bit)
+    {
+        result[bit] = 1u << bit;
+    }
+    while (size != 0)
+    {
+        if (size & 1)
+        {
+            result = Compose(power, result);
+        }
+        size >>= 1;
+        if (size != 0)
+        {
+            power = Compose(power, power);
+        }
+    }
+    return result;
+}
+}
+
+bool HasHardwareCRC32C()
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+    return has_sse42;
+#else
+    return false;
+#endif
+}
+
+std::uint32_t CRC32C(const char *data, const std::size_t size, const std::uint32_t crc)
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (HasHardwareCRC32C())
+    {
+        return ComputeInHardware(data, size, crc);
+    }
+#endif
+    return ComputeInSoftware(data, size, crc);
+}
+
+std::uint32_t CombineCRC32C(const std::uint32_t first,
+                            const std::uint32_t second,
+                            const std::uint64_t second_size)
+{
+    return Apply(ZeroBytesOperator(second_size), first) ^ second;
+}
+
+std::uint32_t ParallelCRC32C(const char *data, const std::size_t size)
+{
+    const std::size_t number_of_chunks = (size + CRC32C_CHUNK_SIZE - 1) / CRC32C_CHUNK_SIZE;
+    if (number_of_chunks <= 1)
+    {
+        return CRC32C(data, size);
+    }
+
+    std::vector<std::uint32_t> chunk_crcs(number_of_chunks);
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_chunks, 1),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          for (auto chunk = range.begin(); chunk != range.end(); ++chunk)
+                          {
+                              const auto begin = chunk * CRC32C_CHUNK_SIZE;
+                              const auto end = std::min(begin + CRC32C_CHUNK_SIZE, size);
+                              chunk_crcs[chunk] = CRC32C(data + begin, end - begin);
+                          }
+                      });
+
+    // all but the last chunk are full, so they share one shift operator
+    const auto full_chunk_operator = ZeroBytesOperator(CRC32C_CHUNK_SIZE);
+    std::uint32_t crc = chunk_crcs.front();
+    for (std::size_t chunk = 1; chunk + 1 < number_of_chunks; ++chunk)
+    {
+        crc = Apply(full_chunk_operator, crc) ^ chunk_crcs[chunk];
+    }
+    const auto last_chunk_size = size - (number_of_chunks - 1) * CRC32C_CHUNK_SIZE;
+    return CombineCRC32C(crc, chunk_crcs.back(), last_chunk_size);
+}
+}
+}
@@ -62,18 +62,26 @@ DiscreteBearing BearingClass::getDiscreteBearing(const double bearing)
 
 std::size_t BearingClass::findMatchingBearing(const double bearing) const
 {
-    BOOST_ASSERT(!available_bearings.empty());
+    return guidance::findMatchingBearing(
+        BearingRange(available_bearings.data(),
+                     available_bearings.data() + available_bearings.size()),
+        bearing);
+}
+
+std::size_t findMatchingBearing(const BearingRange bearings, const double bearing)
+{
+    BOOST_ASSERT(!bearings.empty());
     // the small size of the intersections allows a linear compare
     auto discrete_bearing = static_cast<DiscreteBearing>(bearing);
     auto max_element =
-        std::max_element(available_bearings.begin(),
-                         available_bearings.end(),
+        std::max_element(bearings.begin(),
+                         bearings.end(),
                          [&](const DiscreteBearing first, const DiscreteBearing second) {
                              return angularDeviation(first, discrete_bearing) >
                                     angularDeviation(second, discrete_bearing);
                          });
 
-    return std::distance(available_bearings.begin(), max_element);
+    return std::distance(bearings.begin(), max_element);
 }
 
 } // namespace guidance
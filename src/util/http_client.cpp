@@ -0,0 +1,132 @@
+#include "util/http_client.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/asio.hpp>
+
+#include <array>
+#include <cstdlib>
+#include <functional>
+
+namespace osrm
+{
+namespace util
+{
+
+boost::optional<HttpResponse> HttpGet(const std::string &host,
+                                      const std::string &port,
+                                      const std::string &target,
+                                      const std::chrono::milliseconds timeout)
+{
+    using boost::asio::ip::tcp;
+
+    // all steps run asynchronously, so the timer can abort whichever of them is stuck
+    boost::asio::io_service io_service;
+    tcp::resolver resolver(io_service);
+    tcp::socket socket(io_service);
+    boost::asio::deadline_timer timer(io_service);
+
+    // HTTP/1.0 replies are neither chunked nor kept alive, they end with the connection
+    const std::string request = "GET " + target + " HTTP/1.0\r\nHost: " + host + "\r\n\r\n";
+    std::array<char, 64 * 1024> buffer;
+    std::string response;
+    bool complete = false;
+
+    std::function<void(const boost::system::error_code &, std::size_t)> on_read =
+        [&](const boost::system::error_code &error, const std::size_t read) {
+            response.append(buffer.data(), read);
+            if (!error)
+            {
+                socket.async_read_some(boost::asio::buffer(buffer), on_read);
+                return;
+            }
+            complete = error == boost::asio::error::eof;
+            timer.cancel();
+        };
+    const auto on_write = [&](const boost::system::error_code &error, std::size_t) {
+        if (error)
+        {
+            timer.cancel();
+            return;
+        }
+        socket.async_read_some(boost::asio::buffer(buffer), on_read);
+    };
+    const auto on_connect = [&](const boost::system::error_code &error,
+                                tcp::resolver::iterator) {
+        if (error)
+        {
+            timer.cancel();
+            return;
+        }
+        boost::asio::async_write(socket, boost::asio::buffer(request), on_write);
+    };
+    const auto on_resolve = [&](const boost::system::error_code &error,
+                                const tcp::resolver::iterator endpoints) {
+        if (error)
+        {
+            timer.cancel();
+            return;
+        }
+        boost::asio::async_connect(socket, endpoints, on_connect);
+    };
+
+    timer.expires_from_now(boost::posix_time::milliseconds(timeout.count()));
+    timer.async_wait([&](const boost::system::error_code &error) {
+        // cancelled once the exchange ended, otherwise it took too long
+        if (!error)
+        {
+            resolver.cancel();
+            boost::system::error_code ignored;
+            socket.close(ignored);
+        }
+    });
+    resolver.async_resolve(tcp::resolver::query(host, port), on_resolve);
+    try
+    {
+        io_service.run();
+    }
+    catch (const boost::system::system_error &)
+    {
+        return boost::none;
+    }
+    if (!complete)
+    {
+        return boost::none;
+    }
+
+    const auto status_begin = response.find(' ');
+    const auto header_end = response.find("\r\n\r\n");
+    if (!boost::starts_with(response, "HTTP/") || status_begin == std::string::npos ||
+        header_end == std::string::npos || status_begin > header_end)
+    {
+        return boost::none;
+    }
+
+    HttpResponse result;
+    char *status_end = nullptr;
+    result.status =
+        static_cast<unsigned>(std::strtoul(response.c_str() + status_begin + 1, &status_end, 10));
+    if (status_end != response.c_str() + status_begin + 4)
+    {
+        return boost::none;
+    }
+
+    // header names are case-insensitive, the values of the other headers are not needed
+    for (auto line_begin = response.find("\r\n") + 2; line_begin < header_end;)
+    {
+        const auto line_end = response.find("\r\n", line_begin);
+        const auto line = response.substr(line_begin, line_end - line_begin);
+        const auto colon = line.find(':');
+        if (colon != std::string::npos &&
+            boost::iequals(line.substr(0, colon), std::string("Content-Type")))
+        {
+            result.content_type = boost::algorithm::trim_copy(line.substr(colon + 1));
+        }
+        line_begin = line_end + 2;
+    }
+
+    result.body = response.substr(header_end + 4);
+    return result;
+}
+}
+}
@@ -1,38 +1,39 @@
 #include "util/name_table.hpp"
 #include "util/exception.hpp"
+#include "util/range_table.hpp"
 #include "util/simple_logger.hpp"
 
-#include <algorithm>
-#include <fstream>
-#include <limits>
-
 #include <boost/filesystem/fstream.hpp>
 
+#include <unordered_map>
+
 namespace osrm
 {
 namespace util
 {
 
-NameTable::NameTable(const std::string &filename)
+void ReadInternedNames(const std::string &filename,
+                       std::vector<std::uint32_t> &offsets,
+                       std::vector<std::uint8_t> &lengths,
+                       std::vector<char> &chars)
 {
     boost::filesystem::ifstream name_stream(filename, std::ios::binary);
 
     if (!name_stream)
         throw exception("Failed to open " + filename + " for reading.");
 
-    name_stream >> m_name_table;
+    RangeTable<16, false> name_table;
+    name_stream >> name_table;
 
     unsigned number_of_chars = 0;
     name_stream.read(reinterpret_cast<char *>(&number_of_chars), sizeof(number_of_chars));
     if (!name_stream)
         throw exception("Encountered invalid file, failed to read number of contained chars");
 
-    m_names_char_list.resize(number_of_chars + 1); //+1 gives sentinel element
-    m_names_char_list.back() = 0;
+    std::vector<char> file_chars(number_of_chars);
     if (number_of_chars > 0)
     {
-        name_stream.read(reinterpret_cast<char *>(&m_names_char_list[0]),
-                         number_of_chars * sizeof(m_names_char_list[0]));
+        name_stream.read(file_chars.data(), number_of_chars);
     }
     else
     {
@@ -43,26 +44,37 @@ NameTable::NameTable(const std::string &filename)
     if (!name_stream)
         throw exception("Failed to read " + std::to_string(number_of_chars) + " characters from " +
                         filename);
-}
 
-std::string NameTable::GetNameForID(const unsigned name_id) const
-{
-    if (std::numeric_limits<unsigned>::max() == name_id)
+    // names repeat a lot, e.g. the same street name with different destinations
+    const auto number_of_names = name_table.GetNumberOfRanges();
+    std::unordered_map<std::string, std::uint32_t> interned;
+    offsets.resize(number_of_names);
+    lengths.resize(number_of_names);
+    chars.clear();
+    for (const auto name_id : irange(0u, number_of_names))
     {
-        return "";
-    }
-    auto range = m_name_table.GetRange(name_id);
+        const auto range = name_table.GetRange(name_id);
+        BOOST_ASSERT(range.size() <= std::numeric_limits<std::uint8_t>::max());
+        lengths[name_id] = range.size();
+        if (range.size() == 0)
+        {
+            offsets[name_id] = chars.size();
+            continue;
+        }
 
-    std::string result;
-    result.reserve(range.size());
-    if (range.begin() != range.end())
-    {
-        result.resize(range.back() - range.front() + 1);
-        std::copy(m_names_char_list.begin() + range.front(),
-                  m_names_char_list.begin() + range.back() + 1,
-                  result.begin());
+        std::string name(file_chars.begin() + range.front(),
+                         file_chars.begin() + range.front() + range.size());
+        const auto inserted = interned.emplace(std::move(name), chars.size());
+        if (inserted.second)
+        {
+            chars.insert(chars.end(), inserted.first->first.begin(), inserted.first->first.end());
+        }
+        offsets[name_id] = inserted.first->second;
     }
-    return result;
+
+    util::SimpleLogger().Write() << "interned " << number_of_names << " names with "
+                                 << number_of_chars << " characters into " << chars.size()
+                                 << " characters";
 }
 } // namespace util
 } // namespace osrm
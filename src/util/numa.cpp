@@ -0,0 +1,201 @@
+#include "util/numa.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+namespace numa
+{
+
+namespace
+{
+thread_local unsigned thread_node = 0;
+
+#ifdef __linux__
+const char *const SYSFS_NODE_PATH = "/sys/devices/system/node/node";
+
+// Parses a cpulist of the kernel, e.g. "0-7,16-23"
+std::vector<unsigned> GetCPUsOfNode(const unsigned node)
+{
+    std::vector<unsigned> cpus;
+    boost::filesystem::ifstream cpulist_stream(SYSFS_NODE_PATH + std::to_string(node) +
+                                               "/cpulist");
+    std::string cpulist;
+    std::getline(cpulist_stream, cpulist);
+
+    std::istringstream ranges(cpulist);
+    std::string range;
+    while (std::getline(ranges, range, ','))
+    {
+        const auto dash = range.find('-');
+        try
+        {
+            const unsigned first = std::stoul(range.substr(0, dash));
+            const unsigned last =
+                dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+            for (unsigned cpu = first; cpu <= last; ++cpu)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        catch (const std::logic_error &)
+        {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+// The CPUs the process may run on
+std::vector<unsigned> GetCPUsOfProcess()
+{
+    std::vector<unsigned> cpus;
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (0 != sched_getaffinity(0, sizeof(cpu_set), &cpu_set))
+    {
+        return cpus;
+    }
+    for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &cpu_set))
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+bool SetAffinity(const std::vector<unsigned> &cpus)
+{
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const auto cpu : cpus)
+    {
+        CPU_SET(cpu, &cpu_set);
+    }
+    return 0 == pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+}
+
+bool SetMemoryPolicy(void *address,
+                     const std::size_t size,
+                     const int mode,
+                     const unsigned long node_mask)
+{
+#ifdef SYS_mbind
+    // the kernel reads maxnode - 1 bits of the mask
+    const unsigned long max_node = 8 * sizeof(node_mask) + 1;
+    return 0 == syscall(SYS_mbind, address, size, mode, &node_mask, max_node, MPOL_MF_MOVE);
+#else
+    (void)address;
+    (void)size;
+    (void)mode;
+    (void)node_mask;
+    return false;
+#endif
+}
+#endif
+}
+
+unsigned GetNumberOfNodes()
+{
+#ifdef __linux__
+    unsigned number_of_nodes = 0;
+    while (number_of_nodes < MAX_NUMA_NODES &&
+           boost::filesystem::is_directory(SYSFS_NODE_PATH + std::to_string(number_of_nodes)))
+    {
+        ++number_of_nodes;
+    }
+    return std::max(1u, number_of_nodes);
+#else
+    return 1;
+#endif
+}
+
+bool PinThreadToNode(const unsigned node)
+{
+#ifdef __linux__
+    const auto cpus = GetCPUsOfNode(node);
+    if (cpus.empty() || !SetAffinity(cpus))
+    {
+        return false;
+    }
+    thread_node = node;
+    return true;
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+bool PinThreadToCPU(const unsigned node, const unsigned index)
+{
+#ifdef __linux__
+    auto cpus = GetCPUsOfNode(node);
+    if (cpus.empty() && node == 0)
+    {
+        cpus = GetCPUsOfProcess();
+    }
+    if (cpus.empty() || !SetAffinity({cpus[index % cpus.size()]}))
+    {
+        return false;
+    }
+    thread_node = node;
+    return true;
+#else
+    (void)node;
+    (void)index;
+    return false;
+#endif
+}
+
+unsigned GetThreadNode() { return thread_node; }
+
+bool InterleaveMemory(void *address, const std::size_t size, const unsigned number_of_nodes)
+{
+#ifdef __linux__
+    const auto nodes = std::min(number_of_nodes, MAX_NUMA_NODES);
+    const unsigned long node_mask = nodes >= 8 * sizeof(unsigned long) ? ~0ul : (1ul << nodes) - 1;
+    return SetMemoryPolicy(address, size, MPOL_INTERLEAVE, node_mask);
+#else
+    (void)address;
+    (void)size;
+    (void)number_of_nodes;
+    return false;
+#endif
+}
+
+bool BindMemory(void *address, const std::size_t size, const unsigned node)
+{
+#ifdef __linux__
+    if (node >= MAX_NUMA_NODES)
+    {
+        return false;
+    }
+    return SetMemoryPolicy(address, size, MPOL_BIND, 1ul << node);
+#else
+    (void)address;
+    (void)size;
+    (void)node;
+    return false;
+#endif
+}
+}
+}
+}
@@ -0,0 +1,168 @@
+#include "util/quantized_rectangles.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// The AVX2 kernel is compiled via function attributes and selected at runtime, no global
+// compiler flags are required.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OSRM_HAS_AVX2_KERNEL 1
+#include <immintrin.h>
+#else
+#define OSRM_HAS_AVX2_KERNEL 0
+#endif
+
+namespace osrm
+{
+namespace util
+{
+namespace quantized_rectangles
+{
+
+namespace
+{
+// Decoded bounds are widened by one unit, which covers the rounding of step
+struct Frame
+{
+    explicit Frame(const RectangleInt2D &frame)
+        : min_lon(static_cast<std::int32_t>(frame.min_lon) - 1.),
+          min_lat(static_cast<std::int32_t>(frame.min_lat) - 1.),
+          lon_step((static_cast<double>(static_cast<std::int32_t>(frame.max_lon)) -
+                    static_cast<std::int32_t>(frame.min_lon)) /
+                   QUANTIZATION_STEPS),
+          lat_step((static_cast<double>(static_cast<std::int32_t>(frame.max_lat)) -
+                    static_cast<std::int32_t>(frame.min_lat)) /
+                   QUANTIZATION_STEPS)
+    {
+    }
+
+    double MinLon(const std::uint8_t value) const { return min_lon + value * lon_step; }
+    double MaxLon(const std::uint8_t value) const { return min_lon + 2. + value * lon_step; }
+    double MinLat(const std::uint8_t value) const { return min_lat + value * lat_step; }
+    double MaxLat(const std::uint8_t value) const { return min_lat + 2. + value * lat_step; }
+
+    double min_lon;
+    double min_lat;
+    double lon_step;
+    double lat_step;
+};
+
+void minSquaredDistancesScalar(const Frame &frame,
+                               const QuantizedRectangles &rectangles,
+                               const std::size_t first,
+                               const std::size_t count,
+                               const double lon,
+                               const double lat,
+                               std::uint64_t *distances)
+{
+    for (std::size_t index = first; index < count; ++index)
+    {
+        const double dx = std::max(std::max(frame.MinLon(rectangles.min_lons[index]) - lon,
+                                            lon - frame.MaxLon(rectangles.max_lons[index])),
+                                   0.);
+        const double dy = std::max(std::max(frame.MinLat(rectangles.min_lats[index]) - lat,
+                                            lat - frame.MaxLat(rectangles.max_lats[index])),
+                                   0.);
+        distances[index] = static_cast<std::uint64_t>(dx * dx + dy * dy);
+    }
+}
+
+#if OSRM_HAS_AVX2_KERNEL
+__attribute__((target("avx2"))) inline __m256d loadQuantizedAVX2(const std::uint8_t *values)
+{
+    std::int32_t bytes;
+    std::memcpy(&bytes, values, sizeof(bytes));
+    return _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes)));
+}
+
+// Four rectangles per iteration, the same operations as the scalar version in the same order
+__attribute__((target("avx2"))) void minSquaredDistancesAVX2(const Frame &frame,
+                                                             const QuantizedRectangles &rectangles,
+                                                             const std::size_t count,
+                                                             const double lon,
+                                                             const double lat,
+                                                             std::uint64_t *distances)
+{
+    const __m256d min_lon = _mm256_set1_pd(frame.min_lon);
+    const __m256d max_lon = _mm256_set1_pd(frame.min_lon + 2.);
+    const __m256d min_lat = _mm256_set1_pd(frame.min_lat);
+    const __m256d max_lat = _mm256_set1_pd(frame.min_lat + 2.);
+    const __m256d lon_step = _mm256_set1_pd(frame.lon_step);
+    const __m256d lat_step = _mm256_set1_pd(frame.lat_step);
+    const __m256d location_lon = _mm256_set1_pd(lon);
+    const __m256d location_lat = _mm256_set1_pd(lat);
+    const __m256d zero = _mm256_setzero_pd();
+
+    std::size_t index = 0;
+    for (; index + 4 <= count; index += 4)
+    {
+        const __m256d west = _mm256_add_pd(
+            min_lon, _mm256_mul_pd(loadQuantizedAVX2(rectangles.min_lons + index), lon_step));
+        const __m256d east = _mm256_add_pd(
+            max_lon, _mm256_mul_pd(loadQuantizedAVX2(rectangles.max_lons + index), lon_step));
+        const __m256d south = _mm256_add_pd(
+            min_lat, _mm256_mul_pd(loadQuantizedAVX2(rectangles.min_lats + index), lat_step));
+        const __m256d north = _mm256_add_pd(
+            max_lat, _mm256_mul_pd(loadQuantizedAVX2(rectangles.max_lats + index), lat_step));
+
+        const __m256d dx = _mm256_max_pd(_mm256_max_pd(_mm256_sub_pd(west, location_lon),
+                                                       _mm256_sub_pd(location_lon, east)),
+                                         zero);
+        const __m256d dy = _mm256_max_pd(_mm256_max_pd(_mm256_sub_pd(south, location_lat),
+                                                       _mm256_sub_pd(location_lat, north)),
+                                         zero);
+        alignas(32) double squared[4];
+        _mm256_store_pd(squared,
+                        _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+        for (std::size_t lane = 0; lane < 4; ++lane)
+        {
+            distances[index + lane] = static_cast<std::uint64_t>(squared[lane]);
+        }
+    }
+    minSquaredDistancesScalar(frame, rectangles, index, count, lon, lat, distances);
+}
+#endif
+}
+
+void minSquaredDistances(const RectangleInt2D &frame,
+                         const QuantizedRectangles &rectangles,
+                         const std::size_t count,
+                         const Coordinate location,
+                         std::uint64_t *distances)
+{
+    const Frame decoded_frame(frame);
+    const double lon = static_cast<std::int32_t>(location.lon);
+    const double lat = static_cast<std::int32_t>(location.lat);
+#if OSRM_HAS_AVX2_KERNEL
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2)
+    {
+        minSquaredDistancesAVX2(decoded_frame, rectangles, count, lon, lat, distances);
+        return;
+    }
+#endif
+    minSquaredDistancesScalar(decoded_frame, rectangles, 0, count, lon, lat, distances);
+}
+
+void intersects(const RectangleInt2D &frame,
+                const QuantizedRectangles &rectangles,
+                const std::size_t count,
+                const RectangleInt2D &rectangle,
+                bool *results)
+{
+    const Frame decoded_frame(frame);
+    const double min_lon = static_cast<std::int32_t>(rectangle.min_lon);
+    const double max_lon = static_cast<std::int32_t>(rectangle.max_lon);
+    const double min_lat = static_cast<std::int32_t>(rectangle.min_lat);
+    const double max_lat = static_cast<std::int32_t>(rectangle.max_lat);
+    for (std::size_t index = 0; index < count; ++index)
+    {
+        results[index] = decoded_frame.MinLon(rectangles.min_lons[index]) <= max_lon &&
+                         decoded_frame.MaxLon(rectangles.max_lons[index]) >= min_lon &&
+                         decoded_frame.MinLat(rectangles.min_lats[index]) <= max_lat &&
+                         decoded_frame.MaxLat(rectangles.max_lats[index]) >= min_lat;
+    }
+}
+}
+}
+}
@@ -0,0 +1,201 @@
+#include "util/region_polygon.hpp"
+
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/assert.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <string>
+
+namespace osrm
+{
+namespace util
+{
+
+namespace
+{
+// a band is searched for every node in the bounding box, so there are about as many bands as
+// segments
+const constexpr std::size_t MAX_NUMBER_OF_BANDS = 1 << 16;
+
+bool ReadLine(boost::filesystem::ifstream &input, std::string &line)
+{
+    while (std::getline(input, line))
+    {
+        boost::algorithm::trim(line);
+        if (!line.empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+RegionPolygon::RegionPolygon(const boost::filesystem::path &polygon_path)
+    : number_of_rings(0), min_lon(std::numeric_limits<std::int32_t>::max()),
+      max_lon(std::numeric_limits<std::int32_t>::min()),
+      min_lat(std::numeric_limits<std::int32_t>::max()),
+      max_lat(std::numeric_limits<std::int32_t>::min()), band_height(1)
+{
+    boost::filesystem::ifstream input(polygon_path);
+    if (!input)
+    {
+        throw exception("Could not open region polygon " + polygon_path.string());
+    }
+
+    std::string line;
+    // name of the polygon
+    if (!ReadLine(input, line))
+    {
+        throw exception("Region polygon " + polygon_path.string() + " is empty");
+    }
+
+    std::vector<Coordinate> ring;
+    while (ReadLine(input, line) && line != "END")
+    {
+        const bool is_hole = line.front() == '!';
+
+        ring.clear();
+        bool is_closed = false;
+        while (ReadLine(input, line))
+        {
+            if (line == "END")
+            {
+                is_closed = true;
+                break;
+            }
+            std::istringstream vertex(line);
+            double lon, lat;
+            if (!(vertex >> lon >> lat) || std::abs(lon) > 180. || std::abs(lat) > 90.)
+            {
+                throw exception("Invalid vertex \"" + line + "\" in region polygon " +
+                                      polygon_path.string());
+            }
+            ring.emplace_back(FloatLongitude{lon}, FloatLatitude{lat});
+        }
+        if (!is_closed)
+        {
+            throw exception("Region polygon " + polygon_path.string() +
+                                  " ends inside of a ring");
+        }
+        if (ring.size() < 3)
+        {
+            throw exception("Region polygon " + polygon_path.string() +
+                                  " has a ring with less than 3 vertices");
+        }
+        AddRing(ring, is_hole);
+    }
+
+    if (number_of_rings == 0 || segments.empty())
+    {
+        throw exception("Region polygon " + polygon_path.string() + " has no area");
+    }
+    BuildBands();
+}
+
+void RegionPolygon::AddRing(const std::vector<Coordinate> &ring, const bool is_hole)
+{
+    for (std::size_t index = 0; index < ring.size(); ++index)
+    {
+        const auto &first = ring[index];
+        const auto &second = ring[(index + 1) % ring.size()];
+
+        min_lon = std::min(min_lon, static_cast<std::int32_t>(first.lon));
+        max_lon = std::max(max_lon, static_cast<std::int32_t>(first.lon));
+        min_lat = std::min(min_lat, static_cast<std::int32_t>(first.lat));
+        max_lat = std::max(max_lat, static_cast<std::int32_t>(first.lat));
+
+        // horizontal segments are never crossed by a horizontal ray
+        if (first.lat != second.lat)
+        {
+            segments.push_back({first, second, is_hole});
+        }
+    }
+    ++number_of_rings;
+}
+
+void RegionPolygon::BuildBands()
+{
+    const auto number_of_bands = std::min(segments.size(), MAX_NUMBER_OF_BANDS);
+    band_height = (std::int64_t{max_lat} - min_lat) / number_of_bands + 1;
+
+    const auto band_of = [this](const FixedLatitude lat) {
+        return static_cast<std::size_t>((static_cast<std::int32_t>(lat) - std::int64_t{min_lat}) /
+                                        band_height);
+    };
+
+    band_offsets.assign(number_of_bands + 1, 0);
+    for (const auto &segment : segments)
+    {
+        const auto first_band = band_of(std::min(segment.first.lat, segment.second.lat));
+        const auto last_band = band_of(std::max(segment.first.lat, segment.second.lat));
+        for (auto band = first_band; band <= last_band; ++band)
+        {
+            ++band_offsets[band + 1];
+        }
+    }
+    std::partial_sum(band_offsets.begin(), band_offsets.end(), band_offsets.begin());
+
+    band_segments.resize(band_offsets.back());
+    std::vector<std::size_t> insert_position(band_offsets.begin(), band_offsets.end() - 1);
+    for (const auto index : irange<std::size_t>(0, segments.size()))
+    {
+        const auto &segment = segments[index];
+        const auto first_band = band_of(std::min(segment.first.lat, segment.second.lat));
+        const auto last_band = band_of(std::max(segment.first.lat, segment.second.lat));
+        for (auto band = first_band; band <= last_band; ++band)
+        {
+            band_segments[insert_position[band]++] = index;
+        }
+    }
+}
+
+// Counts the crossings of a ray from the coordinate towards the east with the segments of its
+// band, the coordinate is inside if it crosses an outer ring an odd number of times.
+bool RegionPolygon::Contains(const Coordinate coordinate) const
+{
+    const auto lon = static_cast<std::int32_t>(coordinate.lon);
+    const auto lat = static_cast<std::int32_t>(coordinate.lat);
+    if (lon < min_lon || lon > max_lon || lat < min_lat || lat > max_lat)
+    {
+        return false;
+    }
+
+    const auto band = static_cast<std::size_t>((std::int64_t{lat} - min_lat) / band_height);
+    BOOST_ASSERT(band + 1 < band_offsets.size());
+
+    bool is_in_outer_ring = false;
+    bool is_in_hole = false;
+    for (auto index = band_offsets[band]; index != band_offsets[band + 1]; ++index)
+    {
+        const auto &segment = segments[band_segments[index]];
+        const auto first_lon = static_cast<std::int32_t>(segment.first.lon);
+        const auto first_lat = static_cast<std::int32_t>(segment.first.lat);
+        const auto second_lon = static_cast<std::int32_t>(segment.second.lon);
+        const auto second_lat = static_cast<std::int32_t>(segment.second.lat);
+        if ((first_lat > lat) == (second_lat > lat))
+        {
+            continue;
+        }
+
+        const auto crossing_lon = first_lon + static_cast<double>(lat - first_lat) *
+                                                  (second_lon - first_lon) /
+                                                  (second_lat - first_lat);
+        if (lon < crossing_lon)
+        {
+            auto &is_inside = segment.is_hole ? is_in_hole : is_in_outer_ring;
+            is_inside = !is_inside;
+        }
+    }
+    return is_in_outer_ring && !is_in_hole;
+}
+}
+}
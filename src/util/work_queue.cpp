@@ -0,0 +1,101 @@
+#include "util/work_queue.hpp"
+#include "util/simple_logger.hpp"
+
+#include <boost/assert.hpp>
+
+#include <exception>
+#include <utility>
+
+namespace osrm
+{
+namespace util
+{
+
+WorkQueue::WorkQueue(const unsigned number_of_workers,
+                     const std::size_t capacity,
+                     std::vector<Lane> lanes_,
+                     std::function<void(unsigned)> initialize_worker)
+    : capacity(capacity), lanes(std::move(lanes_)),
+      initialize_worker(std::move(initialize_worker)), pending_tasks(lanes.size(), 0)
+{
+    BOOST_ASSERT(number_of_workers > 0);
+    workers.reserve(number_of_workers);
+    for (unsigned worker = 0; worker < number_of_workers; ++worker)
+    {
+        workers.emplace_back([this, worker] { RunWorker(worker); });
+    }
+}
+
+WorkQueue::~WorkQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    task_available.notify_all();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+bool WorkQueue::TryPush(const std::size_t lane, Task task)
+{
+    BOOST_ASSERT(lane < lanes.size());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopped || queue.size() >= capacity || pending_tasks[lane] >= lanes[lane].max_pending)
+        {
+            return false;
+        }
+        ++pending_tasks[lane];
+        queue.push(QueuedTask{lanes[lane].priority, next_sequence++, lane, std::move(task)});
+    }
+    task_available.notify_one();
+    return true;
+}
+
+std::size_t WorkQueue::NumberOfQueuedTasks() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size();
+}
+
+void WorkQueue::RunWorker(const unsigned worker)
+{
+    if (initialize_worker)
+    {
+        initialize_worker(worker);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        task_available.wait(lock, [this] { return stopped || !queue.empty(); });
+        if (stopped)
+        {
+            return;
+        }
+
+        // top() is const, the task is moved out right before the element is removed
+        auto task = std::move(const_cast<QueuedTask &>(queue.top()));
+        queue.pop();
+        lock.unlock();
+
+        try
+        {
+            task.task();
+        }
+        catch (const std::exception &e)
+        {
+            util::SimpleLogger().Write(logWARNING) << "[work queue] task failed: " << e.what();
+        }
+        // release whatever the task captured before admitting the next task of its lane
+        task.task = nullptr;
+
+        lock.lock();
+        --pending_tasks[task.lane];
+    }
+}
+}
+}
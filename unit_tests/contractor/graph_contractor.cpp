@@ -0,0 +1,142 @@
+#include "contractor/graph_contractor.hpp"
+#include "contractor/query_edge.hpp"
+#include "extractor/edge_based_edge.hpp"
+#include "util/deallocating_vector.hpp"
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <tbb/task_scheduler_init.h>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(graph_contractor)
+
+using namespace osrm;
+using namespace osrm::contractor;
+
+namespace
+{
+// A grid of one-way and two-way edges with random weights
+util::DeallocatingVector<extractor::EdgeBasedEdge> MakeGrid(const NodeID size)
+{
+    std::mt19937 generator(7);
+    util::DeallocatingVector<extractor::EdgeBasedEdge> edges;
+    const auto add_edge = [&](const NodeID source, const NodeID target) {
+        const EdgeWeight weight = 1 + generator() % 1000;
+        const bool forward = generator() % 4 != 0;
+        const bool backward = !forward || generator() % 2 != 0;
+        edges.push_back(
+            extractor::EdgeBasedEdge{source, target, source, weight, forward, backward});
+    };
+    for (const auto row : util::irange<NodeID>(0, size))
+    {
+        for (const auto column : util::irange<NodeID>(0, size))
+        {
+            const auto node = row * size + column;
+            if (column + 1 < size)
+            {
+                add_edge(node, node + 1);
+            }
+            if (row + 1 < size)
+            {
+                add_edge(node, node + size);
+            }
+        }
+    }
+    return edges;
+}
+
+struct Hierarchy
+{
+    std::vector<QueryEdge> edges;
+    std::vector<float> node_levels;
+    std::vector<bool> is_core_node;
+};
+
+Hierarchy GetHierarchy(GraphContractor &contractor)
+{
+    Hierarchy hierarchy;
+    util::DeallocatingVector<QueryEdge> edges;
+    contractor.GetEdges(edges);
+    hierarchy.edges.assign(edges.begin(), edges.end());
+    // the data are bit fields that std::tie can not refer to
+    const auto key = [](const QueryEdge &edge) {
+        return std::tuple<NodeID, NodeID, int, NodeID, bool, bool, bool>{edge.source,
+                                                                         edge.target,
+                                                                         edge.data.distance,
+                                                                         edge.data.id,
+                                                                         edge.data.shortcut,
+                                                                         edge.data.forward,
+                                                                         edge.data.backward};
+    };
+    std::sort(hierarchy.edges.begin(),
+              hierarchy.edges.end(),
+              [&key](const QueryEdge &lhs, const QueryEdge &rhs) { return key(lhs) < key(rhs); });
+    contractor.GetNodeLevels(hierarchy.node_levels);
+    contractor.GetCoreMarker(hierarchy.is_core_node);
+    return hierarchy;
+}
+}
+
+// A contraction that is interrupted after every round and resumed from its checkpoint, which
+// includes the rounds after the graph was flushed, ends with the same hierarchy as one that runs
+// through
+BOOST_AUTO_TEST_CASE(resume_from_checkpoint_test)
+{
+    // with more threads the order of the edges of a node differs between any two runs
+    tbb::task_scheduler_init init(1);
+    const NodeID size = 40;
+    const auto checkpoint_path =
+        (boost::filesystem::temp_directory_path() /
+         boost::filesystem::unique_path("graph_contractor_test_%%%%%%%%.checkpoint"))
+            .string();
+
+    auto uninterrupted_edges = MakeGrid(size);
+    GraphContractor uninterrupted_contractor(
+        size * size, uninterrupted_edges, {}, std::vector<EdgeWeight>(size * size, 1));
+    BOOST_REQUIRE(uninterrupted_contractor.Run());
+    const auto uninterrupted = GetHierarchy(uninterrupted_contractor);
+
+    std::atomic<bool> interrupted{true};
+    unsigned number_of_runs = 0;
+    Hierarchy resumed;
+    while (true)
+    {
+        auto edges = MakeGrid(size);
+        GraphContractor contractor(
+            size * size, edges, {}, std::vector<EdgeWeight>(size * size, 1));
+        // only interruptions write checkpoints
+        contractor.SetCheckpoint(checkpoint_path, 3600.);
+        contractor.SetInterruptFlag(interrupted);
+        ++number_of_runs;
+        BOOST_REQUIRE_LT(number_of_runs, size * size);
+        if (contractor.Run())
+        {
+            resumed = GetHierarchy(contractor);
+            break;
+        }
+        BOOST_REQUIRE(boost::filesystem::exists(checkpoint_path));
+    }
+    BOOST_CHECK_GT(number_of_runs, 2);
+    // a finished contraction removes its checkpoint
+    BOOST_CHECK(!boost::filesystem::exists(checkpoint_path));
+    BOOST_CHECK(!boost::filesystem::exists(checkpoint_path + ".external"));
+
+    BOOST_CHECK(resumed.node_levels == uninterrupted.node_levels);
+    BOOST_CHECK(resumed.is_core_node == uninterrupted.is_core_node);
+    BOOST_REQUIRE_EQUAL(resumed.edges.size(), uninterrupted.edges.size());
+    for (const auto index : util::irange<std::size_t>(0, resumed.edges.size()))
+    {
+        BOOST_CHECK(resumed.edges[index] == uninterrupted.edges[index]);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,192 @@
+#include "contractor/query_graph_update.hpp"
+
+#include "util/integer_range.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(query_graph_update)
+
+using namespace osrm;
+using namespace osrm::contractor;
+using namespace osrm::contractor::query_graph_update;
+
+namespace
+{
+struct TestGraph
+{
+    std::vector<GraphNode> nodes;
+    std::vector<GraphEdge> edges;
+
+    QueryGraphData GetData()
+    {
+        QueryGraphData data;
+        data.nodes = nodes.data();
+        data.edges = edges.data();
+        data.number_of_nodes = nodes.size() - 1;
+        data.geometry_indices = nullptr;
+        data.geometry_list = nullptr;
+        data.number_of_geometry_segments = 0;
+        return data;
+    }
+};
+
+GraphEdge MakeEdge(const NodeID target,
+                   const int weight,
+                   const bool forward,
+                   const bool backward,
+                   const bool shortcut = false,
+                   const NodeID id = 0)
+{
+    GraphEdge edge;
+    edge.target = target;
+    edge.data.id = id;
+    edge.data.shortcut = shortcut;
+    edge.data.distance = weight;
+    edge.data.forward = forward;
+    edge.data.backward = backward;
+    return edge;
+}
+
+// The graph 1 - 0 - 2 - 3 with the one-way detour 3 -> 4 -> 1, contracted in the order 0, 4, 2.
+// Contracting 0 adds the shortcut 2 - 1, contracting 4 the shortcut 3 -> 1 and contracting 2 the
+// shortcut of a shortcut 1 - 3. Every edge is stored at its node that was contracted first.
+// The edges of 0 to 1 have a different weight in each direction.
+TestGraph MakeContractedGraph()
+{
+    TestGraph graph;
+    const std::vector<std::vector<GraphEdge>> adjacency = {
+        // 0
+        {MakeEdge(1, 10, true, false), MakeEdge(1, 12, false, true), MakeEdge(2, 20, true, true)},
+        // 1
+        {MakeEdge(3, 12, false, true, true, 4), MakeEdge(3, 47, true, true, true, 2)},
+        // 2
+        {MakeEdge(1, 32, true, true, true, 0), MakeEdge(3, 15, true, true)},
+        // 3
+        {},
+        // 4
+        {MakeEdge(3, 5, false, true), MakeEdge(1, 7, true, false)}};
+
+    for (const auto &node_edges : adjacency)
+    {
+        GraphNode node;
+        node.first_edge = graph.edges.size();
+        graph.nodes.push_back(node);
+        graph.edges.insert(graph.edges.end(), node_edges.begin(), node_edges.end());
+    }
+    GraphNode sentinel;
+    sentinel.first_edge = graph.edges.size();
+    graph.nodes.push_back(sentinel);
+    return graph;
+}
+
+// Weight of from -> middle -> to over the edges stored at the middle node
+int ViaMiddle(const QueryGraphData &data, const NodeID middle, const NodeID from, const NodeID to)
+{
+    int first = INVALID_EDGE_WEIGHT;
+    int second = INVALID_EDGE_WEIGHT;
+    for (const auto edge : util::irange(data.BeginEdges(middle), data.EndEdges(middle)))
+    {
+        const auto &edge_data = data.edges[edge].data;
+        if (data.edges[edge].target == from && edge_data.backward)
+        {
+            first = std::min<int>(first, edge_data.distance);
+        }
+        if (data.edges[edge].target == to && edge_data.forward)
+        {
+            second = std::min<int>(second, edge_data.distance);
+        }
+    }
+    BOOST_REQUIRE(first != INVALID_EDGE_WEIGHT && second != INVALID_EDGE_WEIGHT);
+    return first + second;
+}
+
+// Every shortcut has the weight of its two middle edges, the larger one of both directions
+void CheckShortcuts(const QueryGraphData &data)
+{
+    for (const auto node : util::irange<NodeID>(0, data.number_of_nodes))
+    {
+        for (const auto edge : util::irange(data.BeginEdges(node), data.EndEdges(node)))
+        {
+            const auto &edge_data = data.edges[edge].data;
+            if (!edge_data.shortcut)
+            {
+                continue;
+            }
+            const auto target = data.edges[edge].target;
+            int weight = 0;
+            if (edge_data.forward)
+            {
+                weight = std::max(weight, ViaMiddle(data, edge_data.id, node, target));
+            }
+            if (edge_data.backward)
+            {
+                weight = std::max(weight, ViaMiddle(data, edge_data.id, target, node));
+            }
+            BOOST_CHECK_EQUAL(edge_data.distance, weight);
+        }
+    }
+}
+
+int GetWeight(const QueryGraphData &data, const EdgeID edge)
+{
+    return data.edges[edge].data.distance;
+}
+}
+
+BOOST_AUTO_TEST_CASE(shortcut_layers_test)
+{
+    auto graph = MakeContractedGraph();
+    const auto layers = GetShortcutLayers(graph.GetData());
+
+    // 2 needs the edges of 0, and 1 the ones of 4 and of 2
+    BOOST_REQUIRE_EQUAL(layers.size(), 3);
+    BOOST_CHECK(layers[0] == std::vector<NodeID>({0, 3, 4}));
+    BOOST_CHECK(layers[1] == std::vector<NodeID>({2}));
+    BOOST_CHECK(layers[2] == std::vector<NodeID>({1}));
+}
+
+BOOST_AUTO_TEST_CASE(repair_shortcuts_test)
+{
+    auto graph = MakeContractedGraph();
+    const auto data = graph.GetData();
+    CheckShortcuts(data);
+
+    // nothing changed, nothing to repair
+    std::vector<char> is_changed(data.number_of_nodes, false);
+    BOOST_CHECK_EQUAL(RepairShortcuts(data, is_changed), 0);
+
+    // 0 - 2 gets slower, which changes 2 - 1 and with it the shortcut of a shortcut 1 - 3
+    graph.edges[2].data.distance = 50;
+    is_changed[0] = true;
+    BOOST_CHECK_EQUAL(RepairShortcuts(data, is_changed), 2);
+    CheckShortcuts(data);
+    // 1 -> 0 -> 2 takes 12 + 50 and 2 -> 0 -> 1 takes 50 + 10, the larger weight is kept
+    BOOST_CHECK_EQUAL(GetWeight(data, 5), 62);
+    BOOST_CHECK_EQUAL(GetWeight(data, 4), 62 + 15);
+    BOOST_CHECK_EQUAL(GetWeight(data, 3), 12);
+    BOOST_CHECK(is_changed[2]);
+    BOOST_CHECK(is_changed[1]);
+
+    // 4 -> 1 gets slower, only the one-way shortcut 3 -> 1 changes
+    std::fill(is_changed.begin(), is_changed.end(), false);
+    graph.edges[8].data.distance = 17;
+    is_changed[4] = true;
+    BOOST_CHECK_EQUAL(RepairShortcuts(data, is_changed), 1);
+    CheckShortcuts(data);
+    BOOST_CHECK_EQUAL(GetWeight(data, 3), 5 + 17);
+    BOOST_CHECK_EQUAL(GetWeight(data, 4), 62 + 15);
+    BOOST_CHECK(!is_changed[2]);
+
+    // an excluded edge makes its shortcuts excluded as well
+    std::fill(is_changed.begin(), is_changed.end(), false);
+    graph.edges[6].data.distance = EXCLUDED_EDGE_WEIGHT;
+    is_changed[2] = true;
+    BOOST_CHECK_EQUAL(RepairShortcuts(data, is_changed), 1);
+    BOOST_CHECK_EQUAL(GetWeight(data, 4), EXCLUDED_EDGE_WEIGHT);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -75,4 +75,85 @@ BOOST_AUTO_TEST_CASE(hint_encoding_decoding_roundtrip_bytewise)
                            reinterpret_cast<const unsigned char *>(&decoded)));
 }
 
+BOOST_AUTO_TEST_CASE(compact_hint_encoding_decoding_roundtrip)
+{
+    using namespace osrm::engine;
+    using namespace osrm::util;
+
+    const Coordinate input_location{FloatLongitude{7.419758}, FloatLatitude{43.731142}};
+    const Coordinate location{FloatLongitude{7.419505}, FloatLatitude{43.736825}};
+    const PhantomNode phantom{SegmentID{1, true},
+                              SegmentID{2, true},
+                              3,
+                              40,
+                              50,
+                              600,
+                              700,
+                              8,
+                              9,
+                              false,
+                              10,
+                              location,
+                              input_location,
+                              2,
+                              1,
+                              1};
+    const std::uint32_t checksum = 0xDEADBEEF;
+
+    const Hint hint{phantom, checksum};
+    const auto base64 = hint.ToCompactBase64();
+
+    BOOST_CHECK_EQUAL(base64.size(), ENCODED_COMPACT_HINT_SIZE);
+    BOOST_CHECK(0 == std::count(begin(base64), end(base64), '+'));
+    BOOST_CHECK(0 == std::count(begin(base64), end(base64), '/'));
+    BOOST_CHECK(0 == std::count(begin(base64), end(base64), '='));
+
+    const auto decoded = Hint::FromBase64(base64);
+    BOOST_CHECK(decoded.IsCompact());
+    BOOST_CHECK(!hint.IsCompact());
+
+    // everything but the offsets and the input location is kept
+    BOOST_CHECK_EQUAL(decoded.phantom.forward_segment_id.id, 1);
+    BOOST_CHECK_EQUAL(decoded.phantom.reverse_segment_id.id, 2);
+    BOOST_CHECK(decoded.phantom.forward_segment_id.enabled);
+    BOOST_CHECK(decoded.phantom.reverse_segment_id.enabled);
+    BOOST_CHECK_EQUAL(decoded.phantom.name_id, 3);
+    BOOST_CHECK_EQUAL(decoded.phantom.forward_weight, 40);
+    BOOST_CHECK_EQUAL(decoded.phantom.reverse_weight, 50);
+    BOOST_CHECK_EQUAL(decoded.phantom.forward_packed_geometry_id, 8);
+    BOOST_CHECK_EQUAL(decoded.phantom.reverse_packed_geometry_id, 9);
+    BOOST_CHECK_EQUAL(decoded.phantom.component.id, 10);
+    BOOST_CHECK_EQUAL(decoded.phantom.location, location);
+    BOOST_CHECK_EQUAL(decoded.phantom.fwd_segment_position, 2);
+
+    // only valid for the same dataset and input coordinate
+    BOOST_CHECK(decoded.IsValid(input_location, 100, checksum));
+    BOOST_CHECK(!decoded.IsValid(input_location, 100, checksum + 1));
+    BOOST_CHECK(!decoded.IsValid(location, 100, checksum));
+    BOOST_CHECK(!decoded.IsValid(input_location, 1, checksum));
+
+    // the full encoding is still accepted
+    BOOST_CHECK_EQUAL(hint.ToBase64().size(), ENCODED_HINT_SIZE);
+    BOOST_CHECK(Hint::FromBase64(hint.ToBase64()).IsValid(input_location, 100, checksum));
+}
+
+BOOST_AUTO_TEST_CASE(encoding_in_pieces)
+{
+    using namespace osrm::engine;
+
+    const std::string bytes = "the matrix arrives row by row";
+    for (std::size_t piece_size = 1; piece_size <= 7; ++piece_size)
+    {
+        Base64Encoder encoder;
+        std::string encoded;
+        for (std::size_t begin = 0; begin < bytes.size(); begin += piece_size)
+        {
+            encoded += encoder.Append(bytes.data() + begin,
+                                      std::min(piece_size, bytes.size() - begin));
+        }
+        encoded += encoder.Finish();
+        BOOST_CHECK_EQUAL(encoded, encodeBase64(bytes));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,188 @@
+#include "engine/core_landmarks.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(core_landmarks)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+// Stores every directed edge at both nodes like the query graph does
+struct TestGraph
+{
+    struct EdgeData
+    {
+        EdgeWeight distance;
+        bool forward;
+        bool backward;
+    };
+
+    struct Edge
+    {
+        NodeID target;
+        EdgeData data;
+    };
+
+    TestGraph(const std::size_t number_of_nodes, const std::vector<NodeID> &non_core_nodes)
+        : adjacency(number_of_nodes), core(number_of_nodes, true)
+    {
+        for (const auto node : non_core_nodes)
+            core[node] = false;
+    }
+
+    void AddEdge(const NodeID source, const NodeID target, const EdgeWeight weight)
+    {
+        adjacency[source].push_back({target, {weight, true, false}});
+        adjacency[target].push_back({source, {weight, false, true}});
+        edges.emplace_back(source, target, weight);
+    }
+
+    std::size_t GetNumberOfNodes() const { return adjacency.size(); }
+    bool IsCoreNode(const NodeID node) const { return core[node]; }
+
+    std::vector<std::size_t> GetAdjacentEdgeRange(const NodeID node) const
+    {
+        std::vector<std::size_t> range;
+        for (const auto index : util::irange<std::size_t>(0, adjacency[node].size()))
+            range.push_back(node * MAX_DEGREE + index);
+        return range;
+    }
+    NodeID GetTarget(const std::size_t edge) const { return GetEdge(edge).target; }
+    const EdgeData &GetEdgeData(const std::size_t edge) const { return GetEdge(edge).data; }
+
+    const Edge &GetEdge(const std::size_t edge) const
+    {
+        return adjacency[edge / MAX_DEGREE][edge % MAX_DEGREE];
+    }
+
+    static const constexpr std::size_t MAX_DEGREE = 16;
+    std::vector<std::vector<Edge>> adjacency;
+    std::vector<bool> core;
+    std::vector<std::tuple<NodeID, NodeID, EdgeWeight>> edges;
+};
+
+// 0..7 form a one-way ring with chords in both directions, 8 is not in the core and 9 is
+// disconnected from everything
+TestGraph MakeGraph()
+{
+    TestGraph graph(10, {8});
+    for (const auto node : util::irange<NodeID>(0, 8))
+        graph.AddEdge(node, (node + 1) % 8, 3 + node % 3);
+    graph.AddEdge(0, 4, 7);
+    graph.AddEdge(4, 0, 9);
+    graph.AddEdge(2, 6, 5);
+    graph.AddEdge(6, 2, 4);
+    graph.AddEdge(1, 8, 1);
+    graph.AddEdge(8, 5, 1);
+    return graph;
+}
+
+std::vector<EdgeWeight> GetCoreDistances(const TestGraph &graph, const NodeID source)
+{
+    // Bellman-Ford is good enough for a handful of nodes
+    std::vector<EdgeWeight> distance(graph.GetNumberOfNodes(), INVALID_EDGE_WEIGHT);
+    distance[source] = 0;
+    for (const auto iteration : util::irange<std::size_t>(0, graph.GetNumberOfNodes()))
+    {
+        (void)iteration;
+        for (const auto &edge : graph.edges)
+        {
+            const auto from = std::get<0>(edge);
+            const auto to = std::get<1>(edge);
+            if (!graph.IsCoreNode(from) || !graph.IsCoreNode(to) ||
+                distance[from] == INVALID_EDGE_WEIGHT)
+                continue;
+            distance[to] = std::min(distance[to], distance[from] + std::get<2>(edge));
+        }
+    }
+    return distance;
+}
+}
+
+BOOST_AUTO_TEST_CASE(number_of_landmarks_is_limited_by_core)
+{
+    const auto graph = MakeGraph();
+    BOOST_CHECK_EQUAL(CoreLandmarks(graph, 4).GetNumberOfLandmarks(), 4);
+    BOOST_CHECK_EQUAL(CoreLandmarks(graph, 100).GetNumberOfLandmarks(), 9);
+}
+
+BOOST_AUTO_TEST_CASE(potential_is_consistent_lower_bound)
+{
+    const auto graph = MakeGraph();
+    const CoreLandmarks landmarks(graph, 3);
+
+    for (const auto source : util::irange<NodeID>(0, 8))
+    {
+        const auto from_source = GetCoreDistances(graph, source);
+        for (const auto target : util::irange<NodeID>(0, 8))
+        {
+            const auto potential = landmarks.GetPotential({{source, 0}}, {{target, 0}});
+
+            // the forward key of the source and the reverse key of the target stay a lower
+            // bound of the shortest path
+            BOOST_CHECK_LE(potential(source), from_source[target]);
+            BOOST_CHECK_LE(-potential(target), from_source[target]);
+
+            // neither search ever sees a negative reduced edge weight
+            for (const auto &edge : graph.edges)
+            {
+                const auto from = std::get<0>(edge);
+                const auto to = std::get<1>(edge);
+                if (!graph.IsCoreNode(from) || !graph.IsCoreNode(to))
+                    continue;
+                BOOST_CHECK_LE(potential(from) - potential(to), 2 * std::get<2>(edge));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(initial_weights_shift_potential)
+{
+    const auto graph = MakeGraph();
+    const CoreLandmarks landmarks(graph, 2);
+    const auto from_zero = GetCoreDistances(graph, 0);
+    const auto from_three = GetCoreDistances(graph, 3);
+
+    const auto potential = landmarks.GetPotential({{0, 4}, {3, 1}}, {{6, 2}});
+    const auto shortest = std::min(4 + from_zero[6], 1 + from_three[6]) + 2;
+    BOOST_CHECK_LE(2 * 4 + potential(0), 2 * shortest);
+    BOOST_CHECK_LE(2 * 1 + potential(3), 2 * shortest);
+    BOOST_CHECK_LE(2 * 2 - potential(6), 2 * shortest);
+}
+
+BOOST_AUTO_TEST_CASE(disconnected_nodes_are_unreachable)
+{
+    const auto graph = MakeGraph();
+    const CoreLandmarks landmarks(graph, 9);
+
+    const auto potential = landmarks.GetPotential({{0, 0}}, {{5, 0}});
+    BOOST_CHECK(potential(9) == CoreLandmarks::Potential::UNREACHABLE);
+    BOOST_CHECK(potential(3) != CoreLandmarks::Potential::UNREACHABLE);
+}
+
+BOOST_AUTO_TEST_CASE(stored_distances_give_same_potential)
+{
+    const auto graph = MakeGraph();
+    const CoreLandmarks computed(graph, 3);
+    const std::vector<EdgeWeight> stored(computed.GetDistances(),
+                                         computed.GetDistances() + computed.GetNumberOfDistances());
+    const CoreLandmarks loaded(graph, stored.data(), stored.size());
+    BOOST_CHECK_EQUAL(loaded.GetNumberOfLandmarks(), 3);
+
+    const auto computed_potential = computed.GetPotential({{1, 2}}, {{6, 0}, {7, 3}});
+    const auto loaded_potential = loaded.GetPotential({{1, 2}}, {{6, 0}, {7, 3}});
+    for (const auto node : util::irange<NodeID>(0, graph.GetNumberOfNodes()))
+        BOOST_CHECK_EQUAL(computed_potential(node), loaded_potential(node));
+
+    // the core has nine nodes, two distances each per landmark
+    BOOST_CHECK_THROW(CoreLandmarks(graph, stored.data(), 17), util::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,158 @@
+#include "engine/dataset_generation.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(dataset_generation)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+const constexpr unsigned DELETED = 0;
+
+// Stands in for the shared memory: two data regions that the generations alternate between
+struct TestMemory
+{
+    std::atomic<unsigned> timestamp{1};
+    // the generation a region holds, DELETED once the publisher deleted it
+    std::atomic<unsigned> region_generation[2];
+    std::atomic<int> queries[2];
+
+    TestMemory()
+    {
+        region_generation[0] = DELETED;
+        region_generation[1] = 1;
+        queries[0] = 0;
+        queries[1] = 0;
+    }
+
+    // Publishes the next generation like osrm-datastore does
+    void Publish()
+    {
+        const unsigned generation = timestamp + 1;
+        const unsigned region = generation % 2;
+        region_generation[region] = generation;
+        timestamp = generation;
+        while (queries[1 - region] > 0)
+        {
+            std::this_thread::yield();
+        }
+        region_generation[1 - region] = DELETED;
+    }
+};
+
+struct TestGeneration
+{
+    const TestMemory &memory;
+    unsigned generation;
+
+    bool IsOutdated() const { return memory.timestamp != generation; }
+    unsigned GetDataRegion() const { return generation % 2; }
+    bool IsIntact() const { return memory.region_generation[GetDataRegion()] == generation; }
+};
+
+struct TestLock
+{
+    TestMemory &memory;
+    std::mutex reload_mutex;
+
+    void IncreaseQueryCount(const unsigned region) { ++memory.queries[region]; }
+    void DecreaseQueryCount(const unsigned region) { --memory.queries[region]; }
+};
+
+// Loading a generation takes a while, like warming up a facade
+std::shared_ptr<TestGeneration> Load(const TestMemory &memory)
+{
+    auto generation = std::make_shared<TestGeneration>(TestGeneration{memory, memory.timestamp});
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    return generation;
+}
+}
+
+// A query must not run on a generation that got outdated while another thread loads the new one
+BOOST_AUTO_TEST_CASE(outdated_while_loading_test)
+{
+    TestMemory memory;
+    TestLock lock{memory, {}};
+    auto current = std::make_shared<TestGeneration>(TestGeneration{memory, 1});
+    const auto load = [&memory] { return Load(memory); };
+
+    // another thread loads the new generation, the previous one is deleted already
+    std::unique_lock<std::mutex> loading(lock.reload_mutex);
+    memory.Publish();
+    BOOST_CHECK_EQUAL(memory.region_generation[1], DELETED);
+
+    auto query = std::async(std::launch::async, [&] {
+        auto generation = AcquireGeneration(lock, current, load);
+        lock.DecreaseQueryCount(generation->GetDataRegion());
+        return generation->generation;
+    });
+    BOOST_CHECK(query.wait_for(std::chrono::milliseconds(50)) != std::future_status::ready);
+    // the query is not counted while it waits
+    BOOST_CHECK_EQUAL(memory.queries[1], 0);
+
+    loading.unlock();
+    BOOST_CHECK_EQUAL(query.get(), 2);
+    BOOST_CHECK_EQUAL(current->generation, 2);
+}
+
+// Queries keep running while new generations get published, none of them may see its data
+// region deleted as long as it is counted
+BOOST_AUTO_TEST_CASE(reload_while_querying_test)
+{
+    TestMemory memory;
+    TestLock lock{memory, {}};
+    auto current = std::make_shared<TestGeneration>(TestGeneration{memory, 1});
+    const auto load = [&memory] { return Load(memory); };
+
+    std::atomic<bool> publishing{true};
+    std::atomic<unsigned> broken_queries{0};
+    std::atomic<unsigned> queries{0};
+    std::vector<std::thread> query_threads;
+    for (unsigned thread = 0; thread < 4; ++thread)
+    {
+        query_threads.emplace_back([&] {
+            while (publishing)
+            {
+                const auto generation = AcquireGeneration(lock, current, load);
+                for (unsigned step = 0; step < 10; ++step)
+                {
+                    if (!generation->IsIntact())
+                    {
+                        ++broken_queries;
+                    }
+                    std::this_thread::yield();
+                }
+                lock.DecreaseQueryCount(generation->GetDataRegion());
+                ++queries;
+            }
+        });
+    }
+
+    for (unsigned update = 0; update < 50; ++update)
+    {
+        memory.Publish();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    publishing = false;
+    for (auto &thread : query_threads)
+    {
+        thread.join();
+    }
+
+    BOOST_CHECK_GT(queries, 0);
+    BOOST_CHECK_EQUAL(broken_queries, 0);
+    BOOST_CHECK_EQUAL(memory.queries[0], 0);
+    BOOST_CHECK_EQUAL(memory.queries[1], 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
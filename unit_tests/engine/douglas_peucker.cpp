@@ -114,4 +114,52 @@ BOOST_AUTO_TEST_CASE(remove_second_node_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(significance_matches_simplification)
+{
+    // a zig-zag of growing amplitude, so every zoom level keeps a different number of points
+    std::vector<util::Coordinate> coordinates;
+    for (int idx = 0; idx < 200; ++idx)
+    {
+        const auto amplitude = (idx % 2 == 0 ? 1 : -1) * 1e-6 * (idx % 17) * (idx % 17) * idx;
+        coordinates.push_back(util::Coordinate{util::FloatLongitude{7.4 + 1e-3 * idx},
+                                               util::FloatLatitude{43.7 + amplitude}});
+    }
+
+    DouglasPeucker simplifier;
+    simplifier.ComputeSignificance(coordinates.begin(), coordinates.end());
+    BOOST_CHECK_EQUAL(simplifier.GetSignificance().size(), coordinates.size());
+
+    for (unsigned z = 0; z < detail::DOUGLAS_PEUCKER_THRESHOLDS_SIZE; z++)
+    {
+        const auto expected = douglasPeucker(coordinates, z);
+        std::vector<util::Coordinate> filtered;
+        simplifier.Filter(coordinates.begin(), z, filtered);
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            filtered.begin(), filtered.end(), expected.begin(), expected.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(reused_simplifier)
+{
+    std::vector<util::Coordinate> coordinates = {
+        util::Coordinate{util::FloatLongitude{5}, util::FloatLatitude{5}},
+        util::Coordinate{util::FloatLongitude{12.5}, util::FloatLatitude{12.6096298302}},
+        util::Coordinate{util::FloatLongitude{20}, util::FloatLatitude{20}},
+        util::Coordinate{util::FloatLongitude{25}, util::FloatLatitude{5}}};
+
+    DouglasPeucker simplifier;
+    std::vector<util::Coordinate> output;
+    simplifier.Simplify(coordinates.begin(), coordinates.end(), 10, output);
+    BOOST_CHECK_EQUAL(output.size(), 3);
+
+    // a shorter geometry afterwards, the output is appended to
+    simplifier.Simplify(coordinates.begin() + 2, coordinates.end(), 10, output);
+    BOOST_REQUIRE_EQUAL(output.size(), 5);
+    BOOST_CHECK_EQUAL(output[3], coordinates[2]);
+    BOOST_CHECK_EQUAL(output[4], coordinates[3]);
+
+    simplifier.Simplify(coordinates.begin(), coordinates.begin() + 1, 10, output);
+    BOOST_CHECK_EQUAL(output.size(), 5);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
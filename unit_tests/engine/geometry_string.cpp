@@ -7,6 +7,8 @@
 #include <osrm/coordinate.hpp>
 
 #include <cmath>
+#include <cstdint>
+#include <string>
 #include <vector>
 
 BOOST_AUTO_TEST_SUITE(polyline)
@@ -44,4 +46,37 @@ BOOST_AUTO_TEST_CASE(decode)
     }
 }
 
+BOOST_AUTO_TEST_CASE(encode)
+{
+    // Example from the polyline algorithm documentation
+    std::vector<util::Coordinate> coords = {
+        {util::FloatLongitude{-120.2}, util::FloatLatitude{38.5}},
+        {util::FloatLongitude{-120.95}, util::FloatLatitude{40.7}},
+        {util::FloatLongitude{-126.453}, util::FloatLatitude{43.252}}};
+
+    BOOST_CHECK_EQUAL(encodePolyline(coords.begin(), coords.end()),
+                      "_p~iF~ps|U_ulLnnqC_mqNvxq`@");
+    BOOST_CHECK_EQUAL(encodePolyline(coords.end(), coords.end()), "");
+}
+
+BOOST_AUTO_TEST_CASE(encode_decode_polyline6)
+{
+    // six decimal places survive polyline6, five decimal places round the last one away
+    std::vector<util::Coordinate> coords = {
+        {util::FloatLongitude{7.416351}, util::FloatLatitude{43.731142}},
+        {util::FloatLongitude{7.419012}, util::FloatLatitude{43.730601}},
+        {util::FloatLongitude{-179.999999}, util::FloatLatitude{-89.999999}}};
+
+    const auto polyline6 =
+        encodePolyline(coords.begin(), coords.end(), detail::POLYLINE6_PRECISION);
+    BOOST_CHECK(decodePolyline(polyline6, detail::POLYLINE6_PRECISION) == coords);
+
+    const auto polyline = encodePolyline(coords.begin(), coords.end());
+    const auto rounded = decodePolyline(polyline);
+    BOOST_REQUIRE_EQUAL(rounded.size(), coords.size());
+    BOOST_CHECK_EQUAL(static_cast<std::int32_t>(rounded[0].lat), 43731140);
+    BOOST_CHECK_EQUAL(static_cast<std::int32_t>(rounded[0].lon), 7416350);
+    BOOST_CHECK_EQUAL(static_cast<std::int32_t>(rounded[2].lon), -180000000);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
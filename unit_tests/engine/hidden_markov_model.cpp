@@ -0,0 +1,74 @@
+#include "engine/map_matching/hidden_markov_model.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(hidden_markov_model)
+
+using namespace osrm;
+using namespace osrm::engine;
+using namespace osrm::engine::map_matching;
+
+using Candidates = std::vector<std::vector<int>>;
+
+BOOST_AUTO_TEST_CASE(layers_follow_candidates)
+{
+    const Candidates candidates{{1, 2}, {}, {3, 4, 5}};
+    HiddenMarkovModel<Candidates> model(candidates);
+
+    BOOST_CHECK_EQUAL(model.viterbi.size(), 3);
+    BOOST_CHECK_EQUAL(model.viterbi[0].size(), 2);
+    BOOST_CHECK_EQUAL(model.viterbi[1].size(), 0);
+    BOOST_CHECK_EQUAL(model.pruned[2].size(), 3);
+    // the layers are one array
+    BOOST_CHECK(model.viterbi[0].end() == model.viterbi[2].begin());
+
+    for (const auto value : model.viterbi[2])
+    {
+        BOOST_CHECK_EQUAL(value, IMPOSSIBLE_LOG_PROB);
+    }
+    BOOST_CHECK(model.breakage[0] && model.breakage[1] && model.breakage[2]);
+}
+
+BOOST_AUTO_TEST_CASE(initialize_skips_broken_layers)
+{
+    const Candidates candidates{{1}, {2, 3}, {4}};
+    HiddenMarkovModel<Candidates> model(candidates);
+    model.emission_log_probabilities[0][0] = IMPOSSIBLE_LOG_PROB;
+    model.emission_log_probabilities[1][0] = -2.;
+    model.emission_log_probabilities[1][1] = -1.;
+    model.emission_log_probabilities[2][0] = -3.;
+
+    BOOST_CHECK_EQUAL(model.initialize(0), 1);
+    BOOST_CHECK(model.breakage[0]);
+    BOOST_CHECK(!model.breakage[1]);
+    BOOST_CHECK_EQUAL(model.viterbi[1][1], -1.);
+    BOOST_CHECK(!model.pruned[1][1]);
+    BOOST_CHECK_EQUAL(model.parents[1][1].first, 1);
+    BOOST_CHECK_EQUAL(model.parents[1][1].second, 1);
+
+    // clearing keeps the layers before the given one
+    model.viterbi[2][0] = -4.;
+    model.Clear(2);
+    BOOST_CHECK_EQUAL(model.viterbi[1][1], -1.);
+    BOOST_CHECK_EQUAL(model.viterbi[2][0], IMPOSSIBLE_LOG_PROB);
+    BOOST_CHECK(model.pruned[2][0]);
+}
+
+BOOST_AUTO_TEST_CASE(storage_is_reused)
+{
+    const Candidates candidates{{1, 2}, {3, 4}};
+    const double *first_values = nullptr;
+    {
+        HiddenMarkovModel<Candidates> model(candidates);
+        first_values = model.viterbi[0].begin();
+    }
+    HiddenMarkovModel<Candidates> model(candidates);
+    BOOST_CHECK_EQUAL(model.viterbi[0].begin(), first_values);
+    BOOST_CHECK_EQUAL(model.viterbi[1][1], IMPOSSIBLE_LOG_PROB);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
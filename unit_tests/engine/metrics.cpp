@@ -0,0 +1,56 @@
+#include "engine/metrics.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(metrics_test)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(query_log)
+{
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("osrm-queries-%%%%-%%%%.log");
+    metrics::UseQueryLog(path.string(), std::chrono::milliseconds(5), 0);
+
+    {
+        metrics::RequestScope request;
+        metrics::SetService("route");
+        metrics::SetURL("/route/v1/driving/13.1,52.1;13.2,52.2?steps=true");
+        metrics::StageTimer timer(metrics::Stage::Search);
+        metrics::CountSearch(20, 10);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // fast queries are not sampled with a rate of 0, queries without a service never are
+    {
+        metrics::RequestScope request;
+        metrics::SetService("table");
+        metrics::SetURL("/table/v1/driving/13.1,52.1;13.2,52.2");
+    }
+    {
+        metrics::RequestScope request;
+        metrics::SetURL("/metrics");
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    boost::filesystem::ifstream input(path);
+    std::string line;
+    BOOST_REQUIRE(std::getline(input, line));
+    // the renderer escapes slashes
+    BOOST_CHECK_EQUAL(
+        line.find(R"({"url":"\/route\/v1\/driving\/13.1,52.1;13.2,52.2?steps=true",)"
+                  R"("service":"route","duration_ms":)"),
+        0);
+    BOOST_CHECK(line.find("\"slow\":true,\"stages_ms\":{\"search\":") != std::string::npos);
+    BOOST_CHECK(line.find("\"settled_nodes\":10,\"inserted_nodes\":20}") != std::string::npos);
+    BOOST_CHECK(!std::getline(input, line));
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
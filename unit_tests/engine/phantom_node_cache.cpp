@@ -0,0 +1,41 @@
+#include "engine/phantom_node_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(phantom_node_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(key_includes_snapping_options)
+{
+    const util::Coordinate coordinate{util::FloatLongitude{7.419758},
+                                      util::FloatLatitude{43.731142}};
+    const boost::optional<Bearing> bearing = Bearing{90, 10};
+
+    const auto plain = PhantomNodeCache::MakeKey(coordinate, boost::none, boost::none);
+    BOOST_CHECK(plain == PhantomNodeCache::MakeKey(coordinate, boost::none, boost::none));
+    BOOST_CHECK(!(plain == PhantomNodeCache::MakeKey(coordinate, bearing, boost::none)));
+    BOOST_CHECK(!(plain == PhantomNodeCache::MakeKey(coordinate, boost::none, 5.)));
+}
+
+BOOST_AUTO_TEST_CASE(lookup_after_put)
+{
+    PhantomNodeCache cache(16);
+    const util::Coordinate coordinate{util::FloatLongitude{7.419758},
+                                      util::FloatLatitude{43.731142}};
+    const auto key = PhantomNodeCache::MakeKey(coordinate, boost::none, boost::none);
+
+    BOOST_CHECK(!cache.Get(key));
+
+    PhantomNodePair phantoms;
+    phantoms.first.forward_segment_id = {42, true};
+    cache.Put(key, phantoms);
+
+    const auto cached = cache.Get(key);
+    BOOST_REQUIRE(cached);
+    BOOST_CHECK_EQUAL(cached->first.forward_segment_id.id, 42u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+#include "engine/route_result_cache.hpp"
+#include "engine/time_slot.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(route_result_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+PhantomNode MakePhantom(const NodeID segment,
+                        const unsigned geometry,
+                        const unsigned short position,
+                        const int forward_weight,
+                        const int forward_offset)
+{
+    PhantomNode phantom;
+    phantom.forward_segment_id = {segment, true};
+    phantom.reverse_segment_id = {segment + 1, true};
+    phantom.forward_packed_geometry_id = geometry;
+    phantom.reverse_packed_geometry_id = geometry;
+    phantom.fwd_segment_position = position;
+    phantom.forward_weight = forward_weight;
+    phantom.forward_offset = forward_offset;
+    phantom.reverse_weight = 10 - forward_weight;
+    phantom.reverse_offset = 0;
+    return phantom;
+}
+}
+
+BOOST_AUTO_TEST_CASE(key_buckets_offsets_by_geometry_position)
+{
+    const PhantomNodes phantoms{MakePhantom(4, 1, 2, 3, 20), MakePhantom(8, 2, 0, 5, 0)};
+    const PhantomNodes same_bucket{MakePhantom(4, 1, 2, 6, 20), MakePhantom(8, 2, 0, 1, 0)};
+    const PhantomNodes other_bucket{MakePhantom(4, 1, 3, 3, 20), MakePhantom(8, 2, 0, 5, 0)};
+
+    const auto key = RouteResultCache::MakeKey(phantoms, INVALID_TIME_SLOT);
+    BOOST_CHECK(key == RouteResultCache::MakeKey(same_bucket, INVALID_TIME_SLOT));
+    BOOST_CHECK(!(key == RouteResultCache::MakeKey(other_bucket, INVALID_TIME_SLOT)));
+    BOOST_CHECK(!(key == RouteResultCache::MakeKey(phantoms, 0)));
+
+    BOOST_CHECK(RouteResultCache::IsCacheable(phantoms));
+    BOOST_CHECK(!RouteResultCache::IsCacheable(PhantomNodes{phantoms.source_phantom,
+                                                            phantoms.source_phantom}));
+}
+
+BOOST_AUTO_TEST_CASE(hits_are_rebased_to_the_offsets)
+{
+    RouteResultCache cache(16);
+    const PhantomNodes phantoms{MakePhantom(4, 1, 2, 3, 20), MakePhantom(8, 2, 0, 5, 0)};
+    const auto key = RouteResultCache::MakeKey(phantoms, INVALID_TIME_SLOT);
+
+    BOOST_CHECK(!cache.Get(key, phantoms));
+
+    InternalRouteResult route;
+    route.segment_end_coordinates.push_back(phantoms);
+    route.source_traversed_in_reverse.push_back(false);
+    route.target_traversed_in_reverse.push_back(false);
+    route.unpacked_path_segments.resize(1);
+    route.unpacked_path_segments.front().push_back(PathData{});
+    route.unpacked_path_segments.front().front().duration_until_turn = 7;
+    route.shortest_path_length = 100;
+    cache.Put(key, route);
+
+    // the source moved 3 towards the target, the target 4 towards the source
+    const PhantomNodes same_bucket{MakePhantom(4, 1, 2, 6, 20), MakePhantom(8, 2, 0, 1, 0)};
+    const auto cached = cache.Get(key, same_bucket);
+    BOOST_REQUIRE(cached);
+    BOOST_CHECK_EQUAL(cached->shortest_path_length, 93);
+    BOOST_CHECK_EQUAL(cached->unpacked_path_segments.front().front().duration_until_turn, 4);
+    BOOST_CHECK_EQUAL(cached->segment_end_coordinates.front().source_phantom.forward_weight, 6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
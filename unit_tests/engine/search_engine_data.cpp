@@ -0,0 +1,71 @@
+#include "engine/search_engine_data.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace
+{
+struct PooledObject
+{
+    std::size_t size;
+};
+
+std::size_t created_objects = 0;
+}
+
+namespace osrm
+{
+namespace engine
+{
+template <> struct PoolTraits<PooledObject>
+{
+    static std::unique_ptr<PooledObject> Create(const std::size_t size)
+    {
+        ++created_objects;
+        return std::unique_ptr<PooledObject>(new PooledObject{size});
+    }
+
+    static bool Release(PooledObject &) { return true; }
+};
+}
+}
+
+BOOST_AUTO_TEST_SUITE(search_engine_data)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(reserved_objects_are_handed_out)
+{
+    using Pool = ThreadLocalPool<PooledObject>;
+    created_objects = 0;
+
+    Pool::Reserve(5, 3);
+    BOOST_CHECK_EQUAL(created_objects, 3);
+    {
+        std::vector<Pool::Handle> handles;
+        for (int i = 0; i < 3; ++i)
+        {
+            handles.push_back(Pool::Acquire(5));
+            BOOST_CHECK_EQUAL(handles.back()->size, 5);
+        }
+        BOOST_CHECK_EQUAL(created_objects, 3);
+
+        handles.push_back(Pool::Acquire(5));
+        BOOST_CHECK_EQUAL(created_objects, 4);
+    }
+
+    // idle objects are kept, objects of another size are replaced
+    Pool::Reserve(5, 2);
+    BOOST_CHECK_EQUAL(created_objects, 4);
+    Pool::Reserve(7, 1);
+    BOOST_CHECK_EQUAL(created_objects, 5);
+    BOOST_CHECK_EQUAL(Pool::Acquire(7)->size, 7);
+    BOOST_CHECK_EQUAL(created_objects, 5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,283 @@
+#include "contractor/query_edge.hpp"
+#include "engine/datafacade/datafacade_base.hpp"
+#include "engine/phantom_node.hpp"
+#include "engine/routing_algorithms/shortest_path.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(shortest_path)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+// A graph without shortcuts that stores every directed edge at both nodes like the query graph
+struct TestFacade
+{
+    using EdgeData = contractor::QueryEdge::EdgeData;
+
+    struct AdjacentEdge
+    {
+        NodeID target;
+        EdgeData data;
+    };
+
+    TestFacade(const std::size_t number_of_nodes,
+               const std::vector<std::tuple<NodeID, NodeID, EdgeWeight>> &edges)
+    {
+        std::vector<std::vector<AdjacentEdge>> adjacency(number_of_nodes);
+        for (const auto &edge : edges)
+        {
+            EdgeData data;
+            data.id = 0;
+            data.shortcut = false;
+            data.distance = std::get<2>(edge);
+            data.forward = true;
+            data.backward = false;
+            adjacency[std::get<0>(edge)].push_back({std::get<1>(edge), data});
+            data.forward = false;
+            data.backward = true;
+            adjacency[std::get<1>(edge)].push_back({std::get<0>(edge), data});
+        }
+        begin.push_back(0);
+        for (const auto &node_edges : adjacency)
+        {
+            for (const auto &edge : node_edges)
+            {
+                targets.push_back(edge.target);
+                data.push_back(edge.data);
+            }
+            begin.push_back(targets.size());
+        }
+    }
+
+    unsigned GetNumberOfNodes() const { return begin.size() - 1; }
+    unsigned GetCoreSize() const { return 0; }
+    bool IsCoreNode(const NodeID) const { return false; }
+    bool GetContinueStraightDefault() const { return true; }
+    std::vector<NodeID> GetDuplicatedNodes(const NodeID) const { return {}; }
+    NodeID GetOriginalNode(const NodeID node) const { return node; }
+    datafacade::EdgeRange GetDirectedEdgeRange(const NodeID node, const bool) const
+    {
+        return GetAdjacentEdgeRange(node);
+    }
+    datafacade::EdgeRange GetAdjacentEdgeRange(const NodeID node) const
+    {
+        return util::irange(begin[node], begin[node + 1]);
+    }
+    AdjacentEdge GetAdjacentEdge(const EdgeID edge) const { return {targets[edge], data[edge]}; }
+    NodeID GetTarget(const EdgeID edge) const { return targets[edge]; }
+    const EdgeData &GetEdgeData(const EdgeID edge) const { return data[edge]; }
+
+    std::vector<EdgeID> begin;
+    std::vector<NodeID> targets;
+    std::vector<EdgeData> data;
+};
+
+PhantomNode MakePhantom(const NodeID forward_node,
+                        const EdgeWeight forward_weight,
+                        const NodeID reverse_node,
+                        const EdgeWeight reverse_weight)
+{
+    PhantomNode phantom;
+    phantom.forward_segment_id = {forward_node, forward_node != SPECIAL_NODEID};
+    phantom.reverse_segment_id = {reverse_node, reverse_node != SPECIAL_NODEID};
+    phantom.forward_weight = forward_weight;
+    phantom.forward_offset = 0;
+    phantom.reverse_weight = reverse_weight;
+    phantom.reverse_offset = 0;
+    return phantom;
+}
+
+struct Distances
+{
+    EdgeWeight to_forward;
+    EdgeWeight to_reverse;
+};
+
+// Searches to both target nodes at once, which takes the single forward search, and checks
+// the result against a search to each of them on its own
+Distances SearchBothWays(const TestFacade &facade,
+                         const bool from_forward,
+                         const bool from_reverse,
+                         const PhantomNode &source,
+                         const PhantomNode &target,
+                         const EdgeWeight total_to_forward,
+                         const EdgeWeight total_to_reverse)
+{
+    const auto number_of_nodes = facade.GetNumberOfNodes();
+    auto forward_heap = SearchEngineData::GetHeap<SearchEngineData::QueryHeap>(number_of_nodes);
+    auto reverse_heap = SearchEngineData::GetHeap<SearchEngineData::QueryHeap>(number_of_nodes);
+    auto forward_core_heap =
+        SearchEngineData::GetHeap<SearchEngineData::QueryHeap>(number_of_nodes);
+    auto reverse_core_heap =
+        SearchEngineData::GetHeap<SearchEngineData::QueryHeap>(number_of_nodes);
+
+    SearchEngineData engine_working_data;
+    TestFacade facade_copy = facade;
+    routing_algorithms::ShortestPathRouting<TestFacade> routing(&facade_copy,
+                                                                engine_working_data);
+
+    const auto search = [&](const bool to_forward,
+                            const bool to_reverse,
+                            EdgeWeight &distance_to_forward,
+                            EdgeWeight &distance_to_reverse,
+                            std::vector<NodeID> &path_to_forward,
+                            std::vector<NodeID> &path_to_reverse) {
+        distance_to_forward = INVALID_EDGE_WEIGHT;
+        distance_to_reverse = INVALID_EDGE_WEIGHT;
+        routing.Search(*forward_heap,
+                       *reverse_heap,
+                       *forward_core_heap,
+                       *reverse_core_heap,
+                       from_forward,
+                       from_reverse,
+                       to_forward,
+                       to_reverse,
+                       source,
+                       target,
+                       total_to_forward,
+                       total_to_reverse,
+                       distance_to_forward,
+                       distance_to_reverse,
+                       path_to_forward,
+                       path_to_reverse);
+    };
+
+    Distances both;
+    std::vector<NodeID> both_path_to_forward, both_path_to_reverse;
+    search(true,
+           true,
+           both.to_forward,
+           both.to_reverse,
+           both_path_to_forward,
+           both_path_to_reverse);
+
+    Distances separate;
+    EdgeWeight unused = INVALID_EDGE_WEIGHT;
+    std::vector<NodeID> path_to_forward, path_to_reverse, unused_path;
+    search(true, false, separate.to_forward, unused, path_to_forward, unused_path);
+    search(false, true, unused, separate.to_reverse, unused_path, path_to_reverse);
+
+    BOOST_CHECK_EQUAL(both.to_forward, separate.to_forward);
+    BOOST_CHECK_EQUAL(both.to_reverse, separate.to_reverse);
+    // a path is found exactly if there is a distance, and it ends on its target node
+    BOOST_CHECK_EQUAL(both_path_to_forward.empty(), both.to_forward == INVALID_EDGE_WEIGHT);
+    BOOST_CHECK_EQUAL(both_path_to_reverse.empty(), both.to_reverse == INVALID_EDGE_WEIGHT);
+    if (!both_path_to_forward.empty())
+    {
+        BOOST_CHECK_EQUAL(both_path_to_forward.back(), target.forward_segment_id.id);
+    }
+    if (!both_path_to_reverse.empty())
+    {
+        BOOST_CHECK_EQUAL(both_path_to_reverse.back(), target.reverse_segment_id.id);
+    }
+    return both;
+}
+}
+
+// A two-way street, node 0 is its forward and node 1 its reverse direction. Turning around at
+// either end takes 10.
+BOOST_AUTO_TEST_CASE(uturn_test)
+{
+    const TestFacade facade(2, {std::make_tuple(0, 1, 10), std::make_tuple(1, 0, 10)});
+    const auto source = MakePhantom(0, 5, 1, 5);
+
+    // the target lies behind the source, forwards it takes a loop over both ends
+    const auto behind = MakePhantom(0, 2, 1, 8);
+    auto distances = SearchBothWays(facade, true, false, source, behind, 0, 0);
+    BOOST_CHECK_EQUAL(distances.to_forward, -5 + 10 + 10 + 2);
+    BOOST_CHECK_EQUAL(distances.to_reverse, -5 + 10 + 8);
+
+    // the distances of the previous legs add up, here a u-turn after arriving in the forward
+    // direction beats arriving in the reverse one
+    distances = SearchBothWays(facade, true, true, source, behind, 100, 200);
+    BOOST_CHECK_EQUAL(distances.to_forward, 100 - 5 + 10 + 10 + 2);
+    BOOST_CHECK_EQUAL(distances.to_reverse, 100 - 5 + 10 + 8);
+    distances = SearchBothWays(facade, true, true, source, behind, 100, 50);
+    BOOST_CHECK_EQUAL(distances.to_forward, 50 - 5 + 10 + 2);
+    BOOST_CHECK_EQUAL(distances.to_reverse, 50 - 5 + 8);
+
+    // the target lies ahead of the source
+    const auto ahead = MakePhantom(0, 8, 1, 2);
+    distances = SearchBothWays(facade, true, false, source, ahead, 0, 0);
+    BOOST_CHECK_EQUAL(distances.to_forward, -5 + 8);
+    BOOST_CHECK_EQUAL(distances.to_reverse, -5 + 10 + 2);
+}
+
+// One-way streets 0 -> 2 -> 4, the reverse directions 1, 3 and 5 are not connected
+BOOST_AUTO_TEST_CASE(oneway_test)
+{
+    const TestFacade facade(6, {std::make_tuple(0, 2, 10), std::make_tuple(2, 4, 20)});
+    const auto source = MakePhantom(0, 5, SPECIAL_NODEID, 0);
+
+    auto distances = SearchBothWays(facade, true, false, source, MakePhantom(4, 3, 5, 7), 0, 0);
+    BOOST_CHECK_EQUAL(distances.to_forward, -5 + 10 + 20 + 3);
+    BOOST_CHECK_EQUAL(distances.to_reverse, INVALID_EDGE_WEIGHT);
+
+    // against the one-way direction nothing is reachable
+    distances = SearchBothWays(
+        facade, false, true, MakePhantom(5, 5, 4, 5), MakePhantom(1, 3, 0, 7), 0, 0);
+    BOOST_CHECK_EQUAL(distances.to_forward, INVALID_EDGE_WEIGHT);
+    BOOST_CHECK_EQUAL(distances.to_reverse, INVALID_EDGE_WEIGHT);
+
+    // a target behind the source on a one-way street can not be reached either
+    distances = SearchBothWays(facade, true, false, source, MakePhantom(0, 2, 1, 8), 0, 0);
+    BOOST_CHECK_EQUAL(distances.to_forward, INVALID_EDGE_WEIGHT);
+    BOOST_CHECK_EQUAL(distances.to_reverse, INVALID_EDGE_WEIGHT);
+}
+
+// Random one-way edges, targets often share a node with the source
+BOOST_AUTO_TEST_CASE(random_graph_test)
+{
+    std::mt19937 generator(3);
+    const auto random = [&generator](const unsigned bound) { return generator() % bound; };
+
+    const unsigned number_of_nodes = 50;
+    for (unsigned round = 0; round < 20; ++round)
+    {
+        std::vector<std::tuple<NodeID, NodeID, EdgeWeight>> edges;
+        for (unsigned edge = 0; edge < 150; ++edge)
+        {
+            edges.emplace_back(random(number_of_nodes),
+                               random(number_of_nodes),
+                               static_cast<EdgeWeight>(1 + random(100)));
+        }
+        const TestFacade facade(number_of_nodes, edges);
+
+        for (unsigned query = 0; query < 20; ++query)
+        {
+            const NodeID source_forward = random(number_of_nodes);
+            const NodeID source_reverse = random(number_of_nodes);
+            const auto source = MakePhantom(source_forward,
+                                            static_cast<EdgeWeight>(random(60)),
+                                            source_reverse,
+                                            static_cast<EdgeWeight>(random(60)));
+            const auto target = MakePhantom(
+                query % 3 == 0 ? source_forward : random(number_of_nodes),
+                static_cast<EdgeWeight>(random(60)),
+                query % 4 == 0 ? source_reverse : random(number_of_nodes),
+                static_cast<EdgeWeight>(random(60)));
+            const bool from_forward = random(4) != 0;
+            const bool from_reverse = !from_forward || random(2) != 0;
+            SearchBothWays(facade,
+                           from_forward,
+                           from_reverse,
+                           source,
+                           target,
+                           static_cast<EdgeWeight>(random(50)),
+                           static_cast<EdgeWeight>(random(50)));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
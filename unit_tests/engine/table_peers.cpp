@@ -0,0 +1,122 @@
+#include "engine/table_peers.hpp"
+#include "engine/api/table_api.hpp"
+#include "util/exception.hpp"
+
+#include "mocks/mock_datafacade.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <limits>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(table_peers)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+api::TableParameters MakeParameters()
+{
+    api::TableParameters params;
+    params.coordinates = {{util::FloatLongitude{13.1}, util::FloatLatitude{52.1}},
+                          {util::FloatLongitude{13.2}, util::FloatLatitude{52.2}},
+                          {util::FloatLongitude{13.3}, util::FloatLatitude{52.3}},
+                          {util::FloatLongitude{-13.4}, util::FloatLatitude{-52.4}}};
+    return params;
+}
+
+std::string Render(const api::TableParameters &params,
+                   const std::vector<EdgeWeight> &durations,
+                   const std::vector<EdgeWeight> &distances)
+{
+    test::MockDataFacade facade;
+    std::vector<PhantomNode> phantoms(params.coordinates.size());
+    for (const auto i : util::irange<std::size_t>(0UL, phantoms.size()))
+    {
+        phantoms[i].location = params.coordinates[i];
+    }
+    std::vector<char> buffer;
+    api::TableAPI(facade, params).MakeBinaryResponse(durations, distances, phantoms, buffer);
+    return std::string(buffer.begin(), buffer.end());
+}
+}
+
+BOOST_AUTO_TEST_CASE(query_of_a_shard)
+{
+    auto params = MakeParameters();
+    params.sources = {0, 1, 2, 3};
+    params.destinations = {3, 0};
+    params.annotations = api::TableParameters::AnnotationsType::All;
+    params.radiuses = {boost::none, 10., std::numeric_limits<double>::infinity(), boost::none};
+    params.bearings = {Bearing{90, 20}, boost::none, boost::none, boost::none};
+
+    const TablePeers peers({"localhost:5000"}, "car", std::chrono::milliseconds(1000));
+    BOOST_CHECK_EQUAL(peers.Size(), 1);
+    BOOST_CHECK_EQUAL(peers.MakeQuery(params, {1, 2}),
+                      "/table/v1/car/13.200000,52.200000;13.300000,52.300000;"
+                      "-13.400000,-52.400000;13.100000,52.100000.binary"
+                      "?sources=0;1&destinations=2;3&annotations=duration,distance"
+                      "&radiuses=10.000000;unlimited;;&bearings=;;;90,20&distribute=false");
+
+    // all coordinates are destinations if none are given
+    params.destinations.clear();
+    params.annotations = api::TableParameters::AnnotationsType::Distance;
+    params.radiuses.clear();
+    params.bearings.clear();
+    BOOST_CHECK_EQUAL(peers.MakeQuery(params, {3}),
+                      "/table/v1/car/-13.400000,-52.400000;13.100000,52.100000;"
+                      "13.200000,52.200000;13.300000,52.300000;-13.400000,-52.400000.binary"
+                      "?sources=0&destinations=1;2;3;4&annotations=distance&distribute=false");
+}
+
+BOOST_AUTO_TEST_CASE(parse_binary_tables)
+{
+    auto params = MakeParameters();
+    params.sources = {0, 1};
+    params.destinations = {1, 2, 3};
+    const std::vector<EdgeWeight> durations = {1, 2, 3, 4, INVALID_EDGE_WEIGHT, 6};
+    const std::vector<EdgeWeight> distances = {10, 20, 30, 40, INVALID_EDGE_WEIGHT, 60};
+
+    // version 1 only has durations
+    auto rows = TablePeers::ParseBinaryTable(Render(params, durations, {}), 2, 3);
+    BOOST_REQUIRE(rows);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        rows->durations.begin(), rows->durations.end(), durations.begin(), durations.end());
+    BOOST_CHECK(rows->distances.empty());
+
+    params.annotations = api::TableParameters::AnnotationsType::All;
+    rows = TablePeers::ParseBinaryTable(Render(params, durations, distances), 2, 3);
+    BOOST_REQUIRE(rows);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        rows->durations.begin(), rows->durations.end(), durations.begin(), durations.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        rows->distances.begin(), rows->distances.end(), distances.begin(), distances.end());
+
+    params.annotations = api::TableParameters::AnnotationsType::Distance;
+    rows = TablePeers::ParseBinaryTable(Render(params, durations, distances), 2, 3);
+    BOOST_REQUIRE(rows);
+    BOOST_CHECK(rows->durations.empty());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        rows->distances.begin(), rows->distances.end(), distances.begin(), distances.end());
+
+    // other dimensions, truncated responses and errors are rejected
+    const auto body = Render(params, durations, distances);
+    BOOST_CHECK(!TablePeers::ParseBinaryTable(body, 3, 2));
+    BOOST_CHECK(!TablePeers::ParseBinaryTable(body.substr(0, body.size() - 1), 2, 3));
+    BOOST_CHECK(!TablePeers::ParseBinaryTable("{\"code\":\"TooBig\"}", 2, 3));
+    BOOST_CHECK(!TablePeers::ParseBinaryTable("", 2, 3));
+}
+
+BOOST_AUTO_TEST_CASE(malformed_peers)
+{
+    const std::chrono::milliseconds timeout(1000);
+    BOOST_CHECK_THROW(TablePeers({"localhost"}, "car", timeout), util::exception);
+    BOOST_CHECK_THROW(TablePeers({":5000"}, "car", timeout), util::exception);
+    BOOST_CHECK_THROW(TablePeers({"localhost:"}, "car", timeout), util::exception);
+    BOOST_CHECK_EQUAL(TablePeers({"[::1]:5000", "10.0.0.2:5000"}, "car", timeout).Size(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+#include "engine/map_matching/trace_thinning.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(trace_thinning)
+
+using namespace osrm;
+using namespace osrm::engine;
+using namespace osrm::engine::map_matching;
+
+namespace
+{
+// about 1.1m per step along the meridian
+util::Coordinate North(const double steps)
+{
+    return {util::FloatLongitude{7.42}, util::FloatLatitude{43.73 + steps * 0.00001}};
+}
+}
+
+BOOST_AUTO_TEST_CASE(thins_by_distance)
+{
+    api::MatchParameters parameters;
+    for (const auto steps : {0., 2., 4., 12., 13., 30., 31.})
+    {
+        parameters.coordinates.push_back(North(steps));
+    }
+    parameters.radiuses.resize(parameters.coordinates.size());
+    parameters.radiuses[3] = 7.;
+
+    const auto thinned = ThinTrace(parameters);
+    const std::vector<std::size_t> kept_indices = {0, 3, 5, 6};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        thinned.indices.begin(), thinned.indices.end(), kept_indices.begin(), kept_indices.end());
+    BOOST_CHECK_EQUAL(thinned.parameters.coordinates.size(), 4);
+    BOOST_CHECK_EQUAL(thinned.parameters.coordinates[1], parameters.coordinates[3]);
+    BOOST_REQUIRE_EQUAL(thinned.parameters.radiuses.size(), 4);
+    BOOST_CHECK_EQUAL(*thinned.parameters.radiuses[1], 7.);
+    BOOST_CHECK(thinned.parameters.timestamps.empty());
+    BOOST_CHECK_EQUAL(thinned.sample_time, 0);
+}
+
+BOOST_AUTO_TEST_CASE(keeps_stationary_samples_apart_in_time)
+{
+    api::MatchParameters parameters;
+    for (const auto timestamp : {0u, 1u, 2u, 3u, 4u, 5u, 6u, 7u, 40u})
+    {
+        parameters.coordinates.push_back(North(0));
+        parameters.timestamps.push_back(timestamp);
+    }
+
+    const auto thinned = ThinTrace(parameters);
+    const std::vector<std::size_t> kept_indices = {0, 5, 8};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        thinned.indices.begin(), thinned.indices.end(), kept_indices.begin(), kept_indices.end());
+    BOOST_CHECK_EQUAL(thinned.parameters.timestamps[1], 5);
+    BOOST_CHECK_EQUAL(thinned.parameters.timestamps[2], 40);
+    // the gaps are those of the original trace
+    BOOST_CHECK_EQUAL(thinned.sample_time, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,109 @@
+#include "engine/trip/trip_brute_force.hpp"
+#include "engine/trip/trip_farthest_insertion.hpp"
+#include "engine/trip/trip_nearest_neighbour.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(trip_brute_force)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+EdgeWeight TripDuration(const util::DistTableWrapper<EdgeWeight> &table,
+                        const std::vector<NodeID> &trip)
+{
+    EdgeWeight duration = 0;
+    for (std::size_t i = 0; i < trip.size(); ++i)
+    {
+        duration += table(trip[i], trip[(i + 1) % trip.size()]);
+    }
+    return duration;
+}
+
+// asymmetric durations, like one-way streets would cause
+util::DistTableWrapper<EdgeWeight> MakeRandomTable(const std::size_t number_of_locations,
+                                                   const unsigned seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<EdgeWeight> duration(1, 1000);
+    std::vector<EdgeWeight> table(number_of_locations * number_of_locations, 0);
+    for (std::size_t from = 0; from < number_of_locations; ++from)
+    {
+        for (std::size_t to = 0; to < number_of_locations; ++to)
+        {
+            if (from != to)
+            {
+                table[from * number_of_locations + to] = duration(generator);
+            }
+        }
+    }
+    return util::DistTableWrapper<EdgeWeight>(std::move(table), number_of_locations);
+}
+
+bool IsPermutation(std::vector<NodeID> trip, std::vector<NodeID> locations)
+{
+    std::sort(trip.begin(), trip.end());
+    std::sort(locations.begin(), locations.end());
+    return trip == locations;
+}
+}
+
+BOOST_AUTO_TEST_CASE(finds_the_shortest_trip)
+{
+    const std::size_t number_of_locations = 8;
+    for (const unsigned seed : {1, 2, 3, 4, 5})
+    {
+        const auto table = MakeRandomTable(number_of_locations, seed);
+        // every other location, in reverse
+        const std::vector<NodeID> component = {6, 4, 2, 0};
+
+        auto permutation = component;
+        std::sort(permutation.begin(), permutation.end());
+        auto shortest = TripDuration(table, permutation);
+        while (std::next_permutation(permutation.begin(), permutation.end()))
+        {
+            shortest = std::min(shortest, TripDuration(table, permutation));
+        }
+
+        const auto trip =
+            trip::BruteForceTrip(component.begin(), component.end(), number_of_locations, table);
+        BOOST_CHECK(IsPermutation(trip, component));
+        BOOST_CHECK_EQUAL(trip.front(), 0);
+        BOOST_CHECK_EQUAL(TripDuration(table, trip), shortest);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(solves_twelve_locations)
+{
+    const std::size_t number_of_locations = 12;
+    const auto table = MakeRandomTable(number_of_locations, 42);
+    std::vector<NodeID> component(number_of_locations);
+    std::iota(component.begin(), component.end(), 0);
+
+    const auto trip =
+        trip::BruteForceTrip(component.begin(), component.end(), number_of_locations, table);
+    BOOST_CHECK(IsPermutation(trip, component));
+
+    // the same trip however the searches are scheduled, and no heuristic beats it
+    BOOST_CHECK(trip == trip::BruteForceTrip(
+                            component.begin(), component.end(), number_of_locations, table));
+    const auto insertion_trip = trip::FarthestInsertionTrip(
+        component.begin(), component.end(), number_of_locations, table);
+    BOOST_CHECK(IsPermutation(insertion_trip, component));
+    BOOST_CHECK_LE(TripDuration(table, trip), TripDuration(table, insertion_trip));
+    const auto neighbour_trip = trip::NearestNeighbourTrip(
+        component.begin(), component.end(), number_of_locations, table);
+    BOOST_CHECK(IsPermutation(neighbour_trip, component));
+    BOOST_CHECK_LE(TripDuration(table, trip), TripDuration(table, neighbour_trip));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,100 @@
+#include "engine/trip/trip_local_search.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(trip_local_search)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+EdgeWeight TripDuration(const util::DistTableWrapper<EdgeWeight> &table,
+                        const std::vector<NodeID> &trip)
+{
+    EdgeWeight duration = 0;
+    for (std::size_t i = 0; i < trip.size(); ++i)
+    {
+        duration += table(trip[i], trip[(i + 1) % trip.size()]);
+    }
+    return duration;
+}
+
+// locations on a line, visiting them in the given order criss-crosses
+util::DistTableWrapper<EdgeWeight> MakeLineTable(const std::size_t number_of_locations)
+{
+    std::vector<EdgeWeight> table(number_of_locations * number_of_locations);
+    for (std::size_t from = 0; from < number_of_locations; ++from)
+    {
+        for (std::size_t to = 0; to < number_of_locations; ++to)
+        {
+            table[from * number_of_locations + to] =
+                10 * std::abs(static_cast<int>(from) - static_cast<int>(to));
+        }
+    }
+    return util::DistTableWrapper<EdgeWeight>(std::move(table), number_of_locations);
+}
+}
+
+BOOST_AUTO_TEST_CASE(untangles_crossing_trip)
+{
+    const auto table = MakeLineTable(6);
+    const std::vector<NodeID> crossing = {0, 3, 1, 4, 2, 5};
+
+    const auto trip = trip::LocalSearchTrip(crossing, table, std::chrono::milliseconds(1000));
+
+    BOOST_CHECK_EQUAL(trip.front(), 0);
+    BOOST_CHECK_EQUAL(TripDuration(table, trip), 100);
+}
+
+BOOST_AUTO_TEST_CASE(keeps_permutation_and_never_gets_longer)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> coordinate(0, 1000);
+    std::uniform_int_distribution<int> detour(0, 100);
+
+    const std::size_t number_of_locations = 60;
+    std::vector<int> x(number_of_locations), y(number_of_locations);
+    for (std::size_t i = 0; i < number_of_locations; ++i)
+    {
+        x[i] = coordinate(generator);
+        y[i] = coordinate(generator);
+    }
+    // asymmetric durations, like one-way streets would cause
+    std::vector<EdgeWeight> durations(number_of_locations * number_of_locations, 0);
+    for (std::size_t from = 0; from < number_of_locations; ++from)
+    {
+        for (std::size_t to = 0; to < number_of_locations; ++to)
+        {
+            if (from != to)
+            {
+                durations[from * number_of_locations + to] =
+                    std::abs(x[from] - x[to]) + std::abs(y[from] - y[to]) + detour(generator);
+            }
+        }
+    }
+    const util::DistTableWrapper<EdgeWeight> table(std::move(durations), number_of_locations);
+
+    std::vector<NodeID> initial(number_of_locations);
+    for (std::size_t i = 0; i < number_of_locations; ++i)
+    {
+        initial[i] = i;
+    }
+    std::shuffle(initial.begin() + 1, initial.end(), generator);
+
+    const auto trip = trip::LocalSearchTrip(initial, table, std::chrono::milliseconds(1000));
+
+    BOOST_CHECK_EQUAL(trip.front(), initial.front());
+    BOOST_CHECK(std::is_permutation(trip.begin(), trip.end(), initial.begin()));
+    BOOST_CHECK_LT(TripDuration(table, trip), TripDuration(table, initial));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,40 @@
+#include "engine/unpacking_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(unpacking_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(lookup_appends_original_edges)
+{
+    UnpackingCache cache(16);
+    std::vector<EdgeID> original_edges = {1};
+
+    BOOST_CHECK(!cache.Get(42, original_edges));
+    BOOST_CHECK_EQUAL(original_edges.size(), 1);
+
+    cache.Put(42, {7, 8, 9});
+    BOOST_REQUIRE(cache.Get(42, original_edges));
+    const std::vector<EdgeID> expected = {1, 7, 8, 9};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        original_edges.begin(), original_edges.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(evicts_least_recently_used)
+{
+    // a single entry per shard, the shortcuts 0 and 8 end up in the same one
+    UnpackingCache cache(8);
+    std::vector<EdgeID> original_edges;
+
+    cache.Put(0, {1, 2});
+    cache.Put(8, {3, 4});
+    BOOST_CHECK(!cache.Get(0, original_edges));
+    BOOST_CHECK(cache.Get(8, original_edges));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
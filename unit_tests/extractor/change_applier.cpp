@@ -0,0 +1,126 @@
+#include "extractor/change_applier.hpp"
+#include "util/exception.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <osmium/io/any_input.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(change_applier)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+namespace
+{
+boost::filesystem::path WriteFile(const std::string &content, const std::string &extension)
+{
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("osrm-change-%%%%-%%%%" + extension);
+    boost::filesystem::ofstream output(path);
+    output << content;
+    return path;
+}
+
+// type, id and version of the objects in a buffer
+using Objects = std::vector<std::string>;
+
+void AddObjects(const osmium::memory::Buffer &buffer, Objects &objects)
+{
+    const auto end = buffer.cend<osmium::OSMObject>();
+    for (auto object = buffer.cbegin<osmium::OSMObject>(); object != end; ++object)
+    {
+        objects.push_back(osmium::item_type_to_char(object->type()) +
+                          std::to_string(object->id()) + "v" +
+                          std::to_string(object->version()));
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(merge_changes)
+{
+    const auto input_path = WriteFile(R"(<?xml version='1.0' encoding='UTF-8'?>
+<osm version="0.6">
+  <node id="1" version="1" lat="0" lon="0"/>
+  <node id="2" version="1" lat="0" lon="0.001"/>
+  <node id="3" version="1" lat="0.001" lon="0"/>
+  <node id="5" version="1" lat="0.002" lon="0"/>
+  <way id="10" version="1"><nd ref="1"/><nd ref="2"/></way>
+  <way id="11" version="1"><nd ref="1"/><nd ref="3"/></way>
+  <way id="12" version="1"><nd ref="3"/><nd ref="5"/></way>
+</osm>
+)",
+                                      ".osm");
+    const auto first_change_path = WriteFile(R"(<?xml version='1.0' encoding='UTF-8'?>
+<osmChange version="0.6">
+  <modify>
+    <node id="2" version="2" lat="0" lon="0.002"/>
+    <way id="11" version="2"><nd ref="1"/><nd ref="3"/><nd ref="4"/></way>
+  </modify>
+  <create>
+    <node id="4" version="1" lat="0.001" lon="0.001"/>
+  </create>
+  <delete>
+    <way id="12" version="2"/>
+    <node id="5" version="2"/>
+  </delete>
+</osmChange>
+)",
+                                             ".osc");
+    const auto second_change_path = WriteFile(R"(<?xml version='1.0' encoding='UTF-8'?>
+<osmChange version="0.6">
+  <modify>
+    <node id="2" version="3" lat="0" lon="0.003"/>
+  </modify>
+  <create>
+    <way id="13" version="1"><nd ref="4"/><nd ref="1"/></way>
+    <relation id="20" version="1"><member type="way" ref="13" role=""/></relation>
+  </create>
+</osmChange>
+)",
+                                              ".osc");
+
+    // the older version of node 2 is in the later file
+    ChangeApplier applier({second_change_path, first_change_path});
+    BOOST_CHECK_EQUAL(applier.GetNumberOfChanges(), 7);
+
+    Objects objects;
+    osmium::io::Reader reader(input_path.string());
+    while (const auto buffer = reader.read())
+    {
+        AddObjects(applier.Apply(buffer), objects);
+    }
+    reader.close();
+    const auto remaining = applier.Finish();
+    BOOST_REQUIRE(remaining);
+    AddObjects(remaining, objects);
+    BOOST_CHECK(!applier.Finish());
+
+    const Objects expected_objects{
+        "n1v1", "n2v3", "n3v1", "n4v1", "w10v1", "w11v2", "w13v1", "r20v1"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        objects.begin(), objects.end(), expected_objects.begin(), expected_objects.end());
+
+    // way 10 references the changed node 2
+    const std::vector<OSMWayID> expected_ways{
+        OSMWayID{10}, OSMWayID{11}, OSMWayID{12}, OSMWayID{13}};
+    const auto &affected_ways = applier.GetAffectedWays();
+    BOOST_CHECK(affected_ways == expected_ways);
+
+    boost::filesystem::remove(input_path);
+    boost::filesystem::remove(first_change_path);
+    boost::filesystem::remove(second_change_path);
+}
+
+BOOST_AUTO_TEST_CASE(missing_change_file)
+{
+    const std::vector<boost::filesystem::path> change_paths{"/does/not/exist.osc"};
+    BOOST_CHECK_THROW(ChangeApplier{change_paths}, util::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
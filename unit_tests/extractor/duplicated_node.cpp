@@ -0,0 +1,53 @@
+#include "extractor/duplicated_node.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(duplicated_node_test)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+BOOST_AUTO_TEST_CASE(find_duplicates_test)
+{
+    const std::vector<DuplicatedNode> duplicated_nodes = {{1, 10}, {3, 11}, {3, 12}, {7, 13}};
+    const auto begin = duplicated_nodes.data();
+    const auto end = begin + duplicated_nodes.size();
+
+    BOOST_CHECK(FindDuplicates(begin, end, 0).empty());
+    BOOST_CHECK(FindDuplicates(begin, end, 2).empty());
+    BOOST_CHECK(FindDuplicates(begin, end, 8).empty());
+    BOOST_CHECK(FindDuplicates(begin, end, 1) == std::vector<NodeID>({10}));
+    BOOST_CHECK(FindDuplicates(begin, end, 3) == std::vector<NodeID>({11, 12}));
+    BOOST_CHECK(FindDuplicates(begin, end, 7) == std::vector<NodeID>({13}));
+    BOOST_CHECK(FindDuplicates(end, end, 1).empty());
+}
+
+BOOST_AUTO_TEST_CASE(find_original_test)
+{
+    // osrm-contract renumbers the nodes, so the copies are not in the order of the originals
+    const std::vector<DuplicatedNode> duplicated_nodes = {{1, 12}, {3, 5}, {3, 11}, {7, 2}};
+    const auto by_duplicate = SortByDuplicate(
+        duplicated_nodes.data(), duplicated_nodes.data() + duplicated_nodes.size());
+    BOOST_REQUIRE_EQUAL(by_duplicate.size(), duplicated_nodes.size());
+    BOOST_CHECK_EQUAL(by_duplicate.front().duplicate, 2);
+    BOOST_CHECK_EQUAL(by_duplicate.back().duplicate, 12);
+
+    const auto begin = by_duplicate.data();
+    const auto end = begin + by_duplicate.size();
+
+    BOOST_CHECK_EQUAL(FindOriginal(begin, end, 12), 1);
+    BOOST_CHECK_EQUAL(FindOriginal(begin, end, 5), 3);
+    BOOST_CHECK_EQUAL(FindOriginal(begin, end, 11), 3);
+    BOOST_CHECK_EQUAL(FindOriginal(begin, end, 2), 7);
+    // nodes that are no copies stand for themselves
+    BOOST_CHECK_EQUAL(FindOriginal(begin, end, 3), 3);
+    BOOST_CHECK_EQUAL(FindOriginal(begin, end, 0), 0);
+    BOOST_CHECK_EQUAL(FindOriginal(begin, end, 6), 6);
+    BOOST_CHECK_EQUAL(FindOriginal(begin, end, 14), 14);
+    BOOST_CHECK_EQUAL(FindOriginal(end, end, 12), 12);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
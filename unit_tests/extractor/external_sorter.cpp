@@ -0,0 +1,87 @@
+#include "extractor/external_sorter.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(external_sorter)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+namespace
+{
+// Chosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 13;
+
+// few distinct values, so that the runs contain many equal elements
+using Element = std::uint64_t;
+
+std::vector<Element> randomElements(const std::size_t size)
+{
+    std::mt19937 generator(RANDOM_SEED);
+    std::uniform_int_distribution<std::uint32_t> key_distribution(0, 100);
+    std::uniform_int_distribution<std::uint32_t> value_distribution(0, 3);
+    std::vector<Element> elements(size);
+    for (auto &element : elements)
+    {
+        element = (Element{key_distribution(generator)} << 32) | value_distribution(generator);
+    }
+    return elements;
+}
+
+std::size_t numberOfSpillFiles(const boost::filesystem::path &directory)
+{
+    return std::count_if(boost::filesystem::directory_iterator(directory),
+                         boost::filesystem::directory_iterator(),
+                         [](const boost::filesystem::directory_entry &entry) {
+                             return entry.path().filename().string().find("osrm-sort-") == 0;
+                         });
+}
+}
+
+BOOST_AUTO_TEST_CASE(sort_in_memory)
+{
+    auto elements = randomElements(1000);
+    auto expected = elements;
+    std::sort(expected.begin(), expected.end());
+
+    const ExternalSorter sorter(1000 * sizeof(Element), boost::filesystem::temp_directory_path());
+    sorter.Sort(elements.begin(), elements.end(), std::less<Element>());
+    BOOST_CHECK(elements == expected);
+}
+
+BOOST_AUTO_TEST_CASE(sort_with_spilling)
+{
+    const auto directory = boost::filesystem::temp_directory_path();
+    const auto spill_files_before = numberOfSpillFiles(directory);
+
+    // budgets that lead to a single short run, uneven runs and one run per element
+    for (const std::size_t run_size : {999, 64, 7, 1})
+    {
+        auto elements = randomElements(1000);
+        auto expected = elements;
+        std::sort(expected.begin(), expected.end(), std::greater<Element>());
+
+        const ExternalSorter sorter(run_size * sizeof(Element), directory);
+        sorter.Sort(elements.begin(), elements.end(), std::greater<Element>());
+        BOOST_CHECK(elements == expected);
+    }
+
+    BOOST_CHECK_EQUAL(numberOfSpillFiles(directory), spill_files_before);
+}
+
+BOOST_AUTO_TEST_CASE(sort_empty)
+{
+    std::vector<Element> elements;
+    const ExternalSorter sorter(0, boost::filesystem::temp_directory_path());
+    sorter.Sort(elements.begin(), elements.end(), std::less<Element>());
+    BOOST_CHECK(elements.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -7,7 +7,10 @@
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE(graph_compressor)
 
@@ -543,4 +546,109 @@ BOOST_AUTO_TEST_CASE(direction_changes)
     BOOST_CHECK(graph.FindEdge(1, 2) != SPECIAL_EDGEID);
 }
 
+BOOST_AUTO_TEST_CASE(parallel_chains)
+{
+    //
+    //     2---3
+    //    /     \
+    // 5-0       1-6
+    //    \     /
+    //     --4--
+    //
+    GraphCompressor compressor;
+
+    std::unordered_set<NodeID> barrier_nodes;
+    std::unordered_set<NodeID> traffic_lights;
+    RestrictionMap map;
+    CompressedEdgeContainer container;
+
+    std::vector<InputEdge> edges;
+    for (const auto &segment : std::vector<std::pair<NodeID, NodeID>>{
+             {0, 2}, {2, 3}, {3, 1}, {0, 4}, {4, 1}, {5, 0}, {1, 6}})
+    {
+        for (const auto &direction : {segment, std::make_pair(segment.second, segment.first)})
+        {
+            edges.push_back({direction.first,
+                             direction.second,
+                             1,
+                             SPECIAL_EDGEID,
+                             0,
+                             false,
+                             false,
+                             false,
+                             true,
+                             TRAVEL_MODE_INACCESSIBLE,
+                             INVALID_LANE_DESCRIPTIONID});
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    Graph graph(7, edges);
+    compressor.Compress(barrier_nodes, traffic_lights, map, graph, container);
+
+    // the chain with the lower highest node is compressed, the other one keeps its node
+    BOOST_CHECK_EQUAL(graph.FindEdge(0, 2), SPECIAL_EDGEID);
+    BOOST_CHECK_EQUAL(graph.FindEdge(3, 1), SPECIAL_EDGEID);
+    const auto edge = graph.FindEdge(0, 1);
+    BOOST_REQUIRE(edge != SPECIAL_EDGEID);
+    BOOST_CHECK_EQUAL(graph.GetEdgeData(edge).distance, 3);
+    BOOST_CHECK(graph.FindEdge(0, 4) != SPECIAL_EDGEID);
+    BOOST_CHECK(graph.FindEdge(4, 1) != SPECIAL_EDGEID);
+
+    const auto &geometry = container.GetBucketReference(edge);
+    BOOST_REQUIRE_EQUAL(geometry.size(), 3);
+    BOOST_CHECK_EQUAL(geometry[0].node_id, 2);
+    BOOST_CHECK_EQUAL(geometry[1].node_id, 3);
+    BOOST_CHECK_EQUAL(geometry[2].node_id, 1);
+}
+
+BOOST_AUTO_TEST_CASE(isolated_cycle)
+{
+    //
+    // 0---1---2
+    // |       |
+    // 5---4---3
+    //
+    GraphCompressor compressor;
+
+    std::unordered_set<NodeID> barrier_nodes;
+    std::unordered_set<NodeID> traffic_lights;
+    RestrictionMap map;
+    CompressedEdgeContainer container;
+
+    std::vector<InputEdge> edges;
+    for (const NodeID node : util::irange<NodeID>(0, 6))
+    {
+        const NodeID next = (node + 1) % 6;
+        for (const auto &direction : {std::make_pair(node, next), std::make_pair(next, node)})
+        {
+            edges.push_back({direction.first,
+                             direction.second,
+                             1,
+                             SPECIAL_EDGEID,
+                             0,
+                             false,
+                             false,
+                             false,
+                             true,
+                             TRAVEL_MODE_INACCESSIBLE,
+                             INVALID_LANE_DESCRIPTIONID});
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    Graph graph(6, edges);
+    compressor.Compress(barrier_nodes, traffic_lights, map, graph, container);
+
+    // a triangle of the highest nodes is left
+    for (const NodeID node : util::irange<NodeID>(0, 3))
+    {
+        BOOST_CHECK_EQUAL(graph.GetOutDegree(node), 0);
+    }
+    BOOST_CHECK(graph.FindEdge(3, 4) != SPECIAL_EDGEID);
+    BOOST_CHECK(graph.FindEdge(4, 5) != SPECIAL_EDGEID);
+    BOOST_CHECK(graph.FindEdge(5, 3) != SPECIAL_EDGEID);
+    BOOST_CHECK_EQUAL(graph.GetEdgeData(graph.FindEdge(5, 3)).distance, 4);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
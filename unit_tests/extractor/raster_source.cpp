@@ -7,6 +7,9 @@
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <utility>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(raster_source)
 
 using namespace osrm;
@@ -79,4 +82,39 @@ BOOST_AUTO_TEST_CASE(raster_test)
         util::exception);
 }
 
+BOOST_AUTO_TEST_CASE(raster_bulk_test)
+{
+    SourceContainer sources;
+    int source_id = sources.LoadRasterSource(
+        "../unit_tests/fixtures/raster_data.asc", 1, 1.09, 1, 1.09, 10, 10);
+
+    std::vector<std::pair<double, double>> lon_lats;
+    std::vector<util::Coordinate> coordinates;
+    for (double lon = 0.99; lon < 1.1; lon += 0.003)
+    {
+        for (double lat = 0.99; lat < 1.1; lat += 0.007)
+        {
+            lon_lats.emplace_back(lon, lat);
+            coordinates.emplace_back(util::FloatLongitude{lon}, util::FloatLatitude{lat});
+        }
+    }
+
+    const auto data = sources.GetRasterDataFromSource(source_id, coordinates);
+    const auto interpolated = sources.GetRasterInterpolateFromSource(source_id, coordinates);
+    BOOST_REQUIRE_EQUAL(data.size(), coordinates.size());
+    BOOST_REQUIRE_EQUAL(interpolated.size(), coordinates.size());
+
+    for (std::size_t index = 0; index < coordinates.size(); ++index)
+    {
+        const auto lon = lon_lats[index].first;
+        const auto lat = lon_lats[index].second;
+        BOOST_CHECK_EQUAL(data[index].datum,
+                          sources.GetRasterDataFromSource(source_id, lon, lat).datum);
+        BOOST_CHECK_EQUAL(interpolated[index].datum,
+                          sources.GetRasterInterpolateFromSource(source_id, lon, lat).datum);
+    }
+
+    BOOST_CHECK_THROW(sources.GetRasterDataFromSource(1, coordinates), util::exception);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,98 @@
+#include "extractor/region_filter.hpp"
+#include "util/exception.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(region_filter)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+namespace
+{
+boost::filesystem::path WritePolygon(const std::string &content)
+{
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("osrm-region-%%%%-%%%%.poly");
+    boost::filesystem::ofstream output(path);
+    output << content;
+    return path;
+}
+
+util::Coordinate MakeCoordinate(const double lon, const double lat)
+{
+    return util::Coordinate{util::FloatLongitude{lon}, util::FloatLatitude{lat}};
+}
+}
+
+BOOST_AUTO_TEST_CASE(polygon_with_hole)
+{
+    // a square with a square hole and a triangle next to it
+    const auto path = WritePolygon("region\n"
+                                   "outer\n"
+                                   "   0.0E+00   0.0E+00\n"
+                                   "   1.0E+01   0.0E+00\n"
+                                   "   1.0E+01   1.0E+01\n"
+                                   "   0.0E+00   1.0E+01\n"
+                                   "   0.0E+00   0.0E+00\n"
+                                   "END\n"
+                                   "!hole\n"
+                                   "   4.0 4.0\n"
+                                   "   6.0 4.0\n"
+                                   "   6.0 6.0\n"
+                                   "   4.0 6.0\n"
+                                   "END\n"
+                                   "triangle\n"
+                                   "   20.0 0.0\n"
+                                   "   30.0 0.0\n"
+                                   "   20.0 10.0\n"
+                                   "END\n"
+                                   "END\n");
+    const RegionFilter filter(path);
+    boost::filesystem::remove(path);
+
+    BOOST_CHECK_EQUAL(filter.GetNumberOfRings(), 3);
+    BOOST_CHECK(filter.Contains(MakeCoordinate(1, 1)));
+    BOOST_CHECK(filter.Contains(MakeCoordinate(9, 5)));
+    BOOST_CHECK(filter.Contains(MakeCoordinate(5, 3)));
+    BOOST_CHECK(!filter.Contains(MakeCoordinate(5, 5)));
+    BOOST_CHECK(!filter.Contains(MakeCoordinate(15, 5)));
+    BOOST_CHECK(!filter.Contains(MakeCoordinate(-1, 5)));
+    BOOST_CHECK(!filter.Contains(MakeCoordinate(5, 11)));
+    BOOST_CHECK(filter.Contains(MakeCoordinate(21, 1)));
+    BOOST_CHECK(!filter.Contains(MakeCoordinate(29, 9)));
+}
+
+BOOST_AUTO_TEST_CASE(invalid_polygons)
+{
+    for (const std::string content : {std::string{""},
+                                      std::string{"region\nEND\n"},
+                                      std::string{"region\nring\n0 0\n1 0\n1 1\n"},
+                                      std::string{"region\nring\n0 0\n1 0\nEND\nEND\n"},
+                                      std::string{"region\nring\n0 0\n1 x\n1 1\nEND\nEND\n"}})
+    {
+        const auto path = WritePolygon(content);
+        BOOST_CHECK_THROW(RegionFilter{path}, util::exception);
+        boost::filesystem::remove(path);
+    }
+    BOOST_CHECK_THROW(RegionFilter{"/nonexistent/region.poly"}, util::exception);
+}
+
+BOOST_AUTO_TEST_CASE(node_set)
+{
+    RegionNodeSet nodes;
+    nodes.Insert(OSMNodeID{5});
+    nodes.Insert(OSMNodeID{4000000000});
+
+    BOOST_CHECK(nodes.Contains(OSMNodeID{5}));
+    BOOST_CHECK(nodes.Contains(OSMNodeID{4000000000}));
+    BOOST_CHECK(!nodes.Contains(OSMNodeID{6}));
+    BOOST_CHECK(!nodes.Contains(OSMNodeID{4000000001}));
+    BOOST_CHECK(!nodes.Contains(OSMNodeID{5000000000}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,95 @@
+#include "extractor/restriction_map.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(restriction_map)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+TurnRestriction MakeRestriction(NodeID from, NodeID via, NodeID to, bool is_only)
+{
+    TurnRestriction restriction(is_only);
+    restriction.from.node = from;
+    restriction.via.node = via;
+    restriction.to.node = to;
+    return restriction;
+}
+
+TurnRestriction MakeViaWayRestriction(NodeID from, NodeID via, NodeID via_end, NodeID to)
+{
+    auto restriction = MakeRestriction(from, via, to, false);
+    restriction.via_end.node = via_end;
+    restriction.flags.uses_via_way = true;
+    return restriction;
+}
+
+BOOST_AUTO_TEST_CASE(flat_index_test)
+{
+    //      3
+    //      |
+    // 0 -- 1 -- 2
+    //      |
+    //      4
+    std::vector<TurnRestriction> restrictions = {MakeRestriction(0, 1, 3, false),
+                                                 MakeRestriction(0, 1, 4, false),
+                                                 MakeRestriction(2, 1, 4, true),
+                                                 MakeRestriction(3, 1, 0, false)};
+    RestrictionMap map(restrictions);
+    BOOST_CHECK_EQUAL(map.size(), 4);
+    BOOST_CHECK(map.IsViaNode(1));
+    BOOST_CHECK(!map.IsViaNode(0));
+
+    map.BuildFlatIndex(5);
+
+    BOOST_CHECK(map.CheckIfTurnIsRestricted(0, 1, 3));
+    BOOST_CHECK(map.CheckIfTurnIsRestricted(0, 1, 4));
+    BOOST_CHECK(!map.CheckIfTurnIsRestricted(0, 1, 2));
+    BOOST_CHECK(map.CheckIfTurnIsRestricted(2, 1, 0));
+    BOOST_CHECK(map.CheckIfTurnIsRestricted(2, 1, 3));
+    BOOST_CHECK(!map.CheckIfTurnIsRestricted(2, 1, 4));
+    BOOST_CHECK(map.CheckIfTurnIsRestricted(3, 1, 0));
+    BOOST_CHECK(!map.CheckIfTurnIsRestricted(4, 1, 0));
+    BOOST_CHECK(!map.CheckIfTurnIsRestricted(1, 2, 1));
+
+    BOOST_CHECK_EQUAL(map.CheckForEmanatingIsOnlyTurn(2, 1), 4);
+    BOOST_CHECK_EQUAL(map.CheckForEmanatingIsOnlyTurn(0, 1), SPECIAL_NODEID);
+    BOOST_CHECK_EQUAL(map.CheckForEmanatingIsOnlyTurn(4, 1), SPECIAL_NODEID);
+}
+
+BOOST_AUTO_TEST_CASE(via_way_test)
+{
+    // 0 -- 1 -- 2 -- 3
+    //           |
+    //           4
+    std::vector<TurnRestriction> restrictions = {MakeViaWayRestriction(0, 1, 2, 4),
+                                                 MakeRestriction(3, 2, 4, false)};
+    RestrictionMap map(restrictions);
+    BOOST_CHECK_EQUAL(map.size(), 1);
+    BOOST_REQUIRE_EQUAL(map.GetViaWayRestrictions().size(), 1);
+
+    const auto &via_way_restriction = map.GetViaWayRestrictions().front();
+    BOOST_CHECK_EQUAL(via_way_restriction.from, 0);
+    BOOST_CHECK_EQUAL(via_way_restriction.via_start, 1);
+    BOOST_CHECK_EQUAL(via_way_restriction.via_end, 2);
+    BOOST_CHECK_EQUAL(via_way_restriction.to, 4);
+    BOOST_CHECK(!via_way_restriction.is_only);
+
+    // the nodes of via-way restrictions must not be compressed
+    for (const NodeID node : {0, 1, 2, 4})
+    {
+        BOOST_CHECK(map.IsViaNode(node));
+    }
+    BOOST_CHECK(!map.IsViaNode(3));
+
+    // via-way restrictions are not turn restrictions at a single node
+    map.BuildFlatIndex(5);
+    BOOST_CHECK(!map.CheckIfTurnIsRestricted(1, 2, 4));
+    BOOST_CHECK(!map.CheckIfTurnIsRestricted(0, 1, 2));
+    BOOST_CHECK(map.CheckIfTurnIsRestricted(3, 2, 4));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,152 @@
+#include "extractor/matrix_scc.hpp"
+#include "extractor/parallel_scc.hpp"
+#include "extractor/tarjan_scc.hpp"
+#include "util/dist_table_wrapper.hpp"
+#include "util/matrix_graph_wrapper.hpp"
+#include "util/static_graph.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(strongly_connected_components)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+struct TestData
+{
+};
+using TestGraph = util::StaticGraph<TestData>;
+
+// Chosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 15;
+
+// A strongly connected core of the first nodes with sparse random edges around it
+std::shared_ptr<const TestGraph> MakeRandomGraph(const unsigned number_of_nodes,
+                                                 const unsigned core_size,
+                                                 const unsigned number_of_edges)
+{
+    std::mt19937 generator(RANDOM_SEED);
+    std::uniform_int_distribution<unsigned> node_distribution(0, number_of_nodes - 1);
+
+    std::vector<TestGraph::InputEdge> edges;
+    for (unsigned node = 0; node < core_size; ++node)
+    {
+        edges.emplace_back(node, (node + 1) % core_size);
+    }
+    for (unsigned edge = 0; edge < number_of_edges; ++edge)
+    {
+        const auto source = node_distribution(generator);
+        // short edges give many small components
+        const auto target =
+            std::min(number_of_nodes - 1, source + node_distribution(generator) % 8);
+        edges.emplace_back(source, target);
+        if (node_distribution(generator) % 3 == 0)
+        {
+            edges.emplace_back(target, source);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    return std::make_shared<const TestGraph>(number_of_nodes, edges);
+}
+
+template <typename ExpectedSCC, typename ActualSCC>
+void CheckSamePartition(const ExpectedSCC &expected, const ActualSCC &actual, const NodeID size)
+{
+    BOOST_REQUIRE_EQUAL(expected.GetNumberOfComponents(), actual.GetNumberOfComponents());
+
+    std::vector<unsigned> expected_to_actual(expected.GetNumberOfComponents(), SPECIAL_NODEID);
+    for (NodeID node = 0; node < size; ++node)
+    {
+        const auto expected_id = expected.GetComponentID(node);
+        const auto actual_id = actual.GetComponentID(node);
+        if (expected_to_actual[expected_id] == SPECIAL_NODEID)
+        {
+            expected_to_actual[expected_id] = actual_id;
+            BOOST_CHECK_EQUAL(expected.GetComponentSize(expected_id),
+                              actual.GetComponentSize(actual_id));
+        }
+        BOOST_CHECK_EQUAL(expected_to_actual[expected_id], actual_id);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_matches_tarjan)
+{
+    const unsigned number_of_nodes = 20000;
+    const auto graph = MakeRandomGraph(number_of_nodes, 5000, 30000);
+
+    TarjanSCC<TestGraph> tarjan(graph);
+    tarjan.Run();
+    ParallelSCC<TestGraph> parallel(graph);
+    parallel.Run();
+
+    CheckSamePartition(tarjan, parallel, number_of_nodes);
+    BOOST_CHECK_EQUAL(tarjan.GetSizeOneCount(), parallel.GetSizeOneCount());
+
+    // numbered in order of the smallest node of a component
+    unsigned next_id = 0;
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        BOOST_CHECK_LE(parallel.GetComponentID(node), next_id);
+        next_id = std::max(next_id, parallel.GetComponentID(node) + 1);
+    }
+    BOOST_CHECK_GE(parallel.GetComponentSize(parallel.GetComponentID(0)), 5000);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_without_edges)
+{
+    const std::vector<TestGraph::InputEdge> edges;
+    const auto graph = std::make_shared<const TestGraph>(10, edges);
+
+    ParallelSCC<TestGraph> parallel(graph);
+    parallel.Run();
+
+    BOOST_CHECK_EQUAL(parallel.GetNumberOfComponents(), 10);
+    BOOST_CHECK_EQUAL(parallel.GetSizeOneCount(), 10);
+    for (NodeID node = 0; node < 10; ++node)
+    {
+        BOOST_CHECK_EQUAL(parallel.GetComponentID(node), node);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(matrix_matches_tarjan)
+{
+    std::mt19937 generator(RANDOM_SEED);
+    std::uniform_int_distribution<int> weight_distribution(0, 9);
+
+    MatrixSCC matrix_scc;
+    for (const std::size_t number_of_nodes : {1, 2, 5, 12, 30, 12})
+    {
+        std::vector<EdgeWeight> table(number_of_nodes * number_of_nodes);
+        for (auto &weight : table)
+        {
+            const auto value = weight_distribution(generator);
+            weight = value < 7 ? INVALID_EDGE_WEIGHT : value;
+        }
+
+        const auto wrapper =
+            std::make_shared<util::MatrixGraphWrapper<EdgeWeight>>(table, number_of_nodes);
+        TarjanSCC<util::MatrixGraphWrapper<EdgeWeight>> tarjan(wrapper);
+        tarjan.Run();
+        matrix_scc.Run(util::DistTableWrapper<EdgeWeight>(table, number_of_nodes));
+
+        BOOST_REQUIRE_EQUAL(tarjan.GetNumberOfComponents(), matrix_scc.GetNumberOfComponents());
+        for (NodeID node = 0; node < number_of_nodes; ++node)
+        {
+            BOOST_CHECK_EQUAL(tarjan.GetComponentID(node), matrix_scc.GetComponentID(node));
+        }
+        for (unsigned component = 0; component < tarjan.GetNumberOfComponents(); ++component)
+        {
+            BOOST_CHECK_EQUAL(tarjan.GetComponentSize(component),
+                              matrix_scc.GetComponentSize(component));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,60 @@
+#include "extractor/turn_cost_tables.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(turn_cost_tables)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+BOOST_AUTO_TEST_CASE(equal_tables_are_shared)
+{
+    const auto X = INVALID_EDGE_WEIGHT;
+    // two T junctions with the same costs, a dead end and a node without edges
+    const std::vector<EdgeWeight> t_junction = {X, 10, 20, 10, X, 30, 20, 30, X};
+    const std::vector<EdgeWeight> dead_end = {5};
+
+    TurnCostTables tables;
+    tables.AddIntersection(t_junction);
+    tables.AddIntersection(dead_end);
+    tables.AddIntersection(t_junction);
+    tables.AddIntersection({});
+
+    BOOST_CHECK_EQUAL(tables.GetNumberOfIntersections(), 4);
+    BOOST_CHECK_EQUAL(tables.GetNumberOfTables(), 3);
+    BOOST_CHECK_EQUAL(tables.GetDegree(0), 3);
+    BOOST_CHECK_EQUAL(tables.GetDegree(1), 1);
+    BOOST_CHECK_EQUAL(tables.GetDegree(3), 0);
+    BOOST_CHECK_EQUAL(tables.GetTurnCost(2, 1, 2), 30);
+    BOOST_CHECK_EQUAL(tables.GetTurnCost(2, 2, 0), 20);
+    BOOST_CHECK_EQUAL(tables.GetTurnCost(0, 1, 1), INVALID_EDGE_WEIGHT);
+    BOOST_CHECK_EQUAL(tables.GetTurnCost(1, 0, 0), 5);
+}
+
+BOOST_AUTO_TEST_CASE(write_and_read)
+{
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("osrm-turn-costs-%%%%-%%%%");
+
+    TurnCostTables tables;
+    tables.AddIntersection({1, 2, 3, 4});
+    tables.AddIntersection({7});
+    tables.AddIntersection({1, 2, 3, 4});
+    tables.Write(path.string());
+
+    TurnCostTables read_tables;
+    read_tables.Read(path.string());
+    BOOST_CHECK_EQUAL(read_tables.GetNumberOfIntersections(), 3);
+    BOOST_CHECK_EQUAL(read_tables.GetNumberOfTables(), 2);
+    BOOST_CHECK_EQUAL(read_tables.GetSize(), tables.GetSize());
+    BOOST_CHECK_EQUAL(read_tables.GetTurnCost(2, 1, 0), 3);
+    BOOST_CHECK_EQUAL(read_tables.GetTurnCost(1, 0, 0), 7);
+
+    boost::filesystem::remove(path);
+    BOOST_CHECK_THROW(read_tables.Read(path.string()), util::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
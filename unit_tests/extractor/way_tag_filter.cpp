@@ -0,0 +1,92 @@
+#include "extractor/way_tag_filter.hpp"
+#include "util/exception.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+BOOST_AUTO_TEST_SUITE(way_tag_filter)
+
+using namespace osrm;
+using namespace osrm::extractor;
+
+namespace
+{
+// the rules car.lua declares, cut down to a few values
+WayTagFilter MakeCarFilter()
+{
+    WayTagFilter filter;
+    filter.Require("tagged", "highway", "");
+    filter.Require("tagged", "route", "");
+    filter.Require("speed", "highway", "primary");
+    filter.Require("speed", "route", "ferry");
+    filter.AddAccessKey("motorcar");
+    filter.AddAccessKey("access");
+    filter.RequireAccess("speed", "yes");
+    filter.RejectAccess("no");
+    filter.Reject("area", "yes");
+    return filter;
+}
+
+bool Rejects(const WayTagFilter &filter,
+             const std::initializer_list<std::pair<const char *, const char *>> &tags)
+{
+    osmium::memory::Buffer buffer(1024);
+    const auto offset = osmium::builder::add_tag_list(buffer, osmium::builder::attr::_tags(tags));
+    return filter.Rejects(buffer.get<osmium::TagList>(offset));
+}
+}
+
+BOOST_AUTO_TEST_CASE(rejects_unroutable_ways)
+{
+    const auto filter = MakeCarFilter();
+
+    BOOST_CHECK(!Rejects(filter, {{"highway", "primary"}, {"name", "Main Street"}}));
+    BOOST_CHECK(!Rejects(filter, {{"route", "ferry"}}));
+
+    // no tag of the "tagged" group, or one with an empty value
+    BOOST_CHECK(Rejects(filter, {{"building", "yes"}}));
+    BOOST_CHECK(Rejects(filter, {{"highway", ""}, {"access", "yes"}}));
+    // no tag of the "speed" group
+    BOOST_CHECK(Rejects(filter, {{"highway", "footway"}}));
+    BOOST_CHECK(!Rejects(filter, {{"highway", "footway"}, {"access", "yes"}}));
+
+    BOOST_CHECK(Rejects(filter, {{"highway", "primary"}, {"area", "yes"}}));
+    BOOST_CHECK(!Rejects(filter, {{"highway", "primary"}, {"area", "no"}}));
+}
+
+BOOST_AUTO_TEST_CASE(access_hierarchy)
+{
+    const auto filter = MakeCarFilter();
+
+    BOOST_CHECK(Rejects(filter, {{"highway", "primary"}, {"access", "no"}}));
+    // the first access key a way has decides
+    BOOST_CHECK(!Rejects(filter, {{"highway", "primary"}, {"access", "no"}, {"motorcar", "yes"}}));
+    BOOST_CHECK(Rejects(filter, {{"highway", "footway"}, {"access", "yes"}, {"motorcar", "no"}}));
+    BOOST_CHECK(!Rejects(filter, {{"highway", "primary"}, {"motorcar", ""}, {"access", "yes"}}));
+}
+
+BOOST_AUTO_TEST_CASE(empty_filter)
+{
+    WayTagFilter filter;
+    BOOST_CHECK(filter.Empty());
+    BOOST_CHECK(!filter.Rejects(osmium::TagList()));
+    BOOST_CHECK(!MakeCarFilter().Empty());
+}
+
+BOOST_AUTO_TEST_CASE(too_many_groups)
+{
+    WayTagFilter filter;
+    for (int group = 0; group < 32; ++group)
+    {
+        filter.Require(std::to_string(group), "highway", "");
+    }
+    BOOST_CHECK_THROW(filter.Require("32", "highway", ""), util::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -13,6 +13,10 @@
 #include "osrm/osrm.hpp"
 #include "osrm/status.hpp"
 
+#include <future>
+#include <string>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(nearest)
 
 BOOST_AUTO_TEST_CASE(test_nearest_response)
@@ -43,6 +47,34 @@ BOOST_AUTO_TEST_CASE(test_nearest_response)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_nearest_response_async)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    NearestParameters params;
+    params.coordinates.push_back(get_dummy_location());
+
+    json::Object expected_result;
+    const auto expected_rc = osrm.Nearest(params, expected_result);
+
+    std::promise<Status> rc;
+    json::Object result;
+    const auto queued = osrm.NearestAsync(params, [&](const Status status, json::Object &async) {
+        result = std::move(async);
+        rc.set_value(status);
+    });
+    BOOST_REQUIRE(queued);
+    BOOST_CHECK(rc.get_future().get() == expected_rc);
+
+    const auto code = result.values.at("code").get<json::String>().value;
+    BOOST_CHECK_EQUAL(code, "Ok");
+    BOOST_CHECK_EQUAL(result.values.at("waypoints").get<json::Array>().values.size(),
+                      expected_result.values.at("waypoints").get<json::Array>().values.size());
+}
+
 BOOST_AUTO_TEST_CASE(test_nearest_response_no_coordinates)
 {
     const auto args = get_args();
@@ -73,10 +105,24 @@ BOOST_AUTO_TEST_CASE(test_nearest_response_multiple_coordinates)
 
     json::Object result;
     const auto rc = osrm.Nearest(params, result);
-    BOOST_REQUIRE(rc == Status::Error);
+    BOOST_REQUIRE(rc == Status::Ok);
 
     const auto code = result.values.at("code").get<json::String>().value;
-    BOOST_CHECK_EQUAL(code, "InvalidOptions");
+    BOOST_CHECK_EQUAL(code, "Ok");
+
+    // one array of candidates per input coordinate
+    const auto &waypoints = result.values.at("waypoints").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(waypoints.size(), 2);
+    for (const auto &candidates : waypoints)
+    {
+        BOOST_CHECK(!candidates.get<json::Array>().values.empty());
+    }
+
+    std::vector<char> rendered;
+    const auto rendered_rc = osrm.Nearest(params, rendered);
+    BOOST_REQUIRE(rendered_rc == Status::Ok);
+    const std::string rendered_text(rendered.begin(), rendered.end());
+    BOOST_CHECK_EQUAL(rendered_text.find("{\"waypoints\":[["), 0);
 }
 
 BOOST_AUTO_TEST_CASE(test_nearest_response_for_location_in_small_component)
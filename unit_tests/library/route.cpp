@@ -14,6 +14,8 @@
 #include "osrm/route_parameters.hpp"
 #include "osrm/status.hpp"
 
+#include "util/integer_range.hpp"
+
 BOOST_AUTO_TEST_SUITE(route)
 
 BOOST_AUTO_TEST_CASE(test_route_same_coordinates_fixture)
@@ -361,4 +363,82 @@ BOOST_AUTO_TEST_CASE(test_route_response_for_locations_across_components)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_route_without_geometry_matches_full_route)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    const auto locations = get_locations_in_big_component();
+
+    // with neither steps nor overview the legs are assembled without their geometry
+    RouteParameters lean_params;
+    lean_params.overview = RouteParameters::OverviewType::False;
+    lean_params.coordinates = locations;
+
+    RouteParameters full_params;
+    full_params.steps = true;
+    full_params.overview = RouteParameters::OverviewType::Full;
+    full_params.coordinates = locations;
+
+    json::Object lean_result;
+    json::Object full_result;
+    BOOST_CHECK(osrm.Route(lean_params, lean_result) == Status::Ok);
+    BOOST_CHECK(osrm.Route(full_params, full_result) == Status::Ok);
+
+    const auto &lean_route =
+        lean_result.values.at("routes").get<json::Array>().values.at(0).get<json::Object>();
+    const auto &full_route =
+        full_result.values.at("routes").get<json::Array>().values.at(0).get<json::Object>();
+    BOOST_CHECK(lean_route.values.find("geometry") == lean_route.values.end());
+
+    const auto number = [](const json::Object &object, const char *key) {
+        return object.values.at(key).get<json::Number>().value;
+    };
+    BOOST_CHECK_EQUAL(number(lean_route, "duration"), number(full_route, "duration"));
+    BOOST_CHECK_EQUAL(number(lean_route, "distance"), number(full_route, "distance"));
+
+    const auto &lean_legs = lean_route.values.at("legs").get<json::Array>().values;
+    const auto &full_legs = full_route.values.at("legs").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(lean_legs.size(), full_legs.size());
+    for (const auto idx : util::irange<std::size_t>(0UL, lean_legs.size()))
+    {
+        const auto &lean_leg = lean_legs[idx].get<json::Object>();
+        const auto &full_leg = full_legs[idx].get<json::Object>();
+        BOOST_CHECK_EQUAL(number(lean_leg, "duration"), number(full_leg, "duration"));
+        BOOST_CHECK_EQUAL(number(lean_leg, "distance"), number(full_leg, "distance"));
+        BOOST_CHECK(lean_leg.values.at("steps").get<json::Array>().values.empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_route_on_snapshot)
+{
+    const auto args = get_args();
+    auto osrm = getOSRM(args.at(0));
+
+    using namespace osrm;
+
+    RouteParameters params;
+    params.steps = true;
+    params.coordinates = get_locations_in_big_component();
+
+    json::Object result;
+    BOOST_CHECK(osrm.Route(params, result) == Status::Ok);
+
+    const auto snapshot = osrm.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshot.GetDatasetGeneration(), osrm.GetDatasetGeneration());
+    BOOST_CHECK_EQUAL(snapshot.GetTimestamp(), osrm.GetTimestamp());
+
+    json::Object snapshot_result;
+    BOOST_CHECK(snapshot.Route(params, snapshot_result) == Status::Ok);
+    CHECK_EQUAL_JSON(result, snapshot_result);
+
+    // copies pin the same dataset
+    const auto copy = snapshot;
+    json::Object copy_result;
+    BOOST_CHECK(copy.Route(params, copy_result) == Status::Ok);
+    CHECK_EQUAL_JSON(result, copy_result);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
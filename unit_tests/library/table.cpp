@@ -161,4 +161,114 @@ BOOST_AUTO_TEST_CASE(test_table_three_coordinates_matrix)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_table_three_coordinates_distances)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    TableParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.annotations = TableParameters::AnnotationsType::All;
+
+    json::Object result;
+
+    const auto rc = osrm.Table(params, result);
+
+    BOOST_CHECK(rc == Status::Ok || rc == Status::Error);
+    const auto code = result.values.at("code").get<json::String>().value;
+    BOOST_CHECK_EQUAL(code, "Ok");
+
+    // both matrices are 3x3 with zeros on the diagonal
+    const auto &durations_array = result.values.at("durations").get<json::Array>().values;
+    const auto &distances_array = result.values.at("distances").get<json::Array>().values;
+    BOOST_CHECK_EQUAL(durations_array.size(), params.coordinates.size());
+    BOOST_CHECK_EQUAL(distances_array.size(), params.coordinates.size());
+    for (unsigned int i = 0; i < distances_array.size(); i++)
+    {
+        const auto distances_matrix = distances_array[i].get<json::Array>().values;
+        BOOST_CHECK_EQUAL(distances_matrix.size(), params.coordinates.size());
+        BOOST_CHECK_EQUAL(distances_matrix[i].get<json::Number>().value, 0);
+    }
+
+    // only the requested matrix is returned
+    params.annotations = TableParameters::AnnotationsType::Distance;
+    json::Object distances_only;
+    BOOST_CHECK(osrm.Table(params, distances_only) == Status::Ok);
+    BOOST_CHECK(distances_only.values.count("durations") == 0);
+    BOOST_CHECK(distances_only.values.count("distances") == 1);
+}
+
+// A single source with many targets takes the one-to-many sweep, which has to give the same table
+// as the bucket searches that answer it as soon as there is a second source. One target lies on
+// the segment of the source, one directly behind and one directly ahead of it.
+BOOST_AUTO_TEST_CASE(test_table_one_source_many_targets)
+{
+    const auto args = get_args();
+    BOOST_REQUIRE_EQUAL(args.size(), 1);
+
+    using namespace osrm;
+
+    auto osrm = getOSRM(args[0]);
+
+    const auto source = get_dummy_location();
+    TableParameters params;
+    params.coordinates.push_back(source);
+    params.coordinates.push_back(source);
+    params.coordinates.push_back(
+        {Longitude{static_cast<double>(toFloating(source.lon)) - 0.00002}, toFloating(source.lat)});
+    params.coordinates.push_back(
+        {Longitude{static_cast<double>(toFloating(source.lon)) + 0.00002}, toFloating(source.lat)});
+    for (unsigned row = 0; row < 8; ++row)
+    {
+        for (unsigned column = 0; column < 8; ++column)
+        {
+            params.coordinates.push_back(
+                {Longitude{7.412 + 0.0035 * column}, Latitude{43.728 + 0.0025 * row}});
+        }
+    }
+    for (std::size_t index = 1; index < params.coordinates.size(); ++index)
+    {
+        params.destinations.push_back(index);
+    }
+    BOOST_REQUIRE_GE(params.destinations.size(), 64);
+    params.annotations = TableParameters::AnnotationsType::All;
+
+    params.sources = {0};
+    json::Object one_to_many;
+    BOOST_REQUIRE(osrm.Table(params, one_to_many) == Status::Ok);
+
+    params.sources = {0, 1};
+    json::Object buckets;
+    BOOST_REQUIRE(osrm.Table(params, buckets) == Status::Ok);
+
+    for (const auto annotation : {"durations", "distances"})
+    {
+        const auto &one_to_many_row =
+            one_to_many.values.at(annotation).get<json::Array>().values.at(0).get<json::Array>();
+        const auto &buckets_row =
+            buckets.values.at(annotation).get<json::Array>().values.at(0).get<json::Array>();
+        BOOST_REQUIRE_EQUAL(one_to_many_row.values.size(), params.destinations.size());
+        BOOST_REQUIRE_EQUAL(buckets_row.values.size(), params.destinations.size());
+        for (std::size_t column = 0; column < params.destinations.size(); ++column)
+        {
+            const auto &value = one_to_many_row.values[column];
+            const auto &expected = buckets_row.values[column];
+            BOOST_REQUIRE_EQUAL(value.is<json::Null>(), expected.is<json::Null>());
+            if (!expected.is<json::Null>())
+            {
+                BOOST_CHECK_EQUAL(value.get<json::Number>().value,
+                                  expected.get<json::Number>().value);
+            }
+        }
+        // the target on the source itself
+        BOOST_CHECK_EQUAL(one_to_many_row.values[0].get<json::Number>().value, 0);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
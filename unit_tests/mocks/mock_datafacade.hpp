@@ -20,6 +20,8 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
 {
   private:
     EdgeData foo;
+    partition::MultiLevelPartition multi_level_partition;
+    partition::CellStorage cell_storage;
 
   public:
     unsigned GetNumberOfNodes() const override { return 0; }
@@ -27,12 +29,25 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
     unsigned GetOutDegree(const NodeID /* n */) const override { return 0; }
     NodeID GetTarget(const EdgeID /* e */) const override { return SPECIAL_NODEID; }
     const EdgeData &GetEdgeData(const EdgeID /* e */) const override { return foo; }
+    AdjacentEdge GetAdjacentEdge(const EdgeID /* e */) const override
+    {
+        return {SPECIAL_NODEID, foo};
+    }
+    bool HasEdgeLengths() const override { return false; }
+    EdgeLength GetEdgeLength(const EdgeID /* e */) const override { return 0; }
+    std::vector<NodeID> GetDuplicatedNodes(const NodeID /* n */) const override { return {}; }
+    NodeID GetOriginalNode(const NodeID n) const override { return n; }
     EdgeID BeginEdges(const NodeID /* n */) const override { return SPECIAL_EDGEID; }
     EdgeID EndEdges(const NodeID /* n */) const override { return SPECIAL_EDGEID; }
     osrm::engine::datafacade::EdgeRange GetAdjacentEdgeRange(const NodeID /* node */) const override
     {
         return util::irange(static_cast<EdgeID>(0), static_cast<EdgeID>(0));
     }
+    osrm::engine::datafacade::EdgeRange
+    GetDirectedEdgeRange(const NodeID /* node */, const bool /* forward_direction */) const override
+    {
+        return util::irange(static_cast<EdgeID>(0), static_cast<EdgeID>(0));
+    }
     EdgeID FindEdge(const NodeID /* from */, const NodeID /* to */) const override
     {
         return SPECIAL_EDGEID;
@@ -69,6 +84,18 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
                                     std::vector<uint8_t> & /*data_sources*/) const override
     {
     }
+    util::StridedView<NodeID> GetUncompressedGeometryView(const EdgeID /* id */) const override
+    {
+        return {};
+    }
+    util::StridedView<EdgeWeight> GetUncompressedWeightsView(const EdgeID /* id */) const override
+    {
+        return {};
+    }
+    util::StridedView<uint8_t> GetUncompressedDatasourcesView(const EdgeID /*id*/) const override
+    {
+        return {};
+    }
     std::string GetDatasourceName(const uint8_t /*datasource_name_id*/) const override
     {
         return "";
@@ -114,6 +141,17 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
         return {};
     }
 
+    std::vector<std::vector<engine::PhantomNodeWithDistance>>
+    NearestPhantomNodes(const std::vector<util::Coordinate> &input_coordinates,
+                        const unsigned /*max_results*/,
+                        const std::vector<boost::optional<double>> & /*radiuses*/,
+                        const std::vector<boost::optional<engine::Bearing>> & /*bearings*/) const
+        override
+    {
+        return std::vector<std::vector<engine::PhantomNodeWithDistance>>(
+            input_coordinates.size());
+    }
+
     std::vector<engine::PhantomNodeWithDistance>
     NearestPhantomNodes(const util::Coordinate /*input_coordinate*/,
                         const unsigned /*max_results*/,
@@ -169,14 +207,41 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
         return {};
     };
 
+    std::vector<std::pair<engine::PhantomNode, engine::PhantomNode>>
+    NearestPhantomNodesWithAlternativeFromBigComponent(
+        const std::vector<util::Coordinate> &input_coordinates) const override
+    {
+        return std::vector<std::pair<engine::PhantomNode, engine::PhantomNode>>(
+            input_coordinates.size());
+    }
+
     unsigned GetCheckSum() const override { return 0; }
     bool IsCoreNode(const NodeID /* id */) const override { return false; }
     unsigned GetNameIndexFromEdgeID(const unsigned /* id */) const override { return 0; }
     std::string GetNameForID(const unsigned /* name_id */) const override { return ""; }
     std::string GetPronunciationForID(const unsigned /* name_id */) const override { return ""; }
     std::string GetDestinationsForID(const unsigned /* name_id */) const override { return ""; }
+    util::StringView GetNameViewForID(const unsigned /* name_id */) const override { return {}; }
+    util::StringView GetPronunciationViewForID(const unsigned /* name_id */) const override
+    {
+        return {};
+    }
+    util::StringView GetDestinationsViewForID(const unsigned /* name_id */) const override
+    {
+        return {};
+    }
     std::size_t GetCoreSize() const override { return 0; }
+    std::size_t GetNumberOfCoreLandmarkDistances() const override { return 0; }
+    const EdgeWeight *GetCoreLandmarkDistances() const override { return nullptr; }
+    unsigned GetNumberOfTimeSlots() const override { return 0; }
+    unsigned GetTimeSlotDuration() const override { return 0; }
+    unsigned GetNumberOfMetrics() const override { return 0; }
+    extractor::EdgeClasses GetExcludedClasses(const unsigned) const override
+    {
+        return EDGE_CLASS_NONE;
+    }
     std::string GetTimestamp() const override { return ""; }
+    bool HasGuidanceData() const override { return true; }
     bool GetContinueStraightDefault() const override { return true; }
     BearingClassID GetBearingClassID(const NodeID /*id*/) const override { return 0; };
     EntryClassID GetEntryClassID(const EdgeID /*id*/) const override { return 0; }
@@ -203,6 +268,13 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
         return result;
     }
 
+    util::guidance::BearingRange
+    GetBearings(const BearingClassID /*bearing_class_id*/) const override
+    {
+        static const DiscreteBearing bearings[] = {0, 90, 180, 270};
+        return {std::begin(bearings), std::end(bearings)};
+    }
+
     util::guidance::EntryClass GetEntryClass(const EntryClassID /*entry_class_id*/) const override
     {
         util::guidance::EntryClass result;
@@ -211,6 +283,22 @@ class MockDataFacade final : public engine::datafacade::BaseDataFacade
         result.activate(3);
         return result;
     }
+
+    bool HasMultiLevelData() const override { return false; }
+    const partition::MultiLevelPartition &GetMultiLevelPartition() const override
+    {
+        return multi_level_partition;
+    }
+    const partition::CellStorage &GetCellStorage() const override { return cell_storage; }
+    osrm::engine::datafacade::EdgeRange
+    GetUncontractedAdjacentEdgeRange(const NodeID /* node */) const override
+    {
+        return util::irange(static_cast<EdgeID>(0), static_cast<EdgeID>(0));
+    }
+    NodeID GetUncontractedTarget(const EdgeID /* e */) const override { return SPECIAL_NODEID; }
+    const EdgeData &GetUncontractedEdgeData(const EdgeID /* e */) const override { return foo; }
+
+    void WarmUp() const override {}
 };
 } // ns test
 } // ns osrm
@@ -0,0 +1,190 @@
+#include "partition/cell_customizer.hpp"
+#include "partition/cell_storage.hpp"
+#include "partition/multi_level_partition.hpp"
+#include "partition/recursive_bisection.hpp"
+
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(multi_level_partition)
+
+using namespace osrm;
+using namespace osrm::partition;
+
+namespace
+{
+constexpr unsigned GRID_SIZE = 12;
+constexpr unsigned NUMBER_OF_NODES = GRID_SIZE * GRID_SIZE;
+// Chosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 7;
+
+// Directed grid with random weights, every arc stored at both end points
+struct GridFixture
+{
+    GridFixture()
+    {
+        std::mt19937 generator(RANDOM_SEED);
+        std::uniform_int_distribution<> weight_distribution(1, 20);
+
+        std::vector<contractor::QueryEdge> edge_list;
+        const auto add_arc = [&](const NodeID from, const NodeID to) {
+            const EdgeWeight weight = weight_distribution(generator);
+            contractor::QueryEdge::EdgeData data;
+            data.id = static_cast<NodeID>(arcs.size());
+            data.distance = weight;
+            data.forward = true;
+            data.backward = false;
+            edge_list.emplace_back(from, to, data);
+            data.forward = false;
+            data.backward = true;
+            edge_list.emplace_back(to, from, data);
+            arcs.push_back(std::make_pair(from, to));
+            weights[std::make_pair(from, to)] = weight;
+        };
+        for (const auto row : util::irange(0u, GRID_SIZE))
+        {
+            for (const auto column : util::irange(0u, GRID_SIZE))
+            {
+                const NodeID node = row * GRID_SIZE + column;
+                if (column + 1 < GRID_SIZE)
+                {
+                    add_arc(node, node + 1);
+                    add_arc(node + 1, node);
+                }
+                if (row + 1 < GRID_SIZE)
+                {
+                    add_arc(node, node + GRID_SIZE);
+                    add_arc(node + GRID_SIZE, node);
+                }
+            }
+        }
+        std::sort(edge_list.begin(), edge_list.end());
+        graph.reset(new BaseGraph(NUMBER_OF_NODES, edge_list));
+    }
+
+    // plain Dijkstra on the arcs with both end points inside of the cell
+    EdgeWeight DistanceInCell(const MultiLevelPartition &partition,
+                              const LevelID level,
+                              const NodeID source,
+                              const NodeID target) const
+    {
+        const auto cell = partition.GetCell(level, source);
+        std::vector<EdgeWeight> distances(NUMBER_OF_NODES, INVALID_EDGE_WEIGHT);
+        std::set<std::pair<EdgeWeight, NodeID>> queue;
+        distances[source] = 0;
+        queue.emplace(0, source);
+        while (!queue.empty())
+        {
+            const auto node = queue.begin()->second;
+            queue.erase(queue.begin());
+            for (const auto &arc_weight : weights)
+            {
+                const auto from = arc_weight.first.first;
+                const auto to = arc_weight.first.second;
+                if (from != node || partition.GetCell(level, to) != cell)
+                    continue;
+                const auto distance = distances[node] + arc_weight.second;
+                if (distance < distances[to])
+                {
+                    queue.erase(std::make_pair(distances[to], to));
+                    distances[to] = distance;
+                    queue.emplace(distance, to);
+                }
+            }
+        }
+        return distances[target];
+    }
+
+    std::vector<std::pair<NodeID, NodeID>> arcs;
+    std::map<std::pair<NodeID, NodeID>, EdgeWeight> weights;
+    std::unique_ptr<BaseGraph> graph;
+};
+}
+
+BOOST_FIXTURE_TEST_CASE(bisection_nested_cells, GridFixture)
+{
+    const std::vector<std::size_t> max_cell_sizes = {8, 32, 64};
+    const auto partition = bisectGraph(NUMBER_OF_NODES, arcs, max_cell_sizes);
+
+    BOOST_CHECK_EQUAL(partition.GetNumberOfLevels(), 4);
+    BOOST_CHECK_EQUAL(partition.GetNumberOfNodes(), NUMBER_OF_NODES);
+
+    for (const auto level : util::irange<LevelID>(1, partition.GetNumberOfLevels()))
+    {
+        std::vector<std::size_t> cell_sizes(partition.GetNumberOfCells(level), 0);
+        for (const auto node : util::irange(0u, NUMBER_OF_NODES))
+        {
+            BOOST_REQUIRE_LT(partition.GetCell(level, node), cell_sizes.size());
+            ++cell_sizes[partition.GetCell(level, node)];
+
+            // nodes sharing a cell share all cells above it
+            for (const auto other : util::irange(0u, NUMBER_OF_NODES))
+            {
+                if (level > 1 &&
+                    partition.GetCell(level - 1, node) == partition.GetCell(level - 1, other))
+                {
+                    BOOST_CHECK_EQUAL(partition.GetCell(level, node),
+                                      partition.GetCell(level, other));
+                }
+            }
+        }
+        for (const auto size : cell_sizes)
+        {
+            BOOST_CHECK_GT(size, 0);
+            BOOST_CHECK_LE(size, max_cell_sizes[level - 1]);
+        }
+    }
+
+    BOOST_CHECK_EQUAL(partition.GetHighestDifferentLevel(0, 0), 0);
+    BOOST_CHECK_EQUAL(partition.GetHighestDifferentLevel(0, NUMBER_OF_NODES - 1), 3);
+}
+
+BOOST_FIXTURE_TEST_CASE(customized_cliques, GridFixture)
+{
+    const auto partition = bisectGraph(NUMBER_OF_NODES, arcs, {8, 32, 64});
+    CellStorage cells(partition, *graph);
+    CellCustomizer(partition).Customize(*graph, cells);
+
+    BOOST_CHECK_EQUAL(cells.GetNumberOfLevels(), partition.GetNumberOfLevels());
+    for (const auto level : util::irange<LevelID>(1, partition.GetNumberOfLevels()))
+    {
+        for (const auto id : util::irange<CellID>(0, partition.GetNumberOfCells(level)))
+        {
+            const auto cell = cells.GetCell(level, id);
+            for (const auto source_index : util::irange(0u, cell.GetNumberOfSources()))
+            {
+                const auto source = cell.GetSource(source_index);
+                BOOST_CHECK_EQUAL(partition.GetCell(level, source), id);
+                BOOST_CHECK_EQUAL(cell.GetSourceIndex(source), source_index);
+                for (const auto destination_index :
+                     util::irange(0u, cell.GetNumberOfDestinations()))
+                {
+                    const auto destination = cell.GetDestination(destination_index);
+                    BOOST_CHECK_EQUAL(cell.GetWeight(source_index, destination_index),
+                                      DistanceInCell(partition, level, source, destination));
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(invalid_cell_sizes)
+{
+    const std::vector<std::pair<NodeID, NodeID>> edges = {{0, 1}, {1, 2}};
+    BOOST_CHECK_THROW(bisectGraph(3, edges, {}), util::exception);
+    BOOST_CHECK_THROW(bisectGraph(3, edges, {2, 2}), util::exception);
+    BOOST_CHECK_THROW(bisectGraph(3, edges, {0, 2}), util::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+#include "server/compressor.hpp"
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <zlib.h>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(compressor)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+std::string decompress(std::vector<char> compressed, const int window_bits)
+{
+    z_stream stream{};
+    BOOST_REQUIRE_EQUAL(inflateInit2(&stream, window_bits), Z_OK);
+
+    std::vector<char> output(1 << 16);
+    stream.next_in = reinterpret_cast<Bytef *>(compressed.data());
+    stream.avail_in = static_cast<uInt>(compressed.size());
+    stream.next_out = reinterpret_cast<Bytef *>(output.data());
+    stream.avail_out = static_cast<uInt>(output.size());
+    BOOST_CHECK_EQUAL(inflate(&stream, Z_FINISH), Z_STREAM_END);
+    const auto size = stream.total_out;
+    inflateEnd(&stream);
+
+    return std::string(output.begin(), output.begin() + size);
+}
+}
+
+BOOST_AUTO_TEST_CASE(round_trip_reuses_streams)
+{
+    const std::string first = "{\"code\":\"Ok\",\"waypoints\":[]}";
+    const std::string second(5000, 'x');
+
+    Compressor compressor;
+    std::vector<char> output;
+    const auto initializations_before = Compressor::GetStatistics().stream_initializations.load();
+
+    compressor.Compress(std::vector<char>(first.begin(), first.end()), http::gzip_rfc1952, output);
+    BOOST_CHECK_EQUAL(decompress(output, MAX_WBITS + 16), first);
+
+    compressor.Compress(
+        std::vector<char>(second.begin(), second.end()), http::gzip_rfc1952, output);
+    BOOST_CHECK_EQUAL(decompress(output, MAX_WBITS + 16), second);
+
+    compressor.Compress(
+        std::vector<char>(first.begin(), first.end()), http::deflate_rfc1951, output);
+    BOOST_CHECK_EQUAL(decompress(output, -MAX_WBITS), first);
+
+    // one stream per compression type, the second gzip reply reused the first stream
+    BOOST_CHECK_EQUAL(Compressor::GetStatistics().stream_initializations.load() -
+                          initializations_before,
+                      2u);
+}
+
+BOOST_AUTO_TEST_CASE(chunks_form_one_stream)
+{
+    const std::string first(20000, 'a');
+    const std::string second = "{\"code\":\"Ok\"}";
+    const std::string last(3000, 'b');
+
+    Compressor compressor;
+    std::vector<char> compressed;
+    std::vector<char> output;
+    compressor.CompressChunk(
+        std::vector<char>(first.begin(), first.end()), http::gzip_rfc1952, output, true, false);
+    compressed.insert(compressed.end(), output.begin(), output.end());
+
+    // a single reply in between does not disturb the stream of another compression type
+    compressor.Compress(
+        std::vector<char>(second.begin(), second.end()), http::deflate_rfc1951, output);
+    BOOST_CHECK_EQUAL(decompress(output, -MAX_WBITS), second);
+
+    output.clear();
+    compressor.CompressChunk(
+        std::vector<char>(second.begin(), second.end()), http::gzip_rfc1952, output, false, false);
+    compressor.CompressChunk(
+        std::vector<char>(last.begin(), last.end()), http::gzip_rfc1952, output, false, true);
+    compressed.insert(compressed.end(), output.begin(), output.end());
+
+    BOOST_CHECK_EQUAL(decompress(compressed, MAX_WBITS + 16), first + second + last);
+}
+
+BOOST_AUTO_TEST_CASE(small_replies_are_not_compressed)
+{
+    Compressor::Configure(Z_BEST_COMPRESSION, 100);
+    BOOST_CHECK(!Compressor::ShouldCompress(99));
+    BOOST_CHECK(Compressor::ShouldCompress(100));
+
+    // the level applies to streams created afterwards
+    const std::string input(5000, 'x');
+    Compressor compressor;
+    std::vector<char> output;
+    compressor.Compress(std::vector<char>(input.begin(), input.end()), http::gzip_rfc1952, output);
+    BOOST_CHECK_EQUAL(decompress(output, MAX_WBITS + 16), input);
+
+    Compressor::Configure(Compressor::DEFAULT_LEVEL, Compressor::DEFAULT_MIN_SIZE);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
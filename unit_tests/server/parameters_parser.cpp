@@ -3,6 +3,7 @@
 #include "parameters_io.hpp"
 
 #include "engine/api/base_parameters.hpp"
+#include "engine/api/isochrone_parameters.hpp"
 #include "engine/api/match_parameters.hpp"
 #include "engine/api/nearest_parameters.hpp"
 #include "engine/api/route_parameters.hpp"
@@ -40,12 +41,21 @@ BOOST_AUTO_TEST_CASE(invalid_route_urls)
                       32UL);
     BOOST_CHECK_EQUAL(
         testInvalidOptions<RouteParameters>("1,2;3,4?overview=false&continue_straight=foo"), 41UL);
+    BOOST_CHECK_EQUAL(
+        testInvalidOptions<RouteParameters>("1,2;3,4?overview=false&departure_time=foo"), 38UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?overview=false&metric=foo"),
+                      30UL);
+    BOOST_CHECK_EQUAL(
+        testInvalidOptions<RouteParameters>("1,2;3,4?overview=false&exclude=toll,foo"), 35UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?overview=false&radiuses=foo"),
                       32UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?overview=false&hints=foo"),
                       29UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?overview=false&hints=;;; ;"),
                       32UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?overview=false&hints=" +
+                                                          std::string(70, 'A')),
+                      29UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?overview=false&geometries=foo"),
                       34UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4?overview=false&overview=foo"),
@@ -60,6 +70,10 @@ BOOST_AUTO_TEST_CASE(invalid_route_urls)
     BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>(std::string{"1,2;3,4"} + '\0' + ".json"),
                       7);
     BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>(std::string{"1,2;3,"} + '\0'), 6);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;"), 3);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3"), 5);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,-"), 6);
+    BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>("1,2;3,4e5"), 7);
 
     // BOOST_CHECK_EQUAL(testInvalidOptions<RouteParameters>(), );
 }
@@ -72,6 +86,43 @@ BOOST_AUTO_TEST_CASE(invalid_table_urls)
         testInvalidOptions<TableParameters>("1,2;3,4?sources=1&destinations=1&bla=foo"), 32UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?sources=foo"), 16UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?destinations=foo"), 21UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?annotations=speed"), 20UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?annotations=duration,"), 28UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?target_set=depots.1"), 25UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<TableParameters>("1,2;3,4?matrix_encoding=hex"), 24UL);
+}
+
+BOOST_AUTO_TEST_CASE(valid_coordinates)
+{
+    // the same coordinates as converting the closest double to fixed point
+    const auto coordinate = [](const double lon, const double lat) {
+        return util::Coordinate{util::toFixed(util::FloatLongitude{lon}),
+                                util::toFixed(util::FloatLatitude{lat})};
+    };
+
+    std::vector<util::Coordinate> coords_1 = {coordinate(7.416351, 43.731205),
+                                              coordinate(-7.420363, -43.736189),
+                                              coordinate(0.5, -0.25),
+                                              coordinate(13., 52.)};
+    auto result_1 = parseParameters<RouteParameters>(
+        "7.416351,43.731205;-7.420363,-43.736189;+.5,-.25;13.,52.?steps=true");
+    BOOST_CHECK(result_1);
+    CHECK_EQUAL_RANGE(coords_1, result_1->coordinates);
+
+    // more digits than a double holds exactly
+    std::vector<util::Coordinate> coords_2 = {
+        coordinate(7.4163510000000000001, 43.73120499999999999),
+        coordinate(0.000000999999999999999, 12.1234567891234567)};
+    auto result_2 = parseParameters<RouteParameters>(
+        "7.4163510000000000001,43.73120499999999999;0.000000999999999999999,12.1234567891234567");
+    BOOST_CHECK(result_2);
+    CHECK_EQUAL_RANGE(coords_2, result_2->coordinates);
+
+    // the format suffix is not part of the last number
+    std::vector<util::Coordinate> coords_3 = {coordinate(1, 2), coordinate(3.5, 4)};
+    auto result_3 = parseParameters<RouteParameters>("1,2;3.5,4.json");
+    BOOST_CHECK(result_3);
+    CHECK_EQUAL_RANGE(coords_3, result_3->coordinates);
 }
 
 BOOST_AUTO_TEST_CASE(valid_route_urls)
@@ -173,6 +224,17 @@ BOOST_AUTO_TEST_CASE(valid_route_urls)
     CHECK_EQUAL_RANGE(reference_4.coordinates, result_4->coordinates);
     CHECK_EQUAL_RANGE(reference_4.hints, result_4->hints);
 
+    // compact and full hints can be mixed
+    const auto compact_hint = hints_4[0]->ToCompactBase64();
+    std::vector<boost::optional<engine::Hint>> hints_compact = {
+        engine::Hint::FromBase64(compact_hint), boost::none, hints_4[2]};
+    auto result_compact = parseParameters<RouteParameters>(
+        "1,2;3,4;5,6?hints=" + compact_hint + ";;" + hints_4[2]->ToBase64());
+    BOOST_CHECK(result_compact);
+    CHECK_EQUAL_RANGE(hints_compact, result_compact->hints);
+    BOOST_CHECK(result_compact->hints[0]->IsCompact());
+    BOOST_CHECK(!result_compact->hints[2]->IsCompact());
+
     std::vector<boost::optional<engine::Bearing>> bearings_4 = {
         boost::none, engine::Bearing{200, 10}, engine::Bearing{100, 5},
     };
@@ -289,6 +351,33 @@ BOOST_AUTO_TEST_CASE(valid_route_urls)
     CHECK_EQUAL_RANGE(reference_10.radiuses, result_10->radiuses);
     CHECK_EQUAL_RANGE(reference_10.coordinates, result_10->coordinates);
     CHECK_EQUAL_RANGE(reference_10.hints, result_10->hints);
+
+    auto result_11 = parseParameters<RouteParameters>("1,2;3,4?departure_time=28800");
+    BOOST_CHECK(result_11);
+    BOOST_CHECK(result_11->departure_time);
+    BOOST_CHECK_EQUAL(*result_11->departure_time, 28800u);
+    BOOST_CHECK(!parseParameters<RouteParameters>("1,2;3,4")->departure_time);
+
+    auto result_12 = parseParameters<RouteParameters>("1,2;3,4?metric=2");
+    BOOST_CHECK(result_12);
+    BOOST_CHECK_EQUAL(result_12->metric, 2u);
+    BOOST_CHECK_EQUAL(parseParameters<RouteParameters>("1,2;3,4")->metric, 0u);
+
+    auto result_13 =
+        parseParameters<RouteParameters>("1,2;3,4?exclude=ferry&exclude=toll,motorway");
+    BOOST_CHECK(result_13);
+    BOOST_CHECK_EQUAL(result_13->exclude, EDGE_CLASS_TOLL | EDGE_CLASS_MOTORWAY);
+    BOOST_CHECK_EQUAL(parseParameters<RouteParameters>("1,2;3,4")->exclude, EDGE_CLASS_NONE);
+
+    auto result_14 = parseParameters<RouteParameters>("1,2;3,4?alternatives=3");
+    BOOST_CHECK(result_14);
+    BOOST_CHECK(result_14->alternatives);
+    BOOST_CHECK_EQUAL(result_14->number_of_alternatives, 3u);
+    auto result_15 = parseParameters<RouteParameters>("1,2;3,4?alternatives=3&alternatives=true");
+    BOOST_CHECK(result_15);
+    BOOST_CHECK(result_15->alternatives);
+    BOOST_CHECK_EQUAL(result_15->number_of_alternatives, 1u);
+    BOOST_CHECK(!parseParameters<RouteParameters>("1,2;3,4?alternatives=0")->alternatives);
 }
 
 BOOST_AUTO_TEST_CASE(valid_table_urls)
@@ -325,6 +414,64 @@ BOOST_AUTO_TEST_CASE(valid_table_urls)
     CHECK_EQUAL_RANGE(reference_1.bearings, result_3->bearings);
     CHECK_EQUAL_RANGE(reference_1.radiuses, result_3->radiuses);
     CHECK_EQUAL_RANGE(reference_1.coordinates, result_3->coordinates);
+
+    auto result_4 = parseParameters<TableParameters>("1,2;3,4.json?sources=all");
+    BOOST_CHECK(result_4);
+    BOOST_CHECK(result_4->format == TableParameters::OutputFormatType::JSON);
+    CHECK_EQUAL_RANGE(reference_1.coordinates, result_4->coordinates);
+
+    auto result_5 = parseParameters<TableParameters>("1,2;3,4.binary?sources=all");
+    BOOST_CHECK(result_5);
+    BOOST_CHECK(result_5->format == TableParameters::OutputFormatType::Binary);
+    BOOST_CHECK(result_5->IsValid());
+    CHECK_EQUAL_RANGE(reference_1.coordinates, result_5->coordinates);
+
+    BOOST_CHECK(result_1->annotations == TableParameters::AnnotationsType::Duration);
+
+    auto result_7 = parseParameters<TableParameters>("1,2;3,4?annotations=distance");
+    BOOST_CHECK(result_7);
+    BOOST_CHECK(result_7->annotations == TableParameters::AnnotationsType::Distance);
+    BOOST_CHECK(result_7->IsValid());
+
+    auto result_8 =
+        parseParameters<TableParameters>("1,2;3,4?annotations=distance,duration&sources=0");
+    BOOST_CHECK(result_8);
+    BOOST_CHECK(result_8->annotations == TableParameters::AnnotationsType::All);
+    BOOST_CHECK(result_8->HasAnnotation(TableParameters::AnnotationsType::Duration));
+    BOOST_CHECK(result_8->HasAnnotation(TableParameters::AnnotationsType::Distance));
+    BOOST_CHECK(result_8->matrix_encoding == TableParameters::MatrixEncodingType::Array);
+
+    auto result_12 = parseParameters<TableParameters>("1,2;3,4?matrix_encoding=base64");
+    BOOST_CHECK(result_12);
+    BOOST_CHECK(result_12->matrix_encoding == TableParameters::MatrixEncodingType::Base64);
+    BOOST_CHECK(result_12->distribute);
+
+    // peers search their share of a distributed table themselves
+    auto result_13 = parseParameters<TableParameters>("1,2;3,4?distribute=false");
+    BOOST_CHECK(result_13);
+    BOOST_CHECK(!result_13->distribute);
+
+    // registers the destinations as target set
+    auto result_9 = parseParameters<TableParameters>("1,2;3,4?destinations=1&target_set=depots-1");
+    BOOST_CHECK(result_9);
+    BOOST_CHECK_EQUAL(result_9->target_set, "depots-1");
+    BOOST_CHECK(!result_9->UsesTargetSet());
+    BOOST_CHECK(result_9->IsValid());
+
+    // against a registered target set a single source is enough
+    auto result_10 = parseParameters<TableParameters>("1,2?target_set=depots-1");
+    BOOST_CHECK(result_10);
+    BOOST_CHECK(result_10->UsesTargetSet());
+    BOOST_CHECK(result_10->IsValid());
+
+    auto result_11 = parseParameters<TableParameters>("1,2");
+    BOOST_CHECK(result_11);
+    BOOST_CHECK(!result_11->IsValid());
+
+    // binary output is not implemented for the route service
+    auto result_6 = parseParameters<RouteParameters>("1,2;3,4.binary");
+    BOOST_CHECK(result_6);
+    BOOST_CHECK(!result_6->IsValid());
 }
 
 BOOST_AUTO_TEST_CASE(valid_match_urls)
@@ -350,6 +497,27 @@ BOOST_AUTO_TEST_CASE(valid_match_urls)
     CHECK_EQUAL_RANGE(reference_2.bearings, result_2->bearings);
     CHECK_EQUAL_RANGE(reference_2.radiuses, result_2->radiuses);
     CHECK_EQUAL_RANGE(reference_2.coordinates, result_2->coordinates);
+
+    // sessions continue a trace, so a single coordinate is enough
+    std::vector<util::Coordinate> coords_2 = {{util::FloatLongitude{1}, util::FloatLatitude{2}}};
+    MatchParameters reference_3{};
+    reference_3.coordinates = coords_2;
+    reference_3.session = "vehicle-42_a";
+    auto result_3 = parseParameters<MatchParameters>("1,2?session=vehicle-42_a");
+    BOOST_CHECK(result_3);
+    BOOST_CHECK_EQUAL(reference_3.session, result_3->session);
+    CHECK_EQUAL_RANGE(reference_3.coordinates, result_3->coordinates);
+    BOOST_CHECK(result_3->IsValid());
+
+    auto result_4 = parseParameters<MatchParameters>("1,2");
+    BOOST_CHECK(result_4);
+    BOOST_CHECK(!result_4->IsValid());
+
+    auto result_5 = parseParameters<MatchParameters>("1,2;3,4?tidy=true&timestamps=5;6");
+    BOOST_CHECK(result_5);
+    BOOST_CHECK(result_5->tidy);
+    CHECK_EQUAL_RANGE(reference_2.timestamps, result_5->timestamps);
+    BOOST_CHECK(!parseParameters<MatchParameters>("1,2;3,4")->tidy);
 }
 
 BOOST_AUTO_TEST_CASE(valid_nearest_urls)
@@ -374,6 +542,35 @@ BOOST_AUTO_TEST_CASE(valid_nearest_urls)
     CHECK_EQUAL_RANGE(reference_2.bearings, result_2->bearings);
     CHECK_EQUAL_RANGE(reference_2.radiuses, result_2->radiuses);
     CHECK_EQUAL_RANGE(reference_2.coordinates, result_2->coordinates);
+    BOOST_CHECK(!result_2->debug);
+
+    auto result_3 = parseParameters<NearestParameters>("1,2?debug=true&number=3");
+    BOOST_CHECK(result_3);
+    BOOST_CHECK(result_3->debug);
+    BOOST_CHECK_EQUAL(result_3->number_of_results, 3);
+    BOOST_CHECK_EQUAL(testInvalidOptions<NearestParameters>("1,2?debug=foo"), 10UL);
+}
+
+BOOST_AUTO_TEST_CASE(valid_isochrone_urls)
+{
+    std::vector<util::Coordinate> coords_1 = {{util::FloatLongitude{1}, util::FloatLatitude{2}}};
+
+    auto result_1 = parseParameters<IsochroneParameters>("1,2?duration=600");
+    BOOST_CHECK(result_1);
+    BOOST_CHECK(result_1->IsValid());
+    BOOST_CHECK_EQUAL(result_1->duration, 600);
+    BOOST_CHECK_EQUAL(result_1->segments, false);
+    CHECK_EQUAL_RANGE(coords_1, result_1->coordinates);
+
+    auto result_2 = parseParameters<IsochroneParameters>("1,2?segments=true&duration=60");
+    BOOST_CHECK(result_2);
+    BOOST_CHECK_EQUAL(result_2->duration, 60);
+    BOOST_CHECK_EQUAL(result_2->segments, true);
+
+    // the duration is required
+    auto result_3 = parseParameters<IsochroneParameters>("1,2");
+    BOOST_CHECK(result_3);
+    BOOST_CHECK(!result_3->IsValid());
 }
 
 BOOST_AUTO_TEST_CASE(valid_tile_urls)
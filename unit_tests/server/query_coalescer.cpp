@@ -0,0 +1,149 @@
+#include "server/query_coalescer.hpp"
+
+#include "util/json_container.hpp"
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(query_coalescer)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+QueryCoalescer::QueryT CountingQuery(std::atomic<int> &runs, const double value)
+{
+    return [&runs, value](QueryCoalescer::ResultT &result) {
+        ++runs;
+        util::json::Object object;
+        object.values["value"] = value;
+        result = std::move(object);
+        return engine::Status::Ok;
+    };
+}
+
+double Value(const QueryCoalescer::ResultT &result)
+{
+    return result.get<util::json::Object>()
+        .values.at("value")
+        .get<util::json::Number>()
+        .value;
+}
+}
+
+BOOST_AUTO_TEST_CASE(make_key)
+{
+    const auto route_key = [](const std::string &query) {
+        return QueryCoalescer::MakeKey("route", 1, query);
+    };
+
+    BOOST_CHECK_EQUAL(route_key("driving/1,2;3,4"), "route/v1/driving/1,2;3,4");
+    BOOST_CHECK_EQUAL(route_key("driving/1,2;3,4?steps=true&alternatives=true"),
+                      route_key("driving/1,2;3,4?alternatives=true&steps=true"));
+    BOOST_CHECK_NE(route_key("driving/1,2;3,4"),
+                   QueryCoalescer::MakeKey("table", 1, "driving/1,2;3,4"));
+    // the last of two equal options wins, so their order is kept
+    BOOST_CHECK_NE(route_key("driving/1,2;3,4?steps=true&steps=false"),
+                   route_key("driving/1,2;3,4?steps=false&steps=true"));
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_queries_are_computed_once)
+{
+    QueryCoalescer coalescer(std::chrono::milliseconds(0), 16);
+
+    std::atomic<int> runs{0};
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> started;
+
+    QueryCoalescer::ResultT leader_result;
+    std::thread leader([&] {
+        coalescer.Run("key",
+                      0,
+                      [&](QueryCoalescer::ResultT &result) {
+                          started.set_value();
+                          released.wait();
+                          return CountingQuery(runs, 1)(result);
+                      },
+                      leader_result);
+    });
+    started.get_future().wait();
+
+    QueryCoalescer::ResultT follower_result;
+    std::thread follower(
+        [&] { coalescer.Run("key", 0, CountingQuery(runs, 2), follower_result); });
+
+    // the follower either waits for the leader or runs after it, without a time to live
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    release.set_value();
+    leader.join();
+    follower.join();
+
+    BOOST_CHECK_EQUAL(Value(leader_result), 1);
+    BOOST_CHECK(runs == 1 ? Value(follower_result) == 1 : Value(follower_result) == 2);
+}
+
+BOOST_AUTO_TEST_CASE(results_are_kept_within_a_generation)
+{
+    QueryCoalescer coalescer(std::chrono::milliseconds(60000), 16);
+    std::atomic<int> runs{0};
+
+    QueryCoalescer::ResultT result;
+    coalescer.Run("key", 0, CountingQuery(runs, 1), result);
+    coalescer.Run("key", 0, CountingQuery(runs, 2), result);
+    BOOST_CHECK_EQUAL(runs, 1);
+    BOOST_CHECK_EQUAL(Value(result), 1);
+
+    coalescer.Run("key", 1, CountingQuery(runs, 3), result);
+    BOOST_CHECK_EQUAL(runs, 2);
+    BOOST_CHECK_EQUAL(Value(result), 3);
+}
+
+BOOST_AUTO_TEST_CASE(failed_queries_are_not_kept)
+{
+    QueryCoalescer coalescer(std::chrono::milliseconds(60000), 16);
+    std::atomic<int> runs{0};
+
+    QueryCoalescer::ResultT result;
+    BOOST_CHECK_THROW(coalescer.Run("key",
+                                    0,
+                                    [](QueryCoalescer::ResultT &) -> engine::Status {
+                                        throw std::runtime_error("failed");
+                                    },
+                                    result),
+                      std::runtime_error);
+    coalescer.Run("key", 0, CountingQuery(runs, 1), result);
+    BOOST_CHECK_EQUAL(runs, 1);
+}
+
+BOOST_AUTO_TEST_CASE(match_sessions_are_not_shared)
+{
+    BOOST_CHECK(QueryCoalescer::IsShareable("match", "driving/1,2;3,4"));
+    BOOST_CHECK(QueryCoalescer::IsShareable("match", "driving/1,2;3,4?radiuses=5;5"));
+    BOOST_CHECK(!QueryCoalescer::IsShareable("match", "driving/1,2;3,4?session=abc"));
+    BOOST_CHECK(
+        !QueryCoalescer::IsShareable("match", "driving/1,2;3,4?steps=true&session=abc"));
+    // any trace of a batch
+    BOOST_CHECK(!QueryCoalescer::IsShareable("match", "driving/1,2;3,4:5,6;7,8?session=abc"));
+    // only options count
+    BOOST_CHECK(QueryCoalescer::IsShareable("route", "driving/1,2;3,4?session=abc"));
+}
+
+BOOST_AUTO_TEST_CASE(target_sets_are_not_shared)
+{
+    BOOST_CHECK(QueryCoalescer::IsShareable("table", "driving/1,2;3,4?destinations=1"));
+    BOOST_CHECK(!QueryCoalescer::IsShareable(
+        "table", "driving/1,2;3,4?target_set=depots&destinations=1"));
+    BOOST_CHECK(!QueryCoalescer::IsShareable("table", "driving/1,2?target_set=depots"));
+    BOOST_CHECK(QueryCoalescer::IsShareable("table", "driving/1,2;3,4?sources=0"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+#include "server/rate_limiter.hpp"
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(rate_limiter)
+
+using namespace osrm;
+using namespace osrm::server;
+
+BOOST_AUTO_TEST_CASE(buckets_refill_per_client)
+{
+    using Zero = RateLimiter::Clock::duration;
+    RateLimiter limiter(10, 100);
+    const auto start = RateLimiter::Clock::now();
+
+    BOOST_CHECK(limiter.Acquire("a", 60, start) == Zero::zero());
+    BOOST_CHECK(limiter.Acquire("a", 40, start) == Zero::zero());
+    // the bucket is empty, 20 take two seconds to refill
+    const auto wait = limiter.Acquire("a", 20, start);
+    BOOST_CHECK(wait > std::chrono::milliseconds(1999));
+    BOOST_CHECK(wait <= std::chrono::seconds(2));
+
+    // other clients have their own bucket
+    BOOST_CHECK(limiter.Acquire("b", 100, start) == Zero::zero());
+
+    BOOST_CHECK(limiter.Acquire("a", 20, start + std::chrono::seconds(2)) == Zero::zero());
+    BOOST_CHECK(limiter.Acquire("a", 1, start + std::chrono::seconds(2)) != Zero::zero());
+
+    // queries beyond the burst need a full bucket
+    BOOST_CHECK(limiter.Acquire("c", 1000, start) == Zero::zero());
+    BOOST_CHECK(limiter.Acquire("c", 1000, start + std::chrono::seconds(5)) != Zero::zero());
+    BOOST_CHECK(limiter.Acquire("c", 1000, start + std::chrono::seconds(10)) == Zero::zero());
+}
+
+BOOST_AUTO_TEST_CASE(costs_of_queries)
+{
+    BOOST_CHECK_EQUAL(RateLimiter::EstimateCost("route", "1,2;3,4;5,6?steps=true"), 3.);
+    BOOST_CHECK_EQUAL(RateLimiter::EstimateCost("match", "1,2;3,4.json"), 2.);
+    BOOST_CHECK_EQUAL(RateLimiter::EstimateCost("trip", "1,2;3,4;5,6"), 9.);
+    BOOST_CHECK_EQUAL(RateLimiter::EstimateCost("nearest", "1,2?number=10"), 1.);
+
+    BOOST_CHECK_EQUAL(RateLimiter::EstimateCost("table", "1,2;3,4;5,6;7,8"), 16.);
+    BOOST_CHECK_EQUAL(RateLimiter::EstimateCost("table", "1,2;3,4;5,6;7,8?sources=0"), 4.);
+    BOOST_CHECK_EQUAL(
+        RateLimiter::EstimateCost("table", "1,2;3,4;5,6;7,8?sources=0;1&destinations=all"), 8.);
+    BOOST_CHECK_EQUAL(
+        RateLimiter::EstimateCost("table", "1,2;3,4;5,6;7,8.binary?destinations=2;3;1"), 12.);
+
+    // three coordinates, the polyline contains a '?' that does not start the options
+    BOOST_CHECK_EQUAL(
+        RateLimiter::EstimateCost("route", "polyline(_ibE?_seK_seK_seK_seK)?overview=false"),
+        3.);
+
+    // the traces of a match batch each have their own options
+    BOOST_CHECK_EQUAL(
+        RateLimiter::EstimateCost("match", "1,2;3,4?radiuses=5;5:5,6;7,8;9,10?steps=true"), 5.);
+    BOOST_CHECK_EQUAL(RateLimiter::EstimateCost("match", "polyline(_ibE?_seK_seK):1,2;3,4:5,6"),
+                      5.);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,131 @@
+#include "server/http/request.hpp"
+#include "server/request_parser.hpp"
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <tuple>
+
+BOOST_AUTO_TEST_SUITE(request_parser)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+// Parses one request from input and returns how many bytes were consumed
+std::size_t parse(std::string &input, http::request &request, RequestParser::RequestStatus &status)
+{
+    RequestParser parser;
+    http::compression_type compression;
+    char *end;
+    std::tie(status, compression, end) =
+        parser.parse(request, &input[0], &input[0] + input.size());
+    return static_cast<std::size_t>(end - &input[0]);
+}
+}
+
+BOOST_AUTO_TEST_CASE(keep_alive_defaults_to_http_version)
+{
+    RequestParser::RequestStatus status;
+
+    std::string http_1_0 = "GET /route/v1/driving/1,2;3,4 HTTP/1.0\r\n\r\n";
+    http::request request_1_0;
+    parse(http_1_0, request_1_0, status);
+    BOOST_CHECK(status == RequestParser::RequestStatus::valid);
+    BOOST_CHECK_EQUAL(request_1_0.uri, "/route/v1/driving/1,2;3,4");
+    BOOST_CHECK(!request_1_0.keep_alive);
+
+    std::string http_1_1 = "GET /route/v1/driving/1,2;3,4 HTTP/1.1\r\nHost: osrm\r\n\r\n";
+    http::request request_1_1;
+    parse(http_1_1, request_1_1, status);
+    BOOST_CHECK(status == RequestParser::RequestStatus::valid);
+    BOOST_CHECK(request_1_1.keep_alive);
+}
+
+BOOST_AUTO_TEST_CASE(connection_header_overrides_default)
+{
+    RequestParser::RequestStatus status;
+
+    std::string close = "GET / HTTP/1.1\r\nConnection: close\r\n\r\n";
+    http::request close_request;
+    parse(close, close_request, status);
+    BOOST_CHECK(status == RequestParser::RequestStatus::valid);
+    BOOST_CHECK(!close_request.keep_alive);
+
+    std::string keep_alive = "GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n";
+    http::request keep_alive_request;
+    parse(keep_alive, keep_alive_request, status);
+    BOOST_CHECK(status == RequestParser::RequestStatus::valid);
+    BOOST_CHECK(keep_alive_request.keep_alive);
+}
+
+BOOST_AUTO_TEST_CASE(pipelined_requests)
+{
+    const std::string first = "GET /first HTTP/1.1\r\n\r\n";
+    const std::string second = "GET /second HTTP/1.1\r\n\r\n";
+    std::string input = first + second;
+
+    RequestParser::RequestStatus status;
+    http::request request;
+    const auto consumed = parse(input, request, status);
+    BOOST_CHECK(status == RequestParser::RequestStatus::valid);
+    BOOST_CHECK_EQUAL(request.uri, "/first");
+    BOOST_CHECK_EQUAL(consumed, first.size());
+
+    std::string rest = input.substr(consumed);
+    http::request next_request;
+    BOOST_CHECK_EQUAL(parse(rest, next_request, status), second.size());
+    BOOST_CHECK(status == RequestParser::RequestStatus::valid);
+    BOOST_CHECK_EQUAL(next_request.uri, "/second");
+}
+
+BOOST_AUTO_TEST_CASE(request_split_across_reads)
+{
+    const std::string input = "GET /route/v1/driving/1,2;3,4 HTTP/1.1\r\n"
+                              "Accept-Encoding: deflate, gzip\r\n"
+                              "User-Agent: osrm-test\r\n\r\n";
+
+    // every split point, the second part is read into the buffer the first part was in
+    for (std::size_t split = 1; split < input.size(); ++split)
+    {
+        RequestParser parser;
+        http::request request;
+        RequestParser::RequestStatus status;
+        http::compression_type compression;
+        char *end;
+
+        std::string buffer = input.substr(0, split);
+        std::tie(status, compression, end) =
+            parser.parse(request, &buffer[0], &buffer[0] + buffer.size());
+        BOOST_CHECK(status == RequestParser::RequestStatus::indeterminate);
+
+        buffer = input.substr(split);
+        std::tie(status, compression, end) =
+            parser.parse(request, &buffer[0], &buffer[0] + buffer.size());
+        BOOST_CHECK(status == RequestParser::RequestStatus::valid);
+        BOOST_CHECK(compression == http::gzip_rfc1952);
+        BOOST_CHECK_EQUAL(request.uri, "/route/v1/driving/1,2;3,4");
+        BOOST_CHECK_EQUAL(request.agent, "osrm-test");
+        BOOST_CHECK(end == &buffer[0] + buffer.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(invalid_requests)
+{
+    RequestParser::RequestStatus status;
+
+    for (std::string input : {"GET /\r\n\r\n",
+                              "GET / HTTP/1.1\n\n",
+                              "GET / HTTX/1.1\r\n\r\n",
+                              "GET /\x01 HTTP/1.1\r\n\r\n",
+                              "GET / HTTP/1.1\r\nNo colon\r\n\r\n"})
+    {
+        http::request request;
+        parse(input, request, status);
+        BOOST_CHECK(status == RequestParser::RequestStatus::invalid);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
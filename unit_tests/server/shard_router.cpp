@@ -0,0 +1,119 @@
+#include "server/shard_router.hpp"
+#include "engine/polyline_compressor.hpp"
+#include "util/exception.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(shard_router)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+const std::chrono::milliseconds timeout(1000);
+
+// A square of the given size with its lower left corner at lon, lat
+boost::filesystem::path WriteSquare(const double lon, const double lat, const double size)
+{
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("osrm-shard-%%%%-%%%%.poly");
+    boost::filesystem::ofstream output(path);
+    output << "region\nsquare\n"
+           << lon << ' ' << lat << '\n'
+           << lon + size << ' ' << lat << '\n'
+           << lon + size << ' ' << lat + size << '\n'
+           << lon << ' ' << lat + size << "\nEND\nEND\n";
+    return path;
+}
+
+util::Coordinate MakeCoordinate(const double lon, const double lat)
+{
+    return util::Coordinate{util::FloatLongitude{lon}, util::FloatLatitude{lat}};
+}
+}
+
+BOOST_AUTO_TEST_CASE(parse_coordinates)
+{
+    const std::vector<util::Coordinate> coordinates = {MakeCoordinate(13.1, 52.1),
+                                                       MakeCoordinate(-13.2, -52.2)};
+    auto parsed = ShardRouter::ParseCoordinates("13.1,52.1;-13.2,-52.2.json?steps=true");
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        parsed.begin(), parsed.end(), coordinates.begin(), coordinates.end());
+    parsed = ShardRouter::ParseCoordinates("13.1,52.1;-13.2,-52.2");
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        parsed.begin(), parsed.end(), coordinates.begin(), coordinates.end());
+
+    const auto polyline = engine::encodePolyline(coordinates.begin(), coordinates.end());
+    parsed = ShardRouter::ParseCoordinates("polyline(" + polyline + ")?overview=false");
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        parsed.begin(), parsed.end(), coordinates.begin(), coordinates.end());
+    parsed = ShardRouter::ParseCoordinates("polyline(" + polyline + ").json");
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        parsed.begin(), parsed.end(), coordinates.begin(), coordinates.end());
+    parsed = ShardRouter::ParseCoordinates("13.1,52.1;-13.2,-52.2.binary?steps=true");
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        parsed.begin(), parsed.end(), coordinates.begin(), coordinates.end());
+    parsed = ShardRouter::ParseCoordinates("13.1,52.1;-13.2,-52.json");
+    BOOST_CHECK_EQUAL(parsed.size(), 2);
+
+    // malformed or missing coordinates leave the query to the service
+    BOOST_CHECK(ShardRouter::ParseCoordinates("13.1,52.1;").empty());
+    BOOST_CHECK(ShardRouter::ParseCoordinates("13.1;52.1").empty());
+    BOOST_CHECK(ShardRouter::ParseCoordinates("13.1,?52.1").empty());
+    BOOST_CHECK(ShardRouter::ParseCoordinates("181,52.1").empty());
+    BOOST_CHECK(ShardRouter::ParseCoordinates("13.1,nan").empty());
+    BOOST_CHECK(ShardRouter::ParseCoordinates("polyline(abc").empty());
+    // input that is not consumed up to the format and the options
+    BOOST_CHECK(ShardRouter::ParseCoordinates("13.1,52.1;-13.2,-52.2x").empty());
+    BOOST_CHECK(ShardRouter::ParseCoordinates("13.1,52.1x;-13.2,-52.2").empty());
+    BOOST_CHECK(ShardRouter::ParseCoordinates("13.1,52.1;-13.2,-52.2.xml").empty());
+    BOOST_CHECK(ShardRouter::ParseCoordinates("13.1,52.1;-13.2,-52.2:1,2;3,4").empty());
+    BOOST_CHECK(
+        ShardRouter::ParseCoordinates("polyline(" + polyline + ")x?overview=false").empty());
+    BOOST_CHECK(ShardRouter::ParseCoordinates("tile(1,2,3).mvt").empty());
+    BOOST_CHECK(ShardRouter::ParseCoordinates("").empty());
+}
+
+BOOST_AUTO_TEST_CASE(select_shards)
+{
+    const auto west = WriteSquare(0, 0, 10);
+    const auto east = WriteSquare(10, 0, 10);
+    const ShardRouter router(
+        {west.string() + "=localhost:5001", east.string() + "=[::1]:5002"}, timeout);
+    boost::filesystem::remove(west);
+    boost::filesystem::remove(east);
+
+    BOOST_CHECK_EQUAL(router.Size(), 2);
+    BOOST_CHECK_EQUAL(*router.SelectShard("1,1;9,9.json"), 0);
+    BOOST_CHECK_EQUAL(*router.SelectShard("11,1;19,9?steps=true"), 1);
+    // across the border and outside of all regions
+    BOOST_CHECK(!router.SelectShard("1,1;19,9"));
+    BOOST_CHECK(!router.SelectShard("1,1;1,11"));
+    BOOST_CHECK(!router.SelectShard("tile(1,2,3).mvt"));
+    // batches, sessions and target sets stay here
+    BOOST_CHECK(!router.SelectShard("1,1;9,9:2,2;3,3"));
+    BOOST_CHECK(!router.SelectShard("1,1;9,9?session=abc"));
+    BOOST_CHECK(!router.SelectShard("1,1;9,9?steps=true&target_set=shops"));
+    BOOST_CHECK_EQUAL(*router.SelectShard("1,1;9,9?steps=true&no_session=abc"), 0);
+}
+
+BOOST_AUTO_TEST_CASE(malformed_shards)
+{
+    const auto square = WriteSquare(0, 0, 10);
+    BOOST_CHECK_THROW(ShardRouter({"localhost:5000"}, timeout), util::exception);
+    BOOST_CHECK_THROW(ShardRouter({square.string() + "=localhost"}, timeout), util::exception);
+    BOOST_CHECK_THROW(ShardRouter({square.string() + "=:5000"}, timeout), util::exception);
+    BOOST_CHECK_THROW(ShardRouter({square.string() + "=localhost:"}, timeout), util::exception);
+    BOOST_CHECK_THROW(ShardRouter({"/nonexistent/region.poly=localhost:5000"}, timeout),
+                      util::exception);
+    boost::filesystem::remove(square);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -47,6 +47,9 @@ BOOST_AUTO_TEST_CASE(invalid_urls)
     BOOST_CHECK_EQUAL(testInvalidURL("/route/v1/pro_file/1,2;3,4"), 13UL);
     BOOST_CHECK_EQUAL(testInvalidURL("/route/v1/profile"), 17UL);
     BOOST_CHECK_EQUAL(testInvalidURL("/route/v1/profile/"), 18UL);
+    BOOST_CHECK_EQUAL(testInvalidURL("/route/v99999999999/profile/1,2;3,4"), 8UL);
+    BOOST_CHECK_EQUAL(testInvalidURL("/route/v1/profile/1,2 3,4"), 21UL);
+    BOOST_CHECK_EQUAL(testInvalidURL("route/v1/profile/1,2;3,4"), 0UL);
 }
 
 BOOST_AUTO_TEST_CASE(valid_urls)
@@ -104,4 +107,21 @@ BOOST_AUTO_TEST_CASE(valid_urls)
     BOOST_CHECK_EQUAL(reference_6.prefix_length, result_6->prefix_length);
 }
 
+BOOST_AUTO_TEST_CASE(query_options)
+{
+    BOOST_CHECK(api::hasOption("1,2;3,4?session=abc", "session"));
+    BOOST_CHECK(api::hasOption("1,2;3,4.json?steps=true&session=abc", "session"));
+    BOOST_CHECK(!api::hasOption("1,2;3,4?steps=true", "session"));
+    BOOST_CHECK(!api::hasOption("1,2;3,4?no_session=abc", "session"));
+    BOOST_CHECK(!api::hasOption("1,2;3,4?session", "session"));
+    // polylines may contain '?'
+    BOOST_CHECK(!api::hasOption("polyline(?session)?steps=true", "session"));
+
+    BOOST_CHECK_EQUAL(api::getOption("1,2;3,4?session=abc", "session"), "abc");
+    BOOST_CHECK_EQUAL(api::getOption("1,2;3,4?session=abc&steps=true", "session"), "abc");
+    BOOST_CHECK_EQUAL(api::getOption("1,2;3,4?session=abc:5,6;7,8", "session"), "abc");
+    BOOST_CHECK_EQUAL(api::getOption("1,2;3,4?no_session=abc", "session"), "");
+    BOOST_CHECK_EQUAL(api::getOption("1,2;3,4?session=", "session"), "");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
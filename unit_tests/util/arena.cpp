@@ -0,0 +1,59 @@
+#include "util/arena.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <numeric>
+
+BOOST_AUTO_TEST_SUITE(arena)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(aligned_allocations)
+{
+    MonotonicArena arena;
+    for (const std::size_t alignment : {1, 2, 8, 16, 64})
+    {
+        const auto address = arena.Allocate(3, alignment);
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(address) % alignment, 0);
+    }
+
+    // larger than a block
+    const auto large = static_cast<char *>(arena.Allocate(3 * MonotonicArena::BLOCK_SIZE, 8));
+    large[3 * MonotonicArena::BLOCK_SIZE - 1] = 1;
+    BOOST_CHECK_EQUAL(arena.AllocatedBytes(), 5 * 3 + 3 * MonotonicArena::BLOCK_SIZE);
+
+    arena.Release();
+    BOOST_CHECK_EQUAL(arena.AllocatedBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(vectors_in_scope)
+{
+    ArenaVector<int> heap_values(10);
+    {
+        const ArenaScope scope;
+        ArenaVector<int> values;
+        for (int value = 0; value < 100000; ++value)
+        {
+            values.push_back(value);
+        }
+        BOOST_CHECK_EQUAL(std::accumulate(values.begin(), values.end(), std::int64_t{0}),
+                          std::int64_t{100000} * 99999 / 2);
+        BOOST_CHECK(values.get_allocator() != heap_values.get_allocator());
+
+        // an inner scope keeps allocating from the outer one
+        {
+            const ArenaScope inner_scope;
+            ArenaVector<int> inner_values(10);
+            BOOST_CHECK(values.get_allocator() == inner_values.get_allocator());
+        }
+        values.push_back(1);
+        BOOST_CHECK_EQUAL(values.back(), 1);
+    }
+
+    ArenaVector<int> more_heap_values(10);
+    BOOST_CHECK(more_heap_values.get_allocator() == heap_values.get_allocator());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
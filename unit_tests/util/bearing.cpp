@@ -1,10 +1,13 @@
 #include "util/bearing.hpp"
+#include "util/guidance/bearing_class.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/functional/hash.hpp>
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <iterator>
+
 BOOST_AUTO_TEST_SUITE(bearing_test)
 
 using namespace osrm;
@@ -44,4 +47,55 @@ BOOST_AUTO_TEST_CASE(bearing_range_test)
     BOOST_CHECK_EQUAL(true, bearing::CheckInBounds(719, 5, 10));
 }
 
+// The sectors of a bearing range must cover every bearing CheckInBounds accepts
+BOOST_AUTO_TEST_CASE(bearing_sectors_test)
+{
+    BOOST_CHECK_EQUAL(bearing::Sector(0), 1);
+    BOOST_CHECK_EQUAL(bearing::Sector(22), 1);
+    BOOST_CHECK_EQUAL(bearing::Sector(23), 2);
+    BOOST_CHECK_EQUAL(bearing::Sector(359), 1 << 15);
+    BOOST_CHECK_EQUAL(bearing::Sector(360), 1);
+    BOOST_CHECK_EQUAL(bearing::Sector(-1), 1 << 15);
+
+    BOOST_CHECK_EQUAL(bearing::SectorsInBounds(5, 10), bearing::Sector(355) | bearing::Sector(0));
+    BOOST_CHECK_EQUAL(bearing::SectorsInBounds(100, 10), bearing::Sector(100));
+    BOOST_CHECK_EQUAL(bearing::SectorsInBounds(90, 180), bearing::ALL_SECTORS);
+
+    for (int B = -360; B <= 720; B += 7)
+    {
+        for (const int range : {1, 10, 22, 45, 90, 179})
+        {
+            const auto sectors = bearing::SectorsInBounds(B, range);
+            for (int A = 0; A <= 360; ++A)
+            {
+                if (bearing::CheckInBounds(A, B, range))
+                {
+                    BOOST_CHECK(sectors & bearing::Sector(A));
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(matching_bearing_of_stored_bearings)
+{
+    const DiscreteBearing stored[] = {10, 95, 180, 350};
+    const guidance::BearingRange bearings(std::begin(stored), std::end(stored));
+    guidance::BearingClass bearing_class;
+    for (const auto bearing : stored)
+    {
+        bearing_class.add(bearing);
+    }
+
+    BOOST_CHECK_EQUAL(guidance::findMatchingBearing(bearings, 5), 0);
+    BOOST_CHECK_EQUAL(guidance::findMatchingBearing(bearings, 90), 1);
+    BOOST_CHECK_EQUAL(guidance::findMatchingBearing(bearings, 200), 2);
+    BOOST_CHECK_EQUAL(guidance::findMatchingBearing(bearings, 355), 3);
+    for (int bearing = 0; bearing < 360; bearing += 5)
+    {
+        BOOST_CHECK_EQUAL(guidance::findMatchingBearing(bearings, bearing),
+                          bearing_class.findMatchingBearing(bearing));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
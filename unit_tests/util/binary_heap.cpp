@@ -157,4 +157,40 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(decrease_key_test, T, storage_types, RandomData
     }
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(clear_test, T, storage_types, RandomDataFixture<NUM_NODES>)
+{
+    BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(NUM_NODES);
+
+    for (unsigned idx : order)
+    {
+        heap.Insert(ids[idx], weights[idx], data[idx]);
+    }
+
+    heap.Clear();
+    BOOST_CHECK(heap.Empty());
+
+    // stale entries of the previous search must not show up again
+    for (auto id : ids)
+    {
+        BOOST_CHECK(!heap.WasInserted(id));
+    }
+
+    heap.Insert(ids.back(), weights.back(), data.back());
+    BOOST_CHECK(heap.WasInserted(ids.back()));
+    BOOST_CHECK(!heap.WasInserted(ids.front()));
+    BOOST_CHECK_EQUAL(heap.Min(), ids.back());
+}
+
+BOOST_AUTO_TEST_CASE(array_storage_grows_test)
+{
+    BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, ArrayStorage<TestNodeID, TestKey>> heap(
+        10);
+
+    BOOST_CHECK(!heap.WasInserted(100));
+    heap.Insert(100, 5, TestData{1});
+    BOOST_CHECK(heap.WasInserted(100));
+    BOOST_CHECK_EQUAL(heap.GetKey(100), 5);
+    BOOST_CHECK_EQUAL(heap.GetData(100).value, 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,112 @@
+#include "util/block_encoded_coordinates.hpp"
+#include "util/coordinate.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(block_encoded_coordinates_test)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+// Coordinates that are mostly close to the previous one, some that jump across the whole range
+// and runs of equal coordinates
+std::vector<Coordinate> MakeCoordinates(const std::size_t number_of_coordinates)
+{
+    std::mt19937 generator(5);
+    std::uniform_int_distribution<std::int32_t> step(-500, 500);
+    std::uniform_int_distribution<std::int32_t> any_lon(-180000000, 180000000);
+    std::uniform_int_distribution<std::int32_t> any_lat(-90000000, 90000000);
+
+    std::vector<Coordinate> coordinates;
+    std::int32_t lon = 13000000;
+    std::int32_t lat = 52000000;
+    for (std::size_t index = 0; index < number_of_coordinates; ++index)
+    {
+        if (index % 37 == 0)
+        {
+            lon = any_lon(generator);
+            lat = any_lat(generator);
+        }
+        else if (index / 64 % 3 != 0)
+        {
+            lon = std::max(-180000000, std::min(180000000, lon + step(generator)));
+            lat = std::max(-90000000, std::min(90000000, lat + step(generator)));
+        }
+        coordinates.push_back(Coordinate{FixedLongitude{lon}, FixedLatitude{lat}});
+    }
+    coordinates.push_back(Coordinate{FixedLongitude{-180000000}, FixedLatitude{-90000000}});
+    coordinates.push_back(Coordinate{FixedLongitude{180000000}, FixedLatitude{90000000}});
+    return coordinates;
+}
+
+template <typename CoordinateListT>
+void CheckCoordinates(const CoordinateListT &list, const std::vector<Coordinate> &coordinates)
+{
+    BOOST_REQUIRE_EQUAL(list.size(), coordinates.size());
+    for (std::size_t index = 0; index < coordinates.size(); ++index)
+    {
+        BOOST_CHECK_EQUAL(list[index], coordinates[index]);
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(round_trip_test)
+{
+    // empty, partial and full blocks
+    for (const std::size_t number_of_coordinates : {0, 1, 14, 15, 1000})
+    {
+        const auto coordinates = MakeCoordinates(number_of_coordinates);
+
+        std::vector<BlockEncodedCoordinates<false>::Block> blocks;
+        std::vector<std::uint64_t> words;
+        BlockEncodedCoordinates<false>::Encode(coordinates, blocks, words);
+        BOOST_CHECK_EQUAL(blocks.size(),
+                          BlockEncodedCoordinates<false>::NumberOfBlocks(coordinates.size()));
+
+        BlockEncodedCoordinates<false> encoded;
+        encoded.Reset(blocks, words);
+        CheckCoordinates(encoded, coordinates);
+
+        BlockEncodedCoordinates<true> shared_encoded;
+        shared_encoded.Reset(blocks.data(), blocks.size(), words.data(), words.size());
+        CheckCoordinates(shared_encoded, coordinates);
+
+        CoordinateList<true> list;
+        list.Reset(shared_encoded);
+        BOOST_CHECK(list.IsEncoded());
+        CheckCoordinates(list, coordinates);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(plain_coordinate_list_test)
+{
+    const auto coordinates = MakeCoordinates(100);
+    CoordinateList<false> list;
+    list.Reset(coordinates);
+    BOOST_CHECK(!list.IsEncoded());
+    BOOST_CHECK_EQUAL(list.SizeInBytes(), coordinates.size() * sizeof(Coordinate));
+    CheckCoordinates(list, coordinates);
+}
+
+BOOST_AUTO_TEST_CASE(smaller_than_uncompressed_test)
+{
+    const auto coordinates = MakeCoordinates(10000);
+
+    std::vector<BlockEncodedCoordinates<false>::Block> blocks;
+    std::vector<std::uint64_t> words;
+    BlockEncodedCoordinates<false>::Encode(coordinates, blocks, words);
+
+    CoordinateList<false> list;
+    BlockEncodedCoordinates<false> encoded;
+    encoded.Reset(std::move(blocks), std::move(words));
+    list.Reset(std::move(encoded));
+    BOOST_CHECK_LT(list.SizeInBytes(), coordinates.size() * sizeof(Coordinate));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+#include "util/buffered_file.hpp"
+#include "util/exception.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(buffered_file)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(write_and_read_blocks)
+{
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("osrm-buffered-%%%%-%%%%");
+
+    // spans several blocks, written one value at a time
+    const std::uint64_t number_of_values = 3 * detail::FILE_BLOCK_SIZE / sizeof(std::uint32_t) + 7;
+    {
+        BufferedOutputFile output(path);
+        const std::uint64_t empty_prefix = 0;
+        output.write(reinterpret_cast<const char *>(&empty_prefix), sizeof(empty_prefix));
+        for (std::uint32_t value = 0; value < number_of_values; ++value)
+        {
+            output.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+        BOOST_CHECK_EQUAL(output.tellp(),
+                          sizeof(empty_prefix) + number_of_values * sizeof(std::uint32_t));
+
+        // the prefix is only known at the end
+        output.seekp(0);
+        output.write(reinterpret_cast<const char *>(&number_of_values), sizeof(number_of_values));
+        output.close();
+    }
+    BOOST_CHECK_EQUAL(boost::filesystem::file_size(path),
+                      sizeof(std::uint64_t) + number_of_values * sizeof(std::uint32_t));
+
+    BufferedInputFile input(path);
+    BOOST_REQUIRE(input);
+    std::uint64_t count = 0;
+    input.read(reinterpret_cast<char *>(&count), sizeof(count));
+    BOOST_CHECK_EQUAL(count, number_of_values);
+
+    std::vector<std::uint32_t> values(count);
+    input.read(reinterpret_cast<char *>(values.data()), count * sizeof(std::uint32_t));
+    BOOST_REQUIRE(input);
+    for (std::uint32_t value = 0; value < count; ++value)
+    {
+        BOOST_REQUIRE_EQUAL(values[value], value);
+    }
+
+    // reading past the end fails the stream
+    std::uint32_t value = 0;
+    input.read(reinterpret_cast<char *>(&value), sizeof(value));
+    BOOST_CHECK(!input);
+
+    input.clear();
+    input.seekg(sizeof(std::uint64_t) + 1000 * sizeof(std::uint32_t));
+    input.read(reinterpret_cast<char *>(&value), sizeof(value));
+    BOOST_CHECK_EQUAL(value, 1000);
+    BOOST_CHECK_EQUAL(input.tellg(), sizeof(std::uint64_t) + 1001 * sizeof(std::uint32_t));
+
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(missing_files)
+{
+    BufferedInputFile input("/does/not/exist");
+    BOOST_CHECK(!input);
+
+    BOOST_CHECK_THROW(BufferedOutputFile("/does/not/exist/file"), util::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,8 @@
 #include <osrm/coordinate.hpp>
 
 #include <cmath>
+#include <random>
+#include <vector>
 
 using namespace osrm;
 using namespace osrm::util;
@@ -255,6 +257,93 @@ BOOST_AUTO_TEST_CASE(point_on_segment)
     BOOST_CHECK_EQUAL(result_4.second.lat, reference_point_4.lat);
 }
 
+BOOST_AUTO_TEST_CASE(points_on_segments)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<> lon_dist(-180., 180.);
+    std::uniform_real_distribution<> lat_dist(-85., 85.);
+
+    // the count is not a multiple of the vector width and includes degenerated segments
+    const std::size_t count = 39;
+    std::vector<FloatCoordinate> sources;
+    std::vector<FloatCoordinate> targets;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        sources.push_back({FloatLongitude{lon_dist(generator)}, FloatLatitude{lat_dist(generator)}});
+        targets.push_back(i % 7 == 0 ? sources.back()
+                                     : FloatCoordinate{FloatLongitude{lon_dist(generator)},
+                                                       FloatLatitude{lat_dist(generator)}});
+    }
+    const FloatCoordinate input{FloatLongitude{13.4}, FloatLatitude{52.5}};
+
+    std::vector<FloatCoordinate> nearest(count);
+    coordinate_calculation::projectPointOnSegments(
+        sources.data(), targets.data(), count, input, nearest.data());
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const auto reference =
+            coordinate_calculation::projectPointOnSegment(sources[i], targets[i], input).second;
+        BOOST_CHECK_EQUAL(nearest[i].lon, reference.lon);
+        BOOST_CHECK_EQUAL(nearest[i].lat, reference.lat);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(batch_distances)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<> lon_dist(-180., 180.);
+    std::uniform_real_distribution<> lat_dist(-85., 85.);
+    std::uniform_real_distribution<> offset_dist(-0.001, 0.001);
+
+    // consecutive points of a trace that alternates between long jumps and steps of a few
+    // meters, the count is not a multiple of the vector width
+    const std::size_t count = 1003;
+    std::vector<Coordinate> trace;
+    for (std::size_t i = 0; i < count + 1; ++i)
+    {
+        if (i % 2 == 0)
+        {
+            trace.emplace_back(FloatLongitude{lon_dist(generator)},
+                               FloatLatitude{lat_dist(generator)});
+        }
+        else
+        {
+            const auto lon = static_cast<double>(toFloating(trace.back().lon));
+            const auto lat = static_cast<double>(toFloating(trace.back().lat));
+            trace.emplace_back(FloatLongitude{lon + offset_dist(generator)},
+                               FloatLatitude{lat + offset_dist(generator)});
+        }
+    }
+    // identical points, across the antimeridian and along the equator
+    trace[10] = trace[11];
+    trace[20] = Coordinate{FloatLongitude{179.9999}, FloatLatitude{10.}};
+    trace[21] = Coordinate{FloatLongitude{-179.9999}, FloatLatitude{10.}};
+    trace[30] = Coordinate{FloatLongitude{-90.}, FloatLatitude{0.}};
+    trace[31] = Coordinate{FloatLongitude{90.}, FloatLatitude{0.}};
+
+    std::vector<double> haversine(count);
+    coordinate_calculation::haversineDistances(
+        trace.data(), trace.data() + 1, count, haversine.data());
+    std::vector<double> great_circle(count);
+    coordinate_calculation::greatCircleDistances(
+        trace.data(), trace.data() + 1, count, great_circle.data());
+
+    // within a micrometer, the conversion to radians rounds differently in the vector kernels
+    const auto check_close = [](const double distance, const double reference) {
+        BOOST_CHECK_LE(std::abs(distance - reference), 1e-6 + 1e-12 * reference);
+    };
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        check_close(haversine[i],
+                    coordinate_calculation::haversineDistance(trace[i], trace[i + 1]));
+        check_close(great_circle[i],
+                    coordinate_calculation::greatCircleDistance(trace[i], trace[i + 1]));
+    }
+    BOOST_CHECK_EQUAL(haversine[10], 0.);
+    BOOST_CHECK_EQUAL(great_circle[10], 0.);
+}
+
 BOOST_AUTO_TEST_CASE(circleCenter)
 {
     Coordinate a(FloatLongitude{-100.}, FloatLatitude{10.});
@@ -311,4 +400,32 @@ BOOST_AUTO_TEST_CASE(circleCenter)
     BOOST_CHECK(!result);
 }
 
+BOOST_AUTO_TEST_CASE(convex_hull)
+{
+    // a square with points inside and on its border
+    const std::vector<Coordinate> coordinates = {
+        Coordinate(FloatLongitude{1}, FloatLatitude{1}),
+        Coordinate(FloatLongitude{0}, FloatLatitude{0}),
+        Coordinate(FloatLongitude{2}, FloatLatitude{0}),
+        Coordinate(FloatLongitude{1}, FloatLatitude{0}),
+        Coordinate(FloatLongitude{2}, FloatLatitude{2}),
+        Coordinate(FloatLongitude{0.5}, FloatLatitude{1.5}),
+        Coordinate(FloatLongitude{0}, FloatLatitude{2}),
+        Coordinate(FloatLongitude{2}, FloatLatitude{2})};
+
+    const auto hull = coordinate_calculation::convexHull(coordinates);
+    const std::vector<Coordinate> expected = {Coordinate(FloatLongitude{0}, FloatLatitude{0}),
+                                              Coordinate(FloatLongitude{2}, FloatLatitude{0}),
+                                              Coordinate(FloatLongitude{2}, FloatLatitude{2}),
+                                              Coordinate(FloatLongitude{0}, FloatLatitude{2})};
+    BOOST_CHECK_EQUAL_COLLECTIONS(hull.begin(), hull.end(), expected.begin(), expected.end());
+
+    // collinear coordinates collapse to the end points
+    const auto line = coordinate_calculation::convexHull(
+        {Coordinate(FloatLongitude{0}, FloatLatitude{0}),
+         Coordinate(FloatLongitude{2}, FloatLatitude{2}),
+         Coordinate(FloatLongitude{1}, FloatLatitude{1})});
+    BOOST_CHECK_EQUAL(line.size(), 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
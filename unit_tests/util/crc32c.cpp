@@ -0,0 +1,45 @@
+#include "util/crc32c.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(crc32c)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(check_value)
+{
+    // the standard check value includes the pre- and post-inversion
+    const std::string digits = "123456789";
+    BOOST_CHECK_EQUAL(~CRC32C(digits.data(), digits.size(), ~0u), 0xE3069283u);
+    BOOST_CHECK_EQUAL(CRC32C(digits.data(), 0), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(combined_ranges)
+{
+    std::vector<char> data(3 * CRC32C_CHUNK_SIZE + 13);
+    std::uint32_t state = 1;
+    for (auto &byte : data)
+    {
+        state = state * 1103515245 + 12345;
+        byte = static_cast<char>(state >> 16);
+    }
+    const auto expected = CRC32C(data.data(), data.size());
+
+    // unaligned split and the continuation of a checksum
+    const std::size_t split = 1000003;
+    const auto first = CRC32C(data.data(), split);
+    const auto second = CRC32C(data.data() + split, data.size() - split);
+    BOOST_CHECK_EQUAL(CombineCRC32C(first, second, data.size() - split), expected);
+    BOOST_CHECK_EQUAL(CRC32C(data.data() + split, data.size() - split, first), expected);
+    BOOST_CHECK_EQUAL(CombineCRC32C(first, 0, 0), first);
+
+    BOOST_CHECK_EQUAL(ParallelCRC32C(data.data(), data.size()), expected);
+    BOOST_CHECK_EQUAL(ParallelCRC32C(data.data(), split), first);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
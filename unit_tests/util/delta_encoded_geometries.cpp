@@ -0,0 +1,135 @@
+#include "util/delta_encoded_geometries.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(delta_encoded_geometries_test)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+struct Segment
+{
+    NodeID node_id;
+    EdgeWeight weight;
+};
+
+// Geometries of up to max_length segments, some of them empty, with node ids that are mostly
+// close to each other and some that jump across the whole range
+void MakeGeometries(const std::size_t number_of_geometries,
+                    const std::size_t max_length,
+                    std::vector<unsigned> &indices,
+                    std::vector<Segment> &segments)
+{
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<std::size_t> length(0, max_length);
+    std::uniform_int_distribution<int> step(-1000, 1000);
+    std::uniform_int_distribution<NodeID> any_node(0, std::numeric_limits<NodeID>::max() - 1);
+    std::uniform_int_distribution<EdgeWeight> weight(0, 100000);
+
+    indices = {0};
+    segments.clear();
+    NodeID node = 1 << 20;
+    for (std::size_t geometry = 0; geometry < number_of_geometries; ++geometry)
+    {
+        for (auto count = length(generator); count > 0; --count)
+        {
+            node = count % 7 == 0 ? any_node(generator) : node + step(generator);
+            segments.push_back({node, weight(generator)});
+        }
+        indices.push_back(segments.size());
+    }
+    segments.push_back({SPECIAL_NODEID, INVALID_EDGE_WEIGHT});
+    segments.push_back({0, 0});
+    indices.push_back(segments.size());
+}
+
+template <typename Geometries>
+void CheckGeometries(const Geometries &geometries,
+                     const std::vector<unsigned> &indices,
+                     const std::vector<Segment> &segments)
+{
+    std::vector<NodeID> nodes;
+    std::vector<EdgeWeight> weights;
+    for (std::size_t geometry = 0; geometry + 1 < indices.size(); ++geometry)
+    {
+        geometries.GetNodes(indices, geometry, nodes);
+        geometries.GetWeights(indices, geometry, weights);
+        BOOST_REQUIRE_EQUAL(nodes.size(), indices[geometry + 1] - indices[geometry]);
+        BOOST_REQUIRE_EQUAL(weights.size(), nodes.size());
+        for (std::size_t index = 0; index < nodes.size(); ++index)
+        {
+            BOOST_CHECK_EQUAL(nodes[index], segments[indices[geometry] + index].node_id);
+            BOOST_CHECK_EQUAL(weights[index], segments[indices[geometry] + index].weight);
+        }
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(round_trip_test)
+{
+    // short geometries decode with the scalar skip only, long ones go through the 16 byte skip
+    for (const std::size_t max_length : {0, 1, 3, 40})
+    {
+        std::vector<unsigned> indices;
+        std::vector<Segment> segments;
+        MakeGeometries(100, max_length, indices, segments);
+
+        std::vector<std::uint64_t> block_offsets;
+        std::vector<unsigned char> bytes;
+        DeltaEncodedGeometries<false>::Encode(indices, segments, block_offsets, bytes);
+        BOOST_CHECK_EQUAL(block_offsets.size(),
+                          DeltaEncodedGeometries<false>::NumberOfBlocks(indices.size() - 1));
+
+        DeltaEncodedGeometries<false> geometries;
+        geometries.Reset(block_offsets, bytes);
+        CheckGeometries(geometries, indices, segments);
+
+        DeltaEncodedGeometries<true> shared_geometries;
+        shared_geometries.Reset(
+            block_offsets.data(), block_offsets.size(), bytes.data(), bytes.size());
+        CheckGeometries(shared_geometries, indices, segments);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(smaller_than_uncompressed_test)
+{
+    std::vector<unsigned> indices;
+    std::vector<Segment> segments;
+    MakeGeometries(1000, 10, indices, segments);
+
+    std::vector<std::uint64_t> block_offsets;
+    std::vector<unsigned char> bytes;
+    DeltaEncodedGeometries<false>::Encode(indices, segments, block_offsets, bytes);
+
+    DeltaEncodedGeometries<false> geometries;
+    geometries.Reset(std::move(block_offsets), std::move(bytes));
+    BOOST_CHECK_LT(geometries.SizeInBytes(), segments.size() * sizeof(Segment));
+}
+
+BOOST_AUTO_TEST_CASE(skip_varints_test)
+{
+    std::vector<unsigned char> bytes;
+    std::vector<std::size_t> ends;
+    std::mt19937_64 generator(3);
+    for (std::size_t index = 0; index < 200; ++index)
+    {
+        // anything from one to ten bytes
+        detail::writeVarint(generator() >> (generator() % 64), bytes);
+        ends.push_back(bytes.size());
+    }
+    for (std::size_t count = 0; count <= ends.size(); ++count)
+    {
+        const auto position = detail::skipVarints(bytes.data(), count);
+        BOOST_CHECK_EQUAL(position - bytes.data(), count == 0 ? 0 : ends[count - 1]);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
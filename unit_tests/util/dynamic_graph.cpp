@@ -4,6 +4,9 @@
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <sstream>
+#include <utility>
 #include <vector>
 
 BOOST_AUTO_TEST_SUITE(dynamic_graph)
@@ -64,4 +67,96 @@ BOOST_AUTO_TEST_CASE(find_test)
     BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(eit).id, 2);
 }
 
+BOOST_AUTO_TEST_CASE(insert_compact_test)
+{
+    std::vector<TestInputEdge> input_edges = {TestInputEdge{0, 1, TestData{1}},
+                                              TestInputEdge{1, 2, TestData{2}},
+                                              TestInputEdge{2, 0, TestData{3}}};
+    TestDynamicGraph graph(3, input_edges);
+
+    // node 0 outgrows its block and moves it, leaving a free block behind
+    for (const auto target : {2u, 1u, 2u, 1u, 2u, 1u})
+    {
+        graph.InsertEdge(0, target, TestData{10 + static_cast<EdgeID>(graph.GetOutDegree(0))});
+    }
+    graph.InsertEdge(1, 0, TestData{4});
+    graph.InsertEdge(1, 0, TestData{5});
+    graph.InsertEdge(1, 0, TestData{6});
+    graph.DeleteEdgesTo(0, 2);
+
+    BOOST_CHECK_EQUAL(graph.GetNumberOfEdges(), 9);
+    BOOST_CHECK_GT(graph.GetEdgeCapacity(), graph.GetNumberOfEdges());
+
+    const auto edges_of = [&graph](const NodeID node) {
+        std::vector<std::pair<NodeID, EdgeID>> edges;
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            edges.emplace_back(graph.GetTarget(edge), graph.GetEdgeData(edge).id);
+        }
+        std::sort(edges.begin(), edges.end());
+        return edges;
+    };
+    const std::vector<decltype(edges_of(0))> before = {edges_of(0), edges_of(1), edges_of(2)};
+
+    graph.Compact();
+
+    BOOST_CHECK_EQUAL(graph.GetEdgeCapacity(), graph.GetNumberOfEdges());
+    const std::vector<decltype(edges_of(0))> after = {edges_of(0), edges_of(1), edges_of(2)};
+    BOOST_CHECK(before == after);
+    BOOST_CHECK_EQUAL(graph.GetOutDegree(0), 4);
+    BOOST_CHECK_EQUAL(graph.GetOutDegree(1), 4);
+    BOOST_CHECK_EQUAL(graph.GetOutDegree(2), 1);
+
+    // the graph keeps growing after the compaction
+    graph.InsertEdge(2, 1, TestData{7});
+    BOOST_CHECK_EQUAL(graph.GetOutDegree(2), 2);
+    BOOST_CHECK_EQUAL(graph.GetEdgeData(graph.FindEdge(2, 1)).id, 7);
+    BOOST_CHECK_EQUAL(graph.GetEdgeData(graph.FindEdge(2, 0)).id, 3);
+}
+
+BOOST_AUTO_TEST_CASE(write_read_test)
+{
+    std::vector<TestInputEdge> input_edges = {TestInputEdge{0, 1, TestData{1}},
+                                              TestInputEdge{1, 2, TestData{2}},
+                                              TestInputEdge{2, 0, TestData{3}}};
+    TestDynamicGraph graph(3, input_edges);
+    for (const auto target : {2u, 1u, 2u, 1u, 2u})
+    {
+        graph.InsertEdge(0, target, TestData{10 + static_cast<EdgeID>(graph.GetOutDegree(0))});
+    }
+    graph.DeleteEdgesTo(0, 2);
+
+    std::stringstream stream;
+    BOOST_REQUIRE(graph.Write(stream));
+    TestDynamicGraph read_graph(0);
+    BOOST_REQUIRE(read_graph.Read(stream));
+
+    // both graphs put new edges into the same slots, which keeps the edges in the same order
+    const auto edges_of = [](const TestDynamicGraph &graph, const NodeID node) {
+        std::vector<std::pair<EdgeID, EdgeID>> edges;
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            edges.emplace_back(edge, graph.GetEdgeData(edge).id);
+        }
+        return edges;
+    };
+    for (const auto source : {1u, 2u, 0u, 2u, 1u})
+    {
+        graph.InsertEdge(source, 0, TestData{20 + source});
+        read_graph.InsertEdge(source, 0, TestData{20 + source});
+    }
+    BOOST_CHECK_EQUAL(read_graph.GetNumberOfNodes(), 3);
+    BOOST_CHECK_EQUAL(read_graph.GetNumberOfEdges(), graph.GetNumberOfEdges());
+    BOOST_CHECK_EQUAL(read_graph.GetEdgeCapacity(), graph.GetEdgeCapacity());
+    for (const auto node : {0u, 1u, 2u})
+    {
+        BOOST_CHECK(edges_of(read_graph, node) == edges_of(graph, node));
+    }
+
+    // a truncated graph is not read
+    const auto written = stream.str();
+    std::stringstream truncated(written.substr(0, written.size() - 1));
+    BOOST_CHECK(!TestDynamicGraph(0).Read(truncated));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,137 @@
+#include "util/exception.hpp"
+#include "util/intermediate_file.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(intermediate_file)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+// Writes a count that is only known at the end, followed by the values
+void WriteValues(const boost::filesystem::path &path,
+                 const bool compress,
+                 const std::uint64_t number_of_values)
+{
+    IntermediateOutputFile output(path, compress);
+    const std::uint64_t empty_prefix = 0;
+    output.write(reinterpret_cast<const char *>(&empty_prefix), sizeof(empty_prefix));
+    for (std::uint32_t value = 0; value < number_of_values; ++value)
+    {
+        const std::uint32_t compressible_value = value / 16;
+        output.write(reinterpret_cast<const char *>(&compressible_value), sizeof(value));
+    }
+    BOOST_CHECK_EQUAL(output.tellp(),
+                      sizeof(empty_prefix) + number_of_values * sizeof(std::uint32_t));
+
+    output.seekp(0);
+    output.write(reinterpret_cast<const char *>(&number_of_values), sizeof(number_of_values));
+    output.close();
+}
+
+void CheckValues(const boost::filesystem::path &path, const std::uint64_t number_of_values)
+{
+    IntermediateInputFile input(path);
+    BOOST_REQUIRE(input);
+    std::uint64_t count = 0;
+    input.read(reinterpret_cast<char *>(&count), sizeof(count));
+    BOOST_CHECK_EQUAL(count, number_of_values);
+
+    std::vector<std::uint32_t> values(count);
+    input.read(reinterpret_cast<char *>(values.data()), count * sizeof(std::uint32_t));
+    BOOST_REQUIRE(input);
+    for (std::uint32_t value = 0; value < count; ++value)
+    {
+        BOOST_REQUIRE_EQUAL(values[value], value / 16);
+    }
+
+    std::uint32_t value = 0;
+    input.read(reinterpret_cast<char *>(&value), sizeof(value));
+    BOOST_CHECK(!input);
+
+    // forwards across frames, backwards into the header and relative to the position
+    const auto offset_of = [](const std::uint64_t index) {
+        return sizeof(std::uint64_t) + index * sizeof(std::uint32_t);
+    };
+    input.clear();
+    input.seekg(offset_of(count - 3));
+    input.read(reinterpret_cast<char *>(&value), sizeof(value));
+    BOOST_CHECK_EQUAL(value, (count - 3) / 16);
+    input.seekg(0);
+    input.read(reinterpret_cast<char *>(&count), sizeof(count));
+    BOOST_CHECK_EQUAL(count, number_of_values);
+    input.seekg((count - 1) * sizeof(std::uint32_t), std::ios::cur);
+    input.read(reinterpret_cast<char *>(&value), sizeof(value));
+    BOOST_CHECK_EQUAL(value, (count - 1) / 16);
+    BOOST_CHECK_EQUAL(input.tellg(), offset_of(count));
+}
+}
+
+BOOST_AUTO_TEST_CASE(compressed_and_plain_files)
+{
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("osrm-intermediate-%%%%-%%%%");
+    const std::uint64_t number_of_values = 3 * detail::FILE_BLOCK_SIZE / sizeof(std::uint32_t);
+
+    WriteValues(path, true, number_of_values);
+    BOOST_CHECK(IsCompressedFile(path));
+    BOOST_CHECK_LT(boost::filesystem::file_size(path), number_of_values);
+    CheckValues(path, number_of_values);
+
+    WriteValues(path, false, number_of_values);
+    BOOST_CHECK(!IsCompressedFile(path));
+    CheckValues(path, number_of_values);
+
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(small_compressed_files)
+{
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("osrm-intermediate-%%%%-%%%%");
+
+    // fits into the header, no frames
+    WriteValues(path, true, 3);
+    CheckValues(path, 3);
+
+    {
+        IntermediateOutputFile output(path, true);
+        output.close();
+    }
+    IntermediateInputFile input(path);
+    BOOST_CHECK(input);
+    BOOST_CHECK_EQUAL(input.get(), std::char_traits<char>::eof());
+
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(seeking_past_the_header)
+{
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("osrm-intermediate-%%%%-%%%%");
+
+    IntermediateOutputFile output(path, true);
+    const std::vector<char> data(2 * detail::INTERMEDIATE_HEADER_SIZE);
+    output.write(data.data(), data.size());
+    output.seekp(detail::INTERMEDIATE_HEADER_SIZE + 1);
+    BOOST_CHECK(output.fail());
+    output.close();
+
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(missing_files)
+{
+    IntermediateInputFile input("/does/not/exist");
+    BOOST_CHECK(!input);
+
+    BOOST_CHECK_THROW(IntermediateOutputFile("/does/not/exist/file", true), util::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
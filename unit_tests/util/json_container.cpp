@@ -0,0 +1,45 @@
+#include "util/json_container.hpp"
+#include "util/json_renderer.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(json_container)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(object_keys_keep_insertion_order)
+{
+    json::Object object;
+    object.values["code"] = json::String("Ok");
+    object.values["routes"] = json::Array();
+    object.values["waypoints"] = json::Array();
+    object.values[std::string("code")] = json::String("NoRoute");
+
+    BOOST_CHECK_EQUAL(object.values.size(), 3u);
+    BOOST_CHECK_EQUAL(object.values.begin()->first, "code");
+    BOOST_CHECK_EQUAL(object.values.at("code").get<json::String>().value, "NoRoute");
+
+    std::vector<char> output;
+    json::render(output, object);
+    BOOST_CHECK_EQUAL(std::string(output.begin(), output.end()), "{\"code\":\"NoRoute\",\"routes\":[],\"waypoints\":[]}");
+}
+
+BOOST_AUTO_TEST_CASE(object_lookups)
+{
+    const json::Object object{{{"distance", json::Number(1)}, {"distance", json::Number(2)}}};
+
+    BOOST_CHECK_EQUAL(object.values.size(), 1u);
+    BOOST_CHECK_EQUAL(object.values.count("distance"), 1u);
+    BOOST_CHECK_EQUAL(object.values.count("duration"), 0u);
+    BOOST_CHECK(object.values.find("duration") == object.values.end());
+    BOOST_CHECK_EQUAL(object.values.at("distance").get<json::Number>().value, 1.);
+    BOOST_CHECK_THROW(object.values.at("duration"), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+#include "util/json_renderer.hpp"
+#include "util/json_writer.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(json_writer)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(nested_containers)
+{
+    std::vector<char> buffer;
+    json::Writer writer(buffer);
+
+    writer.StartObject();
+    writer.Key("code");
+    writer.String("Ok");
+    writer.Key("rows");
+    writer.StartArray();
+    writer.StartArray();
+    writer.EndArray();
+    writer.StartArray();
+    writer.Number(1.5);
+    writer.Null();
+    writer.Bool(true);
+    writer.EndArray();
+    writer.EndArray();
+    writer.Key("empty");
+    writer.StartObject();
+    writer.EndObject();
+    writer.EndObject();
+
+    BOOST_CHECK_EQUAL(std::string(buffer.begin(), buffer.end()),
+                      "{\"code\":\"Ok\",\"rows\":[[],[1.5,null,true]],\"empty\":{}}");
+}
+
+BOOST_AUTO_TEST_CASE(matches_renderer)
+{
+    json::Array waypoint;
+    waypoint.values.push_back(json::Number(7.419758));
+    waypoint.values.push_back(json::String("Avenue \"Princesse\""));
+
+    std::vector<char> expected;
+    json::ArrayRenderer renderer(expected);
+    renderer(json::String("a\\b"));
+    expected.push_back(',');
+    renderer(waypoint);
+
+    std::vector<char> buffer;
+    json::Writer writer(buffer);
+    writer.StartArray();
+    writer.String("a\\b");
+    writer.Value(waypoint);
+    writer.EndArray();
+
+    BOOST_CHECK_EQUAL(std::string(buffer.begin() + 1, buffer.end() - 1),
+                      std::string(expected.begin(), expected.end()));
+}
+
+BOOST_AUTO_TEST_CASE(number_in_tenths)
+{
+    for (const std::int64_t value : {0, 1, 9, 10, 15, 100, 1234567, -1, -10, -25})
+    {
+        std::vector<char> expected;
+        json::ArrayRenderer{expected}(json::Number(value / 10.));
+
+        std::vector<char> buffer;
+        json::Writer{buffer}.NumberInTenths(value);
+
+        BOOST_CHECK_EQUAL(std::string(buffer.begin(), buffer.end()),
+                          std::string(expected.begin(), expected.end()));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
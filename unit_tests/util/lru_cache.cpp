@@ -0,0 +1,53 @@
+#include "util/lru_cache.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(lru_cache)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(evicts_least_recently_used)
+{
+    LRUCache<int, std::string> cache(2);
+    cache.Put(1, "one");
+    cache.Put(2, "two");
+
+    // touching 1 makes 2 the least recently used entry
+    BOOST_REQUIRE(cache.Get(1));
+    BOOST_CHECK_EQUAL(*cache.Get(1), "one");
+
+    cache.Put(3, "three");
+    BOOST_CHECK_EQUAL(cache.Size(), 2u);
+    BOOST_CHECK(cache.Get(2) == nullptr);
+    BOOST_REQUIRE(cache.Get(1));
+    BOOST_REQUIRE(cache.Get(3));
+    BOOST_CHECK_EQUAL(*cache.Get(3), "three");
+}
+
+BOOST_AUTO_TEST_CASE(put_replaces_value)
+{
+    LRUCache<int, std::string> cache(2);
+    cache.Put(1, "one");
+    cache.Put(1, "uno");
+    BOOST_CHECK_EQUAL(cache.Size(), 1u);
+    BOOST_REQUIRE(cache.Get(1));
+    BOOST_CHECK_EQUAL(*cache.Get(1), "uno");
+
+    cache.Clear();
+    BOOST_CHECK_EQUAL(cache.Size(), 0u);
+    BOOST_CHECK(cache.Get(1) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(zero_capacity)
+{
+    LRUCache<int, int> cache(0);
+    cache.Put(1, 1);
+    BOOST_CHECK_EQUAL(cache.Size(), 0u);
+    BOOST_CHECK(cache.Get(1) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
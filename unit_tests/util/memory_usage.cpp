@@ -0,0 +1,37 @@
+#include "util/memory_usage.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+BOOST_AUTO_TEST_SUITE(memory_usage_test)
+
+using namespace osrm;
+using namespace osrm::util;
+
+#ifdef __linux__
+BOOST_AUTO_TEST_CASE(resident_size_of_touched_pages)
+{
+    const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    auto memory = static_cast<char *>(
+        mmap(nullptr, 4 * page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    BOOST_REQUIRE(memory != MAP_FAILED);
+
+    BOOST_CHECK_EQUAL(ResidentSize(memory, 4 * page_size), 0);
+    memory[0] = 1;
+    memory[2 * page_size] = 1;
+    BOOST_CHECK_EQUAL(ResidentSize(memory, 4 * page_size), 2 * page_size);
+
+    // only the part of a page that belongs to the memory counts
+    BOOST_CHECK_EQUAL(ResidentSize(memory + page_size / 2, 2 * page_size), page_size);
+    BOOST_CHECK_EQUAL(ResidentSize(memory + 10, 20), 20);
+    BOOST_CHECK_EQUAL(ResidentSize(memory, 0), 0);
+
+    munmap(memory, 4 * page_size);
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,87 @@
+#include "util/name_table.hpp"
+#include "util/range_table.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(name_table)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+// Same format as the .names file of the extractor, see WriteCharData
+void WriteNames(const boost::filesystem::path &path, const std::vector<std::string> &names)
+{
+    std::vector<unsigned> lengths;
+    std::string chars;
+    for (const auto &name : names)
+    {
+        lengths.push_back(name.size());
+        chars += name;
+    }
+
+    boost::filesystem::ofstream stream(path, std::ios::binary);
+    stream << RangeTable<16, false>(lengths);
+    const unsigned number_of_chars = chars.size();
+    stream.write((char *)&number_of_chars, sizeof(unsigned));
+    stream.write(chars.data(), chars.size());
+}
+}
+
+BOOST_AUTO_TEST_CASE(interned_names_test)
+{
+    // name, destination and pronunciation of each name id, with many repetitions
+    std::vector<std::string> names;
+    for (unsigned index = 0; index < 100; ++index)
+    {
+        names.push_back("Street " + std::to_string(index % 7));
+        names.push_back(index % 2 == 0 ? "" : "Downtown");
+        names.push_back(index % 3 == 0 ? std::string(255, 'x') : "");
+    }
+
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("name_table_test_%%%%%%.names");
+    WriteNames(path, names);
+    const NameTable table(path.string());
+    boost::filesystem::remove(path);
+
+    BOOST_CHECK_GE(table.GetNumberOfNames(), names.size());
+    for (unsigned name_id = 0; name_id < names.size(); ++name_id)
+    {
+        BOOST_CHECK_EQUAL(table.GetNameForID(name_id), names[name_id]);
+    }
+    // ids past the names of the file up to the end of the last block are empty
+    for (unsigned name_id = names.size(); name_id < table.GetNumberOfNames(); ++name_id)
+    {
+        BOOST_CHECK(table.GetNameViewForID(name_id).empty());
+    }
+    BOOST_CHECK(table.GetNameViewForID(std::numeric_limits<unsigned>::max()).empty());
+
+    // equal strings share their characters
+    BOOST_CHECK(table.GetNameViewForID(0).begin() == table.GetNameViewForID(21).begin());
+    BOOST_CHECK(table.GetNameViewForID(4).begin() == table.GetNameViewForID(10).begin());
+    BOOST_CHECK(table.GetNameViewForID(2).begin() == table.GetNameViewForID(11).begin());
+}
+
+BOOST_AUTO_TEST_CASE(shared_memory_test)
+{
+    std::vector<std::uint32_t> offsets = {0, 0, 3};
+    std::vector<std::uint8_t> lengths = {3, 0, 2};
+    std::vector<char> chars = {'f', 'o', 'o', 'b', 'a'};
+
+    BasicNameTable<true> table;
+    table.reset(offsets.data(), lengths.data(), offsets.size(), chars.data(), chars.size());
+    BOOST_CHECK_EQUAL(table.GetNumberOfNames(), 3);
+    BOOST_CHECK_EQUAL(table.GetNameForID(0), "foo");
+    BOOST_CHECK_EQUAL(table.GetNameForID(1), "");
+    BOOST_CHECK_EQUAL(table.GetNameForID(2), "ba");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,9 +1,14 @@
 #include "util/packed_vector.hpp"
 #include "util/typedefs.hpp"
 
+#include <boost/mpl/list.hpp>
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <cstdint>
+#include <random>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(packed_vector_test)
 
 using namespace osrm;
@@ -12,7 +17,7 @@ using namespace osrm::util;
 // Verify that the packed vector behaves as expected
 BOOST_AUTO_TEST_CASE(insert_and_retrieve_packed_test)
 {
-    PackedVector<OSMNodeID, false> packed_ids;
+    PackedOSMNodeIDs<false> packed_ids;
     std::vector<OSMNodeID> original_ids;
 
     const constexpr std::size_t num_test_cases = 399;
@@ -33,7 +38,7 @@ BOOST_AUTO_TEST_CASE(insert_and_retrieve_packed_test)
 
 BOOST_AUTO_TEST_CASE(packed_vector_capacity_test)
 {
-    PackedVector<OSMNodeID, false> packed_vec;
+    PackedOSMNodeIDs<false> packed_vec;
     const std::size_t original_size = packed_vec.capacity();
     std::vector<OSMNodeID> dummy_vec;
 
@@ -44,4 +49,79 @@ BOOST_AUTO_TEST_CASE(packed_vector_capacity_test)
     BOOST_CHECK(packed_vec.capacity() >= 100);
 }
 
+template <std::size_t Bits> struct Width
+{
+    static const constexpr std::size_t value = Bits;
+};
+using Widths = boost::mpl::list<Width<1>, Width<4>, Width<7>, Width<32>, Width<33>, Width<63>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(bit_widths_test, WidthT, Widths)
+{
+    const constexpr std::size_t bits = WidthT::value;
+    const std::uint64_t mask = (std::uint64_t{1} << bits) - 1;
+
+    using PackedT = PackedVector<std::uint64_t, bits>;
+
+    std::mt19937_64 generator(42);
+    PackedT packed;
+    std::vector<std::uint64_t> original;
+    for (std::size_t i = 0; i < 1000; ++i)
+    {
+        // higher bits are dropped
+        const auto value = generator();
+        packed.push_back(value);
+        original.push_back(value & mask);
+    }
+    BOOST_CHECK_EQUAL(packed.size(), original.size());
+    BOOST_CHECK_EQUAL(PackedT::elements_to_blocks(1000), (1000 * bits + 63) / 64);
+
+    // overwriting an element leaves its neighbours alone
+    for (std::size_t i = 0; i < original.size(); i += 3)
+    {
+        original[i] = generator() & mask;
+        packed.set(i, original[i]);
+    }
+    for (std::size_t i = 0; i < original.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(packed.at(i), original[i]);
+    }
+
+    // ranges that start and end at any position within a word
+    for (const std::size_t first : {0, 1, 63, 64, 500})
+    {
+        for (const std::size_t count : {0, 1, 2, 65, 400})
+        {
+            std::vector<std::uint64_t> decoded;
+            packed.decode(first, count, std::back_inserter(decoded));
+            BOOST_CHECK_EQUAL_COLLECTIONS(decoded.begin(),
+                                          decoded.end(),
+                                          original.begin() + first,
+                                          original.begin() + first + count);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(shared_memory_test)
+{
+    const constexpr std::size_t count = 100;
+
+    // the words of shared memory can hold anything before they are written
+    using PackedT = PackedVector<unsigned char, 4, true>;
+    std::vector<std::uint64_t> words(PackedT::elements_to_blocks(count), ~std::uint64_t{0});
+    PackedT packed;
+    packed.reset(words.data(), words.size());
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        packed.push_back(i % 13);
+    }
+
+    PackedT view;
+    view.reset(words.data(), words.size());
+    view.set_number_of_entries(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        BOOST_CHECK_EQUAL(view.at(i), i % 13);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,9 +1,15 @@
+#include "util/quantized_rectangles.hpp"
 #include "util/rectangle.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(rectangle_test)
 
 using namespace osrm;
@@ -136,4 +142,77 @@ BOOST_AUTO_TEST_CASE(get_min_dist_test)
         sw.GetMinSquaredDist(sw_n), 0.01 * COORDINATE_PRECISION * COORDINATE_PRECISION, 0.1);
 }
 
+// Quantized boxes contain the original ones, distances to them are lower bounds
+BOOST_AUTO_TEST_CASE(quantized_rectangles_test)
+{
+    using namespace quantized_rectangles;
+
+    const RectangleInt2D frame{
+        FloatLongitude{-12.5}, FloatLongitude{47.25}, FloatLatitude{-3.75}, FloatLatitude{60}};
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<std::int32_t> lon_distribution(
+        static_cast<std::int32_t>(frame.min_lon), static_cast<std::int32_t>(frame.max_lon));
+    std::uniform_int_distribution<std::int32_t> lat_distribution(
+        static_cast<std::int32_t>(frame.min_lat), static_cast<std::int32_t>(frame.max_lat));
+
+    // not a multiple of the vector width to cover the scalar remainder
+    const std::size_t count = 103;
+    std::vector<RectangleInt2D> rectangles;
+    std::vector<std::uint8_t> min_lons, max_lons, min_lats, max_lats;
+    for (std::size_t index = 0; index < count; ++index)
+    {
+        std::pair<std::int32_t, std::int32_t> lons =
+            std::minmax(lon_distribution(generator), lon_distribution(generator));
+        const std::pair<std::int32_t, std::int32_t> lats =
+            std::minmax(lat_distribution(generator), lat_distribution(generator));
+        // include degenerate boxes on the border of the frame
+        if (index == 0)
+        {
+            lons = {static_cast<std::int32_t>(frame.max_lon),
+                    static_cast<std::int32_t>(frame.max_lon)};
+        }
+        rectangles.push_back(RectangleInt2D{FixedLongitude{lons.first},
+                                            FixedLongitude{lons.second},
+                                            FixedLatitude{lats.first},
+                                            FixedLatitude{lats.second}});
+        const auto frame_min_lon = static_cast<std::int32_t>(frame.min_lon);
+        const auto frame_max_lon = static_cast<std::int32_t>(frame.max_lon);
+        const auto frame_min_lat = static_cast<std::int32_t>(frame.min_lat);
+        const auto frame_max_lat = static_cast<std::int32_t>(frame.max_lat);
+        min_lons.push_back(quantizeMin(lons.first, frame_min_lon, frame_max_lon));
+        max_lons.push_back(quantizeMax(lons.second, frame_min_lon, frame_max_lon));
+        min_lats.push_back(quantizeMin(lats.first, frame_min_lat, frame_max_lat));
+        max_lats.push_back(quantizeMax(lats.second, frame_min_lat, frame_max_lat));
+    }
+    const QuantizedRectangles quantized{
+        min_lons.data(), max_lons.data(), min_lats.data(), max_lats.data()};
+
+    std::vector<std::uint64_t> distances(count);
+    for (const auto lon : {-20., -12.5, 0., 20.3, 47.25, 50.})
+    {
+        for (const auto lat : {-10., -3.75, 10.1, 60., 70.})
+        {
+            const Coordinate location{FloatLongitude{lon}, FloatLatitude{lat}};
+            minSquaredDistances(frame, quantized, count, location, distances.data());
+            for (std::size_t index = 0; index < count; ++index)
+            {
+                BOOST_CHECK_LE(distances[index], rectangles[index].GetMinSquaredDist(location));
+            }
+        }
+    }
+
+    std::unique_ptr<bool[]> results(new bool[count]);
+    for (std::size_t index = 0; index < count; ++index)
+    {
+        intersects(frame, quantized, count, rectangles[index], results.get());
+        for (std::size_t other = 0; other < count; ++other)
+        {
+            if (rectangles[index].Intersects(rectangles[other]))
+            {
+                BOOST_CHECK(results[other]);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,82 @@
+#include "util/segment_weight_list.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(segment_weight_list_test)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+template <typename SegmentWeightListT>
+void CheckWeights(const SegmentWeightListT &list, const std::vector<EdgeWeight> &weights)
+{
+    BOOST_REQUIRE_EQUAL(list.size(), weights.size());
+    for (std::size_t index = 0; index < weights.size(); ++index)
+    {
+        BOOST_CHECK_EQUAL(list[index], weights[index]);
+    }
+
+    const auto view = list.View(1, weights.size() - 2);
+    BOOST_REQUIRE_EQUAL(view.size(), weights.size() - 2);
+    for (std::size_t index = 0; index < view.size(); ++index)
+    {
+        BOOST_CHECK_EQUAL(view[index], weights[index + 1]);
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(fits_narrow_test)
+{
+    BOOST_CHECK(SegmentWeightList<>::FitsNarrow(0));
+    BOOST_CHECK(SegmentWeightList<>::FitsNarrow(65534));
+    BOOST_CHECK(SegmentWeightList<>::FitsNarrow(INVALID_EDGE_WEIGHT));
+    BOOST_CHECK(!SegmentWeightList<>::FitsNarrow(65535));
+    BOOST_CHECK(!SegmentWeightList<>::FitsNarrow(-1));
+    BOOST_CHECK(!SegmentWeightList<>::FitsNarrow(EXCLUDED_EDGE_WEIGHT));
+}
+
+BOOST_AUTO_TEST_CASE(narrow_round_trip_test)
+{
+    const std::vector<EdgeWeight> weights = {0, 1, 10, INVALID_EDGE_WEIGHT, 300, 65534, 7};
+
+    std::vector<std::uint16_t> narrow(weights.size());
+    std::transform(weights.begin(), weights.end(), narrow.begin(), SegmentWeightList<>::Narrow);
+
+    SegmentWeightList<false> list;
+    list.Reset(narrow);
+    BOOST_CHECK(list.IsNarrow());
+    BOOST_CHECK_EQUAL(list.SizeInBytes(), weights.size() * sizeof(std::uint16_t));
+    CheckWeights(list, weights);
+
+    SegmentWeightList<true> shared_list;
+    shared_list.Reset(SegmentWeightList<true>::NarrowVector(narrow.data(), narrow.size()));
+    BOOST_CHECK(shared_list.IsNarrow());
+    CheckWeights(shared_list, weights);
+}
+
+BOOST_AUTO_TEST_CASE(wide_test)
+{
+    std::vector<EdgeWeight> weights = {0, 70000, INVALID_EDGE_WEIGHT, 5, EXCLUDED_EDGE_WEIGHT};
+
+    SegmentWeightList<false> list;
+    list.Reset(weights);
+    BOOST_CHECK(!list.IsNarrow());
+    BOOST_CHECK_EQUAL(list.SizeInBytes(), weights.size() * sizeof(EdgeWeight));
+    CheckWeights(list, weights);
+
+    SegmentWeightList<true> shared_list;
+    shared_list.Reset(SegmentWeightList<true>::WideVector(weights.data(), weights.size()));
+    BOOST_CHECK(!shared_list.IsNarrow());
+    CheckWeights(shared_list, weights);
+    // the wide form is viewed in place
+    BOOST_CHECK_EQUAL(&shared_list.View(1, 2)[0], &weights[1]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -149,4 +149,50 @@ BOOST_AUTO_TEST_CASE(find_test)
     BOOST_CHECK_EQUAL(simple_graph.GetEdgeData(eit).id, 2);
 }
 
+struct DirectedTestData
+{
+    EdgeID id;
+    bool forward;
+    bool backward;
+};
+
+BOOST_AUTO_TEST_CASE(directed_edge_range_test)
+{
+    using DirectedStaticGraph = StaticGraph<DirectedTestData>;
+    using DirectedInputEdge = DirectedStaticGraph::InputEdge;
+
+    // node 0 has a forward only, two bidirectional and a backward only edge, node 1 has only a
+    // backward edge and node 2 has none
+    std::vector<DirectedInputEdge> input_edges = {
+        DirectedInputEdge{0, 1, DirectedTestData{0, true, false}},
+        DirectedInputEdge{0, 2, DirectedTestData{1, true, true}},
+        DirectedInputEdge{0, 2, DirectedTestData{2, true, true}},
+        DirectedInputEdge{0, 3, DirectedTestData{3, false, true}},
+        DirectedInputEdge{1, 3, DirectedTestData{4, false, true}}};
+    DirectedStaticGraph graph(4, input_edges);
+    BOOST_CHECK(graph.IsDirectionOrdered());
+
+    const auto ids = [&graph](const NodeID node, const bool forward_direction) {
+        std::vector<EdgeID> edge_ids;
+        for (const auto edge : graph.GetDirectedEdgeRange(node, forward_direction))
+        {
+            edge_ids.push_back(graph.GetEdgeData(edge).id);
+        }
+        return edge_ids;
+    };
+    const std::vector<EdgeID> forward_ids = {0, 1, 2};
+    const std::vector<EdgeID> backward_ids = {1, 2, 3};
+    BOOST_CHECK(ids(0, true) == forward_ids);
+    BOOST_CHECK(ids(0, false) == backward_ids);
+    BOOST_CHECK(ids(1, true).empty());
+    BOOST_CHECK(ids(1, false) == std::vector<EdgeID>{4});
+    BOOST_CHECK(ids(2, true).empty());
+    BOOST_CHECK(ids(2, false).empty());
+
+    // a forward only edge behind a backward only one
+    input_edges[3].target = 0;
+    std::sort(input_edges.begin(), input_edges.end());
+    BOOST_CHECK(!DirectedStaticGraph(4, input_edges).IsDirectionOrdered());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 #include "util/coordinate.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/exception.hpp"
+#include "util/integer_range.hpp"
 #include "util/rectangle.hpp"
 #include "util/typedefs.hpp"
 
@@ -18,6 +19,7 @@
 #include <cstdint>
 
 #include <algorithm>
+#include <limits>
 #include <memory>
 #include <random>
 #include <string>
@@ -239,6 +241,55 @@ void sampling_verify_rtree(RTreeT &rtree,
     }
 }
 
+template <typename RTreeT>
+void batch_verify_rtree(RTreeT &rtree, const std::vector<Coordinate> &coords, unsigned num_samples)
+{
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_int_distribution<> lat_udist(WORLD_MIN_LAT, WORLD_MAX_LAT);
+    std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+    std::vector<Coordinate> queries;
+    for (unsigned i = 0; i < num_samples; i++)
+    {
+        queries.emplace_back(FixedLongitude{lon_udist(g)}, FixedLatitude{lat_udist(g)});
+    }
+
+    using CandidateSegment = typename RTreeT::CandidateSegment;
+    auto batch_results = rtree.Nearest(
+        queries,
+        [](const std::size_t, const CandidateSegment &) { return std::make_pair(true, true); },
+        [](const std::size_t, const std::size_t num_results, const CandidateSegment &) {
+            return num_results >= 2;
+        });
+
+    auto batch_k_results = rtree.KNearest(
+        queries,
+        {},
+        2,
+        [](const std::size_t, const CandidateSegment &) { return std::make_pair(true, true); },
+        [](const std::size_t, const CandidateSegment &) { return false; });
+
+    BOOST_REQUIRE_EQUAL(batch_results.size(), queries.size());
+    BOOST_REQUIRE_EQUAL(batch_k_results.size(), queries.size());
+    for (const auto i : util::irange<std::size_t>(0UL, queries.size()))
+    {
+        auto single_results = rtree.Nearest(queries[i], 2);
+        BOOST_REQUIRE_EQUAL(batch_k_results[i].size(), single_results.size());
+        BOOST_REQUIRE_EQUAL(batch_results[i].size(), single_results.size());
+        for (const auto j : util::irange<std::size_t>(0UL, single_results.size()))
+        {
+            BOOST_CHECK_EQUAL(batch_k_results[i][j].u, single_results[j].u);
+            BOOST_CHECK_EQUAL(batch_k_results[i][j].v, single_results[j].v);
+            // the search in order of distance may order segments of the same distance otherwise
+            BOOST_CHECK_CLOSE(
+                coordinate_calculation::perpendicularDistance(
+                    coords[batch_results[i][j].u], coords[batch_results[i][j].v], queries[i]),
+                coordinate_calculation::perpendicularDistance(
+                    coords[single_results[j].u], coords[single_results[j].v], queries[i]),
+                0.0001);
+        }
+    }
+}
+
 template <typename FixtureT, typename RTreeT = TestStaticRTree>
 void build_rtree(const std::string &prefix,
                  FixtureT *fixture,
@@ -262,6 +313,7 @@ void construction_test(const std::string &prefix, FixtureT *fixture)
 
     simple_verify_rtree(rtree, fixture->coords, fixture->edges);
     sampling_verify_rtree(rtree, lsnn, fixture->coords, 100);
+    batch_verify_rtree(rtree, fixture->coords, 1000);
 }
 
 BOOST_FIXTURE_TEST_CASE(construct_tiny, TestRandomGraphFixture_10_30)
@@ -295,6 +347,54 @@ BOOST_FIXTURE_TEST_CASE(construct_multiple_levels_test, TestRandomGraphFixture_M
     construction_test("test_5", this);
 }
 
+BOOST_FIXTURE_TEST_CASE(in_memory_leaves_test, TestRandomGraphFixture_MultipleLevels)
+{
+    using SharedTestRTree = StaticRTree<TestData,
+                                        std::vector<Coordinate>,
+                                        true,
+                                        TEST_BRANCHING_FACTOR,
+                                        TEST_LEAF_NODE_SIZE>;
+    using LeafNode = SharedTestRTree::LeafNode;
+
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree("test_in_memory", this, leaves_path, nodes_path);
+    TestStaticRTree file_rtree(nodes_path, leaves_path, coords);
+
+    boost::filesystem::ifstream tree_node_file(nodes_path, std::ios::binary);
+    std::uint32_t tree_size = 0;
+    tree_node_file.read((char *)&tree_size, sizeof(std::uint32_t));
+    std::vector<SharedTestRTree::TreeNode> tree_nodes(tree_size);
+    tree_node_file.read((char *)tree_nodes.data(), sizeof(SharedTestRTree::TreeNode) * tree_size);
+
+    // leaves need to be aligned to their page size, as they would be in shared memory
+    const auto leaves_size = boost::filesystem::file_size(leaves_path);
+    std::vector<char> leaves_buffer(leaves_size + sizeof(LeafNode) - 1);
+    const auto leaves_address = reinterpret_cast<std::uintptr_t>(leaves_buffer.data());
+    char *leaves_ptr = reinterpret_cast<char *>((leaves_address + sizeof(LeafNode) - 1) &
+                                                ~(sizeof(LeafNode) - 1));
+    boost::filesystem::ifstream leaf_node_file(leaves_path, std::ios::binary);
+    leaf_node_file.read(leaves_ptr, leaves_size);
+
+    SharedTestRTree memory_rtree(tree_nodes.data(),
+                                 tree_size,
+                                 reinterpret_cast<const LeafNode *>(leaves_ptr),
+                                 leaves_size / sizeof(LeafNode),
+                                 coords);
+
+    BOOST_CHECK_EQUAL(file_rtree.WarmUpLeaves(), edges.size());
+    BOOST_CHECK_EQUAL(memory_rtree.WarmUpLeaves(), edges.size());
+
+    for (const auto &e : edges)
+    {
+        auto file_result = file_rtree.Nearest(coords[e.u], 1);
+        auto memory_result = memory_rtree.Nearest(coords[e.u], 1);
+        BOOST_REQUIRE(file_result.size() == 1 && memory_result.size() == 1);
+        BOOST_CHECK_EQUAL(file_result.front().u, memory_result.front().u);
+        BOOST_CHECK_EQUAL(file_result.front().v, memory_result.front().v);
+    }
+}
+
 // Bug: If you querry a point that lies between two BBs that have a gap,
 // one BB will be pruned, even if it could contain a nearer match.
 BOOST_AUTO_TEST_CASE(regression_test)
@@ -433,6 +533,193 @@ BOOST_AUTO_TEST_CASE(bearing_tests)
     }
 }
 
+// Pruning by the bearing sectors of the subtrees and the bearings of the leaf objects must not
+// change the result of a search whose filter checks the bearings itself
+BOOST_FIXTURE_TEST_CASE(bearing_filter_test, TestRandomGraphFixture_MultipleLevels)
+{
+    for (const auto i : util::irange<std::size_t>(0UL, edges.size()))
+    {
+        edges[i].forward_segment_id = {static_cast<NodeID>(i), i % 2 == 0};
+        edges[i].reverse_segment_id = {static_cast<NodeID>(i), i % 3 != 0};
+    }
+
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree("test_bearing_filter", this, leaves_path, nodes_path);
+    TestStaticRTree rtree(nodes_path, leaves_path, coords);
+
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_int_distribution<> lat_udist(WORLD_MIN_LAT, WORLD_MAX_LAT);
+    std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+    std::uniform_int_distribution<> bearing_udist(0, 359);
+    std::uniform_int_distribution<> range_udist(1, 90);
+
+    using CandidateSegment = TestStaticRTree::CandidateSegment;
+    for (unsigned sample = 0; sample < 100; ++sample)
+    {
+        const Coordinate query{FixedLongitude{lon_udist(g)}, FixedLatitude{lat_udist(g)}};
+        const TestStaticRTree::BearingFilter bearing_filter{bearing_udist(g), range_udist(g)};
+        const auto filter = [&](const CandidateSegment &segment) {
+            const int forward_bearing = std::round(
+                coordinate_calculation::bearing(coords[segment.data.u], coords[segment.data.v]));
+            return std::make_pair(
+                segment.data.forward_segment_id.enabled &&
+                    bearing::CheckInBounds(
+                        forward_bearing, bearing_filter.bearing, bearing_filter.range),
+                segment.data.reverse_segment_id.enabled &&
+                    bearing::CheckInBounds(
+                        forward_bearing + 180, bearing_filter.bearing, bearing_filter.range));
+        };
+        const auto terminate = [](const std::size_t num_results, const CandidateSegment &) {
+            return num_results >= 5;
+        };
+
+        const auto expected = rtree.Nearest(query, filter, terminate);
+        const auto pruned = rtree.Nearest(query, bearing_filter, filter, terminate);
+        // segments of the same distance may come in a different order
+        BOOST_REQUIRE_EQUAL(pruned.size(), expected.size());
+        for (const auto j : util::irange<std::size_t>(0UL, expected.size()))
+        {
+            BOOST_CHECK_CLOSE(coordinate_calculation::perpendicularDistance(
+                                  coords[pruned[j].u], coords[pruned[j].v], query),
+                              coordinate_calculation::perpendicularDistance(
+                                  coords[expected[j].u], coords[expected[j].v], query),
+                              0.0001);
+        }
+    }
+}
+
+// The bounded k nearest search must find what the search in order of distance finds with a
+// terminator for the number of results and the range
+BOOST_FIXTURE_TEST_CASE(k_nearest_test, TestRandomGraphFixture_MultipleLevels)
+{
+    for (const auto i : util::irange<std::size_t>(0UL, edges.size()))
+    {
+        edges[i].forward_segment_id = {static_cast<NodeID>(i), true};
+        edges[i].reverse_segment_id = {static_cast<NodeID>(i), true};
+    }
+
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree("test_k_nearest", this, leaves_path, nodes_path);
+    TestStaticRTree rtree(nodes_path, leaves_path, coords);
+
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_int_distribution<> lat_udist(WORLD_MIN_LAT, WORLD_MAX_LAT);
+    std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+    std::uniform_int_distribution<> results_udist(0, 20);
+    std::uniform_real_distribution<> radius_udist(0, 2000000);
+
+    using CandidateSegment = TestStaticRTree::CandidateSegment;
+    for (unsigned sample = 0; sample < 200; ++sample)
+    {
+        const Coordinate query{FixedLongitude{lon_udist(g)}, FixedLatitude{lat_udist(g)}};
+        const std::size_t max_results = results_udist(g);
+        // every other sample without a range
+        const double radius =
+            sample % 2 == 0 ? std::numeric_limits<double>::max() : radius_udist(g);
+        const auto filter = [](const CandidateSegment &segment) {
+            return std::make_pair(segment.data.u % 3 != 0, segment.data.v % 5 != 0);
+        };
+        const auto out_of_range = [&](const CandidateSegment &segment) {
+            return coordinate_calculation::haversineDistance(
+                       query, web_mercator::toWGS84(segment.fixed_projected_coordinate)) > radius;
+        };
+
+        const auto expected = rtree.Nearest(
+            query, filter, [&](const std::size_t num_results, const CandidateSegment &segment) {
+                return num_results >= max_results || out_of_range(segment);
+            });
+        const auto bounded = rtree.KNearest(query, max_results, filter, out_of_range);
+        // segments of the same distance may come in a different order
+        BOOST_REQUIRE_EQUAL(bounded.size(), expected.size());
+        for (const auto j : util::irange<std::size_t>(0UL, expected.size()))
+        {
+            BOOST_CHECK_CLOSE(coordinate_calculation::perpendicularDistance(
+                                  coords[bounded[j].u], coords[bounded[j].v], query),
+                              coordinate_calculation::perpendicularDistance(
+                                  coords[expected[j].u], coords[expected[j].v], query),
+                              0.0001);
+            BOOST_CHECK_EQUAL(bounded[j].forward_segment_id.enabled, bounded[j].u % 3 != 0);
+            BOOST_CHECK_EQUAL(bounded[j].reverse_segment_id.enabled, bounded[j].v % 5 != 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(big_component_tests)
+{
+    using Coord = std::pair<FloatLongitude, FloatLatitude>;
+    using Edge = std::pair<unsigned, unsigned>;
+    GraphFixture fixture(
+        {
+            Coord(FloatLongitude{0.0}, FloatLatitude{0.0}),
+            Coord(FloatLongitude{0.0}, FloatLatitude{1.0}),
+            Coord(FloatLongitude{0.3}, FloatLatitude{0.0}),
+            Coord(FloatLongitude{0.3}, FloatLatitude{1.0}),
+            Coord(FloatLongitude{1.0}, FloatLatitude{0.0}),
+            Coord(FloatLongitude{1.0}, FloatLatitude{1.0}),
+            Coord(FloatLongitude{2.0}, FloatLatitude{0.0}),
+            Coord(FloatLongitude{2.0}, FloatLatitude{1.0}),
+        },
+        {Edge(0, 1), Edge(2, 3), Edge(4, 5), Edge(6, 7)});
+    fixture.edges[0].component.is_tiny = true;
+    fixture.edges[1].component.is_tiny = true;
+
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree<GraphFixture, MiniStaticRTree>(
+        "test_big_component", &fixture, leaves_path, nodes_path);
+    MiniStaticRTree rtree(nodes_path, leaves_path, fixture.coords);
+    MockDataFacade mockfacade;
+    engine::GeospatialQuery<MiniStaticRTree, MockDataFacade> query(
+        rtree, fixture.coords, mockfacade);
+
+    Coordinate input(FloatLongitude{0.1}, FloatLatitude{0.5});
+
+    {
+        // the nearest segment is tiny, the alternative skips the second tiny one
+        auto results = query.NearestPhantomNodeWithAlternativeFromBigComponent(input);
+        BOOST_CHECK_EQUAL(results.first.forward_segment_id.id, 1);
+        BOOST_CHECK_EQUAL(results.second.forward_segment_id.id, 5);
+
+        auto batch_results = query.NearestPhantomNodesWithAlternativeFromBigComponent({input});
+        BOOST_REQUIRE_EQUAL(batch_results.size(), 1);
+        BOOST_CHECK_EQUAL(batch_results.front().first.forward_segment_id.id, 1);
+        BOOST_CHECK_EQUAL(batch_results.front().second.forward_segment_id.id, 5);
+    }
+
+    {
+        // no big component within range
+        auto results = query.NearestPhantomNodeWithAlternativeFromBigComponent(input, 50000);
+        BOOST_CHECK_EQUAL(results.first.forward_segment_id.id, 1);
+        BOOST_CHECK_EQUAL(results.second.forward_segment_id.id, 1);
+    }
+
+    {
+        auto results = query.NearestPhantomNodeWithAlternativeFromBigComponent(input, 0, 10);
+        BOOST_CHECK_EQUAL(results.first.forward_segment_id.id, 1);
+        BOOST_CHECK(results.first.forward_segment_id.enabled);
+        BOOST_CHECK(!results.first.reverse_segment_id.enabled);
+        BOOST_CHECK_EQUAL(results.second.forward_segment_id.id, 5);
+        BOOST_CHECK(results.second.forward_segment_id.enabled);
+        BOOST_CHECK(!results.second.reverse_segment_id.enabled);
+    }
+
+    {
+        auto results = query.NearestPhantomNodeWithAlternativeFromBigComponent(input, 90, 10);
+        BOOST_CHECK(!results.first.IsValid());
+        BOOST_CHECK(!results.second.IsValid());
+    }
+
+    {
+        // the nearest segment is big already
+        Coordinate big_input(FloatLongitude{1.9}, FloatLatitude{0.5});
+        auto results = query.NearestPhantomNodeWithAlternativeFromBigComponent(big_input);
+        BOOST_CHECK_EQUAL(results.first.forward_segment_id.id, 7);
+        BOOST_CHECK_EQUAL(results.second.forward_segment_id.id, 7);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(bbox_search_tests)
 {
     using Coord = std::pair<FloatLongitude, FloatLatitude>;
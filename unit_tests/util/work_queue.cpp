@@ -0,0 +1,77 @@
+#include "util/work_queue.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <future>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(work_queue)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+const constexpr auto UNLIMITED = std::numeric_limits<std::size_t>::max();
+}
+
+BOOST_AUTO_TEST_CASE(runs_lower_priorities_first)
+{
+    std::vector<int> order;
+    std::mutex order_mutex;
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> done;
+
+    {
+        WorkQueue queue(1, 16, {{1, UNLIMITED}, {0, UNLIMITED}});
+        // keeps the only worker busy until all tasks are queued
+        BOOST_CHECK(queue.TryPush(0, [released] { released.wait(); }));
+
+        const auto record = [&](const int task) {
+            return [&order, &order_mutex, task] {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(task);
+            };
+        };
+        BOOST_CHECK(queue.TryPush(0, record(1)));
+        BOOST_CHECK(queue.TryPush(1, record(2)));
+        BOOST_CHECK(queue.TryPush(0, record(3)));
+        BOOST_CHECK(queue.TryPush(0, [&] { done.set_value(); }));
+
+        release.set_value();
+        done.get_future().wait();
+    }
+
+    const std::vector<int> expected = {2, 1, 3};
+    BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(rejects_tasks_beyond_the_limits)
+{
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    const auto wait = [released] { released.wait(); };
+
+    WorkQueue queue(1, 2, {{0, 2}, {0, UNLIMITED}});
+    std::promise<void> started;
+    BOOST_CHECK(queue.TryPush(0, [&started, released] {
+        started.set_value();
+        released.wait();
+    }));
+    started.get_future().wait();
+
+    // the running task counts against the lane, but not against the capacity of the queue
+    BOOST_CHECK(queue.TryPush(0, wait));
+    BOOST_CHECK(!queue.TryPush(0, wait));
+    BOOST_CHECK(queue.TryPush(1, wait));
+    BOOST_CHECK(!queue.TryPush(1, wait));
+    BOOST_CHECK_EQUAL(queue.NumberOfQueuedTasks(), 2);
+
+    release.set_value();
+}
+
+BOOST_AUTO_TEST_SUITE_END()